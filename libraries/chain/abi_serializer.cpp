@@ -2,9 +2,13 @@
 #include <eosio/chain/asset.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <fc/io/raw.hpp>
+#include <fc/io/json.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <fc/io/varint.hpp>
 
+#include <deque>
+#include <set>
+
 using namespace boost;
 
 
@@ -72,14 +76,179 @@ namespace eosio { namespace chain {
       );
    }
 
+   namespace impl {
+
+      struct field_plan {
+         const type_plan* type = nullptr;
+         bool             extension = false;
+      };
+
+      /// how a resolved type is (de)serialized, mirrors the type name lookups of the _binary_to_variant and
+      /// _variant_to_binary overloads taking a type name
+      struct type_plan {
+         enum class kind_t : uint8_t { built_in, array, optional, variant, other };
+
+         kind_t                                             kind = kind_t::other;
+         std::string_view                                   rtype; ///< resolved type, owned by abi_type_plans
+         const pair<abi_serializer::unpack_function, abi_serializer::pack_function>* built_in = nullptr;
+         bool                                               is_array = false;    ///< of built_in
+         bool                                               is_optional = false; ///< of built_in
+         const type_plan*                                   element = nullptr;   ///< of array or optional
+         map<type_name, variant_def>::const_iterator        variant_itr;
+         vector<const type_plan*>                           variant_types;
+         bool                                               is_struct = false;
+         map<type_name, struct_def>::const_iterator         struct_itr;
+         const type_plan*                                   base = nullptr;
+         vector<field_plan>                                 fields;
+         bool                                               duplicate_fields = false; ///< a field name repeats within the struct and its bases
+         bool                                               kv_name = false;     ///< kv tables exist and rtype is a valid name
+         const type_plan*                                   kv_table = nullptr;  ///< type of the kv table named rtype
+      };
+
+      struct abi_type_plans {
+         std::deque<type_plan>                              plans; ///< stable addresses
+         map<type_name, const type_plan*, std::less<>>      by_type;
+
+         const type_plan* compile( const abi_serializer& abis, const std::string_view& type, abi_traverse_context& ctx ) {
+            const std::string_view rtype = abis.resolve_type( type );
+            if( auto itr = by_type.find( type ); itr != by_type.end() ) return itr->second;
+            if( auto itr = by_type.find( rtype ); itr != by_type.end() ) {
+               by_type.emplace( type_name( type ), itr->second );
+               return itr->second;
+            }
+            // bounds the recursion through bases, fields, elements and variant types by max_recursion_depth
+            auto h = ctx.enter_scope();
+
+            // registered before compiling the types it refers to, which may refer back to it
+            type_plan& p = plans.emplace_back();
+            p.rtype = by_type.emplace( type_name( rtype ), &p ).first->first;
+            if( type != rtype ) by_type.emplace( type_name( type ), &p );
+
+            const std::string_view ftype = abis.fundamental_type( p.rtype );
+            if( auto btype = abis.built_in_types.find( ftype ); btype != abis.built_in_types.end() ) {
+               p.kind = type_plan::kind_t::built_in;
+               p.built_in = &btype->second;
+               p.is_array = abis.is_array( p.rtype );
+               p.is_optional = abis.is_optional( p.rtype );
+            } else if( abis.is_array( p.rtype ) ) {
+               p.kind = type_plan::kind_t::array;
+               p.element = compile( abis, ftype, ctx );
+            } else if( abis.is_optional( p.rtype ) ) {
+               p.kind = type_plan::kind_t::optional;
+               p.element = compile( abis, ftype, ctx );
+            } else if( auto v_itr = abis.variants.find( p.rtype ); v_itr != abis.variants.end() ) {
+               p.kind = type_plan::kind_t::variant;
+               p.variant_itr = v_itr;
+               p.variant_types.reserve( v_itr->second.types.size() );
+               for( const auto& t : v_itr->second.types ) {
+                  p.variant_types.push_back( compile( abis, t, ctx ) );
+               }
+            }
+            // a struct may also be the base of another struct when its name resolves to a built-in type
+            if( auto s_itr = abis.structs.find( p.rtype ); s_itr != abis.structs.end() ) {
+               p.is_struct = true;
+               p.struct_itr = s_itr;
+               const auto& st = s_itr->second;
+               if( st.base != type_name() ) p.base = compile( abis, st.base, ctx );
+               p.fields.reserve( st.fields.size() );
+               for( const auto& field : st.fields ) {
+                  const bool extension = ends_with( field.type, "$" );
+                  p.fields.push_back( { compile( abis, abi_serializer::_remove_bin_extension( field.type ), ctx ), extension } );
+               }
+            }
+            if( !abis.kv_tables.empty() && is_string_valid_name( p.rtype ) ) {
+               p.kv_name = true;
+               if( auto kv_itr = abis.kv_tables.find( name( p.rtype ) ); kv_itr != abis.kv_tables.end() ) {
+                  p.kv_table = compile( abis, kv_itr->second.type, ctx );
+               }
+            }
+            return &p;
+         }
+      };
+
+   }
+
    abi_serializer::abi_serializer( const abi_def& abi, const yield_function_t& yield ) {
       configure_built_in_types();
       set_abi(abi, yield);
    }
 
+   abi_serializer::abi_serializer( const abi_serializer& other ) {
+      *this = other;
+   }
+
+   // moved map nodes keep their addresses, the plans remain valid
+   abi_serializer::abi_serializer( abi_serializer&& other ) = default;
+   abi_serializer::~abi_serializer() = default;
+   abi_serializer& abi_serializer::operator=( abi_serializer&& other ) = default;
+
+   abi_serializer& abi_serializer::operator=( const abi_serializer& other ) {
+      if( this == &other ) return *this;
+      typedefs = other.typedefs;
+      structs = other.structs;
+      actions = other.actions;
+      tables = other.tables;
+      kv_tables = other.kv_tables;
+      error_messages = other.error_messages;
+      variants = other.variants;
+      action_results = other.action_results;
+      built_in_types = other.built_in_types;
+      // plans of other refer to its maps
+      type_plans.reset();
+      if( other.type_plans ) {
+         impl::abi_traverse_context ctx( yield_function_t{} );
+         compile_type_plans( ctx );
+      }
+      return *this;
+   }
+
    void abi_serializer::add_specialized_unpack_pack( const string& name,
                                                      std::pair<abi_serializer::unpack_function, abi_serializer::pack_function> unpack_pack ) {
       built_in_types[name] = std::move( unpack_pack );
+      if( type_plans ) {
+         impl::abi_traverse_context ctx( yield_function_t{} );
+         compile_type_plans( ctx );
+      }
+   }
+
+   void abi_serializer::compile_type_plans( impl::abi_traverse_context& ctx ) {
+      auto plans = std::make_unique<impl::abi_type_plans>();
+      try {
+         for( const auto& t : typedefs )       plans->compile( *this, t.first, ctx );
+         for( const auto& s : structs )        plans->compile( *this, s.first, ctx );
+         for( const auto& v : variants )       plans->compile( *this, v.first, ctx );
+         for( const auto& a : actions )        plans->compile( *this, a.second, ctx );
+         for( const auto& t : tables )         plans->compile( *this, t.second, ctx );
+         for( const auto& kt : kv_tables ) {
+            plans->compile( *this, kt.first.to_string(), ctx );
+            plans->compile( *this, kt.second.type, ctx );
+         }
+         for( const auto& r : action_results ) plans->compile( *this, r.second, ctx );
+      } catch( const abi_recursion_depth_exception& ) {
+         // types nested deeper than max_recursion_depth are valid, they are (de)serialized by type name instead
+         type_plans.reset();
+         return;
+      }
+      // fc::mutable_variant_object keeps the last value of a repeated field name at the position of the first
+      for( auto& p : plans->plans ) {
+         if( !p.is_struct ) continue;
+         std::set<std::string_view> names;
+         for( const impl::type_plan* s = &p; s && s->is_struct && !p.duplicate_fields; s = s->base ) {
+            for( const auto& field : s->struct_itr->second.fields ) {
+               if( !names.insert( field.name ).second ) {
+                  p.duplicate_fields = true;
+                  break;
+               }
+            }
+         }
+      }
+      type_plans = std::move( plans );
+   }
+
+   const impl::type_plan* abi_serializer::find_type_plan( const std::string_view& type )const {
+      if( !type_plans ) return nullptr;
+      auto itr = type_plans->by_type.find( type );
+      return itr != type_plans->by_type.end() ? itr->second : nullptr;
    }
 
    void abi_serializer::configure_built_in_types() {
@@ -138,6 +307,7 @@ namespace eosio { namespace chain {
       error_messages.clear();
       variants.clear();
       action_results.clear();
+      type_plans.reset();
 
       for( const auto& st : abi.structs )
          structs[st.name] = st;
@@ -180,6 +350,7 @@ namespace eosio { namespace chain {
       EOS_ASSERT( action_results.size() == abi.action_results.value.size(), duplicate_abi_action_results_def_exception, "duplicate action results definition detected" );
 
       validate(ctx);
+      compile_type_plans(ctx);
    }
 
    bool abi_serializer::is_builtin_type(const std::string_view& type)const {
@@ -334,6 +505,10 @@ namespace eosio { namespace chain {
    void abi_serializer::_binary_to_variant( const std::string_view& type, fc::datastream<const char *>& stream,
                                             fc::mutable_variant_object& obj, impl::binary_to_variant_context& ctx )const
    {
+      if( auto plan = find_type_plan(type) ) {
+         _binary_to_variant(*plan, stream, obj, ctx);
+         return;
+      }
       auto h = ctx.enter_scope();
       auto s_itr = structs.find(type);
       EOS_ASSERT( s_itr != structs.end(), invalid_type_inside_abi, "Unknown type ${type}", ("type",ctx.maybe_shorten(type)) );
@@ -367,6 +542,9 @@ namespace eosio { namespace chain {
    fc::variant abi_serializer::_binary_to_variant( const std::string_view& type, fc::datastream<const char *>& stream,
                                                    impl::binary_to_variant_context& ctx )const
    {
+      if( auto plan = find_type_plan(type) ) {
+         return _binary_to_variant(*plan, stream, ctx);
+      }
       auto h = ctx.enter_scope();
       auto rtype = resolve_type(type);
       auto ftype = fundamental_type(rtype);
@@ -436,6 +614,98 @@ namespace eosio { namespace chain {
       return fc::variant( std::move(mvo) );
    }
 
+   void abi_serializer::_binary_to_variant( const impl::type_plan& plan, fc::datastream<const char *>& stream,
+                                            fc::mutable_variant_object& obj, impl::binary_to_variant_context& ctx )const
+   {
+      auto h = ctx.enter_scope();
+      EOS_ASSERT( plan.is_struct, invalid_type_inside_abi, "Unknown type ${type}", ("type",ctx.maybe_shorten(plan.rtype)) );
+      ctx.hint_struct_type_if_in_array( plan.struct_itr );
+      const auto& st = plan.struct_itr->second;
+      if( plan.base ) {
+         _binary_to_variant(*plan.base, stream, obj, ctx);
+      }
+      bool encountered_extension = false;
+      for( uint32_t i = 0; i < st.fields.size(); ++i ) {
+         const auto& field = st.fields[i];
+         const auto& field_plan = plan.fields[i];
+         encountered_extension |= field_plan.extension;
+         if( !stream.remaining() ) {
+            if( field_plan.extension ) {
+               continue;
+            }
+            if( encountered_extension ) {
+               EOS_THROW( abi_exception, "Encountered field '${f}' without binary extension designation while processing struct '${p}'",
+                          ("f", ctx.maybe_shorten(field.name))("p", ctx.get_path_string()) );
+            }
+            EOS_THROW( unpack_exception, "Stream unexpectedly ended; unable to unpack field '${f}' of struct '${p}'",
+                       ("f", ctx.maybe_shorten(field.name))("p", ctx.get_path_string()) );
+
+         }
+         auto h1 = ctx.push_to_path( impl::field_path_item{ .parent_struct_itr = plan.struct_itr, .field_ordinal = i } );
+         obj( field.name, _binary_to_variant(*field_plan.type, stream, ctx) );
+      }
+   }
+
+   fc::variant abi_serializer::_binary_to_variant( const impl::type_plan& plan, fc::datastream<const char *>& stream,
+                                                   impl::binary_to_variant_context& ctx )const
+   {
+      auto h = ctx.enter_scope();
+      switch( plan.kind ) {
+      case impl::type_plan::kind_t::built_in:
+         try {
+            return plan.built_in->first(stream, plan.is_array, plan.is_optional, ctx.get_yield_function());
+         } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack ${class} type '${type}' while processing '${p}'",
+                                   ("class", plan.is_array ? "array of built-in" : plan.is_optional ? "optional of built-in" : "built-in")
+                                   ("type", impl::limit_size(fundamental_type(plan.rtype)))("p", ctx.get_path_string()) )
+      case impl::type_plan::kind_t::array: {
+         ctx.hint_array_type_if_in_array();
+         fc::unsigned_int size;
+         try {
+            fc::raw::unpack(stream, size);
+         } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack size of array '${p}'", ("p", ctx.get_path_string()) )
+         vector<fc::variant> vars;
+         auto h1 = ctx.push_to_path( impl::array_index_path_item{} );
+         for( decltype(size.value) i = 0; i < size; ++i ) {
+            ctx.set_array_index_of_path_back(i);
+            auto v = _binary_to_variant(*plan.element, stream, ctx);
+            EOS_ASSERT( !v.is_null(), unpack_exception, "Invalid packed array '${p}'", ("p", ctx.get_path_string()) );
+            vars.emplace_back(std::move(v));
+         }
+         return fc::variant( std::move(vars) );
+      }
+      case impl::type_plan::kind_t::optional: {
+         char flag;
+         try {
+            fc::raw::unpack(stream, flag);
+         } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack presence flag of optional '${p}'", ("p", ctx.get_path_string()) )
+         return flag ? _binary_to_variant(*plan.element, stream, ctx) : fc::variant();
+      }
+      case impl::type_plan::kind_t::variant: {
+         ctx.hint_variant_type_if_in_array(plan.variant_itr);
+         fc::unsigned_int select;
+         try {
+            fc::raw::unpack(stream, select);
+         } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack tag of variant '${p}'", ("p", ctx.get_path_string()) )
+         const auto& types = plan.variant_itr->second.types;
+         EOS_ASSERT( (size_t)select < types.size(), unpack_exception,
+                     "Unpacked invalid tag (${select}) for variant '${p}'", ("select", select.value)("p",ctx.get_path_string()) );
+         auto h1 = ctx.push_to_path( impl::variant_path_item{ .variant_itr = plan.variant_itr, .variant_ordinal = static_cast<uint32_t>(select) } );
+         return vector<fc::variant>{types[select], _binary_to_variant(*plan.variant_types[select], stream, ctx)};
+      }
+      case impl::type_plan::kind_t::other:
+         break;
+      }
+
+      if( plan.kv_table ) {
+         return _binary_to_variant(*plan.kv_table, stream, ctx);
+      }
+
+      fc::mutable_variant_object mvo;
+      _binary_to_variant(plan, stream, mvo, ctx);
+      EOS_ASSERT( mvo.size() > 0, unpack_exception, "Unable to unpack '${p}' from stream", ("p", ctx.get_path_string()) );
+      return fc::variant( std::move(mvo) );
+   }
+
    fc::variant abi_serializer::_binary_to_variant( const std::string_view& type, const bytes& binary, impl::binary_to_variant_context& ctx )const
    {
       auto h = ctx.enter_scope();
@@ -455,8 +725,157 @@ namespace eosio { namespace chain {
       return _binary_to_variant(type, binary, ctx);
    }
 
+   void abi_serializer::_binary_to_json( const impl::type_plan& plan, fc::datastream<const char *>& stream, std::string& out,
+                                         size_t& field_count, impl::binary_to_variant_context& ctx )const
+   {
+      auto h = ctx.enter_scope();
+      EOS_ASSERT( plan.is_struct, invalid_type_inside_abi, "Unknown type ${type}", ("type",ctx.maybe_shorten(plan.rtype)) );
+      ctx.hint_struct_type_if_in_array( plan.struct_itr );
+      const auto& st = plan.struct_itr->second;
+      if( plan.base ) {
+         _binary_to_json(*plan.base, stream, out, field_count, ctx);
+      }
+      bool encountered_extension = false;
+      for( uint32_t i = 0; i < st.fields.size(); ++i ) {
+         const auto& field = st.fields[i];
+         const auto& field_plan = plan.fields[i];
+         encountered_extension |= field_plan.extension;
+         if( !stream.remaining() ) {
+            if( field_plan.extension ) {
+               continue;
+            }
+            if( encountered_extension ) {
+               EOS_THROW( abi_exception, "Encountered field '${f}' without binary extension designation while processing struct '${p}'",
+                          ("f", ctx.maybe_shorten(field.name))("p", ctx.get_path_string()) );
+            }
+            EOS_THROW( unpack_exception, "Stream unexpectedly ended; unable to unpack field '${f}' of struct '${p}'",
+                       ("f", ctx.maybe_shorten(field.name))("p", ctx.get_path_string()) );
+
+         }
+         auto h1 = ctx.push_to_path( impl::field_path_item{ .parent_struct_itr = plan.struct_itr, .field_ordinal = i } );
+         if( field_count++ ) out += ',';
+         out += '"';
+         out += fc::escape_string( field.name, nullptr );
+         out += "\":";
+         _binary_to_json(*field_plan.type, stream, out, ctx);
+      }
+   }
+
+   bool abi_serializer::_binary_to_json( const impl::type_plan& plan, fc::datastream<const char *>& stream, std::string& out,
+                                         impl::binary_to_variant_context& ctx )const
+   {
+      auto h = ctx.enter_scope();
+      switch( plan.kind ) {
+      case impl::type_plan::kind_t::built_in: {
+         fc::variant v;
+         try {
+            v = plan.built_in->first(stream, plan.is_array, plan.is_optional, ctx.get_yield_function());
+         } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack ${class} type '${type}' while processing '${p}'",
+                                   ("class", plan.is_array ? "array of built-in" : plan.is_optional ? "optional of built-in" : "built-in")
+                                   ("type", impl::limit_size(fundamental_type(plan.rtype)))("p", ctx.get_path_string()) )
+         out += fc::json::to_string( v, fc::time_point::maximum() );
+         return !v.is_null();
+      }
+      case impl::type_plan::kind_t::array: {
+         ctx.hint_array_type_if_in_array();
+         fc::unsigned_int size;
+         try {
+            fc::raw::unpack(stream, size);
+         } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack size of array '${p}'", ("p", ctx.get_path_string()) )
+         out += '[';
+         auto h1 = ctx.push_to_path( impl::array_index_path_item{} );
+         for( decltype(size.value) i = 0; i < size; ++i ) {
+            ctx.set_array_index_of_path_back(i);
+            if( i ) out += ',';
+            EOS_ASSERT( _binary_to_json(*plan.element, stream, out, ctx), unpack_exception,
+                        "Invalid packed array '${p}'", ("p", ctx.get_path_string()) );
+         }
+         out += ']';
+         return true;
+      }
+      case impl::type_plan::kind_t::optional: {
+         char flag;
+         try {
+            fc::raw::unpack(stream, flag);
+         } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack presence flag of optional '${p}'", ("p", ctx.get_path_string()) )
+         if( flag ) return _binary_to_json(*plan.element, stream, out, ctx);
+         out += "null";
+         return false;
+      }
+      case impl::type_plan::kind_t::variant: {
+         ctx.hint_variant_type_if_in_array(plan.variant_itr);
+         fc::unsigned_int select;
+         try {
+            fc::raw::unpack(stream, select);
+         } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack tag of variant '${p}'", ("p", ctx.get_path_string()) )
+         const auto& types = plan.variant_itr->second.types;
+         EOS_ASSERT( (size_t)select < types.size(), unpack_exception,
+                     "Unpacked invalid tag (${select}) for variant '${p}'", ("select", select.value)("p",ctx.get_path_string()) );
+         auto h1 = ctx.push_to_path( impl::variant_path_item{ .variant_itr = plan.variant_itr, .variant_ordinal = static_cast<uint32_t>(select) } );
+         out += "[\"";
+         out += fc::escape_string( types[select], nullptr );
+         out += "\",";
+         _binary_to_json(*plan.variant_types[select], stream, out, ctx);
+         out += ']';
+         return true;
+      }
+      case impl::type_plan::kind_t::other:
+         break;
+      }
+
+      if( plan.kv_table ) {
+         return _binary_to_json(*plan.kv_table, stream, out, ctx);
+      }
+
+      if( plan.duplicate_fields ) {
+         out += fc::json::to_string( _binary_to_variant(plan, stream, ctx), fc::time_point::maximum() );
+         return true;
+      }
+
+      out += '{';
+      size_t field_count = 0;
+      _binary_to_json(plan, stream, out, field_count, ctx);
+      EOS_ASSERT( field_count > 0, unpack_exception, "Unable to unpack '${p}' from stream", ("p", ctx.get_path_string()) );
+      out += '}';
+      return true;
+   }
+
+   bool abi_serializer::_binary_to_json( const std::string_view& type, fc::datastream<const char *>& stream, std::string& out,
+                                         impl::binary_to_variant_context& ctx )const
+   {
+      if( auto plan = find_type_plan(type) ) {
+         return _binary_to_json(*plan, stream, out, ctx);
+      }
+      // types not named by the abi are rare enough to go through the variant
+      auto v = _binary_to_variant(type, stream, ctx);
+      out += fc::json::to_string( v, fc::time_point::maximum() );
+      return !v.is_null();
+   }
+
+   void abi_serializer::binary_to_json( const std::string_view& type, fc::datastream<const char*>& binary, std::string& out,
+                                        const yield_function_t& yield, bool short_path )const {
+      impl::binary_to_variant_context ctx(*this, yield, type);
+      ctx.short_path = short_path;
+      _binary_to_json(type, binary, out, ctx);
+   }
+
+   std::string abi_serializer::binary_to_json( const std::string_view& type, const bytes& binary, const yield_function_t& yield, bool short_path )const {
+      impl::binary_to_variant_context ctx(*this, yield, type);
+      ctx.short_path = short_path;
+      auto h = ctx.enter_scope();
+      fc::datastream<const char*> ds( binary.data(), binary.size() );
+      std::string out;
+      out.reserve( binary.size() * 2 );
+      _binary_to_json(type, ds, out, ctx);
+      return out;
+   }
+
    void abi_serializer::_variant_to_binary( const std::string_view& type, const fc::variant& var, fc::datastream<char *>& ds, impl::variant_to_binary_context& ctx )const
    { try {
+      if( auto plan = find_type_plan(type) ) {
+         _variant_to_binary(*plan, var, ds, ctx);
+         return;
+      }
       auto h = ctx.enter_scope();
       auto rtype = resolve_type(type);
 
@@ -569,6 +988,124 @@ namespace eosio { namespace chain {
       }
    } FC_CAPTURE_AND_RETHROW() }
 
+   void abi_serializer::_variant_to_binary( const impl::type_plan& plan, const fc::variant& var, fc::datastream<char *>& ds, impl::variant_to_binary_context& ctx )const
+   { try {
+      auto h = ctx.enter_scope();
+
+      switch( plan.kind ) {
+      case impl::type_plan::kind_t::built_in:
+         plan.built_in->second(var, ds, plan.is_array, plan.is_optional, ctx.get_yield_function());
+         return;
+      case impl::type_plan::kind_t::array: {
+         ctx.hint_array_type_if_in_array();
+         const auto& vars = var.get_array();
+         fc::raw::pack(ds, (fc::unsigned_int)vars.size());
+
+         auto h1 = ctx.push_to_path( impl::array_index_path_item{} );
+         auto h2 = ctx.disallow_extensions_unless(false);
+
+         int64_t i = 0;
+         for (const auto& var : vars) {
+            ctx.set_array_index_of_path_back(i);
+            _variant_to_binary(*plan.element, var, ds, ctx);
+            ++i;
+         }
+         return;
+      }
+      case impl::type_plan::kind_t::optional: {
+         char flag = !var.is_null();
+         fc::raw::pack(ds, flag);
+         if( flag ) {
+            _variant_to_binary(*plan.element, var, ds, ctx);
+         }
+         return;
+      }
+      case impl::type_plan::kind_t::variant: {
+         ctx.hint_variant_type_if_in_array( plan.variant_itr );
+         const auto& v = plan.variant_itr->second;
+         EOS_ASSERT( var.is_array() && var.size() == 2, pack_exception,
+                    "Expected input to be an array of two items while processing variant '${p}'", ("p", ctx.get_path_string()) );
+         EOS_ASSERT( var[size_t(0)].is_string(), pack_exception,
+                    "Encountered non-string as first item of input array while processing variant '${p}'", ("p", ctx.get_path_string()) );
+         const auto& variant_type_str = var[size_t(0)].get_string();
+         auto it = find(v.types.begin(), v.types.end(), variant_type_str);
+         EOS_ASSERT( it != v.types.end(), pack_exception,
+                     "Specified type '${t}' in input array is not valid within the variant '${p}'",
+                     ("t", ctx.maybe_shorten(variant_type_str))("p", ctx.get_path_string()) );
+         const uint32_t ordinal = static_cast<uint32_t>(it - v.types.begin());
+         fc::raw::pack(ds, fc::unsigned_int(ordinal));
+         auto h1 = ctx.push_to_path( impl::variant_path_item{ .variant_itr = plan.variant_itr, .variant_ordinal = ordinal } );
+         _variant_to_binary( *plan.variant_types[ordinal], var[size_t(1)], ds, ctx );
+         return;
+      }
+      case impl::type_plan::kind_t::other:
+         break;
+      }
+
+      if( plan.is_struct ) {
+         ctx.hint_struct_type_if_in_array( plan.struct_itr );
+         const auto& st = plan.struct_itr->second;
+
+         if( var.is_object() ) {
+            const auto& vo = var.get_object();
+
+            if( plan.base ) {
+               auto h2 = ctx.disallow_extensions_unless(false);
+               _variant_to_binary(*plan.base, var, ds, ctx);
+            }
+            bool disallow_additional_fields = false;
+            for( uint32_t i = 0; i < st.fields.size(); ++i ) {
+               const auto& field = st.fields[i];
+               auto field_itr = vo.find( field.name );
+               if( field_itr != vo.end() ) {
+                  if( disallow_additional_fields )
+                     EOS_THROW( pack_exception, "Unexpected field '${f}' found in input object while processing struct '${p}'",
+                                ("f", ctx.maybe_shorten(field.name))("p", ctx.get_path_string()) );
+                  {
+                     auto h1 = ctx.push_to_path( impl::field_path_item{ .parent_struct_itr = plan.struct_itr, .field_ordinal = i } );
+                     auto h2 = ctx.disallow_extensions_unless( &field == &st.fields.back() );
+                     _variant_to_binary(*plan.fields[i].type, field_itr->value(), ds, ctx);
+                  }
+               } else if( plan.fields[i].extension && ctx.extensions_allowed() ) {
+                  disallow_additional_fields = true;
+               } else if( disallow_additional_fields ) {
+                  EOS_THROW( abi_exception, "Encountered field '${f}' without binary extension designation while processing struct '${p}'",
+                             ("f", ctx.maybe_shorten(field.name))("p", ctx.get_path_string()) );
+               } else {
+                  EOS_THROW( pack_exception, "Missing field '${f}' in input object while processing struct '${p}'",
+                             ("f", ctx.maybe_shorten(field.name))("p", ctx.get_path_string()) );
+               }
+            }
+         } else if( var.is_array() ) {
+            const auto& va = var.get_array();
+            EOS_ASSERT( st.base == type_name(), invalid_type_inside_abi,
+                        "Using input array to specify the fields of the derived struct '${p}'; input arrays are currently only allowed for structs without a base",
+                        ("p",ctx.get_path_string()) );
+            for( uint32_t i = 0; i < st.fields.size(); ++i ) {
+               const auto& field = st.fields[i];
+               if( va.size() > i ) {
+                  auto h1 = ctx.push_to_path( impl::field_path_item{ .parent_struct_itr = plan.struct_itr, .field_ordinal = i } );
+                  auto h2 = ctx.disallow_extensions_unless( &field == &st.fields.back() );
+                  _variant_to_binary(*plan.fields[i].type, va[i], ds, ctx);
+               } else if( plan.fields[i].extension && ctx.extensions_allowed() ) {
+                  break;
+               } else {
+                  EOS_THROW( pack_exception, "Early end to input array specifying the fields of struct '${p}'; require input for field '${f}'",
+                             ("p", ctx.get_path_string())("f", ctx.maybe_shorten(field.name)) );
+               }
+            }
+         } else {
+            EOS_THROW( pack_exception, "Unexpected input encountered while processing struct '${p}'", ("p",ctx.get_path_string()) );
+         }
+      } else if( var.is_object() && plan.kv_name ) {
+         if( plan.kv_table ) {
+            _variant_to_binary( *plan.kv_table, var, ds, ctx );
+         }
+      } else {
+         EOS_THROW( invalid_type_inside_abi, "Unknown type ${type}", ("type",ctx.maybe_shorten(plan.rtype)) );
+      }
+   } FC_CAPTURE_AND_RETHROW() }
+
    bytes abi_serializer::_variant_to_binary( const std::string_view& type, const fc::variant& var, impl::variant_to_binary_context& ctx )const
    { try {
       auto h = ctx.enter_scope();
@@ -0,0 +1,38 @@
+#include <eosio/chain/action_profile.hpp>
+
+#include <algorithm>
+
+namespace eosio { namespace chain {
+
+namespace {
+   // filled during static initialization of the wasm runtimes, read only afterwards
+   std::vector<std::string>& registered_intrinsics() {
+      static std::vector<std::string> names;
+      return names;
+   }
+}
+
+uint32_t action_profiler::register_intrinsic( const char* name ) {
+   auto& names = registered_intrinsics();
+   auto itr = std::find( names.begin(), names.end(), name );
+   if( itr != names.end() ) return itr - names.begin();
+   names.emplace_back( name );
+   return names.size() - 1;
+}
+
+action_profile action_profiler::finalize()const {
+   const auto& names = registered_intrinsics();
+   action_profile result;
+   result.wasm_time = _wasm_time;
+   for( uint32_t id = 0; id < _counts.size(); ++id ) {
+      if( _counts[id] == 0 ) continue;
+      const auto& intrinsic = names[id];
+      result.host_calls += _counts[id];
+      if( intrinsic.compare( 0, 3, "db_" ) == 0 || intrinsic.compare( 0, 3, "kv_" ) == 0 )
+         result.db_calls += _counts[id];
+      result.host_call_counts.push_back( host_call_count{ intrinsic, _counts[id] } );
+   }
+   return result;
+}
+
+} } /// namespace eosio::chain
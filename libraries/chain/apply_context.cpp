@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <eosio/chain/apply_context.hpp>
 #include <eosio/chain/controller.hpp>
+#include <eosio/chain/contract_cpu_sampler.hpp>
 #include <eosio/chain/transaction_context.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/wasm_interface.hpp>
@@ -45,6 +46,7 @@ apply_context::apply_context(controller& con, transaction_context& trx_ctx, uint
 ,idx256(*this)
 ,idx_double(*this)
 ,idx_long_double(*this)
+,_buffers(trx_ctx.acquire_apply_context_buffers())
 {
    kv_iterators.emplace_back(); // the iterator handle with value 0 is reserved
    action_trace& trace = trx_ctx.get_action_trace(action_ordinal);
@@ -52,6 +54,12 @@ apply_context::apply_context(controller& con, transaction_context& trx_ctx, uint
    receiver = trace.receiver;
    context_free = trace.context_free;
    _db_context = control.kv_db().create_db_context(*this, receiver);
+   if( trx_ctx.state_accesses ) state_accesses = &*trx_ctx.state_accesses;
+   if( trx_ctx.table_deltas ) table_deltas = &*trx_ctx.table_deltas;
+}
+
+apply_context::~apply_context() {
+   trx_context.release_apply_context_buffers( std::move(_buffers) );
 }
 
 template <typename Exception>
@@ -99,18 +107,21 @@ void apply_context::exec_one()
    };
 
    try {
+      auto cpu_sample_tag = control.get_contract_cpu_sampler().tag( receiver, act->account, act->name );
       try {
          action_return_value.clear();
+         if( trx_context.profile_actions ) _profiler = std::make_unique<action_profiler>();
          kv_iterators.resize(1);
          kv_destroyed_iterators.clear();
-         if (!context_free) {
-            kv_backing_store = control.kv_db().create_kv_context(receiver, create_kv_resource_manager(*this), control.get_global_properties().kv_configuration);
-        }
+         // created by kv_get_backing_store on the first use of a kv intrinsic, notified accounts without code never use one
+         kv_backing_store.reset();
          receiver_account = &db.get<account_metadata_object,by_name>( receiver );
          if( !(context_free && control.skip_trx_checks()) ) {
             privileged = receiver_account->is_privileged();
             auto native = control.find_apply_handler( receiver, act->account, act->name );
             if( native ) {
+               EOS_ASSERT( !trx_context.read_only, transaction_exception,
+                           "native action ${a}::${n} may not be executed by a read-only transaction", ("a", act->account)("n", act->name) );
                if( trx_context.enforce_whiteblacklist && control.is_producing_block() ) {
                   control.check_contract_list( receiver );
                   control.check_action_list( act->account, act->name );
@@ -129,9 +140,11 @@ void apply_context::exec_one()
                   control.check_contract_list( receiver );
                   control.check_action_list( act->account, act->name );
                }
+               auto wasm_start = _profiler ? fc::time_point::now() : fc::time_point();
                try {
                   control.get_wasm_interface().apply( receiver_account->code_hash, receiver_account->vm_type, receiver_account->vm_version, *this );
                } catch( const wasm_exit& ) {}
+               if( _profiler ) _profiler->add_wasm_time( fc::time_point::now() - wasm_start );
             }
 
             if (!privileged) {
@@ -140,6 +153,7 @@ void apply_context::exec_one()
                }
             }
          }
+         trx_context.flush_ram_usage();
       } FC_RETHROW_EXCEPTIONS( warn, "pending console output: ${console}", ("console", _pending_console_output) )
 
       if( control.is_builtin_activated( builtin_protocol_feature_t::action_return_value ) ) {
@@ -213,6 +227,11 @@ void apply_context::finalize_trace( action_trace& trace, const fc::time_point& s
    _pending_console_output.clear();
 
    trace.elapsed = fc::time_point::now() - start;
+
+   if( _profiler ) {
+      trace.profile = _profiler->finalize();
+      _profiler.reset();
+   }
 }
 
 void apply_context::exec()
@@ -717,11 +736,20 @@ uint32_t apply_context::schedule_action( action&& act_to_schedule, account_name
 }
 
 const table_id_object* apply_context::find_table( name code, name scope, name table ) {
-   return db.find<table_id_object, by_code_scope_table>(boost::make_tuple(code, scope, table));
+   const backing_store::unique_table key{ code, scope, table };
+   auto itr = _table_lookup_cache.find( key );
+   if( itr != _table_lookup_cache.end() )
+      return itr->second;
+
+   // misses are not cached, the table may still be created by this action
+   const auto* tid = db.find<table_id_object, by_code_scope_table>(boost::make_tuple(code, scope, table));
+   if( tid != nullptr )
+      _table_lookup_cache.emplace( key, tid );
+   return tid;
 }
 
 const table_id_object& apply_context::find_or_create_table( name code, name scope, name table, const account_name &payer ) {
-   const auto* existing_tid =  db.find<table_id_object, by_code_scope_table>(boost::make_tuple(code, scope, table));
+   const auto* existing_tid = find_table( code, scope, table );
    if (existing_tid != nullptr) {
       return *existing_tid;
    }
@@ -757,6 +785,7 @@ void apply_context::remove_table( const table_id_object& tid ) {
       db_context::log_remove_table(*dm_logger, get_action_id(), tid.code, tid.scope, tid.table, tid.payer);
    }
 
+   _table_lookup_cache.erase( backing_store::unique_table{ tid.code, tid.scope, tid.table } );
    db.remove(tid);
 }
 
@@ -853,6 +882,8 @@ int apply_context::db_store_i64_chainbase( name scope, name table, const account
 
    EOS_ASSERT( payer != account_name(), invalid_table_payer, "must specify a valid account to pay for new record" );
 
+   record_db_write( receiver, scope, table, id );
+
    const auto& obj = db.create<key_value_object>( [&]( auto& o ) {
       o.t_id        = tableid;
       o.primary_key = id;
@@ -865,6 +896,7 @@ int apply_context::db_store_i64_chainbase( name scope, name table, const account
    });
 
    int64_t billable_size = (int64_t)(buffer_size + config::billable_size_v<key_value_object>);
+   record_table_usage( receiver, table, 1, billable_size );
 
    std::string event_id;
    if (control.get_deep_mind_logger() != nullptr) {
@@ -889,11 +921,14 @@ void apply_context::db_update_i64_chainbase( int iterator, account_name payer, c
 
 //   require_write_lock( table_obj.scope );
 
+   record_db_write( table_obj.code, table_obj.scope, table_obj.table, obj.primary_key );
+
    const int64_t overhead = config::billable_size_v<key_value_object>;
    int64_t old_size = (int64_t)(obj.value.size() + overhead);
    int64_t new_size = (int64_t)(buffer_size + overhead);
 
    if( payer == account_name() ) payer = obj.payer;
+   record_table_usage( table_obj.code, table_obj.table, 0, new_size - old_size );
 
    std::string event_id;
    if (control.get_deep_mind_logger() != nullptr) {
@@ -930,12 +965,15 @@ void apply_context::db_remove_i64_chainbase( int iterator ) {
 
 //   require_write_lock( table_obj.scope );
 
+   record_db_write( table_obj.code, table_obj.scope, table_obj.table, obj.primary_key );
+
    std::string event_id;
    if (control.get_deep_mind_logger() != nullptr) {
       event_id = db_context::table_event(table_obj.code, table_obj.scope, table_obj.table, name(obj.primary_key));
    }
 
    update_db_usage( obj.payer,  -(obj.value.size() + config::billable_size_v<key_value_object>), db_context::row_rem_trace(get_action_id(), std::move(event_id)) );
+   record_table_usage( table_obj.code, table_obj.table, -1, -static_cast<int64_t>( obj.value.size() + config::billable_size_v<key_value_object> ) );
 
    if (auto dm_logger = control.get_deep_mind_logger()) {
       db_context::log_row_remove(*dm_logger, get_action_id(), table_obj.code, table_obj.scope, table_obj.table, obj.payer, name(obj.primary_key), obj.value.data(), obj.value.size());
@@ -971,6 +1009,11 @@ int apply_context::db_next_i64_chainbase( int iterator, uint64_t& primary ) {
    const auto& obj = db_iter_store.get( iterator ); // Check for iterator != -1 happens in this call
    const auto& idx = db.get_index<key_value_index, by_scope_primary>();
 
+   if( state_accesses ) {
+      const auto& table_obj = db_iter_store.get_table( obj.t_id );
+      record_db_range_read( table_obj.code, table_obj.scope, table_obj.table );
+   }
+
    auto itr = idx.iterator_to( obj );
    ++itr;
 
@@ -987,6 +1030,7 @@ int apply_context::db_previous_i64_chainbase( int iterator, uint64_t& primary )
    {
       auto tab = db_iter_store.find_table_by_end_iterator(iterator);
       EOS_ASSERT( tab, invalid_table_iterator, "not a valid end iterator" );
+      record_db_range_read( tab->code, tab->scope, tab->table );
 
       auto itr = idx.upper_bound(tab->id);
       if( idx.begin() == idx.end() || itr == idx.begin() ) return -1; // Empty table
@@ -1001,6 +1045,11 @@ int apply_context::db_previous_i64_chainbase( int iterator, uint64_t& primary )
 
    const auto& obj = db_iter_store.get(iterator); // Check for iterator != -1 happens in this call
 
+   if( state_accesses ) {
+      const auto& table_obj = db_iter_store.get_table( obj.t_id );
+      record_db_range_read( table_obj.code, table_obj.scope, table_obj.table );
+   }
+
    auto itr = idx.iterator_to(obj);
    if( itr == idx.begin() ) return -1; // cannot decrement past beginning iterator of table
 
@@ -1014,6 +1063,7 @@ int apply_context::db_previous_i64_chainbase( int iterator, uint64_t& primary )
 
 int apply_context::db_find_i64_chainbase( name code, name scope, name table, uint64_t id ) {
    //require_read_lock( code, scope ); // redundant?
+   record_db_read( code, scope, table, id );
 
    const auto* tab = find_table( code, scope, table );
    if( !tab ) return -1;
@@ -1026,8 +1076,27 @@ int apply_context::db_find_i64_chainbase( name code, name scope, name table, uin
    return db_iter_store.add( *obj );
 }
 
+int apply_context::db_get_by_id_i64_chainbase( name code, name scope, name table, uint64_t id, char* buffer, size_t buffer_size ) {
+   record_db_read( code, scope, table, id );
+
+   const auto* tab = find_table( code, scope, table );
+   if( !tab ) return -1;
+
+   const key_value_object* obj = db.find<key_value_object, by_scope_primary>( boost::make_tuple( tab->id, id ) );
+   if( !obj ) return -1;
+
+   auto s = obj->value.size();
+   if( buffer_size == 0 ) return s;
+
+   auto copy_size = std::min( buffer_size, s );
+   memcpy( buffer, obj->value.data(), copy_size );
+
+   return copy_size;
+}
+
 int apply_context::db_lowerbound_i64_chainbase( name code, name scope, name table, uint64_t id ) {
    //require_read_lock( code, scope ); // redundant?
+   record_db_range_read( code, scope, table );
 
    const auto* tab = find_table( code, scope, table );
    if( !tab ) return -1;
@@ -1044,6 +1113,7 @@ int apply_context::db_lowerbound_i64_chainbase( name code, name scope, name tabl
 
 int apply_context::db_upperbound_i64_chainbase( name code, name scope, name table, uint64_t id ) {
    //require_read_lock( code, scope ); // redundant?
+   record_db_range_read( code, scope, table );
 
    const auto* tab = find_table( code, scope, table );
    if( !tab ) return -1;
@@ -1060,6 +1130,7 @@ int apply_context::db_upperbound_i64_chainbase( name code, name scope, name tabl
 
 int apply_context::db_end_i64_chainbase( name code, name scope, name table ) {
    //require_read_lock( code, scope ); // redundant?
+   record_db_range_read( code, scope, table );
 
    const auto* tab = find_table( code, scope, table );
    if( !tab ) return -1;
@@ -1068,14 +1139,17 @@ int apply_context::db_end_i64_chainbase( name code, name scope, name table ) {
 }
 
 int64_t apply_context::kv_erase(uint64_t contract, const char* key, uint32_t key_size) {
+   if( state_accesses ) state_accesses->add_kv_write( name(contract), key, key_size );
    return kv_get_backing_store().kv_erase(contract, key, key_size);
 }
 
 int64_t apply_context::kv_set(uint64_t contract, const char* key, uint32_t key_size, const char* value, uint32_t value_size, account_name payer) {
+   if( state_accesses ) state_accesses->add_kv_write( name(contract), key, key_size );
    return kv_get_backing_store().kv_set(contract, key, key_size, value, value_size, payer);
 }
 
 bool apply_context::kv_get(uint64_t contract, const char* key, uint32_t key_size, uint32_t& value_size) {
+   if( state_accesses ) state_accesses->add_kv_read( name(contract), key, key_size );
    return kv_get_backing_store().kv_get(contract, key, key_size, value_size);
 }
 
@@ -1095,6 +1169,7 @@ uint32_t apply_context::kv_it_create(uint64_t contract, const char* prefix, uint
       kv_iterators.emplace_back();
    }
    kv_iterators[itr] = kv_get_backing_store().kv_it_create(contract, prefix, size);
+   if( state_accesses ) state_accesses->add_kv_range_read( name(contract), prefix, size );
    return itr;
 }
 
@@ -1150,6 +1225,14 @@ int32_t apply_context::kv_it_value(uint32_t itr, uint32_t offset, char* dest, ui
    return static_cast<int32_t>(kv_iterators[itr]->kv_it_value(offset, dest, size, actual_size));
 }
 
+kv_context& apply_context::kv_get_backing_store() {
+   EOS_ASSERT( !context_free, action_validate_exception, "KV APIs cannot access state (null backing_store)" );
+   if( !kv_backing_store ) {
+      kv_backing_store = control.kv_db().create_kv_context(receiver, create_kv_resource_manager(*this), control.get_global_properties().kv_configuration);
+   }
+   return *kv_backing_store;
+}
+
 void apply_context::kv_check_iterator(uint32_t itr) {
    EOS_ASSERT(itr < kv_iterators.size() && kv_iterators[itr], kv_bad_iter, "Bad key-value iterator");
 }
@@ -1,5 +1,6 @@
 #include <eosio/chain/asset.hpp>
 #include <boost/rational.hpp>
+#include <charconv>
 #include <fc/reflect/variant.hpp>
 
 namespace eosio { namespace chain {
@@ -17,15 +18,26 @@ int64_t asset::precision()const {
 }
 
 string asset::to_string()const {
-   string sign = amount < 0 ? "-" : "";
-   int64_t abs_amount = std::abs(amount);
-   string result = fc::to_string( static_cast<int64_t>(abs_amount) / precision());
-   if( decimals() )
-   {
-      auto fract = static_cast<int64_t>(abs_amount) % precision();
-      result += "." + fc::to_string(precision() + fract).erase(0,1);
+   // formatted in place: up to 20 digits with the decimal point and a leading zero, a sign, a space and 7 characters
+   char buf[48];
+   char* p = buf;
+   if( amount < 0 ) *p++ = '-';
+   const uint64_t abs_amount = std::abs(amount);
+   const uint64_t prec = precision();
+   p = std::to_chars( p, buf + sizeof(buf), abs_amount / prec ).ptr;
+   if( const uint8_t d = decimals() ) {
+      *p++ = '.';
+      uint64_t fract = abs_amount % prec;
+      for( uint8_t i = d; i > 0; --i ) {
+         p[i - 1] = '0' + fract % 10;
+         fract /= 10;
+      }
+      p += d;
    }
-   return sign + result + " " + symbol_name();
+   *p++ = ' ';
+   for( uint64_t v = sym.value() >> 8; v > 0; v >>= 8 )
+      *p++ = char(v & 0xFF);
+   return string( buf, p );
 }
 
 asset asset::from_string(const string& from)
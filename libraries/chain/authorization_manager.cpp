@@ -29,6 +29,7 @@ namespace eosio { namespace chain {
 
    void authorization_manager::initialize_database() {
       _db.create<permission_object>([](auto&){}); /// reserve perm 0 (used else where)
+      clear_caches();
    }
 
    namespace detail {
@@ -127,6 +128,7 @@ namespace eosio { namespace chain {
             }
          });
       });
+      clear_caches();
    }
 
    const permission_object& authorization_manager::create_permission( account_name account,
@@ -166,6 +168,7 @@ namespace eosio { namespace chain {
             );
          }
       });
+      invalidate_permission({account, name});
       return perm;
    }
 
@@ -206,6 +209,7 @@ namespace eosio { namespace chain {
             );
          }
       });
+      invalidate_permission({account, name});
       return perm;
    }
 
@@ -236,6 +240,7 @@ namespace eosio { namespace chain {
             );
          }
       });
+      invalidate_permission({permission.owner, permission.name});
    }
 
    void authorization_manager::remove_permission( const permission_object& permission, uint32_t action_id) {
@@ -254,7 +259,9 @@ namespace eosio { namespace chain {
          );
       }
 
+      const permission_level level{permission.owner, permission.name};
       _db.remove( permission );
+      invalidate_permission(level);
    }
 
    void authorization_manager::update_permission_usage( const permission_object& permission ) {
@@ -280,12 +287,67 @@ namespace eosio { namespace chain {
       return _db.get<permission_object, by_owner>( boost::make_tuple(level.actor,level.permission) );
    } EOS_RETHROW_EXCEPTIONS( chain::permission_query_exception, "Failed to retrieve permission: ${level}", ("level", level) ) }
 
+   const authority& authorization_manager::get_cached_authority( const permission_level& level )const {
+      auto itr = _authority_cache.find( level );
+      if( itr == _authority_cache.end() ) {
+         itr = _authority_cache.emplace( level, get_permission( level ).auth.to_authority() ).first;
+      }
+      return itr->second;
+   }
+
+   void authorization_manager::trim_authority_cache()const {
+      // only called where no authority_checker holds references into the cache
+      if( _authority_cache.size() > max_cached_entries ) _authority_cache.clear();
+   }
+
+   void authorization_manager::record_change() {
+      _last_change_revision = std::max( _last_change_revision.value_or( _db.revision() ), _db.revision() );
+   }
+
+   void authorization_manager::clear_caches() {
+      _authority_cache.clear();
+      _link_cache.clear();
+      _last_change_revision.reset();
+   }
+
+   void authorization_manager::invalidate_permission( const permission_level& level ) {
+      _authority_cache.erase( level );
+      record_change();
+   }
+
+   void authorization_manager::invalidate_linked_permissions( account_name authorizer_account, scope_name code_account ) {
+      // a contract-wide link applies to every action of the contract, so drop all of them
+      auto itr = _link_cache.lower_bound( link_key_type{authorizer_account, code_account, action_name()} );
+      while( itr != _link_cache.end() && std::get<0>( itr->first ) == authorizer_account
+                                      && std::get<1>( itr->first ) == code_account ) {
+         itr = _link_cache.erase( itr );
+      }
+      record_change();
+   }
+
+   void authorization_manager::on_undo() {
+      // Changes made at a revision are reverted once the revision drops below it. Squashed sessions lower the
+      // revision as well, which merely clears the caches more often than needed.
+      if( _last_change_revision && _db.revision() < *_last_change_revision ) {
+         _authority_cache.clear();
+         _link_cache.clear();
+         // changes below the current revision may still be undone later
+         _last_change_revision = _db.revision();
+      }
+   }
+
    std::optional<permission_name> authorization_manager::lookup_linked_permission( account_name authorizer_account,
                                                                                    account_name scope,
                                                                                    action_name act_name
                                                                                  )const
    {
       try {
+         auto cached = _link_cache.find( link_key_type{authorizer_account, scope, act_name} );
+         if( cached != _link_cache.end() ) {
+            return cached->second;
+         }
+         if( _link_cache.size() > max_cached_entries ) _link_cache.clear();
+
          // First look up a specific link for this message act_name
          auto key = boost::make_tuple(authorizer_account, scope, act_name);
          auto link = _db.find<permission_link_object, by_action_name>(key);
@@ -296,10 +358,12 @@ namespace eosio { namespace chain {
          }
 
          // If no specific or default link found, use active permission
+         std::optional<permission_name> result;
          if (link != nullptr) {
-            return link->required_permission;
+            result = link->required_permission;
          }
-         return std::optional<permission_name>();
+         _link_cache.emplace( link_key_type{authorizer_account, scope, act_name}, result );
+         return result;
       } FC_CAPTURE_AND_RETHROW((authorizer_account)(scope)(act_name))
    }
 
@@ -492,11 +556,13 @@ namespace eosio { namespace chain {
    {
       const auto& checktime = ( static_cast<bool>(_checktime) ? _checktime : _noop_checktime );
 
+      trim_authority_cache();
+
       auto delay_max_limit = fc::seconds( _control.get_global_properties().configuration.max_transaction_delay );
 
       auto effective_provided_delay =  (provided_delay >= delay_max_limit) ? fc::microseconds::maximum() : provided_delay;
 
-      auto checker = make_auth_checker( [&](const permission_level& p){ return get_permission(p).auth; },
+      auto checker = make_auth_checker( [&](const permission_level& p) -> const authority& { return get_cached_authority(p); },
                                         _control.get_global_properties().configuration.max_authority_depth,
                                         provided_keys,
                                         provided_permissions,
@@ -595,9 +661,11 @@ namespace eosio { namespace chain {
    {
       const auto& checktime = ( static_cast<bool>(_checktime) ? _checktime : _noop_checktime );
 
+      trim_authority_cache();
+
       auto delay_max_limit = fc::seconds( _control.get_global_properties().configuration.max_transaction_delay );
 
-      auto checker = make_auth_checker( [&](const permission_level& p){ return get_permission(p).auth; },
+      auto checker = make_auth_checker( [&](const permission_level& p) -> const authority& { return get_cached_authority(p); },
                                         _control.get_global_properties().configuration.max_authority_depth,
                                         provided_keys,
                                         provided_permissions,
@@ -628,7 +696,9 @@ namespace eosio { namespace chain {
                                                                        fc::microseconds provided_delay
                                                                      )const
    {
-      auto checker = make_auth_checker( [&](const permission_level& p){ return get_permission(p).auth; },
+      trim_authority_cache();
+
+      auto checker = make_auth_checker( [&](const permission_level& p) -> const authority& { return get_cached_authority(p); },
                                         _control.get_global_properties().configuration.max_authority_depth,
                                         candidate_keys,
                                         {},
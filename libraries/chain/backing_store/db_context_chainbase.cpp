@@ -48,6 +48,10 @@ namespace eosio { namespace chain { namespace backing_store {
          return context.db_end_i64_chainbase(name(code), name(scope), name(table));
       }
 
+      int32_t db_get_by_id_i64(uint64_t code, uint64_t scope, uint64_t table, uint64_t id, char* buffer, size_t buffer_size) override {
+         return context.db_get_by_id_i64_chainbase(name(code), name(scope), name(table), id, buffer, buffer_size);
+      }
+
       /**
        * interface for uint64_t secondary
        */
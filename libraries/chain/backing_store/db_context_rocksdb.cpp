@@ -32,6 +32,7 @@ namespace eosio { namespace chain { namespace backing_store {
       int32_t db_lowerbound_i64(uint64_t code, uint64_t scope, uint64_t table, uint64_t id) override;
       int32_t db_upperbound_i64(uint64_t code, uint64_t scope, uint64_t table, uint64_t id) override;
       int32_t db_end_i64(uint64_t code, uint64_t scope, uint64_t table) override;
+      int32_t db_get_by_id_i64(uint64_t code, uint64_t scope, uint64_t table, uint64_t id, char* value, size_t value_size) override;
 
       /**
        * interface for uint64_t secondary
@@ -174,6 +175,7 @@ namespace eosio { namespace chain { namespace backing_store {
       EOS_ASSERT( payer != account_name(), invalid_table_payer, "must specify a valid account to pay for new record" );
       const name scope_name{scope};
       const name table_name{table};
+      context.record_db_write(receiver, scope_name, table_name, id);
       const auto old_key_value = get_primary_key_value(receiver, scope_name, table_name, id);
 
       EOS_ASSERT( !old_key_value.value, db_rocksdb_invalid_operation_exception, "db_store_i64 called with pre-existing key");
@@ -184,6 +186,7 @@ namespace eosio { namespace chain { namespace backing_store {
       set_value(old_key_value.full_key, pp);
 
       const int64_t billable_size = static_cast<int64_t>(value_size + db_key_value_any_lookup::overhead);
+      context.record_table_usage(receiver, table_name, 1, billable_size);
 
       std::string event_id;
       auto dm_logger = context.control.get_deep_mind_logger();
@@ -207,6 +210,7 @@ namespace eosio { namespace chain { namespace backing_store {
       const auto& key_store = primary_iter_store.get(itr);
       const auto& table_store = primary_iter_store.get_table(key_store);
       EOS_ASSERT( table_store.contract == receiver, table_access_violation, "db access violation" );
+      context.record_db_write(receiver, table_store.scope, table_store.table, key_store.primary);
       const auto old_key_value = get_primary_key_value(receiver, table_store.scope, table_store.table, key_store.primary);
 
       EOS_ASSERT( old_key_value.value, db_rocksdb_invalid_operation_exception,
@@ -233,6 +237,7 @@ namespace eosio { namespace chain { namespace backing_store {
       const int64_t overhead = db_key_value_any_lookup::overhead;
       const int64_t old_size = static_cast<int64_t>(old_value_actual_size + overhead);
       const int64_t new_size = static_cast<int64_t>(value_size + overhead);
+      context.record_table_usage(receiver, table_store.table, 0, new_size - old_size);
 
       if( old_payer != payer ) {
          // refund the existing payer
@@ -258,6 +263,7 @@ namespace eosio { namespace chain { namespace backing_store {
       const auto& key_store = primary_iter_store.get(itr);
       const auto& table_store = primary_iter_store.get_table(key_store);
       EOS_ASSERT( table_store.contract == receiver, table_access_violation, "db access violation" );
+      context.record_db_write(receiver, table_store.scope, table_store.table, key_store.primary);
       const auto old_key_value = get_primary_key_value(receiver, table_store.scope, table_store.table, key_store.primary);
 
       EOS_ASSERT( old_key_value.value, db_rocksdb_invalid_operation_exception,
@@ -273,6 +279,7 @@ namespace eosio { namespace chain { namespace backing_store {
 
       payer_payload pp(*old_key_value.value);
       update_db_usage( old_payer,  -(pp.value_size + db_key_value_any_lookup::overhead), db_context::row_rem_trace(context.get_action_id(), std::move(event_id)) );
+      context.record_table_usage(receiver, table_store.table, -1, -static_cast<int64_t>(pp.value_size + db_key_value_any_lookup::overhead));
 
       if (dm_logger != nullptr) {
          db_context::log_row_remove(*dm_logger, context.get_action_id(), table_store.contract, table_store.scope,
@@ -309,6 +316,7 @@ namespace eosio { namespace chain { namespace backing_store {
 
       const auto& key_store = primary_iter_store.get(itr);
       const auto& table_store = primary_iter_store.get_table(key_store);
+      context.record_db_range_read(table_store.contract, table_store.scope, table_store.table);
       auto exact =
             get_exact_iterator(table_store.contract, table_store.scope, table_store.table, key_store.primary);
       EOS_ASSERT( exact.valid, db_rocksdb_invalid_operation_exception,
@@ -324,6 +332,7 @@ namespace eosio { namespace chain { namespace backing_store {
       if( itr < primary_iter_store.invalid_iterator() ) { // is end iterator
          const backing_store::unique_table* table_store = primary_iter_store.find_table_by_end_iterator(itr);
          EOS_ASSERT( table_store, invalid_table_iterator, "not a valid end iterator" );
+         context.record_db_range_read(table_store->contract, table_store->scope, table_store->table);
          if (current_session.begin() == current_session.end()) {
             // NOTE: matching chainbase functionality, if iterator store found, but no keys in db
             return primary_iter_store.invalid_iterator();
@@ -354,6 +363,7 @@ namespace eosio { namespace chain { namespace backing_store {
 
       const auto& key_store = primary_iter_store.get(itr);
       const backing_store::unique_table& table_store = primary_iter_store.get_table(key_store);
+      context.record_db_range_read(table_store.contract, table_store.scope, table_store.table);
       const auto slice_primary_key = get_primary_slice_in_primaries(table_store.contract, table_store.scope, table_store.table, key_store.primary);
       auto exact = get_exact_iterator(table_store.contract, table_store.scope, table_store.table, key_store.primary);
       auto& session_iter = exact.itr;
@@ -381,9 +391,26 @@ namespace eosio { namespace chain { namespace backing_store {
    }
 
    int32_t db_context_rocksdb::db_end_i64(uint64_t code, uint64_t scope, uint64_t table) {
+      context.record_db_range_read(name{code}, name{scope}, name{table});
       return primary_lookup.get_end_iter(name{code}, name{scope}, name{table}, primary_iter_store);
    }
 
+   int32_t db_context_rocksdb::db_get_by_id_i64(uint64_t code, uint64_t scope, uint64_t table, uint64_t id, char* value, size_t value_size) {
+      context.record_db_read(name{code}, name{scope}, name{table}, id);
+      const auto key_value = get_primary_key_value(name{code}, name{scope}, name{table}, id);
+      if (!key_value.value) {
+         return -1;
+      }
+      payer_payload pp {*key_value.value};
+      const size_t actual_size = pp.value_size;
+      if (value_size == 0) {
+         return actual_size;
+      }
+      const size_t copy_size = std::min<size_t>(value_size, actual_size);
+      memcpy( value, pp.value, copy_size );
+      return copy_size;
+   }
+
    /**
     * interface for uint64_t secondary
     */
@@ -697,6 +724,11 @@ namespace eosio { namespace chain { namespace backing_store {
    }
 
    int32_t db_context_rocksdb::find_i64(name code, name scope, name table, uint64_t id, comp comparison) {
+      if (comparison == comp::equals) {
+         context.record_db_read(code, scope, table, id);
+      } else {
+         context.record_db_range_read(code, scope, table);
+      }
       // expanding the "in-play" iterator space to include every key type for that table, to ensure we know if
       // the key is not found, that there is anything in the table at all (and thus can return an end iterator
       // or if an invalid iterator needs to be returned
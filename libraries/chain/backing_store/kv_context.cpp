@@ -13,6 +13,10 @@ namespace eosio { namespace chain {
          }
 
          context.update_db_usage(payer, delta, storage_usage_trace(context.get_action_id(), std::move(event_id), "kv", trace.op_to_string()));
+
+         const int64_t rows = trace.op == kv_resource_trace::operation::create ? 1
+                            : trace.op == kv_resource_trace::operation::erase ? -1 : 0;
+         context.record_kv_table_usage(trace.key.data(), trace.key.size(), rows, delta);
       }
    }
    kv_resource_manager create_kv_resource_manager(apply_context& context) {
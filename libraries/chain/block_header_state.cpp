@@ -1,5 +1,6 @@
 #include <eosio/chain/block_header_state.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <array>
 #include <limits>
 
 namespace eosio { namespace chain {
@@ -15,23 +16,33 @@ namespace eosio { namespace chain {
       }
    }
 
-   producer_authority block_header_state::get_scheduled_producer( block_timestamp_type t )const {
+   const producer_authority& block_header_state::get_scheduled_producer( block_timestamp_type t )const {
       auto index = t.slot % (active_schedule.producers.size() * config::producer_repetitions);
       index /= config::producer_repetitions;
       return active_schedule.producers[index];
    }
 
    uint32_t block_header_state::calc_dpos_last_irreversible( account_name producer_of_next_block )const {
-      vector<uint32_t> blocknums; blocknums.reserve( producer_to_last_implied_irb.size() );
+      const auto num_producers = producer_to_last_implied_irb.size();
+      if( num_producers == 0 ) return 0;
+
+      // runs for every block; schedules never exceed max_producers so the scratch space normally stays on the stack
+      std::array<uint32_t, config::max_producers> stack_blocknums;
+      vector<uint32_t>                            heap_blocknums;
+      uint32_t* blocknums = stack_blocknums.data();
+      if( num_producers > stack_blocknums.size() ) {
+         heap_blocknums.resize( num_producers );
+         blocknums = heap_blocknums.data();
+      }
+
+      std::size_t n = 0;
       for( auto& i : producer_to_last_implied_irb ) {
-         blocknums.push_back( (i.first == producer_of_next_block) ? dpos_proposed_irreversible_blocknum : i.second);
+         blocknums[n++] = (i.first == producer_of_next_block) ? dpos_proposed_irreversible_blocknum : i.second;
       }
       /// 2/3 must be greater, so if I go 1/3 into the list sorted from low to high, then 2/3 are greater
 
-      if( blocknums.size() == 0 ) return 0;
-
-      std::size_t index = (blocknums.size()-1) / 3;
-      std::nth_element( blocknums.begin(),  blocknums.begin() + index, blocknums.end() );
+      std::size_t index = (num_producers-1) / 3;
+      std::nth_element( blocknums,  blocknums + index, blocknums + num_producers );
       return blocknums[ index ];
    }
 
@@ -46,7 +57,7 @@ namespace eosio { namespace chain {
         (when = header.timestamp).slot++;
       }
 
-      auto proauth = get_scheduled_producer(when);
+      const auto& proauth = get_scheduled_producer(when);
 
       auto itr = producer_to_last_produced.find( proauth.producer_name );
       if( itr != producer_to_last_produced.end() ) {
@@ -6,9 +6,20 @@
 #include <eosio/chain/block_log_config.hpp>
 #include <eosio/chain/thread_utils.hpp>
 #include <fc/bitutil.hpp>
+#include <fc/io/fstream.hpp>
+#include <fc/io/json.hpp>
 #include <fc/io/raw.hpp>
 #include <future>
+#include <mutex>
 #include <regex>
+#include <unordered_map>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef EOSIO_BLOCK_LOG_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
 
 namespace eosio { namespace chain {
 
@@ -21,22 +32,29 @@ namespace eosio { namespace chain {
     *            from block 1
     * Version 4: changes the block entry from the serialization of signed_block to a tuple of offset to next entry,
     *            compression_status and pruned_block.
+    * Version 5: adds the zstd dictionary of the file to the preamble, the block of an entry may be compressed with it
+    *            after the block header. Only written when zstd compression is enabled, new files are version 4
+    *            otherwise so that they stay readable by older tools.
     */
 
    enum versions {
       initial_version = 1,
       block_x_start_version = 2,
       genesis_state_or_chain_id_version = 3,
-      pruned_transaction_version = 4
+      pruned_transaction_version = 4,
+      compressed_block_version = 5
    };
 
    const uint32_t block_log::min_supported_version = initial_version;
-   const uint32_t block_log::max_supported_version = pruned_transaction_version;
+   const uint32_t block_log::max_supported_version = compressed_block_version;
+   const uint32_t block_log::default_version = pruned_transaction_version;
+   const char* const block_log::chunk_manifest_name = "blocks-manifest.json";
 
    struct block_log_preamble {
       uint32_t version         = 0;
       uint32_t first_block_num = 0;
       std::variant<genesis_state, chain_id_type> chain_context;
+      std::vector<char> dictionary; // version 5 and later, the zstd dictionary of the compressed entries, may be empty
 
       chain_id_type chain_id() const {
          return std::visit(overloaded{[](const chain_id_type& id) { return id; },
@@ -44,9 +62,6 @@ namespace eosio { namespace chain {
                            chain_context);
       }
 
-      constexpr static int nbytes_with_chain_id = // the bytes count when the preamble contains chain_id
-          sizeof(version) + sizeof(first_block_num) + sizeof(chain_id_type) + sizeof(block_log::npos);
-
       void read_from(fc::datastream<const char*>& ds, const fc::path& log_path) {
         ds.read((char*)&version, sizeof(version));
          EOS_ASSERT(version > 0, block_log_exception, "Block log was not setup properly");
@@ -74,6 +89,10 @@ namespace eosio { namespace chain {
                       ("ver", version)("fbn", first_block_num));
          }
 
+         if (version >= compressed_block_version) {
+            fc::raw::unpack(ds, dictionary);
+         }
+
          if (version != initial_version) {
             auto                                    expected_totem = block_log::npos;
             std::decay_t<decltype(block_log::npos)> actual_totem;
@@ -100,6 +119,11 @@ namespace eosio { namespace chain {
                                   }}, 
                        chain_context);
 
+            if (version >= compressed_block_version) {
+               auto data = fc::raw::pack(dictionary);
+               ds.write(data.data(), data.size());
+            }
+
             auto totem = block_log::npos;
             ds.write(reinterpret_cast<const char*>(&totem), sizeof(totem));
          }
@@ -116,10 +140,19 @@ namespace eosio { namespace chain {
          //    1. An uint32_t size for number of bytes from the start of this log entry to the start of the next log entry.
          //    2. An uint8_t indicating the compression status for the serialization of the pruned_block following this.
          //    3. The serialization of a signed_block representation of the block for the entry including padding.
+         // Only segment compression type none is written or accepted so far: the prunable data of a transaction keeps
+         // room for a digest so context free data can be pruned in place, and compressing segments (see the TODO in
+         // padded_pack_size in transaction.cpp) has to preserve that before any other type can be enabled.
+         //
+         // Version 5 entries are the same, except that zstd_entry_flag may be set in the compression status. The
+         // serialization of the block then stops after the block header and is followed by an uint32_t size and a
+         // zstd frame of the rest of the serialization, compressed with the dictionary in the preamble. Such an entry
+         // has no padding: pruning compresses the block again in the space of the entry.
 
          struct metadata_type {
             packed_transaction::cf_compression_type compression = packed_transaction::cf_compression_type::none;
             uint32_t size = 0; // the size of the log entry
+            bool     zstd = false;
          };
 
          metadata_type meta;
@@ -140,19 +173,136 @@ namespace eosio { namespace chain {
          return version >= pruned_transaction_version ? sizeof(uint32_t) + 1 : 0;
       }
 
+      /// set in the compression status of a version 5 entry whose block is compressed with zstd
+      constexpr uint8_t zstd_entry_flag = 0x80;
+
+      /// Compresses and decompresses the blocks of the entries of a version 5 file with the zstd dictionary in its
+      /// preamble, or without a dictionary when it is empty
+      class entry_codec {
+       public:
+         entry_codec(const std::vector<char>& dictionary, int level);
+
+         std::vector<char> compress(const char* data, size_t size) const;
+         std::vector<char> decompress(const char* data, size_t size) const;
+
+       private:
+#ifdef EOSIO_BLOCK_LOG_ZSTD
+         std::vector<char> dictionary;
+         int               level;
+         uint32_t          dict_id = 0;
+         // only created when the file is written to
+         mutable std::once_flag                                          cdict_once;
+         mutable std::unique_ptr<ZSTD_CDict, decltype(&ZSTD_freeCDict)> cdict{nullptr, &ZSTD_freeCDict};
+         std::unique_ptr<ZSTD_DDict, decltype(&ZSTD_freeDDict)>         ddict{nullptr, &ZSTD_freeDDict};
+#endif
+      };
+
+#ifdef EOSIO_BLOCK_LOG_ZSTD
+      void check_zstd(size_t r, const char* what) {
+         EOS_ASSERT(!ZSTD_isError(r), block_log_exception, "${w}: ${e}", ("w", what)("e", ZSTD_getErrorName(r)));
+      }
+
+      // contexts are reused by the calls of a thread
+      ZSTD_CCtx& cctx() {
+         thread_local std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> ctx(ZSTD_createCCtx(), &ZSTD_freeCCtx);
+         return *ctx;
+      }
+
+      ZSTD_DCtx& dctx() {
+         thread_local std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> ctx(ZSTD_createDCtx(), &ZSTD_freeDCtx);
+         return *ctx;
+      }
+
+      entry_codec::entry_codec(const std::vector<char>& dictionary, int level)
+          : dictionary(dictionary), level(level) {
+         if (dictionary.empty())
+            return;
+         dict_id = ZDICT_getDictID(dictionary.data(), dictionary.size());
+         EOS_ASSERT(dict_id != 0, block_log_exception, "invalid zstd dictionary in block log");
+         ddict.reset(ZSTD_createDDict(dictionary.data(), dictionary.size()));
+         EOS_ASSERT(ddict, block_log_exception, "unable to load zstd dictionary of block log");
+      }
+
+      std::vector<char> entry_codec::compress(const char* data, size_t size) const {
+         if (dict_id) {
+            std::call_once(cdict_once, [this]() {
+               cdict.reset(ZSTD_createCDict(dictionary.data(), dictionary.size(), level));
+            });
+            EOS_ASSERT(cdict, block_log_exception, "unable to load zstd dictionary of block log");
+         }
+         std::vector<char> result(ZSTD_compressBound(size));
+         size_t r = dict_id ? ZSTD_compress_usingCDict(&cctx(), result.data(), result.size(), data, size, cdict.get())
+                            : ZSTD_compressCCtx(&cctx(), result.data(), result.size(), data, size, level);
+         check_zstd(r, "zstd compression of block failed");
+         result.resize(r);
+         return result;
+      }
+
+      std::vector<char> entry_codec::decompress(const char* data, size_t size) const {
+         auto frame_dict_id = ZSTD_getDictID_fromFrame(data, size);
+         EOS_ASSERT(frame_dict_id == dict_id, block_log_exception,
+                    "zstd frame of block needs dictionary ${id}, the block log has dictionary ${dict}",
+                    ("id", frame_dict_id)("dict", dict_id));
+         auto content_size = ZSTD_getFrameContentSize(data, size);
+         EOS_ASSERT(content_size != ZSTD_CONTENTSIZE_UNKNOWN && content_size != ZSTD_CONTENTSIZE_ERROR &&
+                    content_size <= std::numeric_limits<uint32_t>::max(), block_log_exception, "invalid zstd frame of block");
+         std::vector<char> result(content_size);
+         size_t r = dict_id ? ZSTD_decompress_usingDDict(&dctx(), result.data(), result.size(), data, size, ddict.get())
+                            : ZSTD_decompressDCtx(&dctx(), result.data(), result.size(), data, size);
+         check_zstd(r, "zstd decompression of block failed");
+         EOS_ASSERT(r == content_size, block_log_exception, "zstd frame of block is truncated");
+         return result;
+      }
+#else
+      entry_codec::entry_codec(const std::vector<char>&, int) {}
+
+      std::vector<char> entry_codec::compress(const char*, size_t) const {
+         EOS_THROW(block_log_exception, "built without zstd");
+      }
+
+      std::vector<char> entry_codec::decompress(const char*, size_t) const {
+         EOS_THROW(block_log_exception, "built without zstd, unable to read zstd compressed block log entry");
+      }
+#endif
+
+      /// unpack a block whose serialization after the block header is a zstd frame
       template <typename Stream>
-      log_entry_v4::metadata_type unpack(Stream& ds, signed_block& block){
+      void unpack_compressed(Stream& ds, signed_block& block, const entry_codec& codec, const log_entry_v4::metadata_type& meta) {
+         block_header header;
+         fc::raw::unpack(ds, header);
+         uint32_t frame_size;
+         fc::raw::unpack(ds, frame_size);
+         EOS_ASSERT(frame_size < meta.size, block_log_exception, "Invalid zstd frame size in block log entry");
+         std::vector<char> frame(frame_size);
+         ds.read(frame.data(), frame.size());
+
+         auto buffer = fc::raw::pack(header);
+         auto rest   = codec.decompress(frame.data(), frame.size());
+         buffer.insert(buffer.end(), rest.begin(), rest.end());
+         fc::datastream<const char*> block_ds(buffer.data(), buffer.size());
+         block.unpack(block_ds, meta.compression);
+      }
+
+      template <typename Stream>
+      log_entry_v4::metadata_type unpack(Stream& ds, signed_block& block, const entry_codec* codec){
          log_entry_v4::metadata_type meta;
          const auto                  start_pos = ds.tellp();
          fc::raw::unpack(ds, meta.size);
          uint8_t compression;
          fc::raw::unpack(ds, compression);
+         meta.zstd = compression & zstd_entry_flag;
+         compression &= ~zstd_entry_flag;
          EOS_ASSERT(compression < static_cast<uint8_t>(packed_transaction::cf_compression_type::COMPRESSION_TYPE_COUNT), block_log_exception, 
                   "Unknown compression_type");
          meta.compression = static_cast<packed_transaction::cf_compression_type>(compression);
          EOS_ASSERT(meta.compression == packed_transaction::cf_compression_type::none, block_log_exception,
                   "Only support compression_type none");         
-         block.unpack(ds, meta.compression);
+         if (meta.zstd) {
+            EOS_ASSERT(codec, block_log_exception, "zstd compressed block log entry in a block log which does not support it");
+            unpack_compressed(ds, block, *codec, meta);
+         } else {
+            block.unpack(ds, meta.compression);
+         }
          const uint64_t current_stream_offset = ds.tellp() - start_pos;
          // For a block which contains CFD (context free data) and the CFD is pruned afterwards, the entry.size may
          // be the size before the CFD has been pruned while the actual serialized block does not have the CFD anymore.
@@ -166,14 +316,33 @@ namespace eosio { namespace chain {
       }
 
       template <typename Stream>
-      void unpack(Stream& ds, log_entry_v4& entry){
-         entry.meta = unpack(ds, entry.block);
+      void unpack(Stream& ds, log_entry_v4& entry, const entry_codec* codec){
+         entry.meta = unpack(ds, entry.block, codec);
       }
 
-      std::vector<char> pack(const signed_block& block, packed_transaction::cf_compression_type compression) {
+      /// pack the entry of a block without its position, the block is compressed when a codec is given
+      std::vector<char> pack(const signed_block& block, packed_transaction::cf_compression_type compression,
+                             const entry_codec* codec) {
+         static_assert( block_log::max_supported_version == compressed_block_version,
+                     "Code was written to support format of version 5, need to update this code for latest format." );
+         if (codec) {
+            const auto        data        = fc::raw::pack(block);
+            const std::size_t header_size = fc::raw::pack_size(static_cast<const block_header&>(block));
+            const auto        frame       = codec->compress(data.data() + header_size, data.size() - header_size);
+            std::vector<char> buffer(offset_to_block_start(block_log::max_supported_version) + header_size +
+                                     sizeof(uint32_t) + frame.size());
+            fc::datastream<char*> stream(buffer.data(), buffer.size());
+
+            const uint32_t size = buffer.size() + sizeof(uint64_t);
+            stream.write((char*)&size, sizeof(size));
+            fc::raw::pack(stream, static_cast<uint8_t>(static_cast<uint8_t>(compression) | zstd_entry_flag));
+            stream.write(data.data(), header_size);
+            fc::raw::pack(stream, static_cast<uint32_t>(frame.size()));
+            stream.write(frame.data(), frame.size());
+            return buffer;
+         }
+
          const std::size_t padded_size = block.maximum_pruned_pack_size(compression);
-         static_assert( block_log::max_supported_version == pruned_transaction_version,
-                     "Code was written to support format of version 4, need to update this code for latest format." );
          std::vector<char>     buffer(padded_size + offset_to_block_start(block_log::max_supported_version));
          fc::datastream<char*> stream(buffer.data(), buffer.size());
 
@@ -193,10 +362,10 @@ namespace eosio { namespace chain {
       }
 
       template <typename Stream>
-      void unpack(Stream& ds, log_entry& entry) {
+      void unpack(Stream& ds, log_entry& entry, const entry_codec* codec) {
          std::visit(
              overloaded{[&ds](signed_block_v0& v) { fc::raw::unpack(ds, v); }, 
-                        [&ds](log_entry_v4& v) { unpack(ds, v); }},
+                        [&ds, codec](log_entry_v4& v) { unpack(ds, v, codec); }},
              entry);
       }
 
@@ -233,11 +402,12 @@ namespace eosio { namespace chain {
    };
 
    template <typename Stream>
-   std::unique_ptr<signed_block> read_block(Stream&& ds, uint32_t version, uint32_t expect_block_num = 0) {
+   std::unique_ptr<signed_block> read_block(Stream&& ds, uint32_t version, const entry_codec* codec,
+                                            uint32_t expect_block_num = 0) {
       std::unique_ptr<signed_block> block;
       if (version >= pruned_transaction_version) {
          block = std::make_unique<signed_block>();
-         unpack(ds, *block);
+         unpack(ds, *block, codec);
       } else {
          signed_block_v0 block_v0;
          fc::raw::unpack(ds, block_v0);
@@ -259,7 +429,8 @@ namespace eosio { namespace chain {
          uint8_t  compression;
          fc::raw::unpack(ds, size);
          fc::raw::unpack(ds, compression);
-         EOS_ASSERT(compression == static_cast<uint8_t>(packed_transaction::cf_compression_type::none),
+         // the block header is not compressed in an entry flagged with zstd_entry_flag
+         EOS_ASSERT((compression & ~zstd_entry_flag) == static_cast<uint8_t>(packed_transaction::cf_compression_type::none),
                      block_log_exception, "Only \"none\" compression type is supported.");
       }
       block_header bh;
@@ -276,6 +447,7 @@ namespace eosio { namespace chain {
    class block_log_data : public chain::log_data_base<block_log_data> {
       block_log_preamble                   preamble;
       uint64_t                             first_block_pos = block_log::npos;
+      std::shared_ptr<entry_codec>         codec; // only for version 5 or later
    public:
 
      block_log_data() = default;
@@ -290,8 +462,13 @@ namespace eosio { namespace chain {
         fc::datastream<const char*> ds(this->data(), this->size());
         preamble.read_from(ds, path);
         first_block_pos = ds.tellp();
+        codec = preamble.version >= compressed_block_version
+                    ? std::make_shared<entry_codec>(preamble.dictionary, block_log_config{}.zstd_level)
+                    : nullptr;
         return ds;
       }
+
+      const entry_codec* get_codec() const { return codec.get(); }
       
       uint32_t      version() const { return preamble.version; }
       uint32_t      first_block_num() const { return preamble.first_block_num; }
@@ -352,11 +529,12 @@ namespace eosio { namespace chain {
        *  @returns The tuple of block number and block id in the entry
        **/
       static std::tuple<uint32_t, block_id_type> 
-      full_validate_block_entry(fc::datastream<const char*>& ds, uint32_t previous_block_num, const block_id_type& previous_block_id, log_entry& entry) {
+      full_validate_block_entry(fc::datastream<const char*>& ds, uint32_t previous_block_num, const block_id_type& previous_block_id,
+                                log_entry& entry, const entry_codec* codec) {
          uint64_t pos = ds.tellp();
 
          try {
-            unpack(ds, entry);
+            unpack(ds, entry, codec);
          } catch (...) {
             throw bad_block_exception{std::current_exception()};
          }
@@ -476,8 +654,22 @@ namespace eosio { namespace chain {
       index_writer index(index_file_path, num_blocks);
       uint32_t     blocks_found = 0;
 
+      // The walk goes backwards one entry at a time, which defeats the kernel's readahead: on a large log every block
+      // costs a synchronous page fault. Ask for the window below the cursor ahead of time so it is read in bulk.
+      constexpr uint64_t prefetch_window = 64 * 1024 * 1024;
+      const uint64_t     page_mask       = static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) - 1;
+      uint64_t           prefetched_from = this->size();
+      auto prefetch_below = [&](uint64_t position) {
+         if (prefetched_from == 0 || position > prefetched_from + prefetch_window / 2)
+            return;
+         const uint64_t from = (prefetched_from > prefetch_window ? prefetched_from - prefetch_window : 0) & ~page_mask;
+         madvise(const_cast<char*>(this->data()) + from, prefetched_from - from, MADV_WILLNEED);
+         prefetched_from = from;
+      };
+
       for (auto iter = make_reverse_block_position_iterator(*this);
            iter.get_value() != block_log::npos && blocks_found < num_blocks; ++iter, ++blocks_found) {
+         prefetch_below(iter.current_position);
          index.write(iter.get_value());
       }
 
@@ -527,6 +719,21 @@ namespace eosio { namespace chain {
          const size_t              stride;
          static uint32_t           default_version;
 
+         // zstd compression of the blocks, the codecs are only set for files of version 5 or later
+         const bool                   zstd_compression;
+         std::vector<char>            new_file_dictionary;
+         std::shared_ptr<entry_codec> new_file_codec;
+         std::shared_ptr<entry_codec> codec;        // of blocks.log
+         std::shared_ptr<entry_codec> future_codec; // of the file the next future is packed for
+         std::vector<char>         read_buffer;
+         std::mutex                read_mtx; // reads share the file positions and read_buffer, e.g. with the replay prefetch thread
+
+         // transaction id index, only maintained when config.trx_index is set
+         bool                                         trx_index_enabled = false;
+         fc::datastream<fc::cfile>                    trx_index_file;
+         std::unordered_multimap<uint64_t, uint32_t>  trx_index; // first 8 bytes of transaction id -> block num
+         uint32_t                                     trx_index_last_block_num = 0;
+
          explicit block_log_impl(const block_log::config_type& config);
 
          static void ensure_file_exists(fc::cfile& f) {
@@ -538,8 +745,23 @@ namespace eosio { namespace chain {
 
          uint64_t get_block_pos(uint32_t block_num);
 
+         // Returns the end of the block's entry, excluding the trailing position. Requires get_block_pos(block_num) != npos.
+         uint64_t get_block_end(uint32_t block_num);
+
          void reset(uint32_t first_block_num, std::variant<genesis_state, chain_id_type>&& chain_context);
 
+         // version of the blocks.log started by split_log
+         uint32_t split_version() const {
+            return zstd_compression ? compressed_block_version : block_log::default_version;
+         }
+
+         // set the dictionary and codec of a new blocks.log once its preamble.version is set
+         void init_new_file_codec();
+
+         const entry_codec* write_codec(const std::shared_ptr<entry_codec>& c) const {
+            return zstd_compression ? c.get() : nullptr;
+         }
+
          void flush();
 
          uint64_t append(const signed_block_ptr& b, packed_transaction::cf_compression_type segment_compression);
@@ -558,8 +780,13 @@ namespace eosio { namespace chain {
          block_id_type                 read_block_id_by_num(uint32_t block_num);
          std::unique_ptr<signed_block> read_block_by_num(uint32_t block_num);
          void                          read_head();
+
+         void                    open_trx_index(const fc::path& path);
+         void                    reset_trx_index(uint32_t last_block_num);
+         void                    append_trx_index(const signed_block& b);
+         std::optional<uint32_t> find_block_num_by_trx_id(const transaction_id_type& id);
       };
-      uint32_t block_log_impl::default_version = block_log::max_supported_version;
+      uint32_t block_log_impl::default_version = block_log::default_version;
    } // namespace detail
 
    block_log::block_log(const block_log::config_type& config)
@@ -573,7 +800,17 @@ namespace eosio { namespace chain {
 
    detail::block_log_impl::block_log_impl(const block_log::config_type& config)
    : stride( config.stride )
+   , zstd_compression( config.zstd_compression )
    {
+      EOS_ASSERT( !zstd_compression || block_log::zstd_supported(), block_log_exception,
+                  "zstd compression of the block log is not supported, built without zstd" );
+      if (zstd_compression && !config.zstd_dictionary.empty()) {
+         auto file = config.zstd_dictionary.is_relative() ? config.log_dir / config.zstd_dictionary : config.zstd_dictionary;
+         std::string content;
+         fc::read_file_contents(file, content);
+         new_file_dictionary.assign(content.begin(), content.end());
+      }
+      new_file_codec = std::make_shared<entry_codec>(new_file_dictionary, config.zstd_level);
 
       if (!fc::is_directory(config.log_dir))
          fc::create_directories(config.log_dir);
@@ -612,6 +849,9 @@ namespace eosio { namespace chain {
          block_log_data log_data(block_file.get_file_path());
          preamble = log_data.get_preamble();
          future_version = preamble.version;
+         if (preamble.version >= compressed_block_version)
+            codec = std::make_shared<entry_codec>(preamble.dictionary, config.zstd_level);
+         future_codec = codec;
 
          EOS_ASSERT(catalog.verifier.chain_id.empty() || catalog.verifier.chain_id == preamble.chain_id(), block_log_exception,
                     "block log file ${path} has a different chain id", ("path", block_file.get_file_path()));
@@ -658,13 +898,17 @@ namespace eosio { namespace chain {
       index_file.open(fc::cfile::update_rw_mode);
       if (log_size)
          read_head();
+
+      if (config.trx_index)
+         open_trx_index(config.log_dir / "blocks.trx_index");
    }
 
-   std::vector<char> create_block_buffer( const signed_block& b, uint32_t version, packed_transaction::cf_compression_type segment_compression ) {
+   std::vector<char> create_block_buffer( const signed_block& b, uint32_t version, packed_transaction::cf_compression_type segment_compression,
+                                          const entry_codec* codec ) {
       std::vector<char> buffer;
 
       if (version >= pruned_transaction_version)  {
-         buffer = pack(b, segment_compression);
+         buffer = pack(b, segment_compression, codec);
       } else {
          auto block_ptr = b.to_signed_block_v0();
          EOS_ASSERT(block_ptr, block_log_append_fail, "Unable to convert block to legacy format");
@@ -682,7 +926,6 @@ namespace eosio { namespace chain {
       block_file.write(block_buffer.data(), block_buffer.size());
       block_file.write((char*)&pos, sizeof(pos));
       index_file.write((char*)&pos, sizeof(pos));
-      flush();
       return pos;
    }
 
@@ -702,8 +945,10 @@ namespace eosio { namespace chain {
                    ("position", (uint64_t) index_file.tellp())
                    ("expected", (b->block_num() - preamble.first_block_num) * sizeof(uint64_t)));
 
-         std::vector<char> buffer = create_block_buffer( *b, preamble.version, segment_compression );
+         std::vector<char> buffer = create_block_buffer( *b, preamble.version, segment_compression, write_codec(codec) );
          auto pos = write_log_entry(buffer);
+         append_trx_index(*b);
+         flush();
          head     = b;
          if (b->block_num() % stride == 0) {
             split_log();
@@ -727,6 +972,7 @@ namespace eosio { namespace chain {
                    ("expected", (b->block_num() - preamble.first_block_num) * sizeof(uint64_t)));
 
          auto pos = write_log_entry(buffer);
+         append_trx_index(*b);
          head     = b;
          if (b->block_num() % stride == 0) {
             split_log();
@@ -743,18 +989,26 @@ namespace eosio { namespace chain {
 
    std::future<std::tuple<signed_block_ptr, std::vector<char>>>
    detail::block_log_impl::create_append_future(boost::asio::io_context& thread_pool, const signed_block_ptr& b, packed_transaction::cf_compression_type segment_compression) {
-      future_version = (b->block_num() % stride == 0) ? block_log::max_supported_version : future_version;
-      std::promise<std::tuple<signed_block_ptr, std::vector<char>>> p;
-      std::future<std::tuple<signed_block_ptr, std::vector<char>>> f = p.get_future();
-      return async_thread_pool( thread_pool, [b, version=future_version, segment_compression]() {
-         return std::make_tuple(b, create_block_buffer(*b, version, segment_compression));
-      } );
+      static auto& counters = get_thread_pool_task_counters( "block_log_pack" );
+      auto task = [b, version=future_version, codec=zstd_compression ? future_codec : nullptr, segment_compression]() {
+         return std::make_tuple(b, create_block_buffer(*b, version, segment_compression, codec.get()));
+      };
+      // the block at the end of a stride is the last one of its file, split_log starts a new file after it
+      if (b->block_num() % stride == 0) {
+         future_version = split_version();
+         future_codec   = new_file_codec;
+      }
+      return async_thread_pool( thread_pool, counters, std::move(task) );
    }
 
    uint64_t block_log::append(std::future<std::tuple<signed_block_ptr, std::vector<char>>> f) {
       return my->append( std::move( f ) );
    }
 
+   void block_log::flush() {
+      my->flush();
+   }
+
    void detail::block_log_impl::split_log() {
       block_file.close();
       index_file.close();
@@ -763,16 +1017,31 @@ namespace eosio { namespace chain {
       
       block_file.open(fc::cfile::truncate_rw_mode);
       index_file.open(fc::cfile::truncate_rw_mode);
-      preamble.version         = block_log::max_supported_version;
+      preamble.version         = split_version();
       preamble.chain_context   = preamble.chain_id();
       preamble.first_block_num = this->head->block_num() + 1;
+      init_new_file_codec();
       preamble.write_to(block_file);
       flush();
    }
 
+   void detail::block_log_impl::init_new_file_codec() {
+      const bool compressible = preamble.version >= compressed_block_version;
+      preamble.dictionary     = compressible ? new_file_dictionary : std::vector<char>{};
+      codec                   = compressible ? new_file_codec : nullptr;
+   }
+
    void detail::block_log_impl::flush() {
       block_file.flush();
       index_file.flush();
+      if (trx_index_enabled) {
+         // records past the last block in the header are discarded and rebuilt on open, so the header goes last
+         trx_index_file.flush();
+         trx_index_file.seek(sizeof(uint32_t));
+         trx_index_file.write((const char*)&trx_index_last_block_num, sizeof(trx_index_last_block_num));
+         trx_index_file.seek_end(0);
+         trx_index_file.flush();
+      }
    }
 
    void detail::block_log_impl::reset(uint32_t first_bnum, std::variant<genesis_state, chain_id_type>&& chain_context) {
@@ -780,12 +1049,17 @@ namespace eosio { namespace chain {
       block_file.open(fc::cfile::truncate_rw_mode);
       index_file.open(fc::cfile::truncate_rw_mode);
 
-      future_version           = block_log_impl::default_version;
-      preamble.version         = block_log_impl::default_version; 
+      preamble.version         = zstd_compression ? compressed_block_version : block_log_impl::default_version;
+      future_version           = preamble.version;
       preamble.first_block_num = first_bnum;
       preamble.chain_context   = std::move(chain_context);
+      init_new_file_codec();
+      future_codec             = codec;
       preamble.write_to(block_file);
 
+      if (trx_index_enabled)
+         reset_trx_index(first_bnum - 1);
+
       flush();
       genesis_written_to_block_log = true;
       static_assert( block_log::max_supported_version > 0, "a version number of zero is not supported" );
@@ -808,19 +1082,30 @@ namespace eosio { namespace chain {
    }
 
    std::unique_ptr<signed_block> detail::block_log_impl::read_block_by_num(uint32_t block_num) {
+      std::lock_guard g(read_mtx);
       uint64_t pos = get_block_pos(block_num);
       if (pos != block_log::npos) {
+         // Fetch the whole entry with a single read and unpack it from memory; unpacking straight from the file
+         // costs a buffered read call for every field of every transaction.
+         const uint64_t end = get_block_end(block_num);
+         EOS_ASSERT(end > pos, block_log_exception, "Invalid entry for block ${num} in block log", ("num", block_num));
+         read_buffer.resize(end - pos);
          block_file.seek(pos);
-         return read_block(block_file, preamble.version, block_num);
+         block_file.read(read_buffer.data(), read_buffer.size());
+         fc::datastream<const char*> ds(read_buffer.data(), read_buffer.size());
+         return read_block(ds, preamble.version, codec.get(), block_num);
       } else {
-         auto [ds, version] = catalog.ro_stream_for_block(block_num);
-         if (ds.remaining())
-            return read_block(ds, version, block_num);
+         auto [bundle, bundle_pos] = catalog.get_block_position(block_num);
+         if (bundle) {
+            auto [ds, version] = bundle->log_data.ro_stream_at(bundle_pos);
+            return read_block(ds, version, bundle->log_data.get_codec(), block_num);
+         }
       }
       return {};
    }
 
    block_id_type detail::block_log_impl::read_block_id_by_num(uint32_t block_num) {
+      std::lock_guard g(read_mtx);
       uint64_t pos = get_block_pos(block_num);
       if (pos != block_log::npos) {
          block_file.seek(pos);
@@ -850,6 +1135,18 @@ namespace eosio { namespace chain {
       return pos;
    }
 
+   uint64_t detail::block_log_impl::get_block_end(uint32_t block_num) {
+      uint64_t next_pos;
+      if (block_num < head->block_num()) {
+         index_file.seek(sizeof(uint64_t) * (block_num + 1 - preamble.first_block_num));
+         index_file.read((char*)&next_pos, sizeof(next_pos));
+      } else {
+         block_file.seek_end(0);
+         next_pos = block_file.tellp();
+      }
+      return next_pos - sizeof(uint64_t);
+   }
+
    void detail::block_log_impl::read_head() {
       uint64_t pos;
 
@@ -857,7 +1154,7 @@ namespace eosio { namespace chain {
       block_file.read((char*)&pos, sizeof(pos));
       if (pos != block_log::npos) {
          block_file.seek(pos);
-         head = read_block(block_file, preamble.version);
+         head = read_block(block_file, preamble.version, codec.get());
       }
    }
 
@@ -909,7 +1206,7 @@ namespace eosio { namespace chain {
       fc::datastream<const char*> ds(log_data.data() + pos, log_data.size() - pos);
 
       try {
-         unpack(ds, entry);
+         unpack(ds, entry, log_data.get_codec());
          const block_header& header = get_block_header(entry);
          if (header.block_num() != expected_block_num) {
             return false;
@@ -977,7 +1274,8 @@ namespace eosio { namespace chain {
       try {
          try {
             while (ds.remaining() > 0 && block_num < truncate_at_block) {
-               std::tie(block_num, block_id) = block_log_data::full_validate_block_entry(ds, block_num, block_id, entry);
+               std::tie(block_num, block_id) = block_log_data::full_validate_block_entry(ds, block_num, block_id, entry,
+                                                                                        log_data.get_codec());
                if (block_num % 1000 == 0)
                   ilog("Verified block ${num}", ("num", block_num));
                pos  = ds.tellp();
@@ -1023,14 +1321,15 @@ namespace eosio { namespace chain {
       return block_log_data(data_dir / "blocks.log").chain_id();
    }
 
-   size_t prune_trxs(fc::datastream<char*> strm, uint32_t block_num, std::vector<transaction_id_type>& ids, uint32_t version) {
+   size_t prune_trxs(fc::datastream<char*> strm, uint32_t block_num, std::vector<transaction_id_type>& ids, uint32_t version,
+                     const entry_codec* codec) {
 
       EOS_ASSERT(version >= pruned_transaction_version, block_log_exception,
                     "The block log version ${version} does not support transaction pruning.", ("version", version));
 
       auto         read_strm = strm;
       log_entry_v4 entry;
-      unpack(read_strm, entry);
+      unpack(read_strm, entry, codec);
 
       EOS_ASSERT(entry.block.block_num() == block_num, block_log_exception,
                      "Wrong block was read from block log.");
@@ -1055,15 +1354,28 @@ namespace eosio { namespace chain {
          entry.block.prune_state = signed_block::prune_state_type::incomplete;
       }
       strm.skip(offset_to_block_start(version));
+      if (entry.meta.zstd) {
+         if (num_trx_pruned == 0)
+            return 0;
+         // a compressed entry has no padding, the pruned block is compressed again in its space and the size of the
+         // entry is kept, unpack skips the bytes left after the new frame
+         const auto buffer = pack(entry.block, entry.meta.compression, codec);
+         EOS_ASSERT(buffer.size() + sizeof(uint64_t) <= entry.meta.size, block_log_exception,
+                    "Pruned block ${n} does not fit in its compressed block log entry, use prune_and_compact instead",
+                    ("n", block_num));
+         strm.write(buffer.data() + offset_to_block_start(version), buffer.size() - offset_to_block_start(version));
+         return num_trx_pruned;
+      }
       entry.block.pack(strm, entry.meta.compression);
       return num_trx_pruned;
    }
 
    size_t block_log::prune_transactions(uint32_t block_num, std::vector<transaction_id_type>& ids) {
 
-      auto [strm, version] = my->catalog.rw_stream_for_block(block_num);
-      if (strm.remaining()) {       
-         return prune_trxs(strm, block_num, ids, version);
+      auto [bundle, bundle_pos] = my->catalog.get_block_position(block_num, block_log_catalog::mapmode::readwrite);
+      if (bundle) {
+         auto [strm, version] = bundle->log_data.rw_stream_at(bundle_pos);
+         return prune_trxs(strm, block_num, ids, version, bundle->log_data.get_codec());
       }
 
       const uint64_t pos = my->get_block_pos(block_num);
@@ -1073,7 +1385,7 @@ namespace eosio { namespace chain {
       using boost::iostreams::mapped_file_sink;
       mapped_file_sink      sink(my->block_file.get_file_path().string(), mapped_file_sink::max_length, 0);
       fc::datastream<char*> ds(sink.data() + pos , sink.size() - pos);
-      return prune_trxs(ds, block_num, ids, my->preamble.version);
+      return prune_trxs(ds, block_num, ids, my->preamble.version, my->codec.get());
    }
 
    bool block_log::contains_genesis_state(uint32_t version, uint32_t first_block_num) {
@@ -1088,6 +1400,107 @@ namespace eosio { namespace chain {
       return std::clamp(version, min_supported_version, max_supported_version) == version;
    }
 
+#ifdef EOSIO_BLOCK_LOG_ZSTD
+   bool block_log::zstd_supported() { return true; }
+
+   std::vector<char> block_log::train_zstd_dictionary(const fc::path& block_dir, uint32_t first_block_num,
+                                                      uint32_t last_block_num, size_t max_size) {
+      block_log_config config;
+      config.log_dir = block_dir;
+      block_log log(config);
+
+      // the samples are what pack compresses, the serialization of a block after its header
+      std::vector<char>   samples;
+      std::vector<size_t> sizes;
+      first_block_num = std::max(first_block_num, log.first_block_num());
+      last_block_num  = std::min(last_block_num, log.head() ? log.head()->block_num() : 0);
+      for (uint32_t block_num = first_block_num; block_num <= last_block_num; ++block_num) {
+         auto b = log.read_signed_block_by_num(block_num);
+         if (!b)
+            continue;
+         const auto        data        = fc::raw::pack(*b);
+         const std::size_t header_size = fc::raw::pack_size(static_cast<const block_header&>(*b));
+         samples.insert(samples.end(), data.begin() + header_size, data.end());
+         sizes.push_back(data.size() - header_size);
+      }
+      EOS_ASSERT(!sizes.empty(), block_log_exception, "no blocks ${first} through ${last} in ${dir}",
+                 ("first", first_block_num)("last", last_block_num)("dir", block_dir.generic_string()));
+
+      std::vector<char> result(max_size);
+      size_t r = ZDICT_trainFromBuffer(result.data(), result.size(), samples.data(), sizes.data(), sizes.size());
+      EOS_ASSERT(!ZDICT_isError(r), block_log_exception, "zstd dictionary training failed: ${e}",
+                 ("e", ZDICT_getErrorName(r)));
+      result.resize(r);
+      return result;
+   }
+#else
+   bool block_log::zstd_supported() { return false; }
+
+   std::vector<char> block_log::train_zstd_dictionary(const fc::path&, uint32_t, uint32_t, size_t) {
+      EOS_THROW(block_log_exception, "built without zstd");
+   }
+#endif
+
+   /**
+    * Write blocks [first_block_num, last_block_num] of log_bundle as a standalone block log and index.
+    * Unless the range starts at the first block of the log, the new log gets a preamble containing the
+    * chain id and the block positions are shifted to account for the removed blocks.
+    */
+   static void write_block_range(const block_log_bundle& log_bundle, uint32_t first_block_num, uint32_t last_block_num,
+                                 const fc::path& block_file_name, const fc::path& index_file_name) {
+      static_assert( block_log::max_supported_version == compressed_block_version,
+                     "Code was written to support format of version 5 or lower, need to update this code for latest format." );
+
+      const auto&    log_data         = log_bundle.log_data;
+      const auto&    log_index        = log_bundle.log_index;
+      const uint32_t first_index      = first_block_num - log_data.first_block_num();
+      const uint32_t num_blocks       = last_block_num - first_block_num + 1;
+      const uint64_t first_block_pos  = log_index.nth_block_position(first_index);
+      const uint64_t end_pos          = first_index + num_blocks < static_cast<uint32_t>(log_index.num_blocks())
+                                           ? log_index.nth_block_position(first_index + num_blocks)
+                                           : log_data.size();
+      const bool     keep_preamble    = first_block_num == log_data.first_block_num();
+
+      block_log_preamble preamble;
+      // version 4 or above have different log entry format; therefore version 1 to 3 can only be upgrade up to version 3 format.
+      // version 4 and 5 are kept as they are, together with the dictionary of the entries.
+      preamble.version         = log_data.version() < pruned_transaction_version ? genesis_state_or_chain_id_version : log_data.version();
+      preamble.first_block_num = first_block_num;
+      preamble.chain_context   = log_data.chain_id();
+      preamble.dictionary      = log_data.get_preamble().dictionary;
+      fc::datastream<size_t> preamble_size_ds;
+      preamble.write_to(preamble_size_ds);
+
+      const uint64_t preamble_size    = keep_preamble ? first_block_pos : preamble_size_ds.tellp();
+      const uint64_t nbytes_to_trim   = first_block_pos - preamble_size;
+      const uint64_t new_block_file_size = end_pos - nbytes_to_trim;
+
+      boost::iostreams::mapped_file_sink new_block_file;
+      create_mapped_file(new_block_file, block_file_name.generic_string(), new_block_file_size);
+
+      if (keep_preamble) {
+         memcpy(new_block_file.data(), log_data.data(), preamble_size);
+      } else {
+         fc::datastream<char*> ds(new_block_file.data(), new_block_file.size());
+         preamble.write_to(ds);
+      }
+
+      memcpy(new_block_file.data() + preamble_size, log_data.data() + first_block_pos, new_block_file_size - preamble_size);
+
+      index_writer index(index_file_name, num_blocks);
+
+      // walk along the block position of each block entry and decrement its value by nbytes_to_trim
+      for (auto itr = make_reverse_block_position_iterator(new_block_file, preamble_size);
+            itr.get_value() != block_log::npos; ++itr) {
+         auto new_pos = itr.get_value() - nbytes_to_trim;
+         index.write(new_pos);
+         itr.set_value(new_pos);
+      }
+
+      index.close();
+      new_block_file.close();
+   }
+
    bool block_log::trim_blocklog_front(const fc::path& block_dir, const fc::path& temp_dir, uint32_t truncate_at_block) {
       EOS_ASSERT( block_dir != temp_dir, block_log_exception, "block_dir and temp_dir need to be different directories" );
       
@@ -1105,45 +1518,118 @@ namespace eosio { namespace chain {
          return false;
       }
 
-      // ****** create the new block log file and write out the header for the file
       fc::create_directories(temp_dir);
       fc::path new_block_filename = temp_dir / "blocks.log";
-   
-      static_assert( block_log::max_supported_version == pruned_transaction_version,
-                     "Code was written to support format of version 4 or lower, need to update this code for latest format." );
-      
-      const auto     preamble_size           = block_log_preamble::nbytes_with_chain_id;
-      const auto     num_blocks_to_truncate  = truncate_at_block - log_bundle.log_data.first_block_num();
-      const uint64_t first_kept_block_pos    = log_bundle.log_index.nth_block_position(num_blocks_to_truncate);
-      const uint64_t nbytes_to_trim          = first_kept_block_pos - preamble_size;
-      const auto     new_block_file_size     = log_bundle.log_data.size() - nbytes_to_trim;
+      fc::path new_index_filename = temp_dir / "blocks.index";
+      write_block_range(log_bundle, truncate_at_block, log_bundle.log_data.last_block_num(), new_block_filename, new_index_filename);
 
-      boost::iostreams::mapped_file_sink new_block_file;
-      create_mapped_file(new_block_file, new_block_filename.generic_string(), new_block_file_size);
-      fc::datastream<char*> ds(new_block_file.data(), new_block_file.size());
+      fc::path old_log = temp_dir / "old.log";
+      rename(log_bundle.block_file_name, old_log);
+      rename(new_block_filename, log_bundle.block_file_name);
+      fc::path old_ind = temp_dir / "old.index";
+      rename(log_bundle.index_file_name, old_ind);
+      rename(new_index_filename, log_bundle.index_file_name);
 
-      block_log_preamble preamble;
-      // version 4 or above have different log entry format; therefore version 1 to 3 can only be upgrade up to version 3 format.
-      preamble.version         = log_bundle.log_data.version() < pruned_transaction_version ? genesis_state_or_chain_id_version : block_log::max_supported_version;
-      preamble.first_block_num = truncate_at_block;
-      preamble.chain_context   = log_bundle.log_data.chain_id();
-      preamble.write_to(ds);
+      return true;
+   }
+
+   size_t block_log::prune_and_compact(const fc::path& block_dir, const fc::path& temp_dir, uint32_t first_block_num,
+                                       uint32_t last_block_num, fc::time_point older_than, uint16_t num_threads) {
+      EOS_ASSERT( block_dir != temp_dir, block_log_exception, "block_dir and temp_dir need to be different directories" );
+      EOS_ASSERT( num_threads > 0, block_log_exception, "num_threads must be greater than 0" );
+
+      ilog("In directory ${dir} will prune and compact blocks ${first} through ${last} of blocks.log",
+           ("dir", block_dir.generic_string())("first", first_block_num)("last", last_block_num));
 
-      memcpy(new_block_file.data() + preamble_size, log_bundle.log_data.data() + first_kept_block_pos, new_block_file_size - preamble_size);
+      block_log_bundle log_bundle(block_dir);
+      const auto&      log_data  = log_bundle.log_data;
+      const auto&      log_index = log_bundle.log_index;
+      EOS_ASSERT( log_data.version() >= pruned_transaction_version, block_log_exception,
+                  "Pruning requires a block log of version ${ver} or later, ${file} is version ${actual}",
+                  ("ver", pruned_transaction_version)("file", log_bundle.block_file_name.generic_string())("actual", log_data.version()) );
+
+      static_assert( block_log::max_supported_version == compressed_block_version,
+                     "Code was written to support format of version 5 or lower, need to update this code for latest format." );
 
+      fc::create_directories(temp_dir);
+      fc::path new_block_filename = temp_dir / "blocks.log";
       fc::path new_index_filename = temp_dir / "blocks.index";
-      index_writer index(new_index_filename, log_bundle.log_index.num_blocks() - num_blocks_to_truncate);
+      fc::cfile new_block_file;
+      new_block_file.set_file_path(new_block_filename);
+      new_block_file.open(fc::cfile::truncate_rw_mode);
+      fc::cfile new_index_file;
+      new_index_file.set_file_path(new_index_filename);
+      new_index_file.open(fc::cfile::truncate_rw_mode);
 
-      // walk along the block position of each block entry and decrement its value by nbytes_to_trim
-      for (auto itr = make_reverse_block_position_iterator(new_block_file, preamble_size);
-            itr.get_value() != block_log::npos; ++itr) {
-         auto new_pos = itr.get_value() - nbytes_to_trim;
-         index.write(new_pos);
-         itr.set_value(new_pos);
+      new_block_file.write(log_data.data(), log_data.first_block_position());
+
+      const uint32_t num_blocks = log_index.num_blocks();
+      auto entry_end = [&](uint32_t n) {
+         return n + 1 < num_blocks ? log_index.nth_block_position(n + 1) : log_data.size();
+      };
+
+      using pruned_entry = std::pair<std::vector<char>, size_t>; // repacked entry without its position, number of trxs pruned
+      auto prune_entry = [&log_data, older_than](uint64_t pos, uint64_t end) -> pruned_entry {
+         fc::datastream<const char*> ds(log_data.data() + pos, end - pos);
+         log_entry_v4                entry;
+         unpack(ds, entry, log_data.get_codec());
+
+         size_t num_trx_pruned = 0;
+         if (entry.block.timestamp.to_time_point() < older_than) {
+            for (auto& receipt : entry.block.transactions) {
+               auto ptx = std::get_if<packed_transaction>(&receipt.trx);
+               if (ptx && !std::holds_alternative<packed_transaction::prunable_data_type::none>(ptx->get_prunable_data().prunable_data)) {
+                  ptx->prune_all();
+                  ++num_trx_pruned;
+               }
+            }
+            if (num_trx_pruned > 0)
+               entry.block.prune_state = signed_block::prune_state_type::incomplete;
+         }
+         // a compressed block is compressed again, with the dictionary of the file as the preamble is copied
+         return { pack(entry.block, entry.meta.compression, entry.meta.zstd ? log_data.get_codec() : nullptr), num_trx_pruned };
+      };
+
+      named_thread_pool thread_pool("prune", num_threads);
+      size_t            num_trx_pruned = 0;
+
+      // blocks in range are repacked on the thread pool a batch at a time and written out in order, the others are
+      // copied as is; in both cases the position at the end of the entry changes
+      constexpr uint32_t batch_size = 1024;
+      for (uint32_t batch_start = 0; batch_start < num_blocks; batch_start += batch_size) {
+         const uint32_t batch_end = std::min(batch_start + batch_size, num_blocks);
+
+         std::vector<std::optional<std::future<pruned_entry>>> entries(batch_end - batch_start);
+         for (uint32_t n = batch_start; n < batch_end; ++n) {
+            const uint32_t block_num = log_data.first_block_num() + n;
+            if (block_num >= first_block_num && block_num <= last_block_num) {
+               entries[n - batch_start] = async_thread_pool(thread_pool.get_executor(),
+                  [&prune_entry, pos = log_index.nth_block_position(n), end = entry_end(n)]() { return prune_entry(pos, end); });
+            }
+         }
+
+         for (uint32_t n = batch_start; n < batch_end; ++n) {
+            const uint64_t new_pos = new_block_file.tellp();
+            auto&          entry   = entries[n - batch_start];
+            if (entry) {
+               auto [buffer, pruned] = entry->get();
+               new_block_file.write(buffer.data(), buffer.size());
+               num_trx_pruned += pruned;
+            } else {
+               const uint64_t pos = log_index.nth_block_position(n);
+               new_block_file.write(log_data.data() + pos, entry_end(n) - pos - sizeof(uint64_t));
+            }
+            new_block_file.write((const char*)&new_pos, sizeof(new_pos));
+            new_index_file.write((const char*)&new_pos, sizeof(new_pos));
+         }
       }
 
-      index.close();
+      thread_pool.stop();
       new_block_file.close();
+      new_index_file.close();
+
+      ilog("Pruned ${n} transactions, blocks.log went from ${before} to ${after} bytes",
+           ("n", num_trx_pruned)("before", log_data.size())("after", fc::file_size(new_block_filename)));
 
       fc::path old_log = temp_dir / "old.log";
       rename(log_bundle.block_file_name, old_log);
@@ -1152,7 +1638,7 @@ namespace eosio { namespace chain {
       rename(log_bundle.index_file_name, old_ind);
       rename(new_index_filename, log_bundle.index_file_name);
 
-      return true;
+      return num_trx_pruned;
    }
 
    int block_log::trim_blocklog_end(fc::path block_dir, uint32_t n) {       //n is last block to keep (remove later blocks)
@@ -1198,6 +1684,246 @@ namespace eosio { namespace chain {
       }
    }
 
+   static fc::sha256 hash_file(const fc::path& path) {
+      // sha256::encoder::write takes a 32 bit length, feed it the mapped file in bounded pieces
+      constexpr uint64_t                   piece_size = 64 * 1024 * 1024;
+      boost::iostreams::mapped_file_source file(path.generic_string());
+      fc::sha256::encoder                  enc;
+      for (uint64_t pos = 0; pos < file.size(); pos += piece_size) {
+         enc.write(file.data() + pos, std::min<uint64_t>(piece_size, file.size() - pos));
+      }
+      return enc.result();
+   }
+
+   std::vector<block_log_chunk> block_log::export_chunks(const fc::path& block_dir, const fc::path& output_dir, uint32_t stride) {
+      EOS_ASSERT( stride > 0, block_log_exception, "stride must be greater than 0" );
+      EOS_ASSERT( block_dir != output_dir, block_log_exception, "block_dir and output_dir need to be different directories" );
+
+      block_log_bundle log_bundle(block_dir);
+      const uint32_t   first_block_num = log_bundle.log_data.first_block_num();
+      const uint32_t   last_block_num  = log_bundle.log_data.last_block_num();
+
+      fc::create_directories(output_dir);
+      const fc::path tmp_log   = output_dir / "chunk.log.tmp";
+      const fc::path tmp_index = output_dir / "chunk.index.tmp";
+
+      std::vector<block_log_chunk> chunks;
+      // the first block of every chunk is one past a multiple of the stride, matching block_log_impl::split_log
+      uint32_t chunk_start = ((first_block_num - 1 + stride - 1) / stride) * stride + 1;
+      while (chunk_start <= last_block_num && last_block_num - chunk_start + 1 >= stride) {
+         block_log_chunk chunk;
+         chunk.first_block_num = chunk_start;
+         chunk.last_block_num  = chunk_start + stride - 1;
+
+         write_block_range(log_bundle, chunk.first_block_num, chunk.last_block_num, tmp_log, tmp_index);
+         chunk.log_hash   = hash_file(tmp_log);
+         chunk.index_hash = hash_file(tmp_index);
+         fc::rename(tmp_log, output_dir / (chunk.log_hash.str() + ".log"));
+         fc::rename(tmp_index, output_dir / (chunk.index_hash.str() + ".index"));
+
+         ilog("exported blocks ${first} through ${last} as ${hash}.log",
+              ("first", chunk.first_block_num)("last", chunk.last_block_num)("hash", chunk.log_hash));
+         chunks.push_back(chunk);
+         chunk_start += stride;
+      }
+
+      if (chunks.empty() || chunks.back().last_block_num != last_block_num) {
+         const uint32_t first_left_out = chunks.empty() ? first_block_num : chunks.back().last_block_num + 1;
+         ilog("blocks ${first} through ${last} do not fill a complete chunk of ${stride} blocks and were not exported",
+              ("first", first_left_out)("last", last_block_num)("stride", stride));
+      }
+
+      fc::json::save_to_file(chunks, output_dir / chunk_manifest_name, true);
+      return chunks;
+   }
+
+   static bool import_chunk(const fc::path& source_dir, const fc::path& retained_dir, const block_log_chunk& chunk) {
+      const std::string base = "blocks-" + std::to_string(chunk.first_block_num) + "-" + std::to_string(chunk.last_block_num);
+      const fc::path    log_path   = retained_dir / (base + ".log");
+      const fc::path    index_path = retained_dir / (base + ".index");
+      if (fc::exists(log_path) && fc::exists(index_path))
+         return false;
+
+      // copy under names log_catalog does not pick up, only rename into place once the content is verified
+      const fc::path tmp_log   = retained_dir / (base + ".log.tmp");
+      const fc::path tmp_index = retained_dir / (base + ".index.tmp");
+      fc::remove(tmp_log);
+      fc::remove(tmp_index);
+      fc::copy(source_dir / (chunk.log_hash.str() + ".log"), tmp_log);
+      fc::copy(source_dir / (chunk.index_hash.str() + ".index"), tmp_index);
+
+      const bool log_matches   = hash_file(tmp_log) == chunk.log_hash;
+      const bool index_matches = hash_file(tmp_index) == chunk.index_hash;
+      if (!log_matches || !index_matches) {
+         fc::remove(tmp_log);
+         fc::remove(tmp_index);
+         EOS_THROW(block_log_exception, "content of chunk for blocks ${first} through ${last} in ${dir} does not match its hash",
+                   ("first", chunk.first_block_num)("last", chunk.last_block_num)("dir", source_dir.generic_string()));
+      }
+
+      fc::rename(tmp_index, index_path);
+      fc::rename(tmp_log, log_path);
+      return true;
+   }
+
+   size_t block_log::import_chunks(const fc::path& source_dir, const fc::path& retained_dir, uint16_t num_threads) {
+      const fc::path manifest_path = source_dir / chunk_manifest_name;
+      EOS_ASSERT( fc::is_regular_file(manifest_path), block_log_exception, "${manifest} does not exist",
+                  ("manifest", manifest_path.generic_string()) );
+      EOS_ASSERT( num_threads > 0, block_log_exception, "num_threads must be greater than 0" );
+
+      const auto chunks = fc::json::from_file(manifest_path).as<std::vector<block_log_chunk>>();
+      fc::create_directories(retained_dir);
+
+      std::vector<std::future<bool>> results;
+      results.reserve(chunks.size());
+      {
+         named_thread_pool thread_pool("blkimp", num_threads);
+         for (const auto& chunk : chunks) {
+            results.push_back(async_thread_pool(thread_pool.get_executor(), [&source_dir, &retained_dir, chunk]() {
+               return import_chunk(source_dir, retained_dir, chunk);
+            }));
+         }
+         for (auto& r : results)
+            r.wait();
+      }
+
+      size_t num_imported = 0;
+      for (auto& r : results)
+         num_imported += r.get();
+      ilog("imported ${n} of ${total} block log chunks from ${dir}",
+           ("n", num_imported)("total", chunks.size())("dir", source_dir.generic_string()));
+      return num_imported;
+   }
+
+   static transaction_id_type receipt_trx_id(const transaction_receipt& receipt) {
+      return std::visit(overloaded{[](const transaction_id_type& id) { return id; },
+                                   [](const packed_transaction& ptx) { return ptx.id(); }},
+                        receipt.trx);
+   }
+
+   namespace {
+      constexpr uint32_t trx_index_version     = 1;
+      constexpr uint64_t trx_index_header_size = 2 * sizeof(uint32_t);           // version, last block num
+      constexpr uint64_t trx_index_record_size = sizeof(uint64_t) + sizeof(uint32_t); // id prefix, block num
+   }
+
+   /**
+    * Load the records of blocks.trx_index up to the last block recorded in its header, ignoring the header when it is
+    * past max_block_num.
+    * @returns The pair of the last block indexed, or 0 if the index has to be rebuilt, and the size of the file
+    *          holding the loaded records
+    */
+   static std::pair<uint32_t, uint64_t> load_trx_index(const fc::path& path, uint32_t max_block_num,
+                                                       std::unordered_multimap<uint64_t, uint32_t>& index) {
+      if (!fc::exists(path) || fc::file_size(path) < trx_index_header_size)
+         return { 0, 0 };
+
+      boost::iostreams::mapped_file_source file(path.generic_string());
+      if (read_buffer<uint32_t>(file.data()) != trx_index_version)
+         return { 0, 0 };
+      const uint32_t last_block_num = read_buffer<uint32_t>(file.data() + sizeof(uint32_t));
+      if (last_block_num == 0 || last_block_num > max_block_num)
+         return { 0, 0 };
+
+      // only keep the records which were complete when the header was last written
+      uint64_t pos = trx_index_header_size;
+      for (; pos + trx_index_record_size <= file.size(); pos += trx_index_record_size) {
+         const uint32_t block_num = read_buffer<uint32_t>(file.data() + pos + sizeof(uint64_t));
+         if (block_num > last_block_num)
+            break;
+         index.emplace(read_buffer<uint64_t>(file.data() + pos), block_num);
+      }
+      return { last_block_num, pos };
+   }
+
+   void detail::block_log_impl::open_trx_index(const fc::path& path) {
+      trx_index_enabled = true;
+      trx_index_file.set_file_path(path);
+
+      uint64_t file_size;
+      std::tie(trx_index_last_block_num, file_size) = load_trx_index(path, head ? head->block_num() : 0, trx_index);
+
+      if (trx_index_last_block_num == 0) {
+         ilog("Creating ${path}", ("path", path.generic_string()));
+         reset_trx_index(0);
+      } else {
+         boost::filesystem::resize_file(path, file_size);
+         trx_index_file.open(fc::cfile::update_rw_mode);
+         trx_index_file.seek_end(0);
+      }
+
+      if (!head)
+         return;
+
+      // index the blocks appended while the index was disabled or not yet flushed
+      uint32_t first_block_num = trx_index_last_block_num + 1;
+      if (first_block_num == 1)
+         first_block_num = catalog.empty() ? preamble.first_block_num : catalog.first_block_num();
+      if (first_block_num <= head->block_num()) {
+         ilog("Adding blocks ${first} through ${last} to ${path}",
+              ("first", first_block_num)("last", head->block_num())("path", path.generic_string()));
+         for (uint32_t block_num = first_block_num; block_num <= head->block_num(); ++block_num) {
+            auto b = read_block_by_num(block_num);
+            if (b)
+               append_trx_index(*b);
+         }
+         trx_index_last_block_num = head->block_num();
+         flush();
+      }
+   }
+
+   void detail::block_log_impl::reset_trx_index(uint32_t last_block_num) {
+      trx_index.clear();
+      trx_index_last_block_num = last_block_num;
+      trx_index_file.open(fc::cfile::truncate_rw_mode);
+      trx_index_file.write((const char*)&trx_index_version, sizeof(trx_index_version));
+      trx_index_file.write((const char*)&trx_index_last_block_num, sizeof(trx_index_last_block_num));
+      trx_index_file.flush();
+   }
+
+   void detail::block_log_impl::append_trx_index(const signed_block& b) {
+      if (!trx_index_enabled)
+         return;
+      const uint32_t block_num = b.block_num();
+      for (const auto& receipt : b.transactions) {
+         const uint64_t prefix = receipt_trx_id(receipt)._hash[0];
+         trx_index_file.write((const char*)&prefix, sizeof(prefix));
+         trx_index_file.write((const char*)&block_num, sizeof(block_num));
+         trx_index.emplace(prefix, block_num);
+      }
+      trx_index_last_block_num = block_num;
+   }
+
+   std::optional<uint32_t> detail::block_log_impl::find_block_num_by_trx_id(const transaction_id_type& id) {
+      EOS_ASSERT(trx_index_enabled, block_log_exception, "The transaction id index of the block log is not enabled");
+      // the index only holds an id prefix, confirm against the block itself
+      auto [begin, end] = trx_index.equal_range(id._hash[0]);
+      for (auto itr = begin; itr != end; ++itr) {
+         auto b = read_block_by_num(itr->second);
+         if (b && std::any_of(b->transactions.begin(), b->transactions.end(),
+                              [&id](const transaction_receipt& receipt) { return receipt_trx_id(receipt) == id; }))
+            return itr->second;
+      }
+      return {};
+   }
+
+   bool block_log::has_trx_index() const {
+      return my->trx_index_enabled;
+   }
+
+   std::optional<uint32_t> block_log::find_block_num_by_trx_id(const transaction_id_type& id) {
+      return my->find_block_num_by_trx_id(id);
+   }
+
+   void block_log::construct_trx_index(const fc::path& block_dir) {
+      fc::remove(block_dir / "blocks.trx_index");
+      block_log_config config;
+      config.log_dir   = block_dir;
+      config.trx_index = true;
+      block_log log(config);
+   }
+
    bool block_log::exists(const fc::path& data_dir) {
       return fc::exists(data_dir / "blocks.log") && fc::exists(data_dir / "blocks.index");
    }
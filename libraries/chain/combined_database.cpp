@@ -5,10 +5,15 @@
 #include <eosio/chain/kv_chainbase_objects.hpp>
 #include <eosio/chain/backing_store/db_context.hpp>
 #include <eosio/chain/backing_store/db_key_value_format.hpp>
+#include <eosio/chain/thread_utils.hpp>
+#include <fc/filesystem.hpp>
+#include <rocksdb/cache.h>
+#include <deque>
 
 namespace eosio { namespace chain {
-   combined_session::combined_session(chainbase::database& cb_database, eosio::session::undo_stack<rocks_db_type>* undo_stack)
-       : kv_undo_stack{ undo_stack } {
+   combined_session::combined_session(chainbase::database& cb_database, eosio::session::undo_stack<rocks_db_type>* undo_stack,
+                                      const std::function<void()>* undo_callback)
+       : kv_undo_stack{ undo_stack }, undo_callback{ undo_callback } {
       cb_session = std::make_unique<chainbase::database::session>(cb_database.start_undo_session(true));
       try {
         try {
@@ -22,8 +27,9 @@ namespace eosio { namespace chain {
    }
 
    combined_session::combined_session(combined_session&& src) noexcept
-       : cb_session(std::move(src.cb_session)), kv_undo_stack(src.kv_undo_stack) {
+       : cb_session(std::move(src.cb_session)), kv_undo_stack(src.kv_undo_stack), undo_callback(src.undo_callback) {
       src.kv_undo_stack = nullptr;
+      src.undo_callback = nullptr;
    }
 
    void combined_session::push() {
@@ -70,6 +76,10 @@ namespace eosio { namespace chain {
             }
             CATCH_AND_EXIT_DB_FAILURE()
          }
+
+         if (undo_callback && *undo_callback) {
+            (*undo_callback)();
+         }
       }
    }
 
@@ -103,15 +113,81 @@ namespace eosio { namespace chain {
       });
    }
 
+   /**
+    * Writes the batches of key values restored from a snapshot to rocksdb on a thread pool, so that the rows of the
+    * snapshot keep being decoded on the calling thread meanwhile. The batches hold puts of distinct keys, the order
+    * in which they land does not matter. At most two batches per thread are pending before write() waits.
+    *
+    * With an ingest_dir each batch is sorted into an SST file in that directory and ingested, skipping the memtable
+    * and the compactions of flushed puts; rocksdb moves the files into the database.
+    */
+   class rocksdb_snapshot_batch_writer {
+    public:
+      using batch_type = std::vector<std::pair<eosio::session::shared_bytes, eosio::session::shared_bytes>>;
+
+      rocksdb_snapshot_batch_writer(rocks_db_type& kv_database, uint16_t num_threads, const std::string& ingest_dir)
+          : kv_database(kv_database), max_pending(2 * std::max<uint16_t>(num_threads, 1)),
+            thread_pool("snapld", std::max<uint16_t>(num_threads, 1)), ingest_dir(ingest_dir) {
+         if (ingesting()) {
+            fc::remove_all(ingest_dir);
+            fc::create_directories(ingest_dir);
+         }
+      }
+
+      bool ingesting() const { return !ingest_dir.empty(); }
+
+      void write(batch_type&& batch) {
+         if (batch.empty())
+            return;
+         if (pending.size() >= max_pending) {
+            pending.front().get();
+            pending.pop_front();
+         }
+         if (ingesting()) {
+            auto file = (fc::path(ingest_dir) / ("snapshot-" + std::to_string(next_file++) + ".sst")).generic_string();
+            pending.push_back(async_thread_pool(thread_pool.get_executor(), [this, batch = std::move(batch), file]() mutable {
+               kv_database.ingest(batch, file);
+            }));
+         } else {
+            pending.push_back(async_thread_pool(thread_pool.get_executor(), [this, batch = std::move(batch)]() {
+               kv_database.write(batch);
+            }));
+         }
+      }
+
+      // waits for all pending batches, rethrowing the first failure
+      void finish() {
+         while (!pending.empty()) {
+            auto f = std::move(pending.front());
+            pending.pop_front();
+            f.get();
+         }
+         if (ingesting())
+            fc::remove_all(ingest_dir);
+      }
+
+    private:
+      rocks_db_type&                kv_database;
+      const size_t                  max_pending;
+      named_thread_pool             thread_pool;
+      const std::string             ingest_dir;
+      uint64_t                      next_file = 0;
+      std::deque<std::future<void>> pending;
+   };
+
    void read_kv_table_from_snapshot(const snapshot_reader_ptr& snapshot, chainbase::database& db,
-                                    const std::unique_ptr<rocks_db_type>& kv_database, uint32_t version, backing_store_type backing_store ) {
+                                    const std::unique_ptr<rocks_db_type>& kv_database, uint32_t version, backing_store_type backing_store,
+                                    uint64_t snapshot_batch_threashold, uint16_t write_threads, const std::string& ingest_dir) {
       if (version < kv_object::minimum_snapshot_version)
          return;
       if (backing_store == backing_store_type::ROCKSDB) {
          auto key_values = std::vector<std::pair<eosio::session::shared_bytes, eosio::session::shared_bytes>>{};
          constexpr std::size_t batch_size = 500;
          key_values.reserve(batch_size);
-         snapshot->read_section<kv_object>([&key_values, &db, &kv_database](auto& section) {
+         rocksdb_snapshot_batch_writer writer(*kv_database, write_threads, ingest_dir);
+         // SST files are worth building only for batches of the size of the contract table ones
+         uint64_t batch_mem_size = 0;
+         snapshot->read_section<kv_object>([&key_values, &db, &writer, &batch_mem_size, snapshot_batch_threashold](auto& section) {
             const std::string_view prefix_key {&backing_store::rocksdb_contract_kv_prefix, 1};
             bool more = !section.empty();
             while (more) {
@@ -133,15 +209,19 @@ namespace eosio { namespace chain {
 
                key_values.emplace_back(full_key,
                                        final_kv_value.as_payload());
+               batch_mem_size += key_values.back().first.size() + key_values.back().second.size();
 
-               if (key_values.size() >= batch_size) {
-                  kv_database->write(key_values);
+               if (writer.ingesting() ? batch_mem_size >= snapshot_batch_threashold : key_values.size() >= batch_size) {
+                  writer.write(std::move(key_values));
                   key_values.clear();
+                  key_values.reserve(batch_size);
+                  batch_mem_size = 0;
                }
             }
          });
          // write out any remaining key-values
-         kv_database->write(key_values);
+         writer.write(std::move(key_values));
+         writer.finish();
       }
       else {
          snapshot->read_section<kv_object>([&db](auto& section) {
@@ -188,6 +268,12 @@ namespace eosio { namespace chain {
             options.max_write_buffer_number = 10; // maximum number of memtables, both active and immutable
             options.min_write_buffer_number_to_merge = 2; // minimum number of memtables to be merged before flushing to storage
 
+            // Bloom filter over whole keys in each memtable. Contracts routinely probe for keys that do not exist
+            // (find before emplace), the table files' bloom filter below rules those out on disk, this rules them
+            // out in the up to max_write_buffer_number memtables as well.
+            options.memtable_whole_key_filtering     = true;
+            options.memtable_prefix_bloom_size_ratio = 0.02;
+
             // Once level 0 reaches this number of files, L0->L1 compaction is triggered.
             options.level0_file_num_compaction_trigger = 2;
 
@@ -216,15 +302,37 @@ namespace eosio { namespace chain {
             table_options.format_version               = 5;
             table_options.index_block_restart_interval = 16;
 
+            // Keys within a data block are delta encoded against the previous key, and only restart points store a
+            // full key. Table rows and their secondary index entries share long [type, contract, scope, table]
+            // prefixes, so restarting less often stores far fewer copies of them. The hash index in each data
+            // block keeps point lookups from paying for the longer linear scan between restart points.
+            table_options.block_restart_interval           = 32;
+            table_options.data_block_index_type            = rocksdb::BlockBasedTableOptions::kDataBlockBinaryAndHash;
+            table_options.data_block_hash_table_util_ratio = 0.75;
+
             // Sets the bloom filter - Given an arbitrary key, 
             // this bit array may be used to determine if the key 
             // may exist or definitely does not exist in the key set.
 	          table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(15, false));
 	          table_options.index_type = rocksdb::BlockBasedTableOptions::kBinarySearch;
 
+            // Keep uncompressed blocks in a dedicated LRU cache sized by the operator. Index and filter
+            // blocks are charged to the same cache so its size bounds memory use; those of L0 files are
+            // pinned since every point lookup consults them.
+            table_options.block_cache                                      = rocksdb::NewLRUCache(cfg.persistent_storage_block_cache_size);
+            table_options.cache_index_and_filter_blocks                    = true;
+            table_options.cache_index_and_filter_blocks_with_high_priority = true;
+            table_options.pin_l0_filter_and_index_blocks_in_cache          = true;
+
             // Incorporates the Table options into options
             options.table_factory.reset(NewBlockBasedTableFactory(table_options));
 
+            // Keeps recently read rows in RAM ahead of the block cache so a hot working set is served
+            // without decoding blocks. Disabled when the size is 0.
+            if (cfg.persistent_storage_row_cache_size > 0) {
+               options.row_cache = rocksdb::NewLRUCache(cfg.persistent_storage_row_cache_size);
+            }
+
             rocksdb::DB* p;
             auto         status = rocksdb::DB::Open(options, (cfg.state_dir / "chain-kv").string(), &p);
             if (!status.ok())
@@ -233,7 +341,9 @@ namespace eosio { namespace chain {
             return std::make_unique<rocks_db_type>(eosio::session::make_session(std::move(rdb), 1024));
          }() },
          kv_undo_stack(std::make_unique<eosio::session::undo_stack<rocks_db_type>>(*kv_database, cfg.state_dir)),
-         kv_snapshot_batch_threashold(cfg.persistent_storage_mbytes_batch * 1024 * 1024)  {}
+         kv_snapshot_batch_threashold(cfg.persistent_storage_mbytes_batch * 1024 * 1024),
+         kv_snapshot_write_threads(cfg.persistent_storage_num_threads),
+         kv_snapshot_ingest_dir(cfg.persistent_storage_snapshot_ingest ? (cfg.state_dir / "chain-kv-ingest").generic_string() : std::string()) {}
 
    void combined_database::check_backing_store_setting(bool clean_startup) {
       if (backing_store != db.get<kv_db_config_object>().backing_store) {   
@@ -286,6 +396,51 @@ namespace eosio { namespace chain {
       }
    }
 
+   kv_cache_stats combined_database::get_kv_cache_stats() const {
+      kv_cache_stats result;
+      if (backing_store != backing_store_type::ROCKSDB) {
+         return result;
+      }
+
+      // Both kv and db keys start with a one byte type prefix followed by the contract name.
+      std::map<uint64_t, kv_cache_contract_stats> contracts;
+      auto add_to_contract = [&](const eosio::session::shared_bytes& key, const auto& state) {
+         if (key.size() < 1 + sizeof(uint64_t) ||
+             (key[0] != backing_store::rocksdb_contract_kv_prefix && key[0] != backing_store::rocksdb_contract_db_prefix)) {
+            return;
+         }
+         auto     begin    = key.data() + 1;
+         uint64_t contract = 0;
+         b1::chain_kv::extract_key(begin, key.data() + key.size(), contract);
+         auto& stats = contracts[contract];
+         stats.contract = name{contract};
+         ++stats.cached_keys;
+         stats.cached_bytes += key.size() + state.value.size();
+      };
+
+      kv_undo_stack->visit_sessions([&](const auto& session) {
+         const auto stats = session.stats();
+         result.layers.push_back(kv_cache_layer_stats{ stats.cached_keys, stats.updated_keys, stats.deleted_keys,
+                                                       stats.cached_bytes, stats.read_hits, stats.read_misses });
+         session.visit_cache(add_to_contract);
+      });
+
+      result.contracts.reserve(contracts.size());
+      for (auto& c : contracts) {
+         result.contracts.push_back(std::move(c.second));
+      }
+      std::sort(result.contracts.begin(), result.contracts.end(), [](const auto& a, const auto& b) {
+         return a.cached_bytes > b.cached_bytes;
+      });
+
+      result.rocksdb_reads              = kv_database->reads();
+      result.rocksdb_estimate_num_keys  = kv_database->int_property("rocksdb.estimate-num-keys").value_or(0);
+      result.rocksdb_block_cache_bytes  = kv_database->int_property("rocksdb.block-cache-usage").value_or(0);
+      result.rocksdb_memtable_bytes     = kv_database->int_property("rocksdb.cur-size-all-mem-tables").value_or(0);
+      result.rocksdb_table_reader_bytes = kv_database->int_property("rocksdb.estimate-table-readers-mem").value_or(0);
+      return result;
+   }
+
    void combined_database::undo() {
       db.undo();
 
@@ -298,6 +453,10 @@ namespace eosio { namespace chain {
          }
          CATCH_AND_EXIT_DB_FAILURE()
       }
+
+      if (undo_callback) {
+         undo_callback();
+      }
    }
 
    void combined_database::commit(int64_t revision) {
@@ -497,7 +656,8 @@ namespace eosio { namespace chain {
          });
       });
 
-      read_kv_table_from_snapshot(snapshot, db, kv_database, header.version, backing_store);
+      read_kv_table_from_snapshot(snapshot, db, kv_database, header.version, backing_store, kv_snapshot_batch_threashold,
+                                  kv_snapshot_write_threads, kv_snapshot_ingest_dir);
       read_contract_tables_from_snapshot(snapshot);
 
       authorization.read_from_snapshot(snapshot);
@@ -590,7 +750,9 @@ namespace eosio { namespace chain {
 
    template <typename Section>
    void rocksdb_read_contract_tables_from_snapshot(rocks_db_type& kv_database, chainbase::database& db,
-                                                   Section& section, uint64_t snapshot_batch_threashold) {
+                                                   Section& section, uint64_t snapshot_batch_threashold,
+                                                   uint16_t write_threads, const std::string& ingest_dir) {
+      rocksdb_snapshot_batch_writer                                                      writer(kv_database, write_threads, ingest_dir);
       std::vector<std::pair<eosio::session::shared_bytes, eosio::session::shared_bytes>> batch;
       bool                more     = !section.empty();
       auto                read_row = [&section, &more, &db](auto& row) { more = section.read_row(row, db); };
@@ -600,7 +762,7 @@ namespace eosio { namespace chain {
          // read the row for the table
          backing_store::table_id_object_view table_obj;
          read_row(table_obj);
-         auto put = [&batch, &table_obj, &batch_mem_size, &kv_database, snapshot_batch_threashold]
+         auto put = [&batch, &table_obj, &batch_mem_size, &writer, snapshot_batch_threashold]
                (auto&& value, auto create_fun, auto&&... args) {
             auto composite_key = create_fun(table_obj.scope, table_obj.table, std::forward<decltype(args)>(args)...);
             batch.emplace_back(backing_store::db_key_value_format::create_full_key(composite_key, table_obj.code),
@@ -609,7 +771,7 @@ namespace eosio { namespace chain {
             const auto& back = batch.back();
             const auto size = back.first.size() + back.second.size();
             if (size >= snapshot_batch_threashold || snapshot_batch_threashold - size < batch_mem_size) {
-               kv_database.write(batch);
+               writer.write(std::move(batch));
                batch_mem_size = 0;
                batch.clear();
             }
@@ -654,13 +816,15 @@ namespace eosio { namespace chain {
          put(pp.as_payload(), create_table_key);
 
       }
-      kv_database.write(batch);
+      writer.write(std::move(batch));
+      writer.finish();
    }
 
    void combined_database::read_contract_tables_from_snapshot(const snapshot_reader_ptr& snapshot) {
       snapshot->read_section("contract_tables", [this](auto& section) {
          if (kv_undo_stack && db.get<kv_db_config_object>().backing_store == backing_store_type::ROCKSDB)
-            rocksdb_read_contract_tables_from_snapshot(*kv_database, db, section, kv_snapshot_batch_threashold);
+            rocksdb_read_contract_tables_from_snapshot(*kv_database, db, section, kv_snapshot_batch_threashold,
+                                                       kv_snapshot_write_threads, kv_snapshot_ingest_dir);
          else
             chainbase_read_contract_tables_from_snapshot(db, section);
       });
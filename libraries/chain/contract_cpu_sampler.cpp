@@ -0,0 +1,84 @@
+#include <eosio/chain/contract_cpu_sampler.hpp>
+
+#include <fc/log/logger_config.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+namespace eosio { namespace chain {
+
+contract_cpu_sampler::~contract_cpu_sampler() {
+   stop();
+}
+
+void contract_cpu_sampler::start( fc::microseconds interval ) {
+   stop();
+   {
+      std::lock_guard<std::mutex> g( _mtx );
+      _stopping = false;
+   }
+   _interval = interval;
+   _tagged_thread = std::this_thread::get_id();
+   _running = true;
+   _thread = std::thread( [this]() {
+      fc::set_os_thread_name( "cpusmp" );
+      run();
+   } );
+}
+
+void contract_cpu_sampler::stop() {
+   if( !_thread.joinable() ) return;
+   _running = false;
+   {
+      std::lock_guard<std::mutex> g( _mtx );
+      _stopping = true;
+   }
+   _stop_cv.notify_all();
+   _thread.join();
+}
+
+void contract_cpu_sampler::run() {
+   std::unique_lock<std::mutex> g( _mtx );
+   while( !_stop_cv.wait_for( g, std::chrono::microseconds( _interval.count() ), [this]() { return _stopping; } ) ) {
+      const auto seq = _seq.load( std::memory_order_acquire );
+      const auto receiver = _receiver.load( std::memory_order_relaxed );
+      const auto account = _account.load( std::memory_order_relaxed );
+      const auto action = _action.load( std::memory_order_relaxed );
+      std::atomic_thread_fence( std::memory_order_acquire );
+      ++_samples;
+      // a tag being written is an action starting or ending, not counted
+      if( seq % 2 == 1 || seq != _seq.load( std::memory_order_relaxed ) || receiver == 0 )
+         continue;
+      ++_action_samples;
+      ++_counts[std::make_tuple( receiver, account, action )];
+   }
+}
+
+contract_cpu_samples contract_cpu_sampler::get_samples( size_t limit )const {
+   contract_cpu_samples result;
+   {
+      std::lock_guard<std::mutex> g( _mtx );
+      result.interval = _interval;
+      result.samples = _samples;
+      result.action_samples = _action_samples;
+      result.actions.reserve( _counts.size() );
+      for( const auto& [key, samples] : _counts ) {
+         const auto& [receiver, account, action] = key;
+         result.actions.push_back( { name( receiver ), name( account ), name( action ), samples } );
+      }
+   }
+   std::sort( result.actions.begin(), result.actions.end(),
+              []( const auto& a, const auto& b ) { return a.samples > b.samples; } );
+   if( result.actions.size() > limit )
+      result.actions.resize( limit );
+   return result;
+}
+
+void contract_cpu_sampler::reset() {
+   std::lock_guard<std::mutex> g( _mtx );
+   _samples = 0;
+   _action_samples = 0;
+   _counts.clear();
+}
+
+} } /// namespace eosio::chain
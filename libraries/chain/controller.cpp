@@ -12,6 +12,11 @@
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/thread_utils.hpp>
 #include <eosio/chain/platform_timer.hpp>
+#include <eosio/chain/recovered_key_cache.hpp>
+#include <eosio/chain/block_apply_metrics.hpp>
+#include <eosio/chain/contract_cpu_sampler.hpp>
+#include <eosio/chain/state_access_recorder.hpp>
+#include <eosio/chain/table_usage_tracker.hpp>
 
 #include <chainbase/chainbase.hpp>
 #include <fc/io/json.hpp>
@@ -20,7 +25,12 @@
 #include <fc/variant_object.hpp>
 #include <b1/chain_kv/chain_kv.hpp>
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <new>
+#include <thread>
+#include <unordered_set>
 
 #if defined(EOSIO_EOS_VM_RUNTIME_ENABLED) || defined(EOSIO_EOS_VM_JIT_RUNTIME_ENABLED)
 #include <eosio/vm/allocator.hpp>
@@ -30,6 +40,109 @@ namespace eosio { namespace chain {
 
 using resource_limits::resource_limits_manager;
 
+/// hashed copy of a list of the config, looked up for every action; the flat_set of the config stays the source of truth
+template<typename T, typename Hash = std::hash<T>>
+class hashed_list {
+public:
+   void assign( const flat_set<T>& list ) {
+      _set.clear();
+      _set.reserve( list.size() );
+      _set.insert( list.begin(), list.end() );
+   }
+
+   void insert( const T& v ) { _set.insert( v ); }
+   void erase( const T& v ) { _set.erase( v ); }
+
+   bool empty()const { return _set.empty(); }
+   bool contains( const T& v )const { return _set.find( v ) != _set.end(); }
+
+private:
+   std::unordered_set<T, Hash> _set;
+};
+
+struct action_list_hash {
+   size_t operator()( const pair<account_name, action_name>& a )const {
+      return std::hash<uint64_t>()( a.first.to_uint64_t() ^ ( a.second.to_uint64_t() * 0x9e3779b97f4a7c15ull ) );
+   }
+};
+
+/// reads and unpacks the blocks of the block log on a thread of its own, up to depth blocks ahead of replay
+class replay_block_prefetcher {
+public:
+   replay_block_prefetcher( const block_log& blog, uint32_t first_block_num, uint32_t depth )
+   :_blog( blog )
+   ,_next_block_num( first_block_num )
+   ,_depth( depth )
+   ,_thread( [this]() {
+      fc::set_os_thread_name( "replay-read" );
+      run();
+   } )
+   {}
+
+   ~replay_block_prefetcher() {
+      {
+         std::lock_guard g( _mtx );
+         _stopping = true;
+      }
+      _cv.notify_all();
+      _thread.join();
+   }
+
+   /// the next block, nullptr past the end of the block log; rethrows the error the read failed with
+   std::unique_ptr<signed_block> next() {
+      std::unique_lock g( _mtx );
+      _cv.wait( g, [this]() { return !_blocks.empty() || _done; } );
+      if( _blocks.empty() ) {
+         if( _error ) std::rethrow_exception( _error );
+         return {};
+      }
+      auto b = std::move( _blocks.front() );
+      _blocks.pop_front();
+      g.unlock();
+      _cv.notify_all();
+      return b;
+   }
+
+private:
+   void run() {
+      try {
+         while( true ) {
+            {
+               std::unique_lock g( _mtx );
+               _cv.wait( g, [this]() { return _stopping || _blocks.size() < _depth; } );
+               if( _stopping ) break;
+            }
+            auto b = _blog.read_signed_block_by_num( _next_block_num++ );
+            if( !b ) break;
+            {
+               std::lock_guard g( _mtx );
+               _blocks.push_back( std::move( b ) );
+            }
+            _cv.notify_all();
+         }
+      } catch( ... ) {
+         std::lock_guard g( _mtx );
+         _error = std::current_exception();
+      }
+      {
+         std::lock_guard g( _mtx );
+         _done = true;
+      }
+      _cv.notify_all();
+   }
+
+   const block_log&                          _blog;
+   uint32_t                                  _next_block_num;
+   const uint32_t                            _depth;
+   std::mutex                                _mtx;
+   std::condition_variable                   _cv;
+   std::deque<std::unique_ptr<signed_block>> _blocks;
+   bool                                      _stopping = false;
+   bool                                      _done = false;
+   std::exception_ptr                        _error;
+   std::thread                               _thread; ///< last, started once the members above are constructed
+};
+
 struct building_block {
    building_block( const block_header_state& prev,
                    block_timestamp_type when,
@@ -37,7 +150,7 @@ struct building_block {
                    const vector<digest_type>& new_protocol_feature_activations )
    :_pending_block_header_state( prev.next( when, num_prev_blocks_to_confirm ) )
    ,_new_protocol_feature_activations( new_protocol_feature_activations )
-   ,_trx_mroot_or_receipt_digests( digests_t{} )
+   ,_trx_mroot_or_receipt_merkle( merkle_accumulator{} )
    {}
 
    pending_block_header_state                 _pending_block_header_state;
@@ -46,8 +159,13 @@ struct building_block {
    size_t                                     _num_new_protocol_features_that_have_activated = 0;
    deque<transaction_metadata_ptr>            _pending_trx_metas;
    deque<transaction_receipt>                 _pending_trx_receipts; // boost deque in 1.71 with 1024 elements performs better
-   std::variant<checksum256_type, digests_t>  _trx_mroot_or_receipt_digests;
-   digests_t                                  _action_receipt_digests;
+   std::variant<checksum256_type, merkle_accumulator> _trx_mroot_or_receipt_merkle;
+   merkle_accumulator                         _action_receipt_merkle;
+   std::optional<checksum256_type>            _trusted_action_mroot; // used instead of _action_receipt_merkle root when set
+
+   void append_action_receipt_digests( const deque<digest_type>& digests ) {
+      if( !_trusted_action_mroot ) _action_receipt_merkle.append( digests );
+   }
 };
 
 struct assembled_block {
@@ -79,6 +197,8 @@ struct pending_state {
    block_stage_type                   _block_stage;
    controller::block_status           _block_status = controller::block_status::incomplete;
    std::optional<block_id_type>       _producer_block_id;
+   vector<state_access_recorder::recorded_transaction> _trx_state_accesses; ///< only recorded with a state_access_recorder
+   vector<table_usage_deltas>         _trx_table_usage; ///< only recorded with a table_usage_tracker
 
    /** @pre _block_stage cannot hold completed_block alternative */
    const pending_block_header_state& get_pending_block_header_state()const {
@@ -162,6 +282,12 @@ struct controller_impl {
    authorization_manager               authorization;
    protocol_feature_manager            protocol_features;
    controller::config                  conf;
+   hashed_list<account_name>           actor_whitelist;    ///< of conf, kept in sync by the setters
+   hashed_list<account_name>           actor_blacklist;
+   hashed_list<account_name>           contract_whitelist;
+   hashed_list<account_name>           contract_blacklist;
+   hashed_list<pair<account_name, action_name>, action_list_hash> action_blacklist;
+   hashed_list<account_name>           resource_greylist;
    const chain_id_type                 chain_id; // read by thread_pool threads, value will not be changed
    std::optional<fc::time_point>       replay_head_time;
    db_read_mode                        read_mode = db_read_mode::SPECULATIVE;
@@ -170,7 +296,23 @@ struct controller_impl {
    bool                                trusted_producer_light_validation = false;
    uint32_t                            snapshot_head_block = 0;
    named_thread_pool                   thread_pool;
+   recovered_key_cache                 key_cache;
    platform_timer                      timer;
+   block_apply_metrics                 apply_metrics;
+   contract_cpu_sampler                cpu_sampler; ///< started when conf.contract_cpu_sample_interval_us is set
+   block_apply_stage_times             last_apply_times;
+   block_apply_stage_times*            current_apply_times = nullptr; ///< set while in apply_block
+   std::unique_ptr<state_access_recorder> access_recorder; ///< set when conf.state_access_log is configured
+   std::shared_ptr<table_usage_tracker> table_usage; ///< set by set_table_usage_tracker
+   uint64_t                            profiled_trx_candidates = 0; ///< transactions considered for conf.action_profile_sample_rate
+
+   struct prefetched_block_keys {
+      signed_block_ptr                 block;
+      vector<recover_keys_future>      trx_keys; ///< one per packed_transaction receipt, in block order
+   };
+   std::mutex                                         prefetched_keys_mtx;
+   deque<pair<block_id_type, prefetched_block_keys>>  prefetched_keys; ///< in order of start, guarded by prefetched_keys_mtx
+   uint32_t                                           prefetch_head_block_num = 0; ///< guarded by prefetched_keys_mtx
    fc::logger*                         deep_mind_logger = nullptr;
 #if defined(EOSIO_EOS_VM_RUNTIME_ENABLED) || defined(EOSIO_EOS_VM_JIT_RUNTIME_ENABLED)
    vm::wasm_allocator               wasm_alloc;
@@ -197,6 +339,8 @@ struct controller_impl {
          EOS_ASSERT( head->block, block_validate_exception, "attempting to pop a block that was sparsely loaded from a snapshot");
       }
 
+      if( table_usage ) table_usage->pop_block( head->block_num );
+
       head = prev;
 
       kv_db.undo();
@@ -244,7 +388,8 @@ struct controller_impl {
     conf( cfg ),
     chain_id( chain_id ),
     read_mode( cfg.read_mode ),
-    thread_pool( "chain", cfg.thread_pool_size )
+    thread_pool( "chain", cfg.thread_pool_size, cfg.thread_pool_cpus ),
+    key_cache( cfg.recovered_key_cache_size )
    {
       fork_db.open( [this]( block_timestamp_type timestamp,
                             const flat_set<digest_type>& cur_features,
@@ -261,11 +406,29 @@ struct controller_impl {
       set_activation_handler<builtin_protocol_feature_t::kv_database>();
       set_activation_handler<builtin_protocol_feature_t::configurable_wasm_limits>();
       set_activation_handler<builtin_protocol_feature_t::blockchain_parameters>();
+      set_activation_handler<builtin_protocol_feature_t::batched_database>();
 
       self.irreversible_block.connect([this](const block_state_ptr& bsp) {
          wasmif.current_lib(bsp->block_num);
       });
 
+      kv_db.set_undo_callback([this]() { authorization.on_undo(); });
+
+      actor_whitelist.assign( conf.actor_whitelist );
+      actor_blacklist.assign( conf.actor_blacklist );
+      contract_whitelist.assign( conf.contract_whitelist );
+      contract_blacklist.assign( conf.contract_blacklist );
+      action_blacklist.assign( conf.action_blacklist );
+      resource_greylist.assign( conf.resource_greylist );
+
+      // controller is created on the main thread, whose actions are sampled
+      if( conf.contract_cpu_sample_interval_us > 0 )
+         cpu_sampler.start( fc::microseconds( conf.contract_cpu_sample_interval_us ) );
+
+      if( !cfg.state_access_log.empty() ) {
+         access_recorder = std::make_unique<state_access_recorder>( cfg.state_access_log );
+      }
+
 #define SET_APP_HANDLER( receiver, contract, action) \
    set_apply_handler( account_name(#receiver), account_name(#contract), action_name(#action), \
                       &BOOST_PP_CAT(apply_, BOOST_PP_CAT(contract, BOOST_PP_CAT(_,action) ) ) )
@@ -351,29 +514,57 @@ struct controller_impl {
          }
          auto it = v.begin();
 
-         for( auto bitr = branch.rbegin(); bitr != branch.rend(); ++bitr ) {
-            if( read_mode == db_read_mode::IRREVERSIBLE ) {
-               apply_block( *bitr, controller::block_status::complete, trx_meta_cache_lookup{} );
-               head = (*bitr);
-               fork_db.mark_valid( head );
-            }
-
-            emit( self.irreversible_block, *bitr );
-
-            // blog.append could fail due to failures like running out of space.
+         // Appended blocks are flushed to the block log as a group, and only then committed, so catching up on
+         // irreversibility costs one flush per group instead of one per block.
+         constexpr uint32_t max_blocks_per_log_flush = 32;
+         block_state_ptr    last_appended;
+         uint32_t           unflushed_blocks = 0;
+         auto flush_and_commit = [&]() {
+            if( !last_appended )
+               return;
+            // blog.flush could fail due to failures like running out of space.
             // Do it before commit so that in case it throws, DB can be rolled back.
-            blog.append( std::move( *it ) );
-            ++it;
+            const auto flush_start = fc::time_point::now();
+            blog.flush();
+            apply_metrics.block_log_append.add( fc::time_point::now() - flush_start );
 
-            kv_db.commit( (*bitr)->block_num );
-            root_id = (*bitr)->id;
+            kv_db.commit( last_appended->block_num );
+            root_id = last_appended->id;
 
             auto rbitr = rbi.begin();
-            while( rbitr != rbi.end() && rbitr->blocknum <= (*bitr)->block_num ) {
+            while( rbitr != rbi.end() && rbitr->blocknum <= last_appended->block_num ) {
                reversible_blocks.remove( *rbitr );
                rbitr = rbi.begin();
             }
+            last_appended.reset();
+            unflushed_blocks = 0;
+         };
+
+         try {
+            for( auto bitr = branch.rbegin(); bitr != branch.rend(); ++bitr ) {
+               if( read_mode == db_read_mode::IRREVERSIBLE ) {
+                  apply_block( *bitr, controller::block_status::complete, trx_meta_cache_lookup{} );
+                  head = (*bitr);
+                  fork_db.mark_valid( head );
+               }
+
+               emit( self.irreversible_block, *bitr );
+
+               const auto append_start = fc::time_point::now();
+               blog.append( std::move( *it ) );
+               apply_metrics.block_log_append.add( fc::time_point::now() - append_start );
+               ++it;
+
+               last_appended = *bitr;
+               if( ++unflushed_blocks == max_blocks_per_log_flush )
+                  flush_and_commit();
+            }
+         } catch( std::exception& ) {
+            // keep the blocks that made it in to the block log before the failure
+            flush_and_commit();
+            throw;
          }
+         flush_and_commit();
       } catch( std::exception& ) {
          if( root_id != fork_db.root()->id ) {
             fork_db.advance_root( root_id );
@@ -429,7 +620,13 @@ struct controller_impl {
          ilog( "existing block log, attempting to replay from ${s} to ${n} blocks",
                ("s", start_block_num)("n", blog_head->block_num()) );
          try {
-            while( std::unique_ptr<signed_block> next = blog.read_signed_block_by_num( head->block_num + 1 ) ) {
+            std::optional<replay_block_prefetcher> prefetcher;
+            if( conf.replay_prefetch_blocks > 0 )
+               prefetcher.emplace( blog, head->block_num + 1, conf.replay_prefetch_blocks );
+            auto read_next = [&]() {
+               return prefetcher ? prefetcher->next() : blog.read_signed_block_by_num( head->block_num + 1 );
+            };
+            while( std::unique_ptr<signed_block> next = read_next() ) {
                auto block_num = next->block_num();
                replay_push_block( std::move(next), controller::block_status::irreversible );
                if( check_shutdown() ) break;
@@ -443,6 +640,22 @@ struct controller_impl {
          ilog( "${n} irreversible blocks replayed", ("n", 1 + head->block_num - start_block_num) );
 
          auto pending_head = fork_db.pending_head();
+         if( conf.replay_trust_block_log && !conf.force_all_checks ) {
+            // the action merkle roots were taken from the block log, so the replayed ids only show that the log is
+            // consistent with itself; check it against the blocks this node validated before, kept in the fork database
+            const auto& root = fork_db.root();
+            if( root->block_num <= head->block_num && head->block_num <= pending_head->block_num ) {
+               auto validated = head->block_num == root->block_num ? root : fork_db.search_on_branch( pending_head->id, head->block_num );
+               EOS_ASSERT( validated && validated->id == head->id, block_log_exception,
+                           "replayed head ${h} does not match block ${n} of the fork database",
+                           ("h", head->id)("n", head->block_num) );
+            } else {
+               wlog( "trusted block log does not overlap the fork database, replayed head ${h} could not be checked",
+                     ("h", head->id) );
+            }
+         }
+
+
          if( pending_head->block_num < head->block_num || head->block_num < fork_db.root()->block_num ) {
             ilog( "resetting fork database with new last irreversible block as the new root: ${id}",
                   ("id", head->id) );
@@ -726,6 +939,11 @@ struct controller_impl {
          replay( check_shutdown ); // replay any irreversible and reversible blocks ahead of current head
       }
 
+      {
+         std::lock_guard<std::mutex> g( prefetched_keys_mtx );
+         prefetch_head_block_num = head->block_num;
+      }
+
       if( check_shutdown() ) return;
 
       if( read_mode != db_read_mode::IRREVERSIBLE
@@ -872,27 +1090,48 @@ struct controller_impl {
       auto& bb = std::get<building_block>(pending->_block_stage);
       auto orig_trx_receipts_size           = bb._pending_trx_receipts.size();
       auto orig_trx_metas_size              = bb._pending_trx_metas.size();
-      auto orig_trx_receipt_digests_size    = std::holds_alternative<digests_t>(bb._trx_mroot_or_receipt_digests) ?
-            std::get<digests_t>(bb._trx_mroot_or_receipt_digests).size() : 0;
-      auto orig_action_receipt_digests_size = bb._action_receipt_digests.size();
+      auto orig_trx_state_accesses_size     = pending->_trx_state_accesses.size();
+      auto orig_trx_table_usage_size        = pending->_trx_table_usage.size();
+      // accumulators can not be truncated, they hold only O(log n) subtree roots so are copied instead
+      auto orig_trx_receipt_merkle          = bb._trx_mroot_or_receipt_merkle;
+      auto orig_action_receipt_merkle       = bb._action_receipt_merkle;
 
       std::function<void()> callback = [this,
             orig_trx_receipts_size,
             orig_trx_metas_size,
-            orig_trx_receipt_digests_size,
-            orig_action_receipt_digests_size]()
+            orig_trx_state_accesses_size,
+            orig_trx_table_usage_size,
+            orig_trx_receipt_merkle{std::move(orig_trx_receipt_merkle)},
+            orig_action_receipt_merkle{std::move(orig_action_receipt_merkle)}]()
       {
         auto& bb = std::get<building_block>(pending->_block_stage);
          bb._pending_trx_receipts.resize(orig_trx_receipts_size);
          bb._pending_trx_metas.resize(orig_trx_metas_size);
-        if( std::holds_alternative<digests_t>(bb._trx_mroot_or_receipt_digests) )
-            std::get<digests_t>(bb._trx_mroot_or_receipt_digests).resize(orig_trx_receipt_digests_size);
-         bb._action_receipt_digests.resize(orig_action_receipt_digests_size);
+         pending->_trx_state_accesses.resize(orig_trx_state_accesses_size);
+         pending->_trx_table_usage.resize(orig_trx_table_usage_size);
+         bb._trx_mroot_or_receipt_merkle = orig_trx_receipt_merkle;
+         bb._action_receipt_merkle = orig_action_receipt_merkle;
       };
 
       return fc::make_scoped_exit( std::move(callback) );
    }
 
+   /// one in every conf.action_profile_sample_rate transactions is profiled
+   bool sample_action_profile() {
+      return conf.action_profile_sample_rate > 0 && ++profiled_trx_candidates % conf.action_profile_sample_rate == 0;
+   }
+
+   void record_state_accesses( const transaction_id_type& id, transaction_context& trx_context ) {
+      if( !trx_context.state_accesses ) return;
+      trx_context.state_accesses->normalize();
+      pending->_trx_state_accesses.emplace_back( id, std::move( *trx_context.state_accesses ) );
+   }
+
+   void record_table_usage( transaction_context& trx_context ) {
+      if( !trx_context.table_deltas ) return;
+      pending->_trx_table_usage.emplace_back( std::move( *trx_context.table_deltas ) );
+   }
+
    transaction_trace_ptr apply_onerror( const generated_transaction& gtrx,
                                         fc::time_point deadline,
                                         fc::time_point start,
@@ -931,6 +1170,7 @@ struct controller_impl {
       trx_context.explicit_billed_cpu_time = explicit_billed_cpu_time;
       trx_context.billed_cpu_time_us = billed_cpu_time_us;
       trx_context.enforce_whiteblacklist = enforce_whiteblacklist;
+      if( table_usage ) trx_context.table_deltas.emplace();
       transaction_trace_ptr trace = trx_context.trace;
 
       auto handle_exception = [&](const auto& e)
@@ -950,8 +1190,8 @@ struct controller_impl {
          auto restore = make_block_restore_point();
          trace->receipt = push_receipt( gtrx.trx_id, transaction_receipt::soft_fail,
                                         trx_context.billed_cpu_time_us, trace->net_usage );
-         fc::move_append( std::get<building_block>(pending->_block_stage)._action_receipt_digests,
-                          std::move(trx_context.executed_action_receipt_digests) );
+         std::get<building_block>(pending->_block_stage).append_action_receipt_digests( trx_context.executed_action_receipt_digests );
+         record_table_usage( trx_context );
 
          trx_context.squash();
          restore.cancel();
@@ -1077,6 +1317,9 @@ struct controller_impl {
       trx_context.explicit_billed_cpu_time = explicit_billed_cpu_time;
       trx_context.billed_cpu_time_us = billed_cpu_time_us;
       trx_context.enforce_whiteblacklist = gtrx.sender.empty() ? true : !sender_avoids_whitelist_blacklist_enforcement( gtrx.sender );
+      if( access_recorder ) trx_context.state_accesses.emplace();
+      if( table_usage ) trx_context.table_deltas.emplace();
+      trx_context.profile_actions = sample_action_profile();
       trace = trx_context.trace;
 
       auto handle_exception = [&](const auto& e)
@@ -1116,9 +1359,10 @@ struct controller_impl {
                                         transaction_receipt::executed,
                                         trx_context.billed_cpu_time_us,
                                         trace->net_usage );
+         record_state_accesses( gtrx.trx_id, trx_context );
+         record_table_usage( trx_context );
 
-         fc::move_append( std::get<building_block>(pending->_block_stage)._action_receipt_digests,
-                          std::move(trx_context.executed_action_receipt_digests) );
+         std::get<building_block>(pending->_block_stage).append_action_receipt_digests( trx_context.executed_action_receipt_digests );
 
          trace->account_ram_delta = account_delta( gtrx.payer, trx_removal_ram_delta );
 
@@ -1227,8 +1471,8 @@ struct controller_impl {
       r.net_usage_words      = net_usage_words;
       r.status               = status;
       auto& bb = std::get<building_block>(pending->_block_stage);
-      if( std::holds_alternative<digests_t>(bb._trx_mroot_or_receipt_digests) )
-         std::get<digests_t>(bb._trx_mroot_or_receipt_digests).emplace_back( r.digest() );
+      if( std::holds_alternative<merkle_accumulator>(bb._trx_mroot_or_receipt_merkle) )
+         std::get<merkle_accumulator>(bb._trx_mroot_or_receipt_merkle).append( r.digest() );
       return r;
    }
 
@@ -1249,7 +1493,8 @@ struct controller_impl {
       transaction_trace_ptr trace;
       try {
          auto start = fc::time_point::now();
-         const bool check_auth = !self.skip_auth_check() && !trx->implicit;
+         // read-only transactions can not change state, so they are run without signatures
+         const bool check_auth = !self.skip_auth_check() && !trx->implicit && !trx->read_only;
          const fc::microseconds sig_cpu_usage = trx->signature_cpu_usage();
 
          if( !explicit_billed_cpu_time ) {
@@ -1271,6 +1516,10 @@ struct controller_impl {
          trx_context.explicit_billed_cpu_time = explicit_billed_cpu_time;
          trx_context.billed_cpu_time_us = billed_cpu_time_us;
          trx_context.subjective_cpu_bill_us = subjective_cpu_bill_us;
+         trx_context.read_only = trx->read_only;
+         if( access_recorder && !trx->implicit && !trx->read_only ) trx_context.state_accesses.emplace();
+         if( table_usage && !trx->read_only ) trx_context.table_deltas.emplace();
+         trx_context.profile_actions = !trx->implicit && sample_action_profile();
          trace = trx_context.trace;
 
          auto handle_exception =[&](const auto& e)
@@ -1300,6 +1549,7 @@ struct controller_impl {
 
             trx_context.delay = fc::seconds(trn.delay_sec);
 
+            const auto auth_start = fc::time_point::now();
             if( check_auth ) {
                authorization.check_authorization(
                        trn.actions,
@@ -1310,10 +1560,23 @@ struct controller_impl {
                        false
                );
             }
+            if( current_apply_times ) current_apply_times->check_auth += fc::time_point::now() - auth_start;
             trx_context.exec();
             trx_context.finalize(); // Automatically rounds up network and CPU usage in trace and bills payers if successful
 
+            if( trx->read_only ) {
+               // only the trace is returned, nothing is added to the pending block or signaled
+               transaction_receipt_header r;
+               r.status = transaction_receipt::executed;
+               r.cpu_usage_us = trx_context.billed_cpu_time_us;
+               r.net_usage_words = trace->net_usage / 8;
+               trace->receipt = r;
+               trx_context.undo();
+               return trace;
+            }
+
             auto restore = make_block_restore_point();
+            record_table_usage( trx_context );
 
             if (!trx->implicit) {
                transaction_receipt::status_enum s = (trx_context.delay == fc::seconds(0))
@@ -1321,6 +1584,7 @@ struct controller_impl {
                                                     : transaction_receipt::delayed;
                trace->receipt = push_receipt(*trx->packed_trx(), s, trx_context.billed_cpu_time_us, trace->net_usage);
                trx->billed_cpu_time_us = trx_context.billed_cpu_time_us;
+               record_state_accesses( trx->id(), trx_context );
                std::get<building_block>(pending->_block_stage)._pending_trx_metas.emplace_back(trx);
             } else {
                transaction_receipt_header r;
@@ -1330,8 +1594,7 @@ struct controller_impl {
                trace->receipt = r;
             }
 
-            fc::move_append( std::get<building_block>(pending->_block_stage)._action_receipt_digests,
-                             std::move(trx_context.executed_action_receipt_digests) );
+            std::get<building_block>(pending->_block_stage).append_action_receipt_digests( trx_context.executed_action_receipt_digests );
 
             // call the accept signal but only once for this transaction
             if (!trx->accepted) {
@@ -1364,8 +1627,10 @@ struct controller_impl {
            handle_exception(wrapper);
          }
 
-         emit( self.accepted_transaction, trx );
-         emit( self.applied_transaction, std::tie(trace, trx->packed_trx()) );
+         if( !trx->read_only ) {
+            emit( self.accepted_transaction, trx );
+            emit( self.applied_transaction, std::tie(trace, trx->packed_trx()) );
+         }
 
          return trace;
       } FC_CAPTURE_AND_RETHROW((trace))
@@ -1543,19 +1808,6 @@ struct controller_impl {
 
       auto& bb = std::get<building_block>(pending->_block_stage);
 
-      auto action_merkle_fut = async_thread_pool( thread_pool.get_executor(),
-                                                  [ids{std::move( bb._action_receipt_digests )}]() mutable {
-                                                     return merkle( std::move( ids ) );
-                                                  } );
-      const bool calc_trx_merkle = !std::holds_alternative<checksum256_type>(bb._trx_mroot_or_receipt_digests);
-      std::future<checksum256_type> trx_merkle_fut;
-      if( calc_trx_merkle ) {
-         trx_merkle_fut = async_thread_pool( thread_pool.get_executor(),
-                                             [ids{std::move( std::get<digests_t>(bb._trx_mroot_or_receipt_digests) )}]() mutable {
-                                                return merkle( std::move( ids ) );
-                                             } );
-      }
-
       // Update resource limits:
       resource_limits.process_account_limit_updates();
       const auto& chain_config = self.get_global_properties().configuration;
@@ -1568,8 +1820,10 @@ struct controller_impl {
 
       // Create (unsigned) block:
       auto block_ptr = std::make_shared<signed_block>( pbhs.make_block_header(
-         calc_trx_merkle ? trx_merkle_fut.get() : std::get<checksum256_type>(bb._trx_mroot_or_receipt_digests),
-         action_merkle_fut.get(),
+         std::holds_alternative<checksum256_type>(bb._trx_mroot_or_receipt_merkle) ?
+               std::get<checksum256_type>(bb._trx_mroot_or_receipt_merkle)
+               : std::get<merkle_accumulator>(bb._trx_mroot_or_receipt_merkle).get_root(),
+         bb._trusted_action_mroot ? *bb._trusted_action_mroot : bb._action_receipt_merkle.get_root(),
          bb._new_pending_producer_schedule,
          std::move( bb._new_protocol_feature_activations ),
          protocol_features.get_protocol_feature_set()
@@ -1620,13 +1874,19 @@ struct controller_impl {
          auto bsp = std::get<completed_block>(pending->_block_stage)._block_state;
 
          if( add_to_fork_db ) {
-            fork_db.add( bsp );
-            fork_db.mark_valid( bsp );
+            fork_db.add_validated( bsp );
             emit( self.accepted_block_header, bsp );
             head = fork_db.head();
             EOS_ASSERT( bsp == head, fork_database_exception, "committed block did not become the new head in fork database");
          }
 
+         if( access_recorder ) {
+            access_recorder->write_block( bsp->block_num, bsp->id, pending->_trx_state_accesses );
+         }
+         if( table_usage ) {
+            table_usage->commit_block( bsp->block_num, pending->_trx_table_usage, fork_db.root()->block_num );
+         }
+
          if( !replay_head_time && read_mode != db_read_mode::IRREVERSIBLE ) {
             reversible_blocks.create<reversible_block_object>( [&]( auto& ubo ) {
                ubo.blocknum = bsp->block_num;
@@ -1711,17 +1971,94 @@ struct controller_impl {
       }
    }
 
-   void apply_block( const block_state_ptr& bsp, controller::block_status s, const trx_meta_cache_lookup& trx_lookup )
+   /// thread safe, called from threads receiving blocks ahead of their apply
+   void start_block_key_recovery( const block_id_type& id, const signed_block_ptr& b ) {
+      EOS_ASSERT( b, block_validate_exception, "null block" );
+      // apply_block does not recover keys for these, see skip_auth_check()
+      if( conf.block_key_prefetch_limit == 0 || read_mode == db_read_mode::IRREVERSIBLE ||
+          conf.block_validation_mode == validation_mode::LIGHT || conf.trusted_producers.count( b->producer ) )
+         return;
+
+      const auto is_prefetched = [&]( const auto& p ) { return p.first == id; };
+      const uint32_t block_num = block_header::num_from_id( id );
+      {
+         std::lock_guard<std::mutex> g( prefetched_keys_mtx );
+         // blocks not yet validated are only prefetched close above head, a block at or below head is already applied
+         // or on a fork, and far-future blocks could otherwise keep the limit filled with recoveries never used
+         if( block_num <= prefetch_head_block_num || block_num > prefetch_head_block_num + conf.block_key_prefetch_limit )
+            return;
+         if( std::any_of( prefetched_keys.begin(), prefetched_keys.end(), is_prefetched ) ) return;
+      }
+
+      vector<packed_transaction_ptr> ptrxs;
+      ptrxs.reserve( b->transactions.size() );
+      for( const auto& receipt : b->transactions ) {
+         if( std::holds_alternative<packed_transaction>(receipt.trx) ) {
+            ptrxs.emplace_back( b, &std::get<packed_transaction>(receipt.trx) ); // alias signed_block_ptr
+         }
+      }
+      prefetched_block_keys pbk{ b, transaction_metadata::start_recover_keys(
+            std::move( ptrxs ), thread_pool.get_executor(), chain_id, microseconds::maximum(), conf.thread_pool_size,
+            UINT32_MAX, &key_cache ) };
+
+      std::lock_guard<std::mutex> g( prefetched_keys_mtx );
+      if( block_num <= prefetch_head_block_num ||
+          std::any_of( prefetched_keys.begin(), prefetched_keys.end(), is_prefetched ) ) return;
+      prefetched_keys.emplace_back( id, std::move( pbk ) );
+      while( prefetched_keys.size() > conf.block_key_prefetch_limit ) {
+         prefetched_keys.pop_front();
+      }
+   }
+
+   /// @returns keys started by start_block_key_recovery for exactly this block, empty if none;
+   ///          prefetches of any block at or below the block number of b are dropped
+   vector<recover_keys_future> take_prefetched_block_keys( const block_id_type& id, const signed_block_ptr& b ) {
+      std::lock_guard<std::mutex> g( prefetched_keys_mtx );
+      vector<recover_keys_future> result;
+      const uint32_t block_num = block_header::num_from_id( id );
+      prefetch_head_block_num = block_num;
+      if( prefetched_keys.empty() ) return result;
+      auto itr = std::find_if( prefetched_keys.begin(), prefetched_keys.end(), [&]( const auto& p ) { return p.first == id; } );
+      // same block id but different signed_block instance is recovered again rather than trusting the prefetched copy
+      if( itr != prefetched_keys.end() && itr->second.block == b ) {
+         result = std::move( itr->second.trx_keys );
+      }
+      prefetched_keys.erase( std::remove_if( prefetched_keys.begin(), prefetched_keys.end(), [&]( const auto& p ) {
+                                return block_header::num_from_id( p.first ) <= block_num;
+                             } ),
+                             prefetched_keys.end() );
+      return result;
+   }
+
+   void apply_block( const block_state_ptr& bsp, controller::block_status s, const trx_meta_cache_lookup& trx_lookup,
+                     bool add_to_fork_db = false )
    { try {
       try {
          const signed_block_ptr& b = bsp->block;
          const auto& new_protocol_feature_activations = bsp->get_new_protocol_feature_activations();
 
+         const auto apply_start = fc::time_point::now();
+         block_apply_stage_times times;
+         times.block_num = bsp->block_num;
+         times.num_trxs = b->transactions.size();
+
          auto producer_block_id = bsp->id;
          start_block( b->timestamp, b->confirmed, new_protocol_feature_activations, s, producer_block_id);
+         current_apply_times = &times;
+         auto reset_apply_times = fc::make_scoped_exit( [this]() { current_apply_times = nullptr; } );
+         auto stage_start = fc::time_point::now();
+         times.start_block = stage_start - apply_start;
 
          // validated in create_block_state_future()
-         std::get<building_block>(pending->_block_stage)._trx_mroot_or_receipt_digests = b->transaction_mroot;
+         std::get<building_block>(pending->_block_stage)._trx_mroot_or_receipt_merkle = b->transaction_mroot;
+         if( s == controller::block_status::irreversible && conf.replay_trust_block_log && !conf.force_all_checks ) {
+            // action receipts of a trusted block log are not re-verified, see replay() for the check against the fork database
+            std::get<building_block>(pending->_block_stage)._trusted_action_mroot = b->action_mroot;
+         } else if( s == controller::block_status::validated && conf.fork_switch_trust_validated && !conf.force_all_checks ) {
+            // this node already produced the same action receipts from the same parent state, which happens when
+            // switching back to a previously applied branch; a divergence of the re-applied state goes unnoticed
+            std::get<building_block>(pending->_block_stage)._trusted_action_mroot = b->action_mroot;
+         }
 
          const bool existing_trxs_metas = !bsp->trxs_metas().empty();
          const bool pub_keys_recovered = bsp->is_pub_keys_recovered();
@@ -1731,9 +2068,14 @@ struct controller_impl {
          if( pub_keys_recovered || (skip_auth_checks && existing_trxs_metas) ) {
             use_bsp_cached = true;
          } else {
+            auto prefetched = skip_auth_checks ? vector<recover_keys_future>{} : take_prefetched_block_keys( bsp->id, b );
+            size_t num_packed = 0;
+            vector<packed_transaction_ptr> to_recover;
+            vector<size_t> to_recover_idx; // index into trx_metas of each to_recover
             trx_metas.reserve( b->transactions.size() );
             for( const auto& receipt : b->transactions ) {
                if( std::holds_alternative<packed_transaction>(receipt.trx)) {
+                  const size_t packed_num = num_packed++;
                   const auto& pt = std::get<packed_transaction>(receipt.trx);
                   transaction_metadata_ptr trx_meta_ptr = trx_lookup ? trx_lookup( pt.id() ) : transaction_metadata_ptr{};
                   if( trx_meta_ptr && *trx_meta_ptr->packed_trx() != pt ) trx_meta_ptr = nullptr;
@@ -1744,29 +2086,44 @@ struct controller_impl {
                      trx_metas.emplace_back(
                            transaction_metadata::create_no_recover_keys( std::move(ptrx), transaction_metadata::trx_type::input ),
                            recover_keys_future{} );
+                  } else if( packed_num < prefetched.size() ) {
+                     trx_metas.emplace_back( transaction_metadata_ptr{}, std::move( prefetched[packed_num] ) );
                   } else {
-                     packed_transaction_ptr ptrx( b, &pt ); // alias signed_block_ptr
-                     auto fut = transaction_metadata::start_recover_keys(
-                           std::move( ptrx ), thread_pool.get_executor(), chain_id, microseconds::maximum() );
-                     trx_metas.emplace_back( transaction_metadata_ptr{}, std::move( fut ) );
+                     to_recover_idx.push_back( trx_metas.size() );
+                     to_recover.emplace_back( b, &pt ); // alias signed_block_ptr
+                     trx_metas.emplace_back( transaction_metadata_ptr{}, recover_keys_future{} );
                   }
                }
             }
+            if( !to_recover.empty() ) {
+               auto futs = transaction_metadata::start_recover_keys(
+                     std::move( to_recover ), thread_pool.get_executor(), chain_id, microseconds::maximum(), conf.thread_pool_size,
+                     UINT32_MAX, &key_cache );
+               for( size_t i = 0; i < futs.size(); ++i ) {
+                  std::get<1>( trx_metas[to_recover_idx[i]] ) = std::move( futs[i] );
+               }
+            }
          }
 
          transaction_trace_ptr trace;
 
          bool explicit_net = self.skip_trx_checks();
 
+         auto now = fc::time_point::now();
+         times.trx_prep = now - stage_start;
+         stage_start = now;
+
          size_t packed_idx = 0;
          const auto& trx_receipts = std::get<building_block>(pending->_block_stage)._pending_trx_receipts;
          for( const auto& receipt : b->transactions ) {
             auto num_pending_receipts = trx_receipts.size();
             if( std::holds_alternative<packed_transaction>(receipt.trx) ) {
+               const auto keys_start = fc::time_point::now();
                const auto& trx_meta = ( use_bsp_cached ? bsp->trxs_metas().at( packed_idx )
                                                        : ( !!std::get<0>( trx_metas.at( packed_idx ) ) ?
                                                              std::get<0>( trx_metas.at( packed_idx ) )
                                                              : std::get<1>( trx_metas.at( packed_idx ) ).get() ) );
+               times.recover_keys += fc::time_point::now() - keys_start;
                std::optional<uint32_t> explicit_net_usage_words;
                if( explicit_net ) {
                   explicit_net_usage_words = receipt.net_usage_words.value;
@@ -1800,8 +2157,16 @@ struct controller_impl {
                         ("producer_receipt", static_cast<const transaction_receipt_header&>(receipt))("validator_receipt", r) );
          }
 
+         now = fc::time_point::now();
+         times.exec_trxs = now - stage_start - times.recover_keys - times.check_auth;
+         stage_start = now;
+
          finalize_block();
 
+         now = fc::time_point::now();
+         times.finalize_block = now - stage_start;
+         stage_start = now;
+
          auto& ab = std::get<assembled_block>(pending->_block_stage);
 
          // this implicitly asserts that all header fields (less the signature) are identical
@@ -1814,7 +2179,13 @@ struct controller_impl {
          // create completed_block with the existing block_state as we just verified it is the same as assembled_block
          pending->_block_stage = completed_block{ bsp };
 
-         commit_block(false);
+         commit_block(add_to_fork_db);
+
+         now = fc::time_point::now();
+         times.commit_block = now - stage_start;
+         times.total = now - apply_start;
+         apply_metrics.add( times );
+         last_apply_times = times;
          return;
       } catch ( const std::bad_alloc& ) {
          throw;
@@ -1842,7 +2213,8 @@ struct controller_impl {
       EOS_ASSERT( prev, unlinkable_block_exception,
                   "unlinkable block ${id}", ("id", id)("previous", b->previous) );
 
-      return async_thread_pool( thread_pool.get_executor(), [b, prev, id, control=this]() {
+      static auto& counters = get_thread_pool_task_counters( "block_state" );
+      return async_thread_pool( thread_pool.get_executor(), counters, [b, prev, id, control=this]() {
          const bool skip_validate_signee = false;
 
          auto trx_mroot = calculate_trx_merkle( b->transactions );
@@ -1887,12 +2259,23 @@ struct controller_impl {
 
          emit( self.pre_accepted_block, b );
 
-         fork_db.add( bsp );
-
          if (self.is_trusted_producer(b->producer)) {
             trusted_producer_light_validation = true;
          };
 
+         // The common case while syncing: the block extends the head and there is no other fork it could lose to.
+         // Applying it before adding it to the fork database does what maybe_switch_forks would, but inserts the block
+         // state once already valid instead of re-indexing it in mark_valid, and leaves nothing to remove on failure.
+         // commit_block adds it to the fork database and makes it head before accepted_block is emitted, as it does
+         // for produced blocks, so subscribers never see a fork database without the accepted block.
+         if( read_mode != db_read_mode::IRREVERSIBLE && b->previous == head->id &&
+             fork_db.head() == head && fork_db.pending_head() == head ) {
+            apply_block( bsp, s, trx_lookup, true );
+            return bsp;
+         }
+
+         fork_db.add( bsp );
+
          emit( self.accepted_block_header, bsp );
 
          if( read_mode != db_read_mode::IRREVERSIBLE ) {
@@ -2082,6 +2465,7 @@ struct controller_impl {
             db.modify(permission, [&]( auto& po ) {
                po.auth = auth;
             });
+            authorization.invalidate_permission({permission.owner, permission.name});
          }
       };
 
@@ -2137,30 +2521,10 @@ struct controller_impl {
    void check_actor_list( const flat_set<account_name>& actors )const {
       if( actors.size() == 0 ) return;
 
-      if( conf.actor_whitelist.size() > 0 ) {
+      if( !actor_whitelist.empty() ) {
          // throw if actors is not a subset of whitelist
-         const auto& whitelist = conf.actor_whitelist;
-         bool is_subset = true;
-
-         // quick extents check, then brute force the check actors
-         if (*actors.cbegin() >= *whitelist.cbegin() && *actors.crbegin() <= *whitelist.crbegin() ) {
-            auto lower_bound = whitelist.cbegin();
-            for (const auto& actor: actors) {
-               lower_bound = std::lower_bound(lower_bound, whitelist.cend(), actor);
-
-               // if the actor is not found, this is not a subset
-               if (lower_bound == whitelist.cend() || *lower_bound != actor ) {
-                  is_subset = false;
-                  break;
-               }
-
-               // if the actor was found, we are guaranteed that other actors are either not present in the whitelist
-               // or will be present in the range defined as [next actor,end)
-               lower_bound = std::next(lower_bound);
-            }
-         } else {
-            is_subset = false;
-         }
+         const bool is_subset = std::all_of( actors.begin(), actors.end(),
+                                             [this]( const auto& actor ) { return actor_whitelist.contains( actor ); } );
 
          // helper lambda to lazily calculate the actors for error messaging
          static auto generate_missing_actors = [](const flat_set<account_name>& actors, const flat_set<account_name>& whitelist) -> vector<account_name> {
@@ -2174,32 +2538,12 @@ struct controller_impl {
 
          EOS_ASSERT( is_subset,  actor_whitelist_exception,
                      "authorizing actor(s) in transaction are not on the actor whitelist: ${actors}",
-                     ("actors", generate_missing_actors(actors, whitelist))
+                     ("actors", generate_missing_actors(actors, conf.actor_whitelist))
                    );
-      } else if( conf.actor_blacklist.size() > 0 ) {
+      } else if( !actor_blacklist.empty() ) {
          // throw if actors intersects blacklist
-         const auto& blacklist = conf.actor_blacklist;
-         bool intersects = false;
-
-         // quick extents check then brute force check actors
-         if( *actors.cbegin() <= *blacklist.crbegin() && *actors.crbegin() >= *blacklist.cbegin() ) {
-            auto lower_bound = blacklist.cbegin();
-            for (const auto& actor: actors) {
-               lower_bound = std::lower_bound(lower_bound, blacklist.cend(), actor);
-
-               // if the lower bound in the blacklist is at the end, all other actors are guaranteed to
-               // not exist in the blacklist
-               if (lower_bound == blacklist.cend()) {
-                  break;
-               }
-
-               // if the lower bound of an actor IS the actor, then we have an intersection
-               if (*lower_bound == actor) {
-                  intersects = true;
-                  break;
-               }
-            }
-         }
+         const bool intersects = std::any_of( actors.begin(), actors.end(),
+                                              [this]( const auto& actor ) { return actor_blacklist.contains( actor ); } );
 
          // helper lambda to lazily calculate the actors for error messaging
          static auto generate_blacklisted_actors = [](const flat_set<account_name>& actors, const flat_set<account_name>& blacklist) -> vector<account_name> {
@@ -2214,19 +2558,19 @@ struct controller_impl {
 
          EOS_ASSERT( !intersects, actor_blacklist_exception,
                      "authorizing actor(s) in transaction are on the actor blacklist: ${actors}",
-                     ("actors", generate_blacklisted_actors(actors, blacklist))
+                     ("actors", generate_blacklisted_actors(actors, conf.actor_blacklist))
                    );
       }
    }
 
    void check_contract_list( account_name code )const {
-      if( conf.contract_whitelist.size() > 0 ) {
-         EOS_ASSERT( conf.contract_whitelist.find( code ) != conf.contract_whitelist.end(),
+      if( !contract_whitelist.empty() ) {
+         EOS_ASSERT( contract_whitelist.contains( code ),
                      contract_whitelist_exception,
                      "account '${code}' is not on the contract whitelist", ("code", code)
                    );
-      } else if( conf.contract_blacklist.size() > 0 ) {
-         EOS_ASSERT( conf.contract_blacklist.find( code ) == conf.contract_blacklist.end(),
+      } else if( !contract_blacklist.empty() ) {
+         EOS_ASSERT( !contract_blacklist.contains( code ),
                      contract_blacklist_exception,
                      "account '${code}' is on the contract blacklist", ("code", code)
                    );
@@ -2234,8 +2578,8 @@ struct controller_impl {
    }
 
    void check_action_list( account_name code, action_name action )const {
-      if( conf.action_blacklist.size() > 0 ) {
-         EOS_ASSERT( conf.action_blacklist.find( std::make_pair(code, action) ) == conf.action_blacklist.end(),
+      if( !action_blacklist.empty() ) {
+         EOS_ASSERT( !action_blacklist.contains( std::make_pair(code, action) ),
                      action_blacklist_exception,
                      "action '${code}::${action}' is on the action blacklist",
                      ("code", code)("action", action)
@@ -2597,10 +2941,30 @@ boost::asio::io_context& controller::get_thread_pool() {
    return my->thread_pool.get_executor();
 }
 
+recovered_key_cache& controller::get_recovered_key_cache() {
+   return my->key_cache;
+}
+
+const block_apply_metrics& controller::get_block_apply_metrics()const {
+   return my->apply_metrics;
+}
+
+contract_cpu_sampler& controller::get_contract_cpu_sampler() {
+   return my->cpu_sampler;
+}
+
+const block_apply_stage_times& controller::get_last_block_apply_times()const {
+   return my->last_apply_times;
+}
+
 std::future<block_state_ptr> controller::create_block_state_future( const block_id_type& id, const signed_block_ptr& b ) {
    return my->create_block_state_future( id, b );
 }
 
+void controller::start_block_key_recovery( const block_id_type& id, const signed_block_ptr& b ) {
+   my->start_block_key_recovery( id, b );
+}
+
 block_state_ptr controller::push_block( std::future<block_state_ptr>& block_state_future,
                              const forked_branch_callback& forked_branch_cb, const trx_meta_cache_lookup& trx_lookup )
 {
@@ -2647,15 +3011,19 @@ const flat_set<public_key_type>& controller::get_key_blacklist() const {
 
 void controller::set_actor_whitelist( const flat_set<account_name>& new_actor_whitelist ) {
    my->conf.actor_whitelist = new_actor_whitelist;
+   my->actor_whitelist.assign( my->conf.actor_whitelist );
 }
 void controller::set_actor_blacklist( const flat_set<account_name>& new_actor_blacklist ) {
    my->conf.actor_blacklist = new_actor_blacklist;
+   my->actor_blacklist.assign( my->conf.actor_blacklist );
 }
 void controller::set_contract_whitelist( const flat_set<account_name>& new_contract_whitelist ) {
    my->conf.contract_whitelist = new_contract_whitelist;
+   my->contract_whitelist.assign( my->conf.contract_whitelist );
 }
 void controller::set_contract_blacklist( const flat_set<account_name>& new_contract_blacklist ) {
    my->conf.contract_blacklist = new_contract_blacklist;
+   my->contract_blacklist.assign( my->conf.contract_blacklist );
 }
 void controller::set_action_blacklist( const flat_set< pair<account_name, action_name> >& new_action_blacklist ) {
    for (auto& act: new_action_blacklist) {
@@ -2663,6 +3031,7 @@ void controller::set_action_blacklist( const flat_set< pair<account_name, action
       EOS_ASSERT(act.second != action_name(), action_type_exception, "Action blacklist - action name should not be empty");
    }
    my->conf.action_blacklist = new_action_blacklist;
+   my->action_blacklist.assign( my->conf.action_blacklist );
 }
 void controller::set_key_blacklist( const flat_set<public_key_type>& new_key_blacklist ) {
    my->conf.key_blacklist = new_key_blacklist;
@@ -2798,6 +3167,14 @@ signed_block_ptr controller::fetch_block_by_number( uint32_t block_num )const  {
    return my->blog.read_signed_block_by_num(block_num);
 } FC_CAPTURE_AND_RETHROW( (block_num) ) }
 
+bool controller::has_block_log_trx_index()const {
+   return my->blog.has_trx_index();
+}
+
+std::optional<uint32_t> controller::fetch_irreversible_block_num_by_trx_id( const transaction_id_type& id )const { try {
+   return my->blog.find_block_num_by_trx_id( id );
+} FC_CAPTURE_AND_RETHROW( (id) ) }
+
 block_state_ptr controller::fetch_block_state_by_id( block_id_type id )const {
    auto state = my->fork_db.get_block(id);
    return state;
@@ -3160,14 +3537,16 @@ uint32_t controller::get_greylist_limit()const {
 
 void controller::add_resource_greylist(const account_name &name) {
    my->conf.resource_greylist.insert(name);
+   my->resource_greylist.insert(name);
 }
 
 void controller::remove_resource_greylist(const account_name &name) {
    my->conf.resource_greylist.erase(name);
+   my->resource_greylist.erase(name);
 }
 
 bool controller::is_resource_greylisted(const account_name &name) const {
-   return my->conf.resource_greylist.find(name) !=  my->conf.resource_greylist.end();
+   return !my->resource_greylist.empty() && my->resource_greylist.contains(name);
 }
 
 const flat_set<account_name> &controller::get_resource_greylist() const {
@@ -3219,6 +3598,10 @@ void controller::enable_deep_mind(fc::logger* logger) {
    my->deep_mind_logger = logger;
 }
 
+void controller::set_table_usage_tracker( std::shared_ptr<table_usage_tracker> tracker ) {
+   my->table_usage = std::move( tracker );
+}
+
 #if defined(EOSIO_EOS_VM_RUNTIME_ENABLED) || defined(EOSIO_EOS_VM_JIT_RUNTIME_ENABLED)
 vm::wasm_allocator& controller::get_wasm_allocator() {
    return my->wasm_alloc;
@@ -3316,6 +3699,7 @@ void controller::replace_account_keys( name account, name permission, const publ
    mutable_db().modify(*perm, [&](auto& p) {
       p.auth = authority(key);
    });
+   get_mutable_authorization_manager().invalidate_permission({account, permission});
    int64_t new_size = (int64_t)(chain::config::billable_size_v<permission_object> + perm->auth.get_billable_size());
    rlm.add_pending_ram_usage(account, new_size - old_size, generic_storage_usage_trace(0));
    rlm.verify_account_ram_usage(account);
@@ -3423,6 +3807,15 @@ void controller_impl::on_activation<builtin_protocol_feature_t::blockchain_param
    } );
 }
 
+template<>
+void controller_impl::on_activation<builtin_protocol_feature_t::batched_database>() {
+   db.modify( db.get<protocol_state_object>(), [&]( auto& ps ) {
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "db_get_batch_i64" );
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "kv_get_batch" );
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "kv_set_batch" );
+   } );
+}
+
 /// End of protocol feature activation handlers
 
 } } /// eosio::chain
@@ -126,11 +126,37 @@ void apply_eosio_newaccount(apply_context& context) {
 
 } FC_CAPTURE_AND_RETHROW( (create) ) }
 
+/**
+ *  setcode unpacked in place: code points into the action data rather than into a copy of it,
+ *  which matters since the payload is the whole contract
+ */
+struct setcode_view {
+   account_name   account;
+   uint8_t        vmtype = 0;
+   uint8_t        vmversion = 0;
+   const char*    code = nullptr;
+   size_t         code_size = 0;
+
+   explicit setcode_view( const action& a ) {
+      EOS_ASSERT( a.account == setcode::get_account() && a.name == setcode::get_name(), action_type_exception,
+                  "action is not setcode" );
+      fc::datastream<const char*> ds( a.data.data(), a.data.size() );
+      fc::unsigned_int size;
+      fc::raw::unpack( ds, account );
+      fc::raw::unpack( ds, vmtype );
+      fc::raw::unpack( ds, vmversion );
+      fc::raw::unpack( ds, size );
+      EOS_ASSERT( size.value <= ds.remaining(), fc::out_of_range_exception, "setcode code exceeds action data" );
+      code      = ds.pos();
+      code_size = size.value;
+   }
+};
+
 void apply_eosio_setcode(apply_context& context) {
    const auto& cfg = context.control.get_global_properties().configuration;
 
    auto& db = context.db;
-   auto  act = context.get_action().data_as<setcode>();
+   setcode_view act( context.get_action() );
    context.require_authorization(act.account);
 
    EOS_ASSERT( act.vmtype == 0, invalid_contract_vm_type, "code should be 0" );
@@ -138,11 +164,11 @@ void apply_eosio_setcode(apply_context& context) {
 
    fc::sha256 code_hash; /// default is the all zeros hash
 
-   int64_t code_size = (int64_t)act.code.size();
+   int64_t code_size = (int64_t)act.code_size;
 
    if( code_size > 0 ) {
-     code_hash = fc::sha256::hash( act.code.data(), (uint32_t)act.code.size() );
-     wasm_interface::validate(context.control, act.code);
+     code_hash = fc::sha256::hash( act.code, (uint32_t)act.code_size );
+     wasm_interface::validate(context.control, act.code, act.code_size);
    }
 
    const auto& account = db.get<account_metadata_object,by_name>(act.account);
@@ -178,7 +204,7 @@ void apply_eosio_setcode(apply_context& context) {
       } else {
          db.create<code_object>([&](code_object& o) {
             o.code_hash = code_hash;
-            o.code.assign(act.code.data(), code_size);
+            o.code.assign(act.code, code_size);
             o.code_ref_count = 1;
             o.first_block_used = context.control.head_block_num() + 1;
             o.vm_type = act.vmtype;
@@ -420,6 +446,7 @@ void apply_eosio_linkauth(apply_context& context) {
             storage_usage_trace(context.get_action_id(), std::move(event_id), "auth_link", "add", "linkauth")
          );
       }
+      context.control.get_mutable_authorization_manager().invalidate_linked_permissions(requirement.account, requirement.code);
 
   } FC_CAPTURE_AND_RETHROW((requirement))
 }
@@ -448,6 +475,7 @@ void apply_eosio_unlinkauth(apply_context& context) {
    );
 
    db.remove(*link);
+   context.control.get_mutable_authorization_manager().invalidate_linked_permissions(unlink.account, unlink.code);
 }
 
 void apply_eosio_canceldelay(apply_context& context) {
@@ -8,6 +8,7 @@
 #include <boost/multi_index/global_fun.hpp>
 #include <boost/multi_index/composite_key.hpp>
 #include <fc/io/fstream.hpp>
+#include <boost/filesystem.hpp>
 #include <fstream>
 
 namespace eosio { namespace chain {
@@ -27,7 +28,34 @@ namespace eosio { namespace chain {
    /**
     * History:
     * Version 1: initial version of the new refactored fork database portable format
+    * Version 2: append-only journal (fork_db.log) replacing the file written on shutdown
     */
+   static const uint32_t journal_version = 2;
+
+   // the journal is rewritten once it holds more than this many bytes beyond its size at the last compaction
+   static const uint64_t journal_compaction_slack = 64*1024*1024ll;
+
+   /**
+    * Every mutation of the fork database is appended to the journal as
+    * [uint8_t type][uint32_t size][payload][uint64_t checksum] and flushed, so the fork database survives an unclean
+    * shutdown. Replaying the records in order rebuilds the same tree and head. A record that was cut short by a crash
+    * fails its checksum, and the journal is truncated at that point.
+    */
+   enum class journal_record : uint8_t {
+      reset                 = 1, ///< payload: root block_header_state
+      add                   = 2, ///< payload: block_state
+      remove                = 3, ///< payload: block_id_type
+      advance_root          = 4, ///< payload: block_id_type
+      mark_valid            = 5, ///< payload: block_id_type
+      rollback_head_to_root = 6  ///< no payload
+   };
+
+   static uint64_t journal_checksum( journal_record type, const vector<char>& payload ) {
+      fc::sha256::encoder enc;
+      enc.write( (const char*)&type, sizeof(type) );
+      enc.write( payload.data(), payload.size() );
+      return enc.result()._hash[0];
+   }
 
    struct by_block_id;
    struct by_lib_block_num;
@@ -71,157 +99,314 @@ namespace eosio { namespace chain {
       block_state_ptr       head;
       fc::path              datadir;
 
+      std::optional<std::ofstream> journal; ///< only open while mutations should be recorded
+      uint64_t                     journal_size = 0;
+      uint64_t                     compacted_size = 0;
+
       void add( const block_state_ptr& n,
                 bool ignore_duplicate, bool validate,
                 const std::function<void( block_timestamp_type,
                                           const flat_set<digest_type>&,
                                           const vector<digest_type>& )>& validator );
+      void remove( const block_id_type& id );
+
+      /**
+       *  Lookups for walking the tree. They point at the block_state_ptr owned by the index (or root) so walking a
+       *  branch does not touch reference counts. Copy the pointer only for blocks that are handed out.
+       */
+      const block_state_ptr* find( const block_id_type& id )const {
+         auto itr = index.find( id );
+         return itr != index.end() ? &*itr : nullptr;
+      }
+      const block_state_ptr* find_or_root( const block_id_type& id )const {
+         return root->id == id ? &root : find( id );
+      }
+
+      fc::path journal_path()const { return datadir / config::forkdb_journal_filename; }
+
+      void append( journal_record type, const vector<char>& payload );
+      template<typename T>
+      void append( journal_record type, const T& payload ) { append( type, fc::raw::pack( payload ) ); }
+
+      void load_legacy( const fc::path& fork_db_dat,
+                        const std::function<void( block_timestamp_type,
+                                                  const flat_set<digest_type>&,
+                                                  const vector<digest_type>& )>& validator );
+      void replay( const std::function<void( block_timestamp_type,
+                                             const flat_set<digest_type>&,
+                                             const vector<digest_type>& )>& validator );
+      void compact();
+      void validate_head( const fc::path& filename )const;
    };
 
+   void fork_database_impl::append( journal_record type, const vector<char>& payload ) {
+      if( !journal ) return;
+
+      const uint32_t size = payload.size();
+      const uint64_t checksum = journal_checksum( type, payload );
+      journal->write( (const char*)&type, sizeof(type) );
+      journal->write( (const char*)&size, sizeof(size) );
+      journal->write( payload.data(), payload.size() );
+      journal->write( (const char*)&checksum, sizeof(checksum) );
+      journal->flush();
+      EOS_ASSERT( journal->good(), fork_database_exception, "failed to append to fork database journal '${filename}'",
+                  ("filename", journal_path().generic_string()) );
+
+      journal_size += sizeof(type) + sizeof(size) + payload.size() + sizeof(checksum);
+      if( journal_size > compacted_size * 2 + journal_compaction_slack )
+         compact();
+   }
 
-   fork_database::fork_database( const fc::path& data_dir )
-   :my( new fork_database_impl( *this, data_dir ) )
-   {}
+   /**
+    *  Rewrites the journal as a reset to the current root followed by the blocks currently in the fork database,
+    *  parents before children.
+    */
+   void fork_database_impl::compact() {
+      const auto filename = journal_path();
+      auto tmp_filename = filename;
+      tmp_filename += ".tmp";
+
+      journal.emplace( tmp_filename.generic_string().c_str(), std::ios::out | std::ios::binary | std::ofstream::trunc );
+      fc::raw::pack( *journal, fork_database::magic_number );
+      fc::raw::pack( *journal, journal_version );
+      journal_size = sizeof(fork_database::magic_number) + sizeof(journal_version);
+      compacted_size = std::numeric_limits<uint64_t>::max() / 4; // no recursive compaction while rewriting
+
+      if( root ) {
+         append( journal_record::reset, *static_cast<block_header_state*>(&*root) );
+
+         vector<block_state_ptr> blocks( index.begin(), index.end() );
+         std::sort( blocks.begin(), blocks.end(), []( const auto& lhs, const auto& rhs ) {
+            return lhs->block_num < rhs->block_num;
+         } );
+         for( const auto& b : blocks )
+            append( journal_record::add, *b );
+      }
 
+      journal.reset();
+      fc::rename( tmp_filename, filename );
+      journal.emplace( filename.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::app );
+      compacted_size = journal_size;
+   }
 
-   void fork_database::open( const std::function<void( block_timestamp_type,
-                                                       const flat_set<digest_type>&,
-                                                       const vector<digest_type>& )>& validator )
+   void fork_database_impl::replay( const std::function<void( block_timestamp_type,
+                                                               const flat_set<digest_type>&,
+                                                               const vector<digest_type>& )>& validator )
    {
-      if (!fc::is_directory(my->datadir))
-         fc::create_directories(my->datadir);
+      const auto filename = journal_path();
+      std::ifstream in( filename.generic_string().c_str(), std::ios::in | std::ios::binary );
+
+      uint32_t totem = 0;
+      in.read( (char*)&totem, sizeof(totem) );
+      EOS_ASSERT( in && totem == fork_database::magic_number, fork_database_exception,
+                  "Fork database journal '${filename}' has unexpected magic number: ${actual_totem}. Expected ${expected_totem}",
+                  ("filename", filename.generic_string())
+                  ("actual_totem", totem)
+                  ("expected_totem", fork_database::magic_number)
+      );
 
-      auto fork_db_dat = my->datadir / config::forkdb_filename;
-      if( fc::exists( fork_db_dat ) ) {
-         try {
-            string content;
-            fc::read_file_contents( fork_db_dat, content );
-
-            fc::datastream<const char*> ds( content.data(), content.size() );
-
-            // validate totem
-            uint32_t totem = 0;
-            fc::raw::unpack( ds, totem );
-            EOS_ASSERT( totem == magic_number, fork_database_exception,
-                        "Fork database file '${filename}' has unexpected magic number: ${actual_totem}. Expected ${expected_totem}",
-                        ("filename", fork_db_dat.generic_string())
-                        ("actual_totem", totem)
-                        ("expected_totem", magic_number)
-            );
-
-            // validate version
-            uint32_t version = 0;
-            fc::raw::unpack( ds, version );
-            EOS_ASSERT( version >= min_supported_version && version <= max_supported_version,
-                        fork_database_exception,
-                       "Unsupported version of fork database file '${filename}'. "
-                       "Fork database version is ${version} while code supports version(s) [${min},${max}]",
-                       ("filename", fork_db_dat.generic_string())
-                       ("version", version)
-                       ("min", min_supported_version)
-                       ("max", max_supported_version)
-            );
-
-            block_header_state bhs;
-            fc::raw::unpack( ds, bhs );
-            reset( bhs );
-
-            unsigned_int size; fc::raw::unpack( ds, size );
-            for( uint32_t i = 0, n = size.value; i < n; ++i ) {
+      uint32_t version = 0;
+      in.read( (char*)&version, sizeof(version) );
+      EOS_ASSERT( in && version == journal_version, fork_database_exception,
+                  "Unsupported version of fork database journal '${filename}'. "
+                  "Journal version is ${version} while code supports version ${expected}",
+                  ("filename", filename.generic_string())
+                  ("version", version)
+                  ("expected", journal_version)
+      );
+
+      uint64_t     good_size = in.tellg();
+      vector<char> payload;
+      while( true ) {
+         journal_record type;
+         uint32_t       size = 0;
+         uint64_t       checksum = 0;
+         if( !in.read( (char*)&type, sizeof(type) ) ) break;
+         if( !in.read( (char*)&size, sizeof(size) ) ) break;
+         payload.resize( size );
+         if( !in.read( payload.data(), payload.size() ) ) break;
+         if( !in.read( (char*)&checksum, sizeof(checksum) ) ) break;
+         if( checksum != journal_checksum( type, payload ) ) break;
+
+         fc::datastream<const char*> ds( payload.data(), payload.size() );
+         switch( type ) {
+            case journal_record::reset: {
+               block_header_state bhs;
+               fc::raw::unpack( ds, bhs );
+               self.reset( bhs );
+               break;
+            }
+            case journal_record::add: {
                block_state s;
                fc::raw::unpack( ds, s );
                // do not populate transaction_metadatas, they will be created as needed in apply_block with appropriate key recovery
                s.header_exts = s.block->validate_and_extract_header_extensions();
-               my->add( std::make_shared<block_state>( move( s ) ), false, true, validator );
+               // a duplicate add is recorded when the caller asked for it to be ignored
+               add( std::make_shared<block_state>( move( s ) ), true, true, validator );
+               break;
             }
-            block_id_type head_id;
-            fc::raw::unpack( ds, head_id );
-
-            if( my->root->id == head_id ) {
-               my->head = my->root;
-            } else {
-               my->head = get_block( head_id );
-               EOS_ASSERT( my->head, fork_database_exception,
-                           "could not find head while reconstructing fork database from file; '${filename}' is likely corrupted",
-                           ("filename", fork_db_dat.generic_string()) );
+            case journal_record::remove: {
+               block_id_type id;
+               fc::raw::unpack( ds, id );
+               remove( id );
+               break;
             }
-
-            auto candidate = my->index.get<by_lib_block_num>().begin();
-            if( candidate == my->index.get<by_lib_block_num>().end() || !(*candidate)->is_valid() ) {
-               EOS_ASSERT( my->head->id == my->root->id, fork_database_exception,
-                           "head not set to root despite no better option available; '${filename}' is likely corrupted",
-                           ("filename", fork_db_dat.generic_string()) );
-            } else {
-               EOS_ASSERT( !first_preferred( **candidate, *my->head ), fork_database_exception,
-                           "head not set to best available option available; '${filename}' is likely corrupted",
-                           ("filename", fork_db_dat.generic_string()) );
+            case journal_record::advance_root: {
+               block_id_type id;
+               fc::raw::unpack( ds, id );
+               self.advance_root( id );
+               break;
             }
-         } FC_CAPTURE_AND_RETHROW( (fork_db_dat) )
+            case journal_record::mark_valid: {
+               block_id_type id;
+               fc::raw::unpack( ds, id );
+               auto b = self.get_block( id );
+               EOS_ASSERT( b, fork_database_exception,
+                           "fork database journal '${filename}' marks unknown block ${id} valid; it is likely corrupted",
+                           ("filename", filename.generic_string())("id", id) );
+               self.mark_valid( b );
+               break;
+            }
+            case journal_record::rollback_head_to_root:
+               self.rollback_head_to_root();
+               break;
+            default:
+               EOS_THROW( fork_database_exception, "fork database journal '${filename}' has unknown record type ${t}",
+                          ("filename", filename.generic_string())("t", static_cast<uint32_t>(type)) );
+         }
+         good_size = in.tellg();
+      }
+      in.close();
 
-         fc::remove( fork_db_dat );
+      const auto file_size = fc::file_size( filename );
+      if( good_size < file_size ) {
+         wlog( "truncating incomplete record at the end of fork database journal '${filename}', ${n} bytes discarded",
+               ("filename", filename.generic_string())("n", file_size - good_size) );
+         boost::filesystem::resize_file( filename, good_size );
       }
-   }
 
-   void fork_database::close() {
-      auto fork_db_dat = my->datadir / config::forkdb_filename;
+      if( root )
+         validate_head( filename );
 
-      if( !my->root ) {
-         if( my->index.size() > 0 ) {
-            elog( "fork_database is in a bad state when closing; not writing out '${filename}'",
-                  ("filename", fork_db_dat.generic_string()) );
-         }
-         return;
+      journal_size = good_size;
+      compacted_size = good_size;
+   }
+
+   void fork_database_impl::validate_head( const fc::path& filename )const {
+      auto candidate = index.get<by_lib_block_num>().begin();
+      if( candidate == index.get<by_lib_block_num>().end() || !(*candidate)->is_valid() ) {
+         EOS_ASSERT( head->id == root->id, fork_database_exception,
+                     "head not set to root despite no better option available; '${filename}' is likely corrupted",
+                     ("filename", filename.generic_string()) );
+      } else {
+         EOS_ASSERT( !first_preferred( **candidate, *head ), fork_database_exception,
+                     "head not set to best available option available; '${filename}' is likely corrupted",
+                     ("filename", filename.generic_string()) );
       }
+   }
 
-      std::ofstream out( fork_db_dat.generic_string().c_str(), std::ios::out | std::ios::binary | std::ofstream::trunc );
-      fc::raw::pack( out, magic_number );
-      fc::raw::pack( out, max_supported_version ); // write out current version which is always max_supported_version
-      fc::raw::pack( out, *static_cast<block_header_state*>(&*my->root) );
-      uint32_t num_blocks_in_fork_db = my->index.size();
-      fc::raw::pack( out, unsigned_int{num_blocks_in_fork_db} );
 
-      const auto& indx = my->index.get<by_lib_block_num>();
+   fork_database::fork_database( const fc::path& data_dir )
+   :my( new fork_database_impl( *this, data_dir ) )
+   {}
+
 
-      auto unvalidated_itr = indx.rbegin();
-      auto unvalidated_end = boost::make_reverse_iterator( indx.lower_bound( false ) );
+   void fork_database::open( const std::function<void( block_timestamp_type,
+                                                       const flat_set<digest_type>&,
+                                                       const vector<digest_type>& )>& validator )
+   {
+      if (!fc::is_directory(my->datadir))
+         fc::create_directories(my->datadir);
+
+      auto fork_db_dat = my->datadir / config::forkdb_filename;
+      auto fork_db_log = my->journal_path();
+      if( fc::exists( fork_db_dat ) ) {
+         // written on shutdown by versions without a journal
+         my->load_legacy( fork_db_dat, validator );
+         my->compact();
+         fc::remove( fork_db_dat );
+      } else if( fc::exists( fork_db_log ) ) {
+         try {
+            my->replay( validator );
+         } FC_CAPTURE_AND_RETHROW( (fork_db_log) )
+         my->journal.emplace( fork_db_log.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::app );
+      } else {
+         my->compact();
+      }
+   }
 
-      auto validated_itr = unvalidated_end;
-      auto validated_end = indx.rend();
+   void fork_database_impl::load_legacy( const fc::path& fork_db_dat,
+                                         const std::function<void( block_timestamp_type,
+                                                                   const flat_set<digest_type>&,
+                                                                   const vector<digest_type>& )>& validator )
+   {
+      try {
+         string content;
+         fc::read_file_contents( fork_db_dat, content );
+
+         fc::datastream<const char*> ds( content.data(), content.size() );
+
+         // validate totem
+         uint32_t totem = 0;
+         fc::raw::unpack( ds, totem );
+         EOS_ASSERT( totem == fork_database::magic_number, fork_database_exception,
+                     "Fork database file '${filename}' has unexpected magic number: ${actual_totem}. Expected ${expected_totem}",
+                     ("filename", fork_db_dat.generic_string())
+                     ("actual_totem", totem)
+                     ("expected_totem", fork_database::magic_number)
+         );
 
-      for(  bool unvalidated_remaining = (unvalidated_itr != unvalidated_end),
-                 validated_remaining   = (validated_itr != validated_end);
+         // validate version
+         uint32_t version = 0;
+         fc::raw::unpack( ds, version );
+         EOS_ASSERT( version >= fork_database::min_supported_version && version <= fork_database::max_supported_version,
+                     fork_database_exception,
+                    "Unsupported version of fork database file '${filename}'. "
+                    "Fork database version is ${version} while code supports version(s) [${min},${max}]",
+                    ("filename", fork_db_dat.generic_string())
+                    ("version", version)
+                    ("min", fork_database::min_supported_version)
+                    ("max", fork_database::max_supported_version)
+         );
 
-            unvalidated_remaining || validated_remaining;
+         block_header_state bhs;
+         fc::raw::unpack( ds, bhs );
+         self.reset( bhs );
+
+         unsigned_int size; fc::raw::unpack( ds, size );
+         for( uint32_t i = 0, n = size.value; i < n; ++i ) {
+            block_state s;
+            fc::raw::unpack( ds, s );
+            // do not populate transaction_metadatas, they will be created as needed in apply_block with appropriate key recovery
+            s.header_exts = s.block->validate_and_extract_header_extensions();
+            add( std::make_shared<block_state>( move( s ) ), false, true, validator );
+         }
+         block_id_type head_id;
+         fc::raw::unpack( ds, head_id );
 
-            unvalidated_remaining = (unvalidated_itr != unvalidated_end),
-            validated_remaining   = (validated_itr != validated_end)
-         )
-      {
-         auto itr = (validated_remaining ? validated_itr : unvalidated_itr);
-
-         if( unvalidated_remaining && validated_remaining ) {
-            if( first_preferred( **validated_itr, **unvalidated_itr ) ) {
-               itr = unvalidated_itr;
-               ++unvalidated_itr;
-            } else {
-               ++validated_itr;
-            }
-         } else if( unvalidated_remaining ) {
-            ++unvalidated_itr;
+         if( root->id == head_id ) {
+            head = root;
          } else {
-            ++validated_itr;
+            head = self.get_block( head_id );
+            EOS_ASSERT( head, fork_database_exception,
+                        "could not find head while reconstructing fork database from file; '${filename}' is likely corrupted",
+                        ("filename", fork_db_dat.generic_string()) );
          }
 
-         fc::raw::pack( out, *(*itr) );
-      }
+         validate_head( fork_db_dat );
+      } FC_CAPTURE_AND_RETHROW( (fork_db_dat) )
+   }
 
-      if( my->head ) {
-         fc::raw::pack( out, my->head->id );
-      } else {
-         elog( "head not set in fork database; '${filename}' will be corrupted",
-               ("filename", fork_db_dat.generic_string()) );
+   void fork_database::close() {
+      if( !my->journal ) return;
+
+      if( !my->root && my->index.size() > 0 ) {
+         elog( "fork_database is in a bad state when closing; '${filename}' may not be usable",
+               ("filename", my->journal_path().generic_string()) );
       }
 
+      // every mutation is already in the journal, only the file needs to be closed
+      my->journal.reset();
       my->index.clear();
    }
 
@@ -235,6 +420,10 @@ namespace eosio { namespace chain {
       static_cast<block_header_state&>(*my->root) = root_bhs;
       my->root->validated = true;
       my->head = my->root;
+
+      // nothing before a reset is needed to rebuild the fork database
+      if( my->journal )
+         my->compact();
    }
 
    void fork_database::rollback_head_to_root() {
@@ -247,6 +436,7 @@ namespace eosio { namespace chain {
          ++itr;
       }
       my->head = my->root;
+      my->append( journal_record::rollback_head_to_root, vector<char>() );
    }
 
    void fork_database::advance_root( const block_id_type& id ) {
@@ -260,9 +450,9 @@ namespace eosio { namespace chain {
 
 
       vector<block_id_type> blocks_to_remove;
-      for( auto b = new_root; b; ) {
-         blocks_to_remove.push_back( b->header.previous );
-         b = get_block( blocks_to_remove.back() );
+      for( auto b = &new_root; b; ) {
+         blocks_to_remove.push_back( (*b)->header.previous );
+         b = my->find( blocks_to_remove.back() );
          EOS_ASSERT( b || blocks_to_remove.back() == my->root->id, fork_database_exception, "invariant violation: orphaned branch was present in forked database" );
       }
 
@@ -272,7 +462,7 @@ namespace eosio { namespace chain {
 
       // The other blocks to be removed are removed using the remove method so that orphaned branches do not remain in the fork database.
       for( const auto& block_id : blocks_to_remove ) {
-         remove( block_id );
+         my->remove( block_id );
       }
 
       // Even though fork database no longer needs block or trxs when a block state becomes a root of the tree,
@@ -280,6 +470,7 @@ namespace eosio { namespace chain {
       // parts of the code which run asynchronously may later expect it remain unmodified.
 
       my->root = new_root;
+      my->append( journal_record::advance_root, id );
    }
 
    block_header_state_ptr fork_database::get_block_header( const block_id_type& id )const {
@@ -305,7 +496,7 @@ namespace eosio { namespace chain {
       EOS_ASSERT( root, fork_database_exception, "root not yet set" );
       EOS_ASSERT( n, fork_database_exception, "attempt to add null block state" );
 
-      auto prev_bh = self.get_block_header( n->header.previous );
+      auto prev_bh = find_or_root( n->header.previous );
 
       EOS_ASSERT( prev_bh, unlinkable_block_exception,
                   "unlinkable block", ("id", n->id)("previous", n->header.previous) );
@@ -316,7 +507,7 @@ namespace eosio { namespace chain {
 
             if( exts.count(protocol_feature_activation::extension_id()) > 0 ) {
                const auto& new_protocol_features = std::get<protocol_feature_activation>(exts.lower_bound(protocol_feature_activation::extension_id())->second).protocol_features;
-               validator( n->header.timestamp, prev_bh->activated_protocol_features->protocol_features, new_protocol_features );
+               validator( n->header.timestamp, (*prev_bh)->activated_protocol_features->protocol_features, new_protocol_features );
             }
          } EOS_RETHROW_EXCEPTIONS( fork_database_exception, "serialized fork database is incompatible with configured protocol features"  )
       }
@@ -340,6 +531,13 @@ namespace eosio { namespace chain {
                    const vector<digest_type>& new_features )
                {}
       );
+      my->append( journal_record::add, *n );
+   }
+
+   void fork_database::add_validated( const block_state_ptr& n ) {
+      EOS_ASSERT( n, fork_database_exception, "attempt to add null block state" );
+      n->validated = true;
+      add( n );
    }
 
    const block_state_ptr& fork_database::root()const { return my->root; }
@@ -360,18 +558,18 @@ namespace eosio { namespace chain {
 
    branch_type fork_database::fetch_branch( const block_id_type& h, uint32_t trim_after_block_num )const {
       branch_type result;
-      for( auto s = get_block(h); s; s = get_block( s->header.previous ) ) {
-         if( s->block_num <= trim_after_block_num )
-             result.push_back( s );
+      for( auto s = my->find(h); s; s = my->find( (*s)->header.previous ) ) {
+         if( (*s)->block_num <= trim_after_block_num )
+             result.push_back( *s );
       }
 
       return result;
    }
 
    block_state_ptr fork_database::search_on_branch( const block_id_type& h, uint32_t block_num )const {
-      for( auto s = get_block(h); s; s = get_block( s->header.previous ) ) {
-         if( s->block_num == block_num )
-             return s;
+      for( auto s = my->find(h); s; s = my->find( (*s)->header.previous ) ) {
+         if( (*s)->block_num == block_num )
+             return *s;
       }
 
       return {};
@@ -384,44 +582,44 @@ namespace eosio { namespace chain {
    pair< branch_type, branch_type >  fork_database::fetch_branch_from( const block_id_type& first,
                                                                        const block_id_type& second )const {
       pair<branch_type,branch_type> result;
-      auto first_branch = (first == my->root->id) ? my->root : get_block(first);
-      auto second_branch = (second == my->root->id) ? my->root : get_block(second);
+      auto first_branch = my->find_or_root(first);
+      auto second_branch = my->find_or_root(second);
 
       EOS_ASSERT(first_branch, fork_db_block_not_found, "block ${id} does not exist", ("id", first));
       EOS_ASSERT(second_branch, fork_db_block_not_found, "block ${id} does not exist", ("id", second));
 
-      while( first_branch->block_num > second_branch->block_num )
+      while( (*first_branch)->block_num > (*second_branch)->block_num )
       {
-         result.first.push_back(first_branch);
-         const auto& prev = first_branch->header.previous;
-         first_branch = (prev == my->root->id) ? my->root : get_block( prev );
+         result.first.push_back(*first_branch);
+         const auto& prev = (*first_branch)->header.previous;
+         first_branch = my->find_or_root( prev );
          EOS_ASSERT( first_branch, fork_db_block_not_found,
                      "block ${id} does not exist",
                      ("id", prev)
          );
       }
 
-      while( second_branch->block_num > first_branch->block_num )
+      while( (*second_branch)->block_num > (*first_branch)->block_num )
       {
-         result.second.push_back( second_branch );
-         const auto& prev = second_branch->header.previous;
-         second_branch = (prev == my->root->id) ? my->root : get_block( prev );
+         result.second.push_back( *second_branch );
+         const auto& prev = (*second_branch)->header.previous;
+         second_branch = my->find_or_root( prev );
          EOS_ASSERT( second_branch, fork_db_block_not_found,
                      "block ${id} does not exist",
                      ("id", prev)
          );
       }
 
-      if (first_branch->id == second_branch->id) return result;
+      if ((*first_branch)->id == (*second_branch)->id) return result;
 
-      while( first_branch->header.previous != second_branch->header.previous )
+      while( (*first_branch)->header.previous != (*second_branch)->header.previous )
       {
-         result.first.push_back(first_branch);
-         result.second.push_back(second_branch);
-         const auto &first_prev = first_branch->header.previous;
-         first_branch = get_block( first_prev );
-         const auto &second_prev = second_branch->header.previous;
-         second_branch = get_block( second_prev );
+         result.first.push_back(*first_branch);
+         result.second.push_back(*second_branch);
+         const auto &first_prev = (*first_branch)->header.previous;
+         first_branch = my->find( first_prev );
+         const auto &second_prev = (*second_branch)->header.previous;
+         second_branch = my->find( second_prev );
          EOS_ASSERT( first_branch, fork_db_block_not_found,
                      "block ${id} does not exist",
                      ("id", first_prev)
@@ -434,17 +632,22 @@ namespace eosio { namespace chain {
 
       if( first_branch && second_branch )
       {
-         result.first.push_back(first_branch);
-         result.second.push_back(second_branch);
+         result.first.push_back(*first_branch);
+         result.second.push_back(*second_branch);
       }
       return result;
    } /// fetch_branch_from
 
-   /// remove all of the invalid forks built off of this id including this id
    void fork_database::remove( const block_id_type& id ) {
+      my->remove( id );
+      my->append( journal_record::remove, id );
+   }
+
+   /// remove all of the invalid forks built off of this id including this id
+   void fork_database_impl::remove( const block_id_type& id ) {
       vector<block_id_type> remove_queue{id};
-      const auto& previdx = my->index.get<by_prev>();
-      const auto head_id = my->head->id;
+      const auto& previdx = index.get<by_prev>();
+      const auto head_id = head->id;
 
       for( uint32_t i = 0; i < remove_queue.size(); ++i ) {
          EOS_ASSERT( remove_queue[i] != head_id, fork_database_exception,
@@ -458,9 +661,9 @@ namespace eosio { namespace chain {
       }
 
       for( const auto& block_id : remove_queue ) {
-         auto itr = my->index.find( block_id );
-         if( itr != my->index.end() )
-            my->index.erase(itr);
+         auto itr = index.find( block_id );
+         if( itr != index.end() )
+            index.erase(itr);
       }
    }
 
@@ -482,6 +685,8 @@ namespace eosio { namespace chain {
       if( first_preferred( **candidate, *my->head ) ) {
          my->head = *candidate;
       }
+
+      my->append( journal_record::mark_valid, h->id );
    }
 
    block_state_ptr   fork_database::get_block(const block_id_type& id)const {
@@ -2,6 +2,7 @@
 #include <eosio/chain/abi_def.hpp>
 #include <eosio/chain/trace.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <memory>
 #include <utility>
 #include <fc/variant_object.hpp>
 #include <fc/scoped_exit.hpp>
@@ -22,6 +23,8 @@ namespace impl {
    struct abi_traverse_context_with_path;
    struct binary_to_variant_context;
    struct variant_to_binary_context;
+   struct type_plan;
+   struct abi_type_plans;
 }
 
 /**
@@ -35,6 +38,11 @@ struct abi_serializer {
 
    abi_serializer(){ configure_built_in_types(); }
    abi_serializer( const abi_def& abi, const yield_function_t& yield );
+   abi_serializer( const abi_serializer& other );
+   abi_serializer( abi_serializer&& other );
+   ~abi_serializer();
+   abi_serializer& operator=( const abi_serializer& other );
+   abi_serializer& operator=( abi_serializer&& other );
    void set_abi( const abi_def& abi, const yield_function_t& yield );
 
    /// @return string_view of `t` or internal string type
@@ -63,6 +71,11 @@ struct abi_serializer {
    fc::variant binary_to_variant( const std::string_view& type, const bytes& binary, const yield_function_t& yield, bool short_path = false )const;
    fc::variant binary_to_variant( const std::string_view& type, fc::datastream<const char*>& binary, const yield_function_t& yield, bool short_path = false )const;
 
+   /// appends the JSON of `type` unpacked from `binary` to `out`, the same text as fc::json::to_string of binary_to_variant
+   /// but without building the fc::variant of structs, arrays and variants; on exception `out` holds partial output
+   void        binary_to_json( const std::string_view& type, fc::datastream<const char*>& binary, std::string& out, const yield_function_t& yield, bool short_path = false )const;
+   std::string binary_to_json( const std::string_view& type, const bytes& binary, const yield_function_t& yield, bool short_path = false )const;
+
    bytes       variant_to_binary( const std::string_view& type, const fc::variant& var, const yield_function_t& yield, bool short_path = false )const;
    void        variant_to_binary( const std::string_view& type, const fc::variant& var, fc::datastream<char*>& ds, const yield_function_t& yield, bool short_path = false )const;
 
@@ -128,6 +141,12 @@ private:
    map<type_name, pair<unpack_function, pack_function>, std::less<>> built_in_types;
    void configure_built_in_types();
 
+   /// types of the abi compiled by set_abi, each refers to the plans of its elements, fields, base and variant types
+   /// so they are (de)serialized without looking up type names
+   std::unique_ptr<impl::abi_type_plans> type_plans;
+   void compile_type_plans( impl::abi_traverse_context& ctx );
+   const impl::type_plan* find_type_plan( const std::string_view& type )const;
+
    fc::variant _binary_to_variant( const std::string_view& type, const bytes& binary, impl::binary_to_variant_context& ctx )const;
    fc::variant _binary_to_variant( const std::string_view& type, fc::datastream<const char*>& binary, impl::binary_to_variant_context& ctx )const;
    void        _binary_to_variant( const std::string_view& type, fc::datastream<const char*>& stream,
@@ -137,6 +156,18 @@ private:
    void        _variant_to_binary( const std::string_view& type, const fc::variant& var,
                                    fc::datastream<char*>& ds, impl::variant_to_binary_context& ctx )const;
 
+   fc::variant _binary_to_variant( const impl::type_plan& plan, fc::datastream<const char*>& stream, impl::binary_to_variant_context& ctx )const;
+   void        _binary_to_variant( const impl::type_plan& plan, fc::datastream<const char*>& stream,
+                                   fc::mutable_variant_object& obj, impl::binary_to_variant_context& ctx )const;
+   void        _variant_to_binary( const impl::type_plan& plan, const fc::variant& var,
+                                   fc::datastream<char*>& ds, impl::variant_to_binary_context& ctx )const;
+
+   /// @return false if null was written
+   bool        _binary_to_json( const std::string_view& type, fc::datastream<const char*>& stream, std::string& out, impl::binary_to_variant_context& ctx )const;
+   bool        _binary_to_json( const impl::type_plan& plan, fc::datastream<const char*>& stream, std::string& out, impl::binary_to_variant_context& ctx )const;
+   void        _binary_to_json( const impl::type_plan& plan, fc::datastream<const char*>& stream, std::string& out,
+                                size_t& field_count, impl::binary_to_variant_context& ctx )const;
+
    static std::string_view _remove_bin_extension(const std::string_view& type);
    bool _is_type( const std::string_view& type, impl::abi_traverse_context& ctx )const;
 
@@ -145,6 +176,7 @@ private:
    friend struct impl::abi_from_variant;
    friend struct impl::abi_to_variant;
    friend struct impl::abi_traverse_context_with_path;
+   friend struct impl::abi_type_plans;
 };
 
 namespace impl {
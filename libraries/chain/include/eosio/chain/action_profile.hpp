@@ -0,0 +1,53 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <string>
+#include <vector>
+
+namespace eosio { namespace chain {
+
+struct host_call_count {
+   std::string intrinsic;
+   uint32_t    calls = 0;
+};
+
+/**
+ * Where the execution of a single action went, attached to its action_trace when the transaction is profiled.
+ *
+ * wasm_time includes the time spent in host calls made by the contract; native handlers are not timed.
+ */
+struct action_profile {
+   fc::microseconds              wasm_time;
+   uint32_t                      host_calls = 0;
+   uint32_t                      db_calls = 0;        ///< calls of db_* and kv_* intrinsics, i.e. iterator and row operations
+   std::vector<host_call_count>  host_call_counts;    ///< intrinsics called at least once, in registration order
+};
+
+/**
+ * Counts the host calls of the action being executed.
+ *
+ * Every intrinsic is given an id by register_intrinsic when the wasm runtimes register their host functions,
+ * counting a call is then an increment of a vector entry.
+ */
+class action_profiler {
+   public:
+      static uint32_t register_intrinsic( const char* name );
+
+      void count_host_call( uint32_t id ) {
+         if( id >= _counts.size() ) _counts.resize( id + 1 );
+         ++_counts[id];
+      }
+      void add_wasm_time( fc::microseconds t ) { _wasm_time += t; }
+
+      action_profile finalize()const;
+
+   private:
+      std::vector<uint32_t> _counts;
+      fc::microseconds      _wasm_time;
+};
+
+} } /// namespace eosio::chain
+
+FC_REFLECT( eosio::chain::host_call_count, (intrinsic)(calls) )
+FC_REFLECT( eosio::chain::action_profile, (wasm_time)(host_calls)(db_calls)(host_call_counts) )
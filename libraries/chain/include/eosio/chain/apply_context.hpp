@@ -5,7 +5,10 @@
 #include <eosio/chain/backing_store/kv_context.hpp>
 #include <eosio/chain/backing_store/db_context.hpp>
 #include <eosio/chain/backing_store/db_chainbase_iter_store.hpp>
+#include <eosio/chain/backing_store/db_key_value_iter_store.hpp>
 #include <eosio/chain/backing_store/db_secondary_key_helper.hpp>
+#include <eosio/chain/state_access_recorder.hpp>
+#include <eosio/chain/transaction_context.hpp>
 #include <fc/utility.hpp>
 #include <sstream>
 #include <algorithm>
@@ -42,6 +45,8 @@ class apply_context {
 
 //               context.require_write_lock( scope );
 
+               context.record_db_write( context.receiver, name(scope), name(table), id );
+
                const auto& tab = context.find_or_create_table( context.receiver, name(scope), name(table), payer );
 
                const auto& obj = context.db.create<ObjectType>( [&]( auto& o ){
@@ -71,6 +76,7 @@ class apply_context {
 
                const auto& table_obj = itr_cache.get_table( obj.t_id );
                EOS_ASSERT( table_obj.code == context.receiver, table_access_violation, "db access violation" );
+               context.record_db_write( table_obj.code, table_obj.scope, table_obj.table, obj.primary_key );
 
                std::string event_id;
                if (context.control.get_deep_mind_logger() != nullptr) {
@@ -98,6 +104,7 @@ class apply_context {
 
                const auto& table_obj = itr_cache.get_table( obj.t_id );
                EOS_ASSERT( table_obj.code == context.receiver, table_access_violation, "db access violation" );
+               context.record_db_write( table_obj.code, table_obj.scope, table_obj.table, obj.primary_key );
 
 //               context.require_write_lock( table_obj.scope );
 
@@ -122,6 +129,7 @@ class apply_context {
             }
 
             int find_secondary( uint64_t code, uint64_t scope, uint64_t table, secondary_key_proxy_const_type secondary, uint64_t& primary ) {
+               context.record_db_range_read( name(code), name(scope), name(table) );
                auto tab = context.find_table( name(code), name(scope), name(table) );
                if( !tab ) return -1;
 
@@ -136,6 +144,7 @@ class apply_context {
             }
 
             int lowerbound_secondary( uint64_t code, uint64_t scope, uint64_t table, secondary_key_proxy_type secondary, uint64_t& primary ) {
+               context.record_db_range_read( name(code), name(scope), name(table) );
                auto tab = context.find_table( name(code), name(scope), name(table) );
                if( !tab ) return -1;
 
@@ -153,6 +162,7 @@ class apply_context {
             }
 
             int upperbound_secondary( uint64_t code, uint64_t scope, uint64_t table, secondary_key_proxy_type secondary, uint64_t& primary ) {
+               context.record_db_range_read( name(code), name(scope), name(table) );
                auto tab = context.find_table( name(code), name(scope), name(table) );
                if( !tab ) return -1;
 
@@ -170,6 +180,7 @@ class apply_context {
             }
 
             int end_secondary( uint64_t code, uint64_t scope, uint64_t table ) {
+               context.record_db_range_read( name(code), name(scope), name(table) );
                auto tab = context.find_table( name(code), name(scope), name(table) );
                if( !tab ) return -1;
 
@@ -181,6 +192,7 @@ class apply_context {
 
                const auto& obj = itr_cache.get(iterator); // Check for iterator != -1 happens in this call
                const auto& idx = context.db.get_index<typename chainbase::get_index_type<ObjectType>::type, by_secondary>();
+               record_range_read( obj );
 
                auto itr = idx.iterator_to(obj);
                ++itr;
@@ -198,6 +210,7 @@ class apply_context {
                {
                   auto tab = itr_cache.find_table_by_end_iterator(iterator);
                   EOS_ASSERT( tab, invalid_table_iterator, "not a valid end iterator" );
+                  context.record_db_range_read( tab->code, tab->scope, tab->table );
 
                   auto itr = idx.upper_bound(tab->id);
                   if( idx.begin() == idx.end() || itr == idx.begin() ) return -1; // Empty index
@@ -211,6 +224,7 @@ class apply_context {
                }
 
                const auto& obj = itr_cache.get(iterator); // Check for iterator != -1 happens in this call
+               record_range_read( obj );
 
                auto itr = idx.iterator_to(obj);
                if( itr == idx.begin() ) return -1; // cannot decrement past beginning iterator of index
@@ -224,6 +238,7 @@ class apply_context {
             }
 
             int find_primary( uint64_t code, uint64_t scope, uint64_t table, secondary_key_proxy_type secondary, uint64_t primary ) {
+               context.record_db_read( name(code), name(scope), name(table), primary );
                auto tab = context.find_table( name(code), name(scope), name(table) );
                if( !tab ) return -1;
 
@@ -237,6 +252,7 @@ class apply_context {
             }
 
             int lowerbound_primary( uint64_t code, uint64_t scope, uint64_t table, uint64_t primary ) {
+               context.record_db_range_read( name(code), name(scope), name(table) );
                auto tab = context.find_table( name(code), name(scope), name(table) );
                if (!tab) return -1;
 
@@ -251,6 +267,7 @@ class apply_context {
             }
 
             int upperbound_primary( uint64_t code, uint64_t scope, uint64_t table, uint64_t primary ) {
+               context.record_db_range_read( name(code), name(scope), name(table) );
                auto tab = context.find_table( name(code), name(scope), name(table) );
                if ( !tab ) return -1;
 
@@ -270,6 +287,7 @@ class apply_context {
 
                const auto& obj = itr_cache.get(iterator); // Check for iterator != -1 happens in this call
                const auto& idx = context.db.get_index<typename chainbase::get_index_type<ObjectType>::type, by_primary>();
+               record_range_read( obj );
 
                auto itr = idx.iterator_to(obj);
                ++itr;
@@ -287,6 +305,7 @@ class apply_context {
                {
                   auto tab = itr_cache.find_table_by_end_iterator(iterator);
                   EOS_ASSERT( tab, invalid_table_iterator, "not a valid end iterator" );
+                  context.record_db_range_read( tab->code, tab->scope, tab->table );
 
                   auto itr = idx.upper_bound(tab->id);
                   if( idx.begin() == idx.end() || itr == idx.begin() ) return -1; // Empty table
@@ -300,6 +319,7 @@ class apply_context {
                }
 
                const auto& obj = itr_cache.get(iterator); // Check for iterator != -1 happens in this call
+               record_range_read( obj );
 
                auto itr = idx.iterator_to(obj);
                if( itr == idx.begin() ) return -1; // cannot decrement past beginning iterator of table
@@ -319,6 +339,13 @@ class apply_context {
             }
 
          private:
+            /// an iterator may move to any row of its table
+            void record_range_read( const ObjectType& obj ) {
+               if( !context.state_accesses ) return;
+               const auto& table_obj = itr_cache.get_table( obj.t_id );
+               context.record_db_range_read( table_obj.code, table_obj.scope, table_obj.table );
+            }
+
             apply_context&                                     context;
             backing_store::db_chainbase_iter_store<ObjectType> itr_cache;
       }; /// class generic_index
@@ -327,6 +354,7 @@ class apply_context {
    /// Constructor
    public:
       apply_context(controller& con, transaction_context& trx_ctx, uint32_t action_ordinal, uint32_t depth=0);
+      ~apply_context();
 
    /// Execution methods:
    public:
@@ -401,6 +429,7 @@ class apply_context {
       int  db_lowerbound_i64_chainbase( name code, name scope, name table, uint64_t id );
       int  db_upperbound_i64_chainbase( name code, name scope, name table, uint64_t id );
       int  db_end_i64_chainbase( name code, name scope, name table );
+      int  db_get_by_id_i64_chainbase( name code, name scope, name table, uint64_t id, char* buffer, size_t buffer_size );
 
 # warning look into if we can make any of the db_** methods and idx***'s methods const and provide a const interface
       backing_store::db_context& db_get_context();
@@ -428,10 +457,7 @@ class apply_context {
       int32_t  kv_it_lower_bound(uint32_t itr, const char* key, uint32_t size, uint32_t* found_key_size, uint32_t* found_value_size);
       int32_t  kv_it_key(uint32_t itr, uint32_t offset, char* dest, uint32_t size, uint32_t& actual_size);
       int32_t  kv_it_value(uint32_t itr, uint32_t offset, char* dest, uint32_t size, uint32_t& actual_size);
-      kv_context& kv_get_backing_store() {
-         EOS_ASSERT( kv_backing_store, action_validate_exception, "KV APIs cannot access state (null backing_store)" );
-         return *kv_backing_store;
-      }
+      kv_context& kv_get_backing_store();
 
    private:
       void kv_check_iterator(uint32_t itr);
@@ -459,9 +485,33 @@ class apply_context {
 
       action_name get_sender() const;
 
+      /// profiler of the action being executed, null when the transaction is not profiled
+      action_profiler* get_profiler()const { return _profiler.get(); }
+
       uint32_t get_action_id() const;
       void increment_action_id();
 
+   /// State access recording, no-ops unless the transaction records its state accesses
+   public:
+      void record_db_read( name code, name scope, name table, uint64_t primary_key ) {
+         if( state_accesses ) state_accesses->add_db_read( code, scope, table, primary_key );
+      }
+      void record_db_range_read( name code, name scope, name table ) {
+         if( state_accesses ) state_accesses->add_db_range_read( code, scope, table );
+      }
+      void record_db_write( name code, name scope, name table, uint64_t primary_key ) {
+         if( state_accesses ) state_accesses->add_db_write( code, scope, table, primary_key );
+      }
+
+   /// Table usage tracking, no-ops unless the transaction tracks its table usage
+   public:
+      void record_table_usage( name code, name table, int64_t rows, int64_t bytes ) {
+         if( table_deltas ) (*table_deltas)[table_usage_key{ code, table, false }] += table_usage{ rows, bytes };
+      }
+      void record_kv_table_usage( const char* key, uint32_t key_size, int64_t rows, int64_t bytes ) {
+         if( table_deltas ) (*table_deltas)[table_usage_key{ receiver, table_usage_key::kv_table( key, key_size ), true }] += table_usage{ rows, bytes };
+      }
+
    /// Fields:
    public:
 
@@ -494,13 +544,19 @@ class apply_context {
    private:
 
       backing_store::db_chainbase_iter_store<key_value_object> db_iter_store;
-      vector< std::pair<account_name, uint32_t> >              _notified; ///< keeps track of new accounts to be notifed of current message
-      vector<uint32_t>                                         _inline_actions; ///< action_ordinals of queued inline actions
-      vector<uint32_t>                                         _cfa_inline_actions; ///< action_ordinals of queued inline context-free actions
+      /// (code,scope,table) of tables already found by this action, entries are dropped by remove_table
+      std::unordered_map<backing_store::unique_table, const table_id_object*, backing_store::unique_table_hash> _table_lookup_cache;
+      std::unique_ptr<apply_context_buffers>                   _buffers; ///< taken over from finished apply_contexts of the transaction
+      vector< std::pair<account_name, uint32_t> >&             _notified = _buffers->notified; ///< keeps track of new accounts to be notifed of current message
+      vector<uint32_t>&                                        _inline_actions = _buffers->inline_actions; ///< action_ordinals of queued inline actions
+      vector<uint32_t>&                                        _cfa_inline_actions = _buffers->cfa_inline_actions; ///< action_ordinals of queued inline context-free actions
       std::string                                              _pending_console_output;
       flat_set<account_delta>                                  _account_ram_deltas; ///< flat_set of account_delta so json is an array of objects
 
       std::unique_ptr<backing_store::db_context>               _db_context;
+      transaction_state_accesses*                              state_accesses = nullptr; ///< of trx_context, null when not recorded
+      table_usage_deltas*                                      table_deltas = nullptr; ///< of trx_context, null when not tracked
+      std::unique_ptr<action_profiler>                         _profiler; ///< of the current exec_one, only when trx_context.profile_actions
 };
 
 using apply_handler = std::function<void(apply_context&)>;
@@ -6,6 +6,8 @@
 
 #include <utility>
 #include <functional>
+#include <map>
+#include <tuple>
 
 namespace eosio { namespace chain {
 
@@ -54,6 +56,21 @@ namespace eosio { namespace chain {
          const permission_object*  find_permission( const permission_level& level )const;
          const permission_object&  get_permission( const permission_level& level )const;
 
+         /**
+          * @brief Drop the cached authority of a permission, must be called after a permission_object is created,
+          * modified or removed other than through this class
+          */
+         void invalidate_permission( const permission_level& level );
+
+         /**
+          * @brief Drop the cached links of @ref authorizer_account for any action of @ref code_account, must be called
+          * after a permission_link_object is created, modified or removed
+          */
+         void invalidate_linked_permissions( account_name authorizer_account, scope_name code_account );
+
+         /// Called after changes of an undo session or block were undone
+         void on_undo();
+
          /**
           * @brief Find the lowest authority level required for @ref authorizer_account to authorize a message of the
           * specified type
@@ -117,9 +134,27 @@ namespace eosio { namespace chain {
          static std::function<void()> _noop_checktime;
 
       private:
+         using link_key_type = std::tuple<account_name, scope_name, action_name>;
+
+         /// cached entries are dropped all at once when either cache grows past this size
+         static constexpr size_t max_cached_entries = 64*1024;
+
          const controller&    _control;
          chainbase::database& _db;
 
+         /// Authorities of permissions and results of lookup_linked_permission, kept consistent with the database by
+         /// the invalidate_* calls and by on_undo. Holding permission trees outside of chainbase avoids the lookup and
+         /// the copy of the shared_authority for every permission visited by the authority_checker.
+         mutable std::map<permission_level, authority>                     _authority_cache;
+         mutable std::map<link_key_type, std::optional<permission_name>>   _link_cache;
+         /// highest database revision which changed permissions or links since the caches were last cleared
+         std::optional<int64_t>                                            _last_change_revision;
+
+         const authority& get_cached_authority( const permission_level& level )const;
+         void             trim_authority_cache()const;
+         void             record_change();
+         void             clear_caches();
+
          void             check_updateauth_authorization( const updateauth& update, const vector<permission_level>& auths )const;
          void             check_deleteauth_authorization( const deleteauth& del, const vector<permission_level>& auths )const;
          void             check_linkauth_authorization( const linkauth& link, const vector<permission_level>& auths )const;
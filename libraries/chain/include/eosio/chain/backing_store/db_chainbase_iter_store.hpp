@@ -4,6 +4,7 @@
 #include <sstream>
 #include <algorithm>
 #include <set>
+#include <unordered_map>
 
 namespace eosio { namespace chain { namespace backing_store {
 
@@ -13,28 +14,30 @@ class db_chainbase_iter_store {
       db_chainbase_iter_store(){
          _end_iterator_to_table.reserve(8);
          _iterator_to_object.reserve(32);
+         _table_cache.reserve(8);
+         _object_to_iterator.reserve(32);
       }
 
       /// Returns end iterator of the table.
       int cache_table( const table_id_object& tobj ) {
-         auto itr = _table_cache.find(tobj.id);
+         auto itr = _table_cache.find(tobj.id._id);
          if( itr != _table_cache.end() )
             return itr->second.second;
 
          auto ei = index_to_end_iterator(_end_iterator_to_table.size());
          _end_iterator_to_table.push_back( &tobj );
-         _table_cache.emplace( tobj.id, make_pair(&tobj, ei) );
+         _table_cache.emplace( tobj.id._id, make_pair(&tobj, ei) );
          return ei;
       }
 
       const table_id_object& get_table( table_id_object::id_type i )const {
-         auto itr = _table_cache.find(i);
+         auto itr = _table_cache.find(i._id);
          EOS_ASSERT( itr != _table_cache.end(), table_not_in_cache, "an invariant was broken, table should be in cache" );
          return *itr->second.first;
       }
 
       int get_end_iterator_by_table_id( table_id_object::id_type i )const {
-         auto itr = _table_cache.find(i);
+         auto itr = _table_cache.find(i._id);
          EOS_ASSERT( itr != _table_cache.end(), table_not_in_cache, "an invariant was broken, table should be in cache" );
          return itr->second.second;
       }
@@ -78,10 +81,11 @@ class db_chainbase_iter_store {
       }
 
    private:
-      map<table_id_object::id_type, pair<const table_id_object*, int>> _table_cache;
-      vector<const table_id_object*>                                   _end_iterator_to_table;
-      vector<const T*>                                                 _iterator_to_object;
-      map<const T*,int>                                                _object_to_iterator;
+      /// hashed rather than ordered, contracts scanning many rows look these up on every iterator operation
+      std::unordered_map<int64_t, pair<const table_id_object*, int>> _table_cache; ///< keyed by table_id_object::id_type::_id
+      vector<const table_id_object*>                                 _end_iterator_to_table;
+      vector<const T*>                                               _iterator_to_object;
+      std::unordered_map<const T*,int>                               _object_to_iterator;
 
       /// Precondition: std::numeric_limits<int>::min() < ei < -1
       /// Iterator of -1 is reserved for invalid iterators (i.e. when the appropriate table has not yet been created).
@@ -47,6 +47,9 @@ namespace backing_store {
 
          virtual int32_t db_end_i64(uint64_t code, uint64_t scope, uint64_t table) = 0;
 
+         // reads the row with primary key id without adding an iterator, returns -1 if there is no such row
+         virtual int32_t db_get_by_id_i64(uint64_t code, uint64_t scope, uint64_t table, uint64_t id, char* buffer, size_t buffer_size) = 0;
+
          /**
           * interface for uint64_t secondary
           */
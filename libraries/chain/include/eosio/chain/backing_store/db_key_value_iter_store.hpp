@@ -1,8 +1,10 @@
 #pragma once
 #include <fc/utility.hpp>
+#include <boost/functional/hash.hpp>
 #include <sstream>
 #include <algorithm>
 #include <set>
+#include <unordered_map>
 
 namespace eosio { namespace chain { namespace backing_store {
 struct unique_table {
@@ -23,6 +25,20 @@ inline bool operator<(const unique_table& lhs, const unique_table& rhs) {
    return std::tie(lhs.contract, lhs.scope, lhs.table) < std::tie(rhs.contract, rhs.scope, rhs.table);
 }
 
+inline bool operator==(const unique_table& lhs, const unique_table& rhs) {
+   return std::tie(lhs.contract, lhs.scope, lhs.table) == std::tie(rhs.contract, rhs.scope, rhs.table);
+}
+
+struct unique_table_hash {
+   size_t operator()(const unique_table& t) const {
+      size_t seed = 0;
+      boost::hash_combine(seed, t.contract.to_uint64_t());
+      boost::hash_combine(seed, t.scope.to_uint64_t());
+      boost::hash_combine(seed, t.table.to_uint64_t());
+      return seed;
+   }
+};
+
 template<typename T>
 bool operator<(const secondary_key<T>& lhs, const secondary_key<T>& rhs) {
    // checking primary second to optimize the search since a given primary key
@@ -41,6 +57,7 @@ class db_key_value_iter_store {
       db_key_value_iter_store(){
          _end_iterator_to_table.reserve(8);
          _iterator_to_object.reserve(32);
+         _table_cache.reserve(8);
       }
 
       constexpr int invalid_iterator() const { return -1; }
@@ -145,10 +162,10 @@ class db_key_value_iter_store {
          EOS_ASSERT( (size_t)iterator < _iterator_to_object.size(), invalid_table_iterator, "iterator out of range" );
       }
 
-      map<unique_table, int>                    _table_cache;
-      vector<unique_table>                      _end_iterator_to_table;
-      vector<std::optional<secondary_obj_type>> _iterator_to_object;
-      map<secondary_obj_type, int>              _object_to_iterator;
+      std::unordered_map<unique_table, int, unique_table_hash> _table_cache;
+      vector<unique_table>                                     _end_iterator_to_table;
+      vector<std::optional<secondary_obj_type>>                _iterator_to_object;
+      map<secondary_obj_type, int>                             _object_to_iterator;
 
       /// Precondition: std::numeric_limits<int>::min() < ei < -1
       /// Iterator of -1 is reserved for invalid iterators (i.e. when the appropriate table has not yet been created).
@@ -107,6 +107,7 @@ namespace eosio { namespace chain { namespace backing_store {
       int store( name scope, name table, const account_name& payer,
                  uint64_t id, const SecondaryKey& secondary ) {
          EOS_ASSERT( payer != account_name(), invalid_table_payer, "must specify a valid account to pay for new record" );
+         parent.context.record_db_write(parent.receiver, scope, table, id);
 
          const sec_pair_bundle secondary_key = get_secondary_slices_in_secondaries(parent.receiver, scope, table, secondary, id);
 
@@ -141,6 +142,7 @@ namespace eosio { namespace chain { namespace backing_store {
          const iter_obj& key_store = iter_store.get(iterator);
          const unique_table& table = iter_store.get_table(key_store);
          EOS_ASSERT( table.contract == parent.receiver, table_access_violation, "db access violation" );
+         parent.context.record_db_write(table.contract, table.scope, table.table, key_store.primary);
 
          const sec_pair_bundle secondary_key = get_secondary_slices_in_secondaries(parent.receiver, table.scope, table.table, key_store.secondary, key_store.primary);
          auto old_value = current_session.read(secondary_key.full_secondary_key);
@@ -170,6 +172,7 @@ namespace eosio { namespace chain { namespace backing_store {
          const iter_obj& key_store = iter_store.get(iterator);
          const unique_table& table = iter_store.get_table(key_store);
          EOS_ASSERT( table.contract == parent.receiver, table_access_violation, "db access violation" );
+         parent.context.record_db_write(table.contract, table.scope, table.table, key_store.primary);
 
          const sec_pair_bundle secondary_key = get_secondary_slices_in_secondaries(parent.receiver, table.scope, table.table, key_store.secondary, key_store.primary);
          auto old_value = current_session.read(secondary_key.full_secondary_key);
@@ -219,6 +222,7 @@ namespace eosio { namespace chain { namespace backing_store {
       }
 
       int find_secondary( name code, name scope, name table, const SecondaryKey& secondary, uint64_t& primary ) {
+         parent.context.record_db_range_read(code, scope, table);
          prefix_bundle secondary_key = get_secondary_slice_in_table(code, scope, table, secondary);
          auto session_iter = current_session.lower_bound(secondary_key.full_key);
 
@@ -255,6 +259,7 @@ namespace eosio { namespace chain { namespace backing_store {
       }
 
       int end_secondary( name code, name scope, name table ) {
+         parent.context.record_db_range_read(code, scope, table);
          return get_end_iter(name{code}, name{scope}, name{table}, iter_store);
       }
 
@@ -263,6 +268,7 @@ namespace eosio { namespace chain { namespace backing_store {
 
          const iter_obj& key_store = iter_store.get(iterator);
          const unique_table& table = iter_store.get_table(key_store);
+         parent.context.record_db_range_read(table.contract, table.scope, table.table);
 
          prefix_bundle secondary_key = get_secondary_slice_in_secondaries(table.contract, table.scope, table.table, key_store.secondary, key_store.primary);
          auto session_iter = current_session.lower_bound(secondary_key.full_key);
@@ -288,6 +294,7 @@ namespace eosio { namespace chain { namespace backing_store {
          if( iterator < iter_store.invalid_iterator() ) {
             const backing_store::unique_table* table = iter_store.find_table_by_end_iterator(iterator);
             EOS_ASSERT( table, invalid_table_iterator, "not a valid end iterator" );
+            parent.context.record_db_range_read(table->contract, table->scope, table->table);
             constexpr static auto kt = db_key_value_format::derive_secondary_key_type<SecondaryKey>();
             const bytes legacy_type_key = db_key_value_format::create_prefix_type_key(table->scope, table->table, kt);
             const shared_bytes type_prefix = db_key_value_format::create_full_key(legacy_type_key, table->contract);
@@ -311,6 +318,7 @@ namespace eosio { namespace chain { namespace backing_store {
 
          const iter_obj& key_store = iter_store.get(iterator);
          const unique_table& table = iter_store.get_table(key_store);
+         parent.context.record_db_range_read(table.contract, table.scope, table.table);
 
          prefix_bundle secondary_key = get_secondary_slice_in_secondaries(table.contract, table.scope, table.table, key_store.secondary, key_store.primary);
          auto session_iter = current_session.lower_bound(secondary_key.full_key);
@@ -333,6 +341,7 @@ namespace eosio { namespace chain { namespace backing_store {
       }
 
       int find_primary( name code, name scope, name table, SecondaryKey& secondary, uint64_t primary ) {
+         parent.context.record_db_read(code, scope, table, primary);
          const bytes legacy_prim_to_sec_key = db_key_value_format::create_prefix_primary_to_secondary_key<SecondaryKey>(scope, table, primary);
          const shared_bytes key = db_key_value_format::create_full_key(legacy_prim_to_sec_key, code);
          const shared_bytes prefix = db_key_value_format::create_full_key_prefix(key, end_of_prefix::pre_type);
@@ -380,6 +389,7 @@ namespace eosio { namespace chain { namespace backing_store {
 
          const iter_obj& key_store = iter_store.get(iterator);
          const unique_table& table = iter_store.get_table(key_store);
+         parent.context.record_db_range_read(table.contract, table.scope, table.table);
 
          const bytes prim_to_sec_key =
                db_key_value_format::create_primary_to_secondary_key<SecondaryKey>(table.scope, table.table, key_store.primary, key_store.secondary);
@@ -409,6 +419,7 @@ namespace eosio { namespace chain { namespace backing_store {
          if( iterator < iter_store.invalid_iterator() ) {
             const backing_store::unique_table* table = iter_store.find_table_by_end_iterator(iterator);
             EOS_ASSERT( table, invalid_table_iterator, "not a valid end iterator" );
+            parent.context.record_db_range_read(table->contract, table->scope, table->table);
             const bytes types_key = db_key_value_format::create_prefix_primary_to_secondary_key<SecondaryKey>(table->scope, table->table);
 
             // create the key pointing to the start of the primary to secondary keys of this type, and then increment it to be past the end
@@ -432,6 +443,7 @@ namespace eosio { namespace chain { namespace backing_store {
 
          const iter_obj& key_store = iter_store.get(iterator);
          const unique_table& table = iter_store.get_table(key_store);
+         parent.context.record_db_range_read(table.contract, table.scope, table.table);
 
          const bytes prim_to_sec_key =
                db_key_value_format::create_primary_to_secondary_key<SecondaryKey>(table.scope, table.table, key_store.primary, key_store.secondary);
@@ -557,6 +569,7 @@ namespace eosio { namespace chain { namespace backing_store {
       enum class bound_type { lower, upper };
       const char* as_string(bound_type bt) { return (bt == bound_type::upper) ? "upper" : "lower"; }
       int bound_secondary( name code, name scope, name table, bound_type bt, SecondaryKey& secondary, uint64_t& primary ) {
+         parent.context.record_db_range_read(code, scope, table);
          prefix_bundle secondary_key = get_secondary_slice_in_table(code, scope, table, secondary);
          auto session_iter = current_session.lower_bound(secondary_key.full_key);
          // setting the "key space" to be the whole table, so that we either get a match or another key for this table
@@ -601,6 +614,7 @@ namespace eosio { namespace chain { namespace backing_store {
       }
 
       int bound_primary( name code, name scope, name table, uint64_t primary, bound_type bt ){
+         parent.context.record_db_range_read(code, scope, table);
          const bytes prim_to_sec_key = db_key_value_format::create_prefix_primary_to_secondary_key<SecondaryKey>(scope, table, primary);
          const shared_bytes key = db_key_value_format::create_full_key(prim_to_sec_key, code);
          // use the primary to secondary key type to only retrieve secondary keys of SecondaryKey type
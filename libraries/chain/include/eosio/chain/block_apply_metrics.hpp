@@ -0,0 +1,81 @@
+#pragma once
+
+#include <fc/time.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace eosio { namespace chain {
+
+/**
+ * Histogram of durations with power of two microsecond buckets.
+ * Bucket 0 counts durations below 1us, bucket i counts durations in [2^(i-1), 2^i) us,
+ * and the last bucket counts everything above.
+ */
+struct duration_histogram {
+   static constexpr size_t num_buckets = 24;
+
+   uint64_t              count    = 0;
+   int64_t               total_us = 0;
+   int64_t               max_us   = 0;
+   std::vector<uint64_t> buckets  = std::vector<uint64_t>( num_buckets );
+
+   void add( const fc::microseconds& d ) {
+      const int64_t us = std::max<int64_t>( d.count(), 0 );
+      ++count;
+      total_us += us;
+      max_us = std::max( max_us, us );
+      size_t b = 0;
+      for( uint64_t v = us; v > 0 && b < num_buckets - 1; v >>= 1 ) {
+         ++b;
+      }
+      ++buckets[b];
+   }
+};
+
+/// Wall clock time spent by controller in each stage of applying a single block
+struct block_apply_stage_times {
+   uint32_t         block_num = 0;
+   uint32_t         num_trxs  = 0;
+   fc::microseconds start_block;    ///< onblock and scheduling of the pending block
+   fc::microseconds trx_prep;       ///< creation of transaction_metadata and start of key recovery
+   fc::microseconds recover_keys;   ///< waiting on recovered keys of transactions
+   fc::microseconds check_auth;     ///< authorization checks of input transactions
+   fc::microseconds exec_trxs;      ///< execution of transactions (wasm, native actions and db access) and receipts
+   fc::microseconds finalize_block; ///< resource limits update and merkle roots
+   fc::microseconds commit_block;   ///< fork database, reversible blocks and accepted_block signal
+   fc::microseconds total;
+};
+
+/// Aggregate of block_apply_stage_times of all blocks applied since startup
+struct block_apply_metrics {
+   duration_histogram start_block;
+   duration_histogram trx_prep;
+   duration_histogram recover_keys;
+   duration_histogram check_auth;
+   duration_histogram exec_trxs;
+   duration_histogram finalize_block;
+   duration_histogram commit_block;
+   duration_histogram total;
+   duration_histogram block_log_append; ///< per irreversible block appended to the block log
+
+   void add( const block_apply_stage_times& t ) {
+      start_block.add( t.start_block );
+      trx_prep.add( t.trx_prep );
+      recover_keys.add( t.recover_keys );
+      check_auth.add( t.check_auth );
+      exec_trxs.add( t.exec_trxs );
+      finalize_block.add( t.finalize_block );
+      commit_block.add( t.commit_block );
+      total.add( t.total );
+   }
+};
+
+} } // eosio::chain
+
+FC_REFLECT( eosio::chain::duration_histogram, (count)(total_us)(max_us)(buckets) )
+FC_REFLECT( eosio::chain::block_apply_stage_times,
+            (block_num)(num_trxs)(start_block)(trx_prep)(recover_keys)(check_auth)(exec_trxs)(finalize_block)(commit_block)(total) )
+FC_REFLECT( eosio::chain::block_apply_metrics,
+            (start_block)(trx_prep)(recover_keys)(check_auth)(exec_trxs)(finalize_block)(commit_block)(total)(block_log_append) )
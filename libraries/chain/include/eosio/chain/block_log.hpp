@@ -9,6 +9,15 @@ namespace eosio { namespace chain {
 
    namespace detail { class block_log_impl; }
 
+   /// One stride-aligned range of blocks exported by block_log::export_chunks, as listed in the chunk manifest.
+   /// The log and index files of a chunk are named after the sha256 of their content.
+   struct block_log_chunk {
+      uint32_t   first_block_num = 0;
+      uint32_t   last_block_num  = 0;
+      fc::sha256 log_hash;
+      fc::sha256 index_hash;
+   };
+
    /* The block log is an external append only log of the blocks with a header. Blocks should only
     * be written to the log after they are irreversible as the log is append only. The log is a doubly
     * linked list of blocks. There is a secondary index file of only block positions that enables
@@ -32,6 +41,17 @@ namespace eosio { namespace chain {
     *
     * The main file is the only file that needs to persist. The index file can be reconstructed during a
     * linear scan of the main file.
+    *
+    * Optionally a transaction id index is kept in blocks.trx_index. After a header holding the version and the
+    * last block indexed, it contains one record per transaction in the order the blocks were appended: the first
+    * 8 bytes of the transaction id followed by the block number. It covers the retained block files as well and
+    * can be reconstructed from the block files at any time.
+    *
+    * Version 5 files are only created when block_log_config::zstd_compression is set, otherwise new files are version 4.
+    * From version 5 the header of a file holds a zstd dictionary, which may be empty. When block_log_config::zstd_compression
+    * is set, the serialization of a block after its block header is written as a zstd frame using that dictionary, so
+    * the block number and id of an entry can still be read without decompressing it. The dictionary of new files is
+    * read from block_log_config::zstd_dictionary, see train_zstd_dictionary.
     */
 
    namespace bfs = boost::filesystem;
@@ -51,8 +71,11 @@ namespace eosio { namespace chain {
          std::future<std::tuple<signed_block_ptr, std::vector<char>>>
             create_append_future(boost::asio::io_context& thread_pool,
                                  const signed_block_ptr& b, packed_transaction::cf_compression_type segment_compression);
+         // does not flush, call flush() once the blocks of a batch have been appended
          uint64_t append(std::future<std::tuple<signed_block_ptr, std::vector<char>>> f);
 
+         void flush();
+
          void reset( const genesis_state& gs, const signed_block_ptr& genesis_block, packed_transaction::cf_compression_type segment_compression);
          void reset( const chain_id_type& chain_id, uint32_t first_block_num );
          
@@ -63,6 +86,16 @@ namespace eosio { namespace chain {
          const signed_block_ptr&        head() const;
          uint32_t                       first_block_num() const;
 
+         /// @returns whether blocks.trx_index is maintained, see block_log_config::trx_index
+         bool has_trx_index() const;
+
+         /**
+          *  Find the block containing a transaction through blocks.trx_index.
+          *  @pre has_trx_index()
+          *  @returns The number of the block containing the transaction, if it is in the block log
+          **/
+         std::optional<uint32_t> find_block_num_by_trx_id(const transaction_id_type& id);
+
          static bool exists(const fc::path& data_dir);
          /**
           *  @param ids[in,out] The list of transaction ids to be pruned. After the member function returns,
@@ -76,6 +109,8 @@ namespace eosio { namespace chain {
 
          static const uint32_t min_supported_version;
          static const uint32_t max_supported_version;
+         /// version of new block log files when zstd compression is disabled
+         static const uint32_t default_version;
 
          static fc::path repair_log( const fc::path& data_dir, uint32_t truncate_at_block = UINT32_MAX, const char* reversible_block_dir_name="" );
 
@@ -85,15 +120,56 @@ namespace eosio { namespace chain {
 
          static void construct_index(const fc::path& block_file_name, const fc::path& index_file_name);
 
+         /// Rebuild blocks.trx_index from the blocks.log and retained block files of block_dir
+         static void construct_trx_index(const fc::path& block_dir);
+
          static bool contains_genesis_state(uint32_t version, uint32_t first_block_num);
 
          static bool contains_chain_id(uint32_t version, uint32_t first_block_num);
 
          static bool is_supported_version(uint32_t version);
 
+         /// @returns whether nodeos is built with zstd, needed to write or read zstd compressed blocks
+         static bool zstd_supported();
+
+         /**
+          * Train a zstd dictionary of at most max_size bytes on the blocks [first_block_num, last_block_num] of the
+          * block log in block_dir which exist, for use as block_log_config::zstd_dictionary
+          */
+         static std::vector<char> train_zstd_dictionary(const fc::path& block_dir, uint32_t first_block_num,
+                                                        uint32_t last_block_num, size_t max_size);
+
          static bool trim_blocklog_front(const fc::path& block_dir, const fc::path& temp_dir, uint32_t truncate_at_block);
+
+         /**
+          * Prune the context free data and signatures of every transaction in blocks [first_block_num, last_block_num]
+          * of the blocks.log in block_dir with a timestamp before older_than, then rewrite the blocks.log and
+          * blocks.index so that the space of the pruned data, including data pruned in place earlier, is reclaimed.
+          * Blocks are unpacked and pruned on num_threads threads. The original files are moved to temp_dir as
+          * old.log and old.index.
+          * @returns The number of transactions pruned
+          */
+         static size_t prune_and_compact(const fc::path& block_dir, const fc::path& temp_dir, uint32_t first_block_num,
+                                         uint32_t last_block_num, fc::time_point older_than, uint16_t num_threads);
          static int  trim_blocklog_end(fc::path block_dir, uint32_t n);
 
+         static const char* const chunk_manifest_name;
+
+         /**
+          * Split the blocks.log in block_dir into chunks of @p stride blocks aligned the same way as the retained
+          * block files, i.e. blocks [k*stride+1, (k+1)*stride]. Only complete chunks are exported. Each chunk is
+          * written to output_dir as <sha256>.log and <sha256>.index along with a manifest listing all chunks.
+          * @returns The exported chunks
+          */
+         static std::vector<block_log_chunk> export_chunks(const fc::path& block_dir, const fc::path& output_dir, uint32_t stride);
+
+         /**
+          * Copy the chunks listed in the manifest of source_dir into retained_dir as blocks-<start>-<end>.log/index,
+          * verifying the content hash of every file. Chunks which already exist in retained_dir are skipped.
+          * @returns The number of chunks imported
+          */
+         static size_t import_chunks(const fc::path& source_dir, const fc::path& retained_dir, uint16_t num_threads);
+
          // used for unit test to generate older version blocklog
          static void set_version(uint32_t);
          uint32_t    version() const;
@@ -107,3 +183,5 @@ namespace eosio { namespace chain {
          std::unique_ptr<detail::block_log_impl> my;
    };
 } }
+
+FC_REFLECT( eosio::chain::block_log_chunk, (first_block_num)(last_block_num)(log_hash)(index_hash) )
@@ -13,6 +13,10 @@ struct block_log_config {
    uint32_t  stride                  = UINT32_MAX;
    uint16_t  max_retained_files      = 10;
    bool      fix_irreversible_blocks = false;
+   bool      trx_index               = false; ///< maintain blocks.trx_index for looking up blocks by transaction id
+   bool      zstd_compression        = false; ///< compress the blocks of new entries with zstd, needs a version 5 file
+   bfs::path zstd_dictionary;                 ///< optional dictionary of new files, absolute or relative to log_dir
+   int       zstd_level              = 3;
 };
 
 } // namespace chain
@@ -62,7 +62,8 @@ namespace eosio { namespace chain {
     public:
       combined_session() = default;
 
-      combined_session(chainbase::database& cb_database, eosio::session::undo_stack<rocks_db_type>* undo_stack);
+      combined_session(chainbase::database& cb_database, eosio::session::undo_stack<rocks_db_type>* undo_stack,
+                       const std::function<void()>* undo_callback = nullptr);
 
       combined_session(combined_session&& src) noexcept;
 
@@ -79,6 +80,33 @@ namespace eosio { namespace chain {
     private:
       std::unique_ptr<chainbase::database::session> cb_session    = {};
       eosio::session::undo_stack<rocks_db_type>*     kv_undo_stack = nullptr;
+      const std::function<void()>*                   undo_callback = nullptr;
+   };
+
+   struct kv_cache_layer_stats {
+      uint64_t cached_keys  = 0;
+      uint64_t updated_keys = 0;
+      uint64_t deleted_keys = 0;
+      uint64_t cached_bytes = 0;
+      uint64_t read_hits    = 0;
+      uint64_t read_misses  = 0;
+   };
+
+   struct kv_cache_contract_stats {
+      name     contract;
+      uint64_t cached_keys  = 0;
+      uint64_t cached_bytes = 0;
+   };
+
+   // Memory use of the undo stack sessions layered over rocksdb, and of rocksdb itself.
+   struct kv_cache_stats {
+      std::vector<kv_cache_layer_stats>    layers;    // oldest (next to be committed) first
+      std::vector<kv_cache_contract_stats> contracts; // summed over all layers, largest first
+      uint64_t                             rocksdb_reads              = 0;
+      uint64_t                             rocksdb_estimate_num_keys  = 0;
+      uint64_t                             rocksdb_block_cache_bytes  = 0;
+      uint64_t                             rocksdb_memtable_bytes     = 0;
+      uint64_t                             rocksdb_table_reader_bytes = 0;
    };
 
    class combined_database {
@@ -100,9 +128,13 @@ namespace eosio { namespace chain {
       static combined_session make_no_op_session() { return combined_session(); }
 
       combined_session make_session() {
-         return combined_session(db, kv_undo_stack.get());
+         return combined_session(db, kv_undo_stack.get(), &undo_callback);
       }
 
+      // Called after the changes of a session or a block were undone, allows caches of database
+      // state to drop entries which may have been reverted.
+      void set_undo_callback(std::function<void()> cb) { undo_callback = std::move(cb); }
+
       void set_revision(uint64_t revision);
 
       int64_t revision();
@@ -130,6 +162,9 @@ namespace eosio { namespace chain {
                               eosio::chain::fork_database& fork_db, eosio::chain::block_state_ptr& head,
                               uint32_t& snapshot_head_block, const eosio::chain::chain_id_type& chain_id);
 
+      // Only meaningful for the rocksdb backing store; empty otherwise.
+      kv_cache_stats get_kv_cache_stats() const;
+
       auto &get_db(void) const { return db; }
       auto &get_kv_undo_stack(void) const { return kv_undo_stack; }
       backing_store_type get_backing_store() const { return backing_store; }
@@ -143,6 +178,10 @@ namespace eosio { namespace chain {
       std::unique_ptr<rocks_db_type>                             kv_database;
       kv_undo_stack_ptr                                          kv_undo_stack;
       const uint64_t                                             kv_snapshot_batch_threashold;
+      const uint16_t                                             kv_snapshot_write_threads = 1;
+      // when set, snapshot rows are ingested into rocksdb as SST files built in this directory
+      const std::string                                          kv_snapshot_ingest_dir;
+      std::function<void()>                                      undo_callback;
    };
 
    std::optional<eosio::chain::genesis_state> extract_legacy_genesis_state(snapshot_reader& snapshot, uint32_t version);
@@ -151,3 +190,8 @@ namespace eosio { namespace chain {
    char make_rocksdb_contract_db_prefix();
 
 }} // namespace eosio::chain
+
+FC_REFLECT(eosio::chain::kv_cache_layer_stats, (cached_keys)(updated_keys)(deleted_keys)(cached_bytes)(read_hits)(read_misses))
+FC_REFLECT(eosio::chain::kv_cache_contract_stats, (contract)(cached_keys)(cached_bytes))
+FC_REFLECT(eosio::chain::kv_cache_stats, (layers)(contracts)(rocksdb_reads)(rocksdb_estimate_num_keys)
+                                         (rocksdb_block_cache_bytes)(rocksdb_memtable_bytes)(rocksdb_table_reader_bytes))
@@ -19,6 +19,7 @@ const static auto default_reversible_guard_size = 2*1024*1024ll;/// 1MB * 340 bl
 
 const static auto default_state_dir_name     = "state";
 const static auto forkdb_filename            = "fork_db.dat";
+const static auto forkdb_journal_filename    = "fork_db.log";
 const static auto default_state_size            = 1*1024*1024*1024ll;
 const static auto default_state_guard_size      =    128*1024*1024ll;
 
@@ -85,6 +86,8 @@ const static uint16_t   default_max_auth_depth                       = 6;
 const static uint32_t   default_sig_cpu_bill_pct                     = 50 * percent_1; // billable percentage of signature recovery
 const static uint32_t   default_block_cpu_effort_pct                 = 80 * percent_1; // percentage of block time used for producing block
 const static uint16_t   default_controller_thread_pool_size          = 2;
+const static uint32_t   default_block_key_prefetch_limit             = 32; // received blocks with signature recovery started ahead of apply
+const static uint32_t   default_recovered_key_cache_size             = 64 * 1024; // recovered public keys kept for reuse by block validation
 const static uint32_t   default_max_variable_signature_length        = 16384u;
 const static uint32_t   default_max_nonprivileged_inline_action_size = 4 * 1024; // 4 KB
 const static uint32_t   default_max_action_return_value_size         = 256;
@@ -93,6 +96,9 @@ const static int        default_persistent_storage_max_num_files     = -1;
 const static uint64_t   default_persistent_storage_write_buffer_size = 128 * 1024 * 1024;
 const static uint64_t   default_persistent_storage_bytes_per_sync    = 1 * 1024 * 1024;
 const static uint32_t   default_persistent_storage_mbytes_batch      = 50;
+const static uint64_t   default_persistent_storage_block_cache_size  = 512 * 1024 * 1024;
+const static uint64_t   default_persistent_storage_row_cache_size    = 0;
+const static uint32_t   default_replay_prefetch_blocks               = 64;
 
 static_assert(MAX_SIZE_OF_BYTE_ARRAYS == 20*1024*1024, "Changing MAX_SIZE_OF_BYTE_ARRAYS breaks consensus. Make sure this is expected");
 
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace eosio { namespace chain {
+
+struct contract_cpu_sample {
+   account_name receiver;
+   account_name account;
+   action_name  action;
+   uint64_t     samples = 0;
+};
+
+struct contract_cpu_samples {
+   fc::microseconds                  interval;
+   uint64_t                          samples = 0;          ///< samples taken
+   uint64_t                          action_samples = 0;   ///< samples which found an action executing
+   std::vector<contract_cpu_sample>  actions;              ///< by descending samples
+};
+
+/**
+ * Low frequency sampling of the action executing on the main thread, to attribute its cpu time to contracts.
+ *
+ * apply_context tags the action it executes for the duration of exec_one. A sampler thread wakes every interval
+ * and counts a sample for the receiver and action tagged at that moment, if any. Tagging is a few relaxed atomic
+ * stores; it is done only on the thread which started the sampler, actions run on other threads are not sampled.
+ */
+class contract_cpu_sampler {
+   public:
+      /// tags an action until destroyed
+      class scope {
+         public:
+            explicit scope( contract_cpu_sampler* s ) : _sampler( s ) {}
+            scope( const scope& ) = delete;
+            scope& operator=( const scope& ) = delete;
+            ~scope() { if( _sampler ) _sampler->set_tag( 0, 0, 0 ); }
+         private:
+            contract_cpu_sampler* _sampler;
+      };
+
+      contract_cpu_sampler() = default;
+
+      // calls stop()
+      ~contract_cpu_sampler();
+
+      /// start sampling the actions tagged on the calling thread every interval
+      void start( fc::microseconds interval );
+
+      void stop();
+
+      scope tag( account_name receiver, account_name account, action_name action ) {
+         if( !_running.load( std::memory_order_relaxed ) || std::this_thread::get_id() != _tagged_thread )
+            return scope( nullptr );
+         set_tag( receiver.to_uint64_t(), account.to_uint64_t(), action.to_uint64_t() );
+         return scope( this );
+      }
+
+      /// the limit actions with the most samples
+      contract_cpu_samples get_samples( size_t limit )const;
+
+      void reset();
+
+   private:
+      void set_tag( uint64_t receiver, uint64_t account, uint64_t action ) {
+         const auto seq = _seq.load( std::memory_order_relaxed );
+         _seq.store( seq + 1, std::memory_order_relaxed );
+         std::atomic_thread_fence( std::memory_order_release );
+         _receiver.store( receiver, std::memory_order_relaxed );
+         _account.store( account, std::memory_order_relaxed );
+         _action.store( action, std::memory_order_relaxed );
+         _seq.store( seq + 2, std::memory_order_release );
+      }
+
+      void run();
+
+      // tag of the executing action, a sequence lock: _seq is odd while the tag is being written
+      std::atomic<uint64_t>         _seq{0};
+      std::atomic<uint64_t>         _receiver{0};
+      std::atomic<uint64_t>         _account{0};
+      std::atomic<uint64_t>         _action{0};
+      std::atomic<bool>             _running{false};
+      std::thread::id               _tagged_thread;
+      fc::microseconds              _interval;
+      std::thread                   _thread;
+
+      mutable std::mutex            _mtx;
+      std::condition_variable       _stop_cv;
+      bool                          _stopping = false;
+      uint64_t                      _samples = 0;
+      uint64_t                      _action_samples = 0;
+      std::map<std::tuple<uint64_t, uint64_t, uint64_t>, uint64_t> _counts; ///< by receiver, account, action
+};
+
+} } /// namespace eosio::chain
+
+FC_REFLECT( eosio::chain::contract_cpu_sample, (receiver)(account)(action)(samples) )
+FC_REFLECT( eosio::chain::contract_cpu_samples, (interval)(samples)(action_samples)(actions) )
@@ -34,6 +34,11 @@ namespace eosio { namespace chain {
    };
 
    class combined_database;
+   class recovered_key_cache;
+   struct block_apply_metrics;
+   struct block_apply_stage_times;
+   class contract_cpu_sampler;
+   class table_usage_tracker;
 
    struct controller_impl;
    using chainbase::database;
@@ -76,12 +81,16 @@ namespace eosio { namespace chain {
             flat_set<public_key_type> key_blacklist;
             block_log_config         blog;
             path                     state_dir                  = chain::config::default_state_dir_name;
+            path                     state_access_log; //< when set, conflict graphs of committed blocks are appended to this file
             uint64_t                 state_size                 = chain::config::default_state_size;
             uint64_t                 state_guard_size           = chain::config::default_state_guard_size;
             uint64_t                 reversible_cache_size      = chain::config::default_reversible_cache_size;
             uint64_t                 reversible_guard_size      = chain::config::default_reversible_guard_size;
             uint32_t                 sig_cpu_bill_pct           = chain::config::default_sig_cpu_bill_pct;
             uint16_t                 thread_pool_size           = chain::config::default_controller_thread_pool_size;
+            std::vector<uint16_t>    thread_pool_cpus; //< cpus the thread pool threads are pinned to, empty to not pin
+            uint32_t                 block_key_prefetch_limit   = chain::config::default_block_key_prefetch_limit; //< 0 disables block key prefetch
+            uint32_t                 recovered_key_cache_size   = chain::config::default_recovered_key_cache_size; //< 0 disables recovered key cache
             uint16_t                 max_retained_block_files   = chain::config::default_max_retained_block_files;
             uint64_t                 blocks_log_stride          = chain::config::default_blocks_log_stride;
             backing_store_type       backing_store              = backing_store_type::CHAINBASE;
@@ -90,12 +99,20 @@ namespace eosio { namespace chain {
             uint64_t                 persistent_storage_write_buffer_size = chain::config::default_persistent_storage_write_buffer_size;
             uint64_t                 persistent_storage_bytes_per_sync = chain::config::default_persistent_storage_bytes_per_sync;
             uint32_t                 persistent_storage_mbytes_batch = chain::config::default_persistent_storage_mbytes_batch;
+            bool                     persistent_storage_snapshot_ingest = false;
+            uint64_t                 persistent_storage_block_cache_size = chain::config::default_persistent_storage_block_cache_size;
+            uint64_t                 persistent_storage_row_cache_size = chain::config::default_persistent_storage_row_cache_size; //< 0 disables the row cache
             fc::microseconds         abi_serializer_max_time_us = fc::microseconds(chain::config::default_abi_serializer_max_time_us);
             uint32_t   max_nonprivileged_inline_action_size =  chain::config::default_max_nonprivileged_inline_action_size;
             bool                     read_only                  = false;
             bool                     force_all_checks           = false;
             bool                     disable_replay_opts        = false;
+            bool                     replay_trust_block_log     = false; //< do not recompute action merkle roots of irreversible blocks on replay
+            bool                     fork_switch_trust_validated = false; //< do not recompute action merkle roots of blocks re-applied by a fork switch
+            uint32_t                 replay_prefetch_blocks     = chain::config::default_replay_prefetch_blocks; //< blocks read ahead of replay on a thread of their own, 0 reads them in the replay loop
             bool                     contracts_console          = false;
+            uint32_t                 action_profile_sample_rate = 0; //< attach an action_profile to the action traces of one in this many transactions, 0 disables
+            uint32_t                 contract_cpu_sample_interval_us = 0; //< sample the action executing every this many us, 0 disables
             bool                     allow_ram_billing_in_notify = false;
 
             uint32_t                 maximum_variable_signature_length = chain::config::default_max_variable_signature_length;
@@ -180,6 +197,14 @@ namespace eosio { namespace chain {
 
          std::future<block_state_ptr> create_block_state_future( const block_id_type& id, const signed_block_ptr& b );
 
+         /**
+          * Thread safe. Starts recovery of the transaction signing keys of a received block on the chain thread pool
+          * so that it overlaps with the apply of the blocks ahead of it. The recovered keys are used by push_block when
+          * the block is applied. Only blocks within config::block_key_prefetch_limit block numbers above head are
+          * prefetched and at most that many are kept, the earliest started are dropped first.
+          */
+         void start_block_key_recovery( const block_id_type& id, const signed_block_ptr& b );
+
          /**
           * @param block_state_future provide from call to create_block_state_future
           * @param cb calls cb with forked applied transactions for each forked block
@@ -191,6 +216,15 @@ namespace eosio { namespace chain {
 
          boost::asio::io_context& get_thread_pool();
 
+         /// thread safe, shared by all key recovery of input transactions and blocks, see config::recovered_key_cache_size
+         recovered_key_cache& get_recovered_key_cache();
+
+         /// main thread only, stage timings aggregated over all blocks applied since startup
+         const block_apply_metrics& get_block_apply_metrics()const;
+         contract_cpu_sampler& get_contract_cpu_sampler();
+         /// main thread only, stage timings of the most recently applied block
+         const block_apply_stage_times& get_last_block_apply_times()const;
+
          const chainbase::database& db()const;
          const chainbase::database& reversible_db() const;
 
@@ -257,6 +291,11 @@ namespace eosio { namespace chain {
          signed_block_ptr fetch_block_by_number( uint32_t block_num )const;
          signed_block_ptr fetch_block_by_id( block_id_type id )const;
 
+         /// @returns whether the block log maintains its transaction id index, see block_log_config::trx_index
+         bool has_block_log_trx_index()const;
+         /// Find the irreversible block containing a transaction through the block log transaction id index
+         std::optional<uint32_t> fetch_irreversible_block_num_by_trx_id( const transaction_id_type& id )const;
+
          block_state_ptr fetch_block_state_by_number( uint32_t block_num )const;
          block_state_ptr fetch_block_state_by_id( block_id_type id )const;
 
@@ -326,6 +365,9 @@ namespace eosio { namespace chain {
          fc::logger* get_deep_mind_logger() const;
          void enable_deep_mind( fc::logger* logger );
 
+         /// keep tracker up to date with the table rows written by blocks committed from now on, nullptr stops tracking
+         void set_table_usage_tracker( std::shared_ptr<table_usage_tracker> tracker );
+
 #if defined(EOSIO_EOS_VM_RUNTIME_ENABLED) || defined(EOSIO_EOS_VM_JIT_RUNTIME_ENABLED)
          vm::wasm_allocator&  get_wasm_allocator();
 #endif
@@ -16,6 +16,10 @@ namespace eosio { namespace chain {
     * database tracks the longest chain and the last irreversible block number. All
     * blocks older than the last irreversible block are freed after emitting the
     * irreversible signal.
+    *
+    * Every change is appended to a journal in the data directory as it happens, so
+    * opening replays the journal rather than a file written on shutdown. The journal is
+    * periodically rewritten down to the blocks still in the fork database.
     */
    class fork_database {
       public:
@@ -53,6 +57,12 @@ namespace eosio { namespace chain {
           */
          void            add( const block_state_ptr& next_block, bool ignore_duplicate = false );
 
+         /**
+          *  Add an already applied block state to fork database, marked valid.
+          *  Equivalent to add() followed by mark_valid() without re-indexing the block state in between.
+          */
+         void            add_validated( const block_state_ptr& next_block );
+
          void            remove( const block_id_type& id );
 
          const block_state_ptr& root()const;
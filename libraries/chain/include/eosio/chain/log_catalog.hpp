@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+#include <list>
 #include <boost/container/flat_map.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
@@ -46,14 +48,20 @@ struct log_catalog {
 
    using mapmode = boost::iostreams::mapped_file::mapmode;
 
-   bfs::path    retained_dir;
-   bfs::path    archive_dir;
-   size_type    max_retained_files = 10;
-   collection_t collection;
-   size_type    active_index = npos;
-   LogData      log_data;
-   LogIndex     log_index;
-   LogVerifier  verifier;
+   /// A retained log/index bundle that is currently mapped.
+   struct open_bundle {
+      block_num_t first_block_num = 0;
+      LogData     log_data;
+      LogIndex    log_index;
+   };
+
+   bfs::path              retained_dir;
+   bfs::path              archive_dir;
+   size_type              max_retained_files = 10;
+   size_type              max_open_bundles   = 8;
+   collection_t           collection;
+   std::list<open_bundle> open_bundles; // most recently used first
+   LogVerifier            verifier;
 
    bool empty() const { return collection.empty(); }
 
@@ -131,54 +139,79 @@ struct log_catalog {
       return pos == log.last_block_position();
    }
 
-   std::optional<uint64_t> get_block_position(uint32_t block_num, mapmode mode = mapmode::readonly) {
-      try {
-         if (active_index != npos) {
-            auto active_item = collection.nth(active_index);
-            if (active_item->first <= block_num && block_num <= active_item->second.last_block_num &&
-                log_data.flags() == mode) {
-               return log_index.nth_block_position(block_num - log_data.first_block_num());
-            }
+   /// Returns the mapped bundle holding the given catalog entry, mapping it if needed. Bundles are kept mapped
+   /// in LRU order, so random lookups spread over a few retained files do not remap them on every call.
+   open_bundle& get_bundle(typename collection_t::const_iterator it, mapmode mode) {
+      auto bit = std::find_if(open_bundles.begin(), open_bundles.end(),
+                              [&](const open_bundle& b) { return b.first_block_num == it->first; });
+      if (bit != open_bundles.end()) {
+         if (bit->log_data.flags() == mode) {
+            open_bundles.splice(open_bundles.begin(), open_bundles, bit);
+            return open_bundles.front();
          }
+         // remap with the requested mode
+         open_bundles.erase(bit);
+      }
+
+      auto name = it->second.filename_base;
+      open_bundles.emplace_front();
+      auto& bundle = open_bundles.front();
+      try {
+         bundle.first_block_num = it->first;
+         bundle.log_data.open(name.replace_extension("log"), mode);
+         bundle.log_index.open(name.replace_extension("index"));
+      } catch (...) {
+         open_bundles.pop_front();
+         throw;
+      }
+      if (open_bundles.size() > max_open_bundles)
+         open_bundles.pop_back();
+      return bundle;
+   }
+
+   /// Unmaps the bundles whose first block number satisfies the predicate
+   template <typename Predicate>
+   void close_bundles_if(Predicate&& pred) {
+      open_bundles.remove_if([&](const open_bundle& b) { return pred(b.first_block_num); });
+   }
+
+   std::pair<open_bundle*, uint64_t> get_block_position(uint32_t block_num, mapmode mode = mapmode::readonly) {
+      try {
          if (collection.empty() || block_num < collection.begin()->first)
             return {};
 
          auto it = --collection.upper_bound(block_num);
 
          if (block_num <= it->second.last_block_num) {
-            auto name = it->second.filename_base;
-            log_data.open(name.replace_extension("log"), mode);
-            log_index.open(name.replace_extension("index"));
-            this->active_index = collection.index_of(it);
-            return log_index.nth_block_position(block_num - log_data.first_block_num());
+            auto& bundle = get_bundle(it, mode);
+            return { &bundle, bundle.log_index.nth_block_position(block_num - bundle.log_data.first_block_num()) };
          }
          return {};
       } catch (...) {
-         this->active_index = npos;
          return {};
       }
    }
 
    std::pair<fc::datastream<const char*>, uint32_t> ro_stream_for_block(uint32_t block_num) {
-      auto pos = get_block_position(block_num, mapmode::readonly);
-      if (pos) {
-         return log_data.ro_stream_at(*pos);
+      auto [bundle, pos] = get_block_position(block_num, mapmode::readonly);
+      if (bundle) {
+         return bundle->log_data.ro_stream_at(pos);
       }
       return {fc::datastream<const char*>(nullptr, 0), static_cast<uint32_t>(0)};
    }
 
    std::pair<fc::datastream<char*>, uint32_t> rw_stream_for_block(uint32_t block_num) {
-      auto pos = get_block_position(block_num, mapmode::readwrite);
-      if (pos) {
-         return log_data.rw_stream_at(*pos);
+      auto [bundle, pos] = get_block_position(block_num, mapmode::readwrite);
+      if (bundle) {
+         return bundle->log_data.rw_stream_at(pos);
       }
       return {fc::datastream<char*>(nullptr, 0), static_cast<uint32_t>(0)};
    }
 
    std::optional<block_id_type> id_for_block(uint32_t block_num) {
-      auto pos = get_block_position(block_num, mapmode::readonly);
-      if (pos) {
-         return log_data.block_id_at(*pos);
+      auto [bundle, pos] = get_block_position(block_num, mapmode::readonly);
+      if (bundle) {
+         return bundle->log_data.block_id_at(pos);
       }
       return {};
    }
@@ -201,8 +234,8 @@ struct log_catalog {
    /// Add a new entry into the catalog.
    ///
    /// Notice that \c start_block_num must be monotonically increasing between the invocations of this function
-   /// so that the new entry would be inserted at the end of the flat_map; otherwise, \c active_index would be
-   /// invalidated and the mapping between the log data their block range would be wrong. This function is only used
+   /// so that the new entry would be inserted at the end of the flat_map; otherwise, the block ranges of the
+   /// catalog entries could overlap and the mapping between the log data their block range would be wrong. This function is only used
    /// during the splitting of block log. Using this function for other purpose should make sure if the monotonically
    /// increasing block num guarantee can be met.
    void add(uint32_t start_block_num, uint32_t end_block_num, const bfs::path& dir, const char* name) {
@@ -227,10 +260,9 @@ struct log_catalog {
                rename_bundle(orig_name, archive_dir / orig_name.filename());
             }
          }
+         const auto last_erased = (this->collection.begin() + items_to_erase - 1)->first;
+         close_bundles_if([last_erased](block_num_t first) { return first <= last_erased; });
          this->collection.erase(this->collection.begin(), this->collection.begin() + items_to_erase);
-         this->active_index = this->active_index == npos || this->active_index < items_to_erase
-                                  ? npos
-                                  : this->active_index - items_to_erase;
       }
       if (max_retained_files > 0)
          this->collection.emplace(start_block_num, mapped_type{end_block_num, new_path});
@@ -255,11 +287,15 @@ struct log_catalog {
       auto it = collection.upper_bound(block_num);
 
       if (it == collection.begin() || block_num > (it - 1)->second.last_block_num) {
+         if (it != collection.end()) {
+            close_bundles_if([first_removed = it->first](block_num_t first) { return first >= first_removed; });
+         }
          std::for_each(it, collection.end(), remove_files);
          collection.erase(it, collection.end());
          return 0;
       } else {
          auto truncate_it = --it;
+         close_bundles_if([first_removed = truncate_it->first](block_num_t first) { return first >= first_removed; });
          auto name        = truncate_it->second.filename_base;
          bfs::rename(name.replace_extension("log"), new_name.replace_extension("log"));
          bfs::rename(name.replace_extension("index"), new_name.replace_extension("index"));
@@ -14,9 +14,40 @@ namespace eosio { namespace chain {
       return make_pair(make_canonical_left(l), make_canonical_right(r));
    };
 
+   /**
+    *  Same result as digest_type::hash( make_canonical_pair( l, r ) ), hashes the 64 byte concatenation directly
+    *  instead of serializing the pair through fc::raw.
+    */
+   digest_type hash_canonical_pair(const digest_type& l, const digest_type& r);
+
    /**
     *  Calculates the merkle root of a set of digests, if ids is odd it will duplicate the last id.
     */
    digest_type merkle( deque<digest_type> ids );
 
+   /**
+    *  Accumulates digests as they are produced so that the merkle root of all of them is available without
+    *  re-hashing all the leaves. Holds the roots of the complete power of two subtrees, one per set bit of
+    *  the number of digests, so append is amortized O(1) and get_root() only folds O(log n) nodes.
+    *  get_root() is identical to merkle() over the same sequence of digests.
+    */
+   class merkle_accumulator {
+   public:
+      void append( const digest_type& digest );
+
+      template<typename Container>
+      void append( const Container& digests ) {
+         for( const auto& d : digests ) append( d );
+      }
+
+      digest_type get_root()const;
+
+      uint64_t size()const { return _count; }
+      bool empty()const { return _count == 0; }
+
+   private:
+      uint64_t             _count = 0;
+      vector<digest_type>  _subtree_roots; ///< _subtree_roots[h] is valid when bit h of _count is set
+   };
+
 } } /// eosio::chain
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <string>
 #include <fc/reflect/reflect.hpp>
 #include <fc/exception/exception.hpp>
@@ -15,18 +16,25 @@ namespace fc {
 } // fc
 
 namespace eosio::chain {
+   namespace detail {
+      inline constexpr uint8_t invalid_name_symbol = 0xff;
+
+      /// the 5 bit symbol of each character in a name, invalid_name_symbol for the characters a name can not contain
+      inline constexpr auto name_symbols = []() {
+         std::array<uint8_t, 256> symbols{};
+         for( auto& s : symbols ) s = invalid_name_symbol;
+         symbols['.'] = 0;
+         for( char c = '1'; c <= '5'; ++c ) symbols[static_cast<unsigned char>(c)] = (c - '1') + 1;
+         for( char c = 'a'; c <= 'z'; ++c ) symbols[static_cast<unsigned char>(c)] = (c - 'a') + 6;
+         return symbols;
+      }();
+   }
+
    constexpr uint64_t char_to_symbol( char c ) {
-      if( c >= 'a' && c <= 'z' )
-         return (c - 'a') + 6;
-      if( c >= '1' && c <= '5' )
-         return (c - '1') + 1;
-      else if( c == '.')
-         return 0;
-      else
+      const uint8_t symbol = detail::name_symbols[static_cast<unsigned char>(c)];
+      if( symbol == detail::invalid_name_symbol )
          FC_THROW_EXCEPTION(name_type_exception, "Name contains invalid character: (${c}) ", ("c", std::string(1, c)));
-
-      //unreachable
-      return 0;
+      return symbol;
    }
 
    // true if std::string can be converted to name
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <eosio/chain/types.hpp>
+#include <bitset>
 #include <iterator>
 
 namespace eosio { namespace chain {
@@ -26,7 +27,8 @@ enum class builtin_protocol_feature_t : uint32_t {
    action_return_value,
    kv_database,
    configurable_wasm_limits,
-   blockchain_parameters
+   blockchain_parameters,
+   batched_database
 };
 
 struct protocol_feature_subjective_restrictions {
@@ -342,7 +344,14 @@ public:
    const_iterator upper_bound( uint32_t block_num )const;
 
 
-   bool is_builtin_activated( builtin_protocol_feature_t feature_codename, uint32_t current_block_num )const;
+   /// Answered from a bitset of the activated builtin features once current_block_num is at or past the last
+   /// activation, which is every call outside of replaying or inspecting blocks from before that activation.
+   bool is_builtin_activated( builtin_protocol_feature_t feature_codename, uint32_t current_block_num )const {
+      uint32_t indx = static_cast<uint32_t>( feature_codename );
+      if( indx >= _builtin_protocol_features.size() ) return false;
+      if( current_block_num >= _last_builtin_activation_block_num ) return _activated_builtins[indx];
+      return (_builtin_protocol_features[indx].activation_block_num <= current_block_num);
+   }
 
    void activate_feature( const digest_type& feature_digest, uint32_t current_block_num );
    void popped_blocks_to( uint32_t block_num );
@@ -367,6 +376,9 @@ protected:
    vector<protocol_feature_entry>         _activated_protocol_features;
    vector<builtin_protocol_feature_entry> _builtin_protocol_features;
    size_t                                 _head_of_builtin_activation_list = builtin_protocol_feature_entry::no_previous;
+   static constexpr size_t                max_builtin_protocol_features = 64;
+   std::bitset<max_builtin_protocol_features> _activated_builtins;         ///< kept in sync with _builtin_protocol_features
+   uint32_t                               _last_builtin_activation_block_num = 0;
    bool                                   _initialized = false;
 
 private:
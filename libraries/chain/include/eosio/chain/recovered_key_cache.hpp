@@ -0,0 +1,57 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace eosio { namespace chain {
+
+/**
+ * Thread safe, bounded cache of public keys recovered from (signature, signing digest) pairs.
+ *
+ * Allows block validation to reuse the keys recovered when the same transaction was received earlier as an
+ * input transaction. The cache is split into independently locked shards so that recovery running on many
+ * threads does not serialize on a single mutex. When full, a shard evicts its oldest entries first.
+ * Also used by the recover_key and assert_recover_key intrinsics, which recover without the canonical check.
+ */
+class recovered_key_cache {
+public:
+   /// @param max_entries total capacity across all shards, 0 disables caching
+   explicit recovered_key_cache( size_t max_entries );
+
+   /// @returns cache key of sig over digest, keys recovered without the canonical check are kept apart
+   static digest_type make_key( const signature_type& sig, const digest_type& digest, bool check_canonical = true );
+
+   std::optional<public_key_type> find( const digest_type& key );
+   void insert( const digest_type& key, const public_key_type& pub_key );
+
+   /// @returns public key of sig over digest, recovered and cached if not already cached
+   public_key_type recover( const signature_type& sig, const digest_type& digest, bool check_canonical = true );
+
+   size_t size();
+   void clear();
+
+private:
+   static constexpr size_t num_shards = 16;
+
+   struct key_hash {
+      size_t operator()( const digest_type& d ) const { return d._hash[0]; }
+   };
+
+   struct shard {
+      std::mutex                                                   mtx;
+      std::unordered_map<digest_type, public_key_type, key_hash>   keys;
+      std::deque<digest_type>                                      insertion_order;
+   };
+
+   shard& get_shard( const digest_type& key ) { return _shards[key._hash[1] % num_shards]; }
+
+   const size_t                   _max_entries_per_shard;
+   std::array<shard, num_shards>  _shards;
+};
+
+} } // eosio::chain
@@ -58,6 +58,11 @@ namespace eosio { namespace chain { namespace resource_limits {
       int64_t current_used = 0;  ///< current usage according to the given timestamp
    };
 
+   struct account_bandwidth_limits {
+      std::pair<account_resource_limit, bool> net; ///< as returned by get_account_net_limit_ex
+      std::pair<account_resource_limit, bool> cpu; ///< as returned by get_account_cpu_limit_ex
+   };
+
    class resource_limits_manager {
       public:
 
@@ -78,6 +83,12 @@ namespace eosio { namespace chain { namespace resource_limits {
          void add_transaction_usage( const flat_set<account_name>& accounts, uint64_t cpu_usage, uint64_t net_usage, uint32_t ordinal );
 
          void add_pending_ram_usage( const account_name account, int64_t ram_delta, const storage_usage_trace& trace );
+         /**
+          * Add the sum of a sequence of RAM deltas of account, failing as adding them one by one would
+          * @param min_running_delta - lowest running sum of the sequence, 0 or less
+          * @param max_running_delta - highest running sum of the sequence, 0 or more
+          */
+         void add_pending_ram_usage( const account_name account, int64_t ram_delta, int64_t min_running_delta, int64_t max_running_delta );
          void verify_account_ram_usage( const account_name accunt )const;
 
          /// set_account_limits returns true if new ram_bytes limit is more restrictive than the previously set one
@@ -103,6 +114,9 @@ namespace eosio { namespace chain { namespace resource_limits {
          get_account_cpu_limit_ex( const account_name& name, uint32_t greylist_limit = config::maximum_elastic_resource_multiplier, const std::optional<block_timestamp_type>& current_time={} ) const;
          std::pair<account_resource_limit, bool>
          get_account_net_limit_ex( const account_name& name, uint32_t greylist_limit = config::maximum_elastic_resource_multiplier, const std::optional<block_timestamp_type>& current_time={} ) const;
+         /// net and cpu limits of name, looking up its objects once rather than once for each
+         account_bandwidth_limits
+         get_account_bandwidth_limits_ex( const account_name& name, uint32_t greylist_limit = config::maximum_elastic_resource_multiplier, const std::optional<block_timestamp_type>& current_time={} ) const;
 
          int64_t get_account_ram_usage( const account_name& name ) const;
 
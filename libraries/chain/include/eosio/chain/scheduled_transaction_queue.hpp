@@ -0,0 +1,50 @@
+#pragma once
+
+#include <eosio/chain/generated_transaction_object.hpp>
+
+#include <optional>
+#include <vector>
+
+namespace chainbase { class database; }
+
+namespace eosio { namespace chain {
+
+/**
+ * The generated transactions due by a pending block, in (delay_until, id) order.
+ *
+ * The by_delay index orders generated transactions by time, so the transactions due by a block form a prefix of it.
+ * That prefix is read a chunk at a time: executing a transaction only costs a seek per chunk instead of one per
+ * transaction, and transactions due by later blocks are never visited.
+ */
+class scheduled_transaction_queue {
+   public:
+      struct entry {
+         transaction_id_type trx_id;
+         time_point          expiration;
+      };
+
+      scheduled_transaction_queue( const chainbase::database& db, time_point pending_block_time, size_t chunk_size = 1024 );
+
+      /// next due transaction still in the database, nothing once all due transactions have been returned
+      std::optional<entry> next();
+
+      size_t   depth()const         { return _depth; }         ///< generated transactions in the database when created
+      uint32_t num_published()const { return _num_published; } ///< due transactions skipped since they were scheduled by the pending block
+
+   private:
+      void refill();
+
+      using delay_key = std::pair<time_point, generated_transaction_object::id_type>;
+
+      const chainbase::database&  _db;
+      const time_point            _pending_block_time;
+      const size_t                _chunk_size;
+      const size_t                _depth;
+      std::vector<entry>          _chunk;
+      size_t                      _pos = 0;
+      std::optional<delay_key>    _last;       ///< by_delay key of the last transaction read
+      bool                        _end = false;
+      uint32_t                    _num_published = 0;
+};
+
+} } /// namespace eosio::chain
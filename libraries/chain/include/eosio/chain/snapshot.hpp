@@ -4,9 +4,15 @@
 #include <eosio/chain/exceptions.hpp>
 #include <fc/variant_object.hpp>
 #include <boost/core/demangle.hpp>
+#include <deque>
+#include <future>
+#include <memory>
 #include <ostream>
+#include <unordered_map>
 
 namespace eosio { namespace chain {
+   class named_thread_pool;
+
    /**
     * History:
     * Version 1: initial version with string identified sections and rows
@@ -380,4 +386,193 @@ namespace eosio { namespace chain {
 
    };
 
+   namespace detail {
+      struct compressed_snapshot_section {
+         std::string name;
+         uint64_t    pos       = 0;
+         uint64_t    row_count = 0;
+      };
+   }
+
+   /**
+    * Binary snapshot whose sections are split into independently zlib compressed frames.
+    *
+    * Each section is a sequence of frames `[uint32 compressed size][uint32 raw size][data]` ended by a zero compressed size.
+    * The sections are followed by a table of `[name\0][uint64 pos][uint64 row count]` entries and a trailer of
+    * `[uint64 table pos][uint32 magic]`, so the file is written front to back without seeking.  Rows are serialized exactly
+    * as in the uncompressed snapshot; when an encoder is given it receives the same bytes as
+    * integrity_hash_snapshot_writer, yielding the integrity hash without a second pass over the state.
+    * Frames are compressed on num_threads threads while the following rows are serialized.
+    */
+   class compressed_ostream_snapshot_writer : public snapshot_writer {
+      public:
+         explicit compressed_ostream_snapshot_writer(std::ostream& snapshot, fc::sha256::encoder* integrity_enc = nullptr,
+                                                     uint16_t num_threads = 2, uint32_t frame_size = default_frame_size);
+         ~compressed_ostream_snapshot_writer();
+
+         void write_start_section( const std::string& section_name ) override;
+         void write_row( const detail::abstract_snapshot_row_writer& row_writer ) override;
+         void write_end_section( ) override;
+         void finalize();
+
+         static const uint32_t magic_number = 0x30510551;
+         static const uint32_t default_frame_size = 4*1024*1024;
+
+      private:
+         void flush_frame();
+         void write_pending_frames( size_t max_remaining );
+
+         std::ostream&                                      snapshot;
+         std::streampos                                     header_pos;
+         fc::sha256::encoder*                               integrity_enc;
+         const uint32_t                                     frame_size;
+         const size_t                                       max_pending;
+         std::unique_ptr<named_thread_pool>                 thread_pool;
+         std::vector<char>                                  frame;
+         std::unique_ptr<std::streambuf>                    frame_buf;
+         std::unique_ptr<std::ostream>                      frame_stream;
+         std::deque<std::future<std::vector<char>>>         pending;
+         std::vector<detail::compressed_snapshot_section>   sections;
+         bool                                               in_section = false;
+   };
+
+   /**
+    * Reads snapshots written by compressed_ostream_snapshot_writer.  The frames of the current section are decompressed on
+    * num_threads threads ahead of the row decoding.
+    */
+   class compressed_istream_snapshot_reader : public snapshot_reader {
+      public:
+         explicit compressed_istream_snapshot_reader(std::istream& snapshot, uint16_t num_threads = 2);
+         ~compressed_istream_snapshot_reader();
+
+         void validate() const override;
+         bool has_section( const string& section_name ) override;
+         void set_section( const string& section_name ) override;
+         bool read_row( detail::abstract_snapshot_row_reader& row_reader ) override;
+         bool empty ( ) override;
+         void clear_section() override;
+         void return_to_header() override;
+
+         /// @return true if the stream, at its current position, starts with a compressed snapshot; the position is restored
+         static bool is_compressed_snapshot( std::istream& snapshot );
+
+      private:
+         void load_section_table() const;
+         const detail::compressed_snapshot_section* find_section( const string& section_name ) const;
+         void read_ahead();
+         bool next_frame( std::vector<char>& out );
+
+         std::istream&                                            snapshot;
+         std::streampos                                           header_pos;
+         const size_t                                             max_pending;
+         std::unique_ptr<named_thread_pool>                       thread_pool;
+         mutable std::vector<detail::compressed_snapshot_section> sections;
+         mutable bool                                             sections_loaded = false;
+         std::deque<std::future<std::vector<char>>>               pending;
+         bool                                                     section_exhausted = true;
+         std::unique_ptr<std::streambuf>                          frame_buf;
+         std::unique_ptr<std::istream>                            row_stream;
+         uint64_t                                                 num_rows = 0;
+         uint64_t                                                 cur_row = 0;
+   };
+
+   namespace detail {
+      /**
+       * Content defined chunking with a gear rolling hash, boundaries depend only on the preceding bytes so an insertion
+       * or removal only changes the chunks around it.
+       */
+      struct content_chunker {
+         static constexpr size_t min_chunk_size = 16*1024;
+         static constexpr size_t max_chunk_size = 256*1024;
+
+         /// @return the size of the chunk starting at data, or 0 if more than size bytes are needed to find its end
+         size_t next( const char* data, size_t size );
+
+         size_t   pos  = 0;
+         uint64_t hash = 0;
+      };
+   }
+
+   /**
+    * Snapshot holding only the content that differs from a base binary snapshot written by ostream_snapshot_writer.
+    *
+    * Sections use the ostream_snapshot_writer layout, but their rows are stored as a sequence of content defined chunks
+    * terminated by a 0 byte: `[1][uint32 size][data]` for new data, `[2][uint64 pos][uint32 size][uint64 check]` for a
+    * chunk found at pos in the same section of the base.  A delta depends only on its base, so restoring needs the base
+    * and a single delta.
+    */
+   class delta_ostream_snapshot_writer : public snapshot_writer {
+      public:
+         delta_ostream_snapshot_writer(std::ostream& snapshot, std::istream& base);
+         ~delta_ostream_snapshot_writer();
+
+         void write_start_section( const std::string& section_name ) override;
+         void write_row( const detail::abstract_snapshot_row_writer& row_writer ) override;
+         void write_end_section( ) override;
+         void finalize();
+
+         static const uint32_t magic_number = 0x30510552;
+
+      private:
+         struct base_chunk {
+            uint64_t pos  = 0;
+            uint32_t size = 0;
+         };
+
+         struct chunk_hash {
+            size_t operator()( const fc::sha256& d ) const { return d._hash[0]; }
+         };
+
+         void index_base_section( const std::string& section_name );
+         void write_chunks();
+         void write_chunk( const char* data, size_t size );
+
+         std::ostream&                                           snapshot;
+         std::istream&                                           base;
+         std::streampos                                          base_header_pos;
+         std::streampos                                          section_pos;
+         uint64_t                                                row_count;
+         std::vector<char>                                       pending;
+         std::unique_ptr<std::streambuf>                         pending_buf;
+         std::unique_ptr<std::ostream>                           pending_stream;
+         detail::content_chunker                                 chunker;
+         std::unordered_map<fc::sha256, base_chunk, chunk_hash>  base_chunks;
+   };
+
+   /**
+    * Reads a snapshot written by delta_ostream_snapshot_writer, taking referenced chunks from its base.  Every chunk copied
+    * from the base is checked against the delta so a mismatched base is rejected.
+    */
+   class delta_istream_snapshot_reader : public snapshot_reader {
+      public:
+         delta_istream_snapshot_reader(std::istream& snapshot, std::istream& base);
+         ~delta_istream_snapshot_reader();
+
+         void validate() const override;
+         bool has_section( const string& section_name ) override;
+         void set_section( const string& section_name ) override;
+         bool read_row( detail::abstract_snapshot_row_reader& row_reader ) override;
+         bool empty ( ) override;
+         void clear_section() override;
+         void return_to_header() override;
+
+         /// @return true if the stream, at its current position, starts with a delta snapshot; the position is restored
+         static bool is_delta_snapshot( std::istream& snapshot );
+
+      private:
+         bool next_chunk( std::vector<char>& out );
+
+         std::istream&                   snapshot;
+         std::istream&                   base;
+         std::streampos                  header_pos;
+         std::streampos                  base_header_pos;
+         std::streampos                  base_data_pos;
+         uint64_t                        base_data_size = 0;
+         bool                            section_done = true;
+         std::unique_ptr<std::streambuf> chunk_buf;
+         std::unique_ptr<std::istream>   row_stream;
+         uint64_t                        num_rows = 0;
+         uint64_t                        cur_row = 0;
+   };
+
 }}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+#include <fc/filesystem.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace eosio { namespace chain {
+
+/**
+ * Contract state keys read and written by a single transaction.
+ *
+ * Keys are byte strings which sort in state order: contract table rows are encoded as
+ * 'd' code scope table primary_key and key-value database entries as 'k' contract key, with
+ * names and primary keys big endian. A range read is recorded as the prefix of the keys the range may
+ * cover, for contract tables this is the whole table ('d' code scope table) since a lookup of any
+ * index of a table may land on any of its rows.
+ *
+ * Only contract state is recorded: system objects updated by every transaction (sequence numbers,
+ * resource usage and billing) and objects modified by native actions are not.
+ */
+struct transaction_state_accesses {
+   std::vector<std::string> reads;       ///< exact keys read
+   std::vector<std::string> range_reads; ///< prefixes of key ranges searched or iterated
+   std::vector<std::string> writes;      ///< exact keys created, modified or removed
+
+   static std::string db_table_prefix( name code, name scope, name table );
+   static std::string db_row_key( name code, name scope, name table, uint64_t primary_key );
+   static std::string kv_key( name contract, const char* key, uint32_t key_size );
+
+   void add_db_read( name code, name scope, name table, uint64_t primary_key ) {
+      reads.emplace_back( db_row_key( code, scope, table, primary_key ) );
+   }
+   void add_db_range_read( name code, name scope, name table ) {
+      range_reads.emplace_back( db_table_prefix( code, scope, table ) );
+   }
+   void add_db_write( name code, name scope, name table, uint64_t primary_key ) {
+      writes.emplace_back( db_row_key( code, scope, table, primary_key ) );
+   }
+   void add_kv_read( name contract, const char* key, uint32_t key_size ) {
+      reads.emplace_back( kv_key( contract, key, key_size ) );
+   }
+   void add_kv_range_read( name contract, const char* prefix, uint32_t prefix_size ) {
+      range_reads.emplace_back( kv_key( contract, prefix, prefix_size ) );
+   }
+   void add_kv_write( name contract, const char* key, uint32_t key_size ) {
+      writes.emplace_back( kv_key( contract, key, key_size ) );
+   }
+
+   /// sort and remove duplicates of all key sets
+   void normalize();
+};
+
+/**
+ * Conflict graph of the transactions of a block.
+ *
+ * An edge connects an earlier and a later transaction of the block if one of them writes a key the other
+ * reads or writes, i.e. the later transaction can not be executed before the earlier one completes.
+ * Only edges to the latest conflicting accesses of a key are included, dependencies which follow
+ * transitively through them are omitted.
+ */
+struct block_conflict_graph {
+   uint32_t                                  block_num = 0;
+   block_id_type                             id;
+   vector<transaction_id_type>               trxs;
+   vector<std::pair<uint32_t, uint32_t>>     edges;         ///< (earlier, later) indexes into trxs, ordered by later
+   uint32_t                                  longest_chain = 0; ///< transactions in the longest path of dependent transactions
+};
+
+/**
+ * Writes the conflict graph of every committed block as a line of json to a file,
+ * used to measure how much parallelism real workloads offer.
+ */
+class state_access_recorder {
+public:
+   using recorded_transaction = std::pair<transaction_id_type, transaction_state_accesses>;
+
+   explicit state_access_recorder( const fc::path& output_file );
+
+   /// @param trxs accesses of the transactions of the block in block order, normalized
+   static block_conflict_graph build_conflict_graph( uint32_t block_num, const block_id_type& id,
+                                                     const vector<recorded_transaction>& trxs );
+
+   /// @param trxs accesses of the transactions of the block in block order, normalized
+   void write_block( uint32_t block_num, const block_id_type& id, const vector<recorded_transaction>& trxs );
+
+private:
+   std::ofstream _out;
+};
+
+} } // eosio::chain
+
+FC_REFLECT( eosio::chain::block_conflict_graph, (block_num)(id)(trxs)(edges)(longest_chain) )
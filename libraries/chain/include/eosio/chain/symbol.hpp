@@ -103,15 +103,11 @@ namespace eosio {
             }
             string name() const
             {
-               uint64_t v = m_value;
-               v >>= 8;
-               string result;
-               while (v > 0) {
-                  char c = v & 0xFF;
-                  result += c;
-                  v >>= 8;
-               }
-               return result;
+               char buf[7];
+               size_t len = 0;
+               for (uint64_t v = m_value >> 8; v > 0; v >>= 8)
+                  buf[len++] = v & 0xFF;
+               return string(buf, len);
             }
 
             symbol_code to_symbol_code()const { return {m_value >> 8}; }
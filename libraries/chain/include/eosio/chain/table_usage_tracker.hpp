@@ -0,0 +1,85 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <boost/container/flat_map.hpp>
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace eosio { namespace chain {
+
+/**
+ * A contract table. Rows of multi index tables are counted over all scopes of the table, tables of the
+ * key value database are named by the first 8 bytes of their keys.
+ */
+struct table_usage_key {
+   name  code;
+   name  table;
+   bool  kv = false; ///< a table of the key value database
+
+   /// table of a key value database key, its first 8 bytes big endian padded with zeros
+   static name kv_table( const char* key, uint32_t key_size ) {
+      uint64_t table = 0;
+      for( uint32_t i = 0; i < 8; ++i )
+         table = ( table << 8 ) | ( i < key_size ? static_cast<uint8_t>( key[i] ) : 0 );
+      return name( table );
+   }
+
+   friend bool operator<( const table_usage_key& a, const table_usage_key& b ) {
+      return std::tie( a.code, a.table, a.kv ) < std::tie( b.code, b.table, b.kv );
+   }
+};
+
+struct table_usage {
+   int64_t  rows  = 0;
+   int64_t  bytes = 0; ///< billable bytes of the rows, as charged to the ram of their payers
+
+   table_usage& operator+=( const table_usage& u ) { rows += u.rows; bytes += u.bytes; return *this; }
+   table_usage& operator-=( const table_usage& u ) { rows -= u.rows; bytes -= u.bytes; return *this; }
+};
+
+/// changes of table usage by a transaction
+using table_usage_deltas = boost::container::flat_map<table_usage_key, table_usage>;
+
+/**
+ * Rows and bytes of contract tables, kept up to date from the table rows written by the transactions of
+ * committed blocks. The changes of reversible blocks are kept so they are undone when the blocks are popped.
+ *
+ * commit_block and pop_block are called from the main thread, the other methods may be called from any thread.
+ */
+class table_usage_tracker {
+public:
+   using usage_map = std::map<table_usage_key, table_usage>;
+
+   /**
+    * @param baseline - usage of the tables when tracking starts
+    * @param has_baseline - false when baseline is not known, usage is then the growth since tracking started
+    */
+   table_usage_tracker( usage_map baseline, bool has_baseline );
+
+   /// @param trxs changes of the transactions of the block
+   void commit_block( uint32_t block_num, const vector<table_usage_deltas>& trxs, uint32_t last_irreversible_block_num );
+
+   /// undo the changes of block_num, when they were committed
+   void pop_block( uint32_t block_num );
+
+   usage_map get_tables()const;
+   bool has_baseline()const { return _has_baseline; }
+   /// last block committed, 0 when none
+   uint32_t head_block_num()const;
+
+private:
+   const bool                                          _has_baseline;
+   mutable std::mutex                                  _mtx;
+   usage_map                                           _tables;
+   std::deque<std::pair<uint32_t, table_usage_deltas>> _reversible; ///< changes of the committed reversible blocks, oldest first
+   uint32_t                                            _head_block_num = 0;
+};
+
+} } // eosio::chain
+
+FC_REFLECT( eosio::chain::table_usage_key, (code)(table)(kv) )
+FC_REFLECT( eosio::chain::table_usage, (rows)(bytes) )
@@ -3,9 +3,18 @@
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/thread_pool.hpp>
 #include <boost/asio/post.hpp>
+#include <fc/exception/exception.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/scoped_exit.hpp>
+#include <fc/time.hpp>
+#include <atomic>
+#include <condition_variable>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
+#include <vector>
 
 namespace eosio { namespace chain {
 
@@ -17,7 +26,8 @@ namespace eosio { namespace chain {
    public:
       // name_prefix is name appended with -## of thread.
       // short name_prefix (6 chars or under) is recommended as console_appender uses 9 chars for thread name
-      named_thread_pool( std::string name_prefix, size_t num_threads );
+      // cpus, if not empty, pins thread ## to cpus[## % cpus.size()] (linux only)
+      named_thread_pool( std::string name_prefix, size_t num_threads, const std::vector<uint16_t>& cpus = {} );
 
       // calls stop()
       ~named_thread_pool();
@@ -36,6 +46,99 @@ namespace eosio { namespace chain {
    };
 
 
+   /**
+    * Runs posted tasks one at a time, in order, on a dedicated named thread.
+    * post() blocks the caller while max_queued tasks are pending, applying back-pressure to the caller
+    * instead of queuing without bound. Intended for signal consumers moving work off the main thread.
+    * Exceptions thrown by tasks are logged and dropped.
+    */
+   class bounded_serial_executor {
+   public:
+      bounded_serial_executor( std::string name, size_t max_queued );
+
+      // calls stop()
+      ~bounded_serial_executor();
+
+      template<typename F>
+      void post( F&& f ) {
+         {
+            std::unique_lock<std::mutex> g( _mtx );
+            _cv.wait( g, [this]() { return _queued < _max_queued; } );
+            ++_queued;
+         }
+         boost::asio::post( _thread_pool.get_executor(), [this, f{std::forward<F>( f )}]() mutable {
+            auto done = fc::make_scoped_exit( [this]() { task_done(); } );
+            try {
+               f();
+            } FC_LOG_AND_DROP();
+         } );
+      }
+
+      // blocks until all posted tasks have run
+      void drain();
+
+      // drain() and stop the thread, no tasks may be posted afterwards
+      void stop();
+
+      size_t queued();
+
+   private:
+      void task_done();
+
+      std::mutex                 _mtx;
+      std::condition_variable    _cv;
+      size_t                     _queued = 0;
+      const size_t               _max_queued;
+      named_thread_pool          _thread_pool;
+   };
+
+   /**
+    * Counters of the tasks of one type posted with async_thread_pool, to see what a thread pool is busy with.
+    * Task types are process wide, see get_thread_pool_task_counters().
+    */
+   struct thread_pool_task_counters {
+      std::atomic<uint64_t> queued{0};    ///< posted and not started
+      std::atomic<uint64_t> running{0};
+      std::atomic<uint64_t> completed{0};
+      std::atomic<uint64_t> wait_us{0};   ///< total time from post until start
+      std::atomic<uint64_t> run_us{0};    ///< total run time
+   };
+
+   struct thread_pool_task_metrics {
+      std::string task_type;
+      uint64_t    queued = 0;
+      uint64_t    running = 0;
+      uint64_t    completed = 0;
+      uint64_t    wait_us = 0;
+      uint64_t    run_us = 0;
+   };
+
+   // counters of task_type, created on first use and never destroyed
+   thread_pool_task_counters& get_thread_pool_task_counters( const std::string& task_type );
+
+   // counters of all task types, by task type
+   std::vector<thread_pool_task_metrics> get_thread_pool_task_metrics();
+
+   namespace detail {
+      // f counted as a task of counters
+      template<typename F>
+      auto counted_task( thread_pool_task_counters& counters, F&& f ) {
+         counters.queued.fetch_add( 1, std::memory_order_relaxed );
+         return [&counters, posted = fc::time_point::now(), f{std::forward<F>( f )}]() mutable {
+            const auto start = fc::time_point::now();
+            counters.queued.fetch_sub( 1, std::memory_order_relaxed );
+            counters.running.fetch_add( 1, std::memory_order_relaxed );
+            counters.wait_us.fetch_add( ( start - posted ).count(), std::memory_order_relaxed );
+            auto done = fc::make_scoped_exit( [&counters, start]() {
+               counters.run_us.fetch_add( ( fc::time_point::now() - start ).count(), std::memory_order_relaxed );
+               counters.running.fetch_sub( 1, std::memory_order_relaxed );
+               counters.completed.fetch_add( 1, std::memory_order_relaxed );
+            } );
+            return f();
+         };
+      }
+   }
+
    // async on thread_pool and return future
    template<typename F>
    auto async_thread_pool( boost::asio::io_context& thread_pool, F&& f ) {
@@ -44,6 +147,26 @@ namespace eosio { namespace chain {
       return task->get_future();
    }
 
-} } // eosio::chain
+   // async on thread_pool, counted in counters, and return future
+   template<typename F>
+   auto async_thread_pool( boost::asio::io_context& thread_pool, thread_pool_task_counters& counters, F&& f ) {
+      return async_thread_pool( thread_pool, detail::counted_task( counters, std::forward<F>( f ) ) );
+   }
 
+   // async on thread_pool, counted in counters, then call then( future ) on the same thread once f is done,
+   // instead of blocking a thread on future.get(). The future is ready, get() returns the result or rethrows
+   // the exception of f. then must not throw.
+   template<typename F, typename Then>
+   void async_thread_pool( boost::asio::io_context& thread_pool, thread_pool_task_counters& counters, F&& f, Then&& then ) {
+      boost::asio::post( thread_pool, [task = detail::counted_task( counters, std::forward<F>( f ) ),
+                                       then{std::forward<Then>( then )}]() mutable {
+         std::packaged_task<decltype( task() )()> pt( std::move( task ) );
+         auto fut = pt.get_future();
+         pt();
+         then( std::move( fut ) );
+      } );
+   }
+
+} } // eosio::chain
 
+FC_REFLECT( eosio::chain::thread_pool_task_metrics, (task_type)(queued)(running)(completed)(wait_us)(run_us) )
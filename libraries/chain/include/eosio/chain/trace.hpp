@@ -2,6 +2,7 @@
 
 #include <eosio/chain/action.hpp>
 #include <eosio/chain/action_receipt.hpp>
+#include <eosio/chain/action_profile.hpp>
 #include <eosio/chain/block.hpp>
 
 namespace eosio { namespace chain {
@@ -46,6 +47,7 @@ namespace eosio { namespace chain {
       std::optional<fc::exception>    except;
       std::optional<uint64_t>         error_code;
       std::vector<char>               return_value;
+      std::optional<action_profile>   profile; ///< only when the transaction was profiled, not reflected so the packed trace is unchanged
    };
 
    struct transaction_trace {
@@ -116,6 +118,7 @@ namespace eosio { namespace chain {
 FC_REFLECT( eosio::chain::account_delta,
             (account)(delta) )
 
+// @ignore profile
 FC_REFLECT( eosio::chain::action_trace,
                (action_ordinal)(creator_action_ordinal)(closest_unnotified_ancestor_action_ordinal)(receipt)
                (receiver)(act)(context_free)(elapsed)(console)(trx_id)(block_num)(block_time)
@@ -5,6 +5,8 @@
 
 namespace eosio { namespace chain {
 
+   class recovered_key_cache;
+
    struct deferred_transaction_generation_context : fc::reflect_init {
       static constexpr uint16_t extension_id() { return 0; }
       static constexpr bool     enforce_unique() { return true; }
@@ -86,7 +88,8 @@ namespace eosio { namespace chain {
                                                      fc::time_point deadline,
                                                      const vector<bytes>& cfd,
                                                      flat_set<public_key_type>& recovered_pub_keys,
-                                                     bool allow_duplicate_keys = false) const;
+                                                     bool allow_duplicate_keys = false,
+                                                     recovered_key_cache* key_cache = nullptr) const;
 
       uint32_t total_actions()const { return context_free_actions.size() + actions.size(); }
 
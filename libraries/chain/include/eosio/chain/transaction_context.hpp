@@ -3,6 +3,8 @@
 #include <eosio/chain/controller.hpp>
 #include <eosio/chain/trace.hpp>
 #include <eosio/chain/platform_timer.hpp>
+#include <eosio/chain/state_access_recorder.hpp>
+#include <eosio/chain/table_usage_tracker.hpp>
 #include <signal.h>
 
 namespace eosio { namespace chain {
@@ -46,6 +48,22 @@ namespace eosio { namespace chain {
          friend controller_impl;
    };
 
+   /**
+    * Containers an apply_context fills while it executes, handed on to the later apply_contexts of a transaction
+    * so that they are not allocated again for every action
+    */
+   struct apply_context_buffers {
+      vector< std::pair<account_name, uint32_t> >   notified;
+      vector<uint32_t>                              inline_actions;
+      vector<uint32_t>                              cfa_inline_actions;
+
+      void clear() {
+         notified.clear();
+         inline_actions.clear();
+         cfa_inline_actions.clear();
+      }
+   };
+
    class transaction_context {
       private:
          void init( uint64_t initial_net_usage );
@@ -122,6 +140,8 @@ namespace eosio { namespace chain {
          friend class apply_context;
 
          void add_ram_usage( account_name account, int64_t ram_delta, const storage_usage_trace& trace );
+         /// apply the RAM deltas added since the last flush to the resource limits, called at the end of every action
+         void flush_ram_usage();
 
          action_trace& get_action_trace( uint32_t action_ordinal );
          const action_trace& get_action_trace( uint32_t action_ordinal )const;
@@ -140,6 +160,9 @@ namespace eosio { namespace chain {
 
          void execute_action( uint32_t action_ordinal, uint32_t recurse_depth );
 
+         std::unique_ptr<apply_context_buffers> acquire_apply_context_buffers();
+         void release_apply_context_buffers( std::unique_ptr<apply_context_buffers> buffers );
+
          void schedule_transaction();
          void record_transaction( const transaction_id_type& id, fc::time_point_sec expire );
 
@@ -162,6 +185,12 @@ namespace eosio { namespace chain {
 
 
          deque<digest_type>            executed_action_receipt_digests;
+         /// contract state accessed by the transaction, only recorded when set before execution
+         std::optional<transaction_state_accesses> state_accesses;
+         /// changes of contract table usage by the transaction, only recorded when set before execution
+         std::optional<table_usage_deltas> table_deltas;
+         /// attach an action_profile to the trace of every action, only when set before execution
+         bool                          profile_actions = false;
          flat_set<account_name>        bill_to_accounts;
          flat_set<account_name>        validate_ram_usage;
          flat_set<account_name>        validate_disk_usage;
@@ -173,6 +202,7 @@ namespace eosio { namespace chain {
          bool                          is_input           = false;
          bool                          apply_context_free = true;
          bool                          enforce_whiteblacklist = true;
+         bool                          read_only = false; ///< contract writes are rejected, set for transaction_metadata::trx_type::read_only
 
          fc::time_point                deadline = fc::time_point::maximum();
          fc::microseconds              leeway = fc::microseconds( config::default_subjective_cpu_leeway_us );
@@ -188,6 +218,14 @@ namespace eosio { namespace chain {
       private:
          bool                          is_initialized = false;
 
+         /// sum of the RAM deltas of an account since the last flush_ram_usage, with the range of its running sum
+         struct pending_ram_delta {
+            int64_t delta = 0;
+            int64_t min_delta = 0;
+            int64_t max_delta = 0;
+         };
+         flat_map<account_name, pending_ram_delta> pending_ram_deltas;
+
 
          uint64_t                      net_limit = 0;
          bool                          net_limit_due_to_block = true;
@@ -206,6 +244,9 @@ namespace eosio { namespace chain {
          fc::time_point                pseudo_start;
          fc::microseconds              billed_time;
          fc::microseconds              billing_timer_duration_limit;
+
+         /// released by finished apply_contexts, apply_contexts of nested inline actions each hold their own
+         vector<std::unique_ptr<apply_context_buffers>> free_apply_context_buffers;
    };
 
 } }
@@ -23,7 +23,8 @@ class transaction_metadata {
       enum class trx_type {
          input,
          implicit,
-         scheduled
+         scheduled,
+         read_only ///< executed for its traces only: writes are rejected and the state is always rolled back
       };
 
    private:
@@ -34,6 +35,7 @@ class transaction_metadata {
    public:
       const bool                                                 implicit;
       const bool                                                 scheduled;
+      const bool                                                 read_only;
       bool                                                       accepted = false;       // not thread safe
       uint32_t                                                   billed_cpu_time_us = 0; // not thread safe
 
@@ -49,16 +51,21 @@ class transaction_metadata {
          return *sigs;
       }
 
+      static transaction_metadata_ptr recover_keys( packed_transaction_ptr trx, const chain_id_type& chain_id,
+                                                    fc::microseconds time_limit, uint32_t max_variable_sig_size,
+                                                    recovered_key_cache* key_cache );
+
    public:
       // creation of tranaction_metadata restricted to start_recover_keys and create_no_recover_keys below, public for make_shared
       explicit transaction_metadata( const private_type& pt, packed_transaction_ptr ptrx,
                                      fc::microseconds sig_cpu_usage, flat_set<public_key_type> recovered_pub_keys,
-                                     bool _implicit = false, bool _scheduled = false)
+                                     bool _implicit = false, bool _scheduled = false, bool _read_only = false)
          : _packed_trx( std::move( ptrx ) )
          , _sig_cpu_usage( sig_cpu_usage )
          , _recovered_pub_keys( std::move( recovered_pub_keys ) )
          , implicit( _implicit )
-         , scheduled( _scheduled ) {
+         , scheduled( _scheduled )
+         , read_only( _read_only ) {
       }
 
       transaction_metadata() = delete;
@@ -75,17 +82,29 @@ class transaction_metadata {
       uint32_t get_estimated_size() const;
 
       /// Thread safe.
+      /// @param key_cache optional cache consulted before and updated after recovering each signature
       /// @returns transaction_metadata_ptr or exception via future
       static recover_keys_future
       start_recover_keys( packed_transaction_ptr trx, boost::asio::io_context& thread_pool,
                           const chain_id_type& chain_id, fc::microseconds time_limit,
-                          uint32_t max_variable_sig_size = UINT32_MAX );
+                          uint32_t max_variable_sig_size = UINT32_MAX,
+                          recovered_key_cache* key_cache = nullptr );
+
+      /// Thread safe. Recovers keys of all trxs in at most num_jobs thread_pool jobs instead of one job per trx.
+      /// trxs are distributed round-robin across the jobs so results become available roughly in trxs order.
+      /// @returns one future per trx, in trxs order, with transaction_metadata_ptr or exception of that trx
+      static std::vector<recover_keys_future>
+      start_recover_keys( std::vector<packed_transaction_ptr> trxs, boost::asio::io_context& thread_pool,
+                          const chain_id_type& chain_id, fc::microseconds time_limit, size_t num_jobs,
+                          uint32_t max_variable_sig_size = UINT32_MAX,
+                          recovered_key_cache* key_cache = nullptr );
 
       /// @returns constructed transaction_metadata with no key recovery (sig_cpu_usage=0, recovered_pub_keys=empty)
       static transaction_metadata_ptr
       create_no_recover_keys( packed_transaction_ptr trx, trx_type t ) {
          return std::make_shared<transaction_metadata>( private_type(), std::move(trx),
-               fc::microseconds(), flat_set<public_key_type>(), t == trx_type::implicit, t == trx_type::scheduled );
+               fc::microseconds(), flat_set<public_key_type>(), t == trx_type::implicit, t == trx_type::scheduled,
+               t == trx_type::read_only );
       }
 
 };
@@ -8,6 +8,7 @@
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/member.hpp>
+#include <boost/multi_index/composite_key.hpp>
 
 namespace fc {
   inline std::size_t hash_value( const fc::sha256& v ) {
@@ -29,12 +30,15 @@ enum class trx_enum_type {
 };
 
 using next_func_t = std::function<void(const std::variant<fc::exception_ptr, transaction_trace_ptr>&)>;
+/// higher priority incoming transactions are applied first, equal priority in arrival order
+using priority_func_t = std::function<uint32_t(const transaction_metadata_ptr&)>;
 
 struct unapplied_transaction {
    const transaction_metadata_ptr trx_meta;
    const fc::time_point           expiry;
    trx_enum_type                  trx_type = trx_enum_type::unknown;
    next_func_t                    next;
+   uint32_t                       priority = 0;
 
    const transaction_id_type& id()const { return trx_meta->id(); }
 
@@ -47,6 +51,8 @@ struct unapplied_transaction {
 /**
  * Track unapplied transactions for persisted, forked blocks, and aborted blocks.
  * Persisted are first so that they can be applied in each block until expired.
+ * Within a type, transactions are ordered by priority then arrival. When the incoming queue is full, a higher
+ * priority incoming transaction replaces lower priority incoming transactions.
  */
 class unapplied_transaction_queue {
 private:
@@ -59,7 +65,13 @@ private:
          hashed_unique< tag<by_trx_id>,
                const_mem_fun<unapplied_transaction, const transaction_id_type&, &unapplied_transaction::id>
          >,
-         ordered_non_unique< tag<by_type>, member<unapplied_transaction, trx_enum_type, &unapplied_transaction::trx_type> >,
+         ordered_non_unique< tag<by_type>,
+               composite_key< unapplied_transaction,
+                     member<unapplied_transaction, trx_enum_type, &unapplied_transaction::trx_type>,
+                     member<unapplied_transaction, uint32_t, &unapplied_transaction::priority>
+               >,
+               composite_key_compare< std::less<trx_enum_type>, std::greater<uint32_t> >
+         >,
          ordered_non_unique< tag<by_expiry>, member<unapplied_transaction, const fc::time_point, &unapplied_transaction::expiry> >
       >
    > unapplied_trx_queue_type;
@@ -68,11 +80,15 @@ private:
    uint64_t max_transaction_queue_size = 1024*1024*1024; // enforced for incoming
    uint64_t size_in_bytes = 0;
    size_t incoming_count = 0;
+   priority_func_t priority_func;
 
 public:
 
    void set_max_transaction_queue_size( uint64_t v ) { max_transaction_queue_size = v; }
 
+   /// called for each incoming transaction, if not set all incoming transactions have the same priority
+   void set_priority_function( priority_func_t f ) { priority_func = std::move( f ); }
+
    bool empty() const {
       return queue.empty();
    }
@@ -183,19 +199,22 @@ public:
    }
 
    void add_incoming( const transaction_metadata_ptr& trx, bool persist_until_expired, next_func_t next ) {
+      const uint32_t priority = priority_func ? priority_func( trx ) : 0;
       auto itr = queue.get<by_trx_id>().find( trx->id() );
       if( itr == queue.get<by_trx_id>().end() ) {
+         evict_incoming( calc_size( trx ), priority );
          fc::time_point expiry = trx->packed_trx()->expiration();
          auto insert_itr = queue.insert(
-               { trx, expiry, persist_until_expired ? trx_enum_type::incoming_persisted : trx_enum_type::incoming, std::move( next ) } );
+               { trx, expiry, persist_until_expired ? trx_enum_type::incoming_persisted : trx_enum_type::incoming, std::move( next ), priority } );
          if( insert_itr.second ) added( insert_itr.first );
       } else {
          if (itr->trx_type != trx_enum_type::incoming && itr->trx_type != trx_enum_type::incoming_persisted)
             ++incoming_count;
 
-         queue.get<by_trx_id>().modify( itr, [persist_until_expired, next{std::move(next)}](auto& un) mutable {
+         queue.get<by_trx_id>().modify( itr, [persist_until_expired, priority, next{std::move(next)}](auto& un) mutable {
             un.trx_type = persist_until_expired ? trx_enum_type::incoming_persisted : trx_enum_type::incoming;
             un.next = std::move( next );
+            un.priority = priority;
          } );
       }
    }
@@ -222,6 +241,34 @@ public:
    }
 
 private:
+   /// drop lowest priority incoming transactions, non-persisted first, to make room for size bytes of priority.
+   /// nothing is dropped if that would not make enough room.
+   void evict_incoming( uint64_t size, uint32_t priority ) {
+      if( size_in_bytes + size < max_transaction_queue_size ) return;
+      auto& idx = queue.get<by_type>();
+      std::vector<iterator> victims;
+      uint64_t freed = 0;
+      for( trx_enum_type t : { trx_enum_type::incoming, trx_enum_type::incoming_persisted } ) {
+         auto b = idx.lower_bound( t );
+         for( auto e = idx.upper_bound( t ); e != b && size_in_bytes - freed + size >= max_transaction_queue_size; ) {
+            --e;
+            if( e->priority >= priority ) break;
+            freed += calc_size( e->trx_meta );
+            victims.push_back( e );
+         }
+      }
+      if( size_in_bytes - freed + size >= max_transaction_queue_size ) return;
+      for( auto& itr : victims ) {
+         if( itr->next ) {
+            itr->next( std::static_pointer_cast<fc::exception>( std::make_shared<tx_resource_exhaustion>(
+                  FC_LOG_MESSAGE( error, "transaction ${id} dropped from incoming queue for higher priority transaction",
+                                  ("id", itr->id()) ) ) ) );
+         }
+         removed( itr );
+         idx.erase( itr );
+      }
+   }
+
    template<typename Itr>
    void added( Itr itr ) {
       auto size = calc_size( itr->trx_meta );
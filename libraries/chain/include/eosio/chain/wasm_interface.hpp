@@ -48,7 +48,7 @@ namespace eosio { namespace chain {
          void indicate_shutting_down();
 
          //validates code -- does a WASM validation pass and checks the wasm against EOSIO specific constraints
-         static void validate(const controller& control, const bytes& code);
+         static void validate(const controller& control, const char* code, size_t code_size);
 
          //indicate that a particular code probably won't be used after given block_num
          void code_block_num_last_used(const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version, const uint32_t& block_num);
@@ -59,6 +59,9 @@ namespace eosio { namespace chain {
          //Calls apply or error on a given code
          void apply(const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version, apply_context& context);
 
+         //compiles the contracts EOS VM OC tier-up used most recently before the last shutdown, waiting for them until deadline
+         void eosvmoc_prewarm(const fc::time_point& deadline);
+
          //Immediately exits currently running wasm. UB is called when no wasm running
          void exit();
 
@@ -90,22 +90,70 @@ namespace eosio { namespace chain {
                });
       }
 
-      std::vector<uint8_t> parse_initial_memory(const Module& module) {
-         std::vector<uint8_t> mem_image;
-
-         for(const DataSegment& data_segment : module.dataSegments) {
-            EOS_ASSERT(data_segment.baseOffset.type == InitializerExpression::Type::i32_const, wasm_exception, "");
-            EOS_ASSERT(module.memories.defs.size(), wasm_exception, "");
-            const U32 base_offset = data_segment.baseOffset.i32;
-            const Uptr memory_size = (module.memories.defs[0].type.size.min << IR::numBytesPerPageLog2);
-            if(base_offset >= memory_size || base_offset + data_segment.data.size() > memory_size)
-               FC_THROW_EXCEPTION(wasm_execution_error, "WASM data segment outside of valid memory range");
-            if(base_offset + data_segment.data.size() > mem_image.size())
-               mem_image.resize(base_offset + data_segment.data.size(), 0x00);
-            memcpy(mem_image.data() + base_offset, data_segment.data.data(), data_segment.data.size());
+      // setcode only checks that the data segments lie in the first maximum_linear_memory_init bytes, not in the
+      // initial memory the module declares. Only the memory and data sections of the wasm are decoded for it.
+      static void check_data_segments(const char* code, size_t size) {
+         constexpr uint8_t memory_section_id = 5;
+         constexpr uint8_t data_section_id   = 11;
+         constexpr uint8_t i32_const_opcode  = 0x41;
+         constexpr uint8_t end_opcode        = 0x0b;
+
+         auto read_varint32 = [](fc::datastream<const char*>& ds) {
+            uint32_t result = 0;
+            uint32_t shift  = 0;
+            uint8_t  b;
+            do {
+               fc::raw::unpack(ds, b);
+               result |= static_cast<uint32_t>(b & 0x7f) << shift;
+               shift += 7;
+            } while ((b & 0x80) && shift < 35);
+            if (shift < 32 && (b & 0x40))
+               result |= ~0u << shift;
+            return result;
+         };
+
+         fc::datastream<const char*> ds(code, size);
+         ds.skip(8); // magic number and version
+         bool     has_memory  = false;
+         uint64_t memory_size = 0;
+         while (ds.remaining()) {
+            uint8_t          id;
+            fc::unsigned_int section_size;
+            fc::raw::unpack(ds, id);
+            fc::raw::unpack(ds, section_size);
+            EOS_ASSERT(section_size.value <= ds.remaining(), wasm_serialization_error, "wasm section is truncated");
+            fc::datastream<const char*> section(ds.pos(), section_size.value);
+            ds.skip(section_size.value);
+
+            if (id == memory_section_id) {
+               fc::unsigned_int count, flags, initial;
+               fc::raw::unpack(section, count);
+               if (count.value) {
+                  fc::raw::unpack(section, flags);
+                  fc::raw::unpack(section, initial);
+                  has_memory  = true;
+                  memory_size = static_cast<uint64_t>(initial.value) * wasm_constraints::wasm_page_size;
+               }
+            } else if (id == data_section_id) {
+               fc::unsigned_int count;
+               fc::raw::unpack(section, count);
+               for (uint32_t i = 0; i < count.value; ++i) {
+                  fc::unsigned_int memory_index, data_size;
+                  uint8_t          opcode;
+                  fc::raw::unpack(section, memory_index);
+                  fc::raw::unpack(section, opcode);
+                  EOS_ASSERT(opcode == i32_const_opcode, wasm_exception, "");
+                  const uint64_t base_offset = read_varint32(section);
+                  fc::raw::unpack(section, opcode);
+                  EOS_ASSERT(opcode == end_opcode, wasm_exception, "");
+                  fc::raw::unpack(section, data_size);
+                  section.skip(data_size.value);
+                  EOS_ASSERT(has_memory, wasm_exception, "");
+                  if(base_offset >= memory_size || base_offset + data_size.value > memory_size)
+                     FC_THROW_EXCEPTION(wasm_execution_error, "WASM data segment outside of valid memory range");
+               }
+            }
          }
-
-         return mem_image;
       }
 
       void code_block_num_last_used(const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version, const uint32_t& block_num) {
@@ -124,12 +172,18 @@ namespace eosio { namespace chain {
          if(eosvmoc) for(auto it = first_it; it != last_it; it++)
             eosvmoc->cc.free_code(it->code_hash, it->vm_version);
 #endif
+         last_used = nullptr;
          wasm_instantiation_cache.get<by_last_block_num>().erase(first_it, last_it);
       }
 
       const std::unique_ptr<wasm_instantiated_module_interface>& get_instantiated_module( const digest_type& code_hash, const uint8_t& vm_type,
                                                                                  const uint8_t& vm_version, transaction_context& trx_context )
       {
+         // consecutive actions and notifications are commonly handled by the same contract
+         if(last_used && last_used->module && last_used->code_hash == code_hash &&
+            last_used->vm_type == vm_type && last_used->vm_version == vm_version)
+            return last_used->module;
+
          wasm_cache_index::iterator it = wasm_instantiation_cache.find(
                                              boost::make_tuple(code_hash, vm_type, vm_version) );
          const code_object* codeobject = nullptr;
@@ -154,39 +208,14 @@ namespace eosio { namespace chain {
                trx_context.resume_billing_timer();
             });
             trx_context.pause_billing_timer();
-            IR::Module module;
-            std::vector<U8> bytes = {
-                (const U8*)codeobject->code.data(),
-                (const U8*)codeobject->code.data() + codeobject->code.size()};
-            try {
-               Serialization::MemoryInputStream stream((const U8*)bytes.data(),
-                                                       bytes.size());
-               WASM::scoped_skip_checks no_check;
-               WASM::serialize(stream, module);
-               module.userSections.clear();
-            } catch (const Serialization::FatalSerializationException& e) {
-               EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
-            } catch (const IR::ValidationException& e) {
-               EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
-            }
-            if (runtime_interface->inject_module(module)) {
-               try {
-                  Serialization::ArrayOutputStream outstream;
-                  WASM::serialize(outstream, module);
-                  bytes = outstream.getBytes();
-               } catch (const Serialization::FatalSerializationException& e) {
-                  EOS_ASSERT(false, wasm_serialization_error,
-                             e.message.c_str());
-               } catch (const IR::ValidationException& e) {
-                  EOS_ASSERT(false, wasm_serialization_error,
-                             e.message.c_str());
-               }
-            }
-
+            // both eos-vm and EOS VM OC work directly from the wasm bytes, so there is no need to parse it into
+            // WAVM IR first; the data segments are the one thing setcode leaves to be checked here
+            check_data_segments(codeobject->code.data(), codeobject->code.size());
             wasm_instantiation_cache.modify(it, [&](auto& c) {
-               c.module = runtime_interface->instantiate_module((const char*)bytes.data(), bytes.size(), parse_initial_memory(module), code_hash, vm_type, vm_version);
+               c.module = runtime_interface->instantiate_module(codeobject->code.data(), codeobject->code.size(), code_hash, vm_type, vm_version);
             });
          }
+         last_used = &*it;
          return it->module;
       }
 
@@ -208,6 +237,7 @@ namespace eosio { namespace chain {
          >
       > wasm_cache_index;
       wasm_cache_index wasm_instantiation_cache;
+      const wasm_cache_entry* last_used = nullptr; ///< entry returned by the last get_instantiated_module, reset on eviction
 
       const chainbase::database& db;
       const wasm_interface::vm_type wasm_runtime_time;
@@ -13,6 +13,8 @@
 #include <boost/interprocess/mem_algo/rbtree_best_fit.hpp>
 #include <boost/asio/local/datagram_protocol.hpp>
 
+#include <fc/time.hpp>
+
 
 #include <thread>
 
@@ -76,6 +78,15 @@ class code_cache_base {
       std::unordered_set<code_tuple> _queued_compiles;
       std::unordered_map<code_tuple, bool> _outstanding_compiles_and_poison;
 
+      //how much each code is used, for ordering compiles and choosing which entries to evict
+      struct code_usage {
+         uint64_t         executions = 0;
+         fc::microseconds baseline_time; ///< time spent executing in the baseline runtime, roughly what compiling saves
+      };
+      std::unordered_map<code_tuple, code_usage> _usage;
+      code_usage usage_of(const code_tuple& ct) const;
+      code_usage& track_usage(const code_tuple& ct);
+
       size_t _free_bytes_eviction_threshold;
       void check_eviction_threshold(size_t free_bytes);
       void run_eviction_round();
@@ -84,6 +95,12 @@ class code_cache_base {
 
       template <typename T>
       void serialize_cache_index(fc::datastream<T>& ds);
+
+      //the most recently used codes of a run, read back by the next one to compile them ahead of use
+      bfs::path _hot_list_path;
+      size_t _hot_list_size;
+      void write_hot_list();
+      std::vector<code_tuple> read_hot_list();
 };
 
 class code_cache_async : public code_cache_base {
@@ -92,17 +109,29 @@ class code_cache_async : public code_cache_base {
       ~code_cache_async();
 
       //If code is in cache: returns pointer & bumps to front of MRU list
-      //If code is not in cache, and not blacklisted, and not currently compiling: return nullptr and kick off compile
+      //If code is not in cache, executed at least tierup_threshold times, not blacklisted, and not currently compiling:
+      // return nullptr and kick off compile
       //otherwise: return nullptr
       const code_descriptor* const get_descriptor_for_code(const digest_type& code_id, const uint8_t& vm_version);
 
+      //adds time code was executed by the baseline runtime while not in the cache
+      void record_baseline_time(const digest_type& code_id, const uint8_t& vm_version, const fc::microseconds& t);
+
+      //Compiles the codes of the previous run's hot list that are not in the cache, on all compile threads, and waits
+      // until they are done or deadline passes. Returns the number of codes it started compiling
+      size_t prewarm(const fc::time_point& deadline);
+
    private:
+      void process_compile_results();
+      void start_compile(const code_tuple& ct);
       std::thread _monitor_reply_thread;
       boost::lockfree::spsc_queue<wasm_compilation_result_message> _result_queue;
       void wait_on_compile_monitor_message();
       std::tuple<size_t, size_t> consume_compile_thread_queue();
       std::unordered_set<code_tuple> _blacklist;
       size_t _threads;
+      uint64_t _tierup_threshold;
+      int _compile_nice;
 };
 
 class code_cache_sync : public code_cache_base {
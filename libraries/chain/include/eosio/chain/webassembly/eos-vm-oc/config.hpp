@@ -13,6 +13,10 @@ namespace eosio { namespace chain { namespace eosvmoc {
 struct config {
    uint64_t cache_size = 1024u*1024u*1024u;
    uint64_t threads    = 1u;
+   uint64_t prewarm_contracts = 0u; ///< most recently used contracts recorded at shutdown and compiled again at startup
+   uint64_t tierup_threshold  = 1u; ///< executions of a contract before tier-up compiles it
+   boost::filesystem::path cache_dir;  ///< directory of the code cache file, the state directory when empty
+   int      compile_nice      = 0;  ///< niceness of tier-up compile processes, keeps them from competing with the main thread
 };
 
 }}}
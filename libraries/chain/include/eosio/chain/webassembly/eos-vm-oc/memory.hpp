@@ -30,6 +30,11 @@ class memory {
       memory& operator=(const memory&) = delete;
       void reset(uint64_t max_pages);
 
+      //zeroes the first pages of linear memory, as needed before each execution
+      void zero_linear_memory(uint64_t pages);
+      //smallest linear memory, in wasm pages, zeroed by releasing its host pages rather than writing them
+      static constexpr uint64_t release_min_pages = 16u;
+
       uint8_t* const zero_page_memory_base() const { return zeropage_base; }
       uint8_t* const full_page_memory_base() const { return fullpage_base; }
 
@@ -59,6 +64,8 @@ class memory {
 
       uint8_t* zeropage_base;
       uint8_t* fullpage_base;
+
+      int fd;
 };
 
 }}}
@@ -28,9 +28,9 @@ namespace webassembly { namespace eos_vm_runtime {
 using namespace fc;
 using namespace eosio::vm;
 
-void validate(const bytes& code, const whitelisted_intrinsics_type& intrinsics );
+void validate(const char* code, size_t code_size, const whitelisted_intrinsics_type& intrinsics );
 
-void validate(const bytes& code, const wasm_config& cfg, const whitelisted_intrinsics_type& intrinsics );
+void validate(const char* code, size_t code_size, const wasm_config& cfg, const whitelisted_intrinsics_type& intrinsics );
 
 struct apply_options;
 
@@ -38,8 +38,7 @@ template<typename Backend>
 class eos_vm_runtime : public eosio::chain::wasm_runtime_interface {
    public:
       eos_vm_runtime();
-      bool inject_module(IR::Module&) override;
-      std::unique_ptr<wasm_instantiated_module_interface> instantiate_module(const char* code_bytes, size_t code_size, std::vector<uint8_t>,
+      std::unique_ptr<wasm_instantiated_module_interface> instantiate_module(const char* code_bytes, size_t code_size,
                                                                              const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version) override;
 
       void immediately_exit_currently_running_module() override;
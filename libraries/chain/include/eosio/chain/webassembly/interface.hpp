@@ -655,7 +655,7 @@ namespace webassembly {
           *
           * @return the number of bytes copied to msg, or number of bytes that can be copied if an empty span is passed.
          */
-         int32_t read_action_data(legacy_span<char> memory) const;
+         inline int32_t read_action_data(legacy_span<char> memory) const;
 
          /**
           * Get the length of the current action's data field. This method is useful for dynamically sized actions.
@@ -663,7 +663,7 @@ namespace webassembly {
           * @ingroup action
           * @return the length of the current action's data field
          */
-         int32_t action_data_size() const;
+         inline int32_t action_data_size() const;
 
          /**
           * Get the current receiver of the action.
@@ -671,7 +671,7 @@ namespace webassembly {
           * @ingroup action
           * @return the name of the receiver
          */
-         name current_receiver() const;
+         inline name current_receiver() const;
 
          /**
           * Sets a value (packed blob char array) to be included in the action receipt.
@@ -905,6 +905,26 @@ namespace webassembly {
           */
          int32_t db_end_i64(uint64_t code, uint64_t scope, uint64_t table);
 
+         /**
+          * Get the rows of several primary keys of a primary 64-bit integer index table in one call.
+          * The input buffer is a packed vector of primary keys with the following format:
+          * |varuint32:sequence_length | uint64:primary_key | ...
+          * The output buffer is a packed vector of optional row data, one entry per requested key, with the following format:
+          * |varuint32:sequence_length | uint8:found | varuint32:size | bytes:data | ...
+          * where size and data are omitted for keys that have no row.
+          * The output is only written if the buffer is large enough to hold all of it.
+          *
+          * @ingroup database primary-index
+          * @param code - the name of the owner of the table.
+          * @param scope - the scope where the table resides.
+          * @param table - the table name.
+          * @param packed_ids - the input buffer with the format as described above.
+          * @param[out] packed_rows - the output buffer with the format as described above.
+          *
+          * @return the size of the output, whether or not it was written.
+          */
+         uint32_t db_get_batch_i64(uint64_t code, uint64_t scope, uint64_t table, span<const char> packed_ids, span<char> packed_rows);
+
          /**
           * Store an association of a 64-bit integer secondary key to a primary key in a secondary 64-bit integer index table.
           *
@@ -1810,11 +1830,44 @@ namespace webassembly {
          */
          int32_t  kv_it_value(uint32_t itr, uint32_t offset, span<char> dest, uint32_t* actual_size);
 
-         // memory api
-         void* memcpy(memcpy_params) const;
-         void* memmove(memcpy_params) const;
-         int32_t memcmp(memcmp_params) const;
-         void* memset(memset_params) const;
+         /**
+          * Get the values of several keys in one call.
+          * The input buffer is a packed vector of keys with the following format:
+          * |varuint32:sequence_length | varuint32:key_size | bytes:key | ...
+          * The output buffer is a packed vector of optional values, one entry per requested key, with the following format:
+          * |varuint32:sequence_length | uint8:found | varuint32:value_size | bytes:value | ...
+          * where value_size and value are omitted for keys that do not exist.
+          * The output is only written if the buffer is large enough to hold all of it.
+          *
+          * @ingroup kv-database
+          * @param contract - name of the contract associated with the kv pairs.
+          * @param packed_keys - the input buffer with the format as described above.
+          * @param[out] packed_values - the output buffer with the format as described above.
+          *
+          * @return the size of the output, whether or not it was written.
+         */
+         uint32_t kv_get_batch(uint64_t contract, span<const char> packed_keys, span<char> packed_values);
+
+         /**
+          * Set several key-value pairs in one call.
+          * The input buffer is a packed vector of pairs with the following format:
+          * |varuint32:sequence_length | varuint32:key_size | bytes:key | varuint32:value_size | bytes:value | ...
+          * The pairs are set in order, as if by kv_set.
+          *
+          * @ingroup kv-database
+          * @param contract - name of the contract associated with the kv pairs.
+          * @param packed_pairs - the input buffer with the format as described above.
+          * @param payer - name of the account paying for the resource.
+          *
+          * @return total change in resource usage.
+         */
+         int64_t  kv_set_batch(uint64_t contract, span<const char> packed_pairs, account_name payer);
+
+         // memory api, defined in interface_inline.hpp so the host function thunks can inline them
+         inline void* memcpy(memcpy_params) const;
+         inline void* memmove(memcpy_params) const;
+         inline int32_t memcmp(memcmp_params) const;
+         inline void* memset(memset_params) const;
 
          /**
           * Send an inline action in the context of the parent transaction of this operation.
@@ -1,6 +1,19 @@
+#pragma once
+
 #include <eosio/chain/webassembly/interface.hpp>
+#include <eosio/chain/apply_context.hpp>
+
+#include <cstring>
+
+// Definitions of the small, frequently called host functions. They are kept out of the
+// per-api translation units so that the host function thunks generated when registering
+// the intrinsics with a runtime can inline them instead of calling across translation units.
+// Include this header only where the intrinsics are registered.
 
 namespace eosio { namespace chain { namespace webassembly {
+
+   // memory api
+
    void* interface::memcpy( memcpy_params args ) const {
       auto [dest, src, length] = args;
       EOS_ASSERT((size_t)(std::abs((ptrdiff_t)(char*)dest - (ptrdiff_t)(const char*)src)) >= length,
@@ -24,4 +37,24 @@ namespace eosio { namespace chain { namespace webassembly {
       return (char *)std::memset( (char*)dest, value, length );
    }
 
+   // action api
+
+   int32_t interface::read_action_data(legacy_span<char> memory) const {
+      auto s = context.get_action().data.size();
+      if( memory.size() == 0 ) return s;
+
+      auto copy_size = std::min( static_cast<size_t>(memory.size()), s );
+      std::memcpy( memory.data(), context.get_action().data.data(), copy_size );
+
+      return copy_size;
+   }
+
+   int32_t interface::action_data_size() const {
+      return context.get_action().data.size();
+   }
+
+   name interface::current_receiver() const {
+      return context.get_receiver();
+   }
+
 }}} // ns eosio::chain::webassembly
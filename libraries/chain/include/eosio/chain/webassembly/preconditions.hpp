@@ -118,6 +118,12 @@ namespace eosio { namespace chain { namespace webassembly {
                        "${code} does not have permission to call this API", ("code", ctx.get_host().get_context().get_receiver()));
          }));
 
+   EOS_VM_PRECONDITION(read_write_check,
+         EOS_VM_INVOKE_ONCE([&](auto&&...) {
+            EOS_ASSERT(!ctx.get_host().get_context().trx_context.read_only, unaccessible_api,
+                       "this API may not be called from a read-only transaction");
+         }));
+
    namespace detail {
       template<typename T>
       vm::span<const char> to_span(const vm::argument_proxy<T*>& val) { 
@@ -1,5 +1,8 @@
 #include <eosio/chain/merkle.hpp>
 #include <fc/io/raw.hpp>
+#include <algorithm>
+#include <array>
+#include <optional>
 
 namespace eosio { namespace chain {
 
@@ -32,21 +35,62 @@ bool is_canonical_right(const digest_type& val) {
 }
 
 
+digest_type hash_canonical_pair(const digest_type& l, const digest_type& r) {
+   std::array<digest_type, 2> pair{ make_canonical_left(l), make_canonical_right(r) };
+   static_assert( sizeof(pair) == 2 * sizeof(digest_type::_hash), "digest_type expected to be its raw hash" );
+   return digest_type::hash( reinterpret_cast<const char*>(pair.data()), sizeof(pair) );
+}
+
 digest_type merkle(deque<digest_type> ids) {
    if( 0 == ids.size() ) { return digest_type(); }
 
    while( ids.size() > 1 ) {
-      if( ids.size() % 2 )
-         ids.push_back(ids.back());
-
-      for (size_t i = 0; i < ids.size() / 2; i++) {
-         ids[i] = digest_type::hash(make_canonical_pair(ids[2 * i], ids[(2 * i) + 1]));
+      const size_t n = ids.size();
+      // an odd last id is paired with itself
+      for (size_t i = 0; i < (n + 1) / 2; i++) {
+         const size_t r = std::min( 2 * i + 1, n - 1 );
+         ids[i] = hash_canonical_pair(ids[2 * i], ids[r]);
       }
 
-      ids.resize(ids.size() / 2);
+      ids.resize((n + 1) / 2);
    }
 
    return ids.front();
 }
 
+void merkle_accumulator::append( const digest_type& digest ) {
+   digest_type carry = digest;
+   size_t h = 0;
+   for( ; _count & (uint64_t(1) << h); ++h ) {
+      carry = hash_canonical_pair( _subtree_roots[h], carry );
+   }
+   if( h >= _subtree_roots.size() ) _subtree_roots.resize( h + 1 );
+   _subtree_roots[h] = carry;
+   ++_count;
+}
+
+digest_type merkle_accumulator::get_root()const {
+   if( _count == 0 ) return digest_type();
+
+   // fold from the lowest level up, a node without a right sibling is paired with itself as merkle() does
+   std::optional<digest_type> carry;
+   for( size_t h = 0; h < _subtree_roots.size(); ++h ) {
+      const bool has_subtree = _count & (uint64_t(1) << h);
+      const bool has_higher  = (_count >> (h + 1)) != 0;
+      if( has_subtree ) {
+         if( carry ) {
+            carry = hash_canonical_pair( _subtree_roots[h], *carry );
+         } else if( has_higher ) {
+            carry = hash_canonical_pair( _subtree_roots[h], _subtree_roots[h] );
+         } else {
+            return _subtree_roots[h];
+         }
+      } else if( carry ) {
+         if( !has_higher ) break;
+         carry = hash_canonical_pair( *carry, *carry );
+      }
+   }
+   return *carry;
+}
+
 } } // eosio::chain
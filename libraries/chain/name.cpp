@@ -1,6 +1,5 @@
 #include <eosio/chain/name.hpp>
 #include <fc/variant.hpp>
-#include <boost/algorithm/string.hpp>
 
 namespace eosio::chain {
 
@@ -10,19 +9,20 @@ namespace eosio::chain {
 
    // keep in sync with name::to_string() in contract definition for name
    std::string name::to_string()const {
-     static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
-
-      std::string str(13,'.');
-
-      uint64_t tmp = value;
-      for( uint32_t i = 0; i <= 12; ++i ) {
-         char c = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
-         str[12-i] = c;
-         tmp >>= (i == 0 ? 4 : 5);
+      static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+
+      // trailing '.' are not part of the string, they are the trailing zero symbols: the 13th character is the low
+      // 4 bits, each of the 12 before it 5 bits above those
+      size_t len = 0;
+      if( value ) {
+         const int zero_bits = __builtin_ctzll( value );
+         len = zero_bits < 4 ? 13 : 12 - ( zero_bits - 4 ) / 5;
       }
 
-      boost::algorithm::trim_right_if( str, []( char c ){ return c == '.'; } );
-      return str;
+      char str[13];
+      for( size_t i = 0; i < len; ++i )
+         str[i] = charmap[i < 12 ? ( value >> ( 59 - 5 * i ) ) & 0x1f : value & 0x0f];
+      return std::string( str, len );
    }
 
    bool is_string_valid_name(std::string_view str)
@@ -33,22 +33,12 @@ namespace eosio::chain {
 
       size_t len = (slen <= 12) ? slen : 12;
       for( size_t i = 0; i < len; ++i ) {
-         char c = str[i];
-         if ((c >= 'a' && c <= 'z') || (c >= '1' && c <= '5') || (c == '.'))
-            continue;
-         else
-            return false;
-      }
-
-      if( slen == 13) {
-         char c = str[12];
-         if ((c >= 'a' && c <= 'j') || (c >= '1' && c <= '5') || (c == '.'))
-            return true;
-         else
+         if( detail::name_symbols[static_cast<unsigned char>(str[i])] == detail::invalid_name_symbol )
             return false;
       }
 
-      return true;
+      // the 13th character is encoded in 4 bits, [.1-5a-j]
+      return slen < 13 || detail::name_symbols[static_cast<unsigned char>(str[12])] <= 0x0f;
    }
 
 } // eosio::chain
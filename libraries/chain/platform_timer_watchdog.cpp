@@ -0,0 +1,154 @@
+#include <eosio/chain/platform_timer.hpp>
+#include <eosio/chain/platform_timer_accuracy.hpp>
+
+#include <fc/fwd_impl.hpp>
+#include <fc/log/logger_config.hpp> //set_os_thread_name()
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Timers publish their deadline with an atomic store and a single watchdog thread, shared by all instances, sleeps
+ * until the earliest published deadline and expires the timers whose deadline passed. Arming and disarming a timer
+ * makes no syscall: the watchdog is only woken when a deadline is published earlier than the one it sleeps until.
+ * Transactions run back to back arm deadlines later than the previous one, so the watchdog wakes at most once per
+ * deadline period instead of the two timer_settime() calls per transaction of the posix implementation.
+ */
+
+namespace eosio { namespace chain {
+
+namespace {
+   constexpr int64_t disarmed = std::numeric_limits<int64_t>::max();
+   constexpr int64_t expiring = -1; ///< the watchdog is calling the expiration callback
+
+   //the watchdog wakes at least this often even with no deadline published
+   constexpr int64_t max_sleep_us = 1000000;
+
+   int64_t now_us() {
+      return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+   }
+}
+
+//a thread is shared for all instances
+static std::mutex watchdog_mutex;
+static std::condition_variable watchdog_cv;
+static std::vector<platform_timer*> watchdog_timers;
+static std::thread watchdog_thread;
+static bool watchdog_stopping;
+//deadline the watchdog sleeps until, disarmed while it scans the timers
+static std::atomic<int64_t> watchdog_wake{disarmed};
+
+struct platform_timer::impl {
+   std::atomic<int64_t> deadline{disarmed}; ///< microseconds since epoch
+
+   static void run();
+   static void expire(platform_timer& timer, int64_t deadline);
+};
+
+void platform_timer::impl::run() {
+   std::unique_lock g(watchdog_mutex);
+   while(!watchdog_stopping) {
+      watchdog_wake = disarmed;
+      const int64_t now = now_us();
+      int64_t next = now + max_sleep_us;
+      for(platform_timer* t : watchdog_timers) {
+         const int64_t d = t->my->deadline.load();
+         if(d == disarmed || d == expiring)
+            continue;
+         if(d > now)
+            next = std::min(next, d);
+         else
+            expire(*t, d);
+      }
+      watchdog_wake = next;
+      watchdog_cv.wait_until(g, std::chrono::system_clock::time_point(std::chrono::microseconds(next)));
+   }
+}
+
+void platform_timer::impl::expire(platform_timer& timer, int64_t deadline) {
+   //a stop() or start() since the deadline was read wins, so an expiration never leaks into the next deadline;
+   //while expiring, start() and stop() wait for the callback to return
+   if(!timer.my->deadline.compare_exchange_strong(deadline, expiring))
+      return;
+   timer.expired = 1;
+   timer.call_expiration_callback();
+   timer.my->deadline = disarmed;
+}
+
+platform_timer::platform_timer() {
+   static_assert(sizeof(impl) <= fwd_size);
+
+   std::lock_guard guard(watchdog_mutex);
+
+   watchdog_timers.push_back(this);
+   if(watchdog_timers.size() == 1) {
+      watchdog_stopping = false;
+      watchdog_thread = std::thread([]() {
+         fc::set_os_thread_name("checktime");
+         impl::run();
+      });
+   }
+
+   //compute_and_print_timer_accuracy(*this);
+}
+
+platform_timer::~platform_timer() {
+   stop();
+   std::thread joining;
+   {
+      std::lock_guard guard(watchdog_mutex);
+      watchdog_timers.erase(std::find(watchdog_timers.begin(), watchdog_timers.end(), this));
+      if(watchdog_timers.empty()) {
+         watchdog_stopping = true;
+         joining = std::move(watchdog_thread);
+      }
+   }
+   if(joining.joinable()) {
+      watchdog_cv.notify_all();
+      joining.join();
+   }
+}
+
+void platform_timer::start(fc::time_point tp) {
+   if(tp == fc::time_point::maximum()) {
+      expired = 0;
+      return;
+   }
+   const int64_t deadline = tp.time_since_epoch().count();
+   if(deadline <= now_us()) {
+      expired = 1;
+      return;
+   }
+   //an expiration callback still running belongs to the previous deadline
+   while(my->deadline.load() == expiring)
+      std::this_thread::yield();
+   expired = 0;
+   my->deadline = deadline;
+   //the watchdog publishes its wake up after scanning, so either it saw this deadline or this sees its wake up
+   if(deadline < watchdog_wake.load()) {
+      std::lock_guard guard(watchdog_mutex);
+      watchdog_cv.notify_one();
+   }
+}
+
+void platform_timer::stop() {
+   if(expired)
+      return;
+
+   int64_t d = my->deadline.load();
+   //wait out an expiration callback in progress, it must not run once the timer is stopped
+   while(d == expiring || !my->deadline.compare_exchange_weak(d, disarmed)) {
+      if(d == expiring) {
+         std::this_thread::yield();
+         d = my->deadline.load();
+      }
+   }
+   expired = 1;
+}
+
+}}
@@ -230,6 +230,18 @@ Builtin protocol feature: BLOCKCHAIN_PARAMETERS
 
 Allows privileged contracts to get and set subsets of blockchain parameters.
 */
+         (  builtin_protocol_feature_t::batched_database, builtin_protocol_feature_spec{
+            "BATCHED_DATABASE",
+            fc::variant("e8c8d6a5edd99acd01dca2685bf3801d8e8a7e05ab220466974068b75568fccb").as<digest_type>(),
+            // SHA256 hash of the raw message below within the comment delimiters (do not modify message below).
+/*
+Builtin protocol feature: BATCHED_DATABASE
+Depends on: KV_DATABASE
+
+Enables intrinsics that read or write several database rows in one call: `db_get_batch_i64`, `kv_get_batch` and `kv_set_batch`.
+*/
+            {builtin_protocol_feature_t::kv_database}
+         } )
    ;
 
 
@@ -541,6 +553,10 @@ Allows privileged contracts to get and set subsets of blockchain parameters.
       std::function<fc::logger*()> get_deep_mind_logger
    ):_protocol_feature_set( std::move(pfs) ), _get_deep_mind_logger(get_deep_mind_logger)
    {
+      EOS_ASSERT( _protocol_feature_set._recognized_builtin_protocol_features.size() <= max_builtin_protocol_features,
+                  protocol_feature_exception,
+                  "invariant failure: more builtin protocol features than max_builtin_protocol_features"
+      );
       _builtin_protocol_features.resize( _protocol_feature_set._recognized_builtin_protocol_features.size() );
    }
 
@@ -667,16 +683,6 @@ Allows privileged contracts to get and set subsets of blockchain parameters.
       return const_iterator{this, static_cast<std::size_t>(itr - begin)};
    }
 
-   bool protocol_feature_manager::is_builtin_activated( builtin_protocol_feature_t feature_codename,
-                                                        uint32_t current_block_num )const
-   {
-      uint32_t indx = static_cast<uint32_t>( feature_codename );
-
-      if( indx >= _builtin_protocol_features.size() ) return false;
-
-      return (_builtin_protocol_features[indx].activation_block_num <= current_block_num);
-   }
-
    void protocol_feature_manager::activate_feature( const digest_type& feature_digest,
                                                     uint32_t current_block_num )
    {
@@ -730,6 +736,8 @@ Allows privileged contracts to get and set subsets of blockchain parameters.
       _builtin_protocol_features[indx].previous = _head_of_builtin_activation_list;
       _builtin_protocol_features[indx].activation_block_num = current_block_num;
       _head_of_builtin_activation_list = indx;
+      _activated_builtins.set( indx );
+      _last_builtin_activation_block_num = current_block_num;
    }
 
    void protocol_feature_manager::popped_blocks_to( uint32_t block_num ) {
@@ -739,10 +747,13 @@ Allows privileged contracts to get and set subsets of blockchain parameters.
          auto& e = _builtin_protocol_features[_head_of_builtin_activation_list];
          if( e.activation_block_num <= block_num ) break;
 
+         _activated_builtins.reset( _head_of_builtin_activation_list );
          _head_of_builtin_activation_list = e.previous;
          e.previous = builtin_protocol_feature_entry::no_previous;
          e.activation_block_num = builtin_protocol_feature_entry::not_active;
       }
+      _last_builtin_activation_block_num = ( _head_of_builtin_activation_list == builtin_protocol_feature_entry::no_previous )
+                                           ? 0 : _builtin_protocol_features[_head_of_builtin_activation_list].activation_block_num;
 
       while( _activated_protocol_features.size() > 0
               && block_num < _activated_protocol_features.back().activation_block_num )
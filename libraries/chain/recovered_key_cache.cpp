@@ -0,0 +1,62 @@
+#include <eosio/chain/recovered_key_cache.hpp>
+
+namespace eosio { namespace chain {
+
+recovered_key_cache::recovered_key_cache( size_t max_entries )
+: _max_entries_per_shard( max_entries == 0 ? 0 : std::max<size_t>( max_entries / num_shards, 1 ) )
+{}
+
+digest_type recovered_key_cache::make_key( const signature_type& sig, const digest_type& digest, bool check_canonical ) {
+   if( check_canonical ) return digest_type::hash( std::make_pair( digest, sig ) );
+   // a non-canonical signature must never satisfy a lookup that requires the canonical check
+   return digest_type::hash( std::make_pair( std::make_pair( digest, sig ), check_canonical ) );
+}
+
+std::optional<public_key_type> recovered_key_cache::find( const digest_type& key ) {
+   if( _max_entries_per_shard == 0 ) return {};
+   auto& s = get_shard( key );
+   std::lock_guard<std::mutex> g( s.mtx );
+   auto itr = s.keys.find( key );
+   if( itr == s.keys.end() ) return {};
+   return itr->second;
+}
+
+void recovered_key_cache::insert( const digest_type& key, const public_key_type& pub_key ) {
+   if( _max_entries_per_shard == 0 ) return;
+   auto& s = get_shard( key );
+   std::lock_guard<std::mutex> g( s.mtx );
+   if( !s.keys.emplace( key, pub_key ).second ) return;
+   s.insertion_order.push_back( key );
+   while( s.insertion_order.size() > _max_entries_per_shard ) {
+      s.keys.erase( s.insertion_order.front() );
+      s.insertion_order.pop_front();
+   }
+}
+
+public_key_type recovered_key_cache::recover( const signature_type& sig, const digest_type& digest, bool check_canonical ) {
+   if( _max_entries_per_shard == 0 ) return public_key_type( sig, digest, check_canonical );
+   const digest_type key = make_key( sig, digest, check_canonical );
+   if( auto pub_key = find( key ) ) return *pub_key;
+   public_key_type pub_key( sig, digest, check_canonical );
+   insert( key, pub_key );
+   return pub_key;
+}
+
+size_t recovered_key_cache::size() {
+   size_t result = 0;
+   for( auto& s : _shards ) {
+      std::lock_guard<std::mutex> g( s.mtx );
+      result += s.keys.size();
+   }
+   return result;
+}
+
+void recovered_key_cache::clear() {
+   for( auto& s : _shards ) {
+      std::lock_guard<std::mutex> g( s.mtx );
+      s.keys.clear();
+      s.insertion_order.clear();
+   }
+}
+
+} } // eosio::chain
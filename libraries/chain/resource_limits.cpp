@@ -162,6 +162,9 @@ void resource_limits_manager::update_account_usage(const flat_set<account_name>&
    const auto& config = _db.get<resource_limits_config_object>();
    for( const auto& a : accounts ) {
       const auto& usage = _db.get<resource_usage_object,by_owner>( a );
+      // adding nothing in the slot of the last usage changes nothing, skip the undo tracked modify
+      if( usage.net_usage.last_ordinal == time_slot && usage.cpu_usage.last_ordinal == time_slot )
+         continue;
       _db.modify( usage, [&]( auto& bu ){
           bu.net_usage.add( 0, time_slot, config.account_net_usage_average_window );
           bu.cpu_usage.add( 0, time_slot, config.account_cpu_usage_average_window );
@@ -173,13 +176,18 @@ void resource_limits_manager::add_transaction_usage(const flat_set<account_name>
    const auto& state = _db.get<resource_limits_state_object>();
    const auto& config = _db.get<resource_limits_config_object>();
 
+   // the same for all accounts
+   const uint128_t cpu_window_size = config.account_cpu_usage_average_window;
+   const uint128_t net_window_size = config.account_net_usage_average_window;
+   const auto virtual_cpu_capacity_in_window = (uint128_t)state.virtual_cpu_limit * cpu_window_size;
+   const auto virtual_net_capacity_in_window = (uint128_t)state.virtual_net_limit * net_window_size;
+
    for( const auto& a : accounts ) {
 
       const auto& usage = _db.get<resource_usage_object,by_owner>( a );
-      int64_t unused;
-      int64_t net_weight;
-      int64_t cpu_weight;
-      get_account_limits( a, unused, net_weight, cpu_weight );
+      const auto& limits = get_account_limits( a );
+      const int64_t net_weight = limits.net_weight;
+      const int64_t cpu_weight = limits.cpu_weight;
 
       _db.modify( usage, [&]( auto& bu ){
           bu.net_usage.add( net_usage, time_slot, config.account_net_usage_average_window );
@@ -193,14 +201,12 @@ void resource_limits_manager::add_transaction_usage(const flat_set<account_name>
       });
 
       if( cpu_weight >= 0 && state.total_cpu_weight > 0 ) {
-         uint128_t window_size = config.account_cpu_usage_average_window;
-         auto virtual_network_capacity_in_window = (uint128_t)state.virtual_cpu_limit * window_size;
-         auto cpu_used_in_window                 = ((uint128_t)usage.cpu_usage.value_ex * window_size) / (uint128_t)config::rate_limiting_precision;
+         auto cpu_used_in_window = ((uint128_t)usage.cpu_usage.value_ex * cpu_window_size) / (uint128_t)config::rate_limiting_precision;
 
          uint128_t user_weight     = (uint128_t)cpu_weight;
          uint128_t all_user_weight = state.total_cpu_weight;
 
-         auto max_user_use_in_window = (virtual_network_capacity_in_window * user_weight) / all_user_weight;
+         auto max_user_use_in_window = (virtual_cpu_capacity_in_window * user_weight) / all_user_weight;
 
          EOS_ASSERT( cpu_used_in_window <= max_user_use_in_window,
                      tx_cpu_usage_exceeded,
@@ -211,15 +217,12 @@ void resource_limits_manager::add_transaction_usage(const flat_set<account_name>
       }
 
       if( net_weight >= 0 && state.total_net_weight > 0) {
-
-         uint128_t window_size = config.account_net_usage_average_window;
-         auto virtual_network_capacity_in_window = (uint128_t)state.virtual_net_limit * window_size;
-         auto net_used_in_window                 = ((uint128_t)usage.net_usage.value_ex * window_size) / (uint128_t)config::rate_limiting_precision;
+         auto net_used_in_window = ((uint128_t)usage.net_usage.value_ex * net_window_size) / (uint128_t)config::rate_limiting_precision;
 
          uint128_t user_weight     = (uint128_t)net_weight;
          uint128_t all_user_weight = state.total_net_weight;
 
-         auto max_user_use_in_window = (virtual_network_capacity_in_window * user_weight) / all_user_weight;
+         auto max_user_use_in_window = (virtual_net_capacity_in_window * user_weight) / all_user_weight;
 
          EOS_ASSERT( net_used_in_window <= max_user_use_in_window,
                      tx_net_usage_exceeded,
@@ -271,6 +274,28 @@ void resource_limits_manager::add_pending_ram_usage( const account_name account,
    });
 }
 
+void resource_limits_manager::add_pending_ram_usage( const account_name account, int64_t ram_delta, int64_t min_running_delta, int64_t max_running_delta ) {
+   if (ram_delta == 0 && min_running_delta == 0 && max_running_delta == 0) {
+      return;
+   }
+
+   const auto& usage  = _db.get<resource_usage_object,by_owner>( account );
+
+   // the usage after every delta of the sequence is between usage + min_running_delta and usage + max_running_delta
+   EOS_ASSERT( max_running_delta <= 0 || UINT64_MAX - usage.ram_usage >= (uint64_t)max_running_delta, transaction_exception,
+              "Ram usage delta would overflow UINT64_MAX");
+   EOS_ASSERT(min_running_delta >= 0 || usage.ram_usage >= (uint64_t)(-min_running_delta), transaction_exception,
+              "Ram usage delta would underflow UINT64_MAX");
+
+   if (ram_delta == 0) {
+      return;
+   }
+
+   _db.modify( usage, [&]( auto& u ) {
+      u.ram_usage += ram_delta;
+   });
+}
+
 void resource_limits_manager::verify_account_ram_usage( const account_name account )const {
    int64_t ram_bytes; int64_t net_weight; int64_t cpu_weight;
    get_account_limits( account, ram_bytes, net_weight, cpu_weight );
@@ -448,61 +473,55 @@ uint64_t resource_limits_manager::get_block_net_limit() const {
    return config.net_limit_parameters.max - state.pending_net_usage;
 }
 
-std::pair<int64_t, bool> resource_limits_manager::get_account_cpu_limit( const account_name& name, uint32_t greylist_limit ) const {
-   auto [arl, greylisted] = get_account_cpu_limit_ex(name, greylist_limit);
-   return {arl.available, greylisted};
-}
-
-std::pair<account_resource_limit, bool>
-resource_limits_manager::get_account_cpu_limit_ex( const account_name& name, uint32_t greylist_limit, const std::optional<block_timestamp_type>& current_time) const {
-
-   const auto& state = _db.get<resource_limits_state_object>();
-   const auto& usage = _db.get<resource_usage_object, by_owner>(name);
-   const auto& config = _db.get<resource_limits_config_object>();
-
-   int64_t cpu_weight, x, y;
-   get_account_limits( name, x, y, cpu_weight );
-
-   if( cpu_weight < 0 || state.total_cpu_weight == 0 ) {
-      return {{ -1, -1, -1, block_timestamp_type(usage.cpu_usage.last_ordinal), -1 }, false};
+/**
+ * Limit of an account in a resource, its share by weight of the virtual limit of the resource over the usage window
+ * @param max_limit - the max of the elastic limit parameters of the resource, the virtual limit under greylist_limit
+ *                    is at most max_limit * greylist_limit
+ */
+static std::pair<account_resource_limit, bool>
+compute_account_limit( const usage_accumulator& usage, int64_t weight, uint64_t total_weight, uint64_t virtual_limit,
+                       uint64_t max_limit, uint32_t window, uint32_t greylist_limit,
+                       const std::optional<block_timestamp_type>& current_time ) {
+   if( weight < 0 || total_weight == 0 ) {
+      return {{ -1, -1, -1, block_timestamp_type(usage.last_ordinal), -1 }, false};
    }
 
    account_resource_limit arl;
 
-   uint128_t window_size = config.account_cpu_usage_average_window;
+   uint128_t window_size = window;
 
    bool greylisted = false;
-   uint128_t virtual_cpu_capacity_in_window = window_size;
+   uint128_t virtual_capacity_in_window = window_size;
    if( greylist_limit < config::maximum_elastic_resource_multiplier ) {
-      uint64_t greylisted_virtual_cpu_limit = config.cpu_limit_parameters.max * greylist_limit;
-      if( greylisted_virtual_cpu_limit < state.virtual_cpu_limit ) {
-         virtual_cpu_capacity_in_window *= greylisted_virtual_cpu_limit;
+      uint64_t greylisted_virtual_limit = max_limit * greylist_limit;
+      if( greylisted_virtual_limit < virtual_limit ) {
+         virtual_capacity_in_window *= greylisted_virtual_limit;
          greylisted = true;
       } else {
-         virtual_cpu_capacity_in_window *= state.virtual_cpu_limit;
+         virtual_capacity_in_window *= virtual_limit;
       }
    } else {
-      virtual_cpu_capacity_in_window *= state.virtual_cpu_limit;
+      virtual_capacity_in_window *= virtual_limit;
    }
 
-   uint128_t user_weight     = (uint128_t)cpu_weight;
-   uint128_t all_user_weight = (uint128_t)state.total_cpu_weight;
+   uint128_t user_weight     = (uint128_t)weight;
+   uint128_t all_user_weight = (uint128_t)total_weight;
 
-   auto max_user_use_in_window = (virtual_cpu_capacity_in_window * user_weight) / all_user_weight;
-   auto cpu_used_in_window  = impl::integer_divide_ceil((uint128_t)usage.cpu_usage.value_ex * window_size, (uint128_t)config::rate_limiting_precision);
+   auto max_user_use_in_window = (virtual_capacity_in_window * user_weight) / all_user_weight;
+   auto used_in_window  = impl::integer_divide_ceil((uint128_t)usage.value_ex * window_size, (uint128_t)config::rate_limiting_precision);
 
-   if( max_user_use_in_window <= cpu_used_in_window )
+   if( max_user_use_in_window <= used_in_window )
       arl.available = 0;
    else
-      arl.available = impl::downgrade_cast<int64_t>(max_user_use_in_window - cpu_used_in_window);
+      arl.available = impl::downgrade_cast<int64_t>(max_user_use_in_window - used_in_window);
 
-   arl.used = impl::downgrade_cast<int64_t>(cpu_used_in_window);
+   arl.used = impl::downgrade_cast<int64_t>(used_in_window);
    arl.max = impl::downgrade_cast<int64_t>(max_user_use_in_window);
-   arl.last_usage_update_time = block_timestamp_type(usage.cpu_usage.last_ordinal);
+   arl.last_usage_update_time = block_timestamp_type(usage.last_ordinal);
    arl.current_used = arl.used;
    if ( current_time ) {
-      if (current_time->slot > usage.cpu_usage.last_ordinal) {
-         auto history_usage = usage.cpu_usage;
+      if (current_time->slot > usage.last_ordinal) {
+         auto history_usage = usage;
          history_usage.add(0, current_time->slot, window_size);
          arl.current_used = impl::downgrade_cast<int64_t>(impl::integer_divide_ceil((uint128_t)history_usage.value_ex * window_size, (uint128_t)config::rate_limiting_precision));
       }
@@ -510,6 +529,23 @@ resource_limits_manager::get_account_cpu_limit_ex( const account_name& name, uin
    return {arl, greylisted};
 }
 
+std::pair<int64_t, bool> resource_limits_manager::get_account_cpu_limit( const account_name& name, uint32_t greylist_limit ) const {
+   auto [arl, greylisted] = get_account_cpu_limit_ex(name, greylist_limit);
+   return {arl.available, greylisted};
+}
+
+std::pair<account_resource_limit, bool>
+resource_limits_manager::get_account_cpu_limit_ex( const account_name& name, uint32_t greylist_limit, const std::optional<block_timestamp_type>& current_time) const {
+   const auto& state = _db.get<resource_limits_state_object>();
+   const auto& usage = _db.get<resource_usage_object, by_owner>(name);
+   const auto& config = _db.get<resource_limits_config_object>();
+   const auto& limits = get_account_limits( name );
+
+   return compute_account_limit( usage.cpu_usage, limits.cpu_weight, state.total_cpu_weight, state.virtual_cpu_limit,
+                                 config.cpu_limit_parameters.max, config.account_cpu_usage_average_window,
+                                 greylist_limit, current_time );
+}
+
 std::pair<int64_t, bool> resource_limits_manager::get_account_net_limit( const account_name& name, uint32_t greylist_limit ) const {
    auto [arl, greylisted] = get_account_net_limit_ex(name, greylist_limit);
    return {arl.available, greylisted};
@@ -520,55 +556,26 @@ resource_limits_manager::get_account_net_limit_ex( const account_name& name, uin
    const auto& config = _db.get<resource_limits_config_object>();
    const auto& state  = _db.get<resource_limits_state_object>();
    const auto& usage  = _db.get<resource_usage_object, by_owner>(name);
+   const auto& limits = get_account_limits( name );
 
-   int64_t net_weight, x, y;
-   get_account_limits( name, x, net_weight, y );
-
-   if( net_weight < 0 || state.total_net_weight == 0) {
-      return {{ -1, -1, -1, block_timestamp_type(usage.net_usage.last_ordinal), -1 }, false};
-   }
-
-   account_resource_limit arl;
-
-   uint128_t window_size = config.account_net_usage_average_window;
-
-   bool greylisted = false;
-   uint128_t virtual_network_capacity_in_window = window_size;
-   if( greylist_limit < config::maximum_elastic_resource_multiplier ) {
-      uint64_t greylisted_virtual_net_limit = config.net_limit_parameters.max * greylist_limit;
-      if( greylisted_virtual_net_limit < state.virtual_net_limit ) {
-         virtual_network_capacity_in_window *= greylisted_virtual_net_limit;
-         greylisted = true;
-      } else {
-         virtual_network_capacity_in_window *= state.virtual_net_limit;
-      }
-   } else {
-      virtual_network_capacity_in_window *= state.virtual_net_limit;
-   }
-
-   uint128_t user_weight     = (uint128_t)net_weight;
-   uint128_t all_user_weight = (uint128_t)state.total_net_weight;
-
-   auto max_user_use_in_window = (virtual_network_capacity_in_window * user_weight) / all_user_weight;
-   auto net_used_in_window  = impl::integer_divide_ceil((uint128_t)usage.net_usage.value_ex * window_size, (uint128_t)config::rate_limiting_precision);
-
-   if( max_user_use_in_window <= net_used_in_window )
-      arl.available = 0;
-   else
-      arl.available = impl::downgrade_cast<int64_t>(max_user_use_in_window - net_used_in_window);
+   return compute_account_limit( usage.net_usage, limits.net_weight, state.total_net_weight, state.virtual_net_limit,
+                                 config.net_limit_parameters.max, config.account_net_usage_average_window,
+                                 greylist_limit, current_time );
+}
 
-   arl.used = impl::downgrade_cast<int64_t>(net_used_in_window);
-   arl.max = impl::downgrade_cast<int64_t>(max_user_use_in_window);
-   arl.last_usage_update_time = block_timestamp_type(usage.net_usage.last_ordinal);
-   arl.current_used = arl.used;
-   if ( current_time ) {
-      if (current_time->slot > usage.net_usage.last_ordinal) {
-         auto history_usage = usage.net_usage;
-         history_usage.add(0, current_time->slot, window_size);
-         arl.current_used = impl::downgrade_cast<int64_t>(impl::integer_divide_ceil((uint128_t)history_usage.value_ex * window_size, (uint128_t)config::rate_limiting_precision));
-      }
-   }
-   return {arl, greylisted};
+account_bandwidth_limits
+resource_limits_manager::get_account_bandwidth_limits_ex( const account_name& name, uint32_t greylist_limit, const std::optional<block_timestamp_type>& current_time) const {
+   const auto& config = _db.get<resource_limits_config_object>();
+   const auto& state  = _db.get<resource_limits_state_object>();
+   const auto& usage  = _db.get<resource_usage_object, by_owner>(name);
+   const auto& limits = get_account_limits( name );
+
+   return { compute_account_limit( usage.net_usage, limits.net_weight, state.total_net_weight, state.virtual_net_limit,
+                                   config.net_limit_parameters.max, config.account_net_usage_average_window,
+                                   greylist_limit, current_time ),
+            compute_account_limit( usage.cpu_usage, limits.cpu_weight, state.total_cpu_weight, state.virtual_cpu_limit,
+                                   config.cpu_limit_parameters.max, config.account_cpu_usage_average_window,
+                                   greylist_limit, current_time ) };
 }
 
 } } } /// eosio::chain::resource_limits
@@ -0,0 +1,44 @@
+#include <eosio/chain/scheduled_transaction_queue.hpp>
+
+#include <chainbase/chainbase.hpp>
+
+namespace eosio { namespace chain {
+
+scheduled_transaction_queue::scheduled_transaction_queue( const chainbase::database& db, time_point pending_block_time, size_t chunk_size )
+: _db( db )
+, _pending_block_time( pending_block_time )
+, _chunk_size( std::max<size_t>( chunk_size, 1 ) )
+, _depth( db.get_index<generated_transaction_multi_index>().indices().size() )
+{
+}
+
+std::optional<scheduled_transaction_queue::entry> scheduled_transaction_queue::next() {
+   while( true ) {
+      while( _pos == _chunk.size() ) {
+         if( _end ) return {};
+         refill();
+      }
+      const auto& e = _chunk[_pos++];
+      // transactions executed before this one may have canceled or replaced it
+      if( _db.find<generated_transaction_object, by_trx_id>( e.trx_id ) ) return e;
+   }
+}
+
+void scheduled_transaction_queue::refill() {
+   const auto& idx = _db.get_index<generated_transaction_multi_index, by_delay>();
+   auto itr = _last ? idx.upper_bound( boost::make_tuple( _last->first, _last->second ) ) : idx.begin();
+   _chunk.clear();
+   _pos = 0;
+   for( ; itr != idx.end() && _chunk.size() < _chunk_size; ++itr ) {
+      if( itr->delay_until > _pending_block_time ) break; // not scheduled yet
+      _last = delay_key{ itr->delay_until, itr->id };
+      if( itr->published >= _pending_block_time ) {
+         ++_num_published; // do not allow schedule and execute in same block
+         continue;
+      }
+      _chunk.push_back( entry{ itr->trx_id, itr->expiration } );
+   }
+   _end = itr == idx.end() || itr->delay_until > _pending_block_time;
+}
+
+} } /// namespace eosio::chain
@@ -1,7 +1,17 @@
 #include <eosio/chain/snapshot.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <fc/scoped_exit.hpp>
 
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <array>
+#include <cstring>
+#include <functional>
+#include <optional>
+
 namespace eosio { namespace chain {
 
 variant_snapshot_writer::variant_snapshot_writer(fc::mutable_variant_object& snapshot)
@@ -368,4 +378,801 @@ void integrity_hash_snapshot_writer::finalize() {
    // no-op for structural details
 }
 
+namespace {
+   namespace bio = boost::iostreams;
+
+   // frames larger than this are rejected as corrupt
+   constexpr uint32_t max_snapshot_frame_size = 1024*1024*1024;
+
+   // unbuffered so the size of the frame is always current
+   class frame_write_buf : public std::streambuf {
+   public:
+      explicit frame_write_buf(std::vector<char>& frame)
+      :frame(frame) {}
+
+   protected:
+      int_type overflow( int_type c ) override {
+         if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            frame.push_back(traits_type::to_char_type(c));
+         }
+         return traits_type::not_eof(c);
+      }
+
+      std::streamsize xsputn( const char* s, std::streamsize n ) override {
+         frame.insert(frame.end(), s, s + n);
+         return n;
+      }
+
+   private:
+      std::vector<char>& frame;
+   };
+
+   class frame_read_buf : public std::streambuf {
+   public:
+      explicit frame_read_buf(std::function<bool(std::vector<char>&)> next)
+      :next(std::move(next)) {}
+
+   protected:
+      int_type underflow() override {
+         while (gptr() == egptr()) {
+            if (!next(frame)) {
+               return traits_type::eof();
+            }
+            setg(frame.data(), frame.data(), frame.data() + frame.size());
+         }
+         return traits_type::to_int_type(*gptr());
+      }
+
+   private:
+      std::function<bool(std::vector<char>&)> next;
+      std::vector<char>                       frame;
+   };
+
+   std::vector<char> compress_frame( const std::vector<char>& raw ) {
+      std::vector<char> out(2*sizeof(uint32_t));
+      bio::filtering_ostream comp;
+      comp.push(bio::zlib_compressor(bio::zlib::default_compression));
+      comp.push(bio::back_inserter(out));
+      bio::write(comp, raw.data(), raw.size());
+      bio::close(comp);
+
+      uint32_t compressed_size = out.size() - 2*sizeof(uint32_t);
+      uint32_t raw_size = raw.size();
+      memcpy(out.data(), &compressed_size, sizeof(compressed_size));
+      memcpy(out.data() + sizeof(compressed_size), &raw_size, sizeof(raw_size));
+      return out;
+   }
+
+   std::vector<char> decompress_frame( const std::vector<char>& compressed, uint32_t raw_size ) {
+      std::vector<char> out;
+      out.reserve(raw_size);
+      try {
+         bio::filtering_ostream decomp;
+         decomp.push(bio::zlib_decompressor());
+         decomp.push(bio::back_inserter(out));
+         bio::write(decomp, compressed.data(), compressed.size());
+         bio::close(decomp);
+      } catch( const std::exception& e ) {
+         EOS_THROW(snapshot_exception, "Compressed snapshot frame failed to decompress (${what})", ("what", e.what()));
+      }
+      EOS_ASSERT(out.size() == raw_size, snapshot_exception,
+                 "Compressed snapshot frame decompressed to ${actual} bytes, expected ${expected}",
+                 ("actual", out.size())("expected", raw_size));
+      return out;
+   }
+}
+
+compressed_ostream_snapshot_writer::compressed_ostream_snapshot_writer(std::ostream& snapshot, fc::sha256::encoder* integrity_enc,
+                                                                       uint16_t num_threads, uint32_t frame_size)
+:snapshot(snapshot)
+,header_pos(snapshot.tellp())
+,integrity_enc(integrity_enc)
+,frame_size(frame_size)
+,max_pending(2*num_threads)
+{
+   EOS_ASSERT(num_threads > 0, snapshot_exception, "Compressed snapshot writer requires at least one thread");
+   EOS_ASSERT(frame_size > 0 && frame_size <= max_snapshot_frame_size, snapshot_exception,
+              "Compressed snapshot frame size ${s} is out of range", ("s", frame_size));
+   thread_pool = std::make_unique<named_thread_pool>("snapz", num_threads);
+   frame_buf = std::make_unique<frame_write_buf>(frame);
+   frame_stream = std::make_unique<std::ostream>(frame_buf.get());
+
+   // write magic number
+   auto totem = magic_number;
+   snapshot.write((char*)&totem, sizeof(totem));
+
+   // write version
+   auto version = current_snapshot_version;
+   snapshot.write((char*)&version, sizeof(version));
+}
+
+compressed_ostream_snapshot_writer::~compressed_ostream_snapshot_writer() {
+   thread_pool->stop();
+}
+
+void compressed_ostream_snapshot_writer::write_start_section( const std::string& section_name )
+{
+   EOS_ASSERT(!in_section, snapshot_exception, "Attempting to write a new section without closing the previous section");
+   sections.push_back({section_name, static_cast<uint64_t>(snapshot.tellp() - header_pos), 0});
+   in_section = true;
+}
+
+void compressed_ostream_snapshot_writer::write_row( const detail::abstract_snapshot_row_writer& row_writer ) {
+   auto restore = frame.size();
+   try {
+      detail::ostream_wrapper out(*frame_stream);
+      row_writer.write(out);
+   } catch (...) {
+      frame.resize(restore);
+      throw;
+   }
+   sections.back().row_count++;
+
+   // rows never straddle frames, a frame may exceed frame_size by its last row
+   if (frame.size() >= frame_size) {
+      flush_frame();
+   }
+}
+
+void compressed_ostream_snapshot_writer::write_end_section( ) {
+   flush_frame();
+   write_pending_frames(0);
+
+   uint32_t end_of_section = 0;
+   snapshot.write((char*)&end_of_section, sizeof(end_of_section));
+   in_section = false;
+}
+
+void compressed_ostream_snapshot_writer::finalize() {
+   EOS_ASSERT(!in_section, snapshot_exception, "Attempting to finalize a snapshot with an open section");
+   uint64_t table_pos = snapshot.tellp() - header_pos;
+
+   uint64_t count = sections.size();
+   snapshot.write((char*)&count, sizeof(count));
+   for (const auto& s : sections) {
+      snapshot.write(s.name.data(), s.name.size());
+      snapshot.put(0);
+      snapshot.write((char*)&s.pos, sizeof(s.pos));
+      snapshot.write((char*)&s.row_count, sizeof(s.row_count));
+   }
+
+   snapshot.write((char*)&table_pos, sizeof(table_pos));
+   auto totem = magic_number;
+   snapshot.write((char*)&totem, sizeof(totem));
+}
+
+void compressed_ostream_snapshot_writer::flush_frame() {
+   if (frame.empty()) {
+      return;
+   }
+   if (integrity_enc) {
+      integrity_enc->write(frame.data(), frame.size());
+   }
+
+   write_pending_frames(max_pending - 1);
+   static auto& counters = get_thread_pool_task_counters("snapshot_compress");
+   pending.emplace_back(async_thread_pool(thread_pool->get_executor(), counters, [raw = std::move(frame)]() {
+      return compress_frame(raw);
+   }));
+   frame.clear();
+}
+
+void compressed_ostream_snapshot_writer::write_pending_frames( size_t max_remaining ) {
+   while (pending.size() > max_remaining) {
+      auto compressed = pending.front().get();
+      pending.pop_front();
+      snapshot.write(compressed.data(), compressed.size());
+   }
+}
+
+compressed_istream_snapshot_reader::compressed_istream_snapshot_reader(std::istream& snapshot, uint16_t num_threads)
+:snapshot(snapshot)
+,header_pos(snapshot.tellg())
+,max_pending(2*num_threads)
+{
+   EOS_ASSERT(num_threads > 0, snapshot_exception, "Compressed snapshot reader requires at least one thread");
+   thread_pool = std::make_unique<named_thread_pool>("snapz", num_threads);
+}
+
+compressed_istream_snapshot_reader::~compressed_istream_snapshot_reader() {
+   thread_pool->stop();
+}
+
+bool compressed_istream_snapshot_reader::is_compressed_snapshot( std::istream& snapshot ) {
+   auto restore_pos = fc::make_scoped_exit([&snapshot, pos=snapshot.tellg()](){
+      snapshot.clear();
+      snapshot.seekg(pos);
+   });
+
+   uint32_t actual_totem = 0;
+   snapshot.read((char*)&actual_totem, sizeof(actual_totem));
+   return snapshot && actual_totem == compressed_ostream_snapshot_writer::magic_number;
+}
+
+void compressed_istream_snapshot_reader::validate() const {
+   // make sure to restore the read pos
+   auto restore_pos = fc::make_scoped_exit([this,pos=snapshot.tellg(),ex=snapshot.exceptions()](){
+      snapshot.seekg(pos);
+      snapshot.exceptions(ex);
+   });
+
+   snapshot.exceptions(std::istream::failbit|std::istream::eofbit);
+
+   try {
+      snapshot.seekg(header_pos);
+
+      // validate totem
+      auto expected_totem = compressed_ostream_snapshot_writer::magic_number;
+      decltype(expected_totem) actual_totem;
+      snapshot.read((char*)&actual_totem, sizeof(actual_totem));
+      EOS_ASSERT(actual_totem == expected_totem, snapshot_exception,
+                 "Compressed snapshot has unexpected magic number!");
+
+      // validate version
+      auto expected_version = current_snapshot_version;
+      decltype(expected_version) actual_version;
+      snapshot.read((char*)&actual_version, sizeof(actual_version));
+      EOS_ASSERT(actual_version == expected_version, snapshot_exception,
+                 "Compressed snapshot is an unsuppored version.  Expected : ${expected}, Got: ${actual}",
+                 ("expected", expected_version)("actual", actual_version));
+
+      sections_loaded = false;
+      load_section_table();
+
+      // walk the frame headers of every section
+      for (const auto& s : sections) {
+         snapshot.seekg(header_pos + std::streamoff(s.pos));
+         while (true) {
+            uint32_t compressed_size = 0;
+            snapshot.read((char*)&compressed_size, sizeof(compressed_size));
+            if (compressed_size == 0) {
+               break;
+            }
+            uint32_t raw_size = 0;
+            snapshot.read((char*)&raw_size, sizeof(raw_size));
+            EOS_ASSERT(compressed_size <= max_snapshot_frame_size && raw_size <= max_snapshot_frame_size, snapshot_exception,
+                       "Compressed snapshot section ${n} has an oversized frame", ("n", s.name));
+            snapshot.seekg(snapshot.tellg() + std::streamoff(compressed_size));
+         }
+      }
+   } catch( const std::exception& e ) {
+      snapshot_exception fce(FC_LOG_MESSAGE( warn, "Compressed snapshot validation threw IO exception (${what})",("what",e.what())));
+      throw fce;
+   }
+}
+
+void compressed_istream_snapshot_reader::load_section_table() const {
+   if (sections_loaded) {
+      return;
+   }
+
+   auto restore_pos = fc::make_scoped_exit([this,pos=snapshot.tellg()](){
+      snapshot.clear();
+      snapshot.seekg(pos);
+   });
+
+   uint64_t table_pos = 0;
+   uint32_t totem = 0;
+   snapshot.seekg(-std::streamoff(sizeof(table_pos) + sizeof(totem)), std::ios::end);
+   snapshot.read((char*)&table_pos, sizeof(table_pos));
+   snapshot.read((char*)&totem, sizeof(totem));
+   EOS_ASSERT(snapshot && totem == compressed_ostream_snapshot_writer::magic_number, snapshot_exception,
+              "Compressed snapshot has a missing or corrupt section table");
+
+   snapshot.seekg(header_pos + std::streamoff(table_pos));
+   uint64_t count = 0;
+   snapshot.read((char*)&count, sizeof(count));
+
+   std::vector<detail::compressed_snapshot_section> table;
+   for (uint64_t i = 0; i < count && snapshot; ++i) {
+      detail::compressed_snapshot_section s;
+      std::getline(snapshot, s.name, '\0');
+      snapshot.read((char*)&s.pos, sizeof(s.pos));
+      snapshot.read((char*)&s.row_count, sizeof(s.row_count));
+      EOS_ASSERT(s.pos < table_pos, snapshot_exception, "Compressed snapshot section ${n} is out of bounds", ("n", s.name));
+      table.push_back(std::move(s));
+   }
+   EOS_ASSERT(snapshot, snapshot_exception, "Compressed snapshot has a truncated section table");
+
+   sections = std::move(table);
+   sections_loaded = true;
+}
+
+const detail::compressed_snapshot_section* compressed_istream_snapshot_reader::find_section( const string& section_name ) const {
+   load_section_table();
+   for (const auto& s : sections) {
+      if (s.name == section_name) {
+         return &s;
+      }
+   }
+   return nullptr;
+}
+
+bool compressed_istream_snapshot_reader::has_section( const string& section_name ) {
+   return find_section(section_name) != nullptr;
+}
+
+void compressed_istream_snapshot_reader::set_section( const string& section_name ) {
+   const auto* s = find_section(section_name);
+   EOS_ASSERT(s != nullptr, snapshot_exception, "Compressed snapshot has no section named ${n}", ("n", section_name));
+
+   clear_section();
+   snapshot.seekg(header_pos + std::streamoff(s->pos));
+   num_rows = s->row_count;
+   section_exhausted = false;
+   frame_buf = std::make_unique<frame_read_buf>([this](std::vector<char>& out) { return next_frame(out); });
+   row_stream = std::make_unique<std::istream>(frame_buf.get());
+
+   // get the first frames decompressing before the first row is requested
+   read_ahead();
+}
+
+bool compressed_istream_snapshot_reader::read_row( detail::abstract_snapshot_row_reader& row_reader ) {
+   row_reader.provide(*row_stream);
+   return ++cur_row < num_rows;
+}
+
+bool compressed_istream_snapshot_reader::empty ( ) {
+   return num_rows == 0;
+}
+
+void compressed_istream_snapshot_reader::clear_section() {
+   // outstanding decompressions only reference their own buffers
+   pending.clear();
+   section_exhausted = true;
+   row_stream.reset();
+   frame_buf.reset();
+   num_rows = 0;
+   cur_row = 0;
+}
+
+void compressed_istream_snapshot_reader::return_to_header() {
+   snapshot.seekg( header_pos );
+   clear_section();
+}
+
+void compressed_istream_snapshot_reader::read_ahead() {
+   while (!section_exhausted && pending.size() < max_pending) {
+      uint32_t compressed_size = 0;
+      snapshot.read((char*)&compressed_size, sizeof(compressed_size));
+      EOS_ASSERT(snapshot, snapshot_exception, "Compressed snapshot section is truncated");
+      if (compressed_size == 0) {
+         section_exhausted = true;
+         break;
+      }
+
+      uint32_t raw_size = 0;
+      snapshot.read((char*)&raw_size, sizeof(raw_size));
+      EOS_ASSERT(compressed_size <= max_snapshot_frame_size && raw_size <= max_snapshot_frame_size, snapshot_exception,
+                 "Compressed snapshot has an oversized frame");
+
+      std::vector<char> compressed(compressed_size);
+      snapshot.read(compressed.data(), compressed.size());
+      EOS_ASSERT(snapshot, snapshot_exception, "Compressed snapshot section is truncated");
+
+      static auto& counters = get_thread_pool_task_counters("snapshot_decompress");
+      pending.emplace_back(async_thread_pool(thread_pool->get_executor(), counters, [compressed = std::move(compressed), raw_size]() {
+         return decompress_frame(compressed, raw_size);
+      }));
+   }
+}
+
+bool compressed_istream_snapshot_reader::next_frame( std::vector<char>& out ) {
+   read_ahead();
+   if (pending.empty()) {
+      return false;
+   }
+   out = pending.front().get();
+   pending.pop_front();
+   read_ahead();
+   return true;
+}
+
+namespace {
+   const std::array<uint64_t, 256>& gear_table() {
+      static const auto table = []() {
+         // splitmix64 from a fixed seed, chunk boundaries must not change between releases
+         std::array<uint64_t, 256> t;
+         uint64_t x = 0x5eed5eed5eed5eedull;
+         for (auto& v : t) {
+            uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            v = z ^ (z >> 31);
+         }
+         return t;
+      }();
+      return table;
+   }
+
+   // top 16 bits of the gear hash, averaging 64KiB chunks
+   constexpr uint64_t chunk_boundary_mask = 0xffff000000000000ull;
+
+   const std::streamoff binary_header_size = sizeof(ostream_snapshot_writer::magic_number) + sizeof(current_snapshot_version);
+
+   struct binary_section {
+      std::streampos data_pos;
+      uint64_t       data_size = 0;
+      uint64_t       row_count = 0;
+   };
+
+   // locate a section in the ostream_snapshot_writer layout shared by binary and delta snapshots
+   std::optional<binary_section> find_binary_section( std::istream& in, std::streampos header_pos, const std::string& section_name ) {
+      auto next_section_pos = header_pos + binary_header_size;
+
+      while (true) {
+         in.seekg(next_section_pos);
+         uint64_t section_size = 0;
+         in.read((char*)&section_size,sizeof(section_size));
+         if (!in || section_size == std::numeric_limits<uint64_t>::max()) {
+            break;
+         }
+
+         next_section_pos = in.tellg() + std::streamoff(section_size);
+
+         uint64_t row_count = 0;
+         in.read((char*)&row_count,sizeof(row_count));
+
+         bool match = true;
+         for(auto c : section_name) {
+            if(in.get() != c) {
+               match = false;
+               break;
+            }
+         }
+
+         if (match && in.get() == 0) {
+            binary_section result;
+            result.data_pos = in.tellg();
+            result.data_size = section_size - sizeof(row_count) - section_name.size() - 1;
+            result.row_count = row_count;
+            return result;
+         }
+      }
+
+      in.clear();
+      return {};
+   }
+
+   void check_binary_header( std::istream& in, uint32_t expected_totem, const char* what ) {
+      uint32_t actual_totem = 0;
+      in.read((char*)&actual_totem, sizeof(actual_totem));
+      EOS_ASSERT(in && actual_totem == expected_totem, snapshot_exception, "${w} has unexpected magic number!", ("w", what));
+
+      auto expected_version = current_snapshot_version;
+      decltype(expected_version) actual_version = 0;
+      in.read((char*)&actual_version, sizeof(actual_version));
+      EOS_ASSERT(in && actual_version == expected_version, snapshot_exception,
+                 "${w} is an unsuppored version.  Expected : ${expected}, Got: ${actual}",
+                 ("w", what)("expected", expected_version)("actual", actual_version));
+   }
+
+   enum class delta_record : uint8_t {
+      end     = 0,
+      literal = 1,
+      copy    = 2
+   };
+}
+
+size_t detail::content_chunker::next( const char* data, size_t size ) {
+   const auto& gear = gear_table();
+   for (; pos < size; ++pos) {
+      hash = (hash << 1) + gear[static_cast<uint8_t>(data[pos])];
+      if ((pos + 1 >= min_chunk_size && (hash & chunk_boundary_mask) == 0) || pos + 1 >= max_chunk_size) {
+         size_t len = pos + 1;
+         pos = 0;
+         hash = 0;
+         return len;
+      }
+   }
+   return 0;
+}
+
+delta_ostream_snapshot_writer::delta_ostream_snapshot_writer(std::ostream& snapshot, std::istream& base)
+:snapshot(snapshot)
+,base(base)
+,base_header_pos(base.tellg())
+,section_pos(-1)
+,row_count(0)
+{
+   check_binary_header(base, ostream_snapshot_writer::magic_number, "Base snapshot");
+
+   pending_buf = std::make_unique<frame_write_buf>(pending);
+   pending_stream = std::make_unique<std::ostream>(pending_buf.get());
+
+   // write magic number
+   auto totem = magic_number;
+   snapshot.write((char*)&totem, sizeof(totem));
+
+   // write version
+   auto version = current_snapshot_version;
+   snapshot.write((char*)&version, sizeof(version));
+}
+
+delta_ostream_snapshot_writer::~delta_ostream_snapshot_writer() = default;
+
+void delta_ostream_snapshot_writer::write_start_section( const std::string& section_name )
+{
+   EOS_ASSERT(section_pos == std::streampos(-1), snapshot_exception, "Attempting to write a new section without closing the previous section");
+   section_pos = snapshot.tellp();
+   row_count = 0;
+
+   uint64_t placeholder = std::numeric_limits<uint64_t>::max();
+
+   // write a placeholder for the section size
+   snapshot.write((char*)&placeholder, sizeof(placeholder));
+
+   // write placeholder for row count
+   snapshot.write((char*)&placeholder, sizeof(placeholder));
+
+   // write the section name (null terminated)
+   snapshot.write(section_name.data(), section_name.size());
+   snapshot.put(0);
+
+   index_base_section(section_name);
+}
+
+void delta_ostream_snapshot_writer::write_row( const detail::abstract_snapshot_row_writer& row_writer ) {
+   auto restore = pending.size();
+   try {
+      detail::ostream_wrapper out(*pending_stream);
+      row_writer.write(out);
+   } catch (...) {
+      pending.resize(restore);
+      throw;
+   }
+   row_count++;
+   write_chunks();
+}
+
+void delta_ostream_snapshot_writer::write_end_section( ) {
+   write_chunks();
+   if (!pending.empty()) {
+      write_chunk(pending.data(), pending.size());
+      pending.clear();
+   }
+   chunker = detail::content_chunker{};
+   base_chunks.clear();
+
+   snapshot.put(static_cast<char>(delta_record::end));
+
+   auto restore = snapshot.tellp();
+
+   uint64_t section_size = restore - section_pos - sizeof(uint64_t);
+
+   snapshot.seekp(section_pos);
+
+   // write a the section size
+   snapshot.write((char*)&section_size, sizeof(section_size));
+
+   // write the row count
+   snapshot.write((char*)&row_count, sizeof(row_count));
+
+   snapshot.seekp(restore);
+
+   section_pos = std::streampos(-1);
+   row_count = 0;
+}
+
+void delta_ostream_snapshot_writer::finalize() {
+   uint64_t end_marker = std::numeric_limits<uint64_t>::max();
+   snapshot.write((char*)&end_marker, sizeof(end_marker));
+}
+
+void delta_ostream_snapshot_writer::index_base_section( const std::string& section_name ) {
+   base_chunks.clear();
+   auto section = find_binary_section(base, base_header_pos, section_name);
+   if (!section) {
+      return;
+   }
+
+   base.seekg(section->data_pos);
+
+   constexpr uint64_t read_size = 1024*1024;
+   detail::content_chunker base_chunker;
+   std::vector<char> buf;
+   uint64_t chunk_pos = 0;
+   uint64_t remaining = section->data_size;
+
+   auto add_chunk = [&](const char* data, size_t size) {
+      base_chunks.emplace(fc::sha256::hash(data, size), base_chunk{chunk_pos, static_cast<uint32_t>(size)});
+      chunk_pos += size;
+   };
+
+   while (remaining > 0) {
+      auto n = std::min(read_size, remaining);
+      auto offset = buf.size();
+      buf.resize(offset + n);
+      base.read(buf.data() + offset, n);
+      EOS_ASSERT(base, snapshot_exception, "Base snapshot section ${n} is truncated", ("n", section_name));
+      remaining -= n;
+
+      size_t start = 0;
+      while (auto len = base_chunker.next(buf.data() + start, buf.size() - start)) {
+         add_chunk(buf.data() + start, len);
+         start += len;
+      }
+      buf.erase(buf.begin(), buf.begin() + start);
+   }
+   if (!buf.empty()) {
+      add_chunk(buf.data(), buf.size());
+   }
+}
+
+void delta_ostream_snapshot_writer::write_chunks() {
+   size_t start = 0;
+   while (auto len = chunker.next(pending.data() + start, pending.size() - start)) {
+      write_chunk(pending.data() + start, len);
+      start += len;
+   }
+   if (start > 0) {
+      pending.erase(pending.begin(), pending.begin() + start);
+   }
+}
+
+void delta_ostream_snapshot_writer::write_chunk( const char* data, size_t size ) {
+   auto digest = fc::sha256::hash(data, size);
+   auto itr = base_chunks.find(digest);
+   uint32_t chunk_size = size;
+   if (itr != base_chunks.end() && itr->second.size == chunk_size) {
+      snapshot.put(static_cast<char>(delta_record::copy));
+      snapshot.write((char*)&itr->second.pos, sizeof(itr->second.pos));
+      snapshot.write((char*)&chunk_size, sizeof(chunk_size));
+      uint64_t check = digest._hash[0];
+      snapshot.write((char*)&check, sizeof(check));
+   } else {
+      snapshot.put(static_cast<char>(delta_record::literal));
+      snapshot.write((char*)&chunk_size, sizeof(chunk_size));
+      snapshot.write(data, size);
+   }
+}
+
+delta_istream_snapshot_reader::delta_istream_snapshot_reader(std::istream& snapshot, std::istream& base)
+:snapshot(snapshot)
+,base(base)
+,header_pos(snapshot.tellg())
+,base_header_pos(base.tellg())
+{
+}
+
+delta_istream_snapshot_reader::~delta_istream_snapshot_reader() = default;
+
+bool delta_istream_snapshot_reader::is_delta_snapshot( std::istream& snapshot ) {
+   auto restore_pos = fc::make_scoped_exit([&snapshot, pos=snapshot.tellg()](){
+      snapshot.clear();
+      snapshot.seekg(pos);
+   });
+
+   uint32_t actual_totem = 0;
+   snapshot.read((char*)&actual_totem, sizeof(actual_totem));
+   return snapshot && actual_totem == delta_ostream_snapshot_writer::magic_number;
+}
+
+void delta_istream_snapshot_reader::validate() const {
+   // make sure to restore the read pos
+   auto restore_pos = fc::make_scoped_exit([this,pos=snapshot.tellg(),ex=snapshot.exceptions(),base_pos=base.tellg()](){
+      snapshot.seekg(pos);
+      snapshot.exceptions(ex);
+      base.clear();
+      base.seekg(base_pos);
+   });
+
+   snapshot.exceptions(std::istream::failbit|std::istream::eofbit);
+
+   try {
+      snapshot.seekg(header_pos);
+      check_binary_header(snapshot, delta_ostream_snapshot_writer::magic_number, "Delta snapshot");
+
+      base.seekg(base_header_pos);
+      check_binary_header(base, ostream_snapshot_writer::magic_number, "Base snapshot");
+
+      while (true) {
+         uint64_t section_size = 0;
+         snapshot.read((char*)&section_size,sizeof(section_size));
+
+         // stop when we see the end marker
+         if (section_size == std::numeric_limits<uint64_t>::max()) {
+            break;
+         }
+
+         // seek past the section
+         snapshot.seekg(snapshot.tellg() + std::streamoff(section_size));
+      }
+   } catch( const std::exception& e ) {
+      snapshot_exception fce(FC_LOG_MESSAGE( warn, "Delta snapshot validation threw IO exception (${what})",("what",e.what())));
+      throw fce;
+   }
+}
+
+bool delta_istream_snapshot_reader::has_section( const string& section_name ) {
+   auto restore_pos = fc::make_scoped_exit([this,pos=snapshot.tellg()](){
+      snapshot.seekg(pos);
+   });
+
+   return find_binary_section(snapshot, header_pos, section_name).has_value();
+}
+
+void delta_istream_snapshot_reader::set_section( const string& section_name ) {
+   clear_section();
+
+   auto section = find_binary_section(snapshot, header_pos, section_name);
+   EOS_ASSERT(section, snapshot_exception, "Delta snapshot has no section named ${n}", ("n", section_name));
+
+   auto base_section = find_binary_section(base, base_header_pos, section_name);
+   base_data_pos = base_section ? base_section->data_pos : std::streampos(0);
+   base_data_size = base_section ? base_section->data_size : 0;
+
+   snapshot.seekg(section->data_pos);
+   num_rows = section->row_count;
+   section_done = false;
+   chunk_buf = std::make_unique<frame_read_buf>([this](std::vector<char>& out) { return next_chunk(out); });
+   row_stream = std::make_unique<std::istream>(chunk_buf.get());
+}
+
+bool delta_istream_snapshot_reader::read_row( detail::abstract_snapshot_row_reader& row_reader ) {
+   row_reader.provide(*row_stream);
+   return ++cur_row < num_rows;
+}
+
+bool delta_istream_snapshot_reader::empty ( ) {
+   return num_rows == 0;
+}
+
+void delta_istream_snapshot_reader::clear_section() {
+   section_done = true;
+   row_stream.reset();
+   chunk_buf.reset();
+   num_rows = 0;
+   cur_row = 0;
+}
+
+void delta_istream_snapshot_reader::return_to_header() {
+   snapshot.seekg( header_pos );
+   clear_section();
+}
+
+bool delta_istream_snapshot_reader::next_chunk( std::vector<char>& out ) {
+   if (section_done) {
+      return false;
+   }
+
+   auto kind = static_cast<delta_record>(snapshot.get());
+   EOS_ASSERT(snapshot, snapshot_exception, "Delta snapshot section is truncated");
+
+   uint32_t size = 0;
+   switch (kind) {
+      case delta_record::end:
+         section_done = true;
+         return false;
+
+      case delta_record::literal:
+         snapshot.read((char*)&size, sizeof(size));
+         EOS_ASSERT(size <= detail::content_chunker::max_chunk_size, snapshot_exception, "Delta snapshot has an oversized chunk");
+         out.resize(size);
+         snapshot.read(out.data(), size);
+         EOS_ASSERT(snapshot, snapshot_exception, "Delta snapshot section is truncated");
+         return true;
+
+      case delta_record::copy: {
+         uint64_t pos = 0;
+         uint64_t check = 0;
+         snapshot.read((char*)&pos, sizeof(pos));
+         snapshot.read((char*)&size, sizeof(size));
+         snapshot.read((char*)&check, sizeof(check));
+         EOS_ASSERT(snapshot, snapshot_exception, "Delta snapshot section is truncated");
+         EOS_ASSERT(size <= detail::content_chunker::max_chunk_size && pos + size <= base_data_size, snapshot_exception,
+                    "Delta snapshot references data outside of its base snapshot");
+
+         out.resize(size);
+         base.seekg(base_data_pos + std::streamoff(pos));
+         base.read(out.data(), size);
+         EOS_ASSERT(base && fc::sha256::hash(out.data(), size)._hash[0] == check, snapshot_exception,
+                    "Delta snapshot does not match its base snapshot");
+         return true;
+      }
+   }
+
+   EOS_THROW(snapshot_exception, "Delta snapshot has an unknown chunk type ${t}", ("t", static_cast<uint32_t>(kind)));
+}
+
 }}
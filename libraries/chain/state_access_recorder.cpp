@@ -0,0 +1,143 @@
+#include <eosio/chain/state_access_recorder.hpp>
+#include <eosio/chain/exceptions.hpp>
+#include <fc/io/json.hpp>
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <string_view>
+
+namespace eosio { namespace chain {
+
+namespace {
+   void append_big_endian( std::string& s, uint64_t v ) {
+      for( int shift = 56; shift >= 0; shift -= 8 ) {
+         s.push_back( static_cast<char>( (v >> shift) & 0xff ) );
+      }
+   }
+
+   template<typename Container>
+   void sort_unique( Container& c ) {
+      std::sort( c.begin(), c.end() );
+      c.erase( std::unique( c.begin(), c.end() ), c.end() );
+   }
+
+   bool starts_with( std::string_view s, std::string_view prefix ) {
+      return s.size() >= prefix.size() && s.compare( 0, prefix.size(), prefix ) == 0;
+   }
+}
+
+std::string transaction_state_accesses::db_table_prefix( name code, name scope, name table ) {
+   std::string k;
+   k.reserve( 1 + 4*sizeof(uint64_t) );
+   k.push_back( 'd' );
+   append_big_endian( k, code.to_uint64_t() );
+   append_big_endian( k, scope.to_uint64_t() );
+   append_big_endian( k, table.to_uint64_t() );
+   return k;
+}
+
+std::string transaction_state_accesses::db_row_key( name code, name scope, name table, uint64_t primary_key ) {
+   std::string k = db_table_prefix( code, scope, table );
+   append_big_endian( k, primary_key );
+   return k;
+}
+
+std::string transaction_state_accesses::kv_key( name contract, const char* key, uint32_t key_size ) {
+   std::string k;
+   k.reserve( 1 + sizeof(uint64_t) + key_size );
+   k.push_back( 'k' );
+   append_big_endian( k, contract.to_uint64_t() );
+   k.append( key, key_size );
+   return k;
+}
+
+void transaction_state_accesses::normalize() {
+   sort_unique( reads );
+   sort_unique( range_reads );
+   sort_unique( writes );
+}
+
+state_access_recorder::state_access_recorder( const fc::path& output_file )
+: _out( output_file.generic_string(), std::ios::out | std::ios::app )
+{
+   EOS_ASSERT( _out.good(), misc_exception, "unable to open state access log ${f}", ("f", output_file.generic_string()) );
+}
+
+block_conflict_graph state_access_recorder::build_conflict_graph( uint32_t block_num, const block_id_type& id,
+                                                                  const vector<recorded_transaction>& trxs ) {
+   block_conflict_graph g;
+   g.block_num = block_num;
+   g.id = id;
+   g.trxs.reserve( trxs.size() );
+
+   // Only the latest writer of a key and the readers since then are tracked, dependencies on earlier
+   // accesses follow transitively through the latest writer.
+   struct key_state {
+      std::optional<uint32_t> last_writer;
+      vector<uint32_t>        readers;
+   };
+   std::map<std::string, key_state, std::less<>>        keys;
+   std::map<std::string, vector<uint32_t>, std::less<>> range_readers;
+   vector<uint32_t> chain_length( trxs.size(), 0 );
+   vector<uint32_t> deps;
+
+   for( uint32_t i = 0; i < trxs.size(); ++i ) {
+      const auto& [trx_id, accesses] = trxs[i];
+      g.trxs.push_back( trx_id );
+      deps.clear();
+
+      for( const auto& k : accesses.reads ) {
+         auto itr = keys.find( k );
+         if( itr != keys.end() && itr->second.last_writer ) deps.push_back( *itr->second.last_writer );
+      }
+      for( const auto& p : accesses.range_reads ) {
+         for( auto itr = keys.lower_bound( p ); itr != keys.end() && starts_with( itr->first, p ); ++itr ) {
+            if( itr->second.last_writer ) deps.push_back( *itr->second.last_writer );
+         }
+      }
+      for( const auto& k : accesses.writes ) {
+         auto itr = keys.find( k );
+         if( itr != keys.end() ) {
+            if( itr->second.last_writer ) deps.push_back( *itr->second.last_writer );
+            deps.insert( deps.end(), itr->second.readers.begin(), itr->second.readers.end() );
+         }
+         if( !range_readers.empty() ) {
+            const std::string_view kv( k );
+            for( size_t len = 0; len <= kv.size(); ++len ) {
+               auto ritr = range_readers.find( kv.substr( 0, len ) );
+               if( ritr != range_readers.end() ) deps.insert( deps.end(), ritr->second.begin(), ritr->second.end() );
+            }
+         }
+      }
+
+      sort_unique( deps );
+      for( uint32_t d : deps ) {
+         g.edges.emplace_back( d, i );
+         chain_length[i] = std::max( chain_length[i], chain_length[d] );
+      }
+      ++chain_length[i];
+      g.longest_chain = std::max( g.longest_chain, chain_length[i] );
+
+      for( const auto& k : accesses.reads ) {
+         keys[k].readers.push_back( i );
+      }
+      for( const auto& p : accesses.range_reads ) {
+         range_readers[p].push_back( i );
+      }
+      for( const auto& k : accesses.writes ) {
+         auto& ks = keys[k];
+         ks.last_writer = i;
+         ks.readers.clear();
+      }
+   }
+
+   return g;
+}
+
+void state_access_recorder::write_block( uint32_t block_num, const block_id_type& id, const vector<recorded_transaction>& trxs ) {
+   _out << fc::json::to_string( build_conflict_graph( block_num, id, trxs ), fc::time_point::maximum() ) << '\n';
+   _out.flush();
+}
+
+} } // eosio::chain
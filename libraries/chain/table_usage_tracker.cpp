@@ -0,0 +1,51 @@
+#include <eosio/chain/table_usage_tracker.hpp>
+
+namespace eosio { namespace chain {
+
+table_usage_tracker::table_usage_tracker( usage_map baseline, bool has_baseline )
+: _has_baseline( has_baseline )
+, _tables( std::move( baseline ) )
+{}
+
+void table_usage_tracker::commit_block( uint32_t block_num, const vector<table_usage_deltas>& trxs, uint32_t last_irreversible_block_num ) {
+   table_usage_deltas block;
+   for( const auto& trx : trxs ) {
+      for( const auto& [key, usage] : trx )
+         block[key] += usage;
+   }
+
+   std::lock_guard<std::mutex> g( _mtx );
+   for( const auto& [key, usage] : block ) {
+      auto& t = _tables[key];
+      t += usage;
+      if( t.rows == 0 && t.bytes == 0 ) _tables.erase( key );
+   }
+   _reversible.emplace_back( block_num, std::move( block ) );
+   while( !_reversible.empty() && _reversible.front().first <= last_irreversible_block_num )
+      _reversible.pop_front();
+   _head_block_num = block_num;
+}
+
+void table_usage_tracker::pop_block( uint32_t block_num ) {
+   std::lock_guard<std::mutex> g( _mtx );
+   if( _reversible.empty() || _reversible.back().first != block_num ) return;
+   for( const auto& [key, usage] : _reversible.back().second ) {
+      auto& t = _tables[key];
+      t -= usage;
+      if( t.rows == 0 && t.bytes == 0 ) _tables.erase( key );
+   }
+   _reversible.pop_back();
+   _head_block_num = block_num - 1;
+}
+
+table_usage_tracker::usage_map table_usage_tracker::get_tables()const {
+   std::lock_guard<std::mutex> g( _mtx );
+   return _tables;
+}
+
+uint32_t table_usage_tracker::head_block_num()const {
+   std::lock_guard<std::mutex> g( _mtx );
+   return _head_block_num;
+}
+
+} } // eosio::chain
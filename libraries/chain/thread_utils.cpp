@@ -1,5 +1,11 @@
 #include <eosio/chain/thread_utils.hpp>
 #include <fc/log/logger_config.hpp>
+#include <fc/log/logger.hpp>
+#include <algorithm>
+#include <map>
+#ifdef __linux__
+#include <pthread.h>
+#endif
 
 namespace eosio { namespace chain {
 
@@ -7,15 +13,28 @@ namespace eosio { namespace chain {
 //
 // named_thread_pool
 //
-named_thread_pool::named_thread_pool( std::string name_prefix, size_t num_threads )
+named_thread_pool::named_thread_pool( std::string name_prefix, size_t num_threads, const std::vector<uint16_t>& cpus )
 : _thread_pool( num_threads )
 , _ioc( num_threads )
 {
    _ioc_work.emplace( boost::asio::make_work_guard( _ioc ) );
    for( size_t i = 0; i < num_threads; ++i ) {
-      boost::asio::post( _thread_pool, [&ioc = _ioc, name_prefix, i]() {
+      std::optional<uint16_t> cpu;
+      if( !cpus.empty() ) cpu = cpus[i % cpus.size()];
+      boost::asio::post( _thread_pool, [&ioc = _ioc, name_prefix, i, cpu]() {
          std::string tn = name_prefix + "-" + std::to_string( i );
          fc::set_os_thread_name( tn );
+         if( cpu ) {
+#ifdef __linux__
+            cpu_set_t set;
+            CPU_ZERO( &set );
+            CPU_SET( *cpu, &set );
+            if( pthread_setaffinity_np( pthread_self(), sizeof( set ), &set ) != 0 )
+               wlog( "Unable to pin thread ${t} to cpu ${c}", ("t", tn)("c", *cpu) );
+#else
+            wlog( "Thread cpu affinity is not supported on this platform, thread ${t} is not pinned", ("t", tn) );
+#endif
+         }
          ioc.run();
       } );
    }
@@ -32,5 +51,65 @@ void named_thread_pool::stop() {
    _thread_pool.stop();
 }
 
+//
+// bounded_serial_executor
+//
+bounded_serial_executor::bounded_serial_executor( std::string name, size_t max_queued )
+: _max_queued( std::max<size_t>( max_queued, 1 ) )
+, _thread_pool( std::move( name ), 1 )
+{
+}
+
+bounded_serial_executor::~bounded_serial_executor() {
+   stop();
+}
+
+void bounded_serial_executor::drain() {
+   std::unique_lock<std::mutex> g( _mtx );
+   _cv.wait( g, [this]() { return _queued == 0; } );
+}
+
+void bounded_serial_executor::stop() {
+   drain();
+   _thread_pool.stop();
+}
+
+size_t bounded_serial_executor::queued() {
+   std::lock_guard<std::mutex> g( _mtx );
+   return _queued;
+}
+
+void bounded_serial_executor::task_done() {
+   {
+      std::lock_guard<std::mutex> g( _mtx );
+      --_queued;
+   }
+   _cv.notify_all();
+}
+
+//
+// thread pool task counters
+//
+namespace {
+   std::mutex                                                       task_counters_mtx;
+   std::map<std::string, std::unique_ptr<thread_pool_task_counters>> task_counters;
+}
+
+thread_pool_task_counters& get_thread_pool_task_counters( const std::string& task_type ) {
+   std::lock_guard<std::mutex> g( task_counters_mtx );
+   auto& c = task_counters[task_type];
+   if( !c ) c = std::make_unique<thread_pool_task_counters>();
+   return *c;
+}
+
+std::vector<thread_pool_task_metrics> get_thread_pool_task_metrics() {
+   std::vector<thread_pool_task_metrics> result;
+   std::lock_guard<std::mutex> g( task_counters_mtx );
+   result.reserve( task_counters.size() );
+   for( const auto& [task_type, c] : task_counters ) {
+      result.push_back( { task_type, c->queued.load(), c->running.load(), c->completed.load(), c->wait_us.load(), c->run_us.load() } );
+   }
+   return result;
+}
 
 } } // eosio::chain
\ No newline at end of file
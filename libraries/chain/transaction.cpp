@@ -1,6 +1,8 @@
 #include <fc/io/raw.hpp>
 #include <fc/bitutil.hpp>
 #include <algorithm>
+#include <utility>
+#include <vector>
 
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
@@ -10,6 +12,7 @@
 #include <eosio/chain/config.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/transaction.hpp>
+#include <eosio/chain/recovered_key_cache.hpp>
 
 namespace eosio { namespace chain {
 
@@ -58,7 +61,8 @@ digest_type transaction::sig_digest( const chain_id_type& chain_id, const vector
 
 fc::microseconds transaction::get_signature_keys( const vector<signature_type>& signatures,
       const chain_id_type& chain_id, fc::time_point deadline, const vector<bytes>& cfd,
-      flat_set<public_key_type>& recovered_pub_keys, bool allow_duplicate_keys)const
+      flat_set<public_key_type>& recovered_pub_keys, bool allow_duplicate_keys,
+      recovered_key_cache* key_cache)const
 { try {
    auto start = fc::time_point::now();
    recovered_pub_keys.clear();
@@ -68,7 +72,8 @@ fc::microseconds transaction::get_signature_keys( const vector<signature_type>&
       auto now = fc::time_point::now();
       EOS_ASSERT( now < deadline, tx_cpu_usage_exceeded, "transaction signature verification executed for too long ${time}us",
                   ("time", now - start)("now", now)("deadline", deadline)("start", start) );
-      auto[ itr, successful_insertion ] = recovered_pub_keys.emplace( sig, digest );
+      auto[ itr, successful_insertion ] = key_cache ? recovered_pub_keys.emplace( key_cache->recover( sig, digest ) )
+                                                    : recovered_pub_keys.emplace( sig, digest );
       EOS_ASSERT( allow_duplicate_keys || successful_insertion, tx_duplicate_sig,
                   "transaction includes more than one signature signed using the same key associated with public key: ${key}",
                   ("key", *itr ) );
@@ -189,12 +194,71 @@ static transaction unpack_transaction(const bytes& data) {
    return fc::raw::unpack<transaction>(data);
 }
 
+/**
+ * Allocator which keeps the blocks freed on a thread for the allocations of the same size which follow on it. zlib's
+ * inflate state and window and the filter's buffer are the same size for every transaction, so decompressing one
+ * reuses the memory of the previous decompression on the thread instead of allocating about 40KiB again.
+ */
+template<typename T>
+struct thread_pooled_allocator {
+   using value_type      = T;
+   using size_type       = std::size_t;
+   using difference_type = std::ptrdiff_t;
+   using pointer         = T*;
+   using const_pointer   = const T*;
+   using reference       = T&;
+   using const_reference = const T&;
+   template<typename U> struct rebind { using other = thread_pooled_allocator<U>; };
+
+   thread_pooled_allocator() = default;
+   template<typename U> thread_pooled_allocator(const thread_pooled_allocator<U>&) {}
+
+   T* allocate(size_type n) {
+      auto& blocks = free_blocks();
+      const size_t size = n * sizeof(T);
+      for( auto itr = blocks.begin(); itr != blocks.end(); ++itr ) {
+         if( itr->first == size ) {
+            void* p = itr->second;
+            blocks.erase(itr);
+            return static_cast<T*>(p);
+         }
+      }
+      return static_cast<T*>(::operator new(size));
+   }
+   T* allocate(size_type n, const void*) { return allocate(n); }
+
+   void deallocate(T* p, size_type n) {
+      auto& blocks = free_blocks();
+      if( blocks.size() < max_free_blocks )
+         blocks.emplace_back(n * sizeof(T), p);
+      else
+         ::operator delete(p);
+   }
+
+   template<typename U> bool operator==(const thread_pooled_allocator<U>&) const { return true; }
+   template<typename U> bool operator!=(const thread_pooled_allocator<U>&) const { return false; }
+
+private:
+   static constexpr size_t max_free_blocks = 8;
+
+   struct block_list : std::vector<std::pair<size_t, void*>> {
+      ~block_list() { for( auto& b : *this ) ::operator delete(b.second); }
+   };
+
+   static block_list& free_blocks() {
+      thread_local block_list blocks;
+      return blocks;
+   }
+};
+
 static bytes zlib_decompress(const bytes& data) {
+   constexpr size_t limit = 1*1024*1024; // limit to 1 meg decompressed for zip bomb protections
    try {
       bytes out;
+      out.reserve(std::min(data.size() * 4, limit));
       bio::filtering_ostream decomp;
-      decomp.push(bio::zlib_decompressor());
-      decomp.push(read_limiter<1*1024*1024>()); // limit to 1 meg decompressed for zip bomb protections
+      decomp.push(bio::basic_zlib_decompressor<thread_pooled_allocator<char>>());
+      decomp.push(read_limiter<limit>());
       decomp.push(bio::back_inserter(out));
       bio::write(decomp, data.data(), data.size());
       bio::close(decomp);
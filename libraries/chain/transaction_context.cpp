@@ -285,6 +285,7 @@ namespace eosio { namespace chain {
       EOS_ASSERT( is_initialized, transaction_exception, "must first initialize" );
 
       const transaction& trx = packed_trx.get_transaction();
+      trace->action_traces.reserve( trx.context_free_actions.size() + trx.actions.size() );
       if( apply_context_free ) {
          for( const auto& act : trx.context_free_actions ) {
             schedule_action( act, act.account, true, 0, 0 );
@@ -321,6 +322,7 @@ namespace eosio { namespace chain {
          }
       }
 
+      flush_ram_usage();
       auto& rl = control.get_mutable_resource_limits_manager();
       for( auto a : validate_ram_usage ) {
          rl.verify_account_ram_usage( a );
@@ -522,13 +524,32 @@ namespace eosio { namespace chain {
    }
 
    void transaction_context::add_ram_usage( account_name account, int64_t ram_delta, const storage_usage_trace& trace ) {
-      auto& rl = control.get_mutable_resource_limits_manager();
-      rl.add_pending_ram_usage( account, ram_delta, trace );
+      if( control.get_deep_mind_logger() ) {
+         // every delta is applied, and logged, with its trace
+         auto& rl = control.get_mutable_resource_limits_manager();
+         rl.add_pending_ram_usage( account, ram_delta, trace );
+      } else if( ram_delta != 0 ) {
+         // rows emplaced one by one in an action are applied as a single modify of the usage of their payer
+         auto& p = pending_ram_deltas[account];
+         p.delta += ram_delta;
+         p.min_delta = std::min( p.min_delta, p.delta );
+         p.max_delta = std::max( p.max_delta, p.delta );
+      }
       if( ram_delta > 0 ) {
          validate_ram_usage.insert( account );
       }
    }
 
+   void transaction_context::flush_ram_usage() {
+      if( pending_ram_deltas.empty() ) return;
+      auto deltas = std::move( pending_ram_deltas );
+      pending_ram_deltas.clear();
+      auto& rl = control.get_mutable_resource_limits_manager();
+      for( const auto& [account, p] : deltas ) {
+         rl.add_pending_ram_usage( account, p.delta, p.min_delta, p.max_delta );
+      }
+   }
+
    uint32_t transaction_context::update_billed_cpu_time( fc::time_point now ) {
       if( explicit_billed_cpu_time ) return static_cast<uint32_t>(billed_cpu_time_us);
 
@@ -559,14 +580,15 @@ namespace eosio { namespace chain {
                greylist_limit = specified_greylist_limit;
             }
          }
-         auto [net_limit, net_was_greylisted] = rl.get_account_net_limit(a, greylist_limit);
-         if( net_limit >= 0 ) {
-            account_net_limit = std::min( account_net_limit, net_limit );
+         const auto limits = rl.get_account_bandwidth_limits_ex(a, greylist_limit);
+         auto [net_limit, net_was_greylisted] = limits.net;
+         if( net_limit.available >= 0 ) {
+            account_net_limit = std::min( account_net_limit, net_limit.available );
             greylisted_net |= net_was_greylisted;
          }
-         auto [cpu_limit, cpu_was_greylisted] = rl.get_account_cpu_limit(a, greylist_limit);
-         if( cpu_limit >= 0 ) {
-            account_cpu_limit = std::min( account_cpu_limit, cpu_limit );
+         auto [cpu_limit, cpu_was_greylisted] = limits.cpu;
+         if( cpu_limit.available >= 0 ) {
+            account_cpu_limit = std::min( account_cpu_limit, cpu_limit.available );
             greylisted_cpu |= cpu_was_greylisted;
          }
       }
@@ -627,7 +649,11 @@ namespace eosio { namespace chain {
    {
       uint32_t new_action_ordinal = trace->action_traces.size() + 1;
 
-      trace->action_traces.reserve( new_action_ordinal );
+      // grow geometrically, reserving exactly one more for every notification would reallocate all traces each time
+      auto& action_traces = trace->action_traces;
+      if( action_traces.capacity() < new_action_ordinal ) {
+         action_traces.reserve( std::max<size_t>( new_action_ordinal, 2 * action_traces.capacity() ) );
+      }
 
       const action& provided_action = get_action_trace( action_ordinal ).act;
 
@@ -654,6 +680,21 @@ namespace eosio { namespace chain {
       acontext.exec();
    }
 
+   std::unique_ptr<apply_context_buffers> transaction_context::acquire_apply_context_buffers() {
+      if( free_apply_context_buffers.empty() ) {
+         return std::make_unique<apply_context_buffers>();
+      }
+      auto buffers = std::move( free_apply_context_buffers.back() );
+      free_apply_context_buffers.pop_back();
+      return buffers;
+   }
+
+   void transaction_context::release_apply_context_buffers( std::unique_ptr<apply_context_buffers> buffers ) {
+      if( !buffers ) return;
+      buffers->clear();
+      free_apply_context_buffers.emplace_back( std::move( buffers ) );
+   }
+
 
    void transaction_context::schedule_transaction() {
       // Charge ahead of time for the additional net usage needed to retire the delayed transaction
@@ -1,30 +1,83 @@
 #include <eosio/chain/transaction_metadata.hpp>
 #include <eosio/chain/thread_utils.hpp>
 #include <boost/asio/thread_pool.hpp>
+#include <algorithm>
 
 namespace eosio { namespace chain {
 
+transaction_metadata_ptr transaction_metadata::recover_keys( packed_transaction_ptr trx,
+                                                             const chain_id_type& chain_id,
+                                                             fc::microseconds time_limit,
+                                                             uint32_t max_variable_sig_size,
+                                                             recovered_key_cache* key_cache )
+{
+   fc::time_point deadline = time_limit == fc::microseconds::maximum() ?
+                             fc::time_point::maximum() : fc::time_point::now() + time_limit;
+   const vector<signature_type>& sigs = check_variable_sig_size( trx, max_variable_sig_size );
+   const vector<bytes>* context_free_data = trx->get_context_free_data();
+   EOS_ASSERT( context_free_data, tx_no_context_free_data, "context free data pruned from packed_transaction" );
+   flat_set<public_key_type> recovered_pub_keys;
+   const bool allow_duplicate_keys = false;
+   fc::microseconds cpu_usage =
+         trx->get_transaction().get_signature_keys(sigs, chain_id, deadline, *context_free_data, recovered_pub_keys, allow_duplicate_keys, key_cache);
+   return std::make_shared<transaction_metadata>( private_type(), std::move( trx ), cpu_usage, std::move( recovered_pub_keys ) );
+}
+
 recover_keys_future transaction_metadata::start_recover_keys( packed_transaction_ptr trx,
                                                               boost::asio::io_context& thread_pool,
                                                               const chain_id_type& chain_id,
                                                               fc::microseconds time_limit,
-                                                              uint32_t max_variable_sig_size )
+                                                              uint32_t max_variable_sig_size,
+                                                              recovered_key_cache* key_cache )
 {
-   return async_thread_pool( thread_pool, [trx{std::move(trx)}, chain_id, time_limit, max_variable_sig_size]() mutable {
-         fc::time_point deadline = time_limit == fc::microseconds::maximum() ?
-                                   fc::time_point::maximum() : fc::time_point::now() + time_limit;
-         const vector<signature_type>& sigs = check_variable_sig_size( trx, max_variable_sig_size );
-         const vector<bytes>* context_free_data = trx->get_context_free_data();
-         EOS_ASSERT( context_free_data, tx_no_context_free_data, "context free data pruned from packed_transaction" );
-         flat_set<public_key_type> recovered_pub_keys;
-         const bool allow_duplicate_keys = false;
-         fc::microseconds cpu_usage =
-               trx->get_transaction().get_signature_keys(sigs, chain_id, deadline, *context_free_data, recovered_pub_keys, allow_duplicate_keys);
-         return std::make_shared<transaction_metadata>( private_type(), std::move( trx ), cpu_usage, std::move( recovered_pub_keys ) );
+   static auto& counters = get_thread_pool_task_counters( "recover_keys" );
+   return async_thread_pool( thread_pool, counters, [trx{std::move(trx)}, chain_id, time_limit, max_variable_sig_size, key_cache]() mutable {
+         return recover_keys( std::move( trx ), chain_id, time_limit, max_variable_sig_size, key_cache );
       }
    );
 }
 
+std::vector<recover_keys_future> transaction_metadata::start_recover_keys( std::vector<packed_transaction_ptr> trxs,
+                                                                           boost::asio::io_context& thread_pool,
+                                                                           const chain_id_type& chain_id,
+                                                                           fc::microseconds time_limit,
+                                                                           size_t num_jobs,
+                                                                           uint32_t max_variable_sig_size,
+                                                                           recovered_key_cache* key_cache )
+{
+   using batch_type = std::vector<std::pair<packed_transaction_ptr, std::promise<transaction_metadata_ptr>>>;
+
+   std::vector<recover_keys_future> result;
+   if( trxs.empty() ) return result;
+   result.reserve( trxs.size() );
+
+   num_jobs = std::clamp<size_t>( num_jobs, 1, trxs.size() );
+   std::vector<std::shared_ptr<batch_type>> batches( num_jobs );
+   for( auto& batch : batches ) {
+      batch = std::make_shared<batch_type>();
+      batch->reserve( trxs.size() / num_jobs + 1 );
+   }
+   for( size_t i = 0; i < trxs.size(); ++i ) {
+      auto& batch = *batches[i % num_jobs];
+      batch.emplace_back( std::move( trxs[i] ), std::promise<transaction_metadata_ptr>() );
+      result.emplace_back( batch.back().second.get_future() );
+   }
+
+   static auto& counters = get_thread_pool_task_counters( "recover_keys_batch" );
+   for( auto& batch : batches ) {
+      boost::asio::post( thread_pool, detail::counted_task( counters, [batch{std::move(batch)}, chain_id, time_limit, max_variable_sig_size, key_cache]() {
+         for( auto& [trx, promise] : *batch ) {
+            try {
+               promise.set_value( recover_keys( std::move( trx ), chain_id, time_limit, max_variable_sig_size, key_cache ) );
+            } catch( ... ) {
+               promise.set_exception( std::current_exception() );
+            }
+         }
+      } ) );
+   }
+   return result;
+}
+
 uint32_t transaction_metadata::get_estimated_size() const {
    return sizeof(*this) + _recovered_pub_keys.size() * sizeof(public_key_type) + packed_trx()->get_estimated_size();
 }
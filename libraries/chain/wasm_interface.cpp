@@ -38,17 +38,17 @@ namespace eosio { namespace chain {
 
    wasm_interface::~wasm_interface() {}
 
-   void wasm_interface::validate(const controller& control, const bytes& code) {
+   void wasm_interface::validate(const controller& control, const char* code, size_t code_size) {
       const auto& pso = control.db().get<protocol_state_object>();
 
       if (control.is_builtin_activated(builtin_protocol_feature_t::configurable_wasm_limits)) {
          const auto& gpo = control.get_global_properties();
-         webassembly::eos_vm_runtime::validate( code, gpo.wasm_configuration, pso.whitelisted_intrinsics );
+         webassembly::eos_vm_runtime::validate( code, code_size, gpo.wasm_configuration, pso.whitelisted_intrinsics );
          return;
       }
       Module module;
       try {
-         Serialization::MemoryInputStream stream((U8*)code.data(), code.size());
+         Serialization::MemoryInputStream stream((const U8*)code, code_size);
          WASM::serialize(stream, module);
       } catch(const Serialization::FatalSerializationException& e) {
          EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
@@ -59,7 +59,7 @@ namespace eosio { namespace chain {
       wasm_validations::wasm_binary_validation validator(control, module);
       validator.validate();
 
-      webassembly::eos_vm_runtime::validate( code, pso.whitelisted_intrinsics );
+      webassembly::eos_vm_runtime::validate( code, code_size, pso.whitelisted_intrinsics );
 
       //there are a couple opportunties for improvement here--
       //Easy: Cache the Module created here so it can be reused for instantiaion
@@ -97,11 +97,30 @@ namespace eosio { namespace chain {
             my->eosvmoc->exec.execute(*cd, my->eosvmoc->mem, context);
             return;
          }
+
+         const auto start = fc::time_point::now();
+         auto record_time = fc::make_scoped_exit([&]() {
+            my->eosvmoc->cc.record_baseline_time(code_hash, vm_version, fc::time_point::now() - start);
+         });
+         my->get_instantiated_module(code_hash, vm_type, vm_version, context.trx_context)->apply(context);
+         return;
       }
 #endif
       my->get_instantiated_module(code_hash, vm_type, vm_version, context.trx_context)->apply(context);
    }
 
+   void wasm_interface::eosvmoc_prewarm(const fc::time_point& deadline) {
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+      if(my->eosvmoc) {
+         const auto start = fc::time_point::now();
+         const size_t compiled = my->eosvmoc->cc.prewarm(deadline);
+         if(compiled)
+            ilog("EOS VM OC compiled ${n} contracts of the previous run in ${t} ms",
+                 ("n", compiled)("t", (fc::time_point::now() - start).count() / 1000));
+      }
+#endif
+   }
+
    void wasm_interface::exit() {
       my->runtime_interface->immediately_exit_currently_running_module();
    }
@@ -35,6 +35,38 @@ namespace eosio { namespace chain { namespace webassembly {
    int32_t interface::db_end_i64( uint64_t code, uint64_t scope, uint64_t table ) {
       return context.db_get_context().db_end_i64( code, scope, table );
    }
+   uint32_t interface::db_get_batch_i64( uint64_t code, uint64_t scope, uint64_t table, span<const char> packed_ids, span<char> packed_rows ) {
+      datastream<const char*> ds_ids( packed_ids.data(), packed_ids.size() );
+      std::vector<uint64_t> ids;
+      fc::raw::unpack( ds_ids, ids );
+
+      auto& db_context = context.db_get_context();
+      // row size of each id, rows are read by id so the batch leaves no iterators behind
+      std::vector<int32_t> row_sizes;
+      row_sizes.reserve( ids.size() );
+      size_t size = fc::raw::pack_size( fc::unsigned_int( ids.size() ) );
+      for( auto id : ids ) {
+         context.trx_context.checktime();
+         auto row_size = db_context.db_get_by_id_i64( code, scope, table, id, nullptr, 0 );
+         row_sizes.push_back( row_size );
+         size += 1;
+         if( row_size >= 0 ) size += fc::raw::pack_size( fc::unsigned_int( row_size ) ) + row_size;
+      }
+      if( size > packed_rows.size() ) return size;
+
+      datastream<char*> ds( packed_rows.data(), size );
+      fc::raw::pack( ds, fc::unsigned_int( ids.size() ) );
+      for( size_t i = 0; i < ids.size(); ++i ) {
+         context.trx_context.checktime();
+         auto row_size = row_sizes[i];
+         fc::raw::pack( ds, row_size >= 0 );
+         if( row_size < 0 ) continue;
+         fc::raw::pack( ds, fc::unsigned_int( row_size ) );
+         if( row_size > 0 ) db_context.db_get_by_id_i64( code, scope, table, ids[i], ds.pos(), row_size );
+         ds.skip( row_size );
+      }
+      return size;
+   }
 
    /**
     * interface for uint64_t secondary
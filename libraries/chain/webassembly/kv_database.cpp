@@ -61,4 +61,41 @@ namespace eosio { namespace chain { namespace webassembly {
    int32_t  interface::kv_it_value(uint32_t itr, uint32_t offset, span<char> dest, uint32_t* actual_size) {
       return context.kv_it_value(itr, offset, dest.data(), dest.size(), *actual_size);
    }
+
+   uint32_t interface::kv_get_batch(uint64_t contract, span<const char> packed_keys, span<char> packed_values) {
+      datastream<const char*> ds_keys( packed_keys.data(), packed_keys.size() );
+      std::vector<bytes> keys;
+      fc::raw::unpack(ds_keys, keys);
+
+      std::vector<std::optional<bytes>> values;
+      values.reserve(keys.size());
+      for( const auto& key : keys ) {
+         context.trx_context.checktime();
+         uint32_t value_size = 0;
+         auto& value = values.emplace_back();
+         if( !context.kv_get(contract, key.data(), key.size(), value_size) ) continue;
+         value.emplace(value_size);
+         context.kv_get_data(0, value->data(), value_size);
+      }
+
+      auto size = fc::raw::pack_size( values );
+      if( size > packed_values.size() ) return size;
+
+      datastream<char*> ds( packed_values.data(), size );
+      fc::raw::pack( ds, values );
+      return size;
+   }
+
+   int64_t  interface::kv_set_batch(uint64_t contract, span<const char> packed_pairs, account_name payer) {
+      datastream<const char*> ds( packed_pairs.data(), packed_pairs.size() );
+      std::vector<std::pair<bytes, bytes>> pairs;
+      fc::raw::unpack(ds, pairs);
+
+      int64_t resource_delta = 0;
+      for( const auto& [key, value] : pairs ) {
+         context.trx_context.checktime();
+         resource_delta += context.kv_set(contract, key.data(), key.size(), value.data(), value.size(), payer);
+      }
+      return resource_delta;
+   }
 }}} // ns eosio::chain::webassembly
@@ -717,6 +717,17 @@ namespace LLVMJIT
 			auto llvmArgs = (llvm::Value**)alloca(sizeof(llvm::Value*) * calleeType->parameters.size());
 			popMultiple(llvmArgs,calleeType->parameters.size());
 
+			// memcpy, memmove and memset are expanded inline, with the intrinsic only called when the fast path can't be taken.
+			if(imm.functionIndex < moduleContext.importedFunctionOffsets.size())
+			{
+				const auto& import = module.functions.imports[imm.functionIndex];
+				if(import.moduleName == "env" && isInlinableMemoryIntrinsic(import.exportName,calleeType))
+				{
+					push(emitInlineMemoryIntrinsic(import.exportName,callee,llvmArgs));
+					return;
+				}
+			}
+
 			// Call the function.
 			auto result = createCall(callee,llvm::ArrayRef<llvm::Value*>(llvmArgs,calleeType->parameters.size()));
 			if(isExit) {
@@ -928,6 +939,184 @@ namespace LLVMJIT
    #define LOAD_STORE_ALIGNMENT_PARAM llvm::Align(1)
 #endif
 
+		//
+		// Inline expansion of the memory intrinsics
+		//
+
+		bool isInlinableMemoryIntrinsic(const std::string& name,const FunctionType* type)
+		{
+			if(name != "memcpy" && name != "memmove" && name != "memset")
+				return false;
+			return type->ret == ResultType::i32 && type->parameters.size() == 3 &&
+			       type->parameters[0] == ValueType::i32 && type->parameters[1] == ValueType::i32 && type->parameters[2] == ValueType::i32;
+		}
+
+		llvm::Type* getI8x16Type()
+		{
+#if LLVM_VERSION_MAJOR < 11
+			return llvm::VectorType::get(llvmI8Type,16);
+#else
+			return llvm::FixedVectorType::get(llvmI8Type,16);
+#endif
+		}
+
+		// Points at linear memory address base+offset, both being I64 byte indices.
+		llvm::Value* getLinearMemoryPointer(llvm::Value* base,llvm::Value* offset,llvm::Type* memoryType)
+		{
+			auto bytePointer = CreateInBoundsGEPWAR(irBuilder, moduleContext.defaultMemoryBase, irBuilder.CreateAdd(base,offset));
+			return irBuilder.CreatePointerCast(bytePointer,memoryType->getPointerTo(256));
+		}
+
+		// Emits a loop running emitBody(index) for index in [0,tripCount). emitBody must not create basic blocks.
+		template<typename F>
+		void emitCountedLoop(llvm::Value* tripCount,const char* name,F&& emitBody)
+		{
+			auto preheaderBlock = irBuilder.GetInsertBlock();
+			auto loopBlock = llvm::BasicBlock::Create(context,llvm::Twine(name) + "Loop",llvmFunction);
+			auto endBlock = llvm::BasicBlock::Create(context,llvm::Twine(name) + "End",llvmFunction);
+			irBuilder.CreateCondBr(irBuilder.CreateICmpEQ(tripCount,emitLiteral((U64)0)),endBlock,loopBlock);
+
+			irBuilder.SetInsertPoint(loopBlock);
+			auto index = irBuilder.CreatePHI(llvmI64Type,2);
+			index->addIncoming(emitLiteral((U64)0),preheaderBlock);
+			emitBody(index);
+			auto nextIndex = irBuilder.CreateAdd(index,emitLiteral((U64)1));
+			index->addIncoming(nextIndex,loopBlock);
+			irBuilder.CreateCondBr(irBuilder.CreateICmpULT(nextIndex,tripCount),loopBlock,endBlock);
+
+			irBuilder.SetInsertPoint(endBlock);
+		}
+
+		// Copies len bytes in 16 byte vectors followed by a byte wise tail. Each chunk is fully loaded before it is stored,
+		// so a forward copy is correct when dst <= src and a backward copy when dst >= src, even if the ranges overlap.
+		void emitCopyLoop(llvm::Value* dst,llvm::Value* src,llvm::Value* len,bool backward)
+		{
+			auto vectorType = getI8x16Type();
+			auto numVectors = irBuilder.CreateLShr(len,emitLiteral((U64)4));
+			auto tailLength = irBuilder.CreateAnd(len,emitLiteral((U64)15));
+			auto vectorBytes = irBuilder.CreateShl(numVectors,emitLiteral((U64)4));
+
+			auto copy = [&](llvm::Value* offset,llvm::Type* memoryType) {
+				auto load = irBuilder.CreateLoad(getLinearMemoryPointer(src,offset,memoryType));
+				load->setAlignment(LOAD_STORE_ALIGNMENT_PARAM);
+				load->setVolatile(true);
+				auto store = irBuilder.CreateStore(load,getLinearMemoryPointer(dst,offset,memoryType));
+				store->setAlignment(LOAD_STORE_ALIGNMENT_PARAM);
+				store->setVolatile(true);
+			};
+
+			if(!backward)
+			{
+				emitCountedLoop(numVectors,"memcpyVector",[&](llvm::Value* index) {
+					copy(irBuilder.CreateShl(index,emitLiteral((U64)4)),vectorType);
+				});
+				emitCountedLoop(tailLength,"memcpyTail",[&](llvm::Value* index) {
+					copy(irBuilder.CreateAdd(vectorBytes,index),llvmI8Type);
+				});
+			}
+			else
+			{
+				emitCountedLoop(numVectors,"memmoveVector",[&](llvm::Value* index) {
+					copy(irBuilder.CreateSub(len,irBuilder.CreateShl(irBuilder.CreateAdd(index,emitLiteral((U64)1)),emitLiteral((U64)4))),vectorType);
+				});
+				emitCountedLoop(tailLength,"memmoveTail",[&](llvm::Value* index) {
+					copy(irBuilder.CreateSub(irBuilder.CreateSub(tailLength,index),emitLiteral((U64)1)),llvmI8Type);
+				});
+			}
+		}
+
+		void emitFillLoop(llvm::Value* dst,llvm::Value* value,llvm::Value* len)
+		{
+			auto vectorType = getI8x16Type();
+			auto byteValue = irBuilder.CreateTrunc(value,llvmI8Type);
+			auto vectorValue = irBuilder.CreateVectorSplat(16,byteValue);
+			auto numVectors = irBuilder.CreateLShr(len,emitLiteral((U64)4));
+			auto tailLength = irBuilder.CreateAnd(len,emitLiteral((U64)15));
+			auto vectorBytes = irBuilder.CreateShl(numVectors,emitLiteral((U64)4));
+
+			auto fill = [&](llvm::Value* offset,llvm::Value* memoryValue,llvm::Type* memoryType) {
+				auto store = irBuilder.CreateStore(memoryValue,getLinearMemoryPointer(dst,offset,memoryType));
+				store->setAlignment(LOAD_STORE_ALIGNMENT_PARAM);
+				store->setVolatile(true);
+			};
+
+			emitCountedLoop(numVectors,"memsetVector",[&](llvm::Value* index) {
+				fill(irBuilder.CreateShl(index,emitLiteral((U64)4)),vectorValue,vectorType);
+			});
+			emitCountedLoop(tailLength,"memsetTail",[&](llvm::Value* index) {
+				fill(irBuilder.CreateAdd(vectorBytes,index),byteValue,llvmI8Type);
+			});
+		}
+
+		// Emits memcpy/memmove/memset directly on linear memory. The checks mirror the ones done when the intrinsic's
+		// arguments are converted (every range ends at or before first_invalid_memory_address, dst is valid even
+		// for an empty range) plus memcpy's overlap check. When any of them fail the intrinsic itself is called, so
+		// errors are raised exactly as before.
+		llvm::Value* emitInlineMemoryIntrinsic(const std::string& name,llvm::Value* callee,llvm::Value** args)
+		{
+			const bool isSet = name == "memset";
+			const bool isCopy = name == "memcpy";
+
+			auto dst = irBuilder.CreateZExt(args[0],llvmI64Type);
+			auto len = irBuilder.CreateZExt(args[2],llvmI64Type);
+
+			auto firstInvalid = irBuilder.CreateLoad(emitLiteralPointer((void*)OFFSET_OF_CONTROL_BLOCK_MEMBER(first_invalid_memory_address), llvmI64Type->getPointerTo(256)));
+
+			auto dstEnd = irBuilder.CreateAdd(dst,irBuilder.CreateSelect(irBuilder.CreateICmpEQ(len,emitLiteral((U64)0)),emitLiteral((U64)1),len));
+			llvm::Value* fastPath = irBuilder.CreateICmpSLE(dstEnd,firstInvalid);
+			llvm::Value* src = nullptr;
+			if(!isSet)
+			{
+				src = irBuilder.CreateZExt(args[1],llvmI64Type);
+				fastPath = irBuilder.CreateAnd(fastPath,irBuilder.CreateICmpSLE(irBuilder.CreateAdd(src,len),firstInvalid));
+			}
+			if(isCopy)
+			{
+				auto distance = irBuilder.CreateSelect(irBuilder.CreateICmpUGE(dst,src),irBuilder.CreateSub(dst,src),irBuilder.CreateSub(src,dst));
+				fastPath = irBuilder.CreateAnd(fastPath,irBuilder.CreateICmpUGE(distance,len));
+			}
+
+			auto inlineBlock = llvm::BasicBlock::Create(context,llvm::Twine(name) + "Inline",llvmFunction);
+			auto intrinsicBlock = llvm::BasicBlock::Create(context,llvm::Twine(name) + "Intrinsic",llvmFunction);
+			auto endBlock = llvm::BasicBlock::Create(context,llvm::Twine(name) + "Done",llvmFunction);
+			irBuilder.CreateCondBr(fastPath,inlineBlock,intrinsicBlock,moduleContext.likelyTrueBranchWeights);
+
+			irBuilder.SetInsertPoint(intrinsicBlock);
+			auto intrinsicResult = createCall(callee,llvm::ArrayRef<llvm::Value*>(args,3));
+			irBuilder.CreateBr(endBlock);
+
+			llvm::SmallVector<llvm::BasicBlock*,2> inlineExitBlocks;
+			irBuilder.SetInsertPoint(inlineBlock);
+			if(isSet)
+				emitFillLoop(dst,args[1],len);
+			else if(isCopy)
+				emitCopyLoop(dst,src,len,false);
+			else
+			{
+				auto forwardBlock = llvm::BasicBlock::Create(context,"memmoveForward",llvmFunction);
+				auto backwardBlock = llvm::BasicBlock::Create(context,"memmoveBackward",llvmFunction);
+				irBuilder.CreateCondBr(irBuilder.CreateICmpULE(dst,src),forwardBlock,backwardBlock);
+
+				irBuilder.SetInsertPoint(forwardBlock);
+				emitCopyLoop(dst,src,len,false);
+				irBuilder.CreateBr(endBlock);
+				inlineExitBlocks.push_back(irBuilder.GetInsertBlock());
+
+				irBuilder.SetInsertPoint(backwardBlock);
+				emitCopyLoop(dst,src,len,true);
+			}
+			irBuilder.CreateBr(endBlock);
+			inlineExitBlocks.push_back(irBuilder.GetInsertBlock());
+
+			// memcpy, memmove and memset all return dst
+			irBuilder.SetInsertPoint(endBlock);
+			auto result = irBuilder.CreatePHI(llvmI32Type,inlineExitBlocks.size() + 1);
+			result->addIncoming(intrinsicResult,intrinsicBlock);
+			for(auto exitBlock : inlineExitBlocks)
+				result->addIncoming(args[0],exitBlock);
+			return result;
+		}
+
 		EMIT_LOAD_OP(i32,load8_s,llvmI8Type,0,irBuilder.CreateSExt,LOAD_STORE_ALIGNMENT_PARAM)  EMIT_LOAD_OP(i32,load8_u,llvmI8Type,0,irBuilder.CreateZExt,LOAD_STORE_ALIGNMENT_PARAM)
 		EMIT_LOAD_OP(i32,load16_s,llvmI16Type,1,irBuilder.CreateSExt,LOAD_STORE_ALIGNMENT_PARAM) EMIT_LOAD_OP(i32,load16_u,llvmI16Type,1,irBuilder.CreateZExt,LOAD_STORE_ALIGNMENT_PARAM)
 		EMIT_LOAD_OP(i64,load8_s,llvmI8Type,0,irBuilder.CreateSExt,LOAD_STORE_ALIGNMENT_PARAM)  EMIT_LOAD_OP(i64,load8_u,llvmI8Type,0,irBuilder.CreateZExt,LOAD_STORE_ALIGNMENT_PARAM)
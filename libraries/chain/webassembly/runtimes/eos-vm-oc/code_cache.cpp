@@ -14,6 +14,9 @@
 #include <sys/mman.h>
 #include <linux/memfd.h>
 
+#include <algorithm>
+#include <iterator>
+
 #include "IR/Module.h"
 #include "IR/Validate.h"
 #include "WASM/WASM.h"
@@ -42,7 +45,9 @@ static_assert(sizeof(code_cache_header) <= header_size, "code_cache_header too b
 code_cache_async::code_cache_async(const bfs::path data_dir, const eosvmoc::config& eosvmoc_config, const chainbase::database& db) :
    code_cache_base(data_dir, eosvmoc_config, db),
    _result_queue(eosvmoc_config.threads * 2),
-   _threads(eosvmoc_config.threads)
+   _threads(eosvmoc_config.threads),
+   _tierup_threshold(eosvmoc_config.tierup_threshold),
+   _compile_nice(eosvmoc_config.compile_nice)
 {
    FC_ASSERT(_threads, "EOS VM OC requires at least 1 compile thread");
 
@@ -106,8 +111,7 @@ std::tuple<size_t, size_t> code_cache_async::consume_compile_thread_queue() {
    return {gotsome, bytes_remaining};
 }
 
-const code_descriptor* const code_cache_async::get_descriptor_for_code(const digest_type& code_id, const uint8_t& vm_version) {
-   //if there are any outstanding compiles, process the result queue now
+void code_cache_async::process_compile_results() {
    if(_outstanding_compiles_and_poison.size()) {
       auto [count_processed, bytes_remaining] = consume_compile_thread_queue();
 
@@ -115,7 +119,10 @@ const code_descriptor* const code_cache_async::get_descriptor_for_code(const dig
          check_eviction_threshold(bytes_remaining);
 
       while(count_processed && _queued_compiles.size()) {
-         auto nextup = _queued_compiles.begin();
+         //the queued code that has spent the most time in the baseline runtime saves the most once compiled
+         auto nextup = std::max_element(_queued_compiles.begin(), _queued_compiles.end(), [&](const code_tuple& a, const code_tuple& b) {
+            return usage_of(a).baseline_time < usage_of(b).baseline_time;
+         });
 
          //it's not clear this check is required: if apply() was called for code then it existed in the code_index; and then
          // if we got notification of it no longer existing we would have removed it from queued_compiles
@@ -124,12 +131,21 @@ const code_descriptor* const code_cache_async::get_descriptor_for_code(const dig
             _outstanding_compiles_and_poison.emplace(*nextup, false);
             std::vector<wrapped_fd> fds_to_pass;
             fds_to_pass.emplace_back(memfd_for_bytearray(codeobject->code));
-            FC_ASSERT(write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ *nextup }, fds_to_pass), "EOS VM failed to communicate to OOP manager");
+            FC_ASSERT(write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ *nextup, _compile_nice }, fds_to_pass), "EOS VM failed to communicate to OOP manager");
             --count_processed;
          }
          _queued_compiles.erase(nextup);
       }
    }
+}
+
+const code_descriptor* const code_cache_async::get_descriptor_for_code(const digest_type& code_id, const uint8_t& vm_version) {
+   //if there are any outstanding compiles, process the result queue now
+   process_compile_results();
+
+   const code_tuple ct = code_tuple{code_id, vm_version};
+   code_usage& usage = track_usage(ct);
+   ++usage.executions;
 
    //check for entry in cache
    code_cache_index::index<by_hash>::type::iterator it = _cache_index.get<by_hash>().find(boost::make_tuple(code_id, vm_version));
@@ -138,31 +154,63 @@ const code_descriptor* const code_cache_async::get_descriptor_for_code(const dig
       return &*it;
    }
 
-   const code_tuple ct = code_tuple{code_id, vm_version};
+   if(usage.executions < _tierup_threshold)
+      return nullptr;
+
+   start_compile(ct);
+   return nullptr;
+}
 
+void code_cache_async::start_compile(const code_tuple& ct) {
    if(_blacklist.find(ct) != _blacklist.end())
-      return nullptr;
+      return;
    if(auto it = _outstanding_compiles_and_poison.find(ct); it != _outstanding_compiles_and_poison.end()) {
       it->second = false;
-      return nullptr;
+      return;
    }
    if(_queued_compiles.find(ct) != _queued_compiles.end())
-      return nullptr;
+      return;
 
    if(_outstanding_compiles_and_poison.size() >= _threads) {
       _queued_compiles.emplace(ct);
-      return nullptr;
+      return;
    }
 
-   const code_object* const codeobject = _db.find<code_object,by_code_hash>(boost::make_tuple(code_id, 0, vm_version));
+   const code_object* const codeobject = _db.find<code_object,by_code_hash>(boost::make_tuple(ct.code_id, 0, ct.vm_version));
    if(!codeobject) //should be impossible right?
-      return nullptr;
+      return;
 
    _outstanding_compiles_and_poison.emplace(ct, false);
    std::vector<wrapped_fd> fds_to_pass;
    fds_to_pass.emplace_back(memfd_for_bytearray(codeobject->code));
-   write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ ct }, fds_to_pass);
-   return nullptr;
+   write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ ct, _compile_nice }, fds_to_pass);
+}
+
+void code_cache_async::record_baseline_time(const digest_type& code_id, const uint8_t& vm_version, const fc::microseconds& t) {
+   track_usage(code_tuple{code_id, vm_version}).baseline_time += t;
+}
+
+size_t code_cache_async::prewarm(const fc::time_point& deadline) {
+   size_t started = 0;
+   for(const code_tuple& ct : read_hot_list()) {
+      if(_cache_index.get<by_hash>().find(boost::make_tuple(ct.code_id, ct.vm_version)) != _cache_index.get<by_hash>().end())
+         continue;
+      if(!_db.find<code_object,by_code_hash>(boost::make_tuple(ct.code_id, 0, ct.vm_version)))
+         continue;
+      //starts the compile, or queues it once every compile thread is busy; the tier-up threshold does not apply
+      start_compile(ct);
+      ++started;
+   }
+
+   while(_outstanding_compiles_and_poison.size() && fc::time_point::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      process_compile_results();
+   }
+   if(_outstanding_compiles_and_poison.size())
+      wlog("EOS VM OC prewarm stopped at deadline with ${n} compiles outstanding",
+           ("n", _outstanding_compiles_and_poison.size() + _queued_compiles.size()));
+
+   return started;
 }
 
 code_cache_sync::~code_cache_sync() {
@@ -202,13 +250,15 @@ const code_descriptor* const code_cache_sync::get_descriptor_for_code_sync(const
    return &*_cache_index.push_front(std::move(std::get<code_descriptor>(result.result))).first;
 }
 
-code_cache_base::code_cache_base(const boost::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, const chainbase::database& db) :
+code_cache_base::code_cache_base(const boost::filesystem::path state_dir, const eosvmoc::config& eosvmoc_config, const chainbase::database& db) :
    _db(db),
-   _cache_file_path(data_dir/"code_cache.bin")
+   _cache_file_path((eosvmoc_config.cache_dir.empty() ? state_dir : eosvmoc_config.cache_dir)/"code_cache.bin"),
+   _hot_list_path(_cache_file_path.parent_path()/"code_cache_hot.bin"),
+   _hot_list_size(eosvmoc_config.prewarm_contracts)
 {
    static_assert(sizeof(allocator_t) <= header_offset, "header offset intersects with allocator");
 
-   bfs::create_directories(data_dir);
+   bfs::create_directories(_cache_file_path.parent_path());
 
    if(!bfs::exists(_cache_file_path)) {
       EOS_ASSERT(eosvmoc_config.cache_size >= allocator_t::get_min_size(total_header_size), database_exception, "configured code cache size is too small");
@@ -231,7 +281,8 @@ code_cache_base::code_cache_base(const boost::filesystem::path data_dir, const e
    }
 
    EOS_ASSERT(cache_header.id == header_id, bad_database_version_exception, "existing EOS VM OC code cache not compatible with this version");
-   EOS_ASSERT(!cache_header.dirty, database_exception, "code cache is dirty");
+   EOS_ASSERT(!cache_header.dirty, database_exception, "code cache ${p} is dirty: nodeos did not shut down cleanly, or another nodeos is using it",
+              ("p", _cache_file_path.generic_string()));
 
    set_on_disk_region_dirty(true);
 
@@ -303,7 +354,44 @@ void code_cache_base::serialize_cache_index(fc::datastream<T>& ds) {
       fc::raw::pack(ds, cd);
 }
 
+void code_cache_base::write_hot_list() {
+   if(!_hot_list_size)
+      return;
+   std::vector<code_tuple> hot;
+   for(const code_descriptor& cd : _cache_index) {
+      if(hot.size() == _hot_list_size)
+         break;
+      hot.push_back(code_tuple{cd.code_hash, cd.vm_version});
+   }
+   const std::vector<char> packed = fc::raw::pack(hot);
+   std::ofstream ofs(_hot_list_path.generic_string(), std::ofstream::binary | std::ofstream::trunc);
+   ofs.write(packed.data(), packed.size());
+   if(!ofs.good())
+      elog("unable to write EOS VM OC hot code list ${p}", ("p", _hot_list_path.generic_string()));
+}
+
+std::vector<code_tuple> code_cache_base::read_hot_list() {
+   std::vector<code_tuple> hot;
+   if(!_hot_list_size || !bfs::exists(_hot_list_path))
+      return hot;
+   try {
+      std::ifstream ifs(_hot_list_path.generic_string(), std::ifstream::binary);
+      const std::vector<char> packed((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+      fc::datastream<const char*> ds(packed.data(), packed.size());
+      fc::raw::unpack(ds, hot);
+   } catch(const fc::exception& e) {
+      wlog("ignoring unreadable EOS VM OC hot code list ${p}: ${e}", ("p", _hot_list_path.generic_string())("e", e.to_detail_string()));
+      hot.clear();
+   }
+   if(hot.size() > _hot_list_size)
+      hot.resize(_hot_list_size);
+   return hot;
+}
+
 code_cache_base::~code_cache_base() {
+   //record the most recently used codes while the index is still complete
+   write_hot_list();
+
    //reopen the code cache in our process
    struct stat st;
    if(fstat(_cache_fd, &st))
@@ -359,6 +447,7 @@ void code_cache_base::free_code(const digest_type& code_id, const uint8_t& vm_ve
 
    //if it's in the queued list, erase it
    _queued_compiles.erase({code_id, vm_version});
+   _usage.erase({code_id, vm_version});
 
    //however, if it's currently being compiled there is no way to cancel the compile,
    //so instead set a poison boolean that indicates not to insert the code in to the cache
@@ -369,14 +458,48 @@ void code_cache_base::free_code(const digest_type& code_id, const uint8_t& vm_ve
 }
 
 void code_cache_base::run_eviction_round() {
+   //of the least recently used entries, evict the ones executed least often; the most recently used entry always stays
+   constexpr size_t evict_count = 25;
+   constexpr size_t candidate_count = evict_count * 4;
+   std::vector<code_cache_index::iterator> candidates;
+   for(auto it = _cache_index.end(); it != _cache_index.begin() && candidates.size() < candidate_count && candidates.size() + 1 < _cache_index.size();)
+      candidates.push_back(--it);
+   std::stable_sort(candidates.begin(), candidates.end(), [&](const auto& a, const auto& b) {
+      return usage_of({a->code_hash, a->vm_version}).executions < usage_of({b->code_hash, b->vm_version}).executions;
+   });
+   if(candidates.size() > evict_count)
+      candidates.resize(evict_count);
+
    evict_wasms_message evict_msg;
-   for(unsigned int i = 0; i < 25 && _cache_index.size() > 1; ++i) {
-      evict_msg.codes.emplace_back(_cache_index.back());
-      _cache_index.pop_back();
+   for(const auto& it : candidates) {
+      evict_msg.codes.emplace_back(*it);
+      _usage.erase({it->code_hash, it->vm_version});
+      _cache_index.erase(it);
    }
    write_message_with_fds(_compile_monitor_write_socket, evict_msg);
 }
 
+code_cache_base::code_usage code_cache_base::usage_of(const code_tuple& ct) const {
+   auto it = _usage.find(ct);
+   return it != _usage.end() ? it->second : code_usage{};
+}
+
+code_cache_base::code_usage& code_cache_base::track_usage(const code_tuple& ct) {
+   static constexpr size_t max_tracked = 8192;
+   if(_usage.size() >= max_tracked && _usage.find(ct) == _usage.end()) {
+      //decay so that past usage counts for less, and forget codes that have gone cold
+      for(auto it = _usage.begin(); it != _usage.end();) {
+         it->second.executions /= 2;
+         it->second.baseline_time = fc::microseconds(it->second.baseline_time.count() / 2);
+         if(it->second.executions == 0)
+            it = _usage.erase(it);
+         else
+            ++it;
+      }
+   }
+   return _usage[ct];
+}
+
 void code_cache_base::check_eviction_threshold(size_t free_bytes) {
    if(free_bytes < _free_bytes_eviction_threshold)
       run_eviction_round();
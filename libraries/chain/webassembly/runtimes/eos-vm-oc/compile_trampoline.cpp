@@ -160,11 +160,16 @@ void run_compile_trampoline(int fd) {
          continue;
       }
 
+      const int compile_nice = std::get<compile_wasm_message>(message).nice;
+
       pid_t pid = fork();
       if(pid == 0) {
          prctl(PR_SET_NAME, "oc-compile");
          prctl(PR_SET_PDEATHSIG, SIGKILL);
 
+         if(compile_nice)
+            setpriority(PRIO_PROCESS, 0, compile_nice);
+
          struct rlimit cpu_limits = {20u, 20u};
          setrlimit(RLIMIT_CPU, &cpu_limits);
 
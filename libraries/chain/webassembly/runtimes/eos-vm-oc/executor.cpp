@@ -173,7 +173,7 @@ void executor::execute(const code_descriptor& code, memory& mem, apply_context&
                   (code.starting_memory_pages - initial_page_offset) * eosio::chain::wasm_constraints::wasm_page_size, PROT_READ | PROT_WRITE);
       }
       arch_prctl(ARCH_SET_GS, (unsigned long*)(mem.zero_page_memory_base()+initial_page_offset*memory::stride));
-      memset(mem.full_page_memory_base(), 0, 64u*1024u*code.starting_memory_pages);
+      mem.zero_linear_memory(code.starting_memory_pages);
    }
    else
       arch_prctl(ARCH_SET_GS, (unsigned long*)mem.zero_page_memory_base());
@@ -4,6 +4,7 @@
 
 #include <fc/scoped_exit.hpp>
 
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/syscall.h>
 #include <sys/mman.h>
@@ -14,9 +15,9 @@ namespace eosio { namespace chain { namespace eosvmoc {
 memory::memory(uint64_t max_pages) {
    uint64_t number_slices = max_pages + 1;
    uint64_t wasm_memory_size = max_pages * wasm_constraints::wasm_page_size;
-   int fd = syscall(SYS_memfd_create, "eosvmoc_mem", MFD_CLOEXEC);
+   fd = syscall(SYS_memfd_create, "eosvmoc_mem", MFD_CLOEXEC);
    FC_ASSERT(fd >= 0, "Failed to create memory memfd");
-   auto cleanup_fd = fc::make_scoped_exit([&fd](){close(fd);});
+   auto cleanup_fd = fc::make_scoped_exit([this](){close(fd);});
    int ret = ftruncate(fd, wasm_memory_size+memory_prologue_size);
    FC_ASSERT(!ret, "Failed to grow memory memfd");
 
@@ -41,6 +42,18 @@ memory::memory(uint64_t max_pages) {
    const intrinsic_map_t& intrinsics = get_intrinsic_map();
    for(const auto& intrinsic : intrinsics)
       intrinsic_jump_table[-intrinsic.second.ordinal] = (uintptr_t)intrinsic.second.function_ptr;
+
+   //the memfd stays open so that linear memory can be released by zero_linear_memory
+   cleanup_fd.cancel();
+}
+
+void memory::zero_linear_memory(uint64_t pages) {
+   const uint64_t size = pages*wasm_constraints::wasm_page_size;
+   //punching a hole releases only the host pages resident in the range, i.e. those touched since the last reset, and
+   // they read back as zeros. Writing zeros instead touches every page, which costs more once the range is large
+   if(pages >= release_min_pages && fallocate(fd, FALLOC_FL_PUNCH_HOLE|FALLOC_FL_KEEP_SIZE, memory_prologue_size, size) == 0)
+      return;
+   memset(fullpage_base, 0, size);
 }
 
 void memory::reset(uint64_t max_pages) {
@@ -51,10 +64,12 @@ void memory::reset(uint64_t max_pages) {
    std::swap(mapsize, new_memory.mapsize);
    std::swap(zeropage_base, new_memory.zeropage_base);
    std::swap(fullpage_base, new_memory.fullpage_base);
+   std::swap(fd, new_memory.fd);
 }
 
 memory::~memory() {
    munmap(mapbase, mapsize);
+   close(fd);
 }
 
 }}}
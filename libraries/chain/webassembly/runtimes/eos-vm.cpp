@@ -1,5 +1,6 @@
 #include <eosio/chain/webassembly/eos-vm.hpp>
 #include <eosio/chain/webassembly/interface.hpp>
+#include <eosio/chain/webassembly/interface_inline.hpp>
 #include <eosio/chain/apply_context.hpp>
 #include <eosio/chain/transaction_context.hpp>
 #include <eosio/chain/global_property_object.hpp>
@@ -61,10 +62,10 @@ struct setcode_options {
    static constexpr bool allow_zero_blocktype = true;
 };
 
-void validate(const bytes& code, const whitelisted_intrinsics_type& intrinsics) {
-   wasm_code_ptr code_ptr((uint8_t*)code.data(), code.size());
+void validate(const char* code, size_t code_size, const whitelisted_intrinsics_type& intrinsics) {
+   wasm_code_ptr code_ptr((uint8_t*)code, code_size);
    try {
-      eos_vm_null_backend_t<setcode_options> bkend(code_ptr, code.size(), nullptr);
+      eos_vm_null_backend_t<setcode_options> bkend(code_ptr, code_size, nullptr);
       // check import signatures
        eos_vm_host_functions_t::resolve(bkend.get_module());
       // check that the imports are all currently enabled
@@ -81,11 +82,11 @@ void validate(const bytes& code, const whitelisted_intrinsics_type& intrinsics)
    }
 }
 
-void validate( const bytes& code, const wasm_config& cfg, const whitelisted_intrinsics_type& intrinsics ) {
-   EOS_ASSERT(code.size() <= cfg.max_module_bytes, wasm_serialization_error, "Code too large");
-   wasm_code_ptr code_ptr((uint8_t*)code.data(), code.size());
+void validate( const char* code, size_t code_size, const wasm_config& cfg, const whitelisted_intrinsics_type& intrinsics ) {
+   EOS_ASSERT(code_size <= cfg.max_module_bytes, wasm_serialization_error, "Code too large");
+   wasm_code_ptr code_ptr((uint8_t*)code, code_size);
    try {
-      eos_vm_null_backend_t<wasm_config> bkend(code_ptr, code.size(), nullptr, cfg);
+      eos_vm_null_backend_t<wasm_config> bkend(code_ptr, code_size, nullptr, cfg);
       // check import signatures
       eos_vm_host_functions_t::resolve(bkend.get_module());
       // check that the imports are all currently enabled
@@ -128,7 +129,11 @@ class eos_vm_instantiated_module : public wasm_instantiated_module_interface {
          _instantiated_module(std::move(mod)) {}
 
       void apply(apply_context& context) override {
-         _instantiated_module->set_wasm_allocator(&context.control.get_wasm_allocator());
+         // the allocator belongs to the controller owning this module, it only has to be bound once
+         if(vm::wasm_allocator* allocator = &context.control.get_wasm_allocator(); allocator != _allocator) {
+            _instantiated_module->set_wasm_allocator(allocator);
+            _allocator = allocator;
+         }
          _runtime->_bkend = _instantiated_module.get();
          apply_options opts;
          if(context.control.is_builtin_activated(builtin_protocol_feature_t::configurable_wasm_limits)) {
@@ -160,6 +165,7 @@ class eos_vm_instantiated_module : public wasm_instantiated_module_interface {
    private:
       eos_vm_runtime<Impl>*            _runtime;
       std::unique_ptr<backend_t> _instantiated_module;
+      vm::wasm_allocator*              _allocator = nullptr;
 };
 
 template<typename Impl>
@@ -171,12 +177,7 @@ void eos_vm_runtime<Impl>::immediately_exit_currently_running_module() {
 }
 
 template<typename Impl>
-bool eos_vm_runtime<Impl>::inject_module(IR::Module& module) {
-   return false;
-}
-
-template<typename Impl>
-std::unique_ptr<wasm_instantiated_module_interface> eos_vm_runtime<Impl>::instantiate_module(const char* code_bytes, size_t code_size, std::vector<uint8_t>,
+std::unique_ptr<wasm_instantiated_module_interface> eos_vm_runtime<Impl>::instantiate_module(const char* code_bytes, size_t code_size,
                                                                                              const digest_type&, const uint8_t&, const uint8_t&) {
 
    using backend_t = eos_vm_backend_t<Impl>;
@@ -197,17 +198,39 @@ template class eos_vm_runtime<eosio::vm::jit>;
 
 } 
 
+/// counts the call in the action_profiler of the running action, when it is profiled
+template <auto HostFunction>
+struct host_call_profile {
+   inline static uint32_t id = 0;
+
+   template <typename Type_Converter, typename... Args>
+   inline static void condition(Type_Converter& ctx, Args&&...) {
+      if( auto* profiler = ctx.get_host().get_context().get_profiler() )
+         profiler->count_host_call( id );
+   }
+};
+
 template <auto HostFunction, typename... Preconditions>
 struct host_function_registrator {
    template <typename Mod, typename Name>
    constexpr host_function_registrator(Mod mod_name, Name fn_name) {
       using rhf_t = eos_vm_host_functions_t;
-      rhf_t::add<HostFunction, Preconditions...>(mod_name.c_str(), fn_name.c_str());
-#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
       constexpr bool is_injected = (Mod() == BOOST_HANA_STRING(EOSIO_INJECTED_MODULE_NAME));
-      eosvmoc::register_eosvm_oc<HostFunction, is_injected, std::tuple<Preconditions...>>(
-          mod_name + BOOST_HANA_STRING(".") + fn_name);
+      // injected softfloat functions are not intrinsics a contract calls, they are not profiled
+      if constexpr (is_injected) {
+         rhf_t::add<HostFunction, Preconditions...>(mod_name.c_str(), fn_name.c_str());
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+         eosvmoc::register_eosvm_oc<HostFunction, is_injected, std::tuple<Preconditions...>>(
+             mod_name + BOOST_HANA_STRING(".") + fn_name);
 #endif
+      } else {
+         host_call_profile<HostFunction>::id = action_profiler::register_intrinsic(fn_name.c_str());
+         rhf_t::add<HostFunction, host_call_profile<HostFunction>, Preconditions...>(mod_name.c_str(), fn_name.c_str());
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+         eosvmoc::register_eosvm_oc<HostFunction, is_injected, std::tuple<host_call_profile<HostFunction>, Preconditions...>>(
+             mod_name + BOOST_HANA_STRING(".") + fn_name);
+#endif
+      }
    }
 };
 
@@ -256,24 +279,24 @@ REGISTER_LEGACY_CF_ONLY_HOST_FUNCTION(get_context_free_data)
 
 // privileged api
 REGISTER_HOST_FUNCTION(is_feature_active, privileged_check);
-REGISTER_HOST_FUNCTION(activate_feature, privileged_check);
-REGISTER_LEGACY_HOST_FUNCTION(preactivate_feature, privileged_check);
-REGISTER_HOST_FUNCTION(set_resource_limits, privileged_check);
+REGISTER_HOST_FUNCTION(activate_feature, privileged_check, read_write_check);
+REGISTER_LEGACY_HOST_FUNCTION(preactivate_feature, privileged_check, read_write_check);
+REGISTER_HOST_FUNCTION(set_resource_limits, privileged_check, read_write_check);
 REGISTER_LEGACY_HOST_FUNCTION(get_resource_limits, privileged_check);
-REGISTER_HOST_FUNCTION(set_resource_limit, privileged_check);
+REGISTER_HOST_FUNCTION(set_resource_limit, privileged_check, read_write_check);
 REGISTER_HOST_FUNCTION(get_resource_limit, privileged_check);
 REGISTER_HOST_FUNCTION(get_wasm_parameters_packed, privileged_check);
-REGISTER_HOST_FUNCTION(set_wasm_parameters_packed, privileged_check);
-REGISTER_LEGACY_HOST_FUNCTION(set_proposed_producers, privileged_check);
-REGISTER_LEGACY_HOST_FUNCTION(set_proposed_producers_ex, privileged_check);
+REGISTER_HOST_FUNCTION(set_wasm_parameters_packed, privileged_check, read_write_check);
+REGISTER_LEGACY_HOST_FUNCTION(set_proposed_producers, privileged_check, read_write_check);
+REGISTER_LEGACY_HOST_FUNCTION(set_proposed_producers_ex, privileged_check, read_write_check);
 REGISTER_LEGACY_HOST_FUNCTION(get_blockchain_parameters_packed, privileged_check);
-REGISTER_LEGACY_HOST_FUNCTION(set_blockchain_parameters_packed, privileged_check);
+REGISTER_LEGACY_HOST_FUNCTION(set_blockchain_parameters_packed, privileged_check, read_write_check);
 REGISTER_HOST_FUNCTION(get_parameters_packed, privileged_check);
-REGISTER_HOST_FUNCTION(set_parameters_packed, privileged_check);
+REGISTER_HOST_FUNCTION(set_parameters_packed, privileged_check, read_write_check);
 REGISTER_HOST_FUNCTION(get_kv_parameters_packed, privileged_check);
-REGISTER_HOST_FUNCTION(set_kv_parameters_packed, privileged_check);
+REGISTER_HOST_FUNCTION(set_kv_parameters_packed, privileged_check, read_write_check);
 REGISTER_HOST_FUNCTION(is_privileged, privileged_check);
-REGISTER_HOST_FUNCTION(set_privileged, privileged_check);
+REGISTER_HOST_FUNCTION(set_privileged, privileged_check, read_write_check);
 
 // softfloat api
 REGISTER_INJECTED_HOST_FUNCTION(_eosio_f32_add);
@@ -397,9 +420,9 @@ REGISTER_LEGACY_CF_HOST_FUNCTION(printhex);
 
 // database api
 // primary index api
-REGISTER_LEGACY_HOST_FUNCTION(db_store_i64);
-REGISTER_LEGACY_HOST_FUNCTION(db_update_i64);
-REGISTER_HOST_FUNCTION(db_remove_i64);
+REGISTER_LEGACY_HOST_FUNCTION(db_store_i64, read_write_check);
+REGISTER_LEGACY_HOST_FUNCTION(db_update_i64, read_write_check);
+REGISTER_HOST_FUNCTION(db_remove_i64, read_write_check);
 REGISTER_LEGACY_HOST_FUNCTION(db_get_i64);
 REGISTER_LEGACY_HOST_FUNCTION(db_next_i64);
 REGISTER_LEGACY_HOST_FUNCTION(db_previous_i64);
@@ -407,11 +430,12 @@ REGISTER_HOST_FUNCTION(db_find_i64);
 REGISTER_HOST_FUNCTION(db_lowerbound_i64);
 REGISTER_HOST_FUNCTION(db_upperbound_i64);
 REGISTER_HOST_FUNCTION(db_end_i64);
+REGISTER_HOST_FUNCTION(db_get_batch_i64);
 
 // uint64_t secondary index api
-REGISTER_LEGACY_HOST_FUNCTION(db_idx64_store);
-REGISTER_LEGACY_HOST_FUNCTION(db_idx64_update);
-REGISTER_HOST_FUNCTION(db_idx64_remove);
+REGISTER_LEGACY_HOST_FUNCTION(db_idx64_store, read_write_check);
+REGISTER_LEGACY_HOST_FUNCTION(db_idx64_update, read_write_check);
+REGISTER_HOST_FUNCTION(db_idx64_remove, read_write_check);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx64_find_secondary);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx64_find_primary);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx64_lowerbound);
@@ -421,9 +445,9 @@ REGISTER_LEGACY_HOST_FUNCTION(db_idx64_next);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx64_previous);
 
 // uint128_t secondary index api
-REGISTER_LEGACY_HOST_FUNCTION(db_idx128_store);
-REGISTER_LEGACY_HOST_FUNCTION(db_idx128_update);
-REGISTER_HOST_FUNCTION(db_idx128_remove);
+REGISTER_LEGACY_HOST_FUNCTION(db_idx128_store, read_write_check);
+REGISTER_LEGACY_HOST_FUNCTION(db_idx128_update, read_write_check);
+REGISTER_HOST_FUNCTION(db_idx128_remove, read_write_check);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx128_find_secondary);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx128_find_primary);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx128_lowerbound);
@@ -433,9 +457,9 @@ REGISTER_LEGACY_HOST_FUNCTION(db_idx128_next);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx128_previous);
 
 // 256-bit secondary index api
-REGISTER_LEGACY_HOST_FUNCTION(db_idx256_store);
-REGISTER_LEGACY_HOST_FUNCTION(db_idx256_update);
-REGISTER_HOST_FUNCTION(db_idx256_remove);
+REGISTER_LEGACY_HOST_FUNCTION(db_idx256_store, read_write_check);
+REGISTER_LEGACY_HOST_FUNCTION(db_idx256_update, read_write_check);
+REGISTER_HOST_FUNCTION(db_idx256_remove, read_write_check);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx256_find_secondary);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx256_find_primary);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx256_lowerbound);
@@ -445,9 +469,9 @@ REGISTER_LEGACY_HOST_FUNCTION(db_idx256_next);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx256_previous);
 
 // double secondary index api
-REGISTER_LEGACY_HOST_FUNCTION(db_idx_double_store, is_nan_check);
-REGISTER_LEGACY_HOST_FUNCTION(db_idx_double_update, is_nan_check);
-REGISTER_HOST_FUNCTION(db_idx_double_remove);
+REGISTER_LEGACY_HOST_FUNCTION(db_idx_double_store, is_nan_check, read_write_check);
+REGISTER_LEGACY_HOST_FUNCTION(db_idx_double_update, is_nan_check, read_write_check);
+REGISTER_HOST_FUNCTION(db_idx_double_remove, read_write_check);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx_double_find_secondary, is_nan_check);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx_double_find_primary);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx_double_lowerbound, is_nan_check);
@@ -457,9 +481,9 @@ REGISTER_LEGACY_HOST_FUNCTION(db_idx_double_next);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx_double_previous);
 
 // long double secondary index api
-REGISTER_LEGACY_HOST_FUNCTION(db_idx_long_double_store, is_nan_check);
-REGISTER_LEGACY_HOST_FUNCTION(db_idx_long_double_update, is_nan_check);
-REGISTER_HOST_FUNCTION(db_idx_long_double_remove);
+REGISTER_LEGACY_HOST_FUNCTION(db_idx_long_double_store, is_nan_check, read_write_check);
+REGISTER_LEGACY_HOST_FUNCTION(db_idx_long_double_update, is_nan_check, read_write_check);
+REGISTER_HOST_FUNCTION(db_idx_long_double_remove, read_write_check);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx_long_double_find_secondary, is_nan_check);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx_long_double_find_primary);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx_long_double_lowerbound, is_nan_check);
@@ -469,8 +493,8 @@ REGISTER_LEGACY_HOST_FUNCTION(db_idx_long_double_next);
 REGISTER_LEGACY_HOST_FUNCTION(db_idx_long_double_previous);
 
 // kv database api
-REGISTER_HOST_FUNCTION(kv_erase);
-REGISTER_HOST_FUNCTION(kv_set);
+REGISTER_HOST_FUNCTION(kv_erase, read_write_check);
+REGISTER_HOST_FUNCTION(kv_set, read_write_check);
 REGISTER_HOST_FUNCTION(kv_get);
 REGISTER_HOST_FUNCTION(kv_get_data);
 REGISTER_HOST_FUNCTION(kv_it_create);
@@ -484,6 +508,8 @@ REGISTER_HOST_FUNCTION(kv_it_prev);
 REGISTER_HOST_FUNCTION(kv_it_lower_bound);
 REGISTER_HOST_FUNCTION(kv_it_key);
 REGISTER_HOST_FUNCTION(kv_it_value);
+REGISTER_HOST_FUNCTION(kv_get_batch);
+REGISTER_HOST_FUNCTION(kv_set_batch, read_write_check);
 
 // memory api
 REGISTER_LEGACY_CF_HOST_FUNCTION(memcpy);
@@ -492,10 +518,10 @@ REGISTER_LEGACY_CF_HOST_FUNCTION(memcmp);
 REGISTER_LEGACY_CF_HOST_FUNCTION(memset);
 
 // transaction api
-REGISTER_LEGACY_HOST_FUNCTION(send_inline);
-REGISTER_LEGACY_HOST_FUNCTION(send_context_free_inline);
-REGISTER_LEGACY_HOST_FUNCTION(send_deferred);
-REGISTER_LEGACY_HOST_FUNCTION(cancel_deferred);
+REGISTER_LEGACY_HOST_FUNCTION(send_inline, read_write_check);
+REGISTER_LEGACY_HOST_FUNCTION(send_context_free_inline, read_write_check);
+REGISTER_LEGACY_HOST_FUNCTION(send_deferred, read_write_check);
+REGISTER_LEGACY_HOST_FUNCTION(cancel_deferred, read_write_check);
 
 // context-free transaction api
 REGISTER_LEGACY_CF_HOST_FUNCTION(read_transaction);
@@ -3,7 +3,9 @@
 #include <fc/io/raw.hpp>
 #include <optional>
 #include <rocksdb/db.h>
+#include <rocksdb/sst_file_writer.h>
 #include <rocksdb/table.h>
+#include <rocksdb/utilities/checkpoint.h>
 #include <stdexcept>
 #include <softfloat.hpp>
 #include <algorithm>
@@ -298,29 +300,17 @@ bytes create_full_key(const bytes& prefix, uint64_t contract, const T& key) {
    return result;
 }
 
+struct read_only_t {};
+inline constexpr read_only_t read_only{};
+
 struct database {
    std::unique_ptr<rocksdb::DB> rdb;
 
    database(const char* db_path, bool create_if_missing, std::optional<uint32_t> threads = {},
             std::optional<int> max_open_files = {}) {
 
-      rocksdb::Options options;
-      options.create_if_missing                    = create_if_missing;
-      options.level_compaction_dynamic_level_bytes = true;
-      options.bytes_per_sync                       = 1048576;
-
-      if (threads)
-         options.IncreaseParallelism(*threads);
-
-      options.OptimizeLevelStyleCompaction(256ull << 20);
-
-      if (max_open_files)
-         options.max_open_files = *max_open_files;
-
-      rocksdb::BlockBasedTableOptions table_options;
-      table_options.format_version               = 4;
-      table_options.index_block_restart_interval = 16;
-      options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+      rocksdb::Options options = make_options(threads, max_open_files);
+      options.create_if_missing = create_if_missing;
 
       rocksdb::DB* p;
       check(rocksdb::DB::Open(options, db_path, &p), "database::database: rocksdb::DB::Open: ");
@@ -346,9 +336,48 @@ struct database {
          write(batch);
    }
 
+   // Opens a database written by another instance, e.g. a checkpoint, without writing to it. All table files are
+   // kept open, so the database stays readable after its files are unlinked.
+   database(const char* db_path, read_only_t) {
+      rocksdb::DB* p;
+      check(rocksdb::DB::OpenForReadOnly(make_options({}, -1), db_path, &p),
+            "database::database: rocksdb::DB::OpenForReadOnly: ");
+      rdb.reset(p);
+   }
+
    database(database&&) = default;
    database& operator=(database&&) = default;
 
+   static rocksdb::Options make_options(std::optional<uint32_t> threads, std::optional<int> max_open_files) {
+      rocksdb::Options options;
+      options.level_compaction_dynamic_level_bytes = true;
+      options.bytes_per_sync                       = 1048576;
+
+      if (threads)
+         options.IncreaseParallelism(*threads);
+
+      options.OptimizeLevelStyleCompaction(256ull << 20);
+
+      if (max_open_files)
+         options.max_open_files = *max_open_files;
+
+      rocksdb::BlockBasedTableOptions table_options;
+      table_options.format_version               = 4;
+      table_options.index_block_restart_interval = 16;
+      options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+      return options;
+   }
+
+   // Create a checkpoint of the database in path, which must not exist. Table files are hard linked when path is on
+   // the same file system. Memtables are flushed first since writes bypass the WAL.
+   void create_checkpoint(const std::string& path) {
+      rocksdb::Checkpoint* p;
+      check(rocksdb::Checkpoint::Create(rdb.get(), &p), "database::create_checkpoint: rocksdb::Checkpoint::Create: ");
+      std::unique_ptr<rocksdb::Checkpoint> checkpoint{ p };
+      check(checkpoint->CreateCheckpoint(path, 0),
+            "database::create_checkpoint: rocksdb::Checkpoint::CreateCheckpoint: ");
+   }
+
    void flush(bool allow_write_stall, bool wait) {
       rocksdb::FlushOptions op;
       op.allow_write_stall = allow_write_stall;
@@ -617,6 +646,37 @@ class undo_stack {
       db.write(batch);
    } // write_changes()
 
+   // Write the changes in `cache` by building a sorted table file at `sst_path` and ingesting it into the
+   // database, bypassing the memtable. The file is moved into the database. Ingestion doesn't record undo
+   // segments, so it's only possible while the undo stack is empty.
+   void ingest_changes(cache_map& cache, const std::string& sst_path) {
+      if (!state.undo_stack.empty())
+         throw exception("cannot ingest changes while there is an existing undo stack");
+
+      rocksdb::SstFileWriter writer(rocksdb::EnvOptions(), db.rdb->GetOptions());
+      bool                   opened = false;
+      for (auto& [key, value] : cache) {
+         if (!compare_value(value.orig_value, value.current_value))
+            continue;
+         if (!opened) {
+            check(writer.Open(sst_path), "undo_stack::ingest_changes: rocksdb::SstFileWriter::Open: ");
+            opened = true;
+         }
+         if (value.current_value)
+            check(writer.Put(to_slice(key), to_slice(*value.current_value)),
+                  "undo_stack::ingest_changes: rocksdb::SstFileWriter::Put: ");
+         else
+            check(writer.Delete(to_slice(key)), "undo_stack::ingest_changes: rocksdb::SstFileWriter::Delete: ");
+      }
+      if (opened) {
+         check(writer.Finish(), "undo_stack::ingest_changes: rocksdb::SstFileWriter::Finish: ");
+         rocksdb::IngestExternalFileOptions opt;
+         opt.move_files = true;
+         check(db.rdb->IngestExternalFile({ sst_path }, opt), "undo_stack::ingest_changes: rocksdb::DB::IngestExternalFile: ");
+      }
+      write_state();
+   }
+
    void write_state() {
       rocksdb::WriteBatch batch;
       write_state(batch);
@@ -652,6 +712,7 @@ struct write_session {
    const rocksdb::Snapshot* snapshot;
    cache_map                cache;
    cache_map::iterator      change_list = cache.end();
+   size_t                   num_changes = 0; // Number of items in change_list
 
    write_session(database& db, const rocksdb::Snapshot* snapshot = nullptr) : db{ db }, snapshot{ snapshot } {}
 
@@ -668,6 +729,7 @@ struct write_session {
       it->second.in_change_list   = true;
       it->second.change_list_next = change_list;
       change_list                 = it;
+      ++num_changes;
    }
 
    // Get a value. Includes any changes written to cache. Returns nullptr
@@ -767,10 +829,19 @@ struct write_session {
       wipe_cache();
    }
 
+   // Write changes to database through an ingested table file. See undo_stack::ingest_changes.
+   //
+   // Caution: ingest_changes wipes the cache, which invalidates iterators
+   void ingest_changes(undo_stack& u, const std::string& sst_path) {
+      u.ingest_changes(cache, sst_path);
+      wipe_cache();
+   }
+
    // Wipe the cache. Invalidates iterators.
    void wipe_cache() {
       cache.clear();
       change_list = cache.end();
+      num_changes = 0;
    }
 }; // write_session
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <forward_list>
 #include <iterator>
@@ -12,6 +13,7 @@
 #include <rocksdb/filter_policy.h>
 #include <rocksdb/options.h>
 #include <rocksdb/slice_transform.h>
+#include <rocksdb/sst_file_writer.h>
 
 #include <b1/session/session.hpp>
 #include <eosio/chain/exceptions.hpp>
@@ -89,6 +91,12 @@ class session<rocksdb_t> {
    /// \param max_iterators This type will cache up to max_iterators RocksDB iterator instances.
    session(std::shared_ptr<rocksdb::DB> db, size_t max_iterators);
 
+   /// \brief Constructs a session that reads from a point-in-time RocksDB snapshot.
+   /// \param db A pointer to the RocksDB db type instance.
+   /// \param max_iterators This type will cache up to max_iterators RocksDB iterator instances.
+   /// \param snapshot The snapshot all reads and iterators of this session are served from.
+   session(std::shared_ptr<rocksdb::DB> db, size_t max_iterators, std::shared_ptr<const rocksdb::Snapshot> snapshot);
+
    session& operator=(const session&) = default;
    session& operator=(session&&) = default;
 
@@ -109,6 +117,13 @@ class session<rocksdb_t> {
    template <typename Iterable>
    void write(const Iterable& key_values);
 
+   /// \brief Sorts the key values, builds an SST file from them at sst_path and ingests it into the database.
+   /// \remarks Ingested keys skip the memtable and the compactions that writing them would cause, which makes this
+   /// the fastest way to bulk load keys that are not yet present, e.g. from a snapshot. The keys must be distinct.
+   /// The file is moved into the database.
+   template <typename Key_values>
+   void ingest(Key_values& key_values, const std::string& sst_path);
+
    template <typename Iterable>
    void erase(const Iterable& keys);
 
@@ -149,6 +164,19 @@ class session<rocksdb_t> {
    /// \brief The column family associated with this instance of the RocksDB session.
    std::shared_ptr<const rocksdb::ColumnFamilyHandle> column_family() const;
 
+   /// \brief Returns the value of an integer RocksDB property (e.g. "rocksdb.block-cache-usage") of the active column
+   /// family, or an empty optional if the property is not known.
+   std::optional<uint64_t> int_property(const std::string& name) const;
+
+   /// \brief The number of point reads this session has issued to RocksDB.
+   uint64_t reads() const;
+
+   /// \brief Returns a session that sees the database as it is at the time of the call.
+   /// \remarks RocksDB reads are thread safe, so the returned session can be used from another thread while this
+   /// session keeps writing, as long as each session is only used by one thread at a time. The returned session must
+   /// only be read from. Its snapshot is released when the last copy of it is destroyed.
+   session read_snapshot() const;
+
  protected:
    template <typename Iterable>
    const std::pair<std::vector<std::pair<shared_bytes, shared_bytes>>, std::unordered_set<shared_bytes>>
@@ -173,9 +201,11 @@ class session<rocksdb_t> {
  private:
    std::shared_ptr<rocksdb::DB>                 m_db;
    std::shared_ptr<rocksdb::ColumnFamilyHandle> m_column_family;
+   std::shared_ptr<const rocksdb::Snapshot>     m_snapshot;
    rocksdb::ReadOptions                         m_read_options;
    rocksdb::ReadOptions                         m_iterator_read_options;
    rocksdb::WriteOptions                        m_write_options;
+   uint64_t                                     m_reads{ 0 };
 
    /// \brief The cache of RocksDB iterators.
    mutable std::vector<std::unique_ptr<rocksdb::Iterator>> m_iterators;
@@ -189,15 +219,26 @@ inline session<rocksdb_t> make_session(std::shared_ptr<rocksdb::DB> db, size_t m
 }
 
 inline session<rocksdb_t>::session(std::shared_ptr<rocksdb::DB> db, size_t max_iterators)
+    : session{ std::move(db), max_iterators, nullptr } {}
+
+inline session<rocksdb_t>::session(std::shared_ptr<rocksdb::DB> db, size_t max_iterators,
+                                   std::shared_ptr<const rocksdb::Snapshot> snapshot)
     : m_db{ [&]() {
          EOS_ASSERT(db, eosio::chain::database_exception, "db parameter cannot be null");
          return std::move(db);
       }() },
+      m_snapshot{ std::move(snapshot) },
+      m_read_options{ [&]() {
+         auto read_options     = rocksdb::ReadOptions{};
+         read_options.snapshot = m_snapshot.get();
+         return read_options;
+      }() },
       m_iterator_read_options{ [&]() {
          auto read_options                                 = rocksdb::ReadOptions{};
          read_options.verify_checksums                     = false;
          read_options.fill_cache                           = false;
          read_options.background_purge_on_iterator_cleanup = true;
+         read_options.snapshot                             = m_snapshot.get();
          return read_options;
       }() },
       m_iterators{ [&]() {
@@ -232,6 +273,7 @@ inline std::optional<shared_bytes> session<rocksdb_t>::read(const shared_bytes&
    auto key_slice      = rocksdb::Slice{ key.data(), key.size() };
    auto pinnable_value = rocksdb::PinnableSlice{};
    auto status         = m_db->Get(m_read_options, column_family_(), key_slice, &pinnable_value);
+   ++m_reads;
 
    if (status.code() != rocksdb::Status::Code::kOk) {
       return {};
@@ -272,6 +314,7 @@ session<rocksdb_t>::read_(const Iterable& keys) {
 
    auto values = std::vector<std::string>{};
    values.reserve(key_slices.size());
+   m_reads += key_slices.size();
    auto status = m_db->MultiGet(m_read_options, { key_slices.size(), column_family_() }, key_slices, &values);
 
    auto kvs = std::vector<std::pair<shared_bytes, shared_bytes>>{};
@@ -307,12 +350,47 @@ void session<rocksdb_t>::write(const Iterable& key_values) {
    auto status = m_db->Write(m_write_options, &batch);
 }
 
+template <typename Key_values>
+void session<rocksdb_t>::ingest(Key_values& key_values, const std::string& sst_path) {
+   if (key_values.empty()) {
+      return;
+   }
+
+   auto        options    = m_db->GetOptions(column_family_());
+   const auto* comparator = options.comparator;
+   std::sort(key_values.begin(), key_values.end(), [comparator](const auto& lhs, const auto& rhs) {
+      return comparator->Compare({ lhs.first.data(), lhs.first.size() }, { rhs.first.data(), rhs.first.size() }) < 0;
+   });
+
+   auto writer = rocksdb::SstFileWriter{ rocksdb::EnvOptions{}, options, column_family_() };
+   auto status = writer.Open(sst_path);
+   EOS_ASSERT(status.ok(), eosio::chain::database_exception, "unable to create SST file ${f}: ${s}",
+              ("f", sst_path)("s", status.ToString()));
+   for (const auto& kv : key_values) {
+      status = writer.Put({ kv.first.data(), kv.first.size() }, { kv.second.data(), kv.second.size() });
+      EOS_ASSERT(status.ok(), eosio::chain::database_exception, "unable to add key to SST file ${f}: ${s}",
+                 ("f", sst_path)("s", status.ToString()));
+   }
+   status = writer.Finish();
+   EOS_ASSERT(status.ok(), eosio::chain::database_exception, "unable to finish SST file ${f}: ${s}",
+              ("f", sst_path)("s", status.ToString()));
+
+   auto ingest_options       = rocksdb::IngestExternalFileOptions{};
+   ingest_options.move_files = true;
+   status                    = m_db->IngestExternalFile(column_family_(), { sst_path }, ingest_options);
+   EOS_ASSERT(status.ok(), eosio::chain::database_exception, "unable to ingest SST file ${f}: ${s}",
+              ("f", sst_path)("s", status.ToString()));
+}
+
 template <typename Iterable>
 void session<rocksdb_t>::erase(const Iterable& keys) {
+   auto batch = rocksdb::WriteBatch{ 1024 * 1024 };
+
    for (const auto& key : keys) {
-      auto key_slice = rocksdb::Slice{ key.data(), key.size() };
-      auto status    = m_db->Delete(m_write_options, column_family_(), key_slice);
+      batch.Delete(column_family_(), { key.data(), key.size() });
    }
+
+   auto status = m_db->Write(m_write_options, &batch);
 }
 
 template <typename Other_data_store, typename Iterable>
@@ -353,7 +431,15 @@ inline typename session<rocksdb_t>::iterator session<rocksdb_t>::find(const shar
       it.Seek(key_slice);
       if (it.Valid() && it.key().compare(key_slice) != 0) {
          // Get an invalid iterator
-         it.Refresh();
+         if (m_snapshot) {
+            // Refresh is not supported on iterators bound to a snapshot.
+            it.SeekToLast();
+            if (it.Valid()) {
+               it.Next();
+            }
+         } else {
+            it.Refresh();
+         }
       }
    };
    return make_iterator_(predicate);
@@ -397,6 +483,26 @@ inline std::shared_ptr<const rocksdb::ColumnFamilyHandle> session<rocksdb_t>::co
    return m_column_family;
 }
 
+inline std::optional<uint64_t> session<rocksdb_t>::int_property(const std::string& name) const {
+   auto value = uint64_t{ 0 };
+   if (!m_db || !m_db->GetIntProperty(column_family_(), name, &value)) {
+      return {};
+   }
+   return value;
+}
+
+inline uint64_t session<rocksdb_t>::reads() const { return m_reads; }
+
+inline session<rocksdb_t> session<rocksdb_t>::read_snapshot() const {
+   auto db       = m_db;
+   auto snapshot = std::shared_ptr<const rocksdb::Snapshot>{ m_db->GetSnapshot(),
+                                                             [db](const rocksdb::Snapshot* s) { db->ReleaseSnapshot(s); } };
+   // Iterators are created on demand so they pick up the column family below.
+   auto result            = session{ m_db, 0, std::move(snapshot) };
+   result.m_column_family = m_column_family;
+   return result;
+}
+
 inline rocksdb::ColumnFamilyHandle* session<rocksdb_t>::column_family_() const {
    if (m_column_family) {
       return m_column_family.get();
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <iterator>
+#include <map>
 #include <optional>
 #include <queue>
 #include <set>
@@ -7,6 +9,7 @@
 #include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <variant>
 
 #include <b1/session/shared_bytes.hpp>
@@ -20,6 +23,61 @@ struct overloaded : Ts... {
 template <class... Ts>
 overloaded(Ts...) -> overloaded<Ts...>;
 
+/// \brief An ordered map with an additional hash index over its keys.
+/// \remarks Ordered operations (iteration, lower_bound) go through the underlying std::map, while find and
+/// emplace of a key that is already present are answered by the hash index without walking the tree.  The
+/// iterators are the std::map's, so they remain valid across inserts.  Elements are only ever removed all at once
+/// through clear().
+template <typename Key, typename T>
+class hashed_map {
+ public:
+   using map_type       = std::map<Key, T>;
+   using key_type       = Key;
+   using mapped_type    = T;
+   using value_type     = typename map_type::value_type;
+   using iterator       = typename map_type::iterator;
+   using const_iterator = typename map_type::const_iterator;
+
+   iterator       begin() { return m_map.begin(); }
+   const_iterator begin() const { return m_map.begin(); }
+   iterator       end() { return m_map.end(); }
+   const_iterator end() const { return m_map.end(); }
+
+   bool   empty() const { return m_map.empty(); }
+   size_t size() const { return m_map.size(); }
+
+   iterator find(const Key& key) {
+      auto it = m_index.find(key);
+      return it == m_index.end() ? m_map.end() : it->second;
+   }
+
+   const_iterator find(const Key& key) const {
+      auto it = m_index.find(key);
+      return it == m_index.end() ? m_map.end() : const_iterator{ it->second };
+   }
+
+   iterator       lower_bound(const Key& key) { return m_map.lower_bound(key); }
+   const_iterator lower_bound(const Key& key) const { return m_map.lower_bound(key); }
+
+   std::pair<iterator, bool> emplace(const Key& key, T&& value) {
+      if (auto it = m_index.find(key); it != m_index.end()) {
+         return { it->second, false };
+      }
+      auto result = m_map.emplace(key, std::move(value));
+      m_index.emplace(key, result.first);
+      return result;
+   }
+
+   void clear() {
+      m_index.clear();
+      m_map.clear();
+   }
+
+ private:
+   map_type                          m_map;
+   std::unordered_map<Key, iterator> m_index;
+};
+
 /// \brief Defines a session for reading/write data to a cache and persistent data store.
 /// \tparam Parent The parent type of this session
 /// \remarks Specializations of this type can be created to create new parent types that
@@ -42,11 +100,30 @@ class session {
       shared_bytes value;
    };
 
+   /// \brief Describes the contents of a session's cache and how often reads were served from it.
+   struct session_stats {
+      /// The number of keys held in the cache, including deleted keys and keys only cached for iteration.
+      uint64_t cached_keys{ 0 };
+      /// The number of keys updated in this session.
+      uint64_t updated_keys{ 0 };
+      /// The number of keys deleted in this session.
+      uint64_t deleted_keys{ 0 };
+      /// The number of bytes of keys and values held in the cache.
+      uint64_t cached_bytes{ 0 };
+      /// The number of reads answered by this session without consulting its parent.
+      uint64_t read_hits{ 0 };
+      /// The number of reads that had to be forwarded to the parent.
+      uint64_t read_misses{ 0 };
+   };
+
    using type                = session;
    using parent_type         = Parent;
-   using cache_type          = std::map<shared_bytes, value_state>;
+   using cache_type          = hashed_map<shared_bytes, value_state>;
    using parent_variant_type = std::variant<type*, parent_type*>;
 
+   /// \brief The number of keys pulled from the parent in one step when iterating forward past the cache.
+   static constexpr size_t iterator_prefetch_size = 16;
+
    friend Parent;
 
    /// \brief Defines a key lexicographically ordered, cyclical iterator for traversing a session (which includes
@@ -155,6 +232,14 @@ class session {
    /// \brief Returns the set of keys that have been deleted in this session.
    std::unordered_set<shared_bytes> deleted_keys() const;
 
+   /// \brief Returns statistics describing the cache of this session.
+   /// \remarks This walks the cache, so it is meant for diagnostics rather than the hot path.
+   session_stats stats() const;
+
+   /// \brief Invokes the visitor with each key and its value_state in this session's cache, in key order.
+   template <typename Visitor>
+   void visit_cache(const Visitor& visitor) const;
+
    /// \brief Attaches a new parent to the session.
    void attach(Parent& parent);
 
@@ -168,6 +253,9 @@ class session {
    /// \brief Discards the changes in this session and detachs the session from its parent.
    void undo();
    /// \brief Commits the changes in this session into its parent.
+   /// \remarks When the parent is a session with no changes of its own, e.g. a block session before its first
+   /// transaction is squashed into it, the cache is moved into the parent whole instead of entry by entry. Iterators
+   /// into the parent are invalidated in that case.
    void commit();
 
    std::optional<shared_bytes> read(const shared_bytes& key);
@@ -261,6 +349,10 @@ class session {
  private:
    parent_variant_type m_parent{ static_cast<Parent*>(nullptr) };
    cache_type          m_cache;
+   uint64_t            m_read_hits{ 0 };
+   uint64_t            m_read_misses{ 0 };
+   /// Indicates if any key was written or erased in this session since it was last cleared.
+   bool                m_modified{ false };
 };
 
 template <typename Parent>
@@ -296,6 +388,7 @@ void session<Parent>::prime_cache_() {
 template <typename Parent>
 void session<Parent>::clear() {
    m_cache.clear();
+   m_modified = false;
 }
 
 template <typename Parent>
@@ -309,7 +402,10 @@ session<Parent>::session(session& parent, std::nullptr_t) : m_parent{ &parent }
 }
 
 template <typename Parent>
-session<Parent>::session(session&& other) : m_parent{ std::move(other.m_parent) }, m_cache{ std::move(other.m_cache) } {
+session<Parent>::session(session&& other)
+    : m_parent{ std::move(other.m_parent) }, m_cache{ std::move(other.m_cache) },
+      m_read_hits{ std::exchange(other.m_read_hits, 0) }, m_read_misses{ std::exchange(other.m_read_misses, 0) },
+      m_modified{ std::exchange(other.m_modified, false) } {
    session* null_parent = nullptr;
    other.m_parent       = null_parent;
 }
@@ -320,8 +416,11 @@ session<Parent>& session<Parent>::operator=(session&& other) {
       return *this;
    }
 
-   m_parent = std::move(other.m_parent);
-   m_cache  = std::move(other.m_cache);
+   m_parent      = std::move(other.m_parent);
+   m_cache       = std::move(other.m_cache);
+   m_read_hits   = std::exchange(other.m_read_hits, 0);
+   m_read_misses = std::exchange(other.m_read_misses, 0);
+   m_modified    = std::exchange(other.m_modified, false);
 
    session* null_parent = nullptr;
    other.m_parent       = null_parent;
@@ -444,6 +543,29 @@ typename session<Parent>::cache_type::iterator session<Parent>::update_iterator_
    return it;
 }
 
+template <typename Parent>
+typename session<Parent>::session_stats session<Parent>::stats() const {
+   auto result        = session_stats{};
+   result.cached_keys = m_cache.size();
+   result.read_hits   = m_read_hits;
+   result.read_misses = m_read_misses;
+   for (const auto& it : m_cache) {
+      result.cached_bytes += it.first.size() + it.second.value.size();
+      if (it.second.deleted) {
+         ++result.deleted_keys;
+      } else if (it.second.updated) {
+         ++result.updated_keys;
+      }
+   }
+   return result;
+}
+
+template <typename Parent>
+template <typename Visitor>
+void session<Parent>::visit_cache(const Visitor& visitor) const {
+   for (const auto& it : m_cache) { visitor(it.first, it.second); }
+}
+
 template <typename Parent>
 std::unordered_set<shared_bytes> session<Parent>::updated_keys() const {
    auto results = std::unordered_set<shared_bytes>{};
@@ -491,6 +613,26 @@ void session<Parent>::commit() {
       return;
    }
 
+   // The parent's cache only holds values read through it, which this session's cache supersedes: this session read
+   // through the parent, so its cache, including the order of keys known to be adjacent, describes the same data.
+   auto move_to_parent = [&](session& parent) {
+      parent.m_cache    = std::move(m_cache);
+      parent.m_modified = m_modified;
+      clear();
+   };
+
+   // Merge into a parent session directly, without collecting the changes first.
+   auto merge_to_parent = [&](session& parent) {
+      for (const auto& p : m_cache) {
+         if (p.second.deleted) {
+            parent.erase(p.first);
+         } else if (p.second.updated) {
+            parent.write(p.first, p.second.value);
+         }
+      }
+      clear();
+   };
+
    auto write_through = [&](auto& ds) {
       auto deletes = std::unordered_set<shared_bytes>{};
       auto updates = std::unordered_map<shared_bytes, shared_bytes>{};
@@ -519,7 +661,15 @@ void session<Parent>::commit() {
             if (!p) {
                return;
             }
-            write_through(*p);
+            if constexpr (std::is_same_v<std::decay_t<decltype(*p)>, session>) {
+               if (!p->m_modified) {
+                  move_to_parent(*p);
+               } else {
+                  merge_to_parent(*p);
+               }
+            } else {
+               write_through(*p);
+            }
          },
          m_parent);
 }
@@ -532,13 +682,16 @@ std::optional<shared_bytes> session<Parent>::read(const shared_bytes& key) {
    auto it = m_cache.find(key);
    if (it != std::end(m_cache) && it->second.deleted) {
       // key has been deleted at this level.
+      ++m_read_hits;
       return {};
    }
 
    if (it != std::end(m_cache) && it->second.value) {
+      ++m_read_hits;
       return it->second.value;
    }
 
+   ++m_read_misses;
    auto value = std::optional<shared_bytes>{};
    std::visit(
          [&](auto* p) {
@@ -563,6 +716,7 @@ void session<Parent>::write(const shared_bytes& key, const shared_bytes& value)
    it->second.value   = value;
    it->second.deleted = false;
    it->second.updated = true;
+   m_modified         = true;
 }
 
 template <typename Parent>
@@ -598,6 +752,7 @@ void session<Parent>::erase(const shared_bytes& key) {
    auto it            = update_iterator_cache_(key);
    it->second.deleted = true;
    it->second.updated = false;
+   m_modified         = true;
    ++it->second.version;
 }
 
@@ -842,47 +997,56 @@ void session<Parent>::session_iterator<Iterator_traits>::move_next_() {
    auto move         = [](auto& it) { ++it; };
    auto test         = [](auto& it) { return it->second.next_in_cache; };
    auto update_cache = [&](auto& it) mutable {
-      auto value = std::optional<shared_bytes>{};
-
-      auto pending_key = eosio::session::shared_bytes{};
-      auto end         = std::end(m_active_session->m_cache);
-      if (it != end) {
-         ++it;
-         if (it != end) {
-            pending_key = it->first;
-         }
-         --it;
-      }
+      auto& cache = m_active_session->m_cache;
+      auto  end   = std::end(cache);
 
-      auto key = std::visit(
+      return std::visit(
             [&](auto* p) {
-               auto pit = p->lower_bound(it->first);
-               if (pit != std::end(*p) && pit.key() == it->first) {
+               auto pit  = p->lower_bound(it->first);
+               auto pend = std::end(*p);
+               if (pit != pend && pit.key() == it->first) {
                   ++pit;
                }
-               value = (*pit).second;
-               return pit.key();
-            },
-            m_active_session->m_parent);
 
-      // We have two candidates for the next key.
-      // 1. The next key in order in this sessions cache.
-      // 2. The next key in lexicographical order retrieved from the sessions parent.
-      // Choose which one it is.
-      if (!key || (pending_key && pending_key < key)) {
-         key = pending_key;
-      }
+               // Link up to iterator_prefetch_size keys past the current one while the parent iterator is
+               // positioned, so a range scan only has to seek the parent once per batch instead of once per key.
+               auto current = it;
+               for (size_t i = 0; i < iterator_prefetch_size; ++i) {
+                  auto pending     = std::next(current);
+                  auto pending_key = pending != end ? pending->first : shared_bytes{};
+                  auto key         = pit != pend ? pit.key() : shared_bytes{};
+
+                  // We have two candidates for the next key.
+                  // 1. The next key in order in this sessions cache.
+                  // 2. The next key in lexicographical order retrieved from the sessions parent.
+                  // Choose which one it is.
+                  auto from_parent = key && (!pending_key || !(pending_key < key));
+                  if (!from_parent) {
+                     key = pending_key;
+                  }
+                  if (!key) {
+                     return i > 0;
+                  }
 
-      if (key) {
-         auto nit                            = m_active_session->m_cache.emplace(key, value_state{});
-         nit.first->second.previous_in_cache = true;
-         it->second.next_in_cache            = true;
-         if (nit.second) {
-            nit.first->second.value = std::move(*value);
-         }
-         return true;
-      }
-      return false;
+                  auto nit = cache.emplace(key, value_state{});
+                  if (nit.second) {
+                     nit.first->second.value = *(*pit).second;
+                  }
+                  nit.first->second.previous_in_cache = true;
+                  current->second.next_in_cache       = true;
+                  if (from_parent) {
+                     ++pit;
+                  }
+
+                  current = nit.first;
+                  if (current->second.next_in_cache) {
+                     // The rest of the range is already known to this cache.
+                     break;
+                  }
+               }
+               return true;
+            },
+            m_active_session->m_parent);
    };
 
    if (m_active_iterator == std::end(m_active_session->m_cache)) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstring>
 #include <memory>
@@ -199,6 +200,33 @@ namespace details {
       }
       return left_size - right_size;
    }
+
+   template <size_t words>
+   inline std::shared_ptr<char> make_single_allocation_buffer() {
+      auto block = std::make_shared<std::array<uint64_t, words>>();
+      return std::shared_ptr<char>{ block, reinterpret_cast<char*>(block->data()) };
+   }
+
+   /// \brief Allocates a buffer of the given aligned size with at least its last uint64_t, which holds any padding,
+   /// zeroed.
+   /// \remarks Keys and small values make up most buffers, so those of up to 64 bytes are allocated in the same
+   /// block as the shared_ptr control block, one allocation instead of two.
+   inline std::shared_ptr<char> make_buffer(size_t aligned_size) {
+      switch (aligned_size / sizeof(uint64_t)) {
+         case 1: return make_single_allocation_buffer<1>();
+         case 2: return make_single_allocation_buffer<2>();
+         case 3: return make_single_allocation_buffer<3>();
+         case 4: return make_single_allocation_buffer<4>();
+         case 5: return make_single_allocation_buffer<5>();
+         case 6: return make_single_allocation_buffer<6>();
+         case 7: return make_single_allocation_buffer<7>();
+         case 8: return make_single_allocation_buffer<8>();
+         default: break;
+      }
+      auto result = std::shared_ptr<char>{ new char[aligned_size], std::default_delete<char[]>() };
+      std::memset(result.get() + aligned_size - sizeof(uint64_t), 0, sizeof(uint64_t));
+      return result;
+   }
 } // namespace details
 
 /// \brief Constructs a new shared_bytes instance from an array of StringView instances.
@@ -210,8 +238,8 @@ template <typename StringView, std::size_t N>
 shared_bytes make_shared_bytes(std::array<StringView, N>&& data) {
    auto result = shared_bytes{};
 
-   const std::size_t length =
-         std::accumulate(data.begin(), data.end(), 0, [](std::size_t a, const StringView& b) { return a + b.size(); });
+   const std::size_t length = std::accumulate(data.begin(), data.end(), std::size_t{ 0 },
+                                              [](std::size_t a, const StringView& b) { return a + b.size(); });
 
    if (length == 0) {
       return result;
@@ -219,10 +247,8 @@ shared_bytes make_shared_bytes(std::array<StringView, N>&& data) {
 
    result.m_size   = length;
    result.m_offset = details::aligned_size(length) - length;
-   result.m_data   = std::shared_ptr<shared_bytes::underlying_type_t>{
-      new shared_bytes::underlying_type_t[result.m_size + result.m_offset],
-      std::default_delete<shared_bytes::underlying_type_t[]>()
-   };
+   // the buffer comes with its padding zeroed
+   result.m_data   = details::make_buffer(result.m_size + result.m_offset);
    char* chunk_ptr = result.m_data.get();
    for (const auto& view : data) {
       const char* const view_ptr = view.data();
@@ -232,7 +258,6 @@ shared_bytes make_shared_bytes(std::array<StringView, N>&& data) {
       std::memcpy(chunk_ptr, view_ptr, view.size());
       chunk_ptr += view.size();
    }
-   std::memset(chunk_ptr, 0, result.m_offset);
 
    return result;
 }
@@ -245,13 +270,9 @@ shared_bytes::shared_bytes(const T* data, size_t size)
          }
 
          // Make sure to instantiate a buffer that is aligned to the size of a uint64_t.
-         auto  actual_size = m_size + m_offset;
-         auto  result      = std::shared_ptr<underlying_type_t>{ new underlying_type_t[actual_size],
-                                                           std::default_delete<underlying_type_t[]>() };
-         auto* buffer      = result.get();
-         std::memcpy(buffer, reinterpret_cast<const void*>(data), m_size);
-         // Pad with zeros at the end.
-         std::memset(buffer + m_size, 0, m_offset);
+         // It comes with the padding at the end zeroed.
+         auto result = details::make_buffer(m_size + m_offset);
+         std::memcpy(result.get(), reinterpret_cast<const void*>(data), m_size);
          return result;
       }() } {}
 
@@ -262,10 +283,8 @@ inline shared_bytes::shared_bytes(size_t size)
          }
 
          // Make sure to instantiate a buffer that is aligned to the size of a uint64_t.
-         auto actual_size = m_size + m_offset;
-         auto result      = std::shared_ptr<underlying_type_t>{ new underlying_type_t[actual_size],
-                                                           std::default_delete<underlying_type_t[]>() };
-         std::memset(result.get(), 0, actual_size);
+         auto result = details::make_buffer(m_size + m_offset);
+         std::memset(result.get(), 0, m_size + m_offset);
          return result;
       }() } {}
 
@@ -75,6 +75,10 @@ class undo_stack {
    /// \remarks This is the next session to be committed.
    const_variant_type bottom() const;
 
+   /// \brief Invokes the visitor with each session in the stack, from the bottom (oldest) to the top.
+   template <typename Visitor>
+   void visit_sessions(const Visitor& visitor) const;
+
    void open();
    void close();
 
@@ -212,6 +216,12 @@ typename undo_stack<Session>::const_variant_type undo_stack<Session>::bottom() c
    return { *m_head, nullptr };
 }
 
+template <typename Session>
+template <typename Visitor>
+void undo_stack<Session>::visit_sessions(const Visitor& visitor) const {
+   for (const auto& session : m_sessions) { visitor(session); }
+}
+
 template <typename Session>
 void undo_stack<Session>::open() {
    if (m_datadir.empty())
@@ -1,5 +1,6 @@
 #include "data_store_tests.hpp"
 #include <b1/session/rocks_session.hpp>
+#include <boost/filesystem.hpp>
 
 using namespace eosio::session;
 using namespace eosio::session_tests;
@@ -110,4 +111,64 @@ BOOST_AUTO_TEST_CASE(rocks_session_iterator_key_order_test) {
    }
 }
 
+BOOST_AUTO_TEST_CASE(rocks_session_read_snapshot_test) {
+   auto datastore = eosio::session_tests::make_session("/tmp/rocks_snapshot");
+   datastore.write(shared_bytes("a", 1), shared_bytes("1", 1));
+   datastore.write(shared_bytes("c", 1), shared_bytes("3", 1));
+
+   auto snapshot = datastore.read_snapshot();
+   datastore.write(shared_bytes("b", 1), shared_bytes("2", 1));
+   datastore.write(shared_bytes("a", 1), shared_bytes("4", 1));
+   datastore.erase(shared_bytes("c", 1));
+
+   // the snapshot still sees the state from before the writes
+   BOOST_REQUIRE(*snapshot.read(shared_bytes("a", 1)) == shared_bytes("1", 1));
+   BOOST_REQUIRE(!snapshot.read(shared_bytes("b", 1)).has_value());
+   BOOST_REQUIRE(*snapshot.read(shared_bytes("c", 1)) == shared_bytes("3", 1));
+   BOOST_REQUIRE(snapshot.find(shared_bytes("b", 1)) == std::end(snapshot));
+
+   auto keys = std::vector<shared_bytes>{};
+   for (auto it = std::begin(snapshot); it != std::end(snapshot); ++it) { keys.push_back(it.key()); }
+   BOOST_REQUIRE(keys == (std::vector<shared_bytes>{ shared_bytes("a", 1), shared_bytes("c", 1) }));
+
+   // while the live session sees the new state
+   BOOST_REQUIRE(*datastore.read(shared_bytes("a", 1)) == shared_bytes("4", 1));
+   BOOST_REQUIRE(*datastore.read(shared_bytes("b", 1)) == shared_bytes("2", 1));
+   BOOST_REQUIRE(!datastore.read(shared_bytes("c", 1)).has_value());
+}
+
+BOOST_AUTO_TEST_CASE(rocks_session_ingest_test) {
+   auto datastore = eosio::session_tests::make_session("/tmp/rocks_ingest");
+   datastore.write(shared_bytes("b", 1), shared_bytes("2", 1));
+
+   // unsorted, the file is sorted before it is written
+   auto key_values = std::vector<std::pair<shared_bytes, shared_bytes>>{
+      { shared_bytes("d", 1), shared_bytes("4", 1) },
+      { shared_bytes("a", 1), shared_bytes("1", 1) },
+      { shared_bytes("c", 1), shared_bytes("3", 1) },
+   };
+   const auto sst_path = std::string{ "/tmp/rocks_ingest.sst" };
+   datastore.ingest(key_values, sst_path);
+
+   BOOST_REQUIRE(*datastore.read(shared_bytes("a", 1)) == shared_bytes("1", 1));
+   BOOST_REQUIRE(*datastore.read(shared_bytes("b", 1)) == shared_bytes("2", 1));
+   BOOST_REQUIRE(*datastore.read(shared_bytes("d", 1)) == shared_bytes("4", 1));
+
+   auto keys = std::vector<shared_bytes>{};
+   for (auto it = std::begin(datastore); it != std::end(datastore); ++it) { keys.push_back(it.key()); }
+   BOOST_REQUIRE(keys == (std::vector<shared_bytes>{ shared_bytes("a", 1), shared_bytes("b", 1), shared_bytes("c", 1),
+                                                     shared_bytes("d", 1) }));
+
+   // the file was moved into the database
+   BOOST_REQUIRE(!boost::filesystem::exists(sst_path));
+
+   // duplicate keys can not be ingested
+   auto duplicates = std::vector<std::pair<shared_bytes, shared_bytes>>{
+      { shared_bytes("e", 1), shared_bytes("5", 1) },
+      { shared_bytes("e", 1), shared_bytes("6", 1) },
+   };
+   BOOST_REQUIRE_THROW(datastore.ingest(duplicates, sst_path), eosio::chain::database_exception);
+   boost::filesystem::remove(sst_path);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -79,6 +79,44 @@ void perform_session_level_test(const std::string& dbpath, bool always_undo = fa
 
 BOOST_AUTO_TEST_SUITE(session_tests)
 
+BOOST_AUTO_TEST_CASE(hashed_map_test) {
+   auto map  = hashed_map<shared_bytes, int>{};
+   auto keys = std::vector<std::string>{ "d", "b", "a", "c", "bb" };
+   for (size_t i = 0; i < keys.size(); ++i) {
+      auto result = map.emplace(shared_bytes(keys[i].data(), keys[i].size()), static_cast<int>(i));
+      BOOST_REQUIRE(result.second);
+      BOOST_REQUIRE(result.first->second == static_cast<int>(i));
+   }
+   BOOST_REQUIRE(map.size() == keys.size());
+
+   // emplacing an existing key returns the existing element
+   auto existing = map.emplace(shared_bytes("b", 1), 100);
+   BOOST_REQUIRE(!existing.second);
+   BOOST_REQUIRE(existing.first->second == 1);
+   BOOST_REQUIRE(map.size() == keys.size());
+
+   // point lookups agree with the ordered map
+   for (const auto& key : keys) {
+      auto it = map.find(shared_bytes(key.data(), key.size()));
+      BOOST_REQUIRE(it != std::end(map));
+      BOOST_REQUIRE(it == map.lower_bound(shared_bytes(key.data(), key.size())));
+   }
+   BOOST_REQUIRE(map.find(shared_bytes("e", 1)) == std::end(map));
+
+   // iteration is in key order
+   auto expected = std::vector<std::string>{ "a", "b", "bb", "c", "d" };
+   auto it       = std::begin(map);
+   for (const auto& key : expected) {
+      BOOST_REQUIRE(it->first == shared_bytes(key.data(), key.size()));
+      ++it;
+   }
+   BOOST_REQUIRE(it == std::end(map));
+
+   map.clear();
+   BOOST_REQUIRE(map.empty());
+   BOOST_REQUIRE(map.find(shared_bytes("a", 1)) == std::end(map));
+}
+
 BOOST_AUTO_TEST_CASE(session_create_test) {
    {
       auto session1 = eosio::session_tests::make_session("/tmp/session18");
@@ -179,6 +217,77 @@ BOOST_AUTO_TEST_CASE(session_iterator_key_order_test) {
    }
 }
 
+BOOST_AUTO_TEST_CASE(session_iterator_prefetch_test) {
+   auto make_key = [](size_t i, const std::string& suffix = "") {
+      auto key = std::string{ "k" } + (i < 10 ? "0" : "") + std::to_string(i) + suffix;
+      return shared_bytes(key.data(), key.size());
+   };
+
+   // Enough keys in the parent to span several prefetch batches.
+   auto root_session  = eosio::session_tests::make_session("/tmp/session_prefetch");
+   using session_type = eosio::session::session<decltype(root_session)>;
+   auto expected      = std::map<shared_bytes, shared_bytes>{};
+   for (size_t i = 0; i < 3 * session_type::iterator_prefetch_size; ++i) {
+      root_session.write(make_key(i), make_key(i));
+      expected.emplace(make_key(i), make_key(i));
+   }
+
+   // Interleave keys that only exist in the child with overwrites and deletes of parent keys.
+   auto child = session_type(root_session);
+   for (size_t i = 0; i < 3 * session_type::iterator_prefetch_size; i += 5) {
+      child.write(make_key(i, "a"), make_key(i, "a"));
+      expected[make_key(i, "a")] = make_key(i, "a");
+   }
+   for (size_t i = 3; i < 3 * session_type::iterator_prefetch_size; i += 7) {
+      child.erase(make_key(i));
+      expected.erase(make_key(i));
+   }
+   child.write(make_key(20), make_key(20, "b"));
+   expected[make_key(20)] = make_key(20, "b");
+
+   auto eit = std::begin(expected);
+   for (auto it = std::begin(child); it != std::end(child); ++it, ++eit) {
+      BOOST_REQUIRE(eit != std::end(expected));
+      auto kv = *it;
+      BOOST_REQUIRE(kv.first == eit->first);
+      BOOST_REQUIRE(kv.second.has_value());
+      BOOST_REQUIRE(*kv.second == eit->second);
+   }
+   BOOST_REQUIRE(eit == std::end(expected));
+}
+
+BOOST_AUTO_TEST_CASE(session_stats_test) {
+   auto root_session  = eosio::session_tests::make_session("/tmp/session_stats");
+   using session_type = eosio::session::session<decltype(root_session)>;
+   for (const auto& key : { "a", "b", "m", "n", "z" }) { root_session.write(shared_bytes(key, 1), shared_bytes("12", 2)); }
+
+   auto child = session_type(root_session);
+   child.write(shared_bytes("c", 1), shared_bytes("567", 3));
+   child.erase(shared_bytes("b", 1));
+
+   BOOST_REQUIRE(child.read(shared_bytes("c", 1)).has_value());
+   BOOST_REQUIRE(!child.read(shared_bytes("b", 1)).has_value());
+   // "n" is not among the keys the child cached around its own writes
+   auto reads = root_session.reads();
+   BOOST_REQUIRE(child.read(shared_bytes("n", 1)).has_value());
+   BOOST_REQUIRE(root_session.reads() == reads + 1);
+
+   auto stats = child.stats();
+   BOOST_REQUIRE(stats.updated_keys == 1);
+   BOOST_REQUIRE(stats.deleted_keys == 1);
+   BOOST_REQUIRE(stats.read_hits == 2);
+   BOOST_REQUIRE(stats.read_misses == 1);
+
+   auto keys  = size_t{ 0 };
+   auto bytes = size_t{ 0 };
+   child.visit_cache([&](const auto& key, const auto& state) {
+      ++keys;
+      bytes += key.size() + state.value.size();
+   });
+   BOOST_REQUIRE(stats.cached_keys == keys);
+   BOOST_REQUIRE(stats.cached_bytes == bytes);
+}
+
 BOOST_AUTO_TEST_CASE(session_level_test_undo_sometimes) {
    eosio::session_tests::perform_session_level_test("/tmp/session22");
 }
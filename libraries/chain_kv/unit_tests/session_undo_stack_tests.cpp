@@ -93,4 +93,49 @@ BOOST_AUTO_TEST_CASE(undo_stack_test) {
                 int_t{});
 }
 
+BOOST_AUTO_TEST_CASE(undo_stack_squash_into_unmodified_session_test) {
+   auto data_store    = eosio::session::make_session(make_rocks_db(), 16);
+   auto undo          = eosio::session::undo_stack(data_store);
+   auto session_kvs_1 = std::unordered_map<uint16_t, uint16_t>{
+      { 1, 100 }, { 2, 200 }, { 3, 300 }, { 4, 400 }, { 5, 500 },
+   };
+   write(data_store, session_kvs_1);
+
+   auto top = [&]() -> decltype(undo)::session_type& {
+      return *std::get<decltype(undo)::session_type*>(undo.top().holder());
+   };
+
+   // Squash into a session which only read through to the data store, its cache is replaced by the top's.
+   undo.push();
+   uint16_t read_key = 1;
+   BOOST_REQUIRE(top().read(eosio::session::shared_bytes(&read_key, 1)).has_value());
+   undo.push();
+   auto session_kvs_2 = std::unordered_map<uint16_t, uint16_t>{
+      { 2, 2000 }, { 6, 600 }, { 7, 700 },
+   };
+   write(top(), session_kvs_2);
+   uint16_t erased_key = 3;
+   top().erase(eosio::session::shared_bytes(&erased_key, 1));
+   undo.squash();
+   BOOST_REQUIRE(undo.revision() == 1);
+
+   auto expected = collapse({ session_kvs_1, session_kvs_2 });
+   expected.erase(erased_key);
+   verify_equal(top(), expected, int_t{});
+
+   // The squashed session is modified now, the next squash merges into it.
+   undo.push();
+   auto session_kvs_3 = std::unordered_map<uint16_t, uint16_t>{
+      { 3, 3000 }, { 8, 800 },
+   };
+   write(top(), session_kvs_3);
+   undo.squash();
+   verify_equal(top(), collapse({ expected, session_kvs_3 }), int_t{});
+
+   // Undoing the squashed session leaves the data store untouched.
+   undo.undo();
+   BOOST_REQUIRE(undo.empty());
+   verify_equal(data_store, session_kvs_1, int_t{});
+}
+
 BOOST_AUTO_TEST_SUITE_END();
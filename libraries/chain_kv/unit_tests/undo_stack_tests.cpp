@@ -453,4 +453,45 @@ BOOST_AUTO_TEST_CASE(test_commit) {
    commit_tests(true, 64 * 1024 * 1024);
 }
 
+BOOST_AUTO_TEST_CASE(test_ingest) {
+   boost::filesystem::remove_all("test-ingest-db");
+   chain_kv::database   db{ "test-ingest-db", true };
+   chain_kv::undo_stack undo_stack{ db, bytes{ 0x10 } };
+   {
+      chain_kv::write_session session{ db };
+      session.set({ 0x20, 0x01 }, to_slice({ 0x40 }));
+      session.set({ 0x20, 0x02 }, to_slice({ 0x50 }));
+      session.write_changes(undo_stack);
+   }
+   {
+      chain_kv::write_session session{ db };
+      session.set({ 0x20, 0x03 }, to_slice({ 0x60 }));
+      session.erase({ 0x20, 0x01 });
+      session.set({ 0x20, 0x00 }, to_slice({}));
+      session.get({ 0x20, 0x02 }); // unchanged values aren't written
+      BOOST_REQUIRE_EQUAL(session.num_changes, 3u);
+      session.ingest_changes(undo_stack, "test-ingest-db/ingest.sst");
+      BOOST_REQUIRE_EQUAL(session.num_changes, 0u);
+   }
+   BOOST_REQUIRE(!boost::filesystem::exists("test-ingest-db/ingest.sst"));
+   BOOST_REQUIRE_EQUAL(get_all(db, { 0x20 }), (kv_values{ {
+                                                    { { 0x20, 0x00 }, {} },
+                                                    { { 0x20, 0x02 }, { 0x50 } },
+                                                    { { 0x20, 0x03 }, { 0x60 } },
+                                              } }));
+
+   // nothing changed, nothing to ingest
+   {
+      chain_kv::write_session session{ db };
+      session.set({ 0x20, 0x02 }, to_slice({ 0x50 }));
+      session.ingest_changes(undo_stack, "test-ingest-db/ingest.sst");
+   }
+
+   undo_stack.push();
+   chain_kv::write_session session{ db };
+   session.set({ 0x20, 0x04 }, to_slice({ 0x70 }));
+   KV_REQUIRE_EXCEPTION(session.ingest_changes(undo_stack, "test-ingest-db/ingest.sst"),
+                        "cannot ingest changes while there is an existing undo stack");
+}
+
 BOOST_AUTO_TEST_SUITE_END();
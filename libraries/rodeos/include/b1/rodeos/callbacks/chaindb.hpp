@@ -78,16 +78,8 @@ class iterator_cache {
             result = map_it->second;
          } else {
             // std::cout << "...new it\n";
-            if (iterators.size() > std::numeric_limits<int32_t>::max())
-               throw std::runtime_error("too many iterators");
-            result = iterators.size();
-            iterators.emplace_back();
-            it = &iterators.back();
-            eosio::input_stream stream{ view_it.get_kv()->value.data(), view_it.get_kv()->value.size() };
-            auto row = std::get<0>(eosio::from_bin<eosio::ship_protocol::contract_row>(stream));
-            it->table_index = rk.table_index;
-            it->primary     = row.primary_key;
-            it->value.insert(it->value.end(), row.value.pos, row.value.end);
+            result = add_iterator(rk.table_index, view_it.get_kv()->value);
+            it     = &iterators[result];
          }
       }
       if (!it->view_it)
@@ -95,6 +87,21 @@ class iterator_cache {
       return result;
    }
 
+   // the iterator's view_it is created when it's first incremented
+   int32_t add_iterator(int32_t table_index, const rocksdb::Slice& contract_row) {
+      if (iterators.size() > std::numeric_limits<int32_t>::max())
+         throw std::runtime_error("too many iterators");
+      int32_t result = iterators.size();
+      iterators.emplace_back();
+      auto&               it = iterators.back();
+      eosio::input_stream stream{ contract_row.data(), contract_row.size() };
+      auto                row = std::get<0>(eosio::from_bin<eosio::ship_protocol::contract_row>(stream));
+      it.table_index          = table_index;
+      it.primary              = row.primary_key;
+      it.value.insert(it.value.end(), row.value.pos, row.value.end);
+      return result;
+   }
+
    // Precondition: std::numeric_limits<int32_t>::min() < ei < -1
    // Iterator of -1 is reserved for invalid iterators (i.e. when the appropriate table has not yet been created).
    size_t end_iterator_to_index(int32_t ei) const { return (-ei - 2); }
@@ -178,6 +185,29 @@ class iterator_cache {
                                                                eosio::name{ "primary" }, code, table, scope, key)));
       return get_iterator(rk, std::move(it));
    }
+   // a point lookup of the row; doesn't position a view iterator like lower_bound does
+   int32_t find(uint64_t code, uint64_t scope, uint64_t table, uint64_t key) {
+      int32_t table_index = get_table_index({ code, table, scope });
+      if (table_index < 0)
+         return -1;
+      auto map_it = key_to_iterator_index.find({ table_index, key });
+      if (map_it != key_to_iterator_index.end())
+         return map_it->second;
+      auto row = view.get(state_account.value,
+                          chain_kv::to_slice(eosio::convert_to_key(std::make_tuple(
+                                (uint8_t)0x01, eosio::name{ "contract.row" }, eosio::name{ "primary" }, code, table,
+                                scope, key))));
+      if (!row)
+         return index_to_end_iterator(table_index);
+      return add_iterator(table_index, chain_kv::to_slice(*row));
+   }
+
+   int32_t end(uint64_t code, uint64_t scope, uint64_t table) {
+      int32_t table_index = get_table_index({ code, table, scope });
+      if (table_index < 0)
+         return -1;
+      return index_to_end_iterator(table_index);
+   }
 }; // iterator_cache
 
 struct chaindb_state {
@@ -218,7 +248,7 @@ struct chaindb_callbacks {
    }
 
    int db_find_i64(uint64_t code, uint64_t scope, uint64_t table, uint64_t id) {
-      throw std::runtime_error("unimplemented: db_find_i64");
+      return get_iterator_cache().find(code, scope, table, id);
    }
 
    int db_lowerbound_i64(uint64_t code, uint64_t scope, uint64_t table, uint64_t id) {
@@ -230,7 +260,7 @@ struct chaindb_callbacks {
    }
 
    int db_end_i64(uint64_t code, uint64_t scope, uint64_t table) {
-      throw std::runtime_error("unimplemented: db_end_i64");
+      return get_iterator_cache().end(code, scope, table);
    }
 
    template <typename Rft>
@@ -52,4 +52,27 @@ std::optional<std::pair<std::shared_ptr<const chain_kv::bytes>, T>> get_state_ro
    return result;
 }
 
+// Calls f(row) for the rows of a secondary index whose keys start with prefix, in index order, until f returns false.
+// Only the matching index entries are visited; each row is a point lookup.
+template <typename T, typename K, typename F>
+void for_each_state_row_secondary(chain_kv::view& view, const K& prefix, F f) {
+   chain_kv::view::iterator it{ view, state_account.value,
+                                chain_kv::to_slice(eosio::convert_to_key(std::make_tuple((uint8_t)0x01, prefix))) };
+   for (it.move_to_begin(); !it.is_end(); ++it) {
+      auto row = view.get(state_account.value, it.get_kv()->value);
+      if (!row)
+         continue;
+
+      T                   obj;
+      eosio::input_stream stream{ *row };
+      try {
+         from_bin(obj, stream);
+      } catch(std::exception& e) {
+         throw std::runtime_error("An error occurred deserializing state: " + std::string(e.what()));
+      }
+      if (!f(obj))
+         return;
+   }
+}
+
 } // namespace b1::rodeos
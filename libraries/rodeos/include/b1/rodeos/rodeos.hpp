@@ -2,8 +2,11 @@
 #include <b1/chain_kv/chain_kv.hpp>
 #include <b1/rodeos/filter.hpp>
 #include <b1/rodeos/wasm_ql.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <eosio/ship_protocol.hpp>
+#include <deque>
 #include <functional>
+#include <future>
 
 namespace b1::rodeos {
 
@@ -49,9 +52,24 @@ struct rodeos_db_snapshot {
    eosio::checksum256                      irreversible_id = {};
    uint32_t                                first           = 0;
    std::optional<uint32_t>                 writing_block   = {};
+   uint32_t                                decode_threads  = 0;
+   bool                                    bulk_load       = false; // see set_bulk_load
+   bool                                    scope_index     = false; // see enable_scope_index
+   std::unique_ptr<eosio::chain::named_thread_pool> decode_thread_pool = {}; // only if decode_threads > 0
 
    rodeos_db_snapshot(std::shared_ptr<rodeos_db_partition> partition, bool persistent);
 
+   // decode the rows of table deltas on num_threads worker threads; 0 decodes on the calling thread
+   void set_decode_threads(uint32_t num_threads);
+
+   // Load irreversible blocks by ingesting sorted table files instead of writing batches. Only takes effect on an
+   // empty database and ends at the first reversible block.
+   void set_bulk_load(bool enable);
+
+   // Maintain contract_table_scope_kv. Only takes effect on an empty database, so the index is complete; it is then
+   // kept for the life of the database.
+   void enable_scope_index();
+
    void refresh();
    void end_write(bool write_fill);
    void start_block(const eosio::ship_protocol::get_blocks_result_base& result);
@@ -78,6 +96,39 @@ struct rodeos_filter {
 
    void process(rodeos_db_snapshot& snapshot, const eosio::ship_protocol::get_blocks_result_base& result,
                 eosio::input_stream bin, const std::function<void(const char* data, uint64_t size)>& push_data);
+
+   // run the filter on bin with the database seen through view_state
+   void run(db_view_state& view_state, eosio::input_stream bin,
+            const std::function<void(const char* data, uint64_t size)>& push_data);
+};
+
+// Runs a stateless filter on several blocks at once, one instance per thread. A stateless filter
+// neither writes to the database nor reads it; it only transforms the block it's given. Its output
+// is pushed in the order the blocks were processed, on the thread calling process() or drain().
+class rodeos_parallel_filter {
+ public:
+   using push_data_t = std::function<void(const char* data, uint64_t size)>;
+
+   rodeos_parallel_filter(eosio::name name, const std::string& wasm_filename, uint32_t num_threads);
+   ~rodeos_parallel_filter();
+
+   // queue the block for the filter and push the output of the blocks which are done
+   void process(rodeos_db_snapshot& snapshot, const eosio::ship_protocol::get_blocks_result_base& result,
+                eosio::input_stream bin, const push_data_t& push_data);
+
+   // wait for all queued blocks and push their output
+   void drain(const push_data_t& push_data);
+
+ private:
+   using output_t = std::vector<std::vector<char>>;
+
+   void push_front(const push_data_t& push_data);
+
+   const uint32_t                                   max_pending;
+   std::mutex                                       mutex;
+   std::vector<std::unique_ptr<rodeos_filter>>      idle_filters;
+   std::deque<std::future<output_t>>                pending;
+   std::unique_ptr<eosio::chain::named_thread_pool> thread_pool; // destroyed first, tasks use the members above
 };
 
 struct rodeos_query_handler {
@@ -49,6 +49,17 @@ inline bool operator!=(const fill_status_v0& a, fill_status_v0& b) { return !(a
 
 using fill_status_sing = eosio::kv_singleton<fill_status, eosio::name{ "fill.status" }, state_database>;
 
+// Optional indices, maintained since the database was created
+struct index_status_v0 {
+   bool contract_table_scope = {}; // see contract_table_scope_kv
+};
+
+EOSIO_REFLECT(index_status_v0, contract_table_scope)
+
+using index_status = std::variant<index_status_v0>;
+
+using index_status_sing = eosio::kv_singleton<index_status, eosio::name{ "index.status" }, state_database>;
+
 struct block_info_v0 {
    uint32_t                         num                = {};
    eosio::checksum256               id                 = {};
@@ -139,6 +150,28 @@ struct contract_table_kv : eosio::kv_table<contract_table> {
    }
 };
 
+// contract_table_kv which also indexes the tables by (scope, code, table), e.g. to find all the tables holding rows
+// of an account without scanning every table. Only complete in databases created with it; see index_status.
+struct contract_table_scope_kv : eosio::kv_table<contract_table> {
+   index<std::tuple<const eosio::name&, const eosio::name&, const eosio::name&>> primary_index{
+      eosio::name{ "primary" },
+      [](const auto& var) {
+         return std::visit([](const auto& obj) { return std::tie(obj.code, obj.table, obj.scope); }, *var);
+      }
+   };
+   index<std::tuple<const eosio::name&, const eosio::name&, const eosio::name&>> scope_index{
+      eosio::name{ "scope" },
+      [](const auto& var) {
+         return std::visit([](const auto& obj) { return std::tie(obj.scope, obj.code, obj.table); }, *var);
+      }
+   };
+
+   contract_table_scope_kv(eosio::kv_environment environment)
+       : eosio::kv_table<contract_table>{ std::move(environment) } {
+      init(state_account, eosio::name{ "contract.tab" }, state_database, primary_index, scope_index);
+   }
+};
+
 struct contract_row_kv : eosio::kv_table<contract_row> {
    using PT = typename std::tuple<const eosio::name&, const eosio::name&, const eosio::name&, const uint64_t&>;
    index<PT> primary_index{ eosio::name{ "primary" }, [](const auto& var) {
@@ -206,16 +239,38 @@ struct contract_index128_kv : eosio::kv_table<contract_index128> {
    }
 };
 
-template <typename Table, typename D, typename F>
-void store_delta_typed(eosio::kv_environment environment, D& delta, bool bypass_preexist_check, F f) {
-   Table table{ environment };
-   for (auto& row : delta.rows) {
-      f();
-      auto obj = eosio::from_bin<typename Table::value_type>(row.data);
-      if (row.present)
-         table.put(obj);
-      else
-         table.erase(obj);
+// Decodes rows [begin, end) of a table delta into out. Decoders don't touch the database, so a decoder
+// may spread the rows over other threads; the decoded rows are always stored in order by the caller.
+struct serial_row_decoder {
+   template <typename T, typename Rows>
+   void operator()(const Rows& rows, size_t begin, size_t end, std::vector<T>& out) const {
+      out.clear();
+      out.reserve(end - begin);
+      for (size_t i = begin; i < end; ++i) {
+         auto data = rows[i].data;
+         out.push_back(eosio::from_bin<T>(data));
+      }
+   }
+};
+
+// rows decoded at a time; bounds the memory used by large deltas
+static constexpr size_t store_delta_decode_chunk = 10000;
+
+template <typename Table, typename D, typename F, typename Decoder = serial_row_decoder>
+void store_delta_typed(eosio::kv_environment environment, D& delta, bool bypass_preexist_check, F f,
+                       const Decoder& decoder = {}) {
+   Table                                   table{ environment };
+   std::vector<typename Table::value_type> objs;
+   for (size_t begin = 0; begin < delta.rows.size(); begin += store_delta_decode_chunk) {
+      auto end = std::min(begin + store_delta_decode_chunk, delta.rows.size());
+      decoder(delta.rows, begin, end, objs);
+      for (size_t i = begin; i < end; ++i) {
+         f();
+         if (delta.rows[i].present)
+            table.put(objs[i - begin]);
+         else
+            table.erase(objs[i - begin]);
+      }
    }
 }
 
@@ -236,24 +291,29 @@ void store_delta_kv(eosio::kv_environment environment, D& delta, F f) {
    }
 }
 
-template <typename D, typename F>
-inline void store_delta(eosio::kv_environment environment, D& delta, bool bypass_preexist_check, F f) {
+template <typename D, typename F, typename Decoder = serial_row_decoder>
+inline void store_delta(eosio::kv_environment environment, D& delta, bool bypass_preexist_check, F f,
+                        const Decoder& decoder = {}, const index_status_v0& indices = {}) {
    if (delta.name == "global_property")
-      store_delta_typed<global_property_kv>(environment, delta, bypass_preexist_check, f);
+      store_delta_typed<global_property_kv>(environment, delta, bypass_preexist_check, f, decoder);
    if (delta.name == "account")
-      store_delta_typed<account_kv>(environment, delta, bypass_preexist_check, f);
+      store_delta_typed<account_kv>(environment, delta, bypass_preexist_check, f, decoder);
    if (delta.name == "account_metadata")
-      store_delta_typed<account_metadata_kv>(environment, delta, bypass_preexist_check, f);
+      store_delta_typed<account_metadata_kv>(environment, delta, bypass_preexist_check, f, decoder);
    if (delta.name == "code")
-      store_delta_typed<code_kv>(environment, delta, bypass_preexist_check, f);
-   if (delta.name == "contract_table")
-      store_delta_typed<contract_table_kv>(environment, delta, bypass_preexist_check, f);
+      store_delta_typed<code_kv>(environment, delta, bypass_preexist_check, f, decoder);
+   if (delta.name == "contract_table") {
+      if (indices.contract_table_scope)
+         store_delta_typed<contract_table_scope_kv>(environment, delta, bypass_preexist_check, f, decoder);
+      else
+         store_delta_typed<contract_table_kv>(environment, delta, bypass_preexist_check, f, decoder);
+   }
    if (delta.name == "contract_row")
-      store_delta_typed<contract_row_kv>(environment, delta, bypass_preexist_check, f);
+      store_delta_typed<contract_row_kv>(environment, delta, bypass_preexist_check, f, decoder);
    if (delta.name == "contract_index64")
-      store_delta_typed<contract_index64_kv>(environment, delta, bypass_preexist_check, f);
+      store_delta_typed<contract_index64_kv>(environment, delta, bypass_preexist_check, f, decoder);
    if (delta.name == "contract_index128")
-      store_delta_typed<contract_index128_kv>(environment, delta, bypass_preexist_check, f);
+      store_delta_typed<contract_index128_kv>(environment, delta, bypass_preexist_check, f, decoder);
    if (delta.name == "key_value")
       store_delta_kv(environment, delta, f);
 }
@@ -15,19 +15,35 @@ struct shared_state {
    uint32_t                                wasm_cache_size  = {};
    uint64_t                                max_exec_time_ms = {};
    uint32_t                                max_action_return_value_size = {};
+   uint32_t                                state_buffer_size = {}; // bytes reserved for each thread_state's buffers
    std::string                             contract_dir     = {};
    std::shared_ptr<wasm_ql::backend_cache> backend_cache    = {};
-   std::shared_ptr<chain_kv::database>     db;
 
    shared_state(std::shared_ptr<chain_kv::database> db);
    shared_state(const shared_state&) = delete;
    ~shared_state();
 
    shared_state& operator=(const shared_state&) = delete;
+
+   std::shared_ptr<chain_kv::database> get_db() const {
+      std::lock_guard<std::mutex> lock{ db_mutex };
+      return db;
+   }
+
+   // Switch to another database, e.g. a newer checkpoint. Queries which already started keep their database.
+   void set_db(std::shared_ptr<chain_kv::database> new_db) {
+      std::lock_guard<std::mutex> lock{ db_mutex };
+      db = std::move(new_db);
+   }
+
+ private:
+   mutable std::mutex                  db_mutex;
+   std::shared_ptr<chain_kv::database> db;
 };
 
 struct thread_state : action_state, console_state, query_state {
    std::shared_ptr<const shared_state> shared = {};
+   std::shared_ptr<chain_kv::database> db     = {}; // database of the current query; see thread_state_cache
    eosio::vm::wasm_allocator           wa     = {};
 };
 
@@ -40,30 +56,74 @@ class thread_state_cache {
  public:
    thread_state_cache(const std::shared_ptr<const wasm_ql::shared_state>& shared_state) : shared_state(shared_state) {}
 
-   std::unique_ptr<thread_state> get_state() {
+   // Create states ahead of the first requests; creating a wasm allocator maps its whole address space
+   void preallocate(uint32_t num_states) {
       std::lock_guard<std::mutex> lock{ mutex };
-      if (states.empty()) {
-         auto result    = std::make_unique<thread_state>();
-         result->shared = shared_state;
-         return result;
+      while (states.size() < num_states)
+         states.push_back(create_state());
+   }
+
+   std::unique_ptr<thread_state> get_state() {
+      {
+         std::lock_guard<std::mutex> lock{ mutex };
+         if (!states.empty()) {
+            auto result = std::move(states.back());
+            states.pop_back();
+            result->db = shared_state->get_db();
+            return result;
+         }
       }
-      auto result = std::move(states.back());
-      states.pop_back();
+      auto result = create_state();
+      result->db  = shared_state->get_db();
       return result;
    }
 
    void store_state(std::unique_ptr<thread_state> state) {
+      // don't keep a database the shared state moved away from open
+      state->db.reset();
+      // buffers grown by a large query are trimmed, so the pool doesn't pin them
+      auto size = shared_state->state_buffer_size;
+      if (state->action_return_value.capacity() > size) {
+         state->action_return_value = {};
+         state->action_return_value.reserve(size);
+      }
+      if (state->console.capacity() > size) {
+         state->console = {};
+         state->console.reserve(std::min(size, shared_state->max_console_size));
+      }
       std::lock_guard<std::mutex> lock{ mutex };
       states.push_back(std::move(state));
    }
+
+ private:
+   std::unique_ptr<thread_state> create_state() {
+      auto result    = std::make_unique<thread_state>();
+      result->shared = shared_state;
+      result->action_return_value.reserve(shared_state->state_buffer_size);
+      result->console.reserve(std::min(shared_state->state_buffer_size, shared_state->max_console_size));
+      return result;
+   }
 };
 
+// accounts which have a contract in contract_dir
+std::vector<eosio::name> get_local_contracts(const shared_state& shared_state);
+
+// compile an instance of the contract of account in contract_dir and add it to the backend cache, so queries
+// don't wait on the compiler. Queries that find no compiled instance still compile their own.
+void precompile_contract(const shared_state& shared_state, eosio::name account);
+
+// id of the head block written by the cloner; empty if there isn't one yet
+eosio::checksum256 get_head_block_id(const shared_state& shared_state, const std::vector<char>& contract_kv_prefix);
+
 const std::vector<char>& query_get_info(wasm_ql::thread_state&   thread_state,
                                         const std::vector<char>& contract_kv_prefix);
 const std::vector<char>& query_get_block(wasm_ql::thread_state&   thread_state,
                                          const std::vector<char>& contract_kv_prefix, std::string_view body);
 const std::vector<char>& query_get_abi(wasm_ql::thread_state& thread_state, const std::vector<char>& contract_kv_prefix,
                                        std::string_view body);
+// tables holding rows of a scope; needs a database cloned with the scope index
+const std::vector<char>& query_get_tables_by_scope(wasm_ql::thread_state&   thread_state,
+                                                   const std::vector<char>& contract_kv_prefix, std::string_view body);
 const std::vector<char>& query_get_required_keys(wasm_ql::thread_state& thread_state, std::string_view body);
 const std::vector<char>& query_send_transaction(wasm_ql::thread_state&   thread_state,
                                                 const std::vector<char>& contract_kv_prefix, std::string_view body,
@@ -3,11 +3,20 @@
 #include <b1/rodeos/callbacks/kv.hpp>
 #include <b1/rodeos/rodeos_tables.hpp>
 #include <fc/log/trace.hpp>
+#include <fc/scoped_exit.hpp>
+
+#include <future>
 
 namespace b1::rodeos {
 
 namespace ship_protocol = eosio::ship_protocol;
 
+// while bulk loading, changes are ingested once this many are pending; smaller writes use a write batch
+static constexpr size_t bulk_load_min_changes = 100000;
+// rows of a large delta written at a time
+static constexpr size_t delta_write_rows      = 10000;
+static constexpr size_t bulk_load_write_rows  = 250000;
+
 using ship_protocol::get_blocks_result_base;
 using ship_protocol::get_blocks_result_v0;
 using ship_protocol::get_blocks_result_v1;
@@ -35,6 +44,42 @@ rodeos_db_snapshot::rodeos_db_snapshot(std::shared_ptr<rodeos_db_partition> part
       irreversible_id = status.irreversible_id;
       first           = status.first;
    }
+   index_status_sing index_sing{ state_account, view_state, false };
+   if (index_sing.exists())
+      scope_index = std::get<0>(index_sing.get()).contract_table_scope;
+}
+
+void rodeos_db_snapshot::set_decode_threads(uint32_t num_threads) {
+   decode_thread_pool.reset();
+   decode_threads = num_threads;
+   if (num_threads)
+      decode_thread_pool = std::make_unique<eosio::chain::named_thread_pool>("decode", num_threads);
+}
+
+void rodeos_db_snapshot::set_bulk_load(bool enable) {
+   if (!undo_stack)
+      throw std::runtime_error("Can only bulk load persistent snapshots");
+   bulk_load = enable && head == 0;
+   if (bulk_load)
+      ilog("bulk loading irreversible blocks");
+}
+
+void rodeos_db_snapshot::enable_scope_index() {
+   if (!undo_stack)
+      throw std::runtime_error("Can only write to persistent snapshots");
+   if (scope_index)
+      return;
+   if (head != 0) {
+      wlog("the contract table scope index can only be created with the database; it is not maintained");
+      return;
+   }
+   scope_index = true;
+
+   db_view_state view_state{ state_account, *db, *write_session, partition->contract_kv_prefix };
+   view_state.kv_state.enable_write = true;
+   index_status_sing sing{ state_account, view_state, false };
+   sing.set(index_status_v0{ .contract_table_scope = true });
+   sing.store();
 }
 
 void rodeos_db_snapshot::refresh() {
@@ -76,7 +121,10 @@ void rodeos_db_snapshot::end_write(bool write_fill) {
       throw std::runtime_error("Can only write to persistent snapshots");
    if (write_fill)
       write_fill_status();
-   write_session->write_changes(*undo_stack);
+   if (bulk_load && write_session->num_changes >= bulk_load_min_changes)
+      write_session->ingest_changes(*undo_stack, db->rdb->GetName() + "/rodeos-bulk-load.sst");
+   else
+      write_session->write_changes(*undo_stack);
 }
 
 void rodeos_db_snapshot::start_block(const get_blocks_result_base& result) {
@@ -104,6 +152,10 @@ void rodeos_db_snapshot::start_block(const get_blocks_result_base& result) {
       undo_stack->set_revision(result.this_block->block_num, false);
    } else {
       end_write(false);
+      if (bulk_load) {
+         ilog("bulk load reached reversible block ${b}", ("b", result.this_block->block_num));
+         bulk_load = false;
+      }
       undo_stack->commit(std::min(result.last_irreversible.block_num, head));
       undo_stack->push(false);
    }
@@ -168,6 +220,39 @@ namespace {
       auto bytes = cs.extract_as_byte_array();
       return fc::to_hex((const char*)bytes.data(), bytes.size());
    }
+
+   // splits the rows to decode over the decode thread pool
+   struct parallel_row_decoder {
+      static constexpr size_t min_rows_per_thread = 256;
+
+      eosio::chain::named_thread_pool& thread_pool;
+      uint32_t                         num_threads;
+
+      template <typename T, typename Rows>
+      void operator()(const Rows& rows, size_t begin, size_t end, std::vector<T>& out) const {
+         auto per_thread = std::max(min_rows_per_thread, (end - begin + num_threads - 1) / num_threads);
+         if (end - begin <= per_thread)
+            return serial_row_decoder{}(rows, begin, end, out);
+
+         out.clear();
+         out.resize(end - begin);
+         std::vector<std::future<void>> decoded;
+         for (size_t b = begin; b < end; b += per_thread) {
+            auto e = std::min(b + per_thread, end);
+            decoded.push_back(eosio::chain::async_thread_pool(thread_pool.get_executor(), [&rows, &out, begin, b, e] {
+               for (size_t i = b; i < e; ++i) {
+                  auto data      = rows[i].data;
+                  out[i - begin] = eosio::from_bin<T>(data);
+               }
+            }));
+         }
+         // all tasks refer to out, so wait for every one of them before rethrowing
+         for (auto& f : decoded)
+            f.wait();
+         for (auto& f : decoded)
+            f.get();
+      }
+   };
 }
 
 void rodeos_db_snapshot::write_block_info(const ship_protocol::get_blocks_result_v0& result) {
@@ -222,19 +307,26 @@ void rodeos_db_snapshot::write_deltas(uint32_t block_num, eosio::opaque<std::vec
       size_t num_processed = 0;
       std::visit(
          [&](auto& delta_any_v) {
-         store_delta({ view_state }, delta_any_v, head == 0, [&]() {
-            if (delta_any_v.rows.size() > 10000 && !(num_processed % 10000)) {
+         auto progress = [&]() {
+            if (delta_any_v.rows.size() > delta_write_rows && !(num_processed % delta_write_rows)) {
                if (shutdown())
                   throw std::runtime_error("shutting down");
                ilog("block ${b} ${t} ${n} of ${r}",
                     ("b", block_num)("t", delta_any_v.name)("n", num_processed)("r", delta_any_v.rows.size()));
-               if (head == 0) {
+               if (head == 0 && !(num_processed % (bulk_load ? bulk_load_write_rows : delta_write_rows))) {
                   end_write(false);
                   view_state.reset();
                }
             }
             ++num_processed;
-         });
+         };
+         if (decode_thread_pool)
+            store_delta({ view_state }, delta_any_v, head == 0, progress,
+                        parallel_row_decoder{ *decode_thread_pool, decode_threads },
+                        index_status_v0{ .contract_table_scope = scope_index });
+         else
+            store_delta({ view_state }, delta_any_v, head == 0, progress, serial_row_decoder{},
+                        index_status_v0{ .contract_table_scope = scope_index });
       }, delta);
 }
 
@@ -283,12 +375,17 @@ rodeos_filter::rodeos_filter(eosio::name name, const std::string& wasm_filename)
 void rodeos_filter::process(rodeos_db_snapshot& snapshot, const ship_protocol::get_blocks_result_base& result,
                             eosio::input_stream                                         bin,
                             const std::function<void(const char* data, uint64_t size)>& push_data) {
-   // todo: timeout
    snapshot.check_write(result);
-   chaindb_state chaindb_state;
    db_view_state view_state{ name, *snapshot.db, *snapshot.write_session, snapshot.partition->contract_kv_prefix };
    view_state.kv_disk.enable_write = true;
    view_state.kv_ram.enable_write  = true;
+   run(view_state, bin, push_data);
+}
+
+void rodeos_filter::run(db_view_state& view_state, eosio::input_stream bin,
+                        const std::function<void(const char* data, uint64_t size)>& push_data) {
+   // todo: timeout
+   chaindb_state     chaindb_state;
    filter::callbacks cb{ *filter_state, chaindb_state, view_state };
    filter_state->max_console_size = 10000;
    filter_state->console.clear();
@@ -322,6 +419,61 @@ void rodeos_filter::process(rodeos_db_snapshot& snapshot, const ship_protocol::g
    }
 }
 
+rodeos_parallel_filter::rodeos_parallel_filter(eosio::name name, const std::string& wasm_filename,
+                                               uint32_t num_threads)
+    : max_pending{ 2 * num_threads } {
+   for (uint32_t i = 0; i < num_threads; ++i)
+      idle_filters.push_back(std::make_unique<rodeos_filter>(name, wasm_filename));
+   thread_pool = std::make_unique<eosio::chain::named_thread_pool>("filter", num_threads);
+}
+
+rodeos_parallel_filter::~rodeos_parallel_filter() { thread_pool.reset(); }
+
+void rodeos_parallel_filter::process(rodeos_db_snapshot& snapshot, const ship_protocol::get_blocks_result_base& result,
+                                     eosio::input_stream bin, const push_data_t& push_data) {
+   snapshot.check_write(result);
+   // bin only lives until the block is processed
+   auto block = std::make_shared<std::vector<char>>(bin.pos, bin.end);
+   pending.push_back(eosio::chain::async_thread_pool(
+         thread_pool->get_executor(),
+         [this, block, db = snapshot.db, prefix = snapshot.partition->contract_kv_prefix]() {
+            std::unique_ptr<rodeos_filter> filter;
+            {
+               std::lock_guard<std::mutex> lock{ mutex };
+               filter = std::move(idle_filters.back());
+               idle_filters.pop_back();
+            }
+            auto done = fc::make_scoped_exit([&] {
+               std::lock_guard<std::mutex> lock{ mutex };
+               idle_filters.push_back(std::move(filter));
+            });
+
+            // the filter may not write, and reads wouldn't see the state as of this block
+            chain_kv::write_session write_session{ *db };
+            db_view_state           view_state{ filter->name, *db, write_session, prefix };
+            output_t                output;
+            filter->run(view_state, eosio::input_stream{ block->data(), block->size() },
+                        [&](const char* data, uint64_t size) { output.emplace_back(data, data + size); });
+            return output;
+         }));
+
+   while (!pending.empty() && (pending.size() > max_pending ||
+                               pending.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+      push_front(push_data);
+}
+
+void rodeos_parallel_filter::drain(const push_data_t& push_data) {
+   while (!pending.empty())
+      push_front(push_data);
+}
+
+void rodeos_parallel_filter::push_front(const push_data_t& push_data) {
+   auto f = std::move(pending.front());
+   pending.pop_front();
+   for (auto& data : f.get())
+      push_data(data.data(), data.size());
+}
+
 rodeos_query_handler::rodeos_query_handler(std::shared_ptr<rodeos_db_partition>         partition,
                                            std::shared_ptr<const wasm_ql::shared_state> shared_state)
     : partition{ partition }, shared_state{ std::move(shared_state) }, state_cache{ this->shared_state } {}
@@ -5,6 +5,7 @@
 #include <b1/rodeos/callbacks/console.hpp>
 #include <b1/rodeos/callbacks/memory.hpp>
 #include <b1/rodeos/callbacks/unimplemented.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
@@ -172,10 +173,10 @@ shared_state::shared_state(std::shared_ptr<chain_kv::database> db)
 
 shared_state::~shared_state() {}
 
-std::optional<std::vector<uint8_t>> read_code(wasm_ql::thread_state& thread_state, eosio::name account) {
+std::optional<std::vector<uint8_t>> read_code(const wasm_ql::shared_state& shared_state, eosio::name account) {
    std::optional<std::vector<uint8_t>> code;
-   if (!thread_state.shared->contract_dir.empty()) {
-      auto          filename = thread_state.shared->contract_dir + "/" + (std::string)account + ".wasm";
+   if (!shared_state.contract_dir.empty()) {
+      auto          filename = shared_state.contract_dir + "/" + (std::string)account + ".wasm";
       std::ifstream wasm_file(filename, std::ios::binary);
       if (wasm_file.is_open()) {
          ilog("compiling ${f}", ("f", filename));
@@ -221,19 +222,51 @@ std::optional<std::vector<uint8_t>> read_contract(db_view_state& db_view_state,
    return result;
 }
 
+std::unique_ptr<backend_t> create_backend(std::vector<uint8_t>& code) {
+   std::call_once(registered_callbacks, register_callbacks);
+   auto backend = std::make_unique<backend_t>(code, nullptr);
+   rhf_t::resolve(backend->get_module());
+   return backend;
+}
+
+std::vector<eosio::name> get_local_contracts(const shared_state& shared_state) {
+   std::vector<eosio::name> result;
+   if (shared_state.contract_dir.empty() || !boost::filesystem::is_directory(shared_state.contract_dir))
+      return result;
+   for (auto& p : boost::filesystem::directory_iterator(shared_state.contract_dir)) {
+      if (p.path().extension() != ".wasm")
+         continue;
+      auto        stem = p.path().stem().string();
+      eosio::name account{ stem };
+      if ((std::string)account == stem)
+         result.push_back(account);
+   }
+   return result;
+}
+
+void precompile_contract(const shared_state& shared_state, eosio::name account) {
+   auto code = read_code(shared_state, account);
+   if (!code)
+      return;
+   backend_entry entry;
+   entry.name    = account;
+   entry.backend = create_backend(*code);
+   shared_state.backend_cache->add(std::move(entry));
+}
+
 void run_action(wasm_ql::thread_state& thread_state, const std::vector<char>& contract_kv_prefix,
                 ship_protocol::action& action, action_trace_v1& atrace, const rocksdb::Snapshot* snapshot,
                 const std::chrono::steady_clock::time_point& stop_time, std::vector<std::vector<char>>& memory) {
    if (std::chrono::steady_clock::now() >= stop_time)
       throw eosio::vm::timeout_exception("execution timed out");
 
-   chain_kv::write_session write_session{ *thread_state.shared->db, snapshot };
-   db_view_state           db_view_state{ state_account, *thread_state.shared->db, write_session, contract_kv_prefix };
+   chain_kv::write_session write_session{ *thread_state.db, snapshot };
+   db_view_state           db_view_state{ state_account, *thread_state.db, write_session, contract_kv_prefix };
 
    std::optional<backend_entry>        entry = thread_state.shared->backend_cache->get(action.account);
    std::optional<std::vector<uint8_t>> code;
    if (!entry)
-      code = read_code(thread_state, action.account);
+      code = read_code(*thread_state.shared, action.account);
    std::optional<eosio::checksum256> hash;
    if (!entry && !code) {
       hash = get_contract_hash(db_view_state, action.account);
@@ -254,10 +287,7 @@ void run_action(wasm_ql::thread_state& thread_state, const std::vector<char>& co
          entry->hash = *hash;
       else
          entry->name = action.account;
-
-      std::call_once(registered_callbacks, register_callbacks);
-      entry->backend = std::make_unique<backend_t>(*code, nullptr);
-      rhf_t::resolve(entry->backend->get_module());
+      entry->backend = create_backend(*code);
    }
    auto se = fc::make_scoped_exit([&] { thread_state.shared->backend_cache->add(std::move(*entry)); });
 
@@ -269,6 +299,7 @@ void run_action(wasm_ql::thread_state& thread_state, const std::vector<char>& co
    // todo: move these out of thread_state since future enhancements could cause state to accidentally leak between
    // queries
    thread_state.max_console_size = thread_state.shared->max_console_size;
+   thread_state.console.clear();
    thread_state.receiver         = action.account;
    thread_state.action_data      = action.data;
    thread_state.action_return_value.clear();
@@ -286,20 +317,31 @@ void run_action(wasm_ql::thread_state& thread_state, const std::vector<char>& co
          (*entry->backend)(cb, "env", "apply", action.account.value, action.account.value, action.name.value);
       });
    } catch (...) {
-      atrace.console = std::move(thread_state.console);
+      atrace.console = thread_state.console;
       throw;
    }
 
-   atrace.console = std::move(thread_state.console);
-   memory.push_back(std::move(thread_state.action_return_value));
+   // copied, not moved, so thread_state keeps its buffers for the next query
+   atrace.console = thread_state.console;
+   memory.emplace_back(thread_state.action_return_value.begin(), thread_state.action_return_value.end());
    atrace.return_value = memory.back();
 } // run_action
 
+eosio::checksum256 get_head_block_id(const shared_state& shared_state, const std::vector<char>& contract_kv_prefix) {
+   auto                    db = shared_state.get_db();
+   chain_kv::write_session write_session{ *db };
+   db_view_state           db_view_state{ state_account, *db, write_session, contract_kv_prefix };
+   fill_status_sing        sing{ state_account, db_view_state, false };
+   if (!sing.exists())
+      return {};
+   return std::visit([](auto& obj) { return obj.head_id; }, sing.get());
+}
+
 const std::vector<char>& query_get_info(wasm_ql::thread_state&   thread_state,
                                         const std::vector<char>& contract_kv_prefix) {
-   rocksdb::ManagedSnapshot snapshot{ thread_state.shared->db->rdb.get() };
-   chain_kv::write_session  write_session{ *thread_state.shared->db, snapshot.snapshot() };
-   db_view_state            db_view_state{ state_account, *thread_state.shared->db, write_session, contract_kv_prefix };
+   rocksdb::ManagedSnapshot snapshot{ thread_state.db->rdb.get() };
+   chain_kv::write_session  write_session{ *thread_state.db, snapshot.snapshot() };
+   db_view_state            db_view_state{ state_account, *thread_state.db, write_session, contract_kv_prefix };
 
    std::string result = "{\"server_type\":\"wasm-ql\"";
 
@@ -355,9 +397,9 @@ const std::vector<char>& query_get_block(wasm_ql::thread_state&   thread_state,
       throw std::runtime_error("An error occurred deserializing get_block_params: "s + e.what());
    }
 
-   rocksdb::ManagedSnapshot snapshot{ thread_state.shared->db->rdb.get() };
-   chain_kv::write_session  write_session{ *thread_state.shared->db, snapshot.snapshot() };
-   db_view_state            db_view_state{ state_account, *thread_state.shared->db, write_session, contract_kv_prefix };
+   rocksdb::ManagedSnapshot snapshot{ thread_state.db->rdb.get() };
+   chain_kv::write_session  write_session{ *thread_state.db, snapshot.snapshot() };
+   db_view_state            db_view_state{ state_account, *thread_state.db, write_session, contract_kv_prefix };
 
    std::string              bn_json = "\"" + params.block_num_or_id + "\"";
    eosio::json_token_stream bn_stream{ bn_json.data() };
@@ -433,9 +475,9 @@ const std::vector<char>& query_get_abi(wasm_ql::thread_state& thread_state, cons
       throw std::runtime_error("An error occurred deserializing get_abi_params: "s + e.what());
    }
 
-   rocksdb::ManagedSnapshot snapshot{ thread_state.shared->db->rdb.get() };
-   chain_kv::write_session  write_session{ *thread_state.shared->db, snapshot.snapshot() };
-   db_view_state            db_view_state{ state_account, *thread_state.shared->db, write_session, contract_kv_prefix };
+   rocksdb::ManagedSnapshot snapshot{ thread_state.db->rdb.get() };
+   chain_kv::write_session  write_session{ *thread_state.db, snapshot.snapshot() };
+   db_view_state            db_view_state{ state_account, *thread_state.db, write_session, contract_kv_prefix };
 
    auto acc = get_state_row<ship_protocol::account>(
          db_view_state.kv_state.view,
@@ -457,6 +499,59 @@ const std::vector<char>& query_get_abi(wasm_ql::thread_state& thread_state, cons
    return thread_state.action_return_value;
 } // query_get_abi
 
+struct get_tables_by_scope_params {
+   eosio::name scope = {};
+   uint32_t    limit = 100;
+};
+
+EOSIO_REFLECT(get_tables_by_scope_params, scope, limit)
+
+struct get_tables_by_scope_result {
+   std::vector<ship_protocol::contract_table_v0> rows = {};
+   bool                                          more = false;
+};
+
+EOSIO_REFLECT(get_tables_by_scope_result, rows, more)
+
+static constexpr uint32_t max_tables_by_scope = 1000;
+
+const std::vector<char>& query_get_tables_by_scope(wasm_ql::thread_state&   thread_state,
+                                                   const std::vector<char>& contract_kv_prefix, std::string_view body) {
+   get_tables_by_scope_params params;
+   std::string                s{ body.begin(), body.end() };
+   eosio::json_token_stream   stream{ s.data() };
+   try {
+      from_json(params, stream);
+   } catch (std::exception& e) {
+      throw std::runtime_error("An error occurred deserializing get_tables_by_scope_params: "s + e.what());
+   }
+   params.limit = std::min(params.limit, max_tables_by_scope);
+
+   rocksdb::ManagedSnapshot snapshot{ thread_state.db->rdb.get() };
+   chain_kv::write_session  write_session{ *thread_state.db, snapshot.snapshot() };
+   db_view_state            db_view_state{ state_account, *thread_state.db, write_session, contract_kv_prefix };
+
+   index_status_sing sing{ state_account, db_view_state, false };
+   if (!sing.exists() || !std::get<0>(sing.get()).contract_table_scope)
+      throw std::runtime_error("database was not cloned with the contract table scope index");
+
+   get_tables_by_scope_result result;
+   for_each_state_row_secondary<ship_protocol::contract_table>(
+         db_view_state.kv_state.view,
+         std::make_tuple(eosio::name{ "contract.tab" }, eosio::name{ "scope" }, params.scope), [&](const auto& row) {
+            if (result.rows.size() >= params.limit) {
+               result.more = true;
+               return false;
+            }
+            result.rows.push_back(std::get<ship_protocol::contract_table_v0>(row));
+            return true;
+         });
+
+   auto json = eosio::convert_to_json(result);
+   thread_state.action_return_value.assign(json.begin(), json.end());
+   return thread_state.action_return_value;
+} // query_get_tables_by_scope
+
 // Ignores data field
 struct action_no_data {
    eosio::name                                  account       = {};
@@ -555,7 +650,7 @@ const std::vector<char>& query_send_transaction(wasm_ql::thread_state&   thread_
                                                 std::move(params.signatures), params.packed_context_free_data.data } },
                                           params.packed_trx.data };
 
-   rocksdb::ManagedSnapshot snapshot{ thread_state.shared->db->rdb.get() };
+   rocksdb::ManagedSnapshot snapshot{ thread_state.db->rdb.get() };
 
    std::vector<std::vector<char>> memory;
    send_transaction_results       results;
@@ -46,11 +46,44 @@ extern const char* const state_history_plugin_abi = R"({
                 { "name": "fetch_block_header", "type": "bool" }
             ]
         },
+        {
+            "name": "get_blocks_request_v2", "fields": [
+                { "name": "start_block_num", "type": "uint32" },
+                { "name": "end_block_num", "type": "uint32" },
+                { "name": "max_messages_in_flight", "type": "uint32" },
+                { "name": "have_positions", "type": "block_position[]" },
+                { "name": "irreversible_only", "type": "bool" },
+                { "name": "fetch_block", "type": "bool" },
+                { "name": "fetch_traces", "type": "bool" },
+                { "name": "fetch_deltas", "type": "bool" },
+                { "name": "fetch_block_header", "type": "bool" },
+                { "name": "filter_contracts", "type": "name[]" },
+                { "name": "filter_actions", "type": "name[]" },
+                { "name": "filter_tables", "type": "name[]" },
+                { "name": "filter_scopes", "type": "name[]" }
+            ]
+        },
         {
             "name": "get_blocks_ack_request_v0", "fields": [
                 { "name": "num_messages", "type": "uint32" }
             ]
         },
+        {
+            "name": "get_table_blocks_request_v0", "fields": [
+                { "name": "code", "type": "name" },
+                { "name": "table", "type": "name" },
+                { "name": "start_block_num", "type": "uint32" },
+                { "name": "end_block_num", "type": "uint32" },
+                { "name": "max_results", "type": "uint32" }
+            ]
+        },
+        {
+            "name": "get_table_blocks_result_v0", "fields": [
+                { "name": "block_nums", "type": "uint32[]" },
+                { "name": "next_block_num", "type": "uint32" },
+                { "name": "index_end_block", "type": "uint32" }
+            ]
+        },
         {
             "name": "get_blocks_result_base", "fields": [
                 { "name": "head", "type": "block_position" },
@@ -652,8 +685,8 @@ extern const char* const state_history_plugin_abi = R"({
         { "new_type_name": "transaction_id", "type": "checksum256" }
     ],
     "variants": [
-        { "name": "request", "types": ["get_status_request_v0", "get_blocks_request_v0", "get_blocks_ack_request_v0", "get_blocks_request_v1"] },
-        { "name": "result", "types": ["get_status_result_v0", "get_blocks_result_v0", "get_blocks_result_v1", "get_blocks_result_v2"] },
+        { "name": "request", "types": ["get_status_request_v0", "get_blocks_request_v0", "get_blocks_ack_request_v0", "get_blocks_request_v1", "get_blocks_request_v2", "get_table_blocks_request_v0"] },
+        { "name": "result", "types": ["get_status_result_v0", "get_blocks_result_v0", "get_blocks_result_v1", "get_blocks_result_v2", "get_table_blocks_result_v0"] },
 
         { "name": "action_receipt", "types": ["action_receipt_v0"] },
         { "name": "action_trace", "types": ["action_trace_v0", "action_trace_v1"] },
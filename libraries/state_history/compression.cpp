@@ -0,0 +1,131 @@
+#include <eosio/state_history/compression.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <fc/io/fstream.hpp>
+
+#ifdef EOSIO_STATE_HISTORY_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
+namespace eosio {
+namespace state_history {
+
+#ifdef EOSIO_STATE_HISTORY_ZSTD
+
+namespace {
+   void check_zstd(size_t r, const char* what) {
+      EOS_ASSERT(!ZSTD_isError(r), chain::state_history_exception, "${w}: ${e}", ("w", what)("e", ZSTD_getErrorName(r)));
+   }
+
+   // contexts are reused by the calls of a thread
+   ZSTD_CCtx& cctx() {
+      thread_local std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> ctx(ZSTD_createCCtx(), &ZSTD_freeCCtx);
+      return *ctx;
+   }
+
+   ZSTD_DCtx& dctx() {
+      thread_local std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> ctx(ZSTD_createDCtx(), &ZSTD_freeDCtx);
+      return *ctx;
+   }
+} // namespace
+
+struct zstd_dictionary::impl {
+   ZSTD_CDict* cdict = nullptr;
+   ZSTD_DDict* ddict = nullptr;
+   uint32_t    id    = 0;
+};
+
+zstd_dictionary::zstd_dictionary(const std::vector<char>& content, int level)
+    : my(std::make_unique<impl>()) {
+   my->id = ZDICT_getDictID(content.data(), content.size());
+   EOS_ASSERT(my->id != 0, chain::state_history_exception, "invalid zstd dictionary");
+   my->cdict = ZSTD_createCDict(content.data(), content.size(), level);
+   my->ddict = ZSTD_createDDict(content.data(), content.size());
+   EOS_ASSERT(my->cdict && my->ddict, chain::state_history_exception, "unable to load zstd dictionary");
+}
+
+zstd_dictionary::~zstd_dictionary() {
+   ZSTD_freeCDict(my->cdict);
+   ZSTD_freeDDict(my->ddict);
+}
+
+uint32_t zstd_dictionary::id() const { return my->id; }
+
+bool zstd_supported() { return true; }
+
+std::vector<char> zstd_compress(const char* data, size_t size, int level, const zstd_dictionary* dict) {
+   std::vector<char> result(ZSTD_compressBound(size));
+   size_t            r = dict ? ZSTD_compress_usingCDict(&cctx(), result.data(), result.size(), data, size, dict->my->cdict)
+                              : ZSTD_compressCCtx(&cctx(), result.data(), result.size(), data, size, level);
+   check_zstd(r, "zstd compression failed");
+   result.resize(r);
+   return result;
+}
+
+std::vector<char> zstd_decompress(const char* data, size_t size, const zstd_dictionary* dict) {
+   auto dict_id = ZSTD_getDictID_fromFrame(data, size);
+   EOS_ASSERT(!dict_id || (dict && dict->id() == dict_id), chain::state_history_exception,
+              "zstd frame needs dictionary ${id}", ("id", dict_id));
+   auto content_size = ZSTD_getFrameContentSize(data, size);
+   EOS_ASSERT(content_size != ZSTD_CONTENTSIZE_UNKNOWN && content_size != ZSTD_CONTENTSIZE_ERROR,
+              chain::state_history_exception, "invalid zstd frame");
+   std::vector<char> result(content_size);
+   size_t r = dict_id ? ZSTD_decompress_usingDDict(&dctx(), result.data(), result.size(), data, size, dict->my->ddict)
+                      : ZSTD_decompressDCtx(&dctx(), result.data(), result.size(), data, size);
+   check_zstd(r, "zstd decompression failed");
+   EOS_ASSERT(r == content_size, chain::state_history_exception, "zstd frame is truncated");
+   return result;
+}
+
+std::vector<char> zstd_train_dictionary(const std::vector<std::vector<char>>& samples, size_t max_size) {
+   std::vector<char>   buffer;
+   std::vector<size_t> sizes;
+   for (auto& s : samples) {
+      buffer.insert(buffer.end(), s.begin(), s.end());
+      sizes.push_back(s.size());
+   }
+   std::vector<char> result(max_size);
+   size_t r = ZDICT_trainFromBuffer(result.data(), result.size(), buffer.data(), sizes.data(), sizes.size());
+   EOS_ASSERT(!ZDICT_isError(r), chain::state_history_exception, "zstd dictionary training failed: ${e}",
+              ("e", ZDICT_getErrorName(r)));
+   result.resize(r);
+   return result;
+}
+
+#else
+
+struct zstd_dictionary::impl {};
+
+zstd_dictionary::zstd_dictionary(const std::vector<char>&, int) {
+   EOS_THROW(chain::state_history_exception, "built without zstd");
+}
+
+zstd_dictionary::~zstd_dictionary() = default;
+
+uint32_t zstd_dictionary::id() const { return 0; }
+
+bool zstd_supported() { return false; }
+
+std::vector<char> zstd_compress(const char*, size_t, int, const zstd_dictionary*) {
+   EOS_THROW(chain::state_history_exception, "built without zstd");
+}
+
+std::vector<char> zstd_decompress(const char*, size_t, const zstd_dictionary*) {
+   EOS_THROW(chain::state_history_exception, "built without zstd, unable to read zstd compressed state history");
+}
+
+std::vector<char> zstd_train_dictionary(const std::vector<std::vector<char>>&, size_t) {
+   EOS_THROW(chain::state_history_exception, "built without zstd");
+}
+
+#endif
+
+std::shared_ptr<zstd_dictionary> zstd_dictionary::load(const fc::path& file, int level) {
+   std::string content;
+   fc::read_file_contents(file, content);
+   return std::make_shared<zstd_dictionary>(std::vector<char>(content.begin(), content.end()), level);
+}
+
+} // namespace state_history
+} // namespace eosio
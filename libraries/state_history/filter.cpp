@@ -0,0 +1,171 @@
+#include <eosio/state_history/filter.hpp>
+#include <eosio/state_history/serialization.hpp>
+#include <eosio/chain/table_usage_tracker.hpp>
+
+namespace eosio {
+namespace state_history {
+
+namespace {
+   block_filter::name_set to_set(const std::vector<chain::name>& names) {
+      return block_filter::name_set(names.begin(), names.end());
+   }
+
+   bool contains(const block_filter::name_set& set, chain::name n) { return set.empty() || set.count(n); }
+
+   /// the names a contract table row is filtered by
+   struct row_names {
+      chain::name                code;
+      std::optional<chain::name> scope;
+      chain::name                table;
+   };
+
+   enum class row_kind { other, contract, key_value };
+
+   row_kind kind_of(const std::string& table_delta_name) {
+      static const boost::container::flat_set<std::string> contract_tables = {
+          "contract_table",    "contract_row",          "contract_index64",          "contract_index128",
+          "contract_index256", "contract_index_double", "contract_index_long_double"};
+      if (table_delta_name == "key_value")
+         return row_kind::key_value;
+      return contract_tables.count(table_delta_name) ? row_kind::contract : row_kind::other;
+   }
+
+   row_names read_row_names(row_kind kind, const bytes& row) {
+      fc::datastream<const char*> ds(row.data(), row.size());
+      fc::unsigned_int            version;
+      row_names                   result;
+      fc::raw::unpack(ds, version);
+      fc::raw::unpack(ds, result.code);
+      if (kind == row_kind::contract) {
+         // contract_table_v0, contract_row_v0 and contract_index*_v0 start with code, scope, table
+         chain::name scope;
+         fc::raw::unpack(ds, scope);
+         fc::raw::unpack(ds, result.table);
+         result.scope = scope;
+      } else {
+         // key_value_v0 starts with contract, key
+         fc::unsigned_int key_size;
+         fc::raw::unpack(ds, key_size);
+         EOS_ASSERT(ds.remaining() >= key_size.value, chain::plugin_exception, "invalid key_value row");
+         result.table = chain::table_usage_key::kv_table(ds.pos(), key_size.value);
+      }
+      return result;
+   }
+} // namespace
+
+block_filter::block_filter(const get_blocks_request_v2& req)
+    : contracts(to_set(req.filter_contracts))
+    , actions(to_set(req.filter_actions))
+    , tables(to_set(req.filter_tables))
+    , scopes(to_set(req.filter_scopes)) {}
+
+bytes block_filter::filter_traces(const bytes& traces) const {
+   if (traces.empty())
+      return {};
+   std::vector<transaction_trace> all;
+   fc::datastream<const char*>    ds(traces.data(), traces.size());
+   fc::raw::unpack(ds, all);
+
+   auto match = [this](const action_trace& at) {
+      return std::visit(
+          [this](const auto& a) {
+             chain::name receiver(a.receiver), account(a.act.account), act(a.act.name);
+             return (contracts.empty() || contracts.count(account) || contracts.count(receiver)) &&
+                    contains(actions, act);
+          },
+          at);
+   };
+
+   std::vector<transaction_trace> kept;
+   for (auto& trx : all) {
+      auto& t = std::get<transaction_trace_v0>(trx);
+      t.action_traces.erase(
+          std::remove_if(t.action_traces.begin(), t.action_traces.end(), [&](const auto& at) { return !match(at); }),
+          t.action_traces.end());
+      if (!t.action_traces.empty())
+         kept.emplace_back(std::move(trx));
+   }
+   if (kept.empty())
+      return {};
+   return fc::raw::pack(kept);
+}
+
+bytes block_filter::filter_deltas(const bytes& deltas) const {
+   if (deltas.empty())
+      return {};
+   fc::datastream<const char*> ds(deltas.data(), deltas.size());
+   fc::unsigned_int            num_deltas;
+   fc::raw::unpack(ds, num_deltas);
+
+   // read row by row, the deltas of a full snapshot can hold more rows than fc unpacks into a vector
+   std::vector<table_delta> kept;
+   for (uint32_t i = 0; i < num_deltas.value; ++i) {
+      table_delta delta;
+      fc::raw::unpack(ds, delta.struct_version);
+      fc::raw::unpack(ds, delta.name);
+      fc::unsigned_int num_rows;
+      fc::raw::unpack(ds, num_rows);
+      auto kind = kind_of(delta.name);
+      for (uint32_t j = 0; j < num_rows.value; ++j) {
+         std::pair<uint8_t, bytes> row;
+         fc::raw::unpack(ds, row.first);
+         fc::raw::unpack(ds, row.second);
+         if (kind == row_kind::other)
+            continue;
+         auto names = read_row_names(kind, row.second);
+         if (contains(contracts, names.code) && contains(tables, names.table) &&
+             (scopes.empty() || (names.scope && scopes.count(*names.scope))))
+            delta.rows.obj.emplace_back(std::move(row));
+      }
+      if (!delta.rows.obj.empty())
+         kept.emplace_back(std::move(delta));
+   }
+   if (kept.empty())
+      return {};
+   return fc::raw::pack(kept);
+}
+
+table_names changed_tables(const std::vector<table_delta>& deltas) {
+   table_names result;
+   for (auto& delta : deltas) {
+      auto kind = kind_of(delta.name);
+      if (kind == row_kind::other)
+         continue;
+      for (auto& row : delta.rows.obj) {
+         auto names = read_row_names(kind, row.second);
+         result.emplace(names.code, names.table);
+      }
+   }
+   return result;
+}
+
+table_names changed_tables(const bytes& deltas) {
+   table_names result;
+   if (deltas.empty())
+      return result;
+   fc::datastream<const char*> ds(deltas.data(), deltas.size());
+   fc::unsigned_int            num_deltas;
+   fc::raw::unpack(ds, num_deltas);
+   for (uint32_t i = 0; i < num_deltas.value; ++i) {
+      fc::unsigned_int struct_version, num_rows;
+      std::string      name;
+      fc::raw::unpack(ds, struct_version);
+      fc::raw::unpack(ds, name);
+      fc::raw::unpack(ds, num_rows);
+      auto kind = kind_of(name);
+      for (uint32_t j = 0; j < num_rows.value; ++j) {
+         uint8_t present;
+         bytes   row;
+         fc::raw::unpack(ds, present);
+         fc::raw::unpack(ds, row);
+         if (kind == row_kind::other)
+            continue;
+         auto names = read_row_names(kind, row);
+         result.emplace(names.code, names.table);
+      }
+   }
+   return result;
+}
+
+} // namespace state_history
+} // namespace eosio
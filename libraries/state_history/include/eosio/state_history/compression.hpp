@@ -7,6 +7,9 @@
 #include <fc/io/raw.hpp>
 #include <fc/io/datastream.hpp>
 #include <fc/io/bio_device_adaptor.hpp>
+#include <fc/filesystem.hpp>
+
+#include <memory>
 
 
 namespace eosio {
@@ -55,6 +58,14 @@ void zlib_pack(STREAM& strm, const T& obj) {
    }
 }
 
+/// same as zlib_pack of an object which packs to the size bytes of data
+template <typename STREAM>
+void zlib_pack_bytes(STREAM& strm, const char* data, size_t size) {
+   length_writer<STREAM>                     len_writer(strm);
+   fc::datastream<bio::filtering_ostreambuf> compressed_strm(bio::zlib_compressor() | fc::to_sink(strm));
+   compressed_strm.write(data, size);
+}
+
 template <typename STREAM, typename T>
 void zlib_unpack(STREAM& strm, T& obj) {
    uint32_t len;
@@ -82,5 +93,34 @@ std::vector<char> zlib_decompress(STREAM& strm) {
    return {};
 }
 
+/// compression of the entries of a state history log
+enum class log_compression { zlib, zstd };
+
+/**
+ * A zstd dictionary shared by the entries of a log, trained by zstd_train_dictionary. The frames compressed with
+ * it record its id, they can only be decompressed with the same dictionary.
+ */
+class zstd_dictionary {
+ public:
+   /// @param level compression level of the frames compressed with the dictionary
+   zstd_dictionary(const std::vector<char>& content, int level);
+   ~zstd_dictionary();
+
+   static std::shared_ptr<zstd_dictionary> load(const fc::path& file, int level);
+
+   uint32_t id() const;
+
+   struct impl;
+   std::unique_ptr<impl> my;
+};
+
+/// false when built without zstd, the zstd functions below then throw
+bool zstd_supported();
+
+/// @returns a single zstd frame with its content size
+std::vector<char> zstd_compress(const char* data, size_t size, int level, const zstd_dictionary* dict = nullptr);
+std::vector<char> zstd_decompress(const char* data, size_t size, const zstd_dictionary* dict = nullptr);
+std::vector<char> zstd_train_dictionary(const std::vector<std::vector<char>>& samples, size_t max_size);
+
 } // namespace state_history
 } // namespace eosio
@@ -3,10 +3,17 @@
 #include <eosio/state_history/types.hpp>
 #include <eosio/chain/combined_database.hpp>
 
+#include <boost/asio/io_context.hpp>
+
 namespace eosio {
 namespace state_history {
 
-std::vector<table_delta> create_deltas(const chain::combined_database& db, bool full_snapshot);
+/**
+ * @param thread_pool when set, the chainbase tables are packed in parallel on it while the caller waits;
+ *                    db must not be modified meanwhile
+ */
+std::vector<table_delta> create_deltas(const chain::combined_database& db, bool full_snapshot,
+                                       boost::asio::io_context* thread_pool = nullptr);
 
 } // namespace state_history
 } // namespace eosio
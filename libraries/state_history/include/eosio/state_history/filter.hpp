@@ -0,0 +1,56 @@
+#pragma once
+
+#include <eosio/state_history/types.hpp>
+
+#include <boost/container/flat_set.hpp>
+
+namespace eosio {
+namespace state_history {
+
+/**
+ * The filters of a get_blocks_request_v2, applied to the traces and deltas of a block before they are sent.
+ * The filtered traces and deltas keep their encoding: transaction_trace[] and table_delta[].
+ */
+struct block_filter {
+   using name_set = boost::container::flat_set<chain::name>;
+
+   name_set contracts;
+   name_set actions;
+   name_set tables;
+   name_set scopes;
+
+   block_filter() = default;
+   explicit block_filter(const get_blocks_request_v2& req);
+
+   bool filters_traces() const { return !contracts.empty() || !actions.empty(); }
+   bool filters_deltas() const { return !contracts.empty() || !tables.empty() || !scopes.empty(); }
+
+   /**
+    * Keeps the action traces which match, and the transactions with at least one of them. Failed deferred
+    * transaction traces are kept as they are.
+    * @param traces packed transaction_trace[]
+    * @returns the packed transaction_trace[], empty when no transaction matches
+    */
+   bytes filter_traces(const bytes& traces) const;
+
+   /**
+    * Keeps the rows of the contract tables (contract_table, contract_row, contract_index*, key_value) which
+    * match, the deltas of the other tables are dropped. The table of a key_value row is the first 8 bytes of its
+    * key, key_value rows have no scope.
+    * @param deltas packed table_delta[]
+    * @returns the packed table_delta[], empty when no row matches
+    */
+   bytes filter_deltas(const bytes& deltas) const;
+};
+
+/// code and table of contract tables, named as block_filter matches them
+using table_names = boost::container::flat_set<std::pair<chain::name, chain::name>>;
+
+/// @returns the contract tables with rows in deltas
+table_names changed_tables(const std::vector<table_delta>& deltas);
+
+/// @param deltas packed table_delta[]
+table_names changed_tables(const bytes& deltas);
+
+} // namespace state_history
+} // namespace eosio
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <boost/filesystem.hpp>
+#include <boost/asio/io_context.hpp>
 #include <fstream>
 #include <stdint.h>
 
@@ -12,12 +13,17 @@
 #include <eosio/chain/log_data_base.hpp>
 #include <eosio/chain/log_index.hpp>
 #include <eosio/chain/types.hpp>
+#include <eosio/state_history/compression.hpp>
+#include <eosio/state_history/row_diff.hpp>
+#include <eosio/state_history/table_index.hpp>
 #include <eosio/state_history/transaction_trace_cache.hpp>
 #include <fc/bitutil.hpp>
 #include <fc/io/cfile.hpp>
 #include <fc/io/datastream.hpp>
 #include <fc/log/logger.hpp>
 
+#include <mutex>
+
 namespace eosio {
 
 namespace bfs = boost::filesystem;
@@ -47,8 +53,13 @@ inline bool           is_ship(uint64_t magic) {
    return (magic & 0xffff'ffff'0000'0000) == "ship"_n.to_uint64_t();
 }
 inline uint32_t       get_ship_version(uint64_t magic) { return magic; }
-inline bool           is_ship_supported_version(uint64_t magic) { return get_ship_version(magic) <= 1; }
+inline bool           is_ship_supported_version(uint64_t magic) { return get_ship_version(magic) <= 4; }
 static const uint32_t ship_current_version = 1;
+/// chain state entries which are a zstd frame of the packed table_delta[], written when the log uses zstd
+static const uint32_t ship_zstd_version = 2;
+/// chain state entries of version 1 and 2 whose table_delta[] has rows diffed against the previous entry, see row_differ
+static const uint32_t ship_row_diff_version      = 3;
+static const uint32_t ship_zstd_row_diff_version = 4;
 
 struct state_history_log_header {
    uint64_t             magic        = ship_magic(ship_current_version);
@@ -113,6 +124,12 @@ struct state_history_config {
    bfs::path archive_dir;
    uint32_t  stride             = UINT32_MAX;
    uint32_t  max_retained_files = 10;
+   state_history::log_compression chain_state_compression = state_history::log_compression::zlib;
+   bfs::path zstd_dictionary; ///< optional, absolute or relative to log_dir
+   int       zstd_level = 3;
+   bool      chain_state_table_index = false; ///< index the tables changed by each block, see state_history_table_index
+   /// when not 0, rows are diffed against the previous block, every block multiple of it is stored without diffs
+   uint32_t  chain_state_row_diff_interval = 0;
 };
 
 class state_history_log {
@@ -127,8 +144,10 @@ class state_history_log {
    uint32_t             stride;
 
  protected:
-   cfile_stream write_log;
-   cfile_stream read_log;
+   /// guards the files and the catalog, entries are written on the main thread and read on the state history threads
+   mutable std::mutex mx;
+   cfile_stream       write_log;
+   cfile_stream       read_log;
 
    using catalog_t = chain::log_catalog<state_history_log_data, chain::log_index<chain::state_history_exception>>;
    catalog_t catalog;
@@ -143,13 +162,17 @@ class state_history_log {
    state_history_log(const char* const name, const state_history_config& conf);
 
    block_num_type begin_block() const {
-      block_num_type result = catalog.first_block_num();
-      return result != 0 ? result : _begin_block;
+      std::lock_guard<std::mutex> g(mx);
+      return first_block();
+   }
+   block_num_type end_block() const {
+      std::lock_guard<std::mutex> g(mx);
+      return _end_block;
    }
-   block_num_type end_block() const { return _end_block; }
 
    template <typename F>
    void write_entry(state_history_log_header& header, const chain::block_id_type& prev_id, F write_payload) {
+      std::lock_guard<std::mutex> g(mx);
 
       auto [block_num, start_pos] = write_entry_header(header, prev_id);
       try {
@@ -166,8 +189,20 @@ class state_history_log {
    std::optional<chain::block_id_type> get_block_id(block_num_type block_num);
 
  protected:
+   // the methods below expect mx to be held
+   block_num_type first_block() const {
+      block_num_type result = catalog.first_block_num();
+      return result != 0 ? result : _begin_block;
+   }
+   bool has_block(block_num_type block_num) const { return block_num >= first_block() && block_num < _end_block; }
    void get_entry_header(block_num_type block_num, state_history_log_header& header);
 
+   /**
+    *  Copies the payload of an entry so that it can be decoded without holding mx.
+    *  @returns the payload and the version of the entry, an empty payload when the block is not in the log
+    **/
+   std::pair<std::vector<char>, version_type> read_payload(block_num_type block_num);
+
  private:
    void               read_header(state_history_log_header& header, bool assert_version = true);
    void               write_header(const state_history_log_header& header);
@@ -187,7 +222,7 @@ class state_history_log {
 }; // state_history_log
 
 class state_history_traces_log : public state_history_log {
-   state_history::transaction_trace_cache cache;
+   state_history::packed_trace_cache cache;
 
  public:
    bool                            trace_debug_mode = false;
@@ -197,8 +232,10 @@ class state_history_traces_log : public state_history_log {
 
    static bool exists(bfs::path state_history_dir);
 
-   void add_transaction(const chain::transaction_trace_ptr& trace, const chain::packed_transaction_ptr& transaction) {
-      cache.add_transaction(trace, transaction);
+   /// the trace is serialized right away, db is only needed for that
+   void add_transaction(const chainbase::database& db, const chain::transaction_trace_ptr& trace,
+                        const chain::packed_transaction_ptr& transaction) {
+      cache.add_transaction(db, trace_debug_mode, compression, trace, transaction);
    }
 
    chain::bytes get_log_entry(block_num_type block_num);
@@ -214,12 +251,39 @@ class state_history_traces_log : public state_history_log {
 };
 
 class state_history_chain_state_log : public state_history_log {
+   state_history::log_compression                  compression;
+   std::shared_ptr<state_history::zstd_dictionary> dictionary;
+   int                                             zstd_level;
+   std::optional<state_history_table_index>        table_index;
+   std::optional<state_history::row_differ>        differ;
+   uint32_t                                        diff_interval;
+   uint32_t                                        stride;
+
+   /// the last entry rebuilt from row diffs, the next block is usually diffed against it
+   std::mutex     cache_mx;
+   uint32_t       cache_generation = 0; ///< incremented when blocks are stored, they may replace the cached one
+   block_num_type cached_block_num = 0;
+   chain::bytes   cached_deltas;
+
  public:
    state_history_chain_state_log(const state_history_config& conf);
 
    chain::bytes get_log_entry(block_num_type block_num);
 
-   void store(const chain::combined_database& db, const chain::block_state_ptr& block_state);
+   /// nullptr unless config.chain_state_table_index
+   const state_history_table_index* get_table_index() const { return table_index ? &*table_index : nullptr; }
+
+   /**
+    *  Rewrites chain_state_history.log of config.log_dir with config.chain_state_compression, config.zstd_dictionary
+    *  is used to read and to write the entries. Rows diffed against the previous entry are rebuilt. nodeos must not be
+    *  running. Retained files are not converted.
+    *  @returns the number of entries rewritten
+    **/
+   static uint32_t convert(const state_history_config& config);
+
+   /// @param thread_pool when set, the deltas are packed in parallel on it
+   void store(const chain::combined_database& db, const chain::block_state_ptr& block_state,
+              boost::asio::io_context* thread_pool = nullptr);
 };
 
 } // namespace eosio
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <eosio/state_history/types.hpp>
+
+#include <map>
+
+namespace eosio {
+namespace state_history {
+
+/**
+ * The present flag of a row stored in the chain state history log as a diff against its image in the previous
+ * block. Such rows are rebuilt before the deltas leave the log, clients never see them.
+ */
+constexpr uint8_t row_diff_present = 3;
+
+/**
+ * Replaces the rows modified by a block by diffs against their images in the previous block when these are in the
+ * deltas of the previous block, which is the case of rows modified by most blocks (global, rammarket, order books).
+ * Only the rows of contract_row, key_value and the single row tables global_property and resource_limits_state
+ * are diffed.
+ */
+class row_differ {
+ public:
+   /**
+    * @param keyframe when set, no row is diffed, so that the block can be read without the previous one
+    * @returns whether a row was diffed
+    */
+   bool encode(std::vector<table_delta>& deltas, const chain::block_id_type& id, const chain::block_id_type& prev_id,
+               bool keyframe);
+
+   /// forgets the rows of the last block, e.g. after storing a full snapshot of the state
+   void reset();
+
+ private:
+   std::map<std::pair<std::string, bytes>, bytes> rows; ///< delta name and row key -> row of the last block
+   std::optional<chain::block_id_type>            block_id;
+};
+
+/**
+ * @param deltas packed table_delta[] of a block with diffed rows
+ * @param prev packed table_delta[] of the previous block, without diffed rows
+ * @returns deltas with the diffed rows rebuilt
+ */
+bytes apply_row_diffs(const bytes& deltas, const bytes& prev);
+
+} // namespace state_history
+} // namespace eosio
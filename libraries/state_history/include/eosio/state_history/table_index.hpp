@@ -0,0 +1,45 @@
+#pragma once
+
+#include <eosio/state_history/filter.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace eosio {
+
+/**
+ * Which contract tables changed in which blocks of the chain state history log, kept in a RocksDB database next to
+ * the log, so that the blocks changing a table are found without reading the deltas of the other blocks. The
+ * tables are named as state_history::block_filter matches them.
+ *
+ * add_block and truncate are called from one thread at a time, the other methods may be called from any thread
+ * concurrently with them.
+ */
+class state_history_table_index {
+ public:
+   explicit state_history_table_index(const fc::path& dir);
+   ~state_history_table_index();
+
+   /// one past the last block indexed, 0 when none
+   uint32_t end_block() const;
+
+   /// indexes the tables of block_num, after forgetting block_num and the blocks after it which a fork replaced
+   void add_block(uint32_t block_num, const state_history::table_names& tables);
+
+   /// forgets the blocks from block_num on
+   void truncate(uint32_t block_num);
+
+   /// @returns up to max_results blocks in [start_block_num, end_block_num) where the table of code changed, in order
+   std::vector<uint32_t> find_blocks(chain::name code, chain::name table, uint32_t start_block_num,
+                                     uint32_t end_block_num, uint32_t max_results) const;
+
+   bool changed(uint32_t block_num, chain::name code, chain::name table) const;
+
+ private:
+   struct impl;
+   std::unique_ptr<impl> my;
+};
+
+} // namespace eosio
@@ -21,5 +21,34 @@ struct transaction_trace_cache {
    void clear();
 };
 
+/**
+ * Keeps the traces of the transactions of a block serialized in the trace log format as they are applied, so the
+ * memory held for a block is bounded by the packed size of its traces rather than by their trace objects.
+ */
+class packed_trace_cache {
+ public:
+   /// @param compression of the context free data, the same for all the transactions of a block
+   void add_transaction(const chainbase::database& db, bool debug_mode, compression_type compression,
+                        const transaction_trace_ptr& trace, const packed_transaction_ptr& transaction);
+
+   /// @returns the version 1 trace log entry of block_state, as written by trace_converter::pack, and clears the cache
+   std::vector<char> prepare_entry(const block_state_ptr& block_state, compression_type compression);
+
+   void clear();
+
+ private:
+   /// where a trace is in arena
+   struct packed_trace {
+      uint64_t offset          = 0;
+      uint32_t unprunable_size = 0; ///< the trace without its prunable data
+      uint32_t prunable_size   = 0; ///< its prunable data, following the trace
+      uint32_t padding         = 0; ///< reserved after the prunable data of the block for pruning in place
+   };
+
+   std::vector<char>                            arena; ///< traces replaced by a later one of the same id are kept
+   std::map<transaction_id_type, packed_trace> cached_traces;
+   std::optional<packed_trace>                  onblock_trace;
+};
+
 } // namespace state_history
 } // namespace eosio
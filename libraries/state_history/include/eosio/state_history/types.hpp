@@ -139,10 +139,34 @@ struct get_blocks_request_v1 : get_blocks_request_v0 {
    using response_type = get_blocks_result_v2;
 };
 
+/// get_blocks_request_v1 with filters of the traces and deltas, an empty filter matches everything
+struct get_blocks_request_v2 : get_blocks_request_v1 {
+   std::vector<chain::name> filter_contracts = {}; ///< actions sent to or received by, and table rows of, these contracts
+   std::vector<chain::name> filter_actions   = {}; ///< actions of these names
+   std::vector<chain::name> filter_tables    = {}; ///< rows of these tables
+   std::vector<chain::name> filter_scopes    = {}; ///< rows of these scopes
+   using response_type = get_blocks_result_v2;
+};
+
 struct get_blocks_ack_request_v0 {
    uint32_t num_messages = 0;
 };
 
+/// blocks in [start_block_num, end_block_num) whose deltas change a contract table, see state_history_table_index
+struct get_table_blocks_request_v0 {
+   chain::name code            = {};
+   chain::name table           = {};
+   uint32_t    start_block_num = 0;
+   uint32_t    end_block_num   = 0;
+   uint32_t    max_results     = 0;
+};
+
+struct get_table_blocks_result_v0 {
+   std::vector<uint32_t> block_nums     = {};
+   uint32_t              next_block_num = 0; ///< where to continue the search, end_block_num when done
+   uint32_t              index_end_block = 0; ///< the blocks from this one on are not indexed yet
+};
+
 struct get_blocks_result_v0 {
    block_position                head;
    block_position                last_irreversible;
@@ -153,7 +177,7 @@ struct get_blocks_result_v0 {
    std::optional<bytes>          deltas;
 };
 
-using state_request = std::variant<get_status_request_v0, get_blocks_request_v0, get_blocks_ack_request_v0, get_blocks_request_v1>;
+using state_request = std::variant<get_status_request_v0, get_blocks_request_v0, get_blocks_ack_request_v0, get_blocks_request_v1, get_blocks_request_v2, get_table_blocks_request_v0>;
 
 struct account_auth_sequence {
    uint64_t account  = {};
@@ -305,7 +329,7 @@ struct get_blocks_result_v2 {
 };
 
 
-using state_result = std::variant<get_status_result_v0, get_blocks_result_v0, get_blocks_result_v1, get_blocks_result_v2>;
+using state_result = std::variant<get_status_result_v0, get_blocks_result_v0, get_blocks_result_v1, get_blocks_result_v2, get_table_blocks_result_v0>;
 
 } // namespace state_history
 } // namespace eosio
@@ -317,7 +341,10 @@ FC_REFLECT_EMPTY(eosio::state_history::get_status_request_v0);
 FC_REFLECT(eosio::state_history::get_status_result_v0, (head)(last_irreversible)(trace_begin_block)(trace_end_block)(chain_state_begin_block)(chain_state_end_block)(chain_id));
 FC_REFLECT(eosio::state_history::get_blocks_request_v0, (start_block_num)(end_block_num)(max_messages_in_flight)(have_positions)(irreversible_only)(fetch_block)(fetch_traces)(fetch_deltas));
 FC_REFLECT_DERIVED(eosio::state_history::get_blocks_request_v1, (eosio::state_history::get_blocks_request_v0), (fetch_block_header));
+FC_REFLECT_DERIVED(eosio::state_history::get_blocks_request_v2, (eosio::state_history::get_blocks_request_v1), (filter_contracts)(filter_actions)(filter_tables)(filter_scopes));
 FC_REFLECT(eosio::state_history::get_blocks_ack_request_v0, (num_messages));
+FC_REFLECT(eosio::state_history::get_table_blocks_request_v0, (code)(table)(start_block_num)(end_block_num)(max_results));
+FC_REFLECT(eosio::state_history::get_table_blocks_result_v0, (block_nums)(next_block_num)(index_end_block));
 
 FC_REFLECT(eosio::state_history::account_auth_sequence, (account)(sequence));
 FC_REFLECT(eosio::state_history::account_delta, (account)(delta));
@@ -1,9 +1,12 @@
 #include <eosio/state_history/compression.hpp>
 #include <eosio/state_history/create_deltas.hpp>
+#include <eosio/state_history/filter.hpp>
 #include <eosio/state_history/log.hpp>
 #include <eosio/state_history/serialization.hpp>
 #include <eosio/state_history/trace_converter.hpp>
 
+#include <boost/iostreams/filtering_stream.hpp>
+
 namespace eosio {
 
 uint64_t state_history_log_data::payload_size_at(uint64_t pos) const {
@@ -69,6 +72,7 @@ void state_history_log::get_entry_header(state_history_log::block_num_type block
 }
 
 std::optional<chain::block_id_type> state_history_log::get_block_id(state_history_log::block_num_type block_num) {
+   std::lock_guard<std::mutex> g(mx);
    auto result = catalog.id_for_block(block_num);
    if (!result && block_num >= _begin_block && block_num < _end_block) {
       state_history_log_header header;
@@ -78,6 +82,22 @@ std::optional<chain::block_id_type> state_history_log::get_block_id(state_histor
    return result;
 }
 
+std::pair<std::vector<char>, state_history_log::version_type>
+state_history_log::read_payload(state_history_log::block_num_type block_num) {
+   auto [ds, version] = catalog.ro_stream_for_block(block_num);
+   if (ds.remaining()) {
+      return {std::vector<char>(ds.pos(), ds.pos() + ds.remaining()), version};
+   }
+
+   if (!has_block(block_num))
+      return {};
+   state_history_log_header header;
+   get_entry_header(block_num, header);
+   std::vector<char> payload(header.payload_size);
+   read_log.read(payload.data(), payload.size());
+   return {std::move(payload), get_ship_version(header.magic)};
+}
+
 bool state_history_log::get_last_block(uint64_t size) {
    state_history_log_header header;
    uint64_t                 suffix;
@@ -324,21 +344,24 @@ chain::bytes state_history_traces_log::get_log_entry(block_num_type block_num) {
       }
    };
 
-   auto [ds, version] = catalog.ro_stream_for_block(block_num);
-   if (ds.remaining()) {
-      return get_traces_bin(ds, version, ds.remaining());
+   std::vector<char> payload;
+   version_type      version;
+   {
+      std::lock_guard<std::mutex> g(mx);
+      std::tie(payload, version) = read_payload(block_num);
    }
-
-   if (block_num < begin_block() || block_num >= end_block())
+   if (payload.empty())
       return {};
-   state_history_log_header header;
-   get_entry_header(block_num, header);
-   return get_traces_bin(read_log, get_ship_version(header.magic), header.payload_size);
+   EOS_ASSERT(version < ship_zstd_version, chain::state_history_exception,
+              "unsupported version ${v} of trace_history.log entry", ("v", version));
+   fc::datastream<const char*> ds(payload.data(), payload.size());
+   return get_traces_bin(ds, version, payload.size());
 }
 
 
 void state_history_traces_log::prune_transactions(state_history_log::block_num_type        block_num,
                                                   std::vector<chain::transaction_id_type>& ids) {
+   std::lock_guard<std::mutex> g(mx);
    auto [ds, version] = catalog.rw_stream_for_block(block_num);
 
    if (ds.remaining()) {
@@ -348,7 +371,7 @@ void state_history_traces_log::prune_transactions(state_history_log::block_num_t
       return;
    }
 
-   if (block_num < begin_block() || block_num >= end_block())
+   if (!has_block(block_num))
       return;
    state_history_log_header header;
    get_entry_header(block_num, header);
@@ -362,11 +385,10 @@ void state_history_traces_log::prune_transactions(state_history_log::block_num_t
 void state_history_traces_log::store(const chainbase::database& db, const chain::block_state_ptr& block_state) {
 
    state_history_log_header header{.magic = ship_magic(ship_current_version), .block_id = block_state->id};
-   auto                     trace = cache.prepare_traces(block_state);
+   auto                     entry = cache.prepare_entry(block_state, compression);
 
-   this->write_entry(header, block_state->block->previous, [&](auto& stream) {
-      state_history::trace_converter::pack(stream, db, trace_debug_mode, trace, compression);
-   });
+   this->write_entry(header, block_state->block->previous,
+                     [&entry](auto& stream) { stream.write(entry.data(), entry.size()); });
 }
 
 bool state_history_traces_log::exists(bfs::path state_history_dir) {
@@ -374,34 +396,219 @@ bool state_history_traces_log::exists(bfs::path state_history_dir) {
           bfs::exists(state_history_dir / "trace_history.index");
 }
 
+namespace {
+std::shared_ptr<state_history::zstd_dictionary> load_dictionary(const state_history_config& config) {
+   if (config.zstd_dictionary.empty())
+      return {};
+   auto file = config.zstd_dictionary.is_relative() ? config.log_dir / config.zstd_dictionary : config.zstd_dictionary;
+   return state_history::zstd_dictionary::load(file, config.zstd_level);
+}
+
+/// @returns the packed table_delta[] of a chain state entry
+chain::bytes decode_chain_state(const std::vector<char>& payload, uint32_t version,
+                                const state_history::zstd_dictionary* dictionary) {
+   if (version == ship_zstd_version || version == ship_zstd_row_diff_version)
+      return state_history::zstd_decompress(payload.data(), payload.size(), dictionary);
+   fc::datastream<const char*> ds(payload.data(), payload.size());
+   return state_history::zlib_decompress(ds);
+}
+
+/// @returns the payload of a zlib compressed chain state entry, as written by zlib_pack
+std::vector<char> zlib_chain_state(const chain::bytes& deltas) {
+   std::vector<char> compressed;
+   if (!deltas.empty()) {
+      bio::filtering_ostream out;
+      out.push(bio::zlib_compressor());
+      out.push(bio::back_inserter(compressed));
+      out.write(deltas.data(), deltas.size());
+   }
+   std::vector<char> payload(sizeof(uint32_t));
+   uint32_t          len = compressed.size();
+   memcpy(payload.data(), &len, sizeof(len));
+   payload.insert(payload.end(), compressed.begin(), compressed.end());
+   return payload;
+}
+} // namespace
+
 state_history_chain_state_log::state_history_chain_state_log(const state_history_config& config)
-    : state_history_log("chain_state_history", config) {}
+    : state_history_log("chain_state_history", config)
+    , compression(config.chain_state_compression)
+    , dictionary(load_dictionary(config))
+    , zstd_level(config.zstd_level)
+    , diff_interval(config.chain_state_row_diff_interval)
+    , stride(config.stride) {
+   EOS_ASSERT(compression != state_history::log_compression::zstd || state_history::zstd_supported(),
+              chain::state_history_exception, "nodeos is built without zstd, chain state history can not use it");
+   if (diff_interval)
+      differ.emplace();
+
+   if (config.chain_state_table_index) {
+      table_index.emplace(config.log_dir / "chain_state_tables");
+      // the index is written after the log, it lags behind it after a crash
+      table_index->truncate(end_block());
+      auto begin = std::max(table_index->end_block(), begin_block());
+      if (begin < end_block())
+         ilog("indexing the tables of chain state history blocks ${b} to ${e}", ("b", begin)("e", end_block() - 1));
+      for (auto block_num = begin; block_num < end_block(); ++block_num)
+         table_index->add_block(block_num, state_history::changed_tables(get_log_entry(block_num)));
+   }
+}
 
 chain::bytes state_history_chain_state_log::get_log_entry(block_num_type block_num) {
+   uint32_t generation;
+   {
+      std::lock_guard<std::mutex> g(cache_mx);
+      if (cached_block_num == block_num && block_num)
+         return cached_deltas;
+      generation = cache_generation;
+   }
 
-   auto [ds, _] = catalog.ro_stream_for_block(block_num);
-   if (ds.remaining()) {
-      return state_history::zlib_decompress(ds);
+   // the entries back to one without row diffs or to the cached one
+   std::vector<std::pair<std::vector<char>, version_type>> entries;
+   chain::bytes                                            deltas;
+   for (auto num = block_num;; --num) {
+      if (num != block_num) {
+         std::lock_guard<std::mutex> g(cache_mx);
+         if (cached_block_num == num && num) {
+            deltas = cached_deltas;
+            break;
+         }
+      }
+      std::vector<char> payload;
+      version_type      version;
+      {
+         std::lock_guard<std::mutex> g(mx);
+         std::tie(payload, version) = read_payload(num);
+      }
+      if (payload.empty()) {
+         EOS_ASSERT(num == block_num, chain::state_history_exception,
+                    "chain state of block ${b} is missing, block ${n} has rows diffed against it", ("b", num)("n", num + 1));
+         return {};
+      }
+      entries.emplace_back(std::move(payload), version);
+      if (version < ship_row_diff_version)
+         break;
    }
 
-   if (block_num < begin_block() || block_num >= end_block())
-      return {};
-   state_history_log_header header;
-   get_entry_header(block_num, header);
-   return state_history::zlib_decompress(read_log);
+   for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+      auto entry = decode_chain_state(it->first, it->second, dictionary.get());
+      deltas = it->second >= ship_row_diff_version ? state_history::apply_row_diffs(entry, deltas) : std::move(entry);
+   }
+
+   if (diff_interval || entries.front().second >= ship_row_diff_version) {
+      std::lock_guard<std::mutex> g(cache_mx);
+      if (cache_generation == generation) {
+         cached_block_num = block_num;
+         cached_deltas    = deltas;
+      }
+   }
+   return deltas;
 }
 
 void state_history_chain_state_log::store(const chain::combined_database& db,
-                                          const chain::block_state_ptr&   block_state) {
+                                          const chain::block_state_ptr&   block_state,
+                                          boost::asio::io_context*        thread_pool) {
    bool fresh = this->begin_block() == this->end_block();
    if (fresh)
       ilog("Placing initial state in block ${n}", ("n", block_state->block->block_num()));
 
    using namespace state_history;
-   std::vector<table_delta> deltas = create_deltas(db, fresh);
-   state_history_log_header header{.magic = ship_magic(ship_current_version), .block_id = block_state->id};
+   std::vector<table_delta> deltas = create_deltas(db, fresh, thread_pool);
+
+   std::optional<table_names> tables;
+   if (table_index)
+      tables = changed_tables(deltas);
+
+   // the rows of a full snapshot are not kept, the file following a split can be read without the previous one
+   bool diffed = false;
+   if (differ && fresh)
+      differ->reset();
+   else if (differ)
+      diffed = differ->encode(deltas, block_state->id, block_state->block->previous,
+                              block_state->block_num % diff_interval == 0 || block_state->block_num % stride == 1);
+
+   {
+      // a block of a fork may replace the cached one
+      std::lock_guard<std::mutex> g(cache_mx);
+      ++cache_generation;
+      if (cached_block_num >= block_state->block_num) {
+         cached_block_num = 0;
+         cached_deltas.clear();
+      }
+   }
+
+   if (compression == log_compression::zstd) {
+      auto packed = fc::raw::pack(deltas);
+      auto frame  = zstd_compress(packed.data(), packed.size(), zstd_level, dictionary.get());
+      state_history_log_header header{.magic    = ship_magic(diffed ? ship_zstd_row_diff_version : ship_zstd_version),
+                                      .block_id = block_state->id};
+      this->write_entry(header, block_state->block->previous,
+                        [&frame](auto& stream) { stream.write(frame.data(), frame.size()); });
+   } else {
+      state_history_log_header header{.magic    = ship_magic(diffed ? ship_row_diff_version : ship_current_version),
+                                      .block_id = block_state->id};
+      this->write_entry(header, block_state->block->previous, [&deltas](auto& stream) { zlib_pack(stream, deltas); });
+   }
+
+   if (table_index)
+      table_index->add_block(block_state->block_num, *tables);
+}
+
+uint32_t state_history_chain_state_log::convert(const state_history_config& config) {
+   using namespace state_history;
+   const auto log_path   = config.log_dir / "chain_state_history.log";
+   const auto index_path = config.log_dir / "chain_state_history.index";
+   const auto new_path   = config.log_dir / "chain_state_history.log.new";
+   auto       dictionary = load_dictionary(config);
+   uint32_t   num_entries = 0;
+   chain::bytes prev_deltas; ///< rebuilt deltas of the previous entry
+
+   {
+      state_history_log_data log(log_path);
+      fc::cfile              out;
+      out.set_file_path(new_path);
+      out.open("wb");
+
+      uint64_t pos = 0;
+      while (pos < log.size()) {
+         uint64_t                    payload_size = log.payload_size_at(pos);
+         fc::datastream<const char*> ds(log.data() + pos, sizeof(state_history_log_header));
+         state_history_log_header    header;
+         fc::raw::unpack(ds, header);
+
+         const char*       payload_start = log.data() + pos + state_history_log_header_serial_size;
+         std::vector<char> payload(payload_start, payload_start + payload_size);
+         const auto        version = get_ship_version(header.magic);
+         auto              deltas  = decode_chain_state(payload, version, dictionary.get());
+         if (version >= ship_row_diff_version)
+            deltas = apply_row_diffs(deltas, prev_deltas);
+         if (config.chain_state_compression == log_compression::zstd) {
+            payload      = zstd_compress(deltas.data(), deltas.size(), config.zstd_level, dictionary.get());
+            header.magic = ship_magic(ship_zstd_version);
+         } else {
+            payload      = zlib_chain_state(deltas);
+            header.magic = ship_magic(ship_current_version);
+         }
+         header.payload_size = payload.size();
+
+         uint64_t new_pos       = out.tellp();
+         auto     packed_header = fc::raw::pack(header);
+         out.write(packed_header.data(), packed_header.size());
+         out.write(payload.data(), payload.size());
+         out.write(reinterpret_cast<const char*>(&new_pos), sizeof(new_pos));
+
+         pos += state_history_log_header_serial_size + payload_size + sizeof(uint64_t);
+         prev_deltas = std::move(deltas);
+         ++num_entries;
+      }
+      out.flush();
+      out.close();
+   }
 
-   this->write_entry(header, block_state->block->previous, [&deltas](auto& stream) { zlib_pack(stream, deltas); });
+   bfs::rename(new_path, log_path);
+   bfs::remove(index_path);
+   state_history_log_data(log_path).construct_index(index_path);
+   return num_entries;
 }
 
 } // namespace eosio
@@ -0,0 +1,194 @@
+#include <eosio/chain/exceptions.hpp>
+#include <eosio/state_history/row_diff.hpp>
+#include <eosio/state_history/serialization.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace eosio {
+namespace state_history {
+
+namespace {
+/// equal bytes a diff range spans rather than starting a new range
+constexpr size_t max_range_gap = 4;
+
+/// @returns the bytes which identify row in its table, nothing for the tables whose rows are not diffed
+std::optional<bytes> row_key(const std::string& table, const bytes& row) {
+   if (table == "global_property" || table == "resource_limits_state")
+      return bytes{};
+   if (table != "contract_row" && table != "key_value")
+      return {};
+   fc::datastream<const char*> ds(row.data(), row.size());
+   fc::unsigned_int            version;
+   fc::raw::unpack(ds, version);
+   size_t key_end = 0;
+   if (table == "contract_row") {
+      // contract_row_v0 starts with code, scope, table, primary_key
+      key_end = ds.tellp() + 4 * sizeof(uint64_t);
+   } else {
+      // key_value_v0 starts with contract, key
+      EOS_ASSERT(ds.remaining() >= sizeof(uint64_t), chain::state_history_exception, "invalid key_value row");
+      ds.skip(sizeof(uint64_t));
+      fc::unsigned_int key_size;
+      fc::raw::unpack(ds, key_size);
+      key_end = ds.tellp() + key_size.value;
+   }
+   EOS_ASSERT(key_end <= row.size(), chain::state_history_exception, "invalid ${t} row", ("t", table));
+   return bytes(row.data(), row.data() + key_end);
+}
+
+/// the key of row, its size, then the ranges where it differs from old: their offset from the end of the previous
+/// range, their size and their bytes
+bytes make_diff(const bytes& old, const bytes& row, size_t key_size) {
+   auto same = [&](size_t i) { return i < old.size() && old[i] == row[i]; };
+
+   std::vector<std::pair<size_t, size_t>> ranges;
+   for (size_t i = key_size; i < row.size();) {
+      if (same(i)) {
+         ++i;
+         continue;
+      }
+      size_t begin = i, end = i + 1, gap = 0;
+      for (++i; i < row.size() && gap <= max_range_gap; ++i) {
+         if (same(i))
+            ++gap;
+         else
+            gap = 0, end = i + 1;
+      }
+      ranges.emplace_back(begin, end);
+      i = end;
+   }
+
+   fc::datastream<std::vector<char>> ds;
+   ds.write(row.data(), key_size);
+   fc::raw::pack(ds, fc::unsigned_int(row.size()));
+   fc::raw::pack(ds, fc::unsigned_int(ranges.size()));
+   size_t pos = key_size;
+   for (auto [begin, end] : ranges) {
+      fc::raw::pack(ds, fc::unsigned_int(begin - pos));
+      fc::raw::pack(ds, fc::unsigned_int(end - begin));
+      ds.write(row.data() + begin, end - begin);
+      pos = end;
+   }
+   return ds.storage();
+}
+
+bytes apply_diff(const bytes& old, const bytes& diff, size_t key_size) {
+   fc::datastream<const char*> ds(diff.data() + key_size, diff.size() - key_size);
+   fc::unsigned_int            size, num_ranges;
+   fc::raw::unpack(ds, size);
+   fc::raw::unpack(ds, num_ranges);
+   EOS_ASSERT(key_size <= size.value, chain::state_history_exception, "invalid row diff");
+   bytes  row(old.begin(), old.begin() + std::min<size_t>(old.size(), size.value));
+   size_t pos = key_size;
+   row.resize(size.value);
+   for (uint32_t i = 0; i < num_ranges.value; ++i) {
+      fc::unsigned_int offset, range_size;
+      fc::raw::unpack(ds, offset);
+      fc::raw::unpack(ds, range_size);
+      pos += offset.value;
+      EOS_ASSERT(pos + range_size.value <= row.size() && range_size.value <= ds.remaining(),
+                 chain::state_history_exception, "invalid row diff");
+      ds.read(row.data() + pos, range_size.value);
+      pos += range_size.value;
+   }
+   return row;
+}
+
+/// reads row by row, the deltas of a full snapshot can hold more rows than fc unpacks into a vector
+std::vector<table_delta> unpack_deltas(const bytes& packed) {
+   std::vector<table_delta> deltas;
+   if (packed.empty())
+      return deltas;
+   fc::datastream<const char*> ds(packed.data(), packed.size());
+   fc::unsigned_int            num_deltas;
+   fc::raw::unpack(ds, num_deltas);
+   deltas.resize(num_deltas.value);
+   for (auto& delta : deltas) {
+      fc::unsigned_int num_rows;
+      fc::raw::unpack(ds, delta.struct_version);
+      fc::raw::unpack(ds, delta.name);
+      fc::raw::unpack(ds, num_rows);
+      delta.rows.obj.resize(num_rows.value);
+      for (auto& row : delta.rows.obj) {
+         fc::raw::unpack(ds, row.first);
+         fc::raw::unpack(ds, row.second);
+      }
+   }
+   return deltas;
+}
+} // namespace
+
+bool row_differ::encode(std::vector<table_delta>& deltas, const chain::block_id_type& id,
+                        const chain::block_id_type& prev_id, bool keyframe) {
+   const bool diff_rows = !keyframe && block_id && *block_id == prev_id;
+   bool       diffed    = false;
+   decltype(rows) block_rows;
+   for (auto& delta : deltas) {
+      for (auto& row : delta.rows.obj) {
+         if (row.first == 0)
+            continue;
+         auto key = row_key(delta.name, row.second);
+         if (!key)
+            break;
+         const auto                    key_size = key->size();
+         std::pair<std::string, bytes> row_id{delta.name, std::move(*key)};
+         if (diff_rows && row.first == 1) {
+            auto it = rows.find(row_id);
+            if (it != rows.end()) {
+               auto diff = make_diff(it->second, row.second, key_size);
+               if (diff.size() - key_size < (row.second.size() - key_size) / 2) {
+                  block_rows[std::move(row_id)] = std::exchange(row.second, std::move(diff));
+                  row.first                     = row_diff_present;
+                  diffed                        = true;
+                  continue;
+               }
+            }
+         }
+         block_rows[std::move(row_id)] = row.second;
+      }
+   }
+   rows     = std::move(block_rows);
+   block_id = id;
+   return diffed;
+}
+
+void row_differ::reset() {
+   rows.clear();
+   block_id.reset();
+}
+
+bytes apply_row_diffs(const bytes& deltas, const bytes& prev) {
+   std::map<std::pair<std::string, bytes>, bytes> prev_rows;
+   for (auto& delta : unpack_deltas(prev)) {
+      for (auto& row : delta.rows.obj) {
+         if (row.first == 0)
+            continue;
+         auto key = row_key(delta.name, row.second);
+         if (!key)
+            break;
+         prev_rows[{delta.name, std::move(*key)}] = std::move(row.second);
+      }
+   }
+
+   auto result = unpack_deltas(deltas);
+   for (auto& delta : result) {
+      for (auto& row : delta.rows.obj) {
+         if (row.first != row_diff_present)
+            continue;
+         // a diffed row starts with its key
+         auto key = row_key(delta.name, row.second);
+         EOS_ASSERT(key, chain::state_history_exception, "unexpected row diff in ${t}", ("t", delta.name));
+         const auto key_size = key->size();
+         auto       it       = prev_rows.find({delta.name, std::move(*key)});
+         EOS_ASSERT(it != prev_rows.end(), chain::state_history_exception,
+                    "row diff in ${t} has no row in the previous block", ("t", delta.name));
+         row.second = apply_diff(it->second, row.second, key_size);
+         row.first  = 1;
+      }
+   }
+   return fc::raw::pack(result);
+}
+
+} // namespace state_history
+} // namespace eosio
@@ -0,0 +1,161 @@
+#include <eosio/state_history/table_index.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <b1/chain_kv/chain_kv.hpp>
+
+#include <atomic>
+
+namespace eosio {
+using b1::chain_kv::bytes;
+using b1::chain_kv::check;
+using b1::chain_kv::to_slice;
+
+namespace {
+/// first byte of the keys, the sentinels of chain_kv::database are 0x00 and 0xff
+enum key_prefix : char {
+   table_prefix = 't', ///< code, table, block num -> empty
+   block_prefix = 'b', ///< block num, code, table -> empty
+   meta_prefix  = 'm'  ///< -> end block
+};
+
+bytes table_key(chain::name code, chain::name table) {
+   bytes k{table_prefix};
+   b1::chain_kv::append_key(k, code.to_uint64_t());
+   b1::chain_kv::append_key(k, table.to_uint64_t());
+   return k;
+}
+
+bytes table_key(chain::name code, chain::name table, uint32_t block_num) {
+   bytes k = table_key(code, table);
+   b1::chain_kv::append_key(k, block_num);
+   return k;
+}
+
+bytes block_key(uint32_t block_num) {
+   bytes k{block_prefix};
+   b1::chain_kv::append_key(k, block_num);
+   return k;
+}
+
+bytes block_key(uint32_t block_num, chain::name code, chain::name table) {
+   bytes k = block_key(block_num);
+   b1::chain_kv::append_key(k, code.to_uint64_t());
+   b1::chain_kv::append_key(k, table.to_uint64_t());
+   return k;
+}
+
+const bytes meta_key{meta_prefix};
+} // namespace
+
+struct state_history_table_index::impl {
+   explicit impl(const fc::path& dir)
+       : db(dir.generic_string().c_str(), true) {
+      rocksdb::PinnableSlice v;
+      auto stat = db.rdb->Get(rocksdb::ReadOptions(), db.rdb->DefaultColumnFamily(), to_slice(meta_key), &v);
+      if (!stat.IsNotFound()) {
+         check(stat, "state_history_table_index: rocksdb::DB::Get: ");
+         fc::datastream<const char*> ds(v.data(), v.size());
+         uint32_t                    end = 0;
+         fc::raw::unpack(ds, end);
+         end_block = end;
+      }
+   }
+
+   /// adds the removal of the blocks from block_num on to batch
+   void truncate(rocksdb::WriteBatch& batch, uint32_t block_num) {
+      std::unique_ptr<rocksdb::Iterator> itr{db.rdb->NewIterator(rocksdb::ReadOptions())};
+      for (itr->Seek(to_slice(block_key(block_num))); itr->Valid(); itr->Next()) {
+         auto k = itr->key();
+         if (k.empty() || k[0] != block_prefix)
+            break;
+         auto     key_itr = k.data() + 1;
+         uint32_t num     = 0;
+         uint64_t code = 0, table = 0;
+         b1::chain_kv::extract_key(key_itr, k.data() + k.size(), num);
+         b1::chain_kv::extract_key(key_itr, k.data() + k.size(), code);
+         b1::chain_kv::extract_key(key_itr, k.data() + k.size(), table);
+         check(batch.Delete(k), "state_history_table_index: rocksdb::WriteBatch::Delete: ");
+         check(batch.Delete(to_slice(table_key(chain::name(code), chain::name(table), num))),
+               "state_history_table_index: rocksdb::WriteBatch::Delete: ");
+      }
+      check(itr->status(), "state_history_table_index: rocksdb::Iterator: ");
+   }
+
+   void write(rocksdb::WriteBatch& batch, uint32_t end) {
+      check(batch.Put(to_slice(meta_key), to_slice(fc::raw::pack(end))),
+            "state_history_table_index: rocksdb::WriteBatch::Put: ");
+      check(db.rdb->Write(rocksdb::WriteOptions(), &batch), "state_history_table_index: rocksdb::DB::Write: ");
+      end_block = end;
+   }
+
+   b1::chain_kv::database db;
+   std::atomic<uint32_t>  end_block{0};
+};
+
+state_history_table_index::state_history_table_index(const fc::path& dir) {
+   if (!fc::exists(dir))
+      fc::create_directories(dir);
+   my = std::make_unique<impl>(dir);
+}
+
+state_history_table_index::~state_history_table_index() = default;
+
+uint32_t state_history_table_index::end_block() const { return my->end_block.load(); }
+
+void state_history_table_index::add_block(uint32_t block_num, const state_history::table_names& tables) {
+   rocksdb::WriteBatch batch;
+   if (block_num < my->end_block.load())
+      my->truncate(batch, block_num);
+   for (auto& [code, table] : tables) {
+      check(batch.Put(to_slice(table_key(code, table, block_num)), {}),
+            "state_history_table_index: rocksdb::WriteBatch::Put: ");
+      check(batch.Put(to_slice(block_key(block_num, code, table)), {}),
+            "state_history_table_index: rocksdb::WriteBatch::Put: ");
+   }
+   my->write(batch, block_num + 1);
+}
+
+void state_history_table_index::truncate(uint32_t block_num) {
+   if (block_num >= my->end_block.load())
+      return;
+   rocksdb::WriteBatch batch;
+   my->truncate(batch, block_num);
+   my->write(batch, block_num);
+}
+
+std::vector<uint32_t> state_history_table_index::find_blocks(chain::name code, chain::name table,
+                                                             uint32_t start_block_num, uint32_t end_block_num,
+                                                             uint32_t max_results) const {
+   std::vector<uint32_t> result;
+   if (start_block_num >= end_block_num || !max_results)
+      return result;
+   const auto                         prefix = table_key(code, table);
+   std::unique_ptr<rocksdb::Iterator> itr{my->db.rdb->NewIterator(rocksdb::ReadOptions())};
+   for (itr->Seek(to_slice(table_key(code, table, start_block_num))); itr->Valid(); itr->Next()) {
+      auto k = itr->key();
+      if (!k.starts_with(to_slice(prefix)))
+         break;
+      auto     key_itr   = k.data() + prefix.size();
+      uint32_t block_num = 0;
+      b1::chain_kv::extract_key(key_itr, k.data() + k.size(), block_num);
+      if (block_num >= end_block_num)
+         break;
+      result.push_back(block_num);
+      if (result.size() >= max_results)
+         break;
+   }
+   check(itr->status(), "state_history_table_index: rocksdb::Iterator: ");
+   return result;
+}
+
+bool state_history_table_index::changed(uint32_t block_num, chain::name code, chain::name table) const {
+   rocksdb::PinnableSlice v;
+   auto stat = my->db.rdb->Get(rocksdb::ReadOptions(), my->db.rdb->DefaultColumnFamily(),
+                               to_slice(table_key(code, table, block_num)), &v);
+   if (stat.IsNotFound())
+      return false;
+   check(stat, "state_history_table_index: rocksdb::DB::Get: ");
+   return true;
+}
+
+} // namespace eosio
@@ -1,4 +1,5 @@
 #include "eosio/state_history/transaction_trace_cache.hpp"
+#include "eosio/state_history/trace_converter.hpp"
 
 namespace eosio {
 namespace state_history {
@@ -56,4 +57,76 @@ void transaction_trace_cache::clear() {
    this->onblock_trace.reset();
 }
 
+void packed_trace_cache::add_transaction(const chainbase::database& db, bool debug_mode, compression_type compression,
+                                         const transaction_trace_ptr& trace, const packed_transaction_ptr& transaction) {
+   if (!trace->receipt)
+      return;
+
+   augmented_transaction_trace augmented{trace, transaction};
+   packed_trace                packed{.offset = arena.size()};
+   auto unprunable = fc::raw::pack(make_history_context_wrapper(db, trace_receipt_context{.debug_mode = debug_mode}, augmented));
+   arena.insert(arena.end(), unprunable.begin(), unprunable.end());
+   packed.unprunable_size = unprunable.size();
+
+   fc::datastream<std::vector<char>> prunable;
+   size_t                            size_with_padding = 0;
+   trace_converter::for_each_packed_transaction(augmented, [&](const chain::packed_transaction& pt) {
+      size_with_padding += trace_converter::pack(prunable, pt.get_prunable_data(), compression);
+   });
+   arena.insert(arena.end(), prunable.storage().begin(), prunable.storage().end());
+   packed.prunable_size = prunable.storage().size();
+   packed.padding       = size_with_padding - packed.prunable_size;
+
+   if (is_onblock(trace))
+      onblock_trace = packed;
+   else if (trace->failed_dtrx_trace)
+      cached_traces[trace->failed_dtrx_trace->id] = packed;
+   else
+      cached_traces[trace->id] = packed;
+}
+
+std::vector<char> packed_trace_cache::prepare_entry(const block_state_ptr& block_state, compression_type compression) {
+   std::vector<packed_trace> traces;
+   if (onblock_trace)
+      traces.push_back(*onblock_trace);
+   for (auto& r : block_state->block->transactions) {
+      transaction_id_type id;
+      if (std::holds_alternative<transaction_id_type>(r.trx))
+         id = std::get<transaction_id_type>(r.trx);
+      else
+         id = std::get<packed_transaction>(r.trx).id();
+      auto it = cached_traces.find(id);
+      EOS_ASSERT(it != cached_traces.end(), state_history_exception, "missing trace for transaction ${id}", ("id", id));
+      traces.push_back(it->second);
+   }
+
+   // same layout as trace_converter::pack: the zlib compressed traces, the compression of the context free data,
+   // then the prunable data of the traces and its padding
+   fc::datastream<std::vector<char>> strm;
+   if (traces.empty()) {
+      fc::raw::pack(strm, uint32_t(0));
+   } else {
+      auto unprunable = fc::raw::pack(fc::unsigned_int(traces.size()));
+      for (auto& t : traces)
+         unprunable.insert(unprunable.end(), arena.data() + t.offset, arena.data() + t.offset + t.unprunable_size);
+      zlib_pack_bytes(strm, unprunable.data(), unprunable.size());
+   }
+   fc::raw::pack(strm, static_cast<uint8_t>(compression));
+   uint32_t padding = 0;
+   for (auto& t : traces) {
+      strm.write(arena.data() + t.offset + t.unprunable_size, t.prunable_size);
+      padding += t.padding;
+   }
+   std::vector<char> entry = std::move(strm.storage());
+   entry.resize(entry.size() + padding);
+   clear();
+   return entry;
+}
+
+void packed_trace_cache::clear() {
+   arena.clear();
+   cached_traces.clear();
+   onblock_trace.reset();
+}
+
 }} // namespace eosio::state_history
@@ -106,5 +106,51 @@ struct buffered_snapshot_suite {
    }
 };
 
+// not part of snapshot_suites as there are no reference snapshots in this format
+struct compressed_snapshot_suite {
+   using writer_t = compressed_ostream_snapshot_writer;
+   using reader_t = compressed_istream_snapshot_reader;
+   using write_storage_t = std::ostringstream;
+   using snapshot_t = std::string;
+   using read_storage_t = std::istringstream;
+
+   // small frames so that sections span many frames
+   static constexpr uint32_t frame_size = 512;
+
+   struct writer : public writer_t {
+      writer( const std::shared_ptr<write_storage_t>& storage, fc::sha256::encoder* enc )
+      :writer_t(*storage, enc, 2, frame_size)
+      ,storage(storage)
+      {
+
+      }
+
+      std::shared_ptr<write_storage_t> storage;
+   };
+
+   struct reader : public reader_t {
+      explicit reader(const std::shared_ptr<read_storage_t>& storage)
+      :reader_t(*storage)
+      ,storage(storage)
+      {}
+
+      std::shared_ptr<read_storage_t> storage;
+   };
+
+
+   static auto get_writer( fc::sha256::encoder* enc = nullptr ) {
+      return std::make_shared<writer>(std::make_shared<write_storage_t>(), enc);
+   }
+
+   static auto finalize(const std::shared_ptr<writer>& w) {
+      w->finalize();
+      return w->storage->str();
+   }
+
+   static auto get_reader( const snapshot_t& buffer) {
+      return std::make_shared<reader>(std::make_shared<read_storage_t>(buffer));
+   }
+};
+
 using snapshot_suites = boost::mpl::list<variant_snapshot_suite, buffered_snapshot_suite>;
 
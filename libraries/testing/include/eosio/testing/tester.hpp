@@ -67,6 +67,10 @@ namespace eosio { namespace testing {
       full
    };
 
+   /// selects the tester constructors starting from a snapshot of a setup policy, see base_tester::init_from_setup_snapshot
+   struct from_setup_snapshot_t {};
+   inline constexpr from_setup_snapshot_t from_setup_snapshot{};
+
    std::vector<uint8_t> read_wasm( const char* fn );
    std::vector<char>    read_abi( const char* fn );
    std::string          read_wast( const char* fn );
@@ -167,6 +171,15 @@ namespace eosio { namespace testing {
          void              init(controller::config config, protocol_feature_set&& pfs);
          void              execute_setup_policy(const setup_policy policy);
 
+         /**
+          * Starts from the state execute_setup_policy(policy) leaves a new chain in, without executing it: the first
+          * time a policy is asked for in the process a chain is set up and a snapshot of it is kept, later testers
+          * start from that snapshot. The block log of the chain holds no block before the snapshot.
+          */
+         void              init_from_setup_snapshot(const setup_policy policy, db_read_mode read_mode = db_read_mode::SPECULATIVE);
+         /// a reader of the snapshot of policy, taken the first time it is asked for
+         static snapshot_reader_ptr setup_snapshot(const setup_policy policy);
+
          void              close();
          void              open( protocol_feature_set&& pfs, std::optional<chain_id_type> expected_chain_id, const std::function<void()>& lambda );
          void              open( protocol_feature_set&& pfs, const snapshot_reader_ptr& snapshot );
@@ -507,6 +520,10 @@ namespace eosio { namespace testing {
       tester(const std::function<void(controller&)>& control_setup, setup_policy policy = setup_policy::full,
              db_read_mode read_mode = db_read_mode::SPECULATIVE);
 
+      tester(from_setup_snapshot_t, setup_policy policy = setup_policy::full, db_read_mode read_mode = db_read_mode::SPECULATIVE) {
+         init_from_setup_snapshot(policy, read_mode);
+      }
+
       using base_tester::produce_block;
 
       signed_block_ptr produce_block( fc::microseconds skip_time = fc::milliseconds(config::block_interval_ms) )override {
@@ -575,6 +592,9 @@ namespace eosio { namespace testing {
       validating_tester(const fc::temp_directory& tempdir, bool use_genesis,
                         std::optional<backing_store_type> config_backing_store = std::optional<backing_store_type>{});
 
+      /// the tester and its validating node start from the snapshot of policy, see base_tester::init_from_setup_snapshot
+      validating_tester(from_setup_snapshot_t, setup_policy policy = setup_policy::full);
+
       template <typename Lambda>
       validating_tester(const fc::temp_directory& tempdir, Lambda conf_edit, bool use_genesis) {
          auto def_conf = default_config(tempdir);
@@ -5,11 +5,14 @@
 #include <eosio/chain/wast_to_wasm.hpp>
 #include <eosio/chain/eosio_contract.hpp>
 #include <eosio/chain/generated_transaction_object.hpp>
+#include <eosio/chain/snapshot.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/copy.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
 
 #include <fstream>
+#include <map>
+#include <sstream>
 
 #include <contracts.hpp>
 
@@ -193,6 +196,42 @@ namespace eosio { namespace testing {
       open(std::move(pfs), default_genesis().compute_chain_id());
    }
 
+   namespace {
+      struct snapshot_stream {
+         std::istringstream stream;
+      };
+
+      /// istream_snapshot_reader of its own copy of a binary snapshot
+      class buffered_snapshot_reader : private snapshot_stream, public istream_snapshot_reader {
+      public:
+         explicit buffered_snapshot_reader(const std::string& snapshot)
+         : snapshot_stream{std::istringstream(snapshot)}
+         , istream_snapshot_reader(stream) {}
+      };
+   }
+
+   snapshot_reader_ptr base_tester::setup_snapshot(const setup_policy policy) {
+      static std::map<setup_policy, std::string> snapshots;
+
+      auto itr = snapshots.find(policy);
+      if( itr == snapshots.end() ) {
+         tester chain(policy);
+         chain.control->abort_block();
+         std::ostringstream out;
+         auto writer = std::make_shared<ostream_snapshot_writer>(out);
+         chain.control->write_snapshot(writer);
+         writer->finalize();
+         itr = snapshots.emplace(policy, out.str()).first;
+      }
+      return std::make_shared<buffered_snapshot_reader>(itr->second);
+   }
+
+   void base_tester::init_from_setup_snapshot(const setup_policy policy, db_read_mode read_mode) {
+      auto def_conf = default_config(tempdir);
+      def_conf.first.read_mode = read_mode;
+      init(def_conf.first, setup_snapshot(policy));
+   }
+
    void base_tester::execute_setup_policy(const setup_policy policy) {
       const auto& pfm = control->get_protocol_feature_manager();
 
@@ -1251,6 +1290,20 @@ namespace eosio { namespace testing {
       }
    }
 
+   validating_tester::validating_tester(from_setup_snapshot_t, const setup_policy policy) {
+      auto def_conf = default_config(tempdir);
+      vcfg = def_conf.first;
+      config_validator(vcfg);
+
+      auto snapshot = setup_snapshot(policy);
+      validating_node = std::make_unique<controller>(vcfg, make_protocol_feature_set(), controller::extract_chain_id(*snapshot));
+      validating_node->add_indices();
+      snapshot->return_to_header();
+      validating_node->startup( [](){}, []() { return false; }, snapshot );
+
+      init(def_conf.first, setup_snapshot(policy));
+   }
+
    backing_store_type validating_tester::alternate_type(backing_store_type type) {
       return type == backing_store_type::CHAINBASE ? backing_store_type::ROCKSDB : backing_store_type::CHAINBASE;
    }
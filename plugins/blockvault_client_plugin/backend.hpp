@@ -14,11 +14,29 @@ class backend {
       virtual void on_block(std::string_view block)           = 0;
    };
 
+   /// a block proposed by propose_constructed_blocks
+   struct constructed_block {
+      std::pair<uint32_t, uint32_t> watermark;
+      uint32_t                      lib = 0;
+      std::vector<char>             block_content;
+      std::string_view              block_id;
+      std::string_view              previous_block_id;
+   };
+
    virtual ~backend() {}
 
    virtual bool propose_constructed_block(std::pair<uint32_t, uint32_t> watermark, uint32_t lib,
                                           const std::vector<char>& block_content, std::string_view block_id,
                                           std::string_view previous_block_id)                            = 0;
+   /// proposes the blocks in order, as many propose_constructed_block calls would, returns whether each was accepted
+   virtual std::vector<bool> propose_constructed_blocks(const std::vector<constructed_block>& blocks) {
+      std::vector<bool> results;
+      results.reserve(blocks.size());
+      for (const auto& b : blocks)
+         results.push_back(
+             propose_constructed_block(b.watermark, b.lib, b.block_content, b.block_id, b.previous_block_id));
+      return results;
+   }
    virtual bool append_external_block(uint32_t block_num, uint32_t lib, const std::vector<char>& block_content,
                                       std::string_view block_id, std::string_view previous_block_id)     = 0;
    virtual bool propose_snapshot(std::pair<uint32_t, uint32_t> watermark, const char* snapshot_filename) = 0;
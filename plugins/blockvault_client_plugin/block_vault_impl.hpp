@@ -6,6 +6,7 @@
 #include <fc/io/datastream.hpp>
 #include <fc/scoped_exit.hpp>
 #include <memory>
+#include <mutex>
 #include <thread>
 
 namespace eosio {
@@ -39,9 +40,19 @@ struct transform_callback : backend::sync_callback {
 
 template <typename Compressor>
 class block_vault_impl : public block_vault_interface {
+   struct pending_proposal {
+      uint32_t                  lib;
+      chain::signed_block_ptr   block;
+      std::function<void(bool)> handler;
+   };
+
    Compressor                           compressor;
    std::unique_ptr<blockvault::backend> backend;
 
+   // constructed blocks proposed while the backend is busy are proposed together by the next round trip
+   std::mutex                    pending_mtx;
+   std::vector<pending_proposal> pending_proposals;
+
    boost::asio::io_context                                                  ioc;
    std::thread                                                              thr;
    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work;
@@ -61,27 +72,14 @@ class block_vault_impl : public block_vault_interface {
 
    void async_propose_constructed_block(uint32_t lib, chain::signed_block_ptr block,
                                         std::function<void(bool)> handler) override {
-      boost::asio::post(ioc, [this, handler, lib, block]() {
-         try {
-            fc::datastream<std::vector<char>> stream;
-            fc::raw::pack(stream, *block);
-            eosio::chain::block_id_type block_id = block->calculate_id();
-
-            bool r = backend->propose_constructed_block({block->block_num(), block->timestamp.slot}, lib,
-                                                        stream.storage(), {block_id.data(), block_id.data_size()},
-                                                        {block->previous.data(), block->previous.data_size()});
-
-            // Notice : 
-            //   This following logging line is used for checking double production in 'tests/blockvault_tests.py'.
-            //   Make sure the corresponding code in 'tests/blockvault_tests.py' is changed if the format is changed.
-            fc_dlog(log, "propose_constructed_block(watermark={${bn}, ${ts}}, lib=${lib}) returns ${r}",
-                 ("bn", block->block_num())("ts", block->timestamp.slot)("lib", lib)("r", r));
-            handler(r);
-         } catch (std::exception& ex) {
-            fc_elog(log, ex.what());
-            handler(false);
-         }
-      });
+      bool idle = false;
+      {
+         std::lock_guard<std::mutex> g(pending_mtx);
+         idle = pending_proposals.empty();
+         pending_proposals.push_back({lib, std::move(block), std::move(handler)});
+      }
+      if (idle)
+         boost::asio::post(ioc, [this]() { propose_pending_blocks(); });
    }
    void async_append_external_block(uint32_t lib, chain::signed_block_ptr block,
                                     std::function<void(bool)> handler) override {
@@ -129,6 +127,49 @@ class block_vault_impl : public block_vault_interface {
       backend->sync(bid, cb);
    }
 
+   /// proposes the pending constructed blocks in one round trip, their handlers are called in order
+   void propose_pending_blocks() {
+      std::vector<pending_proposal> proposals;
+      {
+         std::lock_guard<std::mutex> g(pending_mtx);
+         proposals.swap(pending_proposals);
+      }
+      if (proposals.empty())
+         return;
+
+      std::vector<bool> results;
+      try {
+         std::vector<eosio::chain::block_id_type>  block_ids;
+         std::vector<backend::constructed_block>   blocks;
+         block_ids.reserve(proposals.size());
+         blocks.reserve(proposals.size());
+         for (const auto& p : proposals) {
+            const auto& block_id = block_ids.emplace_back(p.block->calculate_id());
+            blocks.push_back({{p.block->block_num(), p.block->timestamp.slot}, p.lib, fc::raw::pack(*p.block),
+                              {block_id.data(), block_id.data_size()},
+                              {p.block->previous.data(), p.block->previous.data_size()}});
+         }
+         results = backend->propose_constructed_blocks(blocks);
+      } catch (std::exception& ex) {
+         fc_elog(log, ex.what());
+      }
+      results.resize(proposals.size(), false);
+
+      for (size_t i = 0; i < proposals.size(); ++i) {
+         const auto& block = proposals[i].block;
+         // Notice : 
+         //   This following logging line is used for checking double production in 'tests/blockvault_tests.py'.
+         //   Make sure the corresponding code in 'tests/blockvault_tests.py' is changed if the format is changed.
+         fc_dlog(log, "propose_constructed_block(watermark={${bn}, ${ts}}, lib=${lib}) returns ${r}",
+              ("bn", block->block_num())("ts", block->timestamp.slot)("lib", proposals[i].lib)("r", bool(results[i])));
+         try {
+            proposals[i].handler(results[i]);
+         } catch (std::exception& ex) {
+            fc_elog(log, ex.what());
+         }
+      }
+   }
+
    void start() {
       thr = std::thread([&log = log, & ioc = ioc]() {
          fc_ilog(log, "block vault thread started");
@@ -24,10 +24,11 @@ postgres_backend::postgres_backend(const std::string& options)
    
    conn.prepare("serialize_transaction", "SET TRANSACTION ISOLATION LEVEL SERIALIZABLE;");
 
+   // the large object is only created when the block is accepted, so a proposal takes a single round trip
    conn.prepare(
        "insert_constructed_block",
        "INSERT INTO BlockData (watermark_bn, watermark_ts, lib, block_num, block_id, previous_block_id, block, block_size) "
-       "SELECT $1, $2, $3, $1, $4, $5, $6, $7  WHERE NOT "
+       "SELECT $1, $2, $3, $1, $4, $5, lo_from_bytea(0, $6), $7  WHERE NOT "
        "EXISTS (SELECT * FROM BlockData WHERE (watermark_bn >= $1) OR (watermark_ts >= $2) OR (lib > $3))");
 
    conn.prepare(
@@ -51,12 +52,6 @@ postgres_backend::postgres_backend(const std::string& options)
    conn.prepare("get_latest_snapshot", "SELECT snapshot FROM SnapshotData "
                                        "ORDER BY watermark_bn DESC, watermark_ts DESC LIMIT 1");
 
-   conn.prepare("get_blocks_since_watermark", "SELECT block, block_size FROM BlockData WHERE "
-                                              "watermark_bn >= $1 AND watermark_ts >= $2"
-                                              "ORDER BY block_num");
-
-   conn.prepare("get_all_blocks", "SELECT block, block_size FROM BlockData");
-
    conn.prepare("delete_outdated_block_lo",
                 "SELECT lo_unlink(r.block) FROM BlockData r WHERE watermark_bn <= $1 OR watermark_ts <= $2;");
    conn.prepare("delete_outdated_block_data", "DELETE FROM BlockData WHERE watermark_bn <= $1 OR watermark_ts <= $2;");
@@ -71,26 +66,31 @@ postgres_backend::postgres_backend(const std::string& options)
 bool postgres_backend::propose_constructed_block(std::pair<uint32_t, uint32_t> watermark, uint32_t lib,
                                                  const std::vector<char>& block_content, std::string_view block_id,
                                                  std::string_view previous_block_id) {
+   return propose_constructed_blocks({{watermark, lib, block_content, block_id, previous_block_id}})[0];
+}
+
+std::vector<bool> postgres_backend::propose_constructed_blocks(const std::vector<constructed_block>& blocks) {
+   // the blocks are inserted by a single transaction, a rejected block does not prevent the following ones from
+   // being accepted but a failed transaction rejects them all
+   std::vector<bool> results(blocks.size(), false);
    try {
       pqxx::work w(conn);
       w.exec_prepared0("serialize_transaction");
-      pqxx::largeobjectaccess obj(w);
-      
-      obj.write(nullptr, 0);
-      pqxx::binarystring      block_id_blob(block_id.data(), block_id.size());
-      pqxx::binarystring      previous_block_id_blob(previous_block_id.data(), previous_block_id.size());
-      w.exec_prepared0("insert_constructed_block", watermark.first, watermark.second, lib, block_id_blob,
-                       previous_block_id_blob, obj.id(), block_content.size());
-      auto r = w.exec_prepared("get_block_insertion_result", obj.id());
-      if (!r.empty()) {
-         obj.write(block_content.data(), block_content.size());
-         w.commit();
-         return true;
+      for (size_t i = 0; i < blocks.size(); ++i) {
+         const auto&        b = blocks[i];
+         pqxx::binarystring block_id_blob(b.block_id.data(), b.block_id.size());
+         pqxx::binarystring previous_block_id_blob(b.previous_block_id.data(), b.previous_block_id.size());
+         pqxx::binarystring block_blob(b.block_content.data(), b.block_content.size());
+         auto r = w.exec_prepared("insert_constructed_block", b.watermark.first, b.watermark.second, b.lib,
+                                  block_id_blob, previous_block_id_blob, block_blob, b.block_content.size());
+         results[i] = r.affected_rows() == 1;
       }
+      w.commit();
+      return results;
    } catch (const pqxx::sql_error&) {
-   } 
+   }
 
-   return false;
+   return std::vector<bool>(blocks.size(), false);
 }
 
 bool postgres_backend::append_external_block(uint32_t block_num, uint32_t lib, const std::vector<char>& block_content,
@@ -156,16 +156,16 @@ bool postgres_backend::propose_snapshot(std::pair<uint32_t, uint32_t> watermark,
    return false;
 }
 
-void retrieve_blocks(backend::sync_callback& callback, pqxx::work& trx, pqxx::result r) {
-   std::vector<char> block_data;
-
-   for (const auto& x : r) {
-      pqxx::oid               block_oid  = x[0].as<pqxx::oid>();
-      uint64_t                block_size = x[1].as<uint64_t>();
-      pqxx::largeobjectaccess obj(trx, block_oid, std::ios::in | std::ios::binary);
-      block_data.resize(block_size);
-      obj.read(block_data.data(), block_size);
-      callback.on_block(std::string_view{block_data.data(), block_data.size()});
+void retrieve_blocks(backend::sync_callback& callback, pqxx::work& trx, const std::string& query) {
+   // the blocks are read by the query, a batch of rows per round trip instead of a few round trips per large object
+   const int           blocks_per_fetch = 64;
+   pqxx::icursorstream stream(trx, query, "sync_blocks", blocks_per_fetch);
+   pqxx::result        r;
+   while (stream >> r) {
+      for (const auto& x : r) {
+         pqxx::binarystring block(x[0]);
+         callback.on_block(std::string_view{block.get(), block.size()});
+      }
    }
 
    trx.commit();
@@ -179,9 +179,9 @@ void postgres_backend::sync(std::string_view previous_block_id, backend::sync_ca
       auto               r = trx.exec_prepared("get_sync_watermark", blob);
 
       if (!r.empty()) {
-         retrieve_blocks(
-             callback, trx,
-             trx.exec_prepared("get_blocks_since_watermark", r[0][0].as<uint32_t>(), r[0][1].as<uint32_t>()));
+         retrieve_blocks(callback, trx,
+                         "SELECT lo_get(block) FROM BlockData WHERE watermark_bn >= " + trx.quote(r[0][0].as<uint32_t>()) +
+                             " AND watermark_ts >= " + trx.quote(r[0][1].as<uint32_t>()) + " ORDER BY block_num");
          return;
       }
 
@@ -203,7 +203,7 @@ void postgres_backend::sync(std::string_view previous_block_id, backend::sync_ca
       callback.on_snapshot(fname.c_str());
    }
 
-   retrieve_blocks(callback, trx, trx.exec_prepared("get_all_blocks"));
+   retrieve_blocks(callback, trx, "SELECT lo_get(block) FROM BlockData");
 }
 
 } // namespace blockvault
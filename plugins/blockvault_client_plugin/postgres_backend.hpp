@@ -14,6 +14,7 @@ class postgres_backend : public backend {
    bool propose_constructed_block(std::pair<uint32_t, uint32_t> watermark, uint32_t lib,
                                   const std::vector<char>& block_content, std::string_view block_id,
                                   std::string_view previous_block_id) override;
+   std::vector<bool> propose_constructed_blocks(const std::vector<constructed_block>& blocks) override;
    bool append_external_block(uint32_t block_num, uint32_t lib, const std::vector<char>& block_content,
                               std::string_view block_id, std::string_view previous_block_id) override;
    bool propose_snapshot(std::pair<uint32_t, uint32_t> watermark, const char* snapshot_filename) override;
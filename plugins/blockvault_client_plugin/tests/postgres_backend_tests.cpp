@@ -111,6 +111,34 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_propose_constructed_block, T, test_types) {
    BOOST_REQUIRE(!fixture.propose_constructed_block(15, 4, 4, 'f'));
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(test_propose_constructed_blocks, T, test_types) {
+   backend_test_fixture<T> fixture;
+
+   BOOST_REQUIRE(fixture.propose_constructed_block(10, 1, 1, 'a'));
+
+   std::vector<mock_block_id>                                 ids;
+   std::vector<eosio::blockvault::backend::constructed_block> blocks;
+   ids.reserve(8);
+   auto add_block = [&](uint32_t watermark_bn, uint32_t watermark_ts, uint32_t lib, char block_discriminator) {
+      const auto& id = ids.emplace_back(watermark_bn, block_discriminator);
+      const auto& previous_id = ids.emplace_back(watermark_bn - 1, 'b');
+      std::vector<char> block(64);
+      block[0] = block_discriminator;
+      blocks.push_back({{watermark_bn, watermark_ts}, lib, std::move(block), id, previous_id});
+   };
+   add_block(11, 2, 2, 'b');
+   add_block(11, 3, 2, 'c'); // watermark_bn is not increasing over the previous block of the batch
+   add_block(12, 3, 3, 'd');
+   add_block(13, 4, 2, 'e'); // lib is decreasing
+
+   const std::vector<bool> expected = {true, false, true, false};
+   BOOST_CHECK(fixture.backend.propose_constructed_blocks(blocks) == expected);
+
+   // blocks accepted by a batch are stored
+   BOOST_REQUIRE(!fixture.propose_constructed_block(12, 5, 3, 'f'));
+   BOOST_REQUIRE(fixture.propose_constructed_block(13, 5, 3, 'f'));
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE(test_append_external_block, T, test_types) {
 
    backend_test_fixture<T> fixture;
@@ -1,8 +1,12 @@
 #include <eosio/chain_api_plugin/chain_api_plugin.hpp>
+#include <eosio/http_plugin/json_body.hpp>
+#include <eosio/http_plugin/main_thread_queue.hpp>
 #include <eosio/chain/exceptions.hpp>
 
 #include <fc/io/json.hpp>
 
+#include <set>
+
 namespace eosio {
 
 static appbase::abstract_plugin& _chain_api_plugin = app().register_plugin<chain_api_plugin>();
@@ -15,6 +19,7 @@ public:
       : db(db) {}
 
    controller& db;
+   std::optional<boost::signals2::scoped_connection> accepted_block_connection;
 };
 
 
@@ -40,7 +45,7 @@ namespace {
 
       try {
         try {
-           return fc::json::from_string(body).as<T>();
+           return parse_json_body(body).as<T>();
         } catch (const chain::chain_exception& e) { // EOS_RETHROW_EXCEPTIONS does not re-type these so, re-code it
           throw fc::exception(e);
         }
@@ -54,8 +59,34 @@ namespace {
           api_handle.validate(); \
           try { \
              auto params = parse_params<api_namespace::call_name ## _params, params_type>(body);\
-             fc::variant result( api_handle.call_name( std::move(params) ) ); \
-             cb(http_response_code, std::move(result)); \
+             cb(http_response_code, packed_response_body::make( api_handle.call_name( std::move(params) ) )); \
+          } catch (...) { \
+             http_plugin::handle_exception(#api_name, #call_name, body, cb); \
+          } \
+       }}
+
+// results with a to_json() that writes the response body itself
+#define CALL_JSON_WITH_400(api_name, api_handle, api_namespace, call_name, http_response_code, params_type) \
+{std::string("/v1/" #api_name "/" #call_name), \
+   [api_handle](string, string body, url_response_callback cb) mutable { \
+          api_handle.validate(); \
+          try { \
+             auto params = parse_params<api_namespace::call_name ## _params, params_type>(body);\
+             cb(http_response_code, json_response_body{ api_handle.call_name( std::move(params) ).to_json() }); \
+          } catch (...) { \
+             http_plugin::handle_exception(#api_name, #call_name, body, cb); \
+          } \
+       }}
+
+// get_block served from the rendered block cache with its ETag
+#define CALL_BLOCK_JSON_WITH_400(api_name, api_handle, api_namespace, call_name, http_response_code, params_type) \
+{std::string("/v1/" #api_name "/" #call_name), \
+   [api_handle](string, string body, url_response_callback cb) mutable { \
+          api_handle.validate(); \
+          try { \
+             auto params = parse_params<api_namespace::call_name ## _params, params_type>(body);\
+             auto result = api_handle.call_name ## _json( std::move(params) ); \
+             cb(http_response_code, json_response_body{ *result.json, std::move(result.etag) }); \
           } catch (...) { \
              http_plugin::handle_exception(#api_name, #call_name, body, cb); \
           } \
@@ -86,12 +117,99 @@ namespace {
 }
 
 #define CHAIN_RO_CALL(call_name, http_response_code, params_type) CALL_WITH_400(chain, ro_api, chain_apis::read_only, call_name, http_response_code, params_type)
+#define CHAIN_RO_CALL_JSON(call_name, http_response_code, params_type) CALL_JSON_WITH_400(chain, ro_api, chain_apis::read_only, call_name, http_response_code, params_type)
+#define CHAIN_RO_CALL_BLOCK_JSON(call_name, http_response_code, params_type) CALL_BLOCK_JSON_WITH_400(chain, ro_api, chain_apis::read_only, call_name, http_response_code, params_type)
 #define CHAIN_RW_CALL(call_name, http_response_code, params_type) CALL_WITH_400(chain, rw_api, chain_apis::read_write, call_name, http_response_code, params_type)
 #define CHAIN_RO_CALL_ASYNC(call_name, call_result, http_response_code, params_type) CALL_ASYNC_WITH_400(chain, ro_api, chain_apis::read_only, call_name, call_result, http_response_code, params_type)
 #define CHAIN_RW_CALL_ASYNC(call_name, call_result, http_response_code, params_type) CALL_ASYNC_WITH_400(chain, rw_api, chain_apis::read_write, call_name, call_result, http_response_code, params_type)
 
 #define CHAIN_RO_CALL_WITH_400(call_name, http_response_code, params_type) CALL_WITH_400(chain, ro_api, chain_apis::read_only, call_name, http_response_code, params_type)
 
+namespace {
+   constexpr size_t max_batch_calls = 100;
+   const std::string chain_url_prefix = "/v1/chain/";
+
+   /// read only calls available to /v1/chain/batch by call name, they must respond before returning
+   struct batch_calls {
+      std::map<std::string, url_handler>  handlers;
+      std::set<std::string>               state_calls; ///< calls which may run on the read only api threads
+
+      void add( const api_description& api, bool state ) {
+         for( const auto& call : api ) {
+            auto name = call.first.substr( chain_url_prefix.size() );
+            if( state ) state_calls.insert( name );
+            handlers.emplace( std::move( name ), call.second );
+         }
+      }
+   };
+
+   struct batch_call {
+      const url_handler*  handler = nullptr;
+      std::string         params; ///< JSON of the params of the call, empty when none were given
+   };
+
+   /// parse the [{"call": "get_account", "params": {...}}, ...] body of a batch, sets state_only when all calls are state calls
+   std::vector<batch_call> parse_batch( const std::string& body, const batch_calls& calls, bool& state_only ) {
+      EOS_ASSERT( !body.empty(), chain::invalid_http_request, "A Request body is required" );
+      fc::variant v;
+      try {
+         v = parse_json_body( body );
+      } EOS_RETHROW_EXCEPTIONS( chain::invalid_http_request, "Unable to parse valid input from POST body" )
+      EOS_ASSERT( v.is_array(), chain::invalid_http_request, "batch expects an array of calls" );
+      const auto& arr = v.get_array();
+      EOS_ASSERT( arr.size() <= max_batch_calls, chain::invalid_http_request,
+                  "batch of ${n} calls exceeds the maximum of ${m}", ("n", arr.size())("m", max_batch_calls) );
+
+      std::vector<batch_call> result;
+      result.reserve( arr.size() );
+      state_only = true;
+      for( const auto& item : arr ) {
+         EOS_ASSERT( item.is_object() && item.get_object().contains( "call" ), chain::invalid_http_request,
+                     "batch call requires a call name" );
+         const auto& obj = item.get_object();
+         const auto name = obj["call"].as_string();
+         auto itr = calls.handlers.find( name );
+         EOS_ASSERT( itr != calls.handlers.end(), chain::invalid_http_request, "${c} is not a read only chain call", ("c", name) );
+         state_only = state_only && calls.state_calls.count( name );
+         batch_call c{ &itr->second };
+         if( obj.contains( "params" ) ) {
+            c.params = fc::json::to_string( obj["params"], fc::time_point::maximum() );
+         }
+         result.emplace_back( std::move( c ) );
+      }
+      return result;
+   }
+
+   /// run the calls one after the other, JSON array of their {"code": ..., "body": ...} responses
+   std::string run_batch( const std::vector<batch_call>& calls ) {
+      std::string json = "[";
+      for( size_t i = 0; i < calls.size(); ++i ) {
+         int code = 500;
+         url_response_body body;
+         (*calls[i].handler)( std::string(), calls[i].params, [&code, &body]( int c, url_response_body b ) {
+            code = c;
+            body = std::move( b );
+         } );
+         if( i ) json += ',';
+         json += "{\"code\":";
+         json += std::to_string( code );
+         json += ",\"body\":";
+         if( auto* j = std::get_if<json_response_body>( &body ) ) {
+            json += j->json;
+         } else if( auto* p = std::get_if<packed_response_body>( &body ) ) {
+            json += fc::json::to_string( p->to_variant(), fc::time_point::maximum() );
+         } else if( const auto& obj = std::get<std::optional<fc::variant>>( body ); obj.has_value() ) {
+            json += fc::json::to_string( *obj, fc::time_point::maximum() );
+         } else {
+            json += "null";
+         }
+         json += '}';
+      }
+      json += ']';
+      return json;
+   }
+}
+
 
    
 void chain_api_plugin::plugin_startup() {
@@ -103,45 +221,106 @@ void chain_api_plugin::plugin_startup() {
    
    auto& _http_plugin = app().get_plugin<http_plugin>();
    ro_api.set_shorten_abi_errors( !_http_plugin.verbose_errors() );
+   ro_api.set_table_rows_json_text( true );
 
-   _http_plugin.add_api({
-      CHAIN_RO_CALL(get_info, 200, http_params_types::no_params_required)}, appbase::priority::medium_high);
-   _http_plugin.add_api({
+   api_description info_api{
+      CHAIN_RO_CALL(get_info, 200, http_params_types::no_params_required)};
+   _http_plugin.add_api(info_api, appbase::priority::medium_high, "chain_info");
+   api_description main_thread_api{
       CHAIN_RO_CALL(get_activated_protocol_features, 200, http_params_types::possible_no_params),
-      CHAIN_RO_CALL(get_block, 200, http_params_types::params_required),
+      CHAIN_RO_CALL_BLOCK_JSON(get_block, 200, http_params_types::params_required),
+      CHAIN_RO_CALL(get_block_cache_metrics, 200, http_params_types::no_params_required),
       CHAIN_RO_CALL(get_block_info, 200, http_params_types::params_required),
+      CHAIN_RO_CALL(get_transaction_block_num, 200, http_params_types::params_required),
       CHAIN_RO_CALL(get_block_header_state, 200, http_params_types::params_required),
+      CHAIN_RO_CALL(get_producer_schedule, 200, http_params_types::no_params_required),
+      CHAIN_RO_CALL(get_transaction_id, 200, http_params_types::params_required),
+      CHAIN_RO_CALL(get_required_keys, 200, http_params_types::params_required)};
+   _http_plugin.add_api(main_thread_api, appbase::priority::medium_low, "chain_ro");
+   _http_plugin.add_api({
+      CHAIN_RW_CALL_ASYNC(push_block, chain_apis::read_write::push_block_results, 202, http_params_types::params_required),
+      CHAIN_RW_CALL_ASYNC(push_transaction, chain_apis::read_write::push_transaction_results, 202, http_params_types::params_required),
+      CHAIN_RW_CALL_ASYNC(push_transactions, chain_apis::read_write::push_transactions_results, 202, http_params_types::params_required),
+      CHAIN_RW_CALL_ASYNC(send_transaction, chain_apis::read_write::send_transaction_results, 202, http_params_types::params_required),
+      CHAIN_RW_CALL_ASYNC(send_read_only_transaction, chain_apis::read_write::send_read_only_transaction_results, 200, http_params_types::params_required)
+   }, appbase::priority::medium_low, "chain_rw");
+
+   // calls reading only chainbase state, they may run on the read only api threads; calls reading the block log
+   // or fork database stay on the main thread, as does get_required_keys which fills the authorization_manager caches
+   api_description state_api{
       CHAIN_RO_CALL(get_account, 200, http_params_types::params_required),
       CHAIN_RO_CALL(get_code, 200, http_params_types::params_required),
       CHAIN_RO_CALL(get_code_hash, 200, http_params_types::params_required),
       CHAIN_RO_CALL(get_abi, 200, http_params_types::params_required),
       CHAIN_RO_CALL(get_raw_code_and_abi, 200, http_params_types::params_required),
       CHAIN_RO_CALL(get_raw_abi, 200, http_params_types::params_required),
-      CHAIN_RO_CALL(get_table_rows, 200, http_params_types::params_required),
+      CHAIN_RO_CALL_JSON(get_table_rows, 200, http_params_types::params_required),
       CHAIN_RO_CALL(get_kv_table_rows, 200, http_params_types::params_required),
       CHAIN_RO_CALL(get_table_by_scope, 200, http_params_types::params_required),
       CHAIN_RO_CALL(get_currency_balance, 200, http_params_types::params_required),
       CHAIN_RO_CALL(get_currency_stats, 200, http_params_types::params_required),
       CHAIN_RO_CALL(get_producers, 200, http_params_types::params_required),
-      CHAIN_RO_CALL(get_producer_schedule, 200, http_params_types::no_params_required),
       CHAIN_RO_CALL(get_scheduled_transactions, 200, http_params_types::params_required),
       CHAIN_RO_CALL(abi_json_to_bin, 200, http_params_types::params_required),
-      CHAIN_RO_CALL(abi_bin_to_json, 200, http_params_types::params_required),
-      CHAIN_RO_CALL(get_required_keys, 200, http_params_types::params_required),
-      CHAIN_RO_CALL(get_transaction_id, 200, http_params_types::params_required),
-      CHAIN_RW_CALL_ASYNC(push_block, chain_apis::read_write::push_block_results, 202, http_params_types::params_required),
-      CHAIN_RW_CALL_ASYNC(push_transaction, chain_apis::read_write::push_transaction_results, 202, http_params_types::params_required),
-      CHAIN_RW_CALL_ASYNC(push_transactions, chain_apis::read_write::push_transactions_results, 202, http_params_types::params_required),
-      CHAIN_RW_CALL_ASYNC(send_transaction, chain_apis::read_write::send_transaction_results, 202, http_params_types::params_required)
-   });
+      CHAIN_RO_CALL(abi_bin_to_json, 200, http_params_types::params_required)
+   };
+
+   auto batch = std::make_shared<batch_calls>();
+   batch->add(info_api, false);
+   batch->add(main_thread_api, false);
+   batch->add(state_api, true);
+
+   auto* executor = chain.get_read_only_api_executor();
+   if (executor) {
+      for (auto& call : state_api) {
+         call.second = [executor, next=std::make_shared<url_handler>(std::move(call.second))](string url, string body, url_response_callback cb) {
+            executor->post([next, url=std::move(url), body=std::move(body), cb=std::move(cb)]() mutable {
+               (*next)(std::move(url), std::move(body), std::move(cb));
+            });
+         };
+      }
+      _http_plugin.add_async_api(state_api, "chain_ro");
+   } else {
+      _http_plugin.add_api(state_api, appbase::priority::medium_low, "chain_ro");
+   }
+
+   // runs a batch of read only calls as a single task, so they all see the same state
+   _http_plugin.add_async_api({{chain_url_prefix + "batch",
+      [batch, executor](string, string body, url_response_callback cb) {
+         try {
+            bool state_only = false;
+            auto calls = parse_batch(body, *batch, state_only);
+            auto run = [batch, calls=std::move(calls), cb]() {
+               cb(200, json_response_body{ run_batch(calls) });
+            };
+            if (executor && state_only) {
+               executor->post(std::move(run));
+            } else {
+               main_thread_post(appbase::priority::medium_low, std::move(run));
+            }
+         } catch (...) {
+            http_plugin::handle_exception("chain", "batch", body, cb);
+         }
+      }}}, "chain_ro");
    
    if (chain.account_queries_enabled()) {
       _http_plugin.add_async_api({
          CHAIN_RO_CALL_WITH_400(get_accounts_by_authorizers, 200, http_params_types::params_required),
-      });
+      }, "chain_ro");
    }
+
+   // calls answering the same until the next block, so the http response cache may answer them
+   for (const char* call : {"get_info", "get_producers", "get_currency_stats", "get_table_by_scope",
+                            "get_producer_schedule", "get_activated_protocol_features"}) {
+      _http_plugin.enable_response_cache(chain_url_prefix + call);
+   }
+   my->accepted_block_connection.emplace(my->db.accepted_block.connect([&_http_plugin](const chain::block_state_ptr&) {
+      _http_plugin.invalidate_response_cache();
+   }));
 }
 
-void chain_api_plugin::plugin_shutdown() {}
+void chain_api_plugin::plugin_shutdown() {
+   if (my) my->accepted_block_connection.reset();
+}
 
 }
@@ -17,6 +17,10 @@ namespace eosio { namespace chain { namespace plugin_interface {
 
    struct chain_plugin_interface;
 
+   /// origin of an incoming transaction, p2p peers use their connection id
+   using transaction_source = uint32_t;
+   constexpr transaction_source api_transaction_source = 0;
+
    namespace channels {
       using pre_accepted_block     = channel_decl<struct pre_accepted_block_tag,    signed_block_ptr>;
       using rejected_block         = channel_decl<struct rejected_block_tag,        signed_block_ptr>;
@@ -46,7 +50,7 @@ namespace eosio { namespace chain { namespace plugin_interface {
          // synchronously push a block/trx to a single provider
          using block_sync            = method_decl<chain_plugin_interface, bool(const signed_block_ptr&, const std::optional<block_id_type>&), first_provider_policy>;
          using blockvault_sync       = method_decl<chain_plugin_interface, bool(const signed_block_ptr&, bool), first_provider_policy>;
-         using transaction_async     = method_decl<chain_plugin_interface, void(const packed_transaction_ptr&, bool, next_function<transaction_trace_ptr>), first_provider_policy>;
+         using transaction_async     = method_decl<chain_plugin_interface, void(const packed_transaction_ptr&, bool, transaction_source, next_function<transaction_trace_ptr>), first_provider_policy>;
       }
    }
 
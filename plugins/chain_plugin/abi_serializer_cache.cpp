@@ -0,0 +1,83 @@
+#include <eosio/chain_plugin/abi_serializer_cache.hpp>
+
+#include <eosio/chain/controller.hpp>
+#include <eosio/chain/config.hpp>
+
+namespace eosio::chain_apis {
+   using namespace eosio::chain;
+   using namespace eosio::chain::literals;
+
+   abi_serializer_cache::abi_serializer_cache( size_t max_entries )
+   : max_entries( max_entries )
+   {}
+
+   cached_abi_ptr abi_serializer_cache::make( const account_object& account, const fc::microseconds& abi_serializer_max_time ) {
+      auto result = std::make_shared<cached_abi>();
+      if( abi_serializer::to_abi( account.abi, result->abi ) ) {
+         result->serializer.set_abi( result->abi, abi_serializer::create_yield_function( abi_serializer_max_time ) );
+         result->has_abi = true;
+      }
+      return result;
+   }
+
+   cached_abi_ptr abi_serializer_cache::get( const controller& db, const account_object& account,
+                                             const fc::microseconds& abi_serializer_max_time ) {
+      if( max_entries == 0 ) return make( account, abi_serializer_max_time );
+
+      const auto* metadata = db.db().find<account_metadata_object, by_name>( account.name );
+      const uint64_t abi_sequence = metadata ? metadata->abi_sequence : 0;
+      {
+         std::lock_guard<std::mutex> g( mtx );
+         auto itr = entries.find( account.name );
+         if( itr != entries.end() && itr->second.abi_sequence == abi_sequence ) {
+            itr->second.last_used = ++use_count;
+            return itr->second.abi;
+         }
+      }
+
+      // constructed without holding the lock, another thread may construct the same abi meanwhile
+      auto abi = make( account, abi_serializer_max_time );
+
+      std::lock_guard<std::mutex> g( mtx );
+      auto& e = entries[account.name];
+      e.abi_sequence = abi_sequence;
+      e.last_used = ++use_count;
+      e.abi = abi;
+      if( entries.size() > max_entries ) {
+         auto lru = entries.begin();
+         for( auto itr = entries.begin(); itr != entries.end(); ++itr ) {
+            if( itr->second.last_used < lru->second.last_used ) lru = itr;
+         }
+         entries.erase( lru );
+      }
+      return abi;
+   }
+
+   void abi_serializer_cache::invalidate( const transaction_trace_ptr& trace ) {
+      for( const auto& at : trace->action_traces ) {
+         if( at.receiver != config::system_account_name || at.act.account != config::system_account_name ||
+             at.act.name != "setabi"_n ) continue;
+         // account is the first field of setabi
+         if( at.act.data.size() < sizeof(uint64_t) ) continue;
+         fc::datastream<const char*> ds( at.act.data.data(), at.act.data.size() );
+         name account;
+         fc::raw::unpack( ds, account );
+         erase( account );
+      }
+   }
+
+   void abi_serializer_cache::erase( const name& account ) {
+      std::lock_guard<std::mutex> g( mtx );
+      entries.erase( account );
+   }
+
+   void abi_serializer_cache::clear() {
+      std::lock_guard<std::mutex> g( mtx );
+      entries.clear();
+   }
+
+   size_t abi_serializer_cache::size()const {
+      std::lock_guard<std::mutex> g( mtx );
+      return entries.size();
+   }
+}
@@ -1,7 +1,10 @@
 #include <eosio/chain_plugin/account_query_db.hpp>
 
+#include <eosio/chain/authority_checker.hpp>
+#include <eosio/chain/authorization_manager.hpp>
 #include <eosio/chain/contract_types.hpp>
 #include <eosio/chain/controller.hpp>
+#include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/permission_object.hpp>
 
 #include <boost/multi_index_container.hpp>
@@ -9,16 +12,14 @@
 #include <boost/multi_index/composite_key.hpp>
 #include <boost/multi_index/member.hpp>
 
-#include <boost/bimap.hpp>
-#include <boost/bimap/multiset_of.hpp>
-#include <boost/bimap/set_of.hpp>
-
+#include <algorithm>
+#include <atomic>
+#include <set>
 #include <shared_mutex>
 
 using namespace eosio;
 using namespace eosio::chain::literals;
 using namespace boost::multi_index;
-using namespace boost::bimaps;
 
 namespace {
    /**
@@ -32,9 +33,7 @@ namespace {
       uint32_t       last_updated_height;
 
       // un-indexed data
-      uint32_t       threshold;
-
-      using cref = std::reference_wrapper<const permission_info>;
+      chain::authority auth;
    };
 
    struct by_owner_name;
@@ -77,18 +76,31 @@ namespace {
              auth.permission == eosio::chain::config::active_name;
    }
 
+   /**
+    * A permission satisfiable in part by an authorizer (an account permission or an interned key) with a weight.
+    * One entry per authorizer of each permission, ordered by authorizer so the permissions of an authorizer are
+    * a range; looking up a range by the authorizer alone is supported.
+    */
    template<typename T>
-   struct weighted {
-      T                   value;
-      chain::weight_type  weight;
-
-      static weighted lower_bound_for( const T& value ) {
-         return {value, std::numeric_limits<chain::weight_type>::min()};
-      }
+   struct authorizer_entry {
+      T                        value;
+      chain::weight_type       weight;
+      const permission_info*   permission;
+
+      struct less {
+         using is_transparent = void;
+
+         bool operator()( const authorizer_entry& lhs, const authorizer_entry& rhs ) const {
+            if( value_less( lhs.value, rhs.value ) ) return true;
+            if( value_less( rhs.value, lhs.value ) ) return false;
+            if( lhs.weight != rhs.weight ) return lhs.weight < rhs.weight;
+            return std::less<const permission_info*>()( lhs.permission, rhs.permission );
+         }
+         bool operator()( const authorizer_entry& lhs, const T& rhs ) const { return value_less( lhs.value, rhs ); }
+         bool operator()( const T& lhs, const authorizer_entry& rhs ) const { return value_less( lhs, rhs.value ); }
 
-      static weighted upper_bound_for( const T& value ) {
-         return {value, std::numeric_limits<chain::weight_type>::max()};
-      }
+         static bool value_less( const T& lhs, const T& rhs ) { return std::less<T>()( lhs, rhs ); }
+      };
    };
 
    template<typename Output, typename Input>
@@ -101,29 +113,6 @@ namespace {
    }
 }
 
-namespace std {
-   /**
-    * support for using `permission_info::cref` in ordered containers
-    */
-   template<>
-   struct less<permission_info::cref> {
-      bool operator()( const permission_info::cref& lhs, const permission_info::cref& rhs ) const {
-         return std::uintptr_t(&lhs.get()) < std::uintptr_t(&rhs.get());
-      }
-   };
-
-   /**
-    * support for using `weighted<T>` in ordered containers
-    */
-   template<typename T>
-   struct less<weighted<T>> {
-      bool operator()( const weighted<T>& lhs, const weighted<T>& rhs ) const {
-         return std::tie(lhs.value, lhs.weight) < std::tie(rhs.value, rhs.weight);
-      }
-   };
-
-}
-
 namespace eosio::chain_apis {
    /**
     * Implementation details of the account query DB
@@ -154,45 +143,73 @@ namespace eosio::chain_apis {
             time_to_block_num.emplace(block_p->timestamp.to_time_point(), block_num);
          }
 
+         std::vector<name_entry_t> name_entries;
+         std::vector<key_entry_t> key_entries;
          for (const auto& po : index ) {
             uint32_t last_updated_height = last_updated_time_to_height(po.last_updated);
-            const auto& pi = permission_info_index.emplace( permission_info{ po.owner, po.name, last_updated_height, po.auth.threshold } ).first;
-            add_to_bimaps(*pi, po);
+            const auto& pi = *permission_info_index.emplace( permission_info{ po.owner, po.name, last_updated_height, po.auth.to_authority() } ).first;
+            for (const auto& a : pi.auth.accounts) {
+               name_entries.emplace_back(name_entry_t{a.permission, a.weight, &pi});
+            }
+            for (const auto& k : pi.auth.keys) {
+               key_entries.emplace_back(key_entry_t{intern_key(k.key), k.weight, &pi});
+            }
          }
+         // sorted ranges are inserted in linear time
+         std::sort(name_entries.begin(), name_entries.end(), name_entry_t::less());
+         name_index.insert(name_entries.begin(), name_entries.end());
+         std::sort(key_entries.begin(), key_entries.end(), key_entry_t::less());
+         key_index.insert(key_entries.begin(), key_entries.end());
+
+         active_schedule_version = controller.head_block_state()->active_schedule.version;
+         max_authority_depth = controller.get_global_properties().configuration.max_authority_depth;
          auto duration = fc::time_point::now() - start;
          ilog("Finished building account query DB in ${sec}", ("sec", (duration.count() / 1'000'000.0 )));
       }
 
       /**
-       * Add a permission to the bimaps for keys and accounts
-       * @param pi - the ephemeral permission info structure being added
-       * @param po - the chain data associted with this permission
+       * @return the single stored copy of key, shared by all the permissions using it
        */
-      void add_to_bimaps( const permission_info& pi, const chain::permission_object& po ) {
-         // For each account, add this permission info's non-owning reference to the bimap for accounts
-         for (const auto& a : po.auth.accounts) {
-            name_bimap.insert(name_bimap_t::value_type {{a.permission, a.weight}, pi});
+      const chain::public_key_type* intern_key( const chain::public_key_type& key ) {
+         auto itr = interned_keys.emplace(key, 0).first;
+         ++itr->second;
+         return &itr->first;
+      }
+
+      void release_key( const chain::public_key_type& key ) {
+         auto itr = interned_keys.find(key);
+         if (itr != interned_keys.end() && --itr->second == 0) {
+            interned_keys.erase(itr);
          }
+      }
 
-         // for each key, add this permission info's non-owning reference to the bimap for keys
-         for (const auto& k: po.auth.keys) {
-            chain::public_key_type key = k.key;
-            key_bimap.insert(key_bimap_t::value_type {{std::move(key), k.weight}, pi});
+      /**
+       * Add the accounts and keys of a permission to the authorizer indices
+       * @param pi - the ephemeral permission info structure being added, its auth is indexed
+       */
+      void add_to_authorizer_indices( const permission_info& pi ) {
+         for (const auto& a : pi.auth.accounts) {
+            name_index.emplace(name_entry_t{a.permission, a.weight, &pi});
+         }
+         for (const auto& k: pi.auth.keys) {
+            key_index.emplace(key_entry_t{intern_key(k.key), k.weight, &pi});
          }
       }
 
       /**
-       * Remove a permission from the bimaps for keys and accounts
+       * Remove a permission from the authorizer indices, pi.auth must still be the authority it was added with
        * @param pi - the ephemeral permission info structure being removed
        */
-      void remove_from_bimaps( const permission_info& pi ) {
-         // remove all entries from the name bimap that refer to this permission_info's reference
-         const auto name_range = name_bimap.right.equal_range(pi);
-         name_bimap.right.erase(name_range.first, name_range.second);
-
-         // remove all entries from the key bimap that refer to this permission_info's reference
-         const auto key_range = key_bimap.right.equal_range(pi);
-         key_bimap.right.erase(key_range.first, key_range.second);
+      void remove_from_authorizer_indices( const permission_info& pi ) {
+         for (const auto& a : pi.auth.accounts) {
+            name_index.erase(name_entry_t{a.permission, a.weight, &pi});
+         }
+         for (const auto& k: pi.auth.keys) {
+            auto itr = interned_keys.find(k.key);
+            if (itr == interned_keys.end()) continue;
+            key_index.erase(key_entry_t{&itr->first, k.weight, &pi});
+            release_key(k.key);
+         }
       }
 
       bool is_rollback_required( const chain::block_state_ptr& bsp ) const {
@@ -256,8 +273,8 @@ namespace eosio::chain_apis {
                break;
             }
 
-            // remove this entry from the bimaps
-            remove_from_bimaps(pi);
+            // remove this entry from the authorizer indices
+            remove_from_authorizer_indices(pi);
 
             auto itr = permission_by_owner.find(std::make_tuple(pi.owner, pi.name));
             if (itr == permission_by_owner.end()) {
@@ -270,9 +287,9 @@ namespace eosio::chain_apis {
 
                index.modify(index.iterator_to(pi), [&po, last_updated_height](auto& mutable_pi) {
                   mutable_pi.last_updated_height = last_updated_height;
-                  mutable_pi.threshold = po.auth.threshold;
+                  mutable_pi.auth = po.auth.to_authority();
                });
-               add_to_bimaps(pi, po);
+               add_to_authorizer_indices(pi);
                ++curr_iter;
             }
          }
@@ -338,6 +355,14 @@ namespace eosio::chain_apis {
          if( onblock_trace )
             process_trace(*onblock_trace);
 
+         // the controller updates the producers authorities without an action whenever a new schedule becomes active
+         if( bsp->active_schedule.version != active_schedule_version ) {
+            for( auto perm : { chain::config::active_name, chain::config::majority_producers_permission_name,
+                               chain::config::minority_producers_permission_name } ) {
+               updated.emplace(chain::permission_level{chain::config::producers_account_name, perm});
+            }
+         }
+
          for( const auto& r : bsp->block->transactions ) {
             chain::transaction_id_type id;
             if( std::holds_alternative<chain::transaction_id_type>( r.trx ) ) {
@@ -367,6 +392,9 @@ namespace eosio::chain_apis {
 
          std::tie(updated, deleted, rollback_required) = commit_block_prelock(bsp);
 
+         active_schedule_version = bsp->active_schedule.version;
+         max_authority_depth = controller.get_global_properties().configuration.max_authority_depth;
+
          // optimistic skip of locking section if there is nothing to do
          if (!updated.empty() || !deleted.empty() || rollback_required) {
             std::unique_lock write_lock(rw_mutex);
@@ -388,16 +416,16 @@ namespace eosio::chain_apis {
                auto itr = index.find(key);
                if (itr == index.end()) {
                   const auto& po = *source_itr;
-                  itr = index.emplace(permission_info{ po.owner, po.name, bnum, po.auth.threshold }).first;
+                  itr = index.emplace(permission_info{ po.owner, po.name, bnum, po.auth.to_authority() }).first;
                } else {
-                  remove_from_bimaps(*itr);
+                  remove_from_authorizer_indices(*itr);
                   index.modify(itr, [&](auto& mutable_pi){
                      mutable_pi.last_updated_height = bnum;
-                     mutable_pi.threshold = source_itr->auth.threshold;
+                     mutable_pi.auth = source_itr->auth.to_authority();
                   });
                }
 
-               add_to_bimaps(*itr, *source_itr);
+               add_to_authorizer_indices(*itr);
             }
 
             // for all deleted permissions, process their removal from the account query DB
@@ -405,7 +433,7 @@ namespace eosio::chain_apis {
                auto key = std::make_tuple(dp.actor, dp.permission);
                auto itr = index.find(key);
                if (itr != index.end()) {
-                  remove_from_bimaps(*itr);
+                  remove_from_authorizer_indices(*itr);
                   index.erase(itr);
                }
             }
@@ -430,22 +458,21 @@ namespace eosio::chain_apis {
          /**
           * Add a range of results
           */
-         auto push_results = [&result](const auto& begin, const auto& end) {
+         auto push_results = [&result](const auto& begin, const auto& end, const auto& authorizer) {
             for (auto itr = begin; itr != end; ++itr) {
-               const auto& pi = itr->second.get();
-               const auto& authorizer = itr->first.value;
-               auto weight = itr->first.weight;
+               const auto& pi = *itr->permission;
 
                result.accounts.emplace_back(result_t::account_result{
                      pi.owner,
                      pi.name,
-                     make_optional_authorizer<chain::permission_level>(authorizer),
-                     make_optional_authorizer<chain::public_key_type>(authorizer),
-                     weight,
-                     pi.threshold
+                     make_optional_authorizer<chain::permission_level>(authorizer(*itr)),
+                     make_optional_authorizer<chain::public_key_type>(authorizer(*itr)),
+                     itr->weight,
+                     pi.auth.threshold
                });
             }
          };
+         auto name_authorizer = [](const name_entry_t& e) -> const chain::permission_level& { return e.value; };
 
 
          for (const auto& a: account_set) {
@@ -453,29 +480,58 @@ namespace eosio::chain_apis {
                // empty permission is a wildcard
                // construct a range between the lower bound of the given account and the lower bound of the
                // next possible account name
-               const auto begin = name_bimap.left.lower_bound(weighted<chain::permission_level>::lower_bound_for({a.actor, a.permission}));
+               const auto begin = name_index.lower_bound(chain::permission_level{a.actor, a.permission});
                const auto next_account_name = chain::name(a.actor.to_uint64_t() + 1);
-               const auto end = name_bimap.left.lower_bound(weighted<chain::permission_level>::lower_bound_for({next_account_name, a.permission}));
-               push_results(begin, end);
+               const auto end = name_index.lower_bound(chain::permission_level{next_account_name, a.permission});
+               push_results(begin, end, name_authorizer);
             } else {
-               // construct a range of all possible weights for an account/permission pair
-               const auto p = chain::permission_level{a.actor, a.permission};
-               const auto begin = name_bimap.left.lower_bound(weighted<chain::permission_level>::lower_bound_for(p));
-               const auto end = name_bimap.left.upper_bound(weighted<chain::permission_level>::upper_bound_for(p));
-               push_results(begin, end);
+               // all possible weights for an account/permission pair
+               const auto range = name_index.equal_range(chain::permission_level{a.actor, a.permission});
+               push_results(range.first, range.second, name_authorizer);
             }
          }
 
          for (const auto& k: key_set) {
-            // construct a range of all possible weights for a key
-            const auto begin = key_bimap.left.lower_bound(weighted<chain::public_key_type>::lower_bound_for(k));
-            const auto end = key_bimap.left.upper_bound(weighted<chain::public_key_type>::upper_bound_for(k));
-            push_results(begin, end);
+            const auto interned = interned_keys.find(k);
+            if (interned == interned_keys.end()) continue;
+            // all possible weights for a key
+            const auto range = key_index.equal_range(&interned->first);
+            push_results(range.first, range.second, [](const key_entry_t& e) -> const chain::public_key_type& { return *e.value; });
          }
 
          return result;
       }
 
+      chain::flat_set<chain::public_key_type>
+      get_required_keys( const chain::transaction& trx, const chain::flat_set<chain::public_key_type>& candidate_keys,
+                         fc::microseconds provided_delay ) const {
+         std::shared_lock read_lock(rw_mutex);
+
+         const auto& index = permission_info_index.get<by_owner_name>();
+         auto checker = chain::make_auth_checker( [&index](const chain::permission_level& p) -> const chain::authority& {
+                                                     auto itr = index.find(std::make_tuple(p.actor, p.permission));
+                                                     EOS_ASSERT( itr != index.end(), chain::permission_query_exception,
+                                                                 "Failed to retrieve permission: ${level}", ("level", p) );
+                                                     return itr->auth;
+                                                  },
+                                                  max_authority_depth.load(),
+                                                  candidate_keys,
+                                                  {},
+                                                  provided_delay,
+                                                  chain::authorization_manager::_noop_checktime
+                                                );
+
+         for (const auto& act : trx.actions ) {
+            for (const auto& declared_auth : act.authorization) {
+               EOS_ASSERT( checker.satisfied(declared_auth), chain::unsatisfied_authorization,
+                           "transaction declares authority '${auth}', but does not have signatures for it.",
+                           ("auth", declared_auth) );
+            }
+         }
+
+         return checker.used_keys();
+      }
+
       /**
        * Convenience aliases
        */
@@ -488,21 +544,27 @@ namespace eosio::chain_apis {
 
       using time_map_t = std::map<fc::time_point, uint32_t>;
       time_map_t                 time_to_block_num;
+      uint32_t                   active_schedule_version = 0; ///< version of the producer schedule of the last committed block
 
 
 
-      using name_bimap_t = bimap<multiset_of<weighted<chain::permission_level>>, multiset_of<permission_info::cref>>;
-      using key_bimap_t = bimap<multiset_of<weighted<chain::public_key_type>>, multiset_of<permission_info::cref>>;
+      using name_entry_t = authorizer_entry<chain::permission_level>;
+      using key_entry_t = authorizer_entry<const chain::public_key_type*>;
+      using name_index_t = std::set<name_entry_t, name_entry_t::less>;
+      using key_index_t = std::set<key_entry_t, key_entry_t::less>;
+      using interned_keys_t = std::map<chain::public_key_type, uint32_t>;
 
       /*
        * The structures below are shared between the writing thread and the reading thread(s) and must be protected
        * by the `rw_mutex`
        */
       permission_info_index_t    permission_info_index;    ///< multi-index that holds ephemeral indices
-      name_bimap_t               name_bimap;               ///< many:many bimap of names:permission_infos
-      key_bimap_t                key_bimap;                ///< many:many bimap of keys:permission_infos
+      name_index_t               name_index;               ///< permissions by authorizing account permission
+      key_index_t                key_index;                ///< permissions by authorizing key, entries refer to interned_keys
+      interned_keys_t            interned_keys;            ///< each key used by a permission once, with its number of key_index entries
+      std::atomic<uint16_t>      max_authority_depth = 0;  ///< chain configuration as of the last committed block
 
-      mutable std::shared_mutex  rw_mutex;                 ///< mutex for read/write locking on the Multi-index and bimaps
+      mutable std::shared_mutex  rw_mutex;                 ///< mutex for read/write locking on the Multi-index and authorizer indices
    };
 
    account_query_db::account_query_db( const chain::controller& controller )
@@ -530,4 +592,10 @@ namespace eosio::chain_apis {
       return _impl->get_accounts_by_authorizers(args);
    }
 
+   chain::flat_set<chain::public_key_type> account_query_db::get_required_keys( const chain::transaction& trx,
+                                                                                const chain::flat_set<chain::public_key_type>& candidate_keys,
+                                                                                fc::microseconds provided_delay ) const {
+      return _impl->get_required_keys(trx, candidate_keys, provided_delay);
+   }
+
 }
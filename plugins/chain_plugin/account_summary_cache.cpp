@@ -0,0 +1,54 @@
+#include <eosio/chain_plugin/account_summary_cache.hpp>
+
+namespace eosio::chain_apis {
+   using namespace eosio::chain;
+
+   account_summary_cache::account_summary_cache( size_t max_entries )
+   : max_entries( max_entries )
+   {}
+
+   account_summary_cache::key_type account_summary_cache::make_key( const read_only::get_account_params& params ) {
+      return { params.account_name, params.expected_core_symbol ? params.expected_core_symbol->value() : 0 };
+   }
+
+   account_summary_cache::state_version account_summary_cache::version( const controller& db )const {
+      std::lock_guard<std::mutex> g( mtx );
+      return { db.head_block_id(), db.db().revision(), generation };
+   }
+
+   std::optional<read_only::get_account_results>
+   account_summary_cache::get( const read_only::get_account_params& params, const state_version& v ) {
+      std::lock_guard<std::mutex> g( mtx );
+      if( v != entries_version ) return {};
+      auto itr = entries.find( make_key( params ) );
+      if( itr == entries.end() ) return {};
+      itr->second.last_used = ++use_count;
+      return itr->second.result;
+   }
+
+   void account_summary_cache::put( const read_only::get_account_params& params, const state_version& v,
+                                    const read_only::get_account_results& result ) {
+      std::lock_guard<std::mutex> g( mtx );
+      if( v.generation != generation ) return; // read before the state changed
+      if( v != entries_version ) {
+         entries.clear();
+         entries_version = v;
+      }
+      auto& e = entries[make_key( params )];
+      e.result = result;
+      e.last_used = ++use_count;
+      if( entries.size() > max_entries ) {
+         auto lru = entries.begin();
+         for( auto itr = entries.begin(); itr != entries.end(); ++itr ) {
+            if( itr->second.last_used < lru->second.last_used ) lru = itr;
+         }
+         entries.erase( lru );
+      }
+   }
+
+   void account_summary_cache::invalidate() {
+      std::lock_guard<std::mutex> g( mtx );
+      ++generation;
+      entries.clear();
+   }
+}
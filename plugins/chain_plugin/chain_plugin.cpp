@@ -1,5 +1,8 @@
 #include <eosio/chain_plugin/chain_plugin.hpp>
+#include <eosio/chain_plugin/account_summary_cache.hpp>
 #include <eosio/chain_plugin/blockvault_sync_strategy.hpp>
+#include <eosio/chain_plugin/deep_mind_framed_writer.hpp>
+#include <eosio/http_plugin/main_thread_queue.hpp>
 #include <eosio/chain/fork_database.hpp>
 #include <eosio/chain/block_log.hpp>
 #include <eosio/chain/exceptions.hpp>
@@ -34,6 +37,15 @@
 #include <signal.h>
 #include <cstdlib>
 
+#ifdef __linux__
+#include <cstring>
+#include <fstream>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#endif
+
 // reflect chainbase::environment for --print-build-info option
 FC_REFLECT_ENUM( chainbase::environment::os_t,
                  (OS_LINUX)(OS_MACOS)(OS_WINDOWS)(OS_OTHER) )
@@ -195,7 +207,17 @@ public:
    //txn_msg_rate_limits              rate_limits;
    std::optional<vm_type>            wasm_runtime;
    fc::microseconds                  abi_serializer_max_time_us;
+   fc::microseconds                  eosvmoc_prewarm_max_time;
    std::optional<bfs::path>          snapshot_path;
+   std::optional<bfs::path>          snapshot_base_path;
+
+   // base of a delta --snapshot, not opened when none was given
+   std::ifstream open_snapshot_base() const {
+      std::ifstream basefile;
+      if( snapshot_base_path )
+         basefile.open( snapshot_base_path->generic_string(), (std::ios::in | std::ios::binary) );
+      return basefile;
+   }
 
 
    // retained references to channels for easy publication
@@ -225,8 +247,16 @@ public:
    std::optional<scoped_connection>                                   irreversible_block_connection;
    std::optional<scoped_connection>                                   accepted_transaction_connection;
    std::optional<scoped_connection>                                   applied_transaction_connection;
+   std::optional<scoped_connection>                                   block_start_connection;
 
    std::optional<chain_apis::account_query_db>                        _account_query_db;
+   std::optional<chain_apis::abi_serializer_cache>                    _abi_serializer_cache;
+   uint16_t                                                           read_only_api_threads = 0;
+   std::optional<chain_apis::read_only_api_executor>                  _read_only_api_executor;
+   std::shared_ptr<deep_mind_framed_writer>                           _deep_mind_writer;   ///< deep-mind-format = framed
+   fc::logger                                                         _deep_mind_framed_log;
+   std::optional<chain_apis::rendered_block_cache>                    _rendered_block_cache;
+   std::optional<chain_apis::account_summary_cache>                   _account_summary_cache;
 
    void do_non_snapshot_startup(std::function<void()> shutdown, std::function<bool()> check_shutdown) {
        if (genesis) {
@@ -293,6 +323,22 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "the location of the blocks archive directory (absolute path or relative to blocks dir).\n"
           "If the value is empty, blocks files beyond the retained limit will be deleted.\n"
           "All files in the archive directory are completely under user's control, i.e. they won't be accessed by nodeos anymore.")
+         ("blocks-trx-index", bpo::value<bool>()->default_value(false),
+          "maintain blocks.trx_index next to the block log to look up the irreversible block containing a transaction id.\n"
+          "The index is built from the existing block files when it is first enabled.")
+         ("blocks-log-compression", bpo::value<std::string>()->default_value("none"),
+          "compression of the blocks appended to the block log. Supported options are \"none\" and \"zstd\".\n"
+          "zstd creates block log files of version 5, which older nodeos and eosio-blocklog cannot read, \"none\" creates version 4 files.\n"
+          "A blocks.log of an older version stays uncompressed until it is split.")
+         ("blocks-log-zstd-dictionary", bpo::value<bfs::path>()->default_value(""),
+          "zstd dictionary of new block log files (absolute path or relative to blocks dir), "
+          "e.g. trained with 'eosio-blocklog --train-blocks-dictionary'. Files keep the dictionary they were created with.")
+         ("blocks-log-zstd-level", bpo::value<int>()->default_value(3),
+          "zstd compression level of the block log")
+         ("import-block-chunks-dir", bpo::value<bfs::path>(),
+          "import the block log chunks listed in the manifest of this directory (as written by 'eosio-blocklog --export-chunks')\n"
+          "into the blocks retained directory before starting. Chunks are copied and verified on 'chain-threads' threads,\n"
+          "chunks already present in the retained directory are skipped.")
          ("fix-irreversible-blocks", bpo::value<bool>()->default_value("false"),
           "When the existing block log is inconsistent with the index, allows fixing the block log and index files automatically - that is, " 
           "it will take the highest indexed block if it is valid; otherwise it will repair the block log and reconstruct the index.")
@@ -325,6 +371,12 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "Rocksdb write rate of flushes and compactions.")
          ("persistent-storage-mbytes-snapshot-batch", bpo::value<uint32_t>()->default_value(config::default_persistent_storage_mbytes_batch),
           "Rocksdb batch size threshold before writing read in snapshot data to database.")
+         ("persistent-storage-snapshot-ingest", bpo::value<bool>()->default_value(false),
+          "Load snapshot data into rocksdb by building sorted SST files of persistent-storage-mbytes-snapshot-batch and ingesting them, instead of writing it through the memtable")
+         ("persistent-storage-block-cache-size-mb", bpo::value<uint64_t>()->default_value(config::default_persistent_storage_block_cache_size / (1024  * 1024)),
+          "Size of the rocksdb block cache (in MiB), which also holds index and filter blocks")
+         ("persistent-storage-row-cache-size-mb", bpo::value<uint64_t>()->default_value(config::default_persistent_storage_row_cache_size / (1024  * 1024)),
+          "Size of the rocksdb cache of recently read rows (in MiB) used to keep a hot working set in RAM. 0 = disabled.")
 
          ("reversible-blocks-db-size-mb", bpo::value<uint64_t>()->default_value(config::default_reversible_cache_size / (1024  * 1024)), "Maximum size (in MiB) of the reversible blocks database")
          ("reversible-blocks-db-guard-size-mb", bpo::value<uint64_t>()->default_value(config::default_reversible_guard_size / (1024  * 1024)), "Safely shut down node when free space remaining in the reverseible blocks database drops below this size (in MiB).")
@@ -332,10 +384,34 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "Percentage of actual signature recovery cpu to bill. Whole number percentages, e.g. 50 for 50%")
          ("chain-threads", bpo::value<uint16_t>()->default_value(config::default_controller_thread_pool_size),
           "Number of worker threads in controller thread pool")
+         ("chain-threads-cpus", bpo::value<vector<uint16_t>>()->composing()->multitoken(),
+          "CPUs the controller thread pool threads are pinned to, thread N to the N-th CPU listed modulo their number (Linux only). Threads are not pinned by default")
+         ("block-key-prefetch-blocks", bpo::value<uint32_t>()->default_value(config::default_block_key_prefetch_limit),
+          "Maximum number of received blocks for which transaction signature recovery is started before the block is applied, "
+          "only blocks at most this many block numbers above head are considered, 0 to disable")
+         ("recovered-key-cache-size", bpo::value<uint32_t>()->default_value(config::default_recovered_key_cache_size),
+          "Number of recovered public keys of input transactions kept for reuse when the transactions are validated in a block, 0 to disable")
+         ("state-access-log", bpo::value<bfs::path>(),
+          "File to append the contract state conflict graph of every committed block to, as one json object per line (relative paths are relative to the data directory). "
+          "Records the table rows and key-value keys read and written by each transaction, which slows down block application.")
          ("contracts-console", bpo::bool_switch()->default_value(false),
           "print contract's output to console")
+         ("action-profile-sample-rate", bpo::value<uint32_t>()->default_value(0),
+          "Attach a profile of wasm time and host calls by intrinsic to the action traces of one in this many transactions (0 disables). "
+          "Meant for non-producing nodes, profiled transactions execute slower.")
+         ("contract-cpu-sample-ms", bpo::value<uint32_t>()->default_value(10),
+          "Sample the receiver and action executing on the main thread every this many milliseconds, to attribute cpu time to contracts (0 disables). "
+          "The samples are returned by /v1/producer/get_contract_cpu_samples.")
          ("deep-mind", bpo::bool_switch()->default_value(false),
           "print deeper information about chain operations")
+         ("deep-mind-format", bpo::value<string>()->default_value("text"),
+          "Format of the deep mind output:\n"
+          "  \"text\" - DMLOG lines through the deep-mind logger\n"
+          "  \"framed\" - events prefixed by their 4 byte little endian length, written to deep-mind-output by a dedicated thread")
+         ("deep-mind-output", bpo::value<string>()->default_value("-"),
+          "File or FIFO the \"framed\" deep mind events are appended to, \"-\" for stdout")
+         ("deep-mind-buffer-events", bpo::value<uint32_t>()->default_value(65536),
+          "Number of \"framed\" deep mind events buffered for the writer thread; the main thread waits while the buffer is full")
          ("telemetry-url", bpo::value<std::string>(),
           "Send Zipkin spans to url. e.g. http://127.0.0.1:9411/api/v2/spans" )
          ("telemetry-service-name", bpo::value<std::string>()->default_value("nodeos"),
@@ -368,6 +444,9 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "Chain validation mode (\"full\" or \"light\").\n"
           "In \"full\" mode all incoming blocks will be fully validated.\n"
           "In \"light\" mode all incoming blocks headers will be fully validated; transactions in those validated blocks will be trusted \n")
+         ("fork-switch-trust-validated-blocks", bpo::bool_switch()->default_value(false),
+          "When switching back to a branch this node already applied, do not recompute the action merkle roots of its blocks. "
+          "A re-applied block that diverges from its first apply is then not detected (ignored with force-all-checks)")
          ("disable-ram-billing-notify-checks", bpo::bool_switch()->default_value(false),
           "Disable the check which subjectively fails a transaction if a contract bills more RAM to another account within the context of a notification handler (i.e. when the receiver is not the code of the action).")
 #ifdef EOSIO_DEVELOPER
@@ -385,6 +464,11 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "In \"locked\" mode database is preloaded, locked in to memory, and will use huge pages if available.\n"
 #endif
          )
+#ifdef __linux__
+         ("database-numa-node", bpo::value<uint32_t>(),
+          "Bind the main thread to the CPUs of this NUMA node and prefer allocating memory from it before the database is opened, "
+          "so a \"heap\" or \"locked\" mode database is preloaded in to that node's memory. Threads started later inherit the binding.")
+#endif
 
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
          ("eos-vm-oc-cache-size-mb", bpo::value<uint64_t>()->default_value(eosvmoc::config().cache_size / (1024u*1024u)), "Maximum size (in MiB) of the EOS VM OC code cache")
@@ -395,8 +479,35 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
                }
          }), "Number of threads to use for EOS VM OC tier-up")
          ("eos-vm-oc-enable", bpo::bool_switch(), "Enable EOS VM OC tier-up runtime")
+         ("eos-vm-oc-cache-dir", bpo::value<bfs::path>(),
+          "Directory of the EOS VM OC code cache, kept across state and block log deletions. If a relative path is "
+          "specified, it is relative to the data directory. Defaults to the state directory")
+         ("eos-vm-oc-tierup-threshold", bpo::value<uint64_t>()->default_value(eosvmoc::config().tierup_threshold),
+          "Number of executions of a contract before EOS VM OC tier-up compiles it. Queued compiles are started in order of "
+          "time spent in the baseline runtime, and the cache evicts the least executed of its least recently used entries")
+         ("eos-vm-oc-prewarm-contracts", bpo::value<uint64_t>()->default_value(0u),
+          "Number of most recently used contracts recorded at shutdown and compiled by EOS VM OC tier-up at the next startup, "
+          "before blocks and transactions are accepted from the network and API. 0 disables")
+         ("eos-vm-oc-prewarm-max-ms", bpo::value<uint32_t>()->default_value(30000u),
+          "Maximum time to wait at startup for the compiles of eos-vm-oc-prewarm-contracts")
+         ("eos-vm-oc-compile-nice", bpo::value<int>()->default_value(eosvmoc::config().compile_nice)->notifier([](const auto n) {
+               if(n < 0 || n > 19) {
+                  elog("eos-vm-oc-compile-nice must be between 0 and 19");
+                  EOS_ASSERT(false, plugin_exception, "");
+               }
+         }), "Niceness of EOS VM OC tier-up compile processes. Raise it so that compiling a large batch of newly deployed "
+             "contracts leaves the CPU to block production and validation")
 #endif
-         ("enable-account-queries", bpo::value<bool>()->default_value(false), "enable queries to find accounts by various metadata.")
+         ("enable-account-queries", bpo::value<bool>()->default_value(false), "enable queries to find accounts by various metadata, get_required_keys is then answered from the same in-memory permission indices.")
+         ("api-abi-cache-size", bpo::value<uint32_t>()->default_value(256),
+          "number of contract abis kept with their constructed abi_serializer for the read only APIs, 0 disables the cache")
+         ("api-block-cache-size", bpo::value<uint32_t>()->default_value(32),
+          "number of get_block responses kept rendered as JSON, served with an ETag, 0 disables the cache")
+         ("api-account-cache-size", bpo::value<uint32_t>()->default_value(1024),
+          "number of get_account results kept until the chain state changes, 0 disables the cache")
+         ("read-only-api-threads", bpo::value<uint16_t>()->default_value(0),
+          "number of threads running the state reading chain APIs (get_table_rows, get_account, ...) in parallel while the main thread "
+          "waits between two of its tasks, 0 runs them on the main thread. Requires backing-store = chainbase")
          ("max-nonprivileged-inline-action-size", bpo::value<uint32_t>()->default_value(config::default_max_nonprivileged_inline_action_size), "maximum allowed size (in bytes) of an inline action for a nonprivileged account")
          ;
 
@@ -427,6 +538,11 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "do not skip any validation checks while replaying blocks (useful for replaying blocks from untrusted source)")
          ("disable-replay-opts", bpo::bool_switch()->default_value(false),
           "disable optimizations that specifically target replay")
+         ("replay-trust-block-log", bpo::bool_switch()->default_value(false),
+          "trust the irreversible blocks of the local block log on replay: do not recompute their action merkle roots, "
+          "only verify the replayed head matches the fork database when they overlap (ignored with force-all-checks)")
+         ("replay-prefetch-blocks", bpo::value<uint32_t>()->default_value(config::default_replay_prefetch_blocks),
+          "number of blocks read from the block log and unpacked ahead of replay on a thread of their own, 0 reads them between applying blocks")
          ("replay-blockchain", bpo::bool_switch()->default_value(false),
           "clear chain state database and replay all blocks")
          ("hard-replay-blockchain", bpo::bool_switch()->default_value(false),
@@ -442,6 +558,7 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
          ("export-reversible-blocks", bpo::value<bfs::path>(),
            "export reversible block database in portable format into specified file and then exit")
          ("snapshot", bpo::value<bfs::path>(), "File to read Snapshot State from")
+         ("snapshot-base", bpo::value<bfs::path>(), "Full snapshot that the delta snapshot given by --snapshot was written against")
          ;
 
 }
@@ -474,6 +591,43 @@ fc::time_point calculate_genesis_timestamp( string tstr ) {
    return genesis_timestamp;
 }
 
+#ifdef __linux__
+void bind_to_numa_node( uint32_t node ) {
+   std::ifstream cpulist_file( "/sys/devices/system/node/node" + std::to_string( node ) + "/cpulist" );
+   std::string cpulist;
+   EOS_ASSERT( cpulist_file && std::getline( cpulist_file, cpulist ), plugin_config_exception,
+               "database-numa-node ${node} does not exist", ("node", node) );
+
+   // cpulist is formatted like "0-15,32-47"
+   cpu_set_t cpus;
+   CPU_ZERO( &cpus );
+   vector<string> ranges;
+   boost::split( ranges, cpulist, boost::is_any_of( "," ) );
+   for( const auto& range : ranges ) {
+      if( range.empty() )
+         continue;
+      const auto dash  = range.find( '-' );
+      const auto first = std::stoul( range.substr( 0, dash ) );
+      const auto last  = dash == string::npos ? first : std::stoul( range.substr( dash + 1 ) );
+      for( auto cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu )
+         CPU_SET( cpu, &cpus );
+   }
+   if( sched_setaffinity( 0, sizeof(cpus), &cpus ) == 0 )
+      ilog( "main thread bound to CPUs ${cpus} of NUMA node ${node}", ("cpus", cpulist)("node", node) );
+   else
+      wlog( "unable to bind main thread to the CPUs of NUMA node ${node}: ${err}", ("node", node)("err", strerror( errno )) );
+
+   // MPOL_PREFERRED falls back to other nodes instead of failing allocations when the node is full
+   constexpr auto bits_per_word = 8 * sizeof(unsigned long);
+   vector<unsigned long> nodemask( node / bits_per_word + 1 );
+   nodemask[node / bits_per_word] |= 1ul << (node % bits_per_word);
+   if( syscall( SYS_set_mempolicy, MPOL_PREFERRED, nodemask.data(), nodemask.size() * bits_per_word + 1 ) == 0 )
+      ilog( "memory allocations prefer NUMA node ${node}", ("node", node) );
+   else
+      wlog( "unable to set memory policy for NUMA node ${node}: ${err}", ("node", node)("err", strerror( errno )) );
+}
+#endif
+
 void clear_directory_contents( const fc::path& p ) {
    using boost::filesystem::directory_iterator;
 
@@ -485,6 +639,17 @@ void clear_directory_contents( const fc::path& p ) {
    }
 }
 
+// compressed and delta snapshots written by producer_plugin are detected by their magic number
+snapshot_reader_ptr make_snapshot_reader( std::istream& infile, std::ifstream& basefile ) {
+   if( compressed_istream_snapshot_reader::is_compressed_snapshot( infile ) )
+      return std::make_shared<compressed_istream_snapshot_reader>( infile );
+   if( delta_istream_snapshot_reader::is_delta_snapshot( infile ) ) {
+      EOS_ASSERT( basefile.is_open(), plugin_config_exception, "--snapshot is a delta snapshot and requires --snapshot-base" );
+      return std::make_shared<delta_istream_snapshot_reader>( infile, basefile );
+   }
+   return std::make_shared<istream_snapshot_reader>( infile );
+}
+
 std::optional<builtin_protocol_feature> read_builtin_protocol_feature( const fc::path& p  ) {
    try {
       return fc::json::from_file<builtin_protocol_feature>( p );
@@ -823,6 +988,19 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
       my->chain_config->blog.stride                  = options.at("blocks-log-stride").as<uint32_t>();
       my->chain_config->blog.max_retained_files      = options.at("max-retained-block-files").as<uint16_t>();
       my->chain_config->blog.fix_irreversible_blocks = options.at("fix-irreversible-blocks").as<bool>();
+      my->chain_config->blog.trx_index               = options.at("blocks-trx-index").as<bool>();
+      my->chain_config->blog.zstd_dictionary         = options.at("blocks-log-zstd-dictionary").as<bfs::path>();
+      my->chain_config->blog.zstd_level              = options.at("blocks-log-zstd-level").as<int>();
+
+      const auto blocks_log_compression = options.at("blocks-log-compression").as<std::string>();
+      if (blocks_log_compression == "zstd") {
+         EOS_ASSERT( block_log::zstd_supported(), plugin_config_exception,
+                     "blocks-log-compression zstd is not supported, nodeos is built without zstd" );
+         my->chain_config->blog.zstd_compression = true;
+      } else {
+         EOS_ASSERT( blocks_log_compression == "none", plugin_config_exception,
+                     "unknown blocks-log-compression ${c}", ("c", blocks_log_compression) );
+      }
 
       if (auto resmon_plugin = app().find_plugin<resource_monitor_plugin>()) {
         resmon_plugin->monitor_directory(my->chain_config->blog.log_dir);
@@ -864,6 +1042,16 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
       my->chain_config->persistent_storage_mbytes_batch = options.at( "persistent-storage-mbytes-snapshot-batch" ).as<uint32_t>();
       EOS_ASSERT( my->chain_config->persistent_storage_mbytes_batch > 0, plugin_config_exception,
                   "persistent-storage-mbytes-snapshot-batch ${num} must be greater than 0", ("num", my->chain_config->persistent_storage_mbytes_batch) );
+      my->chain_config->persistent_storage_snapshot_ingest = options.at( "persistent-storage-snapshot-ingest" ).as<bool>();
+
+      if( options.count( "persistent-storage-block-cache-size-mb" )) {
+         my->chain_config->persistent_storage_block_cache_size = options.at( "persistent-storage-block-cache-size-mb" ).as<uint64_t>() * 1024 * 1024;
+         EOS_ASSERT( my->chain_config->persistent_storage_block_cache_size > 0, plugin_config_exception,
+                     "persistent-storage-block-cache-size-mb ${num} must be greater than 0", ("num", my->chain_config->persistent_storage_block_cache_size) );
+      }
+
+      if( options.count( "persistent-storage-row-cache-size-mb" ))
+         my->chain_config->persistent_storage_row_cache_size = options.at( "persistent-storage-row-cache-size-mb" ).as<uint64_t>() * 1024 * 1024;
 
       if( options.count( "reversible-blocks-db-size-mb" ))
          my->chain_config->reversible_cache_size =
@@ -880,6 +1068,40 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
          EOS_ASSERT( my->chain_config->thread_pool_size > 0, plugin_config_exception,
                      "chain-threads ${num} must be greater than 0", ("num", my->chain_config->thread_pool_size) );
       }
+      if( options.count( "chain-threads-cpus" )) {
+         my->chain_config->thread_pool_cpus = options.at( "chain-threads-cpus" ).as<vector<uint16_t>>();
+#ifdef __linux__
+         for( auto cpu : my->chain_config->thread_pool_cpus ) {
+            EOS_ASSERT( cpu < CPU_SETSIZE, plugin_config_exception,
+                        "chain-threads-cpus ${cpu} must be less than ${max}", ("cpu", cpu)("max", CPU_SETSIZE) );
+         }
+#else
+         wlog( "chain-threads-cpus is only supported on Linux, chain threads are not pinned" );
+#endif
+      }
+
+      if( options.count( "import-block-chunks-dir" )) {
+         auto import_dir = options.at( "import-block-chunks-dir" ).as<bfs::path>();
+         if( import_dir.is_relative())
+            import_dir = bfs::current_path() / import_dir;
+         auto retained_dir = my->chain_config->blog.retained_dir;
+         if( retained_dir.empty())
+            retained_dir = my->blocks_dir;
+         else if( retained_dir.is_relative())
+            retained_dir = my->blocks_dir / retained_dir;
+         block_log::import_chunks( import_dir, retained_dir, my->chain_config->thread_pool_size );
+      }
+
+      if( options.count( "block-key-prefetch-blocks" ))
+         my->chain_config->block_key_prefetch_limit = options.at( "block-key-prefetch-blocks" ).as<uint32_t>();
+
+      if( options.count( "recovered-key-cache-size" ))
+         my->chain_config->recovered_key_cache_size = options.at( "recovered-key-cache-size" ).as<uint32_t>();
+
+      if( options.count( "state-access-log" )) {
+         auto sal = options.at( "state-access-log" ).as<bfs::path>();
+         my->chain_config->state_access_log = sal.is_relative() ? app().data_dir() / sal : sal;
+      }
 
       my->chain_config->sig_cpu_bill_pct = options.at("signature-cpu-billable-pct").as<uint32_t>();
       EOS_ASSERT( my->chain_config->sig_cpu_bill_pct >= 0 && my->chain_config->sig_cpu_bill_pct <= 100, plugin_config_exception,
@@ -891,7 +1113,12 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
 
       my->chain_config->force_all_checks = options.at( "force-all-checks" ).as<bool>();
       my->chain_config->disable_replay_opts = options.at( "disable-replay-opts" ).as<bool>();
+      my->chain_config->replay_trust_block_log = options.at( "replay-trust-block-log" ).as<bool>();
+      my->chain_config->replay_prefetch_blocks = options.at( "replay-prefetch-blocks" ).as<uint32_t>();
       my->chain_config->contracts_console = options.at( "contracts-console" ).as<bool>();
+      my->chain_config->action_profile_sample_rate = options.at( "action-profile-sample-rate" ).as<uint32_t>();
+      my->chain_config->contract_cpu_sample_interval_us = options.at( "contract-cpu-sample-ms" ).as<uint32_t>() * 1000;
+      my->chain_config->fork_switch_trust_validated = options.at( "fork-switch-trust-validated-blocks" ).as<bool>();
       my->chain_config->allow_ram_billing_in_notify = options.at( "disable-ram-billing-notify-checks" ).as<bool>();
 
 #ifdef EOSIO_DEVELOPER
@@ -1009,12 +1236,19 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
          EOS_ASSERT( fc::exists(*my->snapshot_path), plugin_config_exception,
                      "Cannot load snapshot, ${name} does not exist", ("name", my->snapshot_path->generic_string()) );
 
+         if (options.count( "snapshot-base" )) {
+            my->snapshot_base_path = options.at( "snapshot-base" ).as<bfs::path>();
+            EOS_ASSERT( fc::exists(*my->snapshot_base_path), plugin_config_exception,
+                        "Cannot load snapshot base, ${name} does not exist", ("name", my->snapshot_base_path->generic_string()) );
+         }
+
          // recover genesis information from the snapshot
          // used for validation code below
          auto infile = std::ifstream(my->snapshot_path->generic_string(), (std::ios::in | std::ios::binary));
-         istream_snapshot_reader reader(infile);
-         reader.validate();
-         chain_id = controller::extract_chain_id(reader);
+         auto basefile = my->open_snapshot_base();
+         auto reader = make_snapshot_reader(infile, basefile);
+         reader->validate();
+         chain_id = controller::extract_chain_id(*reader);
          infile.close();
 
          EOS_ASSERT( options.count( "genesis-timestamp" ) == 0,
@@ -1192,14 +1426,54 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
          my->chain_config->eosvmoc_config.threads = options.at("eos-vm-oc-compile-threads").as<uint64_t>();
       if( options["eos-vm-oc-enable"].as<bool>() )
          my->chain_config->eosvmoc_tierup = true;
+      if( options.count("eos-vm-oc-cache-dir") ) {
+         auto dir = options.at("eos-vm-oc-cache-dir").as<bfs::path>();
+         my->chain_config->eosvmoc_config.cache_dir = dir.is_relative() ? app().data_dir() / dir : dir;
+      }
+      my->chain_config->eosvmoc_config.tierup_threshold = std::max<uint64_t>( options.at("eos-vm-oc-tierup-threshold").as<uint64_t>(), 1u );
+      my->chain_config->eosvmoc_config.prewarm_contracts = options.at("eos-vm-oc-prewarm-contracts").as<uint64_t>();
+      my->chain_config->eosvmoc_config.compile_nice = options.at("eos-vm-oc-compile-nice").as<int>();
+      my->eosvmoc_prewarm_max_time = fc::milliseconds( options.at("eos-vm-oc-prewarm-max-ms").as<uint32_t>() );
 #endif
 
       my->account_queries_enabled = options.at("enable-account-queries").as<bool>();
+      if( auto abi_cache_size = options.at("api-abi-cache-size").as<uint32_t>() ) {
+         my->_abi_serializer_cache.emplace( abi_cache_size );
+      }
+      if( auto block_cache_size = options.at("api-block-cache-size").as<uint32_t>() ) {
+         my->_rendered_block_cache.emplace( block_cache_size );
+      }
+      if( auto account_cache_size = options.at("api-account-cache-size").as<uint32_t>() ) {
+         my->_account_summary_cache.emplace( account_cache_size );
+      }
+      my->read_only_api_threads = options.at("read-only-api-threads").as<uint16_t>();
+      EOS_ASSERT( my->read_only_api_threads == 0 || my->chain_config->backing_store == backing_store_type::CHAINBASE,
+                  plugin_config_exception, "read-only-api-threads requires backing-store = chainbase" );
+
+#ifdef __linux__
+      if( options.count( "database-numa-node" ) )
+         bind_to_numa_node( options.at( "database-numa-node" ).as<uint32_t>() );
+#endif
 
       my->chain.emplace( *my->chain_config, std::move(pfs), *chain_id );
 
       // initialize deep mind logging
-      if ( options.at( "deep-mind" ).as<bool>() ) {
+      const auto deep_mind_format = options.at( "deep-mind-format" ).as<string>();
+      EOS_ASSERT( deep_mind_format == "text" || deep_mind_format == "framed", plugin_config_exception,
+                  "deep-mind-format must be \"text\" or \"framed\", not ${f}", ("f", deep_mind_format) );
+      if ( options.at( "deep-mind" ).as<bool>() && deep_mind_format == "framed" ) {
+         // events are formatted and written on the writer thread, in large writes, instead of one unbuffered
+         // write to stdout per event on the main thread
+         my->_deep_mind_writer = std::make_shared<deep_mind_framed_writer>(
+               options.at( "deep-mind-output" ).as<string>(), options.at( "deep-mind-buffer-events" ).as<uint32_t>(),
+               []( const std::string& error ) {
+                  elog( "${e}, shutting down", ("e", error) );
+                  app().post( priority::high, []() { app().quit(); } );
+               } );
+         my->_deep_mind_framed_log.set_log_level( fc::log_level::debug );
+         my->_deep_mind_framed_log.add_appender( my->_deep_mind_writer );
+         my->chain->enable_deep_mind( &my->_deep_mind_framed_log );
+      } else if ( options.at( "deep-mind" ).as<bool>() ) {
          // The actual `fc::dmlog_appender` implementation that is currently used by deep mind
          // logger is using `stdout` to prints it's log line out. Deep mind logging outputs
          // massive amount of data out of the process, which can lead under pressure to some
@@ -1313,10 +1587,28 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
                if (my->_account_query_db) {
                   my->_account_query_db->cache_transaction_trace(std::get<0>(t));
                }
+
+               if (my->_abi_serializer_cache) {
+                  my->_abi_serializer_cache->invalidate(std::get<0>(t));
+               }
+
+               if (my->_rendered_block_cache) {
+                  my->_rendered_block_cache->invalidate(std::get<0>(t));
+               }
+
+               if (my->_account_summary_cache) {
+                  my->_account_summary_cache->invalidate();
+               }
                
                my->applied_transaction_channel.publish( priority::low, std::get<0>(t) );
             } );
 
+      if (my->_account_summary_cache) {
+         my->block_start_connection = my->chain->block_start.connect( [this]( uint32_t ) {
+            my->_account_summary_cache->invalidate();
+         } );
+      }
+
       my->chain->add_indices();
    } FC_LOG_AND_RETHROW()
 
@@ -1338,7 +1630,8 @@ void chain_plugin::plugin_startup()
           bss.do_sync();
       } else if (my->snapshot_path) {
          auto infile = std::ifstream(my->snapshot_path->generic_string(), (std::ios::in | std::ios::binary));
-         auto reader = std::make_shared<istream_snapshot_reader>(infile);
+         auto basefile = my->open_snapshot_base();
+         auto reader = make_snapshot_reader(infile, basefile);
          my->chain->startup(shutdown, check_shutdown, reader);
          infile.close();
       } else {
@@ -1363,6 +1656,11 @@ void chain_plugin::plugin_startup()
       ilog("Blockchain started; head block is #${num}", ("num", my->chain->head_block_num()));
    }
 
+   // plugins accepting blocks and transactions start after chain_plugin, so the hot contracts are compiled before any traffic
+   if( my->chain_config->eosvmoc_tierup && my->chain_config->eosvmoc_config.prewarm_contracts ) {
+      my->chain->get_wasm_interface().eosvmoc_prewarm( fc::time_point::now() + my->eosvmoc_prewarm_max_time );
+   }
+
    my->chain_config.reset();
   
    if (my->account_queries_enabled) {
@@ -1373,6 +1671,11 @@ void chain_plugin::plugin_startup()
       } FC_LOG_AND_DROP(("Unable to enable account queries"));
    }
 
+   if (my->read_only_api_threads > 0) {
+      my->_read_only_api_executor.emplace( my->read_only_api_threads, [](std::function<void()> window) {
+         main_thread_post( priority::medium_low, std::move(window) );
+      });
+   }
 
 
 } FC_CAPTURE_AND_RETHROW() }
@@ -1384,9 +1687,14 @@ void chain_plugin::plugin_shutdown() {
    my->irreversible_block_connection.reset();
    my->accepted_transaction_connection.reset();
    my->applied_transaction_connection.reset();
+   my->block_start_connection.reset();
+   if(my->_read_only_api_executor)
+      my->_read_only_api_executor->stop();
    if(app().is_quiting())
       my->chain->get_wasm_interface().indicate_shutting_down();
    my->chain.reset();
+   if(my->_deep_mind_writer)
+      my->_deep_mind_writer->stop();
    zipkin_config::shutdown();
 }
 
@@ -1394,10 +1702,12 @@ void chain_plugin::handle_sighup() {
    fc::logger::update( deep_mind_logger_name, _deep_mind_log );
 }
 
-chain_apis::read_write::read_write(controller& db, const fc::microseconds& abi_serializer_max_time, bool api_accept_transactions)
+chain_apis::read_write::read_write(controller& db, const fc::microseconds& abi_serializer_max_time, bool api_accept_transactions,
+                                   abi_serializer_cache* abi_cache)
 : db(db)
 , abi_serializer_max_time(abi_serializer_max_time)
 , api_accept_transactions(api_accept_transactions)
+, abi_cache(abi_cache)
 {
 }
 
@@ -1407,7 +1717,24 @@ void chain_apis::read_write::validate() const {
 }
 
 chain_apis::read_only chain_plugin::get_read_only_api() const {
-   return chain_apis::read_only(chain(), my->_account_query_db, get_abi_serializer_max_time());
+   return chain_apis::read_only(chain(), my->_account_query_db, get_abi_serializer_max_time(), get_abi_serializer_cache(),
+                                get_rendered_block_cache(), get_account_summary_cache());
+}
+
+chain_apis::abi_serializer_cache* chain_plugin::get_abi_serializer_cache() const {
+   return my->_abi_serializer_cache ? &*my->_abi_serializer_cache : nullptr;
+}
+
+chain_apis::read_only_api_executor* chain_plugin::get_read_only_api_executor() const {
+   return my->_read_only_api_executor ? &*my->_read_only_api_executor : nullptr;
+}
+
+chain_apis::rendered_block_cache* chain_plugin::get_rendered_block_cache() const {
+   return my->_rendered_block_cache ? &*my->_rendered_block_cache : nullptr;
+}
+
+chain_apis::account_summary_cache* chain_plugin::get_account_summary_cache() const {
+   return my->_account_summary_cache ? &*my->_account_summary_cache : nullptr;
 }
 
   
@@ -1415,8 +1742,9 @@ bool chain_plugin::accept_block(const signed_block_ptr& block, const block_id_ty
    return my->incoming_block_sync_method(block, id);
 }
 
-void chain_plugin::accept_transaction(const chain::packed_transaction_ptr& trx, next_function<chain::transaction_trace_ptr> next) {
-   my->incoming_transaction_async_method(trx, false, std::move(next));
+void chain_plugin::accept_transaction(const chain::packed_transaction_ptr& trx, next_function<chain::transaction_trace_ptr> next,
+                                      transaction_source source) {
+   my->incoming_transaction_async_method(trx, false, source, std::move(next));
 }
 
 bool chain_plugin::recover_reversible_blocks( const fc::path& db_dir, uint32_t cache_size,
@@ -1842,6 +2170,23 @@ uint64_t read_only::get_table_index_name(const read_only::get_table_rows_params&
    return index;
 }
 
+string read_only::encode_table_rows_cursor(const table_rows_cursor& c) {
+   return fc::to_hex( fc::raw::pack( c ) );
+}
+
+read_only::table_rows_cursor read_only::decode_table_rows_cursor(const read_only::get_table_rows_params& p, name scope, name index_table, bool reverse) {
+   table_rows_cursor c;
+   try {
+      bytes packed( p.cursor->size() / 2 );
+      EOS_ASSERT( fc::from_hex( *p.cursor, packed.data(), packed.size() ) == packed.size(), chain::contract_table_query_exception, "Invalid cursor ${c}", ("c", *p.cursor) );
+      fc::datastream<const char*> ds( packed.data(), packed.size() );
+      fc::raw::unpack( ds, c );
+   } EOS_RETHROW_EXCEPTIONS( chain::contract_table_query_exception, "Invalid cursor ${c}", ("c", *p.cursor) )
+   EOS_ASSERT( c.code == p.code && c.scope == scope && c.index_table == index_table && c.reverse == reverse,
+               chain::contract_table_query_exception, "Cursor was not returned by a query of this index in this direction" );
+   return c;
+}
+
 uint64_t convert_to_type(const eosio::name &n, const string &desc) {
    return n.to_uint64_t();
 }
@@ -1926,15 +2271,6 @@ string convert_to_string(const float128_t& source, const string& key_type, const
    } FC_RETHROW_EXCEPTIONS(warn, "Could not convert ${desc} from '${source}' to string.", ("desc", desc)("source",source) )
 }
 
-abi_def get_abi( const controller& db, const name& account ) {
-   const auto &d = db.db();
-   const account_object *code_accnt = d.find<account_object, by_name>(account);
-   EOS_ASSERT(code_accnt != nullptr, chain::account_query_exception, "Fail to retrieve account for ${account}", ("account", account) );
-   abi_def abi;
-   abi_serializer::to_abi(code_accnt->abi, abi);
-   return abi;
-}
-
 string get_table_type( const abi_def& abi, const name& table_name ) {
    for( const auto& t : abi.tables ) {
       if( t.name == table_name ){
@@ -1945,7 +2281,9 @@ string get_table_type( const abi_def& abi, const name& table_name ) {
 }
 
 read_only::get_table_rows_result read_only::get_table_rows( const read_only::get_table_rows_params& p )const {
-   const abi_def abi = eosio::chain_apis::get_abi( db, p.code );
+   const auto cached = get_cached_abi( p.code );
+   const abi_def& abi = cached->abi;
+   const abi_serializer& abis = cached->serializer;
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wstrict-aliasing"
    bool primary = false;
@@ -1954,43 +2292,43 @@ read_only::get_table_rows_result read_only::get_table_rows( const read_only::get
       EOS_ASSERT( p.table == table_with_index, chain::contract_table_query_exception, "Invalid table name ${t}", ( "t", p.table ));
       auto table_type = get_table_type( abi, p.table );
       if( table_type == KEYi64 || p.key_type == "i64" || p.key_type == "name" ) {
-         return get_table_rows_ex<key_value_index>(p,abi);
+         return get_table_rows_ex<key_value_index>(p,abis);
       }
       EOS_ASSERT( false, chain::contract_table_query_exception,  "Invalid table type ${type}", ("type",table_type)("abi",abi));
    } else {
       EOS_ASSERT( !p.key_type.empty(), chain::contract_table_query_exception, "key type required for non-primary index" );
 
       if (p.key_type == chain_apis::i64 || p.key_type == "name") {
-         return get_table_rows_by_seckey<index64_index, uint64_t>(p, abi, [](uint64_t v)->uint64_t {
+         return get_table_rows_by_seckey<index64_index, uint64_t>(p, abis, [](uint64_t v)->uint64_t {
             return v;
          });
       }
       else if (p.key_type == chain_apis::i128) {
-         return get_table_rows_by_seckey<index128_index, uint128_t>(p, abi, [](uint128_t v)->uint128_t {
+         return get_table_rows_by_seckey<index128_index, uint128_t>(p, abis, [](uint128_t v)->uint128_t {
             return v;
          });
       }
       else if (p.key_type == chain_apis::i256) {
          if ( p.encode_type == chain_apis::hex) {
             using  conv = keytype_converter<chain_apis::sha256,chain_apis::hex>;
-            return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+            return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abis, conv::function());
          }
          using  conv = keytype_converter<chain_apis::i256>;
-         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abis, conv::function());
       }
       else if (p.key_type == chain_apis::float64) {
-         return get_table_rows_by_seckey<index_double_index, double>(p, abi, [](double v)->float64_t {
+         return get_table_rows_by_seckey<index_double_index, double>(p, abis, [](double v)->float64_t {
             float64_t f = *(float64_t *)&v;
             return f;
          });
       }
       else if (p.key_type == chain_apis::float128) {
          if ( p.encode_type == chain_apis::hex) {
-            return get_table_rows_by_seckey<index_long_double_index, uint128_t>(p, abi, [](uint128_t v)->float128_t{
+            return get_table_rows_by_seckey<index_long_double_index, uint128_t>(p, abis, [](uint128_t v)->float128_t{
                return *reinterpret_cast<float128_t *>(&v);
             });
          }
-         return get_table_rows_by_seckey<index_long_double_index, double>(p, abi, [](double v)->float128_t{
+         return get_table_rows_by_seckey<index_long_double_index, double>(p, abis, [](double v)->float128_t{
             float64_t f = *(float64_t *)&v;
             float128_t f128;
             f64_to_f128M(f, &f128);
@@ -1999,17 +2337,38 @@ read_only::get_table_rows_result read_only::get_table_rows( const read_only::get
       }
       else if (p.key_type == chain_apis::sha256) {
          using  conv = keytype_converter<chain_apis::sha256,chain_apis::hex>;
-         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abis, conv::function());
       }
       else if(p.key_type == chain_apis::ripemd160) {
          using  conv = keytype_converter<chain_apis::ripemd160,chain_apis::hex>;
-         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abis, conv::function());
       }
       EOS_ASSERT(false, chain::contract_table_query_exception,  "Unsupported secondary index type: ${t}", ("t", p.key_type));
    }
 #pragma GCC diagnostic pop
 }
 
+std::string read_only::get_table_rows_result::to_json()const {
+   if( !rows_json_text ) {
+      return fc::json::to_string( fc::variant( *this ), fc::time_point::maximum() );
+   }
+   std::string json = "{\"rows\":[";
+   for( size_t i = 0; i < rows.size(); ++i ) {
+      if( i ) json += ',';
+      json += rows[i].get_string();
+   }
+   json += "],\"more\":";
+   json += more ? "true" : "false";
+   json += ",\"next_key\":";
+   json += fc::json::to_string( fc::variant( next_key ), fc::time_point::maximum() );
+   json += ",\"next_key_bytes\":";
+   json += fc::json::to_string( fc::variant( next_key_bytes ), fc::time_point::maximum() );
+   json += ",\"next_cursor\":";
+   json += fc::json::to_string( fc::variant( next_cursor ), fc::time_point::maximum() );
+   json += '}';
+   return json;
+}
+
 /// short_string is intended to optimize the string equality comparison where one of the operand is
 /// no greater than 8 bytes long.
 struct short_string {
@@ -2240,20 +2599,23 @@ struct kv_table_rows_context {
    std::unique_ptr<eosio::chain::kv_context>  kv_context;
    const read_only::get_kv_table_rows_params& p;
    abi_serializer::yield_function_t           yield_function;                            
-   abi_def                                    abi;
-   abi_serializer                             abis;
+   cached_abi_ptr                             cached;
+   const abi_def&                             abi;
+   const abi_serializer&                      abis;
    std::string                                index_type;
    bool                                       shorten_abi_errors;
    bool                                       is_primary_idx;
 
-   kv_table_rows_context(const controller& db, const read_only::get_kv_table_rows_params& param,
+   kv_table_rows_context(const controller& db, const read_only::get_kv_table_rows_params& param, cached_abi_ptr code_abi,
                          const fc::microseconds abi_serializer_max_time, bool shorten_error)
        : kv_context(db.kv_db().create_kv_context(
              param.code, {},
              db.get_global_properties().kv_configuration)) // To do: provide kv_resource_manmager to create_kv_context
        , p(param)
        , yield_function(abi_serializer::create_yield_function(abi_serializer_max_time))
-       , abi(eosio::chain_apis::get_abi(db, param.code))
+       , cached(std::move(code_abi))
+       , abi(cached->abi)
+       , abis(cached->serializer)
        , shorten_abi_errors(shorten_error) {
 
       EOS_ASSERT(p.limit > 0, chain::contract_table_query_exception, "invalid limit : ${n}", ("n", p.limit));
@@ -2272,7 +2634,6 @@ struct kv_table_rows_context {
                  ("t", p.table)("i", p.index_name));
 
       index_type = kv_tbl_def.get_index_type(p.index_name.to_string());
-      abis.set_abi(abi, yield_function);
    }
 
    bool point_query() const { return p.index_value.size(); }
@@ -2451,7 +2812,7 @@ read_only::get_table_rows_result kv_get_rows(Range&& range) {
 
 read_only::get_table_rows_result read_only::get_kv_table_rows(const read_only::get_kv_table_rows_params& p) const {
 
-   kv_table_rows_context context{db, p, abi_serializer_max_time, shorten_abi_errors};
+   kv_table_rows_context context{db, p, get_cached_abi(p.code), abi_serializer_max_time, shorten_abi_errors};
 
    if (context.point_query()) {
       EOS_ASSERT(p.lower_bound.empty() && p.upper_bound.empty(), chain::contract_table_query_exception,
@@ -2586,8 +2947,7 @@ read_only::get_table_by_scope_result read_only::get_table_by_scope( const read_o
 
 vector<asset> read_only::get_currency_balance( const read_only::get_currency_balance_params& p )const {
 
-   const abi_def abi = eosio::chain_apis::get_abi( db, p.code );
-   (void)get_table_type( abi, name("accounts") );
+   (void)get_table_type( get_cached_abi( p.code )->abi, name("accounts") );
 
    vector<asset> results;
    walk_key_value_table(p.code, p.account, "accounts"_n, [&](const auto& obj){
@@ -2613,8 +2973,7 @@ vector<asset> read_only::get_currency_balance( const read_only::get_currency_bal
 fc::variant read_only::get_currency_stats( const read_only::get_currency_stats_params& p )const {
    fc::mutable_variant_object results;
 
-   const abi_def abi = eosio::chain_apis::get_abi( db, p.code );
-   (void)get_table_type( abi, name("stat") );
+   (void)get_table_type( get_cached_abi( p.code )->abi, name("stat") );
 
    uint64_t scope = ( eosio::chain::string_to_symbol( 0, boost::algorithm::to_upper_copy(p.symbol).c_str() ) >> 8 );
 
@@ -2637,9 +2996,9 @@ fc::variant read_only::get_currency_stats( const read_only::get_currency_stats_p
 
 read_only::get_producers_result read_only::get_producers( const read_only::get_producers_params& p ) const try {
    const auto producers_table = "producers"_n;
-   const abi_def abi = eosio::chain_apis::get_abi(db, config::system_account_name);
-   const auto table_type = get_table_type(abi, producers_table);
-   const abi_serializer abis{ abi, abi_serializer::create_yield_function( abi_serializer_max_time ) };
+   const auto cached = get_cached_abi(config::system_account_name);
+   const auto table_type = get_table_type(cached->abi, producers_table);
+   const abi_serializer& abis = cached->serializer;
    EOS_ASSERT(table_type == KEYi64, chain::contract_table_query_exception, "Invalid table type ${type} for table producers", ("type",table_type));
 
    const auto& d = db.db();
@@ -2805,26 +3164,39 @@ read_only::get_producer_schedule_result read_only::get_producer_schedule( const
    return result;
 }
 
+static cached_abi_ptr get_cached_abi( const controller& db, abi_serializer_cache* abi_cache, const account_object& accnt,
+                                      const fc::microseconds& abi_serializer_max_time ) {
+   return abi_cache ? abi_cache->get( db, accnt, abi_serializer_max_time )
+                    : abi_serializer_cache::make( accnt, abi_serializer_max_time );
+}
+
+cached_abi_ptr read_only::get_cached_abi( const name& account )const {
+   const account_object* accnt = db.db().find<account_object, by_name>( account );
+   EOS_ASSERT( accnt != nullptr, chain::account_query_exception, "Fail to retrieve account for ${account}", ("account", account) );
+   return chain_apis::get_cached_abi( db, abi_cache, *accnt, abi_serializer_max_time );
+}
+
 template<typename Api>
 struct resolver_factory {
-   static auto make(const Api* api, abi_serializer::yield_function_t yield) {
-      return [api, yield{std::move(yield)}](const account_name &name) -> std::optional<abi_serializer> {
+   /// serializers are shared with the abi cache of api, the resolved serializer refers into the cached abi
+   static auto make(const Api* api) {
+      return [api](const account_name &name) -> std::shared_ptr<const abi_serializer> {
          const auto* accnt = api->db.db().template find<account_object, by_name>(name);
          if (accnt != nullptr) {
-            abi_def abi;
-            if (abi_serializer::to_abi(accnt->abi, abi)) {
-               return abi_serializer(abi, yield);
+            auto abi = get_cached_abi(api->db, api->abi_cache, *accnt, api->abi_serializer_max_time);
+            if (abi->has_abi) {
+               return std::shared_ptr<const abi_serializer>(abi, &abi->serializer);
             }
          }
 
-         return std::optional<abi_serializer>();
+         return {};
       };
    }
 };
 
 template<typename Api>
-auto make_resolver(const Api* api, abi_serializer::yield_function_t yield) {
-   return resolver_factory<Api>::make(api, std::move( yield ));
+auto make_resolver(const Api* api) {
+   return resolver_factory<Api>::make(api);
 }
 
 
@@ -2860,7 +3232,7 @@ read_only::get_scheduled_transactions( const read_only::get_scheduled_transactio
 
    read_only::get_scheduled_transactions_result result;
 
-   auto resolver = make_resolver(this, abi_serializer::create_yield_function( abi_serializer_max_time ));
+   auto resolver = make_resolver(this);
 
    uint32_t remaining = p.limit;
    auto time_limit = fc::time_point::now() + fc::microseconds(1000 * 10); /// 10ms max time
@@ -2901,32 +3273,42 @@ read_only::get_scheduled_transactions( const read_only::get_scheduled_transactio
    return result;
 }
 
-fc::variant read_only::get_block(const read_only::get_block_params& params) const {
-   signed_block_ptr block;
-   std::optional<uint64_t> block_num;
-
-   EOS_ASSERT( !params.block_num_or_id.empty() && params.block_num_or_id.size() <= 64,
+static std::optional<uint64_t> parse_block_num( const string& block_num_or_id ) {
+   EOS_ASSERT( !block_num_or_id.empty() && block_num_or_id.size() <= 64,
                chain::block_id_type_exception,
                "Invalid Block number or ID, must be greater than 0 and less than 64 characters"
    );
 
    try {
-      block_num = fc::to_uint64(params.block_num_or_id);
+      return fc::to_uint64(block_num_or_id);
    } catch( ... ) {}
+   return {};
+}
 
-   if( block_num ) {
+static block_id_type parse_block_id( const string& block_num_or_id ) {
+   try {
+      return fc::variant(block_num_or_id).as<block_id_type>();
+   } EOS_RETHROW_EXCEPTIONS(chain::block_id_type_exception, "Invalid block ID: ${block_num_or_id}", ("block_num_or_id", block_num_or_id))
+}
+
+static signed_block_ptr fetch_block( const controller& db, const read_only::get_block_params& params ) {
+   signed_block_ptr block;
+   if( auto block_num = parse_block_num( params.block_num_or_id ) ) {
       block = db.fetch_block_by_number( *block_num );
    } else {
-      try {
-         block = db.fetch_block_by_id( fc::variant(params.block_num_or_id).as<block_id_type>() );
-      } EOS_RETHROW_EXCEPTIONS(chain::block_id_type_exception, "Invalid block ID: ${block_num_or_id}", ("block_num_or_id", params.block_num_or_id))
+      block = db.fetch_block_by_id( parse_block_id( params.block_num_or_id ) );
    }
 
    EOS_ASSERT( block, unknown_block_exception, "Could not find block: ${block}", ("block", params.block_num_or_id));
+   return block;
+}
+
+fc::variant read_only::get_block(const read_only::get_block_params& params) const {
+   signed_block_ptr block = fetch_block( db, params );
 
    // serializes signed_block to variant in signed_block_v0 format
    fc::variant pretty_output;
-   abi_serializer::to_variant(*block, pretty_output, make_resolver(this, abi_serializer::create_yield_function( abi_serializer_max_time )),
+   abi_serializer::to_variant(*block, pretty_output, make_resolver(this),
                               abi_serializer::create_yield_function( abi_serializer_max_time ));
 
    const auto id = block->calculate_id();
@@ -2938,6 +3320,38 @@ fc::variant read_only::get_block(const read_only::get_block_params& params) cons
            ("ref_block_prefix", ref_block_prefix);
 }
 
+read_only::get_block_json_result read_only::get_block_json(const read_only::get_block_params& params) const {
+   if( !block_cache ) {
+      return { std::make_shared<const string>( fc::json::to_string( get_block( params ), fc::time_point::maximum() ) ), {} };
+   }
+
+   // look the block up by id without fetching it, a block number unknown here fails in get_block below
+   std::optional<block_id_type> id;
+   if( auto block_num = parse_block_num( params.block_num_or_id ) ) {
+      try {
+         id = db.get_block_id_for_num( *block_num );
+      } catch( ... ) {}
+   } else {
+      id = parse_block_id( params.block_num_or_id );
+   }
+   if( id ) {
+      if( auto r = block_cache->get( *id ); r.json ) {
+         return { std::move( r.json ), std::move( r.etag ) };
+      }
+   }
+
+   const auto generation = block_cache->current_generation();
+   const auto block = get_block( params );
+   const auto block_id = block["id"].as<block_id_type>();
+   auto r = block_cache->put( block_id, std::make_shared<const string>( fc::json::to_string( block, fc::time_point::maximum() ) ),
+                              generation );
+   return { std::move( r.json ), std::move( r.etag ) };
+}
+
+read_only::get_block_cache_metrics_result read_only::get_block_cache_metrics(const read_only::get_block_cache_metrics_params&) const {
+   return block_cache ? block_cache->get_metrics() : get_block_cache_metrics_result{};
+}
+
 fc::variant read_only::get_block_info(const read_only::get_block_info_params& params) const {
 
    signed_block_ptr block;
@@ -2967,6 +3381,12 @@ fc::variant read_only::get_block_info(const read_only::get_block_info_params& pa
          ("ref_block_prefix", ref_block_prefix);
 }
 
+read_only::get_transaction_block_num_result read_only::get_transaction_block_num(const read_only::get_transaction_block_num_params& params) const {
+   EOS_ASSERT( db.has_block_log_trx_index(), plugin_config_exception,
+               "get_transaction_block_num requires the blocks-trx-index option" );
+   return { db.fetch_irreversible_block_num_by_trx_id( params.id ) };
+}
+
 fc::variant read_only::get_block_header_state(const get_block_header_state_params& params) const {
    block_state_ptr b;
    std::optional<uint64_t> block_num;
@@ -3001,10 +3421,27 @@ void read_write::push_block(read_write::push_block_params&& params, next_functio
    } CATCH_AND_CALL(next);
 }
 
+// action profiles are not part of the reflected action_trace, they are added to the returned trace when present
+static void add_action_profiles( fc::variant& output, const transaction_trace& trace ) {
+   if( std::none_of( trace.action_traces.begin(), trace.action_traces.end(), []( const auto& at ) { return at.profile.has_value(); } ) )
+      return;
+   fc::variants act_traces = output["action_traces"].get_array();
+   for( size_t i = 0; i < act_traces.size() && i < trace.action_traces.size(); ++i ) {
+      if( trace.action_traces[i].profile ) {
+         fc::mutable_variant_object act_trace( act_traces[i] );
+         act_trace["profile"] = fc::variant( *trace.action_traces[i].profile );
+         act_traces[i] = std::move( act_trace );
+      }
+   }
+   fc::mutable_variant_object output_mvo( output );
+   output_mvo["action_traces"] = std::move( act_traces );
+   output = std::move( output_mvo );
+}
+
 void read_write::push_transaction(const read_write::push_transaction_params& params, next_function<read_write::push_transaction_results> next) {
    try {
       packed_transaction_v0 input_trx_v0;
-      auto resolver = make_resolver(this, abi_serializer::create_yield_function( abi_serializer_max_time ));
+      auto resolver = make_resolver(this);
       packed_transaction_ptr input_trx;
       try {
          abi_serializer::from_variant(params, input_trx_v0, std::move( resolver ), abi_serializer::create_yield_function( abi_serializer_max_time ));
@@ -3016,7 +3453,7 @@ void read_write::push_transaction(const read_write::push_transaction_params& par
       fc_add_tag(trx_span, "trx_id", input_trx->id());
       fc_add_tag(trx_span, "method", "push_transaction");
 
-      app().get_method<incoming::methods::transaction_async>()(input_trx, true,
+      app().get_method<incoming::methods::transaction_async>()(input_trx, true, api_transaction_source,
             [this, token=trx_trace.get_token(), input_trx, next]
             (const std::variant<fc::exception_ptr, transaction_trace_ptr>& result) -> void {
 
@@ -3044,6 +3481,7 @@ void read_write::push_transaction(const read_write::push_transaction_params& par
                fc::variant output;
                try {
                   output = db.to_variant_with_abi( *trx_trace_ptr, abi_serializer::create_yield_function( abi_serializer_max_time ) );
+                  add_action_profiles( output, *trx_trace_ptr );
 
                   // Create map of (closest_unnotified_ancestor_action_ordinal, global_sequence) with action trace
                   std::map< std::pair<uint32_t, uint64_t>, fc::mutable_variant_object > act_traces_map;
@@ -3093,6 +3531,7 @@ void read_write::push_transaction(const read_write::push_transaction_params& par
                   output = output_mvo;
                } catch( chain::abi_exception& ) {
                   output = *trx_trace_ptr;
+                  add_action_profiles( output, *trx_trace_ptr );
                }
 
                const chain::transaction_id_type& id = trx_trace_ptr->id;
@@ -3147,7 +3586,7 @@ void read_write::send_transaction(const read_write::send_transaction_params& par
 
    try {
       packed_transaction_v0 input_trx_v0;
-      auto resolver = make_resolver(this, abi_serializer::create_yield_function( abi_serializer_max_time ));
+      auto resolver = make_resolver(this);
       packed_transaction_ptr input_trx;
       try {
          abi_serializer::from_variant(params, input_trx_v0, std::move( resolver ), abi_serializer::create_yield_function( abi_serializer_max_time ));
@@ -3159,7 +3598,7 @@ void read_write::send_transaction(const read_write::send_transaction_params& par
       fc_add_tag(trx_span, "trx_id", input_trx->id());
       fc_add_tag(trx_span, "method", "send_transaction");
 
-      app().get_method<incoming::methods::transaction_async>()(input_trx, true,
+      app().get_method<incoming::methods::transaction_async>()(input_trx, true, api_transaction_source,
             [this, token=trx_trace.get_token(), input_trx, next]
             (const std::variant<fc::exception_ptr, transaction_trace_ptr>& result) -> void {
          auto trx_span = fc_create_span_from_token(token, "Processed");
@@ -3189,6 +3628,7 @@ void read_write::send_transaction(const read_write::send_transaction_params& par
                } catch( chain::abi_exception& ) {
                   output = *trx_trace_ptr;
                }
+               add_action_profiles( output, *trx_trace_ptr );
 
                const chain::transaction_id_type& id = trx_trace_ptr->id;
                next(read_write::send_transaction_results{id, output});
@@ -3202,15 +3642,49 @@ void read_write::send_transaction(const read_write::send_transaction_params& par
    } CATCH_AND_CALL(next);
 }
 
+void read_write::send_read_only_transaction(const read_write::send_read_only_transaction_params& params, next_function<read_write::send_read_only_transaction_results> next) {
+
+   try {
+      packed_transaction_v0 input_trx_v0;
+      auto resolver = make_resolver(this);
+      packed_transaction_ptr input_trx;
+      try {
+         abi_serializer::from_variant(params, input_trx_v0, std::move( resolver ), abi_serializer::create_yield_function( abi_serializer_max_time ));
+         input_trx = std::make_shared<packed_transaction>( std::move( input_trx_v0 ), true );
+      } EOS_RETHROW_EXCEPTIONS(chain::packed_transaction_type_exception, "Invalid packed transaction")
+
+      EOS_ASSERT( db.is_building_block(), chain::block_validate_exception,
+                  "read-only transactions require a pending block" );
+
+      // executed directly against the pending block state and always undone, it never reaches the producer queue
+      auto trx_meta = transaction_metadata::create_no_recover_keys( input_trx, transaction_metadata::trx_type::read_only );
+      auto trx_trace_ptr = db.push_transaction( trx_meta, fc::time_point::maximum(), 0, false, 0 );
+
+      fc::variant output;
+      try {
+         output = db.to_variant_with_abi( *trx_trace_ptr, abi_serializer::create_yield_function( abi_serializer_max_time ) );
+      } catch( chain::abi_exception& ) {
+         output = *trx_trace_ptr;
+      }
+      add_action_profiles( output, *trx_trace_ptr );
+
+      next(read_write::send_read_only_transaction_results{trx_trace_ptr->id, output});
+   } catch ( boost::interprocess::bad_alloc& ) {
+      chain_plugin::handle_db_exhaustion();
+   } catch ( const std::bad_alloc& ) {
+      chain_plugin::handle_bad_alloc();
+   } CATCH_AND_CALL(next);
+}
+
 read_only::get_abi_results read_only::get_abi( const get_abi_params& params )const {
    get_abi_results result;
    result.account_name = params.account_name;
    const auto& d = db.db();
    const auto& accnt  = d.get<account_object,by_name>( params.account_name );
 
-   abi_def abi;
-   if( abi_serializer::to_abi(accnt.abi, abi) ) {
-      result.abi = std::move(abi);
+   const auto cached = chain_apis::get_cached_abi( db, abi_cache, accnt, abi_serializer_max_time );
+   if( cached->has_abi ) {
+      result.abi = cached->abi;
    }
 
    return result;
@@ -3284,6 +3758,18 @@ read_only::get_raw_abi_results read_only::get_raw_abi( const get_raw_abi_params&
 }
 
 read_only::get_account_results read_only::get_account( const get_account_params& params )const {
+   if( !account_cache ) return read_account( params );
+
+   const auto version = account_cache->version( db );
+   if( auto cached = account_cache->get( params, version ) ) {
+      return std::move( *cached );
+   }
+   auto result = read_account( params );
+   account_cache->put( params, version, result );
+   return result;
+}
+
+read_only::get_account_results read_only::read_account( const get_account_params& params )const {
    get_account_results result;
    result.account_name = params.account_name;
 
@@ -3333,11 +3819,9 @@ read_only::get_account_results read_only::get_account( const get_account_params&
       ++perm;
    }
 
-   const auto& code_account = db.db().get<account_object,by_name>( config::system_account_name );
-
-   abi_def abi;
-   if( abi_serializer::to_abi(code_account.abi, abi) ) {
-      abi_serializer abis( abi, abi_serializer::create_yield_function( abi_serializer_max_time ) );
+   const auto cached = get_cached_abi( config::system_account_name );
+   if( cached->has_abi ) {
+      const abi_serializer& abis = cached->serializer;
 
       const auto token_code = "eosio.token"_n;
 
@@ -3384,9 +3868,10 @@ read_only::abi_json_to_bin_result read_only::abi_json_to_bin( const read_only::a
    const auto code_account = db.db().find<account_object,by_name>( params.code );
    EOS_ASSERT(code_account != nullptr, contract_query_exception, "Contract can't be found ${contract}", ("contract", params.code));
 
-   abi_def abi;
-   if( abi_serializer::to_abi(code_account->abi, abi) ) {
-      abi_serializer abis( abi, abi_serializer::create_yield_function( abi_serializer_max_time ) );
+   const auto cached = chain_apis::get_cached_abi( db, abi_cache, *code_account, abi_serializer_max_time );
+   if( cached->has_abi ) {
+      const abi_def& abi = cached->abi;
+      const abi_serializer& abis = cached->serializer;
       auto action_type = abis.get_action_type(params.action);
       EOS_ASSERT(!action_type.empty(), action_validate_exception, "Unknown action ${action} in contract ${contract}", ("action", params.action)("contract", params.code));
       try {
@@ -3404,9 +3889,9 @@ read_only::abi_json_to_bin_result read_only::abi_json_to_bin( const read_only::a
 read_only::abi_bin_to_json_result read_only::abi_bin_to_json( const read_only::abi_bin_to_json_params& params )const {
    abi_bin_to_json_result result;
    const auto& code_account = db.db().get<account_object,by_name>( params.code );
-   abi_def abi;
-   if( abi_serializer::to_abi(code_account.abi, abi) ) {
-      abi_serializer abis( abi, abi_serializer::create_yield_function( abi_serializer_max_time ) );
+   const auto cached = chain_apis::get_cached_abi( db, abi_cache, code_account, abi_serializer_max_time );
+   if( cached->has_abi ) {
+      const abi_serializer& abis = cached->serializer;
       result.args = abis.binary_to_variant( abis.get_action_type( params.action ), params.binargs, abi_serializer::create_yield_function( abi_serializer_max_time ), shorten_abi_errors );
    } else {
       EOS_ASSERT(false, abi_not_found_exception, "No ABI found for ${contract}", ("contract", params.code));
@@ -3416,14 +3901,17 @@ read_only::abi_bin_to_json_result read_only::abi_bin_to_json( const read_only::a
 
 read_only::get_required_keys_result read_only::get_required_keys( const get_required_keys_params& params )const {
    transaction pretty_input;
-   auto resolver = make_resolver(this, abi_serializer::create_yield_function( abi_serializer_max_time ));
+   auto resolver = make_resolver(this);
    try {
       abi_serializer::from_variant(params.transaction, pretty_input, resolver, abi_serializer::create_yield_function( abi_serializer_max_time ));
    } EOS_RETHROW_EXCEPTIONS(chain::transaction_type_exception, "Invalid transaction")
 
-   auto required_keys_set = db.get_authorization_manager().get_required_keys( pretty_input, params.available_keys, fc::seconds( pretty_input.delay_sec ));
    get_required_keys_result result;
-   result.required_keys = required_keys_set;
+   if( aqdb.has_value() ) {
+      result.required_keys = aqdb->get_required_keys( pretty_input, params.available_keys, fc::seconds( pretty_input.delay_sec ));
+   } else {
+      result.required_keys = db.get_authorization_manager().get_required_keys( pretty_input, params.available_keys, fc::seconds( pretty_input.delay_sec ));
+   }
    return result;
 }
 
@@ -3463,10 +3951,8 @@ chain::symbol read_only::extract_core_symbol()const {
 
 fc::variant read_only::get_primary_key(name code, name scope, name table, uint64_t primary_key, row_requirements require_table,
                                        row_requirements require_primary, const std::string_view& type, bool as_json) const {
-   const abi_def abi = eosio::chain_apis::get_abi(db, code);
-   abi_serializer abis;
-   abis.set_abi(abi, abi_serializer::create_yield_function(abi_serializer_max_time));
-   return get_primary_key(code, scope, table, primary_key, require_table, require_primary, type, abis, as_json);
+   const auto cached = get_cached_abi(code);
+   return get_primary_key(code, scope, table, primary_key, require_table, require_primary, type, cached->serializer, as_json);
 }
 
 fc::variant read_only::get_primary_key(name code, name scope, name table, uint64_t primary_key, row_requirements require_table,
@@ -0,0 +1,114 @@
+#include <eosio/chain_plugin/deep_mind_framed_writer.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <fc/log/logger_config.hpp>
+#include <fc/variant.hpp>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace eosio {
+
+   namespace {
+      constexpr size_t write_size = 1024 * 1024; ///< frames are written once this many bytes are buffered
+
+      uint64_t ring_capacity( uint32_t capacity ) {
+         uint64_t c = 1;
+         while( c < capacity ) c <<= 1;
+         return c;
+      }
+   }
+
+   deep_mind_framed_writer::deep_mind_framed_writer( const std::string& output, uint32_t capacity,
+                                                     std::function<void(const std::string&)> on_error )
+   : _ring( ring_capacity( capacity ) )
+   , _mask( _ring.size() - 1 )
+   , _on_error( std::move( on_error ) )
+   {
+      if( output == "-" ) {
+         _fd = STDOUT_FILENO;
+      } else {
+         // opening a FIFO waits for its reader
+         _fd = ::open( output.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644 );
+         EOS_ASSERT( _fd >= 0, chain::plugin_config_exception, "Unable to open deep mind output ${o}: ${e}",
+                     ("o", output)("e", std::strerror( errno )) );
+         _close_fd = true;
+      }
+      _buffer.reserve( write_size + 4096 );
+      _thread = std::thread( [this]() {
+         fc::set_os_thread_name( "dmlog" );
+         run();
+      } );
+   }
+
+   deep_mind_framed_writer::~deep_mind_framed_writer() {
+      stop();
+      if( _close_fd ) ::close( _fd );
+   }
+
+   void deep_mind_framed_writer::log( const fc::log_message& m ) {
+      if( _stopping.load( std::memory_order_relaxed ) ) return;
+      const uint64_t head = _head.load( std::memory_order_relaxed );
+      if( head - _tail.load( std::memory_order_acquire ) > _mask ) {
+         _full_waits.fetch_add( 1, std::memory_order_relaxed );
+         while( head - _tail.load( std::memory_order_acquire ) > _mask ) {
+            if( _failed.load( std::memory_order_relaxed ) ) return;
+            std::this_thread::yield();
+         }
+      }
+      _ring[head & _mask] = m;
+      _head.store( head + 1, std::memory_order_release );
+   }
+
+   void deep_mind_framed_writer::stop() {
+      if( _stopping.exchange( true ) ) return;
+      if( _thread.joinable() ) _thread.join();
+   }
+
+   void deep_mind_framed_writer::run() {
+      while( true ) {
+         uint64_t tail = _tail.load( std::memory_order_relaxed );
+         const uint64_t head = _head.load( std::memory_order_acquire );
+         if( tail == head ) {
+            write_buffer();
+            if( _stopping.load( std::memory_order_acquire ) && _head.load( std::memory_order_acquire ) == tail )
+               return;
+            std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+            continue;
+         }
+         for( ; tail != head; ++tail ) {
+            fc::log_message m = std::move( _ring[tail & _mask] );
+            _ring[tail & _mask] = fc::log_message();
+            _tail.store( tail + 1, std::memory_order_release );
+            if( _failed.load( std::memory_order_relaxed ) ) continue;
+
+            const std::string event = fc::format_string( m.get_format(), m.get_data() );
+            const uint32_t size = event.size();
+            const char prefix[4] = { char( size & 0xff ), char( ( size >> 8 ) & 0xff ),
+                                     char( ( size >> 16 ) & 0xff ), char( ( size >> 24 ) & 0xff ) };
+            _buffer.append( prefix, sizeof( prefix ) );
+            _buffer.append( event );
+            if( _buffer.size() >= write_size ) write_buffer();
+         }
+      }
+   }
+
+   void deep_mind_framed_writer::write_buffer() {
+      size_t written = 0;
+      while( written < _buffer.size() && !_failed.load( std::memory_order_relaxed ) ) {
+         const auto n = ::write( _fd, _buffer.data() + written, _buffer.size() - written );
+         if( n < 0 ) {
+            const int err = errno;
+            if( err == EINTR || err == EAGAIN ) continue;
+            _failed = true;
+            if( _on_error ) _on_error( std::string( "deep mind write failed: " ) + std::strerror( err ) );
+         } else {
+            written += n;
+         }
+      }
+      _buffer.clear();
+   }
+}
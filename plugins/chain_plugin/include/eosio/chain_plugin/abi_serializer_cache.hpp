@@ -0,0 +1,64 @@
+#pragma once
+#include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/account_object.hpp>
+#include <eosio/chain/trace.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace eosio::chain_apis {
+   /**
+    * The abi of an account together with the serializer constructed from it
+    */
+   struct cached_abi {
+      chain::abi_def          abi;
+      chain::abi_serializer   serializer;
+      bool                    has_abi = false; ///< false when the account has no abi, abi is then empty
+   };
+   using cached_abi_ptr = std::shared_ptr<const cached_abi>;
+
+   /**
+    * Serializers of account abis shared by the read only APIs so the abi of a contract is unpacked and compiled
+    * once instead of on every call. Entries are keyed by account and the abi_sequence of the account; they are
+    * dropped when a setabi of the account is applied, which also covers a setabi of a fork reusing the sequence.
+    * All methods may be called from any thread.
+    */
+   class abi_serializer_cache {
+   public:
+      /**
+       * @param max_entries - accounts kept, the least recently used is dropped beyond that
+       */
+      explicit abi_serializer_cache( size_t max_entries );
+
+      /**
+       * @return the abi of account, constructed and cached when not cached for its current abi_sequence
+       */
+      cached_abi_ptr get( const chain::controller& db, const chain::account_object& account,
+                          const fc::microseconds& abi_serializer_max_time );
+
+      /**
+       * Drop the accounts of the setabi actions of an applied transaction
+       */
+      void invalidate( const chain::transaction_trace_ptr& trace );
+
+      void erase( const chain::name& account );
+      void clear();
+      size_t size()const;
+
+      /// abi of account without using a cache
+      static cached_abi_ptr make( const chain::account_object& account, const fc::microseconds& abi_serializer_max_time );
+
+   private:
+      struct entry {
+         uint64_t         abi_sequence = 0;
+         uint64_t         last_used = 0;
+         cached_abi_ptr   abi;
+      };
+
+      const size_t                     max_entries;
+      mutable std::mutex               mtx;
+      std::map<chain::name, entry>     entries;
+      uint64_t                         use_count = 0;
+   };
+}
@@ -81,6 +81,20 @@ namespace eosio::chain_apis {
        */
       get_accounts_by_authorizers_result get_accounts_by_authorizers( const get_accounts_by_authorizers_params& args) const;
 
+      /**
+       * Determine the subset of candidate keys required to satisfy the declared authorizations of a transaction.
+       * Permissions are resolved from the ephemeral indices instead of the chain state, so the result reflects the
+       * last committed block rather than the pending one.
+       *
+       * @param trx - the transaction whose declared authorizations must be satisfied
+       * @param candidate_keys - the keys available to sign the transaction
+       * @param provided_delay - the delay of the transaction
+       * @return the candidate keys used to satisfy the authorizations
+       */
+      chain::flat_set<chain::public_key_type> get_required_keys( const chain::transaction& trx,
+                                                                 const chain::flat_set<chain::public_key_type>& candidate_keys,
+                                                                 fc::microseconds provided_delay ) const;
+
    private:
       std::unique_ptr<struct account_query_db_impl> _impl;
    };
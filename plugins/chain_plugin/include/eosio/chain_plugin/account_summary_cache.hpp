@@ -0,0 +1,59 @@
+#pragma once
+#include <eosio/chain_plugin/chain_plugin.hpp>
+
+#include <map>
+#include <mutex>
+
+namespace eosio::chain_apis {
+   /**
+    * get_account results of the current chain state, so an account polled over and over is looked up once per
+    * block. Resource limits decay with the head block time and a system contract action can update the rows of
+    * accounts it is not authorized by, so rather than tracking the accounts written the results are kept for one
+    * state: a head block, a chainbase revision and no transaction applied or block started since.
+    * All methods may be called from any thread.
+    */
+   class account_summary_cache {
+   public:
+      /**
+       * @param max_entries - accounts kept, the least recently used is dropped beyond that
+       */
+      explicit account_summary_cache( size_t max_entries );
+
+      /// the state get and put are called with, read where the chain state does not change
+      struct state_version {
+         chain::block_id_type  head_id;
+         int64_t               revision = 0;
+         uint64_t              generation = 0;
+
+         friend bool operator==( const state_version& a, const state_version& b ) {
+            return std::tie( a.head_id, a.revision, a.generation ) == std::tie( b.head_id, b.revision, b.generation );
+         }
+         friend bool operator!=( const state_version& a, const state_version& b ) { return !( a == b ); }
+      };
+
+      state_version version( const chain::controller& db )const;
+
+      std::optional<read_only::get_account_results> get( const read_only::get_account_params& params, const state_version& v );
+      void put( const read_only::get_account_params& params, const state_version& v, const read_only::get_account_results& result );
+
+      /// the chain state changed without the head block or revision changing
+      void invalidate();
+
+   private:
+      using key_type = std::pair<chain::name, uint64_t>; // account, expected core symbol or 0
+
+      struct entry {
+         read_only::get_account_results  result;
+         uint64_t                        last_used = 0;
+      };
+
+      static key_type make_key( const read_only::get_account_params& params );
+
+      const size_t                     max_entries;
+      mutable std::mutex               mtx;
+      std::map<key_type, entry>        entries;
+      state_version                    entries_version;
+      uint64_t                         generation = 0;
+      uint64_t                         use_count = 0;
+   };
+}
@@ -23,8 +23,12 @@
 #include <boost/multiprecision/cpp_int.hpp>
 
 #include <eosio/chain_plugin/account_query_db.hpp>
+#include <eosio/chain_plugin/abi_serializer_cache.hpp>
+#include <eosio/chain_plugin/read_only_api_executor.hpp>
+#include <eosio/chain_plugin/rendered_block_cache.hpp>
 
 #include <fc/static_variant.hpp>
+#include <fc/io/json.hpp>
 #include <eosio/blockvault_client_plugin/blockvault_client_plugin.hpp>
 
 namespace fc { class variant; }
@@ -98,21 +102,35 @@ private:
    fc::time_point end_time_;
 };
 
+class account_summary_cache;
+
 class read_only {
    const controller& db;
    const std::optional<account_query_db>& aqdb;
    const fc::microseconds abi_serializer_max_time;
+   abi_serializer_cache*  abi_cache = nullptr;
+   rendered_block_cache*  block_cache = nullptr;
+   account_summary_cache* account_cache = nullptr;
    bool  shorten_abi_errors = true;
+   bool  table_rows_json_text = false;
 
 public:
    static const string KEYi64;
 
-   read_only(const controller& db, const std::optional<account_query_db>& aqdb, const fc::microseconds& abi_serializer_max_time)
-      : db(db), aqdb(aqdb), abi_serializer_max_time(abi_serializer_max_time) {}
+   read_only(const controller& db, const std::optional<account_query_db>& aqdb, const fc::microseconds& abi_serializer_max_time,
+             abi_serializer_cache* abi_cache = nullptr, rendered_block_cache* block_cache = nullptr,
+             account_summary_cache* account_cache = nullptr)
+      : db(db), aqdb(aqdb), abi_serializer_max_time(abi_serializer_max_time), abi_cache(abi_cache), block_cache(block_cache),
+        account_cache(account_cache) {}
    
    void validate() const {}
 
    void set_shorten_abi_errors( bool f ) { shorten_abi_errors = f; }
+   /// get_table_rows writes each row as JSON text straight from its binary, see get_table_rows_result::to_json
+   void set_table_rows_json_text( bool f ) { table_rows_json_text = f; }
+
+   /// abi of account from the abi cache when there is one, throws account_query_exception if account does not exist
+   cached_abi_ptr get_cached_abi( const name& account )const;
 
    using get_info_params = empty;
 
@@ -209,7 +227,9 @@ public:
       name                  account_name;
       std::optional<symbol> expected_core_symbol;
    };
+   /// from the account summary cache when there is one and the chain state did not change since it was read
    get_account_results get_account( const get_account_params& params )const;
+   get_account_results read_account( const get_account_params& params )const;
 
 
    struct get_code_results {
@@ -319,12 +339,35 @@ public:
 
    fc::variant get_block(const get_block_params& params) const;
 
+   struct get_block_json_result {
+      rendered_block_cache::json_ptr json;
+      string                         etag; ///< empty when there is no block cache
+   };
+
+   /// get_block rendered as JSON, from the block cache when there is one
+   get_block_json_result get_block_json(const get_block_params& params) const;
+
+   using get_block_cache_metrics_params = empty;
+   using get_block_cache_metrics_result = rendered_block_cache::metrics;
+
+   get_block_cache_metrics_result get_block_cache_metrics(const get_block_cache_metrics_params&) const;
+
    struct get_block_info_params {
       uint32_t block_num;
    };
 
    fc::variant get_block_info(const get_block_info_params& params) const;
 
+   struct get_transaction_block_num_params {
+      transaction_id_type id;
+   };
+
+   struct get_transaction_block_num_result {
+      std::optional<uint32_t> block_num; ///< not set if the transaction is not in an irreversible block
+   };
+
+   get_transaction_block_num_result get_transaction_block_num(const get_transaction_block_num_params& params) const;
+
    struct get_block_header_state_params {
       string block_num_or_id;
    };
@@ -345,6 +388,7 @@ public:
       string               encode_type{"dec"}; //dec, hex , default=dec
       std::optional<bool>  reverse;
       std::optional<bool>  show_payer; // show RAM pyer
+      std::optional<string> cursor; // next_cursor of the previous page, resumes at its exact row instead of lower_bound (upper_bound when reverse)
     };
 
    struct get_kv_table_rows_params {
@@ -366,6 +410,25 @@ public:
       bool                more = false; ///< true if last element in data is not the end and sizeof data() < limit
       string              next_key; ///< fill lower_bound with this value to fetch more rows
       string              next_key_bytes; ///< fill lower_bound with this value to fetch more rows with encode-type of "bytes"
+      string              next_cursor; ///< fill cursor with this value to fetch more rows starting exactly at the next row
+      bool                rows_json_text = false; ///< each of rows is a string holding the JSON text of the row
+
+      /// JSON of the result as fc::json::to_string would write it, copying rows_json_text rows as they are
+      std::string to_json()const;
+   };
+
+   /**
+    * Position of a get_table_rows walk, handed to clients hex encoded as next_cursor. Unlike next_key it holds the
+    * primary key too, so a page of a secondary index resumes at the exact row even when several rows share the
+    * secondary key of the last page boundary.
+    */
+   struct table_rows_cursor {
+      name        code;
+      name        scope;
+      name        index_table;      ///< table with index of the walked index
+      bool        reverse = false;
+      bytes       secondary_key;    ///< secondary key of the next row, empty for the primary index
+      uint64_t    primary_key = 0;  ///< primary key of the next row
    };
 
    get_table_rows_result get_table_rows( const get_table_rows_params& params )const;
@@ -534,7 +597,7 @@ public:
                                bool as_json = true) const;
 
    auto get_primary_key_value(const std::string_view& type, const abi_serializer& abis, bool as_json = true) const {
-      return [table_type=std::string{type},abis,as_json,this](fc::variant& result_var, const auto& obj) {
+      return [table_type=std::string{type},&abis,as_json,this](fc::variant& result_var, const auto& obj) {
          vector<char> data;
          read_only::copy_inline_row(obj, data);
          if (as_json) {
@@ -554,7 +617,27 @@ public:
    }
 
    auto get_primary_key_value(name table, const abi_serializer& abis, bool as_json, const std::optional<bool>& show_payer) const {
-      return [abis,table,show_payer,as_json,this](const auto& obj) -> fc::variant {
+      return [&abis,table,show_payer,as_json,this](const auto& obj) -> fc::variant {
+         if( table_rows_json_text ) {
+            std::string json;
+            const bool with_payer = show_payer && *show_payer;
+            if( with_payer ) json += "{\"data\":";
+            if( as_json ) {
+               fc::datastream<const char*> ds( obj.value.data(), obj.value.size() );
+               abis.binary_to_json( abis.get_table_type(table), ds, json, abi_serializer::create_yield_function( abi_serializer_max_time ), shorten_abi_errors );
+            } else {
+               vector<char> data;
+               read_only::copy_inline_row(obj, data);
+               json += fc::json::to_string( fc::variant(data), fc::time_point::maximum() );
+            }
+            if( with_payer ) {
+               json += ",\"payer\":\"";
+               json += obj.payer.to_string();
+               json += "\"}";
+            }
+            return fc::variant( std::move(json) );
+         }
+
          fc::variant data_var;
          auto get_prim = get_primary_key_value(data_var, abis.get_table_type(table), abis, as_json);
          get_prim(obj);
@@ -635,18 +718,42 @@ public:
 
    static uint64_t get_table_index_name(const read_only::get_table_rows_params& p, bool& primary);
 
+   static string encode_table_rows_cursor(const table_rows_cursor& c);
+   /// cursor of p, which must come from a walk of the same index in the same direction
+   static table_rows_cursor decode_table_rows_cursor(const read_only::get_table_rows_params& p, name scope, name index_table, bool reverse);
+
+   template<typename Key>
+   static string make_table_rows_cursor(table_rows_cursor c, const Key& secondary_key, uint64_t primary_key) {
+      static_assert( std::is_trivially_copyable_v<Key> );
+      c.secondary_key.resize( sizeof(Key) );
+      memcpy( c.secondary_key.data(), &secondary_key, sizeof(Key) );
+      c.primary_key = primary_key;
+      return encode_table_rows_cursor( c );
+   }
+
+   template<typename Key>
+   static Key table_rows_cursor_key(const table_rows_cursor& c) {
+      static_assert( std::is_trivially_copyable_v<Key> );
+      EOS_ASSERT( c.secondary_key.size() == sizeof(Key), chain::contract_table_query_exception, "Invalid cursor for key type" );
+      Key k;
+      memcpy( &k, c.secondary_key.data(), sizeof(Key) );
+      return k;
+   }
+
 
    template<typename Index, typename Function>
    struct secondary_key_receiver
    : chain::backing_store::single_type_error_receiver<secondary_key_receiver<Index, Function>, chain::backing_store::secondary_index_view<Index>, chain::contract_table_query_exception> {
-      secondary_key_receiver(read_only::get_table_rows_result& result, Function f, const read_only::get_table_rows_params& params)
-      : result_(result), f_(f), params_(params) {}
+      secondary_key_receiver(read_only::get_table_rows_result& result, Function f, const read_only::get_table_rows_params& params,
+                             const table_rows_cursor& cursor)
+      : result_(result), f_(f), params_(params), cursor_(cursor) {}
 
       void add_only_row(const chain::backing_store::secondary_index_view<Index>& row) {
          // needs to allow a second pass after limit is reached or time has passed, to allow "more" processing
          if (reached_limit_ || !kp_()) {
             result_.more = true;
             result_.next_key = convert_to_string(row.secondary_key, params_.key_type, params_.encode_type, "next_key - next lower bound");
+            result_.next_cursor = make_table_rows_cursor(cursor_, row.secondary_key, row.primary_key);
             done_ = true;
          }
          else {
@@ -668,6 +775,7 @@ public:
       read_only::get_table_rows_result& result_;
       Function f_;
       const read_only::get_table_rows_params& params_;
+      const table_rows_cursor& cursor_;
       bool reached_limit_ = false;
       bool done_ = false;
       keep_processing kp_;
@@ -675,22 +783,21 @@ public:
 
 
    template <typename IndexType, typename SecKeyType, typename ConvFn>
-   read_only::get_table_rows_result get_table_rows_by_seckey( const read_only::get_table_rows_params& p, const abi_def& abi, ConvFn conv )const {
+   read_only::get_table_rows_result get_table_rows_by_seckey( const read_only::get_table_rows_params& p, const abi_serializer& abis, ConvFn conv )const {
       read_only::get_table_rows_result result;
+      result.rows_json_text = table_rows_json_text;
       const auto& d = db.db();
 
       name scope{ convert_to_type<uint64_t>(p.scope, "scope") };
 
-      abi_serializer abis;
-      abis.set_abi(abi, abi_serializer::create_yield_function( abi_serializer_max_time ) );
       bool primary = false;
       const uint64_t table_with_index = get_table_index_name(p, primary);
       using secondary_key_type = std::result_of_t<decltype(conv)(SecKeyType)>;
       static_assert( std::is_same<typename IndexType::value_type::secondary_key_type, secondary_key_type>::value, "Return type of conv does not match type of secondary key for IndexType" );
       auto secondary_key_lower = eosio::chain::secondary_key_traits<secondary_key_type>::true_lowest();
-      const auto primary_key_lower = std::numeric_limits<uint64_t>::lowest();
+      auto primary_key_lower = std::numeric_limits<uint64_t>::lowest();
       auto secondary_key_upper = eosio::chain::secondary_key_traits<secondary_key_type>::true_highest();
-      const auto primary_key_upper = std::numeric_limits<uint64_t>::max();
+      auto primary_key_upper = std::numeric_limits<uint64_t>::max();
       if( p.lower_bound.size() ) {
          if( p.key_type == "name" ) {
             if constexpr (std::is_same_v<uint64_t, SecKeyType>) {
@@ -718,10 +825,24 @@ public:
             secondary_key_upper = conv( uv );
          }
       }
+
+      const bool reverse = p.reverse && *p.reverse;
+      const table_rows_cursor cursor_base{ p.code, scope, name(table_with_index), reverse };
+      const bool resume = p.cursor && !p.cursor->empty();
+      if( resume ) {
+         auto cursor = decode_table_rows_cursor(p, scope, name(table_with_index), reverse);
+         if( reverse ) {
+            secondary_key_upper = table_rows_cursor_key<secondary_key_type>(cursor);
+            primary_key_upper = cursor.primary_key;
+         } else {
+            secondary_key_lower = table_rows_cursor_key<secondary_key_type>(cursor);
+            primary_key_lower = cursor.primary_key;
+         }
+      }
+
       if( secondary_key_upper < secondary_key_lower )
          return result;
 
-      const bool reverse = p.reverse && *p.reverse;
       const auto db_backing_store = get_backing_store();
       auto get_prim_key_val = get_primary_key_value(p.table, abis, p.json, p.show_payer);
       if (db_backing_store == eosio::chain::backing_store_type::CHAINBASE) {
@@ -751,6 +872,7 @@ public:
                if( itr != end_itr ) {
                   result.more = true;
                   result.next_key = convert_to_string(itr->secondary_key, p.key_type, p.encode_type, "next_key - next lower bound");
+                  result.next_cursor = make_table_rows_cursor(cursor_base, itr->secondary_key, itr->primary_key);
                }
             };
 
@@ -771,6 +893,14 @@ public:
          const auto context = (reverse) ? backing_store::key_context::standalone_reverse : backing_store::key_context::standalone;
          auto lower = chain::backing_store::db_key_value_format::create_full_prefix_secondary_key(p.code, scope, name(table_with_index), secondary_key_lower);
          auto upper = chain::backing_store::db_key_value_format::create_full_prefix_secondary_key(p.code, scope, name(table_with_index), secondary_key_upper);
+         if (resume) {
+            // resume at the exact row of the cursor
+            if (reverse) {
+               upper = chain::backing_store::db_key_value_format::create_full_secondary_key(p.code, scope, name(table_with_index), secondary_key_upper, primary_key_upper);
+            } else {
+               lower = chain::backing_store::db_key_value_format::create_full_secondary_key(p.code, scope, name(table_with_index), secondary_key_lower, primary_key_lower);
+            }
+         }
          if (reverse) {
             lower = eosio::session::shared_bytes::truncate_key(lower);
          }
@@ -787,7 +917,7 @@ public:
             rows.emplace_back(get_prim_key_val(chain::backing_store::primary_index_view::create(row.primary_key, value->data(), value->size())));
          };
          using secondary_receiver = secondary_key_receiver<secondary_key_type, decltype(get_primary)>;
-         secondary_receiver receiver(result, get_primary, p);
+         secondary_receiver receiver(result, get_primary, p, cursor_base);
          auto kp = receiver.keep_processing_entries();
          backing_store::rocksdb_contract_db_table_writer<secondary_receiver, std::decay_t < decltype(kp)>> writer(receiver, context, kp);
          eosio::chain::backing_store::walk_rocksdb_entries_with_prefix(kv_database.get_kv_undo_stack(), lower, upper, writer);
@@ -797,15 +927,13 @@ public:
    }
 
    template <typename IndexType>
-   read_only::get_table_rows_result get_table_rows_ex( const read_only::get_table_rows_params& p, const abi_def& abi )const {
+   read_only::get_table_rows_result get_table_rows_ex( const read_only::get_table_rows_params& p, const abi_serializer& abis )const {
       read_only::get_table_rows_result result;
+      result.rows_json_text = table_rows_json_text;
       const auto& d = db.db();
 
       name scope { convert_to_type<uint64_t>(p.scope, "scope") };
 
-      abi_serializer abis;
-      abis.set_abi(abi, abi_serializer::create_yield_function( abi_serializer_max_time ));
-
       auto primary_lower = std::numeric_limits<uint64_t>::lowest();
       auto primary_upper = std::numeric_limits<uint64_t>::max();
 
@@ -829,16 +957,30 @@ public:
          }
       }
 
+      const bool reverse = p.reverse && *p.reverse;
+      const table_rows_cursor cursor_base{ p.code, scope, p.table, reverse };
+      if( p.cursor && !p.cursor->empty() ) {
+         auto cursor = decode_table_rows_cursor(p, scope, p.table, reverse);
+         EOS_ASSERT( cursor.secondary_key.empty(), chain::contract_table_query_exception, "Invalid cursor for the primary index" );
+         if( reverse ) {
+            primary_upper = cursor.primary_key;
+         } else {
+            primary_lower = cursor.primary_key;
+         }
+      }
+
       if( primary_upper < primary_lower )
          return result;
 
       auto get_prim_key = get_primary_key_value(p.table, abis, p.json, p.show_payer);
-      auto handle_more = [&result,&p](const auto& row) {
+      auto handle_more = [&result,&p,&cursor_base](const auto& row) {
          result.more = true;
          result.next_key = convert_to_string(row.primary_key, p.key_type, p.encode_type, "next_key - next lower bound");
+         auto cursor = cursor_base;
+         cursor.primary_key = row.primary_key;
+         result.next_cursor = encode_table_rows_cursor(cursor);
       };
 
-      const bool reverse = p.reverse && *p.reverse;
       const auto db_backing_store = get_backing_store();
       if (db_backing_store == eosio::chain::backing_store_type::CHAINBASE) {
          const auto* t_id = d.find<chain::table_id_object, chain::by_code_scope_table>(boost::make_tuple(p.code, scope, p.table));
@@ -917,8 +1059,10 @@ class read_write {
    controller& db;
    const fc::microseconds abi_serializer_max_time;
    const bool api_accept_transactions;
+   abi_serializer_cache* abi_cache = nullptr;
 public:
-   read_write(controller& db, const fc::microseconds& abi_serializer_max_time, bool api_accept_transactions);
+   read_write(controller& db, const fc::microseconds& abi_serializer_max_time, bool api_accept_transactions,
+              abi_serializer_cache* abi_cache = nullptr);
    void validate() const;
 
    using push_block_params = chain::signed_block_v0;
@@ -941,6 +1085,10 @@ public:
    using send_transaction_results = push_transaction_results;
    void send_transaction(const send_transaction_params& params, chain::plugin_interface::next_function<send_transaction_results> next);
 
+   using send_read_only_transaction_params = push_transaction_params;
+   using send_read_only_transaction_results = push_transaction_results;
+   void send_read_only_transaction(const send_read_only_transaction_params& params, chain::plugin_interface::next_function<send_read_only_transaction_results> next);
+
    friend resolver_factory<read_write>;
 };
 
@@ -1029,11 +1177,12 @@ public:
    void plugin_shutdown();
    void handle_sighup() override;
 
-   chain_apis::read_write get_read_write_api() { return chain_apis::read_write(chain(), get_abi_serializer_max_time(), api_accept_transactions()); }
+   chain_apis::read_write get_read_write_api() { return chain_apis::read_write(chain(), get_abi_serializer_max_time(), api_accept_transactions(), get_abi_serializer_cache()); }
    chain_apis::read_only get_read_only_api() const;
    
    bool accept_block( const chain::signed_block_ptr& block, const chain::block_id_type& id );
-   void accept_transaction(const chain::packed_transaction_ptr& trx, chain::plugin_interface::next_function<chain::transaction_trace_ptr> next);
+   void accept_transaction(const chain::packed_transaction_ptr& trx, chain::plugin_interface::next_function<chain::transaction_trace_ptr> next,
+                           chain::plugin_interface::transaction_source source = chain::plugin_interface::api_transaction_source);
 
    static bool recover_reversible_blocks( const fc::path& db_dir,
                                           uint32_t cache_size,
@@ -1069,6 +1218,18 @@ public:
    static void handle_bad_alloc();
    
    bool account_queries_enabled() const;
+
+   /// abis shared by the read only and read write APIs, nullptr when api-abi-cache-size is 0
+   chain_apis::abi_serializer_cache* get_abi_serializer_cache() const;
+
+   /// runs the state reading APIs in parallel, nullptr when read-only-api-threads is 0 and they run on the main thread
+   chain_apis::read_only_api_executor* get_read_only_api_executor() const;
+
+   /// rendered get_block responses, nullptr when api-block-cache-size is 0
+   chain_apis::rendered_block_cache* get_rendered_block_cache() const;
+
+   /// get_account results of the current chain state, nullptr when api-account-cache-size is 0
+   chain_apis::account_summary_cache* get_account_summary_cache() const;
 private:
    static void log_guard_exception(const chain::guard_exception& e);
 
@@ -1089,13 +1250,16 @@ FC_REFLECT(eosio::chain_apis::read_only::get_activated_protocol_features_params,
 FC_REFLECT(eosio::chain_apis::read_only::get_activated_protocol_features_results, (activated_protocol_features)(more) )
 FC_REFLECT(eosio::chain_apis::read_only::get_block_params, (block_num_or_id))
 FC_REFLECT(eosio::chain_apis::read_only::get_block_info_params, (block_num))
+FC_REFLECT(eosio::chain_apis::read_only::get_transaction_block_num_params, (id))
+FC_REFLECT(eosio::chain_apis::read_only::get_transaction_block_num_result, (block_num))
 FC_REFLECT(eosio::chain_apis::read_only::get_block_header_state_params, (block_num_or_id))
 
 FC_REFLECT( eosio::chain_apis::read_write::push_transaction_results, (transaction_id)(processed) )
 
-FC_REFLECT( eosio::chain_apis::read_only::get_table_rows_params, (json)(code)(scope)(table)(table_key)(lower_bound)(upper_bound)(limit)(key_type)(index_position)(encode_type)(reverse)(show_payer) )
+FC_REFLECT( eosio::chain_apis::read_only::get_table_rows_params, (json)(code)(scope)(table)(table_key)(lower_bound)(upper_bound)(limit)(key_type)(index_position)(encode_type)(reverse)(show_payer)(cursor) )
 FC_REFLECT( eosio::chain_apis::read_only::get_kv_table_rows_params, (json)(code)(table)(index_name)(encode_type)(index_value)(lower_bound)(upper_bound)(limit)(reverse)(show_payer) )
-FC_REFLECT( eosio::chain_apis::read_only::get_table_rows_result, (rows)(more)(next_key)(next_key_bytes) );
+FC_REFLECT( eosio::chain_apis::read_only::get_table_rows_result, (rows)(more)(next_key)(next_key_bytes)(next_cursor) );
+FC_REFLECT( eosio::chain_apis::read_only::table_rows_cursor, (code)(scope)(index_table)(reverse)(secondary_key)(primary_key) )
 
 FC_REFLECT( eosio::chain_apis::read_only::get_table_by_scope_params, (code)(table)(lower_bound)(upper_bound)(limit)(reverse) )
 FC_REFLECT( eosio::chain_apis::read_only::get_table_by_scope_result_row, (code)(scope)(table)(payer)(count));
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <fc/log/appender.hpp>
+#include <fc/log/log_message.hpp>
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace eosio {
+   /**
+    * Deep mind appender writing each event as a frame: its length as a 4 byte little endian integer followed by the
+    * event, the text of a deep mind line without the "DMLOG " prefix and the newline.
+    *
+    * log() only moves the event into a lock free single producer ring buffer, it must be called from one thread at
+    * a time, as the controller does on the main thread. A dedicated thread formats the events and writes the frames
+    * in large writes to a file, FIFO or stdout. When the ring buffer is full, log() waits for the writer: events are
+    * never dropped.
+    */
+   class deep_mind_framed_writer : public fc::appender {
+   public:
+      /**
+       * @param output - file or FIFO the frames are appended to, "-" for stdout
+       * @param capacity - events buffered, rounded up to a power of 2
+       * @param on_error - called once, on the writer thread, when a write fails; later events are dropped
+       */
+      deep_mind_framed_writer( const std::string& output, uint32_t capacity, std::function<void(const std::string&)> on_error );
+
+      // calls stop()
+      ~deep_mind_framed_writer();
+
+      void initialize( boost::asio::io_service& ) override {}
+
+      void log( const fc::log_message& m ) override;
+
+      /// write the buffered events and join the writer thread, events logged afterwards are dropped
+      void stop();
+
+      /// times log() waited for the writer because the ring buffer was full
+      uint64_t full_waits()const { return _full_waits.load( std::memory_order_relaxed ); }
+
+   private:
+      void run();
+      void write_buffer();
+
+      std::vector<fc::log_message>             _ring;
+      const uint64_t                           _mask;
+      alignas(64) std::atomic<uint64_t>        _head{0}; ///< next event logged, written by log()
+      alignas(64) std::atomic<uint64_t>        _tail{0}; ///< next event written, written by the writer thread
+      std::atomic<bool>                        _stopping{false};
+      std::atomic<bool>                        _failed{false};
+      std::atomic<uint64_t>                    _full_waits{0};
+      int                                      _fd = -1;
+      bool                                     _close_fd = false;
+      std::string                              _buffer;
+      std::function<void(const std::string&)>  _on_error;
+      std::thread                              _thread;
+   };
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <eosio/chain/thread_utils.hpp>
+
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace eosio::chain_apis {
+   /**
+    * Runs read only API calls on a thread pool in windows during which the main thread waits, so the calls read the
+    * chain state left by the last main thread task without it being modified under them.
+    *
+    * Posted calls are queued until the main thread runs a window: all calls queued at that point are run in parallel
+    * and the window returns once the last of them has completed. A single window is scheduled for the calls queued
+    * before it runs.
+    */
+   class read_only_api_executor {
+   public:
+      /**
+       * @param num_threads - threads running the calls of a window
+       * @param schedule_window - called with the task running a window, which it must run on the main thread
+       */
+      read_only_api_executor( uint16_t num_threads, std::function<void(std::function<void()>)> schedule_window );
+
+      // calls stop()
+      ~read_only_api_executor();
+
+      /// queue call to run in the next window, may be called from any thread
+      void post( std::function<void()> call );
+
+      /// run the queued calls in parallel, returns when all of them have completed; called on the main thread
+      void run_window();
+
+      /// join the threads, calls queued or posted afterwards are dropped
+      void stop();
+
+      size_t queued()const;
+
+   private:
+      chain::named_thread_pool                              thread_pool;
+      std::function<void(std::function<void()>)>            schedule_window;
+      mutable std::mutex                                    mtx;
+      std::deque<std::function<void()>>                     queue;
+      bool                                                  window_scheduled = false;
+      bool                                                  stopped = false;
+   };
+}
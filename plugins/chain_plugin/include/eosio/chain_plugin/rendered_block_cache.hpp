@@ -0,0 +1,77 @@
+#pragma once
+#include <eosio/chain/types.hpp>
+#include <eosio/chain/trace.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace eosio::chain_apis {
+   /**
+    * JSON responses of get_block by block id, so the hot recent blocks requested over and over are fetched and
+    * rendered once. Action data is rendered with the abis current when the block is rendered, so all entries
+    * are dropped when a setabi is applied.
+    * All methods may be called from any thread.
+    */
+   class rendered_block_cache {
+   public:
+      using json_ptr = std::shared_ptr<const std::string>;
+
+      struct metrics {
+         uint32_t  entries = 0;
+         uint64_t  bytes = 0;
+         uint64_t  hits = 0;
+         uint64_t  misses = 0;
+         uint64_t  generation = 0; ///< number of times the entries were dropped for a setabi
+      };
+
+      /**
+       * @param max_entries - blocks kept, the least recently used is dropped beyond that
+       */
+      explicit rendered_block_cache( size_t max_entries );
+
+      struct rendered {
+         json_ptr      json;  ///< nullptr when not cached
+         std::string   etag;  ///< entity tag of the rendering, changes when the entries are dropped for a setabi
+      };
+
+      /// cached rendering of block id
+      rendered get( const chain::block_id_type& id );
+
+      /// generation to pass to put for a rendering starting now
+      uint64_t current_generation()const;
+
+      /**
+       * Cache json of block id unless the entries were dropped since generation
+       * @return the rendering of json
+       */
+      rendered put( const chain::block_id_type& id, json_ptr json, uint64_t generation );
+
+      /**
+       * Drop all entries when the applied transaction has a setabi action
+       */
+      void invalidate( const chain::transaction_trace_ptr& trace );
+      void clear();
+
+      metrics get_metrics()const;
+
+   private:
+      struct entry {
+         json_ptr   json;
+         uint64_t   last_used = 0;
+      };
+
+      static std::string make_etag( const chain::block_id_type& id, uint64_t generation );
+
+      const size_t                              max_entries;
+      mutable std::mutex                        mtx;
+      std::map<chain::block_id_type, entry>     entries;
+      uint64_t                                  use_count = 0;
+      uint64_t                                  bytes = 0;
+      uint64_t                                  hits = 0;
+      uint64_t                                  misses = 0;
+      uint64_t                                  generation = 0;
+   };
+}
+
+FC_REFLECT( eosio::chain_apis::rendered_block_cache::metrics, (entries)(bytes)(hits)(misses)(generation) )
@@ -0,0 +1,66 @@
+#include <eosio/chain_plugin/read_only_api_executor.hpp>
+
+#include <condition_variable>
+
+namespace eosio::chain_apis {
+
+   read_only_api_executor::read_only_api_executor( uint16_t num_threads, std::function<void(std::function<void()>)> schedule_window )
+   : thread_pool( "roapi", num_threads )
+   , schedule_window( std::move( schedule_window ) )
+   {}
+
+   read_only_api_executor::~read_only_api_executor() {
+      stop();
+   }
+
+   void read_only_api_executor::post( std::function<void()> call ) {
+      {
+         std::lock_guard<std::mutex> g( mtx );
+         if( stopped ) return;
+         queue.emplace_back( std::move( call ) );
+         if( std::exchange( window_scheduled, true ) ) return;
+      }
+      schedule_window( [this]() { run_window(); } );
+   }
+
+   void read_only_api_executor::run_window() {
+      std::deque<std::function<void()>> calls;
+      {
+         std::lock_guard<std::mutex> g( mtx );
+         if( stopped ) return;
+         calls.swap( queue );
+         window_scheduled = false;
+      }
+      if( calls.empty() ) return;
+
+      std::mutex done_mtx;
+      std::condition_variable done_cv;
+      size_t remaining = calls.size();
+      for( auto& c : calls ) {
+         boost::asio::post( thread_pool.get_executor(), [&done_mtx, &done_cv, &remaining, call{std::move( c )}]() {
+            try {
+               call();
+            } FC_LOG_AND_DROP();
+            std::lock_guard<std::mutex> g( done_mtx );
+            if( --remaining == 0 ) done_cv.notify_one();
+         } );
+      }
+
+      std::unique_lock<std::mutex> g( done_mtx );
+      done_cv.wait( g, [&remaining]() { return remaining == 0; } );
+   }
+
+   void read_only_api_executor::stop() {
+      {
+         std::lock_guard<std::mutex> g( mtx );
+         stopped = true;
+         queue.clear();
+      }
+      thread_pool.stop();
+   }
+
+   size_t read_only_api_executor::queued()const {
+      std::lock_guard<std::mutex> g( mtx );
+      return queue.size();
+   }
+}
@@ -0,0 +1,77 @@
+#include <eosio/chain_plugin/rendered_block_cache.hpp>
+
+#include <eosio/chain/config.hpp>
+
+namespace eosio::chain_apis {
+   using namespace eosio::chain;
+   using namespace eosio::chain::literals;
+
+   rendered_block_cache::rendered_block_cache( size_t max_entries )
+   : max_entries( max_entries )
+   {}
+
+   std::string rendered_block_cache::make_etag( const block_id_type& id, uint64_t generation ) {
+      return "\"" + id.str() + "." + std::to_string( generation ) + "\"";
+   }
+
+   rendered_block_cache::rendered rendered_block_cache::get( const block_id_type& id ) {
+      std::lock_guard<std::mutex> g( mtx );
+      auto itr = entries.find( id );
+      if( itr == entries.end() ) {
+         ++misses;
+         return {};
+      }
+      ++hits;
+      itr->second.last_used = ++use_count;
+      return { itr->second.json, make_etag( id, generation ) };
+   }
+
+   uint64_t rendered_block_cache::current_generation()const {
+      std::lock_guard<std::mutex> g( mtx );
+      return generation;
+   }
+
+   rendered_block_cache::rendered rendered_block_cache::put( const block_id_type& id, json_ptr json, uint64_t rendered_generation ) {
+      std::lock_guard<std::mutex> g( mtx );
+      if( rendered_generation != generation || max_entries == 0 ) {
+         // rendered with an abi replaced since
+         return { std::move( json ), make_etag( id, rendered_generation ) };
+      }
+      auto& e = entries[id];
+      if( e.json ) bytes -= e.json->size();
+      bytes += json->size();
+      e.json = json;
+      e.last_used = ++use_count;
+      if( entries.size() > max_entries ) {
+         auto lru = entries.begin();
+         for( auto itr = entries.begin(); itr != entries.end(); ++itr ) {
+            if( itr->second.last_used < lru->second.last_used ) lru = itr;
+         }
+         bytes -= lru->second.json->size();
+         entries.erase( lru );
+      }
+      return { std::move( json ), make_etag( id, generation ) };
+   }
+
+   void rendered_block_cache::invalidate( const transaction_trace_ptr& trace ) {
+      for( const auto& at : trace->action_traces ) {
+         if( at.receiver == config::system_account_name && at.act.account == config::system_account_name &&
+             at.act.name == "setabi"_n ) {
+            clear();
+            return;
+         }
+      }
+   }
+
+   void rendered_block_cache::clear() {
+      std::lock_guard<std::mutex> g( mtx );
+      entries.clear();
+      bytes = 0;
+      ++generation;
+   }
+
+   rendered_block_cache::metrics rendered_block_cache::get_metrics()const {
+      std::lock_guard<std::mutex> g( mtx );
+      return { static_cast<uint32_t>( entries.size() ), bytes, hits, misses, generation };
+   }
+}
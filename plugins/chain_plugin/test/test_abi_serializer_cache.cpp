@@ -0,0 +1,98 @@
+#define BOOST_TEST_MODULE abi_serializer_cache
+#include <boost/test/included/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/types.hpp>
+#include <eosio/chain_plugin/abi_serializer_cache.hpp>
+
+#ifdef NON_VALIDATING_TEST
+#define TESTER tester
+#else
+#define TESTER validating_tester
+#endif
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::testing;
+using namespace eosio::chain_apis;
+
+namespace {
+   const char* abi_v1 = R"({
+      "version": "eosio::abi/1.0",
+      "structs": [{"name": "hi", "base": "", "fields": [{"name": "user", "type": "name"}]}],
+      "actions": [{"name": "hi", "type": "hi", "ricardian_contract": ""}]
+   })";
+
+   const char* abi_v2 = R"({
+      "version": "eosio::abi/1.0",
+      "structs": [{"name": "bye", "base": "", "fields": [{"name": "user", "type": "name"}]}],
+      "actions": [{"name": "bye", "type": "bye", "ricardian_contract": ""}]
+   })";
+
+   const fc::microseconds max_time = fc::seconds(1);
+}
+
+BOOST_AUTO_TEST_SUITE(abi_serializer_cache_tests)
+
+BOOST_FIXTURE_TEST_CASE(setabi_replaces_entry, TESTER) { try {
+   abi_serializer_cache cache(16);
+   auto c = control->applied_transaction.connect([&](std::tuple<const transaction_trace_ptr&, const packed_transaction_ptr&> t) {
+      cache.invalidate(std::get<0>(t));
+   });
+
+   create_accounts({"alice"_n, "bob"_n});
+   produce_block();
+   const auto& db = control->db();
+
+   auto no_abi = cache.get(*control, db.get<account_object, by_name>("bob"_n), max_time);
+   BOOST_TEST(!no_abi->has_abi);
+
+   set_abi("alice"_n, abi_v1);
+   produce_block();
+   auto first = cache.get(*control, db.get<account_object, by_name>("alice"_n), max_time);
+   BOOST_TEST_REQUIRE(first->has_abi);
+   BOOST_TEST(first->serializer.get_action_type("hi"_n) == "hi");
+   BOOST_TEST(cache.get(*control, db.get<account_object, by_name>("alice"_n), max_time) == first);
+   BOOST_TEST(cache.size() == 2u);
+
+   set_abi("alice"_n, abi_v2);
+   BOOST_TEST(cache.size() == 1u);
+   produce_block();
+   auto second = cache.get(*control, db.get<account_object, by_name>("alice"_n), max_time);
+   BOOST_TEST(second != first);
+   BOOST_TEST(second->serializer.get_action_type("hi"_n).empty());
+   BOOST_TEST(second->serializer.get_action_type("bye"_n) == "bye");
+   // entries handed out stay valid after being replaced
+   BOOST_TEST(first->serializer.get_action_type("hi"_n) == "hi");
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_FIXTURE_TEST_CASE(least_recently_used_dropped, TESTER) { try {
+   abi_serializer_cache cache(2);
+
+   create_accounts({"alice"_n, "bob"_n, "carol"_n});
+   for (auto n : {"alice"_n, "bob"_n, "carol"_n}) {
+      set_abi(n, abi_v1);
+   }
+   produce_block();
+   const auto& db = control->db();
+   auto get = [&](name n) { return cache.get(*control, db.get<account_object, by_name>(n), max_time); };
+
+   auto alice = get("alice"_n);
+   get("bob"_n);
+   BOOST_TEST(get("alice"_n) == alice);
+   get("carol"_n);
+   BOOST_TEST(cache.size() == 2u);
+   // bob was used least recently
+   BOOST_TEST(get("alice"_n) == alice);
+
+   cache.erase("alice"_n);
+   BOOST_TEST(get("alice"_n) != alice);
+
+   abi_serializer_cache disabled(0);
+   auto a1 = disabled.get(*control, db.get<account_object, by_name>("alice"_n), max_time);
+   BOOST_TEST(a1->has_abi);
+   BOOST_TEST(disabled.size() == 0u);
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
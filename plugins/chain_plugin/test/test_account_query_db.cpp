@@ -97,6 +97,101 @@ BOOST_FIXTURE_TEST_CASE(updateauth_test, TESTER) { try {
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_FIXTURE_TEST_CASE(shared_key_test, TESTER) { try {
+
+   auto aq_db = account_query_db(*control);
+   auto c = control->applied_transaction.connect([&](std::tuple<const transaction_trace_ptr&, const packed_transaction_ptr&> t) {
+      aq_db.cache_transaction_trace(std::get<0>(t));
+   });
+   auto c2 = control->accepted_block.connect([&](const block_state_ptr& blk) {
+      aq_db.commit_block(blk);
+   });
+
+   const auto tester_account = "tester"_n;
+   create_account(tester_account);
+   const auto shared_key = get_public_key(tester_account, "shared");
+   for (auto perm : {"first"_n, "second"_n}) {
+      push_action(config::system_account_name, updateauth::get_name(), tester_account, fc::mutable_variant_object()
+            ("account", tester_account)
+            ("permission", perm)
+            ("parent", "active")
+            ("auth",  authority(shared_key, 1))
+      );
+   }
+   produce_block();
+
+   params pars;
+   pars.keys.emplace_back(shared_key);
+   auto results = aq_db.get_accounts_by_authorizers(pars);
+   BOOST_TEST_REQUIRE(results.accounts.size() == 2u);
+   BOOST_TEST_REQUIRE(find_account_auth(results, tester_account, "first"_n) == true);
+   BOOST_TEST_REQUIRE(find_account_auth(results, tester_account, "second"_n) == true);
+   BOOST_TEST_REQUIRE((results.accounts[0].authorizing_key == shared_key));
+
+   // the key stays indexed for the permission still using it
+   push_action(config::system_account_name, deleteauth::get_name(), tester_account, fc::mutable_variant_object()
+         ("account", tester_account)
+         ("permission", "first"_n)
+   );
+   produce_block();
+   results = aq_db.get_accounts_by_authorizers(pars);
+   BOOST_TEST_REQUIRE(results.accounts.size() == 1u);
+   BOOST_TEST_REQUIRE(find_account_auth(results, tester_account, "second"_n) == true);
+
+   push_action(config::system_account_name, updateauth::get_name(), tester_account, fc::mutable_variant_object()
+         ("account", tester_account)
+         ("permission", "second"_n)
+         ("parent", "active")
+         ("auth",  authority(get_public_key(tester_account, "other"), 1))
+   );
+   produce_block();
+   BOOST_TEST_REQUIRE(aq_db.get_accounts_by_authorizers(pars).accounts.size() == 0u);
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_FIXTURE_TEST_CASE(get_required_keys_test, TESTER) { try {
+
+   // instantiate an account_query_db
+   auto aq_db = account_query_db(*control);
+
+   //link aq_db to the `accepted_block` signal on the controller
+   auto c = control->accepted_block.connect([&](const block_state_ptr& blk) {
+       aq_db.commit_block( blk);
+   });
+
+   produce_blocks(10);
+
+   const auto& tester_account = "tester"_n;
+   aq_db.cache_transaction_trace(create_account(tester_account));
+   const auto trace_ptr = push_action(config::system_account_name, updateauth::get_name(), tester_account, fc::mutable_variant_object()
+         ("account", tester_account)
+         ("permission", "role"_n)
+         ("parent", "active")
+         ("auth",  authority(get_public_key(tester_account, "first")))
+   );
+   aq_db.cache_transaction_trace(trace_ptr);
+   produce_block();
+
+   const flat_set<public_key_type> candidate_keys{ get_public_key(tester_account, "owner"),
+                                                   get_public_key(tester_account, "active"),
+                                                   get_public_key(tester_account, "first") };
+   auto required_keys = [&](permission_name perm) {
+      transaction trx;
+      trx.actions.emplace_back(vector<permission_level>{{tester_account, perm}}, config::system_account_name, "reqauth"_n, bytes());
+      const auto keys = aq_db.get_required_keys(trx, candidate_keys, fc::microseconds(0));
+      BOOST_TEST_REQUIRE((keys == control->get_authorization_manager().get_required_keys(trx, candidate_keys)));
+      return keys;
+   };
+
+   BOOST_TEST_REQUIRE((required_keys("role"_n) == flat_set<public_key_type>{get_public_key(tester_account, "first")}));
+   BOOST_TEST_REQUIRE((required_keys(config::active_name) == flat_set<public_key_type>{get_public_key(tester_account, "active")}));
+
+   transaction trx;
+   trx.actions.emplace_back(vector<permission_level>{{tester_account, "missing"_n}}, config::system_account_name, "reqauth"_n, bytes());
+   BOOST_CHECK_THROW(aq_db.get_required_keys(trx, candidate_keys, fc::microseconds(0)), unsatisfied_authorization);
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE(future_fork_test) { try {
    tester node_a(setup_policy::none);
    tester node_b(setup_policy::none);
@@ -0,0 +1,76 @@
+#define BOOST_TEST_MODULE account_summary_cache
+#include <boost/test/included/unit_test.hpp>
+#include <eosio/chain_plugin/account_summary_cache.hpp>
+
+using namespace eosio::chain;
+using namespace eosio::chain::literals;
+using namespace eosio::chain_apis;
+
+namespace {
+   read_only::get_account_results make_result( name account, int64_t ram_usage ) {
+      read_only::get_account_results r;
+      r.account_name = account;
+      r.ram_usage = ram_usage;
+      return r;
+   }
+}
+
+BOOST_AUTO_TEST_SUITE(account_summary_cache_tests)
+
+BOOST_AUTO_TEST_CASE(kept_for_one_state) {
+   account_summary_cache cache( 2 );
+   account_summary_cache::state_version v;
+   v.revision = 10;
+
+   read_only::get_account_params alice{ "alice"_n };
+   BOOST_TEST( !cache.get( alice, v ) );
+   cache.put( alice, v, make_result( "alice"_n, 100 ) );
+   BOOST_TEST_REQUIRE( cache.get( alice, v ).has_value() );
+   BOOST_TEST( cache.get( alice, v )->ram_usage == 100 );
+
+   // expected core symbol is part of the key
+   read_only::get_account_params alice_sys{ "alice"_n, symbol( 4, "SYS" ) };
+   BOOST_TEST( !cache.get( alice_sys, v ) );
+
+   // next revision
+   auto next = v;
+   ++next.revision;
+   BOOST_TEST( !cache.get( alice, next ) );
+   cache.put( alice, next, make_result( "alice"_n, 200 ) );
+   BOOST_TEST( !cache.get( alice, v ) );
+   BOOST_TEST( cache.get( alice, next )->ram_usage == 200 );
+}
+
+BOOST_AUTO_TEST_CASE(invalidate_drops_reads_in_flight) {
+   account_summary_cache cache( 2 );
+   account_summary_cache::state_version v;
+
+   read_only::get_account_params alice{ "alice"_n };
+   cache.put( alice, v, make_result( "alice"_n, 100 ) );
+   cache.invalidate();
+   BOOST_TEST( !cache.get( alice, v ) );
+
+   // read before the invalidation
+   cache.put( alice, v, make_result( "alice"_n, 100 ) );
+   BOOST_TEST( !cache.get( alice, v ) );
+
+   ++v.generation;
+   cache.put( alice, v, make_result( "alice"_n, 300 ) );
+   BOOST_TEST( cache.get( alice, v )->ram_usage == 300 );
+}
+
+BOOST_AUTO_TEST_CASE(least_recently_used_dropped) {
+   account_summary_cache cache( 2 );
+   account_summary_cache::state_version v;
+
+   read_only::get_account_params alice{ "alice"_n }, bob{ "bob"_n }, carol{ "carol"_n };
+   cache.put( alice, v, make_result( "alice"_n, 1 ) );
+   cache.put( bob, v, make_result( "bob"_n, 2 ) );
+   BOOST_TEST( cache.get( alice, v ).has_value() );
+   cache.put( carol, v, make_result( "carol"_n, 3 ) );
+   BOOST_TEST( !cache.get( bob, v ) );
+   BOOST_TEST( cache.get( alice, v ).has_value() );
+   BOOST_TEST( cache.get( carol, v ).has_value() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,73 @@
+#define BOOST_TEST_MODULE deep_mind_framed_writer
+#include <boost/test/included/unit_test.hpp>
+#include <eosio/chain_plugin/deep_mind_framed_writer.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/log/logger.hpp>
+
+#include <fstream>
+#include <iterator>
+
+using namespace eosio;
+
+namespace {
+   std::vector<std::string> read_frames( const fc::path& file ) {
+      std::ifstream in( file.generic_string(), std::ios::binary );
+      const std::string data( (std::istreambuf_iterator<char>( in )), std::istreambuf_iterator<char>() );
+      std::vector<std::string> frames;
+      size_t pos = 0;
+      while( pos < data.size() ) {
+         BOOST_TEST_REQUIRE( pos + 4 <= data.size() );
+         uint32_t size = 0;
+         for( size_t i = 0; i < 4; ++i )
+            size |= uint32_t( uint8_t( data[pos + i] ) ) << ( 8 * i );
+         pos += 4;
+         BOOST_TEST_REQUIRE( pos + size <= data.size() );
+         frames.emplace_back( data.substr( pos, size ) );
+         pos += size;
+      }
+      return frames;
+   }
+}
+
+BOOST_AUTO_TEST_SUITE(deep_mind_framed_writer_tests)
+
+BOOST_AUTO_TEST_CASE(events_are_framed_in_order) {
+   fc::temp_directory dir;
+   const auto file = dir.path() / "dmlog";
+   bool failed = false;
+   {
+      // a small ring buffer makes log() wait for the writer
+      deep_mind_framed_writer writer( file.generic_string(), 3, [&failed]( const std::string& ) { failed = true; } );
+      for( uint32_t i = 0; i < 1000; ++i ) {
+         writer.log( FC_LOG_MESSAGE( debug, "DB_OP INS ${action_id} ${payer} ${ndata}", ("action_id", i)("payer", "alice")("ndata", "0a0b") ) );
+      }
+      writer.stop();
+      writer.log( FC_LOG_MESSAGE( debug, "dropped after stop" ) );
+   }
+   BOOST_TEST( !failed );
+
+   const auto frames = read_frames( file );
+   BOOST_TEST_REQUIRE( frames.size() == 1000u );
+   for( uint32_t i = 0; i < frames.size(); ++i ) {
+      BOOST_TEST( frames[i] == "DB_OP INS " + std::to_string( i ) + " alice 0a0b" );
+   }
+}
+
+BOOST_AUTO_TEST_CASE(logger_writes_through_writer) {
+   fc::temp_directory dir;
+   const auto file = dir.path() / "dmlog";
+   {
+      auto writer = std::make_shared<deep_mind_framed_writer>( file.generic_string(), 16, []( const std::string& ) {} );
+      fc::logger log;
+      log.set_log_level( fc::log_level::debug );
+      log.add_appender( writer );
+      fc_dlog( log, "ACCEPTED_BLOCK ${num}", ("num", 7) );
+      writer->stop();
+   }
+   const auto frames = read_frames( file );
+   BOOST_TEST_REQUIRE( frames.size() == 1u );
+   BOOST_TEST( frames[0] == "ACCEPTED_BLOCK 7" );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,60 @@
+#define BOOST_TEST_MODULE read_only_api_executor
+#include <boost/test/included/unit_test.hpp>
+#include <eosio/chain_plugin/read_only_api_executor.hpp>
+
+#include <atomic>
+#include <condition_variable>
+
+using namespace eosio::chain_apis;
+
+BOOST_AUTO_TEST_SUITE(read_only_api_executor_tests)
+
+BOOST_AUTO_TEST_CASE(window_runs_queued_calls_in_parallel) {
+   std::vector<std::function<void()>> windows;
+   read_only_api_executor executor( 4, [&windows](std::function<void()> w) { windows.emplace_back( std::move( w ) ); } );
+
+   // each call waits for all of them to have started, so the window only completes when they run in parallel
+   std::mutex mtx;
+   std::condition_variable cv;
+   size_t started = 0;
+   std::atomic<size_t> completed = 0;
+   for( size_t i = 0; i < 4; ++i ) {
+      executor.post( [&]() {
+         std::unique_lock<std::mutex> g( mtx );
+         ++started;
+         cv.notify_all();
+         cv.wait( g, [&started]() { return started == 4; } );
+         ++completed;
+      } );
+   }
+   BOOST_TEST( executor.queued() == 4u );
+   BOOST_TEST_REQUIRE( windows.size() == 1u );
+   BOOST_TEST( completed == 0u );
+
+   windows.front()();
+   BOOST_TEST( completed == 4u );
+   BOOST_TEST( executor.queued() == 0u );
+
+   // calls posted after a window ran schedule another one
+   executor.post( [&]() { throw std::runtime_error( "dropped" ); } );
+   executor.post( [&]() { ++completed; } );
+   BOOST_TEST_REQUIRE( windows.size() == 2u );
+   windows.back()();
+   BOOST_TEST( completed == 5u );
+}
+
+BOOST_AUTO_TEST_CASE(stopped_drops_calls) {
+   std::vector<std::function<void()>> windows;
+   read_only_api_executor executor( 1, [&windows](std::function<void()> w) { windows.emplace_back( std::move( w ) ); } );
+
+   bool called = false;
+   executor.post( [&called]() { called = true; } );
+   executor.stop();
+   executor.post( [&called]() { called = true; } );
+   BOOST_TEST( executor.queued() == 0u );
+   BOOST_TEST_REQUIRE( windows.size() == 1u );
+   windows.front()();
+   BOOST_TEST( !called );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
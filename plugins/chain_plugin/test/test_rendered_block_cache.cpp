@@ -0,0 +1,63 @@
+#define BOOST_TEST_MODULE rendered_block_cache
+#include <boost/test/included/unit_test.hpp>
+#include <eosio/chain_plugin/rendered_block_cache.hpp>
+
+using namespace eosio::chain;
+using namespace eosio::chain_apis;
+
+namespace {
+   block_id_type make_id( uint32_t n ) {
+      block_id_type id;
+      id._hash[0] = n;
+      return id;
+   }
+
+   rendered_block_cache::json_ptr make_json( const std::string& s ) {
+      return std::make_shared<const std::string>( s );
+   }
+}
+
+BOOST_AUTO_TEST_SUITE(rendered_block_cache_tests)
+
+BOOST_AUTO_TEST_CASE(least_recently_used_dropped) {
+   rendered_block_cache cache( 2 );
+   BOOST_TEST( !cache.get( make_id( 1 ) ).json );
+
+   auto r1 = cache.put( make_id( 1 ), make_json( "{1}" ), cache.current_generation() );
+   cache.put( make_id( 2 ), make_json( "{2}" ), cache.current_generation() );
+   BOOST_TEST( *r1.json == "{1}" );
+   BOOST_TEST( cache.get( make_id( 1 ) ).etag == r1.etag );
+
+   // 2 is the least recently used
+   cache.put( make_id( 3 ), make_json( "{3}" ), cache.current_generation() );
+   BOOST_TEST( !cache.get( make_id( 2 ) ).json );
+   BOOST_TEST( *cache.get( make_id( 1 ) ).json == "{1}" );
+   BOOST_TEST( *cache.get( make_id( 3 ) ).json == "{3}" );
+
+   auto m = cache.get_metrics();
+   BOOST_TEST( m.entries == 2u );
+   BOOST_TEST( m.bytes == 6u );
+   BOOST_TEST( m.hits == 3u );
+   BOOST_TEST( m.misses == 2u );
+}
+
+BOOST_AUTO_TEST_CASE(clear_changes_etag) {
+   rendered_block_cache cache( 2 );
+   const auto generation = cache.current_generation();
+   auto r = cache.put( make_id( 1 ), make_json( "{1}" ), generation );
+
+   cache.clear();
+   BOOST_TEST( !cache.get( make_id( 1 ) ).json );
+
+   // rendered before the clear, returned but not cached
+   auto stale = cache.put( make_id( 1 ), make_json( "{1}" ), generation );
+   BOOST_TEST( stale.etag == r.etag );
+   BOOST_TEST( !cache.get( make_id( 1 ) ).json );
+
+   auto fresh = cache.put( make_id( 1 ), make_json( "{1}" ), cache.current_generation() );
+   BOOST_TEST( fresh.etag != r.etag );
+   BOOST_TEST( cache.get( make_id( 1 ) ).etag == fresh.etag );
+   BOOST_TEST( cache.get_metrics().generation == 1u );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,12 +2,20 @@
 #include <fc/io/json.hpp>
 #include <eosio/db_size_api_plugin/db_size_api_plugin.hpp>
 #include <eosio/http_plugin/http_plugin.hpp>
+#include <eosio/chain/contract_table_objects.hpp>
+#include <eosio/chain/kv_chainbase_objects.hpp>
+#include <eosio/chain/table_usage_tracker.hpp>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include <deque>
 
 namespace eosio {
 
 static appbase::abstract_plugin& _db_size_api_plugin = app().register_plugin<db_size_api_plugin>();
 
 using namespace eosio;
+using namespace eosio::chain;
 
 #define CALL_WITH_400(api_name, api_handle, call_name, INVOKE, http_response_code) \
 {std::string("/v1/" #api_name "/" #call_name), \
@@ -21,15 +29,188 @@ using namespace eosio;
           } \
        }}
 
+#define CALL_WITH_400_PARAMS(api_name, api_handle, call_name, params_type, http_response_code) \
+{std::string("/v1/" #api_name "/" #call_name), \
+   [api_handle](string, string body, url_response_callback cb) mutable { \
+          try { \
+             auto params = parse_params<params_type, http_params_types::possible_no_params>(body); \
+             auto result = api_handle->call_name(params); \
+             cb(http_response_code, fc::variant(result)); \
+          } catch (...) { \
+             http_plugin::handle_exception(#api_name, #call_name, body, cb); \
+          } \
+       }}
+
 #define INVOKE_R_V(api_handle, call_name) \
      auto result = api_handle->call_name();
 
+/// usage of the tables and the state database at a point in time, for growth rates
+struct table_usage_sample {
+   fc::time_point                   time;
+   uint64_t                         used_bytes = 0;
+   table_usage_tracker::usage_map   tables;
+};
+
+class db_size_api_plugin_impl {
+public:
+   bool                                          track_tables = false;
+   fc::microseconds                              sample_interval;
+   uint32_t                                      alert_hours = 0;
+   std::shared_ptr<table_usage_tracker>          tracker;
+   std::unique_ptr<boost::asio::steady_timer>    timer;
+   std::deque<table_usage_sample>                samples; ///< oldest first, spanning about an hour
+   size_t                                        max_samples = 2;
+
+   /// rows and bytes of all contract tables, only feasible to count for the chainbase backing store
+   static table_usage_tracker::usage_map scan_chainbase_tables( const chainbase::database& db ) {
+      table_usage_tracker::usage_map tables;
+      std::map<table_id, table_usage*> by_id;
+      for( const auto& t : db.get_index<table_id_multi_index>().indices() ) {
+         auto& u = tables[table_usage_key{ t.code, t.table, false }];
+         u.rows += t.count;
+         by_id[t.id] = &u;
+      }
+      for( const auto& row : db.get_index<key_value_index>().indices() ) {
+         by_id.at( row.t_id )->bytes += row.value.size() + config::billable_size_v<key_value_object>;
+      }
+      for( const auto& kv : db.get_index<kv_index>().indices() ) {
+         tables[table_usage_key{ kv.contract, table_usage_key::kv_table( kv.kv_key.data(), kv.kv_key.size() ), true }] +=
+            table_usage{ 1, static_cast<int64_t>( config::billable_size_v<kv_object> + kv.kv_key.size() + kv.kv_value.size() ) };
+      }
+      return tables;
+   }
+
+   void start_tracking( controller& chain ) {
+      const bool chainbase_store = chain.get_config().backing_store == backing_store_type::CHAINBASE;
+      auto start = fc::time_point::now();
+      auto baseline = chainbase_store ? scan_chainbase_tables( chain.db() ) : table_usage_tracker::usage_map{};
+      const auto counted = baseline.size();
+      tracker = std::make_shared<table_usage_tracker>( std::move( baseline ), chainbase_store );
+      chain.set_table_usage_tracker( tracker );
+      if( chainbase_store ) {
+         ilog( "counted ${n} contract tables in ${t} ms", ("n", counted)("t", (fc::time_point::now() - start).count() / 1000) );
+      } else {
+         ilog( "tracking the growth of contract tables from startup, the rocksdb backing store is not counted" );
+      }
+
+      timer = std::make_unique<boost::asio::steady_timer>( app().get_io_service() );
+      take_sample( chain );
+      schedule_sample( chain );
+   }
+
+   void schedule_sample( controller& chain ) {
+      timer->expires_from_now( std::chrono::microseconds( sample_interval.count() ) );
+      timer->async_wait( app().get_priority_queue().wrap( priority::low, [this, &chain]( const boost::system::error_code& ec ) {
+         if( ec ) return;
+         take_sample( chain );
+         check_growth();
+         schedule_sample( chain );
+      } ) );
+   }
+
+   void take_sample( const controller& chain ) {
+      const auto& db = chain.db();
+      samples.push_back( table_usage_sample{ fc::time_point::now(),
+                                             db.get_segment_manager()->get_size() - db.get_segment_manager()->get_free_memory(),
+                                             tracker->get_tables() } );
+      while( samples.size() > max_samples )
+         samples.pop_front();
+   }
+
+   /// hours between the oldest and the latest sample, 0 with fewer than two samples
+   double sampled_hours()const {
+      if( samples.size() < 2 ) return 0;
+      return ( samples.back().time - samples.front().time ).count() / 3600e6;
+   }
+
+   double used_bytes_per_hour()const {
+      auto hours = sampled_hours();
+      if( hours <= 0 ) return 0;
+      return ( static_cast<double>( samples.back().used_bytes ) - samples.front().used_bytes ) / hours;
+   }
+
+   vector<db_table_usage> table_growth()const {
+      vector<db_table_usage> result;
+      if( samples.empty() ) return result;
+      auto hours = sampled_hours();
+      const auto& oldest = samples.front().tables;
+      result.reserve( samples.back().tables.size() );
+      for( const auto& [key, usage] : samples.back().tables ) {
+         db_table_usage t{ key.code, key.table, key.kv, usage.rows, usage.bytes };
+         if( hours > 0 ) {
+            auto itr = oldest.find( key );
+            t.bytes_per_hour = ( usage.bytes - ( itr != oldest.end() ? itr->second.bytes : 0 ) ) / hours;
+         }
+         result.push_back( t );
+      }
+      return result;
+   }
+
+   void check_growth() {
+      if( alert_hours == 0 ) return;
+      auto rate = used_bytes_per_hour();
+      if( rate <= 0 ) return;
+      const auto& db = app().get_plugin<chain_plugin>().chain().db();
+      auto hours_until_full = db.get_segment_manager()->get_free_memory() / rate;
+      if( hours_until_full >= alert_hours ) return;
+
+      auto tables = table_growth();
+      auto top = std::min<size_t>( tables.size(), 5 );
+      std::partial_sort( tables.begin(), tables.begin() + top, tables.end(),
+                         []( const auto& a, const auto& b ) { return a.bytes_per_hour > b.bytes_per_hour; } );
+      std::string growing;
+      for( size_t i = 0; i < top && tables[i].bytes_per_hour > 0; ++i ) {
+         growing += ( growing.empty() ? "" : ", " ) + tables[i].code.to_string() + ":" + tables[i].table.to_string() +
+                    " " + std::to_string( static_cast<int64_t>( tables[i].bytes_per_hour / 1024 ) ) + " KiB/h";
+      }
+      wlog( "chain state db grows ${r} MiB/hour and is full in ${h} hours at this rate, fastest growing tables: ${t}",
+            ("r", static_cast<int64_t>( rate / ( 1024 * 1024 ) ))("h", static_cast<int64_t>( hours_until_full ))("t", growing) );
+   }
+};
+
+db_size_api_plugin::db_size_api_plugin()
+: my( std::make_shared<db_size_api_plugin_impl>() )
+{}
+
+void db_size_api_plugin::set_program_options(options_description& cli, options_description& cfg) {
+   cfg.add_options()
+         ("db-size-track-tables", bpo::bool_switch()->default_value(false),
+          "Track the rows and bytes of every contract table as blocks are applied, reported by /v1/db_size/get_table_usage. "
+          "With the chainbase backing store all tables are counted at startup, with rocksdb the growth since startup is tracked.")
+         ("db-size-sample-interval-sec", bpo::value<uint32_t>()->default_value(300),
+          "Interval of the table usage samples growth rates are computed from, over the last hour.")
+         ("db-size-alert-hours", bpo::value<uint32_t>()->default_value(24),
+          "Warn when the chain state db fills within this many hours at its growth rate, 0 disables. Requires db-size-track-tables.")
+         ;
+}
+
+void db_size_api_plugin::plugin_initialize(const variables_map& options) {
+   try {
+      my->track_tables = options.at( "db-size-track-tables" ).as<bool>();
+      auto interval = options.at( "db-size-sample-interval-sec" ).as<uint32_t>();
+      EOS_ASSERT( interval > 0, plugin_config_exception, "db-size-sample-interval-sec must be greater than 0" );
+      my->sample_interval = fc::seconds( interval );
+      my->max_samples = std::max<size_t>( 2, 3600 / interval + 1 );
+      my->alert_hours = options.at( "db-size-alert-hours" ).as<uint32_t>();
+   } FC_LOG_AND_RETHROW()
+}
 
 void db_size_api_plugin::plugin_startup() {
    app().get_plugin<http_plugin>().add_api({
        CALL_WITH_400(db_size, this, get,  INVOKE_R_V(this, get), 200),
        CALL_WITH_400(db_size, this, get_reversible, INVOKE_R_V(this, get_reversible), 200),
+       CALL_WITH_400(db_size, this, get_kv_cache, INVOKE_R_V(this, get_kv_cache), 200),
+       CALL_WITH_400_PARAMS(db_size, this, get_table_usage, db_table_usage_params, 200),
    });
+
+   if( my->track_tables ) {
+      my->start_tracking( app().get_plugin<chain_plugin>().chain() );
+   }
+}
+
+void db_size_api_plugin::plugin_shutdown() {
+   if( my->timer ) my->timer->cancel();
+   if( my->tracker ) app().get_plugin<chain_plugin>().chain().set_table_usage_tracker( nullptr );
 }
 
 db_size_stats db_size_api_plugin::get_db_stats(const chainbase::database& db) {
@@ -54,7 +235,50 @@ db_size_stats db_size_api_plugin::get_reversible() {
    return get_db_stats(app().get_plugin<chain_plugin>().chain().reversible_db());
 }
 
+chain::kv_cache_stats db_size_api_plugin::get_kv_cache() {
+   return app().get_plugin<chain_plugin>().chain().kv_db().get_kv_cache_stats();
+}
+
+db_table_usage_result db_size_api_plugin::get_table_usage(const db_table_usage_params& params) {
+   db_table_usage_result result;
+   const auto& db = app().get_plugin<chain_plugin>().chain().db();
+   result.free_bytes = db.get_segment_manager()->get_free_memory();
+   result.used_bytes = db.get_segment_manager()->get_size() - result.free_bytes;
+   if( !my->tracker ) return result;
+
+   // tables as of now, growth rates as of the latest sample
+   auto growth = my->table_growth();
+   std::map<table_usage_key, double> rates;
+   for( const auto& t : growth )
+      rates[table_usage_key{ t.code, t.table, t.kv }] = t.bytes_per_hour;
+
+   result.tracking = true;
+   result.has_baseline = my->tracker->has_baseline();
+   result.head_block_num = my->tracker->head_block_num();
+   result.used_bytes_per_hour = my->used_bytes_per_hour();
+   if( result.used_bytes_per_hour > 0 )
+      result.hours_until_full = result.free_bytes / result.used_bytes_per_hour;
+
+   for( const auto& [key, usage] : my->tracker->get_tables() ) {
+      auto itr = rates.find( key );
+      result.tables.push_back( db_table_usage{ key.code, key.table, key.kv, usage.rows, usage.bytes,
+                                               itr != rates.end() ? itr->second : 0 } );
+   }
+
+   const size_t limit = std::min<size_t>( params.limit.value_or( 100 ), result.tables.size() );
+   if( params.by_growth.value_or( false ) ) {
+      std::partial_sort( result.tables.begin(), result.tables.begin() + limit, result.tables.end(),
+                         []( const auto& a, const auto& b ) { return a.bytes_per_hour > b.bytes_per_hour; } );
+   } else {
+      std::partial_sort( result.tables.begin(), result.tables.begin() + limit, result.tables.end(),
+                         []( const auto& a, const auto& b ) { return a.bytes > b.bytes; } );
+   }
+   result.tables.resize( limit );
+   return result;
+}
+
 #undef INVOKE_R_V
+#undef CALL_WITH_400_PARAMS
 #undef CALL
 
 }
@@ -2,6 +2,7 @@
 
 #include <eosio/http_plugin/http_plugin.hpp>
 #include <eosio/chain_plugin/chain_plugin.hpp>
+#include <eosio/chain/combined_database.hpp>
 
 #include <appbase/application.hpp>
 
@@ -21,30 +22,62 @@ struct db_size_stats {
    vector<db_size_index_count> indices;
 };
 
+struct db_table_usage_params {
+   std::optional<uint32_t>  limit;     ///< tables returned, 100 when not set
+   std::optional<bool>      by_growth; ///< order by growth instead of bytes
+};
+
+struct db_table_usage {
+   chain::name  code;
+   chain::name  table;
+   bool         kv = false;         ///< a table of the key value database, named by the first 8 bytes of its keys
+   int64_t      rows = 0;
+   int64_t      bytes = 0;          ///< billable bytes of the rows
+   double       bytes_per_hour = 0; ///< growth over the sampled window
+};
+
+struct db_table_usage_result {
+   bool                     tracking = false;      ///< false unless db-size-track-tables is enabled
+   bool                     has_baseline = false;  ///< false when rows and bytes are the growth since startup
+   uint32_t                 head_block_num = 0;    ///< last block included in rows and bytes
+   uint64_t                 free_bytes = 0;        ///< of the state database
+   uint64_t                 used_bytes = 0;
+   double                   used_bytes_per_hour = 0;
+   std::optional<double>    hours_until_full;      ///< at used_bytes_per_hour, when growing
+   vector<db_table_usage>   tables;
+};
+
 class db_size_api_plugin : public plugin<db_size_api_plugin> {
 public:
    APPBASE_PLUGIN_REQUIRES((http_plugin) (chain_plugin))
 
-   db_size_api_plugin() = default;
+   db_size_api_plugin();
    db_size_api_plugin(const db_size_api_plugin&) = delete;
    db_size_api_plugin(db_size_api_plugin&&) = delete;
    db_size_api_plugin& operator=(const db_size_api_plugin&) = delete;
    db_size_api_plugin& operator=(db_size_api_plugin&&) = delete;
    virtual ~db_size_api_plugin() override = default;
 
-   virtual void set_program_options(options_description& cli, options_description& cfg) override {}
-   void plugin_initialize(const variables_map& vm) {}
+   virtual void set_program_options(options_description& cli, options_description& cfg) override;
+   void plugin_initialize(const variables_map& vm);
    void plugin_startup();
-   void plugin_shutdown() {}
+   void plugin_shutdown();
 
    db_size_stats get();
    db_size_stats get_reversible();
+   chain::kv_cache_stats get_kv_cache();
+   db_table_usage_result get_table_usage(const db_table_usage_params& params);
 
 private:
    db_size_stats get_db_stats(const chainbase::database& );
+
+   std::shared_ptr<class db_size_api_plugin_impl> my;
 };
 
 }
 
 FC_REFLECT( eosio::db_size_index_count, (index)(row_count) )
-FC_REFLECT( eosio::db_size_stats, (free_bytes)(used_bytes)(size)(indices) )
\ No newline at end of file
+FC_REFLECT( eosio::db_size_stats, (free_bytes)(used_bytes)(size)(indices) )
+FC_REFLECT( eosio::db_table_usage_params, (limit)(by_growth) )
+FC_REFLECT( eosio::db_table_usage, (code)(table)(kv)(rows)(bytes)(bytes_per_hour) )
+FC_REFLECT( eosio::db_table_usage_result, (tracking)(has_baseline)(head_block_num)(free_bytes)(used_bytes)(used_bytes_per_hour)(hours_until_full)(tables) )
\ No newline at end of file
@@ -0,0 +1,285 @@
+#include <eosio/history_plugin/history_log_store.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <b1/chain_kv/chain_kv.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <map>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace eosio {
+   using namespace chain;
+   using b1::chain_kv::bytes;
+   using b1::chain_kv::check;
+   using b1::chain_kv::to_slice;
+
+   namespace {
+      /// first byte of the keys, the sentinels of chain_kv::database are 0x00 and 0xff
+      enum key_prefix : char {
+         action_prefix       = 'a', ///< action sequence -> stored_action
+         account_prefix      = 'h', ///< account, account sequence -> action sequence
+         account_seq_prefix  = 's', ///< account -> account sequence of its next action
+         trx_prefix          = 't', ///< transaction id, action sequence -> empty
+         meta_prefix         = 'm'  ///< -> store_meta
+      };
+
+      /// where the packed trace of an action is in the actions log
+      struct stored_action {
+         uint64_t              offset = 0;
+         uint32_t              size = 0;
+         uint32_t              block_num = 0;
+         block_timestamp_type  block_time;
+         transaction_id_type   trx_id;
+      };
+
+      struct store_meta {
+         uint32_t  last_block_num = 0;
+         uint64_t  log_size = 0;       ///< bytes of the actions log covered by the index
+      };
+
+      bytes action_key( uint64_t seq ) {
+         bytes k{ action_prefix };
+         b1::chain_kv::append_key( k, seq );
+         return k;
+      }
+
+      bytes account_key( account_name account ) {
+         bytes k{ account_prefix };
+         b1::chain_kv::append_key( k, account.to_uint64_t() );
+         return k;
+      }
+
+      bytes account_key( account_name account, int32_t account_seq ) {
+         bytes k = account_key( account );
+         b1::chain_kv::append_key( k, static_cast<uint32_t>( account_seq ) );
+         return k;
+      }
+
+      bytes account_seq_key( account_name account ) {
+         bytes k{ account_seq_prefix };
+         b1::chain_kv::append_key( k, account.to_uint64_t() );
+         return k;
+      }
+
+      bytes trx_key( const transaction_id_type& id ) {
+         bytes k{ trx_prefix };
+         k.insert( k.end(), id.data(), id.data() + id.data_size() );
+         return k;
+      }
+
+      bytes trx_key( const transaction_id_type& id, uint64_t seq ) {
+         bytes k = trx_key( id );
+         b1::chain_kv::append_key( k, seq );
+         return k;
+      }
+
+      const bytes meta_key{ meta_prefix };
+
+      template<typename T>
+      bytes pack( const T& v ) {
+         return fc::raw::pack( v );
+      }
+
+      template<typename T>
+      T unpack( const rocksdb::Slice& s ) {
+         T v;
+         fc::datastream<const char*> ds( s.data(), s.size() );
+         fc::raw::unpack( ds, v );
+         return v;
+      }
+   }
+}
+
+FC_REFLECT( eosio::stored_action, (offset)(size)(block_num)(block_time)(trx_id) )
+FC_REFLECT( eosio::store_meta, (last_block_num)(log_size) )
+
+namespace eosio {
+
+   struct history_log_store::impl {
+      explicit impl( const fc::path& dir )
+      : db( ( dir / "index" ).generic_string().c_str(), true )
+      {
+         const auto log_path = ( dir / "actions.log" ).generic_string();
+         fd = ::open( log_path.c_str(), O_RDWR | O_CREAT, 0644 );
+         EOS_ASSERT( fd >= 0, plugin_exception, "unable to open history actions log ${p}: ${e}",
+                     ("p", log_path)("e", std::strerror( errno )) );
+
+         store_meta meta;
+         rocksdb::PinnableSlice v;
+         auto stat = db.rdb->Get( rocksdb::ReadOptions(), db.rdb->DefaultColumnFamily(), to_slice( meta_key ), &v );
+         if( !stat.IsNotFound() ) {
+            check( stat, "history_log_store: rocksdb::DB::Get: " );
+            meta = unpack<store_meta>( v );
+         }
+         // drop traces of a block whose index was not written
+         EOS_ASSERT( ::ftruncate( fd, meta.log_size ) == 0, plugin_exception, "unable to truncate history actions log ${p}: ${e}",
+                     ("p", log_path)("e", std::strerror( errno )) );
+         log_size = meta.log_size;
+         last_block_num = meta.last_block_num;
+      }
+
+      ~impl() {
+         if( fd >= 0 ) ::close( fd );
+      }
+
+      void write_log( const std::vector<char>& data ) {
+         size_t written = 0;
+         while( written < data.size() ) {
+            auto r = ::pwrite( fd, data.data() + written, data.size() - written, log_size + written );
+            if( r < 0 && errno == EINTR ) continue;
+            EOS_ASSERT( r > 0, plugin_exception, "unable to write history actions log: ${e}", ("e", std::strerror( errno )) );
+            written += r;
+         }
+         EOS_ASSERT( ::fsync( fd ) == 0, plugin_exception, "unable to sync history actions log: ${e}", ("e", std::strerror( errno )) );
+      }
+
+      std::vector<char> read_log( uint64_t offset, uint32_t size )const {
+         std::vector<char> data( size );
+         size_t read = 0;
+         while( read < size ) {
+            auto r = ::pread( fd, data.data() + read, size - read, offset + read );
+            if( r < 0 && errno == EINTR ) continue;
+            EOS_ASSERT( r > 0, plugin_exception, "unable to read history actions log: ${e}", ("e", std::strerror( errno )) );
+            read += r;
+         }
+         return data;
+      }
+
+      std::optional<stored_action> get_action( uint64_t seq )const {
+         rocksdb::PinnableSlice v;
+         auto stat = db.rdb->Get( rocksdb::ReadOptions(), db.rdb->DefaultColumnFamily(), to_slice( action_key( seq ) ), &v );
+         if( stat.IsNotFound() ) return {};
+         check( stat, "history_log_store: rocksdb::DB::Get: " );
+         return unpack<stored_action>( v );
+      }
+
+      history_log_store::action_result read_action( uint64_t seq, const stored_action& a )const {
+         return { seq, 0, a.block_num, a.block_time, a.trx_id, read_log( a.offset, a.size ) };
+      }
+
+      b1::chain_kv::database  db;
+      int                     fd = -1;
+      uint64_t                log_size = 0;        ///< only used by append_block
+      std::atomic<uint32_t>   last_block_num{0};
+   };
+
+   history_log_store::history_log_store( const fc::path& dir ) {
+      if( !fc::exists( dir ) )
+         fc::create_directories( dir );
+      my = std::make_unique<impl>( dir );
+   }
+
+   history_log_store::~history_log_store() = default;
+
+   uint32_t history_log_store::last_block_num()const {
+      return my->last_block_num.load();
+   }
+
+   void history_log_store::append_block( uint32_t block_num, block_timestamp_type block_time, const std::vector<action_entry>& actions ) {
+      if( block_num <= my->last_block_num.load() ) return;
+
+      rocksdb::WriteBatch batch;
+      std::vector<char> log_data;
+      std::map<account_name, int32_t> next_account_seq;
+
+      for( const auto& a : actions ) {
+         stored_action sa{ my->log_size + log_data.size(), static_cast<uint32_t>( a.packed_action_trace.size() ),
+                           block_num, block_time, a.trx_id };
+         log_data.insert( log_data.end(), a.packed_action_trace.begin(), a.packed_action_trace.end() );
+         check( batch.Put( to_slice( action_key( a.action_sequence_num ) ), to_slice( pack( sa ) ) ),
+                "history_log_store: rocksdb::WriteBatch::Put: " );
+         check( batch.Put( to_slice( trx_key( a.trx_id, a.action_sequence_num ) ), {} ),
+                "history_log_store: rocksdb::WriteBatch::Put: " );
+
+         for( auto account : a.accounts ) {
+            auto itr = next_account_seq.find( account );
+            if( itr == next_account_seq.end() ) {
+               auto last = last_account_sequence_num( account );
+               itr = next_account_seq.emplace( account, last ? *last + 1 : 0 ).first;
+            }
+            check( batch.Put( to_slice( account_key( account, itr->second ) ), to_slice( pack( a.action_sequence_num ) ) ),
+                   "history_log_store: rocksdb::WriteBatch::Put: " );
+            ++itr->second;
+         }
+      }
+      for( const auto& [account, next] : next_account_seq ) {
+         check( batch.Put( to_slice( account_seq_key( account ) ), to_slice( pack( next ) ) ),
+                "history_log_store: rocksdb::WriteBatch::Put: " );
+      }
+      check( batch.Put( to_slice( meta_key ), to_slice( pack( store_meta{ block_num, my->log_size + log_data.size() } ) ) ),
+             "history_log_store: rocksdb::WriteBatch::Put: " );
+
+      // the log is synced before the index refers to it, a crash in between is undone on open
+      if( !log_data.empty() ) my->write_log( log_data );
+      rocksdb::WriteOptions wo;
+      wo.sync = true;
+      check( my->db.rdb->Write( wo, &batch ), "history_log_store: rocksdb::DB::Write: " );
+
+      my->log_size += log_data.size();
+      my->last_block_num = block_num;
+   }
+
+   std::optional<int32_t> history_log_store::last_account_sequence_num( account_name account )const {
+      rocksdb::PinnableSlice v;
+      auto stat = my->db.rdb->Get( rocksdb::ReadOptions(), my->db.rdb->DefaultColumnFamily(), to_slice( account_seq_key( account ) ), &v );
+      if( stat.IsNotFound() ) return {};
+      check( stat, "history_log_store: rocksdb::DB::Get: " );
+      auto next = unpack<int32_t>( v );
+      if( next == 0 ) return {};
+      return next - 1;
+   }
+
+   void history_log_store::for_each_account_action( account_name account, int32_t start, int32_t end,
+                                                    const std::function<bool(action_result&&)>& f )const {
+      if( start < 0 ) start = 0;
+      if( end < start ) return;
+      const auto prefix = account_key( account );
+      std::unique_ptr<rocksdb::Iterator> itr{ my->db.rdb->NewIterator( rocksdb::ReadOptions() ) };
+      for( itr->Seek( to_slice( account_key( account, start ) ) ); itr->Valid(); itr->Next() ) {
+         auto k = itr->key();
+         if( !k.starts_with( to_slice( prefix ) ) ) break;
+         auto key_itr = k.data() + prefix.size();
+         uint32_t account_seq = 0;
+         b1::chain_kv::extract_key( key_itr, k.data() + k.size(), account_seq );
+         if( static_cast<int32_t>( account_seq ) > end ) break;
+
+         auto seq = unpack<uint64_t>( itr->value() );
+         auto a = my->get_action( seq );
+         EOS_ASSERT( a, plugin_exception, "history action ${s} of ${a} is missing", ("s", seq)("a", account) );
+         auto r = my->read_action( seq, *a );
+         r.account_sequence_num = account_seq;
+         if( !f( std::move( r ) ) ) return;
+      }
+      check( itr->status(), "history_log_store: rocksdb::Iterator: " );
+   }
+
+   void history_log_store::for_each_transaction_action( const transaction_id_type& id,
+                                                        const std::function<bool(action_result&&)>& f )const {
+      std::unique_ptr<rocksdb::Iterator> itr{ my->db.rdb->NewIterator( rocksdb::ReadOptions() ) };
+      itr->Seek( to_slice( trx_key( id ) ) );
+      if( !itr->Valid() || itr->key()[0] != trx_prefix ) {
+         check( itr->status(), "history_log_store: rocksdb::Iterator: " );
+         return;
+      }
+      // actions of the first transaction found share the prefix of its id
+      const bytes prefix( itr->key().data(), itr->key().data() + 1 + id.data_size() );
+      for( ; itr->Valid(); itr->Next() ) {
+         auto k = itr->key();
+         if( !k.starts_with( to_slice( prefix ) ) ) break;
+         auto key_itr = k.data() + prefix.size();
+         uint64_t seq = 0;
+         b1::chain_kv::extract_key( key_itr, k.data() + k.size(), seq );
+
+         auto a = my->get_action( seq );
+         EOS_ASSERT( a, plugin_exception, "history action ${s} is missing", ("s", seq) );
+         if( !f( my->read_action( seq, *a ) ) ) return;
+      }
+      check( itr->status(), "history_log_store: rocksdb::Iterator: " );
+   }
+
+} /// namespace eosio
@@ -1,7 +1,9 @@
 #include <eosio/history_plugin/history_plugin.hpp>
 #include <eosio/history_plugin/account_control_history_object.hpp>
 #include <eosio/history_plugin/public_key_history_object.hpp>
+#include <eosio/history_plugin/history_log_store.hpp>
 #include <eosio/chain/controller.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <eosio/chain/trace.hpp>
 #include <eosio/chain_plugin/chain_plugin.hpp>
 
@@ -10,6 +12,8 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/signals2/connection.hpp>
 
+#include <fstream>
+
 namespace eosio {
    using namespace chain;
    using boost::signals2::scoped_connection;
@@ -135,6 +139,20 @@ namespace eosio {
       }
    };
 
+   /// actions of a block not yet irreversible, for the history_log_store
+   struct reversible_history_block {
+      block_id_type                                 id;
+      uint32_t                                      block_num = 0;
+      block_timestamp_type                          block_time;
+      std::vector<history_log_store::action_entry>  actions;
+   };
+
+} /// namespace eosio
+
+FC_REFLECT( eosio::reversible_history_block, (id)(block_num)(block_time)(actions) )
+
+namespace eosio {
+
    class history_plugin_impl {
       public:
          bool bypass_filter = false;
@@ -142,6 +160,19 @@ namespace eosio {
          std::set<filter_entry> filter_out;
          chain_plugin*          chain_plug = nullptr;
          std::optional<scoped_connection> applied_transaction_connection;
+         std::optional<scoped_connection> block_start_connection;
+         std::optional<scoped_connection> accepted_block_connection;
+         std::optional<scoped_connection> irreversible_block_connection;
+
+         /// irreversible blocks appended while at most this many are waiting for the store
+         static constexpr size_t max_queued_store_blocks = 1024;
+
+         // set when history-store = log, actions are then kept in store instead of the state db
+         fc::path                                             store_dir;
+         std::shared_ptr<history_log_store>                   store;
+         std::unique_ptr<bounded_serial_executor>             store_executor;
+         std::vector<history_log_store::action_entry>         pending_actions;   ///< of the block being applied
+         std::map<block_id_type, reversible_history_block>    reversible_blocks;
 
           bool filter(const action_trace& act) {
             bool pass_on = false;
@@ -251,7 +282,12 @@ namespace eosio {
          }
 
          void on_action_trace( const action_trace& at ) {
-            if( filter( at ) ) {
+            if( store && filter( at ) ) {
+               auto aset = account_set( at );
+               pending_actions.emplace_back( history_log_store::action_entry{
+                     at.receipt->global_sequence, at.trx_id, std::vector<account_name>( aset.begin(), aset.end() ),
+                     fc::raw::pack( at ) } );
+            } else if( filter( at ) ) {
                //idump((fc::json::to_pretty_string(at)));
                auto& chain = chain_plug->chain();
                chainbase::database& db = const_cast<chainbase::database&>( chain.db() ); // Override read-only access to state DB (highly unrecommended practice!)
@@ -286,6 +322,61 @@ namespace eosio {
                on_action_trace( atrace );
             }
          }
+
+         void on_block_start( uint32_t block_num ) {
+            // actions of an aborted block
+            pending_actions.clear();
+         }
+
+         void on_accepted_block( const block_state_ptr& bsp ) {
+            reversible_blocks[bsp->id] = reversible_history_block{ bsp->id, bsp->block_num, bsp->header.timestamp, std::move( pending_actions ) };
+            pending_actions.clear();
+         }
+
+         void on_irreversible_block( const block_state_ptr& bsp ) {
+            auto itr = reversible_blocks.find( bsp->id );
+            if( itr != reversible_blocks.end() ) {
+               auto blk = std::make_shared<reversible_history_block>( std::move( itr->second ) );
+               store_executor->post( [store = store, blk]() {
+                  store->append_block( blk->block_num, blk->block_time, blk->actions );
+               } );
+            }
+            // blocks of forks which did not become irreversible
+            for( auto i = reversible_blocks.begin(); i != reversible_blocks.end(); ) {
+               if( i->second.block_num <= bsp->block_num )
+                  i = reversible_blocks.erase( i );
+               else
+                  ++i;
+            }
+         }
+
+         /// keep the actions of the reversible blocks across a restart, they are not applied again
+         void save_reversible_blocks() {
+            std::vector<reversible_history_block> blocks;
+            blocks.reserve( reversible_blocks.size() );
+            for( auto& [id, blk] : reversible_blocks )
+               blocks.emplace_back( std::move( blk ) );
+            reversible_blocks.clear();
+            auto data = fc::raw::pack( blocks );
+            std::ofstream out( ( store_dir / "reversible.bin" ).generic_string(), std::ios::binary | std::ios::trunc );
+            out.write( data.data(), data.size() );
+            if( !out ) elog( "unable to save the history of reversible blocks to ${d}", ("d", store_dir) );
+         }
+
+         void load_reversible_blocks() {
+            const auto path = store_dir / "reversible.bin";
+            if( !fc::exists( path ) ) return;
+            std::ifstream in( path.generic_string(), std::ios::binary );
+            std::vector<char> data( (std::istreambuf_iterator<char>( in )), std::istreambuf_iterator<char>() );
+            std::vector<reversible_history_block> blocks;
+            fc::datastream<const char*> ds( data.data(), data.size() );
+            fc::raw::unpack( ds, blocks );
+            for( auto& blk : blocks ) {
+               if( blk.block_num > store->last_block_num() )
+                  reversible_blocks[blk.id] = std::move( blk );
+            }
+            fc::remove( path );
+         }
    };
 
    history_plugin::history_plugin()
@@ -306,6 +397,14 @@ namespace eosio {
             ("filter-out,F", bpo::value<vector<string>>()->composing(),
              "Do not track actions which match receiver:action:actor. Action and Actor both blank excludes all from Reciever. Actor blank excludes all from reciever:action. Receiver may not be blank.")
             ;
+      cfg.add_options()
+            ("history-store", bpo::value<string>()->default_value("chainbase"),
+             "Where tracked actions are kept:\n"
+             "  \"chainbase\" - in the state database, including actions of reversible blocks\n"
+             "  \"log\" - in an actions log indexed in RocksDB under history-dir, actions of irreversible blocks only")
+            ("history-dir", bpo::value<bfs::path>()->default_value("history"),
+             "the location of the history store when history-store = log (absolute path or relative to application data dir)")
+            ;
    }
 
    void history_plugin::plugin_initialize(const variables_map& options) {
@@ -351,6 +450,31 @@ namespace eosio {
          db.add_index<account_control_history_multi_index>();
          db.add_index<public_key_history_multi_index>();
 
+         const auto store_type = options.at( "history-store" ).as<string>();
+         EOS_ASSERT( store_type == "chainbase" || store_type == "log", plugin_config_exception,
+                     "Invalid value ${s} for --history-store, expected chainbase or log", ("s", store_type) );
+         if( store_type == "log" ) {
+            auto dir = options.at( "history-dir" ).as<bfs::path>();
+            my->store_dir = dir.is_relative() ? app().data_dir() / dir : dir;
+            my->store = std::make_shared<history_log_store>( my->store_dir );
+            my->store_executor = std::make_unique<bounded_serial_executor>( "hist", history_plugin_impl::max_queued_store_blocks );
+            my->load_reversible_blocks();
+            ilog( "history store ${d} has actions up to block ${n}", ("d", my->store_dir)("n", my->store->last_block_num()) );
+
+            my->block_start_connection.emplace(
+                  chain.block_start.connect( [&]( uint32_t block_num ) {
+                     my->on_block_start( block_num );
+                  } ));
+            my->accepted_block_connection.emplace(
+                  chain.accepted_block.connect( [&]( const block_state_ptr& bsp ) {
+                     my->on_accepted_block( bsp );
+                  } ));
+            my->irreversible_block_connection.emplace(
+                  chain.irreversible_block.connect( [&]( const block_state_ptr& bsp ) {
+                     my->on_irreversible_block( bsp );
+                  } ));
+         }
+
          my->applied_transaction_connection.emplace(
                chain.applied_transaction.connect( [&]( std::tuple<const transaction_trace_ptr&, const packed_transaction_ptr&> t ) {
                   my->on_applied_transaction( std::get<0>(t) );
@@ -363,6 +487,13 @@ namespace eosio {
 
    void history_plugin::plugin_shutdown() {
       my->applied_transaction_connection.reset();
+      my->block_start_connection.reset();
+      my->accepted_block_connection.reset();
+      my->irreversible_block_connection.reset();
+      if( my->store ) {
+         my->store_executor->stop();
+         my->save_reversible_blocks();
+      }
    }
 
 
@@ -383,7 +514,10 @@ namespace eosio {
         int32_t offset = params.offset ? *params.offset : -20;
         auto n = params.account_name;
         idump((pos));
-        if( pos == -1 ) {
+        if( pos == -1 && history->store ) {
+            if( auto last = history->store->last_account_sequence_num( n ) )
+               pos = *last + 1;
+        } else if( pos == -1 ) {
             auto itr = idx.lower_bound( boost::make_tuple( name(n.to_uint64_t()+1), 0 ) );
             if( itr == idx.begin() ) {
                if( itr->account == n )
@@ -408,14 +542,37 @@ namespace eosio {
 
         idump((start)(end));
 
-        auto start_itr = idx.lower_bound( boost::make_tuple( n, start ) );
-        auto end_itr = idx.upper_bound( boost::make_tuple( n, end) );
-
         auto start_time = fc::time_point::now();
         auto end_time = start_time;
 
         get_actions_result result;
         result.last_irreversible_block = chain.last_irreversible_block_num();
+
+        if( history->store ) {
+           history->store->for_each_account_action( n, start, end, [&]( history_log_store::action_result&& a ) {
+              fc::datastream<const char*> ds( a.packed_action_trace.data(), a.packed_action_trace.size() );
+              action_trace t;
+              fc::raw::unpack( ds, t );
+              result.actions.emplace_back( ordered_action_result{
+                                    a.action_sequence_num,
+                                    a.account_sequence_num,
+                                    a.block_num, a.block_time,
+                                    chain.to_variant_with_abi(t, abi_serializer::create_yield_function( abi_serializer_max_time ))
+                                    });
+
+              end_time = fc::time_point::now();
+              if( end_time - start_time > fc::microseconds(100000) ) {
+                 result.time_limit_exceeded_error = true;
+                 return false;
+              }
+              return true;
+           } );
+           return result;
+        }
+
+        auto start_itr = idx.lower_bound( boost::make_tuple( n, start ) );
+        auto end_itr = idx.upper_bound( boost::make_tuple( n, end) );
+
         while( start_itr != end_itr ) {
            const auto& a = db.get<action_history_object, by_action_sequence_num>( start_itr->action_sequence_num );
            fc::datastream<const char*> ds( a.packed_action_trace.data(), a.packed_action_trace.size() );
@@ -462,33 +619,54 @@ namespace eosio {
             return (*(input_id.data() + input_id_size) & 0xF0) == (*(id.data() + input_id_size) & 0xF0);
          };
 
-         const auto& db = chain.db();
-         const auto& idx = db.get_index<action_history_index, by_trx_id_act_seq>();
-         auto itr = idx.lower_bound( boost::make_tuple( input_id ) );
+         get_transaction_result result;
+         bool in_history = false;
+
+         if( history->store ) {
+            history->store->for_each_transaction_action( input_id, [&]( history_log_store::action_result&& a ) {
+               if( !in_history ) {
+                  if( !txn_id_matched( a.trx_id ) ) return false;
+                  in_history = true;
+                  result.id         = a.trx_id;
+                  result.block_num  = a.block_num;
+                  result.block_time = a.block_time;
+               }
+               fc::datastream<const char*> ds( a.packed_action_trace.data(), a.packed_action_trace.size() );
+               action_trace t;
+               fc::raw::unpack( ds, t );
+               result.traces.emplace_back( chain.to_variant_with_abi(t, abi_serializer::create_yield_function( abi_serializer_max_time )) );
+               return true;
+            } );
+         } else {
+            const auto& db = chain.db();
+            const auto& idx = db.get_index<action_history_index, by_trx_id_act_seq>();
+            auto itr = idx.lower_bound( boost::make_tuple( input_id ) );
+
+            in_history = (itr != idx.end() && txn_id_matched(itr->trx_id) );
 
-         bool in_history = (itr != idx.end() && txn_id_matched(itr->trx_id) );
+            if( in_history ) {
+               result.id         = itr->trx_id;
+               result.block_num  = itr->block_num;
+               result.block_time = itr->block_time;
+
+               while( itr != idx.end() && itr->trx_id == result.id ) {
+
+                 fc::datastream<const char*> ds( itr->packed_action_trace.data(), itr->packed_action_trace.size() );
+                 action_trace t;
+                 fc::raw::unpack( ds, t );
+                 result.traces.emplace_back( chain.to_variant_with_abi(t, abi_serializer::create_yield_function( abi_serializer_max_time )) );
+
+                 ++itr;
+               }
+            }
+         }
 
          if( !in_history && !p.block_num_hint ) {
             EOS_THROW(tx_not_found, "Transaction ${id} not found in history and no block hint was given", ("id",p.id));
          }
 
-         get_transaction_result result;
-
          if( in_history ) {
-            result.id         = itr->trx_id;
             result.last_irreversible_block = chain.last_irreversible_block_num();
-            result.block_num  = itr->block_num;
-            result.block_time = itr->block_time;
-
-            while( itr != idx.end() && itr->trx_id == result.id ) {
-
-              fc::datastream<const char*> ds( itr->packed_action_trace.data(), itr->packed_action_trace.size() );
-              action_trace t;
-              fc::raw::unpack( ds, t );
-              result.traces.emplace_back( chain.to_variant_with_abi(t, abi_serializer::create_yield_function( abi_serializer_max_time )) );
-
-              ++itr;
-            }
 
             auto blk = chain.fetch_block_by_number( result.block_num );
             if( blk || chain.is_building_block() ) {
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+#include <eosio/chain/block_timestamp.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace eosio {
+
+   /**
+    * Action history kept outside of the state db: packed action traces are appended to an actions log and
+    * indexed by global sequence, by account and by transaction id in RocksDB. Only irreversible blocks are
+    * appended, so nothing is ever removed or undone.
+    *
+    * append_block is called from one thread at a time, the other methods may be called from any thread
+    * concurrently with it.
+    */
+   class history_log_store {
+   public:
+      struct action_entry {
+         uint64_t                          action_sequence_num = 0; ///< global sequence of the action
+         chain::transaction_id_type        trx_id;
+         std::vector<chain::account_name>  accounts;                ///< accounts which have the action in their history
+         std::vector<char>                 packed_action_trace;
+      };
+
+      struct action_result {
+         uint64_t                     action_sequence_num = 0;
+         int32_t                      account_sequence_num = 0;   ///< 0 when not looked up by account
+         uint32_t                     block_num = 0;
+         chain::block_timestamp_type  block_time;
+         chain::transaction_id_type   trx_id;
+         std::vector<char>            packed_action_trace;
+      };
+
+      /// open or create the store in dir, dropping a partially appended block
+      explicit history_log_store( const fc::path& dir );
+      ~history_log_store();
+
+      /// last block appended, 0 when none
+      uint32_t last_block_num()const;
+
+      /**
+       * Append the actions of block block_num, ignored when block_num is not after last_block_num().
+       * The actions and their index are durable when this returns.
+       */
+      void append_block( uint32_t block_num, chain::block_timestamp_type block_time, const std::vector<action_entry>& actions );
+
+      /// account sequence number of the last action of account
+      std::optional<int32_t> last_account_sequence_num( chain::account_name account )const;
+
+      /**
+       * Call f with the actions of account with an account sequence number in [start, end], in order, until f
+       * returns false
+       */
+      void for_each_account_action( chain::account_name account, int32_t start, int32_t end,
+                                    const std::function<bool(action_result&&)>& f )const;
+
+      /**
+       * Call f with the actions of the first transaction with an id not less than id, in order, until f returns
+       * false
+       */
+      void for_each_transaction_action( const chain::transaction_id_type& id,
+                                        const std::function<bool(action_result&&)>& f )const;
+
+   private:
+      struct impl;
+      std::unique_ptr<impl> my;
+   };
+
+} /// namespace eosio
+
+FC_REFLECT( eosio::history_log_store::action_entry, (action_sequence_num)(trx_id)(accounts)(packed_action_trace) )
@@ -46,6 +46,7 @@ void http_client_plugin::plugin_initialize(const variables_map& options) {
 
             try {
                my->add_cert( pem_str );
+               root_certs.push_back( pem_str );
             } catch ( const std::bad_alloc& ) {
               throw;
             } catch ( const boost::interprocess::bad_alloc& ) {
@@ -58,10 +59,19 @@ void http_client_plugin::plugin_initialize(const variables_map& options) {
          }
       }
 
-      my->set_verify_peers( options.at( "https-client-validate-peers" ).as<bool>());
+      verify_peers = options.at( "https-client-validate-peers" ).as<bool>();
+      my->set_verify_peers( verify_peers );
    } FC_LOG_AND_RETHROW()
 }
 
+std::unique_ptr<http_client> http_client_plugin::make_client() const {
+   auto client = std::make_unique<http_client>();
+   for( const auto& pem : root_certs )
+      client->add_cert( pem );
+   client->set_verify_peers( verify_peers );
+   return client;
+}
+
 void http_client_plugin::plugin_startup() {
 
 }
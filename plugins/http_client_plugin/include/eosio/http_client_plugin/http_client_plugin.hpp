@@ -23,8 +23,13 @@ namespace eosio {
            return *my;
         }
 
+        /// a separate client with the same TLS settings, for a thread that keeps its own connections
+        std::unique_ptr<http_client> make_client() const;
+
       private:
         std::unique_ptr<http_client> my;
+        std::vector<std::string>     root_certs;
+        bool                         verify_peers = true;
    };
 
 }
@@ -1,4 +1,7 @@
 #include <eosio/http_plugin/http_plugin.hpp>
+#include <eosio/http_plugin/http_metrics.hpp>
+#include <eosio/http_plugin/main_thread_queue.hpp>
+#include <eosio/http_plugin/response_cache.hpp>
 #ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
 #include <eosio/http_plugin/local_endpoint.hpp>
 #endif
@@ -14,6 +17,9 @@
 
 #include <boost/asio.hpp>
 #include <boost/optional.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/ssl.hpp>
 
 #include <websocketpp/config/asio_client.hpp>
 #include <websocketpp/config/asio.hpp>
@@ -22,6 +28,7 @@
 #include <websocketpp/client.hpp>
 #include <websocketpp/logger/stub.hpp>
 
+#include <deque>
 #include <thread>
 #include <memory>
 #include <regex>
@@ -34,6 +41,7 @@ namespace eosio {
    static appbase::abstract_plugin& _http_plugin = app().register_plugin<http_plugin>();
 
    namespace asio = boost::asio;
+   namespace beast = boost::beast;
 
    using std::map;
    using std::vector;
@@ -127,23 +135,49 @@ namespace eosio {
           static const long timeout_open_handshake = 0;
       };
 #endif
+      /**
+       * requests in flight of the endpoints added with an api class, see http-api-class-limit
+       */
+      struct api_class_state {
+         explicit api_class_state(string name) : name(std::move(name)) {}
+
+         const string           name;
+         int32_t                max_in_flight = -1;
+         std::atomic<int32_t>   in_flight{0};
+         std::atomic<uint64_t>  admitted{0};
+         std::atomic<uint64_t>  rejected{0};
+      };
+
+      using api_class_ptr = std::shared_ptr<api_class_state>;
+
       /**
        * virtualized wrapper for the various underlying connection functions needed in req/resp processng
        */
       struct abstract_conn {
-         virtual ~abstract_conn() = default;
+         virtual ~abstract_conn() {
+            if( api_class ) api_class->in_flight -= 1;
+         }
          virtual bool verify_max_bytes_in_flight() = 0;
          virtual bool verify_max_requests_in_flight() = 0;
          virtual void handle_exception() = 0;
 
-         virtual void send_response(std::optional<std::string> body, int code) = 0;
+         virtual void send_response(std::optional<std::string> body, int code, const char* content_type) = 0;
+         virtual void append_header(const std::string& key, const std::string& value) = 0;
+
+         /// class of the endpoint requested, its in_flight counts this request while set
+         api_class_ptr api_class;
+
+         /// metrics of the endpoint requested, nullptr until it is found
+         std::shared_ptr<endpoint_metrics> metrics;
+         request_timing                    timing;
+
+         /// key of the request in the response cache, empty when its response is not cached
+         std::string                       cache_key;
+         uint64_t                          cache_generation = 0;
       };
 
       using abstract_conn_ptr = std::shared_ptr<abstract_conn>;
 
-      template<typename T>
-      using connection_ptr = typename websocketpp::server<T>::connection_ptr;
-
       /**
        * internal url handler that contains more parameters than the handlers provided by external systems
        */
@@ -186,6 +220,21 @@ namespace eosio {
          }
          return 0;
       }
+
+      /**
+       * Helper method to calculate the "in flight" size of a url_response_body
+       *
+       * @param b - the url_response_body
+       * @return in flight size of the variant or JSON text held by b
+       */
+      static size_t in_flight_sizeof( const url_response_body& b ) {
+         if( const auto* j = std::get_if<json_response_body>( &b ) ) {
+            return in_flight_sizeof( j->json );
+         } else if( std::holds_alternative<packed_response_body>( b ) ) {
+            return 0; // not encoded yet, the encoded response is tracked
+         }
+         return in_flight_sizeof( std::get<std::optional<fc::variant>>( b ) );
+      }
    }
 
    using websocket_server_type = websocketpp::server<detail::asio_with_stub_log<websocketpp::transport::asio::basic_socket::endpoint>>;
@@ -195,6 +244,10 @@ namespace eosio {
    using websocket_server_tls_type =  websocketpp::server<detail::asio_with_stub_log<websocketpp::transport::asio::tls_socket::endpoint>>;
    using ssl_context_ptr =  websocketpp::lib::shared_ptr<websocketpp::lib::asio::ssl::context>;
    using http_plugin_impl_ptr = std::shared_ptr<class http_plugin_impl>;
+   class beast_http_listener;
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+   class local_rpc_listener;
+#endif
 
    static bool verbose_http_errors = false;
 
@@ -208,14 +261,38 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
          http_plugin_impl& operator=(const http_plugin_impl&) = delete;
          http_plugin_impl& operator=(http_plugin_impl&&) = delete;
 
+         struct url_handler_entry {
+            detail::internal_url_handler               handler;
+            detail::api_class_ptr                      api_class;
+            std::shared_ptr<detail::endpoint_metrics>  metrics;
+            bool                                       cacheable = false; ///< see http_plugin::enable_response_cache
+         };
+
          // key -> priority, url_handler
-         map<string,detail::internal_url_handler>  url_handlers;
+         map<string,url_handler_entry>  url_handlers;
+         map<string,int32_t>            api_class_limits; ///< http-api-class-limit
+         map<string,detail::api_class_ptr> api_classes;
+
+         const detail::api_class_ptr& get_api_class( const string& name ) {
+            auto& c = api_classes[name];
+            if( !c ) {
+               c = std::make_shared<detail::api_class_state>( name );
+               if( auto itr = api_class_limits.find( name ); itr != api_class_limits.end() )
+                  c->max_in_flight = itr->second;
+            }
+            return c;
+         }
          std::optional<tcp::endpoint>  listen_endpoint;
          string                         access_control_allow_origin;
          string                         access_control_allow_headers;
          string                         access_control_max_age;
          bool                           access_control_allow_credentials = false;
          size_t                         max_body_size{1024*1024};
+         fc::microseconds               slow_request_time{0}; ///< http-slow-request-ms
+         uint32_t                       slow_request_log_sample = 1;
+         static constexpr size_t        slow_request_body_prefix = 256;
+         std::optional<detail::response_cache> response_cache; ///< set when http-response-cache-ttl-ms is not 0
+         vector<std::function<string()>> metrics_providers; ///< see http_plugin::add_metrics_provider
 
          websocket_server_type    server;
 
@@ -234,9 +311,16 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
 
          websocket_server_tls_type https_server;
 
+         bool                                   keep_alive = false;
+         std::chrono::seconds                   keep_alive_timeout{60};
+         std::shared_ptr<beast_http_listener>   beast_listener;
+         std::shared_ptr<beast_http_listener>   beast_https_listener;
+
 #ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
          std::optional<asio::local::stream_protocol::endpoint> unix_endpoint;
          websocket_local_server_type unix_server;
+         std::optional<asio::local::stream_protocol::endpoint> local_rpc_endpoint;
+         std::shared_ptr<local_rpc_listener>                   local_rpc;
 #endif
 
          bool                     validate_host = true;
@@ -296,8 +380,8 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
             return ctx;
          }
 
-         template<class T>
-         static void handle_exception(detail::connection_ptr<T> con) {
+         template<class ConnPtr>
+         static void handle_exception(const ConnPtr& con) {
             string err = "Internal Service error, http: ";
             const auto deadline = fc::time_point::now() + fc::exception::format_time_limit;
             try {
@@ -337,8 +421,9 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
             con->send_http_response();
          }
 
-         template<class T>
-         bool allow_host(const typename T::request_type& req, detail::connection_ptr<T> con) {
+         template<class ConnPtr>
+         bool allow_host(const ConnPtr& con) {
+            const auto& req = con->get_request();
             bool is_secure = con->get_uri()->get_secure();
             const auto& local_endpoint = con->get_socket().lowest_layer().local_endpoint();
             auto local_socket_host_port = local_endpoint.address().to_string() + ":" + std::to_string(local_endpoint.port());
@@ -391,15 +476,34 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
             return true;
          }
 
+         /**
+          * Admit the request of conn to the class of its endpoint, or respond 429 when the class already has
+          * its http-api-class-limit requests in flight
+          */
+         template<typename T>
+         bool verify_api_class( const T& con, detail::abstract_conn& conn, const detail::api_class_ptr& api_class ) {
+            conn.api_class = api_class;
+            auto in_flight = api_class->in_flight += 1;
+            if( api_class->max_in_flight >= 0 && in_flight > api_class->max_in_flight ) {
+               api_class->rejected += 1;
+               fc_dlog( logger, "429 - too many ${c} requests in flight: ${requests}", ("c", api_class->name)("requests", in_flight) );
+               string what = "Too many " + api_class->name + " requests in flight: " + std::to_string( in_flight ) + ". Try again later.";
+               report_429_error(con, what);
+               return false;
+            }
+            api_class->admitted += 1;
+            return true;
+         }
+
          /**
           * child struct, implementing abstract connection for various underlying connection types
           * that ties it to an http_plugin_impl
           *
-          * @tparam T - The downstream parameter for the connection_ptr
+          * @tparam ConnPtr - The connection_ptr of the underlying connection type
           */
-         template<typename T>
+         template<typename ConnPtr>
          struct abstract_conn_impl : public detail::abstract_conn {
-            abstract_conn_impl(detail::connection_ptr<T> conn, http_plugin_impl_ptr impl)
+            abstract_conn_impl(ConnPtr conn, http_plugin_impl_ptr impl)
             :_conn(std::move(conn))
             ,_impl(std::move(impl))
             {
@@ -426,10 +530,13 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
             }
 
             void handle_exception()override {
-               http_plugin_impl::handle_exception<T>(_conn);
+               http_plugin_impl::handle_exception(_conn);
             }
 
-            void send_response(std::optional<std::string> body, int code) override {
+            void send_response(std::optional<std::string> body, int code, const char* content_type) override {
+               if( content_type ) {
+                  _conn->replace_header( "Content-type", content_type );
+               }
                if( body ) {
                   _conn->set_body( std::move( *body ) );
                }
@@ -437,20 +544,24 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
                _conn->send_http_response();
             }
 
-            detail::connection_ptr<T> _conn;
+            void append_header(const std::string& key, const std::string& value) override {
+               _conn->append_header( key, value );
+            }
+
+            ConnPtr _conn;
             http_plugin_impl_ptr _impl;
          };
 
          /**
           * Helper to construct an abstract_conn_impl for a given connection and instance of http_plugin_impl
-          * @tparam T - The downstream parameter for the connection_ptr
-          * @param conn - existing connection_ptr<T>
+          * @tparam ConnPtr - The connection_ptr of the underlying connection type
+          * @param conn - existing connection
           * @param impl - the owning http_plugin_impl
           * @return abstract_conn_ptr backed by type specific implementations of the methods
           */
-         template<typename T>
-         static detail::abstract_conn_ptr make_abstract_conn_ptr( detail::connection_ptr<T> conn, http_plugin_impl_ptr impl ) {
-            return std::make_shared<abstract_conn_impl<T>>(std::move(conn), std::move(impl));
+         template<typename ConnPtr>
+         static detail::abstract_conn_ptr make_abstract_conn_ptr( ConnPtr conn, http_plugin_impl_ptr impl ) {
+            return std::make_shared<abstract_conn_impl<ConnPtr>>(std::move(conn), std::move(impl));
          }
 
          /**
@@ -542,14 +653,15 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
                   return;
                }
 
-               url_response_callback wrapped_then = [tracked_b, then=std::move(then)](int code, std::optional<fc::variant> resp) {
+               url_response_callback wrapped_then = [tracked_b, then=std::move(then)](int code, url_response_body resp) {
                   then(code, std::move(resp));
                };
 
                // post to the app thread taking shared ownership of next (via std::shared_ptr),
                // sole ownership of the tracked body and the passed in parameters
-               app().post( priority, [next_ptr, conn=std::move(conn), r=std::move(r), tracked_b, wrapped_then=std::move(wrapped_then)]() mutable {
+               main_thread_post( priority, [next_ptr, conn=std::move(conn), r=std::move(r), tracked_b, wrapped_then=std::move(wrapped_then)]() mutable {
                   try {
+                     conn->timing.handler_start = fc::time_point::now();
                      // call the `next` url_handler and wrap the response handler
                      (*next_ptr)( std::move( r ), std::move(tracked_b->obj()), std::move(wrapped_then)) ;
                   } catch( ... ) {
@@ -569,6 +681,7 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
          static detail::internal_url_handler make_http_thread_url_handler(url_handler next) {
             return [next=std::move(next)]( const detail::abstract_conn_ptr& conn, string r, string b, url_response_callback then ) {
                try {
+                  conn->timing.handler_start = fc::time_point::now();
                   next(std::move(r), std::move(b), std::move(then));
                } catch( ... ) {
                   conn->handle_exception();
@@ -581,27 +694,61 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
           * JSON-stringify the provided response
           *
           * @param con - pointer for the connection this response should be sent to
+          * @param accept_binary - the request accepts binary_content_type
+          * @param if_none_match - If-None-Match header of the request
           * @return lambda suitable for url_response_callback
           */
-         template<typename T>
-         auto make_http_response_handler( const detail::abstract_conn_ptr& abstract_conn_ptr) {
-            return [my=shared_from_this(), abstract_conn_ptr]( int code, std::optional<fc::variant> response ) {
+         auto make_http_response_handler( const detail::abstract_conn_ptr& abstract_conn_ptr, bool accept_binary, std::string if_none_match ) {
+            return [my=shared_from_this(), abstract_conn_ptr, accept_binary, if_none_match=std::move(if_none_match)]( int code, url_response_body response ) {
+               abstract_conn_ptr->timing.responded = fc::time_point::now();
                auto tracked_response = make_in_flight(std::move(response), my);
                if (!abstract_conn_ptr->verify_max_bytes_in_flight()) {
                   return;
                }
 
                // post  back to an HTTP thread to to allow the response handler to be called from any thread
+               // the response is released as soon as it is encoded, so it is not held in memory with its encoding
                boost::asio::post( my->thread_pool->get_executor(),
-                                  [my, abstract_conn_ptr, code, tracked_response=std::move(tracked_response)]() {
+                                  [my, abstract_conn_ptr, code, accept_binary, if_none_match, tracked_response=std::move(tracked_response)]() mutable {
                   try {
-                     if( tracked_response->obj().has_value() ) {
-                        std::string json = fc::json::to_string( *tracked_response->obj(), fc::time_point::now() + my->max_response_time );
-                        auto tracked_json = make_in_flight( std::move( json ), my );
-                        abstract_conn_ptr->send_response( std::move( tracked_json->obj() ), code );
-                     } else {
-                        abstract_conn_ptr->send_response( {}, code );
+                     abstract_conn_ptr->timing.response_start = fc::time_point::now();
+                     std::optional<std::string> body;
+                     std::shared_ptr<in_flight<std::string>> tracked_body;
+                     const char* content_type = nullptr;
+                     int status = code;
+                     if( auto* j = std::get_if<json_response_body>( &tracked_response->obj() ) ) {
+                        content_type = j->content_type;
+                        if( !j->etag.empty() ) {
+                           abstract_conn_ptr->append_header( "ETag", j->etag );
+                        }
+                        if( !j->etag.empty() && code == websocketpp::http::status_code::ok && if_none_match.find( j->etag ) != std::string::npos ) {
+                           status = websocketpp::http::status_code::not_modified;
+                        } else {
+                           body = std::move( j->json );
+                        }
+                     } else if( auto* p = std::get_if<packed_response_body>( &tracked_response->obj() ) ) {
+                        if( accept_binary ) {
+                           tracked_body = make_in_flight( p->pack(), my );
+                           content_type = binary_content_type;
+                        } else {
+                           tracked_body = make_in_flight( fc::json::to_string( p->to_variant(), fc::time_point::now() + my->max_response_time ), my );
+                        }
+                        tracked_response.reset();
+                     } else if( const auto& obj = std::get<std::optional<fc::variant>>( tracked_response->obj() ); obj.has_value() ) {
+                        tracked_body = make_in_flight( fc::json::to_string( *obj, fc::time_point::now() + my->max_response_time ), my );
+                        tracked_response.reset();
+                     }
+                     if( tracked_body ) {
+                        body = std::move( tracked_body->obj() );
                      }
+                     abstract_conn_ptr->timing.encoded = fc::time_point::now();
+                     if( !abstract_conn_ptr->cache_key.empty() && status == websocketpp::http::status_code::ok && body ) {
+                        my->response_cache->put( abstract_conn_ptr->cache_key, std::make_shared<const std::string>( *body ),
+                                                 content_type, abstract_conn_ptr->cache_generation );
+                     }
+                     const size_t response_size = body ? body->size() : 0;
+                     abstract_conn_ptr->send_response( std::move( body ), status, content_type );
+                     my->record_metrics( *abstract_conn_ptr, response_size );
                   } catch( ... ) {
                      abstract_conn_ptr->handle_exception();
                   }
@@ -609,12 +756,114 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
             };
          }
 
-         template<class T>
-         void handle_http_request(detail::connection_ptr<T> con) {
+         void send_cached_response( detail::abstract_conn& conn, const std::string& body, const char* content_type ) {
+            auto& t = conn.timing;
+            t.handler_start = t.responded = t.response_start = t.encoded = fc::time_point::now();
+            conn.send_response( body, websocketpp::http::status_code::ok, content_type );
+            record_metrics( conn, body.size() );
+         }
+
+         /// add the timings of the request of conn to the metrics of its endpoint, log it when slow
+         void record_metrics( const detail::abstract_conn& conn, size_t response_size ) {
+            if( !conn.metrics ) return;
+            auto& m = *conn.metrics;
+            const auto& t = conn.timing;
+            auto elapsed = []( const fc::time_point& from, const fc::time_point& to ) -> uint64_t {
+               return to > from ? ( to - from ).count() : 0;
+            };
+            const auto handler_start = t.handler_start == fc::time_point() ? t.received : t.handler_start;
+            const auto wait = elapsed( t.received, handler_start );
+            const auto execution = elapsed( handler_start, t.responded );
+            const auto response_wait = elapsed( t.responded, t.response_start );
+            const auto serialization = elapsed( t.response_start, t.encoded );
+            const auto total = elapsed( t.received, t.encoded );
+            m.wait.observe( wait );
+            m.execution.observe( execution );
+            m.response_wait.observe( response_wait );
+            m.serialization.observe( serialization );
+            m.total.observe( total );
+            m.request_size.observe( t.request_size );
+            m.response_size.observe( response_size );
+
+            if( slow_request_time.count() > 0 && total >= static_cast<uint64_t>( slow_request_time.count() ) ) {
+               if( m.slow++ % slow_request_log_sample == 0 ) {
+                  fc_wlog( logger, "slow request ${ep} ${t}us: wait ${w}us, execution ${e}us, response wait ${r}us, "
+                                   "serialization ${s}us, request ${rq} bytes, response ${rs} bytes, body: ${b}",
+                           ("ep", m.endpoint)("t", total)("w", wait)("e", execution)("r", response_wait)("s", serialization)
+                           ("rq", t.request_size)("rs", response_size)("b", t.body_prefix) );
+               }
+            }
+         }
+
+         /// metrics of the endpoints and api classes in the Prometheus text format
+         string prometheus_metrics() const {
+            string out;
+            out += "# HELP nodeos_http_request_duration_seconds Time of the phases of the requests of an endpoint\n"
+                   "# TYPE nodeos_http_request_duration_seconds histogram\n";
+            for( const auto& [url, e] : url_handlers ) {
+               const auto& m = *e.metrics;
+               const string labels = "endpoint=\"" + url + "\"";
+               m.wait.write( out, "nodeos_http_request_duration_seconds", labels + ",phase=\"wait\"", 1e6 );
+               m.execution.write( out, "nodeos_http_request_duration_seconds", labels + ",phase=\"execution\"", 1e6 );
+               m.response_wait.write( out, "nodeos_http_request_duration_seconds", labels + ",phase=\"response_wait\"", 1e6 );
+               m.serialization.write( out, "nodeos_http_request_duration_seconds", labels + ",phase=\"serialization\"", 1e6 );
+               m.total.write( out, "nodeos_http_request_duration_seconds", labels + ",phase=\"total\"", 1e6 );
+            }
+            out += "# HELP nodeos_http_request_size_bytes Size of the request bodies of an endpoint\n"
+                   "# TYPE nodeos_http_request_size_bytes histogram\n";
+            for( const auto& [url, e] : url_handlers ) {
+               e.metrics->request_size.write( out, "nodeos_http_request_size_bytes", "endpoint=\"" + url + "\"", 1 );
+            }
+            out += "# HELP nodeos_http_response_size_bytes Size of the response bodies of an endpoint\n"
+                   "# TYPE nodeos_http_response_size_bytes histogram\n";
+            for( const auto& [url, e] : url_handlers ) {
+               e.metrics->response_size.write( out, "nodeos_http_response_size_bytes", "endpoint=\"" + url + "\"", 1 );
+            }
+            out += "# HELP nodeos_http_slow_requests_total Requests of an endpoint slower than http-slow-request-ms\n"
+                   "# TYPE nodeos_http_slow_requests_total counter\n";
+            for( const auto& [url, e] : url_handlers ) {
+               out += "nodeos_http_slow_requests_total{endpoint=\"" + url + "\"} " + std::to_string( e.metrics->slow.load() ) + "\n";
+            }
+            out += "# HELP nodeos_http_api_class_in_flight Requests of an api class waiting for or being processed\n"
+                   "# TYPE nodeos_http_api_class_in_flight gauge\n";
+            for( const auto& [name, c] : api_classes ) {
+               out += "nodeos_http_api_class_in_flight{class=\"" + name + "\"} " + std::to_string( c->in_flight.load() ) + "\n";
+            }
+            out += "# HELP nodeos_http_api_class_requests_total Requests of an api class by admission\n"
+                   "# TYPE nodeos_http_api_class_requests_total counter\n";
+            for( const auto& [name, c] : api_classes ) {
+               out += "nodeos_http_api_class_requests_total{class=\"" + name + "\",result=\"admitted\"} " + std::to_string( c->admitted.load() ) + "\n";
+               out += "nodeos_http_api_class_requests_total{class=\"" + name + "\",result=\"rejected\"} " + std::to_string( c->rejected.load() ) + "\n";
+            }
+            if( response_cache ) {
+               out += "# HELP nodeos_http_response_cache_requests_total Requests of cacheable endpoints by response cache result\n"
+                      "# TYPE nodeos_http_response_cache_requests_total counter\n"
+                      "nodeos_http_response_cache_requests_total{result=\"hit\"} " + std::to_string( response_cache->get_hits() ) + "\n"
+                      "nodeos_http_response_cache_requests_total{result=\"miss\"} " + std::to_string( response_cache->get_misses() ) + "\n";
+            }
+            out += "# HELP nodeos_http_bytes_in_flight Bytes of the requests and responses being processed\n"
+                   "# TYPE nodeos_http_bytes_in_flight gauge\n"
+                   "nodeos_http_bytes_in_flight " + std::to_string( bytes_in_flight.load() ) + "\n";
+            out += "# HELP nodeos_http_requests_in_flight Requests being processed\n"
+                   "# TYPE nodeos_http_requests_in_flight gauge\n"
+                   "nodeos_http_requests_in_flight " + std::to_string( requests_in_flight.load() ) + "\n";
+            out += main_thread_queue_metrics::instance().prometheus_metrics();
+            for( const auto& provider : metrics_providers ) {
+               out += provider();
+            }
+            return out;
+         }
+
+         /**
+          * @tparam ConnPtr - websocketpp connection_ptr, or beast_http_request_ptr of a beast_http_session
+          */
+         template<class ConnPtr>
+         void handle_http_request(const ConnPtr& con) {
+            const auto received = fc::time_point::now();
             try {
                auto& req = con->get_request();
 
-               if(!allow_host<T>(req, con))
+               if(!allow_host(con))
                   return;
 
                if( !access_control_allow_origin.empty()) {
@@ -638,14 +887,34 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
                con->append_header( "Content-type", "application/json" );
                con->defer_http_response();
 
-               auto abstract_conn_ptr = make_abstract_conn_ptr<T>(con, shared_from_this());
+               auto abstract_conn_ptr = make_abstract_conn_ptr(con, shared_from_this());
                if( !verify_max_bytes_in_flight( con ) || !verify_max_requests_in_flight( con ) ) return;
 
                std::string resource = con->get_uri()->get_resource();
                auto handler_itr = url_handlers.find( resource );
                if( handler_itr != url_handlers.end()) {
+                  abstract_conn_ptr->metrics = handler_itr->second.metrics;
+                  abstract_conn_ptr->timing.received = received;
+                  const bool accept_binary = req.get_header( "Accept" ).find( binary_content_type ) != std::string::npos;
                   std::string body = con->get_request_body();
-                  handler_itr->second( abstract_conn_ptr, std::move( resource ), std::move( body ), make_http_response_handler<T>(abstract_conn_ptr) );
+                  abstract_conn_ptr->timing.request_size = body.size();
+                  if( slow_request_time.count() > 0 ) {
+                     abstract_conn_ptr->timing.body_prefix = body.substr( 0, slow_request_body_prefix );
+                  }
+                  if( handler_itr->second.cacheable && response_cache ) {
+                     // answered here, without taking a slot of the api class, when cached
+                     abstract_conn_ptr->cache_key = detail::response_cache::make_key( resource, accept_binary, body );
+                     if( !abstract_conn_ptr->cache_key.empty() ) {
+                        if( auto cached = response_cache->get( abstract_conn_ptr->cache_key ); cached.body ) {
+                           send_cached_response( *abstract_conn_ptr, *cached.body, cached.content_type );
+                           return;
+                        }
+                        abstract_conn_ptr->cache_generation = response_cache->current_generation();
+                     }
+                  }
+                  if( !verify_api_class( con, *abstract_conn_ptr, handler_itr->second.api_class ) ) return;
+                  handler_itr->second.handler( abstract_conn_ptr, std::move( resource ), std::move( body ),
+                                       make_http_response_handler(abstract_conn_ptr, accept_binary, req.get_header( "If-None-Match" )) );
                } else {
                   fc_dlog( logger, "404 - not found: ${ep}", ("ep", resource) );
                   error_results results{websocketpp::http::status_code::not_found,
@@ -655,7 +924,7 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
                   con->send_http_response();
                }
             } catch( ... ) {
-               handle_exception<T>( con );
+               handle_exception( con );
             }
          }
 
@@ -668,7 +937,7 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
                ws.set_max_http_body_size(max_body_size);
                // captures `this` & ws, my needs to live as long as server is handling requests
                ws.set_http_handler([&](connection_hdl hdl) {
-                  handle_http_request<detail::asio_with_stub_log<T>>(ws.get_con_from_hdl(hdl));
+                  handle_http_request(ws.get_con_from_hdl(hdl));
                });
             } catch ( const fc::exception& e ){
                fc_elog( logger, "http: ${e}", ("e", e.to_detail_string()) );
@@ -688,9 +957,484 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
 
 #ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
    template<>
-   bool http_plugin_impl::allow_host<detail::asio_local_with_stub_log>(const detail::asio_local_with_stub_log::request_type& req, websocketpp::server<detail::asio_local_with_stub_log>::connection_ptr con) {
+   bool http_plugin_impl::allow_host(const websocketpp::server<detail::asio_local_with_stub_log>::connection_ptr& con) {
+      return true;
+   }
+#endif
+
+   /**
+    * HTTP/1.1 connection served with Boost.Beast for http-keep-alive. websocketpp closes every connection after
+    * its response, this keeps it open for the next request when the client asks for keep-alive, and reads the
+    * requests a client pipelines while the earlier ones are processed, sending the responses in request order.
+    *
+    * @tparam Stream - beast::tcp_stream or beast::ssl_stream<beast::tcp_stream>
+    */
+   template<class Stream>
+   class beast_http_session : public std::enable_shared_from_this<beast_http_session<Stream>> {
+   public:
+      using request_type = beast::http::request<beast::http::string_body>;
+      using response_type = beast::http::response<beast::http::string_body>;
+
+      static constexpr bool is_ssl = !std::is_same_v<Stream, beast::tcp_stream>;
+      /// requests read ahead of their response being sent
+      static constexpr size_t max_pipelined = 8;
+
+      beast_http_session( Stream&& stream, http_plugin_impl_ptr impl )
+      : stream( std::move( stream ) )
+      , impl( std::move( impl ) )
+      {}
+
+      void run() {
+         if constexpr( is_ssl ) {
+            beast::get_lowest_layer( stream ).expires_after( impl->keep_alive_timeout );
+            stream.async_handshake( asio::ssl::stream_base::server,
+                                    [self=this->shared_from_this()]( beast::error_code ec ) {
+               if( ec ) {
+                  fc_dlog( logger, "https handshake: ${m}", ("m", ec.message()) );
+                  return;
+               }
+               self->do_read();
+            } );
+         } else {
+            asio::dispatch( stream.get_executor(), [self=this->shared_from_this()]() { self->do_read(); } );
+         }
+      }
+
+      tcp::socket& socket() { return beast::get_lowest_layer( stream ).socket(); }
+
+      /// send the response to request seq once the responses to the requests before it are sent, from any thread
+      void send( uint64_t seq, response_type res ) {
+         asio::post( stream.get_executor(), [self=this->shared_from_this(), seq, res=std::move( res )]() mutable {
+            self->pending.at( seq - self->first_pending ) = std::move( res );
+            self->do_write();
+         } );
+      }
+
+   private:
+      void do_read();
+
+      void on_read( beast::error_code ec ) {
+         reading = false;
+         if( ec ) {
+            if( ec != beast::http::error::end_of_stream )
+               fc_dlog( logger, "http read: ${m}", ("m", ec.message()) );
+            read_closed = true;
+            if( pending.empty() ) do_close();
+            return;
+         }
+
+         pending.emplace_back();
+         const bool keep_alive = parser->keep_alive();
+         if( !keep_alive ) read_closed = true;
+         handle_request( parser->release(), next_seq++ );
+
+         if( keep_alive && pending.size() < max_pipelined ) do_read();
+      }
+
+      void handle_request( request_type&& req, uint64_t seq );
+
+      void do_write() {
+         if( writing || pending.empty() || !pending.front() ) return;
+         writing = true;
+         auto res = std::make_shared<response_type>( std::move( *pending.front() ) );
+         // the expiry set by do_read may have passed while the request was handled, it is shared by reads and writes
+         beast::get_lowest_layer( stream ).expires_after( impl->keep_alive_timeout );
+         beast::http::async_write( stream, *res, [self=this->shared_from_this(), res]( beast::error_code ec, size_t ) {
+            self->on_write( ec, res->need_eof() );
+         } );
+      }
+
+      void on_write( beast::error_code ec, bool close ) {
+         writing = false;
+         pending.pop_front();
+         ++first_pending;
+         if( ec ) {
+            fc_dlog( logger, "http write: ${m}", ("m", ec.message()) );
+            return do_close();
+         }
+         if( close ) {
+            read_closed = true;
+            return do_close();
+         }
+         if( pending.empty() && read_closed ) return do_close();
+
+         do_write();
+         if( !reading && !read_closed && pending.size() < max_pipelined ) do_read();
+      }
+
+      void do_close() {
+         if constexpr( is_ssl ) {
+            beast::get_lowest_layer( stream ).expires_after( std::chrono::seconds( 5 ) );
+            stream.async_shutdown( [self=this->shared_from_this()]( beast::error_code ) {} );
+         } else {
+            beast::error_code ec;
+            socket().shutdown( tcp::socket::shutdown_send, ec );
+         }
+      }
+
+      Stream                                      stream;
+      http_plugin_impl_ptr                        impl;
+      beast::flat_buffer                          buffer;
+      std::optional<beast::http::request_parser<beast::http::string_body>> parser;
+      std::deque<std::optional<response_type>>    pending; ///< responses of the requests read, in request order
+      uint64_t                                    first_pending = 0; ///< seq of pending.front()
+      uint64_t                                    next_seq = 0;
+      bool                                        reading = false;
+      bool                                        writing = false;
+      bool                                        read_closed = false;
+   };
+
+   /**
+    * A request of a beast_http_session, with the subset of the websocketpp connection interface
+    * http_plugin_impl::handle_http_request and abstract_conn_impl use. The response is sent by
+    * send_http_response or, like a websocketpp response that is not deferred, when the last reference is released.
+    */
+   template<class Stream>
+   class beast_http_request {
+   public:
+      using session_ptr = std::shared_ptr<beast_http_session<Stream>>;
+
+      beast_http_request( session_ptr session, typename beast_http_session<Stream>::request_type&& req, uint64_t seq )
+      : session( std::move( session ) )
+      , req( std::move( req ) )
+      , seq( seq )
+      {
+         res.result( beast::http::status::internal_server_error );
+      }
+
+      ~beast_http_request() {
+         if( !sent ) send_http_response();
+      }
+
+      beast_http_request(const beast_http_request&) = delete;
+      beast_http_request& operator=(const beast_http_request&) = delete;
+
+      // request, get_request() and get_uri() return this
+      const beast_http_request& get_request() const { return *this; }
+      const beast_http_request* get_uri() const { return this; }
+      std::string get_header( const std::string& key ) const { return std::string( req[key] ); }
+      std::string get_method() const { return std::string( req.method_string() ); }
+      std::string get_resource() const { return std::string( req.target() ); }
+      bool get_secure() const { return beast_http_session<Stream>::is_ssl; }
+      /// moved out, handle_http_request reads it once
+      std::string get_request_body() { return std::move( req.body() ); }
+      tcp::socket& get_socket() const { return session->socket(); }
+
+      // response
+      void defer_http_response() {}
+      void set_status( unsigned code ) { res.result( code ); }
+      void set_body( std::string body ) { res.body() = std::move( body ); }
+      void append_header( const std::string& key, const std::string& value ) { res.insert( key, value ); }
+      void replace_header( const std::string& key, const std::string& value ) { res.set( key, value ); }
+
+      void send_http_response() {
+         if( std::exchange( sent, true ) ) return;
+         res.version( req.version() );
+         res.keep_alive( req.keep_alive() );
+         res.prepare_payload();
+         session->send( seq, std::move( res ) );
+      }
+
+   private:
+      session_ptr                                       session;
+      typename beast_http_session<Stream>::request_type req;
+      typename beast_http_session<Stream>::response_type res;
+      const uint64_t                                    seq;
+      bool                                              sent = false;
+   };
+
+   template<class Stream>
+   void beast_http_session<Stream>::do_read() {
+      reading = true;
+      parser.emplace();
+      parser->body_limit( impl->max_body_size );
+      beast::get_lowest_layer( stream ).expires_after( impl->keep_alive_timeout );
+      beast::http::async_read( stream, buffer, *parser, [self=this->shared_from_this()]( beast::error_code ec, size_t ) {
+         self->on_read( ec );
+      } );
+   }
+
+   template<class Stream>
+   void beast_http_session<Stream>::handle_request( request_type&& req, uint64_t seq ) {
+      impl->handle_http_request( std::make_shared<beast_http_request<Stream>>( this->shared_from_this(), std::move( req ), seq ) );
+   }
+
+   /**
+    * Accepts the connections of an http or https endpoint for beast_http_session
+    */
+   class beast_http_listener : public std::enable_shared_from_this<beast_http_listener> {
+   public:
+      /// ssl_ctx - nullptr for http
+      beast_http_listener( http_plugin_impl_ptr impl, const tcp::endpoint& ep, ssl_context_ptr ssl_ctx )
+      : impl( std::move( impl ) )
+      , acceptor( asio::make_strand( this->impl->thread_pool->get_executor() ) )
+      , ssl_ctx( std::move( ssl_ctx ) )
+      {
+         acceptor.open( ep.protocol() );
+         acceptor.set_option( asio::socket_base::reuse_address( true ) );
+         acceptor.bind( ep );
+         acceptor.listen( asio::socket_base::max_listen_connections );
+      }
+
+      void run() { do_accept(); }
+
+      void stop() {
+         asio::post( acceptor.get_executor(), [self=shared_from_this()]() {
+            beast::error_code ec;
+            self->acceptor.close( ec );
+         } );
+      }
+
+   private:
+      void do_accept() {
+         acceptor.async_accept( asio::make_strand( impl->thread_pool->get_executor() ),
+                                [self=shared_from_this()]( beast::error_code ec, tcp::socket socket ) {
+            if( ec ) {
+               if( ec == asio::error::operation_aborted ) return;
+               fc_dlog( logger, "http accept: ${m}", ("m", ec.message()) );
+            } else if( self->ssl_ctx ) {
+               using stream_type = beast::ssl_stream<beast::tcp_stream>;
+               std::make_shared<beast_http_session<stream_type>>(
+                     stream_type( beast::tcp_stream( std::move( socket ) ), *self->ssl_ctx ), self->impl )->run();
+            } else {
+               std::make_shared<beast_http_session<beast::tcp_stream>>( beast::tcp_stream( std::move( socket ) ), self->impl )->run();
+            }
+            self->do_accept();
+         } );
+      }
+
+      http_plugin_impl_ptr  impl;
+      tcp::acceptor         acceptor;
+      ssl_context_ptr       ssl_ctx;
+   };
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+   /**
+    * Connection of local-rpc-socket-path: frames of local_rpc_request and local_rpc_response rather than HTTP, for
+    * co-located clients. Up to max_in_flight requests are read ahead of their response, responses are sent as they
+    * complete.
+    */
+   class local_rpc_session : public std::enable_shared_from_this<local_rpc_session> {
+   public:
+      using socket_type = asio::local::stream_protocol::socket;
+      static constexpr size_t max_in_flight = 64;
+      /// allowance for the id and url of a request on top of http-max-body-size
+      static constexpr size_t max_frame_overhead = 4096;
+
+      local_rpc_session( socket_type&& socket, http_plugin_impl_ptr impl )
+      : socket( std::move( socket ) )
+      , impl( std::move( impl ) )
+      {}
+
+      void run() {
+         asio::dispatch( socket.get_executor(), [self=shared_from_this()]() { self->do_read(); } );
+      }
+
+      /// send res, from any thread
+      void send( local_rpc_response res ) {
+         asio::post( socket.get_executor(), [self=shared_from_this(), res=std::move( res )]() {
+            --self->in_flight;
+            if( self->closed ) return;
+            const uint32_t size = fc::raw::pack_size( res );
+            std::string frame( sizeof( size ) + size, '\0' );
+            fc::datastream<char*> ds( frame.data(), frame.size() );
+            fc::raw::pack( ds, size );
+            fc::raw::pack( ds, res );
+            self->write_queue.emplace_back( std::move( frame ) );
+            self->do_write();
+            if( !self->reading && !self->read_closed && self->in_flight < max_in_flight ) self->do_read();
+         } );
+      }
+
+   private:
+      void do_read() {
+         reading = true;
+         asio::async_read( socket, asio::buffer( header ), [self=shared_from_this()]( boost::system::error_code ec, size_t ) {
+            if( ec ) return self->on_read_error( ec );
+            uint32_t size = 0;
+            fc::datastream<const char*> ds( self->header.data(), self->header.size() );
+            fc::raw::unpack( ds, size );
+            if( size > self->impl->max_body_size + max_frame_overhead ) {
+               fc_dlog( logger, "local rpc request of ${s} bytes exceeds http-max-body-size", ("s", size) );
+               return self->close();
+            }
+            self->frame.resize( size );
+            asio::async_read( self->socket, asio::buffer( self->frame ), [self]( boost::system::error_code ec, size_t ) {
+               if( ec ) return self->on_read_error( ec );
+               self->reading = false;
+               self->handle_request();
+            } );
+         } );
+      }
+
+      void on_read_error( const boost::system::error_code& ec ) {
+         reading = false;
+         read_closed = true;
+         if( ec != asio::error::eof )
+            fc_dlog( logger, "local rpc read: ${m}", ("m", ec.message()) );
+         if( in_flight == 0 && write_queue.empty() ) close();
+      }
+
+      void handle_request();
+
+      void do_write() {
+         if( writing || write_queue.empty() ) return;
+         writing = true;
+         asio::async_write( socket, asio::buffer( write_queue.front() ), [self=shared_from_this()]( boost::system::error_code ec, size_t ) {
+            self->writing = false;
+            self->write_queue.pop_front();
+            if( ec ) {
+               fc_dlog( logger, "local rpc write: ${m}", ("m", ec.message()) );
+               return self->close();
+            }
+            if( self->read_closed && self->in_flight == 0 && self->write_queue.empty() ) return self->close();
+            self->do_write();
+         } );
+      }
+
+      void close() {
+         closed = true;
+         read_closed = true;
+         boost::system::error_code ec;
+         socket.shutdown( socket_type::shutdown_both, ec );
+         socket.close( ec );
+      }
+
+      socket_type                  socket;
+      http_plugin_impl_ptr         impl;
+      std::array<char, 4>          header{};
+      std::string                  frame;
+      std::deque<std::string>      write_queue; ///< framed responses, front being written
+      size_t                       in_flight = 0;
+      bool                         reading = false;
+      bool                         writing = false;
+      bool                         read_closed = false;
+      bool                         closed = false;
+   };
+
+   /**
+    * A request of a local_rpc_session, with the subset of the websocketpp connection interface
+    * http_plugin_impl::handle_http_request and abstract_conn_impl use. It accepts binary responses and has no other
+    * header. The response is sent by send_http_response or when the last reference is released.
+    */
+   class local_rpc_call {
+   public:
+      local_rpc_call( std::shared_ptr<local_rpc_session> session, local_rpc_request&& req )
+      : session( std::move( session ) )
+      , req( std::move( req ) )
+      {
+         res.id = this->req.id;
+      }
+
+      ~local_rpc_call() {
+         if( !sent ) send_http_response();
+      }
+
+      local_rpc_call(const local_rpc_call&) = delete;
+      local_rpc_call& operator=(const local_rpc_call&) = delete;
+
+      // request, get_request() and get_uri() return this
+      const local_rpc_call& get_request() const { return *this; }
+      const local_rpc_call* get_uri() const { return this; }
+      std::string get_header( const std::string& key ) const { return key == "Accept" ? binary_content_type : std::string(); }
+      std::string get_method() const { return "POST"; }
+      const std::string& get_resource() const { return req.url; }
+      bool get_secure() const { return false; }
+      /// moved out, handle_http_request reads it once
+      std::string get_request_body() { return std::move( req.body ); }
+
+      // response, of the headers only the content type is kept
+      void defer_http_response() {}
+      void set_status( unsigned code ) { res.code = code; }
+      void set_body( std::string body ) { res.body = std::move( body ); }
+      void append_header( const std::string& key, const std::string& value ) { replace_header( key, value ); }
+      void replace_header( const std::string& key, const std::string& value ) {
+         if( key == "Content-type" ) res.content_type = value;
+      }
+
+      void send_http_response() {
+         if( std::exchange( sent, true ) ) return;
+         session->send( std::move( res ) );
+      }
+
+   private:
+      std::shared_ptr<local_rpc_session> session;
+      local_rpc_request                  req;
+      local_rpc_response                 res;
+      bool                               sent = false;
+   };
+
+   template<>
+   bool http_plugin_impl::allow_host(const std::shared_ptr<local_rpc_call>& con) {
       return true;
    }
+
+   void local_rpc_session::handle_request() {
+      local_rpc_request req;
+      try {
+         fc::datastream<const char*> ds( frame.data(), frame.size() );
+         fc::raw::unpack( ds, req );
+      } catch( const fc::exception& e ) {
+         fc_dlog( logger, "local rpc request: ${e}", ("e", e.to_detail_string()) );
+         return close();
+      }
+      ++in_flight;
+      impl->handle_http_request( std::make_shared<local_rpc_call>( shared_from_this(), std::move( req ) ) );
+      if( !read_closed && in_flight < max_in_flight ) do_read();
+   }
+
+   /**
+    * Accepts the connections of local-rpc-socket-path for local_rpc_session
+    */
+   class local_rpc_listener : public std::enable_shared_from_this<local_rpc_listener> {
+   public:
+      using protocol = asio::local::stream_protocol;
+
+      local_rpc_listener( http_plugin_impl_ptr impl, const protocol::endpoint& ep )
+      : impl( std::move( impl ) )
+      , acceptor( asio::make_strand( this->impl->thread_pool->get_executor() ) )
+      , path( ep.path() )
+      {
+         // a socket left by a previous run is replaced, one still served is not
+         boost::system::error_code ec;
+         protocol::socket test_socket( acceptor.get_executor() );
+         test_socket.connect( ep, ec );
+         EOS_ASSERT( ec, chain::plugin_config_exception, "local rpc socket ${p} is already in use", ("p", ep.path()) );
+         if( ec == boost::system::errc::connection_refused )
+            ::unlink( ep.path().c_str() );
+         acceptor.open( ep.protocol() );
+         acceptor.bind( ep );
+         acceptor.listen( asio::socket_base::max_listen_connections );
+      }
+
+      void run() { do_accept(); }
+
+      void stop() {
+         ::unlink( path.c_str() );
+         asio::post( acceptor.get_executor(), [self=shared_from_this()]() {
+            boost::system::error_code ec;
+            self->acceptor.close( ec );
+         } );
+      }
+
+   private:
+      void do_accept() {
+         acceptor.async_accept( asio::make_strand( impl->thread_pool->get_executor() ),
+                                [self=shared_from_this()]( boost::system::error_code ec, protocol::socket socket ) {
+            if( ec ) {
+               if( ec == asio::error::operation_aborted ) return;
+               fc_dlog( logger, "local rpc accept: ${m}", ("m", ec.message()) );
+            } else {
+               std::make_shared<local_rpc_session>( std::move( socket ), self->impl )->run();
+            }
+            self->do_accept();
+         } );
+      }
+
+      http_plugin_impl_ptr  impl;
+      protocol::acceptor    acceptor;
+      const std::string     path;
+   };
 #endif
 
    http_plugin::http_plugin():my(new http_plugin_impl()){
@@ -708,6 +1452,10 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
          cfg.add_options()
             ("unix-socket-path", bpo::value<string>(),
              "The filename (relative to data-dir) to create a unix socket for HTTP RPC; set blank to disable.");   
+      cfg.add_options()
+            ("local-rpc-socket-path", bpo::value<string>(),
+             "The filename (relative to data-dir) to create a unix socket serving the APIs with length prefixed binary "
+             "frames rather than HTTP, for co-located clients; leave blank to disable.");
 #endif
 
       if(current_http_plugin_defaults.default_http_port)
@@ -777,6 +1525,22 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
              "Additionaly acceptable values for the \"Host\" header of incoming HTTP requests, can be specified multiple times.  Includes http/s_server_address by default.")
             ("http-threads", bpo::value<uint16_t>()->default_value( my->thread_pool_size ),
              "Number of worker threads in http thread pool")
+            ("http-api-class-limit", bpo::value<vector<string>>()->composing(),
+             "Maximum number of requests in flight for the endpoints of an API class, as <class>=<max requests>, 429 error response when "
+             "exceeded. Can be specified multiple times. Classes: chain_info, chain_ro, chain_rw, default")
+            ("http-slow-request-ms", bpo::value<uint32_t>()->default_value(0),
+             "Log the requests taking longer than this from their reception to their response being encoded, with the start of their body; 0 disables the log")
+            ("http-slow-request-log-sample", bpo::value<uint32_t>()->default_value(1),
+             "Log one of this many slow requests of an endpoint")
+            ("http-response-cache-ttl-ms", bpo::value<uint32_t>()->default_value(0),
+             "Cache the responses of idempotent endpoints, such as get_info, for at most this long; they are also dropped on every "
+             "accepted block. 0 disables the cache")
+            ("http-response-cache-size", bpo::value<uint32_t>()->default_value(1024),
+             "Maximum number of responses kept by the response cache")
+            ("http-keep-alive", bpo::bool_switch()->default_value(false),
+             "Serve http-server-address and https-server-address with HTTP/1.1 keep-alive and pipelining rather than one request per connection")
+            ("http-keep-alive-timeout-sec", bpo::value<uint32_t>()->default_value(60),
+             "Seconds a kept alive connection waits for its next request before it is closed")
             ;
    }
 
@@ -814,6 +1578,12 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
                sock_path = app().data_dir() / sock_path;
             my->unix_endpoint = asio::local::stream_protocol::endpoint(sock_path.string());
          }
+         if( options.count( "local-rpc-socket-path" ) && !options.at( "local-rpc-socket-path" ).as<string>().empty()) {
+            boost::filesystem::path sock_path = options.at("local-rpc-socket-path").as<string>();
+            if (sock_path.is_relative())
+               sock_path = app().data_dir() / sock_path;
+            my->local_rpc_endpoint = asio::local::stream_protocol::endpoint(sock_path.string());
+         }
 #endif
 
          if( options.count( "https-server-address" ) && options.at( "https-server-address" ).as<string>().length()) {
@@ -858,6 +1628,27 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
          my->max_bytes_in_flight = options.at( "http-max-bytes-in-flight-mb" ).as<uint32_t>() * 1024 * 1024;
          my->max_requests_in_flight = options.at( "http-max-in-flight-requests" ).as<int32_t>();
          my->max_response_time = fc::microseconds( options.at("http-max-response-time-ms").as<uint32_t>() * 1000 );
+         if( options.count( "http-api-class-limit" )) {
+            for( const auto& limit : options.at( "http-api-class-limit" ).as<vector<string>>() ) {
+               auto eq = limit.find( '=' );
+               EOS_ASSERT( eq != string::npos && eq > 0, chain::plugin_config_exception,
+                           "http-api-class-limit ${l} is not <class>=<max requests>", ("l", limit) );
+               try {
+                  my->api_class_limits[limit.substr( 0, eq )] = std::stoi( limit.substr( eq + 1 ) );
+               } catch( const std::exception& ) {
+                  EOS_THROW( chain::plugin_config_exception, "http-api-class-limit ${l} is not <class>=<max requests>", ("l", limit) );
+               }
+            }
+         }
+         my->slow_request_time = fc::milliseconds( options.at( "http-slow-request-ms" ).as<uint32_t>() );
+         my->slow_request_log_sample = options.at( "http-slow-request-log-sample" ).as<uint32_t>();
+         EOS_ASSERT( my->slow_request_log_sample > 0, chain::plugin_config_exception,
+                     "http-slow-request-log-sample must be greater than 0" );
+         if( auto ttl = options.at( "http-response-cache-ttl-ms" ).as<uint32_t>(); ttl > 0 ) {
+            my->response_cache.emplace( options.at( "http-response-cache-size" ).as<uint32_t>(), fc::milliseconds( ttl ) );
+         }
+         my->keep_alive = options.at( "http-keep-alive" ).as<bool>();
+         my->keep_alive_timeout = std::chrono::seconds( options.at( "http-keep-alive-timeout-sec" ).as<uint32_t>() );
 
          //watch out for the returns above when adding new code here
       } FC_LOG_AND_RETHROW()
@@ -872,11 +1663,15 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
             my->thread_pool.emplace( "http", my->thread_pool_size );
             if(my->listen_endpoint) {
                try {
-                  my->create_server_for_endpoint(*my->listen_endpoint, my->server);
-
                   fc_ilog( logger, "start listening for http requests" );
-                  my->server.listen(*my->listen_endpoint);
-                  my->server.start_accept();
+                  if( my->keep_alive ) {
+                     my->beast_listener = std::make_shared<beast_http_listener>( my, *my->listen_endpoint, nullptr );
+                     my->beast_listener->run();
+                  } else {
+                     my->create_server_for_endpoint(*my->listen_endpoint, my->server);
+                     my->server.listen(*my->listen_endpoint);
+                     my->server.start_accept();
+                  }
                } catch ( const fc::exception& e ){
                   fc_elog( logger, "http service failed to start: ${e}", ("e", e.to_detail_string()) );
                   throw;
@@ -898,7 +1693,7 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
                   my->unix_server.listen(*my->unix_endpoint);
                   // captures `this`, my needs to live as long as unix_server is handling requests
                   my->unix_server.set_http_handler([this](connection_hdl hdl) {
-                     my->handle_http_request<detail::asio_local_with_stub_log>( my->unix_server.get_con_from_hdl(std::move(hdl)));
+                     my->handle_http_request( my->unix_server.get_con_from_hdl(std::move(hdl)));
                   });
                   my->unix_server.start_accept();
                } catch ( const fc::exception& e ){
@@ -912,17 +1707,33 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
                   throw;
                }
             }
+            if(my->local_rpc_endpoint) {
+               try {
+                  my->local_rpc = std::make_shared<local_rpc_listener>( my, *my->local_rpc_endpoint );
+                  my->local_rpc->run();
+               } catch ( const fc::exception& e ){
+                  fc_elog( logger, "local rpc socket (${path}) failed to start: ${e}", ("e", e.to_detail_string())("path",my->local_rpc_endpoint->path()) );
+                  throw;
+               } catch ( const std::exception& e ){
+                  fc_elog( logger, "local rpc socket (${path}) failed to start: ${e}", ("e", e.what())("path",my->local_rpc_endpoint->path()) );
+                  throw;
+               }
+            }
 #endif
             if(my->https_listen_endpoint) {
                try {
-                  my->create_server_for_endpoint(*my->https_listen_endpoint, my->https_server);
-                  my->https_server.set_tls_init_handler([this](const websocketpp::connection_hdl& hdl) -> ssl_context_ptr{
-                     return my->on_tls_init();
-                  });
-
                   fc_ilog( logger, "start listening for https requests" );
-                  my->https_server.listen(*my->https_listen_endpoint);
-                  my->https_server.start_accept();
+                  if( my->keep_alive ) {
+                     my->beast_https_listener = std::make_shared<beast_http_listener>( my, *my->https_listen_endpoint, my->on_tls_init() );
+                     my->beast_https_listener->run();
+                  } else {
+                     my->create_server_for_endpoint(*my->https_listen_endpoint, my->https_server);
+                     my->https_server.set_tls_init_handler([this](const websocketpp::connection_hdl& hdl) -> ssl_context_ptr{
+                        return my->on_tls_init();
+                     });
+                     my->https_server.listen(*my->https_listen_endpoint);
+                     my->https_server.start_accept();
+                  }
                } catch ( const fc::exception& e ){
                   fc_elog( logger, "https service failed to start: ${e}", ("e", e.to_detail_string()) );
                   throw;
@@ -947,6 +1758,26 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
                   }
                }
             }});
+            add_async_api({{
+               std::string("/v1/node/metrics"),
+               [&](const string&, string body, url_response_callback cb) mutable {
+                  try {
+                     cb(200, json_response_body{ my->prometheus_metrics(), {}, "text/plain; version=0.0.4" });
+                  } catch (...) {
+                     handle_exception("node", "metrics", body, cb);
+                  }
+               }
+            }});
+            add_async_api({{
+               std::string("/v1/node/get_api_class_metrics"),
+               [&](const string&, string body, url_response_callback cb) mutable {
+                  try {
+                     cb(200, fc::variant(get_api_class_metrics()));
+                  } catch (...) {
+                     handle_exception("node", "get_api_class_metrics", body, cb);
+                  }
+               }
+            }});
          } catch (...) {
             fc_elog(logger, "http_plugin startup fails, shutting down");
             app().quit();
@@ -963,13 +1794,25 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
          my->server.stop_listening();
       if(my->https_server.is_listening())
          my->https_server.stop_listening();
+      if(my->beast_listener)
+         my->beast_listener->stop();
+      if(my->beast_https_listener)
+         my->beast_https_listener->stop();
 #ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
       if(my->unix_server.is_listening())
          my->unix_server.stop_listening();
+      if(my->local_rpc)
+         my->local_rpc->stop();
 #endif
 
       if( my->thread_pool ) {
          my->thread_pool->stop();
+         // the listeners hold my, release them before their io_context
+         my->beast_listener.reset();
+         my->beast_https_listener.reset();
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+         my->local_rpc.reset();
+#endif
          my->thread_pool.reset();
       }
 
@@ -979,14 +1822,26 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
       app().post( 0, [me = my](){} ); // keep my pointer alive until queue is drained
    }
 
-   void http_plugin::add_handler(const string& url, const url_handler& handler, int priority) {
+   void http_plugin::add_handler(const string& url, const url_handler& handler, int priority, const string& api_class) {
       fc_ilog( logger, "add api url: ${c}", ("c", url) );
-      my->url_handlers[url] = my->make_app_thread_url_handler(priority, handler, my);
+      my->url_handlers[url] = { my->make_app_thread_url_handler(priority, handler, my), my->get_api_class(api_class),
+                                std::make_shared<detail::endpoint_metrics>(url) };
    }
 
-   void http_plugin::add_async_handler(const string& url, const url_handler& handler) {
+   void http_plugin::add_async_handler(const string& url, const url_handler& handler, const string& api_class) {
       fc_ilog( logger, "add api url: ${c}", ("c", url) );
-      my->url_handlers[url] = my->make_http_thread_url_handler(handler);
+      my->url_handlers[url] = { my->make_http_thread_url_handler(handler), my->get_api_class(api_class),
+                                std::make_shared<detail::endpoint_metrics>(url) };
+   }
+
+   void http_plugin::enable_response_cache(const string& url) {
+      auto itr = my->url_handlers.find(url);
+      EOS_ASSERT( itr != my->url_handlers.end(), chain::plugin_config_exception, "${u} has no handler", ("u", url) );
+      itr->second.cacheable = true;
+   }
+
+   void http_plugin::invalidate_response_cache() {
+      if( my->response_cache ) my->response_cache->invalidate();
    }
 
    void http_plugin::handle_exception( const char *api_name, const char *call_name, const string& body, url_response_callback cb ) {
@@ -1056,10 +1911,22 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
       return result;
    }
 
+   http_plugin::get_api_class_metrics_result http_plugin::get_api_class_metrics()const {
+      get_api_class_metrics_result result;
+      for( const auto& [name, c] : my->api_classes ) {
+         result.classes.push_back( { name, c->max_in_flight, c->in_flight.load(), c->admitted.load(), c->rejected.load() } );
+      }
+      return result;
+   }
+
    fc::microseconds http_plugin::get_max_response_time()const {
       return my->max_response_time;
    }
 
+   void http_plugin::add_metrics_provider(std::function<string()> provider) {
+      my->metrics_providers.emplace_back( std::move( provider ) );
+   }
+
    std::istream& operator>>(std::istream& in, https_ecdh_curve_t& curve) {
       std::string s;
       in >> s;
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <fc/time.hpp>
+
+#include <array>
+#include <atomic>
+#include <string>
+
+namespace eosio { namespace detail {
+
+   /**
+    * Histogram with fixed upper bounds, updated lock free from any thread and written in the
+    * Prometheus text format
+    */
+   template<size_t N>
+   class histogram {
+   public:
+      explicit histogram( const std::array<uint64_t, N>& bounds ) : bounds( bounds ) {}
+
+      void observe( uint64_t v ) {
+         size_t i = 0;
+         while( i < N && v > bounds[i] ) ++i;
+         counts[i].fetch_add( 1, std::memory_order_relaxed );
+         sum.fetch_add( v, std::memory_order_relaxed );
+      }
+
+      /**
+       * @param name - metric name
+       * @param labels - labels of the metric, without braces
+       * @param scale - bounds and sum are divided by scale, to write microseconds as seconds
+       */
+      void write( std::string& out, const std::string& name, const std::string& labels, double scale )const {
+         uint64_t cumulative = 0;
+         for( size_t i = 0; i <= N; ++i ) {
+            cumulative += counts[i].load( std::memory_order_relaxed );
+            out += name + "_bucket{" + labels + ",le=\"" + ( i < N ? format( bounds[i] / scale ) : "+Inf" ) + "\"} " +
+                   std::to_string( cumulative ) + "\n";
+         }
+         out += name + "_sum{" + labels + "} " + format( sum.load( std::memory_order_relaxed ) / scale ) + "\n";
+         out += name + "_count{" + labels + "} " + std::to_string( cumulative ) + "\n";
+      }
+
+   private:
+      static std::string format( double v ) {
+         std::string s = std::to_string( v );
+         s.erase( s.find_last_not_of( '0' ) + 1 );
+         if( s.back() == '.' ) s.pop_back();
+         return s;
+      }
+
+      const std::array<uint64_t, N>          bounds;
+      std::array<std::atomic<uint64_t>, N+1> counts{};
+      std::atomic<uint64_t>                  sum{0};
+   };
+
+   /// microseconds, 0.5ms to 10s
+   constexpr std::array<uint64_t, 14> latency_bounds{ 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000,
+                                                      500000, 1000000, 2500000, 5000000, 10000000 };
+   /// bytes, 256B to 16MiB
+   constexpr std::array<uint64_t, 9> size_bounds{ 256, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304, 16777216 };
+
+   using latency_histogram = histogram<latency_bounds.size()>;
+   using size_histogram = histogram<size_bounds.size()>;
+
+   /**
+    * Latencies and sizes of the requests of an endpoint
+    *
+    * The phases of a request are:
+    * - wait: received until its handler runs, the wait for the main thread of handlers added with add_handler
+    * - execution: handler run until it responds
+    * - response_wait: responded until an http thread encodes the response
+    * - serialization: encoding of the response as JSON or binary
+    */
+   struct endpoint_metrics {
+      explicit endpoint_metrics( std::string endpoint ) : endpoint( std::move( endpoint ) ) {}
+
+      const std::string  endpoint;
+      latency_histogram  wait{ latency_bounds };
+      latency_histogram  execution{ latency_bounds };
+      latency_histogram  response_wait{ latency_bounds };
+      latency_histogram  serialization{ latency_bounds };
+      latency_histogram  total{ latency_bounds };
+      size_histogram     request_size{ size_bounds };
+      size_histogram     response_size{ size_bounds };
+      std::atomic<uint64_t> slow{0};
+   };
+
+   /// times of a request for its endpoint_metrics
+   struct request_timing {
+      fc::time_point  received;
+      fc::time_point  handler_start;
+      fc::time_point  responded;
+      fc::time_point  response_start;
+      fc::time_point  encoded;
+      size_t          request_size = 0;
+      std::string     body_prefix; ///< start of the request body for the slow request log
+   };
+
+} } // eosio::detail
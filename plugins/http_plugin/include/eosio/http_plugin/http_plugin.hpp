@@ -1,20 +1,69 @@
 #pragma once
+#include <eosio/http_plugin/json_body.hpp>
 #include <appbase/application.hpp>
 #include <fc/exception/exception.hpp>
 #include <fc/reflect/reflect.hpp>
 #include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
 #include <eosio/chain/exceptions.hpp>
 
+#include <memory>
+#include <variant>
+
 namespace eosio {
    using namespace appbase;
 
+   /**
+    * @brief A response body the URL handler already encoded as JSON, sent as is
+    *
+    * When etag is set it is sent as the ETag header, and a request whose If-None-Match has it gets
+    * 304 Not Modified without the body. When content_type is set, json is text of that media type.
+    */
+   struct json_response_body {
+      std::string json;
+      std::string etag;
+      const char* content_type = nullptr;
+   };
+
+   /**
+    * @brief A result encoded on an http thread in the format asked for by the Accept header of the request:
+    * its fc::raw packed binary for application/octet-stream, JSON otherwise. Only one of pack and to_variant
+    * is called, once.
+    */
+   struct packed_response_body {
+      std::function<std::string()>   pack;
+      std::function<fc::variant()>   to_variant;
+
+      template<typename T>
+      static packed_response_body make( T&& result ) {
+         auto r = std::make_shared<std::decay_t<T>>( std::forward<T>( result ) );
+         return { [r]() {
+                     // packed straight into the response body
+                     std::string packed( fc::raw::pack_size( *r ), '\0' );
+                     fc::datastream<char*> ds( packed.data(), packed.size() );
+                     fc::raw::pack( ds, *r );
+                     return packed;
+                  },
+                  [r]() { return fc::variant( std::move( *r ) ); } };
+      }
+   };
+
+   /// media type of packed_response_body binary responses
+   constexpr auto binary_content_type = "application/octet-stream";
+
+   /**
+    * @brief The body of a response, either a fc::variant to be encoded as JSON on an http thread,
+    * the JSON text itself, or a result encoded as the client asked
+    */
+   using url_response_body = std::variant<std::optional<fc::variant>, json_response_body, packed_response_body>;
+
    /**
     * @brief A callback function provided to a URL handler to
     * allow it to specify the HTTP response code and body
     *
     * Arguments: response_code, response_body
     */
-   using url_response_callback = std::function<void(int,std::optional<fc::variant>)>;
+   using url_response_callback = std::function<void(int,url_response_body)>;
 
    /**
     * @brief Callback type for a URL handler
@@ -37,6 +86,30 @@ namespace eosio {
     */
    using api_description = std::map<string, url_handler>;
 
+   /**
+    * @brief A request on local-rpc-socket-path, sent as its fc::raw packed size, a little endian uint32, followed by
+    * its fc::raw packing. The requests of a connection are processed concurrently and answered as they complete.
+    */
+   struct local_rpc_request {
+      uint64_t id = 0;  ///< copied to the response
+      string   url;     ///< endpoint, e.g. /v1/chain/get_info
+      string   body;    ///< JSON params, as the body of an HTTP request
+   };
+
+   /**
+    * @brief A response on local-rpc-socket-path, framed like local_rpc_request. The body is binary_content_type
+    * when the endpoint supports it, JSON otherwise.
+    */
+   struct local_rpc_response {
+      uint64_t id = 0;
+      uint16_t code = 500;
+      string   content_type;
+      string   body;
+   };
+
+   /// class of the endpoints added without one, see http-api-class-limit
+   constexpr auto default_api_class = "default";
+
    struct http_plugin_defaults {
       //If empty, unix socket support will be completely disabled. If not empty,
       // unix socket support is enabled with the given default path (treated relative
@@ -78,18 +151,33 @@ namespace eosio {
         void plugin_shutdown();
         void handle_sighup() override;
 
-        void add_handler(const string& url, const url_handler&, int priority = appbase::priority::medium_low);
-        void add_api(const api_description& api, int priority = appbase::priority::medium_low) {
+        /**
+         * @param api_class - name of the class of endpoints sharing a limit of requests in flight,
+         *                    configured with http-api-class-limit
+         */
+        void add_handler(const string& url, const url_handler&, int priority = appbase::priority::medium_low,
+                         const string& api_class = default_api_class);
+        void add_api(const api_description& api, int priority = appbase::priority::medium_low,
+                     const string& api_class = default_api_class) {
            for (const auto& call : api)
-              add_handler(call.first, call.second, priority);
+              add_handler(call.first, call.second, priority, api_class);
         }
 
-        void add_async_handler(const string& url, const url_handler& handler);
-        void add_async_api(const api_description& api) {
+        void add_async_handler(const string& url, const url_handler& handler, const string& api_class = default_api_class);
+        void add_async_api(const api_description& api, const string& api_class = default_api_class) {
            for (const auto& call : api)
-              add_handler(call.first, call.second);
+              add_async_handler(call.first, call.second, api_class);
         }
 
+        /**
+         * Let the response cache, enabled by http-response-cache-ttl-ms, answer requests of url with the response
+         * to an identical earlier request. The handler of url must return the same response to the same request
+         * until invalidate_response_cache() is called. Must be called after url is added.
+         */
+        void enable_response_cache(const string& url);
+        /// drop the cached responses, to be called whenever the state they were computed from changes
+        void invalidate_response_cache();
+
         // standard exception handling for api handlers
         static void handle_exception( const char *api_name, const char *call_name, const string& body, url_response_callback cb );
 
@@ -104,9 +192,29 @@ namespace eosio {
 
         get_supported_apis_result get_supported_apis()const;
 
+        struct api_class_metrics {
+           string   name;
+           int32_t  max_in_flight = -1; ///< -1 when unlimited
+           int32_t  in_flight = 0;      ///< requests of the class waiting for or being processed
+           uint64_t admitted = 0;
+           uint64_t rejected = 0;       ///< answered 429 for max_in_flight
+        };
+
+        struct get_api_class_metrics_result {
+           vector<api_class_metrics> classes;
+        };
+
+        get_api_class_metrics_result get_api_class_metrics()const;
+
         /// @return the configured http-max-response-time-ms
         fc::microseconds get_max_response_time()const;
 
+        /**
+         * Add metrics of another plugin to /v1/node/metrics. provider returns them in the Prometheus text format, it
+         * is called from the http threads. Must be called before startup.
+         */
+        void add_metrics_provider(std::function<string()> provider);
+
    private:
         std::shared_ptr<class http_plugin_impl> my;
    };
@@ -239,7 +347,7 @@ namespace eosio {
                   EOS_THROW(chain::invalid_http_request, "no parameter should be given");
                }
             }
-            return fc::json::from_string(body).as<T>();
+            return parse_json_body(body).as<T>();
          } catch (const chain::chain_exception& e) { // EOS_RETHROW_EXCEPTIONS does not re-type these so, re-code it
             throw fc::exception(e);
          }
@@ -251,3 +359,7 @@ FC_REFLECT(eosio::error_results::error_info::error_detail, (message)(file)(line_
 FC_REFLECT(eosio::error_results::error_info, (code)(name)(what)(details))
 FC_REFLECT(eosio::error_results, (code)(message)(error))
 FC_REFLECT(eosio::http_plugin::get_supported_apis_result, (apis))
+FC_REFLECT(eosio::local_rpc_request, (id)(url)(body))
+FC_REFLECT(eosio::local_rpc_response, (id)(code)(content_type)(body))
+FC_REFLECT(eosio::http_plugin::api_class_metrics, (name)(max_in_flight)(in_flight)(admitted)(rejected))
+FC_REFLECT(eosio::http_plugin::get_api_class_metrics_result, (classes))
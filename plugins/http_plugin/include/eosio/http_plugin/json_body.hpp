@@ -0,0 +1,24 @@
+#pragma once
+
+#include <fc/variant.hpp>
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace eosio {
+
+   /**
+    * Parses JSON the way fc::json::from_string does for the common shape of API request bodies: objects, arrays,
+    * strings without escapes, integers, true, false and null. Strings are found with memchr instead of character by
+    * character, which is most of the work for the long hex strings of packed transactions.
+    *
+    * @return std::nullopt for anything else, e.g. an escape, a floating point number, a repeated key or invalid JSON;
+    * the body is then to be parsed with fc::json so its result and errors are unchanged
+    */
+   std::optional<fc::variant> parse_simple_json( std::string_view body );
+
+   /// parse_simple_json() with fc::json::from_string() as the fallback
+   fc::variant parse_json_body( const std::string& body );
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <eosio/http_plugin/http_metrics.hpp>
+
+#include <appbase/application.hpp>
+#include <fc/time.hpp>
+
+#include <array>
+#include <atomic>
+#include <string>
+
+namespace eosio {
+
+   /**
+    * Depth and wait time of the work posted to the main thread queue, per appbase priority class.
+    * Work posted with main_thread_post() is counted; work appbase queues itself, such as channel
+    * subscribers, is not.
+    */
+   class main_thread_queue_metrics {
+   public:
+      struct priority_class {
+         explicit priority_class( const char* name ) : name( name ) {}
+
+         const char*                 name;
+         std::atomic<uint64_t>       queued{0};   ///< posted and not yet run
+         std::atomic<uint64_t>       executed{0};
+         detail::latency_histogram   wait{ detail::latency_bounds }; ///< microseconds from post until run
+      };
+
+      static main_thread_queue_metrics& instance() {
+         static main_thread_queue_metrics metrics;
+         return metrics;
+      }
+
+      /// the class of a priority is the highest named appbase priority it is not below
+      priority_class& for_priority( int priority ) {
+         size_t i = thresholds.size();
+         while( i > 0 && priority < thresholds[i - 1] ) --i;
+         return classes[i];
+      }
+
+      /// the metrics in the Prometheus text format
+      std::string prometheus_metrics()const {
+         std::string out;
+         out += "# HELP nodeos_main_thread_queue_depth Work posted to the main thread and not yet run\n"
+                "# TYPE nodeos_main_thread_queue_depth gauge\n";
+         for( const auto& c : classes )
+            out += std::string( "nodeos_main_thread_queue_depth{priority=\"" ) + c.name + "\"} " + std::to_string( c.queued.load() ) + "\n";
+         out += "# HELP nodeos_main_thread_executed_total Work posted to the main thread and run\n"
+                "# TYPE nodeos_main_thread_executed_total counter\n";
+         for( const auto& c : classes )
+            out += std::string( "nodeos_main_thread_executed_total{priority=\"" ) + c.name + "\"} " + std::to_string( c.executed.load() ) + "\n";
+         out += "# HELP nodeos_main_thread_queue_wait_seconds Time from posting work to the main thread until it runs\n"
+                "# TYPE nodeos_main_thread_queue_wait_seconds histogram\n";
+         for( const auto& c : classes )
+            c.wait.write( out, "nodeos_main_thread_queue_wait_seconds", std::string( "priority=\"" ) + c.name + "\"", 1e6 );
+         return out;
+      }
+
+   private:
+      main_thread_queue_metrics() = default;
+
+      const std::array<int, 6> thresholds{ appbase::priority::low, appbase::priority::medium_low, appbase::priority::medium,
+                                           appbase::priority::medium_high, appbase::priority::high, appbase::priority::highest };
+      std::array<priority_class, 7> classes{ priority_class{"lowest"}, priority_class{"low"}, priority_class{"medium_low"},
+                                             priority_class{"medium"}, priority_class{"medium_high"}, priority_class{"high"},
+                                             priority_class{"highest"} };
+   };
+
+   /**
+    * app().post() which records the queue depth and wait time of the work in its priority class of
+    * main_thread_queue_metrics. Higher priorities run first: blocks and transactions are posted above API
+    * requests, so API work waits behind them.
+    */
+   template<typename Func>
+   void main_thread_post( int priority, Func&& func ) {
+      auto& c = main_thread_queue_metrics::instance().for_priority( priority );
+      c.queued.fetch_add( 1, std::memory_order_relaxed );
+      appbase::app().post( priority, [&c, posted = fc::time_point::now(), func = std::forward<Func>( func )]() mutable {
+         c.queued.fetch_sub( 1, std::memory_order_relaxed );
+         c.executed.fetch_add( 1, std::memory_order_relaxed );
+         c.wait.observe( ( fc::time_point::now() - posted ).count() );
+         func();
+      } );
+   }
+
+} // eosio
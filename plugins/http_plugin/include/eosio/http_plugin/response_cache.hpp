@@ -0,0 +1,137 @@
+#pragma once
+
+#include <fc/io/json.hpp>
+#include <fc/time.hpp>
+#include <fc/variant_object.hpp>
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace eosio { namespace detail {
+
+   /**
+    * Encoded responses of idempotent endpoints by url, response format and request body, so repeated
+    * identical requests are answered on the http thread without running their handler. Responses are dropped
+    * by invalidate() when the state they were computed from changes, and after ttl at the latest.
+    * All methods may be called from any thread.
+    */
+   class response_cache {
+   public:
+      using body_ptr = std::shared_ptr<const std::string>;
+
+      struct response {
+         body_ptr     body;                   ///< nullptr when not cached
+         const char*  content_type = nullptr;
+      };
+
+      /**
+       * @param max_entries - responses kept, the oldest is dropped beyond that
+       * @param ttl - time a response is kept at most
+       */
+      response_cache( size_t max_entries, fc::microseconds ttl )
+      : max_entries( max_entries ), ttl( ttl ) {}
+
+      /**
+       * Key of a request, the same for request bodies differing only in whitespace and order of object keys
+       * @return empty when body is not valid JSON, such a request is not cached
+       */
+      static std::string make_key( const std::string& url, bool accept_binary, const std::string& body ) {
+         std::string key = url;
+         key += accept_binary ? "\nb\n" : "\nj\n";
+         if( body.empty() ) return key;
+         try {
+            key += fc::json::to_string( normalized( fc::json::from_string( body ) ), fc::time_point::maximum() );
+         } catch( ... ) {
+            return {};
+         }
+         return key;
+      }
+
+      response get( const std::string& key ) {
+         std::lock_guard<std::mutex> g( mtx );
+         auto itr = entries.find( key );
+         if( itr == entries.end() || itr->second.expires <= fc::time_point::now() ) {
+            ++misses;
+            return {};
+         }
+         ++hits;
+         return { itr->second.body, itr->second.content_type };
+      }
+
+      /// generation to pass to put for a request starting now
+      uint64_t current_generation()const {
+         std::lock_guard<std::mutex> g( mtx );
+         return generation;
+      }
+
+      /// cache body for key unless invalidate() was called since generation
+      void put( const std::string& key, body_ptr body, const char* content_type, uint64_t rendered_generation ) {
+         std::lock_guard<std::mutex> g( mtx );
+         if( rendered_generation != generation || max_entries == 0 ) return;
+         auto [itr, inserted] = entries.try_emplace( key );
+         if( !inserted ) order.erase( itr->second.order_itr );
+         itr->second.body = std::move( body );
+         itr->second.content_type = content_type;
+         itr->second.expires = fc::time_point::now() + ttl;
+         itr->second.order_itr = order.insert( order.end(), &itr->first );
+         if( entries.size() > max_entries ) {
+            entries.erase( *order.front() );
+            order.pop_front();
+         }
+      }
+
+      /// drop all responses
+      void invalidate() {
+         std::lock_guard<std::mutex> g( mtx );
+         entries.clear();
+         order.clear();
+         ++generation;
+      }
+
+      uint64_t get_hits()const   { std::lock_guard<std::mutex> g( mtx ); return hits; }
+      uint64_t get_misses()const { std::lock_guard<std::mutex> g( mtx ); return misses; }
+
+   private:
+      /// v with the keys of its objects sorted
+      static fc::variant normalized( const fc::variant& v ) {
+         if( v.is_object() ) {
+            const auto& obj = v.get_object();
+            std::vector<const fc::variant_object::entry*> sorted;
+            sorted.reserve( obj.size() );
+            for( const auto& e : obj ) sorted.push_back( &e );
+            std::sort( sorted.begin(), sorted.end(), []( const auto* a, const auto* b ) { return a->key() < b->key(); } );
+            fc::mutable_variant_object result;
+            for( const auto* e : sorted ) result( e->key(), normalized( e->value() ) );
+            return fc::variant( std::move( result ) );
+         }
+         if( v.is_array() ) {
+            fc::variants result;
+            result.reserve( v.size() );
+            for( const auto& e : v.get_array() ) result.push_back( normalized( e ) );
+            return fc::variant( std::move( result ) );
+         }
+         return v;
+      }
+
+      struct entry {
+         body_ptr                                body;
+         const char*                             content_type = nullptr;
+         fc::time_point                          expires;
+         std::list<const std::string*>::iterator order_itr;
+      };
+
+      const size_t                            max_entries;
+      const fc::microseconds                  ttl;
+      mutable std::mutex                      mtx;
+      std::unordered_map<std::string, entry>  entries;
+      std::list<const std::string*>           order; ///< keys of entries, oldest first
+      uint64_t                                generation = 0;
+      uint64_t                                hits = 0;
+      uint64_t                                misses = 0;
+   };
+
+} } // eosio::detail
@@ -0,0 +1,170 @@
+#include <eosio/http_plugin/json_body.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+#include <cstring>
+#include <limits>
+
+namespace eosio {
+
+   namespace {
+      constexpr uint32_t max_depth = 64; ///< deeper bodies are left to fc::json
+
+      class simple_json_parser {
+      public:
+         explicit simple_json_parser( std::string_view s ) : _pos( s.data() ), _end( s.data() + s.size() ) {}
+
+         std::optional<fc::variant> parse() {
+            fc::variant v;
+            if( !value( v, 0 ) ) return {};
+            skip_ws();
+            if( _pos != _end ) return {};
+            return v;
+         }
+
+      private:
+         void skip_ws() {
+            while( _pos != _end && ( *_pos == ' ' || *_pos == '\t' || *_pos == '\n' || *_pos == '\r' ) ) ++_pos;
+         }
+
+         bool literal( const char* lit, size_t size ) {
+            if( size_t( _end - _pos ) < size || std::memcmp( _pos, lit, size ) != 0 ) return false;
+            _pos += size;
+            return true;
+         }
+
+         bool value( fc::variant& v, uint32_t depth ) {
+            skip_ws();
+            if( _pos == _end ) return false;
+            switch( *_pos ) {
+               case '{': return object( v, depth + 1 );
+               case '[': return array( v, depth + 1 );
+               case '"': {
+                  std::string s;
+                  if( !parse_string( s ) ) return false;
+                  v = fc::variant( std::move( s ) );
+                  return true;
+               }
+               case 't': v = fc::variant( true ); return literal( "true", 4 );
+               case 'f': v = fc::variant( false ); return literal( "false", 5 );
+               case 'n': v = fc::variant(); return literal( "null", 4 );
+               default: return number( v );
+            }
+         }
+
+         bool parse_string( std::string& s ) {
+            ++_pos; // opening quote
+            const char* close = static_cast<const char*>( std::memchr( _pos, '"', _end - _pos ) );
+            if( !close ) return false;
+            for( const char* p = _pos; p != close; ++p ) {
+               // escapes, control characters and non ASCII characters are left to fc::json
+               const auto c = static_cast<unsigned char>( *p );
+               if( c == '\\' || c < 0x20 || c >= 0x80 ) return false;
+            }
+            s.assign( _pos, close );
+            _pos = close + 1;
+            return true;
+         }
+
+         // integers only, as fc::json: int64 when negative, otherwise uint64
+         bool number( fc::variant& v ) {
+            const bool neg = *_pos == '-';
+            if( neg ) ++_pos;
+            const char* start = _pos;
+            uint64_t n = 0;
+            while( _pos != _end && *_pos >= '0' && *_pos <= '9' ) {
+               const uint64_t d = *_pos - '0';
+               if( n > ( std::numeric_limits<uint64_t>::max() - d ) / 10 ) return false;
+               n = n * 10 + d;
+               ++_pos;
+            }
+            const size_t digits = _pos - start;
+            if( digits == 0 || ( digits > 1 && *start == '0' ) ) return false;
+            if( _pos != _end && ( *_pos == '.' || *_pos == 'e' || *_pos == 'E' ) ) return false;
+            if( neg ) {
+               if( n > uint64_t( std::numeric_limits<int64_t>::max() ) ) return false;
+               v = fc::variant( -int64_t( n ) );
+            } else {
+               v = fc::variant( n );
+            }
+            return true;
+         }
+
+         bool object( fc::variant& v, uint32_t depth ) {
+            if( depth > max_depth ) return false;
+            ++_pos; // {
+            fc::mutable_variant_object obj;
+            skip_ws();
+            if( _pos != _end && *_pos == '}' ) {
+               ++_pos;
+               v = fc::variant( std::move( obj ) );
+               return true;
+            }
+            while( true ) {
+               skip_ws();
+               if( _pos == _end || *_pos != '"' ) return false;
+               std::string key;
+               if( !parse_string( key ) ) return false;
+               // fc::json decides which of repeated keys is kept
+               if( obj.find( key ) != obj.end() ) return false;
+               skip_ws();
+               if( _pos == _end || *_pos != ':' ) return false;
+               ++_pos;
+               fc::variant member;
+               if( !value( member, depth ) ) return false;
+               obj( std::move( key ), std::move( member ) );
+               skip_ws();
+               if( _pos == _end ) return false;
+               if( *_pos == '}' ) {
+                  ++_pos;
+                  v = fc::variant( std::move( obj ) );
+                  return true;
+               }
+               if( *_pos != ',' ) return false;
+               ++_pos;
+            }
+         }
+
+         bool array( fc::variant& v, uint32_t depth ) {
+            if( depth > max_depth ) return false;
+            ++_pos; // [
+            fc::variants arr;
+            skip_ws();
+            if( _pos != _end && *_pos == ']' ) {
+               ++_pos;
+               v = fc::variant( std::move( arr ) );
+               return true;
+            }
+            while( true ) {
+               fc::variant element;
+               if( !value( element, depth ) ) return false;
+               arr.emplace_back( std::move( element ) );
+               skip_ws();
+               if( _pos == _end ) return false;
+               if( *_pos == ']' ) {
+                  ++_pos;
+                  v = fc::variant( std::move( arr ) );
+                  return true;
+               }
+               if( *_pos != ',' ) return false;
+               ++_pos;
+            }
+         }
+
+         const char* _pos;
+         const char* _end;
+      };
+   }
+
+   std::optional<fc::variant> parse_simple_json( std::string_view body ) {
+      return simple_json_parser( body ).parse();
+   }
+
+   fc::variant parse_json_body( const std::string& body ) {
+      if( auto v = parse_simple_json( body ) )
+         return std::move( *v );
+      return fc::json::from_string( body );
+   }
+
+}
@@ -0,0 +1,62 @@
+#define BOOST_TEST_MODULE json_body
+#include <boost/test/included/unit_test.hpp>
+#include <eosio/http_plugin/json_body.hpp>
+
+#include <fc/io/json.hpp>
+
+using namespace eosio;
+
+namespace {
+   std::string to_json( const fc::variant& v ) {
+      return fc::json::to_string( v, fc::time_point::maximum() );
+   }
+}
+
+BOOST_AUTO_TEST_SUITE(json_body_tests)
+
+BOOST_AUTO_TEST_CASE(same_as_fc_json) {
+   const std::vector<std::string> bodies = {
+      R"({"signatures":["SIG_K1_KfQ57wLFEZxU8Cdjgk5AHj9v9rN5rXRTVJgHq1nRQ4Jk7AXk"],"compression":"none","packed_context_free_data":"","packed_trx":"8c31c5610000"})",
+      R"( { "code" : "eosio.token", "table":"accounts", "scope":"alice", "json":true, "limit":10, "lower_bound":null } )",
+      R"({"a":[1,-2,0,18446744073709551615,-9223372036854775807],"b":{"c":[],"d":{}},"e":false})",
+      R"([])",
+      R"("just a string")",
+      R"(42)",
+   };
+   for( const auto& body : bodies ) {
+      auto v = parse_simple_json( body );
+      BOOST_TEST_REQUIRE( v.has_value(), body );
+      BOOST_TEST( to_json( *v ) == to_json( fc::json::from_string( body ) ) );
+      BOOST_TEST( v->get_type() == fc::json::from_string( body ).get_type() );
+   }
+   auto v = parse_simple_json( R"({"n":5,"m":-5})" );
+   BOOST_TEST_REQUIRE( v.has_value() );
+   BOOST_TEST( ( v->get_object()["n"].get_type() == fc::variant::uint64_type ) );
+   BOOST_TEST( ( v->get_object()["m"].get_type() == fc::variant::int64_type ) );
+}
+
+BOOST_AUTO_TEST_CASE(left_to_fc_json) {
+   const std::vector<std::string> bodies = {
+      R"({"s":"with \"escape\""})",
+      R"({"d":1.5})",
+      R"({"e":1e3})",
+      R"({"k":1,"k":2})",
+      R"({"u":"caf)" "\xc3\xa9" R"("})",
+      R"({"n":18446744073709551616})",
+      R"({"n":-9223372036854775808})",
+      R"({"n":012})",
+      R"({"a":1,})",
+      R"({"a":1} trailing)",
+      R"({"a":1)",
+      R"()",
+      R"(   )",
+      std::string( 100, '[' ) + std::string( 100, ']' ),
+   };
+   for( const auto& body : bodies ) {
+      BOOST_TEST( !parse_simple_json( body ).has_value(), body );
+   }
+   BOOST_TEST( parse_json_body( R"({"s":"with \"escape\""})" ).get_object()["s"].as_string() == "with \"escape\"" );
+   BOOST_TEST( parse_json_body( R"({"d":1.5})" ).get_object()["d"].as_double() == 1.5 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
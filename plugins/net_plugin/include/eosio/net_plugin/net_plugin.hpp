@@ -11,6 +11,13 @@ namespace eosio {
       bool              connecting = false;
       bool              syncing    = false;
       handshake_message last_handshake;
+      uint64_t          bytes_received = 0;
+      uint64_t          bytes_sent = 0;
+      uint64_t          receive_rate = 0;        ///< bytes per second
+      uint64_t          send_rate = 0;           ///< bytes per second
+      int64_t           round_trip_time_us = 0;  ///< 0 if not yet measured
+      int64_t           block_latency_us = 0;    ///< block timestamp to receipt, smoothed
+      uint32_t          write_queue_size = 0;    ///< bytes waiting to be sent
    };
 
    class net_plugin : public appbase::plugin<net_plugin>
@@ -38,4 +45,5 @@ namespace eosio {
 
 }
 
-FC_REFLECT( eosio::connection_status, (peer)(connecting)(syncing)(last_handshake) )
+FC_REFLECT( eosio::connection_status, (peer)(connecting)(syncing)(last_handshake)
+            (bytes_received)(bytes_sent)(receive_rate)(send_rate)(round_trip_time_us)(block_latency_us)(write_queue_size) )
@@ -140,6 +140,35 @@ namespace eosio {
       std::shared_ptr<packed_transaction> trx;
    };
 
+   /// a packed transaction of a compact block that the receiving peer already has
+   struct known_packed_transaction {
+      transaction_id_type id;
+   };
+
+   struct compact_transaction_receipt : public transaction_receipt_header {
+      std::variant<transaction_id_type, packed_transaction, known_packed_transaction> trx;
+   };
+
+   /**
+    * A signed_block whose packed transactions that the receiving peer is known to have are replaced by their ids.
+    * The receiver rebuilds the block from the transactions it has cached and asks for the full block otherwise.
+    */
+   struct compact_block_message {
+      signed_block_header                                    header;
+      fc::enum_type<uint8_t,signed_block::prune_state_type> prune_state{signed_block::prune_state_type::complete_legacy};
+      vector<compact_transaction_receipt>                    transactions;
+      extensions_type                                        block_extensions;
+   };
+
+   /**
+    * A signed_block with everything after its header zlib compressed. The header is left uncompressed so a block
+    * already received is skipped without decompressing it.
+    */
+   struct compressed_block_message {
+      signed_block_header header;
+      bytes               data; ///< compressed pack of prune_state, transactions and block_extensions
+   };
+
    using net_message = std::variant<handshake_message,
                                     chain_size_message,
                                     go_away_message,
@@ -150,7 +179,9 @@ namespace eosio {
                                     signed_block_v0,         // which = 7
                                     packed_transaction_v0,   // which = 8
                                     signed_block,            // which = 9
-                                    trx_message_v1>;         // which = 10
+                                    trx_message_v1,          // which = 10
+                                    compact_block_message,   // which = 11
+                                    compressed_block_message>; // which = 12
 
 } // namespace eosio
 
@@ -170,6 +201,10 @@ FC_REFLECT( eosio::notice_message, (known_trx)(known_blocks) )
 FC_REFLECT( eosio::request_message, (req_trx)(req_blocks) )
 FC_REFLECT( eosio::sync_request_message, (start_block)(end_block) )
 FC_REFLECT( eosio::trx_message_v1, (trx_id)(trx) )
+FC_REFLECT( eosio::known_packed_transaction, (id) )
+FC_REFLECT_DERIVED( eosio::compact_transaction_receipt, (eosio::chain::transaction_receipt_header), (trx) )
+FC_REFLECT( eosio::compact_block_message, (header)(prune_state)(transactions)(block_extensions) )
+FC_REFLECT( eosio::compressed_block_message, (header)(data) )
 
 
 /**
@@ -5,9 +5,11 @@
 #include <eosio/chain/controller.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/block.hpp>
+#include <eosio/chain/merkle.hpp>
 #include <eosio/chain/plugin_interface.hpp>
 #include <eosio/chain/thread_utils.hpp>
 #include <eosio/producer_plugin/producer_plugin.hpp>
+#include <eosio/http_plugin/main_thread_queue.hpp>
 #include <eosio/chain/contract_types.hpp>
 
 #include <fc/network/message_buffer.hpp>
@@ -24,10 +26,18 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ip/host_name.hpp>
 #include <boost/asio/steady_timer.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
 
+#include <array>
 #include <atomic>
 #include <shared_mutex>
 
+#ifdef __linux__
+#include <netinet/tcp.h>
+#endif
+
 using namespace eosio::chain::plugin_interface;
 
 namespace eosio {
@@ -65,6 +75,7 @@ namespace eosio {
       time_point_sec  expires;        /// time after which this may be purged.
       uint32_t        block_num = 0;  /// block transaction was included in
       uint32_t        connection_id = 0;
+      packed_transaction_ptr trx;     /// kept for rebuilding compact blocks, may be null
    };
 
    struct by_expiry;
@@ -138,12 +149,28 @@ namespace eosio {
          in_sync
       };
 
+      struct sync_range {
+         uint32_t       start = 0;
+         uint32_t       end = 0;
+         connection_ptr source; ///< null when the range needs to be requested again
+      };
+
+      struct sync_pending_block {
+         connection_ptr   c;
+         block_id_type    id;
+         signed_block_ptr block;
+      };
+
       mutable std::mutex sync_mtx;
       uint32_t       sync_known_lib_num{0};
       uint32_t       sync_last_requested_num{0};
       uint32_t       sync_next_expected_num{0};
+      uint32_t       sync_next_dispatch_num{0}; ///< next sync block handed to the application thread, 0 if not yet known
       uint32_t       sync_req_span{0};
-      connection_ptr sync_source;
+      const uint32_t sync_fetch_peers{1};
+      connection_ptr sync_source;               ///< most recently selected source, round-robin selection starts after it
+      deque<sync_range> sync_ranges;            ///< outstanding requests ordered by start, at most sync_fetch_peers
+      std::map<uint32_t, sync_pending_block> sync_pending_blocks; ///< sync blocks received ahead of sync_next_dispatch_num
       std::atomic<stages> sync_state{in_sync};
 
    private:
@@ -153,25 +180,74 @@ namespace eosio {
       void request_next_chunk( std::unique_lock<std::mutex> g_sync, const connection_ptr& conn = connection_ptr() );
       void start_sync( const connection_ptr& c, uint32_t target );
       bool verify_catchup( const connection_ptr& c, uint32_t num, const block_id_type& id );
+      connection_ptr select_sync_source( const connection_ptr& conn );
+      bool is_sync_source( const connection_ptr& c ) const;
+      void release_sync_source( const connection_ptr& c );
+      bool pop_completed_ranges();
+      void reset_sync_ranges();
 
    public:
-      explicit sync_manager( uint32_t span );
+      sync_manager( uint32_t span, uint32_t fetch_peers );
       static void send_handshakes();
       bool syncing_with_peer() const { return sync_state == lib_catchup; }
       void sync_reset_lib_num( const connection_ptr& conn );
       void sync_reassign_fetch( const connection_ptr& c, go_away_reason reason );
       void rejected_block( const connection_ptr& c, uint32_t blk_num );
       void sync_recv_block( const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num, bool blk_applied );
+      void sync_dispatch_block( const connection_ptr& c, const block_id_type& blk_id, signed_block_ptr b );
       void sync_update_expected( const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num, bool blk_applied );
       void recv_handshake( const connection_ptr& c, const handshake_message& msg );
       void sync_recv_notice( const connection_ptr& c, const notice_message& msg );
    };
 
+   /// serialized net_message including its header, immutable once created so it can be shared by all connections
+   using send_buffer_type = std::shared_ptr<const std::vector<char>>;
+
+   /**
+    * Index split by block/trx id into shards, each guarded by its own mutex, so net threads working on different ids
+    * do not contend. Lookups by id touch a single shard; expiry walks the shards one at a time.
+    */
+   template <typename Index>
+   class sharded_index {
+   public:
+      static constexpr size_t num_shards = 16;
+
+      struct shard {
+         mutable std::mutex mtx;
+         Index              index;
+      };
+
+      /// _hash[0] of a block id starts with the block number, use a word that is all hash
+      shard& get( const fc::sha256& id ) { return shards[ id._hash[1] % num_shards ]; }
+      const shard& get( const fc::sha256& id ) const { return shards[ id._hash[1] % num_shards ]; }
+
+      template <typename F>
+      void for_each_shard( F&& f ) {
+         for( auto& s : shards ) {
+            std::lock_guard<std::mutex> g( s.mtx );
+            f( s.index );
+         }
+      }
+
+   private:
+      std::array<shard, num_shards> shards;
+   };
+
    class dispatch_manager {
-      mutable std::mutex      blk_state_mtx;
-      peer_block_state_index  blk_state;
-      mutable std::mutex      local_txns_mtx;
-      node_transaction_index  local_txns;
+      sharded_index<peer_block_state_index>  blk_state;
+      sharded_index<node_transaction_index>  local_txns;
+      std::mutex                             requested_txns_mtx;
+      std::map<transaction_id_type, fc::time_point> requested_txns; // announced trxs requested from a peer
+
+      struct block_send_buffers {
+         signed_block_ptr block;
+         send_buffer_type send_buffer;
+         send_buffer_type send_buffer_v0;
+         send_buffer_type send_buffer_compressed; // same as send_buffer if the block does not compress well
+      };
+      static constexpr size_t max_block_send_buffers = 32;
+      std::mutex                 block_buffers_mtx;
+      deque<block_send_buffers>  block_buffers; // most recently serialized blocks, oldest first
 
    public:
       boost::asio::io_context::strand  strand;
@@ -200,7 +276,11 @@ namespace eosio {
       void update_txns_block_num( const transaction_id_type& id, uint32_t blk_num );
       bool peer_has_txn( const transaction_id_type& tid, uint32_t connection_id ) const;
       bool have_txn( const transaction_id_type& tid ) const;
+      packed_transaction_ptr get_txn( const transaction_id_type& tid ) const;
+      void recv_trx_notice( const connection_ptr& c, const vector<transaction_id_type>& ids );
       void expire_txns( uint32_t lib_num );
+
+      send_buffer_type get_block_send_buffer( const signed_block_ptr& b, uint16_t protocol_version );
    };
 
    class net_plugin_impl : public std::enable_shared_from_this<net_plugin_impl> {
@@ -240,6 +320,10 @@ namespace eosio {
       uint32_t                              max_client_count = 0;
       uint32_t                              max_nodes_per_host = 1;
       bool                                  p2p_accept_transactions = true;
+      bool                                  p2p_announce_transactions = false;
+      uint32_t                              max_trx_queue_size = def_max_trx_queue_size_kb * 1024;
+      string                                p2p_blk_congestion_control;
+      bool                                  p2p_compress_blocks = false;
       bool                                  p2p_reject_incomplete_blocks = true;
 
       /// Peer clock may be no more than 1 second skewed from our clock, including network latency.
@@ -382,6 +466,8 @@ namespace eosio {
    constexpr auto     def_send_buffer_size_mb = 4;
    constexpr auto     def_send_buffer_size = 1024*1024*def_send_buffer_size_mb;
    constexpr auto     def_max_write_queue_size = def_send_buffer_size*10;
+   constexpr auto     def_max_trx_queue_size_kb = def_max_write_queue_size / 2 / 1024;
+   constexpr auto     def_max_write_batch_size = def_send_buffer_size;
    constexpr auto     def_max_trx_in_progress_size = 100*1024*1024; // 100 MB
    constexpr auto     def_max_consecutive_immediate_connection_close = 9; // back off if client keeps closing
    constexpr auto     def_max_clients = 25; // 0 for unlimited clients
@@ -389,7 +475,9 @@ namespace eosio {
    constexpr auto     def_conn_retry_wait = 30;
    constexpr auto     def_txn_expire_wait = std::chrono::seconds(3);
    constexpr auto     def_resp_expected_wait = std::chrono::seconds(5);
+   constexpr auto     def_trx_request_wait = std::chrono::seconds(5);
    constexpr auto     def_sync_fetch_span = 100;
+   constexpr auto     def_sync_fetch_peers = 1;
    constexpr auto     def_keepalive_interval = 32000;
 
    constexpr auto     message_header_size = 4;
@@ -397,6 +485,8 @@ namespace eosio {
    constexpr uint32_t packed_transaction_v0_which = fc::get_index<net_message, packed_transaction_v0>(); // see protocol net_message
    constexpr uint32_t signed_block_which          = fc::get_index<net_message, signed_block>();          // see protocol net_message
    constexpr uint32_t trx_message_v1_which        = fc::get_index<net_message, trx_message_v1>();        // see protocol net_message
+   constexpr uint32_t compact_block_which         = fc::get_index<net_message, compact_block_message>(); // see protocol net_message
+   constexpr uint32_t compressed_block_which      = fc::get_index<net_message, compressed_block_message>(); // see protocol net_message
 
    /**
     *  For a while, network version was a 16 bit value equal to the second set of 16 bits
@@ -422,8 +512,11 @@ namespace eosio {
    constexpr uint16_t proto_pruned_types = 3;        // supports new signed_block & packed_transaction types
    constexpr uint16_t heartbeat_interval = 4;        // supports configurable heartbeat interval
    constexpr uint16_t dup_goaway_resolution = 5;     // support peer address based duplicate connection resolution
+   constexpr uint16_t proto_compact_blocks = 6;      // supports compact_block_message
+   constexpr uint16_t proto_trx_announce = 7;        // supports notice_message known_trx and request_message req_trx transaction ids
+   constexpr uint16_t proto_block_compression = 8;   // supports compressed_block_message
 
-   constexpr uint16_t net_version = dup_goaway_resolution;
+   constexpr uint16_t net_version = proto_block_compression;
 
    /**
     * Index by start_block_num
@@ -440,12 +533,24 @@ namespace eosio {
    };
 
    // thread safe
+   /// write queue lanes of queued_buffer, sent in this order
+   enum class msg_priority {
+      control,  ///< handshake, go_away, time and chain_size messages
+      block,    ///< blocks relayed as they are accepted
+      sync,     ///< blocks requested by a syncing peer
+      notice,   ///< notices and requests
+      trx,      ///< transactions
+      count
+   };
+
    class queued_buffer : boost::noncopyable {
    public:
       void clear_write_queue() {
          std::lock_guard<std::mutex> g( _mtx );
-         _write_queue.clear();
-         _sync_write_queue.clear();
+         for( auto& q : _write_queues ) {
+            q.clear();
+         }
+         _lane_sizes.fill( 0 );
          _write_queue_size = 0;
       }
 
@@ -461,6 +566,11 @@ namespace eosio {
          return _write_queue_size;
       }
 
+      uint32_t write_queue_size( msg_priority priority ) const {
+         std::lock_guard<std::mutex> g( _mtx );
+         return _lane_sizes[static_cast<size_t>( priority )];
+      }
+
       bool is_out_queue_empty() const {
          std::lock_guard<std::mutex> g( _mtx );
          return _out_queue.empty();
@@ -469,19 +579,17 @@ namespace eosio {
       bool ready_to_send() const {
          std::lock_guard<std::mutex> g( _mtx );
          // if out_queue is not empty then async_write is in progress
-         return ((!_sync_write_queue.empty() || !_write_queue.empty()) && _out_queue.empty());
+         return _write_queue_size > 0 && _out_queue.empty();
       }
 
       // @param callback must not callback into queued_buffer
-      bool add_write_queue( const std::shared_ptr<vector<char>>& buff,
+      bool add_write_queue( const send_buffer_type& buff,
                             std::function<void( boost::system::error_code, std::size_t )> callback,
-                            bool to_sync_queue ) {
+                            msg_priority priority ) {
          std::lock_guard<std::mutex> g( _mtx );
-         if( to_sync_queue ) {
-            _sync_write_queue.push_back( {buff, callback} );
-         } else {
-            _write_queue.push_back( {buff, callback} );
-         }
+         const auto lane = static_cast<size_t>( priority );
+         _write_queues[lane].push_back( {buff, callback, lane} );
+         _lane_sizes[lane] += buff->size();
          _write_queue_size += buff->size();
          if( _write_queue_size > 2 * def_max_write_queue_size ) {
             return false;
@@ -489,13 +597,21 @@ namespace eosio {
          return true;
       }
 
+      /// fills bufs from the lanes in priority order, lower lanes only while the batch is under def_max_write_batch_size
+      /// so a message queued during the write waits for at most one batch of lower priority messages
       void fill_out_buffer( std::vector<boost::asio::const_buffer>& bufs ) {
          std::lock_guard<std::mutex> g( _mtx );
-         if( _sync_write_queue.size() > 0 ) { // always send msgs from sync_write_queue first
-            fill_out_buffer( bufs, _sync_write_queue );
-         } else { // postpone real_time write_queue if sync queue is not empty
-            fill_out_buffer( bufs, _write_queue );
-            EOS_ASSERT( _write_queue_size == 0, plugin_exception, "write queue size expected to be zero" );
+         size_t batch_size = 0;
+         for( auto& w_queue : _write_queues ) {
+            while( w_queue.size() > 0 && batch_size < def_max_write_batch_size ) {
+               auto& m = w_queue.front();
+               bufs.push_back( boost::asio::buffer( *m.buff ));
+               batch_size += m.buff->size();
+               _lane_sizes[m.lane] -= m.buff->size();
+               _write_queue_size -= m.buff->size();
+               _out_queue.emplace_back( m );
+               w_queue.pop_front();
+            }
          }
       }
 
@@ -506,29 +622,19 @@ namespace eosio {
          }
       }
 
-   private:
-      struct queued_write;
-      void fill_out_buffer( std::vector<boost::asio::const_buffer>& bufs,
-                            deque<queued_write>& w_queue ) {
-         while ( w_queue.size() > 0 ) {
-            auto& m = w_queue.front();
-            bufs.push_back( boost::asio::buffer( *m.buff ));
-            _write_queue_size -= m.buff->size();
-            _out_queue.emplace_back( m );
-            w_queue.pop_front();
-         }
-      }
-
    private:
       struct queued_write {
-         std::shared_ptr<vector<char>> buff;
+         send_buffer_type buff;
          std::function<void( boost::system::error_code, std::size_t )> callback;
+         size_t lane = 0;
       };
 
+      static constexpr size_t num_lanes = static_cast<size_t>( msg_priority::count );
+
       mutable std::mutex  _mtx;
       uint32_t            _write_queue_size{0};
-      deque<queued_write> _write_queue;
-      deque<queued_write> _sync_write_queue; // sync_write_queue will be sent first
+      std::array<uint32_t, num_lanes>            _lane_sizes{};
+      std::array<deque<queued_write>, num_lanes> _write_queues;
       deque<queued_write> _out_queue;
 
    }; // queued_buffer
@@ -621,6 +727,7 @@ namespace eosio {
       queued_buffer           buffer_queue;
 
       std::atomic<uint32_t>   trx_in_progress_size{0};
+      vector<transaction_id_type> trx_announcements; // connection strand only, ids not yet sent in a notice_message
       const uint32_t          connection_id;
       int16_t                 sent_handshake_count = 0;
       std::atomic<bool>       connecting{true};
@@ -651,6 +758,22 @@ namespace eosio {
 
       connection_status get_status()const;
 
+      /** \name Peer Metrics
+       *  Thread safe, atomic. Reported in connection_status and used to prefer well performing peers.
+       *  @{
+       */
+      std::atomic<uint64_t>          bytes_received{0};
+      std::atomic<uint64_t>          bytes_sent{0};
+      std::atomic<uint64_t>          receive_rate{0};     //!< bytes per second, smoothed over heartbeat intervals
+      std::atomic<uint64_t>          send_rate{0};        //!< bytes per second, smoothed over heartbeat intervals
+      std::atomic<int64_t>           round_trip_time{0};  //!< nanoseconds from time_message exchange, 0 if not yet measured
+      std::atomic<int64_t>           block_latency{0};    //!< microseconds from block timestamp to receipt, smoothed
+      /** @} */
+      // connection strand only, totals at the last rate update
+      uint64_t                       rate_bytes_received{0};
+      uint64_t                       rate_bytes_sent{0};
+      tstamp                         rate_time{0};
+
       /** \name Peer Timestamps
        *  Time message handling
        *  @{
@@ -675,6 +798,10 @@ namespace eosio {
       static void _close( connection* self, bool reconnect, bool shutdown ); // for easy capture
 
       bool process_next_block_message(uint32_t message_length);
+      bool process_next_compact_block_message(uint32_t message_length);
+      bool process_next_compressed_block_message(uint32_t message_length);
+      bool discard_block_message(const block_header& bh, const block_id_type& blk_id);
+      bool process_block(const block_id_type& blk_id, shared_ptr<signed_block> ptr);
       bool process_next_trx_message(uint32_t message_length);
    public:
 
@@ -702,6 +829,8 @@ namespace eosio {
       /**  \brief Check heartbeat time and send Time_message
        */
       void check_heartbeat( tstamp current_time );
+      void update_rates( tstamp current_time );
+      void update_block_latency( int64_t latency_us );
       /**  \brief Populate and queue time_message
        */
       void send_time();
@@ -729,13 +858,16 @@ namespace eosio {
 
       void enqueue( const net_message &msg );
       void enqueue_block( const signed_block_ptr& sb, bool to_sync_queue = false);
-      void enqueue_buffer( const std::shared_ptr<std::vector<char>>& send_buffer,
+      void enqueue_buffer( const send_buffer_type& send_buffer,
                            go_away_reason close_after_send,
-                           bool to_sync_queue = false);
+                           msg_priority priority );
       void cancel_sync(go_away_reason);
       void flush_queues();
       bool enqueue_sync_block();
       void request_sync_blocks(uint32_t start, uint32_t end);
+      void announce_trx( const transaction_id_type& id );
+      void send_requested_trxs( const vector<transaction_id_type>& ids );
+      void flush_trx_announcements();
 
       void cancel_wait();
       void sync_wait();
@@ -743,9 +875,9 @@ namespace eosio {
       void sync_timeout(boost::system::error_code ec);
       void fetch_timeout(boost::system::error_code ec);
 
-      void queue_write(const std::shared_ptr<vector<char>>& buff,
+      void queue_write(const send_buffer_type& buff,
                        std::function<void(boost::system::error_code, std::size_t)> callback,
-                       bool to_sync_queue = false);
+                       msg_priority priority);
       void do_queue_write();
 
       static bool is_valid( const handshake_message& msg );
@@ -932,6 +1064,13 @@ namespace eosio {
       stat.peer = peer_addr;
       stat.connecting = connecting;
       stat.syncing = syncing;
+      stat.bytes_received = bytes_received;
+      stat.bytes_sent = bytes_sent;
+      stat.receive_rate = receive_rate;
+      stat.send_rate = send_rate;
+      stat.round_trip_time_us = round_trip_time / 1000;
+      stat.block_latency_us = block_latency;
+      stat.write_queue_size = buffer_queue.write_queue_size();
       std::lock_guard<std::mutex> g( conn_mtx );
       stat.last_handshake = last_handshake_recv;
       return stat;
@@ -949,6 +1088,16 @@ namespace eosio {
          close();
          return false;
       } else {
+#ifdef __linux__
+         const auto& cc = my_impl->p2p_blk_congestion_control;
+         if( is_blocks_only_connection() && !cc.empty() ) {
+            // a loss tolerant algorithm such as bbr keeps block propagation steady on lossy long distance links
+            if( setsockopt( socket->native_handle(), IPPROTO_TCP, TCP_CONGESTION, cc.c_str(), cc.size() ) != 0 ) {
+               fc_wlog( logger, "unable to set TCP congestion control ${cc} for ${peer}: ${e}",
+                        ("cc", cc)("peer", peer_name())("e", strerror( errno )) );
+            }
+         }
+#endif
          fc_dlog( logger, "connected to ${peer}", ("peer", peer_name()) );
          socket_open = true;
          start_read_message();
@@ -1035,7 +1184,7 @@ namespace eosio {
       const auto lib_num = block_header::num_from_id(lib_id);
       if( lib_num == 0 ) return; // if last_irreversible_block_id is null (we have not received handshake or reset)
 
-      app().post( priority::medium, [chain_plug = my_impl->chain_plug, c = shared_from_this(),
+      main_thread_post( priority::medium, [chain_plug = my_impl->chain_plug, c = shared_from_this(),
             lib_num, head_num, msg_head_id]() {
          auto msg_head_num = block_header::num_from_id(msg_head_id);
          bool on_fork = msg_head_num == 0;
@@ -1087,7 +1236,7 @@ namespace eosio {
 
    void connection::blk_send( const block_id_type& blkid ) {
       connection_wptr weak = shared_from_this();
-      app().post( priority::medium, [blkid, weak{std::move(weak)}]() {
+      main_thread_post( priority::medium, [blkid, weak{std::move(weak)}]() {
          connection_ptr c = weak.lock();
          if( !c ) return;
          try {
@@ -1154,9 +1303,31 @@ namespace eosio {
             return;
          }
       }
+      update_rates( current_time );
       send_time();
    }
 
+   // called from connection strand
+   void connection::update_rates( tstamp current_time ) {
+      const uint64_t received = bytes_received;
+      const uint64_t sent = bytes_sent;
+      if( rate_time > 0 && current_time > rate_time ) {
+         const double secs = double( current_time - rate_time ) / 1e9; // tstamp is nanoseconds
+         auto smooth = []( uint64_t prev, uint64_t cur ) { return prev == 0 ? cur : (prev * 3 + cur) / 4; };
+         receive_rate = smooth( receive_rate, uint64_t( double( received - rate_bytes_received ) / secs ) );
+         send_rate = smooth( send_rate, uint64_t( double( sent - rate_bytes_sent ) / secs ) );
+      }
+      rate_bytes_received = received;
+      rate_bytes_sent = sent;
+      rate_time = current_time;
+   }
+
+   // called from connection strand
+   void connection::update_block_latency( int64_t latency_us ) {
+      const int64_t prev = block_latency;
+      block_latency = prev == 0 ? latency_us : (prev * 3 + latency_us) / 4;
+   }
+
    void connection::send_time() {
       time_message xpkt;
       xpkt.org = rec;
@@ -1174,10 +1345,10 @@ namespace eosio {
       enqueue(xpkt);
    }
 
-   void connection::queue_write(const std::shared_ptr<vector<char>>& buff,
+   void connection::queue_write(const send_buffer_type& buff,
                                 std::function<void(boost::system::error_code, std::size_t)> callback,
-                                bool to_sync_queue) {
-      if( !buffer_queue.add_write_queue( buff, callback, to_sync_queue )) {
+                                msg_priority priority) {
+      if( !buffer_queue.add_write_queue( buff, callback, priority )) {
          fc_wlog( logger, "write_queue full ${s} bytes, giving up on connection ${p}",
                   ("s", buffer_queue.write_queue_size())("p", peer_name()) );
          close();
@@ -1217,6 +1388,7 @@ namespace eosio {
                   return;
                }
 
+               c->bytes_sent += w;
                c->buffer_queue.out_callback( ec, w );
 
                c->enqueue_sync_block();
@@ -1266,7 +1438,7 @@ namespace eosio {
          fc_ilog( logger, "completing enqueue_sync_block ${num} to ${p}", ("num", num)("p", peer_name()) );
       }
       connection_wptr weak = shared_from_this();
-      app().post( priority::medium, [num, weak{std::move(weak)}]() {
+      main_thread_post( priority::medium, [num, weak{std::move(weak)}]() {
          connection_ptr c = weak.lock();
          if( !c ) return;
          controller& cc = my_impl->chain_plug->chain();
@@ -1291,8 +1463,6 @@ namespace eosio {
 
    //------------------------------------------------------------------------
 
-   using send_buffer_type = std::shared_ptr<std::vector<char>>;
-
    struct buffer_factory {
 
       /// caches result for subsequent calls, only provide same net_message instance for each invocation
@@ -1345,6 +1515,45 @@ namespace eosio {
 
    };
 
+   namespace bio = boost::iostreams;
+
+   /// zlib at best speed, compression is on the block relay path
+   static bytes zlib_compress( const bytes& in ) {
+      bytes out;
+      bio::filtering_ostream comp;
+      comp.push( bio::zlib_compressor( bio::zlib::best_speed ) );
+      comp.push( bio::back_inserter( out ) );
+      bio::write( comp, in.data(), in.size() );
+      bio::close( comp );
+      return out;
+   }
+
+   template<size_t Limit>
+   struct decompress_limiter {
+      using char_type = char;
+      using category = bio::multichar_output_filter_tag;
+
+      template<typename Sink>
+      size_t write( Sink& sink, const char* s, size_t count ) {
+         EOS_ASSERT( total + count <= Limit, plugin_exception, "Exceeded maximum decompressed block size" );
+         total += count;
+         return bio::write( sink, s, count );
+      }
+
+      size_t total = 0;
+   };
+
+   static bytes zlib_decompress( const bytes& in ) {
+      bytes out;
+      bio::filtering_ostream decomp;
+      decomp.push( bio::zlib_decompressor() );
+      decomp.push( decompress_limiter<def_send_buffer_size*2>() ); // same limit as an uncompressed message
+      decomp.push( bio::back_inserter( out ) );
+      bio::write( decomp, in.data(), in.size() );
+      bio::close( decomp );
+      return out;
+   }
+
    struct block_buffer_factory : public buffer_factory {
 
       /// caches result for subsequent calls, only provide same signed_block_ptr instance for each invocation.
@@ -1370,7 +1579,7 @@ namespace eosio {
 
    private:
 
-      static std::shared_ptr<std::vector<char>> create_send_buffer( const signed_block_ptr& sb ) {
+      static send_buffer_type create_send_buffer( const signed_block_ptr& sb ) {
          static_assert( signed_block_which == fc::get_index<net_message, signed_block>() );
          // this implementation is to avoid copy of signed_block to net_message
          // matches which of net_message for signed_block
@@ -1378,7 +1587,66 @@ namespace eosio {
          return buffer_factory::create_send_buffer( signed_block_which, *sb );
       }
 
-      static std::shared_ptr<std::vector<char>> create_send_buffer( const signed_block_v0& sb_v0 ) {
+   public:
+
+      /// returns an empty buffer if the block does not compress to less than 90% of its size
+      static send_buffer_type create_compressed_send_buffer( const signed_block_ptr& sb ) {
+         static_assert( compressed_block_which == fc::get_index<net_message, compressed_block_message>() );
+         const auto start = fc::time_point::now();
+         const size_t rest_size = fc::raw::pack_size( sb->prune_state ) + fc::raw::pack_size( sb->transactions ) +
+                                  fc::raw::pack_size( sb->block_extensions );
+         bytes rest( rest_size );
+         fc::datastream<char*> ds( rest.data(), rest.size() );
+         fc::raw::pack( ds, sb->prune_state );
+         fc::raw::pack( ds, sb->transactions );
+         fc::raw::pack( ds, sb->block_extensions );
+
+         compressed_block_message cb{ static_cast<const signed_block_header&>( *sb ), zlib_compress( rest ) };
+         fc_dlog( logger, "compressed block ${bn} from ${s} to ${c} bytes in ${t}us",
+                  ("bn", sb->block_num())("s", rest.size())("c", cb.data.size())("t", (fc::time_point::now() - start).count()) );
+         if( cb.data.size() * 10 >= rest.size() * 9 ) return {};
+         return buffer_factory::create_send_buffer( compressed_block_which, cb );
+      }
+
+      /// not cached, which transactions are replaced by their ids depends on the receiving peer.
+      /// returns an empty buffer if peer_has_trx is false for every packed transaction, send the full block instead.
+      template<typename PeerHasTrx>
+      static send_buffer_type create_compact_send_buffer( const signed_block& sb, PeerHasTrx&& peer_has_trx ) {
+         static_assert( compact_block_which == fc::get_index<net_message, compact_block_message>() );
+         std::vector<bool> known( sb.transactions.size(), false );
+         bool any_known = false;
+         for( size_t i = 0; i < sb.transactions.size(); ++i ) {
+            const auto& r = sb.transactions[i];
+            if( std::holds_alternative<packed_transaction>( r.trx ) && peer_has_trx( std::get<packed_transaction>( r.trx ).id() ) ) {
+               known[i] = true;
+               any_known = true;
+            }
+         }
+         if( !any_known ) return {};
+
+         compact_block_message cb;
+         cb.header = static_cast<const signed_block_header&>( sb );
+         cb.prune_state = sb.prune_state;
+         cb.block_extensions = sb.block_extensions;
+         cb.transactions.reserve( sb.transactions.size() );
+         for( size_t i = 0; i < sb.transactions.size(); ++i ) {
+            const auto& r = sb.transactions[i];
+            compact_transaction_receipt cr;
+            static_cast<transaction_receipt_header&>( cr ) = r;
+            if( std::holds_alternative<transaction_id_type>( r.trx ) ) {
+               cr.trx = std::get<transaction_id_type>( r.trx );
+            } else if( known[i] ) {
+               cr.trx = known_packed_transaction{ std::get<packed_transaction>( r.trx ).id() };
+            } else {
+               cr.trx = std::get<packed_transaction>( r.trx );
+            }
+            cb.transactions.emplace_back( std::move( cr ) );
+         }
+         fc_dlog( logger, "sending compact block ${bn}", ("bn", sb.block_num()) );
+         return buffer_factory::create_send_buffer( compact_block_which, cb );
+      }
+
+      static send_buffer_type create_send_buffer( const signed_block_v0& sb_v0 ) {
          static_assert( signed_block_v0_which == fc::get_index<net_message, signed_block_v0>() );
          // this implementation is to avoid copy of signed_block_v0 to net_message
          // matches which of net_message for signed_block_v0
@@ -1412,7 +1680,7 @@ namespace eosio {
 
    private:
 
-      static std::shared_ptr<std::vector<char>> create_send_buffer( const packed_transaction_ptr& trx ) {
+      static send_buffer_type create_send_buffer( const packed_transaction_ptr& trx ) {
          static_assert( trx_message_v1_which == fc::get_index<net_message, trx_message_v1>() );
          std::optional<transaction_id_type> trx_id;
          if( trx->get_estimated_size() > 1024 ) { // simple guess on threshold
@@ -1424,7 +1692,7 @@ namespace eosio {
          return buffer_factory::create_send_buffer( trx_message_v1_which, v1 );
       }
 
-      static std::shared_ptr<std::vector<char>> create_send_buffer( const packed_transaction_v0& trx ) {
+      static send_buffer_type create_send_buffer( const packed_transaction_v0& trx ) {
          static_assert( packed_transaction_v0_which == fc::get_index<net_message, packed_transaction_v0>() );
          // this implementation is to avoid copy of packed_transaction_v0 to net_message
          // matches which of net_message for packed_transaction_v0
@@ -1440,18 +1708,19 @@ namespace eosio {
       if (std::holds_alternative<go_away_message>(m)) {
          close_after_send = std::get<go_away_message>(m).reason;
       }
+      const bool control = std::holds_alternative<handshake_message>(m) || std::holds_alternative<go_away_message>(m) ||
+                           std::holds_alternative<time_message>(m) || std::holds_alternative<chain_size_message>(m);
 
       buffer_factory buff_factory;
       auto send_buffer = buff_factory.get_send_buffer( m );
-      enqueue_buffer( send_buffer, close_after_send );
+      enqueue_buffer( send_buffer, close_after_send, control ? msg_priority::control : msg_priority::notice );
    }
 
    void connection::enqueue_block( const signed_block_ptr& b, bool to_sync_queue) {
       fc_dlog( logger, "enqueue block ${num}", ("num", b->block_num()) );
       verify_strand_in_this_thread( strand, __func__, __LINE__ );
 
-      block_buffer_factory buff_factory;
-      auto sb = buff_factory.get_send_buffer( b, protocol_version.load() );
+      auto sb = my_impl->dispatcher->get_block_send_buffer( b, protocol_version.load() );
       if( !sb ) {
          peer_wlog( this, "Sending go away for incomplete block #${n} ${id}...",
                     ("n", b->block_num())("id", b->calculate_id().str().substr(8,16)) );
@@ -1459,12 +1728,12 @@ namespace eosio {
          enqueue( go_away_message( fatal_other ) );
          return;
       }
-      enqueue_buffer( sb, no_reason, to_sync_queue);
+      enqueue_buffer( sb, no_reason, to_sync_queue ? msg_priority::sync : msg_priority::block );
    }
 
-   void connection::enqueue_buffer( const std::shared_ptr<std::vector<char>>& send_buffer,
+   void connection::enqueue_buffer( const send_buffer_type& send_buffer,
                                     go_away_reason close_after_send,
-                                    bool to_sync_queue)
+                                    msg_priority priority )
    {
       connection_ptr self = shared_from_this();
       queue_write(send_buffer,
@@ -1477,7 +1746,7 @@ namespace eosio {
                            return;
                         }
                   },
-                  to_sync_queue);
+                  priority);
    }
 
    // thread safe
@@ -1545,6 +1814,43 @@ namespace eosio {
       }
    }
 
+   // called from connection strand
+   void connection::announce_trx( const transaction_id_type& id ) {
+      trx_announcements.push_back( id );
+      if( trx_announcements.size() == 1 ) {
+         // ids announced by the handlers already queued on the strand go out in the same notice_message
+         strand.post( [c = shared_from_this()]() {
+            c->flush_trx_announcements();
+         } );
+      }
+   }
+
+   // called from connection strand
+   void connection::flush_trx_announcements() {
+      if( trx_announcements.empty() ) return;
+      notice_message note;
+      note.known_trx.mode = normal;
+      note.known_trx.pending = trx_announcements.size();
+      note.known_trx.ids = std::move( trx_announcements );
+      trx_announcements.clear();
+      peer_dlog( this, "announcing ${n} trxs", ("n", note.known_trx.ids.size()) );
+      enqueue( note );
+   }
+
+   // called from connection strand, trxs no longer cached are skipped, the peer receives them with the block
+   void connection::send_requested_trxs( const vector<transaction_id_type>& ids ) {
+      for( const auto& id : ids ) {
+         packed_transaction_ptr trx = my_impl->dispatcher->get_txn( id );
+         if( !trx ) continue;
+         my_impl->dispatcher->add_peer_txn( node_transaction_state{id, trx->expiration(), 0, connection_id} );
+         trx_buffer_factory buff_factory;
+         const send_buffer_type& sb = buff_factory.get_send_buffer( trx, protocol_version.load() );
+         if( sb ) {
+            enqueue_buffer( sb, no_reason, msg_priority::trx );
+         }
+      }
+   }
+
    void connection::request_sync_blocks(uint32_t start, uint32_t end) {
       sync_request_message srm = {start,end};
       enqueue( net_message(srm) );
@@ -1578,11 +1884,12 @@ namespace eosio {
    }
    //-----------------------------------------------------------
 
-    sync_manager::sync_manager( uint32_t req_span )
+    sync_manager::sync_manager( uint32_t req_span, uint32_t fetch_peers )
       :sync_known_lib_num( 0 )
       ,sync_last_requested_num( 0 )
       ,sync_next_expected_num( 1 )
       ,sync_req_span( req_span )
+      ,sync_fetch_peers( std::max( fetch_peers, 1u ) )
       ,sync_source()
       ,sync_state(in_sync)
    {
@@ -1610,6 +1917,7 @@ namespace eosio {
       std::unique_lock<std::mutex> g( sync_mtx );
       if( sync_state == in_sync ) {
          sync_source.reset();
+         reset_sync_ranges();
       }
       if( !c ) return;
       if( c->current() ) {
@@ -1617,12 +1925,87 @@ namespace eosio {
          if( c->last_handshake_recv.last_irreversible_block_num > sync_known_lib_num ) {
             sync_known_lib_num = c->last_handshake_recv.last_irreversible_block_num;
          }
-      } else if( c == sync_source ) {
-         sync_last_requested_num = 0;
+      } else if( is_sync_source( c ) ) {
+         release_sync_source( c );
          request_next_chunk( std::move(g) );
       }
    }
 
+   // call with g_sync locked
+   bool sync_manager::is_sync_source( const connection_ptr& c ) const {
+      return std::any_of( sync_ranges.begin(), sync_ranges.end(), [&c]( const auto& r ) { return r.source == c; } );
+   }
+
+   // call with g_sync locked, the ranges served by c are requested again by the next request_next_chunk
+   void sync_manager::release_sync_source( const connection_ptr& c ) {
+      pop_completed_ranges();
+      for( auto& r : sync_ranges ) {
+         if( r.source == c ) {
+            r.source.reset();
+         }
+      }
+      // blocks before sync_next_expected_num have already been applied
+      if( !sync_ranges.empty() && !sync_ranges.front().source ) {
+         sync_ranges.front().start = std::max( sync_ranges.front().start, sync_next_expected_num );
+      }
+   }
+
+   // call with g_sync locked, returns true if any range was completely applied
+   bool sync_manager::pop_completed_ranges() {
+      bool popped = false;
+      while( !sync_ranges.empty() && sync_ranges.front().end < sync_next_expected_num ) {
+         sync_ranges.pop_front();
+         popped = true;
+      }
+      return popped;
+   }
+
+   // call with g_sync locked
+   void sync_manager::reset_sync_ranges() {
+      sync_ranges.clear();
+      sync_pending_blocks.clear();
+      sync_next_dispatch_num = 0;
+   }
+
+   // call with g_sync locked, returns a connection able to provide sync blocks that is not already serving a sync range
+   connection_ptr sync_manager::select_sync_source( const connection_ptr& conn ) {
+      auto usable = [this]( const connection_ptr& c ) {
+         return c && c->current() && !c->is_transactions_only_connection() && !is_sync_source( c );
+      };
+      // a provider is supplied and able to be used, use it.
+      if( usable( conn ) ) return conn;
+
+      // otherwise select the available peer with the lowest round trip time, round-robin style among peers not yet
+      // measured. The previous source is only reused when no other peer is available.
+      auto rtt = []( const connection_ptr& c ) {
+         const int64_t t = c->round_trip_time;
+         return t > 0 ? t : std::numeric_limits<int64_t>::max();
+      };
+      std::shared_lock<std::shared_mutex> g( my_impl->connections_mtx );
+      if( my_impl->connections.empty() ) return {};
+      auto cptr = my_impl->connections.begin();
+      if( sync_source ) {
+         // start after the previous source, it is checked last
+         auto itr = my_impl->connections.find( sync_source );
+         if( itr != my_impl->connections.end() && ++itr != my_impl->connections.end() ) {
+            cptr = itr;
+         }
+      }
+      connection_ptr best;
+      const auto cstart_it = cptr;
+      do {
+         const connection_ptr& c = *cptr;
+         if( usable( c ) && !( best && c == sync_source ) ) {
+            if( !best || rtt( c ) < rtt( best ) ) {
+               best = c;
+            }
+         }
+         if( ++cptr == my_impl->connections.end() )
+            cptr = my_impl->connections.begin();
+      } while( cptr != cstart_it );
+      return best;
+   }
+
    // call with g_sync locked
    void sync_manager::request_next_chunk( std::unique_lock<std::mutex> g_sync, const connection_ptr& conn ) {
       uint32_t fork_head_block_num = 0;
@@ -1630,99 +2013,70 @@ namespace eosio {
       std::tie( lib_block_num, std::ignore, fork_head_block_num,
                 std::ignore, std::ignore, std::ignore ) = my_impl->get_chain_info();
 
-      fc_dlog( logger, "sync_last_requested_num: ${r}, sync_next_expected_num: ${e}, sync_known_lib_num: ${k}, sync_req_span: ${s}",
-               ("r", sync_last_requested_num)("e", sync_next_expected_num)("k", sync_known_lib_num)("s", sync_req_span) );
+      fc_dlog( logger, "sync_last_requested_num: ${r}, sync_next_expected_num: ${e}, sync_known_lib_num: ${k}, sync_req_span: ${s}, outstanding ranges: ${o}",
+               ("r", sync_last_requested_num)("e", sync_next_expected_num)("k", sync_known_lib_num)("s", sync_req_span)("o", sync_ranges.size()) );
 
-      if( fork_head_block_num < sync_last_requested_num && sync_source && sync_source->current() ) {
-         fc_ilog( logger, "ignoring request, head is ${h} last req = ${r} source is ${p}",
-                  ("h", fork_head_block_num)( "r", sync_last_requested_num )( "p", sync_source->peer_name() ) );
-         return;
+      // sources that can no longer provide blocks have their ranges requested again
+      for( auto& r : sync_ranges ) {
+         if( r.source && !r.source->current() ) {
+            r.source.reset();
+         }
       }
 
       /* ----------
-       * next chunk provider selection criteria
-       * a provider is supplied and able to be used, use it.
-       * otherwise select the next available from the list, round-robin style.
+       * next chunk provider selection criteria, see select_sync_source.
+       * Each outstanding range is served by a different provider, at most sync-fetch-peers ranges are outstanding.
+       * Ranges are applied in order, a range is replaced by the next chunk once all of its blocks are applied.
        */
-
-      if (conn && conn->current() ) {
-         sync_source = conn;
-      } else {
-         std::shared_lock<std::shared_mutex> g( my_impl->connections_mtx );
-         if( my_impl->connections.size() == 0 ) {
-            sync_source.reset();
-         } else if( my_impl->connections.size() == 1 ) {
-            if (!sync_source) {
-               sync_source = *my_impl->connections.begin();
-            }
-         } else {
-            // init to a linear array search
-            auto cptr = my_impl->connections.begin();
-            auto cend = my_impl->connections.end();
-            // do we remember the previous source?
-            if (sync_source) {
-               //try to find it in the list
-               cptr = my_impl->connections.find( sync_source );
-               cend = cptr;
-               if( cptr == my_impl->connections.end() ) {
-                  //not there - must have been closed! cend is now connections.end, so just flatten the ring.
-                  sync_source.reset();
-                  cptr = my_impl->connections.begin();
-               } else {
-                  //was found - advance the start to the next. cend is the old source.
-                  if( ++cptr == my_impl->connections.end() && cend != my_impl->connections.end() ) {
-                     cptr = my_impl->connections.begin();
-                  }
-               }
-            }
-
-            //scan the list of peers looking for another able to provide sync blocks.
-            if( cptr != my_impl->connections.end() ) {
-               auto cstart_it = cptr;
-               do {
-                  //select the first one which is current and break out.
-                  if( !(*cptr)->is_transactions_only_connection() && (*cptr)->current() ) {
-                     sync_source = *cptr;
-                     break;
-                  }
-                  if( ++cptr == my_impl->connections.end() )
-                     cptr = my_impl->connections.begin();
-               } while( cptr != cstart_it );
-            }
-            // no need to check the result, either source advanced or the whole list was checked and the old source is reused.
-         }
+      std::vector<sync_range> requests;
+      for( auto& r : sync_ranges ) {
+         if( r.source ) continue;
+         r.source = select_sync_source( conn );
+         if( !r.source ) break;
+         sync_source = r.source;
+         requests.push_back( r );
+      }
+      while( sync_ranges.size() < sync_fetch_peers && sync_last_requested_num != sync_known_lib_num ) {
+         const uint32_t start = sync_ranges.empty() ? sync_next_expected_num : sync_ranges.back().end + 1;
+         uint32_t end = start + sync_req_span - 1;
+         if( end > sync_known_lib_num )
+            end = sync_known_lib_num;
+         if( end == 0 || end < start ) break;
+         connection_ptr c = select_sync_source( conn );
+         if( !c ) break;
+         sync_source = c;
+         sync_last_requested_num = end;
+         sync_ranges.push_back( sync_range{ start, end, c } );
+         requests.push_back( sync_ranges.back() );
       }
 
       // verify there is an available source
-      if( !sync_source || !sync_source->current() || sync_source->is_transactions_only_connection() ) {
+      const bool have_source = std::any_of( sync_ranges.begin(), sync_ranges.end(), []( const auto& r ) { return !!r.source; } );
+      if( !have_source && ( !sync_ranges.empty() || !sync_source || !sync_source->current() || sync_source->is_transactions_only_connection() ) ) {
          fc_elog( logger, "Unable to continue syncing at this time");
          sync_known_lib_num = lib_block_num;
          sync_last_requested_num = 0;
+         reset_sync_ranges();
          set_state( in_sync ); // probably not, but we can't do anything else
          return;
       }
 
-      bool request_sent = false;
-      if( sync_last_requested_num != sync_known_lib_num ) {
-         uint32_t start = sync_next_expected_num;
-         uint32_t end = start + sync_req_span - 1;
-         if( end > sync_known_lib_num )
-            end = sync_known_lib_num;
-         if( end > 0 && end >= start ) {
-            sync_last_requested_num = end;
-            connection_ptr c = sync_source;
-            g_sync.unlock();
-            request_sent = true;
-            c->strand.post( [c, start, end]() {
+      if( !requests.empty() ) {
+         g_sync.unlock();
+         for( const auto& r : requests ) {
+            connection_ptr c = r.source;
+            c->strand.post( [c, start = r.start, end = r.end]() {
                fc_ilog( logger, "requesting range ${s} to ${e}, from ${n}", ("n", c->peer_name())( "s", start )( "e", end ) );
                c->request_sync_blocks( start, end );
             } );
          }
-      }
-      if( !request_sent ) {
+      } else if( sync_ranges.empty() ) {
          connection_ptr c = sync_source;
          g_sync.unlock();
          c->send_handshake();
+      } else {
+         fc_ilog( logger, "ignoring request, head is ${h} last req = ${r}, ${o} ranges outstanding",
+                  ("h", fork_head_block_num)( "r", sync_last_requested_num )( "o", sync_ranges.size() ) );
       }
    }
 
@@ -1779,9 +2133,9 @@ namespace eosio {
       fc_ilog( logger, "reassign_fetch, our last req is ${cc}, next expected is ${ne} peer ${p}",
                ("cc", sync_last_requested_num)( "ne", sync_next_expected_num )( "p", c->peer_name() ) );
 
-      if( c == sync_source ) {
+      if( is_sync_source( c ) ) {
          c->cancel_sync(reason);
-         sync_last_requested_num = 0;
+         release_sync_source( c );
          request_next_chunk( std::move(g) );
       }
    }
@@ -1868,7 +2222,7 @@ namespace eosio {
             c->enqueue( note );
          }
          c->syncing = false;
-         app().post( priority::medium, [chain_plug = my_impl->chain_plug, c,
+         main_thread_post( priority::medium, [chain_plug = my_impl->chain_plug, c,
                                         msg_head_num = msg.head_num, msg_head_id = msg.head_id]() {
             bool on_fork = true;
             try {
@@ -1968,10 +2322,9 @@ namespace eosio {
       if( c->block_status_monitor_.max_events_violated()) {
          fc_wlog( logger, "block ${bn} not accepted from ${p}, closing connection", ("bn", blk_num)("p", c->peer_name()) );
          std::unique_lock<std::mutex> g( sync_mtx );
-         sync_last_requested_num = 0;
          sync_source.reset();
          g.unlock();
-         c->close();
+         c->close(); // ranges served by c are requested again from another source by sync_reset_lib_num
       } else {
          c->send_handshake( true );
       }
@@ -2042,9 +2395,10 @@ namespace eosio {
          if( blk_num == sync_known_lib_num ) {
             fc_dlog( logger, "All caught up with last known last irreversible block resending handshake" );
             set_state( in_sync );
+            reset_sync_ranges();
             g_sync.unlock();
             send_handshakes();
-         } else if( blk_num == sync_last_requested_num ) {
+         } else if( pop_completed_ranges() ) {
             request_next_chunk( std::move( g_sync) );
          } else {
             g_sync.unlock();
@@ -2054,17 +2408,81 @@ namespace eosio {
       }
    }
 
+   // called from connection strand
+   // With several sync sources blocks of later ranges arrive before the blocks they build on. Hold them back until the
+   // blocks before them have been handed to the application thread, so every block links to its predecessor when applied.
+   void sync_manager::sync_dispatch_block( const connection_ptr& c, const block_id_type& blk_id, signed_block_ptr b ) {
+      auto apply = []( const connection_ptr& c, const block_id_type& id, signed_block_ptr b ) {
+         main_thread_post( priority::medium, [b{std::move(b)}, id, c]() mutable {
+            c->process_signed_block( id, std::move( b ) );
+         } );
+      };
+
+      const uint32_t blk_num = b->block_num();
+      if( sync_fetch_peers == 1 || sync_state != lib_catchup ) {
+         apply( c, blk_id, std::move( b ) );
+         return;
+      }
+
+      std::unique_lock<std::mutex> g( sync_mtx );
+      if( blk_num > sync_last_requested_num || sync_ranges.empty() ) { // not a sync block
+         g.unlock();
+         apply( c, blk_id, std::move( b ) );
+         return;
+      }
+      if( sync_next_dispatch_num == 0 ) {
+         sync_next_dispatch_num = sync_next_expected_num;
+      }
+
+      if( blk_num > sync_next_dispatch_num && sync_pending_blocks.size() < sync_fetch_peers * sync_req_span ) {
+         sync_pending_blocks.emplace( blk_num, sync_pending_block{ c, blk_id, std::move( b ) } );
+         const bool range_received = std::any_of( sync_ranges.begin(), sync_ranges.end(), [&]( const auto& r ) {
+            return r.source == c && r.end == blk_num;
+         } );
+         g.unlock();
+         // nothing from c is applied until the ranges before it complete, keep its timeout from expiring while it delivers
+         if( range_received ) {
+            c->cancel_wait();
+         } else {
+            c->sync_wait();
+         }
+         return;
+      }
+
+      std::vector<sync_pending_block> ready;
+      ready.push_back( sync_pending_block{ c, blk_id, std::move( b ) } );
+      if( blk_num == sync_next_dispatch_num ) {
+         ++sync_next_dispatch_num;
+         auto itr = sync_pending_blocks.begin();
+         while( itr != sync_pending_blocks.end() && itr->first <= sync_next_dispatch_num ) {
+            if( itr->first == sync_next_dispatch_num ) {
+               // a closed connection drops its blocks in process_signed_block, wait for them to be requested again
+               if( !itr->second.c->socket_is_open() ) break;
+               ++sync_next_dispatch_num;
+               ready.emplace_back( std::move( itr->second ) );
+            }
+            itr = sync_pending_blocks.erase( itr );
+         }
+      }
+      g.unlock();
+
+      for( auto& pb : ready ) {
+         apply( pb.c, pb.id, std::move( pb.block ) );
+      }
+   }
+
    //------------------------------------------------------------------------
 
    // thread safe
    bool dispatch_manager::add_peer_block( const block_id_type& blkid, uint32_t connection_id) {
-      std::lock_guard<std::mutex> g( blk_state_mtx );
-      auto bptr = blk_state.get<by_id>().find( std::make_tuple( connection_id, std::ref( blkid )));
-      bool added = (bptr == blk_state.end());
+      auto& shard = blk_state.get( blkid );
+      std::lock_guard<std::mutex> g( shard.mtx );
+      auto bptr = shard.index.get<by_id>().find( std::make_tuple( connection_id, std::ref( blkid )));
+      bool added = (bptr == shard.index.end());
       if( added ) {
-         blk_state.insert( {blkid, block_header::num_from_id( blkid ), connection_id, true} );
+         shard.index.insert( {blkid, block_header::num_from_id( blkid ), connection_id, true} );
       } else if( !bptr->have_block ) {
-         blk_state.modify( bptr, []( auto& pb ) {
+         shard.index.modify( bptr, []( auto& pb ) {
             pb.have_block = true;
          });
       }
@@ -2072,15 +2490,17 @@ namespace eosio {
    }
 
    bool dispatch_manager::peer_has_block( const block_id_type& blkid, uint32_t connection_id ) const {
-      std::lock_guard<std::mutex> g(blk_state_mtx);
-      const auto blk_itr = blk_state.get<by_id>().find( std::make_tuple( connection_id, std::ref( blkid )));
-      return blk_itr != blk_state.end();
+      const auto& shard = blk_state.get( blkid );
+      std::lock_guard<std::mutex> g( shard.mtx );
+      const auto blk_itr = shard.index.get<by_id>().find( std::make_tuple( connection_id, std::ref( blkid )));
+      return blk_itr != shard.index.end();
    }
 
    bool dispatch_manager::have_block( const block_id_type& blkid ) const {
-      std::lock_guard<std::mutex> g(blk_state_mtx);
+      const auto& shard = blk_state.get( blkid );
+      std::lock_guard<std::mutex> g( shard.mtx );
       // by_peer_block_id sorts have_block by greater so have_block == true will be the first one found
-      const auto& index = blk_state.get<by_peer_block_id>();
+      const auto& index = shard.index.get<by_peer_block_id>();
       auto blk_itr = index.find( blkid );
       if( blk_itr != index.end() ) {
          return blk_itr->have_block;
@@ -2089,25 +2509,27 @@ namespace eosio {
    }
 
    bool dispatch_manager::add_peer_txn( const node_transaction_state& nts ) {
-      std::lock_guard<std::mutex> g( local_txns_mtx );
-      auto tptr = local_txns.get<by_id>().find( std::make_tuple( std::ref( nts.id ), nts.connection_id ) );
-      bool added = (tptr == local_txns.end());
+      auto& shard = local_txns.get( nts.id );
+      std::lock_guard<std::mutex> g( shard.mtx );
+      auto tptr = shard.index.get<by_id>().find( std::make_tuple( std::ref( nts.id ), nts.connection_id ) );
+      bool added = (tptr == shard.index.end());
       if( added ) {
-         local_txns.insert( nts );
+         shard.index.insert( nts );
       }
       return added;
    }
 
    // only adds if tid already exists, returns have_txn( tid )
    bool dispatch_manager::add_peer_txn( const transaction_id_type& tid, uint32_t connection_id ) {
-      std::lock_guard<std::mutex> g( local_txns_mtx );
-      auto tptr = local_txns.get<by_id>().find( tid );
-      if( tptr == local_txns.end() ) return false;
+      auto& shard = local_txns.get( tid );
+      std::lock_guard<std::mutex> g( shard.mtx );
+      auto tptr = shard.index.get<by_id>().find( tid );
+      if( tptr == shard.index.end() ) return false;
       const auto expiration = tptr->expires;
 
-      tptr = local_txns.get<by_id>().find( std::make_tuple( std::ref( tid ), connection_id ) );
-      if( tptr == local_txns.end() ) {
-         local_txns.insert( node_transaction_state{tid, expiration, 0, connection_id} );
+      tptr = shard.index.get<by_id>().find( std::make_tuple( std::ref( tid ), connection_id ) );
+      if( tptr == shard.index.end() ) {
+         shard.index.insert( node_transaction_state{tid, expiration, 0, connection_id} );
       }
       return true;
    }
@@ -2115,64 +2537,141 @@ namespace eosio {
 
    // thread safe
    void dispatch_manager::update_txns_block_num( const signed_block_ptr& sb ) {
-      update_block_num ubn( sb->block_num() );
-      std::lock_guard<std::mutex> g( local_txns_mtx );
       for( const auto& recpt : sb->transactions ) {
          const transaction_id_type& id = (recpt.trx.index() == 0) ? std::get<transaction_id_type>(recpt.trx)
                                                                   : std::get<packed_transaction>(recpt.trx).id();
-         auto range = local_txns.get<by_id>().equal_range( id );
-         for( auto itr = range.first; itr != range.second; ++itr ) {
-            local_txns.modify( itr, ubn );
-         }
+         update_txns_block_num( id, sb->block_num() );
       }
    }
 
    // thread safe
    void dispatch_manager::update_txns_block_num( const transaction_id_type& id, uint32_t blk_num ) {
       update_block_num ubn( blk_num );
-      std::lock_guard<std::mutex> g( local_txns_mtx );
-      auto range = local_txns.get<by_id>().equal_range( id );
+      auto& shard = local_txns.get( id );
+      std::lock_guard<std::mutex> g( shard.mtx );
+      auto range = shard.index.get<by_id>().equal_range( id );
       for( auto itr = range.first; itr != range.second; ++itr ) {
-         local_txns.modify( itr, ubn );
+         shard.index.modify( itr, ubn );
       }
    }
 
    bool dispatch_manager::peer_has_txn( const transaction_id_type& tid, uint32_t connection_id ) const {
-      std::lock_guard<std::mutex> g( local_txns_mtx );
-      const auto tptr = local_txns.get<by_id>().find( std::make_tuple( std::ref( tid ), connection_id ) );
-      return tptr != local_txns.end();
+      const auto& shard = local_txns.get( tid );
+      std::lock_guard<std::mutex> g( shard.mtx );
+      const auto tptr = shard.index.get<by_id>().find( std::make_tuple( std::ref( tid ), connection_id ) );
+      return tptr != shard.index.end();
    }
 
    bool dispatch_manager::have_txn( const transaction_id_type& tid ) const {
-      std::lock_guard<std::mutex> g( local_txns_mtx );
-      const auto tptr = local_txns.get<by_id>().find( tid );
-      return tptr != local_txns.end();
+      const auto& shard = local_txns.get( tid );
+      std::lock_guard<std::mutex> g( shard.mtx );
+      const auto tptr = shard.index.get<by_id>().find( tid );
+      return tptr != shard.index.end();
+   }
+
+   // called from connection strand, requests the announced transactions that are neither known nor already requested
+   void dispatch_manager::recv_trx_notice( const connection_ptr& c, const vector<transaction_id_type>& ids ) {
+      if( !my_impl->p2p_accept_transactions ) return;
+
+      request_message req;
+      req.req_trx.mode = normal;
+      const auto now = fc::time_point::now();
+      const auto request_expires = now + fc::microseconds( std::chrono::duration_cast<std::chrono::microseconds>( def_trx_request_wait ).count() );
+      for( const auto& id : ids ) {
+         // known, add_peer_txn remembers the peer has it so it is not sent back
+         if( add_peer_txn( id, c->connection_id ) ) continue;
+
+         std::lock_guard<std::mutex> g( requested_txns_mtx );
+         auto ritr = requested_txns.find( id );
+         if( ritr != requested_txns.end() && ritr->second > now ) continue; // wait for the peer it was requested from
+         requested_txns[id] = request_expires;
+         req.req_trx.ids.push_back( id );
+      }
+      if( !req.req_trx.ids.empty() ) {
+         fc_dlog( logger, "requesting ${n} of ${t} announced trxs from ${p}",
+                  ("n", req.req_trx.ids.size())("t", ids.size())("p", c->peer_name()) );
+         c->enqueue( req );
+      }
+   }
+
+   packed_transaction_ptr dispatch_manager::get_txn( const transaction_id_type& tid ) const {
+      const auto& shard = local_txns.get( tid );
+      std::lock_guard<std::mutex> g( shard.mtx );
+      auto range = shard.index.get<by_id>().equal_range( tid );
+      for( auto itr = range.first; itr != range.second; ++itr ) {
+         if( itr->trx ) return itr->trx;
+      }
+      return {};
    }
 
    void dispatch_manager::expire_txns( uint32_t lib_num ) {
       size_t start_size = 0, end_size = 0;
 
-      std::unique_lock<std::mutex> g( local_txns_mtx );
-      start_size = local_txns.size();
-      auto& old = local_txns.get<by_expiry>();
-      auto ex_lo = old.lower_bound( fc::time_point_sec( 0 ) );
-      auto ex_up = old.upper_bound( time_point::now() );
-      old.erase( ex_lo, ex_up );
-      g.unlock(); // allow other threads opportunity to use local_txns
+      const auto now = fc::time_point::now();
+      // each shard is locked on its own, allowing other threads opportunity to use the rest of local_txns
+      local_txns.for_each_shard( [&]( node_transaction_index& index ) {
+         start_size += index.size();
+         auto& old = index.get<by_expiry>();
+         old.erase( old.lower_bound( fc::time_point_sec( 0 ) ), old.upper_bound( now ) );
+         auto& stale = index.get<by_block_num>();
+         stale.erase( stale.lower_bound( 1 ), stale.upper_bound( lib_num ) );
+         end_size += index.size();
+      } );
 
-      g.lock();
-      auto& stale = local_txns.get<by_block_num>();
-      stale.erase( stale.lower_bound( 1 ), stale.upper_bound( lib_num ) );
-      end_size = local_txns.size();
+      std::unique_lock<std::mutex> g( requested_txns_mtx );
+      for( auto itr = requested_txns.begin(); itr != requested_txns.end(); ) {
+         itr = itr->second < now ? requested_txns.erase( itr ) : std::next( itr );
+      }
       g.unlock();
 
       fc_dlog( logger, "expire_local_txns size ${s} removed ${r}", ("s", start_size)( "r", start_size - end_size ) );
    }
 
+   // thread safe, serializes each block at most once for the connections it is sent to
+   send_buffer_type dispatch_manager::get_block_send_buffer( const signed_block_ptr& b, uint16_t protocol_version ) {
+      const bool v0 = protocol_version < proto_pruned_types;
+      const bool compress = my_impl->p2p_compress_blocks && protocol_version >= proto_block_compression;
+      auto slot = [&]( block_send_buffers& e ) -> send_buffer_type& {
+         return compress ? e.send_buffer_compressed : v0 ? e.send_buffer_v0 : e.send_buffer;
+      };
+      auto find_buffer = [&]() -> send_buffer_type {
+         for( auto itr = block_buffers.rbegin(); itr != block_buffers.rend(); ++itr ) {
+            if( itr->block == b ) return slot( *itr );
+         }
+         return {};
+      };
+
+      std::unique_lock<std::mutex> g( block_buffers_mtx );
+      if( auto sb = find_buffer() ) return sb;
+      g.unlock();
+
+      // serialize outside of the lock, another thread may race to create the same buffer which is harmless
+      send_buffer_type sb;
+      if( compress ) {
+         sb = block_buffer_factory::create_compressed_send_buffer( b );
+      }
+      if( !sb ) {
+         block_buffer_factory buff_factory;
+         sb = buff_factory.get_send_buffer( b, protocol_version );
+      }
+      if( !sb ) return sb;
+
+      g.lock();
+      auto itr = std::find_if( block_buffers.begin(), block_buffers.end(), [&b]( const auto& e ) { return e.block == b; } );
+      if( itr == block_buffers.end() ) {
+         if( block_buffers.size() >= max_block_send_buffers ) block_buffers.pop_front();
+         block_buffers.push_back( block_send_buffers{ b, {}, {}, {} } );
+         itr = std::prev( block_buffers.end() );
+      }
+      slot( *itr ) = sb;
+      return sb;
+   }
+
    void dispatch_manager::expire_blocks( uint32_t lib_num ) {
-      std::lock_guard<std::mutex> g(blk_state_mtx);
-      auto& stale_blk = blk_state.get<by_block_num>();
-      stale_blk.erase( stale_blk.lower_bound(1), stale_blk.upper_bound(lib_num) );
+      blk_state.for_each_shard( [lib_num]( peer_block_state_index& index ) {
+         auto& stale_blk = index.get<by_block_num>();
+         stale_blk.erase( stale_blk.lower_bound(1), stale_blk.upper_bound(lib_num) );
+      } );
    }
 
    // thread safe
@@ -2181,13 +2680,12 @@ namespace eosio {
 
       if( my_impl->sync_master->syncing_with_peer() ) return;
 
-      block_buffer_factory buff_factory;
       const auto bnum = b->block_num();
-      for_each_block_connection( [this, &id, &bnum, &b, &buff_factory]( auto& cp ) {
+      for_each_block_connection( [this, &id, &bnum, &b]( auto& cp ) {
          peer_dlog( cp, "socket_is_open ${s}, connecting ${c}, syncing ${ss}",
                     ("s", cp->socket_is_open())("c", cp->connecting.load())("ss", cp->syncing.load()) );
          if( !cp->current() ) return true;
-         send_buffer_type sb = buff_factory.get_send_buffer( b, cp->protocol_version.load() );
+         send_buffer_type sb = get_block_send_buffer( b, cp->protocol_version.load() );
          if( !sb ) {
             peer_wlog( cp, "Sending go away for incomplete block #${n} ${id}...",
                        ("n", b->block_num())("id", b->calculate_id().str().substr(8,16)) );
@@ -2196,7 +2694,8 @@ namespace eosio {
             return true;
          }
 
-         cp->strand.post( [this, cp, id, bnum, sb{std::move(sb)}]() {
+         const bool compact = cp->protocol_version.load() >= proto_compact_blocks;
+         cp->strand.post( [this, cp, id, bnum, compact, b, sb{std::move(sb)}]() {
             std::unique_lock<std::mutex> g_conn( cp->conn_mtx );
             bool has_block = cp->last_handshake_recv.last_irreversible_block_num >= bnum;
             g_conn.unlock();
@@ -2206,7 +2705,13 @@ namespace eosio {
                   return;
                }
                fc_dlog( logger, "bcast block ${b} to ${p}", ("b", bnum)("p", cp->peer_name()) );
-               cp->enqueue_buffer( sb, no_reason );
+               send_buffer_type cb;
+               if( compact ) {
+                  cb = block_buffer_factory::create_compact_send_buffer( *b, [this, &cp]( const transaction_id_type& tid ) {
+                     return peer_has_txn( tid, cp->connection_id );
+                  } );
+               }
+               cp->enqueue_buffer( cb ? cb : sb, no_reason, msg_priority::block );
             }
          });
          return true;
@@ -2237,23 +2742,38 @@ namespace eosio {
    void dispatch_manager::bcast_transaction(const packed_transaction_ptr& trx) {
       const auto& id = trx->id();
       time_point_sec trx_expiration = trx->expiration();
-      node_transaction_state nts = {id, trx_expiration, 0, 0};
+      node_transaction_state nts = {id, trx_expiration, 0, 0, trx};
 
       trx_buffer_factory buff_factory;
-      for_each_connection( [this, &trx, &nts, &buff_factory]( auto& cp ) {
+      const bool announce = my_impl->p2p_announce_transactions;
+      for_each_connection( [this, &trx, &id, &nts, &buff_factory, announce]( auto& cp ) {
          if( cp->is_blocks_only_connection() || !cp->current() ) {
             return true;
          }
+         // do not add to the transaction backlog of a peer that is not keeping up
+         const auto trx_queue_size = cp->buffer_queue.write_queue_size( msg_priority::trx );
+         if( trx_queue_size > my_impl->max_trx_queue_size ) {
+            fc_dlog( logger, "not sending trx to ${p}, trx write queue ${s} bytes", ("p", cp->peer_name())("s", trx_queue_size) );
+            return true;
+         }
          nts.connection_id = cp->connection_id;
          if( !add_peer_txn(nts) ) {
             return true;
          }
 
+         if( announce && cp->protocol_version.load() >= proto_trx_announce ) {
+            // peer requests the transaction if it does not have it
+            cp->strand.post( [cp, id]() {
+               cp->announce_trx( id );
+            } );
+            return true;
+         }
+
          send_buffer_type sb = buff_factory.get_send_buffer( trx, cp->protocol_version.load() );
          if( !sb ) return true;
          cp->strand.post( [cp, sb{std::move(sb)}]() {
             fc_dlog( logger, "sending trx to ${n}", ("n", cp->peer_name()) );
-            cp->enqueue_buffer( sb, no_reason );
+            cp->enqueue_buffer( sb, no_reason, msg_priority::trx );
          } );
          return true;
       } );
@@ -2541,6 +3061,7 @@ namespace eosio {
                      }
                      EOS_ASSERT(bytes_transferred <= conn->pending_message_buffer.bytes_to_write(), plugin_exception, "");
                      conn->pending_message_buffer.advance_write_ptr(bytes_transferred);
+                     conn->bytes_received += bytes_transferred;
                      while (conn->pending_message_buffer.bytes_to_read() > 0) {
                         uint32_t bytes_in_buffer = conn->pending_message_buffer.bytes_to_read();
 
@@ -2632,6 +3153,12 @@ namespace eosio {
          if( which == signed_block_which || which == signed_block_v0_which ) {
             return process_next_block_message( message_length );
 
+         } else if( which == compact_block_which ) {
+            return process_next_compact_block_message( message_length );
+
+         } else if( which == compressed_block_which ) {
+            return process_next_compressed_block_message( message_length );
+
          } else if( which == trx_message_v1_which || which == packed_transaction_v0_which ) {
             return process_next_trx_message( message_length );
 
@@ -2661,6 +3188,118 @@ namespace eosio {
       fc::raw::unpack( peek_ds, bh );
 
       const block_id_type blk_id = bh.calculate_id();
+      if( discard_block_message( bh, blk_id ) ) {
+         pending_message_buffer.advance_read_ptr( message_length );
+         return true;
+      }
+
+      auto ds = pending_message_buffer.create_datastream();
+      fc::raw::unpack( ds, which );
+      shared_ptr<signed_block> ptr;
+      if( which == signed_block_which ) {
+         ptr = std::make_shared<signed_block>();
+         fc::raw::unpack( ds, *ptr );
+      } else {
+         signed_block_v0 sb_v0;
+         fc::raw::unpack( ds, sb_v0 );
+         ptr = std::make_shared<signed_block>( std::move( sb_v0 ), true );
+      }
+
+      return process_block( blk_id, std::move( ptr ) );
+   }
+
+   // called from connection strand
+   bool connection::process_next_compact_block_message(uint32_t message_length) {
+      auto peek_ds = pending_message_buffer.create_peek_datastream();
+      unsigned_int which{};
+      fc::raw::unpack( peek_ds, which ); // throw away
+      block_header bh;
+      fc::raw::unpack( peek_ds, bh );
+
+      const block_id_type blk_id = bh.calculate_id();
+      if( discard_block_message( bh, blk_id ) ) {
+         pending_message_buffer.advance_read_ptr( message_length );
+         return true;
+      }
+
+      auto ds = pending_message_buffer.create_datastream();
+      fc::raw::unpack( ds, which );
+      compact_block_message cb;
+      fc::raw::unpack( ds, cb );
+
+      auto ptr = std::make_shared<signed_block>( cb.header );
+      ptr->prune_state = cb.prune_state;
+      ptr->block_extensions = std::move( cb.block_extensions );
+      bool complete = true;
+      for( auto& cr : cb.transactions ) {
+         transaction_receipt r;
+         static_cast<transaction_receipt_header&>( r ) = cr;
+         if( std::holds_alternative<transaction_id_type>( cr.trx ) ) {
+            r.trx = std::get<transaction_id_type>( cr.trx );
+         } else if( std::holds_alternative<packed_transaction>( cr.trx ) ) {
+            r.trx = std::move( std::get<packed_transaction>( cr.trx ) );
+         } else {
+            auto trx = my_impl->dispatcher->get_txn( std::get<known_packed_transaction>( cr.trx ).id );
+            if( !trx ) {
+               complete = false;
+               break;
+            }
+            r.trx = *trx;
+         }
+         ptr->transactions.emplace_back( std::move( r ) );
+      }
+
+      if( complete ) {
+         deque<digest_type> trx_digests;
+         for( const auto& r : ptr->transactions )
+            trx_digests.emplace_back( r.digest() );
+         complete = merkle( std::move( trx_digests ) ) == ptr->transaction_mroot;
+      }
+
+      if( !complete ) {
+         peer_dlog( this, "unable to rebuild compact block ${num}, id ${id}..., requesting full block",
+                    ("num", bh.block_num())("id", blk_id.str().substr(8,16)) );
+         request_message req;
+         req.req_blocks.mode = normal;
+         req.req_blocks.ids.push_back( blk_id );
+         enqueue( req );
+         return true;
+      }
+
+      return process_block( blk_id, std::move( ptr ) );
+   }
+
+   // called from connection strand
+   bool connection::process_next_compressed_block_message(uint32_t message_length) {
+      auto peek_ds = pending_message_buffer.create_peek_datastream();
+      unsigned_int which{};
+      fc::raw::unpack( peek_ds, which ); // throw away
+      block_header bh;
+      fc::raw::unpack( peek_ds, bh );
+
+      const block_id_type blk_id = bh.calculate_id();
+      if( discard_block_message( bh, blk_id ) ) {
+         pending_message_buffer.advance_read_ptr( message_length );
+         return true;
+      }
+
+      auto ds = pending_message_buffer.create_datastream();
+      fc::raw::unpack( ds, which );
+      compressed_block_message cb;
+      fc::raw::unpack( ds, cb );
+
+      const bytes rest = zlib_decompress( cb.data );
+      auto ptr = std::make_shared<signed_block>( cb.header );
+      fc::datastream<const char*> rds( rest.data(), rest.size() );
+      fc::raw::unpack( rds, ptr->prune_state );
+      fc::raw::unpack( rds, ptr->transactions );
+      fc::raw::unpack( rds, ptr->block_extensions );
+
+      return process_block( blk_id, std::move( ptr ) );
+   }
+
+   // called from connection strand, returns true if the block message should be skipped
+   bool connection::discard_block_message(const block_header& bh, const block_id_type& blk_id) {
       const uint32_t blk_num = bh.block_num();
       if( my_impl->dispatcher->have_block( blk_id ) ) {
          fc_dlog( logger, "canceling wait on ${p}, already received block ${num}, id ${id}...",
@@ -2668,13 +3307,14 @@ namespace eosio {
          my_impl->sync_master->sync_recv_block( shared_from_this(), blk_id, blk_num, false );
          cancel_wait();
 
-         pending_message_buffer.advance_read_ptr( message_length );
          return true;
       }
+      const int64_t latency_us = (fc::time_point::now() - bh.timestamp).count();
       fc_dlog( logger, "${p} received block ${num}, id ${id}..., latency: ${latency}",
                ("p", peer_name())("num", bh.block_num())("id", blk_id.str().substr(8,16))
-                     ("latency", (fc::time_point::now() - bh.timestamp).count()/1000) );
+                     ("latency", latency_us/1000) );
       if( !my_impl->sync_master->syncing_with_peer() ) { // guard against peer thinking it needs to send us old blocks
+         update_block_latency( latency_us );
          uint32_t lib = 0;
          std::tie( lib, std::ignore, std::ignore, std::ignore, std::ignore, std::ignore ) = my_impl->get_chain_info();
          if( blk_num < lib ) {
@@ -2691,23 +3331,15 @@ namespace eosio {
                cancel_wait();
             }
 
-            pending_message_buffer.advance_read_ptr( message_length );
             return true;
          }
       }
 
-      auto ds = pending_message_buffer.create_datastream();
-      fc::raw::unpack( ds, which );
-      shared_ptr<signed_block> ptr;
-      if( which == signed_block_which ) {
-         ptr = std::make_shared<signed_block>();
-         fc::raw::unpack( ds, *ptr );
-      } else {
-         signed_block_v0 sb_v0;
-         fc::raw::unpack( ds, sb_v0 );
-         ptr = std::make_shared<signed_block>( std::move( sb_v0 ), true );
-      }
+      return false;
+   }
 
+   // called from connection strand
+   bool connection::process_block(const block_id_type& blk_id, shared_ptr<signed_block> ptr) {
       auto is_webauthn_sig = []( const fc::crypto::signature& s ) {
          return s.which() == fc::get_index<fc::crypto::signature::storage_type, fc::crypto::webauthn::signature>();
       };
@@ -2784,7 +3416,7 @@ namespace eosio {
                }
                have_trx = my_impl->dispatcher->have_txn( ptr->id() );
             }
-            node_transaction_state nts = {ptr->id(), ptr->expiration(), 0, connection_id};
+            node_transaction_state nts = {ptr->id(), ptr->expiration(), 0, connection_id, ptr};
             my_impl->dispatcher->add_peer_txn( nts );
          }
 
@@ -2970,7 +3602,7 @@ namespace eosio {
 
          uint32_t peer_lib = msg.last_irreversible_block_num;
          connection_wptr weak = shared_from_this();
-         app().post( priority::medium, [peer_lib, chain_plug = my_impl->chain_plug, weak{std::move(weak)},
+         main_thread_post( priority::medium, [peer_lib, chain_plug = my_impl->chain_plug, weak{std::move(weak)},
                                      msg_lib_id = msg.last_irreversible_block_id]() {
             connection_ptr c = weak.lock();
             if( !c ) return;
@@ -3055,6 +3687,11 @@ namespace eosio {
       }
 
       double offset = (double(rec - org) + double(msg.xmt - dst)) / 2;
+      // time on the wire, excluding the time the peer held the message
+      const int64_t rtt = int64_t(dst - msg.org) - int64_t(msg.xmt - rec);
+      if( rtt > 0 && rtt < std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::seconds( 10 ) ).count() ) {
+         round_trip_time = rtt;
+      }
       double NsecPerUsec{1000};
 
       if( logger.is_enabled( fc::log_level::all ) )
@@ -3103,6 +3740,9 @@ namespace eosio {
          break;
       }
       case normal: {
+         if( protocol_version >= proto_trx_announce && !msg.known_trx.ids.empty() ) {
+            my_impl->dispatcher->recv_trx_notice( shared_from_this(), msg.known_trx.ids );
+         }
          my_impl->dispatcher->recv_notice( shared_from_this(), msg, false );
       }
       }
@@ -3164,9 +3804,12 @@ namespace eosio {
          // no break
       case normal :
          if( !msg.req_trx.ids.empty() ) {
-            fc_elog( logger, "Invalid request_message, req_trx.ids.size ${s}", ("s", msg.req_trx.ids.size()) );
-            close();
-            return;
+            if( protocol_version < proto_trx_announce ) {
+               fc_elog( logger, "Invalid request_message, req_trx.ids.size ${s}", ("s", msg.req_trx.ids.size()) );
+               close();
+               return;
+            }
+            send_requested_trxs( msg.req_trx.ids );
          }
          break;
       default:;
@@ -3201,9 +3844,11 @@ namespace eosio {
       peer_dlog( this, "received packed_transaction ${id}", ("id", tid) );
 
       trx_in_progress_size += calc_trx_size( trx );
-      app().post( priority::low, [trx{std::move(trx)}, weak = weak_from_this()]() {
+      // accept_transaction is thread safe until keys are recovered, so the signature recovery starts here and
+      // the application thread is only involved once the transaction is ready to execute
+      try {
          my_impl->chain_plug->accept_transaction( trx,
-            [weak, trx](const std::variant<fc::exception_ptr, transaction_trace_ptr>& result) mutable {
+            [weak = weak_from_this(), trx](const std::variant<fc::exception_ptr, transaction_trace_ptr>& result) mutable {
          // next (this lambda) called from application thread
          if (std::holds_alternative<fc::exception_ptr>(result)) {
             fc_dlog( logger, "bad packed_transaction : ${m}", ("m", std::get<fc::exception_ptr>(result)->what()) );
@@ -3219,8 +3864,11 @@ namespace eosio {
          if( conn ) {
             conn->trx_in_progress_size -= calc_trx_size( trx );
          }
-        });
-      });
+        }, connection_id );
+      } catch( ... ) {
+         trx_in_progress_size -= calc_trx_size( trx );
+         throw;
+      }
    }
 
    // called from connection strand
@@ -3234,9 +3882,9 @@ namespace eosio {
             return;
          }
       }
-      app().post(priority::medium, [ptr{std::move(ptr)}, id, c = shared_from_this()]() mutable {
-         c->process_signed_block( id, std::move( ptr ) );
-      });
+      // thread safe, overlaps key recovery of this block with the apply of the blocks queued ahead of it
+      my_impl->chain_plug->chain().start_block_key_recovery( id, ptr );
+      my_impl->sync_master->sync_dispatch_block( shared_from_this(), id, std::move( ptr ) );
    }
 
    // called from application thread
@@ -3638,6 +4286,10 @@ namespace eosio {
            "    p2p.blk.eos.io:9876:blk\n")
          ( "p2p-max-nodes-per-host", bpo::value<int>()->default_value(def_max_nodes_per_host), "Maximum number of client nodes from any single IP address")
          ( "p2p-accept-transactions", bpo::value<bool>()->default_value(true), "Allow transactions received over p2p network to be evaluated and relayed if valid.")
+         ( "p2p-announce-transactions", bpo::value<bool>()->default_value(false), "Relay transaction ids to peers that support it, peers request the transactions they do not already have.")
+         ( "p2p-blk-congestion-control", bpo::value<string>()->default_value(""), "TCP congestion control algorithm, e.g. bbr, for blocks only connections (p2p-peer-address with :blk suffix). Linux only, the algorithm must be available in the kernel.")
+         ( "p2p-compress-blocks", bpo::value<bool>()->default_value(false), "Send zlib compressed blocks to peers that support it. Blocks that do not compress to less than 90% of their size are sent uncompressed.")
+         ( "p2p-max-trx-queue-size-kb", bpo::value<uint32_t>()->default_value(def_max_trx_queue_size_kb), "Maximum KiB of transactions queued for sending to a peer, further transactions are not relayed to that peer until the queue drains. Blocks and control messages are always sent ahead of queued transactions.")
          ( "p2p-reject-incomplete-blocks", bpo::value<bool>()->default_value(true), "Reject pruned signed_blocks even in light validation")
          ( "agent-name", bpo::value<string>()->default_value("EOS Test Agent"), "The name supplied to identify this node amongst the peers.")
          ( "allowed-connection", bpo::value<vector<string>>()->multitoken()->default_value({"any"}, "any"), "Can be 'any' or 'producers' or 'specified' or 'none'. If 'specified', peer-key must be specified at least once. If only 'producers', peer-key is not required. 'producers' and 'specified' may be combined.")
@@ -3650,6 +4302,7 @@ namespace eosio {
          ( "net-threads", bpo::value<uint16_t>()->default_value(my->thread_pool_size),
            "Number of worker threads in net_plugin thread pool" )
          ( "sync-fetch-span", bpo::value<uint32_t>()->default_value(def_sync_fetch_span), "number of blocks to retrieve in a chunk from any individual peer during synchronization")
+         ( "sync-fetch-peers", bpo::value<uint32_t>()->default_value(def_sync_fetch_peers), "number of peers to request sync chunks from concurrently during synchronization")
          ( "use-socket-read-watermark", bpo::value<bool>()->default_value(false), "Enable experimental socket read watermark optimization")
          ( "peer-log-format", bpo::value<string>()->default_value( "[\"${_name}\" ${_ip}:${_port}]" ),
            "The string used to format peers when logging messages about them.  Variables are escaped with ${<variable name>}.\n"
@@ -3676,7 +4329,8 @@ namespace eosio {
       try {
          peer_log_format = options.at( "peer-log-format" ).as<string>();
 
-         my->sync_master.reset( new sync_manager( options.at( "sync-fetch-span" ).as<uint32_t>()));
+         my->sync_master.reset( new sync_manager( options.at( "sync-fetch-span" ).as<uint32_t>(),
+                                                  options.at( "sync-fetch-peers" ).as<uint32_t>() ));
 
          my->connector_period = std::chrono::seconds( options.at( "connection-cleanup-period" ).as<int>());
          my->max_cleanup_time_ms = options.at("max-cleanup-time-msec").as<int>();
@@ -3685,6 +4339,15 @@ namespace eosio {
          my->max_client_count = options.at( "max-clients" ).as<int>();
          my->max_nodes_per_host = options.at( "p2p-max-nodes-per-host" ).as<int>();
          my->p2p_accept_transactions = options.at( "p2p-accept-transactions" ).as<bool>();
+         my->p2p_announce_transactions = options.at( "p2p-announce-transactions" ).as<bool>();
+         my->max_trx_queue_size = options.at( "p2p-max-trx-queue-size-kb" ).as<uint32_t>() * 1024;
+         my->p2p_blk_congestion_control = options.at( "p2p-blk-congestion-control" ).as<string>();
+         my->p2p_compress_blocks = options.at( "p2p-compress-blocks" ).as<bool>();
+#ifndef __linux__
+         if( !my->p2p_blk_congestion_control.empty() ) {
+            wlog( "p2p-blk-congestion-control is only supported on Linux, ignoring" );
+         }
+#endif
          my->p2p_reject_incomplete_blocks = options.at("p2p-reject-incomplete-blocks").as<bool>();
 
          my->use_socket_read_watermark = options.at( "use-socket-read-watermark" ).as<bool>();
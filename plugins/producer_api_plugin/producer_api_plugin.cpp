@@ -111,6 +111,20 @@ void producer_api_plugin::plugin_startup() {
             INVOKE_V_R(producer, set_whitelist_blacklist, producer_plugin::whitelist_blacklist), 201),
        CALL_WITH_400(producer, producer, get_integrity_hash,
             INVOKE_R_V(producer, get_integrity_hash), 201),
+       CALL_WITH_400(producer, producer, get_block_apply_metrics,
+            INVOKE_R_V(producer, get_block_apply_metrics), 201),
+       CALL_WITH_400(producer, producer, get_thread_pool_task_metrics,
+            INVOKE_R_V(producer, get_thread_pool_task_metrics), 201),
+       CALL_WITH_400(producer, producer, get_contract_cpu_samples,
+            INVOKE_R_R_II(producer, get_contract_cpu_samples, producer_plugin::contract_cpu_samples_params), 201),
+       CALL_WITH_400(producer, producer, get_scheduled_transaction_metrics,
+            INVOKE_R_V(producer, get_scheduled_transaction_metrics), 201),
+       CALL_WITH_400(producer, producer, get_expired_transaction_metrics,
+            INVOKE_R_V(producer, get_expired_transaction_metrics), 201),
+       CALL_WITH_400(producer, producer, get_production_trace,
+            INVOKE_R_V(producer, get_production_trace), 201),
+       CALL_WITH_400(producer, producer, get_incoming_source_metrics,
+            INVOKE_R_V(producer, get_incoming_source_metrics), 201),
        CALL_ASYNC(producer, producer, create_snapshot, producer_plugin::snapshot_information,
             INVOKE_R_V_ASYNC(producer, create_snapshot), 201),
        CALL_WITH_400(producer, producer, get_scheduled_protocol_feature_activations,
@@ -2,6 +2,11 @@
 
 #include <eosio/chain_plugin/chain_plugin.hpp>
 #include <eosio/signature_provider_plugin/signature_provider_plugin.hpp>
+#include <eosio/chain/block_apply_metrics.hpp>
+#include <eosio/chain/contract_cpu_sampler.hpp>
+#include <eosio/chain/thread_utils.hpp>
+#include <eosio/producer_plugin/production_tracer.hpp>
+#include <eosio/producer_plugin/trx_source_limiter.hpp>
 
 #include <appbase/application.hpp>
 
@@ -71,6 +76,27 @@ public:
       std::optional<account_name>  more;
    };
 
+   /// scheduled (deferred) transaction queue, counts are of the last block this node produced
+   struct scheduled_transaction_metrics {
+      uint32_t queue_depth = 0;  ///< generated transactions currently in the database
+      uint32_t processed   = 0;
+      uint32_t applied     = 0;
+      uint32_t failed      = 0;
+      uint32_t blacklisted = 0;  ///< due but skipped, previously failed
+      uint32_t published   = 0;  ///< due but skipped, scheduled by the same block
+      bool     exhausted   = false; ///< due transactions were left for a later block
+   };
+
+   /// expired transaction purging, counts are of the last purge
+   struct expired_transaction_metrics {
+      uint32_t expired_unapplied    = 0;  ///< removed from the unapplied transaction queue
+      uint32_t expired_blacklisted  = 0;  ///< removed from the failed scheduled transaction blacklist
+      uint32_t purge_time_us        = 0;
+      uint32_t unapplied_queue_size = 0;  ///< remaining after the purge
+      uint32_t blacklist_size       = 0;  ///< remaining after the purge
+      bool     exhausted            = false; ///< expired transactions were left for a later purge
+   };
+
    template<typename T>
    using next_function = std::function<void(const std::variant<fc::exception_ptr, T>&)>;
 
@@ -104,6 +130,18 @@ public:
    void set_whitelist_blacklist(const whitelist_blacklist& params);
 
    integrity_hash_information get_integrity_hash() const;
+   chain::block_apply_metrics get_block_apply_metrics() const;
+   std::vector<chain::thread_pool_task_metrics> get_thread_pool_task_metrics() const;
+
+   struct contract_cpu_samples_params {
+      uint32_t limit = 100;   ///< actions with the most samples returned
+      bool     reset = false; ///< clear the samples after returning them
+   };
+   chain::contract_cpu_samples get_contract_cpu_samples(const contract_cpu_samples_params& params) const;
+   scheduled_transaction_metrics get_scheduled_transaction_metrics() const;
+   expired_transaction_metrics get_expired_transaction_metrics() const;
+   production_trace get_production_trace() const;
+   std::vector<trx_source_limiter::source_metrics> get_incoming_source_metrics() const;
    void create_snapshot(next_function<snapshot_information> next);
 
    scheduled_protocol_feature_activations get_scheduled_protocol_feature_activations() const;
@@ -130,3 +168,6 @@ FC_REFLECT(eosio::producer_plugin::scheduled_protocol_feature_activations, (prot
 FC_REFLECT(eosio::producer_plugin::get_supported_protocol_features_params, (exclude_disabled)(exclude_unactivatable))
 FC_REFLECT(eosio::producer_plugin::get_account_ram_corrections_params, (lower_bound)(upper_bound)(limit)(reverse))
 FC_REFLECT(eosio::producer_plugin::get_account_ram_corrections_result, (rows)(more))
+FC_REFLECT(eosio::producer_plugin::contract_cpu_samples_params, (limit)(reset))
+FC_REFLECT(eosio::producer_plugin::scheduled_transaction_metrics, (queue_depth)(processed)(applied)(failed)(blacklisted)(published)(exhausted))
+FC_REFLECT(eosio::producer_plugin::expired_transaction_metrics, (expired_unapplied)(expired_blacklisted)(purge_time_us)(unapplied_queue_size)(blacklist_size)(exhausted))
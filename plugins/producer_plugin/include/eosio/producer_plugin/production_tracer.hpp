@@ -0,0 +1,148 @@
+#pragma once
+
+#include <fc/time.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/variant_object.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace eosio {
+
+/// Chrome trace event format, see "Trace Event Format" of the chromium catapult project
+struct production_trace_event {
+   std::string             name;
+   std::string             ph = "X";   ///< complete event
+   int64_t                 ts = 0;     ///< start, microseconds since epoch
+   int64_t                 dur = 0;    ///< microseconds
+   uint32_t                pid = 1;
+   uint32_t                tid = 1;
+   fc::variant_object      args;
+};
+
+struct production_trace {
+   std::vector<production_trace_event> traceEvents;
+};
+
+/**
+ * Records the spans of work done by the producer for each pending block number in a ring buffer of the most recent
+ * blocks. Main thread only.
+ */
+class production_tracer {
+public:
+   class scoped_span {
+   public:
+      scoped_span( production_tracer* t, const char* name )
+      : _tracer( t ), _name( name ), _start( t ? fc::time_point::now() : fc::time_point() ) {}
+      scoped_span( scoped_span&& o ) : _tracer( o._tracer ), _name( o._name ), _start( o._start ) { o._tracer = nullptr; }
+      scoped_span( const scoped_span& ) = delete;
+      scoped_span& operator=( const scoped_span& ) = delete;
+      ~scoped_span() { end(); }
+
+      /// record the span now instead of on destruction
+      void end() {
+         if( _tracer ) _tracer->add_span( _name, _start, fc::time_point::now() );
+         _tracer = nullptr;
+      }
+      /// name must outlive the span
+      void rename( const char* name ) { _name = name; }
+
+   private:
+      production_tracer* _tracer;
+      const char*        _name;
+      fc::time_point     _start;
+   };
+
+   /// 0 disables tracing
+   void set_max_blocks( size_t n ) {
+      _max_blocks = n;
+      while( _blocks.size() > _max_blocks ) _blocks.pop_front();
+   }
+   bool is_enabled() const { return _max_blocks > 0; }
+
+   /// spans recorded from now on belong to block_num
+   void begin_block( uint32_t block_num ) {
+      if( !is_enabled() ) return;
+      if( !_blocks.empty() && _blocks.back().block_num == block_num ) return;
+      if( _blocks.size() >= _max_blocks ) _blocks.pop_front();
+      _blocks.push_back( block_timeline{ block_num } );
+   }
+
+   scoped_span span( const char* name ) {
+      return scoped_span( is_enabled() && !_blocks.empty() ? this : nullptr, name );
+   }
+
+   void add_span( const char* name, const fc::time_point& start, const fc::time_point& end ) {
+      if( !is_enabled() || _blocks.empty() ) return;
+      _blocks.back().spans.push_back( span_record{ name, start, end } );
+   }
+
+   /// transactions applied to the pending block outside of start_block, aggregated per block
+   void add_incoming_trx( const fc::microseconds& elapsed ) {
+      if( !is_enabled() || _blocks.empty() ) return;
+      ++_blocks.back().incoming_trxs;
+      _blocks.back().incoming_trx_us += elapsed.count();
+   }
+
+   /// spans of all recorded blocks, the time between top level spans of a block is reported as idle
+   production_trace get_trace() const {
+      production_trace result;
+      for( const auto& b : _blocks ) {
+         // spans are recorded when they end, so nested spans come before the span containing them
+         std::vector<span_record> spans = b.spans;
+         std::stable_sort( spans.begin(), spans.end(), []( const auto& l, const auto& r ) { return l.start < r.start; } );
+         fc::time_point covered_until;
+         for( const auto& s : spans ) {
+            if( covered_until != fc::time_point() && s.start > covered_until ) {
+               result.traceEvents.emplace_back( make_event( "idle", b.block_num, covered_until, s.start ) );
+            }
+            result.traceEvents.emplace_back( make_event( s.name, b.block_num, s.start, s.end ) );
+            covered_until = std::max( covered_until, s.end );
+         }
+         if( b.incoming_trxs > 0 && !spans.empty() ) {
+            production_trace_event e;
+            e.name = "incoming_trxs";
+            e.ph = "i"; // instant event at the end of the block
+            e.ts = covered_until.time_since_epoch().count();
+            e.args = fc::mutable_variant_object()( "block_num", b.block_num )
+                                                 ( "count", b.incoming_trxs )( "total_us", b.incoming_trx_us );
+            result.traceEvents.emplace_back( std::move( e ) );
+         }
+      }
+      return result;
+   }
+
+private:
+   static production_trace_event make_event( const char* name, uint32_t block_num,
+                                             const fc::time_point& start, const fc::time_point& end ) {
+      production_trace_event e;
+      e.name = name;
+      e.ts = start.time_since_epoch().count();
+      e.dur = ( end - start ).count();
+      e.args = fc::mutable_variant_object()( "block_num", block_num );
+      return e;
+   }
+
+   struct span_record {
+      const char*    name;
+      fc::time_point start;
+      fc::time_point end;
+   };
+
+   struct block_timeline {
+      uint32_t                 block_num = 0;
+      std::vector<span_record> spans;
+      uint32_t                 incoming_trxs = 0;
+      int64_t                  incoming_trx_us = 0;
+   };
+
+   size_t                     _max_blocks = 0;
+   std::deque<block_timeline> _blocks;
+};
+
+} //eosio
+
+FC_REFLECT( eosio::production_trace_event, (name)(ph)(ts)(dur)(pid)(tid)(args) )
+FC_REFLECT( eosio::production_trace, (traceEvents) )
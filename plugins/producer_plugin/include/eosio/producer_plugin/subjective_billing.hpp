@@ -11,9 +11,10 @@
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/ordered_index.hpp>
 
+#include <deque>
 #include <unordered_map>
+#include <vector>
 
 namespace eosio {
 
@@ -24,6 +25,92 @@ using chain::block_state_ptr;
 using chain::packed_transaction;
 namespace config = chain::config;
 
+/**
+ * Open addressing map of account to T using linear probing and backward shift deletion, so lookups touch a single
+ * contiguous array and erase leaves no tombstones. T must be default constructible.
+ */
+template<typename T>
+class account_table {
+public:
+   T* find( const account_name& a ) {
+      if( _size == 0 ) return nullptr;
+      for( size_t i = home( a ); _slots[i].used; i = ( i + 1 ) & mask() ) {
+         if( _slots[i].key == a ) return &_slots[i].value;
+      }
+      return nullptr;
+   }
+
+   const T* find( const account_name& a ) const { return const_cast<account_table*>( this )->find( a ); }
+
+   T& operator[]( const account_name& a ) {
+      if( ( _size + 1 ) * 2 > _slots.size() ) grow();
+      size_t i = home( a );
+      for( ; _slots[i].used; i = ( i + 1 ) & mask() ) {
+         if( _slots[i].key == a ) return _slots[i].value;
+      }
+      _slots[i].used = true;
+      _slots[i].key = a;
+      _slots[i].value = T{};
+      ++_size;
+      return _slots[i].value;
+   }
+
+   void erase( const account_name& a ) {
+      if( _size == 0 ) return;
+      size_t i = home( a );
+      for( ; _slots[i].used; i = ( i + 1 ) & mask() ) {
+         if( _slots[i].key == a ) break;
+      }
+      if( !_slots[i].used ) return;
+      // shift back following entries that would no longer be reachable from their home slot
+      for( size_t j = ( i + 1 ) & mask(); _slots[j].used; j = ( j + 1 ) & mask() ) {
+         const size_t k = home( _slots[j].key );
+         const bool reachable = i <= j ? ( i < k && k <= j ) : ( i < k || k <= j );
+         if( !reachable ) {
+            _slots[i] = std::move( _slots[j] );
+            i = j;
+         }
+      }
+      _slots[i].used = false;
+      _slots[i].value = T{};
+      --_size;
+   }
+
+   void clear() {
+      _slots.clear();
+      _size = 0;
+   }
+
+   size_t size() const { return _size; }
+   bool empty() const { return _size == 0; }
+
+private:
+   struct slot {
+      account_name key;
+      bool         used = false;
+      T            value{};
+   };
+
+   size_t mask() const { return _slots.size() - 1; }
+
+   size_t home( const account_name& a ) const {
+      // fibonacci hashing, account names share many low bits
+      return static_cast<size_t>( ( a.to_uint64_t() * 0x9E3779B97F4A7C15ull ) >> 32 ) & mask();
+   }
+
+   void grow() {
+      std::vector<slot> old( _slots.empty() ? 64 : _slots.size() * 2 );
+      std::swap( old, _slots );
+      _size = 0;
+      for( auto& e : old ) {
+         if( e.used ) (*this)[e.key] = std::move( e.value );
+      }
+   }
+
+   std::vector<slot> _slots;
+   size_t            _size = 0;
+};
+
 class subjective_billing {
 private:
 
@@ -34,16 +121,33 @@ private:
       fc::time_point          expiry;
    };
    struct by_id;
-   struct by_expiry;
 
    using trx_cache_index = bmi::multi_index_container<
          trx_cache_entry,
          indexed_by<
-               bmi::hashed_unique<tag<by_id>, BOOST_MULTI_INDEX_MEMBER( trx_cache_entry, transaction_id_type, trx_id ) >,
-               ordered_non_unique<tag<by_expiry>, BOOST_MULTI_INDEX_MEMBER( trx_cache_entry, fc::time_point, expiry ) >
+               bmi::hashed_unique<tag<by_id>, BOOST_MULTI_INDEX_MEMBER( trx_cache_entry, transaction_id_type, trx_id ) >
          >
    >;
 
+   /// time wheel of one bucket of trx ids per second of expiry, ids of removed entries are skipped when expired
+   struct expiry_wheel {
+      uint32_t                                        base_sec = 0; ///< expiry second of the front bucket
+      std::deque<std::vector<transaction_id_type>>    buckets;
+
+      void add( const transaction_id_type& id, const fc::time_point& expiry ) {
+         const uint32_t sec = expiry.sec_since_epoch();
+         if( buckets.empty() ) base_sec = sec;
+         // already due entries go in the front bucket, their exact expiry is checked when expired
+         const size_t i = sec > base_sec ? sec - base_sec : 0;
+         if( i >= buckets.size() ) buckets.resize( i + 1 );
+         buckets[i].push_back( id );
+      }
+
+      void clear() {
+         buckets.clear();
+      }
+   };
+
    using decaying_accumulator = chain::resource_limits::impl::exponential_decay_accumulator<>;
 
    struct subjective_billing_info {
@@ -55,11 +159,12 @@ private:
       }
    };
 
-   using account_subjective_bill_cache = std::unordered_map<account_name, subjective_billing_info>;
+   using account_subjective_bill_cache = account_table<subjective_billing_info>;
    using block_subjective_bill_cache = std::unordered_map<account_name, uint64_t>;
 
    bool                                      _disabled = false;
    trx_cache_index                           _trx_cache_index;
+   expiry_wheel                              _expiry_wheel;
    account_subjective_bill_cache             _account_subjective_bill_cache;
    block_subjective_bill_cache               _block_subjective_bill_cache;
    std::set<chain::account_name>             _disabled_accounts;
@@ -72,20 +177,20 @@ private:
    }
 
    void remove_subjective_billing( const trx_cache_entry& entry, uint32_t time_ordinal ) {
-      auto aitr = _account_subjective_bill_cache.find( entry.account );
-      if( aitr != _account_subjective_bill_cache.end() ) {
-         aitr->second.pending_cpu_us -= entry.subjective_cpu_bill;
-         EOS_ASSERT( aitr->second.pending_cpu_us >= 0, chain::tx_resource_exhaustion,
+      auto sub_bill_info = _account_subjective_bill_cache.find( entry.account );
+      if( sub_bill_info ) {
+         sub_bill_info->pending_cpu_us -= entry.subjective_cpu_bill;
+         EOS_ASSERT( sub_bill_info->pending_cpu_us >= 0, chain::tx_resource_exhaustion,
                      "Logic error in subjective account billing ${a}", ("a", entry.account) );
-         if( aitr->second.empty(time_ordinal) ) _account_subjective_bill_cache.erase( aitr );
+         if( sub_bill_info->empty(time_ordinal) ) _account_subjective_bill_cache.erase( entry.account );
       }
    }
 
    void transition_to_expired( const trx_cache_entry& entry, uint32_t time_ordinal ) {
-      auto aitr = _account_subjective_bill_cache.find( entry.account );
-      if( aitr != _account_subjective_bill_cache.end() ) {
-         aitr->second.pending_cpu_us -= entry.subjective_cpu_bill;
-         aitr->second.expired_accumulator.add(entry.subjective_cpu_bill, time_ordinal, expired_accumulator_average_window);
+      auto sub_bill_info = _account_subjective_bill_cache.find( entry.account );
+      if( sub_bill_info ) {
+         sub_bill_info->pending_cpu_us -= entry.subjective_cpu_bill;
+         sub_bill_info->expired_accumulator.add(entry.subjective_cpu_bill, time_ordinal, expired_accumulator_average_window);
       }
    }
 
@@ -130,6 +235,7 @@ public:
                                bill,
                                expire} );
          if( p.second ) {
+            _expiry_wheel.add( id, expire );
             _account_subjective_bill_cache[first_auth].pending_cpu_us += bill;
             if( in_pending_block ) {
                _block_subjective_bill_cache[first_auth] += bill;
@@ -150,11 +256,7 @@ public:
    uint32_t get_subjective_bill( const account_name& first_auth, const fc::time_point& now ) const {
       if( _disabled || _disabled_accounts.count( first_auth ) ) return 0;
       const auto time_ordinal = time_ordinal_for(now);
-      const subjective_billing_info* sub_bill_info = nullptr;
-      auto aitr = _account_subjective_bill_cache.find( first_auth );
-      if( aitr != _account_subjective_bill_cache.end() ) {
-         sub_bill_info = &aitr->second;
-      }
+      const subjective_billing_info* sub_bill_info = _account_subjective_bill_cache.find( first_auth );
       uint64_t in_block_pending_cpu_us = 0;
       auto bitr = _block_subjective_bill_cache.find( first_auth );
       if( bitr != _block_subjective_bill_cache.end() ) {
@@ -182,22 +284,45 @@ public:
 
    bool remove_expired( fc::logger& log, const fc::time_point& pending_block_time, const fc::time_point& now, const fc::time_point& deadline ) {
       bool exhausted = false;
-      auto& idx = _trx_cache_index.get<by_expiry>();
-      if( !idx.empty() ) {
+      auto& idx = _trx_cache_index.get<by_id>();
+      if( idx.empty() ) {
+         _expiry_wheel.clear(); // only ids of removed entries left
+      } else {
          const auto time_ordinal = time_ordinal_for(now);
          const auto orig_count = _trx_cache_index.size();
+         const uint32_t pending_block_sec = pending_block_time.sec_since_epoch();
          uint32_t num_expired = 0;
+         std::vector<transaction_id_type> not_due; // same second as pending_block_time but later
 
-         while( !idx.empty() ) {
-            if( deadline <= fc::time_point::now() ) {
-               exhausted = true;
-               break;
+         auto& wheel = _expiry_wheel;
+         while( !wheel.buckets.empty() && wheel.base_sec <= pending_block_sec && !exhausted ) {
+            auto& bucket = wheel.buckets.front();
+            while( !bucket.empty() ) {
+               if( deadline <= fc::time_point::now() ) {
+                  exhausted = true;
+                  break;
+               }
+               auto itr = idx.find( bucket.back() );
+               if( itr != idx.end() ) {
+                  if( itr->expiry > pending_block_time ) {
+                     not_due.push_back( bucket.back() );
+                  } else {
+                     transition_to_expired( *itr, time_ordinal );
+                     idx.erase( itr );
+                     num_expired++;
+                  }
+               }
+               bucket.pop_back();
             }
-            auto b = idx.begin();
-            if( b->expiry > pending_block_time ) break;
-            transition_to_expired( *b, time_ordinal );
-            idx.erase( b );
-            num_expired++;
+            if( !exhausted ) {
+               wheel.buckets.pop_front();
+               ++wheel.base_sec;
+            }
+         }
+         if( !not_due.empty() ) {
+            if( wheel.buckets.empty() ) wheel.buckets.emplace_back();
+            auto& front = wheel.buckets.front();
+            front.insert( front.end(), not_due.begin(), not_due.end() );
          }
 
          fc_dlog( log, "Processed ${n} subjective billed transactions, Expired ${expired}",
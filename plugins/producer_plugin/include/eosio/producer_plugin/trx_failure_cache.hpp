@@ -0,0 +1,101 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+#include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/transaction.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+
+namespace eosio {
+
+namespace bmi = boost::multi_index;
+using chain::digest_type;
+using chain::transaction;
+
+/**
+ * Remembers recent contract assert failures keyed by the actions of the failed transaction, so a transaction with
+ * identical actions is rejected with the same exception without being executed. Entries are only kept for a short
+ * window since a block may change the contract state the assert depends on.
+ */
+class trx_failure_cache {
+private:
+
+   struct failure_entry {
+      digest_type         key;
+      fc::time_point      expiry;
+      fc::exception_ptr   except;
+   };
+   struct by_key;
+   struct by_expiry;
+
+   using failure_index = bmi::multi_index_container<
+         failure_entry,
+         bmi::indexed_by<
+               bmi::hashed_unique<bmi::tag<by_key>, BOOST_MULTI_INDEX_MEMBER( failure_entry, digest_type, key ) >,
+               bmi::ordered_non_unique<bmi::tag<by_expiry>, BOOST_MULTI_INDEX_MEMBER( failure_entry, fc::time_point, expiry ) >
+         >
+   >;
+
+   failure_index       _failures;
+   fc::microseconds    _window;
+   size_t              _max_entries = default_max_entries;
+
+public:
+   static constexpr size_t default_max_entries = 16*1024;
+
+   /// a window of zero disables the cache
+   void set_window( const fc::microseconds& w ) { _window = w; }
+   void set_max_entries( size_t n ) { _max_entries = n; }
+   bool is_enabled() const { return _window.count() > 0; }
+   size_t size() const { return _failures.size(); }
+
+   /// only contract asserts are cached, they depend solely on the actions and the contract state
+   static bool is_deterministic_failure( int64_t exception_code ) {
+      return exception_code == chain::eosio_assert_message_exception::code_value ||
+             exception_code == chain::eosio_assert_code_exception::code_value;
+   }
+
+   /// contract, action name, authorization and data of all actions
+   static digest_type key_for( const transaction& trx ) {
+      digest_type::encoder enc;
+      fc::raw::pack( enc, trx.context_free_actions );
+      fc::raw::pack( enc, trx.actions );
+      return enc.result();
+   }
+
+   void add( const digest_type& key, const fc::exception& e, const fc::time_point& now ) {
+      if( !is_enabled() || !is_deterministic_failure( e.code() ) ) return;
+      remove_expired( now );
+      auto& idx = _failures.get<by_expiry>();
+      while( !idx.empty() && _failures.size() >= _max_entries ) {
+         idx.erase( idx.begin() );
+      }
+      auto itr = _failures.find( key );
+      if( itr == _failures.end() ) {
+         _failures.insert( { key, now + _window, e.dynamic_copy_exception() } );
+      } else {
+         _failures.modify( itr, [&]( auto& f ) { f.expiry = now + _window; } );
+      }
+   }
+
+   /// @return the exception of a recent failure with the same key, or null if none
+   fc::exception_ptr find( const digest_type& key, const fc::time_point& now ) const {
+      auto itr = _failures.find( key );
+      if( itr == _failures.end() || itr->expiry <= now ) return {};
+      return itr->except;
+   }
+
+   void remove_expired( const fc::time_point& now ) {
+      auto& idx = _failures.get<by_expiry>();
+      while( !idx.empty() && idx.begin()->expiry <= now ) {
+         idx.erase( idx.begin() );
+      }
+   }
+
+   void clear() { _failures.clear(); }
+};
+
+} //eosio
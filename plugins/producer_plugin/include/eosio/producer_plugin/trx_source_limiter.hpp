@@ -0,0 +1,201 @@
+#pragma once
+
+#include <eosio/chain/plugin_interface.hpp>
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace eosio {
+
+using chain::plugin_interface::transaction_source;
+using chain::plugin_interface::api_transaction_source;
+
+/**
+ * Shares the main thread execution time of incoming transactions between their sources: the http api, the api
+ * transactions that are persisted until expired and each p2p peer. Each source may only have a limited number of
+ * transactions pending, and a source that used more than its weighted share of the block interval has its
+ * transactions queued until the next block.
+ *
+ * admit() is thread safe, everything else is main thread only.
+ */
+class trx_source_limiter {
+public:
+   static constexpr transaction_source persisted_source = std::numeric_limits<transaction_source>::max();
+
+   struct source_metrics {
+      std::string source;
+      uint32_t    weight        = 0;
+      uint32_t    pending       = 0;  ///< admitted and not yet responded to, includes the queued ones
+      int64_t     block_cpu_us  = 0;  ///< used in the current block
+      uint64_t    executed      = 0;
+      uint64_t    deferred      = 0;  ///< queued until the next block for exceeding the share
+      uint64_t    rejected      = 0;  ///< not admitted for too many pending
+   };
+
+private:
+   struct source_state {
+      explicit source_state( transaction_source s ) : source( s ) {}
+
+      const transaction_source source;
+      std::atomic<uint32_t>    pending{0};
+      std::atomic<uint64_t>    rejected{0};
+      uint32_t                 block_num = 0;
+      int64_t                  block_cpu_us = 0;
+      uint64_t                 executed = 0;
+      uint64_t                 deferred = 0;
+   };
+   using source_state_ptr = std::shared_ptr<source_state>;
+
+   struct ticket {
+      explicit ticket( source_state_ptr s ) : state( std::move( s ) ) {}
+      ticket( const ticket& ) = delete;
+      ~ticket() { --state->pending; }
+      source_state_ptr state;
+   };
+
+public:
+   /// wraps the next function of an admitted transaction, pending until the last copy is destroyed
+   template<typename Result>
+   struct sourced_next {
+      std::shared_ptr<ticket>                                       tkt;
+      std::function<void( const std::variant<fc::exception_ptr, Result>& )> next;
+
+      void operator()( const std::variant<fc::exception_ptr, Result>& r ) const {
+         if( next ) next( r );
+      }
+   };
+
+   void set_weights( uint32_t api, uint32_t persisted, uint32_t p2p_peer ) {
+      _api_weight = api;
+      _persisted_weight = persisted;
+      _p2p_peer_weight = p2p_peer;
+   }
+   /// 0 for unlimited
+   void set_max_pending( uint32_t n ) { _max_pending = n; }
+   /// execution time shared between the sources per block, 0 disables the shares
+   void set_block_budget( const fc::microseconds& b ) { _block_budget_us = b.count(); }
+   bool shares_enabled() const { return _block_budget_us > 0; }
+   bool is_enabled() const { return shares_enabled() || _max_pending > 0; }
+
+   uint32_t weight( transaction_source s ) const {
+      if( s == api_transaction_source ) return _api_weight;
+      if( s == persisted_source ) return _persisted_weight;
+      return _p2p_peer_weight;
+   }
+
+   /// @return next wrapped to keep the transaction pending for its source, or an empty function if not admitted
+   template<typename Result>
+   std::function<void( const std::variant<fc::exception_ptr, Result>& )>
+   admit( transaction_source s, std::function<void( const std::variant<fc::exception_ptr, Result>& )> next ) {
+      source_state_ptr state;
+      {
+         // pending is incremented under the lock so start_block can not drop the source in between
+         std::lock_guard<std::mutex> g( _mtx );
+         auto& st = _sources[s];
+         if( !st ) st = std::make_shared<source_state>( s );
+         if( _max_pending > 0 && st->pending.load() >= _max_pending ) {
+            ++st->rejected;
+            return {};
+         }
+         ++st->pending;
+         state = st;
+      }
+      return sourced_next<Result>{ std::make_shared<ticket>( std::move( state ) ), std::move( next ) };
+   }
+
+   /// @return source the next function was admitted for, or null if it was not returned by admit
+   template<typename Result>
+   static source_state* source_of( const std::function<void( const std::variant<fc::exception_ptr, Result>& )>& next ) {
+      const auto* sn = next.template target<sourced_next<Result>>();
+      return sn && sn->tkt ? sn->tkt->state.get() : nullptr;
+   }
+
+   /// @return true if the source has not used its share of the block budget for block_num
+   bool within_share( source_state* s, uint32_t block_num ) {
+      if( !s || !shares_enabled() ) return true;
+      auto& state = *s;
+      reset_if_new_block( state, block_num );
+      if( state.block_cpu_us == 0 ) return true;
+
+      // shares are among the sources with pending transactions
+      uint64_t total_weight = 0;
+      {
+         std::lock_guard<std::mutex> g( _mtx );
+         for( const auto& i : _sources ) {
+            if( i.second->pending.load() > 0 || i.second.get() == s ) total_weight += weight( i.first );
+         }
+      }
+      if( total_weight == 0 ) return true;
+      const int64_t share_us = _block_budget_us * weight( s->source ) / total_weight;
+      if( state.block_cpu_us < share_us ) return true;
+      ++state.deferred;
+      return false;
+   }
+
+   void executed( source_state* s, uint32_t block_num, const fc::microseconds& elapsed ) {
+      if( !s ) return;
+      auto& state = *s;
+      reset_if_new_block( state, block_num );
+      state.block_cpu_us += elapsed.count();
+      ++state.executed;
+   }
+
+   /// drop the p2p peers that have nothing pending and executed nothing in the block before block_num
+   void start_block( uint32_t block_num ) {
+      std::lock_guard<std::mutex> g( _mtx );
+      for( auto itr = _sources.begin(); itr != _sources.end(); ) {
+         const auto& s = *itr->second;
+         if( s.source != api_transaction_source && s.source != persisted_source &&
+             s.pending.load() == 0 && s.block_num + 1 < block_num ) {
+            itr = _sources.erase( itr );
+         } else {
+            ++itr;
+         }
+      }
+   }
+
+   std::vector<source_metrics> get_metrics() const {
+      std::vector<source_metrics> result;
+      std::lock_guard<std::mutex> g( _mtx );
+      result.reserve( _sources.size() );
+      for( const auto& i : _sources ) {
+         const auto& s = *i.second;
+         std::string name = s.source == api_transaction_source ? "api"
+                          : s.source == persisted_source ? "persisted"
+                          : "p2p:" + std::to_string( s.source );
+         result.push_back( { std::move( name ), weight( s.source ), s.pending.load(), s.block_cpu_us,
+                             s.executed, s.deferred, s.rejected.load() } );
+      }
+      return result;
+   }
+
+private:
+   static void reset_if_new_block( source_state& state, uint32_t block_num ) {
+      if( state.block_num != block_num ) {
+         state.block_num = block_num;
+         state.block_cpu_us = 0;
+      }
+   }
+
+   uint32_t                                          _api_weight = 1;
+   uint32_t                                          _persisted_weight = 1;
+   uint32_t                                          _p2p_peer_weight = 1;
+   uint32_t                                          _max_pending = 0;
+   int64_t                                           _block_budget_us = 0;
+   mutable std::mutex                                _mtx;
+   std::map<transaction_source, source_state_ptr>    _sources;
+};
+
+} //eosio
+
+FC_REFLECT( eosio::trx_source_limiter::source_metrics, (source)(weight)(pending)(block_cpu_us)(executed)(deferred)(rejected) )
@@ -1,9 +1,14 @@
 #include <eosio/producer_plugin/producer_plugin.hpp>
 #include <eosio/producer_plugin/pending_snapshot.hpp>
 #include <eosio/producer_plugin/subjective_billing.hpp>
+#include <eosio/producer_plugin/trx_failure_cache.hpp>
+#include <eosio/producer_plugin/production_tracer.hpp>
+#include <eosio/producer_plugin/trx_source_limiter.hpp>
+#include <eosio/http_plugin/main_thread_queue.hpp>
 #include <eosio/chain/plugin_interface.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/generated_transaction_object.hpp>
+#include <eosio/chain/scheduled_transaction_queue.hpp>
 #include <eosio/chain/snapshot.hpp>
 #include <eosio/chain/transaction_object.hpp>
 #include <eosio/chain/thread_utils.hpp>
@@ -20,6 +25,9 @@
 
 #include <iostream>
 #include <algorithm>
+#include <array>
+#include <deque>
+#include <set>
 #include <boost/range/adaptor/map.hpp>
 #include <boost/function_output_iterator.hpp>
 #include <boost/multi_index_container.hpp>
@@ -123,9 +131,16 @@ enum class pending_block_mode {
 
 class producer_plugin_impl;
 class block_only_sync : public blockvault::sync_callback {
-   producer_plugin_impl*       _impl;
-   boost::asio::deadline_timer _start_sync_timer;
-   bool                        _pending = false;
+   // blocks received from the vault are applied this many blocks behind, so that the recovery of the transaction
+   // signing keys of the blocks ahead overlaps with their apply
+   static constexpr size_t                           block_prefetch = config::default_block_key_prefetch_limit / 2;
+
+   producer_plugin_impl*                             _impl;
+   boost::asio::deadline_timer                       _start_sync_timer;
+   bool                                              _pending = false;
+   std::deque<eosio::chain::signed_block_ptr>        _received_blocks;
+
+   void apply_received_block();
 
  public:
    block_only_sync(producer_plugin_impl* impl, boost::asio::io_service& io)
@@ -136,6 +151,8 @@ class block_only_sync : public blockvault::sync_callback {
    void schedule();
    void on_snapshot(const char* snapshot_filename) override;
    void on_block(eosio::chain::signed_block_ptr block) override;
+   /// applies the blocks received and not yet applied
+   void apply_received_blocks();
 };
 
 class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin_impl> {
@@ -155,7 +172,9 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       bool remove_expired_trxs( const fc::time_point& deadline );
       bool block_is_exhausted() const;
       bool remove_expired_blacklisted_trxs( const fc::time_point& deadline );
-      bool process_unapplied_trxs( const fc::time_point& deadline );
+      bool purge_expired_trxs( const fc::time_point& deadline );
+      void schedule_idle_expired_trx_purge();
+      bool process_unapplied_trxs( const fc::time_point& deadline, bool skip_persisted = false );
       void process_scheduled_and_incoming_trxs( const fc::time_point& deadline, size_t& pending_incoming_process_limit );
       bool process_incoming_trxs( const fc::time_point& deadline, size_t& pending_incoming_process_limit );
 
@@ -163,7 +182,7 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       bool     _production_enabled                 = false;
       bool     _pause_production                   = false;
 
-      using signature_provider_type = signature_provider_plugin::signature_provider_type;
+      using signature_provider_type = signature_provider_plugin::async_signature_provider_type;
       std::map<chain::public_key_type, signature_provider_type> _signature_providers;
       std::set<chain::account_name>                             _producers;
       boost::asio::deadline_timer                               _timer;
@@ -178,10 +197,14 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       fc::microseconds                                          _max_irreversible_block_age_us;
       int32_t                                                   _produce_time_offset_us = 0;
       int32_t                                                   _last_block_time_offset_us = 0;
+      bool                                                      _adaptive_last_block_time_offset = false;
+      int32_t                                                   _adaptive_last_block_time_offset_us = 0; // used instead of _last_block_time_offset_us when adaptive
+      std::optional<std::pair<uint32_t, block_id_type>>         _pending_handoff; // last block of our round, until the next producer's block
       uint32_t                                                  _max_block_cpu_usage_threshold_us = 0;
       uint32_t                                                  _max_block_net_usage_threshold_bytes = 0;
       int32_t                                                   _max_scheduled_transaction_time_per_block_ms = 0;
       bool                                                      _disable_persist_until_expired = false;
+      bool                                                      _prebuild_producer_block = false;
       bool                                                      _disable_subjective_p2p_billing = true;
       bool                                                      _disable_subjective_api_billing = true;
       fc::time_point                                            _irreversible_block_time;
@@ -205,6 +228,33 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       transaction_id_with_expiry_index                          _blacklisted_transactions;
       pending_snapshot_index                                    _pending_snapshot_index;
       subjective_billing                                        _subjective_billing;
+      flat_set<account_name>                                    _priority_accounts;
+      trx_failure_cache                                         _trx_failure_cache;
+      production_tracer                                         _production_tracer;
+      trx_source_limiter                                        _trx_source_limiter;
+
+      // speculative block started with the production parameters of a local producer's upcoming slot
+      struct prebuilt_block {
+         block_id_type    parent;
+         fc::time_point   block_time;
+         uint16_t         blocks_to_confirm = 0;
+      };
+      std::optional<prebuilt_block>                             _prebuilt_block;
+
+      // snapshot of chain state updated on the main thread, read by the producer thread pool to reject incoming
+      // transactions that can not succeed before they reach the main thread
+      struct trx_prevalidation_state {
+         std::atomic<int64_t>                            head_block_time_us{0};
+         std::atomic<uint32_t>                           max_transaction_net_usage{0};
+         std::array<std::atomic<uint32_t>, 1u << 16>     ref_block_prefixes{}; ///< indexed by ref_block_num, 0 if not known
+
+         void update( const block_state_ptr& bsp, const chain::controller& chain ) {
+            head_block_time_us = bsp->header.timestamp.to_time_point().time_since_epoch().count();
+            max_transaction_net_usage = chain.get_global_properties().configuration.max_transaction_net_usage;
+            ref_block_prefixes[static_cast<uint16_t>( bsp->block_num )] = static_cast<uint32_t>( bsp->id._hash[1] );
+         }
+      };
+      std::unique_ptr<trx_prevalidation_state>                  _trx_prevalidation; // null if disabled
 
       std::optional<scoped_connection>                          _accepted_block_connection;
       std::optional<scoped_connection>                          _accepted_block_header_connection;
@@ -225,8 +275,132 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       // keep a expected ratio between defer txn and incoming txn
       double _incoming_defer_ratio = 1.0; // 1:1
 
+      producer_plugin::scheduled_transaction_metrics _scheduled_trx_metrics;
+      producer_plugin::expired_transaction_metrics   _expired_trx_metrics;
+      fc::microseconds                               _expired_trx_purge_time; // 0 to purge until the block deadline
+      bool                                           _idle_expired_trx_purge_scheduled = false;
+
+      // unapplied transactions are saved here on shutdown and restored on startup, empty if disabled
+      bfs::path                                      _unapplied_trxs_file;
+      bool                                           _unapplied_trxs_restored = false;
+
       // path to write the snapshots to
       bfs::path _snapshots_dir;
+      // write snapshots as zlib compressed frames, hashing the state in the same pass
+      bool      _snapshot_compression = false;
+      // when set, snapshots only record the content that differs from this full snapshot
+      std::optional<bfs::path> _snapshot_delta_base;
+
+      static constexpr uint32_t unapplied_trxs_file_magic = 0x51585254; // "TRXQ"
+      static constexpr uint32_t unapplied_trxs_file_version = 1;
+
+      /// called on shutdown, the pending block is aborted so its transactions are saved too
+      void save_unapplied_trxs() {
+         abort_block();
+
+         auto pack_trxs = [this]( auto& ds ) {
+            fc::raw::pack( ds, unapplied_trxs_file_magic );
+            fc::raw::pack( ds, unapplied_trxs_file_version );
+            fc::raw::pack( ds, fc::unsigned_int( _unapplied_transactions.size() ) );
+            for( const auto& ut : _unapplied_transactions ) {
+               // persisted are re-applied until expired, forked and aborted were already accepted once
+               const bool persist_until_expired = ut.trx_type == trx_enum_type::persisted ||
+                                                  ut.trx_type == trx_enum_type::incoming_persisted;
+               fc::raw::pack( ds, persist_until_expired );
+               fc::raw::pack( ds, *ut.trx_meta->packed_trx() );
+            }
+         };
+         fc::datastream<size_t> ps;
+         pack_trxs( ps );
+         std::vector<char> out( ps.tellp() );
+         fc::datastream<char*> ds( out.data(), out.size() );
+         pack_trxs( ds );
+
+         const auto tmp = _unapplied_trxs_file.generic_string() + ".tmp";
+         {
+            std::ofstream f( tmp, std::ios::out | std::ios::binary | std::ios::trunc );
+            f.write( out.data(), out.size() );
+            EOS_ASSERT( f.good(), plugin_exception, "Unable to write ${f}", ("f", tmp) );
+         }
+         bfs::rename( tmp, _unapplied_trxs_file );
+         ilog( "Saved ${n} unapplied transactions to ${f}", ("n", _unapplied_transactions.size())("f", _unapplied_trxs_file.generic_string()) );
+      }
+
+      /// called on startup, transactions go through the normal incoming path for key recovery on the thread pool
+      void restore_unapplied_trxs() {
+         if( !bfs::exists( _unapplied_trxs_file ) ) {
+            _unapplied_trxs_restored = true;
+            return;
+         }
+
+         std::vector<char> in( bfs::file_size( _unapplied_trxs_file ) );
+         {
+            std::ifstream f( _unapplied_trxs_file.generic_string(), std::ios::in | std::ios::binary );
+            f.read( in.data(), in.size() );
+         }
+         // a file that can not be restored is not restored again
+         bfs::remove( _unapplied_trxs_file );
+
+         const chain::controller& chain = chain_plug->chain();
+         const fc::time_point head_block_time = chain.head_block_time();
+         size_t num_restored = 0, num_expired = 0;
+         try {
+            fc::datastream<const char*> ds( in.data(), in.size() );
+            uint32_t magic = 0, version = 0;
+            fc::raw::unpack( ds, magic );
+            fc::raw::unpack( ds, version );
+            EOS_ASSERT( magic == unapplied_trxs_file_magic && version == unapplied_trxs_file_version, plugin_exception,
+                        "Unsupported unapplied transaction file version ${v}", ("v", version) );
+            fc::unsigned_int count;
+            fc::raw::unpack( ds, count );
+            for( uint32_t i = 0; i < count.value; ++i ) {
+               bool persist_until_expired = false;
+               auto trx = std::make_shared<packed_transaction>();
+               fc::raw::unpack( ds, persist_until_expired );
+               fc::raw::unpack( ds, *trx );
+               if( fc::time_point( trx->expiration() ) < head_block_time ) {
+                  ++num_expired;
+                  continue;
+               }
+               // clients of the previous run are gone, nothing to respond to
+               on_incoming_transaction_async( trx, persist_until_expired, api_transaction_source, []( const auto& ) {} );
+               ++num_restored;
+            }
+         } catch( const fc::exception& e ) {
+            elog( "Unable to restore unapplied transactions from ${f}: ${e}",
+                  ("f", _unapplied_trxs_file.generic_string())("e", e.to_detail_string()) );
+         }
+         ilog( "Restored ${n} unapplied transactions, ${e} expired", ("n", num_restored)("e", num_expired) );
+         _unapplied_trxs_restored = true;
+      }
+
+      /// @return the integrity hash when it was computed while writing
+      std::optional<fc::sha256> write_snapshot_file( const bfs::path& p ) {
+         const chain::controller& chain = chain_plug->chain();
+         std::optional<fc::sha256> integrity_hash;
+
+         auto snap_out = std::ofstream(p.generic_string(), (std::ios::out | std::ios::binary));
+         if( _snapshot_delta_base ) {
+            auto base_in = std::ifstream(_snapshot_delta_base->generic_string(), (std::ios::in | std::ios::binary));
+            auto writer = std::make_shared<delta_ostream_snapshot_writer>(snap_out, base_in);
+            chain.write_snapshot(writer);
+            writer->finalize();
+         } else if( _snapshot_compression ) {
+            fc::sha256::encoder enc;
+            auto writer = std::make_shared<compressed_ostream_snapshot_writer>(snap_out, &enc);
+            chain.write_snapshot(writer);
+            writer->finalize();
+            integrity_hash = enc.result();
+         } else {
+            auto writer = std::make_shared<ostream_snapshot_writer>(snap_out);
+            chain.write_snapshot(writer);
+            writer->finalize();
+         }
+         snap_out.flush();
+         snap_out.close();
+         EOS_ASSERT( snap_out, snapshot_finalization_exception, "Unable to write snapshot ${p}", ("p", p.generic_string()) );
+         return integrity_hash;
+      }
 
       void consider_new_watermark( account_name producer, uint32_t block_num, block_timestamp_type timestamp) {
          auto itr = _producer_watermarks.find( producer );
@@ -247,9 +421,11 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       }
 
       void on_block( const block_state_ptr& bsp ) {
+         if( _trx_prevalidation ) _trx_prevalidation->update( bsp, chain_plug->chain() );
          auto before = _unapplied_transactions.size();
          _unapplied_transactions.clear_applied( bsp );
          _subjective_billing.on_block( bsp, fc::time_point::now() );
+         _trx_failure_cache.remove_expired( fc::time_point::now() );
          fc_dlog( _log, "Removed applied transactions before: ${before}, after: ${after}",
                   ("before", before)("after", _unapplied_transactions.size()) );
       }
@@ -281,6 +457,7 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       void abort_block() {
          auto& chain = chain_plug->chain();
 
+         _prebuilt_block.reset();
          _unapplied_transactions.add_aborted( chain.abort_block() );
          _subjective_billing.abort_block();
       }
@@ -386,6 +563,23 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
                return _unapplied_transactions.get_trx( id );
             } );
 
+            if( _pending_handoff && _producers.find( block->producer ) == _producers.end() ) {
+               // the first valid block of the next producer shows whether our last block reached it in time
+               if( block->previous == _pending_handoff->second ) {
+                  adjust_last_block_time_offset( true );
+               } else if( blk_num <= _pending_handoff->first + 1 ) {
+                  adjust_last_block_time_offset( false );
+               }
+               _pending_handoff.reset();
+            }
+
+            if( _log.is_enabled( fc::log_level::debug ) ) {
+               const auto& apply_times = chain.get_last_block_apply_times();
+               if( apply_times.block_num == blk_num ) {
+                  fc_dlog( _log, "applied block ${n} stage times: ${t}", ("n", blk_num)("t", apply_times) );
+               }
+            }
+
             if ( blockvault != nullptr ) {
                if (_block_vault_resync.is_pending() && _producers.count( block->producer ) > 0 ) {
                   // Cancel any pending resync from blockvault if we received any blocks from the same logical producer
@@ -438,19 +632,77 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          schedule_production_loop();
       }
 
-      void on_incoming_transaction_async(const packed_transaction_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
+      /// called from the producer thread pool, only rejects transactions that would certainly fail on the main thread
+      fc::exception_ptr prevalidate_incoming_trx( const packed_transaction& trx ) const {
+         const auto& state = *_trx_prevalidation;
+         const auto& t = trx.get_transaction();
+         const fc::time_point head_block_time{ fc::microseconds( state.head_block_time_us.load() ) };
+         if( fc::time_point( t.expiration ) < head_block_time ) {
+            return std::make_shared<expired_tx_exception>(
+                  FC_LOG_MESSAGE( error, "expired transaction ${id}, expiration ${e}, block time ${bt}",
+                                  ("id", trx.id())("e", t.expiration)("bt", head_block_time) ) );
+         }
+         const uint32_t ref_block_prefix = state.ref_block_prefixes[t.ref_block_num].load();
+         if( ref_block_prefix != 0 && ref_block_prefix != t.ref_block_prefix ) {
+            return std::make_shared<invalid_ref_block_exception>(
+                  FC_LOG_MESSAGE( error, "Transaction's reference block did not match. Is this transaction from a different fork?" ) );
+         }
+         const uint64_t max_net_usage = state.max_transaction_net_usage.load();
+         const uint64_t packed_size = trx.get_unprunable_size() + trx.get_prunable_size();
+         if( max_net_usage != 0 && packed_size > max_net_usage ) {
+            return std::make_shared<tx_net_usage_exceeded>(
+                  FC_LOG_MESSAGE( error, "transaction ${id} packed size ${s} exceeds max transaction net usage ${m}",
+                                  ("id", trx.id())("s", packed_size)("m", max_net_usage) ) );
+         }
+         return {};
+      }
+
+      // thread safe, only starts key recovery; next is called from the application thread
+      void on_incoming_transaction_async(const packed_transaction_ptr& trx, bool persist_until_expired, transaction_source source,
+                                         next_function<transaction_trace_ptr> next) {
+         if( _trx_source_limiter.is_enabled() ) {
+            if( persist_until_expired && source == api_transaction_source )
+               source = trx_source_limiter::persisted_source;
+            auto admitted = _trx_source_limiter.admit( source, next );
+            if( !admitted ) {
+               fc_dlog( _trx_failed_trace_log, "[TRX_TRACE] Source ${s} has too many pending transactions, REJECTING tx: ${txid}",
+                        ("s", source)("txid", trx->id()) );
+               auto ex = std::make_shared<tx_resource_exhaustion>(
+                     FC_LOG_MESSAGE( error, "too many pending transactions from the source of transaction ${id}", ("id", trx->id()) ) );
+               main_thread_post( priority::low, [ex{std::move(ex)}, next{std::move(next)}]() { next( ex ); } );
+               return;
+            }
+            next = std::move( admitted );
+         }
+         if( _trx_prevalidation ) {
+            boost::asio::post( _thread_pool->get_executor(), [self = this, trx, persist_until_expired, next{std::move(next)}]() mutable {
+               if( auto ex = self->prevalidate_incoming_trx( *trx ) ) {
+                  fc_dlog( _trx_failed_trace_log, "[TRX_TRACE] Pre-validation is REJECTING tx: ${txid} : ${why}",
+                           ("txid", trx->id())("why", ex->what()) );
+                  main_thread_post( priority::low, [ex{std::move(ex)}, next{std::move(next)}]() { next( ex ); } );
+                  return;
+               }
+               self->recover_and_process_incoming_trx( trx, persist_until_expired, std::move( next ) );
+            } );
+         } else {
+            recover_and_process_incoming_trx( trx, persist_until_expired, std::move( next ) );
+         }
+      }
+
+      void recover_and_process_incoming_trx(const packed_transaction_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
          chain::controller& chain = chain_plug->chain();
          const auto max_trx_time_ms = _max_transaction_time_ms.load();
          fc::microseconds max_trx_cpu_usage = max_trx_time_ms < 0 ? fc::microseconds::maximum() : fc::milliseconds( max_trx_time_ms );
 
          auto future = transaction_metadata::start_recover_keys( trx, _thread_pool->get_executor(),
-                chain.get_chain_id(), fc::microseconds( max_trx_cpu_usage ), chain.configured_subjective_signature_length_limit() );
+                chain.get_chain_id(), fc::microseconds( max_trx_cpu_usage ), chain.configured_subjective_signature_length_limit(),
+                &chain.get_recovered_key_cache() );
 
          boost::asio::post(_thread_pool->get_executor(), [self = this, future{std::move(future)}, persist_until_expired,
                                                           next{std::move(next)}, trx]() mutable {
             if( future.valid() ) {
                future.wait();
-               app().post( priority::low, [self, future{std::move(future)}, persist_until_expired, next{std::move( next )}, trx{std::move(trx)}]() mutable {
+               main_thread_post( priority::low, [self, future{std::move(future)}, persist_until_expired, next{std::move( next )}, trx{std::move(trx)}]() mutable {
                   auto exception_handler = [&next, trx{std::move(trx)}](fc::exception_ptr ex) {
                      fc_dlog(_trx_failed_trace_log, "[TRX_TRACE] Speculative execution is REJECTING tx: ${txid}, auth: ${a} : ${why} ",
                             ("txid", trx->id())("a",trx->get_transaction().first_authorizer())("why",ex->what()));
@@ -458,7 +710,10 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
                   };
                   try {
                      auto result = future.get();
-                     if( !self->process_incoming_transaction_async( result, persist_until_expired, next ) ) {
+                     const auto start = fc::time_point::now();
+                     const bool keep_going = self->process_incoming_transaction_async( result, persist_until_expired, next );
+                     self->_production_tracer.add_incoming_trx( fc::time_point::now() - start );
+                     if( !keep_going ) {
                         if( self->_pending_block_mode == pending_block_mode::producing ) {
                            self->schedule_maybe_produce_block( true );
                         } else {
@@ -532,6 +787,13 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
                return true;
             }
 
+            // a source over its share of this block waits for the next block
+            auto* source = trx_source_limiter::source_of( next );
+            if( !_trx_source_limiter.within_share( source, chain.head_block_num() + 1 ) ) {
+               _unapplied_transactions.add_incoming( trx, persist_until_expired, next );
+               return true;
+            }
+
             auto deadline = fc::time_point::now() + fc::milliseconds( _max_transaction_time_ms );
             bool deadline_is_subjective = false;
             const auto block_deadline = calculate_block_deadline( chain.pending_block_time() );
@@ -550,7 +812,19 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
             if( !disable_subjective_billing )
                sub_bill = _subjective_billing.get_subjective_bill( first_auth, fc::time_point::now() );
 
+            digest_type failure_key;
+            if( _trx_failure_cache.is_enabled() ) {
+               failure_key = trx_failure_cache::key_for( trx->packed_trx()->get_transaction() );
+               if( auto e_ptr = _trx_failure_cache.find( failure_key, fc::time_point::now() ) ) {
+                  fc_dlog( _trx_failed_trace_log, "[TRX_TRACE] Rejected tx: ${txid} matching a recent failure, ec: ${c}",
+                           ("txid", trx->id())("c", e_ptr->code()) );
+                  send_response( e_ptr->dynamic_copy_exception() );
+                  return true;
+               }
+            }
+
             auto trace = chain.push_transaction( trx, deadline, trx->billed_cpu_time_us, false, sub_bill );
+            _trx_source_limiter.executed( source, chain.head_block_num() + 1, trace->elapsed );
             fc_dlog( _trx_failed_trace_log, "Subjective bill for ${a}: ${b} elapsed ${t}us", ("a",first_auth)("b",sub_bill)("t",trace->elapsed));
             if( trace->except ) {
                if( exception_is_exhausted( *trace->except, deadline_is_subjective )) {
@@ -567,6 +841,8 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
                   exhausted = block_is_exhausted();
                } else {
                   _subjective_billing.subjective_bill_failure( first_auth, trace->elapsed, fc::time_point::now() );
+                  if( _trx_failure_cache.is_enabled() )
+                     _trx_failure_cache.add( failure_key, *trace->except, fc::time_point::now() );
                   auto e_ptr = trace->except->dynamic_copy_exception();
                   send_response( e_ptr );
                }
@@ -629,6 +905,7 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       start_block_result start_block();
 
       fc::time_point calculate_pending_block_time() const;
+      void adjust_last_block_time_offset( bool handed_off );
       fc::time_point calculate_block_deadline( const fc::time_point& ) const;
       void schedule_delayed_production_loop(const std::weak_ptr<producer_plugin_impl>& weak_this, std::optional<fc::time_point> wake_up_time);
       std::optional<fc::time_point> calculate_producer_wake_up_time( const block_timestamp_type& ref_block_time ) const;
@@ -695,6 +972,9 @@ void producer_plugin::set_program_options(
           "Offset of non last block producing time in microseconds. Valid range 0 .. -block_time_interval.")
          ("last-block-time-offset-us", boost::program_options::value<int32_t>()->default_value(-200000),
           "Offset of last block producing time in microseconds. Valid range 0 .. -block_time_interval.")
+         ("adaptive-last-block-time-offset", bpo::bool_switch()->default_value(false),
+          "Adjust the last block producing time offset from whether the next producer builds on our last block. Starts from the last-block-time-offset-us / last-block-cpu-effort-percent value, "
+          "rises up to the produce-time-offset-us value and falls down to the lower of the starting value and -block_time_interval/2.")
          ("cpu-effort-percent", bpo::value<uint32_t>()->default_value(config::default_block_cpu_effort_pct / config::percent_1),
           "Percentage of cpu block production time used to produce block. Whole number percentages, e.g. 80 for 80%")
          ("last-block-cpu-effort-percent", bpo::value<uint32_t>()->default_value(config::default_block_cpu_effort_pct / config::percent_1),
@@ -711,8 +991,32 @@ void producer_plugin::set_program_options(
           "ratio between incoming transactions and deferred transactions when both are queued for execution")
          ("incoming-transaction-queue-size-mb", bpo::value<uint16_t>()->default_value( 1024 ),
           "Maximum size (in MiB) of the incoming transaction queue. Exceeding this value will subjectively drop transaction with resource exhaustion.")
+         ("trx-failure-cache-ms", bpo::value<uint32_t>()->default_value(0),
+          "Milliseconds to reject incoming transactions with the same actions as a transaction that recently failed a contract assert, without executing them. 0 disables.")
+         ("incoming-priority-account", boost::program_options::value<vector<string>>()->composing()->multitoken(),
+          "Account whose queued incoming transactions are applied before those of other accounts. Other accounts are ordered by least recent subjective CPU usage.")
          ("disable-api-persisted-trx", bpo::bool_switch()->default_value(false),
           "Disable the re-apply of API transactions.")
+         ("persist-unapplied-trxs", bpo::bool_switch()->default_value(false),
+          "Save queued unapplied transactions to the data directory on shutdown and resubmit the unexpired ones on startup.")
+         ("expired-trx-purge-time-us", bpo::value<uint32_t>()->default_value(0),
+          "Limit in microseconds on the time spent purging expired transactions when a block starts, the rest is purged while idle. 0 purges until the block deadline.")
+         ("production-trace-blocks", bpo::value<uint32_t>()->default_value(0),
+          "Number of most recent blocks to keep a timeline of block production spans for, retrievable in Chrome trace event format. 0 disables.")
+         ("incoming-trx-source-max-pending", bpo::value<uint32_t>()->default_value(0),
+          "Maximum number of incoming transactions pending execution per source (http api, persisted api, each p2p peer); more are rejected. 0 for unlimited.")
+         ("incoming-trx-source-share", bpo::bool_switch()->default_value(false),
+          "Share the execution time of each block between the incoming transaction sources by weight, transactions of a source over its share are queued for the next block.")
+         ("incoming-api-trx-weight", bpo::value<uint32_t>()->default_value(1),
+          "Weight of http api transactions for incoming-trx-source-share.")
+         ("incoming-persisted-trx-weight", bpo::value<uint32_t>()->default_value(1),
+          "Weight of http api transactions persisted until expired for incoming-trx-source-share.")
+         ("incoming-p2p-peer-trx-weight", bpo::value<uint32_t>()->default_value(1),
+          "Weight of the transactions of each p2p peer for incoming-trx-source-share.")
+         ("incoming-trx-prevalidation", bpo::bool_switch()->default_value(false),
+          "Reject incoming transactions that are expired, reference an unknown fork or exceed the max transaction net usage on the producer threads before they are queued for the main thread.")
+         ("prebuild-producer-block", bpo::bool_switch()->default_value(false),
+          "Build the block of a local producer's next slot while waiting for the slot to begin and continue it when the slot begins on the same parent block.")
          ("disable-subjective-billing", bpo::value<bool>()->default_value(true),
           "Disable subjective CPU billing for API/P2P transactions")
          ("disable-subjective-account-billing", boost::program_options::value<vector<string>>()->composing()->multitoken(),
@@ -725,6 +1029,10 @@ void producer_plugin::set_program_options(
           "Number of worker threads in producer thread pool")
          ("snapshots-dir", bpo::value<bfs::path>()->default_value("snapshots"),
           "the location of the snapshots directory (absolute path or relative to application data dir)")
+         ("snapshot-compression", bpo::value<bool>()->default_value(false),
+          "Write snapshots as compressed frames and log their integrity hash, computed while writing. Compressed snapshots are detected automatically by --snapshot")
+         ("snapshot-delta-base", bpo::value<bfs::path>(),
+          "Write snapshots as deltas relative to this uncompressed snapshot (absolute path or relative to snapshots-dir). Restore with --snapshot <delta> --snapshot-base <base>")
          ;
    config_file_options.add(producer_options);
 }
@@ -743,7 +1051,7 @@ chain::signature_type producer_plugin::sign_compact(const chain::public_key_type
     auto private_key_itr = my->_signature_providers.find(key);
     EOS_ASSERT(private_key_itr != my->_signature_providers.end(), producer_priv_key_not_found, "Local producer has no private key in config.ini corresponding to public key ${key}", ("key", key));
 
-    return private_key_itr->second(digest);
+    return private_key_itr->second(digest).get();
   }
   else {
     return chain::signature_type();
@@ -782,7 +1090,7 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
       {
          try {
             auto key_id_to_wif_pair = dejsonify<std::pair<public_key_type, private_key_type>>(key_id_to_wif_pair_string);
-            my->_signature_providers[key_id_to_wif_pair.first] = app().get_plugin<signature_provider_plugin>().signature_provider_for_private_key(key_id_to_wif_pair.second);
+            my->_signature_providers[key_id_to_wif_pair.first] = app().get_plugin<signature_provider_plugin>().async_signature_provider_for_private_key(key_id_to_wif_pair.second);
             auto blanked_privkey = std::string(key_id_to_wif_pair.second.to_string().size(), '*' );
             wlog("\"private-key\" is DEPRECATED, use \"signature-provider=${pub}=KEY:${priv}\"", ("pub",key_id_to_wif_pair.first)("priv", blanked_privkey));
          } catch ( const std::exception& e ) {
@@ -795,7 +1103,7 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
       const std::vector<std::string> key_spec_pairs = options["signature-provider"].as<std::vector<std::string>>();
       for (const auto& key_spec_pair : key_spec_pairs) {
          try {
-            const auto& [pubkey, provider] = app().get_plugin<signature_provider_plugin>().signature_provider_for_specification(key_spec_pair);
+            const auto& [pubkey, provider] = app().get_plugin<signature_provider_plugin>().async_signature_provider_for_specification(key_spec_pair);
             my->_signature_providers[pubkey] = provider;
          } catch(secure_enclave_exception& e) {
             elog("Error with Secure Enclave signature provider: ${e}; ignoring ${val}", ("e", e.top_message())("val", key_spec_pair));
@@ -829,6 +1137,8 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
 
    my->_produce_time_offset_us = std::min( my->_produce_time_offset_us, cpu_effort_offset_us );
    my->_last_block_time_offset_us = std::min( my->_last_block_time_offset_us, last_block_cpu_effort_offset_us );
+   my->_adaptive_last_block_time_offset = options.at( "adaptive-last-block-time-offset" ).as<bool>();
+   my->_adaptive_last_block_time_offset_us = my->_last_block_time_offset_us;
 
    my->_max_block_cpu_usage_threshold_us = options.at( "max-block-cpu-usage-threshold-us" ).as<uint32_t>();
    EOS_ASSERT( my->_max_block_cpu_usage_threshold_us < config::block_interval_us, plugin_config_exception,
@@ -856,6 +1166,21 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
    my->_incoming_defer_ratio = options.at("incoming-defer-ratio").as<double>();
 
    my->_disable_persist_until_expired = options.at("disable-api-persisted-trx").as<bool>();
+   my->_prebuild_producer_block = options.at("prebuild-producer-block").as<bool>();
+   my->_expired_trx_purge_time = fc::microseconds( options.at("expired-trx-purge-time-us").as<uint32_t>() );
+   my->_production_tracer.set_max_blocks( options.at("production-trace-blocks").as<uint32_t>() );
+   my->_trx_source_limiter.set_max_pending( options.at("incoming-trx-source-max-pending").as<uint32_t>() );
+   my->_trx_source_limiter.set_weights( options.at("incoming-api-trx-weight").as<uint32_t>(),
+                                        options.at("incoming-persisted-trx-weight").as<uint32_t>(),
+                                        options.at("incoming-p2p-peer-trx-weight").as<uint32_t>() );
+   if( options.at("incoming-trx-source-share").as<bool>() )
+      my->_trx_source_limiter.set_block_budget( fc::microseconds( config::block_interval_us ) );
+   if( options.at("persist-unapplied-trxs").as<bool>() ) {
+      my->_unapplied_trxs_file = app().data_dir() / "unapplied_transactions.bin";
+   }
+   if( options.at("incoming-trx-prevalidation").as<bool>() ) {
+      my->_trx_prevalidation = std::make_unique<producer_plugin_impl::trx_prevalidation_state>();
+   }
    bool disable_subjective_billing = options.at("disable-subjective-billing").as<bool>();
    my->_disable_subjective_p2p_billing = options.at("disable-subjective-p2p-billing").as<bool>();
    my->_disable_subjective_api_billing = options.at("disable-subjective-api-billing").as<bool>();
@@ -899,7 +1224,17 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
          resmon_plugin->monitor_directory(my->_snapshots_dir);
       }
    }
-
+   my->_snapshot_compression = options.at( "snapshot-compression" ).as<bool>();
+   if( options.count( "snapshot-delta-base" )) {
+      auto base = options.at( "snapshot-delta-base" ).as<bfs::path>();
+      if( base.is_relative() )
+         base = my->_snapshots_dir / base;
+      EOS_ASSERT( fc::is_regular_file(base), plugin_config_exception,
+                  "snapshot-delta-base ${p} does not exist", ("p", base.generic_string()) );
+      EOS_ASSERT( !my->_snapshot_compression, plugin_config_exception,
+                  "snapshot-delta-base cannot be combined with snapshot-compression" );
+      my->_snapshot_delta_base = base;
+   }
    my->_incoming_block_subscription = app().get_channel<incoming::channels::block>().subscribe(
          [this](const signed_block_ptr& block) {
       try {
@@ -910,7 +1245,7 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
    my->_incoming_transaction_subscription = app().get_channel<incoming::channels::transaction>().subscribe(
          [this](const packed_transaction_ptr& trx) {
       try {
-         my->on_incoming_transaction_async(trx, false, [](const auto&){});
+         my->on_incoming_transaction_async(trx, false, api_transaction_source, [](const auto&){});
       } LOG_AND_DROP();
    });
 
@@ -925,8 +1260,9 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
    });
 
    my->_incoming_transaction_async_provider = app().get_method<incoming::methods::transaction_async>().register_provider(
-         [this](const packed_transaction_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) -> void {
-      return my->on_incoming_transaction_async(trx, persist_until_expired, next );
+         [this](const packed_transaction_ptr& trx, bool persist_until_expired, transaction_source source,
+                next_function<transaction_trace_ptr> next) -> void {
+      return my->on_incoming_transaction_async(trx, persist_until_expired, source, next );
    });
 
    if (options.count("greylist-account")) {
@@ -950,6 +1286,25 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
       }
    }
 
+   my->_trx_failure_cache.set_window( fc::milliseconds( options.at("trx-failure-cache-ms").as<uint32_t>() ) );
+
+   if( options.count("incoming-priority-account") ) {
+      std::vector<std::string> accounts = options["incoming-priority-account"].as<std::vector<std::string>>();
+      for( const auto& a : accounts ) {
+         my->_priority_accounts.insert( account_name(a) );
+      }
+   }
+
+   // priority accounts first, then authorizers with the least recent subjective cpu usage so that an account
+   // flooding the queue does not delay the transactions of other accounts
+   my->_unapplied_transactions.set_priority_function( [my = my.get()]( const transaction_metadata_ptr& trx ) -> uint32_t {
+      const auto first_auth = trx->packed_trx()->get_transaction().first_authorizer();
+      const uint32_t sub_bill_ms = my->_subjective_billing.get_subjective_bill( first_auth, fc::time_point::now() ) / 1000;
+      uint32_t priority = std::numeric_limits<uint16_t>::max() - std::min<uint32_t>( sub_bill_ms, std::numeric_limits<uint16_t>::max() );
+      if( my->_priority_accounts.count( first_auth ) ) priority += 1u << 16;
+      return priority;
+   } );
+
 } FC_LOG_AND_RETHROW() }
 
 void producer_plugin::plugin_startup()
@@ -969,6 +1324,7 @@ void producer_plugin::plugin_startup()
    EOS_ASSERT( my->_producers.empty() || my->chain_plug->accept_transactions(), plugin_config_exception,
               "node cannot have any producer-name configured because no block production is possible with no [api|p2p]-accepted-transactions" );
 
+   if( my->_trx_prevalidation ) my->_trx_prevalidation->update( chain.head_block_state(), chain );
    my->_accepted_block_connection.emplace(chain.accepted_block.connect( [this]( const auto& bsp ){ my->on_block( bsp ); } ));
    my->_accepted_block_header_connection.emplace(chain.accepted_block_header.connect( [this]( const auto& bsp ){ my->on_block_header( bsp ); } ));
    my->_irreversible_block_connection.emplace(chain.irreversible_block.connect( [this]( const auto& bsp ){ my->on_irreversible_block( bsp->block ); } ));
@@ -993,6 +1349,10 @@ void producer_plugin::plugin_startup()
 
    my->schedule_production_loop();
 
+   if( !my->_unapplied_trxs_file.empty() ) {
+      my->restore_unapplied_trxs();
+   }
+
    ilog("producer plugin:  plugin_startup() end");
    } catch( ... ) {
       // always call plugin_shutdown, even on exception
@@ -1005,6 +1365,10 @@ void producer_plugin::plugin_shutdown() {
    try {
       my->_timer.cancel();
       my->_block_vault_resync.cancel();
+      // not when startup failed before the previous run's transactions were restored
+      if( my->_unapplied_trxs_restored ) {
+         my->save_unapplied_trxs();
+      }
    } catch ( const std::bad_alloc& ) {
      chain_plugin::handle_bad_alloc();
    } catch ( const boost::interprocess::bad_alloc& ) {
@@ -1070,6 +1434,7 @@ void producer_plugin::update_runtime_options(const runtime_options& options) {
 
    if (options.last_block_time_offset_us) {
       my->_last_block_time_offset_us = *options.last_block_time_offset_us;
+      my->_adaptive_last_block_time_offset_us = my->_last_block_time_offset_us;
    }
 
    if (options.max_scheduled_transaction_time_per_block_ms) {
@@ -1173,6 +1538,40 @@ producer_plugin::integrity_hash_information producer_plugin::get_integrity_hash(
    return {chain.head_block_id(), chain.calculate_integrity_hash()};
 }
 
+chain::block_apply_metrics producer_plugin::get_block_apply_metrics() const {
+   return my->chain_plug->chain().get_block_apply_metrics();
+}
+
+std::vector<chain::thread_pool_task_metrics> producer_plugin::get_thread_pool_task_metrics() const {
+   return chain::get_thread_pool_task_metrics();
+}
+
+chain::contract_cpu_samples producer_plugin::get_contract_cpu_samples(const contract_cpu_samples_params& params) const {
+   auto& sampler = my->chain_plug->chain().get_contract_cpu_sampler();
+   auto result = sampler.get_samples( params.limit );
+   if( params.reset )
+      sampler.reset();
+   return result;
+}
+
+producer_plugin::scheduled_transaction_metrics producer_plugin::get_scheduled_transaction_metrics() const {
+   auto metrics = my->_scheduled_trx_metrics;
+   metrics.queue_depth = my->chain_plug->chain().db().get_index<generated_transaction_multi_index>().indices().size();
+   return metrics;
+}
+
+producer_plugin::expired_transaction_metrics producer_plugin::get_expired_transaction_metrics() const {
+   return my->_expired_trx_metrics;
+}
+
+production_trace producer_plugin::get_production_trace() const {
+   return my->_production_tracer.get_trace();
+}
+
+std::vector<trx_source_limiter::source_metrics> producer_plugin::get_incoming_source_metrics() const {
+   return my->_trx_source_limiter.get_metrics();
+}
+
 void producer_plugin::create_snapshot(producer_plugin::next_function<producer_plugin::snapshot_information> next) {
    chain::controller& chain = my->chain_plug->chain();
 
@@ -1203,13 +1602,8 @@ void producer_plugin::create_snapshot(producer_plugin::next_function<producer_pl
 
       bfs::create_directory( p.parent_path() );
 
-      // create the snapshot
-      auto snap_out = std::ofstream(p.generic_string(), (std::ios::out | std::ios::binary));
-      auto writer = std::make_shared<ostream_snapshot_writer>(snap_out);
-      chain.write_snapshot(writer);
-      writer->finalize();
-      snap_out.flush();
-      snap_out.close();
+      if( auto hash = my->write_snapshot_file( p ) )
+         ilog( "wrote compressed snapshot ${p}, integrity hash ${h}", ("p", p.generic_string())("h", *hash) );
    };
 
    // If in irreversible mode, create snapshot and return path to snapshot immediately.
@@ -1442,12 +1836,31 @@ fc::time_point producer_plugin_impl::calculate_pending_block_time() const {
 fc::time_point producer_plugin_impl::calculate_block_deadline( const fc::time_point& block_time ) const {
    if( _pending_block_mode == pending_block_mode::producing ) {
       bool last_block = ((block_timestamp_type( block_time ).slot % config::producer_repetitions) == config::producer_repetitions - 1);
-      return block_time + fc::microseconds(last_block ? _last_block_time_offset_us : _produce_time_offset_us);
+      const int32_t last_block_time_offset_us = _adaptive_last_block_time_offset ? _adaptive_last_block_time_offset_us : _last_block_time_offset_us;
+      return block_time + fc::microseconds(last_block ? last_block_time_offset_us : _produce_time_offset_us);
    } else {
       return block_time + fc::microseconds(_produce_time_offset_us);
    }
 }
 
+void producer_plugin_impl::adjust_last_block_time_offset( bool handed_off ) {
+   // back off quickly on a missed handoff, recover slowly. Never more aggressive than non last blocks and never
+   // more conservative than half a block interval or the configured offset.
+   constexpr int32_t missed_step_us = 25000;
+   constexpr int32_t handed_off_step_us = 2000;
+   if( !_adaptive_last_block_time_offset ) return;
+   const int32_t min_offset_us = std::min( _last_block_time_offset_us, -config::block_interval_us / 2 );
+   const int32_t prev = _adaptive_last_block_time_offset_us;
+   if( handed_off ) {
+      _adaptive_last_block_time_offset_us = std::min( prev + handed_off_step_us, _produce_time_offset_us );
+   } else {
+      _adaptive_last_block_time_offset_us = std::max( prev - missed_step_us, min_offset_us );
+      wlog( "Next producer did not build on our last block, last block time offset ${p}us -> ${o}us",
+            ("p", prev)("o", _adaptive_last_block_time_offset_us) );
+   }
+   fc_dlog( _log, "Last block time offset ${o}us", ("o", _adaptive_last_block_time_offset_us) );
+}
+
 producer_plugin_impl::start_block_result producer_plugin_impl::start_block() {
    chain::controller& chain = chain_plug->chain();
 
@@ -1456,6 +1869,11 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block() {
 
    const auto& hbs = chain.head_block_state();
 
+   _production_tracer.begin_block( hbs->block_num + 1 );
+   if( _trx_source_limiter.is_enabled() )
+      _trx_source_limiter.start_block( hbs->block_num + 1 );
+   auto trace_span = _production_tracer.span( "start_block" );
+
    if( chain.get_terminate_at_block() > 0 && chain.get_terminate_at_block() < hbs->block_num ) {
       ilog("Reached configured maximum block ${num}; terminating", ("num", chain.get_terminate_at_block()));
       app().quit();
@@ -1528,13 +1946,25 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block() {
          return start_block_result::waiting_for_block;
    }
 
+   bool prebuilding = false;
    if (_pending_block_mode == pending_block_mode::producing) {
       const auto start_block_time = block_time - fc::microseconds( config::block_interval_us );
       if( now < start_block_time ) {
          fc_dlog(_log, "Not producing block waiting for production window ${n} ${bt}", ("n", hbs->block_num + 1)("bt", block_time) );
          // start_block_time instead of block_time because schedule_delayed_production_loop calculates next block time from given time
          schedule_delayed_production_loop(weak_from_this(), calculate_producer_wake_up_time(start_block_time));
-         return start_block_result::waiting_for_production;
+         // only pre-build within one block interval of the slot, and not when protocol features are to be activated
+         if( !_prebuild_producer_block || now + fc::microseconds( config::block_interval_us ) < start_block_time ||
+             !_protocol_features_to_activate.empty() ) {
+            return start_block_result::waiting_for_production;
+         }
+         if( _prebuilt_block && chain.is_building_block() && _prebuilt_block->parent == hbs->id &&
+             _prebuilt_block->block_time == block_time ) {
+            // already pre-built on this parent, keep it
+            _pending_block_mode = pending_block_mode::speculating;
+            return start_block_result::waiting_for_production;
+         }
+         prebuilding = true;
       }
    } else if (previous_pending_mode == pending_block_mode::producing) {
       // just produced our last block of our round
@@ -1547,6 +1977,7 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block() {
    fc_dlog(_log, "Starting block #${n} at ${time} producer ${p}",
            ("n", hbs->block_num + 1)("time", now)("p", scheduled_producer.producer_name));
 
+   bool reuse_prebuilt = false;
    try {
       uint16_t blocks_to_confirm = 0;
 
@@ -1568,57 +1999,73 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block() {
          blocks_to_confirm = (uint16_t)(std::min<uint32_t>(blocks_to_confirm, (uint32_t)(hbs->block_num - hbs->dpos_irreversible_blocknum)));
       }
 
-      abort_block();
+      if( !prebuilding && _pending_block_mode == pending_block_mode::producing && _prebuilt_block && chain.is_building_block() &&
+          _prebuilt_block->parent == hbs->id && _prebuilt_block->block_time == block_time &&
+          _prebuilt_block->blocks_to_confirm == blocks_to_confirm && _protocol_features_to_activate.empty() ) {
+         fc_dlog(_log, "Continuing pre-built block #${n}", ("n", hbs->block_num + 1));
+         _prebuilt_block.reset();
+         reuse_prebuilt = true;
+      } else {
+         abort_block();
 
-      auto features_to_activate = chain.get_preactivated_protocol_features();
-      if( _pending_block_mode == pending_block_mode::producing && _protocol_features_to_activate.size() > 0 ) {
-         bool drop_features_to_activate = false;
-         try {
-            chain.validate_protocol_features( _protocol_features_to_activate );
-         } catch ( const std::bad_alloc& ) {
-           chain_plugin::handle_bad_alloc();
-         } catch ( const boost::interprocess::bad_alloc& ) {
-           chain_plugin::handle_bad_alloc();
-         } catch( const fc::exception& e ) {
-            wlog( "protocol features to activate are no longer all valid: ${details}",
-                  ("details",e.to_detail_string()) );
-            drop_features_to_activate = true;
-         } catch( const std::exception& e ) {
-            wlog( "protocol features to activate are no longer all valid: ${details}",
-                  ("details",fc::std_exception_wrapper::from_current_exception(e).to_detail_string()) );
-            drop_features_to_activate = true;
-         }
+         auto features_to_activate = chain.get_preactivated_protocol_features();
+         if( _pending_block_mode == pending_block_mode::producing && _protocol_features_to_activate.size() > 0 ) {
+            bool drop_features_to_activate = false;
+            try {
+               chain.validate_protocol_features( _protocol_features_to_activate );
+            } catch ( const std::bad_alloc& ) {
+              chain_plugin::handle_bad_alloc();
+            } catch ( const boost::interprocess::bad_alloc& ) {
+              chain_plugin::handle_bad_alloc();
+            } catch( const fc::exception& e ) {
+               wlog( "protocol features to activate are no longer all valid: ${details}",
+                     ("details",e.to_detail_string()) );
+               drop_features_to_activate = true;
+            } catch( const std::exception& e ) {
+               wlog( "protocol features to activate are no longer all valid: ${details}",
+                     ("details",fc::std_exception_wrapper::from_current_exception(e).to_detail_string()) );
+               drop_features_to_activate = true;
+            }
 
-         if( drop_features_to_activate ) {
-            _protocol_features_to_activate.clear();
-         } else {
-            auto protocol_features_to_activate = _protocol_features_to_activate; // do a copy as pending_block might be aborted
-            if( features_to_activate.size() > 0 ) {
-               protocol_features_to_activate.reserve( protocol_features_to_activate.size()
-                                                         + features_to_activate.size() );
-               std::set<digest_type> set_of_features_to_activate( protocol_features_to_activate.begin(),
-                                                                  protocol_features_to_activate.end() );
-               for( const auto& f : features_to_activate ) {
-                  auto res = set_of_features_to_activate.insert( f );
-                  if( res.second ) {
-                     protocol_features_to_activate.push_back( f );
+            if( drop_features_to_activate ) {
+               _protocol_features_to_activate.clear();
+            } else {
+               auto protocol_features_to_activate = _protocol_features_to_activate; // do a copy as pending_block might be aborted
+               if( features_to_activate.size() > 0 ) {
+                  protocol_features_to_activate.reserve( protocol_features_to_activate.size()
+                                                            + features_to_activate.size() );
+                  std::set<digest_type> set_of_features_to_activate( protocol_features_to_activate.begin(),
+                                                                     protocol_features_to_activate.end() );
+                  for( const auto& f : features_to_activate ) {
+                     auto res = set_of_features_to_activate.insert( f );
+                     if( res.second ) {
+                        protocol_features_to_activate.push_back( f );
+                     }
                   }
+                  features_to_activate.clear();
                }
-               features_to_activate.clear();
+               std::swap( features_to_activate, protocol_features_to_activate );
+               _protocol_features_signaled = true;
+               ilog( "signaling activation of the following protocol features in block ${num}: ${features_to_activate}",
+                     ("num", hbs->block_num + 1)("features_to_activate", features_to_activate) );
             }
-            std::swap( features_to_activate, protocol_features_to_activate );
-            _protocol_features_signaled = true;
-            ilog( "signaling activation of the following protocol features in block ${num}: ${features_to_activate}",
-                  ("num", hbs->block_num + 1)("features_to_activate", features_to_activate) );
          }
-      }
 
-      chain.start_block( block_time, blocks_to_confirm, features_to_activate );
+         chain.start_block( block_time, blocks_to_confirm, features_to_activate );
+
+         if( prebuilding ) {
+            // applied as a speculative block until the slot begins
+            _pending_block_mode = pending_block_mode::speculating;
+            _prebuilt_block = prebuilt_block{ hbs->id, block_time, blocks_to_confirm };
+         }
+      }
    } LOG_AND_DROP();
 
    if( chain.is_building_block() ) {
       const auto& pending_block_signing_authority = chain.pending_block_signing_authority();
-      const fc::time_point preprocess_deadline = calculate_block_deadline(block_time);
+      const fc::time_point preprocess_deadline = prebuilding ?
+            std::min( calculate_block_deadline(block_time), block_time - fc::microseconds( config::block_interval_us ) ) :
+            calculate_block_deadline(block_time);
 
       if (_pending_block_mode == pending_block_mode::producing && pending_block_signing_authority != scheduled_producer.authority) {
          elog("Unexpected block signing authority, reverting to speculative mode! [expected: \"${expected}\", actual: \"${actual\"", ("expected", scheduled_producer.authority)("actual", pending_block_signing_authority));
@@ -1626,17 +2073,22 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block() {
       }
 
       try {
-         if( !remove_expired_trxs( preprocess_deadline ) )
-            return start_block_result::exhausted;
-         if( !remove_expired_blacklisted_trxs( preprocess_deadline ) )
-            return start_block_result::exhausted;
-         if( !_subjective_billing.remove_expired( _log, chain.pending_block_time(), fc::time_point::now(), preprocess_deadline ) )
-            return start_block_result::exhausted;
+         // expired transactions left by the purge time limit are purged while idle
+         const fc::time_point purge_deadline = _expired_trx_purge_time.count() > 0 ?
+               std::min( preprocess_deadline, fc::time_point::now() + _expired_trx_purge_time ) : preprocess_deadline;
+         {
+            auto purge_span = _production_tracer.span( "purge_expired" );
+            if( !purge_expired_trxs( purge_deadline ) && preprocess_deadline <= fc::time_point::now() )
+               return start_block_result::exhausted;
+            if( !_subjective_billing.remove_expired( _log, chain.pending_block_time(), fc::time_point::now(), preprocess_deadline ) )
+               return start_block_result::exhausted;
+         }
 
          // limit execution of pending incoming to once per block
          size_t pending_incoming_process_limit = _unapplied_transactions.incoming_size();
 
-         if( !process_unapplied_trxs( preprocess_deadline ) )
+         // persisted transactions were applied when the block was pre-built
+         if( !process_unapplied_trxs( preprocess_deadline, reuse_prebuilt ) )
             return start_block_result::exhausted;
 
          if (_pending_block_mode == pending_block_mode::producing) {
@@ -1717,6 +2169,7 @@ bool producer_plugin_impl::remove_expired_trxs( const fc::time_point& deadline )
                ("m", num_expired_persistent+num_expired_other)("n", orig_count)
                ("persistent_expired", num_expired_persistent)("other_expired", num_expired_other) );
    }
+   _expired_trx_metrics.expired_unapplied += num_expired_persistent + num_expired_other;
 
    return !exhausted;
 }
@@ -1743,10 +2196,46 @@ bool producer_plugin_impl::remove_expired_blacklisted_trxs( const fc::time_point
 
       fc_dlog(_log, "Processed ${n} blacklisted transactions, Expired ${expired}",
               ("n", orig_count)("expired", num_expired));
+      _expired_trx_metrics.expired_blacklisted += num_expired;
    }
    return !exhausted;
 }
 
+bool producer_plugin_impl::purge_expired_trxs( const fc::time_point& deadline )
+{
+   const auto start = fc::time_point::now();
+   _expired_trx_metrics.expired_unapplied = 0;
+   _expired_trx_metrics.expired_blacklisted = 0;
+
+   bool exhausted = !remove_expired_trxs( deadline ) || !remove_expired_blacklisted_trxs( deadline );
+
+   _expired_trx_metrics.purge_time_us = ( fc::time_point::now() - start ).count();
+   _expired_trx_metrics.unapplied_queue_size = _unapplied_transactions.size();
+   _expired_trx_metrics.blacklist_size = _blacklisted_transactions.size();
+   _expired_trx_metrics.exhausted = exhausted;
+   if( exhausted ) schedule_idle_expired_trx_purge();
+   return !exhausted;
+}
+
+void producer_plugin_impl::schedule_idle_expired_trx_purge()
+{
+   if( _idle_expired_trx_purge_scheduled ) return;
+   _idle_expired_trx_purge_scheduled = true;
+
+   // lowest priority so it only runs when no blocks or transactions are waiting
+   main_thread_post( priority::lowest, [weak_this = weak_from_this()]() {
+      auto self = weak_this.lock();
+      if( !self ) return;
+      self->_idle_expired_trx_purge_scheduled = false;
+      chain::controller& chain = self->chain_plug->chain();
+      // clear_expired needs the pending block time, do not take time from a block being produced
+      if( !chain.is_building_block() || self->_pending_block_mode == pending_block_mode::producing ) return;
+      constexpr auto default_idle_purge_time = fc::milliseconds( 5 );
+      const auto purge_time = self->_expired_trx_purge_time.count() > 0 ? self->_expired_trx_purge_time : default_idle_purge_time;
+      self->purge_expired_trxs( fc::time_point::now() + purge_time );
+   } );
+}
+
 namespace {
 // track multiple failures on unapplied transactions
 class account_failures {
@@ -1833,8 +2322,9 @@ private:
 
 } // anonymous namespace
 
-bool producer_plugin_impl::process_unapplied_trxs( const fc::time_point& deadline )
+bool producer_plugin_impl::process_unapplied_trxs( const fc::time_point& deadline, bool skip_persisted )
 {
+   auto trace_span = _production_tracer.span( "process_unapplied_trxs" );
    bool exhausted = false;
    if( !_unapplied_transactions.empty() ) {
       account_failures account_fails;
@@ -1844,7 +2334,8 @@ bool producer_plugin_impl::process_unapplied_trxs( const fc::time_point& deadlin
       auto unapplied_trxs_size = _unapplied_transactions.size();
       // unapplied and persisted do not have a next method to call
       auto itr     = (_pending_block_mode == pending_block_mode::producing) ?
-                     _unapplied_transactions.unapplied_begin() : _unapplied_transactions.persisted_begin();
+                     ( skip_persisted ? _unapplied_transactions.persisted_end() : _unapplied_transactions.unapplied_begin() ) :
+                     _unapplied_transactions.persisted_begin();
       auto end_itr = (_pending_block_mode == pending_block_mode::producing) ?
                      _unapplied_transactions.unapplied_end()   : _unapplied_transactions.persisted_end();
       while( itr != end_itr ) {
@@ -1932,10 +2423,12 @@ bool producer_plugin_impl::process_unapplied_trxs( const fc::time_point& deadlin
 
 void producer_plugin_impl::process_scheduled_and_incoming_trxs( const fc::time_point& deadline, size_t& pending_incoming_process_limit )
 {
+   auto trace_span = _production_tracer.span( "process_scheduled_and_incoming_trxs" );
    // scheduled transactions
    int num_applied = 0;
    int num_failed = 0;
    int num_processed = 0;
+   int num_blacklisted = 0;
    bool exhausted = false;
    double incoming_trx_weight = 0.0;
 
@@ -1944,31 +2437,20 @@ void producer_plugin_impl::process_scheduled_and_incoming_trxs( const fc::time_p
    time_point pending_block_time = chain.pending_block_time();
    auto itr = _unapplied_transactions.incoming_begin();
    auto end = _unapplied_transactions.incoming_end();
-   const auto& sch_idx = chain.db().get_index<generated_transaction_multi_index,by_delay>();
-   const auto scheduled_trxs_size = sch_idx.size();
-   auto sch_itr = sch_idx.begin();
-   while( sch_itr != sch_idx.end() ) {
-      if( sch_itr->delay_until > pending_block_time) break;    // not scheduled yet
+   scheduled_transaction_queue sch_queue( chain.db(), pending_block_time );
+   while( auto sch = sch_queue.next() ) {
       if( exhausted || deadline <= fc::time_point::now() ) {
          exhausted = true;
          break;
       }
-      if( sch_itr->published >= pending_block_time ) {
-         ++sch_itr;
-         continue; // do not allow schedule and execute in same block
-      }
 
-      if (blacklist_by_id.find(sch_itr->trx_id) != blacklist_by_id.end()) {
-         ++sch_itr;
+      if (blacklist_by_id.find(sch->trx_id) != blacklist_by_id.end()) {
+         ++num_blacklisted;
          continue;
       }
 
-      const transaction_id_type trx_id = sch_itr->trx_id; // make copy since reference could be invalidated
-      const auto sch_expiration = sch_itr->expiration;
-      auto sch_itr_next = sch_itr; // save off next since sch_itr may be invalidated by loop
-      ++sch_itr_next;
-      const auto next_delay_until = sch_itr_next != sch_idx.end() ? sch_itr_next->delay_until : sch_itr->delay_until;
-      const auto next_id = sch_itr_next != sch_idx.end() ? sch_itr_next->id : sch_itr->id;
+      const transaction_id_type& trx_id = sch->trx_id;
+      const auto sch_expiration = sch->expiration;
 
       num_processed++;
 
@@ -2025,20 +2507,25 @@ void producer_plugin_impl::process_scheduled_and_incoming_trxs( const fc::time_p
 
       incoming_trx_weight += _incoming_defer_ratio;
       if (!pending_incoming_process_limit) incoming_trx_weight = 0.0;
-
-      if( sch_itr_next == sch_idx.end() ) break;
-      sch_itr = sch_idx.lower_bound( boost::make_tuple( next_delay_until, next_id ) );
    }
 
-   if( scheduled_trxs_size > 0 ) {
+   _scheduled_trx_metrics.processed = num_processed;
+   _scheduled_trx_metrics.applied = num_applied;
+   _scheduled_trx_metrics.failed = num_failed;
+   _scheduled_trx_metrics.blacklisted = num_blacklisted;
+   _scheduled_trx_metrics.published = sch_queue.num_published();
+   _scheduled_trx_metrics.exhausted = exhausted;
+
+   if( sch_queue.depth() > 0 ) {
       fc_dlog( _log,
                "Processed ${m} of ${n} scheduled transactions, Applied ${applied}, Failed/Dropped ${failed}",
-               ( "m", num_processed )( "n", scheduled_trxs_size )( "applied", num_applied )( "failed", num_failed ) );
+               ( "m", num_processed )( "n", sch_queue.depth() )( "applied", num_applied )( "failed", num_failed ) );
    }
 }
 
 bool producer_plugin_impl::process_incoming_trxs( const fc::time_point& deadline, size_t& pending_incoming_process_limit )
 {
+   auto trace_span = _production_tracer.span( "process_incoming_trxs" );
    bool exhausted = false;
    if( pending_incoming_process_limit ) {
       size_t processed = 0;
@@ -2112,6 +2599,9 @@ void producer_plugin_impl::schedule_production_loop() {
    } else if (result == start_block_result::waiting_for_production) {
       // scheduled in start_block()
 
+   } else if (_prebuilt_block && _pending_block_mode == pending_block_mode::speculating) {
+      fc_dlog(_log, "Pre-built Block Created; Production Change scheduled in start_block()");
+
    } else if (_pending_block_mode == pending_block_mode::producing) {
       schedule_maybe_produce_block( result == start_block_result::exhausted );
 
@@ -2248,7 +2738,9 @@ void block_only_sync::schedule() {
                 fc_dlog(_log, "Attempt to resync from block vault");
                 try {
                   impl->blockvault->sync(&id, *this);
+                  apply_received_blocks();
                 } catch( fc::exception& er ) {
+                   _received_blocks.clear();
                    fc_wlog(_log, "Attempting to resync from blockvault encountered ${details}; the node must restart to "
                         "continue!",
                         ("details", er.to_detail_string()));
@@ -2265,6 +2757,20 @@ void block_only_sync::on_snapshot(const char*) {
 }
 
 void block_only_sync::on_block(eosio::chain::signed_block_ptr block) {
+   _impl->chain_plug->chain().start_block_key_recovery(block->calculate_id(), block);
+   _received_blocks.push_back(std::move(block));
+   if (_received_blocks.size() > block_prefetch)
+      apply_received_block();
+}
+
+void block_only_sync::apply_received_blocks() {
+   while (!_received_blocks.empty())
+      apply_received_block();
+}
+
+void block_only_sync::apply_received_block() {
+   auto block = std::move(_received_blocks.front());
+   _received_blocks.pop_front();
    try {
       bool connectivity_check = false; // use false right now, should investigate further after 3.0 rc
       _impl->on_sync_block(block, connectivity_check);
@@ -2280,6 +2786,7 @@ void producer_plugin_impl::produce_block() {
    chain::controller& chain = chain_plug->chain();
    EOS_ASSERT(chain.is_building_block(), missing_pending_block_state, "pending_block_state does not exist but it should, another plugin may have corrupted it");
 
+   auto trace_span = _production_tracer.span( "produce_block" );
    const auto& auth = chain.pending_block_signing_authority();
    std::vector<std::reference_wrapper<const signature_provider_type>> relevant_providers;
 
@@ -2300,14 +2807,21 @@ void producer_plugin_impl::produce_block() {
    }
 
    //idump( (fc::time_point::now() - chain.pending_block_time()) );
+   auto finalize_span = _production_tracer.span( "finalize_block" );
    block_state_ptr pending_blk_state = chain.finalize_block( [&]( const digest_type& d ) {
       auto debug_logger = maybe_make_debug_time_logger();
-      vector<signature_type> sigs;
-      sigs.reserve(relevant_providers.size());
-
-      // sign with all relevant public keys
+      auto sign_span = _production_tracer.span( "sign_block" );
+      // sign with all relevant public keys, requests to keosd are all in flight before waiting on any of them
+      vector<std::future<signature_type>> pending_sigs;
+      pending_sigs.reserve(relevant_providers.size());
       for (const auto& p : relevant_providers) {
-         sigs.emplace_back(p.get()(d));
+         pending_sigs.emplace_back(p.get()(d));
+      }
+
+      vector<signature_type> sigs;
+      sigs.reserve(pending_sigs.size());
+      for (auto& f : pending_sigs) {
+         sigs.emplace_back(f.get());
       }
       return sigs;
    } );
@@ -2325,8 +2839,22 @@ void producer_plugin_impl::produce_block() {
 
    }
 
-   chain.commit_block();
+   finalize_span.end();
+
+   {
+      // accepted_block is signaled from commit_block, this includes the broadcast of the block by net_plugin
+      auto commit_span = _production_tracer.span( "commit_and_broadcast" );
+      chain.commit_block();
+   }
    block_state_ptr new_bs = chain.head_block_state();
+
+   if( _adaptive_last_block_time_offset ) {
+      const bool last_block = (new_bs->header.timestamp.slot % config::producer_repetitions) == config::producer_repetitions - 1;
+      const auto& next_producer = new_bs->get_scheduled_producer( new_bs->header.timestamp.next() ).producer_name;
+      if( last_block && _producers.find( next_producer ) == _producers.end() ) {
+         _pending_handoff.emplace( new_bs->block_num, new_bs->id );
+      }
+   }
    ilog("Produced block ${id}... #${n} @ ${t} signed by ${p} [trxs: ${count}, lib: ${lib}, confirmed: ${confs}]",
         ("p",new_bs->header.producer)("id",new_bs->id.str().substr(8,16))
         ("n",new_bs->block_num)("t",new_bs->header.timestamp)
@@ -0,0 +1,66 @@
+#define BOOST_TEST_MODULE production_tracer
+#include <boost/test/included/unit_test.hpp>
+
+#include <eosio/producer_plugin/production_tracer.hpp>
+
+namespace {
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE( production_tracer_test )
+
+BOOST_AUTO_TEST_CASE( tracer_test ) {
+
+   const auto t0 = fc::time_point::now();
+   const auto ms = []( int64_t n ) { return fc::milliseconds( n ); };
+
+   {  // disabled by default
+      production_tracer tracer;
+      BOOST_CHECK( !tracer.is_enabled() );
+      tracer.begin_block( 2 );
+      tracer.add_span( "start_block", t0, t0 + ms( 1 ) );
+      { auto s = tracer.span( "produce_block" ); }
+      BOOST_CHECK( tracer.get_trace().traceEvents.empty() );
+   }
+
+   {  // nested spans, idle gaps and ring buffer of blocks
+      production_tracer tracer;
+      tracer.set_max_blocks( 2 );
+      tracer.begin_block( 2 );
+      tracer.add_span( "start_block", t0, t0 + ms( 1 ) );
+      tracer.begin_block( 3 );
+      tracer.add_span( "process_unapplied_trxs", t0 + ms( 11 ), t0 + ms( 12 ) );
+      tracer.add_span( "start_block", t0 + ms( 10 ), t0 + ms( 15 ) );
+      tracer.begin_block( 3 ); // restarted block, same timeline
+      tracer.add_span( "produce_block", t0 + ms( 20 ), t0 + ms( 22 ) );
+      tracer.add_incoming_trx( fc::microseconds( 100 ) );
+      tracer.add_incoming_trx( fc::microseconds( 50 ) );
+      tracer.begin_block( 4 );
+      tracer.add_span( "start_block", t0 + ms( 30 ), t0 + ms( 31 ) );
+
+      const auto events = tracer.get_trace().traceEvents;
+      BOOST_REQUIRE_EQUAL( 6u, events.size() );
+      BOOST_CHECK_EQUAL( "start_block", events[0].name );
+      BOOST_CHECK_EQUAL( 3u, events[0].args["block_num"].as_uint64() );
+      BOOST_CHECK_EQUAL( ms( 5 ).count(), events[0].dur );
+      BOOST_CHECK_EQUAL( "process_unapplied_trxs", events[1].name );
+      BOOST_CHECK_EQUAL( "idle", events[2].name );
+      BOOST_CHECK_EQUAL( ( t0 + ms( 15 ) ).time_since_epoch().count(), events[2].ts );
+      BOOST_CHECK_EQUAL( ms( 5 ).count(), events[2].dur );
+      BOOST_CHECK_EQUAL( "produce_block", events[3].name );
+      BOOST_CHECK_EQUAL( "incoming_trxs", events[4].name );
+      BOOST_CHECK_EQUAL( "i", events[4].ph );
+      BOOST_CHECK_EQUAL( 2u, events[4].args["count"].as_uint64() );
+      BOOST_CHECK_EQUAL( 150, events[4].args["total_us"].as_int64() );
+      BOOST_CHECK_EQUAL( "start_block", events[5].name );
+      BOOST_CHECK_EQUAL( 4u, events[5].args["block_num"].as_uint64() );
+
+      tracer.set_max_blocks( 1 );
+      BOOST_CHECK_EQUAL( 1u, tracer.get_trace().traceEvents.size() );
+   }
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
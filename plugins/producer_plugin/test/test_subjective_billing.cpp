@@ -160,6 +160,90 @@ BOOST_AUTO_TEST_CASE( subjective_bill_test ) {
 
 }
 
+BOOST_AUTO_TEST_CASE( account_table_test ) {
+   account_table<uint64_t> t;
+   BOOST_CHECK( t.empty() );
+   BOOST_CHECK( t.find( "a"_n ) == nullptr );
+
+   constexpr uint64_t n = 1000;
+   for( uint64_t i = 1; i <= n; ++i ) {
+      t[name( i )] = i;
+   }
+   BOOST_CHECK_EQUAL( n, t.size() );
+   for( uint64_t i = 1; i <= n; ++i ) {
+      BOOST_REQUIRE( t.find( name( i ) ) );
+      BOOST_CHECK_EQUAL( i, *t.find( name( i ) ) );
+   }
+
+   // erase every other one, the rest must stay reachable
+   for( uint64_t i = 1; i <= n; i += 2 ) {
+      t.erase( name( i ) );
+   }
+   t.erase( name( n + 1 ) ); // not present
+   BOOST_CHECK_EQUAL( n / 2, t.size() );
+   for( uint64_t i = 1; i <= n; ++i ) {
+      if( i % 2 ) {
+         BOOST_CHECK( t.find( name( i ) ) == nullptr );
+      } else {
+         BOOST_REQUIRE( t.find( name( i ) ) );
+         BOOST_CHECK_EQUAL( i, *t.find( name( i ) ) );
+      }
+   }
+
+   // re-added entries start default constructed
+   BOOST_CHECK_EQUAL( 0u, t[name( 1 )] );
+   t.clear();
+   BOOST_CHECK( t.empty() );
+   BOOST_CHECK( t.find( name( 2 ) ) == nullptr );
+}
+
+BOOST_AUTO_TEST_CASE( subjective_bill_benchmark ) {
+   fc::logger log;
+   subjective_billing sub_bill;
+
+   constexpr uint32_t num_trxs = 200'000;
+   constexpr uint32_t num_accounts = 1'000;
+   std::vector<transaction_id_type> ids;
+   ids.reserve( num_trxs );
+   for( uint32_t i = 0; i < num_trxs; ++i ) {
+      ids.emplace_back( sha256::hash( std::to_string( i ) ) );
+   }
+
+   // trxs expire over an hour, a third of them come back in a block
+   const auto now = time_point::now();
+   auto start = time_point::now();
+   for( uint32_t i = 0; i < num_trxs; ++i ) {
+      sub_bill.subjective_bill( ids[i], now + fc::milliseconds( i * 18 ), name( i % num_accounts + 1 ), fc::microseconds( 100 ), false );
+   }
+   const auto bill_time = time_point::now() - start;
+
+   start = time_point::now();
+   uint64_t total = 0;
+   for( uint32_t i = 0; i < num_trxs; ++i ) {
+      total += sub_bill.get_subjective_bill( name( i % num_accounts + 1 ), now );
+   }
+   const auto get_time = time_point::now() - start;
+   BOOST_CHECK_EQUAL( uint64_t(num_trxs) * (num_trxs / num_accounts) * 100, total );
+
+   start = time_point::now();
+   for( uint32_t i = 0; i < num_trxs; i += 3 ) {
+      sub_bill.remove_subjective_billing( ids[i], 0 );
+   }
+   const auto remove_time = time_point::now() - start;
+
+   start = time_point::now();
+   for( uint32_t s = 0; s <= num_trxs * 18 / 1000; s += 3 ) {
+      sub_bill.remove_expired( log, now + fc::seconds( s ), now, fc::time_point::maximum() );
+   }
+   const auto expire_time = time_point::now() - start;
+
+   // everything expired into the decay, nothing pending
+   BOOST_CHECK_EQUAL( 0, sub_bill.get_subjective_bill( name( 1 ), now + fc::milliseconds( subjective_billing::expired_accumulator_average_window * subjective_billing::subjective_time_interval_ms ) ) );
+
+   BOOST_TEST_MESSAGE( "subjective billing of " << num_trxs << " trxs: bill " << bill_time.count() << "us, get " << get_time.count()
+                       << "us, remove " << remove_time.count() << "us, expire " << expire_time.count() << "us" );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
@@ -0,0 +1,77 @@
+#define BOOST_TEST_MODULE trx_failure_cache
+#include <boost/test/included/unit_test.hpp>
+
+#include <eosio/producer_plugin/trx_failure_cache.hpp>
+
+#include <eosio/testing/tester.hpp>
+
+namespace {
+
+using namespace eosio;
+using namespace eosio::chain;
+
+transaction make_trx( account_name contract, const std::string& data ) {
+   transaction trx;
+   trx.actions.emplace_back( vector<permission_level>{{"alice"_n, config::active_name}}, contract, "act"_n,
+                             bytes( data.begin(), data.end() ) );
+   return trx;
+}
+
+BOOST_AUTO_TEST_SUITE( trx_failure_cache_test )
+
+BOOST_AUTO_TEST_CASE( failure_cache_test ) {
+
+   const auto now = time_point::now();
+   const auto key1 = trx_failure_cache::key_for( make_trx( "contract"_n, "1" ) );
+   const auto key2 = trx_failure_cache::key_for( make_trx( "contract"_n, "2" ) );
+   const auto key3 = trx_failure_cache::key_for( make_trx( "other"_n, "1" ) );
+   BOOST_CHECK( key1 != key2 );
+   BOOST_CHECK( key1 != key3 );
+   BOOST_CHECK( key1 == trx_failure_cache::key_for( make_trx( "contract"_n, "1" ) ) );
+
+   const eosio_assert_message_exception assert_ex( FC_LOG_MESSAGE( error, "pool is drained" ) );
+   const tx_cpu_usage_exceeded cpu_ex( FC_LOG_MESSAGE( error, "cpu" ) );
+
+   {  // disabled by default
+      trx_failure_cache cache;
+      BOOST_CHECK( !cache.is_enabled() );
+      cache.add( key1, assert_ex, now );
+      BOOST_CHECK( !cache.find( key1, now ) );
+   }
+
+   {  // only contract asserts are cached, until the window expires
+      trx_failure_cache cache;
+      cache.set_window( fc::milliseconds( 500 ) );
+      cache.add( key1, assert_ex, now );
+      cache.add( key2, cpu_ex, now );
+      BOOST_CHECK_EQUAL( 1u, cache.size() );
+
+      auto e = cache.find( key1, now + fc::milliseconds( 499 ) );
+      BOOST_REQUIRE( e );
+      BOOST_CHECK_EQUAL( eosio_assert_message_exception::code_value, e->code() );
+      BOOST_CHECK( !cache.find( key2, now ) );
+      BOOST_CHECK( !cache.find( key3, now ) );
+      BOOST_CHECK( !cache.find( key1, now + fc::milliseconds( 500 ) ) );
+
+      cache.remove_expired( now + fc::milliseconds( 500 ) );
+      BOOST_CHECK_EQUAL( 0u, cache.size() );
+   }
+
+   {  // oldest entries are dropped when full
+      trx_failure_cache cache;
+      cache.set_window( fc::milliseconds( 500 ) );
+      cache.set_max_entries( 2 );
+      cache.add( key1, assert_ex, now );
+      cache.add( key2, assert_ex, now + fc::milliseconds( 1 ) );
+      cache.add( key3, assert_ex, now + fc::milliseconds( 2 ) );
+      BOOST_CHECK_EQUAL( 2u, cache.size() );
+      BOOST_CHECK( !cache.find( key1, now + fc::milliseconds( 2 ) ) );
+      BOOST_CHECK( cache.find( key2, now + fc::milliseconds( 2 ) ) );
+      BOOST_CHECK( cache.find( key3, now + fc::milliseconds( 2 ) ) );
+   }
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
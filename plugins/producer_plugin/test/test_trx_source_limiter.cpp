@@ -0,0 +1,93 @@
+#define BOOST_TEST_MODULE trx_source_limiter
+#include <boost/test/included/unit_test.hpp>
+
+#include <eosio/producer_plugin/trx_source_limiter.hpp>
+
+namespace {
+
+using namespace eosio;
+using next_t = std::function<void( const std::variant<fc::exception_ptr, int>& )>;
+
+BOOST_AUTO_TEST_SUITE( trx_source_limiter_test )
+
+BOOST_AUTO_TEST_CASE( max_pending_test ) {
+   trx_source_limiter limiter;
+   limiter.set_max_pending( 2 );
+   BOOST_CHECK( limiter.is_enabled() );
+   BOOST_CHECK( !limiter.shares_enabled() );
+
+   int called = 0;
+   next_t next = [&]( const auto& ) { ++called; };
+   auto n1 = limiter.admit( 7, next );
+   auto n2 = limiter.admit( 7, next );
+   BOOST_REQUIRE( n1 );
+   BOOST_REQUIRE( n2 );
+   BOOST_CHECK( !limiter.admit( 7, next ) );
+   BOOST_CHECK( limiter.admit( api_transaction_source, next ) ); // other sources are not affected
+
+   n1( 1 );
+   BOOST_CHECK_EQUAL( 1, called );
+   BOOST_CHECK( !limiter.admit( 7, next ) ); // still pending until destroyed
+   n1 = nullptr;
+   auto n3 = limiter.admit( 7, next );
+   BOOST_CHECK( n3 );
+   BOOST_CHECK( trx_source_limiter::source_of( n3 ) );
+   BOOST_CHECK( !trx_source_limiter::source_of( next ) );
+
+   auto metrics = limiter.get_metrics();
+   BOOST_REQUIRE_EQUAL( 2u, metrics.size() );
+   BOOST_CHECK_EQUAL( "api", metrics[0].source );
+   BOOST_CHECK_EQUAL( 0u, metrics[0].pending );
+   BOOST_CHECK_EQUAL( "p2p:7", metrics[1].source );
+   BOOST_CHECK_EQUAL( 2u, metrics[1].pending );
+   BOOST_CHECK_EQUAL( 2u, metrics[1].rejected );
+}
+
+BOOST_AUTO_TEST_CASE( share_test ) {
+   trx_source_limiter limiter;
+   limiter.set_block_budget( fc::milliseconds( 300 ) );
+   limiter.set_weights( 2, 1, 1 );
+
+   next_t next = []( const auto& ) {};
+   auto api = limiter.admit( api_transaction_source, next );
+   auto peer1 = limiter.admit( 1, next );
+   auto peer2 = limiter.admit( 2, next );
+   auto* api_src = trx_source_limiter::source_of( api );
+   auto* peer1_src = trx_source_limiter::source_of( peer1 );
+   auto* peer2_src = trx_source_limiter::source_of( peer2 );
+
+   // shares of 150ms, 75ms and 75ms
+   BOOST_CHECK( limiter.within_share( peer1_src, 10 ) );
+   limiter.executed( peer1_src, 10, fc::milliseconds( 74 ) );
+   BOOST_CHECK( limiter.within_share( peer1_src, 10 ) );
+   limiter.executed( peer1_src, 10, fc::milliseconds( 1 ) );
+   BOOST_CHECK( !limiter.within_share( peer1_src, 10 ) );
+   limiter.executed( api_src, 10, fc::milliseconds( 149 ) );
+   BOOST_CHECK( limiter.within_share( api_src, 10 ) );
+   BOOST_CHECK( limiter.within_share( peer2_src, 10 ) );
+
+   // idle sources do not take a share, 100ms with peer2 idle
+   peer2 = nullptr;
+   BOOST_CHECK( limiter.within_share( peer1_src, 10 ) );
+   limiter.executed( peer1_src, 10, fc::milliseconds( 25 ) );
+   BOOST_CHECK( !limiter.within_share( peer1_src, 10 ) );
+   api = nullptr;
+   BOOST_CHECK( limiter.within_share( peer1_src, 10 ) );
+
+   // usage is per block
+   limiter.executed( peer1_src, 10, fc::milliseconds( 200 ) );
+   BOOST_CHECK( !limiter.within_share( peer1_src, 10 ) );
+   BOOST_CHECK( limiter.within_share( peer1_src, 11 ) );
+
+   // idle peers are dropped, the api sources are kept
+   peer1 = nullptr;
+   limiter.start_block( 13 );
+   auto metrics = limiter.get_metrics();
+   BOOST_REQUIRE_EQUAL( 1u, metrics.size() );
+   BOOST_CHECK_EQUAL( "api", metrics[0].source );
+   BOOST_CHECK_EQUAL( 1u, metrics[0].executed );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
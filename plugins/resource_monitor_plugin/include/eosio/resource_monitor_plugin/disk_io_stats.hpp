@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+namespace eosio::resource_monitor {
+   // Cumulative i/o counters of a block device since boot, as in /proc/diskstats
+   struct disk_io_stats {
+      uint64_t reads {0};        // reads completed
+      uint64_t read_bytes {0};
+      uint64_t read_ms {0};      // time spent reading
+      uint64_t writes {0};       // writes completed
+      uint64_t write_bytes {0};
+      uint64_t write_ms {0};     // time spent writing
+      uint64_t busy_ms {0};      // time the device had i/o in progress
+   };
+}
@@ -5,10 +5,35 @@
 
 #include <appbase/application.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/resource_monitor_plugin/disk_io_stats.hpp>
+
+#include <fc/time.hpp>
+
+#include <deque>
+#include <mutex>
+#include <optional>
 
 namespace bfs = boost::filesystem;
 
 namespace eosio::resource_monitor {
+   // Space and i/o of a monitored file system, as of the last check
+   struct file_system_metrics {
+      std::string path;
+      uint64_t    capacity {0};
+      uint64_t    available {0};
+      uint64_t    shutdown_available {0};
+      double      growth_bytes_per_sec {0};   // rate available space decreased at over the forecast window
+      int64_t     seconds_to_threshold {-1};  // forecast time until available reaches shutdown_available, -1 if not decreasing
+      bool        has_io_stats {false};       // false when the device has no i/o counters, e.g. a network file system
+      double      reads_per_sec {0};
+      double      writes_per_sec {0};
+      double      read_bytes_per_sec {0};
+      double      write_bytes_per_sec {0};
+      double      read_latency_ms {0};        // average time of the reads completed since the last check
+      double      write_latency_ms {0};
+      double      utilization {0};            // fraction of the time since the last check the device was busy
+   };
+
    template<typename SpaceProvider>
    class file_space_handler {
    public:
@@ -40,9 +65,17 @@ namespace eosio::resource_monitor {
          warning_interval = new_warning_interval;
       }
 
-      bool is_threshold_exceeded() {
+      // A warning is issued when the file system is forecast to exceed the threshold within this time, 0 to disable
+      void set_forecast_warning_time(uint32_t new_forecast_warning_secs) {
+         forecast_warning_secs = new_forecast_warning_secs;
+      }
+
+      bool is_threshold_exceeded(fc::time_point now = fc::time_point::now()) {
+         bool exceeded = false;
          // Go over each monitored file system
          for (auto& fs: filesystems) {
+            update_io_metrics(fs, now);
+
             boost::system::error_code ec;
             auto info = space_provider.get_space(fs.path_name, ec);
             if ( ec ) {
@@ -56,21 +89,37 @@ namespace eosio::resource_monitor {
 
                continue;
             }
+            update_space_metrics(fs, info, now);
 
             if ( info.available < fs.shutdown_available ) {
                if (output_threshold_warning) {
                   wlog("Space usage warning: ${path}'s file system exceeded threshold ${threshold}%, available: ${available}, Capacity: ${capacity}, shutdown_available: ${shutdown_available}", ("path", fs.path_name.string()) ("threshold", shutdown_threshold) ("available", info.available) ("capacity", info.capacity) ("shutdown_available", fs.shutdown_available));
                }
-               return true;
+               exceeded = true;
             } else if ( info.available < fs.warning_available && output_threshold_warning ) {
                wlog("Space usage warning: ${path}'s file system approaching threshold. available: ${available}, warning_available: ${warning_available}", ("path", fs.path_name.string()) ("available", info.available) ("warning_available", fs.warning_available));
                if ( shutdown_on_exceeded) {
                   wlog("nodeos will shutdown when space usage exceeds threshold ${threshold}%", ("threshold", shutdown_threshold));
                }
+            } else if ( forecast_warning_secs > 0 && fs.metrics.seconds_to_threshold >= 0 &&
+                        fs.metrics.seconds_to_threshold < forecast_warning_secs && output_threshold_warning ) {
+               wlog("Space usage warning: ${path}'s file system is forecast to exceed threshold ${threshold}% in ${hours} hours, available: ${available}, decreasing by ${rate} bytes/s",
+                    ("path", fs.path_name.string()) ("threshold", shutdown_threshold) ("hours", fs.metrics.seconds_to_threshold / 3600.0) ("available", info.available) ("rate", fs.metrics.growth_bytes_per_sec));
             }
          }
 
-         return false;
+         std::lock_guard<std::mutex> g(metrics_mtx);
+         metrics.clear();
+         for (const auto& fs: filesystems) {
+            metrics.push_back(fs.metrics);
+         }
+         return exceeded;
+      }
+
+      // Thread safe
+      std::vector<file_system_metrics> get_metrics() const {
+         std::lock_guard<std::mutex> g(metrics_mtx);
+         return metrics;
       }
 
       void add_file_system(const bfs::path& path_name) {
@@ -107,7 +156,9 @@ namespace eosio::resource_monitor {
          auto warning_available = (100 - warning_threshold) * (info.capacity / 100);
 
          // Add to the list
-         filesystems.emplace_back(statbuf.st_dev, shutdown_available, path_name, warning_available);
+         auto& fs = filesystems.emplace_back(statbuf.st_dev, shutdown_available, path_name, warning_available);
+         fs.metrics.path = path_name.string();
+         fs.metrics.shutdown_available = shutdown_available;
          
          ilog("${path_name}'s file system monitored. shutdown_available: ${shutdown_available}, capacity: ${capacity}, threshold: ${threshold}", ("path_name", path_name.string()) ("shutdown_available", shutdown_available) ("capacity", info.capacity) ("threshold", shutdown_threshold) );
       }
@@ -136,6 +187,9 @@ namespace eosio::resource_monitor {
    }
 
    private:
+      static constexpr int64_t forecast_window_secs = 60 * 60;     // growth is measured over this time
+      static constexpr int64_t min_forecast_window_secs = 10 * 60; // no forecast until growth is measured over this time
+
       SpaceProvider space_provider;
 
       boost::asio::deadline_timer timer;
@@ -150,6 +204,9 @@ namespace eosio::resource_monitor {
          uintmax_t  shutdown_available {0}; // minimum number of available bytes the file system must maintain
          bfs::path  path_name;
          uintmax_t  warning_available {0};  // warning is issued when availabla number of bytese drops below warning_available
+         std::deque<std::pair<fc::time_point, uintmax_t>> space_samples; // available space over the forecast window
+         std::optional<std::pair<fc::time_point, disk_io_stats>> last_io_stats;
+         file_system_metrics metrics;
 
          filesystem_info(dev_t dev, uintmax_t available, const bfs::path& path, uintmax_t warning)
          : st_dev(dev),
@@ -167,6 +224,63 @@ namespace eosio::resource_monitor {
       uint32_t warning_interval {1};
       uint32_t warning_interval_counter {1};
       bool     output_threshold_warning {true};
+      uint32_t forecast_warning_secs {0};
+
+      mutable std::mutex               metrics_mtx;
+      std::vector<file_system_metrics> metrics;
+
+      void update_space_metrics(filesystem_info& fs, const bfs::space_info& info, fc::time_point now) {
+         fs.space_samples.emplace_back(now, info.available);
+         while (fs.space_samples.size() > 2 && now - fs.space_samples[1].first >= fc::seconds(forecast_window_secs)) {
+            fs.space_samples.pop_front();
+         }
+
+         auto& m = fs.metrics;
+         m.capacity = info.capacity;
+         m.available = info.available;
+         m.growth_bytes_per_sec = 0;
+         m.seconds_to_threshold = -1;
+
+         const auto& [first_time, first_available] = fs.space_samples.front();
+         const auto elapsed = now - first_time;
+         if (elapsed < fc::seconds(min_forecast_window_secs)) {
+            return;
+         }
+         m.growth_bytes_per_sec = (double(first_available) - double(info.available)) * 1'000'000 / elapsed.count();
+         if (info.available <= fs.shutdown_available) {
+            m.seconds_to_threshold = 0;
+         } else if (m.growth_bytes_per_sec > 0) {
+            m.seconds_to_threshold = static_cast<int64_t>((info.available - fs.shutdown_available) / m.growth_bytes_per_sec);
+         }
+      }
+
+      void update_io_metrics(filesystem_info& fs, fc::time_point now) {
+         auto& m = fs.metrics;
+         disk_io_stats stats;
+         m.has_io_stats = space_provider.get_io_stats(fs.st_dev, stats);
+         if (!m.has_io_stats) {
+            fs.last_io_stats.reset();
+            return;
+         }
+
+         const auto* last_stats = fs.last_io_stats ? &fs.last_io_stats->second : nullptr;
+         // counters are reset when the device is re-attached
+         if (last_stats && now > fs.last_io_stats->first && stats.reads >= last_stats->reads && stats.writes >= last_stats->writes &&
+             stats.busy_ms >= last_stats->busy_ms) {
+            const auto& last = *last_stats;
+            const double secs = (now - fs.last_io_stats->first).count() / 1'000'000.0;
+            const uint64_t reads = stats.reads - last.reads;
+            const uint64_t writes = stats.writes - last.writes;
+            m.reads_per_sec = reads / secs;
+            m.writes_per_sec = writes / secs;
+            m.read_bytes_per_sec = (stats.read_bytes - last.read_bytes) / secs;
+            m.write_bytes_per_sec = (stats.write_bytes - last.write_bytes) / secs;
+            m.read_latency_ms = reads ? double(stats.read_ms - last.read_ms) / reads : 0;
+            m.write_latency_ms = writes ? double(stats.write_ms - last.write_ms) / writes : 0;
+            m.utilization = std::min(1.0, (stats.busy_ms - last.busy_ms) / (secs * 1000));
+         }
+         fs.last_io_stats.emplace(now, stats);
+      }
 
       void update_warning_interval_counter() {
          if ( warning_interval_counter == warning_interval ) {
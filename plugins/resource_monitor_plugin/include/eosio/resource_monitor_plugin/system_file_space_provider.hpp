@@ -1,5 +1,7 @@
 #pragma once
 
+#include <eosio/resource_monitor_plugin/disk_io_stats.hpp>
+
 #include <sys/stat.h>
 #include <boost/filesystem.hpp>
 
@@ -17,5 +19,9 @@ namespace eosio::resource_monitor {
 
       // Wrapper for boost file system space
       bfs::space_info get_space(const bfs::path& p, boost::system::error_code& ec) const;
+
+      // Reads the i/o counters of device dev from /proc/diskstats,
+      // returns false when it has none (e.g. a network file system)
+      bool get_io_stats(dev_t dev, disk_io_stats& stats) const;
    };
 }
@@ -18,6 +18,7 @@
 #include <eosio/resource_monitor_plugin/resource_monitor_plugin.hpp>
 #include <eosio/resource_monitor_plugin/file_space_handler.hpp>
 #include <eosio/resource_monitor_plugin/system_file_space_provider.hpp>
+#include <eosio/http_plugin/http_plugin.hpp>
 
 #include <eosio/chain/exceptions.hpp>
 
@@ -54,6 +55,8 @@ public:
            "Used to indicate nodeos will not shutdown when threshold is exceeded." )
          ( "resource-monitor-warning-interval", bpo::value<uint32_t>()->default_value(def_monitor_warning_interval),
            "Number of resource monitor intervals between two consecutive warnings when the threshold is hit. Should be between 1 and 450" )
+         ( "resource-monitor-space-forecast-warning-hours", bpo::value<uint32_t>()->default_value(def_forecast_warning_hours),
+           "A warning is generated when the growth of used space over the last hour is forecast to exceed the threshold within this number of hours. 0 to disable" )
          ;
    }
    
@@ -87,6 +90,15 @@ public:
          "\"resource-monitor-warning-interval\" must be between ${warning_interval_min} and ${warning_interval_max}", ("warning_interval_min", warning_interval_min) ("warning_interval_max", warning_interval_max));
       space_handler.set_warning_interval(warning_interval);
       ilog("Warning interval set to ${warning_interval}", ("warning_interval", warning_interval));
+
+      auto forecast_warning_hours = options.at("resource-monitor-space-forecast-warning-hours").as<uint32_t>();
+      EOS_ASSERT(forecast_warning_hours <= forecast_warning_hours_max, chain::plugin_config_exception,
+         "\"resource-monitor-space-forecast-warning-hours\" must be at most ${forecast_warning_hours_max}", ("forecast_warning_hours_max", forecast_warning_hours_max));
+      space_handler.set_forecast_warning_time(forecast_warning_hours * 3600);
+
+      if (auto http = app().find_plugin<http_plugin>()) {
+         http->add_metrics_provider([this]() { return prometheus_metrics(); });
+      }
    }
    
    // Start main thread
@@ -134,7 +146,53 @@ public:
       directories_registered.push_back(path);
    }
 
+   /// space and i/o metrics of the monitored file systems in the Prometheus text format
+   std::string prometheus_metrics() const {
+      const auto metrics = space_handler.get_metrics();
+      std::string out;
+      auto write = [&](const char* name, const char* type, const char* help, auto value_of) {
+         out += std::string("# HELP ") + name + " " + help + "\n# TYPE " + name + " " + type + "\n";
+         for (const auto& m : metrics) {
+            if (auto value = value_of(m)) {
+               out += std::string(name) + "{path=\"" + escape_label(m.path) + "\"} " + *value + "\n";
+            }
+         }
+      };
+      auto to_string = [](auto v) { return std::optional<std::string>(std::to_string(v)); };
+      auto io = [&](double file_system_metrics::*field) {
+         return [to_string, field](const file_system_metrics& m) { return m.has_io_stats ? to_string(m.*field) : std::nullopt; };
+      };
+
+      write("nodeos_resource_monitor_capacity_bytes", "gauge", "Capacity of the file system of a monitored directory",
+            [&](const auto& m) { return to_string(m.capacity); });
+      write("nodeos_resource_monitor_available_bytes", "gauge", "Space available on the file system of a monitored directory",
+            [&](const auto& m) { return to_string(m.available); });
+      write("nodeos_resource_monitor_shutdown_available_bytes", "gauge", "Available space below which the space threshold is exceeded",
+            [&](const auto& m) { return to_string(m.shutdown_available); });
+      write("nodeos_resource_monitor_used_growth_bytes_per_second", "gauge", "Growth of the used space over the last hour",
+            [&](const auto& m) { return to_string(m.growth_bytes_per_sec); });
+      write("nodeos_resource_monitor_seconds_to_threshold", "gauge", "Forecast time until the space threshold is exceeded, absent when used space is not growing",
+            [&](const auto& m) { return m.seconds_to_threshold >= 0 ? to_string(m.seconds_to_threshold) : std::nullopt; });
+      write("nodeos_resource_monitor_reads_per_second", "gauge", "Reads completed by the device of the file system", io(&file_system_metrics::reads_per_sec));
+      write("nodeos_resource_monitor_writes_per_second", "gauge", "Writes completed by the device of the file system", io(&file_system_metrics::writes_per_sec));
+      write("nodeos_resource_monitor_read_bytes_per_second", "gauge", "Bytes read by the device of the file system", io(&file_system_metrics::read_bytes_per_sec));
+      write("nodeos_resource_monitor_write_bytes_per_second", "gauge", "Bytes written by the device of the file system", io(&file_system_metrics::write_bytes_per_sec));
+      write("nodeos_resource_monitor_read_latency_milliseconds", "gauge", "Average time of the reads of the device of the file system", io(&file_system_metrics::read_latency_ms));
+      write("nodeos_resource_monitor_write_latency_milliseconds", "gauge", "Average time of the writes of the device of the file system", io(&file_system_metrics::write_latency_ms));
+      write("nodeos_resource_monitor_utilization_ratio", "gauge", "Fraction of the time the device of the file system was busy", io(&file_system_metrics::utilization));
+      return out;
+   }
+
 private:
+   static std::string escape_label(const std::string& value) {
+      std::string r;
+      for (char c : value) {
+         if (c == '\\' || c == '"') r += '\\';
+         r += c;
+      }
+      return r;
+   }
+
    std::thread               monitor_thread;
    std::vector<bfs::path>    directories_registered;
    
@@ -151,6 +209,9 @@ private:
    static constexpr uint32_t warning_interval_min = 1;
    static constexpr uint32_t warning_interval_max = 450; // e.g. if the monitor interval is 2 sec, the warning interval is at most 15 minutes
 
+   static constexpr uint32_t def_forecast_warning_hours = 6; // warn when the threshold is forecast to be exceeded within this time
+   static constexpr uint32_t forecast_warning_hours_max = 24 * 30;
+
    boost::asio::io_context   ctx;
 
    using file_space_handler_t = file_space_handler<system_file_space_provider>;
@@ -1,5 +1,11 @@
 #include <eosio/resource_monitor_plugin/system_file_space_provider.hpp>
 
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <sys/sysmacros.h>
+
 namespace bfs = boost::filesystem;
 
 namespace eosio::resource_monitor {
@@ -11,5 +17,37 @@ namespace eosio::resource_monitor {
       return bfs::space(p, ec);
    }
 
+   bool system_file_space_provider::get_io_stats(dev_t dev, disk_io_stats& stats) const {
+      static constexpr uint64_t sector_size = 512; // /proc/diskstats counts 512 bytes sectors regardless of the device
+
+      std::ifstream diskstats("/proc/diskstats");
+      std::string   line;
+      while (std::getline(diskstats, line)) {
+         std::istringstream ss(line);
+         unsigned int dev_major = 0, dev_minor = 0;
+         std::string  name;
+         uint64_t     reads = 0, reads_merged = 0, sectors_read = 0, read_ms = 0;
+         uint64_t     writes = 0, writes_merged = 0, sectors_written = 0, write_ms = 0;
+         uint64_t     in_progress = 0, busy_ms = 0;
+         if (!(ss >> dev_major >> dev_minor >> name >> reads >> reads_merged >> sectors_read >> read_ms
+                  >> writes >> writes_merged >> sectors_written >> write_ms >> in_progress >> busy_ms)) {
+            continue;
+         }
+         if (dev_major != major(dev) || dev_minor != minor(dev)) {
+            continue;
+         }
+
+         stats.reads       = reads;
+         stats.read_bytes  = sectors_read * sector_size;
+         stats.read_ms     = read_ms;
+         stats.writes      = writes;
+         stats.write_bytes = sectors_written * sector_size;
+         stats.write_ms    = write_ms;
+         stats.busy_ms     = busy_ms;
+         return true;
+      }
+      return false;
+   }
+
    using bfs::directory_iterator;
 }
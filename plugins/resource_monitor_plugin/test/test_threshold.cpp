@@ -23,6 +23,10 @@ struct threshold_fixture {
          return fixture.mock_get_space(p, ec);
       }
 
+      bool get_io_stats(dev_t, disk_io_stats&) const {
+         return false;
+      }
+
       threshold_fixture& fixture;
    };
 
@@ -298,4 +302,49 @@ BOOST_AUTO_TEST_SUITE(threshol_tests)
       BOOST_TEST(expected_response == actual_response_5);
    }
 
+   BOOST_FIXTURE_TEST_CASE(forecast_time_to_threshold, threshold_fixture)
+   {
+      uintmax_t available = 500000;
+      mock_get_space = [&available]( const bfs::path& p, boost::system::error_code& ec) -> bfs::space_info {
+         ec = boost::system::errc::make_error_code(errc::success);
+
+         bfs::space_info rc;
+         rc.capacity  = 1000000;
+         rc.available = available;
+
+         return rc;
+      };
+
+      mock_get_stat = []( const char *path, struct stat *buf ) -> int {
+         buf->st_dev = 0;
+         return 0;
+      };
+
+      set_threshold(80, 75);
+      add_file_system("/test");
+
+      const auto start = fc::time_point::now();
+      BOOST_TEST( !space_handler.is_threshold_exceeded(start) );
+
+      // not forecast until growth is measured over some time
+      available -= 1000;
+      BOOST_TEST( !space_handler.is_threshold_exceeded(start + fc::minutes(1)) );
+      BOOST_TEST( space_handler.get_metrics().at(0).seconds_to_threshold == -1 );
+
+      // 12000 bytes in 20 minutes, 288000 bytes left before the 200000 bytes shutdown_available
+      available = 488000;
+      BOOST_TEST( !space_handler.is_threshold_exceeded(start + fc::minutes(20)) );
+      auto metrics = space_handler.get_metrics().at(0);
+      BOOST_TEST( metrics.available == 488000u );
+      BOOST_TEST( metrics.shutdown_available == 200000u );
+      BOOST_TEST( metrics.growth_bytes_per_sec == 10.0 );
+      BOOST_TEST( metrics.seconds_to_threshold == 8 * 60 * 60 );
+      BOOST_TEST( !metrics.has_io_stats );
+
+      // space freed, no longer decreasing
+      available = 600000;
+      BOOST_TEST( !space_handler.is_threshold_exceeded(start + fc::minutes(30)) );
+      BOOST_TEST( space_handler.get_metrics().at(0).seconds_to_threshold == -1 );
+   }
+
 BOOST_AUTO_TEST_SUITE_END()
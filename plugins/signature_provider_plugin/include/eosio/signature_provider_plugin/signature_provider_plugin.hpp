@@ -3,6 +3,8 @@
 #include <eosio/http_client_plugin/http_client_plugin.hpp>
 #include <eosio/chain/types.hpp>
 
+#include <future>
+
 namespace eosio {
 
 using namespace appbase;
@@ -17,15 +19,20 @@ public:
 
    void plugin_initialize(const variables_map& options);
    void plugin_startup() {}
-   void plugin_shutdown() {}
+   void plugin_shutdown();
 
    const char* const signature_provider_help_text() const;
 
    using signature_provider_type = std::function<chain::signature_type(chain::digest_type)>;
+   /// returns without waiting on the signer, KEOSD requests are sent over a pool of persistent connections
+   using async_signature_provider_type = std::function<std::future<chain::signature_type>(chain::digest_type)>;
 
    std::pair<chain::public_key_type,signature_provider_type> signature_provider_for_specification(const std::string& spec) const;
    signature_provider_type signature_provider_for_private_key(const chain::private_key_type priv) const;
 
+   std::pair<chain::public_key_type,async_signature_provider_type> async_signature_provider_for_specification(const std::string& spec) const;
+   async_signature_provider_type async_signature_provider_for_private_key(const chain::private_key_type priv) const;
+
 private:
    std::unique_ptr<class signature_provider_plugin_impl> my;
 };
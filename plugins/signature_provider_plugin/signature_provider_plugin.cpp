@@ -1,11 +1,14 @@
 #include <eosio/signature_provider_plugin/signature_provider_plugin.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/thread_utils.hpp>
 
 #include <fc/time.hpp>
 #include <fc/network/url.hpp>
 
 #include <boost/algorithm/string.hpp>
 
+#include <mutex>
+
 #ifdef __APPLE__
 #include <eosio/se-helpers/se-helpers.hpp>
 #endif
@@ -15,17 +18,32 @@ namespace eosio {
 
 class signature_provider_plugin_impl {
    public:
+      using async_signature_provider_type = signature_provider_plugin::async_signature_provider_type;
+
       fc::microseconds  _keosd_provider_timeout_us;
+      uint16_t          _keosd_provider_connections = 0;
+
+      // keosd requests run on their own threads so they never block the caller. Each request takes an idle client,
+      // whose connection to keosd is kept open for the next request instead of being set up again.
+      std::mutex                                   _keosd_mtx;
+      std::optional<chain::named_thread_pool>      _keosd_thread_pool;
+      std::vector<std::unique_ptr<http_client>>    _keosd_idle_clients;
+
+      static std::future<chain::signature_type> ready(const chain::signature_type& sig) {
+         std::promise<chain::signature_type> p;
+         p.set_value(sig);
+         return p.get_future();
+      }
 
-      signature_provider_plugin::signature_provider_type
+      async_signature_provider_type
       make_key_signature_provider(const chain::private_key_type& key) const {
          return [key]( const chain::digest_type& digest ) {
-            return key.sign(digest);
+            return ready(key.sign(digest));
          };
       }
 
 #ifdef __APPLE__
-      signature_provider_plugin::signature_provider_type
+      async_signature_provider_type
       make_se_signature_provider(const chain::public_key_type pubkey) const {
          EOS_ASSERT(secure_enclave::hardware_supports_secure_enclave(), chain::secure_enclave_exception, "Secure Enclave not supported on this hardware");
          EOS_ASSERT(secure_enclave::application_signed(), chain::secure_enclave_exception, "Application is not signed, Secure Enclave use not supported");
@@ -34,15 +52,29 @@ class signature_provider_plugin_impl {
          for(const auto& se_key : secure_enclave::get_all_keys())
             if(se_key.public_key() == pubkey)
                return [se_key](const chain::digest_type& digest) {
-                  return se_key.sign(digest);
+                  return ready(se_key.sign(digest));
                };
 
          EOS_THROW(chain::secure_enclave_exception, "${k} not found in Secure Enclave", ("k", pubkey));
       }
 #endif
 
-      signature_provider_plugin::signature_provider_type
-      make_keosd_signature_provider(const string& url_str, const chain::public_key_type pubkey) const {
+      std::unique_ptr<http_client> take_keosd_client() {
+         std::lock_guard<std::mutex> g(_keosd_mtx);
+         if(_keosd_idle_clients.empty())
+            return app().get_plugin<http_client_plugin>().make_client();
+         auto client = std::move(_keosd_idle_clients.back());
+         _keosd_idle_clients.pop_back();
+         return client;
+      }
+
+      void return_keosd_client(std::unique_ptr<http_client> client) {
+         std::lock_guard<std::mutex> g(_keosd_mtx);
+         _keosd_idle_clients.push_back(std::move(client));
+      }
+
+      async_signature_provider_type
+      make_keosd_signature_provider(const string& url_str, const chain::public_key_type pubkey) {
          fc::url keosd_url;
          if(boost::algorithm::starts_with(url_str, "unix://"))
             //send the entire string after unix:// to http_plugin. It'll auto-detect which part
@@ -51,11 +83,39 @@ class signature_provider_plugin_impl {
          else
             keosd_url = fc::url(url_str);
 
-         return [to=_keosd_provider_timeout_us, keosd_url, pubkey](const chain::digest_type& digest) {
-            fc::variant params;
-            fc::to_variant(std::make_pair(digest, pubkey), params);
+         {
+            std::lock_guard<std::mutex> g(_keosd_mtx);
+            if(!_keosd_thread_pool) {
+               _keosd_thread_pool.emplace("keosd", _keosd_provider_connections);
+               for(uint16_t i = 0; i < _keosd_provider_connections; ++i)
+                  _keosd_idle_clients.push_back(app().get_plugin<http_client_plugin>().make_client());
+            }
+         }
+
+         return [this, to=_keosd_provider_timeout_us, keosd_url, pubkey](const chain::digest_type& digest) {
+            // the timeout includes the time the request waits for a connection
             auto deadline = to.count() >= 0 ? fc::time_point::now() + to : fc::time_point::maximum();
-            return app().get_plugin<http_client_plugin>().get_client().post_sync(keosd_url, params, deadline).as<chain::signature_type>();
+            return chain::async_thread_pool(_keosd_thread_pool->get_executor(), [this, deadline, keosd_url, pubkey, digest]() {
+               fc::variant params;
+               fc::to_variant(std::make_pair(digest, pubkey), params);
+               auto client = take_keosd_client();
+               try {
+                  auto sig = client->post_sync(keosd_url, params, deadline).as<chain::signature_type>();
+                  return_keosd_client(std::move(client));
+                  return sig;
+               } catch(...) {
+                  // the connection may be left in any state, start over with a new one
+                  return_keosd_client(app().get_plugin<http_client_plugin>().make_client());
+                  throw;
+               }
+            });
+         };
+      }
+
+      static signature_provider_plugin::signature_provider_type
+      make_sync(async_signature_provider_type provider) {
+         return [provider{std::move(provider)}](const chain::digest_type& digest) {
+            return provider(digest).get();
          };
       }
 };
@@ -67,6 +127,8 @@ void signature_provider_plugin::set_program_options(options_description&, option
    cfg.add_options()
          ("keosd-provider-timeout", boost::program_options::value<int32_t>()->default_value(5),
           "Limits the maximum time (in milliseconds) that is allowed for sending requests to a keosd provider for signing")
+         ("keosd-provider-connections", boost::program_options::value<uint16_t>()->default_value(2),
+          "Number of connections kept open to keosd providers, and of signing requests sent to them at the same time")
          ;
 }
 
@@ -87,10 +149,29 @@ const char* const signature_provider_plugin::signature_provider_help_text() cons
 
 void signature_provider_plugin::plugin_initialize(const variables_map& options) {
    my->_keosd_provider_timeout_us = fc::milliseconds( options.at("keosd-provider-timeout").as<int32_t>() );
+   my->_keosd_provider_connections = options.at("keosd-provider-connections").as<uint16_t>();
+   EOS_ASSERT( my->_keosd_provider_connections > 0, chain::plugin_config_exception,
+               "keosd-provider-connections ${num} must be greater than 0", ("num", my->_keosd_provider_connections) );
+}
+
+void signature_provider_plugin::plugin_shutdown() {
+   if( my->_keosd_thread_pool )
+      my->_keosd_thread_pool->stop();
 }
 
 std::pair<chain::public_key_type,signature_provider_plugin::signature_provider_type>
 signature_provider_plugin::signature_provider_for_specification(const std::string& spec) const {
+   auto [pubkey, provider] = async_signature_provider_for_specification(spec);
+   return std::make_pair(pubkey, signature_provider_plugin_impl::make_sync(std::move(provider)));
+}
+
+signature_provider_plugin::signature_provider_type
+signature_provider_plugin::signature_provider_for_private_key(const chain::private_key_type priv) const {
+   return signature_provider_plugin_impl::make_sync(my->make_key_signature_provider(priv));
+}
+
+std::pair<chain::public_key_type,signature_provider_plugin::async_signature_provider_type>
+signature_provider_plugin::async_signature_provider_for_specification(const std::string& spec) const {
    auto delim = spec.find("=");
    EOS_ASSERT(delim != std::string::npos, chain::plugin_config_exception, "Missing \"=\" in the key spec pair");
    auto pub_key_str = spec.substr(0, delim);
@@ -117,8 +198,8 @@ signature_provider_plugin::signature_provider_for_specification(const std::strin
    EOS_THROW(chain::plugin_config_exception, "Unsupported key provider type \"${t}\"", ("t", spec_type_str));
 }
 
-signature_provider_plugin::signature_provider_type
-signature_provider_plugin::signature_provider_for_private_key(const chain::private_key_type priv) const {
+signature_provider_plugin::async_signature_provider_type
+signature_provider_plugin::async_signature_provider_for_private_key(const chain::private_key_type priv) const {
    return my->make_key_signature_provider(priv);
 }
 
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <eosio/state_history_plugin/state_history_plugin.hpp>
+#include <eosio/http_plugin/http_plugin.hpp>
+
+#include <appbase/application.hpp>
+
+namespace eosio {
+
+using namespace appbase;
+
+class state_history_api_plugin : public plugin<state_history_api_plugin> {
+public:
+   APPBASE_PLUGIN_REQUIRES((state_history_plugin) (http_plugin))
+
+   state_history_api_plugin() = default;
+   state_history_api_plugin(const state_history_api_plugin&) = delete;
+   state_history_api_plugin(state_history_api_plugin&&) = delete;
+   state_history_api_plugin& operator=(const state_history_api_plugin&) = delete;
+   state_history_api_plugin& operator=(state_history_api_plugin&&) = delete;
+   virtual ~state_history_api_plugin() override = default;
+
+   virtual void set_program_options(options_description& cli, options_description& cfg) override {}
+   void plugin_initialize(const variables_map& vm);
+   void plugin_startup();
+   void plugin_shutdown() {}
+};
+
+}
@@ -0,0 +1,59 @@
+#include <eosio/state_history_api_plugin/state_history_api_plugin.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <fc/variant.hpp>
+#include <fc/io/json.hpp>
+
+namespace eosio {
+
+static appbase::abstract_plugin& _state_history_api_plugin = app().register_plugin<state_history_api_plugin>();
+
+using namespace eosio;
+
+#define CALL_WITH_400(api_name, api_handle, call_name, INVOKE, http_response_code) \
+{std::string("/v1/" #api_name "/" #call_name), \
+   [&api_handle](string, string body, url_response_callback cb) mutable { \
+          try { \
+             INVOKE \
+             cb(http_response_code, fc::variant(result)); \
+          } catch (...) { \
+             http_plugin::handle_exception(#api_name, #call_name, body, cb); \
+          } \
+       }}
+
+#define INVOKE_R_V(api_handle, call_name) \
+     body = parse_params<std::string, http_params_types::no_params_required>(body); \
+     auto result = api_handle.call_name();
+
+
+void state_history_api_plugin::plugin_startup() {
+   ilog("starting state_history_api_plugin");
+   // lifetime of plugin is lifetime of application
+   auto& state_history = app().get_plugin<state_history_plugin>();
+   app().get_plugin<http_plugin>().add_api({
+       CALL_WITH_400(state_history, state_history, get_sessions,
+            INVOKE_R_V(state_history, get_sessions), 200),
+   }, appbase::priority::medium_high);
+}
+
+void state_history_api_plugin::plugin_initialize(const variables_map& options) {
+   try {
+      const auto& _http_plugin = app().get_plugin<http_plugin>();
+      if( !_http_plugin.is_on_loopback()) {
+         wlog( "\n"
+               "**********SECURITY WARNING**********\n"
+               "*                                  *\n"
+               "* --    State History API       -- *\n"
+               "* - EXPOSED to the LOCAL NETWORK - *\n"
+               "* - USE ONLY ON SECURE NETWORKS! - *\n"
+               "*                                  *\n"
+               "************************************\n" );
+      }
+   } FC_LOG_AND_RETHROW()
+}
+
+
+#undef INVOKE_R_V
+#undef CALL_WITH_400
+
+}
@@ -14,6 +14,33 @@ using std::shared_ptr;
 
 typedef shared_ptr<struct state_history_plugin_impl> state_history_ptr;
 
+/// a state history connection
+struct state_history_session_stats {
+   string                  remote_endpoint;
+   fc::time_point          connected;
+   std::optional<uint32_t> current_block;           ///< next block of the get_blocks_request, none without one
+   uint32_t                last_sent_block = 0;     ///< 0 when none was sent
+   uint32_t                lag = 0;                 ///< blocks from last_sent_block to head
+   uint64_t                bytes_sent = 0;
+   uint64_t                messages_sent = 0;
+   uint32_t                queued_messages = 0;     ///< waiting to be sent, including the one being written
+   uint64_t                queued_bytes = 0;
+   uint64_t                log_read_us = 0;         ///< reading and decompressing traces and deltas from the logs
+   uint64_t                serialize_us = 0;        ///< filtering and packing results
+   uint64_t                main_thread_us = 0;      ///< looking up blocks which are not in the logs
+   uint64_t                throttled = 0;           ///< times the session waited for the queues to drain
+};
+
+struct state_history_sessions_result {
+   uint32_t                                 head_block_num = 0;
+   uint64_t                                 queued_bytes = 0;         ///< over all sessions
+   uint64_t                                 max_queued_bytes = 0;     ///< 0 when unlimited
+   uint64_t                                 max_session_queued_bytes = 0;
+   uint64_t                                 disconnected_sessions = 0; ///< for exceeding max_session_queued_bytes
+   uint64_t                                 main_thread_us = 0;       ///< writing the logs of accepted blocks
+   std::vector<state_history_session_stats> sessions;
+};
+
 class state_history_plugin : public plugin<state_history_plugin> {
  public:
    APPBASE_PLUGIN_REQUIRES((chain_plugin))
@@ -29,8 +56,16 @@ class state_history_plugin : public plugin<state_history_plugin> {
 
    void handle_sighup() override;
 
+   /// may be called from any thread
+   state_history_sessions_result get_sessions() const;
+
  private:
    state_history_ptr my;
 };
 
 } // namespace eosio
+
+FC_REFLECT(eosio::state_history_session_stats, (remote_endpoint)(connected)(current_block)(last_sent_block)(lag)
+           (bytes_sent)(messages_sent)(queued_messages)(queued_bytes)(log_read_us)(serialize_us)(main_thread_us)(throttled))
+FC_REFLECT(eosio::state_history_sessions_result, (head_block_num)(queued_bytes)(max_queued_bytes)
+           (max_session_queued_bytes)(disconnected_sessions)(main_thread_us)(sessions))
@@ -1,5 +1,8 @@
 #include <eosio/chain/config.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <eosio/resource_monitor_plugin/resource_monitor_plugin.hpp>
+#include <eosio/http_plugin/main_thread_queue.hpp>
+#include <eosio/state_history/filter.hpp>
 #include <eosio/state_history/log.hpp>
 #include <eosio/state_history/serialization.hpp>
 #include <eosio/state_history_plugin/state_history_plugin.hpp>
@@ -9,11 +12,15 @@
 #include <boost/asio/bind_executor.hpp>
 #include <boost/asio/ip/host_name.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/signals2/connection.hpp>
 
+#include <atomic>
+#include <mutex>
+
 using tcp    = boost::asio::ip::tcp;
 namespace ws = boost::beast::websocket;
 
@@ -43,18 +50,112 @@ auto catch_and_log(F f) {
 }
 
 struct state_history_plugin_impl : std::enable_shared_from_this<state_history_plugin_impl> {
+   /// chain state the sessions need, published by the main thread on each accepted block
+   struct chain_snapshot {
+      block_state_ptr head;
+      block_position  last_irreversible;
+   };
+
+   /// what a get_blocks_result needs beyond the logs
+   struct block_lookup {
+      std::optional<block_id_type> id;
+      std::optional<block_id_type> prev_id;
+      signed_block_ptr             block;
+   };
+
+   /**
+    * The traces and deltas of the blocks near head, read from the logs once for all the sessions which stream them.
+    * Sessions catching up on older blocks read the logs directly, so that they do not evict the recent blocks.
+    */
+   class recent_blocks {
+    public:
+      using entry_ptr = std::shared_ptr<const bytes>;
+
+      void resize(uint32_t size) { slots.resize(size); }
+
+      template <typename Read>
+      entry_ptr get_traces(uint32_t block_num, const block_id_type& id, uint32_t head_block_num, Read read) {
+         return get(&slot::traces, block_num, id, head_block_num, std::move(read));
+      }
+
+      template <typename Read>
+      entry_ptr get_deltas(uint32_t block_num, const block_id_type& id, uint32_t head_block_num, Read read) {
+         return get(&slot::deltas, block_num, id, head_block_num, std::move(read));
+      }
+
+    private:
+      struct slot {
+         uint32_t      block_num = 0;
+         block_id_type id;
+         entry_ptr     traces;
+         entry_ptr     deltas;
+      };
+
+      template <typename Read>
+      entry_ptr get(entry_ptr slot::*member, uint32_t block_num, const block_id_type& id, uint32_t head_block_num,
+                    Read read) {
+         if (slots.empty() || block_num + slots.size() <= head_block_num)
+            return std::make_shared<const bytes>(read());
+         auto& s = slots[block_num % slots.size()];
+         {
+            std::lock_guard<std::mutex> g(mtx);
+            if (s.block_num == block_num && s.id == id && s.*member)
+               return s.*member;
+         }
+         // several sessions may read the same entry at once, they then all keep the first one stored
+         auto entry = std::make_shared<const bytes>(read());
+         std::lock_guard<std::mutex> g(mtx);
+         if (s.block_num != block_num || s.id != id)
+            s = slot{block_num, id};
+         if (!(s.*member))
+            s.*member = std::move(entry);
+         return s.*member;
+      }
+
+      std::mutex        mtx;
+      std::vector<slot> slots; ///< indexed by block number modulo their count
+   };
+
    chain_plugin*                                              chain_plug = nullptr;
    std::optional<state_history_traces_log>                    trace_log;
    std::optional<state_history_chain_state_log>               chain_state_log;
-   bool                                                       stopping = false;
+   std::atomic<bool>                                          stopping = false;
    std::optional<scoped_connection>                           applied_transaction_connection;
    std::optional<scoped_connection>                           block_start_connection;
    std::optional<scoped_connection>                           accepted_block_connection;
    string                                                     endpoint_address = "0.0.0.0";
    uint16_t                                                   endpoint_port    = 8080;
+   uint16_t                                                   thread_pool_size = 1;
+   std::optional<named_thread_pool>                           thread_pool;
    std::unique_ptr<tcp::acceptor>                             acceptor;
+   std::optional<chain_id_type>                               chain_id;
+   std::mutex                                                 snapshot_mtx;
+   chain_snapshot                                             snapshot;
+   recent_blocks                                              recent;
+   std::atomic<uint64_t>                                      queued_bytes = 0; ///< results waiting to be sent, over all sessions
+   uint64_t                                                   max_queued_bytes = 0;
+   uint64_t                                                   max_session_queued_bytes = 0;
+   std::atomic<uint64_t>                                      disconnected_sessions = 0;
+   std::atomic<uint64_t>                                      main_thread_us = 0; ///< storing accepted blocks and traces
+
+   /// how long a session waits before checking again whether the queues drained below max_queued_bytes
+   static constexpr auto throttle_interval = std::chrono::milliseconds(20);
+
+   bool queues_full() const { return max_queued_bytes && queued_bytes.load() > max_queued_bytes; }
+
+   chain_snapshot get_snapshot() {
+      std::lock_guard<std::mutex> g(snapshot_mtx);
+      return snapshot;
+   }
 
-   std::optional<chain::block_id_type> get_block_id(uint32_t block_num) {
+   // main thread only
+   void publish_snapshot(const block_state_ptr& head) {
+      auto& chain = chain_plug->chain();
+      std::lock_guard<std::mutex> g(snapshot_mtx);
+      snapshot = {head, {chain.last_irreversible_block_num(), chain.last_irreversible_block_id()}};
+   }
+
+   std::optional<chain::block_id_type> get_log_block_id(uint32_t block_num) {
       std::optional<chain::block_id_type> result;
 
       if (trace_log)
@@ -63,9 +164,11 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       if (!result && chain_state_log)
          result = chain_state_log->get_block_id(block_num);
 
-      if (result)
-         return result;
+      return result;
+   }
 
+   // main thread only
+   std::optional<chain::block_id_type> get_chain_block_id(uint32_t block_num) {
       try {
          return chain_plug->chain().get_block_id_for_num(block_num);
       } catch (...) {
@@ -73,31 +176,83 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       }
    }
 
-   using get_blocks_request = std::variant<get_blocks_request_v0, get_blocks_request_v1>;
+   // main thread only
+   signed_block_ptr fetch_chain_block(uint32_t block_num) {
+      try {
+         return chain_plug->chain().fetch_block_by_number(block_num);
+      } catch (...) {
+         return {};
+      }
+   }
 
+   /// the most blocks sent in a get_table_blocks_result_v0
+   static constexpr uint32_t max_table_blocks = 10000;
+
+   using get_blocks_request = std::variant<get_blocks_request_v0, get_blocks_request_v1, get_blocks_request_v2>;
+
+   /**
+    * A websocket client. Runs on the strand of its socket on the state history threads, where the logs are read;
+    * the chain is only read on the main thread, see with_chain().
+    */
    struct session : std::enable_shared_from_this<session> {
       std::shared_ptr<state_history_plugin_impl> plugin;
       std::unique_ptr<ws::stream<tcp::socket>>   socket_stream;
       bool                                       sending  = false;
       bool                                       sent_abi = false;
+      bool                                       fetching = false; ///< waiting for a lookup on the main thread
       std::vector<std::vector<char>>             send_queue;
       std::optional<get_blocks_request>          current_request;
+      std::optional<block_filter>                filter; ///< of current_request, when it is a get_blocks_request_v2
+      uint32_t                                   request_generation = 0; ///< incremented for each get_blocks_request
       bool                                       need_to_send_update = false;
+      uint64_t                                   queued_bytes = 0; ///< of send_queue
+      boost::asio::steady_timer                  throttle_timer;
+      bool                                       throttled = false; ///< waiting on throttle_timer
+      mutable std::mutex                         stats_mtx;
+      state_history_session_stats                stats; ///< read from other threads, see get_sessions()
 
-      session(std::shared_ptr<state_history_plugin_impl> plugin)
-          : plugin(std::move(plugin)) {}
+      session(std::shared_ptr<state_history_plugin_impl> plugin, tcp::socket socket)
+          : plugin(std::move(plugin))
+          , socket_stream(std::make_unique<ws::stream<tcp::socket>>(std::move(socket)))
+          , throttle_timer(socket_stream->get_executor()) {}
 
-      void start(tcp::socket socket) {
+      template <typename F>
+      void update_stats(F f) {
+         std::lock_guard<std::mutex> g(stats_mtx);
+         f(stats);
+      }
+
+      void add_time(uint64_t state_history_session_stats::*member, fc::time_point start) {
+         const uint64_t us = (fc::time_point::now() - start).count();
+         update_stats([&](auto& s) { s.*member += us; });
+      }
+
+      state_history_session_stats get_stats() const {
+         std::lock_guard<std::mutex> g(stats_mtx);
+         return stats;
+      }
+
+      void start() {
          fc_ilog(_log, "incoming connection");
-         socket_stream = std::make_unique<ws::stream<tcp::socket>>(std::move(socket));
+         {
+            boost::system::error_code ec;
+            auto ep = socket_stream->next_layer().remote_endpoint(ec);
+            update_stats([&](auto& s) {
+               if (!ec)
+                  s.remote_endpoint = ep.address().to_string() + ":" + std::to_string(ep.port());
+               s.connected = fc::time_point::now();
+            });
+         }
          socket_stream->binary(true);
          socket_stream->next_layer().set_option(boost::asio::ip::tcp::no_delay(true));
          socket_stream->next_layer().set_option(boost::asio::socket_base::send_buffer_size(1024 * 1024));
          socket_stream->next_layer().set_option(boost::asio::socket_base::receive_buffer_size(1024 * 1024));
-         socket_stream->async_accept([self = shared_from_this()](boost::system::error_code ec) {
-            self->callback(ec, "async_accept", [self] {
-               self->start_read();
-               self->send(state_history_plugin_abi);
+         boost::asio::dispatch(socket_stream->get_executor(), [self = shared_from_this()] {
+            self->socket_stream->async_accept([self](boost::system::error_code ec) {
+               self->callback(ec, "async_accept", [self] {
+                  self->start_read();
+                  self->send(state_history_plugin_abi);
+               });
             });
          });
       }
@@ -119,18 +274,64 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       }
 
       void send(const char* s) {
-         send_queue.push_back({s, s + strlen(s)});
+         queue({s, s + strlen(s)});
          send();
       }
 
       template <typename T>
       void send(T obj) {
-         send_queue.push_back(fc::raw::pack(state_result{std::move(obj)}));
+         auto start  = fc::time_point::now();
+         auto packed = fc::raw::pack(state_result{std::move(obj)});
+         add_time(&state_history_session_stats::serialize_us, start);
+         queue(std::move(packed));
          send();
       }
 
+      void queue(std::vector<char> message) {
+         queued_bytes += message.size();
+         plugin->queued_bytes += message.size();
+         send_queue.push_back(std::move(message));
+         update_stats([&](auto& s) {
+            s.queued_messages = send_queue.size();
+            s.queued_bytes    = queued_bytes;
+         });
+         if (plugin->max_session_queued_bytes && queued_bytes > plugin->max_session_queued_bytes) {
+            ++plugin->disconnected_sessions;
+            EOS_THROW(plugin_exception, "disconnecting state history session ${e}: ${b} bytes queued exceed "
+                      "state-history-session-max-queue-mb", ("e", get_stats().remote_endpoint)("b", queued_bytes));
+         }
+      }
+
+      /// the front of send_queue was written
+      void dequeue() {
+         const uint64_t size = send_queue.front().size();
+         const uint64_t released = std::min(size, queued_bytes); // nothing is left to release once closed
+         send_queue.erase(send_queue.begin());
+         queued_bytes -= released;
+         plugin->queued_bytes -= released;
+         update_stats([&](auto& s) {
+            s.bytes_sent += size;
+            ++s.messages_sent;
+            s.queued_messages = send_queue.size();
+            s.queued_bytes    = queued_bytes;
+         });
+      }
+
+      /// waits for the queues of all the sessions to drain below max_queued_bytes before reading the next block
+      void throttle() {
+         if (throttled)
+            return;
+         throttled = true;
+         update_stats([](auto& s) { ++s.throttled; });
+         throttle_timer.expires_after(throttle_interval);
+         throttle_timer.async_wait([self = shared_from_this()](boost::system::error_code ec) {
+            self->throttled = false;
+            self->callback(ec, "throttle", [self] { self->send_update(); });
+         });
+      }
+
       void send() {
-         if (sending)
+         if (sending || fetching)
             return;
          if (send_queue.empty())
             return send_update();
@@ -141,21 +342,46 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
              boost::asio::buffer(send_queue[0]),
              [self = shared_from_this()](boost::system::error_code ec, size_t) {
                 self->callback(ec, "async_write", [self] {
-                   self->send_queue.erase(self->send_queue.begin());
+                   self->dequeue();
                    self->sending = false;
                    self->send();
                 });
              });
       }
 
+      /**
+       * Runs lookup on the main thread, below blocks and transactions, then then(lookup result) on the session strand.
+       * Nothing is sent meanwhile.
+       * lookup must not throw.
+       */
+      template <typename Lookup, typename Then>
+      void with_chain(Lookup lookup, Then then) {
+         fetching = true;
+         main_thread_post(priority::medium_low, [self = shared_from_this(), lookup = std::move(lookup), then = std::move(then)]() mutable {
+            if (self->plugin->stopping)
+               return;
+            auto start  = fc::time_point::now();
+            auto result = lookup();
+            self->add_time(&state_history_session_stats::main_thread_us, start);
+            boost::asio::post(self->socket_stream->get_executor(),
+                              [self, result = std::move(result), then = std::move(then)]() mutable {
+                                 self->fetching = false;
+                                 self->callback({}, "lookup", [&] {
+                                    then(std::move(result));
+                                    self->send();
+                                 });
+                              });
+         });
+      }
+
       using result_type = void;
       void operator()(get_status_request_v0&) {
          fc_ilog(_log, "got get_status_request_v0");
-         auto&                chain = plugin->chain_plug->chain();
+         auto                 snapshot = plugin->get_snapshot();
          get_status_result_v0 result;
-         result.head              = {chain.head_block_num(), chain.head_block_id()};
-         result.last_irreversible = {chain.last_irreversible_block_num(), chain.last_irreversible_block_id()};
-         result.chain_id          = chain.get_chain_id();
+         result.head              = {snapshot.head->block_num, snapshot.head->id};
+         result.last_irreversible = snapshot.last_irreversible;
+         result.chain_id          = *plugin->chain_id;
          if (plugin->trace_log) {
             result.trace_begin_block = plugin->trace_log->begin_block();
             result.trace_end_block   = plugin->trace_log->end_block();
@@ -172,24 +398,89 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       std::enable_if_t<std::is_base_of_v<get_blocks_request_v0,T>>
       operator()(T& req) {
          fc_ilog(_log, "received get_blocks_request = ${req}", ("req",req) );
+         // positions of blocks which are not in the logs are checked against the chain
+         std::vector<block_position> not_in_logs;
          for (auto& cp : req.have_positions) {
             if (req.start_block_num <= cp.block_num)
                continue;
-            auto id = plugin->get_block_id(cp.block_num);
-            if (!id || *id != cp.block_id)
-               req.start_block_num = std::min(req.start_block_num, cp.block_num);
-
-            if (!id) {
-               fc_dlog(_log, "block ${block_num} is not available", ("block_num", cp.block_num));
-            } else if (*id != cp.block_id) {
-               fc_dlog(_log, "the id for block ${block_num} in block request have_positions does not match the existing", ("block_num", cp.block_num));
-            }         
+            auto id = plugin->get_log_block_id(cp.block_num);
+            if (id)
+               check_position(req, cp, id);
+            else
+               not_in_logs.push_back(cp);
          }
          req.have_positions.clear();
+
+         if (not_in_logs.empty())
+            return set_request(req);
+         with_chain(
+             [plugin = plugin, not_in_logs] {
+                std::vector<std::optional<block_id_type>> ids;
+                for (auto& cp : not_in_logs)
+                   ids.push_back(plugin->get_chain_block_id(cp.block_num));
+                return ids;
+             },
+             [this, req, not_in_logs](std::vector<std::optional<block_id_type>> ids) mutable {
+                for (size_t i = 0; i < not_in_logs.size(); ++i)
+                   check_position(req, not_in_logs[i], ids[i]);
+                set_request(req);
+             });
+      }
+
+      void operator()(get_table_blocks_request_v0& req) {
+         fc_ilog(_log, "received get_table_blocks_request_v0 = ${req}", ("req", req));
+         const auto* index = plugin->chain_state_log ? plugin->chain_state_log->get_table_index() : nullptr;
+         EOS_ASSERT(index, plugin_exception, "get_table_blocks_request_v0 needs chain-state-history-table-index");
+
+         get_table_blocks_result_v0 result;
+         result.index_end_block = index->end_block();
+         const uint32_t end         = std::min(req.end_block_num, result.index_end_block);
+         const uint32_t max_results = std::min(req.max_results, max_table_blocks);
+         result.block_nums          = index->find_blocks(req.code, req.table, req.start_block_num, end, max_results);
+         if (max_results && result.block_nums.size() == max_results)
+            result.next_block_num = result.block_nums.back() + 1;
+         else
+            result.next_block_num = std::max(req.start_block_num, end);
+         send(std::move(result));
+      }
+
+      /// false when the table index shows that no row of the delta filter changed in block_num
+      bool deltas_may_match(uint32_t block_num) const {
+         const auto* index = plugin->chain_state_log->get_table_index();
+         if (!index || !filter || filter->contracts.empty() || filter->tables.empty() || block_num >= index->end_block())
+            return true;
+         for (auto code : filter->contracts) {
+            for (auto table : filter->tables) {
+               if (index->changed(block_num, code, table))
+                  return true;
+            }
+         }
+         return false;
+      }
+
+      void check_position(get_blocks_request_v0& req, const block_position& cp, const std::optional<block_id_type>& id) {
+         if (!id || *id != cp.block_id)
+            req.start_block_num = std::min(req.start_block_num, cp.block_num);
+
+         if (!id) {
+            fc_dlog(_log, "block ${block_num} is not available", ("block_num", cp.block_num));
+         } else if (*id != cp.block_id) {
+            fc_dlog(_log, "the id for block ${block_num} in block request have_positions does not match the existing", ("block_num", cp.block_num));
+         }
+      }
+
+      template <typename T>
+      void set_request(const T& req) {
          fc_dlog(_log, "  get_blocks_request start_block_num set to ${num}", ("num", req.start_block_num));
 
          current_request = req;
-         
+         if constexpr (std::is_same_v<T, get_blocks_request_v2>)
+            filter.emplace(req);
+         else
+            filter.reset();
+         ++request_generation;
+         update_stats([&](auto& s) { s.current_block = req.start_block_num; });
+
          send_update(true);
       }
 
@@ -205,9 +496,19 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
          send_update();
       }
 
-      void set_result_block_header(get_blocks_result_v1&, const signed_block_ptr& block) {}
-      void set_result_block_header(get_blocks_result_v2& result, const signed_block_ptr& block) {
-         bool fetch_block_header = std::get<get_blocks_request_v1>(*current_request).fetch_block_header;
+      bool fetch_block_header() const {
+         return std::visit(
+             [](const auto& req) {
+                if constexpr (std::is_base_of_v<get_blocks_request_v1, std::decay_t<decltype(req)>>)
+                   return req.fetch_block_header;
+                else
+                   return false;
+             },
+             *current_request);
+      }
+
+      void set_result_block_header(get_blocks_result_v1&, bool, const signed_block_ptr& block) {}
+      void set_result_block_header(get_blocks_result_v2& result, bool fetch_block_header, const signed_block_ptr& block) {
          if (fetch_block_header && block) {
             result.block_header = static_cast<const signed_block_header&>(*block); 
          }
@@ -221,52 +522,105 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
 
       template <typename T>
       std::enable_if_t<std::is_same_v<get_blocks_result_v1,T> || std::is_same_v<get_blocks_result_v2,T>>
-      send_update(const block_state_ptr& head_block_state, T&& result) {
+      send_update(const chain_snapshot& snapshot, T&& result) {
          need_to_send_update = true;
-         if (!send_queue.empty() || !max_messages_in_flight() )
+         if (!send_queue.empty() || fetching || !max_messages_in_flight() )
             return;
          get_blocks_request_v0& block_req = std::visit([](auto& x) ->get_blocks_request_v0&{  return x; }, *current_request);
          
-         auto& chain              = plugin->chain_plug->chain();
-         result.last_irreversible = {chain.last_irreversible_block_num(), chain.last_irreversible_block_id()};
+         result.last_irreversible = snapshot.last_irreversible;
          uint32_t current =
                block_req.irreversible_only ? result.last_irreversible.block_num : result.head.block_num;
-         if (block_req.start_block_num <= current &&
-             block_req.start_block_num < block_req.end_block_num) {
-
-            auto& block_num = block_req.start_block_num;
-            auto block_id  = plugin->get_block_id(block_num);
-
-            auto get_block = [&chain, block_num, head_block_state]() -> signed_block_ptr {
-               try {
-                  if (head_block_state->block_num == block_num)
-                     return head_block_state->block;
-                  return chain.fetch_block_by_number(block_num);
-               } catch (...) {
-                  return {};
-               }
-            };
-
-            if (block_id) {
-               result.this_block  = block_position{block_num, *block_id};
-               auto prev_block_id = plugin->get_block_id(block_num - 1);
-               if (prev_block_id) 
-                  result.prev_block = block_position{block_num - 1, *prev_block_id};
-               if (block_req.fetch_block) {
-                  result.block = signed_block_ptr_variant{get_block()};
-               }
-               if (block_req.fetch_traces && plugin->trace_log) {
-                  result.traces = plugin->trace_log->get_log_entry(block_num);
-               }
-               if (block_req.fetch_deltas && plugin->chain_state_log) {
-                  result.deltas = plugin->chain_state_log->get_log_entry(block_num);
-               }
-               set_result_block_header(result, get_block());
+         if (!(block_req.start_block_num <= current && block_req.start_block_num < block_req.end_block_num))
+            return send_block(std::move(result), 0, current, {});
+         if (plugin->queues_full())
+            return throttle();
+
+         uint32_t block_num    = block_req.start_block_num++;
+         bool     block_header = fetch_block_header();
+         bool     need_block   = block_req.fetch_block || block_header;
+
+         block_lookup lookup;
+         lookup.id      = plugin->get_log_block_id(block_num);
+         lookup.prev_id = plugin->get_log_block_id(block_num - 1);
+         if (need_block && snapshot.head->block_num == block_num)
+            lookup.block = snapshot.head->block;
+
+         auto fetch = block_fetch{block_req.fetch_block, block_req.fetch_traces, block_req.fetch_deltas, block_header};
+         if (lookup.id && lookup.prev_id && (!need_block || lookup.block))
+            return send_block(std::move(result), block_num, current, fetch, lookup);
+
+         with_chain(
+             [plugin = plugin, block_num, need_block, lookup]() mutable {
+                if (!lookup.id)
+                   lookup.id = plugin->get_chain_block_id(block_num);
+                if (!lookup.prev_id)
+                   lookup.prev_id = plugin->get_chain_block_id(block_num - 1);
+                if (need_block && !lookup.block)
+                   lookup.block = plugin->fetch_chain_block(block_num);
+                return lookup;
+             },
+             [this, result = std::move(result), block_num, current, fetch,
+              generation = request_generation](block_lookup lookup) mutable {
+                // a new request replaced the one this block was for
+                if (generation == request_generation)
+                   send_block(std::move(result), block_num, current, fetch, lookup);
+             });
+      }
+
+      /// what the current request asks for
+      struct block_fetch {
+         bool block        = false;
+         bool traces       = false;
+         bool deltas       = false;
+         bool block_header = false;
+      };
+
+      /// completes result with block_num, unless lookup is empty, and the traces and deltas read from the logs
+      template <typename T>
+      void send_block(T&& result, uint32_t block_num, uint32_t current, const block_fetch& fetch,
+                      const block_lookup& lookup = {}) {
+         if (lookup.id) {
+            const uint32_t head_block_num = result.head.block_num;
+            result.this_block = block_position{block_num, *lookup.id};
+            if (lookup.prev_id) 
+               result.prev_block = block_position{block_num - 1, *lookup.prev_id};
+            if (fetch.block) {
+               result.block = signed_block_ptr_variant{lookup.block};
+            }
+            if (fetch.traces && plugin->trace_log) {
+               auto traces = plugin->recent.get_traces(block_num, *lookup.id, head_block_num, [&] {
+                  auto start = fc::time_point::now();
+                  auto entry = plugin->trace_log->get_log_entry(block_num);
+                  add_time(&state_history_session_stats::log_read_us, start);
+                  return entry;
+               });
+               auto start    = fc::time_point::now();
+               result.traces = filter && filter->filters_traces() ? filter->filter_traces(*traces) : bytes(*traces);
+               add_time(&state_history_session_stats::serialize_us, start);
             }
-            ++block_num;
+            if (fetch.deltas && plugin->chain_state_log && deltas_may_match(block_num)) {
+               auto deltas = plugin->recent.get_deltas(block_num, *lookup.id, head_block_num, [&] {
+                  auto start = fc::time_point::now();
+                  auto entry = plugin->chain_state_log->get_log_entry(block_num);
+                  add_time(&state_history_session_stats::log_read_us, start);
+                  return entry;
+               });
+               auto start    = fc::time_point::now();
+               result.deltas = filter && filter->filters_deltas() ? filter->filter_deltas(*deltas) : bytes(*deltas);
+               add_time(&state_history_session_stats::serialize_us, start);
+            }
+            set_result_block_header(result, fetch.block_header, lookup.block);
          }
-         if (!result.has_value())
+         if (!result.has_value()) {
+            // nothing to send for this block, e.g. filtered out, go on with the next one
+            get_blocks_request_v0& block_req = std::visit([](auto& x) ->get_blocks_request_v0&{  return x; }, *current_request);
+            if (block_req.start_block_num <= current && block_req.start_block_num < block_req.end_block_num)
+               boost::asio::post(socket_stream->get_executor(), [self = shared_from_this()] {
+                  self->callback({}, "send_update", [self] { self->send_update(); });
+               });
             return;
+         }
          fc_ilog(_log,
                  "pushing result "
                  "{\"head\":{\"block_num\":${head}},\"last_irreversible\":{\"block_num\":${last_irr}},\"this_block\":{"
@@ -274,6 +628,11 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
                  ("head", result.head.block_num)("last_irr", result.last_irreversible.block_num)(
                      "this_block", result.this_block ? result.this_block->block_num : fc::variant()));
          send(std::move(result));
+         get_blocks_request_v0& block_req = std::visit([](auto& x) ->get_blocks_request_v0&{  return x; }, *current_request);
+         update_stats([&](auto& s) {
+            s.last_sent_block = block_num;
+            s.current_block   = block_req.start_block_num;
+         });
          --block_req.max_messages_in_flight;
          need_to_send_update = block_req.start_block_num <= current &&
                                block_req.start_block_num < block_req.end_block_num;
@@ -292,36 +651,46 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
          }, result.block );
       }
 
-      void send_update_for_block(const block_state_ptr& head_block_state) {
+      void send_update_for_block(const chain_snapshot& snapshot) {
          std::visit(
-             [&head_block_state, this](const auto& req) {
+             [&snapshot, this](const auto& req) {
                 // send get_blocks_result_v1 when the request is get_blocks_request_v0 and
                 // send send_block_result_v2 when the request is get_blocks_request_v1. 
-                if (head_block_state->block) {
+                if (snapshot.head->block) {
                   typename std::decay_t<decltype(req)>::response_type result;
-                  result.head = { head_block_state->block_num, head_block_state->id };
-                  send_update(head_block_state, std::move(result));
+                  result.head = { snapshot.head->block_num, snapshot.head->id };
+                  send_update(snapshot, std::move(result));
                 }
              },
              *current_request);
       }
 
-      void send_update(const block_state_ptr& block_state) {
+      void send_update(const chain_snapshot& snapshot) {
          need_to_send_update = true;
-         if (!send_queue.empty() || !max_messages_in_flight())
+         if (!send_queue.empty() || fetching || !max_messages_in_flight())
             return;
 
-         send_update_for_block(block_state);
+         send_update_for_block(snapshot);
       }
 
       void send_update(bool changed = false) {
          if (changed)
             need_to_send_update = true;
-         if (!send_queue.empty() || !need_to_send_update || 
+         if (!send_queue.empty() || fetching || !need_to_send_update || 
              !max_messages_in_flight())
             return;
-         auto& chain = plugin->chain_plug->chain();
-         send_update_for_block(chain.head_block_state());
+         send_update_for_block(plugin->get_snapshot());
+      }
+
+      void on_accepted_block(const chain_snapshot& snapshot) {
+         if (current_request) {
+            uint32_t& req_start_block_num =
+                std::visit([](auto& req) -> uint32_t& { return req.start_block_num; }, *current_request);
+            if (snapshot.head->block_num < req_start_block_num) {
+               req_start_block_num = snapshot.head->block_num;
+            }
+         }
+         send_update(snapshot);
       }
 
       template <typename F>
@@ -340,15 +709,14 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
          }
       }
 
+      // called on the session strand
       template <typename F>
       void callback(boost::system::error_code ec, const char* what, F f) {
-         app().post( priority::medium, [=]() {
-            if( plugin->stopping )
-               return;
-            if( ec )
-               return on_fail( ec, what );
-            catch_and_close( f );
-         } );
+         if( plugin->stopping )
+            return;
+         if( ec )
+            return on_fail( ec, what );
+         catch_and_close( f );
       }
 
       void on_fail(boost::system::error_code ec, const char* what) {
@@ -361,18 +729,42 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       }
 
       void close() {
-         socket_stream->next_layer().close();
+         boost::system::error_code ec;
+         socket_stream->next_layer().close(ec);
+         plugin->queued_bytes -= queued_bytes;
+         queued_bytes = 0;
+         std::lock_guard<std::mutex> g(plugin->sessions_mtx);
          plugin->sessions.erase(this);
       }
    };
+   std::mutex                                   sessions_mtx;
    std::map<session*, std::shared_ptr<session>> sessions;
 
+   state_history_sessions_result get_sessions() {
+      state_history_sessions_result result;
+      auto                          snapshot = get_snapshot();
+      result.head_block_num           = snapshot.head ? snapshot.head->block_num : 0;
+      result.queued_bytes             = queued_bytes;
+      result.max_queued_bytes         = max_queued_bytes;
+      result.max_session_queued_bytes = max_session_queued_bytes;
+      result.disconnected_sessions    = disconnected_sessions;
+      result.main_thread_us           = main_thread_us;
+      std::lock_guard<std::mutex> g(sessions_mtx);
+      for (auto& s : sessions) {
+         auto stats = s.second->get_stats();
+         if (stats.last_sent_block && stats.last_sent_block < result.head_block_num)
+            stats.lag = result.head_block_num - stats.last_sent_block;
+         result.sessions.push_back(std::move(stats));
+      }
+      return result;
+   }
+
    void listen() {
       boost::system::error_code ec;
 
       auto address  = boost::asio::ip::make_address(endpoint_address);
       auto endpoint = tcp::endpoint{address, endpoint_port};
-      acceptor      = std::make_unique<tcp::acceptor>(app().get_io_service());
+      acceptor      = std::make_unique<tcp::acceptor>(boost::asio::make_strand(thread_pool->get_executor()));
 
       auto check_ec = [&](const char* what) {
          if (!ec)
@@ -392,8 +784,8 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
    }
 
    void do_accept() {
-      auto socket = std::make_shared<tcp::socket>(app().get_io_service());
-      acceptor->async_accept(*socket, [self = shared_from_this(), socket, this](const boost::system::error_code& ec) {
+      acceptor->async_accept(boost::asio::make_strand(thread_pool->get_executor()),
+                             [self = shared_from_this(), this](const boost::system::error_code& ec, tcp::socket socket) {
          if (stopping)
             return;
          if (ec) {
@@ -402,17 +794,23 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
             return;
          }
          catch_and_log([&] {
-            auto s            = std::make_shared<session>(self);
-            sessions[s.get()] = s;
-            s->start(std::move(*socket));
+            auto s = std::make_shared<session>(self, std::move(socket));
+            {
+               std::lock_guard<std::mutex> g(sessions_mtx);
+               sessions[s.get()] = s;
+            }
+            s->start();
          });
          catch_and_log([&] { do_accept(); });
       });
    }
 
    void on_applied_transaction(const transaction_trace_ptr& p, const packed_transaction_ptr& t) {
-      if (trace_log)
-         trace_log->add_transaction(p, t);
+      if (trace_log) {
+         auto start = fc::time_point::now();
+         trace_log->add_transaction(chain_plug->chain().db(), p, t);
+         main_thread_us += (fc::time_point::now() - start).count();
+      }
    }
 
    void store(const block_state_ptr& block_state) {
@@ -420,7 +818,7 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
          if (trace_log)
             trace_log->store(chain_plug->chain().db(), block_state);
          if (chain_state_log)
-            chain_state_log->store(chain_plug->chain().kv_db(), block_state);
+            chain_state_log->store(chain_plug->chain().kv_db(), block_state, &chain_plug->chain().get_thread_pool());
          return;
       }
       FC_LOG_AND_DROP()
@@ -441,19 +839,18 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       fc_add_tag(blk_span, "block_id", block_state->id);
       fc_add_tag(blk_span, "block_num", block_state->block_num);
       fc_add_tag(blk_span, "block_time", block_state->block->timestamp.to_time_point());
+      auto start = fc::time_point::now();
       this->store(block_state);
+      publish_snapshot(block_state);
+      main_thread_us += (fc::time_point::now() - start).count();
+
+      // the sessions read the new block from the logs on their own strands
+      auto                        snapshot = get_snapshot();
+      std::lock_guard<std::mutex> g(sessions_mtx);
       for (auto& s : sessions) {
-         auto& p = s.second;
-         if (p) {
-            if (p->current_request) {
-               uint32_t& req_start_block_num =
-                   std::visit([](auto& req) -> uint32_t& { return req.start_block_num; }, *p->current_request);
-               if (block_state->block_num < req_start_block_num) {
-                  req_start_block_num = block_state->block_num;
-               }
-            }
-            p->send_update(block_state);
-         }
+         boost::asio::post(s.second->socket_stream->get_executor(), [p = s.second, snapshot] {
+            p->callback({}, "accepted_block", [&] { p->on_accepted_block(snapshot); });
+         });
       }
    }
 
@@ -492,6 +889,12 @@ void state_history_plugin::set_program_options(options_description& cli, options
    cli.add_options()("delete-state-history", bpo::bool_switch()->default_value(false), "clear state history files");
    options("trace-history", bpo::bool_switch()->default_value(false), "enable trace history");
    options("chain-state-history", bpo::bool_switch()->default_value(false), "enable chain state history");
+   options("chain-state-history-table-index", bpo::bool_switch()->default_value(false),
+           "index the contract tables changed by each block of the chain state history, for get_table_blocks_request_v0 "
+           "and the table filters of get_blocks_request_v2. The blocks already in the log are indexed at startup.");
+   options("chain-state-history-row-diffs", bpo::value<uint32_t>()->default_value(0),
+           "when not 0, the rows modified by a block are stored as diffs against the previous block, every block "
+           "multiple of this value is stored with full rows. Clients always receive full rows.");
    options("state-history-endpoint", bpo::value<string>()->default_value("127.0.0.1:8080"),
            "the endpoint upon which to listen for incoming connections. Caution: only expose this port to "
            "your internal network.");
@@ -499,6 +902,26 @@ void state_history_plugin::set_program_options(options_description& cli, options
            "enable debug mode for trace history");
    options("context-free-data-compression", bpo::value<string>()->default_value("zlib"), 
            "compression mode for context free data in transaction traces. Supported options are \"zlib\" and \"none\"");
+   options("state-history-threads", bpo::value<uint16_t>()->default_value(my->thread_pool_size),
+           "Number of threads serving the state history connections and reading the state history logs");
+   options("state-history-max-queue-mb", bpo::value<uint64_t>()->default_value(0),
+           "When the results queued for all the state history connections exceed this many MiB, connections wait for "
+           "them to be sent before reading further blocks from the logs. 0 is unlimited");
+   options("state-history-session-max-queue-mb", bpo::value<uint64_t>()->default_value(0),
+           "Disconnect a state history connection whose queued results exceed this many MiB. A single result larger than "
+           "that also disconnects it. 0 is unlimited");
+   options("state-history-recent-blocks", bpo::value<uint32_t>()->default_value(32),
+           "Number of blocks near head whose traces and deltas are kept in memory for all the state history connections, "
+           "0 reads them from the logs for each connection");
+   options("chain-state-history-compression", bpo::value<string>()->default_value("zlib"),
+           "compression of the new entries of the chain state history log. Supported options are \"zlib\" and \"zstd\".\n"
+           "Entries already in the log keep their compression, eosio-blocklog --convert-state-history rewrites them.");
+   options("state-history-zstd-dictionary", bpo::value<bfs::path>()->default_value(""),
+           "zstd dictionary of the chain state history log (absolute path or relative to state-history dir), "
+           "as trained by eosio-blocklog --train-state-history-dictionary. "
+           "It is needed to read the entries compressed with it and must not be changed once used.");
+   options("state-history-zstd-level", bpo::value<int>()->default_value(3),
+           "zstd compression level of the chain state history log");
 }
 
 void state_history_plugin::plugin_initialize(const variables_map& options) {
@@ -533,6 +956,21 @@ void state_history_plugin::plugin_initialize(const variables_map& options) {
       config.archive_dir        = options.at("state-history-archive-dir").as<bfs::path>();
       config.stride             = options.at("state-history-stride").as<uint32_t>();
       config.max_retained_files = options.at("max-retained-history-files").as<uint32_t>();
+      config.zstd_dictionary    = options.at("state-history-zstd-dictionary").as<bfs::path>();
+      config.zstd_level         = options.at("state-history-zstd-level").as<int>();
+      config.chain_state_table_index = options.at("chain-state-history-table-index").as<bool>();
+      config.chain_state_row_diff_interval = options.at("chain-state-history-row-diffs").as<uint32_t>();
+
+      auto chain_state_compression = options.at("chain-state-history-compression").as<string>();
+      if (chain_state_compression == "zlib") {
+         config.chain_state_compression = state_history::log_compression::zlib;
+      } else if (chain_state_compression == "zstd") {
+         EOS_ASSERT(state_history::zstd_supported(), plugin_config_exception,
+                    "chain-state-history-compression zstd is not supported, nodeos is built without zstd");
+         config.chain_state_compression = state_history::log_compression::zstd;
+      } else {
+         throw bpo::validation_error(bpo::validation_error::invalid_option_value);
+      }
 
       auto ip_port         = options.at("state-history-endpoint").as<string>();
       auto port            = ip_port.substr(ip_port.find(':') + 1, ip_port.size());
@@ -541,6 +979,13 @@ void state_history_plugin::plugin_initialize(const variables_map& options) {
       my->endpoint_port    = std::stoi(port);
       idump((ip_port)(host)(port));
 
+      my->thread_pool_size = options.at("state-history-threads").as<uint16_t>();
+      EOS_ASSERT(my->thread_pool_size > 0, plugin_config_exception,
+                 "state-history-threads ${num} must be greater than 0", ("num", my->thread_pool_size));
+      my->recent.resize(options.at("state-history-recent-blocks").as<uint32_t>());
+      my->max_queued_bytes         = options.at("state-history-max-queue-mb").as<uint64_t>() * 1024 * 1024;
+      my->max_session_queued_bytes = options.at("state-history-session-max-queue-mb").as<uint64_t>() * 1024 * 1024;
+
       if (options.at("delete-state-history").as<bool>()) {
          fc_ilog(_log, "Deleting state history");
          boost::filesystem::remove_all(config.log_dir);
@@ -570,6 +1015,10 @@ void state_history_plugin::plugin_initialize(const variables_map& options) {
 
 void state_history_plugin::plugin_startup() { 
    handle_sighup(); // setup logging
+   auto& chain = my->chain_plug->chain();
+   my->chain_id = chain.get_chain_id();
+   my->publish_snapshot(chain.head_block_state());
+   my->thread_pool.emplace("ship", my->thread_pool_size);
    my->listen(); 
 }
 
@@ -577,9 +1026,25 @@ void state_history_plugin::plugin_shutdown() {
    my->applied_transaction_connection.reset();
    my->accepted_block_connection.reset();
    my->block_start_connection.reset();
-   while (!my->sessions.empty())
-      my->sessions.begin()->second->close();
    my->stopping = true;
+   // with the threads joined, the sockets can be closed from here
+   if (my->thread_pool)
+      my->thread_pool->stop();
+   if (my->acceptor) {
+      boost::system::error_code ec;
+      my->acceptor->close(ec);
+   }
+   std::map<state_history_plugin_impl::session*, std::shared_ptr<state_history_plugin_impl::session>> sessions;
+   {
+      std::lock_guard<std::mutex> g(my->sessions_mtx);
+      sessions.swap(my->sessions);
+   }
+   for (auto& s : sessions)
+      s.second->close();
+}
+
+state_history_sessions_result state_history_plugin::get_sessions() const {
+   return my->get_sessions();
 }
 
 void state_history_plugin::handle_sighup() {
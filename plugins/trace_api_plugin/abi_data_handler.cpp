@@ -12,8 +12,10 @@ namespace eosio::trace_api {
    std::tuple<fc::variant, std::optional<fc::variant>> abi_data_handler::serialize_to_variant(const std::variant<action_trace_v0, action_trace_v1> & action, const yield_function& yield ) {
       auto account = std::visit([](auto &&action) -> auto { return action.account; }, action);
 
-      if (abi_serializer_by_account.count(account) > 0) {
-         const auto &serializer_p = abi_serializer_by_account.at(account);
+      // serializers are built once by add_abi and shared by all requests
+      const auto itr = abi_serializer_by_account.find(account);
+      if (itr != abi_serializer_by_account.end()) {
+         const auto &serializer_p = itr->second;
          auto action_name = std::visit([](auto &&action) -> auto { return action.action; }, action);
          auto type_name = serializer_p->get_action_type(action_name);
 
@@ -1,7 +1,14 @@
 #include <eosio/trace_api/compressed_file.hpp>
 
+#include <algorithm>
+#include <cstring>
+
 #include <zlib.h>
 
+#ifdef EOSIO_TRACE_API_ZSTD
+#include <zstd.h>
+#endif
+
 namespace {
    using seek_point_entry = std::tuple<uint64_t, uint64_t>;
    constexpr size_t expected_seek_point_entry_size = 16;
@@ -11,6 +18,11 @@ namespace {
 
    constexpr int raw_zlib_window_bits = -15;
 
+   using zstd_frame_count_type = uint32_t;
+   constexpr uint32_t zstd_magic = 0x5a434c47; // "ZCLG"
+   constexpr size_t zstd_footer_size = sizeof(zstd_frame_count_type) + sizeof(zstd_magic);
+   constexpr int zstd_level = 9;
+
    // These are hard-coded expectations in the written file format
    //
    static_assert(sizeof(seek_point_entry) == expected_seek_point_entry_size, "unexpected size for seek point");
@@ -20,10 +32,19 @@ namespace {
 namespace eosio::trace_api {
 
 struct compressed_file_impl {
+   virtual ~compressed_file_impl() = default;
+
+   virtual void read( char* d, size_t n, fc::cfile& file ) = 0;
+   virtual void seek( long loc, fc::cfile& file ) = 0;
+
+   size_t file_size = 0;
+};
+
+struct zlib_compressed_file_impl : compressed_file_impl {
    static constexpr size_t read_buffer_size = 4*1024;
    static constexpr size_t compressed_buffer_size = 4*1024;
 
-   ~compressed_file_impl()
+   ~zlib_compressed_file_impl()
    {
       if (initialized) {
          inflateEnd(&strm);
@@ -31,7 +52,7 @@ struct compressed_file_impl {
       }
    }
 
-   void read( char* d, size_t n, fc::cfile& file )
+   void read( char* d, size_t n, fc::cfile& file ) override
    {
       if (!initialized) {
          if (Z_OK != inflateInit2(&strm, raw_zlib_window_bits)) {
@@ -109,7 +130,7 @@ struct compressed_file_impl {
       }
    }
 
-   void seek( long loc, fc::cfile& file ) {
+   void seek( long loc, fc::cfile& file ) override {
       if (initialized) {
          inflateEnd(&strm);
          initialized = false;
@@ -165,15 +186,146 @@ struct compressed_file_impl {
    std::vector<uint8_t> read_buffer = std::vector<uint8_t>(read_buffer_size);
    size_t remaining_read_buffer = 0;
    bool initialized = false;
-   size_t file_size = 0;
 };
 
-compressed_file::compressed_file( fc::path file_path )
+#ifdef EOSIO_TRACE_API_ZSTD
+struct zstd_compressed_file_impl : compressed_file_impl {
+   explicit zstd_compressed_file_impl( fc::path file_path, std::shared_ptr<compressed_frame_cache> frame_cache )
+   :file_path(std::move(file_path))
+   ,frame_cache(std::move(frame_cache))
+   {}
+
+   void read( char* d, size_t n, fc::cfile& file ) override {
+      load_seek_points(file);
+      while (n > 0) {
+         if (position >= std::get<0>(seek_points.back())) {
+            throw std::ios_base::failure("Attempting to read past the end of a compressed file");
+         }
+         load_frame(position, file);
+         const auto frame_offset = position - std::get<0>(seek_points[current_frame]);
+         const auto to_copy = std::min<size_t>(n, frame->size() - frame_offset);
+         std::memcpy(d, frame->data() + frame_offset, to_copy);
+         d += to_copy;
+         n -= to_copy;
+         position += to_copy;
+      }
+   }
+
+   void seek( long loc, fc::cfile& file ) override {
+      load_seek_points(file);
+      if (static_cast<uint64_t>(loc) > std::get<0>(seek_points.back())) {
+         throw std::ios_base::failure("Attempting to seek past the end of a compressed file");
+      }
+      position = loc;
+   }
+
+   // the last seek point is the end of the file
+   void load_seek_points( fc::cfile& file ) {
+      if (!seek_points.empty()) {
+         return;
+      }
+      if (file_size < zstd_footer_size) {
+         throw compressed_file_error("Compressed file is too small");
+      }
+      file.seek_end(-zstd_footer_size);
+      zstd_frame_count_type frame_count = 0;
+      uint32_t magic = 0;
+      file.read(reinterpret_cast<char*>(&frame_count), sizeof(frame_count));
+      file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+      const uint64_t seek_map_size = sizeof(seek_point_entry) * (uint64_t(frame_count) + 1);
+      if (magic != zstd_magic || file_size < zstd_footer_size + seek_map_size) {
+         throw compressed_file_error("Not a zstd compressed file");
+      }
+      file.seek_end(-zstd_footer_size - seek_map_size);
+      seek_points.resize(frame_count + 1);
+      file.read(reinterpret_cast<char*>(seek_points.data()), seek_map_size);
+   }
+
+   void load_frame( uint64_t pos, fc::cfile& file ) {
+      if (frame && pos >= std::get<0>(seek_points[current_frame]) && pos < std::get<0>(seek_points[current_frame + 1])) {
+         return;
+      }
+      auto iter = std::upper_bound(seek_points.begin(), seek_points.end(), pos, []( uint64_t lhs, const auto& rhs ){
+         return lhs < std::get<0>(rhs);
+      });
+      current_frame = (iter - seek_points.begin()) - 1;
+
+      const auto [uncompressed_begin, compressed_begin] = seek_points[current_frame];
+      if (frame_cache) {
+         frame = frame_cache->get(file_path, compressed_begin);
+         if (frame) {
+            return;
+         }
+      }
+
+      const auto compressed_size = std::get<1>(seek_points[current_frame + 1]) - compressed_begin;
+      std::vector<char> compressed(compressed_size);
+      file.seek(compressed_begin);
+      file.read(compressed.data(), compressed.size());
+
+      auto decompressed = std::make_shared<std::vector<char>>(std::get<0>(seek_points[current_frame + 1]) - uncompressed_begin);
+      const auto r = ZSTD_decompress(decompressed->data(), decompressed->size(), compressed.data(), compressed.size());
+      if (ZSTD_isError(r) || r != decompressed->size()) {
+         throw compressed_file_error(std::string("Error decompressing: ") + (ZSTD_isError(r) ? ZSTD_getErrorName(r) : "unexpected size"));
+      }
+      frame = std::move(decompressed);
+      if (frame_cache) {
+         frame_cache->put(file_path, compressed_begin, frame);
+      }
+   }
+
+   const fc::path                            file_path;
+   std::shared_ptr<compressed_frame_cache>   frame_cache;
+   std::vector<seek_point_entry>             seek_points;
+   uint64_t                                  position = 0;
+   size_t                                    current_frame = 0;
+   compressed_frame_cache::frame             frame;
+};
+#endif
+
+compressed_frame_cache::frame compressed_frame_cache::get( const fc::path& file_path, uint64_t offset ) {
+   std::lock_guard g(mtx);
+   auto itr = index.find(make_key(file_path, offset));
+   if (itr == index.end()) {
+      return {};
+   }
+   frames.splice(frames.begin(), frames, itr->second);
+   return itr->second->second;
+}
+
+void compressed_frame_cache::put( const fc::path& file_path, uint64_t offset, frame f ) {
+   if (f->size() > max_bytes) {
+      return;
+   }
+   auto key = make_key(file_path, offset);
+   std::lock_guard g(mtx);
+   if (index.count(key)) {
+      return;
+   }
+   bytes += f->size();
+   frames.emplace_front(key, std::move(f));
+   index.emplace(std::move(key), frames.begin());
+   while (bytes > max_bytes) {
+      bytes -= frames.back().second->size();
+      index.erase(frames.back().first);
+      frames.pop_back();
+   }
+}
+
+compressed_file::compressed_file( fc::path file_path, compression_format format, std::shared_ptr<compressed_frame_cache> frame_cache )
 :file_path(std::move(file_path))
 ,file_ptr(nullptr)
-,impl(std::make_unique<compressed_file_impl>())
 {
-   impl->file_size = fc::file_size(file_path);
+   if (format == compression_format::zstd) {
+#ifdef EOSIO_TRACE_API_ZSTD
+      impl = std::make_unique<zstd_compressed_file_impl>(this->file_path, std::move(frame_cache));
+#else
+      throw compressed_file_error("zstd compressed files are not supported by this build");
+#endif
+   } else {
+      impl = std::make_unique<zlib_compressed_file_impl>();
+   }
+   impl->file_size = fc::file_size(this->file_path);
 }
 
 compressed_file::~compressed_file()
@@ -194,7 +346,49 @@ compressed_file::compressed_file( compressed_file&& ) = default;
 compressed_file& compressed_file::operator= ( compressed_file&& ) = default;
 
 
-bool compressed_file::process( const fc::path& input_path, const fc::path& output_path, size_t seek_point_stride  ) {
+bool compressed_file::zstd_supported() {
+#ifdef EOSIO_TRACE_API_ZSTD
+   return true;
+#else
+   return false;
+#endif
+}
+
+namespace {
+#ifdef EOSIO_TRACE_API_ZSTD
+   bool process_zstd( fc::cfile& input_file, size_t input_size, fc::cfile& output_file, size_t seek_point_stride ) {
+      std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> cctx(ZSTD_createCCtx(), &ZSTD_freeCCtx);
+      if (!cctx) {
+         return false;
+      }
+
+      std::vector<seek_point_entry> seek_point_map;
+      std::vector<char> input_buffer(seek_point_stride);
+      std::vector<char> output_buffer(ZSTD_compressBound(seek_point_stride));
+      size_t read_offset = 0;
+      while (read_offset < input_size) {
+         const auto read_size = std::min(seek_point_stride, input_size - read_offset);
+         input_file.read(input_buffer.data(), read_size);
+         const auto r = ZSTD_compressCCtx(cctx.get(), output_buffer.data(), output_buffer.size(), input_buffer.data(), read_size, zstd_level);
+         if (ZSTD_isError(r)) {
+            throw compressed_file_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(r));
+         }
+         seek_point_map.emplace_back(read_offset, output_file.tellp());
+         output_file.write(output_buffer.data(), r);
+         read_offset += read_size;
+      }
+
+      const zstd_frame_count_type frame_count = seek_point_map.size();
+      seek_point_map.emplace_back(read_offset, output_file.tellp());
+      output_file.write(reinterpret_cast<const char*>(seek_point_map.data()), seek_point_map.size() * sizeof(seek_point_entry));
+      output_file.write(reinterpret_cast<const char*>(&frame_count), sizeof(frame_count));
+      output_file.write(reinterpret_cast<const char*>(&zstd_magic), sizeof(zstd_magic));
+      return true;
+   }
+#endif
+}
+
+bool compressed_file::process( const fc::path& input_path, const fc::path& output_path, size_t seek_point_stride, compression_format format ) {
    if (!fc::exists(input_path)) {
       throw std::ios_base::failure(std::string("Attempting to create compressed_file from file that does not exist: ") + input_path.generic_string());
    }
@@ -204,6 +398,24 @@ bool compressed_file::process( const fc::path& input_path, const fc::path& outpu
       throw std::ios_base::failure(std::string("Attempting to create compressed_file from file that is empty: ") + input_path.generic_string());
    }
 
+   if (format == compression_format::zstd) {
+#ifdef EOSIO_TRACE_API_ZSTD
+      fc::cfile input_file;
+      input_file.set_file_path(input_path);
+      input_file.open("rb");
+
+      fc::cfile output_file;
+      output_file.set_file_path(output_path);
+      output_file.open("wb");
+
+      const bool result = process_zstd(input_file, input_size, output_file, seek_point_stride);
+      output_file.close();
+      return result;
+#else
+      throw compressed_file_error("zstd compressed files are not supported by this build");
+#endif
+   }
+
    // subtract 1 to make sure that the truncated division will only create a seek point if there is at least one byte
    // in the next stride.  So, a file size of N and a stride >= N results in 0 seek points.  N + 1 will have a seek
    // point for the last byte as will XN + 1 which will create X seek points (the last of which is for the last byte)
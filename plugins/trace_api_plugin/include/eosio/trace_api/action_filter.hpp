@@ -0,0 +1,48 @@
+#pragma once
+
+#include <eosio/chain/name.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace eosio::trace_api {
+
+   /**
+    * Selects the action traces stored by the trace_api_plugin. An action is excluded when include rules are given
+    * and it matches none of them, or when it matches an exclude rule. Excluded actions are dropped, or kept
+    * without their data and return value when strip_data is set.
+    */
+   struct action_filter {
+      /// matches the actions of receiver, account and action, an empty name matches any
+      struct rule {
+         chain::name receiver;
+         chain::name account;
+         chain::name action;
+
+         bool matches( chain::name r, chain::name c, chain::name a ) const {
+            return (receiver.empty() || receiver == r) && (account.empty() || account == c) && (action.empty() || action == a);
+         }
+      };
+
+      enum class result {
+         keep,
+         strip, ///< keep the action without its data and return value
+         drop
+      };
+
+      std::vector<rule> include;
+      std::vector<rule> exclude;
+      bool              strip_data = false;
+
+      bool empty() const { return include.empty() && exclude.empty(); }
+
+      result apply( chain::name receiver, chain::name account, chain::name action ) const {
+         auto matches = [&]( const rule& r ) { return r.matches( receiver, account, action ); };
+         const bool excluded = ( !include.empty() && std::none_of( include.begin(), include.end(), matches ) ) ||
+                               std::any_of( exclude.begin(), exclude.end(), matches );
+         if( !excluded ) return result::keep;
+         return strip_data ? result::strip : result::drop;
+      }
+   };
+
+}
@@ -17,12 +17,14 @@ class chain_extraction_impl_type {
 public:
    /**
     * Chain Extractor for capturing transaction traces, action traces, and block info.
-    * @param store provider of append & append_lib
+    * @param store provider of append & append_lib, append receives the block_trace_source of each accepted block
     * @param except_handler called on exceptions, logging if any is left to the user
+    * @param filter if provided, selects the action traces stored
     */
-   chain_extraction_impl_type( StoreProvider store, exception_handler except_handler )
+   chain_extraction_impl_type( StoreProvider store, exception_handler except_handler, std::shared_ptr<const action_filter> filter = {} )
    : store(std::move(store))
    , except_handler(std::move(except_handler))
+   , filter(filter && !filter->empty() ? std::move(filter) : nullptr)
    {}
 
    /// connect to chain controller applied_transaction signal
@@ -81,14 +83,11 @@ private:
 
    void store_block_trace( const chain::block_state_ptr& block_state ) {
       try {
-         using transaction_trace_t = transaction_trace_v2;
-
-         auto bt = create_block_trace( block_state );
-
-         std::vector<transaction_trace_t>& traces = std::get<std::vector<transaction_trace_t>>(bt.transactions);
-         traces.reserve( block_state->block->transactions.size() + 1 );
+         // only the traces are collected here, the store converts them
+         block_trace_source source{ block_state, {}, filter };
+         source.traces.reserve( block_state->block->transactions.size() + 1 );
          if( onblock_trace )
-            traces.emplace_back( to_transaction_trace<transaction_trace_t>( *onblock_trace ));
+            source.traces.emplace_back( *onblock_trace );
          for( const auto& r : block_state->block->transactions ) {
             transaction_id_type id;
             if( std::holds_alternative<transaction_id_type>(r.trx)) {
@@ -98,12 +97,12 @@ private:
             }
             const auto it = cached_traces.find( id );
             if( it != cached_traces.end() ) {
-               traces.emplace_back( to_transaction_trace<transaction_trace_t>( it->second ));
+               source.traces.emplace_back( it->second );
             }
          }
          clear_caches();
 
-         store.append( std::move( bt ) );
+         store.append( std::move( source ) );
 
       } catch( ... ) {
          except_handler( MAKE_EXCEPTION_WITH_CONTEXT( std::current_exception() ) );
@@ -121,6 +120,7 @@ private:
 private:
    StoreProvider                                                store;
    exception_handler                                            except_handler;
+   std::shared_ptr<const action_filter>                         filter;
    std::map<transaction_id_type, cache_trace>                   cached_traces;
    std::optional<cache_trace>                                   onblock_trace;
 
@@ -1,12 +1,49 @@
 #pragma once
 
 #include <ios>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <fc/io/cfile.hpp>
 
 namespace eosio::trace_api {
 
    class compressed_file_datastream;
    struct compressed_file_impl;
+
+   enum class compression_format {
+      zlib, ///< a single raw zlib stream with full flushes as seek points
+      zstd  ///< independent zstd frames, each starting at a seek point
+   };
+
+   /**
+    * Decompressed frames of zstd compressed files, shared by the compressed_files reading them so
+    * frames of hot slices are decompressed once. Frames are dropped least recently used first.
+    * Thread safe.
+    */
+   class compressed_frame_cache {
+   public:
+      using frame = std::shared_ptr<const std::vector<char>>;
+
+      explicit compressed_frame_cache( size_t max_bytes ) : max_bytes(max_bytes) {}
+
+      /// @return the frame at compressed offset of the file, or null
+      frame get( const fc::path& file_path, uint64_t offset );
+      void put( const fc::path& file_path, uint64_t offset, frame f );
+
+   private:
+      using key_type = std::string;
+      static key_type make_key( const fc::path& file_path, uint64_t offset ) {
+         return file_path.generic_string() + ":" + std::to_string(offset);
+      }
+
+      const size_t                                                          max_bytes;
+      std::mutex                                                            mtx;
+      std::list<std::pair<key_type, frame>>                                 frames;  ///< most recently used first
+      std::unordered_map<key_type, decltype(frames)::iterator>              index;
+      size_t                                                                bytes = 0;
+   };
    /**
     * wrapper for read-only access to a compressed file.
     * compressed files support seeking and reading
@@ -41,10 +78,29 @@ namespace eosio::trace_api {
     * seek points do not have to be aware of them
     *
     * In zlib this is created by doing a complete flush of the stream
+    *
+    * A zstd compressed file is instead a sequence of independent frames, each holding seek_point_stride
+    * uncompressed bytes, so a seek only decompresses the frame it lands in, and frames can be compressed in
+    * parallel:
+    * /====================\ file offset 0
+    * |  zstd frames       |
+    * |--------------------|  file offset END - 8 - (16 * (frame count + 1))
+    * |  orig offset and   |
+    * |  frame offset of   |
+    * |  each frame, then  |
+    * |  of the END        |
+    * |--------------------|  file offset END - 8
+    * |  frame count       |
+    * |  magic             |
+    * \====================/  file offset END
     */
    class compressed_file {
    public:
-      explicit compressed_file( fc::path file_path );
+      /**
+       * @param frame_cache - if provided, decompressed frames of zstd files are shared through it
+       */
+      explicit compressed_file( fc::path file_path, compression_format format = compression_format::zlib,
+                                std::shared_ptr<compressed_frame_cache> frame_cache = {} );
       ~compressed_file();
 
       /**
@@ -113,11 +169,18 @@ namespace eosio::trace_api {
        * @param input_path - the path to the input file
        * @param output_path - the path to write the output file to (overwriting an existing file at that path)
        * @param seek_point_stride - the number of uncompressed bytes between seek points
+       * @param format - the compression of the output file
        * @return true if successful, false if there was no error but the process could not complete
        * @throws std::ios_base::failure if the input_path does not exist or the output_path cannot be written to
        * @throws compressed_file_error if there is an issue during compression of the data stream
        */
-      static bool process( const fc::path& input_path, const fc::path& output_path, size_t seek_point_stride );
+      static bool process( const fc::path& input_path, const fc::path& output_path, size_t seek_point_stride,
+                           compression_format format = compression_format::zlib );
+
+      /**
+       * @return true if this build can read and write zstd compressed files
+       */
+      static bool zstd_supported();
 
    private:
       fc::path file_path;
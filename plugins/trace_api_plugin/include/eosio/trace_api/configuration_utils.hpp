@@ -5,6 +5,8 @@
 #include <fc/io/json.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/abi_def.hpp>
+#include <eosio/trace_api/action_filter.hpp>
+#include <boost/algorithm/string.hpp>
 
 namespace eosio::trace_api::configuration_utils {
    using namespace eosio;
@@ -51,4 +53,20 @@ namespace eosio::trace_api::configuration_utils {
       return std::make_pair(input.substr(0, delim), input.substr(delim + 1));
    }
 
-}
\ No newline at end of file
+   /**
+    * Given a string in the form <receiver>:<account>:<action> where any part may be blank to match all, return the
+    * action_filter rule it represents
+    *
+    * @param input
+    * @return
+    */
+   action_filter::rule parse_action_filter_rule( const std::string& input ) {
+      std::vector<std::string> v;
+      boost::split( v, input, boost::is_any_of( ":" ) );
+      EOS_ASSERT(v.size() == 3, chain::plugin_config_exception, "Action filter ${input} is not receiver:account:action", ("input", input));
+      try {
+         return action_filter::rule{ chain::name(v[0]), chain::name(v[1]), chain::name(v[2]) };
+      } EOS_RETHROW_EXCEPTIONS(chain::plugin_config_exception, "Invalid name in action filter ${input}", ("input", input));
+   }
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <eosio/trace_api/trace.hpp>
+#include <eosio/trace_api/action_filter.hpp>
 #include <eosio/chain/block_state.hpp>
 
 namespace eosio { namespace trace_api {
@@ -26,8 +27,9 @@ inline ActionTrace to_action_trace( const chain::action_trace& at ) {
    return r;
 }
 
+/// @param filter if provided, selects the action traces included
 template<typename TransactionTrace>
-inline TransactionTrace to_transaction_trace( const cache_trace& t ) {
+inline TransactionTrace to_transaction_trace( const cache_trace& t, const action_filter* filter = nullptr ) {
    TransactionTrace r;
    if( !t.trace->failed_dtrx_trace ) {
       r.id = t.trace->id;
@@ -52,7 +54,15 @@ inline TransactionTrace to_transaction_trace( const cache_trace& t ) {
    std::get<std::vector<action_trace_t>>(r.actions).reserve( t.trace->action_traces.size());
    for( const auto& at : t.trace->action_traces ) {
       if( !at.context_free ) { // not including CFA at this time
-         std::get<std::vector<action_trace_t>>(r.actions).emplace_back( to_action_trace<action_trace_t>(at) );
+         const auto filtered = filter ? filter->apply( at.receiver, at.act.account, at.act.name ) : action_filter::result::keep;
+         if( filtered == action_filter::result::drop ) continue;
+         auto& action = std::get<std::vector<action_trace_t>>(r.actions).emplace_back( to_action_trace<action_trace_t>(at) );
+         if( filtered == action_filter::result::strip ) {
+            action.data.clear();
+            if constexpr(std::is_same_v<action_trace_t, action_trace_v1>) {
+               action.return_value.clear();
+            }
+         }
       }
    }
 
@@ -72,4 +82,24 @@ inline block_trace_v2 create_block_trace( const chain::block_state_ptr& bsp ) {
    return r;
 }
 
+/// The traces of an accepted block as captured from the chain signals, in block order
+struct block_trace_source {
+   chain::block_state_ptr                  block_state;
+   std::vector<cache_trace>                traces;
+   std::shared_ptr<const action_filter>    filter; ///< selects the action traces stored, all when null
+};
+
+/// Converts the captured traces, only reads the shared chain traces so it may run on any thread
+inline block_trace_v2 to_block_trace( const block_trace_source& source ) {
+   using transaction_trace_t = transaction_trace_v2;
+
+   auto bt = create_block_trace( source.block_state );
+   std::vector<transaction_trace_t>& traces = std::get<std::vector<transaction_trace_t>>(bt.transactions);
+   traces.reserve( source.traces.size() );
+   for( const auto& t : source.traces ) {
+      traces.emplace_back( to_transaction_trace<transaction_trace_t>( t, source.filter.get() ));
+   }
+   return bt;
+}
+
 } }
@@ -20,7 +20,27 @@ namespace eosio { namespace trace_api {
       lib_entry_v0
    >;
 
+   /// the ids of the transactions of a block, appended to the transaction id slice of the block
+   struct block_trxs_entry_v0 {
+      uint32_t                                  number;
+      std::vector<chain::transaction_id_type>   ids;
+   };
+
+   using trx_id_log_entry = std::variant<
+      block_trxs_entry_v0
+   >;
+
+   /// fixed size record of a compacted transaction id slice, where they are sorted by id
+   struct trx_block_entry_v0 {
+      chain::transaction_id_type   id;
+      uint32_t                     number;
+
+      static constexpr size_t packed_size = sizeof(chain::transaction_id_type) + sizeof(uint32_t);
+   };
+
 }}
 
 FC_REFLECT(eosio::trace_api::block_entry_v0, (id)(number)(offset));
 FC_REFLECT(eosio::trace_api::lib_entry_v0, (lib));
+FC_REFLECT(eosio::trace_api::block_trxs_entry_v0, (number)(ids));
+FC_REFLECT(eosio::trace_api::trx_block_entry_v0, (id)(number));
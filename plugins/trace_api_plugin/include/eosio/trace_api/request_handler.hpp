@@ -1,6 +1,10 @@
 #pragma once
 
 #include <fc/variant.hpp>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <eosio/trace_api/metadata_log.hpp>
 #include <eosio/trace_api/data_log.hpp>
 #include <eosio/trace_api/common.hpp>
@@ -8,19 +12,41 @@
 namespace eosio::trace_api {
    using data_handler_function = std::function<std::tuple<fc::variant, std::optional<fc::variant>>( const std::variant<action_trace_v0, action_trace_v1> & action_trace_t, const yield_function&)>;
 
+   /**
+    * Least recently used rendered responses of irreversible blocks, which can no longer change. Thread safe.
+    */
+   class block_response_cache {
+   public:
+      explicit block_response_cache( size_t max_blocks ) : max_blocks(max_blocks) {}
+
+      std::optional<fc::variant> get( uint32_t block_height );
+      void put( uint32_t block_height, const fc::variant& response );
+
+   private:
+      const size_t                                                                max_blocks;
+      std::mutex                                                                  mtx;
+      std::list<std::pair<uint32_t, fc::variant>>                                 responses; ///< most recently used first
+      std::unordered_map<uint32_t, decltype(responses)::iterator>                 index;
+   };
+
    namespace detail {
       class response_formatter {
       public:
          static fc::variant process_block( const data_log_entry& trace, bool irreversible, const data_handler_function& data_handler, const yield_function& yield );
+         static fc::variant process_transaction( const data_log_entry& trace, bool irreversible, const chain::transaction_id_type& id, const data_handler_function& data_handler, const yield_function& yield );
       };
    }
 
    template<typename LogfileProvider, typename DataHandlerProvider>
    class request_handler {
    public:
-      request_handler(LogfileProvider&& logfile_provider, DataHandlerProvider&& data_handler_provider)
+      /**
+       * @param response_cache_size - number of rendered responses of irreversible blocks to keep, 0 to disable
+       */
+      request_handler(LogfileProvider&& logfile_provider, DataHandlerProvider&& data_handler_provider, size_t response_cache_size = 0)
       :logfile_provider(std::move(logfile_provider))
       ,data_handler_provider(std::move(data_handler_provider))
+      ,response_cache(response_cache_size ? std::make_unique<block_response_cache>(response_cache_size) : nullptr)
       {
       }
 
@@ -36,6 +62,12 @@ namespace eosio::trace_api {
        * @throws bad_data_exception when there are issues with the underlying data preventing processing.
        */
       fc::variant get_block_trace( uint32_t block_height, const yield_function& yield = {}) {
+         if (response_cache) {
+            if (auto cached = response_cache->get(block_height)) {
+               return std::move(*cached);
+            }
+         }
+
          auto data = logfile_provider.get_block(block_height, yield);
          if (!data) {
             return {};
@@ -49,12 +81,50 @@ namespace eosio::trace_api {
             }, action);
          };
 
-         return detail::response_formatter::process_block(std::get<0>(*data), std::get<1>(*data), data_handler, yield);
+         auto response = detail::response_formatter::process_block(std::get<0>(*data), std::get<1>(*data), data_handler, yield);
+         if (response_cache && std::get<1>(*data)) {
+            response_cache->put(block_height, response);
+         }
+         return response;
+      }
+
+      /**
+       * Fetch the trace of a transaction and convert it to a fc::variant for conversion to a final format
+       * (eg JSON)
+       *
+       * @param id - the id of the transaction whose trace is requested
+       * @param yield - a yield function to allow cooperation during long running tasks
+       * @return a properly formatted variant representing the trace of the transaction, along with the block
+       * containing it, if it exists, an empty variant otherwise.
+       * @throws yield_exception if a call to `yield` throws.
+       * @throws bad_data_exception when there are issues with the underlying data preventing processing.
+       */
+      fc::variant get_transaction_trace( const chain::transaction_id_type& id, const yield_function& yield = {}) {
+         auto block_height = logfile_provider.get_trx_block_number(id, yield);
+         if (!block_height) {
+            return {};
+         }
+
+         auto data = logfile_provider.get_block(*block_height, yield);
+         if (!data) {
+            return {};
+         }
+
+         yield();
+
+         auto data_handler = [this](const auto& action, const yield_function& yield) -> std::tuple<fc::variant, std::optional<fc::variant>> {
+            return std::visit([&](const auto& action_trace_t) {
+               return data_handler_provider.serialize_to_variant(action_trace_t, yield);
+            }, action);
+         };
+
+         return detail::response_formatter::process_transaction(std::get<0>(*data), std::get<1>(*data), id, data_handler, yield);
       }
 
    private:
       LogfileProvider logfile_provider;
       DataHandlerProvider data_handler_provider;
+      std::unique_ptr<block_response_cache> response_cache;
    };
 
 
@@ -6,6 +6,8 @@
 #include <condition_variable>
 #include <fc/io/cfile.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/container/flat_map.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <fc/variant.hpp>
 #include <eosio/trace_api/common.hpp>
 #include <eosio/trace_api/metadata_log.hpp>
@@ -64,7 +66,18 @@ namespace eosio::trace_api {
     */
    template<typename DataEntry, typename File>
    static uint64_t append_store(const DataEntry &entry, File &file) {
-      auto data = fc::raw::pack(entry);
+      return append_store_data(fc::raw::pack(entry), file);
+   }
+
+   /**
+    * append an already packed entry to the store
+    *
+    * @param data : the packed entry to append
+    * @param file : the file to append entry to
+    * @return the offset in the file where that entry is written
+    */
+   template<typename File>
+   static uint64_t append_store_data(const std::vector<char>& data, File &file) {
       const auto offset = file.tellp();
       file.write(data.data(), data.size());
       file.flush();
@@ -100,8 +113,18 @@ namespace eosio::trace_api {
       };
 
       enum class open_state { read /*read from front to back*/, write /*write to end of file*/ };
+      /**
+       * @param compression : the format slices are compressed to, either format is read
+       * @param compression_threads : the number of slices compressed at the same time
+       * @param frame_cache_size : bytes of decompressed zstd frames kept for reads, 0 to disable
+       * @param cold_slice_dir : the directory compressed slices are moved to, they are read from either directory
+       * @param minimum_hot_irreversible_history_blocks : the number of blocks past lib whose compressed slices are
+       *        kept in slice_dir, no slice is moved when empty
+       */
       slice_directory(const boost::filesystem::path& slice_dir, uint32_t width, std::optional<uint32_t> minimum_irreversible_history_blocks,
-                      std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride);
+                      std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride,
+                      compression_format compression = compression_format::zlib, size_t compression_threads = 1, size_t frame_cache_size = 0,
+                      const boost::filesystem::path& cold_slice_dir = {}, std::optional<uint32_t> minimum_hot_irreversible_history_blocks = {});
 
       /**
        * Return the slice number that would include the passed in block_height
@@ -162,7 +185,8 @@ namespace eosio::trace_api {
       bool find_trace_slice(uint32_t slice_number, open_state state, fc::cfile& trace_file, bool open_file = true) const;
 
       /**
-       * Find the read-only compressed trace file associated with the indicated slice_number
+       * Find the read-only compressed trace file associated with the indicated slice_number, in the slice directory
+       * or else in the cold slice directory
        *
        * @param slice_number : slice number of the requested slice file
        * @param open_file : indicate if the file should be opened (if found) or not
@@ -172,6 +196,67 @@ namespace eosio::trace_api {
        */
       std::optional<compressed_file> find_compressed_trace_slice(uint32_t slice_number, bool open_file = true) const;
 
+      /**
+       * @return the path of the compressed trace file of the indicated slice_number in the given format
+       */
+      boost::filesystem::path compressed_trace_slice_path(uint32_t slice_number, compression_format format) const;
+
+      /**
+       * Move the compressed trace file of the indicated slice_number to the cold slice directory, it is copied before
+       * being removed so the directories may be on different file systems
+       *
+       * @param slice_number : slice number of the slice file to move
+       * @return true if a compressed trace file was moved
+       */
+      bool offload_compressed_trace_slice(uint32_t slice_number) const;
+
+      /**
+       * Find or create the transaction id file associated with the indicated slice_number
+       *
+       * @param slice_number : slice number of the requested slice file
+       * @param state : indicate if the file is going to be written to (appended) or read
+       * @param trx_id_file : the cfile that will be set to the appropriate slice filename
+       *                      and opened to that file
+       * @return the true if file was found (i.e. already existed)
+       */
+      bool find_or_create_trx_id_slice(uint32_t slice_number, open_state state, fc::cfile& trx_id_file) const;
+
+      /**
+       * Find the transaction id file associated with the indicated slice_number
+       *
+       * @param slice_number : slice number of the requested slice file
+       * @param state : indicate if the file is going to be written to (appended) or read
+       * @param trx_id_file : the cfile that will be set to the appropriate slice filename (always)
+       *                      and opened to that file (if it was found)
+       * @param open_file : indicate if the file should be opened (if found) or not
+       * @return the true if file was found (i.e. already existed)
+       */
+      bool find_trx_id_slice(uint32_t slice_number, open_state state, fc::cfile& trx_id_file, bool open_file = true) const;
+
+      /**
+       * Find the compacted transaction id file associated with the indicated slice_number, whose
+       * trx_block_entry_v0 records are sorted by id
+       *
+       * @param slice_number : slice number of the requested slice file
+       * @param compacted_file : the cfile that will be set to the appropriate slice filename (always)
+       *                         and opened to that file, past its header (if it was found)
+       * @param open_file : indicate if the file should be opened (if found) or not
+       * @return the true if file was found (i.e. already existed)
+       */
+      bool find_compacted_trx_id_slice(uint32_t slice_number, fc::cfile& compacted_file, bool open_file = true) const;
+
+      /**
+       * @return the numbers of the slices which have a transaction id file, compacted or not, highest first
+       */
+      std::vector<uint32_t> trx_id_slice_numbers() const;
+
+      /**
+       * Replace the transaction id file of a slice by its compacted file, leaving out the blocks replaced by forks
+       *
+       * @param slice_number : slice number of an irreversible slice
+       */
+      void compact_trx_id_slice(uint32_t slice_number) const;
+
       /**
        * Find or create a trace and index file pair
        *
@@ -200,7 +285,9 @@ namespace eosio::trace_api {
 
       /**
        * Cleans up all slices that are no longer needed to maintain the minimum number of blocks past lib
+       * Compacts the transaction ids of all irreversible slices
        * Compresses up all slices that can be compressed
+       * Moves the compressed slices past the minimum number of hot blocks to the cold slice directory
        *
        * @param lib : block number of the current lib
        */
@@ -214,6 +301,8 @@ namespace eosio::trace_api {
       // take an index file that is initialized to a file and open it and write its header
       void create_new_index_slice_file(fc::cfile& index_file) const;
 
+      boost::filesystem::path compressed_trace_slice_path(const boost::filesystem::path& dir, uint32_t slice_number, compression_format format) const;
+
       // take an open index slice file and verify its header is valid and prepare the file to be appended to (or read from)
       void validate_existing_index_slice_file(fc::cfile& index_file, open_state state) const;
 
@@ -227,7 +316,14 @@ namespace eosio::trace_api {
       std::optional<uint32_t> _last_cleaned_up_slice;
       const std::optional<uint32_t> _minimum_uncompressed_irreversible_history_blocks;
       std::optional<uint32_t> _last_compressed_slice;
+      std::optional<uint32_t> _last_compacted_trx_id_slice;
       const size_t _compression_seek_point_stride;
+      const compression_format _compression;
+      const size_t _compression_threads;
+      const std::shared_ptr<compressed_frame_cache> _frame_cache;
+      const boost::filesystem::path _cold_slice_dir;
+      const std::optional<uint32_t> _minimum_hot_irreversible_history_blocks;
+      std::optional<uint32_t> _last_offloaded_slice;
 
       std::atomic<uint32_t> _best_known_lib{0};
       std::mutex _maintenance_mtx;
@@ -244,10 +340,27 @@ namespace eosio::trace_api {
       using open_state = slice_directory::open_state;
 
       store_provider(const boost::filesystem::path& slice_dir, uint32_t stride_width, std::optional<uint32_t> minimum_irreversible_history_blocks,
-            std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride);
+            std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride,
+            compression_format compression = compression_format::zlib, size_t compression_threads = 1, size_t frame_cache_size = 0,
+            const boost::filesystem::path& cold_slice_dir = {}, std::optional<uint32_t> minimum_hot_irreversible_history_blocks = {});
+
+      /// a block trace packed as a data log entry, along with what the index logs need
+      struct encoded_block_trace {
+         chain::block_id_type                      id;
+         uint32_t                                  number = 0;
+         std::vector<chain::transaction_id_type>   trx_ids;
+         std::vector<char>                         data;
+      };
+
+      /// packs a block trace for append, this does not access the store so it may run on any thread
+      template<typename BlockTrace>
+      static encoded_block_trace encode(const BlockTrace& bt);
 
       template<typename BlockTrace>
-      void append(const BlockTrace& bt);
+      void append(const BlockTrace& bt) {
+         append(encode(bt));
+      }
+      void append(const encoded_block_trace& ebt);
       void append_lib(uint32_t lib);
 
       /**
@@ -258,6 +371,14 @@ namespace eosio::trace_api {
        */
       get_block_t get_block(uint32_t block_height, const yield_function& yield= {});
 
+      /**
+       * Find the block of a transaction, searching the slices from the highest
+       * @param id : the id of the transaction
+       * @return empty optional if no slice has the transaction OTHERWISE
+       *         optional containing the number of its block
+       */
+      std::optional<uint32_t> get_trx_block_number(const chain::transaction_id_type& id, const yield_function& yield = {});
+
       void start_maintenance_thread( log_handler log ) {
          _slice_directory.start_maintenance_thread( std::move(log) );
       }
@@ -351,7 +472,37 @@ namespace eosio::trace_api {
        */
       void validate_existing_index_slice_file(fc::cfile& index, open_state state);
 
+      /**
+       * The block offsets and lib read from the index log of a slice, with a mapping of its trace log, kept
+       * across requests. Both logs are append only, so only what was appended since is read on the next request.
+       */
+      struct cached_slice {
+         boost::container::flat_map<uint32_t, uint64_t>                  block_offsets; ///< last entry of each block number
+         std::optional<uint32_t>                                          lib;           ///< highest lib entry of the index
+         uint64_t                                                         index_size = 0; ///< bytes of the index log read
+         std::shared_ptr<const boost::iostreams::mapped_file_source>      trace;
+         uint64_t                                                         last_used = 0;
+      };
+
+      /**
+       * Find the offset of a block in the trace log of its slice, updating the slice from its index log
+       * @return empty optional if the index has no entry for the block OTHERWISE
+       *         optional containing a 2-tuple of the offset and a flag indicating irreversibility
+       */
+      std::optional<std::tuple<uint64_t, bool>> find_block_offset(uint32_t block_height, const yield_function& yield);
+
+      /**
+       * Read from the trace log of a slice through its mapping, mapping it again when it grew past offset,
+       * falling back to read_data_log when it has been compressed
+       */
+      std::optional<data_log_entry> read_mapped_data_log(uint32_t block_height, uint64_t offset);
+
+      static constexpr size_t max_cached_slices = 8;
+
       slice_directory _slice_directory;
+      std::mutex                              _cache_mtx;
+      std::map<uint32_t, cached_slice>        _cached_slices;
+      uint64_t                                _cache_uses = 0;
    };
 
 }
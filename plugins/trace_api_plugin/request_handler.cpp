@@ -119,6 +119,31 @@ namespace {
    }
 }
 
+namespace eosio::trace_api {
+   std::optional<fc::variant> block_response_cache::get( uint32_t block_height ) {
+      std::lock_guard g(mtx);
+      auto itr = index.find(block_height);
+      if (itr == index.end()) {
+         return {};
+      }
+      responses.splice(responses.begin(), responses, itr->second);
+      return itr->second->second;
+   }
+
+   void block_response_cache::put( uint32_t block_height, const fc::variant& response ) {
+      std::lock_guard g(mtx);
+      if (index.count(block_height)) {
+         return;
+      }
+      responses.emplace_front(block_height, response);
+      index.emplace(block_height, responses.begin());
+      if (responses.size() > max_blocks) {
+         index.erase(responses.back().first);
+         responses.pop_back();
+      }
+   }
+}
+
 namespace eosio::trace_api::detail {
     fc::variant response_formatter::process_block( const data_log_entry& trace, bool irreversible, const data_handler_function& data_handler, const yield_function& yield ) {
        auto common_mvo  = std::visit([&](auto&& arg) -> fc::mutable_variant_object {
@@ -155,4 +180,35 @@ namespace eosio::trace_api::detail {
           return fc::mutable_variant_object();
        }
     }
+
+    fc::variant response_formatter::process_transaction( const data_log_entry& trace, bool irreversible, const chain::transaction_id_type& id, const data_handler_function& data_handler, const yield_function& yield ) {
+       auto block_mvo = std::visit([&](auto&& arg) -> fc::mutable_variant_object {
+          return fc::mutable_variant_object()
+             ("block_id", arg.id.str())
+             ("block_number", arg.number )
+             ("block_status", irreversible ? "irreversible" : "pending" )
+             ("block_timestamp", to_iso8601_datetime(arg.timestamp))
+             ("producer", arg.producer.to_string());}, trace);
+
+       auto process = [&](const auto& transactions) -> fc::variant {
+          auto itr = std::find_if(transactions.begin(), transactions.end(), [&id](const auto& t) { return t.id == id; });
+          if (itr == transactions.end()) {
+             return {};
+          }
+          using transaction_trace_t = std::decay_t<decltype(*itr)>;
+          auto result = process_transactions(std::vector<transaction_trace_t>{*itr}, data_handler, yield);
+          return fc::mutable_variant_object(result.at(0).get_object())
+                (std::move(block_mvo));
+       };
+
+       if (std::holds_alternative<block_trace_v0>(trace)) {
+          return process(std::get<block_trace_v0>(trace).transactions);
+       } else if (std::holds_alternative<block_trace_v1>(trace)) {
+          return process(std::get<block_trace_v1>(trace).transactions_v1);
+       } else if (std::holds_alternative<block_trace_v2>(trace)) {
+          return process(std::get<std::vector<transaction_trace_v2>>(std::get<block_trace_v2>(trace).transactions));
+       } else {
+          return {};
+       }
+    }
 }
@@ -3,12 +3,20 @@
 #include <fc/variant_object.hpp>
 #include <fc/log/logger_config.hpp>
 
+#include <algorithm>
+#include <future>
+#include <map>
+#include <set>
+
 namespace {
       static constexpr uint32_t _current_version = 1;
       static constexpr const char* _trace_prefix = "trace_";
       static constexpr const char* _trace_index_prefix = "trace_index_";
+      static constexpr const char* _trx_id_prefix = "trace_trx_";
       static constexpr const char* _trace_ext = ".log";
       static constexpr const char* _compressed_trace_ext = ".clog";
+      static constexpr const char* _zstd_compressed_trace_ext = ".zclog";
+      static constexpr const char* _compacted_trx_id_ext = ".idx";
       static constexpr uint _max_filename_size = std::char_traits<char>::length(_trace_index_prefix) + 10 + 1 + 10 + std::char_traits<char>::length(_compressed_trace_ext) + 1; // "trace_index_" + 10-digits + '-' + 10-digits + ".clog" + null-char
 
       std::string make_filename(const char* slice_prefix, const char* slice_ext, uint32_t slice_number, uint32_t slice_width) {
@@ -26,29 +34,54 @@ namespace {
 
          return std::string(filename);
       }
+
+      std::vector<eosio::chain::transaction_id_type> transaction_ids(const eosio::trace_api::block_trace_v1& bt) {
+         std::vector<eosio::chain::transaction_id_type> ids;
+         for (const auto& t : bt.transactions_v1)
+            ids.push_back(t.id);
+         return ids;
+      }
+
+      std::vector<eosio::chain::transaction_id_type> transaction_ids(const eosio::trace_api::block_trace_v2& bt) {
+         std::vector<eosio::chain::transaction_id_type> ids;
+         for (const auto& t : std::get<std::vector<eosio::trace_api::transaction_trace_v2>>(bt.transactions))
+            ids.push_back(t.id);
+         return ids;
+      }
 }
 
 namespace eosio::trace_api {
    namespace bfs = boost::filesystem;
-   store_provider::store_provider(const bfs::path& slice_dir, uint32_t stride_width, std::optional<uint32_t> minimum_irreversible_history_blocks, std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride)
-   : _slice_directory(slice_dir, stride_width, minimum_irreversible_history_blocks, minimum_uncompressed_irreversible_history_blocks, compression_seek_point_stride) {
+   store_provider::store_provider(const bfs::path& slice_dir, uint32_t stride_width, std::optional<uint32_t> minimum_irreversible_history_blocks, std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride,
+                                  compression_format compression, size_t compression_threads, size_t frame_cache_size,
+                                  const bfs::path& cold_slice_dir, std::optional<uint32_t> minimum_hot_irreversible_history_blocks)
+   : _slice_directory(slice_dir, stride_width, minimum_irreversible_history_blocks, minimum_uncompressed_irreversible_history_blocks, compression_seek_point_stride,
+                      compression, compression_threads, frame_cache_size, cold_slice_dir, minimum_hot_irreversible_history_blocks) {
    }
 
    template<typename BlockTrace>
-   void store_provider::append(const BlockTrace& bt) {
+   store_provider::encoded_block_trace store_provider::encode(const BlockTrace& bt) {
+      // storing as static_variant to allow adding other data types to the trace file in the future
+      return encoded_block_trace { .id = bt.id, .number = bt.number, .trx_ids = transaction_ids(bt), .data = fc::raw::pack(data_log_entry { bt }) };
+   }
+
+   template store_provider::encoded_block_trace store_provider::encode<block_trace_v1>(const block_trace_v1& bt);
+   template store_provider::encoded_block_trace store_provider::encode<block_trace_v2>(const block_trace_v2& bt);
+
+   void store_provider::append(const encoded_block_trace& ebt) {
       fc::cfile trace;
       fc::cfile index;
-      const uint32_t slice_number = _slice_directory.slice_number(bt.number);
+      const uint32_t slice_number = _slice_directory.slice_number(ebt.number);
       _slice_directory.find_or_create_slice_pair(slice_number, open_state::write, trace, index);
-      // storing as static_variant to allow adding other data types to the trace file in the future
-      const uint64_t offset = append_store(data_log_entry { bt }, trace);
+      const uint64_t offset = append_store_data(ebt.data, trace);
 
-      auto be = metadata_log_entry { block_entry_v0 { .id = bt.id, .number = bt.number, .offset = offset }};
+      auto be = metadata_log_entry { block_entry_v0 { .id = ebt.id, .number = ebt.number, .offset = offset }};
       append_store(be, index);
-   }
 
-   template void store_provider::append<block_trace_v1>(const block_trace_v1& bt);
-   template void store_provider::append<block_trace_v2>(const block_trace_v2& bt);
+      fc::cfile trx_ids;
+      _slice_directory.find_or_create_trx_id_slice(slice_number, open_state::write, trx_ids);
+      append_store(trx_id_log_entry { block_trxs_entry_v0 { .number = ebt.number, .ids = ebt.trx_ids }}, trx_ids);
+   }
 
    void store_provider::append_lib(uint32_t lib) {
       fc::cfile index;
@@ -60,43 +93,180 @@ namespace eosio::trace_api {
    }
 
    get_block_t store_provider::get_block(uint32_t block_height, const yield_function& yield) {
-      std::optional<uint64_t> trace_offset;
-      bool irreversible = false;
-      uint64_t offset = scan_metadata_log_from(block_height, 0, [&block_height, &trace_offset, &irreversible](const metadata_log_entry& e) -> bool {
-         if (std::holds_alternative<block_entry_v0>(e)) {
-            const auto& block = std::get<block_entry_v0>(e);
-            if (block.number == block_height) {
-               trace_offset = block.offset;
-            }
-         } else if (std::holds_alternative<lib_entry_v0>(e)) {
-            auto lib = std::get<lib_entry_v0>(e).lib;
-            if (lib >= block_height) {
-               irreversible = true;
-               return false;
-            }
-         }
-         return true;
-      }, yield);
-      if (!trace_offset) {
+      const auto block = find_block_offset(block_height, yield);
+      if (!block) {
          return get_block_t{};
       }
-      std::optional<data_log_entry> entry = read_data_log(block_height, *trace_offset);
+      std::optional<data_log_entry> entry = read_mapped_data_log(block_height, std::get<0>(*block));
       if (!entry) {
          return get_block_t{};
       }
-      return std::make_tuple( entry.value(), irreversible );
+      return std::make_tuple( entry.value(), std::get<1>(*block) );
+   }
+
+   std::optional<std::tuple<uint64_t, bool>> store_provider::find_block_offset(uint32_t block_height, const yield_function& yield) {
+      const uint32_t slice_number = _slice_directory.slice_number(block_height);
+      fc::cfile index;
+      const bool dont_open_file = false;
+      const bool found = _slice_directory.find_index_slice(slice_number, open_state::read, index, dont_open_file);
+
+      std::lock_guard g(_cache_mtx);
+      if (!found) {
+         // removed by maintenance
+         _cached_slices.erase(slice_number);
+         return {};
+      }
+
+      const uint64_t end = file_size(index.get_file_path());
+      auto& slice = _cached_slices[slice_number];
+      slice.last_used = ++_cache_uses;
+      if (end < slice.index_size) {
+         // replaced by a new log
+         slice = cached_slice{ .last_used = slice.last_used };
+      }
+      if (slice.index_size < end && !(slice.lib && *slice.lib >= block_height)) {
+         _slice_directory.find_index_slice(slice_number, open_state::read, index);
+         if (slice.index_size == 0) {
+            slice.index_size = index.tellp();
+         } else {
+            index.seek(slice.index_size);
+         }
+         // entries after a lib covering the block cannot change it
+         while (slice.index_size < end && !(slice.lib && *slice.lib >= block_height)) {
+            yield();
+            const auto metadata = extract_store<metadata_log_entry>(index);
+            if (std::holds_alternative<block_entry_v0>(metadata)) {
+               const auto& b = std::get<block_entry_v0>(metadata);
+               slice.block_offsets[b.number] = b.offset;
+            } else if (std::holds_alternative<lib_entry_v0>(metadata)) {
+               const auto lib = std::get<lib_entry_v0>(metadata).lib;
+               slice.lib = std::max(slice.lib.value_or(0), lib);
+            }
+            slice.index_size = index.tellp();
+         }
+      }
+
+      std::optional<std::tuple<uint64_t, bool>> result;
+      const auto itr = slice.block_offsets.find(block_height);
+      if (itr != slice.block_offsets.end()) {
+         result = std::make_tuple(itr->second, slice.lib && *slice.lib >= block_height);
+      }
+
+      if (_cached_slices.size() > max_cached_slices) {
+         auto lru = std::min_element(_cached_slices.begin(), _cached_slices.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.second.last_used < rhs.second.last_used;
+         });
+         _cached_slices.erase(lru);
+      }
+      return result;
+   }
+
+   std::optional<data_log_entry> store_provider::read_mapped_data_log(uint32_t block_height, uint64_t offset) {
+      const uint32_t slice_number = _slice_directory.slice_number(block_height);
+      std::shared_ptr<const boost::iostreams::mapped_file_source> trace;
+      {
+         std::lock_guard g(_cache_mtx);
+         auto itr = _cached_slices.find(slice_number);
+         if (itr != _cached_slices.end()) {
+            trace = itr->second.trace;
+         }
+      }
+
+      if (!trace || offset >= trace->size()) {
+         fc::cfile trace_file;
+         const bool dont_open_file = false;
+         if (!_slice_directory.find_trace_slice(slice_number, open_state::read, trace_file, dont_open_file) ||
+             file_size(trace_file.get_file_path()) <= offset) {
+            // compressed, or reported as missing
+            return read_data_log(block_height, offset);
+         }
+         trace = std::make_shared<const boost::iostreams::mapped_file_source>(trace_file.get_file_path().generic_string());
+
+         std::lock_guard g(_cache_mtx);
+         auto itr = _cached_slices.find(slice_number);
+         if (itr != _cached_slices.end()) {
+            itr->second.trace = trace;
+         }
+      }
+
+      // a mapping stays valid if the log is removed, as when it is compressed
+      fc::datastream<const char*> ds(trace->data() + offset, trace->size() - offset);
+      data_log_entry entry;
+      fc::raw::unpack(ds, entry);
+      return entry;
    }
 
-   slice_directory::slice_directory(const bfs::path& slice_dir, uint32_t width, std::optional<uint32_t> minimum_irreversible_history_blocks, std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride)
+   std::optional<uint32_t> store_provider::get_trx_block_number(const chain::transaction_id_type& id, const yield_function& yield) {
+      for (uint32_t slice_number : _slice_directory.trx_id_slice_numbers()) {
+         yield();
+         fc::cfile file;
+         if (_slice_directory.find_compacted_trx_id_slice(slice_number, file)) {
+            // binary search of the records sorted by id
+            const uint64_t begin = file.tellp();
+            const uint64_t count = (file_size(file.get_file_path()) - begin) / trx_block_entry_v0::packed_size;
+            uint64_t low = 0, high = count;
+            while (low < high) {
+               yield();
+               const uint64_t mid = low + (high - low) / 2;
+               file.seek(begin + mid * trx_block_entry_v0::packed_size);
+               if (extract_store<trx_block_entry_v0>(file).id < id) {
+                  low = mid + 1;
+               } else {
+                  high = mid;
+               }
+            }
+            if (low < count) {
+               file.seek(begin + low * trx_block_entry_v0::packed_size);
+               const auto entry = extract_store<trx_block_entry_v0>(file);
+               if (entry.id == id) {
+                  return entry.number;
+               }
+            }
+            continue;
+         }
+
+         if (!_slice_directory.find_trx_id_slice(slice_number, open_state::read, file)) {
+            continue;
+         }
+         std::optional<uint32_t> block_number;
+         const uint64_t end = file_size(file.get_file_path());
+         while (file.tellp() < end) {
+            yield();
+            const auto entry = std::get<block_trxs_entry_v0>(extract_store<trx_id_log_entry>(file));
+            if (std::find(entry.ids.begin(), entry.ids.end(), id) != entry.ids.end()) {
+               block_number = entry.number;
+            } else if (block_number && entry.number <= *block_number) {
+               // a fork replaced the block of the transaction
+               block_number.reset();
+            }
+         }
+         if (block_number) {
+            return block_number;
+         }
+      }
+      return {};
+   }
+
+   slice_directory::slice_directory(const bfs::path& slice_dir, uint32_t width, std::optional<uint32_t> minimum_irreversible_history_blocks, std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride,
+                                    compression_format compression, size_t compression_threads, size_t frame_cache_size,
+                                    const bfs::path& cold_slice_dir, std::optional<uint32_t> minimum_hot_irreversible_history_blocks)
    : _slice_dir(slice_dir)
    , _width(width)
    , _minimum_irreversible_history_blocks(minimum_irreversible_history_blocks)
    , _minimum_uncompressed_irreversible_history_blocks(minimum_uncompressed_irreversible_history_blocks)
    , _compression_seek_point_stride(compression_seek_point_stride)
+   , _compression(compression)
+   , _compression_threads(std::max<size_t>(compression_threads, 1))
+   , _frame_cache(frame_cache_size ? std::make_shared<compressed_frame_cache>(frame_cache_size) : nullptr)
+   , _cold_slice_dir(cold_slice_dir)
+   , _minimum_hot_irreversible_history_blocks(minimum_hot_irreversible_history_blocks)
    , _best_known_lib(0) {
       if (!exists(_slice_dir)) {
          bfs::create_directories(slice_dir);
       }
+      if (!_cold_slice_dir.empty() && !exists(_cold_slice_dir)) {
+         bfs::create_directories(_cold_slice_dir);
+      }
    }
 
    bool slice_directory::find_or_create_index_slice(uint32_t slice_number, open_state state, fc::cfile& index_file) const {
@@ -162,20 +332,158 @@ namespace eosio::trace_api {
    }
 
    std::optional<compressed_file> slice_directory::find_compressed_trace_slice(uint32_t slice_number, bool open_file ) const {
-      auto filename = make_filename(_trace_prefix, _compressed_trace_ext, slice_number, _width);
-      const path slice_path = _slice_dir / filename;
+      // a slice is copied to the cold directory before it is removed from the slice directory
+      for (const path* dir : { &_slice_dir, &_cold_slice_dir }) {
+         if (dir->empty()) {
+            continue;
+         }
+         for (auto format : { compression_format::zlib, compression_format::zstd }) {
+            const path slice_path = compressed_trace_slice_path(*dir, slice_number, format);
+            if (exists(slice_path)) {
+               auto result = compressed_file(slice_path, format, _frame_cache);
+               if (open_file) {
+                  try {
+                     result.open();
+                  } catch (...) {
+                     // moved to the cold directory since it was found
+                     if (exists(slice_path)) {
+                        throw;
+                     }
+                     continue;
+                  }
+               }
+
+               return std::move(result);
+            }
+         }
+      }
+      return {};
+   }
+
+   path slice_directory::compressed_trace_slice_path(uint32_t slice_number, compression_format format) const {
+      return compressed_trace_slice_path(_slice_dir, slice_number, format);
+   }
+
+   path slice_directory::compressed_trace_slice_path(const path& dir, uint32_t slice_number, compression_format format) const {
+      const char* ext = format == compression_format::zstd ? _zstd_compressed_trace_ext : _compressed_trace_ext;
+      return dir / make_filename(_trace_prefix, ext, slice_number, _width);
+   }
+
+   bool slice_directory::offload_compressed_trace_slice(uint32_t slice_number) const {
+      for (auto format : { compression_format::zlib, compression_format::zstd }) {
+         const path slice_path = compressed_trace_slice_path(_slice_dir, slice_number, format);
+         if (!exists(slice_path)) {
+            continue;
+         }
+
+         const path cold_path = compressed_trace_slice_path(_cold_slice_dir, slice_number, format);
+         const path temp_path = cold_path.generic_string() + ".tmp";
+         bfs::copy_file(slice_path, temp_path, bfs::copy_option::overwrite_if_exists);
+         {
+            fc::cfile temp;
+            temp.set_file_path(temp_path);
+            temp.open(fc::cfile::update_rw_mode);
+            temp.sync();
+         }
+         bfs::rename(temp_path, cold_path);
+         bfs::remove(slice_path);
+         return true;
+      }
+      return false;
+   }
+
+   bool slice_directory::find_or_create_trx_id_slice(uint32_t slice_number, open_state state, fc::cfile& trx_id_file) const {
+      const bool found = find_trx_id_slice(slice_number, state, trx_id_file);
+      if( !found ) {
+         create_new_index_slice_file(trx_id_file);
+      }
+      return found;
+   }
+
+   bool slice_directory::find_trx_id_slice(uint32_t slice_number, open_state state, fc::cfile& trx_id_file, bool open_file) const {
+      const bool found = find_slice(_trx_id_prefix, slice_number, trx_id_file, open_file);
+      if( !found || !open_file ) {
+         return found;
+      }
+
+      validate_existing_index_slice_file(trx_id_file, state);
+      return true;
+   }
+
+   bool slice_directory::find_compacted_trx_id_slice(uint32_t slice_number, fc::cfile& compacted_file, bool open_file) const {
+      const path slice_path = _slice_dir / make_filename(_trx_id_prefix, _compacted_trx_id_ext, slice_number, _width);
+      compacted_file.set_file_path(slice_path);
+
       const bool file_exists = exists(slice_path);
+      if( !file_exists || !open_file ) {
+         return file_exists;
+      }
+
+      compacted_file.open(fc::cfile::update_rw_mode);
+      validate_existing_index_slice_file(compacted_file, open_state::read);
+      return true;
+   }
 
-      if (file_exists) {
-         auto result = compressed_file(slice_path);
-         if (open_file) {
-            result.open();
+   std::vector<uint32_t> slice_directory::trx_id_slice_numbers() const {
+      const size_t prefix_size = std::char_traits<char>::length(_trx_id_prefix);
+      std::set<uint32_t, std::greater<uint32_t>> slice_numbers;
+      for (const auto& entry : directory_iterator(_slice_dir)) {
+         const std::string filename = entry.path().filename().generic_string();
+         if (filename.compare(0, prefix_size, _trx_id_prefix) != 0 || filename.size() < prefix_size + 10) {
+            continue;
          }
+         try {
+            slice_numbers.insert(slice_number(std::stoul(filename.substr(prefix_size, 10))));
+         } catch (const std::logic_error&) {
+            // not a slice file
+         }
+      }
+      return std::vector<uint32_t>(slice_numbers.begin(), slice_numbers.end());
+   }
 
-         return std::move(result);
-      } else {
-         return {};
+   void slice_directory::compact_trx_id_slice(uint32_t slice_number) const {
+      fc::cfile trx_ids;
+      if (!find_trx_id_slice(slice_number, open_state::read, trx_ids)) {
+         return;
+      }
+
+      // a block appended again was switched to by a fork, which also replaced the blocks after it
+      std::map<uint32_t, std::vector<chain::transaction_id_type>> blocks;
+      const uint64_t end = file_size(trx_ids.get_file_path());
+      while (trx_ids.tellp() < end) {
+         auto entry = std::get<block_trxs_entry_v0>(extract_store<trx_id_log_entry>(trx_ids));
+         blocks.erase(blocks.lower_bound(entry.number), blocks.end());
+         blocks[entry.number] = std::move(entry.ids);
+      }
+      trx_ids.close();
+
+      std::vector<trx_block_entry_v0> records;
+      for (const auto& [number, ids] : blocks) {
+         for (const auto& id : ids) {
+            records.push_back(trx_block_entry_v0 { .id = id, .number = number });
+         }
+      }
+      std::sort(records.begin(), records.end(), [](const auto& lhs, const auto& rhs) { return lhs.id < rhs.id; });
+
+      fc::cfile compacted;
+      find_compacted_trx_id_slice(slice_number, compacted, false);
+      const path compacted_path = compacted.get_file_path();
+      const path temp_path = compacted_path.generic_string() + ".tmp";
+      {
+         fc::cfile temp;
+         temp.set_file_path(temp_path);
+         temp.open(fc::cfile::truncate_rw_mode);
+         auto data = fc::raw::pack(index_header { .version = _current_version });
+         for (const auto& r : records) {
+            const auto packed = fc::raw::pack(r);
+            data.insert(data.end(), packed.begin(), packed.end());
+         }
+         temp.write(data.data(), data.size());
+         temp.flush();
+         temp.sync();
       }
+      bfs::rename(temp_path, compacted_path);
+      bfs::remove(trx_ids.get_file_path());
    }
 
    bool slice_directory::find_slice(const char* slice_prefix, uint32_t slice_number, fc::cfile& slice_file, bool open_file) const {
@@ -285,20 +593,53 @@ namespace eosio::trace_api {
                bfs::remove(trace.get_file_path());
             }
 
-            auto ctrace = find_compressed_trace_slice(slice_to_clean, dont_open_file);
-            if (ctrace) {
-               log(std::string("Removing: ") + ctrace->get_file_path().generic_string());
-               bfs::remove(ctrace->get_file_path());
+            for (const path* dir : { &_slice_dir, &_cold_slice_dir }) {
+               if (dir->empty()) {
+                  continue;
+               }
+               for (auto format : { compression_format::zlib, compression_format::zstd }) {
+                  const auto ctrace = compressed_trace_slice_path(*dir, slice_to_clean, format);
+                  if (exists(ctrace)) {
+                     log(std::string("Removing: ") + ctrace.generic_string());
+                     bfs::remove(ctrace);
+                  }
+               }
+            }
+
+            fc::cfile trx_ids;
+            if (find_trx_id_slice(slice_to_clean, open_state::read, trx_ids, dont_open_file)) {
+               log(std::string("Removing: ") + trx_ids.get_file_path().generic_string());
+               bfs::remove(trx_ids.get_file_path());
+            }
+            if (find_compacted_trx_id_slice(slice_to_clean, trx_ids, dont_open_file)) {
+               log(std::string("Removing: ") + trx_ids.get_file_path().generic_string());
+               bfs::remove(trx_ids.get_file_path());
             }
          });
       }
 
+      // the transaction ids of a slice are compacted once all its blocks are irreversible
+      process_irreversible_slice_range(lib, 0, _last_compacted_trx_id_slice, [this, &log](uint32_t slice_to_compact){
+         fc::cfile trx_ids;
+         const bool dont_open_file = false;
+         if (find_trx_id_slice(slice_to_compact, open_state::read, trx_ids, dont_open_file)) {
+            log(std::string("Compacting: ") + trx_ids.get_file_path().generic_string());
+            compact_trx_id_slice(slice_to_compact);
+         }
+      });
+
       // Only process compression if its configured AND there is a range of irreversible blocks which would not also
       // be deleted
       if (_minimum_uncompressed_irreversible_history_blocks &&
           (!_minimum_irreversible_history_blocks || *_minimum_uncompressed_irreversible_history_blocks < *_minimum_irreversible_history_blocks) )
       {
-         process_irreversible_slice_range(lib, *_minimum_uncompressed_irreversible_history_blocks, _last_compressed_slice, [this, &log](uint32_t slice_to_compress){
+         std::vector<uint32_t> slices_to_compress;
+         const auto first_uncompressed_slice = _last_compressed_slice;
+         process_irreversible_slice_range(lib, *_minimum_uncompressed_irreversible_history_blocks, _last_compressed_slice, [&slices_to_compress](uint32_t slice_to_compress){
+            slices_to_compress.push_back(slice_to_compress);
+         });
+
+         auto compress = [this, &log](uint32_t slice_to_compress) {
             fc::cfile trace;
             const bool dont_open_file = false;
             const bool trace_found = find_trace_slice(slice_to_compress, open_state::read, trace, dont_open_file);
@@ -306,17 +647,56 @@ namespace eosio::trace_api {
             log(std::string("Attempting compression of slice: ") + std::to_string(slice_to_compress));
 
             if (trace_found) {
-               auto compressed_path = trace.get_file_path();
-               compressed_path.replace_extension(_compressed_trace_ext);
+               const auto compressed_path = compressed_trace_slice_path(slice_to_compress, _compression);
 
                log(std::string("Compressing: ") + trace.get_file_path().generic_string());
-               compressed_file::process(trace.get_file_path(), compressed_path.generic_string(), _compression_seek_point_stride);
+               compressed_file::process(trace.get_file_path(), compressed_path.generic_string(), _compression_seek_point_stride, _compression);
 
                // after compression is complete, delete the old uncompressed file
                log(std::string("Removing: ") + trace.get_file_path().generic_string());
                bfs::remove(trace.get_file_path());
             }
-         });
+         };
+
+         // slices are independent, so a backlog of them is compressed _compression_threads at a time
+         for (size_t batch = 0; batch < slices_to_compress.size(); batch += _compression_threads) {
+            const size_t batch_end = std::min(batch + _compression_threads, slices_to_compress.size());
+            std::vector<std::future<void>> compressions;
+            for (size_t i = batch + 1; i < batch_end; ++i) {
+               compressions.emplace_back(std::async(std::launch::async, compress, slices_to_compress[i]));
+            }
+            std::exception_ptr failure;
+            try {
+               compress(slices_to_compress[batch]);
+            } catch (...) {
+               failure = std::current_exception();
+            }
+            for (auto& c : compressions) {
+               try {
+                  c.get();
+               } catch (...) {
+                  if (!failure) failure = std::current_exception();
+               }
+            }
+            if (failure) {
+               // retry the batch on the next run
+               _last_compressed_slice = batch > 0 ? std::optional<uint32_t>(slices_to_compress[batch - 1]) : first_uncompressed_slice;
+               std::rethrow_exception(failure);
+            }
+         }
+
+         // slices are moved once compressed, the ones which will soon be removed are left in place
+         if (!_cold_slice_dir.empty() && _minimum_hot_irreversible_history_blocks &&
+             *_minimum_hot_irreversible_history_blocks >= *_minimum_uncompressed_irreversible_history_blocks &&
+             (!_minimum_irreversible_history_blocks || *_minimum_hot_irreversible_history_blocks < *_minimum_irreversible_history_blocks))
+         {
+            process_irreversible_slice_range(lib, *_minimum_hot_irreversible_history_blocks, _last_offloaded_slice, [this, &log](uint32_t slice_to_offload){
+               log(std::string("Attempting offload of slice: ") + std::to_string(slice_to_offload));
+               if (offload_compressed_trace_slice(slice_to_offload)) {
+                  log(std::string("Moved slice ") + std::to_string(slice_to_offload) + " to " + _cold_slice_dir.generic_string());
+               }
+            });
+         }
       }
    }
 }
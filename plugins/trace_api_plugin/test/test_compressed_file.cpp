@@ -212,5 +212,41 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(blob_access_no_seek_points, T, test_types, temp
    }
 }
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(zstd_random_access, T, test_types, temp_file_fixture) {
+   if (!compressed_file::zstd_supported()) {
+      return;
+   }
+
+   auto data = std::vector<T>(128);
+   std::generate(data.begin(), data.end(), []() {
+      return make_random<T>();
+   });
+
+   auto uncompressed_filename = create_temp_file(data.data(), data.size() * sizeof(T));
+   auto compressed_filename = create_temp_file(nullptr, 0);
+
+   BOOST_TEST(compressed_file::process(uncompressed_filename, compressed_filename, 512, compression_format::zstd));
+
+   // reads through the frame cache, spanning frames, return the same data as reads decompressing each frame
+   auto cache = std::make_shared<compressed_frame_cache>(4 * 1024);
+   for (const auto& frame_cache : { std::shared_ptr<compressed_frame_cache>(), cache, cache }) {
+      for (std::size_t i = 0; i < data.size(); i++) {
+         auto actual_data = std::vector<T>(128);
+         auto compf = compressed_file(compressed_filename, compression_format::zstd, frame_cache);
+         compf.open();
+         compf.seek(i * sizeof(T));
+         compf.read(reinterpret_cast<char*>(actual_data.data()), (actual_data.size() - i) * sizeof(T));
+         compf.close();
+         BOOST_REQUIRE_EQUAL_COLLECTIONS(data.begin() + i, data.end(), actual_data.begin(), actual_data.end() - i);
+      }
+   }
+
+   // reading past the end fails
+   auto compf = compressed_file(compressed_filename, compression_format::zstd, cache);
+   compf.open();
+   compf.seek(data.size() * sizeof(T) - 1);
+   char c[2];
+   BOOST_CHECK_THROW(compf.read(c, 2), std::ios_base::failure);
+}
 
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
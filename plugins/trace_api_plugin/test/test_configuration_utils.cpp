@@ -8,6 +8,8 @@
 
 using namespace eosio;
 using namespace eosio::trace_api::configuration_utils;
+using namespace eosio::chain::literals;
+using eosio::trace_api::action_filter;
 
 namespace bfs = boost::filesystem;
 
@@ -58,6 +60,26 @@ BOOST_AUTO_TEST_SUITE(configuration_utils_tests)
 
    }
 
+   BOOST_AUTO_TEST_CASE(action_filter_test)
+   {
+      using result = action_filter::result;
+
+      action_filter filter;
+      filter.include.push_back(parse_action_filter_rule("::transfer"));
+      filter.exclude.push_back(parse_action_filter_rule("spam:eosio.token:"));
+      BOOST_TEST( (filter.apply("alice"_n, "eosio.token"_n, "transfer"_n) == result::keep) );
+      BOOST_TEST( (filter.apply("spam"_n, "eosio.token"_n, "transfer"_n) == result::drop) );
+      BOOST_TEST( (filter.apply("alice"_n, "eosio.token"_n, "issue"_n) == result::drop) );
+
+      filter.strip_data = true;
+      BOOST_TEST( (filter.apply("spam"_n, "eosio.token"_n, "transfer"_n) == result::strip) );
+
+      // receiver:account:action only
+      BOOST_REQUIRE_THROW(parse_action_filter_rule("alice:transfer"), chain::plugin_config_exception);
+      BOOST_REQUIRE_THROW(parse_action_filter_rule("alice::transfer:"), chain::plugin_config_exception);
+      BOOST_REQUIRE_THROW(parse_action_filter_rule("Alice::"), chain::plugin_config_exception);
+   }
+
    BOOST_FIXTURE_TEST_CASE(abi_def_from_file_test, temp_file_fixture)
    {
       auto data_dir = fc::path(bfs::temp_directory_path());
@@ -180,6 +180,10 @@ struct extraction_test_fixture {
          fixture.data_log.emplace_back(entry);
       }
 
+      void append( const block_trace_source& source ) {
+         append(to_block_trace(source));
+      }
+
       void append_lib( uint32_t lib ) {
          fixture.max_lib = std::max(fixture.max_lib, lib);
       }
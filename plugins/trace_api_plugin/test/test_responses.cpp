@@ -1069,5 +1069,48 @@ BOOST_AUTO_TEST_SUITE(trace_responses)
 
       BOOST_REQUIRE_THROW(get_block_trace( 1, yield ), yield_exception);
    }
+   BOOST_FIXTURE_TEST_CASE(cached_irreversible_responses, response_test_fixture)
+   {
+      auto block_trace = block_trace_v2 {
+         "b000000000000000000000000000000000000000000000000000000000000001"_h,
+         1,
+         "0000000000000000000000000000000000000000000000000000000000000000"_h,
+         chain::block_timestamp_type(0),
+         "bp.one"_n,
+         "0000000000000000000000000000000000000000000000000000000000000000"_h,
+         "0000000000000000000000000000000000000000000000000000000000000000"_h,
+         0,
+         std::vector<transaction_trace_v2>{}
+      };
+
+      int reads = 0;
+      mock_get_block = [&]( uint32_t height, const yield_function& ) -> get_block_t {
+         ++reads;
+         auto bt = block_trace;
+         bt.number = height;
+         // blocks below 10 are irreversible
+         return std::make_tuple(data_log_entry(bt), height < 10);
+      };
+
+      response_impl_type cached_impl(mock_logfile_provider(*this), mock_data_handler_provider(*this), 2);
+      const auto response = cached_impl.get_block_trace(1);
+      BOOST_TEST(to_kv(cached_impl.get_block_trace(1)) == to_kv(response), boost::test_tools::per_element());
+      BOOST_REQUIRE_EQUAL(reads, 1);
+
+      // pending blocks are read again
+      cached_impl.get_block_trace(10);
+      cached_impl.get_block_trace(10);
+      BOOST_REQUIRE_EQUAL(reads, 3);
+
+      // the least recently used response is dropped
+      cached_impl.get_block_trace(2);
+      cached_impl.get_block_trace(1);
+      cached_impl.get_block_trace(3);
+      BOOST_REQUIRE_EQUAL(reads, 5);
+      cached_impl.get_block_trace(1);
+      BOOST_REQUIRE_EQUAL(reads, 5);
+      cached_impl.get_block_trace(2);
+      BOOST_REQUIRE_EQUAL(reads, 6);
+   }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -786,6 +786,67 @@ BOOST_AUTO_TEST_SUITE(slice_tests)
       BOOST_REQUIRE_EQUAL(files.size(), 0);
    }
 
+   BOOST_FIXTURE_TEST_CASE(slice_dir_compress_and_offload, test_fixture)
+   {
+      fc::temp_directory tempdir;
+      fc::temp_directory cold_tempdir;
+      const uint32_t width = 10;
+      const uint32_t min_uncompressed_blocks = 5;
+      const uint32_t min_hot_blocks = min_uncompressed_blocks + width;
+      slice_directory sd(tempdir.path(), width, std::optional<uint32_t>(), std::optional<uint32_t>(min_uncompressed_blocks), 8,
+                         compression_format::zlib, 1, 0, cold_tempdir.path(), std::optional<uint32_t>(min_hot_blocks));
+      fc::cfile file;
+
+      using file_vector_t = std::vector<std::tuple<bfs::path, bfs::path, bfs::path>>;
+      file_vector_t file_paths;
+      for (int i = 0; i < 7 ; i++) {
+         BOOST_REQUIRE(!sd.find_or_create_index_slice(i, open_state::read, file));
+         auto index_name = file.get_file_path().filename();
+         BOOST_REQUIRE(create_non_empty_trace_slice(sd, i, file));
+         auto trace_name = file.get_file_path().filename();
+         auto compressed_trace_name = trace_name;
+         compressed_trace_name.replace_extension(".clog");
+         file_paths.emplace_back(index_name, trace_name, compressed_trace_name);
+      }
+
+      std::set<bfs::path> files;
+      for (const auto& e: file_paths) {
+         files.insert(std::get<0>(e));
+         files.insert(std::get<1>(e));
+      }
+      std::set<bfs::path> cold_files;
+
+      for (std::size_t reps = 0; reps < file_paths.size() + 1; reps++) {
+         //  leading edge,
+         //  compresses one slice IF its not past the end of our test,
+         if (reps < file_paths.size()) {
+            files.erase(std::get<1>(file_paths.at(reps)));
+            files.insert(std::get<2>(file_paths.at(reps)));
+         }
+
+         // moves one compressed slice IF its not the first, indices are kept
+         if (reps > 0) {
+            files.erase(std::get<2>(file_paths.at(reps-1)));
+            cold_files.insert(std::get<2>(file_paths.at(reps-1)));
+         }
+         sd.run_maintenance_tasks(15 + (reps * width), {});
+         verify_directory_contents(tempdir.path(), files);
+         verify_directory_contents(cold_tempdir.path(), cold_files);
+
+         // trailing edge, no change
+         sd.run_maintenance_tasks(24 + (reps * width), {});
+         verify_directory_contents(tempdir.path(), files);
+         verify_directory_contents(cold_tempdir.path(), cold_files);
+      }
+
+      // moved slices are still found
+      for (uint32_t i = 0; i < file_paths.size(); i++) {
+         auto ctrace = sd.find_compressed_trace_slice(i);
+         BOOST_REQUIRE(ctrace);
+         BOOST_REQUIRE_EQUAL(bfs::path(ctrace->get_file_path()).parent_path().generic_string(), cold_tempdir.path().generic_string());
+      }
+   }
+
    BOOST_FIXTURE_TEST_CASE(store_provider_write_read_v1, test_fixture)
    {
       fc::temp_directory tempdir;
@@ -1001,16 +1062,13 @@ BOOST_AUTO_TEST_SUITE(slice_tests)
       const auto block2_bt = std::get<0>(*block2);
       BOOST_REQUIRE_EQUAL(std::get<block_trace_v1>(block2_bt), bt2_v1);
 
+      // the index is not scanned again
       count = 0;
-      try {
-         sp.get_block(5,[&count]() {
-            if (++count >= 3) {
-               throw yield_exception("");
-            }
-         });
-         BOOST_FAIL("Should not have completed scan");
-      } catch (const yield_exception& ex) {
-      }
+      block2 = sp.get_block(5,[&count]() {
+         ++count;
+      });
+      BOOST_REQUIRE(block2);
+      BOOST_REQUIRE_EQUAL(count, 0);
 
       count = 0;
       block2 = sp.get_block(2,[&count]() {
@@ -1050,16 +1108,13 @@ BOOST_AUTO_TEST_SUITE(slice_tests)
       const auto block2_bt = std::get<0>(*block2);
       BOOST_REQUIRE_EQUAL(std::get<block_trace_v2>(block2_bt), block_trace2_v2);
 
+      // the index is not scanned again
       count = 0;
-      try {
-         sp.get_block(5,[&count]() {
-            if (++count >= 3) {
-               throw yield_exception("");
-            }
-         });
-         BOOST_FAIL("Should not have completed scan");
-      } catch (const yield_exception& ex) {
-      }
+      block2 = sp.get_block(5,[&count]() {
+         ++count;
+      });
+      BOOST_REQUIRE(block2);
+      BOOST_REQUIRE_EQUAL(count, 0);
 
       count = 0;
       block2 = sp.get_block(2,[&count]() {
@@ -1070,5 +1125,82 @@ BOOST_AUTO_TEST_SUITE(slice_tests)
       BOOST_REQUIRE(!block2);
    }
 
+   BOOST_FIXTURE_TEST_CASE(test_get_block_appended_after_read, test_fixture)
+   {
+      fc::temp_directory tempdir;
+      store_provider sp(tempdir.path(), 100, std::optional<uint32_t>(), std::optional<uint32_t>(), 0);
+      auto make_block = [&](uint32_t number, chain::name producer) {
+         auto bt = block_trace1_v2;
+         bt.number = number;
+         bt.producer = producer;
+         return bt;
+      };
+
+      sp.append(make_block(1, "bp.one"_n));
+      auto block = sp.get_block(1);
+      BOOST_REQUIRE(block);
+      BOOST_REQUIRE_EQUAL(std::get<block_trace_v2>(std::get<0>(*block)), make_block(1, "bp.one"_n));
+      BOOST_REQUIRE(!sp.get_block(2));
+
+      // blocks appended after the slice was read, including forks of it, are found
+      sp.append(make_block(2, "bp.one"_n));
+      sp.append(make_block(2, "bp.two"_n));
+      sp.append_lib(2);
+      block = sp.get_block(2);
+      BOOST_REQUIRE(block);
+      BOOST_REQUIRE(std::get<1>(*block));
+      BOOST_REQUIRE_EQUAL(std::get<block_trace_v2>(std::get<0>(*block)), make_block(2, "bp.two"_n));
+   }
+
+   BOOST_FIXTURE_TEST_CASE(test_get_trx_block_number, test_fixture)
+   {
+      fc::temp_directory tempdir;
+      const uint32_t width = 10;
+      store_provider sp(tempdir.path(), width, std::optional<uint32_t>(), std::optional<uint32_t>(), 0);
+
+      auto make_block = [&](uint32_t number, std::vector<chain::transaction_id_type> ids) {
+         auto bt = block_trace1_v2;
+         bt.number = number;
+         auto& trxs = std::get<std::vector<transaction_trace_v2>>(bt.transactions);
+         trxs.clear();
+         for (const auto& id : ids) {
+            trxs.push_back(transaction_trace);
+            trxs.back().id = id;
+         }
+         return bt;
+      };
+      const auto trx1 = "0000000000000000000000000000000000000000000000000000000000000001"_h;
+      const auto trx2 = "0000000000000000000000000000000000000000000000000000000000000002"_h;
+      const auto trx3 = "0000000000000000000000000000000000000000000000000000000000000003"_h;
+      const auto trx4 = "0000000000000000000000000000000000000000000000000000000000000004"_h;
+
+      sp.append(make_block(1, {trx1}));
+      sp.append(make_block(5, {trx2, trx3}));
+      sp.append(make_block(6, {trx4}));
+      // fork switching block 5 and 6, trx3 is moved to block 7
+      sp.append(make_block(5, {trx2}));
+      sp.append(make_block(6, {}));
+      sp.append(make_block(7, {trx3}));
+      sp.append(make_block(12, {trx1}));
+
+      BOOST_REQUIRE_EQUAL(*sp.get_trx_block_number(trx1), 12u); // newest slice first
+      BOOST_REQUIRE_EQUAL(*sp.get_trx_block_number(trx2), 5u);
+      BOOST_REQUIRE_EQUAL(*sp.get_trx_block_number(trx3), 7u);
+      BOOST_REQUIRE(!sp.get_trx_block_number(trx4));
+
+      // compacting the irreversible slice gives the same results
+      slice_directory sd(tempdir.path(), width, std::optional<uint32_t>(), std::optional<uint32_t>(), 0);
+      sd.run_maintenance_tasks(19, {});
+      fc::cfile file;
+      BOOST_REQUIRE(!sd.find_trx_id_slice(0, open_state::read, file, false));
+      BOOST_REQUIRE(sd.find_compacted_trx_id_slice(0, file, false));
+      BOOST_REQUIRE(sd.find_trx_id_slice(1, open_state::read, file, false));
+
+      BOOST_REQUIRE_EQUAL(*sp.get_trx_block_number(trx1), 12u);
+      BOOST_REQUIRE_EQUAL(*sp.get_trx_block_number(trx2), 5u);
+      BOOST_REQUIRE_EQUAL(*sp.get_trx_block_number(trx3), 7u);
+      BOOST_REQUIRE(!sp.get_trx_block_number(trx4));
+      BOOST_REQUIRE(!sp.get_trx_block_number("0000000000000000000000000000000000000000000000000000000000000000"_h));
+   }
 
 BOOST_AUTO_TEST_SUITE_END()
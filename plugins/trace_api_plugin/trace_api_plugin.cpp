@@ -8,6 +8,7 @@
 #include <eosio/trace_api/configuration_utils.hpp>
 
 #include <eosio/resource_monitor_plugin/resource_monitor_plugin.hpp>
+#include <eosio/chain/thread_utils.hpp>
 
 #include <boost/signals2/connection.hpp>
 
@@ -68,26 +69,85 @@ namespace {
       }
    }
 
+   /**
+    * Runs a store write posted to the store executor. There is no extraction call stack left to unwind, so
+    * failures are logged and the application is shut down as the synchronous exception handler would.
+    */
+   template<typename F>
+   void async_store_write(F&& f) {
+      try {
+         f();
+      } catch (...) {
+         log_exception(MAKE_EXCEPTION_WITH_CONTEXT(std::current_exception()), fc::log_level::error);
+         app().post(appbase::priority::high, []() { app().quit(); });
+      }
+   }
+
    template<typename Store>
    struct shared_store_provider {
-      shared_store_provider(const std::shared_ptr<Store>& store)
+      /**
+       * @param executor if provided, appends run in order on it instead of on the calling thread
+       * @param encode_pool if provided with executor, block traces are converted and packed on it, in parallel,
+       * before their appends run in order on executor
+       */
+      shared_store_provider(const std::shared_ptr<Store>& store,
+                            const std::shared_ptr<chain::bounded_serial_executor>& executor = {},
+                            const std::shared_ptr<chain::named_thread_pool>& encode_pool = {})
       :store(store)
+      ,executor(executor)
+      ,encode_pool(encode_pool)
       {}
 
+      void append( block_trace_source&& source ) {
+         if (executor && encode_pool) {
+            auto encoded = chain::async_thread_pool(encode_pool->get_executor(), [source=std::move(source)]() {
+               return Store::encode(to_block_trace(source));
+            }).share();
+            // post blocks while the executor is full, which also bounds the encodes in flight
+            executor->post([store=store, encoded]() {
+               async_store_write([&]() { store->append(encoded.get()); });
+            });
+         } else if (executor) {
+            executor->post([store=store, source=std::move(source)]() {
+               async_store_write([&]() { store->append(Store::encode(to_block_trace(source))); });
+            });
+         } else {
+            store->append(to_block_trace(source));
+         }
+      }
+
       template <typename BlockTrace>
       void append( const BlockTrace& trace ) {
-         store->append(trace);
+         if (executor) {
+            executor->post([store=store, trace]() {
+               async_store_write([&]() { store->append(trace); });
+            });
+         } else {
+            store->append(trace);
+         }
       }
 
       void append_lib( uint32_t new_lib ) {
-         store->append_lib(new_lib);
+         if (executor) {
+            executor->post([store=store, new_lib]() {
+               async_store_write([&]() { store->append_lib(new_lib); });
+            });
+         } else {
+            store->append_lib(new_lib);
+         }
       }
 
       get_block_t get_block(uint32_t height, const yield_function& yield) {
          return store->get_block(height, yield);
       }
 
+      std::optional<uint32_t> get_trx_block_number(const chain::transaction_id_type& id, const yield_function& yield) {
+         return store->get_trx_block_number(id, yield);
+      }
+
       std::shared_ptr<Store> store;
+      std::shared_ptr<chain::bounded_serial_executor> executor;
+      std::shared_ptr<chain::named_thread_pool> encode_pool;
    };
 }
 
@@ -109,6 +169,20 @@ struct trace_api_common_impl {
       cfg_options("trace-minimum-uncompressed-irreversible-history-blocks", boost::program_options::value<int32_t>()->default_value(-1),
                   "Number of blocks to ensure are uncompressed past LIB. Compressed \"slice\" files are still accessible but may carry a performance loss on retrieval\n"
                   "A value of -1 indicates that automatic compression of \"slice\" files will be turned off.");
+      cfg_options("trace-compression-format", bpo::value<std::string>()->default_value("zlib"),
+                  "Compression of \"slice\" files, \"zlib\" or \"zstd\". zstd slices are split into independently compressed frames "
+                  "which are faster to read. Slices compressed in either format are readable.");
+      cfg_options("trace-compression-threads", bpo::value<uint16_t>()->default_value(2),
+                  "Number of \"slice\" files compressed at the same time when several are due");
+      cfg_options("trace-compressed-frame-cache-mb", bpo::value<uint32_t>()->default_value(64),
+                  "Size (in MiB) of the cache of decompressed frames of zstd compressed \"slice\" files, 0 to disable it");
+      cfg_options("trace-cold-dir", bpo::value<bfs::path>(),
+                  "the location of the directory compressed \"slice\" files are moved to, e.g. on a slower disk "
+                  "(absolute path or relative to application data dir)");
+      cfg_options("trace-minimum-hot-irreversible-history-blocks", boost::program_options::value<int32_t>()->default_value(-1),
+                  "Number of blocks to ensure are kept in trace-dir past LIB before compressed \"slice\" files are moved to trace-cold-dir. "
+                  "Moved \"slice\" files are still accessible.\n"
+                  "A value of -1 indicates that \"slice\" files will not be moved.");
    }
 
    void plugin_initialize(const appbase::variables_map& options) {
@@ -137,12 +211,52 @@ struct trace_api_common_impl {
          minimum_uncompressed_irreversible_history_blocks = uncompressed_blocks;
       }
 
+      const int32_t hot_blocks = options.at("trace-minimum-hot-irreversible-history-blocks").as<int32_t>();
+      EOS_ASSERT(hot_blocks >= -1, chain::plugin_config_exception,
+                 "\"trace-minimum-hot-irreversible-history-blocks\" must be greater to or equal to -1.");
+      if (hot_blocks > manual_slice_file_value) {
+         EOS_ASSERT(options.count("trace-cold-dir"), chain::plugin_config_exception,
+                    "\"trace-minimum-hot-irreversible-history-blocks\" requires \"trace-cold-dir\"");
+         EOS_ASSERT(minimum_uncompressed_irreversible_history_blocks && hot_blocks >= *minimum_uncompressed_irreversible_history_blocks,
+                    chain::plugin_config_exception,
+                    "only compressed \"slice\" files are moved, \"trace-minimum-hot-irreversible-history-blocks\" must be greater "
+                    "to or equal to \"trace-minimum-uncompressed-irreversible-history-blocks\"");
+         minimum_hot_irreversible_history_blocks = hot_blocks;
+      }
+      if (options.count("trace-cold-dir")) {
+         auto cold_dir_option = options.at("trace-cold-dir").as<bfs::path>();
+         if (cold_dir_option.is_relative())
+            cold_dir = app().data_dir() / cold_dir_option;
+         else
+            cold_dir = cold_dir_option;
+         EOS_ASSERT(cold_dir != trace_dir, chain::plugin_config_exception,
+                    "\"trace-cold-dir\" must not be \"trace-dir\"");
+         if (auto resmon_plugin = app().find_plugin<resource_monitor_plugin>())
+           resmon_plugin->monitor_directory(cold_dir);
+      }
+
+      const auto compression_option = options.at("trace-compression-format").as<std::string>();
+      compression_format compression = compression_format::zlib;
+      if (compression_option == "zstd") {
+         EOS_ASSERT(compressed_file::zstd_supported(), chain::plugin_config_exception,
+                    "\"trace-compression-format\" zstd is not supported by this build");
+         compression = compression_format::zstd;
+      } else {
+         EOS_ASSERT(compression_option == "zlib", chain::plugin_config_exception,
+                    "\"trace-compression-format\" must be zlib or zstd");
+      }
+
       store = std::make_shared<store_provider>(
          trace_dir,
          slice_stride,
          minimum_irreversible_history_blocks,
          minimum_uncompressed_irreversible_history_blocks,
-         compression_seek_point_stride
+         compression == compression_format::zstd ? zstd_frame_stride : compression_seek_point_stride,
+         compression,
+         options.at("trace-compression-threads").as<uint16_t>(),
+         uint64_t(options.at("trace-compressed-frame-cache-mb").as<uint32_t>()) * 1024 * 1024,
+         cold_dir,
+         minimum_hot_irreversible_history_blocks
       );
    }
 
@@ -162,9 +276,12 @@ struct trace_api_common_impl {
 
    std::optional<uint32_t> minimum_irreversible_history_blocks;
    std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks;
+   boost::filesystem::path cold_dir;
+   std::optional<uint32_t> minimum_hot_irreversible_history_blocks;
 
    static constexpr int32_t manual_slice_file_value = -1;
    static constexpr uint32_t compression_seek_point_stride = 6 * 1024 * 1024; // 6 MiB strides for clog seek points
+   static constexpr uint32_t zstd_frame_stride = 256 * 1024; // 256 KiB zstd frames, small enough to decompress per read
 
    std::shared_ptr<store_provider> store;
 };
@@ -192,6 +309,8 @@ struct trace_api_rpc_plugin_impl : public std::enable_shared_from_this<trace_api
             "Failure to specify this option when there are no trace-rpc-abi configuations will result in an Error.\n"
             "This option is mutually exclusive with trace-rpc-api"
       );
+      cfg_options("trace-response-cache-size", bpo::value<uint32_t>()->default_value(256),
+                  "Number of rendered get_block responses of irreversible blocks kept to answer repeated requests, 0 to disable");
    }
 
    void plugin_initialize(const appbase::variables_map& options) {
@@ -222,7 +341,8 @@ struct trace_api_rpc_plugin_impl : public std::enable_shared_from_this<trace_api
 
       req_handler = std::make_shared<request_handler_t>(
          shared_store_provider<store_provider>(common->store),
-         abi_data_handler::shared_provider(data_handler)
+         abi_data_handler::shared_provider(data_handler),
+         options.at("trace-response-cache-size").as<uint32_t>()
       );
    }
 
@@ -285,6 +405,48 @@ struct trace_api_rpc_plugin_impl : public std::enable_shared_from_this<trace_api
             http_plugin::handle_exception("trace_api", "get_block", body, cb);
          }
       });
+
+      http.add_async_handler("/v1/trace_api/get_transaction_trace",
+            [wthis=weak_from_this(), max_response_time](std::string, std::string body, url_response_callback cb)
+      {
+         auto that = wthis.lock();
+         if (!that) {
+            return;
+         }
+
+         auto trx_id = ([&body]() -> std::optional<chain::transaction_id_type> {
+            if (body.empty()) {
+               return {};
+            }
+
+            try {
+               auto input = fc::json::from_string(body);
+               return input.get_object()["id"].as<chain::transaction_id_type>();
+            } catch (...) {
+               return {};
+            }
+         })();
+
+         if (!trx_id) {
+            error_results results{400, "Bad or missing id"};
+            cb( 400, fc::variant( results ));
+            return;
+         }
+
+         try {
+
+            const auto deadline = that->calc_deadline( max_response_time );
+            auto resp = that->req_handler->get_transaction_trace(*trx_id, [deadline]() { FC_CHECK_DEADLINE(deadline); });
+            if (resp.is_null()) {
+               error_results results{404, "Transaction trace missing"};
+               cb( 404, fc::variant( results ));
+            } else {
+               cb( 200, std::move(resp) );
+            }
+         } catch (...) {
+            http_plugin::handle_exception("trace_api", "get_transaction_trace", body, cb);
+         }
+      });
    }
 
    void plugin_shutdown() {
@@ -302,6 +464,19 @@ struct trace_api_plugin_impl {
 
    static void set_program_options(appbase::options_description& cli, appbase::options_description& cfg) {
       auto cfg_options = cfg.add_options();
+      cfg_options("trace-async-queue-size", bpo::value<uint32_t>()->default_value(0),
+                  "Number of block traces that may be queued for writing on a dedicated thread instead of on the main thread.\n"
+                  "Block processing waits when the queue is full. A value of 0 writes traces synchronously on the main thread.");
+      cfg_options("trace-async-encode-threads", bpo::value<uint16_t>()->default_value(2),
+                  "Number of threads converting and packing queued block traces in parallel, they are still written in order.\n"
+                  "Only used when trace-async-queue-size is greater than 0. A value of 0 does it on the writing thread.");
+      cfg_options("trace-filter-include", bpo::value<vector<string>>()->composing(),
+                  "Store only the action traces which match one of these receiver:account:action filters, a blank part matches any.\n"
+                  "All action traces are included when none is given.");
+      cfg_options("trace-filter-exclude", bpo::value<vector<string>>()->composing(),
+                  "Do not store the action traces which match receiver:account:action, a blank part matches any.");
+      cfg_options("trace-filter-strip-data", bpo::bool_switch()->default_value(false),
+                  "Store the excluded action traces without their data and return value instead of dropping them");
    }
 
    void plugin_initialize(const appbase::variables_map& options) {
@@ -310,7 +485,30 @@ struct trace_api_plugin_impl {
          app().quit();
          throw yield_exception("shutting down");
       };
-      extraction = std::make_shared<chain_extraction_t>(shared_store_provider<store_provider>(common->store), log_exceptions_and_shutdown);
+
+      const auto async_queue_size = options.at("trace-async-queue-size").as<uint32_t>();
+      if (async_queue_size > 0) {
+         store_executor = std::make_shared<chain::bounded_serial_executor>("trace", async_queue_size);
+         const auto encode_threads = options.at("trace-async-encode-threads").as<uint16_t>();
+         if (encode_threads > 0) {
+            encode_pool = std::make_shared<chain::named_thread_pool>("trcenc", encode_threads);
+         }
+      }
+      auto filter = std::make_shared<action_filter>();
+      if (options.count("trace-filter-include")) {
+         for (const auto& f : options.at("trace-filter-include").as<vector<string>>()) {
+            filter->include.push_back(parse_action_filter_rule(f));
+         }
+      }
+      if (options.count("trace-filter-exclude")) {
+         for (const auto& f : options.at("trace-filter-exclude").as<vector<string>>()) {
+            filter->exclude.push_back(parse_action_filter_rule(f));
+         }
+      }
+      filter->strip_data = options.at("trace-filter-strip-data").as<bool>();
+
+      extraction = std::make_shared<chain_extraction_t>(shared_store_provider<store_provider>(common->store, store_executor, encode_pool),
+                                                        log_exceptions_and_shutdown, std::move(filter));
 
       auto& chain = app().find_plugin<chain_plugin>()->chain();
 
@@ -349,10 +547,19 @@ struct trace_api_plugin_impl {
    }
 
    void plugin_shutdown() {
+      if (store_executor) {
+         // queued appends wait on their encodes, so the pool is stopped after them
+         store_executor->stop();
+      }
+      if (encode_pool) {
+         encode_pool->stop();
+      }
       common->plugin_shutdown();
    }
 
    std::shared_ptr<trace_api_common_impl> common;
+   std::shared_ptr<chain::bounded_serial_executor> store_executor;
+   std::shared_ptr<chain::named_thread_pool> encode_pool;
 
    using chain_extraction_t = chain_extraction_impl_type<shared_store_provider<store_provider>>;
    std::shared_ptr<chain_extraction_t> extraction;
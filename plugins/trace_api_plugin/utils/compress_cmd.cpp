@@ -31,7 +31,7 @@ namespace {
    }
 
    std::string validate_output_path(const bpo::variables_map& vmap, const std::string& input_path) {
-      static const std::string default_output_extension = ".clog";
+      const std::string default_output_extension = vmap.count("zstd") ? ".zclog" : ".clog";
       std::string output_path;
       if (vmap.count("output-path")) {
          output_path = vmap.at("output-path").as<std::string>();
@@ -64,7 +64,7 @@ namespace {
          "\n"
          "Compress a trace file to into the \"clog\" format.  By default the name of the\n"
          "of the compressed file will the the same as the input-path with a changing the\n"
-         "extension to \"clog\"."
+         "extension to \"clog\", or \"zclog\" with --zstd."
          "\n\n"
          "Positional Options:\n"
          "  input-path                      path to the file to compress\n"
@@ -80,6 +80,7 @@ namespace {
       opts("seek-point-stride,s", bpo::value<uint32_t>()->default_value(512),
            "the number of bytes between seek points in a compressed trace.  "
            "A smaller stride may degrade compression efficiency but increase read efficiency");
+      opts("zstd,z", "compress to independent zstd frames of seek-point-stride bytes instead of a zlib stream");
 
       if (global_args.count("help")) {
          print_help_text(std::cout, vis_desc);
@@ -107,7 +108,9 @@ namespace {
             auto output_path = validate_output_path(vmap, input_path);
             auto seek_point_stride = vmap.at("seek-point-stride").as<uint32_t>();
 
-            if (!compressed_file::process(input_path, output_path, seek_point_stride)) {
+            const auto format = vmap.count("zstd") ? compression_format::zstd : compression_format::zlib;
+
+            if (!compressed_file::process(input_path, output_path, seek_point_stride, format)) {
                throw std::runtime_error("Unexpected compression failure");
             }
          } else {
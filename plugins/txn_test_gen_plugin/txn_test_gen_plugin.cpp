@@ -1,5 +1,6 @@
 #include <eosio/txn_test_gen_plugin/txn_test_gen_plugin.hpp>
 #include <eosio/chain_plugin/chain_plugin.hpp>
+#include <eosio/http_plugin/main_thread_queue.hpp>
 #include <eosio/chain/wast_to_wasm.hpp>
 #include <eosio/chain/thread_utils.hpp>
 
@@ -12,6 +13,10 @@
 #include <boost/asio/high_resolution_timer.hpp>
 #include <boost/algorithm/clamp.hpp>
 
+#include <array>
+#include <cmath>
+#include <mutex>
+
 #include <Inline/BasicTypes.h>
 #include <IR/Module.h>
 #include <IR/Validate.h>
@@ -28,10 +33,50 @@ namespace eosio { namespace detail {
   struct txn_test_gen_status {
      string status;
   };
+
+  /// a kind of transaction in a workload, generated in proportion to its weight
+  struct txn_test_gen_mix_entry {
+     uint32_t weight    = 1;
+     uint32_t actions   = 1; ///< transfers per transaction, each to another account
+     uint32_t memo_size = 0; ///< bytes of each transfer's memo, at least the salt
+  };
+
+  struct txn_test_gen_workload {
+     string                         salt;
+     uint32_t                       tps      = 1000; ///< target transactions per second
+     uint32_t                       accounts = 0;    ///< accounts authorizing transactions, 0 for all created
+     vector<txn_test_gen_mix_entry> mix;             ///< empty for single transfers
+  };
+
+  struct txn_test_gen_stats {
+     bool     running        = false;
+     double   elapsed_sec    = 0;
+     uint64_t sent           = 0;
+     uint64_t accepted       = 0;
+     uint64_t failed         = 0;
+     double   accepted_tps   = 0;
+     uint64_t avg_cpu_us     = 0;
+     uint64_t avg_latency_us = 0; ///< from handing a transaction to chain_plugin until it's accepted
+     uint64_t p50_latency_us = 0; ///< percentiles are upper bounds, to a power of two
+     uint64_t p99_latency_us = 0;
+     uint64_t max_latency_us = 0;
+  };
+
+  struct txn_test_gen_transfer {
+     chain::name  from;
+     chain::name  to;
+     chain::asset quantity;
+     string       memo;
+  };
 }}
 
 FC_REFLECT(eosio::detail::txn_test_gen_empty, );
 FC_REFLECT(eosio::detail::txn_test_gen_status, (status));
+FC_REFLECT(eosio::detail::txn_test_gen_mix_entry, (weight)(actions)(memo_size));
+FC_REFLECT(eosio::detail::txn_test_gen_workload, (salt)(tps)(accounts)(mix));
+FC_REFLECT(eosio::detail::txn_test_gen_stats, (running)(elapsed_sec)(sent)(accepted)(failed)(accepted_tps)(avg_cpu_us)
+                                              (avg_latency_us)(p50_latency_us)(p99_latency_us)(max_latency_us));
+FC_REFLECT(eosio::detail::txn_test_gen_transfer, (from)(to)(quantity)(memo));
 
 namespace eosio {
 
@@ -61,6 +106,14 @@ using namespace eosio::chain;
      api_handle->call_name(vs.at(0).as<in_param0>(), vs.at(1).as<in_param1>()); \
      eosio::detail::txn_test_gen_empty result;
 
+#define INVOKE_V_R(api_handle, call_name, in_param0) \
+     const auto& vs = fc::json::json::from_string(body).as<fc::variants>(); \
+     auto status = api_handle->call_name(vs.at(0).as<in_param0>()); \
+     eosio::detail::txn_test_gen_status result = { status };
+
+#define INVOKE_R_V(api_handle, call_name) \
+     auto result = api_handle->call_name();
+
 #define INVOKE_V_V(api_handle, call_name) \
      api_handle->call_name(); \
      eosio::detail::txn_test_gen_empty result;
@@ -93,28 +146,84 @@ using namespace eosio::chain;
 
 struct txn_test_gen_plugin_impl {
 
-   uint64_t _total_us = 0;
-   uint64_t _txcount = 0;
+   static constexpr uint32_t tick_ms           = 10;  // workloads send the transactions due every tick
+   static constexpr uint32_t trxs_per_task     = 50;  // transactions created and signed by one thread pool task
+   static constexpr uint32_t actions_per_setup = 50;  // newaccount or transfer actions per setup transaction
+   static constexpr uint32_t max_accounts      = 10000;
+
+   struct stats_t {
+      fc::time_point            start;
+      uint64_t                  sent             = 0;
+      uint64_t                  accepted         = 0;
+      uint64_t                  failed           = 0;
+      uint64_t                  total_cpu_us     = 0;
+      uint64_t                  total_latency_us = 0;
+      uint64_t                  max_latency_us   = 0;
+      std::array<uint64_t, 65>  latency_buckets  = {}; // by bit width of the latency in us
+   };
+
+   std::mutex                                           stats_mtx;
+   stats_t                                              stats;
 
    uint16_t                                             thread_pool_size;
    std::optional<eosio::chain::named_thread_pool>       thread_pool;
    std::shared_ptr<boost::asio::high_resolution_timer>  timer;
-   name                                                 newaccountA;
-   name                                                 newaccountB;
    name                                                 newaccountT;
+   vector<name>                                         accounts;     // authorizers; the first two are the original "a" and "b"
+   vector<fc::crypto::private_key>                      account_keys;
+
+   static string account_suffix(uint32_t i) {
+      if (i < 2)
+         return i == 0 ? "a" : "b";
+      static const char chars[] = "abcdefghijklmnopqrstuvwxyz12345";
+      string suffix;
+      i -= 2;
+      do {
+         suffix.insert(suffix.begin(), chars[i % 31]);
+         i /= 31;
+      } while (i);
+      if (suffix.size() < 2) // keep clear of "a", "b" and "t"
+         suffix.insert(suffix.begin(), 'a');
+      return suffix;
+   }
+
+   static fc::crypto::private_key account_key(uint32_t i) {
+      if (i < 2)
+         return fc::crypto::private_key::regenerate(fc::sha256(std::string(64, i == 0 ? 'a' : 'b')));
+      return fc::crypto::private_key::regenerate(fc::sha256::hash("txn.test.gen." + std::to_string(i)));
+   }
+
+   static action transfer(name token, name from, name to, const string& memo) {
+      return action(vector<permission_level>{{from, config::active_name}}, token, "transfer"_n,
+                    fc::raw::pack(detail::txn_test_gen_transfer{from, to, asset(10000, symbol(4, "CUR")), memo}));
+   }
 
    void push_next_transaction(const std::shared_ptr<std::vector<signed_transaction>>& trxs, const std::function<void(const fc::exception_ptr&)>& next ) {
       chain_plugin& cp = app().get_plugin<chain_plugin>();
 
       for (size_t i = 0; i < trxs->size(); ++i) {
+         auto start = fc::time_point::now();
+         {
+            std::lock_guard<std::mutex> g(stats_mtx);
+            ++stats.sent;
+         }
          cp.accept_transaction( std::make_shared<packed_transaction>(signed_transaction(trxs->at(i)), true),
                [=](const std::variant<fc::exception_ptr, transaction_trace_ptr>& result){
             if (std::holds_alternative<fc::exception_ptr>(result)) {
+               {
+                  std::lock_guard<std::mutex> g(stats_mtx);
+                  ++stats.failed;
+               }
                next(std::get<fc::exception_ptr>(result));
             } else {
                if (std::holds_alternative<transaction_trace_ptr>(result) && std::get<transaction_trace_ptr>(result)->receipt) {
-                  _total_us += std::get<transaction_trace_ptr>(result)->receipt->cpu_usage_us;
-                  ++_txcount;
+                  uint64_t latency_us = (fc::time_point::now() - start).count();
+                  std::lock_guard<std::mutex> g(stats_mtx);
+                  ++stats.accepted;
+                  stats.total_cpu_us += std::get<transaction_trace_ptr>(result)->receipt->cpu_usage_us;
+                  stats.total_latency_us += latency_us;
+                  stats.max_latency_us = std::max(stats.max_latency_us, latency_us);
+                  ++stats.latency_buckets[64 - (latency_us ? __builtin_clzll(latency_us) : 64)];
                }
             }
          });
@@ -123,7 +232,7 @@ struct txn_test_gen_plugin_impl {
 
    void push_transactions( std::vector<signed_transaction>&& trxs, const std::function<void(fc::exception_ptr)>& next ) {
       auto trxs_copy = std::make_shared<std::decay_t<decltype(trxs)>>(std::move(trxs));
-      app().post(priority::low, [this, trxs_copy, next]() {
+      main_thread_post(priority::low, [this, trxs_copy, next]() {
          push_next_transaction(trxs_copy, next);
       });
    }
@@ -131,7 +240,6 @@ struct txn_test_gen_plugin_impl {
    void create_test_accounts(const std::string& init_name, const std::string& init_priv_key, const std::function<void(const fc::exception_ptr&)>& next) {
       ilog("create_test_accounts");
       std::vector<signed_transaction> trxs;
-      trxs.reserve(2);
 
       try {
          name creator(init_name);
@@ -145,44 +253,41 @@ struct txn_test_gen_plugin_impl {
          abi_serializer eosio_token_serializer{fc::json::from_string(contracts::eosio_token_abi().data()).as<abi_def>(),
                                                abi_serializer::create_yield_function( abi_serializer_max_time )};
 
-         fc::crypto::private_key txn_test_receiver_A_priv_key = fc::crypto::private_key::regenerate(fc::sha256(std::string(64, 'a')));
-         fc::crypto::private_key txn_test_receiver_B_priv_key = fc::crypto::private_key::regenerate(fc::sha256(std::string(64, 'b')));
          fc::crypto::private_key txn_test_receiver_C_priv_key = fc::crypto::private_key::regenerate(fc::sha256(std::string(64, 'c')));
-         fc::crypto::public_key  txn_text_receiver_A_pub_key = txn_test_receiver_A_priv_key.get_public_key();
-         fc::crypto::public_key  txn_text_receiver_B_pub_key = txn_test_receiver_B_priv_key.get_public_key();
          fc::crypto::public_key  txn_text_receiver_C_pub_key = txn_test_receiver_C_priv_key.get_public_key();
          fc::crypto::private_key creator_priv_key = fc::crypto::private_key(init_priv_key);
 
-         //create some test accounts
+         auto finish = [&](signed_transaction& trx, const fc::crypto::private_key& key) {
+            trx.expiration = cc.head_block_time() + fc::seconds(180);
+            trx.set_reference_block(cc.head_block_id());
+            trx.max_net_usage_words = 5000;
+            trx.sign(key, chainid);
+            trxs.emplace_back(std::move(trx));
+         };
+
+         //create "T" and the authorizer accounts
          {
             signed_transaction trx;
 
-            //create "A" account
-            {
-            auto owner_auth   = eosio::chain::authority{1, {{txn_text_receiver_A_pub_key, 1}}, {}};
-            auto active_auth  = eosio::chain::authority{1, {{txn_text_receiver_A_pub_key, 1}}, {}};
-
-            trx.actions.emplace_back(vector<chain::permission_level>{{creator,name("active")}}, newaccount{creator, newaccountA, owner_auth, active_auth});
-            }
-            //create "B" account
-            {
-            auto owner_auth   = eosio::chain::authority{1, {{txn_text_receiver_B_pub_key, 1}}, {}};
-            auto active_auth  = eosio::chain::authority{1, {{txn_text_receiver_B_pub_key, 1}}, {}};
-
-            trx.actions.emplace_back(vector<chain::permission_level>{{creator,name("active")}}, newaccount{creator, newaccountB, owner_auth, active_auth});
-            }
-            //create "T" account
             {
             auto owner_auth   = eosio::chain::authority{1, {{txn_text_receiver_C_pub_key, 1}}, {}};
             auto active_auth  = eosio::chain::authority{1, {{txn_text_receiver_C_pub_key, 1}}, {}};
 
             trx.actions.emplace_back(vector<chain::permission_level>{{creator,name("active")}}, newaccount{creator, newaccountT, owner_auth, active_auth});
             }
-
-            trx.expiration = cc.head_block_time() + fc::seconds(180);
-            trx.set_reference_block(cc.head_block_id());
-            trx.sign(creator_priv_key, chainid);
-            trxs.emplace_back(std::move(trx));
+            for (size_t i = 0; i < accounts.size(); ++i) {
+               auto pub_key      = account_keys[i].get_public_key();
+               auto owner_auth   = eosio::chain::authority{1, {{pub_key, 1}}, {}};
+               auto active_auth  = eosio::chain::authority{1, {{pub_key, 1}}, {}};
+
+               trx.actions.emplace_back(vector<chain::permission_level>{{creator,name("active")}}, newaccount{creator, accounts[i], owner_auth, active_auth});
+               if (trx.actions.size() == actions_per_setup) {
+                  finish(trx, creator_priv_key);
+                  trx = signed_transaction();
+               }
+            }
+            if (!trx.actions.empty())
+               finish(trx, creator_priv_key);
          }
 
          //set newaccountT contract to eosio.token & initialize it
@@ -216,44 +321,33 @@ struct txn_test_gen_plugin_impl {
                trx.actions.push_back(act);
             }
             {
+               // 20000 for each authorizer, and as much again for T
                action act;
                act.account = newaccountT;
                act.name = "issue"_n;
                act.authorization = vector<permission_level>{{newaccountT,config::active_name}};
                act.data = eosio_token_serializer.variant_to_binary("issue",
-                                                                   fc::json::from_string(fc::format_string("{\"to\":\"${to}\",\"quantity\":\"60000.0000 CUR\",\"memo\":\"\"}",
-                                                                   fc::mutable_variant_object()("to",newaccountT.to_string()))),
-                                                                   abi_serializer::create_yield_function( abi_serializer_max_time ));
-               trx.actions.push_back(act);
-            }
-            {
-               action act;
-               act.account = newaccountT;
-               act.name = "transfer"_n;
-               act.authorization = vector<permission_level>{{newaccountT,config::active_name}};
-               act.data = eosio_token_serializer.variant_to_binary("transfer",
-                                                                   fc::json::from_string(fc::format_string("{\"from\":\"${from}\",\"to\":\"${to}\",\"quantity\":\"20000.0000 CUR\",\"memo\":\"\"}",
-                                                                   fc::mutable_variant_object()("from",newaccountT.to_string())("to",newaccountA.to_string()))),
-                                                                   abi_serializer::create_yield_function( abi_serializer_max_time ));
-               trx.actions.push_back(act);
-            }
-            {
-               action act;
-               act.account = newaccountT;
-               act.name = "transfer"_n;
-               act.authorization = vector<permission_level>{{newaccountT,config::active_name}};
-               act.data = eosio_token_serializer.variant_to_binary("transfer",
-                                                                   fc::json::from_string(fc::format_string("{\"from\":\"${from}\",\"to\":\"${to}\",\"quantity\":\"20000.0000 CUR\",\"memo\":\"\"}",
-                                                                   fc::mutable_variant_object()("from",newaccountT.to_string())("to",newaccountB.to_string()))),
+                                                                   fc::json::from_string(fc::format_string("{\"to\":\"${to}\",\"quantity\":\"${q}.0000 CUR\",\"memo\":\"\"}",
+                                                                   fc::mutable_variant_object()("to",newaccountT.to_string())("q", 20000 * (accounts.size() + 1)))),
                                                                    abi_serializer::create_yield_function( abi_serializer_max_time ));
                trx.actions.push_back(act);
             }
+            finish(trx, txn_test_receiver_C_priv_key);
+         }
 
-            trx.expiration = cc.head_block_time() + fc::seconds(180);
-            trx.set_reference_block(cc.head_block_id());
-            trx.max_net_usage_words = 5000;
-            trx.sign(txn_test_receiver_C_priv_key, chainid);
-            trxs.emplace_back(std::move(trx));
+         //fund the authorizers
+         {
+            signed_transaction trx;
+            for (const auto& account : accounts) {
+               trx.actions.emplace_back(vector<permission_level>{{newaccountT,config::active_name}}, newaccountT, "transfer"_n,
+                                        fc::raw::pack(detail::txn_test_gen_transfer{newaccountT, account, asset(200000000, symbol(4, "CUR")), ""}));
+               if (trx.actions.size() == actions_per_setup) {
+                  finish(trx, txn_test_receiver_C_priv_key);
+                  trx = signed_transaction();
+               }
+            }
+            if (!trx.actions.empty())
+               finish(trx, txn_test_receiver_C_priv_key);
          }
       } catch ( const std::bad_alloc& ) {
         throw;
@@ -282,55 +376,89 @@ struct txn_test_gen_plugin_impl {
          return "batch_size must be even";
       ilog("Starting transaction test plugin valid");
 
-      running = true;
+      start(salt, period, batch_size, 1, accounts.size(), {detail::txn_test_gen_mix_entry{}});
+      return "success";
+   }
+
+   string start_workload(const detail::txn_test_gen_workload& workload) {
+      if(running)
+         return "start_workload already running";
+      if(workload.tps < 1 || workload.tps > 100000)
+         return "tps must be between 1 and 100000";
+      uint32_t num_accounts = workload.accounts ? workload.accounts : accounts.size();
+      if(num_accounts < 2 || num_accounts > accounts.size())
+         return "accounts must be between 2 and txn-test-gen-accounts";
+      auto mix = workload.mix;
+      if(mix.empty())
+         mix.emplace_back();
+      for(const auto& kind : mix) {
+         if(kind.weight < 1)
+            return "mix weights must be at least 1";
+         if(kind.actions < 1 || kind.actions > 100)
+            return "mix actions must be between 1 and 100";
+         if(kind.memo_size > 256)
+            return "mix memo_size must be at most 256";
+      }
+
+      start(workload.salt, tick_ms, workload.tps, 1000 / tick_ms, num_accounts, std::move(mix));
+      return "success";
+   }
 
-      controller& cc = app().get_plugin<chain_plugin>().chain();
-      auto abi_serializer_max_time = app().get_plugin<chain_plugin>().get_abi_serializer_max_time();
-      abi_serializer eosio_token_serializer{fc::json::from_string(contracts::eosio_token_abi().data()).as<abi_def>(), abi_serializer::create_yield_function( abi_serializer_max_time )};
-      //create the actions here
-      act_a_to_b.account = newaccountT;
-      act_a_to_b.name = "transfer"_n;
-      act_a_to_b.authorization = vector<permission_level>{{newaccountA,config::active_name}};
-      act_a_to_b.data = eosio_token_serializer.variant_to_binary("transfer",
-                                                                  fc::json::from_string(fc::format_string("{\"from\":\"${from}\",\"to\":\"${to}\",\"quantity\":\"1.0000 CUR\",\"memo\":\"${l}\"}",
-                                                                  fc::mutable_variant_object()("from",newaccountA.to_string())("to",newaccountB.to_string())("l", salt))),
-                                                                  abi_serializer::create_yield_function( abi_serializer_max_time ));
-
-      act_b_to_a.account = newaccountT;
-      act_b_to_a.name = "transfer"_n;
-      act_b_to_a.authorization = vector<permission_level>{{newaccountB,config::active_name}};
-      act_b_to_a.data = eosio_token_serializer.variant_to_binary("transfer",
-                                                                  fc::json::from_string(fc::format_string("{\"from\":\"${from}\",\"to\":\"${to}\",\"quantity\":\"1.0000 CUR\",\"memo\":\"${l}\"}",
-                                                                  fc::mutable_variant_object()("from",newaccountB.to_string())("to",newaccountA.to_string())("l", salt))),
-                                                                  abi_serializer::create_yield_function( abi_serializer_max_time ));
+   // every period ms, send the transactions due at rate_num / rate_den per period
+   void start(const string& salt, uint64_t period, uint64_t num, uint64_t den, uint32_t num_accounts,
+              vector<detail::txn_test_gen_mix_entry> workload_mix) {
+      running = true;
 
       timer_timeout = period;
-      batch = batch_size/2;
+      rate_num = num;
+      rate_den = den;
+      tick = 0;
       nonce_prefix = 0;
+      next_trx = 0;
+      active_accounts = num_accounts;
+      mix = std::move(workload_mix);
+      mix_weight = 0;
+      memos.clear();
+      for (const auto& kind : mix) {
+         mix_weight += kind.weight;
+         memos.push_back(salt);
+         if (memos.back().size() < kind.memo_size)
+            memos.back().resize(kind.memo_size, '.');
+      }
+      {
+         std::lock_guard<std::mutex> g(stats_mtx);
+         stats = stats_t{};
+         stats.start = fc::time_point::now();
+      }
 
       thread_pool.emplace( "txntest", thread_pool_size );
       timer = std::make_shared<boost::asio::high_resolution_timer>(thread_pool->get_executor());
 
-      ilog("Started transaction test plugin; generating ${p} transactions every ${m} ms by ${t} load generation threads",
-         ("p", batch_size) ("m", period) ("t", thread_pool_size));
+      ilog("Started transaction test plugin; generating ${p} transactions every ${m} ms from ${a} accounts by ${t} load generation threads",
+         ("p", double(num) / den) ("m", period) ("a", num_accounts) ("t", thread_pool_size));
 
       boost::asio::post( thread_pool->get_executor(), [this]() {
          arm_timer(boost::asio::high_resolution_timer::clock_type::now());
       });
-      return "success";
    }
 
    void arm_timer(boost::asio::high_resolution_timer::time_point s) {
       timer->expires_at(s + std::chrono::milliseconds(timer_timeout));
-      boost::asio::post( thread_pool->get_executor(), [this]() {
-         send_transaction([this](const fc::exception_ptr& e){
-            if (e) {
-               elog("pushing transaction failed: ${e}", ("e", e->to_detail_string()));
-               if(running)
-                  stop_generation();
-            }
-         }, nonce_prefix++);
-      });
+      uint64_t due = (tick + 1) * rate_num / rate_den - tick * rate_num / rate_den;
+      ++tick;
+      // spread signing over the thread pool
+      for (uint64_t sent = 0; sent < due; sent += trxs_per_task) {
+         uint32_t count = std::min<uint64_t>(trxs_per_task, due - sent);
+         boost::asio::post( thread_pool->get_executor(), [this, count, prefix = nonce_prefix++]() {
+            send_transaction([this](const fc::exception_ptr& e){
+               if (e) {
+                  elog("pushing transaction failed: ${e}", ("e", e->to_detail_string()));
+                  if(running)
+                     stop_generation();
+               }
+            }, prefix, count);
+         });
+      }
       timer->async_wait([this](const boost::system::error_code& ec) {
          if(!running || ec)
             return;
@@ -338,18 +466,25 @@ struct txn_test_gen_plugin_impl {
       });
    }
 
-   void send_transaction(std::function<void(const fc::exception_ptr&)> next, uint64_t nonce_prefix) {
+   size_t mix_index(uint64_t trx_num) const {
+      uint64_t w = trx_num % mix_weight;
+      for (size_t i = 0; i < mix.size(); ++i) {
+         if (w < mix[i].weight)
+            return i;
+         w -= mix[i].weight;
+      }
+      return 0;
+   }
+
+   void send_transaction(std::function<void(const fc::exception_ptr&)> next, uint64_t nonce_prefix, uint32_t count) {
       std::vector<signed_transaction> trxs;
-      trxs.reserve(2*batch);
+      trxs.reserve(count);
 
       try {
          controller& cc = app().get_plugin<chain_plugin>().chain();
          auto chainid = app().get_plugin<chain_plugin>().get_chain_id();
 
-         static fc::crypto::private_key a_priv_key = fc::crypto::private_key::regenerate(fc::sha256(std::string(64, 'a')));
-         static fc::crypto::private_key b_priv_key = fc::crypto::private_key::regenerate(fc::sha256(std::string(64, 'b')));
-
-         static uint64_t nonce = static_cast<uint64_t>(fc::time_point::now().sec_since_epoch()) << 32;
+         static std::atomic<uint64_t> nonce = static_cast<uint64_t>(fc::time_point::now().sec_since_epoch()) << 32;
 
          uint32_t reference_block_num = cc.last_irreversible_block_num();
          if (txn_reference_block_lag >= 0) {
@@ -363,28 +498,23 @@ struct txn_test_gen_plugin_impl {
 
          block_id_type reference_block_id = cc.get_block_id_for_num(reference_block_num);
 
-         for(unsigned int i = 0; i < batch; ++i) {
-         {
-         signed_transaction trx;
-         trx.actions.push_back(act_a_to_b);
-         trx.context_free_actions.emplace_back(action({}, config::null_account_name, name("nonce"), fc::raw::pack( std::to_string(nonce_prefix)+std::to_string(nonce++) )));
-         trx.set_reference_block(reference_block_id);
-         trx.expiration = cc.head_block_time() + fc::seconds(30);
-         trx.max_net_usage_words = 100;
-         trx.sign(a_priv_key, chainid);
-         trxs.emplace_back(std::move(trx));
-         }
+         for(unsigned int i = 0; i < count; ++i) {
+            // authorizers take turns; each transfers to the next ones
+            uint64_t    trx_num = next_trx++;
+            auto        kind    = mix_index(trx_num);
+            uint32_t    from    = trx_num % active_accounts;
 
-         {
-         signed_transaction trx;
-         trx.actions.push_back(act_b_to_a);
-         trx.context_free_actions.emplace_back(action({}, config::null_account_name, name("nonce"), fc::raw::pack( std::to_string(nonce_prefix)+std::to_string(nonce++) )));
-         trx.set_reference_block(reference_block_id);
-         trx.expiration = cc.head_block_time() + fc::seconds(30);
-         trx.max_net_usage_words = 100;
-         trx.sign(b_priv_key, chainid);
-         trxs.emplace_back(std::move(trx));
-         }
+            signed_transaction trx;
+            for (uint32_t a = 0; a < mix[kind].actions; ++a) {
+               uint32_t to = (from + 1 + a % (active_accounts - 1)) % active_accounts;
+               trx.actions.push_back(transfer(newaccountT, accounts[from], accounts[to], memos[kind]));
+            }
+            trx.context_free_actions.emplace_back(action({}, config::null_account_name, name("nonce"), fc::raw::pack( std::to_string(nonce_prefix)+std::to_string(nonce++) )));
+            trx.set_reference_block(reference_block_id);
+            trx.expiration = cc.head_block_time() + fc::seconds(30);
+            trx.max_net_usage_words = 100 * mix[kind].actions + mix[kind].actions * mix[kind].memo_size / 8;
+            trx.sign(account_keys[from], chainid);
+            trxs.emplace_back(std::move(trx));
          }
       } catch ( const std::bad_alloc& ) {
         throw;
@@ -399,6 +529,36 @@ struct txn_test_gen_plugin_impl {
       push_transactions(std::move(trxs), next);
    }
 
+   detail::txn_test_gen_stats get_stats() {
+      std::lock_guard<std::mutex> g(stats_mtx);
+      detail::txn_test_gen_stats result;
+      result.running     = running;
+      result.elapsed_sec = stats.start == fc::time_point() ? 0 : (fc::time_point::now() - stats.start).count() / 1e6;
+      result.sent        = stats.sent;
+      result.accepted    = stats.accepted;
+      result.failed      = stats.failed;
+      if (result.elapsed_sec > 0)
+         result.accepted_tps = stats.accepted / result.elapsed_sec;
+      if (stats.accepted) {
+         result.avg_cpu_us     = stats.total_cpu_us / stats.accepted;
+         result.avg_latency_us = stats.total_latency_us / stats.accepted;
+      }
+      result.max_latency_us = stats.max_latency_us;
+
+      auto percentile = [&](double p) -> uint64_t {
+         uint64_t target = std::ceil(stats.accepted * p), seen = 0;
+         for (size_t b = 0; b < stats.latency_buckets.size(); ++b) {
+            seen += stats.latency_buckets[b];
+            if (seen >= target && seen)
+               return b ? (uint64_t(1) << b) - 1 : 0;
+         }
+         return 0;
+      };
+      result.p50_latency_us = percentile(0.5);
+      result.p99_latency_us = percentile(0.99);
+      return result;
+   }
+
    void stop_generation() {
       if(!running)
          throw fc::exception(fc::invalid_operation_exception_code);
@@ -409,20 +569,28 @@ struct txn_test_gen_plugin_impl {
 
       ilog("Stopping transaction generation test");
 
-      if (_txcount) {
-         ilog("${d} transactions executed, ${t}us / transaction", ("d", _txcount)("t", _total_us / (double)_txcount));
-         _txcount = _total_us = 0;
+      auto s = get_stats();
+      if (s.accepted) {
+         ilog("${d} transactions executed, ${t}us / transaction", ("d", s.accepted)("t", s.avg_cpu_us));
+         ilog("${s} sent, ${f} failed, ${r} transactions / second; latency avg ${a}us, p50 ${p50}us, p99 ${p99}us, max ${m}us",
+              ("s", s.sent)("f", s.failed)("r", s.accepted_tps)("a", s.avg_latency_us)("p50", s.p50_latency_us)
+              ("p99", s.p99_latency_us)("m", s.max_latency_us));
       }
    }
 
-   bool running{false};
+   std::atomic<bool> running{false};
 
    unsigned timer_timeout;
-   unsigned batch;
+   uint64_t rate_num;
+   uint64_t rate_den;
+   uint64_t tick;
    uint64_t nonce_prefix;
 
-   action act_a_to_b;
-   action act_b_to_a;
+   std::atomic<uint64_t>                   next_trx{0};
+   uint32_t                                active_accounts = 0;
+   vector<detail::txn_test_gen_mix_entry>  mix;
+   uint64_t                                mix_weight = 0;
+   vector<string>                          memos;  // of each kind in mix
 
    int32_t txn_reference_block_lag;
 };
@@ -435,6 +603,7 @@ void txn_test_gen_plugin::set_program_options(options_description&, options_desc
       ("txn-reference-block-lag", bpo::value<int32_t>()->default_value(0), "Lag in number of blocks from the head block when selecting the reference block for transactions (-1 means Last Irreversible Block)")
       ("txn-test-gen-threads", bpo::value<uint16_t>()->default_value(2), "Number of worker threads in txn_test_gen thread pool")
       ("txn-test-gen-account-prefix", bpo::value<string>()->default_value("txn.test."), "Prefix to use for accounts generated and used by this plugin")
+      ("txn-test-gen-accounts", bpo::value<uint32_t>()->default_value(2), "Number of accounts created by create_test_accounts to authorize generated transactions. Transactions are spread over the accounts, exercising authorization and parallel execution; each account also holds a balance row")
    ;
 }
 
@@ -444,11 +613,20 @@ void txn_test_gen_plugin::plugin_initialize(const variables_map& options) {
       my->txn_reference_block_lag = options.at( "txn-reference-block-lag" ).as<int32_t>();
       my->thread_pool_size = options.at( "txn-test-gen-threads" ).as<uint16_t>();
       const std::string thread_pool_account_prefix = options.at( "txn-test-gen-account-prefix" ).as<std::string>();
-      my->newaccountA = eosio::chain::name(thread_pool_account_prefix + "a");
-      my->newaccountB = eosio::chain::name(thread_pool_account_prefix + "b");
       my->newaccountT = eosio::chain::name(thread_pool_account_prefix + "t");
       EOS_ASSERT( my->thread_pool_size > 0, chain::plugin_config_exception,
                   "txn-test-gen-threads ${num} must be greater than 0", ("num", my->thread_pool_size) );
+      const uint32_t num_accounts = options.at( "txn-test-gen-accounts" ).as<uint32_t>();
+      EOS_ASSERT( num_accounts >= 2 && num_accounts <= txn_test_gen_plugin_impl::max_accounts, chain::plugin_config_exception,
+                  "txn-test-gen-accounts ${num} must be between 2 and ${max}", ("num", num_accounts)("max", txn_test_gen_plugin_impl::max_accounts) );
+      for( uint32_t i = 0; i < num_accounts; ++i ) {
+         const auto account_name = thread_pool_account_prefix + txn_test_gen_plugin_impl::account_suffix( i );
+         my->accounts.emplace_back( account_name );
+         EOS_ASSERT( my->accounts.back().to_string() == account_name, chain::plugin_config_exception,
+                     "txn-test-gen-accounts ${num} makes account name ${n} invalid; use a shorter txn-test-gen-account-prefix",
+                     ("num", num_accounts)("n", account_name) );
+         my->account_keys.push_back( txn_test_gen_plugin_impl::account_key( i ) );
+      }
    } FC_LOG_AND_RETHROW()
 }
 
@@ -456,7 +634,9 @@ void txn_test_gen_plugin::plugin_startup() {
    app().get_plugin<http_plugin>().add_api({
       CALL_ASYNC(txn_test_gen, my, create_test_accounts, INVOKE_ASYNC_R_R(my, create_test_accounts, std::string, std::string), 200),
       CALL(txn_test_gen, my, stop_generation, INVOKE_V_V(my, stop_generation), 200),
-      CALL(txn_test_gen, my, start_generation, INVOKE_V_R_R_R(my, start_generation, std::string, uint64_t, uint64_t), 200)
+      CALL(txn_test_gen, my, start_generation, INVOKE_V_R_R_R(my, start_generation, std::string, uint64_t, uint64_t), 200),
+      CALL(txn_test_gen, my, start_workload, INVOKE_V_R(my, start_workload, eosio::detail::txn_test_gen_workload), 200),
+      CALL(txn_test_gen, my, get_stats, INVOKE_R_V(my, get_stats), 200)
    });
 }
 
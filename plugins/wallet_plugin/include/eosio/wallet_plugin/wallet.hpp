@@ -179,6 +179,10 @@ class soft_wallet final : public wallet_api
       */
       std::optional<signature_type> try_sign_digest( const digest_type digest, const public_key_type public_key ) override;
 
+      /* The keys of an unlocked wallet are held decrypted in memory, signing only reads them
+      */
+      bool can_sign_concurrently() const override { return true; }
+
       std::shared_ptr<detail::soft_wallet_impl> my;
       void encrypt_keys();
 };
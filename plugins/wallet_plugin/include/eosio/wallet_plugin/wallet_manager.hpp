@@ -1,5 +1,6 @@
 #pragma once
 #include <eosio/chain/transaction.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <eosio/wallet_plugin/wallet_api.hpp>
 #include <boost/asio/deadline_timer.hpp>
 #include <boost/filesystem/path.hpp>
@@ -50,6 +51,18 @@ public:
    chain::signed_transaction sign_transaction(const chain::signed_transaction& txn, const flat_set<public_key_type>& keys,
                                              const chain::chain_id_type& id);
 
+   /// Sign transactions with the private keys specified via their public keys, see sign_transaction.
+   /// The wallet of each key is looked up once for the whole batch. Transactions are signed in parallel on the
+   /// signing threads when all the wallets involved support it, see set_signing_threads.
+   /// @param txns the transactions to sign.
+   /// @param keys the public keys to sign each of txns with, same size as txns.
+   /// @param id the chain_id to sign transactions with.
+   /// @return txns signed, in the same order
+   /// @throws fc::exception if corresponding private keys not found in unlocked wallets
+   std::vector<chain::signed_transaction> sign_transactions(const std::vector<chain::signed_transaction>& txns,
+                                                           const std::vector<flat_set<public_key_type>>& keys,
+                                                           const chain::chain_id_type& id);
+
 
    /// Sign digest with the private keys specified via their public keys.
    /// @param digest the digest to sign.
@@ -125,11 +138,18 @@ public:
    /// Takes ownership of a wallet to use
    void own_and_use_wallet(const string& name, std::unique_ptr<wallet_api>&& wallet);
 
+   /// Number of threads sign_transactions signs batches on, 0 signs on the calling thread.
+   void set_signing_threads(uint16_t num_threads);
+
 private:
    /// Verify timeout has not occurred and reset timeout if not.
    /// Calls lock_all() if timeout has passed.
    void check_timeout();
 
+   /// unlocked wallet holding each of keys
+   /// @throws fc::exception if a key is not found in unlocked wallets
+   std::map<public_key_type, wallet_api*> find_signing_wallets(const flat_set<public_key_type>& keys);
+
 private:
    using timepoint_t = std::chrono::time_point<std::chrono::system_clock>;
    std::map<std::string, std::unique_ptr<wallet_api>> wallets;
@@ -138,6 +158,8 @@ private:
    boost::filesystem::path dir = ".";
    boost::filesystem::path lock_path = dir / "wallet.lock";
    std::unique_ptr<boost::interprocess::file_lock> wallet_dir_lock;
+   std::optional<chain::named_thread_pool> signing_thread_pool;
+   uint16_t signing_threads = 0;
 
    void start_lock_watch(std::shared_ptr<boost::asio::deadline_timer> t);
    void initialize_lock();
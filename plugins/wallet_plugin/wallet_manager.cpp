@@ -224,16 +224,36 @@ string wallet_manager::create_key(const std::string& name, const std::string& ke
    return w->create_key(upper_key_type);
 }
 
+std::map<public_key_type, wallet_api*> wallet_manager::find_signing_wallets(const flat_set<public_key_type>& keys) {
+   std::map<public_key_type, wallet_api*> signers;
+   for (const auto& i : wallets) {
+      if (signers.size() == keys.size())
+         break;
+      if (i.second->is_locked())
+         continue;
+      for (const auto& pk : i.second->list_public_keys()) {
+         if (keys.count(pk))
+            signers.emplace(pk, i.second.get()); // first wallet with the key signs, as in sign_digest
+      }
+   }
+   for (const auto& pk : keys) {
+      if (!signers.count(pk))
+         EOS_THROW(chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", pk));
+   }
+   return signers;
+}
+
 chain::signed_transaction
 wallet_manager::sign_transaction(const chain::signed_transaction& txn, const flat_set<public_key_type>& keys, const chain::chain_id_type& id) {
    check_timeout();
    chain::signed_transaction stxn(txn);
+   const auto digest = stxn.sig_digest(id, stxn.context_free_data);
 
    for (const auto& pk : keys) {
       bool found = false;
       for (const auto& i : wallets) {
          if (!i.second->is_locked()) {
-            std::optional<signature_type> sig = i.second->try_sign_digest(stxn.sig_digest(id, stxn.context_free_data), pk);
+            std::optional<signature_type> sig = i.second->try_sign_digest(digest, pk);
             if (sig) {
                stxn.signatures.push_back(*sig);
                found = true;
@@ -249,6 +269,53 @@ wallet_manager::sign_transaction(const chain::signed_transaction& txn, const fla
    return stxn;
 }
 
+std::vector<chain::signed_transaction>
+wallet_manager::sign_transactions(const std::vector<chain::signed_transaction>& txns, const std::vector<flat_set<public_key_type>>& keys,
+                                  const chain::chain_id_type& id) {
+   check_timeout();
+   EOS_ASSERT(txns.size() == keys.size(), chain::wallet_exception, "Got ${k} sets of keys for ${t} transactions",
+              ("k", keys.size())("t", txns.size()));
+
+   flat_set<public_key_type> all_keys;
+   for (const auto& k : keys)
+      all_keys.insert(k.begin(), k.end());
+   const auto signers = find_signing_wallets(all_keys);
+
+   std::vector<chain::signed_transaction> stxns(txns);
+   auto sign = [&](size_t begin, size_t end) {
+      for (size_t t = begin; t < end; ++t) {
+         auto& stxn = stxns[t];
+         const auto digest = stxn.sig_digest(id, stxn.context_free_data);
+         for (const auto& pk : keys[t]) {
+            std::optional<signature_type> sig = signers.at(pk)->try_sign_digest(digest, pk);
+            EOS_ASSERT(sig, chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", pk));
+            stxn.signatures.push_back(*sig);
+         }
+      }
+   };
+
+   const bool concurrent = std::all_of(signers.begin(), signers.end(), [](const auto& s) { return s.second->can_sign_concurrently(); });
+   if (!signing_thread_pool || !concurrent || stxns.size() < 2) {
+      sign(0, stxns.size());
+      return stxns;
+   }
+
+   // the wallets are not modified until all the tasks are done, this thread waits on them
+   const size_t num_tasks = std::min<size_t>(stxns.size(), signing_threads);
+   std::vector<std::future<void>> tasks;
+   tasks.reserve(num_tasks);
+   for (size_t i = 0; i < num_tasks; ++i) {
+      tasks.emplace_back(chain::async_thread_pool(signing_thread_pool->get_executor(), [&sign, i, num_tasks, n = stxns.size()]() {
+         sign(n * i / num_tasks, n * (i + 1) / num_tasks);
+      }));
+   }
+   for (auto& f : tasks)
+      f.wait();
+   for (auto& f : tasks)
+      f.get();
+   return stxns;
+}
+
 chain::signature_type
 wallet_manager::sign_digest(const chain::digest_type& digest, const public_key_type& key) {
    check_timeout();
@@ -266,6 +333,13 @@ wallet_manager::sign_digest(const chain::digest_type& digest, const public_key_t
    EOS_THROW(chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", key));
 }
 
+void wallet_manager::set_signing_threads(uint16_t num_threads) {
+   signing_thread_pool.reset();
+   signing_threads = num_threads;
+   if (num_threads > 0)
+      signing_thread_pool.emplace("sign", num_threads);
+}
+
 void wallet_manager::own_and_use_wallet(const string& name, std::unique_ptr<wallet_api>&& wallet) {
    if(wallets.find(name) != wallets.end())
       EOS_THROW(wallet_exception, "Tried to use wallet name that already exists.");
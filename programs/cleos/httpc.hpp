@@ -128,6 +128,7 @@ namespace eosio { namespace client { namespace http {
    const string wallet_remove_key = wallet_func_base + "/remove_key";
    const string wallet_create_key = wallet_func_base + "/create_key";
    const string wallet_sign_trx = wallet_func_base + "/sign_transaction";
+   const string wallet_sign_trxs = wallet_func_base + "/sign_transactions";
    const string keosd_stop = "/v1/" + string(client::config::key_store_executable_name) + "/stop";
 
    FC_DECLARE_EXCEPTION( connection_exception, 1100000, "Connection Exception" );
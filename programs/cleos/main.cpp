@@ -69,6 +69,10 @@ Options:
 #include <vector>
 #include <regex>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 #include <fc/crypto/hex.hpp>
 #include <fc/variant.hpp>
 #include <fc/io/datastream.hpp>
@@ -398,31 +402,52 @@ void sign_transaction(signed_transaction& trx, fc::variant& required_keys, const
    trx = signed_trx.as<signed_transaction>();
 }
 
-fc::variant push_transaction( signed_transaction& trx, const std::vector<public_key_type>& signing_keys = std::vector<public_key_type>() )
-{
-   auto info = get_info();
+// Set tapos, default to last irreversible block if it's not specified by the user
+block_id_type get_ref_block_id( const eosio::chain_apis::read_only::get_info_results& info ) {
+   block_id_type ref_block_id = info.last_irreversible_block_id;
+   try {
+      fc::variant ref_block;
+      if (!tx_ref_block_num_or_id.empty()) {
+         ref_block = call(get_block_func, fc::mutable_variant_object("block_num_or_id", tx_ref_block_num_or_id));
+         ref_block_id = ref_block["id"].as<block_id_type>();
+      }
+   } EOS_RETHROW_EXCEPTIONS(invalid_ref_block_exception, "Invalid reference block num or id: ${block_num_or_id}", ("block_num_or_id", tx_ref_block_num_or_id));
+   return ref_block_id;
+}
 
-   if (trx.signatures.size() == 0) { // #5445 can't change txn content if already signed
-      trx.expiration = info.head_block_time + tx_expiration;
+void set_transaction_header( signed_transaction& trx, const eosio::chain_apis::read_only::get_info_results& info, const block_id_type& ref_block_id ) {
+   trx.expiration = info.head_block_time + tx_expiration;
+   trx.set_reference_block(ref_block_id);
 
-      // Set tapos, default to last irreversible block if it's not specified by the user
-      block_id_type ref_block_id = info.last_irreversible_block_id;
-      try {
-         fc::variant ref_block;
-         if (!tx_ref_block_num_or_id.empty()) {
-            ref_block = call(get_block_func, fc::mutable_variant_object("block_num_or_id", tx_ref_block_num_or_id));
-            ref_block_id = ref_block["id"].as<block_id_type>();
-         }
-      } EOS_RETHROW_EXCEPTIONS(invalid_ref_block_exception, "Invalid reference block num or id: ${block_num_or_id}", ("block_num_or_id", tx_ref_block_num_or_id));
-      trx.set_reference_block(ref_block_id);
+   if (tx_force_unique) {
+      trx.context_free_actions.emplace_back( generate_nonce_action() );
+   }
 
-      if (tx_force_unique) {
-         trx.context_free_actions.emplace_back( generate_nonce_action() );
+   trx.max_cpu_usage_ms = tx_max_cpu_usage;
+   trx.max_net_usage_words = (tx_max_net_usage + 7)/8;
+   trx.delay_sec = delaysec;
+}
+
+fc::variant send_packed_transaction( const packed_transaction_v0& ptrx ) {
+   if (tx_use_old_rpc) {
+      return call(push_txn_func, ptrx);
+   } else {
+      try {
+         return call(send_txn_func, ptrx);
+      }
+      catch (chain::missing_chain_api_plugin_exception &) {
+         std::cerr << "New RPC send_transaction may not be supported. Add flag --use-old-rpc to use old RPC push_transaction instead." << std::endl;
+         throw;
       }
+   }
+}
 
-      trx.max_cpu_usage_ms = tx_max_cpu_usage;
-      trx.max_net_usage_words = (tx_max_net_usage + 7)/8;
-      trx.delay_sec = delaysec;
+fc::variant push_transaction( signed_transaction& trx, const std::vector<public_key_type>& signing_keys = std::vector<public_key_type>() )
+{
+   auto info = get_info();
+
+   if (trx.signatures.size() == 0) { // #5445 can't change txn content if already signed
+      set_transaction_header(trx, info, get_ref_block_id(info));
    }
 
    if (!tx_skip_sign) {
@@ -438,17 +463,7 @@ fc::variant push_transaction( signed_transaction& trx, const std::vector<public_
 
    packed_transaction::compression_type compression = to_compression_type( tx_compression );
    if (!tx_dont_broadcast) {
-      if (tx_use_old_rpc) {
-         return call(push_txn_func, packed_transaction_v0(trx, compression));
-      } else {
-         try {
-            return call(send_txn_func, packed_transaction_v0(trx, compression));
-         }
-         catch (chain::missing_chain_api_plugin_exception &) {
-            std::cerr << "New RPC send_transaction may not be supported. Add flag --use-old-rpc to use old RPC push_transaction instead." << std::endl;
-            throw;
-         }
-      }
+      return send_packed_transaction(packed_transaction_v0(trx, compression));
    } else {
       if (!tx_return_packed) {
          try {
@@ -471,6 +486,180 @@ fc::variant push_actions(std::vector<chain::action>&& actions, const std::vector
    return push_transaction(trx, signing_keys);
 }
 
+// Actions in a bulk file are either an action object or an array of action objects, one transaction each.
+// "data" is an object serialized with the contract's ABI or an already serialized hex string; "authorization"
+// defaults to --permission.
+vector<chain::action> bulk_actions_from_variant( const fc::variant& v ) {
+   auto action_from_variant = []( const fc::variant& a ) {
+      EOSC_ASSERT( a.is_object(), "ERROR: Each action must be a JSON object" );
+      const auto& obj = a.get_object();
+      EOSC_ASSERT( obj.contains("account") && obj.contains("name"), "ERROR: Each action requires \"account\" and \"name\"" );
+      auto account = name(obj["account"].as_string());
+      auto act_name = name(obj["name"].as_string());
+      auto auth = obj.contains("authorization") ? obj["authorization"].as<vector<chain::permission_level>>()
+                                                : get_account_permissions(tx_permission);
+      EOSC_ASSERT( !auth.empty(), "ERROR: Action ${a}::${n} has no \"authorization\" and no --permission was given",
+                   ("a", account)("n", act_name) );
+      bytes data;
+      if( obj.contains("data") ) {
+         if( obj["data"].is_string() ) {
+            const auto& hex = obj["data"].get_string();
+            data.resize(hex.size() / 2);
+            EOSC_ASSERT( fc::from_hex(hex, data.data(), data.size()) == data.size(), "ERROR: Invalid hex data for action ${a}::${n}",
+                         ("a", account)("n", act_name) );
+         } else {
+            data = variant_to_bin( account, act_name, obj["data"] );
+         }
+      }
+      return chain::action{ std::move(auth), account, act_name, std::move(data) };
+   };
+
+   vector<chain::action> actions;
+   if( v.is_array() ) {
+      for( const auto& a : v.get_array() )
+         actions.emplace_back( action_from_variant(a) );
+   } else {
+      actions.emplace_back( action_from_variant(v) );
+   }
+   EOSC_ASSERT( !actions.empty(), "ERROR: A transaction in the bulk file has no actions" );
+   return actions;
+}
+
+// Pushes one transaction per entry of trx_actions. TaPoS and the chain id are fetched once, required keys are
+// looked up once per distinct set of authorizations and transactions are signed by keosd in batches. Signed
+// transactions are submitted by `window` concurrent connections while the next batch is being signed. Returns
+// one result per transaction, in input order.
+fc::variants push_bulk( vector<vector<chain::action>>&& trx_actions, const std::vector<public_key_type>& signing_keys,
+                        uint32_t window, uint32_t batch_size ) {
+   const auto info = get_info();
+   const auto ref_block_id = get_ref_block_id(info);
+   const auto compression = to_compression_type( tx_compression );
+
+   vector<signed_transaction> trxs(trx_actions.size());
+   for( size_t i = 0; i < trxs.size(); ++i ) {
+      trxs[i].actions = std::move(trx_actions[i]);
+      set_transaction_header(trxs[i], info, ref_block_id);
+   }
+
+   fc::variants results(trxs.size());
+   auto set_error = [&results]( size_t i, const fc::exception& e ) {
+      results[i] = fc::mutable_variant_object()("index", i)("status", "failed")("error", e.to_string());
+   };
+
+   std::mutex mtx;
+   std::condition_variable cv;
+   size_t ready = 0;   // transactions [0, ready) are signed
+   size_t next = 0;    // next transaction to submit
+   bool done = false;  // no more transactions will become ready
+
+   auto submit = [&]( size_t i ) {
+      try {
+         const packed_transaction_v0 ptrx( trxs[i], compression );
+         auto r = fc::mutable_variant_object()("index", i)("transaction_id", ptrx.id());
+         if( tx_dont_broadcast ) {
+            r("status", "signed")("transaction", fc::variant(ptrx));
+         } else {
+            const auto processed = send_packed_transaction( ptrx )["processed"];
+            r("status", processed["receipt"]["status"])("block_num", processed["block_num"]);
+            if( processed["except"].is_object() )
+               r("status", "failed")("error", processed["except"].as<fc::exception>().to_string());
+         }
+         results[i] = std::move(r);
+      } catch( const fc::exception& e ) {
+         set_error(i, e);
+      } catch( const std::exception& e ) {
+         set_error(i, fc::std_exception_wrapper::from_current_exception(e));
+      }
+   };
+
+   std::vector<std::thread> workers;
+   for( uint32_t w = 0; w < std::max<uint32_t>(window, 1); ++w ) {
+      workers.emplace_back( [&]() {
+         while( true ) {
+            size_t i;
+            {
+               std::unique_lock<std::mutex> lock(mtx);
+               cv.wait( lock, [&]() { return next < ready || done; } );
+               if( next >= ready )
+                  return;
+               i = next++;
+            }
+            submit(i);
+         }
+      } );
+   }
+
+   auto make_ready = [&]( size_t end ) {
+      {
+         std::lock_guard<std::mutex> lock(mtx);
+         ready = end;
+      }
+      cv.notify_all();
+   };
+
+   try {
+      fc::variant public_keys;
+      std::map<vector<chain::permission_level>, fc::variant> required_keys_cache;
+      auto required_keys_for = [&]( const signed_transaction& trx ) -> fc::variant {
+         if( !signing_keys.empty() )
+            return fc::variant(signing_keys);
+         vector<chain::permission_level> auths;
+         for( const auto& a : trx.actions )
+            auths.insert( auths.end(), a.authorization.begin(), a.authorization.end() );
+         std::sort( auths.begin(), auths.end() );
+         auths.erase( std::unique( auths.begin(), auths.end() ), auths.end() );
+         auto itr = required_keys_cache.find(auths);
+         if( itr == required_keys_cache.end() ) {
+            if( public_keys.is_null() )
+               public_keys = call(wallet_url, wallet_public_keys);
+            auto get_arg = fc::mutable_variant_object("transaction", (transaction)trx)("available_keys", public_keys);
+            itr = required_keys_cache.emplace( std::move(auths), call(get_required_keys, get_arg)["required_keys"] ).first;
+         }
+         return itr->second;
+      };
+
+      bool batch_signing = true;
+      for( size_t begin = 0; begin < trxs.size(); begin += std::max<uint32_t>(batch_size, 1) ) {
+         const size_t end = std::min<size_t>( begin + std::max<uint32_t>(batch_size, 1), trxs.size() );
+         if( !tx_skip_sign ) {
+            fc::variants keys;
+            for( size_t i = begin; i < end; ++i )
+               keys.emplace_back( required_keys_for(trxs[i]) );
+            if( batch_signing ) {
+               try {
+                  vector<signed_transaction> batch( trxs.begin() + begin, trxs.begin() + end );
+                  auto signed_trxs = call( wallet_url, wallet_sign_trxs, fc::variants{fc::variant(batch), fc::variant(keys), fc::variant(info.chain_id)} )
+                                        .as<vector<signed_transaction>>();
+                  std::move( signed_trxs.begin(), signed_trxs.end(), trxs.begin() + begin );
+               } catch( chain::missing_wallet_api_plugin_exception& ) {
+                  // keosd without batch signing, sign one at a time
+                  batch_signing = false;
+               }
+            }
+            if( !batch_signing ) {
+               for( size_t i = begin; i < end; ++i )
+                  sign_transaction( trxs[i], keys[i - begin], info.chain_id );
+            }
+         }
+         make_ready(end);
+      }
+   } catch( const fc::exception& e ) {
+      std::lock_guard<std::mutex> lock(mtx);
+      for( size_t i = ready; i < trxs.size(); ++i )
+         set_error(i, e);
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(mtx);
+      done = true;
+   }
+   cv.notify_all();
+   for( auto& w : workers )
+      w.join();
+
+   return results;
+}
+
 void print_return_value( const fc::variant& at ) {
    std::string return_value, return_value_prefix{"return value: "};
    const auto  & iter_value = at.get_object().find("return_value_data");
@@ -2830,6 +3019,7 @@ int main( int argc, char** argv ) {
    string index_position;
    bool reverse = false;
    bool show_payer = false;
+   string cursor;
    auto getTable = get->add_subcommand( "table", localized("Retrieve the contents of a database table"));
    getTable->add_option( "account", code, localized("The account who owns the table") )->required();
    getTable->add_option( "scope", scope, localized("The scope within the contract in which the table is found") )->required();
@@ -2850,6 +3040,7 @@ int main( int argc, char** argv ) {
    getTable->add_flag("-b,--binary", binary, localized("Return the value as BINARY rather than using abi to interpret as JSON"));
    getTable->add_flag("-r,--reverse", reverse, localized("Iterate in reverse order"));
    getTable->add_flag("--show-payer", show_payer, localized("Show RAM payer"));
+   getTable->add_option( "--cursor", cursor, localized("next_cursor of the previous result, continues exactly where it stopped") );
 
 
    getTable->callback([&] {
@@ -2866,6 +3057,7 @@ int main( int argc, char** argv ) {
                          ("encode_type", encode_type)
                          ("reverse", reverse)
                          ("show_payer", show_payer)
+                         ("cursor", cursor)
                          );
 
       std::cout << fc::json::to_pretty_string(result)
@@ -3852,6 +4044,30 @@ int main( int argc, char** argv ) {
       std::cout << fc::json::to_pretty_string(trxs_result) << std::endl;
    });
 
+   // push bulk
+   string bulk_file;
+   uint32_t bulk_window = 16;
+   uint32_t bulk_batch_size = 100;
+   auto bulkSubcommand = push->add_subcommand("bulk", localized("Push one transaction per entry of a JSON file of actions, signing in batches and submitting concurrently"));
+   bulkSubcommand->add_option("file", bulk_file, localized("The JSON string or filename defining an array whose entries are an action or an array of actions"))->required();
+   bulkSubcommand->add_option("--window", bulk_window, localized("The number of transactions submitted concurrently"), true);
+   bulkSubcommand->add_option("--batch-size", bulk_batch_size, localized("The number of transactions signed by the wallet per request"), true);
+   add_standard_transaction_options_plus_signing(bulkSubcommand);
+   bulkSubcommand->callback([&] {
+      fc::variant bulk_var = json_from_file_or_string(bulk_file, fc::json::parse_type::relaxed_parser);
+      EOSC_ASSERT( bulk_var.is_array(), "ERROR: Bulk file must contain a JSON array" );
+      vector<vector<chain::action>> trx_actions;
+      for( const auto& t : bulk_var.get_array() )
+         trx_actions.emplace_back( bulk_actions_from_variant(t) );
+
+      auto results = push_bulk( std::move(trx_actions), signing_keys_opt.get_keys(), bulk_window, bulk_batch_size );
+      size_t failed = std::count_if( results.begin(), results.end(), []( const fc::variant& r ) { return r["status"].as_string() == "failed"; } );
+      std::cout << fc::json::to_pretty_string(results) << std::endl;
+      std::cerr << results.size() - failed << " of " << results.size() << " transactions succeeded" << std::endl;
+      if( failed )
+         FC_THROW_EXCEPTION( explained_exception, "${n} transactions failed", ("n", failed) );
+   });
+
 
    // multisig subcommand
    auto msig = app.add_subcommand("multisig", localized("Multisig contract commands"));
@@ -17,6 +17,7 @@
 #include <boost/filesystem/path.hpp>
 
 #include <chrono>
+#include <fstream>
 
 #ifndef _WIN32
 #define FOPEN(p, m) fopen(p, m)
@@ -47,10 +48,16 @@ struct blocklog {
    bool                             no_pretty_print = false;
    bool                             as_json_array = false;
    bool                             make_index = false;
+   bool                             make_trx_index = false;
    bool                             trim_log = false;
    bool                             fix_irreversible_blocks = false;
    bool                             smoke_test = false;
    bool                             prune_transactions = false;
+   bool                             prune_cfd          = false;
+   bool                             export_chunks      = false;
+   bool                             convert_state_history = false;
+   bool                             train_dictionary      = false;
+   bool                             train_blocks_dictionary = false;
    bool                             help               = false;
 };
 
@@ -190,6 +197,8 @@ void blocklog::set_program_options(options_description& cli)
           "Print out json blocks wrapped in json array (otherwise the output is free-standing json objects).")
          ("make-index", bpo::bool_switch(&make_index)->default_value(false),
           "Create blocks.index from blocks.log. Must give 'blocks-dir'. Give 'output-file' relative to current directory or absolute path (default is <blocks-dir>/blocks.index).")
+         ("make-trx-index", bpo::bool_switch(&make_trx_index)->default_value(false),
+          "Create blocks.trx_index from blocks.log and the retained block files in 'blocks-dir'.")
          ("trim-blocklog", bpo::bool_switch(&trim_log)->default_value(false),
           "Trim blocks.log and blocks.index. Must give 'blocks-dir' and 'first and/or 'last'.")
          ("fix-irreversible-blocks", bpo::bool_switch(&fix_irreversible_blocks)->default_value(false),
@@ -197,10 +206,45 @@ void blocklog::set_program_options(options_description& cli)
           "it will take the highest indexed block if it is valid; otherwise it will repair the block log and reconstruct the index.")
          ("smoke-test", bpo::bool_switch(&smoke_test)->default_value(false),
           "Quick test that blocks.log and blocks.index are well formed and agree with each other.")
-         ("block-num", bpo::value<uint32_t>()->default_value(0), "The block number which contains the transactions to be pruned")
+         ("block-num", bpo::value<uint32_t>()->default_value(0), "The block number which contains the transactions to be pruned. "
+          "If not given, it is looked up in blocks.trx_index")
          ("transaction,t", bpo::value<std::vector<std::string> >()->multitoken(), "The transaction id to be pruned")
          ("prune-transactions", bpo::bool_switch(&prune_transactions)->default_value(false),
           "Prune the context free data and signatures from specified transactions of specified block-num.")
+         ("export-chunks", bpo::bool_switch(&export_chunks)->default_value(false),
+          "Export blocks.log as chunks of 'blocks-log-stride' blocks named by the sha256 of their content, plus a manifest, into 'chunks-dir'. "
+          "The chunks can be imported by nodeos with 'import-block-chunks-dir'.")
+         ("blocks-log-stride", bpo::value<uint32_t>()->default_value(config::default_blocks_log_stride),
+          "the number of blocks in each exported chunk, should match the 'blocks-log-stride' of the importing node")
+         ("chunks-dir", bpo::value<bfs::path>()->default_value("chunks"),
+          "the directory the chunks and manifest are exported to (absolute path or relative to the current directory)")
+         ("prune-context-free-data", bpo::bool_switch(&prune_cfd)->default_value(false),
+          "Prune the context free data and signatures of all transactions in blocks 'first' through 'last' older than 'older-than-days' "
+          "and compact blocks.log and blocks.index to reclaim the space. Must give 'blocks-dir'. The original files are kept in <blocks-dir>/old.")
+         ("older-than-days", bpo::value<uint32_t>()->default_value(0),
+          "Only prune blocks with a timestamp more than this many days ago, 0 prunes regardless of age")
+         ("prune-threads", bpo::value<uint16_t>()->default_value(4),
+          "the number of threads used to unpack and prune blocks for 'prune-context-free-data'")
+         ("convert-state-history", bpo::bool_switch(&convert_state_history)->default_value(false),
+          "Rewrite chain_state_history.log of 'state-history-dir' with 'chain-state-history-compression'. "
+          "Retained state history files are not converted.")
+         ("train-state-history-dictionary", bpo::bool_switch(&train_dictionary)->default_value(false),
+          "Train a zstd dictionary on the entries of chain_state_history.log in 'state-history-dir' between 'first' and 'last' "
+          "and write it to 'state-history-zstd-dictionary'.")
+         ("chain-state-history-compression", bpo::value<std::string>()->default_value("zstd"),
+          "the compression \"zlib\" or \"zstd\" of the entries written by 'convert-state-history'")
+         ("state-history-zstd-dictionary", bpo::value<bfs::path>()->default_value(""),
+          "the zstd dictionary of chain_state_history.log (absolute path or relative to 'state-history-dir'), "
+          "used to read and write entries by 'convert-state-history'")
+         ("state-history-zstd-level", bpo::value<int>()->default_value(3),
+          "the zstd compression level of 'convert-state-history'")
+         ("train-blocks-dictionary", bpo::bool_switch(&train_blocks_dictionary)->default_value(false),
+          "Train a zstd dictionary on the blocks of the block log in 'blocks-dir' between 'first' and 'last' "
+          "and write it to 'blocks-zstd-dictionary', for use as the nodeos option blocks-log-zstd-dictionary.")
+         ("blocks-zstd-dictionary", bpo::value<bfs::path>()->default_value(""),
+          "the zstd dictionary written by 'train-blocks-dictionary' (absolute path or relative to 'blocks-dir')")
+         ("dictionary-size", bpo::value<uint32_t>()->default_value(112640),
+          "the maximum size in bytes of the dictionary trained by 'train-state-history-dictionary' or 'train-blocks-dictionary'")
          ("help,h", bpo::bool_switch(&help)->default_value(false), "Print this help message and exit.")
          ;
 }
@@ -277,6 +321,18 @@ int prune_transactions(const char* type, bfs::path dir, uint32_t block_num,
 int prune_transactions(bfs::path block_dir, bfs::path state_history_dir, uint32_t block_num,
                        const std::vector<transaction_id_type>& ids) {
 
+   if (block_num == 0 && ids.size() > 0 && fc::exists(block_dir / "blocks.trx_index")) {
+      block_log::config_type config;
+      config.log_dir   = block_dir;
+      config.trx_index = true;
+      block_log block_logger(config);
+      block_num = block_logger.find_block_num_by_trx_id(ids.front()).value_or(0);
+      if (block_num == 0) {
+         std::cerr << "transaction " << ids.front().str() << " is not found in blocks.trx_index\n";
+         return -1;
+      }
+   }
+
    if (block_num == 0 || ids.size() == 0) {
       std::cerr << "prune-transaction does nothing unless specify block-num and transaction\n";
       return -1;
@@ -287,6 +343,70 @@ int prune_transactions(bfs::path block_dir, bfs::path state_history_dir, uint32_
           prune_transactions<state_history_traces_log>("state history traces log", state_history_dir, block_num, ids);
 }
 
+eosio::state_history_config state_history_config(const variables_map& vmap) {
+   eosio::state_history_config config;
+   config.log_dir         = vmap.at("state-history-dir").as<bfs::path>();
+   config.zstd_dictionary = vmap.at("state-history-zstd-dictionary").as<bfs::path>();
+   config.zstd_level      = vmap.at("state-history-zstd-level").as<int>();
+   const auto compression = vmap.at("chain-state-history-compression").as<std::string>();
+   EOS_ASSERT(compression == "zlib" || compression == "zstd", state_history_exception,
+              "unknown chain-state-history-compression ${c}", ("c", compression));
+   config.chain_state_compression =
+       compression == "zstd" ? eosio::state_history::log_compression::zstd : eosio::state_history::log_compression::zlib;
+   return config;
+}
+
+void train_state_history_dictionary(const variables_map& vmap, uint32_t first_block, uint32_t last_block) {
+   auto config = state_history_config(vmap);
+   EOS_ASSERT(!config.zstd_dictionary.empty(), state_history_exception,
+              "train-state-history-dictionary needs state-history-zstd-dictionary");
+   const auto dictionary_file =
+       config.zstd_dictionary.is_relative() ? config.log_dir / config.zstd_dictionary : config.zstd_dictionary;
+   EOS_ASSERT(!fc::exists(dictionary_file), state_history_exception,
+              "${f} already exists, the entries compressed with it could not be read anymore", ("f", dictionary_file));
+
+   // the entries are read as they are, the dictionary to train does not exist yet
+   config.zstd_dictionary.clear();
+   config.chain_state_compression = eosio::state_history::log_compression::zlib;
+   eosio::state_history_chain_state_log log(config);
+
+   std::vector<std::vector<char>> samples;
+   const auto begin = std::max(first_block, log.begin_block());
+   const auto end   = last_block == std::numeric_limits<uint32_t>::max() ? log.end_block()
+                                                                       : std::min(last_block + 1, log.end_block());
+   for (auto block_num = begin; block_num < end; ++block_num) {
+      auto deltas = log.get_log_entry(block_num);
+      if (!deltas.empty())
+         samples.push_back(std::move(deltas));
+   }
+   EOS_ASSERT(!samples.empty(), state_history_exception, "no chain state history entries to train on");
+
+   const auto dictionary = eosio::state_history::zstd_train_dictionary(samples, vmap.at("dictionary-size").as<uint32_t>());
+   std::ofstream out(dictionary_file.generic_string(), std::ios::binary);
+   out.write(dictionary.data(), dictionary.size());
+   out.close();
+   EOS_ASSERT(out, state_history_exception, "unable to write ${f}", ("f", dictionary_file));
+   std::cout << "trained a dictionary of " << dictionary.size() << " bytes on " << samples.size() << " entries\n";
+}
+
+void train_blocks_dictionary(const variables_map& vmap, uint32_t first_block, uint32_t last_block) {
+   const auto blocks_dir = vmap.at("blocks-dir").as<bfs::path>();
+   auto       dictionary_file = vmap.at("blocks-zstd-dictionary").as<bfs::path>();
+   EOS_ASSERT(!dictionary_file.empty(), block_log_exception, "train-blocks-dictionary needs blocks-zstd-dictionary");
+   if (dictionary_file.is_relative())
+      dictionary_file = blocks_dir / dictionary_file;
+   EOS_ASSERT(!fc::exists(dictionary_file), block_log_exception,
+              "${f} already exists, it may be the dictionary of existing block log files", ("f", dictionary_file));
+
+   const auto dictionary =
+       block_log::train_zstd_dictionary(blocks_dir, first_block, last_block, vmap.at("dictionary-size").as<uint32_t>());
+   std::ofstream out(dictionary_file.generic_string(), std::ios::binary);
+   out.write(dictionary.data(), dictionary.size());
+   out.close();
+   EOS_ASSERT(out, block_log_exception, "unable to write ${f}", ("f", dictionary_file));
+   std::cout << "trained a dictionary of " << dictionary.size() << " bytes\n";
+}
+
 int main(int argc, char** argv) {
    std::ios::sync_with_stdio(false); // for potential performance boost for large block log files
    options_description cli ("eosio-blocklog command line options");
@@ -339,6 +459,54 @@ int main(int argc, char** argv) {
          rt.report();
          return 0;
       }
+      if (blog.export_chunks) {
+         const auto blocks_dir = vmap.at("blocks-dir").as<bfs::path>();
+         const auto chunks_dir = vmap.at("chunks-dir").as<bfs::path>();
+         const auto stride     = vmap.at("blocks-log-stride").as<uint32_t>();
+
+         report_time rt("exporting chunks");
+         const auto chunks = block_log::export_chunks(blocks_dir, chunks_dir, stride);
+         rt.report();
+         std::cout << "exported " << chunks.size() << " chunks to " << chunks_dir << '\n';
+         return 0;
+      }
+      if (blog.make_trx_index) {
+         report_time rt("making transaction index");
+         block_log::construct_trx_index(vmap.at("blocks-dir").as<bfs::path>());
+         rt.report();
+         return 0;
+      }
+      if (blog.prune_cfd) {
+         const auto blocks_dir      = vmap.at("blocks-dir").as<bfs::path>();
+         const auto older_than_days = vmap.at("older-than-days").as<uint32_t>();
+         const auto older_than      = older_than_days ? fc::time_point::now() - fc::days(older_than_days) : fc::time_point::maximum();
+
+         report_time rt("pruning context free data");
+         const auto num_pruned = block_log::prune_and_compact(blocks_dir, blocks_dir / "old", blog.first_block, blog.last_block,
+                                                              older_than, vmap.at("prune-threads").as<uint16_t>());
+         rt.report();
+         std::cout << "pruned " << num_pruned << " transactions\n";
+         return 0;
+      }
+      if (blog.train_blocks_dictionary) {
+         report_time rt("training blocks dictionary");
+         train_blocks_dictionary(vmap, blog.first_block, blog.last_block);
+         rt.report();
+         return 0;
+      }
+      if (blog.train_dictionary) {
+         report_time rt("training state history dictionary");
+         train_state_history_dictionary(vmap, blog.first_block, blog.last_block);
+         rt.report();
+         return 0;
+      }
+      if (blog.convert_state_history) {
+         report_time rt("converting state history");
+         const auto num_entries = eosio::state_history_chain_state_log::convert(state_history_config(vmap));
+         rt.report();
+         std::cout << "converted " << num_entries << " chain state history entries\n";
+         return 0;
+      }
       if (blog.prune_transactions) {
          const auto  blocks_dir        = vmap["blocks-dir"].as<bfs::path>();
          const auto  state_history_dir = vmap["state-history-dir"].as<bfs::path>();
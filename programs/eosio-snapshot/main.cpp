@@ -0,0 +1,442 @@
+#include <eosio/chain/combined_database.hpp>
+#include <eosio/chain/permission_link_object.hpp>
+#include <eosio/chain/permission_object.hpp>
+#include <eosio/chain/resource_limits_private.hpp>
+#include <eosio/chain/snapshot.hpp>
+#include <eosio/chain/thread_utils.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/variant.hpp>
+#include <fc/variant_object.hpp>
+
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <set>
+
+using namespace eosio::chain;
+namespace bfs = boost::filesystem;
+namespace bpo = boost::program_options;
+using bpo::options_description;
+using bpo::variables_map;
+
+namespace {
+
+   // authorization_manager and resource_limits_manager keep their index sets private, mirror them here
+   using snapshot_tool_index_set = index_set<
+      permission_index,
+      permission_usage_index,
+      permission_link_index,
+      resource_limits::resource_limits_index,
+      resource_limits::resource_usage_index,
+      resource_limits::resource_limits_state_index,
+      resource_limits::resource_limits_config_index
+   >;
+
+   // each decoder only ever holds a single row, the size only has to fit the largest code_object
+   constexpr uint64_t decode_db_size = 256*1024*1024ll;
+
+   struct section_entry {
+      std::string name;
+      uint64_t    pos       = 0; ///< offset of the section size field from the start of the file
+      uint64_t    size      = 0; ///< number of bytes following the section size field
+      uint64_t    row_count = 0;
+   };
+
+   /**
+    * Scans the section headers of a binary snapshot without reading any row data
+    */
+   std::vector<section_entry> index_sections(std::istream& in, uint32_t& version) {
+      uint32_t magic = 0;
+      in.read((char*)&magic, sizeof(magic));
+      in.read((char*)&version, sizeof(version));
+      EOS_ASSERT(in && magic == ostream_snapshot_writer::magic_number, snapshot_validation_exception,
+                 "File is not a binary snapshot (compressed and delta snapshots are not supported)");
+
+      std::vector<section_entry> sections;
+      while (true) {
+         section_entry entry;
+         entry.pos = in.tellg();
+         in.read((char*)&entry.size, sizeof(entry.size));
+         EOS_ASSERT(in, snapshot_validation_exception, "Snapshot is truncated, no end marker found");
+         if (entry.size == std::numeric_limits<uint64_t>::max())
+            break;
+
+         in.read((char*)&entry.row_count, sizeof(entry.row_count));
+         std::getline(in, entry.name, '\0');
+         EOS_ASSERT(in, snapshot_validation_exception, "Snapshot is truncated in section header");
+         in.seekg(entry.pos + sizeof(entry.size) + entry.size);
+         sections.emplace_back(std::move(entry));
+      }
+      return sections;
+   }
+
+   /// a selector matches the full section name or its unqualified type name
+   bool section_selected(const std::string& name, const std::set<std::string>& selectors) {
+      if (selectors.empty() || selectors.count(name))
+         return true;
+      auto pos = name.rfind("::");
+      return pos != std::string::npos && selectors.count(name.substr(pos + 2));
+   }
+
+   struct row_filter {
+      std::set<name> codes;
+      std::set<name> tables;
+
+      bool match_code(name code) const { return codes.empty() || codes.count(code); }
+      bool match(const table_id_object& t) const { return match_code(t.code) && (tables.empty() || tables.count(t.table)); }
+   };
+
+   /**
+    * Decodes rows of a section to JSON lines.  Chainbase objects can only be constructed inside of a database, so
+    * each decoder owns a scratch database that holds the row currently being decoded.
+    */
+   class section_decoder {
+   public:
+      section_decoder(const row_filter& filter, uint32_t version)
+      : filter(filter)
+      , version(version)
+      , db(tmp.path(), chainbase::database::read_write, decode_db_size) {
+         controller_index_set::add_indices(db);
+         contract_database_index_set::add_indices(db);
+         snapshot_tool_index_set::add_indices(db);
+         db.add_index<kv_index>();
+      }
+
+      /// @return the number of rows written to out
+      uint64_t decode(snapshot_reader& reader, const std::string& section_name, std::ostream& out) {
+         uint64_t written = 0;
+         auto emit = [&out, &written](const fc::variant& v) {
+            out << fc::json::to_string(v, fc::time_point::maximum()) << '\n';
+            ++written;
+         };
+
+         bool handled = false;
+         if (section_name == "contract_tables") {
+            reader.read_section(section_name, [&](auto& section) { decode_contract_tables(section, emit); });
+            handled = true;
+         } else if (section_name == detail::snapshot_section_traits<chain_snapshot_header>::section_name()) {
+            reader.read_section(section_name, [&](auto& section) { decode_plain_rows<chain_snapshot_header>(section, emit); });
+            handled = true;
+         } else if (section_name == detail::snapshot_section_traits<block_state>::section_name()) {
+            using v2 = legacy::snapshot_block_header_state_v2;
+            reader.read_section(section_name, [&](auto& section) {
+               if (std::clamp(version, v2::minimum_version, v2::maximum_version) == version)
+                  decode_plain_rows<v2>(section, emit);
+               else
+                  decode_plain_rows<block_header_state>(section, emit);
+            });
+            handled = true;
+         } else if (section_name == detail::snapshot_section_traits<genesis_state>::section_name()) {
+            reader.read_section(section_name, [&](auto& section) { decode_plain_rows<genesis_state>(section, emit); });
+            handled = true;
+         } else if (section_name == detail::snapshot_section_traits<kv_object>::section_name()) {
+            reader.read_section(section_name, [&](auto& section) {
+               decode_index_rows<kv_index>(section, [this, &emit](const kv_object& row) {
+                  if (filter.match_code(row.contract))
+                     emit(fc::variant(row));
+               });
+            });
+            handled = true;
+         }
+
+         auto walk = [&](auto utils) {
+            using index_t = typename decltype(utils)::index_t;
+            using value_t = typename index_t::value_type;
+            if (handled || section_name != detail::snapshot_section_traits<value_t>::section_name())
+               return;
+            handled = true;
+            reader.read_section(section_name, [&](auto& section) { decode_object_rows<index_t>(section, emit); });
+         };
+         controller_index_set::walk_indices(walk);
+         snapshot_tool_index_set::walk_indices(walk);
+
+         EOS_ASSERT(handled, snapshot_exception, "Unknown snapshot section ${s}, it can only be extracted in binary format",
+                    ("s", section_name));
+         return written;
+      }
+
+   private:
+      template <typename Row, typename Section, typename Emit>
+      void decode_plain_rows(Section& section, Emit& emit) {
+         bool more = !section.empty();
+         while (more) {
+            Row row;
+            more = section.read_row(row, db);
+            emit(fc::variant(row));
+         }
+      }
+
+      template <typename Index, typename Section, typename F>
+      void decode_index_rows(Section& section, F&& f) {
+         using value_t = typename Index::value_type;
+         bool more = !section.empty();
+         while (more) {
+            const auto& row = db.create<value_t>([this, &section, &more](auto& row) { more = section.read_row(row, db); });
+            f(row);
+            db.remove(row);
+         }
+      }
+
+      template <typename Index, typename Section, typename Emit>
+      void decode_object_rows(Section& section, Emit& emit) {
+         using value_t = typename Index::value_type;
+
+         if constexpr (std::is_same_v<value_t, permission_object>) {
+            // the snapshot row traits for permissions are private to authorization_manager
+            decode_plain_rows<snapshot_permission_object>(section, emit);
+         } else if constexpr (std::is_same_v<value_t, global_property_object>) {
+            using v2 = legacy::snapshot_global_property_object_v2;
+            using v3 = legacy::snapshot_global_property_object_v3;
+            using v4 = legacy::snapshot_global_property_object_v4;
+            if (std::clamp(version, v2::minimum_version, v2::maximum_version) == version)
+               decode_plain_rows<v2>(section, emit);
+            else if (std::clamp(version, v3::minimum_version, v3::maximum_version) == version)
+               decode_plain_rows<v3>(section, emit);
+            else if (std::clamp(version, v4::minimum_version, v4::maximum_version) == version)
+               decode_plain_rows<v4>(section, emit);
+            else
+               decode_plain_rows<typename detail::snapshot_row_traits<value_t>::snapshot_type>(section, emit);
+         } else if constexpr (!std::is_same_v<value_t, typename detail::snapshot_row_traits<value_t>::snapshot_type>) {
+            decode_plain_rows<typename detail::snapshot_row_traits<value_t>::snapshot_type>(section, emit);
+         } else {
+            if constexpr (has_legacy_v3<value_t>(0)) {
+               using v3 = typename value_t::v3;
+               if (v3::minimum_version <= version && version <= v3::maximum_version) {
+                  decode_plain_rows<v3>(section, emit);
+                  return;
+               }
+            }
+            decode_index_rows<Index>(section, [&emit](const value_t& row) { emit(fc::variant(row)); });
+         }
+      }
+
+      template <typename T>
+      static constexpr auto has_legacy_v3(int) -> decltype(std::declval<typename T::v3>(), bool()) {
+         return !std::is_same_v<typename T::v3, T>;
+      }
+      template <typename T>
+      static constexpr bool has_legacy_v3(...) { return false; }
+
+      /// mirrors the layout read by combined_database::read_contract_tables_from_snapshot
+      template <typename Section, typename Emit>
+      void decode_contract_tables(Section& section, Emit& emit) {
+         bool more = !section.empty();
+         while (more) {
+            const auto& table = db.create<table_id_object>([this, &section](auto& row) { section.read_row(row, db); });
+            const bool  selected = filter.match(table);
+
+            contract_database_index_set::walk_indices([this, &section, &more, &table, selected, &emit](auto utils) {
+               using value_t = typename decltype(utils)::index_t::value_type;
+
+               unsigned_int size;
+               more = section.read_row(size, db);
+
+               for (size_t idx = 0; idx < size.value; ++idx) {
+                  const auto& row = db.create<value_t>([this, &section, &more, &table](auto& row) {
+                     row.t_id = table.id;
+                     more     = section.read_row(row, db);
+                  });
+                  if (selected) {
+                     emit(fc::mutable_variant_object()
+                        ("code", table.code)
+                        ("scope", table.scope)
+                        ("table", table.table)
+                        ("index", detail::snapshot_section_traits<value_t>::section_name())
+                        ("row", row));
+                  }
+                  db.remove(row);
+               }
+            });
+            db.remove(table);
+         }
+      }
+
+      const row_filter&   filter;
+      const uint32_t      version;
+      fc::temp_directory  tmp;
+      chainbase::database db;
+   };
+
+   /**
+    * Copies the selected sections verbatim into a new binary snapshot.  The chain_snapshot_header section is
+    * always kept so the result can be opened by istream_snapshot_reader.
+    */
+   void extract_binary(std::istream& in, uint32_t version, const std::vector<section_entry>& sections,
+                       const bfs::path& out_file) {
+      std::ofstream out(out_file.generic_string(), (std::ios::out | std::ios::binary));
+      EOS_ASSERT(out.good(), snapshot_exception, "Unable to open ${f} for writing", ("f", out_file.generic_string()));
+
+      const uint32_t magic = ostream_snapshot_writer::magic_number;
+      out.write((const char*)&magic, sizeof(magic));
+      out.write((const char*)&version, sizeof(version));
+
+      std::vector<char> buf(1024*1024);
+      for (const auto& s : sections) {
+         in.seekg(s.pos);
+         uint64_t remaining = sizeof(s.size) + s.size;
+         while (remaining) {
+            const auto n = std::min<uint64_t>(remaining, buf.size());
+            in.read(buf.data(), n);
+            EOS_ASSERT(in, snapshot_exception, "Failed reading section ${s}", ("s", s.name));
+            out.write(buf.data(), n);
+            remaining -= n;
+         }
+      }
+
+      const uint64_t end_marker = std::numeric_limits<uint64_t>::max();
+      out.write((const char*)&end_marker, sizeof(end_marker));
+      out.flush();
+      EOS_ASSERT(out.good(), snapshot_exception, "Failed writing ${f}", ("f", out_file.generic_string()));
+   }
+
+   std::string section_file_name(std::string name) {
+      std::replace(name.begin(), name.end(), ':', '_');
+      return name + ".json";
+   }
+
+   struct report_time {
+      report_time(std::string desc)
+      : _start(std::chrono::high_resolution_clock::now())
+      , _desc(desc) {
+      }
+
+      void report() {
+         const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - _start).count() / 1000.0;
+         ilog("eosio-snapshot - ${desc} took ${t} sec", ("desc", _desc)("t", duration));
+      }
+
+      const std::chrono::high_resolution_clock::time_point _start;
+      const std::string                                    _desc;
+   };
+
+} // namespace
+
+int main(int argc, char** argv) {
+   std::ios::sync_with_stdio(false);
+   options_description cli ("eosio-snapshot command line options");
+   try {
+      bfs::path                snapshot_path;
+      bfs::path                output_dir;
+      std::string              format;
+      std::vector<std::string> section_opts;
+      std::vector<std::string> code_opts;
+      std::vector<std::string> table_opts;
+      uint16_t                 threads = 1;
+
+      cli.add_options()
+            ("snapshot,s", bpo::value<bfs::path>(&snapshot_path), "the binary snapshot file to inspect")
+            ("list", bpo::bool_switch()->default_value(false),
+             "list the name, file offset, size and row count of every section and exit")
+            ("section", bpo::value<std::vector<std::string>>(&section_opts)->composing(),
+             "a section to extract, either the full section name or the unqualified type name (e.g. account_object). "
+             "May be specified multiple times, if not specified all sections are extracted")
+            ("output-dir,o", bpo::value<bfs::path>(&output_dir)->default_value("."),
+             "the directory to write extracted sections to")
+            ("format", bpo::value<std::string>(&format)->default_value("json"),
+             "output format, 'json' writes one file of JSON lines per section, "
+             "'binary' writes the selected sections as a new snapshot named snapshot.bin")
+            ("code", bpo::value<std::vector<std::string>>(&code_opts)->composing(),
+             "only decode contract_tables and kv_object rows of this contract. May be specified multiple times")
+            ("table", bpo::value<std::vector<std::string>>(&table_opts)->composing(),
+             "only decode contract_tables rows of this table. May be specified multiple times")
+            ("threads", bpo::value<uint16_t>(&threads)->default_value(1),
+             "number of sections decoded in parallel in json format")
+            ("help,h", bpo::bool_switch()->default_value(false), "Print this help message and exit.")
+            ;
+      variables_map vmap;
+      bpo::store(bpo::parse_command_line(argc, argv, cli), vmap);
+      bpo::notify(vmap);
+      if (vmap.at("help").as<bool>() || snapshot_path.empty()) {
+         cli.print(std::cerr);
+         return 0;
+      }
+      EOS_ASSERT(format == "json" || format == "binary", fc::invalid_arg_exception, "Unknown format ${f}", ("f", format));
+      EOS_ASSERT(threads > 0, fc::invalid_arg_exception, "threads must be greater than 0");
+
+      std::ifstream in(snapshot_path.generic_string(), (std::ios::in | std::ios::binary));
+      EOS_ASSERT(in.good(), snapshot_exception, "Unable to open ${f}", ("f", snapshot_path.generic_string()));
+
+      uint32_t version = 0;
+      const auto sections = index_sections(in, version);
+
+      if (vmap.at("list").as<bool>()) {
+         std::cout << "version " << version << '\n';
+         for (const auto& s : sections)
+            std::cout << s.name << '\t' << s.pos << '\t' << s.size << '\t' << s.row_count << '\n';
+         return 0;
+      }
+
+      const std::set<std::string> selectors(section_opts.begin(), section_opts.end());
+      std::vector<section_entry>  selected;
+      for (const auto& s : sections) {
+         if (section_selected(s.name, selectors))
+            selected.push_back(s);
+      }
+      for (const auto& sel : selectors) {
+         EOS_ASSERT(std::any_of(selected.begin(), selected.end(),
+                                [&sel](const auto& s) { return section_selected(s.name, {sel}); }),
+                    snapshot_exception, "Section ${s} not found in snapshot", ("s", sel));
+      }
+
+      bfs::create_directories(output_dir);
+
+      if (format == "binary") {
+         const auto header_name = detail::snapshot_section_traits<chain_snapshot_header>::section_name();
+         if (!section_selected(header_name, selectors)) {
+            auto header = std::find_if(sections.begin(), sections.end(), [&](const auto& s) { return s.name == header_name; });
+            EOS_ASSERT(header != sections.end(), snapshot_exception, "Snapshot has no chain_snapshot_header section");
+            selected.insert(selected.begin(), *header);
+         }
+         report_time rt("extracting binary sections");
+         extract_binary(in, version, selected, output_dir / "snapshot.bin");
+         rt.report();
+         return 0;
+      }
+
+      row_filter filter;
+      for (const auto& c : code_opts)
+         filter.codes.insert(name(c));
+      for (const auto& t : table_opts)
+         filter.tables.insert(name(t));
+
+      report_time rt("decoding sections");
+      named_thread_pool pool("snap", threads);
+      std::vector<std::future<uint64_t>> results;
+      for (const auto& s : selected) {
+         results.emplace_back(async_thread_pool(pool.get_executor(), [&snapshot_path, &output_dir, &filter, version, s]() {
+            std::ifstream snapshot_in(snapshot_path.generic_string(), (std::ios::in | std::ios::binary));
+            istream_snapshot_reader reader(snapshot_in);
+            std::ofstream out((output_dir / section_file_name(s.name)).generic_string());
+            section_decoder decoder(filter, version);
+            return decoder.decode(reader, s.name, out);
+         }));
+      }
+      for (size_t i = 0; i < results.size(); ++i) {
+         const auto rows = results[i].get();
+         ilog("${s}: ${n} rows", ("s", selected[i].name)("n", rows));
+      }
+      rt.report();
+   } catch( const fc::exception& e ) {
+      elog( "${e}", ("e", e.to_detail_string()));
+      return -1;
+   } catch( const boost::exception& e ) {
+      elog("${e}", ("e",boost::diagnostic_information(e)));
+      return -1;
+   } catch( const std::exception& e ) {
+      elog("${e}", ("e",e.what()));
+      return -1;
+   } catch( ... ) {
+      elog("unknown exception");
+      return -1;
+   }
+
+   return 0;
+}
@@ -20,7 +20,12 @@
 #include <eosio/vm/backend.hpp>
 
 #include <chrono>
+#include <fstream>
+#include <map>
+#include <sstream>
 #include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace eosio::literals;
 using namespace std::literals;
@@ -191,6 +196,27 @@ struct test_chain {
    std::set<test_chain_ref*>                         refs;
 
    test_chain(const char* snapshot) {
+      if (snapshot && *snapshot) {
+         std::ifstream snapshot_file(snapshot, (std::ios::in | std::ios::binary));
+         if (!snapshot_file.is_open())
+            throw std::runtime_error("can not open " + std::string{ snapshot });
+         open(&snapshot_file);
+      } else {
+         open(nullptr);
+      }
+   }
+
+   // starts from a snapshot held in memory, see clone_chain
+   explicit test_chain(std::istream& snapshot) { open(&snapshot); }
+
+   test_chain(const test_chain&) = delete;
+   test_chain& operator=(const test_chain&) = delete;
+
+   ~test_chain() {
+      for (auto* ref : refs) ref->chain = nullptr;
+   }
+
+   void open(std::istream* snapshot) {
       eosio::chain::genesis_state genesis;
       genesis.initial_timestamp = fc::time_point::from_iso_string("2020-01-01T00:00:00.000");
       cfg                       = std::make_unique<eosio::chain::controller::config>();
@@ -199,20 +225,17 @@ struct test_chain {
       cfg->contracts_console    = true;
       cfg->wasm_runtime         = eosio::chain::wasm_interface::vm_type::eos_vm_jit;
 
-      std::optional<std::ifstream>                           snapshot_file;
       std::shared_ptr<eosio::chain::istream_snapshot_reader> snapshot_reader;
-      if (snapshot && *snapshot) {
+      if (snapshot) {
          std::optional<eosio::chain::chain_id_type> chain_id;
          {
-            std::ifstream temp_file(snapshot, (std::ios::in | std::ios::binary));
-            if (!temp_file.is_open())
-               throw std::runtime_error("can not open " + std::string{ snapshot });
-            eosio::chain::istream_snapshot_reader tmp_reader(temp_file);
+            eosio::chain::istream_snapshot_reader tmp_reader(*snapshot);
             tmp_reader.validate();
             chain_id = eosio::chain::controller::extract_chain_id(tmp_reader);
          }
-         snapshot_file.emplace(snapshot, std::ios::in | std::ios::binary);
-         snapshot_reader = std::make_shared<eosio::chain::istream_snapshot_reader>(*snapshot_file);
+         snapshot->clear();
+         snapshot->seekg(0);
+         snapshot_reader = std::make_shared<eosio::chain::istream_snapshot_reader>(*snapshot);
          control         = std::make_unique<eosio::chain::controller>(*cfg, make_protocol_feature_set(), *chain_id);
       } else {
          control = std::make_unique<eosio::chain::controller>(*cfg, make_protocol_feature_set(),
@@ -239,13 +262,6 @@ struct test_chain {
       }
    }
 
-   test_chain(const test_chain&) = delete;
-   test_chain& operator=(const test_chain&) = delete;
-
-   ~test_chain() {
-      for (auto* ref : refs) ref->chain = nullptr;
-   }
-
    void on_applied_transaction(const transaction_trace_ptr& p, const packed_transaction_ptr& t) {
       trace_cache.add_transaction(p, t);
    }
@@ -302,6 +318,17 @@ struct test_chain {
       control->finalize_block([&](eosio::chain::digest_type d) { return std::vector{ producer_key.sign(d) }; });
       control->commit_block();
    }
+
+   // a snapshot can not hold a pending block, the one being built is finished first
+   std::string write_snapshot() {
+      if (control->is_building_block())
+         finish_block();
+      std::ostringstream out(std::ios::out | std::ios::binary);
+      auto writer = std::make_shared<eosio::chain::ostream_snapshot_writer>(out);
+      control->write_snapshot(writer);
+      writer->finalize();
+      return out.str();
+   }
 };
 
 test_chain_ref::test_chain_ref(test_chain& chain) {
@@ -738,6 +765,24 @@ struct callbacks {
       return state.chains.size() - 1;
    }
 
+   // a copy of the chain's state which can diverge from it, cheaper than replaying the setup on a new chain
+   uint32_t clone_chain(uint32_t chain) {
+      std::istringstream snapshot(assert_chain(chain).write_snapshot(), std::ios::in | std::ios::binary);
+      state.chains.push_back(std::make_unique<test_chain>(snapshot));
+      return state.chains.size() - 1;
+   }
+
+   // the file can be passed to create_chain, e.g. by a later run or another wasm
+   void write_chain_snapshot(uint32_t chain, span<const char> filename) {
+      auto          snapshot = assert_chain(chain).write_snapshot();
+      std::ofstream out(span_str(filename), std::ios::out | std::ios::binary | std::ios::trunc);
+      if (!out.is_open())
+         throw std::runtime_error("can not open " + span_str(filename));
+      out.write(snapshot.data(), snapshot.size());
+      if (!out)
+         throw std::runtime_error("can not write " + span_str(filename));
+   }
+
    void destroy_chain(uint32_t chain) {
       assert_chain(chain, false);
       if (state.selected_chain_index && *state.selected_chain_index == chain)
@@ -1174,6 +1219,8 @@ void register_callbacks() {
    rhf_t::add<&callbacks::read_whole_file>("env", "read_whole_file");
    rhf_t::add<&callbacks::execute>("env", "execute");
    rhf_t::add<&callbacks::create_chain>("env", "create_chain");
+   rhf_t::add<&callbacks::clone_chain>("env", "clone_chain");
+   rhf_t::add<&callbacks::write_chain_snapshot>("env", "write_chain_snapshot");
    rhf_t::add<&callbacks::destroy_chain>("env", "destroy_chain");
    rhf_t::add<&callbacks::shutdown_chain>("env", "shutdown_chain");
    rhf_t::add<&callbacks::get_chain_path>("env", "get_chain_path");
@@ -1247,20 +1294,108 @@ static void run(const char* wasm, const std::vector<std::string>& args) {
    backend(cb, "env", "start", 0);
 }
 
-const char usage[] = "usage: eosio-tester [-h or --help] [-v or --verbose] file.wasm [args for wasm]\n";
+static int run_and_report(const char* wasm, const std::vector<std::string>& args) {
+   try {
+      run(wasm, args);
+      return 0;
+   } catch (::assert_exception& e) {
+      std::cerr << "tester wasm asserted: " << e.what() << "\n";
+   } catch (eosio::vm::exception& e) {
+      std::cerr << "vm::exception: " << e.detail() << "\n";
+   } catch (fc::exception& e) {
+      std::cerr << "fc::exception: " << e.to_string() << "\n";
+   } catch (std::exception& e) {
+      std::cerr << "std::exception: " << e.what() << "\n";
+   }
+   return 1;
+}
+
+// Runs each wasm in its own process, up to jobs at a time. The callbacks keep process wide state (the files, the
+// logger, the registered host functions) so wasms are not run on threads. The output of a wasm is captured and
+// printed once it exits, so the output of wasms running together does not interleave.
+static int run_parallel(const std::vector<const char*>& wasms, const std::vector<std::string>& args, unsigned jobs) {
+   struct child {
+      const char* wasm;
+      FILE*       output;
+   };
+   std::map<pid_t, child> running;
+   size_t                 next   = 0;
+   int                    failed = 0;
+
+   auto wait_one = [&] {
+      int   status = 0;
+      pid_t pid    = waitpid(-1, &status, 0);
+      if (pid < 0)
+         throw std::runtime_error("waitpid failed: "s + strerror(errno));
+      auto it = running.find(pid);
+      if (it == running.end())
+         return;
+      auto [wasm, output] = it->second;
+      running.erase(it);
+
+      char   buf[4096];
+      size_t size;
+      rewind(output);
+      while ((size = fread(buf, 1, sizeof(buf), output)) > 0) fwrite(buf, 1, size, stdout);
+      fclose(output);
+      bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+      if (!ok)
+         ++failed;
+      printf("%s: %s\n", wasm, ok ? "passed" : "failed");
+      fflush(stdout);
+   };
+
+   while (next < wasms.size() || !running.empty()) {
+      if (next < wasms.size() && running.size() < jobs) {
+         FILE* output = tmpfile();
+         if (!output)
+            throw std::runtime_error("can not create a temporary file: "s + strerror(errno));
+         fflush(stdout);
+         fflush(stderr);
+         pid_t pid = fork();
+         if (pid < 0)
+            throw std::runtime_error("fork failed: "s + strerror(errno));
+         if (pid == 0) {
+            dup2(fileno(output), STDOUT_FILENO);
+            dup2(fileno(output), STDERR_FILENO);
+            int result = run_and_report(wasms[next], args);
+            fflush(stdout);
+            fflush(stderr);
+            _exit(result);
+         }
+         running.emplace(pid, child{ wasms[next], output });
+         ++next;
+      } else {
+         wait_one();
+      }
+   }
+   printf("%d of %d wasms failed\n", failed, int(wasms.size()));
+   return failed ? 1 : 0;
+}
+
+const char usage[] = "usage: eosio-tester [-h or --help] [-v or --verbose] file.wasm [args for wasm]\n"
+                     "       eosio-tester [-h or --help] [-v or --verbose] -j N or --jobs N file.wasm... [-- args for each wasm]\n";
 
 int main(int argc, char* argv[]) {
    fc::logger::get(DEFAULT_LOGGER).set_log_level(fc::log_level::off);
 
-   bool show_usage = false;
-   bool error      = false;
-   int  next_arg   = 1;
+   bool     show_usage = false;
+   bool     error      = false;
+   unsigned jobs       = 0;
+   int      next_arg   = 1;
    while (next_arg < argc && argv[next_arg][0] == '-') {
       if (!strcmp(argv[next_arg], "-h") || !strcmp(argv[next_arg], "--help"))
          show_usage = true;
       else if (!strcmp(argv[next_arg], "-v") || !strcmp(argv[next_arg], "--verbose"))
          fc::logger::get(DEFAULT_LOGGER).set_log_level(fc::log_level::debug);
-      else {
+      else if (!strcmp(argv[next_arg], "-j") || !strcmp(argv[next_arg], "--jobs")) {
+         if (next_arg + 1 < argc && (jobs = atoi(argv[next_arg + 1])) > 0)
+            ++next_arg;
+         else {
+            std::cerr << argv[next_arg] << " needs a number of jobs\n";
+            error = true;
+         }
+      } else {
          std::cerr << "unknown option: " << argv[next_arg] << "\n";
          error = true;
       }
@@ -1272,19 +1407,19 @@ int main(int argc, char* argv[]) {
       std::cerr << usage;
       return error;
    }
+   register_callbacks();
+   if (!jobs)
+      return run_and_report(argv[next_arg], { argv + next_arg + 1, argv + argc });
+
+   std::vector<const char*> wasms;
+   while (next_arg < argc && strcmp(argv[next_arg], "--")) wasms.push_back(argv[next_arg++]);
+   std::vector<std::string> args;
+   if (next_arg < argc)
+      args.assign(argv + next_arg + 1, argv + argc);
    try {
-      std::vector<std::string> args{ argv + next_arg + 1, argv + argc };
-      register_callbacks();
-      run(argv[next_arg], args);
-      return 0;
-   } catch (::assert_exception& e) {
-      std::cerr << "tester wasm asserted: " << e.what() << "\n";
-   } catch (eosio::vm::exception& e) {
-      std::cerr << "vm::exception: " << e.detail() << "\n";
-   } catch (fc::exception& e) {
-      std::cerr << "fc::exception: " << e.to_string() << "\n";
-   } catch (std::exception& e) { 
-     std::cerr << "std::exception: " << e.what() << "\n"; 
+      return run_parallel(wasms, args, jobs);
+   } catch (std::exception& e) {
+      std::cerr << "std::exception: " << e.what() << "\n";
+      return 1;
    }
-   return 1;
 }
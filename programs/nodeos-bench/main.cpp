@@ -0,0 +1,423 @@
+#include <eosio/chain/asset.hpp>
+#include <eosio/chain/block_apply_metrics.hpp>
+#include <eosio/chain/block_log.hpp>
+#include <eosio/chain/controller.hpp>
+#include <eosio/chain/protocol_feature_manager.hpp>
+#include <eosio/chain/snapshot.hpp>
+#include <eosio/chain/transaction_object.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/variant.hpp>
+#include <fc/variant_object.hpp>
+
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <optional>
+
+using namespace eosio::chain;
+namespace bfs = boost::filesystem;
+namespace bpo = boost::program_options;
+using bpo::options_description;
+using bpo::variables_map;
+
+namespace {
+
+   /// every builtin protocol feature with its default subjective restrictions, so any block of the chain can be applied
+   protocol_feature_set make_builtin_protocol_feature_set() {
+      protocol_feature_set pfs;
+      std::map<builtin_protocol_feature_t, std::optional<digest_type>> visited_builtins;
+
+      std::function<digest_type(builtin_protocol_feature_t)> add_builtins =
+      [&pfs, &visited_builtins, &add_builtins](builtin_protocol_feature_t codename) -> digest_type {
+         auto res = visited_builtins.emplace(codename, std::optional<digest_type>());
+         if (!res.second) {
+            EOS_ASSERT(res.first->second, protocol_feature_exception,
+                       "invariant failure: cycle found in builtin protocol feature dependencies");
+            return *res.first->second;
+         }
+
+         auto f = protocol_feature_set::make_default_builtin_protocol_feature(codename,
+                     [&add_builtins](builtin_protocol_feature_t d) { return add_builtins(d); });
+         const auto& pf = pfs.add_feature(f);
+         res.first->second = pf.feature_digest;
+         return pf.feature_digest;
+      };
+
+      for (const auto& p : builtin_protocol_feature_codenames)
+         add_builtins(p.first);
+      return pfs;
+   }
+
+   snapshot_reader_ptr make_snapshot_reader(std::istream& infile) {
+      if (compressed_istream_snapshot_reader::is_compressed_snapshot(infile))
+         return std::make_shared<compressed_istream_snapshot_reader>(infile);
+      EOS_ASSERT(!delta_istream_snapshot_reader::is_delta_snapshot(infile), snapshot_exception,
+                 "Delta snapshots are not supported, start from a full snapshot");
+      return std::make_shared<istream_snapshot_reader>(infile);
+   }
+
+   backing_store_type parse_backing_store(const std::string& s) {
+      if (s == "chainbase")
+         return backing_store_type::CHAINBASE;
+      if (s == "rocksdb")
+         return backing_store_type::ROCKSDB;
+      EOS_THROW(fc::invalid_arg_exception, "Unknown backing-store ${s}", ("s", s));
+   }
+
+   struct report_time {
+      report_time(std::string desc)
+      : _start(std::chrono::high_resolution_clock::now())
+      , _desc(desc) {
+      }
+
+      int64_t elapsed_us() const {
+         return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - _start).count();
+      }
+
+      void report() {
+         ilog("nodeos-bench - ${desc} took ${t} sec", ("desc", _desc)("t", elapsed_us() / 1000000.0));
+      }
+
+      const std::chrono::high_resolution_clock::time_point _start;
+      const std::string                                    _desc;
+   };
+
+   struct dedup_benchmark_options {
+      uint32_t blocks          = 0;
+      uint32_t trxs_per_block  = 1000;
+      uint32_t expiration_sec  = 60;
+      uint32_t lookups         = 1000; ///< per block
+   };
+
+   /**
+    * Measures the transaction dedup table as the controller uses it: every block, in its own undo session, the
+    * expired transaction_objects are removed, as clear_expired_input_transactions does, and trxs_per_block ones are
+    * created, as transaction_context::record_transaction does. Blocks are half a second apart and become irreversible
+    * immediately.
+    */
+   fc::variant run_dedup_benchmark(const bfs::path& state_dir, uint64_t state_size, const dedup_benchmark_options& opts) {
+      using clock = std::chrono::high_resolution_clock;
+      auto ns = [](clock::duration d) { return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count(); };
+
+      chainbase::database db(state_dir, chainbase::database::read_write, state_size);
+      db.add_index<transaction_index>();
+      const auto& dedupe_index = db.get_index<transaction_multi_index, by_expiration>();
+
+      uint64_t next_id = 0;
+      auto make_id = [](uint64_t n) { return transaction_id_type::hash(n); };
+
+      uint64_t inserted = 0, expired = 0, lookups = 0, found = 0;
+      uint64_t insert_ns = 0, expire_ns = 0, lookup_ns = 0, commit_ns = 0;
+      size_t   max_size = 0;
+      fc::time_point block_time = fc::time_point::now();
+      for (uint32_t b = 0; b < opts.blocks; ++b) {
+         block_time += fc::milliseconds(config::block_interval_ms);
+         auto session = db.start_undo_session(true);
+
+         auto start = clock::now();
+         auto& transaction_idx = db.get_mutable_index<transaction_multi_index>();
+         while (!dedupe_index.empty() && block_time > fc::time_point(dedupe_index.begin()->expiration)) {
+            transaction_idx.remove(*dedupe_index.begin());
+            ++expired;
+         }
+         expire_ns += ns(clock::now() - start);
+
+         // as is_known_unexpired_transaction, half the lookups are of unexpired transactions, which are the most
+         // recently created ones, and half of transactions not yet created
+         const uint64_t unexpired = dedupe_index.size();
+         start = clock::now();
+         for (uint32_t i = 0; i < opts.lookups && unexpired; ++i) {
+            const uint64_t n = i % 2 ? next_id + i : next_id - 1 - (i * 7919) % unexpired;
+            if (db.find<transaction_object, by_trx_id>(make_id(n)))
+               ++found;
+         }
+         lookup_ns += ns(clock::now() - start);
+         lookups += unexpired ? opts.lookups : 0;
+
+         const fc::time_point_sec expiration(block_time + fc::seconds(opts.expiration_sec));
+         std::vector<transaction_id_type> ids;
+         ids.reserve(opts.trxs_per_block);
+         for (uint32_t i = 0; i < opts.trxs_per_block; ++i)
+            ids.push_back(make_id(next_id++));
+         start = clock::now();
+         for (const auto& id : ids) {
+            db.create<transaction_object>([&](transaction_object& transaction) {
+               transaction.trx_id = id;
+               transaction.expiration = expiration;
+            });
+         }
+         insert_ns += ns(clock::now() - start);
+         inserted += ids.size();
+         max_size = std::max(max_size, dedupe_index.size());
+
+         start = clock::now();
+         session.push();
+         db.commit(db.revision());
+         commit_ns += ns(clock::now() - start);
+      }
+
+      auto per = [](uint64_t total_ns, uint64_t n) { return n ? total_ns / (double)n : 0.0; };
+      return fc::mutable_variant_object()
+         ("blocks", opts.blocks)
+         ("trxs_per_block", opts.trxs_per_block)
+         ("expiration_sec", opts.expiration_sec)
+         ("max_table_size", max_size)
+         ("inserted", inserted)
+         ("expired", expired)
+         ("lookups", lookups)
+         ("lookups_found", found)
+         ("insert_ns_per_trx", per(insert_ns, inserted))
+         ("expire_ns_per_trx", per(expire_ns, expired))
+         ("lookup_ns", per(lookup_ns, lookups))
+         ("commit_ns_per_block", per(commit_ns, opts.blocks));
+   }
+
+   /**
+    * Measures converting names and assets to and from strings, as abi_serializer does for every name and asset field
+    * of the actions and tables it renders or parses, over a fixed set of typical values.
+    */
+   fc::variant run_name_conversion_benchmark(uint32_t iterations) {
+      using clock = std::chrono::high_resolution_clock;
+      auto ns = [](clock::duration d) { return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count(); };
+
+      const std::vector<std::string> name_strings = { "eosio", "eosio.token", "eosio.system", "transfer", "a",
+                                                      "newaccount", "123451234512", "zzzzzzzzzzzzj", "active", "owner",
+                                                      "delegatebw", "eosio.ram" };
+      const std::vector<std::string> asset_strings = { "1.0000 EOS", "-0.0001 EOS", "123456789.1234 SYS", "42 TOK",
+                                                       "0.00000001 BTC", "0.000000000000000001 LONGSYM" };
+      std::vector<name>  names;
+      std::vector<asset> assets;
+      for (const auto& s : name_strings)
+         names.push_back(name(s));
+      for (const auto& s : asset_strings)
+         assets.push_back(asset::from_string(s));
+
+      // the results are summed so the conversions are not optimized away
+      uint64_t sink = 0;
+      auto measure = [&](const auto& values, auto&& convert) {
+         auto start = clock::now();
+         for (uint32_t i = 0; i < iterations; ++i) {
+            for (const auto& v : values)
+               sink += convert(v);
+         }
+         return ns(clock::now() - start) / (double)(uint64_t(iterations) * values.size());
+      };
+
+      fc::mutable_variant_object result;
+      result("iterations", iterations);
+      result("name_to_string_ns", measure(names, [](const name& n) { return n.to_string().size(); }));
+      result("string_to_name_ns", measure(name_strings, [](const std::string& s) { return name(s).to_uint64_t(); }));
+      result("asset_to_string_ns", measure(assets, [](const asset& a) { return a.to_string().size(); }));
+      result("asset_from_string_ns", measure(asset_strings, [](const std::string& s) { return (uint64_t)asset::from_string(s).get_amount(); }));
+      result("symbol_to_string_ns", measure(assets, [](const asset& a) { return a.get_symbol().to_string().size(); }));
+      result("checksum", sink);
+      return result;
+   }
+
+} // namespace
+
+/**
+ * Applies a range of recorded blocks on top of the state of a snapshot, as a syncing nodeos would, and reports how long
+ * each stage of applying them took. The blocks are read from an existing blocks.log, the state is rebuilt from the
+ * snapshot in a scratch directory on every run, so runs with different settings apply exactly the same blocks to the
+ * same state.
+ */
+int main(int argc, char** argv) {
+   options_description cli ("nodeos-bench command line options");
+   try {
+      bfs::path   snapshot_path;
+      bfs::path   blocks_dir;
+      bfs::path   data_dir;
+      bfs::path   output_file;
+      bfs::path   per_block_file;
+      uint32_t    last_block    = std::numeric_limits<uint32_t>::max();
+      uint32_t    warmup_blocks = 0;
+      std::string backing_store;
+      wasm_interface::vm_type wasm_runtime = config::default_wasm_runtime;
+      dedup_benchmark_options dedup;
+      uint32_t                name_conversions = 0;
+
+      controller::config cfg;
+
+      cli.add_options()
+            ("snapshot,s", bpo::value<bfs::path>(&snapshot_path), "the snapshot to start from, binary or compressed")
+            ("blocks-dir", bpo::value<bfs::path>(&blocks_dir)->default_value("blocks"),
+             "the blocks directory holding blocks.log with the blocks following the snapshot")
+            ("last,l", bpo::value<uint32_t>(&last_block)->default_value(std::numeric_limits<uint32_t>::max()),
+             "the last block to apply, by default all blocks of the block log following the snapshot")
+            ("warmup-blocks", bpo::value<uint32_t>(&warmup_blocks)->default_value(0),
+             "the number of blocks applied first without being counted in the aggregate, e.g. to fill caches and compile contracts")
+            ("data-dir,d", bpo::value<bfs::path>(&data_dir),
+             "the scratch directory of the state and block log, its contents are removed. A temporary directory if not given")
+            ("output-file,o", bpo::value<bfs::path>(&output_file),
+             "the file to write the aggregate timings to as JSON. If not specified then output is to stdout")
+            ("per-block-file", bpo::value<bfs::path>(&per_block_file),
+             "the file to write the stage timings of each block to, as JSON lines")
+            ("wasm-runtime", bpo::value<wasm_interface::vm_type>(&wasm_runtime)->value_name("runtime")
+                ->default_value(config::default_wasm_runtime, wasm_interface::vm_type_string(config::default_wasm_runtime)),
+             "the WASM runtime, \"eos-vm\" or \"eos-vm-jit\"")
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+            ("eos-vm-oc-enable", bpo::bool_switch(&cfg.eosvmoc_tierup), "Enable EOS VM OC tier-up runtime")
+            ("eos-vm-oc-compile-threads", bpo::value<uint64_t>(&cfg.eosvmoc_config.threads)->default_value(1u),
+             "Number of threads to use for EOS VM OC tier-up")
+#endif
+            ("backing-store", bpo::value<std::string>(&backing_store)->default_value("chainbase"),
+             "the storage of the chain state, \"chainbase\" or \"rocksdb\"")
+            ("chain-state-db-size-mb", bpo::value<uint64_t>()->default_value(config::default_state_size / (1024 * 1024)),
+             "Maximum size (in MiB) of the chain state database")
+            ("chain-threads", bpo::value<uint16_t>(&cfg.thread_pool_size)->default_value(config::default_controller_thread_pool_size),
+             "Number of worker threads in controller thread pool")
+            ("persistent-storage-num-threads", bpo::value<uint16_t>(&cfg.persistent_storage_num_threads)->default_value(1),
+             "Number of rocksdb threads for flush and compaction")
+            ("dedup-blocks", bpo::value<uint32_t>(&dedup.blocks),
+             "instead of applying blocks, measure inserting into and expiring from the transaction dedup table for this many simulated blocks")
+            ("dedup-trxs-per-block", bpo::value<uint32_t>(&dedup.trxs_per_block)->default_value(dedup.trxs_per_block),
+             "transactions recorded per simulated block")
+            ("dedup-expiration-sec", bpo::value<uint32_t>(&dedup.expiration_sec)->default_value(dedup.expiration_sec),
+             "expiration of the recorded transactions, in seconds after their block")
+            ("name-conversions", bpo::value<uint32_t>(&name_conversions),
+             "instead of applying blocks, measure converting names and assets to and from strings this many times over a set of typical values")
+            ("help,h", bpo::bool_switch()->default_value(false), "Print this help message and exit.")
+            ;
+      variables_map vmap;
+      bpo::store(bpo::parse_command_line(argc, argv, cli), vmap);
+      bpo::notify(vmap);
+      if (vmap.at("help").as<bool>() || (snapshot_path.empty() && !dedup.blocks && !name_conversions)) {
+         cli.print(std::cerr);
+         return 0;
+      }
+      EOS_ASSERT(wasm_runtime != wasm_interface::vm_type::eos_vm_oc, fc::invalid_arg_exception,
+                 "EOS VM OC is a tier-up compiler, use eos-vm-oc-enable with one of the other runtimes");
+      EOS_ASSERT(cfg.thread_pool_size > 0, fc::invalid_arg_exception, "chain-threads must be greater than 0");
+
+      std::optional<fc::temp_directory> tmp;
+      if (data_dir.empty()) {
+         tmp.emplace();
+         data_dir = tmp->path();
+      } else {
+         bfs::remove_all(data_dir);
+      }
+      bfs::create_directories(data_dir);
+
+      auto write_result = [&output_file](const fc::variant& result) {
+         if (output_file.empty()) {
+            std::cout << fc::json::to_pretty_string(result) << '\n';
+         } else {
+            EOS_ASSERT(fc::json::save_to_file(result, output_file, true), fc::invalid_arg_exception,
+                       "Unable to write ${f}", ("f", output_file.generic_string()));
+         }
+      };
+
+      if (name_conversions) {
+         write_result(run_name_conversion_benchmark(name_conversions));
+         return 0;
+      }
+      if (dedup.blocks) {
+         write_result(run_dedup_benchmark(data_dir / config::default_state_dir_name,
+                                          vmap.at("chain-state-db-size-mb").as<uint64_t>() * 1024 * 1024, dedup));
+         return 0;
+      }
+
+      cfg.blog.log_dir    = data_dir / config::default_blocks_dir_name;
+      cfg.state_dir       = data_dir / config::default_state_dir_name;
+      cfg.state_size      = vmap.at("chain-state-db-size-mb").as<uint64_t>() * 1024 * 1024;
+      cfg.backing_store   = parse_backing_store(backing_store);
+      cfg.wasm_runtime    = wasm_runtime;
+      cfg.eosvmoc_config.cache_dir = data_dir;
+      cfg.read_mode       = db_read_mode::SPECULATIVE;
+
+      std::ifstream infile(snapshot_path.generic_string(), (std::ios::in | std::ios::binary));
+      EOS_ASSERT(infile.good(), snapshot_exception, "Unable to open ${f}", ("f", snapshot_path.generic_string()));
+      auto reader = make_snapshot_reader(infile);
+      const auto chain_id = controller::extract_chain_id(*reader);
+
+      block_log source({ .log_dir = blocks_dir });
+
+      bool shutdown = false;
+      controller chain(cfg, make_builtin_protocol_feature_set(), chain_id);
+      chain.add_indices();
+      {
+         report_time rt("loading snapshot");
+         chain.startup([&shutdown]() { shutdown = true; }, [&shutdown]() { return shutdown; }, reader);
+         rt.report();
+      }
+      infile.close();
+
+      const uint32_t first_block = chain.head_block_num() + 1;
+      EOS_ASSERT(source.first_block_num() <= first_block && source.head() && source.head()->block_num() >= first_block,
+                 block_log_exception, "${d} does not contain block ${n} following the snapshot", ("d", blocks_dir)("n", first_block));
+      last_block = std::min(last_block, source.head()->block_num());
+      ilog("applying blocks ${f} through ${l}, the first ${w} not counted", ("f", first_block)("l", last_block)("w", warmup_blocks));
+
+      std::ofstream per_block_out;
+      if (!per_block_file.empty()) {
+         per_block_out.open(per_block_file.generic_string());
+         EOS_ASSERT(per_block_out.good(), fc::invalid_arg_exception, "Unable to open ${f}", ("f", per_block_file.generic_string()));
+      }
+
+      block_apply_metrics metrics;
+      uint64_t            num_blocks = 0;
+      uint64_t            num_trxs   = 0;
+      std::optional<report_time> measured;
+      for (uint32_t block_num = first_block; block_num <= last_block && !shutdown; ++block_num) {
+         if (block_num == first_block + warmup_blocks)
+            measured.emplace("applying blocks");
+
+         auto block = source.read_signed_block_by_num(block_num);
+         EOS_ASSERT(block, block_log_exception, "block ${n} is missing from the block log", ("n", block_num));
+         auto bsf = chain.create_block_state_future(block->calculate_id(), block);
+         chain.push_block(bsf, {}, {});
+
+         const auto& times = chain.get_last_block_apply_times();
+         if (per_block_out.is_open())
+            per_block_out << fc::json::to_string(times, fc::time_point::maximum()) << '\n';
+         if (measured) {
+            metrics.add(times);
+            ++num_blocks;
+            num_trxs += times.num_trxs;
+         }
+      }
+      EOS_ASSERT(measured, fc::invalid_arg_exception, "warmup-blocks ${w} leaves no blocks to measure", ("w", warmup_blocks));
+      const auto wall_us = measured->elapsed_us();
+      measured->report();
+
+      // wall time includes reading and unpacking the blocks, the stages only the time spent in controller
+      const auto result = fc::mutable_variant_object()
+         ("first_block", first_block + warmup_blocks)
+         ("last_block", chain.head_block_num())
+         ("blocks", num_blocks)
+         ("transactions", num_trxs)
+         ("wall_time_us", wall_us)
+         ("blocks_per_sec", wall_us ? num_blocks * 1000000.0 / wall_us : 0.0)
+         ("transactions_per_sec", wall_us ? num_trxs * 1000000.0 / wall_us : 0.0)
+         ("wasm_runtime", wasm_interface::vm_type_string(wasm_runtime))
+         ("eos_vm_oc", cfg.eosvmoc_tierup)
+         ("backing_store", backing_store)
+         ("chain_threads", cfg.thread_pool_size)
+         ("stages", metrics);
+
+      write_result(fc::variant(result));
+   } catch( const fc::exception& e ) {
+      elog( "${e}", ("e", e.to_detail_string()));
+      return -1;
+   } catch( const boost::exception& e ) {
+      elog("${e}", ("e",boost::diagnostic_information(e)));
+      return -1;
+   } catch( const std::exception& e ) {
+      elog("${e}", ("e",e.what()));
+      return -1;
+   } catch( ... ) {
+      elog("unknown exception");
+      return -1;
+   }
+
+   return 0;
+}
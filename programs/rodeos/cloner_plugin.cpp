@@ -31,6 +31,7 @@ using boost::system::error_code;
 using rodeos::rodeos_db_partition;
 using rodeos::rodeos_db_snapshot;
 using rodeos::rodeos_filter;
+using rodeos::rodeos_parallel_filter;
 
 struct cloner_session;
 
@@ -38,8 +39,12 @@ struct cloner_config : ship_client::connection_config {
    uint32_t    skip_to     = 0;
    uint32_t    stop_before = 0;
    bool        exit_on_filter_wasm_error = false;
+   uint32_t    decode_threads = 0;
+   bool        bulk_load      = false;
+   bool        scope_index    = false;
    eosio::name filter_name = {}; // todo: remove
    std::string filter_wasm = {}; // todo: remove
+   uint32_t    filter_threads = 0;
 };
 
 struct cloner_plugin_impl : std::enable_shared_from_this<cloner_plugin_impl> {
@@ -47,6 +52,7 @@ struct cloner_plugin_impl : std::enable_shared_from_this<cloner_plugin_impl> {
    std::shared_ptr<cloner_session>                                          session;
    boost::asio::deadline_timer                                              timer;
    std::function<void(const char* data, uint64_t data_size)>                streamer = {};
+   std::function<void()>                                                    stream_checkpoint = {};
 
    cloner_plugin_impl() : timer(app().get_io_service()) {}
 
@@ -74,15 +80,39 @@ struct cloner_session : ship_client::connection_callbacks, std::enable_shared_fr
    std::shared_ptr<ship_client::connection> connection;
    bool                                     reported_block = false;
    std::unique_ptr<rodeos_filter>           filter         = {}; // todo: remove
+   std::unique_ptr<rodeos_parallel_filter>  parallel_filter = {}; // todo: remove
 
    cloner_session(cloner_plugin_impl* my) : my(my), config(my->config) {
       // todo: remove
-      if (!config->filter_wasm.empty())
-         filter = std::make_unique<rodeos_filter>(config->filter_name, config->filter_wasm);
+      if (!config->filter_wasm.empty()) {
+         if (config->filter_threads)
+            parallel_filter = std::make_unique<rodeos_parallel_filter>(config->filter_name, config->filter_wasm,
+                                                                       config->filter_threads);
+         else
+            filter = std::make_unique<rodeos_filter>(config->filter_name, config->filter_wasm);
+      }
+   }
+
+   void push_filter_data(const char* data, uint64_t data_size) {
+      if (my->streamer)
+         my->streamer(data, data_size);
+   }
+
+   // everything streamed for the blocks processed so far must be delivered before they are written;
+   // a restart resumes streaming after the last written block
+   void checkpoint_stream() {
+      if (parallel_filter)
+         parallel_filter->drain([&](const char* data, uint64_t data_size) { push_filter_data(data, data_size); });
+      if (my->stream_checkpoint)
+         my->stream_checkpoint();
    }
 
    void connect(asio::io_context& ioc) {
       rodeos_snapshot.emplace(partition, true);
+      rodeos_snapshot->set_decode_threads(config->decode_threads);
+      rodeos_snapshot->set_bulk_load(config->bulk_load);
+      if (config->scope_index)
+         rodeos_snapshot->enable_scope_index();
 
       ilog("cloner database status:");
       ilog("    revisions:    ${f} - ${r}",
@@ -144,6 +174,7 @@ struct cloner_session : ship_client::connection_callbacks, std::enable_shared_fr
          return true;
       if (config->stop_before && result.this_block->block_num >= config->stop_before) {
          ilog("block ${b}: stop requested", ("b", result.this_block->block_num));
+         checkpoint_stream();
          rodeos_snapshot->end_write(true);
          db->flush(false, false);
          return false;
@@ -166,15 +197,17 @@ struct cloner_session : ship_client::connection_callbacks, std::enable_shared_fr
       rodeos_snapshot->write_block_info(result);
       rodeos_snapshot->write_deltas(result, [] { return app().is_quiting(); });
 
-      if (filter) {
-         filter->process(*rodeos_snapshot, result, bin, [&](const char* data, uint64_t data_size) {
-            if (my->streamer) {
-               my->streamer(data, data_size);
-            }
-         });
-      }
+      auto push_data = [&](const char* data, uint64_t data_size) { push_filter_data(data, data_size); };
+      if (filter)
+         filter->process(*rodeos_snapshot, result, bin, push_data);
+      if (parallel_filter)
+         parallel_filter->process(*rodeos_snapshot, result, bin, push_data);
+      if (write_now)
+         checkpoint_stream();
 
       rodeos_snapshot->end_block(result, false);
+      if (write_now)
+         app().find_plugin<rocksdb_plugin>()->checkpoint(result.this_block->block_num);
       return true;
    }
 
@@ -225,6 +258,15 @@ void cloner_plugin::set_program_options(options_description& cli, options_descri
    clop("clone-stop,x", bpo::value<uint32_t>(), "Stop before block [arg]");
    op("clone-exit-on-filter-wasm-error", bpo::bool_switch()->default_value(false),
       "Shutdown application if filter wasm throws an exception");
+   op("clone-decode-threads", bpo::value<uint32_t>()->default_value(4),
+      "Number of threads decoding state-history table delta rows. Rows are still written in order on the main "
+      "thread. 0 decodes on the main thread");
+   op("clone-bulk-load", bpo::bool_switch()->default_value(false),
+      "When starting from an empty database, write irreversible blocks by ingesting sorted table files instead of "
+      "write batches. Switches to normal writes at the first reversible block");
+   op("clone-scope-index", bpo::bool_switch()->default_value(false),
+      "When starting from an empty database, also index contract tables by scope, for "
+      "/v1/rodeos/get_tables_by_scope. Once created the index is maintained for the life of the database");
    op("telemetry-url", bpo::value<std::string>(),
       "Send Zipkin spans to url. e.g. http://127.0.0.1:9411/api/v2/spans" );
    op("telemetry-service-name", bpo::value<std::string>()->default_value(b1::rodeos::config::rodeos_executable_name),
@@ -234,10 +276,15 @@ void cloner_plugin::set_program_options(options_description& cli, options_descri
    // todo: remove
    op("filter-name", bpo::value<std::string>(), "Filter name");
    op("filter-wasm", bpo::value<std::string>(), "Filter wasm");
+   op("filter-threads", bpo::value<uint32_t>()->default_value(0),
+      "Run the filter on this many blocks at once. Only for stateless filters, which neither read nor write the "
+      "database. Output is still streamed in block order. 0 runs the filter on one block at a time");
 }
 
 void cloner_plugin::plugin_initialize(const variables_map& options) {
    try {
+      if (app().find_plugin<rocksdb_plugin>()->is_replica())
+         throw std::runtime_error("cloner_plugin can't write to a read replica; remove rdb-replica-dir");
       auto endpoint = options.at("clone-connect-to").as<std::string>();
       if (endpoint.find(':') == std::string::npos)
          throw std::runtime_error("invalid endpoint: " + endpoint);
@@ -249,9 +296,17 @@ void cloner_plugin::plugin_initialize(const variables_map& options) {
       my->config->skip_to     = options.count("clone-skip-to") ? options["clone-skip-to"].as<uint32_t>() : 0;
       my->config->stop_before = options.count("clone-stop") ? options["clone-stop"].as<uint32_t>() : 0;
       my->config->exit_on_filter_wasm_error = options["clone-exit-on-filter-wasm-error"].as<bool>();
+      my->config->decode_threads = options["clone-decode-threads"].as<uint32_t>();
+      my->config->bulk_load      = options["clone-bulk-load"].as<bool>();
+      my->config->scope_index    = options["clone-scope-index"].as<bool>();
+      if (my->config->decode_threads > 64)
+         throw std::runtime_error("clone-decode-threads must be at most 64");
       if (options.count("filter-name") && options.count("filter-wasm")) {
          my->config->filter_name = eosio::name{ options["filter-name"].as<std::string>() };
          my->config->filter_wasm = options["filter-wasm"].as<std::string>();
+         my->config->filter_threads = options["filter-threads"].as<uint32_t>();
+         if (my->config->filter_threads > 64)
+            throw std::runtime_error("filter-threads must be at most 64");
       } else if (options.count("filter-name") || options.count("filter-wasm")) {
          throw std::runtime_error("filter-name and filter-wasm must be used together");
       }
@@ -281,6 +336,10 @@ void cloner_plugin::set_streamer(std::function<void(const char* data, uint64_t d
    my->streamer = std::move(streamer_func);
 }
 
+void cloner_plugin::set_stream_checkpoint(std::function<void()> checkpoint_func) {
+   my->stream_checkpoint = std::move(checkpoint_func);
+}
+
 void cloner_plugin::handle_sighup() {
 }
 
@@ -17,6 +17,8 @@ class cloner_plugin : public appbase::plugin<cloner_plugin> {
    void         handle_sighup() override;
 
    void set_streamer(std::function<void(const char* data, uint64_t data_size)> streamer_function);
+   // called before blocks are written to the database; returns once everything streamed so far is delivered
+   void set_stream_checkpoint(std::function<void()> checkpoint_function);
 
  private:
    std::shared_ptr<struct cloner_plugin_impl> my;
@@ -1,8 +1,13 @@
 #include "rocksdb_plugin.hpp"
 
+#include <boost/asio/steady_timer.hpp>
 #include <boost/filesystem.hpp>
 #include <fc/exception/exception.hpp>
 
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
 namespace b1 {
 
 using namespace appbase;
@@ -14,6 +19,69 @@ struct rocksdb_plugin_impl {
    std::optional<uint32_t>             max_open_files = {};
    std::shared_ptr<chain_kv::database> database       = {};
    std::mutex                          mutex          = {};
+
+   boost::filesystem::path               checkpoint_dir      = {}; // primary: checkpoints are created here
+   boost::filesystem::path               replica_dir         = {}; // replica: checkpoints are followed here
+   std::chrono::seconds                  checkpoint_interval = {};
+   uint32_t                              checkpoint_keep     = 0;
+   std::chrono::steady_clock::time_point last_checkpoint     = {};
+   uint32_t                              replica_block       = 0; // checkpoint the replica has open
+   std::function<void(std::shared_ptr<chain_kv::database>)> replica_update;
+   std::unique_ptr<boost::asio::steady_timer>               replica_timer;
+
+   // checkpoints are directories named by their zero padded block number, so they sort by block
+   static std::string checkpoint_name(uint32_t block_num) {
+      std::ostringstream name;
+      name << std::setw(10) << std::setfill('0') << block_num;
+      return name.str();
+   }
+
+   static std::vector<uint32_t> list_checkpoints(const boost::filesystem::path& dir) {
+      std::vector<uint32_t> result;
+      if (!boost::filesystem::is_directory(dir))
+         return result;
+      for (auto& entry : boost::filesystem::directory_iterator(dir)) {
+         auto name = entry.path().filename().string();
+         if (name.size() == 10 && std::all_of(name.begin(), name.end(), ::isdigit))
+            result.push_back(std::stoul(name));
+      }
+      std::sort(result.begin(), result.end());
+      return result;
+   }
+
+   // open the newest checkpoint if it's newer than the one open; the caller holds mutex
+   bool open_replica() {
+      auto checkpoints = list_checkpoints(replica_dir);
+      if (checkpoints.empty() || checkpoints.back() <= replica_block)
+         return false;
+      auto path = replica_dir / checkpoint_name(checkpoints.back());
+      database  = std::make_shared<chain_kv::database>(path.c_str(), chain_kv::read_only);
+      replica_block = checkpoints.back();
+      ilog("rodeos database is checkpoint ${d}", ("d", path.string()));
+      return true;
+   }
+
+   void schedule_replica_poll() {
+      replica_timer->expires_after(checkpoint_interval);
+      replica_timer->async_wait([this](const boost::system::error_code& ec) {
+         if (ec)
+            return;
+         try {
+            std::shared_ptr<chain_kv::database> db;
+            {
+               std::lock_guard<std::mutex> lock(mutex);
+               if (open_replica())
+                  db = database;
+            }
+            if (db && replica_update)
+               replica_update(db);
+         } catch (const std::exception& e) {
+            // the primary may have removed the checkpoint while it was being opened; retry on the next poll
+            wlog("opening checkpoint failed: ${e}", ("e", e.what()));
+         }
+         schedule_replica_poll();
+      });
+   }
 };
 
 static abstract_plugin& _rocksdb_plugin = app().register_plugin<rocksdb_plugin>();
@@ -32,6 +100,18 @@ void rocksdb_plugin::set_program_options(options_description& cli, options_descr
    op("rdb-max-files", bpo::value<uint32_t>(),
       "RocksDB limit max number of open files (default unlimited). This should be smaller than 'ulimit -n #'. "
       "# should be a very large number for full-history nodes.");
+   op("rdb-checkpoint-dir", bpo::value<bfs::path>(),
+      "Create checkpoints of the database in this directory for read replicas, at most every rdb-checkpoint-interval. "
+      "Only used with cloner_plugin. Should be on the same file system as rdb-database so table files are hard "
+      "linked instead of copied (default: disabled)");
+   op("rdb-replica-dir", bpo::value<bfs::path>(),
+      "Serve queries from the newest checkpoint in this directory, the rdb-checkpoint-dir of another rodeos, instead "
+      "of rdb-database; check for a newer one every rdb-checkpoint-interval. Can't be used with cloner_plugin "
+      "(default: disabled)");
+   op("rdb-checkpoint-interval", bpo::value<uint32_t>()->default_value(10),
+      "Seconds between checkpoints created in rdb-checkpoint-dir, or between checks for new ones in rdb-replica-dir");
+   op("rdb-checkpoint-keep", bpo::value<uint32_t>()->default_value(3),
+      "Number of checkpoints kept in rdb-checkpoint-dir. Replicas keep using a removed checkpoint until they move on");
 }
 
 void rocksdb_plugin::plugin_initialize(const variables_map& options) {
@@ -45,17 +125,42 @@ void rocksdb_plugin::plugin_initialize(const variables_map& options) {
          my->threads = options["rdb-threads"].as<uint32_t>();
       if (!options["rdb-max-files"].empty())
          my->max_open_files = options["rdb-max-files"].as<uint32_t>();
+
+      auto to_absolute = [](const bfs::path& p) { return p.is_relative() ? app().data_dir() / p : p; };
+      if (options.count("rdb-checkpoint-dir"))
+         my->checkpoint_dir = to_absolute(options.at("rdb-checkpoint-dir").as<bfs::path>());
+      if (options.count("rdb-replica-dir"))
+         my->replica_dir = to_absolute(options.at("rdb-replica-dir").as<bfs::path>());
+      my->checkpoint_interval = std::chrono::seconds{ options.at("rdb-checkpoint-interval").as<uint32_t>() };
+      my->checkpoint_keep     = options.at("rdb-checkpoint-keep").as<uint32_t>();
+      if (!my->checkpoint_dir.empty() && !my->replica_dir.empty())
+         throw std::runtime_error("rdb-checkpoint-dir and rdb-replica-dir can't be used together");
+      if (my->checkpoint_interval.count() == 0)
+         throw std::runtime_error("rdb-checkpoint-interval must be greater than 0");
+      if (my->checkpoint_keep == 0)
+         throw std::runtime_error("rdb-checkpoint-keep must be greater than 0");
    }
    FC_LOG_AND_RETHROW()
 }
 
-void rocksdb_plugin::plugin_startup() {}
+void rocksdb_plugin::plugin_startup() {
+   if (is_replica()) {
+      my->replica_timer = std::make_unique<boost::asio::steady_timer>(app().get_io_service());
+      my->schedule_replica_poll();
+   }
+}
 
-void rocksdb_plugin::plugin_shutdown() {}
+void rocksdb_plugin::plugin_shutdown() {
+   if (my->replica_timer)
+      my->replica_timer->cancel();
+}
 
 std::shared_ptr<chain_kv::database> rocksdb_plugin::get_db() {
    std::lock_guard<std::mutex> lock(my->mutex);
-   if (!my->database) {
+   if (!my->database && is_replica()) {
+      if (!my->open_replica())
+         throw std::runtime_error("no checkpoint found in " + my->replica_dir.string());
+   } else if (!my->database) {
       ilog("rodeos database is ${d}", ("d", my->db_path.string()));
       if (!bfs::exists(my->db_path.parent_path()))
          bfs::create_directories(my->db_path.parent_path());
@@ -64,4 +169,37 @@ std::shared_ptr<chain_kv::database> rocksdb_plugin::get_db() {
    return my->database;
 }
 
+bool rocksdb_plugin::is_replica() const { return !my->replica_dir.empty(); }
+
+void rocksdb_plugin::set_replica_update(std::function<void(std::shared_ptr<chain_kv::database>)> f) {
+   my->replica_update = std::move(f);
+}
+
+void rocksdb_plugin::checkpoint(uint32_t block_num) {
+   if (my->checkpoint_dir.empty())
+      return;
+   auto now = std::chrono::steady_clock::now();
+   if (now - my->last_checkpoint < my->checkpoint_interval)
+      return;
+   my->last_checkpoint = now;
+
+   auto checkpoints = my->list_checkpoints(my->checkpoint_dir);
+   if (!checkpoints.empty() && checkpoints.back() >= block_num)
+      return; // e.g. after a fork switch; the next checkpoint replaces it
+
+   // created under a temporary name and renamed, so replicas never see a partial checkpoint
+   auto tmp_path = my->checkpoint_dir / ("tmp-" + my->checkpoint_name(block_num));
+   auto path     = my->checkpoint_dir / my->checkpoint_name(block_num);
+   bfs::create_directories(my->checkpoint_dir);
+   bfs::remove_all(tmp_path);
+   get_db()->create_checkpoint(tmp_path.string());
+   bfs::rename(tmp_path, path);
+   checkpoints.push_back(block_num);
+
+   while (checkpoints.size() > my->checkpoint_keep) {
+      bfs::remove_all(my->checkpoint_dir / my->checkpoint_name(checkpoints.front()));
+      checkpoints.erase(checkpoints.begin());
+   }
+}
+
 } // namespace b1
@@ -18,6 +18,16 @@ class rocksdb_plugin : public appbase::plugin<rocksdb_plugin> {
 
    std::shared_ptr<b1::chain_kv::database> get_db();
 
+   // true if the database is a read-only replica following the checkpoints in rdb-replica-dir
+   bool is_replica() const;
+
+   // called with the newer checkpoint each time a replica moves to one
+   void set_replica_update(std::function<void(std::shared_ptr<b1::chain_kv::database>)> f);
+
+   // Create a checkpoint in rdb-checkpoint-dir, if one is configured and rdb-checkpoint-interval has passed since the
+   // last one. The database must be consistent; block_num names the checkpoint.
+   void checkpoint(uint32_t block_num);
+
  private:
    std::shared_ptr<struct rocksdb_plugin_impl> my;
 };
@@ -11,6 +11,8 @@
 #include <boost/beast/websocket.hpp>
 #include <fc/exception/exception.hpp>
 
+#include <atomic>
+
 namespace b1::ship_client {
 
 namespace ship = eosio::ship_protocol;
@@ -36,6 +38,23 @@ struct connection_config {
    std::string port;
 };
 
+/// blocks [begin, end)
+struct block_range {
+   uint32_t begin = 0;
+   uint32_t end   = 0;
+};
+
+/// splits [begin, end) into at most num_ranges consecutive ranges of about the same size
+inline std::vector<block_range> split_range(uint32_t begin, uint32_t end, uint32_t num_ranges) {
+   std::vector<block_range> result;
+   if (begin >= end || !num_ranges)
+      return result;
+   uint64_t size = (uint64_t(end - begin) + num_ranges - 1) / num_ranges;
+   for (uint64_t b = begin; b < end; b += size)
+      result.push_back({ uint32_t(b), uint32_t(std::min<uint64_t>(b + size, end)) });
+   return result;
+}
+
 struct abi_def_skip_table : eosio::abi_def {};
 
 EOSIO_REFLECT(abi_def_skip_table, version, types, structs, actions, ricardian_clauses, error_messages, abi_extensions,
@@ -140,6 +159,21 @@ struct connection : std::enable_shared_from_this<connection> {
       send(req);
    }
 
+   /// requests the irreversible blocks of range, up to window of them are sent ahead of ack()
+   void request_range(const block_range& range, uint32_t window, int flags) {
+      ship::get_blocks_request_v0 req;
+      req.start_block_num        = range.begin;
+      req.end_block_num          = range.end;
+      req.max_messages_in_flight = window;
+      req.irreversible_only      = true;
+      req.fetch_block            = flags & request_block;
+      req.fetch_traces           = flags & request_traces;
+      req.fetch_deltas           = flags & request_deltas;
+      send(req);
+   }
+
+   void ack(uint32_t num_messages) { send(ship::get_blocks_ack_request_v0{ num_messages }); }
+
    void request_blocks(const ship::get_status_result_v0& status, uint32_t start_block_num,
                        const std::vector<ship::block_position>& positions, int flags) {
       uint32_t nodeos_start = 0xffff'ffff;
@@ -203,4 +237,81 @@ struct connection : std::enable_shared_from_this<connection> {
    }
 }; // connection
 
+struct range_callbacks {
+   virtual ~range_callbacks() = default;
+   /// @returns false to stop all the ranges
+   virtual bool received(const block_range& range, ship::get_blocks_result_v0& result, eosio::input_stream bin) {
+      return true;
+   }
+   virtual bool received(const block_range& range, ship::get_blocks_result_v1& result, eosio::input_stream bin) {
+      return true;
+   }
+   virtual void range_done(const block_range& range) {}
+   /// the connection of range closed before its end, remaining is what is left to fetch
+   virtual void range_failed(const block_range& remaining, bool retry) = 0;
+};
+
+/// fetches one range of fetch_ranges() over its own connection
+struct range_session : connection_callbacks, std::enable_shared_from_this<range_session> {
+   block_range                        range;
+   uint32_t                           window;
+   int                                flags;
+   uint32_t                           next_block;
+   std::shared_ptr<range_callbacks>   callbacks;
+   std::shared_ptr<std::atomic<bool>> stopped;
+   std::shared_ptr<connection>        conn;
+
+   range_session(const block_range& range, uint32_t window, int flags, std::shared_ptr<range_callbacks> callbacks,
+                 std::shared_ptr<std::atomic<bool>> stopped)
+       : range(range), window(window), flags(flags), next_block(range.begin), callbacks(std::move(callbacks)),
+         stopped(std::move(stopped)) {}
+
+   void start(boost::asio::io_context& ioc, const connection_config& config) {
+      conn = std::make_shared<connection>(ioc, config, shared_from_this());
+      conn->connect();
+   }
+
+   void received_abi() override { conn->request_range(range, window, flags); }
+
+   bool received(ship::get_status_result_v0&, eosio::input_stream) override { return true; }
+   bool received(ship::get_blocks_result_v0& result, eosio::input_stream bin) override { return process(result, bin); }
+   bool received(ship::get_blocks_result_v1& result, eosio::input_stream bin) override { return process(result, bin); }
+
+   template <typename Result>
+   bool process(Result& result, eosio::input_stream bin) {
+      if (*stopped)
+         return false;
+      if (!callbacks->received(range, result, bin)) {
+         *stopped = true;
+         return false;
+      }
+      if (result.this_block)
+         next_block = result.this_block->block_num + 1;
+      if (next_block >= range.end)
+         return false;
+      conn->ack(1);
+      return true;
+   }
+
+   void closed(bool retry) override {
+      conn.reset();
+      if (next_block >= range.end)
+         callbacks->range_done(range);
+      else
+         callbacks->range_failed({ next_block, range.end }, retry && !*stopped);
+   }
+};
+
+/**
+ * Fetches the irreversible blocks of ranges concurrently, each over its own connection. The blocks of a range are
+ * received in order, the ranges are received in no particular order between each other.
+ */
+inline void fetch_ranges(boost::asio::io_context& ioc, const connection_config& config,
+                         const std::vector<block_range>& ranges, uint32_t window, int flags,
+                         std::shared_ptr<range_callbacks> callbacks) {
+   auto stopped = std::make_shared<std::atomic<bool>>(false);
+   for (auto& range : ranges)
+      std::make_shared<range_session>(range, window, flags, callbacks, stopped)->start(ioc, config);
+}
+
 } // namespace b1::ship_client
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "stream.hpp"
+#include <fc/log/logger.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef RODEOS_KAFKA
+#include <appbase/application.hpp>
+#include <librdkafka/rdkafka.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace b1 {
+
+struct kafka_config {
+   uint32_t                                         linger_ms  = 5;     // linger.ms
+   uint32_t                                         batch_size = 10000; // batch.num.messages
+   std::vector<std::pair<std::string, std::string>> properties = {};    // further librdkafka properties
+};
+
+// Parse the specified argument of a '--stream-kafka' option, BROKERS/TOPIC[/STREAMING_ROUTE, ...],
+// into the bootstrap brokers, the topic and the (optional) routes.
+inline std::string parse_kafka_address(const std::string& cmdline_arg, std::string& topic,
+                                       std::vector<eosio::name>& routes) {
+   const auto first_slash_pos = cmdline_arg.find('/');
+   if (first_slash_pos == std::string::npos || first_slash_pos == 0)
+      throw std::runtime_error("Kafka stream should be BROKERS/TOPIC[/ROUTES]: " + cmdline_arg);
+
+   const auto second_slash_pos = cmdline_arg.find('/', first_slash_pos + 1);
+   if (second_slash_pos == std::string::npos) {
+      topic = cmdline_arg.substr(first_slash_pos + 1);
+   } else {
+      topic  = cmdline_arg.substr(first_slash_pos + 1, second_slash_pos - (first_slash_pos + 1));
+      routes = extract_routes(cmdline_arg.substr(second_slash_pos + 1));
+   }
+   if (topic.empty())
+      throw std::runtime_error("Kafka stream has no topic: " + cmdline_arg);
+   return cmdline_arg.substr(0, first_slash_pos);
+}
+
+// Parse a '--stream-kafka-property' option, KEY=VALUE
+inline std::pair<std::string, std::string> parse_kafka_property(const std::string& cmdline_arg) {
+   const auto pos = cmdline_arg.find('=');
+   if (pos == std::string::npos || pos == 0)
+      throw std::runtime_error("Kafka property should be KEY=VALUE: " + cmdline_arg);
+   return { cmdline_arg.substr(0, pos), cmdline_arg.substr(pos + 1) };
+}
+
+#ifdef RODEOS_KAFKA
+
+// Produces to a topic with an idempotent producer. Messages are keyed, and so partitioned, by their
+// routing key. librdkafka batches and sends them on its own threads; delivery reports are served
+// by a polling thread. flush() waits until all messages are delivered. Delivery errors shut down
+// rodeos and are thrown by the next publish() or flush().
+class kafka : public stream_handler {
+   std::vector<eosio::name> routes_;
+   std::string              topic_;
+   rd_kafka_t*              producer_ = nullptr;
+   std::mutex               mtx_;
+   std::string              error_;
+   std::atomic<bool>        stopping_{ false };
+   std::thread              poll_thread_;
+
+ public:
+   kafka(std::vector<eosio::name> routes, const std::string& brokers, std::string topic, const kafka_config& config)
+       : routes_(std::move(routes)), topic_(std::move(topic)) {
+      ilog("Connecting to Kafka brokers ${b} - Topic: ${t}...", ("b", brokers)("t", topic_));
+
+      char             errstr[512];
+      rd_kafka_conf_t* conf = rd_kafka_conf_new();
+      auto             set  = [&](const std::string& name, const std::string& value) {
+         if (rd_kafka_conf_set(conf, name.c_str(), value.c_str(), errstr, sizeof(errstr)) != RD_KAFKA_CONF_OK) {
+            rd_kafka_conf_destroy(conf);
+            throw std::runtime_error("Kafka property " + name + ": " + errstr);
+         }
+      };
+      set("bootstrap.servers", brokers);
+      set("enable.idempotence", "true");
+      set("partitioner", "murmur2_random");
+      set("linger.ms", std::to_string(config.linger_ms));
+      set("batch.num.messages", std::to_string(config.batch_size));
+      for (const auto& [name, value] : config.properties)
+         set(name, value);
+      rd_kafka_conf_set_opaque(conf, this);
+      rd_kafka_conf_set_dr_msg_cb(conf, [](rd_kafka_t*, const rd_kafka_message_t* msg, void* opaque) {
+         if (msg->err)
+            static_cast<kafka*>(opaque)->set_error("Kafka delivery failed: " + std::string(rd_kafka_err2str(msg->err)));
+      });
+      rd_kafka_conf_set_error_cb(conf, [](rd_kafka_t* rk, int err, const char* reason, void* opaque) {
+         if (err != RD_KAFKA_RESP_ERR__FATAL) {
+            wlog("Kafka: ${r}", ("r", reason));
+            return;
+         }
+         char fatal[512];
+         rd_kafka_fatal_error(rk, fatal, sizeof(fatal));
+         static_cast<kafka*>(opaque)->set_error("Kafka fatal error: " + std::string(fatal));
+      });
+
+      producer_ = rd_kafka_new(RD_KAFKA_PRODUCER, conf, errstr, sizeof(errstr));
+      if (!producer_) {
+         rd_kafka_conf_destroy(conf);
+         throw std::runtime_error("Kafka producer: " + std::string(errstr));
+      }
+      poll_thread_ = std::thread([this] {
+         while (!stopping_)
+            rd_kafka_poll(producer_, 100);
+      });
+   }
+
+   ~kafka() {
+      if (rd_kafka_flush(producer_, 5000) == RD_KAFKA_RESP_ERR__TIMED_OUT)
+         elog("Kafka: ${n} messages to topic ${t} were not delivered", ("n", rd_kafka_outq_len(producer_))("t", topic_));
+      stopping_ = true;
+      poll_thread_.join();
+      rd_kafka_destroy(producer_);
+   }
+
+   const std::vector<eosio::name>& get_routes() const override { return routes_; }
+
+   void publish(const char* data, uint64_t data_size, const eosio::name& routing_key) override {
+      auto key = routing_key.to_string();
+      while (true) {
+         check_error();
+         auto err = rd_kafka_producev(producer_, RD_KAFKA_V_TOPIC(topic_.c_str()),
+                                      RD_KAFKA_V_KEY(key.data(), key.size()),
+                                      RD_KAFKA_V_VALUE(const_cast<char*>(data), data_size),
+                                      RD_KAFKA_V_MSGFLAGS(RD_KAFKA_MSG_F_COPY), RD_KAFKA_V_END);
+         if (err != RD_KAFKA_RESP_ERR__QUEUE_FULL) {
+            if (err)
+               throw std::runtime_error("Kafka produce failed: " + std::string(rd_kafka_err2str(err)));
+            return;
+         }
+         // the producer's queue bounds the messages in flight; wait for deliveries
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+   }
+
+   void flush() override {
+      while (rd_kafka_flush(producer_, 1000) == RD_KAFKA_RESP_ERR__TIMED_OUT)
+         check_error();
+      check_error();
+   }
+
+   // messages which aren't delivered yet are streamed again after a restart, from the last written block
+   void set_error(const std::string& error) {
+      elog("${e}", ("e", error));
+      {
+         std::lock_guard<std::mutex> lock(mtx_);
+         if (error_.empty())
+            error_ = error;
+      }
+      appbase::app().quit();
+   }
+
+ private:
+   void check_error() {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (!error_.empty())
+         throw std::runtime_error(error_);
+   }
+};
+
+inline void initialize_kafkas(std::vector<std::unique_ptr<stream_handler>>& streams,
+                              const std::vector<std::string>& kafkas, const kafka_config& config) {
+   for (const std::string& arg : kafkas) {
+      std::string              topic;
+      std::vector<eosio::name> routes;
+
+      auto brokers = parse_kafka_address(arg, topic, routes);
+      streams.emplace_back(std::make_unique<kafka>(std::move(routes), brokers, std::move(topic), config));
+   }
+}
+
+#endif // RODEOS_KAFKA
+
+} // namespace b1
@@ -4,61 +4,192 @@
 #include "amqpcpp/libboostasio.h"
 #include "amqpcpp/linux_tcp.h"
 #include "stream.hpp"
+#include <appbase/application.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <fc/log/logger.hpp>
+
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <set>
 
 namespace b1 {
 
+struct rabbitmq_config {
+   uint32_t max_in_flight  = 1000; // messages published but not yet confirmed by the broker
+   uint32_t batch_size     = 100;  // messages handed to the connection thread at once
+   uint64_t compress_above = 0;    // deflate payloads larger than this many bytes; 0 disables compression
+};
+
 class rabbitmq_handler;
 
+// Publishes with publisher confirms on a connection served by its own thread. Messages are handed to
+// that thread in batches; publish() blocks while max_in_flight messages are unconfirmed and flush()
+// until all messages are confirmed. Errors of the connection shut down rodeos and are thrown by the next
+// publish() or flush().
 class rabbitmq : public stream_handler {
-   std::shared_ptr<rabbitmq_handler>    handler_;
-   std::shared_ptr<AMQP::TcpConnection> connection_;
-   std::shared_ptr<AMQP::TcpChannel>    channel_;
+   struct message {
+      std::string       routing_key;
+      std::vector<char> data;
+   };
+
+   const rabbitmq_config                config_;
    std::string                          exchangeName_;
    std::string                          queueName_;
    std::vector<eosio::name>             routes_;
+   std::vector<message>                 batch_;
+
+   std::mutex                           mtx_;
+   std::condition_variable              cv_;
+   uint64_t                             in_flight_ = 0; // queued or unconfirmed messages
+   std::string                          error_;
+
+   // only used on the connection thread
+   std::shared_ptr<rabbitmq_handler>    handler_;
+   std::shared_ptr<AMQP::TcpConnection> connection_;
+   std::shared_ptr<AMQP::TcpChannel>    channel_;
+   uint64_t                             last_delivery_tag_ = 0;
+   std::set<uint64_t>                   unconfirmed_;
+
+   eosio::chain::named_thread_pool      thread_pool_{ "amqp", 1 }; // stopped first, its thread uses the members above
 
  public:
-   rabbitmq(boost::asio::io_service& io_service, std::vector<eosio::name> routes, const AMQP::Address& address,
-            std::string queue_name)
-       : queueName_(std::move(queue_name)), routes_(std::move(routes)) {
+   rabbitmq(std::vector<eosio::name> routes, const AMQP::Address& address, std::string queue_name,
+            const rabbitmq_config& config)
+       : config_(config), queueName_(std::move(queue_name)), routes_(std::move(routes)) {
       ilog("Connecting to RabbitMQ address ${a} - Queue: ${q}...", ("a", std::string(address))("q", queueName_));
 
-      init(io_service, address);
-
       exchangeName_ = DEFAULT_EXCHANGE;
 
-      declare_queue();
+      run([&] {
+         init(address);
+         declare_queue();
+      });
    }
 
-   rabbitmq(boost::asio::io_service& io_service, std::vector<eosio::name> routes, const AMQP::Address& address,
-            std::string exchange_name, std::string exchange_type)
-       : exchangeName_(std::move(exchange_name)), routes_(std::move(routes)) {
+   rabbitmq(std::vector<eosio::name> routes, const AMQP::Address& address, std::string exchange_name,
+            std::string exchange_type, const rabbitmq_config& config)
+       : config_(config), exchangeName_(std::move(exchange_name)), routes_(std::move(routes)) {
       ilog("Connecting to RabbitMQ address ${a} - Exchange: ${e}...", ("a", std::string(address))("e", exchangeName_));
 
-      init(io_service, address);
-
-      declare_exchange(exchange_type);
+      run([&] {
+         init(address);
+         declare_exchange(exchange_type);
+      });
    }
 
+   ~rabbitmq() { thread_pool_.stop(); }
+
    const std::vector<eosio::name>& get_routes() const override { return routes_; }
 
    void publish(const char* data, uint64_t data_size, const eosio::name& routing_key) override {
-      if (DEFAULT_EXCHANGE == exchangeName_) {
-         channel_->publish(exchangeName_, queueName_, data, data_size, 0);
-      } else {
-         channel_->publish(exchangeName_, routing_key.to_string(), data, data_size, 0);
+      {
+         std::unique_lock<std::mutex> lock(mtx_);
+         if (in_flight_ >= config_.max_in_flight) {
+            lock.unlock();
+            send_batch();
+            lock.lock();
+            cv_.wait(lock, [&] { return in_flight_ < config_.max_in_flight || !error_.empty(); });
+         }
+         if (!error_.empty())
+            throw std::runtime_error(error_);
+         ++in_flight_;
+      }
+      batch_.push_back(message{ DEFAULT_EXCHANGE == exchangeName_ ? queueName_ : routing_key.to_string(),
+                                std::vector<char>(data, data + data_size) });
+      if (batch_.size() >= config_.batch_size)
+         send_batch();
+   }
+
+   void flush() override {
+      send_batch();
+      std::unique_lock<std::mutex> lock(mtx_);
+      cv_.wait(lock, [&] { return in_flight_ == 0 || !error_.empty(); });
+      if (!error_.empty())
+         throw std::runtime_error(error_);
+   }
+
+   // messages which aren't confirmed yet are streamed again after a restart, from the last written block
+   void set_error(const std::string& error) {
+      elog("${e}", ("e", error));
+      {
+         std::lock_guard<std::mutex> lock(mtx_);
+         if (error_.empty())
+            error_ = error;
+         cv_.notify_all();
       }
+      appbase::app().quit();
    }
 
  private:
    inline static const std::string DEFAULT_EXCHANGE = "";
 
-   void init(boost::asio::io_service& io_service, const AMQP::Address& address) {
-      handler_    = std::make_shared<rabbitmq_handler>(io_service);
+   // run f on the connection thread and wait for it
+   template <typename F>
+   void run(F&& f) {
+      eosio::chain::async_thread_pool(thread_pool_.get_executor(), std::forward<F>(f)).get();
+   }
+
+   void send_batch() {
+      if (batch_.empty())
+         return;
+      boost::asio::post(thread_pool_.get_executor(), [this, batch = std::move(batch_)]() mutable {
+         for (auto& m : batch) {
+            if (config_.compress_above && m.data.size() > config_.compress_above) {
+               auto          compressed = compress(m.data);
+               AMQP::Envelope envelope(compressed.data(), compressed.size());
+               envelope.setContentEncoding("deflate");
+               channel_->publish(exchangeName_, m.routing_key, envelope, 0);
+            } else {
+               channel_->publish(exchangeName_, m.routing_key, m.data.data(), m.data.size(), 0);
+            }
+            unconfirmed_.insert(++last_delivery_tag_);
+         }
+      });
+      batch_.clear();
+   }
+
+   static std::vector<char> compress(const std::vector<char>& data) {
+      namespace bio = boost::iostreams;
+      std::vector<char>      out;
+      bio::filtering_ostream comp;
+      comp.push(bio::zlib_compressor(bio::zlib::default_compression));
+      comp.push(bio::back_inserter(out));
+      bio::write(comp, data.data(), data.size());
+      bio::close(comp);
+      return out;
+   }
+
+   void confirmed(uint64_t delivery_tag, bool multiple) {
+      size_t n = 0;
+      if (multiple) {
+         auto end = unconfirmed_.upper_bound(delivery_tag);
+         n        = std::distance(unconfirmed_.begin(), end);
+         unconfirmed_.erase(unconfirmed_.begin(), end);
+      } else {
+         n = unconfirmed_.erase(delivery_tag);
+      }
+      std::lock_guard<std::mutex> lock(mtx_);
+      in_flight_ -= n;
+      cv_.notify_all();
+   }
+
+   void init(const AMQP::Address& address) {
+      handler_    = std::make_shared<rabbitmq_handler>(*this, thread_pool_.get_executor());
       connection_ = std::make_shared<AMQP::TcpConnection>(handler_.get(), address);
       channel_    = std::make_shared<AMQP::TcpChannel>(connection_.get());
+      channel_->onError([this](const char* error_message) {
+         set_error("RabbitMQ channel error: " + std::string(error_message));
+      });
+      channel_->confirmSelect()
+            .onAck([this](uint64_t delivery_tag, bool multiple) { confirmed(delivery_tag, multiple); })
+            .onNack([this](uint64_t delivery_tag, bool multiple, bool requeue) {
+               set_error("RabbitMQ did not accept message " + std::to_string(delivery_tag));
+            });
    }
 
    void declare_queue() {
@@ -67,8 +198,8 @@ class rabbitmq : public stream_handler {
          ilog("RabbitMQ Connected Successfully!\n Queue ${q} - Messages: ${mc} - Consumers: ${cc}",
               ("q", name)("mc", messagecount)("cc", consumercount));
       });
-      queue.onError([](const char* error_message) {
-         throw std::runtime_error("RabbitMQ Queue error: " + std::string(error_message));
+      queue.onError([this](const char* error_message) {
+         set_error("RabbitMQ Queue error: " + std::string(error_message));
       });
    }
 
@@ -83,18 +214,21 @@ class rabbitmq : public stream_handler {
       auto& exchange = channel_->declareExchange(exchangeName_, type);
       exchange.onSuccess(
             [en = exchangeName_]() { ilog("RabbitMQ Connected Successfully!\n Exchange ${e}", ("e", en)); });
-      exchange.onError([](const char* error_message) {
-         throw std::runtime_error("RabbitMQ Exchange error: " + std::string(error_message));
+      exchange.onError([this](const char* error_message) {
+         set_error("RabbitMQ Exchange error: " + std::string(error_message));
       });
    }
 };
 
 class rabbitmq_handler : public AMQP::LibBoostAsioHandler {
+   rabbitmq& stream_;
+
  public:
-   explicit rabbitmq_handler(boost::asio::io_service& io_service) : AMQP::LibBoostAsioHandler(io_service) {}
+   rabbitmq_handler(rabbitmq& stream, boost::asio::io_service& io_service)
+       : AMQP::LibBoostAsioHandler(io_service), stream_(stream) {}
 
    void onError(AMQP::TcpConnection* connection, const char* message) {
-      throw std::runtime_error("rabbitmq connection failed: " + std::string(message));
+      stream_.set_error("rabbitmq connection failed: " + std::string(message));
    }
 
    uint16_t onNegotiate(AMQP::TcpConnection* connection, uint16_t interval) { return 0; }
@@ -158,9 +292,9 @@ inline AMQP::Address parse_rabbitmq_address(const std::string& cmdline_arg, std:
    return AMQP::Address(cmdline_arg.substr(0, second_slash_pos));
 }
 
-inline void initialize_rabbits_queue(boost::asio::io_service&                      io_service,
-                                     std::vector<std::unique_ptr<stream_handler>>& streams,
-                                     const std::vector<std::string>&               rabbits) {
+inline void initialize_rabbits_queue(std::vector<std::unique_ptr<stream_handler>>& streams,
+                                     const std::vector<std::string>&               rabbits,
+                                     const rabbitmq_config&                        config) {
    for (const std::string& rabbit : rabbits) {
       std::string              queue_name;
       std::vector<eosio::name> routes;
@@ -171,13 +305,13 @@ inline void initialize_rabbits_queue(boost::asio::io_service&
          queue_name = "stream.default";
       }
 
-      streams.emplace_back(std::make_unique<rabbitmq>(io_service, std::move(routes), address, std::move(queue_name)));
+      streams.emplace_back(std::make_unique<rabbitmq>(std::move(routes), address, std::move(queue_name), config));
    }
 }
 
-inline void initialize_rabbits_exchange(boost::asio::io_service&                      io_service,
-                                        std::vector<std::unique_ptr<stream_handler>>& streams,
-                                        const std::vector<std::string>&               rabbits) {
+inline void initialize_rabbits_exchange(std::vector<std::unique_ptr<stream_handler>>& streams,
+                                        const std::vector<std::string>&               rabbits,
+                                        const rabbitmq_config&                        config) {
    for (std::string rabbit : rabbits) {
       std::string              exchange;
       std::vector<eosio::name> routes;
@@ -192,8 +326,8 @@ inline void initialize_rabbits_exchange(boost::asio::io_service&
          exchange.erase(double_column_pos);
       }
 
-      streams.emplace_back(std::make_unique<rabbitmq>(io_service, std::move(routes), address, std::move(exchange),
-                                                      std::move(exchange_type)));
+      streams.emplace_back(std::make_unique<rabbitmq>(std::move(routes), address, std::move(exchange),
+                                                      std::move(exchange_type), config));
    }
 }
 
@@ -9,6 +9,8 @@ class stream_handler {
    virtual ~stream_handler() {}
    virtual const std::vector<eosio::name>& get_routes() const = 0;
    virtual void publish(const char* data, uint64_t data_size, const eosio::name& routing_key) = 0;
+   // wait until everything published has been delivered
+   virtual void flush() {}
 
    bool check_route(const eosio::name& stream_route) {
       if (get_routes().size() == 0) {
@@ -1,3 +1,4 @@
+#include "../streams/kafka.hpp"
 #include "../streams/rabbitmq.hpp"
 
 #define BOOST_TEST_MAIN
@@ -45,3 +46,24 @@ BOOST_AUTO_TEST_CASE(rabbitmq_address_parsing) {
          b1::parse_rabbitmq_address("user:pass@host", queue_name, routes), std::runtime_error,
          [](const auto& e) { return std::strstr(e.what(), "AMQP address should start with") != nullptr; });
 }
+
+BOOST_AUTO_TEST_CASE(kafka_address_parsing) {
+   std::string              topic;
+   std::vector<eosio::name> routes;
+
+   BOOST_TEST(b1::parse_kafka_address("host:9092/topic", topic, routes) == "host:9092");
+   BOOST_TEST(topic == "topic");
+   BOOST_TEST(routes.empty());
+
+   BOOST_TEST(b1::parse_kafka_address("h1:9092,h2:9092/topic/r1,r2", topic, routes) == "h1:9092,h2:9092");
+   BOOST_TEST(topic == "topic");
+   BOOST_TEST(routes == std::vector<eosio::name>({ "r1"_n, "r2"_n }));
+
+   BOOST_CHECK_THROW(b1::parse_kafka_address("host:9092", topic, routes), std::runtime_error);
+   BOOST_CHECK_THROW(b1::parse_kafka_address("host:9092//r1", topic, routes), std::runtime_error);
+
+   auto property = b1::parse_kafka_property("compression.type=lz4");
+   BOOST_TEST(property.first == "compression.type");
+   BOOST_TEST(property.second == "lz4");
+   BOOST_CHECK_THROW(b1::parse_kafka_property("compression.type"), std::runtime_error);
+}
@@ -28,7 +28,9 @@
 #include <cstdlib>
 #include <functional>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
@@ -143,14 +145,75 @@ std::string path_cat(beast::string_view base, beast::string_view path) {
    return result;
 }
 
+struct query_cache_stats {
+   uint64_t hits    = {};
+   uint64_t misses  = {};
+   uint32_t entries = {};
+};
+
+EOSIO_REFLECT(query_cache_stats, hits, misses, entries)
+
+// Responses of read-only queries, keyed on target and request body. Responses are only valid
+// for the head block they were produced at; the cache is emptied once the cloner advances head.
+class query_cache {
+ private:
+   using key = std::pair<std::string, std::string>;
+
+   std::mutex                                              mutex;
+   const uint32_t                                          max_entries;
+   eosio::checksum256                                      head_id = {};
+   std::map<key, std::shared_ptr<const std::vector<char>>> entries = {};
+   query_cache_stats                                       stats   = {};
+
+   void set_head(const eosio::checksum256& head) {
+      if (head == head_id)
+         return;
+      head_id = head;
+      entries.clear();
+   }
+
+ public:
+   query_cache(uint32_t max_entries) : max_entries(max_entries) {}
+
+   bool enabled() const { return max_entries > 0; }
+
+   std::shared_ptr<const std::vector<char>> get(const eosio::checksum256& head, beast::string_view target,
+                                                std::string_view body) {
+      std::lock_guard<std::mutex> lock{ mutex };
+      set_head(head);
+      auto it = entries.find(key{ target.to_string(), std::string{ body } });
+      if (it == entries.end()) {
+         ++stats.misses;
+         return {};
+      }
+      ++stats.hits;
+      return it->second;
+   }
+
+   void put(const eosio::checksum256& head, beast::string_view target, std::string_view body,
+            const std::vector<char>& reply) {
+      std::lock_guard<std::mutex> lock{ mutex };
+      if (head != head_id || entries.size() >= max_entries)
+         return;
+      entries.emplace(key{ target.to_string(), std::string{ body } }, std::make_shared<const std::vector<char>>(reply));
+   }
+
+   query_cache_stats get_stats() {
+      std::lock_guard<std::mutex> lock{ mutex };
+      auto                        result = stats;
+      result.entries                     = entries.size();
+      return result;
+   }
+};
+
 // This function produces an HTTP response for the given
 // request. The type of the response object depends on the
 // contents of the request, so the interface requires the
 // caller to pass a generic lambda for receiving the response.
 template <class Body, class Allocator, class Send>
 void handle_request(const wasm_ql::http_config& http_config, const wasm_ql::shared_state& shared_state,
-                    thread_state_cache& state_cache, http::request<Body, http::basic_fields<Allocator>>&& req,
-                    Send&& send) {
+                    thread_state_cache& state_cache, query_cache& query_cache,
+                    http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
    // Returns a bad request response
    const auto bad_request = [&http_config, &req](beast::string_view why) {
       http::response<http::string_body> res{ http::status::bad_request, req.version() };
@@ -203,43 +266,71 @@ void handle_request(const wasm_ql::http_config& http_config, const wasm_ql::shar
       return res;
    };
 
+   // Runs a read-only query, reusing the response to an identical request at the same head block
+   const auto run_query = [&shared_state, &state_cache, &query_cache, &req](auto query) {
+      std::string_view body{ req.body().data(), req.body().size() };
+      eosio::checksum256 head;
+      if (query_cache.enabled()) {
+         head = get_head_block_id(shared_state, temp_contract_kv_prefix);
+         if (auto reply = query_cache.get(head, req.target(), body))
+            return *reply;
+      }
+      auto              thread_state = state_cache.get_state();
+      std::vector<char> reply        = query(*thread_state, body);
+      state_cache.store_state(std::move(thread_state));
+      // head may have advanced while the query ran
+      if (query_cache.enabled() && get_head_block_id(shared_state, temp_contract_kv_prefix) == head)
+         query_cache.put(head, req.target(), body, reply);
+      return reply;
+   };
+
    // todo: pack error messages in json
    // todo: replace "query failed"
    try {
       if (req.target() == "/v1/chain/get_info") {
-         auto thread_state = state_cache.get_state();
-         send(ok(query_get_info(*thread_state, temp_contract_kv_prefix), "application/json"));
-         state_cache.store_state(std::move(thread_state));
+         send(ok(run_query([](auto& thread_state, auto) {
+                    return query_get_info(thread_state, temp_contract_kv_prefix);
+                 }),
+                 "application/json"));
          return;
       } else if (req.target() ==
                  "/v1/chain/get_block") { // todo: replace with /v1/chain/get_block_header. upgrade cleos.
          if (req.method() != http::verb::post)
             return send(
                   error(http::status::bad_request, "Unsupported HTTP-method for " + req.target().to_string() + "\n"));
-         auto thread_state = state_cache.get_state();
-         send(ok(query_get_block(*thread_state, temp_contract_kv_prefix,
-                                 std::string_view{ req.body().data(), req.body().size() }),
+         send(ok(run_query([](auto& thread_state, auto body) {
+                    return query_get_block(thread_state, temp_contract_kv_prefix, body);
+                 }),
                  "application/json"));
-         state_cache.store_state(std::move(thread_state));
          return;
       } else if (req.target() == "/v1/chain/get_abi") { // todo: get_raw_abi. upgrade cleos to use get_raw_abi.
          if (req.method() != http::verb::post)
             return send(
                   error(http::status::bad_request, "Unsupported HTTP-method for " + req.target().to_string() + "\n"));
-         auto thread_state = state_cache.get_state();
-         send(ok(query_get_abi(*thread_state, temp_contract_kv_prefix,
-                               std::string_view{ req.body().data(), req.body().size() }),
+         send(ok(run_query([](auto& thread_state, auto body) {
+                    return query_get_abi(thread_state, temp_contract_kv_prefix, body);
+                 }),
+                 "application/json"));
+         return;
+      } else if (req.target() == "/v1/rodeos/get_tables_by_scope") {
+         if (req.method() != http::verb::post)
+            return send(
+                  error(http::status::bad_request, "Unsupported HTTP-method for " + req.target().to_string() + "\n"));
+         send(ok(run_query([](auto& thread_state, auto body) {
+                    return query_get_tables_by_scope(thread_state, temp_contract_kv_prefix, body);
+                 }),
                  "application/json"));
-         state_cache.store_state(std::move(thread_state));
          return;
       } else if (req.target() == "/v1/chain/get_required_keys") { // todo: replace with a binary endpoint?
          if (req.method() != http::verb::post)
             return send(
                   error(http::status::bad_request, "Unsupported HTTP-method for " + req.target().to_string() + "\n"));
-         auto thread_state = state_cache.get_state();
-         send(ok(query_get_required_keys(*thread_state, std::string_view{ req.body().data(), req.body().size() }),
+         send(ok(run_query([](auto& thread_state, auto body) { return query_get_required_keys(thread_state, body); }),
                  "application/json"));
-         state_cache.store_state(std::move(thread_state));
+         return;
+      } else if (req.target() == "/v1/rodeos/get_query_cache_stats") {
+         auto json = eosio::convert_to_json(query_cache.get_stats());
+         send(ok(std::vector<char>{ json.begin(), json.end() }, "application/json"));
          return;
       } else if (req.target() == "/v1/chain/send_transaction") {
          // todo: replace with /v1/chain/send_transaction2?
@@ -401,6 +492,7 @@ class http_session : public std::enable_shared_from_this<http_session> {
    std::shared_ptr<const wasm_ql::http_config>  http_config;
    std::shared_ptr<const wasm_ql::shared_state> shared_state;
    std::shared_ptr<thread_state_cache>          state_cache;
+   std::shared_ptr<wasm_ql::query_cache>        query_cache;
    queue                                        queue_;
 
    // The parser is stored in an optional container so we can
@@ -411,9 +503,10 @@ class http_session : public std::enable_shared_from_this<http_session> {
    // Take ownership of the socket
    http_session(const std::shared_ptr<const wasm_ql::http_config>&  http_config,
                 const std::shared_ptr<const wasm_ql::shared_state>& shared_state,
-                const std::shared_ptr<thread_state_cache>& state_cache, tcp::socket&& socket)
+                const std::shared_ptr<thread_state_cache>&          state_cache,
+                const std::shared_ptr<wasm_ql::query_cache>& query_cache, tcp::socket&& socket)
        : stream(std::move(socket)), http_config(http_config), shared_state(shared_state), state_cache(state_cache),
-         queue_(*this) {}
+         query_cache(query_cache), queue_(*this) {}
 
    // Start the session
    void run() { do_read(); }
@@ -446,7 +539,7 @@ class http_session : public std::enable_shared_from_this<http_session> {
          return fail(ec, "read");
 
       // Send the response
-      handle_request(*http_config, *shared_state, *state_cache, parser->release(), queue_);
+      handle_request(*http_config, *shared_state, *state_cache, *query_cache, parser->release(), queue_);
 
       // If we aren't at the queue limit, try to pipeline another request
       if (!queue_.is_full())
@@ -489,13 +582,18 @@ class listener : public std::enable_shared_from_this<listener> {
    tcp::acceptor                                acceptor;
    bool                                         acceptor_ready = false;
    std::shared_ptr<thread_state_cache>          state_cache;
+   std::shared_ptr<wasm_ql::query_cache>        query_cache;
 
  public:
    listener(const std::shared_ptr<const wasm_ql::http_config>&  http_config,
             const std::shared_ptr<const wasm_ql::shared_state>& shared_state, net::io_context& ioc,
             tcp::endpoint endpoint)
        : http_config{ http_config }, shared_state{ shared_state }, ioc(ioc), acceptor(net::make_strand(ioc)),
-         state_cache(std::make_shared<thread_state_cache>(shared_state)) {
+         state_cache(std::make_shared<thread_state_cache>(shared_state)),
+         query_cache(std::make_shared<wasm_ql::query_cache>(http_config->query_cache_size)) {
+
+      // one per request thread; get_state creates more if ever needed
+      state_cache->preallocate(http_config->num_threads);
 
       beast::error_code ec;
 
@@ -540,7 +638,7 @@ class listener : public std::enable_shared_from_this<listener> {
          fail(ec, "accept");
       } else {
          // Create the http session and run it
-         std::make_shared<http_session>(http_config, shared_state, state_cache, std::move(socket))->run();
+         std::make_shared<http_session>(http_config, shared_state, state_cache, query_cache, std::move(socket))->run();
       }
 
       // Accept another connection
@@ -587,10 +685,34 @@ struct server_impl : http_server, std::enable_shared_from_this<server_impl> {
                                  tcp::endpoint{ a, (unsigned short)std::atoi(http_config->port.c_str()) })
             ->run();
 
+      if (http_config->precompile)
+         precompile();
+
       threads.reserve(http_config->num_threads);
       for (unsigned i = 0; i < http_config->num_threads; ++i)
          threads.emplace_back([self = shared_from_this()] { self->ioc.run(); });
    }
+
+   // Compile an instance of each local contract per thread, as far as the wasm cache holds them.
+   // The threads do this between requests.
+   void precompile() {
+      auto contracts = get_local_contracts(*shared_state);
+      if (contracts.empty())
+         return;
+      auto instances = std::min<uint32_t>(http_config->num_threads, shared_state->wasm_cache_size / contracts.size());
+      ilog("precompiling ${n} instances of ${c} contracts", ("n", instances)("c", contracts.size()));
+      for (uint32_t i = 0; i < instances; ++i) {
+         for (auto account : contracts) {
+            net::post(ioc, [self = shared_from_this(), account] {
+               try {
+                  precompile_contract(*self->shared_state, account);
+               } catch (const std::exception& e) {
+                  elog("precompiling ${a} failed: ${e}", ("a", (std::string)account)("e", e.what()));
+               }
+            });
+         }
+      }
+   }
 }; // server_impl
 
 std::shared_ptr<http_server> http_server::create(const std::shared_ptr<const http_config>&  http_config,
@@ -7,6 +7,8 @@ struct http_config {
    uint32_t    num_threads      = {};
    uint32_t    max_request_size = {};
    uint64_t    idle_timeout_ms  = {};
+   uint32_t    query_cache_size = {}; // 0 disables the query cache
+   bool        precompile       = {}; // compile the contracts in contract_dir at startup
    std::string allow_origin     = {};
    std::string static_dir       = {};
    std::string address          = {};
@@ -46,11 +46,19 @@ void wasm_ql_plugin::set_program_options(options_description& cli, options_descr
    op("wql-allow-origin", bpo::value<std::string>(), "Access-Control-Allow-Origin header. Use \"*\" to allow any.");
    op("wql-contract-dir", bpo::value<std::string>(),
       "Directory to fetch contracts from. These override contracts on the chain. (default: disabled)");
+   op("wql-precompile", bpo::bool_switch()->default_value(false),
+      "Compile the contracts in wql-contract-dir at startup instead of on their first queries");
    op("wql-static-dir", bpo::value<std::string>(), "Directory to serve static files from (default: disabled)");
    op("wql-console-size", bpo::value<uint32_t>()->default_value(0), "Maximum size of console data");
+   op("wql-state-buffer-size", bpo::value<uint32_t>()->default_value(64 * 1024),
+      "Bytes reserved for the result and console buffers of each query thread state. Thread states are created for "
+      "all wql-threads at startup and reused; buffers which grow past this size are trimmed back after the query");
    op("wql-wasm-cache-size", bpo::value<uint32_t>()->default_value(100), "Maximum number of compiled wasms to cache");
    op("wql-max-request-size", bpo::value<uint32_t>()->default_value(10000), "HTTP maximum request body size (bytes)");
    op("wql-idle-timeout", bpo::value<uint64_t>()->default_value(30000), "HTTP idle connection timeout (ms)");
+   op("wql-query-cache-size", bpo::value<uint32_t>()->default_value(0),
+      "Maximum number of responses to get_* queries to cache. Cached responses are dropped when the head block "
+      "changes. Hits and misses are reported by /v1/rodeos/get_query_cache_stats. 0 disables the cache");
    op("wql-exec-time", bpo::value<uint64_t>()->default_value(200), "Max query execution time (ms)");
    op("wql-max-action-return-value", bpo::value<uint32_t>()->default_value(MAX_SIZE_OF_BYTE_ARRAYS), "Max action return value size (bytes)");
 }
@@ -65,14 +73,19 @@ void wasm_ql_plugin::plugin_initialize(const variables_map& options) {
       auto shared_state = std::make_shared<wasm_ql::shared_state>(app().find_plugin<rocksdb_plugin>()->get_db());
       my->http_config   = http_config;
       my->shared_state  = shared_state;
+      app().find_plugin<rocksdb_plugin>()->set_replica_update(
+            [shared_state](std::shared_ptr<b1::chain_kv::database> db) { shared_state->set_db(std::move(db)); });
 
       http_config->num_threads       = options.at("wql-threads").as<int>();
       http_config->port              = ip_port.substr(ip_port.find(':') + 1, ip_port.size());
       http_config->address           = ip_port.substr(0, ip_port.find(':'));
       shared_state->max_console_size = options.at("wql-console-size").as<uint32_t>();
+      shared_state->state_buffer_size = options.at("wql-state-buffer-size").as<uint32_t>();
       shared_state->wasm_cache_size  = options.at("wql-wasm-cache-size").as<uint32_t>();
       http_config->max_request_size  = options.at("wql-max-request-size").as<uint32_t>();
       http_config->idle_timeout_ms   = options.at("wql-idle-timeout").as<uint64_t>();
+      http_config->query_cache_size  = options.at("wql-query-cache-size").as<uint32_t>();
+      http_config->precompile        = options.at("wql-precompile").as<bool>();
       shared_state->max_exec_time_ms = options.at("wql-exec-time").as<uint64_t>();
       shared_state->max_action_return_value_size = options.at("wql-max-action-return-value").as<uint32_t>();
       if (options.count("wql-contract-dir"))
@@ -327,6 +327,24 @@ BOOST_AUTO_TEST_CASE_TEMPLATE( get_table_test, TESTER_T, backing_store_ts) { try
       BOOST_REQUIRE_EQUAL("7777.0000 CCC", result.rows[0]["balance"].as_string());
    }
 
+   // get table: rows written as JSON text match the variant rows
+   eosio::chain_apis::read_only json_plugin(*(t.control), {}, fc::microseconds::maximum());
+   json_plugin.set_table_rows_json_text(true);
+   p.lower_bound = p.upper_bound = "";
+   p.limit = 3;
+   p.reverse = false;
+   for (bool show_payer : {false, true}) {
+      for (bool json : {true, false}) {
+         p.show_payer = show_payer;
+         p.json = json;
+         result = plugin.read_only::get_table_rows(p);
+         auto json_result = json_plugin.read_only::get_table_rows(p);
+         BOOST_REQUIRE(json_result.rows_json_text);
+         BOOST_REQUIRE_EQUAL(fc::json::to_string(fc::variant(result), fc::time_point::maximum()), json_result.to_json());
+         BOOST_REQUIRE_EQUAL(result.to_json(), json_result.to_json());
+      }
+   }
+
 } FC_LOG_AND_RETHROW() }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE( get_table_by_seckey_test, TESTER_T, backing_store_ts) { try {
@@ -479,6 +497,52 @@ BOOST_AUTO_TEST_CASE_TEMPLATE( get_table_by_seckey_test, TESTER_T, backing_store
    BOOST_REQUIRE_EQUAL(false, all_digits_result.more);
    BOOST_REQUIRE_EQUAL(all_digits_name_1, all_digits_result.rows[0]["newname"].as_string());
 
+   // page through the secondary index with cursors, the two 1.0000 SYS bids share their secondary key
+   auto page_with_cursor = [&](bool reverse) {
+      p.lower_bound.clear();
+      p.upper_bound.clear();
+      p.index_position = "secondary";
+      p.key_type = "i64";
+      p.limit = 1;
+      p.reverse = reverse;
+      p.cursor.reset();
+      std::vector<std::string> names;
+      for (;;) {
+         auto page = plugin.read_only::get_table_rows(p);
+         BOOST_REQUIRE_EQUAL(1u, page.rows.size());
+         names.emplace_back(page.rows[0]["newname"].as_string());
+         if (!page.more) {
+            BOOST_REQUIRE(page.next_cursor.empty());
+            break;
+         }
+         BOOST_REQUIRE(!page.next_cursor.empty());
+         p.cursor = page.next_cursor;
+      }
+      return names;
+   };
+   std::vector<std::string> by_bid{"html", "io", "org", "com", all_digits_name_1, all_digits_name_2};
+   BOOST_REQUIRE(page_with_cursor(false) == by_bid);
+   std::reverse(by_bid.begin(), by_bid.end());
+   BOOST_REQUIRE(page_with_cursor(true) == by_bid);
+
+   // a cursor of the primary index, or of the other direction, is rejected
+   p.reverse = false;
+   p.index_position = "primary";
+   p.key_type = "name";
+   auto primary_page = plugin.read_only::get_table_rows(p);
+   BOOST_REQUIRE(primary_page.more);
+   p.index_position = "secondary";
+   p.key_type = "i64";
+   p.cursor = primary_page.next_cursor;
+   BOOST_CHECK_THROW(plugin.read_only::get_table_rows(p), contract_table_query_exception);
+   p.cursor.reset();
+   auto secondary_page = plugin.read_only::get_table_rows(p);
+   p.reverse = true;
+   p.cursor = secondary_page.next_cursor;
+   BOOST_CHECK_THROW(plugin.read_only::get_table_rows(p), contract_table_query_exception);
+   p.cursor = "zz";
+   BOOST_CHECK_THROW(plugin.read_only::get_table_rows(p), contract_table_query_exception);
+
 } FC_LOG_AND_RETHROW() }
 
 
@@ -175,6 +175,30 @@ BOOST_AUTO_TEST_CASE(wallet_manager_test)
    BOOST_CHECK(find(pks.cbegin(), pks.cend(), pkey1.get_public_key()) != pks.cend());
    BOOST_CHECK(find(pks.cbegin(), pks.cend(), pkey2.get_public_key()) != pks.cend());
 
+   // batches are signed the same, on the signing threads or not
+   for (uint16_t threads : {0, 2}) {
+      wm.set_signing_threads(threads);
+      std::vector<chain::signed_transaction> trxs(5);
+      std::vector<flat_set<public_key_type>> trx_keys(5);
+      for (size_t i = 0; i < trxs.size(); ++i) {
+         trxs[i].ref_block_num = i;
+         trx_keys[i].emplace(i % 2 ? pkey1.get_public_key() : pkey2.get_public_key());
+      }
+      trx_keys[4] = pubkeys;
+      auto signed_trxs = wm.sign_transactions(trxs, trx_keys, chain_id);
+      BOOST_REQUIRE_EQUAL(trxs.size(), signed_trxs.size());
+      for (size_t i = 0; i < signed_trxs.size(); ++i) {
+         BOOST_CHECK_EQUAL(signed_trxs[i].ref_block_num, i);
+         pks.clear();
+         signed_trxs[i].get_signature_keys(chain_id, fc::time_point::maximum(), pks);
+         BOOST_CHECK(pks == trx_keys[i]);
+      }
+      trx_keys[2].emplace(private_key_type::generate().get_public_key());
+      BOOST_CHECK_THROW(wm.sign_transactions(trxs, trx_keys, chain_id), chain::wallet_missing_pub_key_exception);
+      trx_keys.pop_back();
+      BOOST_CHECK_THROW(wm.sign_transactions(trxs, trx_keys, chain_id), chain::wallet_exception);
+   }
+
    BOOST_CHECK_EQUAL(3u, wm.get_public_keys().size());
    wm.set_timeout(chrono::seconds(0));
    BOOST_CHECK_THROW(wm.get_public_keys(), wallet_locked_exception);
@@ -65,6 +65,7 @@ void verify_round_trip_conversion( const abi_serializer& abis, const type_name&
    BOOST_REQUIRE_EQUAL(fc::to_hex(bytes), hex);
    auto var2 = abis.binary_to_variant(type, bytes, abi_serializer::create_yield_function( max_serialization_time ));
    BOOST_REQUIRE_EQUAL(fc::json::to_string(var2, fc::time_point::now() + max_serialization_time), expected_json);
+   BOOST_REQUIRE_EQUAL(abis.binary_to_json(type, bytes, abi_serializer::create_yield_function( max_serialization_time )), expected_json);
    auto bytes2 = abis.variant_to_binary(type, var2, abi_serializer::create_yield_function( max_serialization_time ));
    BOOST_REQUIRE_EQUAL(fc::to_hex(bytes2), hex);
 }
@@ -2624,6 +2625,17 @@ BOOST_AUTO_TEST_CASE(abi_very_deep_structs_1ms)
    } FC_LOG_AND_RETHROW()
 }
 
+// Types nested deeper than max_recursion_depth are not compiled into type plans
+BOOST_AUTO_TEST_CASE(abi_very_deep_structs_without_type_plans)
+{
+   try {
+      abi_serializer abis( fc::json::from_string( large_nested_abi ).as<abi_def>(), abi_serializer::create_yield_function( max_serialization_time ) );
+      verify_byte_round_trip_conversion( abis, "s0", fc::json::from_string( R"({"f1":5})" ) );
+      abi_serializer copy( abis );
+      verify_byte_round_trip_conversion( copy, "s0", fc::json::from_string( R"({"f1":5})" ) );
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE(abi_deep_structs_validate)
 {
    try {
@@ -2830,6 +2842,79 @@ BOOST_AUTO_TEST_CASE(variant_of_aliases)
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE(abi_binary_to_json)
+{
+   auto abi = R"({
+      "version": "eosio::abi/1.1",
+      "types": [
+         { "new_type_name": "names", "type": "name[]" },
+         { "new_type_name": "opt8", "type": "int8?" }
+      ],
+      "structs": [
+         {"name": "base", "base": "", "fields": [{"name": "id", "type": "uint32"}, {"name": "memo", "type": "string"}]},
+         {"name": "dup", "base": "base", "fields": [{"name": "id", "type": "int8"}]},
+         {"name": "row", "base": "", "fields": [{"name": "opts", "type": "opt8[]"}, {"name": "ext", "type": "names$"}]},
+         {"name": "empty", "base": "", "fields": []}
+      ],
+   })";
+
+   try {
+      abi_serializer abis(fc::json::from_string(abi).as<abi_def>(), abi_serializer::create_yield_function( max_serialization_time ));
+      auto to_json = [&](const std::string_view& type, const std::string& hex) {
+         bytes b(hex.size() / 2);
+         fc::from_hex(hex, b.data(), b.size());
+         return abis.binary_to_json(type, b, abi_serializer::create_yield_function( max_serialization_time ));
+      };
+
+      // escaped strings and a repeated field name match the variant
+      BOOST_CHECK_EQUAL(to_json("base", "0100000002220a"), R"({"id":1,"memo":"\"\n"})");
+      BOOST_CHECK_EQUAL(to_json("dup", "0100000000ff"), R"({"id":-1,"memo":""})");
+      BOOST_CHECK_EQUAL(to_json("row", "0101ff"), R"({"opts":[-1]})");
+      BOOST_CHECK_EQUAL(to_json("row", "0101ff010000000000ea3055"), R"({"opts":[-1],"ext":["eosio"]})");
+
+      // same errors as binary_to_variant
+      BOOST_CHECK_THROW(to_json("row", "0100"), unpack_exception);
+      BOOST_CHECK_THROW(to_json("empty", ""), unpack_exception);
+      BOOST_CHECK_THROW(to_json("base", "01000000"), unpack_exception);
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE(abi_serializer_copy)
+{
+   auto abi = R"({
+      "version": "eosio::abi/1.1",
+      "types": [
+         { "new_type_name": "points", "type": "point[]" }
+      ],
+      "structs": [
+         {"name": "base", "base": "", "fields": [{"name": "id", "type": "uint32"}]},
+         {"name": "point", "base": "base", "fields": [{"name": "x", "type": "int8"}, {"name": "tag", "type": "v?"}]}
+      ],
+      "variants": [
+         {"name": "v", "types": ["int8", "string"]}
+      ],
+   })";
+   const std::string json = R"([{"id":1,"x":2,"tag":["string","ab"]},{"id":3,"x":-1,"tag":null}])";
+   const std::string hex = "020100000002010102616203000000ff00";
+
+   try {
+      std::optional<abi_serializer> copied;
+      std::optional<abi_serializer> moved;
+      {
+         abi_serializer abis(fc::json::from_string(abi).as<abi_def>(), abi_serializer::create_yield_function( max_serialization_time ));
+         verify_round_trip_conversion(abis, "points", json, hex);
+         copied.emplace(abis);
+         abi_serializer tmp(abis);
+         moved.emplace(std::move(tmp));
+      }
+      // the compiled types of a copy refer to its own definitions
+      verify_round_trip_conversion(*copied, "points", json, hex);
+      verify_round_trip_conversion(*moved, "points", json, hex);
+      // types not named in the abi are still resolved
+      verify_round_trip_conversion(*copied, "base[]", R"([{"id":7}])", "0107000000");
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE(action_results)
 {
    auto action_results_abi = R"({
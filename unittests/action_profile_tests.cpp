@@ -0,0 +1,101 @@
+#include <eosio/chain/action_profile.hpp>
+#include <eosio/chain/contract_cpu_sampler.hpp>
+#include <eosio/testing/tester.hpp>
+
+#include <fc/variant_object.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <contracts.hpp>
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::testing;
+
+using mvo = fc::mutable_variant_object;
+
+BOOST_AUTO_TEST_SUITE(action_profile_tests)
+
+BOOST_AUTO_TEST_CASE( profile_token_transfer ) try {
+   fc::temp_directory tempdir;
+   tester chain( tempdir, []( controller::config& cfg ) { cfg.action_profile_sample_rate = 1; }, true );
+   chain.execute_setup_policy( setup_policy::full );
+
+   chain.create_accounts( { "eosio.token"_n, "alice"_n, "bob"_n } );
+   chain.set_code( "eosio.token"_n, contracts::eosio_token_wasm() );
+   chain.set_abi( "eosio.token"_n, contracts::eosio_token_abi().data() );
+   chain.push_action( "eosio.token"_n, "create"_n, "eosio.token"_n,
+                      mvo()( "issuer", "eosio.token" )( "maximum_supply", "1000.0000 TOK" ) );
+   chain.push_action( "eosio.token"_n, "issue"_n, "eosio.token"_n,
+                      mvo()( "to", "eosio.token" )( "quantity", "100.0000 TOK" )( "memo", "" ) );
+   chain.push_action( "eosio.token"_n, "transfer"_n, "eosio.token"_n,
+                      mvo()( "from", "eosio.token" )( "to", "alice" )( "quantity", "100.0000 TOK" )( "memo", "" ) );
+   chain.produce_block();
+
+   auto trace = chain.push_action( "eosio.token"_n, "transfer"_n, "alice"_n,
+                                   mvo()( "from", "alice" )( "to", "bob" )( "quantity", "1.0000 TOK" )( "memo", "" ) );
+   // the transfer and its notifications of alice and bob
+   BOOST_REQUIRE_EQUAL( trace->action_traces.size(), 3u );
+   for( const auto& at : trace->action_traces ) {
+      BOOST_REQUIRE( at.profile );
+   }
+
+   const auto& transfer = *trace->action_traces[0].profile;
+   BOOST_CHECK_GT( transfer.host_calls, 0u );
+   BOOST_CHECK_GT( transfer.db_calls, 0u );
+   BOOST_CHECK_LE( transfer.db_calls, transfer.host_calls );
+   uint32_t sum = 0;
+   bool required_auth = false;
+   for( const auto& c : transfer.host_call_counts ) {
+      BOOST_CHECK_GT( c.calls, 0u );
+      sum += c.calls;
+      required_auth |= c.intrinsic == "require_auth";
+   }
+   BOOST_CHECK_EQUAL( sum, transfer.host_calls );
+   BOOST_CHECK( required_auth );
+
+   // the token contract does not handle the notifications it sends to alice and bob, who have no code
+   BOOST_CHECK_EQUAL( trace->action_traces[1].profile->host_calls, 0u );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( not_profiled_by_default ) try {
+   tester chain;
+   auto trace = chain.create_account( "alice"_n );
+   BOOST_REQUIRE( !trace->action_traces.empty() );
+   BOOST_CHECK( !trace->action_traces[0].profile );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( contract_cpu_sampler_counts_tagged_actions ) try {
+   contract_cpu_sampler sampler;
+   {
+      // not started, nothing is tagged
+      auto tag = sampler.tag( "alice"_n, "eosio.token"_n, "transfer"_n );
+   }
+   sampler.start( fc::microseconds( 200 ) );
+   {
+      auto tag = sampler.tag( "alice"_n, "eosio.token"_n, "transfer"_n );
+      std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+   }
+   std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+   // actions of other threads are not sampled
+   std::thread( [&sampler]() {
+      auto tag = sampler.tag( "bob"_n, "eosio.token"_n, "transfer"_n );
+      std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+   } ).join();
+   sampler.stop();
+
+   auto samples = sampler.get_samples( 10 );
+   BOOST_CHECK_EQUAL( samples.interval.count(), 200 );
+   BOOST_CHECK_GT( samples.action_samples, 0u );
+   BOOST_CHECK_GT( samples.samples, samples.action_samples );
+   BOOST_REQUIRE_EQUAL( samples.actions.size(), 1u );
+   BOOST_CHECK_EQUAL( samples.actions[0].receiver, "alice"_n );
+   BOOST_CHECK_EQUAL( samples.actions[0].account, "eosio.token"_n );
+   BOOST_CHECK_EQUAL( samples.actions[0].action, "transfer"_n );
+   BOOST_CHECK_EQUAL( samples.actions[0].samples, samples.action_samples );
+
+   sampler.reset();
+   BOOST_CHECK_EQUAL( sampler.get_samples( 10 ).samples, 0u );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2411,12 +2411,22 @@ static const char memmove_pass_wast[] = R"======(
   (call $fillmem (i32.const 64) (i32.const 128))
   (drop (call $memmove (i32.const 8) (i32.const 64) (i32.const 128)))
   (call $checkmem (i32.const 8) (i32.const 128) (i32.const 640))
+
+  (call $fillmem (i32.const 1024) (i32.const 37))
+  (drop (call $memmove (i32.const 1041) (i32.const 1024) (i32.const 37)))
+  (call $checkmem (i32.const 1041) (i32.const 37) (i32.const 768))
+
+  (call $fillmem (i32.const 1041) (i32.const 37))
+  (drop (call $memmove (i32.const 1024) (i32.const 1041) (i32.const 37)))
+  (call $checkmem (i32.const 1024) (i32.const 37) (i32.const 896))
  )
  (data (i32.const 128) "expected memmove to return 65535")
  (data (i32.const 256) "expected memmove to write one byte")
  (data (i32.const 384) "memmove overlap dest above src")
  (data (i32.const 512) "memmove overlap exact")
  (data (i32.const 640) "memmove overlap src above dst")
+ (data (i32.const 768) "memmove unaligned length dest above src")
+ (data (i32.const 896) "memmove unaligned length src above dst")
 )
 )======";
 
@@ -2447,9 +2457,15 @@ static const char memset_pass_wast[] = R"======(
  (func (export "apply") (param i64 i64 i64)
   (call $eosio_assert (i32.eq (call $memset (i32.const 65535) (i32.const 0xCC) (i32.const 1)) (i32.const 65535)) (i32.const 128))
   (call $eosio_assert (i64.eq (i64.load (i32.const 65528)) (i64.const 0xCC00000000000000)) (i32.const 256))
+  (drop (call $memset (i32.const 1024) (i32.const 0x1AB) (i32.const 37)))
+  (call $eosio_assert (i32.eq (i32.load8_u (i32.const 1023)) (i32.const 0)) (i32.const 384))
+  (call $eosio_assert (i32.eq (i32.load8_u (i32.const 1024)) (i32.const 0xAB)) (i32.const 384))
+  (call $eosio_assert (i32.eq (i32.load8_u (i32.const 1060)) (i32.const 0xAB)) (i32.const 384))
+  (call $eosio_assert (i32.eq (i32.load8_u (i32.const 1061)) (i32.const 0)) (i32.const 384))
  )
  (data (i32.const 128) "expected memset to return 65535")
  (data (i32.const 256) "expected memset to write one byte")
+ (data (i32.const 384) "expected memset to fill exactly 37 bytes")
 )
 )======";
 
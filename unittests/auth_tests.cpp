@@ -521,4 +521,54 @@ BOOST_AUTO_TEST_CASE( linkauth_special ) { try {
 } FC_LOG_AND_RETHROW() }
 
 
+BOOST_AUTO_TEST_CASE( cached_authorities_follow_state ) { try {
+   TESTER chain;
+   chain.create_account("alice"_n);
+   chain.produce_block();
+
+   const auto& authorization = chain.control->get_authorization_manager();
+   const auto active_pub_key = chain.get_public_key("alice"_n, "active");
+   const auto second_pub_key = chain.get_public_key("alice"_n, "second");
+   auto check = [&]( permission_name perm, const public_key_type& key ) {
+      authorization.check_authorization( "alice"_n, perm, {key} );
+   };
+   auto min_permission = [&]() {
+      return *authorization.lookup_minimum_permission( "alice"_n, config::system_account_name, "reqauth"_n );
+   };
+
+   // populate the caches
+   check( config::active_name, active_pub_key );
+   BOOST_CHECK_EQUAL( min_permission(), config::active_name );
+
+   chain.set_authority( "alice"_n, "spending"_n, second_pub_key, config::active_name );
+   chain.link_authority( "alice"_n, config::system_account_name, "spending"_n, "reqauth"_n );
+   BOOST_CHECK_EQUAL( min_permission(), "spending"_n );
+   check( "spending"_n, second_pub_key );
+
+   chain.set_authority( "alice"_n, config::active_name, second_pub_key );
+   check( config::active_name, second_pub_key );
+   BOOST_CHECK_THROW( check( config::active_name, active_pub_key ), unsatisfied_authorization );
+
+   // undoing the pending block must revert the cached authorities and links as well
+   chain.control->abort_block();
+   check( config::active_name, active_pub_key );
+   BOOST_CHECK_THROW( check( config::active_name, second_pub_key ), unsatisfied_authorization );
+   BOOST_CHECK_THROW( check( "spending"_n, second_pub_key ), unsatisfied_authorization );
+   BOOST_CHECK_EQUAL( min_permission(), config::active_name );
+
+   chain.set_authority( "alice"_n, "spending"_n, second_pub_key, config::active_name );
+   chain.link_authority( "alice"_n, config::system_account_name, "spending"_n );
+   chain.produce_block();
+   check( "spending"_n, second_pub_key );
+   BOOST_CHECK_EQUAL( min_permission(), "spending"_n ); // contract-wide link
+
+   chain.unlink_authority( "alice"_n, config::system_account_name );
+   chain.delete_authority( "alice"_n, "spending"_n );
+   BOOST_CHECK_EQUAL( min_permission(), config::active_name );
+   BOOST_CHECK_THROW( check( "spending"_n, second_pub_key ), unsatisfied_authorization );
+   chain.produce_block();
+   BOOST_CHECK_THROW( check( "spending"_n, second_pub_key ), unsatisfied_authorization );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,5 +1,6 @@
 #include <boost/test/unit_test.hpp>
 #include <eosio/testing/tester.hpp>
+#include <eosio/chain/block_apply_metrics.hpp>
 
 using namespace eosio;
 using namespace testing;
@@ -230,6 +231,70 @@ BOOST_AUTO_TEST_CASE(broadcasted_block_test)
   BOOST_CHECK(std::equal(bcasted_blk_by_prod_node_packed.begin(), bcasted_blk_by_prod_node_packed.end(), bcasted_blk_by_recv_node_packed.begin()));
 }
 
+/**
+ * Verify blocks with key recovery started ahead of apply are applied with the prefetched keys
+ */
+BOOST_AUTO_TEST_CASE(block_key_prefetch_test)
+{
+  tester producer_node;
+  tester receiving_node;
+
+  std::vector<signed_block_ptr> blocks;
+  for( auto n : {"alice"_n, "bob"_n, "carol"_n} ) {
+    producer_node.create_account( n );
+    blocks.push_back( producer_node.produce_block() );
+  }
+
+  size_t recovered = 0;
+  receiving_node.control->accepted_block.connect( [&](const block_state_ptr& bs) {
+    for( const auto& trx : bs->trxs_metas() ) {
+      BOOST_CHECK( !trx->recovered_keys().empty() );
+      ++recovered;
+    }
+  });
+
+  for( const auto& b : blocks ) {
+    receiving_node.control->start_block_key_recovery( b->calculate_id(), b );
+  }
+  // already prefetched, ignored
+  receiving_node.control->start_block_key_recovery( blocks.back()->calculate_id(), blocks.back() );
+
+  for( const auto& b : blocks ) {
+    receiving_node.push_block( b );
+  }
+
+  BOOST_CHECK_EQUAL( recovered, 3u );
+  BOOST_CHECK_EQUAL( receiving_node.control->head_block_id(), producer_node.control->head_block_id() );
+}
+
+/**
+ * Verify stage timings are recorded for applied blocks
+ */
+BOOST_AUTO_TEST_CASE(block_apply_metrics_test)
+{
+  tester producer_node;
+  tester receiving_node;
+
+  producer_node.create_account( "alice"_n );
+  auto b1 = producer_node.produce_block();
+  auto b2 = producer_node.produce_block();
+
+  const auto prev_count = receiving_node.control->get_block_apply_metrics().total.count;
+  receiving_node.push_block( b1 );
+  BOOST_CHECK_EQUAL( receiving_node.control->get_last_block_apply_times().block_num, b1->block_num() );
+  BOOST_CHECK_EQUAL( receiving_node.control->get_last_block_apply_times().num_trxs, b1->transactions.size() );
+  receiving_node.push_block( b2 );
+  BOOST_CHECK_EQUAL( receiving_node.control->get_last_block_apply_times().block_num, b2->block_num() );
+
+  const auto& metrics = receiving_node.control->get_block_apply_metrics();
+  BOOST_CHECK_EQUAL( metrics.total.count, prev_count + 2 );
+  BOOST_CHECK_EQUAL( metrics.exec_trxs.count, metrics.total.count );
+  uint64_t bucket_total = 0;
+  for( auto c : metrics.total.buckets ) bucket_total += c;
+  BOOST_CHECK_EQUAL( bucket_total, metrics.total.count );
+  BOOST_CHECK_LE( metrics.total.max_us, metrics.total.total_us );
+}
+
 /**
  * Verify abort block returns applied transactions in block
  */
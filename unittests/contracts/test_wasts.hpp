@@ -383,6 +383,15 @@ static const char memory_init_toolong[] = R"=====(
 )
 )=====";
 
+static const char memory_init_outside_initial_memory[] = R"=====(
+(module
+ (memory $0 0)
+ (export "apply" (func $apply))
+ (func $apply (param $0 i64) (param $1 i64) (param $2 i64))
+ (data (i32.const 0) "sup!")
+)
+)=====";
+
 static const char memory_init_negative[] = R"=====(
 (module
  (memory $0 16)
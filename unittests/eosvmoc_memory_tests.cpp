@@ -0,0 +1,76 @@
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+
+#include <eosio/chain/webassembly/eos-vm-oc/memory.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/time.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace eosio::chain;
+using namespace eosio::chain::eosvmoc;
+
+namespace {
+
+bool is_zero( const uint8_t* p, size_t size ) {
+   return std::all_of( p, p + size, []( uint8_t c ) { return c == 0; } );
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(eosvmoc_memory_tests)
+
+BOOST_AUTO_TEST_CASE( zero_linear_memory ) try {
+   constexpr uint64_t max_pages = memory::release_min_pages * 2;
+   memory mem( max_pages );
+   uint8_t* const base = mem.full_page_memory_base();
+
+   // below and above the size from which host pages are released instead of written
+   for( uint64_t pages : { memory::release_min_pages - 1, memory::release_min_pages, max_pages } ) {
+      const size_t size = pages * wasm_constraints::wasm_page_size;
+      memset( base, 0xcc, size );
+      base[size - 1] = 0x1;
+      mem.zero_linear_memory( pages );
+      BOOST_CHECK( is_zero( base, size ) );
+
+      // the memory is usable again afterwards
+      base[size / 2] = 0x2;
+      BOOST_CHECK_EQUAL( base[size / 2], 0x2 );
+      mem.zero_linear_memory( pages );
+      BOOST_CHECK( is_zero( base, size ) );
+   }
+} FC_LOG_AND_RETHROW()
+
+// reports the cost of resetting a large linear memory of which a contract touched only a few pages
+BOOST_AUTO_TEST_CASE( zero_linear_memory_benchmark ) try {
+   constexpr uint64_t pages = 33; // 2 MiB, a common initial memory for contracts built with large stack/heap
+   constexpr int iterations = 1000;
+   memory mem( pages );
+   uint8_t* const base = mem.full_page_memory_base();
+   const size_t size = pages * wasm_constraints::wasm_page_size;
+
+   auto start = fc::time_point::now();
+   for( int i = 0; i < iterations; ++i ) {
+      base[i % size] = 1;
+      mem.zero_linear_memory( pages );
+   }
+   const auto released = fc::time_point::now() - start;
+
+   start = fc::time_point::now();
+   for( int i = 0; i < iterations; ++i ) {
+      base[i % size] = 1;
+      memset( base, 0, size );
+   }
+   const auto written = fc::time_point::now() - start;
+
+   BOOST_TEST_MESSAGE( "zeroing " << pages << " wasm pages: released " << released.count() / iterations
+                       << " us, written " << written.count() / iterations << " us" );
+   BOOST_CHECK( is_zero( base, size ) );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -10,6 +10,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <fstream>
+
 #include <contracts.hpp>
 
 #include "fork_test_utilities.hpp"
@@ -568,6 +570,38 @@ BOOST_AUTO_TEST_CASE( reopen_forkdb ) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_AUTO_TEST_CASE( forkdb_journal_replay ) try {
+   tester c;
+   c.create_accounts( {"alice"_n,"bob"_n} );
+   c.produce_blocks(5);
+
+   // copy the journal while the chain is still running, as if the process had been killed
+   fc::temp_directory copy_dir;
+   const auto journal_copy = copy_dir.path() / config::forkdb_journal_filename;
+   fc::copy( c.get_config().state_dir / config::forkdb_journal_filename, journal_copy );
+
+   auto no_validation = []( block_timestamp_type, const flat_set<digest_type>&, const vector<digest_type>& ) {};
+   {
+      fork_database fdb( copy_dir.path() );
+      fdb.open( no_validation );
+      BOOST_CHECK( fdb.root()->id == c.control->fork_db().root()->id );
+      BOOST_CHECK( fdb.head()->id == c.control->fork_db().head()->id );
+   }
+
+   // a record cut short by a crash is discarded
+   const auto journal_size = fc::file_size( journal_copy );
+   {
+      std::ofstream out( journal_copy.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::app );
+      out.write( "\x02\xff\xff\x00\x00garbage", 12 );
+   }
+   {
+      fork_database fdb( copy_dir.path() );
+      fdb.open( no_validation );
+      BOOST_CHECK( fdb.head()->id == c.control->fork_db().head()->id );
+   }
+   BOOST_CHECK_EQUAL( fc::file_size( journal_copy ), journal_size );
+} FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_CASE( push_block_returns_forked_transactions ) try {
    tester c;
    while (c.control->head_block_num() < 3) {
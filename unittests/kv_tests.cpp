@@ -1048,4 +1048,112 @@ BOOST_DATA_TEST_CASE_F(tester, alias, bdata::make(databases), db) {
    BOOST_TEST_CHECK(push_action( action({}, alias_general_account, db, construct_span_payload(131, 2)), alias_general_account.to_uint64_t() ) == alias_error_msg);
 }
 
+// Calls the batch intrinsics, the action name picks the call:
+// - set:      kv_set_batch on the packed pairs in the action data, returns the resource delta
+// - setoob:   kv_set_batch on a buffer that runs past the end of memory
+// - get:      kv_get_batch on the packed keys in the action data, returns the packed values
+// - getsmall: kv_get_batch into a 1 byte buffer, returns the required size and the first byte of the buffer
+// - getoob:   kv_get_batch into a buffer that runs past the end of memory
+static const char kv_batch_wast[] = R"=====(
+(module
+ (func $action_data_size (import "env" "action_data_size") (result i32))
+ (func $read_action_data (import "env" "read_action_data") (param i32 i32) (result i32))
+ (func $kv_get_batch (import "env" "kv_get_batch") (param i64 i32 i32 i32 i32) (result i32))
+ (func $kv_set_batch (import "env" "kv_set_batch") (param i64 i32 i32 i64) (result i64))
+ (func $set_action_return_value (import "env" "set_action_return_value") (param i32 i32))
+ (memory 1)
+ (func (export "apply") (param i64 i64 i64)
+  (local $size i32)
+  (set_local $size (call $action_data_size))
+  (drop (call $read_action_data (i32.const 0) (get_local $size)))
+  (if (i64.eq (get_local 2) (i64.const 14029275789212516352))
+   (then
+    (i64.store (i32.const 8192) (call $kv_set_batch (get_local 0) (i32.const 0) (get_local $size) (get_local 0)))
+    (call $set_action_return_value (i32.const 8192) (i32.const 8))
+   )
+  )
+  (if (i64.eq (get_local 2) (i64.const 14029638748308766720))
+   (then
+    (drop (call $kv_set_batch (get_local 0) (i32.const 65535) (i32.const 16) (get_local 0)))
+   )
+  )
+  (if (i64.eq (get_local 2) (i64.const 7111746761571434496))
+   (then
+    (call $set_action_return_value (i32.const 8192)
+       (call $kv_get_batch (get_local 0) (i32.const 0) (get_local $size) (i32.const 8192) (i32.const 4096)))
+   )
+  )
+  (if (i64.eq (get_local 2) (i64.const 7112178982132383744))
+   (then
+    (i32.store8 (i32.const 8192) (i32.const 255))
+    (i32.store (i32.const 4096) (call $kv_get_batch (get_local 0) (i32.const 0) (get_local $size) (i32.const 8192) (i32.const 1)))
+    (i32.store8 (i32.const 4100) (i32.load8_u (i32.const 8192)))
+    (call $set_action_return_value (i32.const 4096) (i32.const 5))
+   )
+  )
+  (if (i64.eq (get_local 2) (i64.const 7112109720667684864))
+   (then
+    (drop (call $kv_get_batch (get_local 0) (i32.const 0) (get_local $size) (i32.const 65535) (i32.const 16)))
+   )
+  )
+ )
+)
+)=====";
+
+BOOST_DATA_TEST_CASE_F(tester, batch, bdata::make(databases), db) {
+   const name batch_account{"batch"_n};
+
+   create_accounts({ "setup"_n, batch_account });
+   set_code( "setup"_n, kv_setup_wast );
+   push_action( "eosio"_n, "setpriv"_n, "eosio"_n, mutable_variant_object()("account", "setup"_n)("is_priv", 1));
+   BOOST_TEST_REQUIRE(push_action( action({}, "setup"_n, db, construct_names_payload({batch_account})), "setup"_n.to_uint64_t() ) == "");
+
+   set_code( batch_account, kv_batch_wast );
+   produce_block();
+
+   auto push_batch = [&](name act, const std::vector<char>& data) {
+      signed_transaction trx;
+      trx.actions.emplace_back( vector<permission_level>{{batch_account, config::active_name}}, batch_account, act, data );
+      set_transaction_headers( trx );
+      trx.sign( get_private_key( batch_account, "active" ), control->get_chain_id() );
+      auto trace = push_transaction( trx );
+      produce_block();
+      return trace->action_traces.at(0).return_value;
+   };
+   auto bytes_of = [](const char* s) { return bytes(s, s + strlen(s)); };
+   auto ram_usage = [&]() { return control->get_resource_limits_manager().get_account_ram_usage( batch_account ); };
+   const int64_t base_billable = config::billable_size_v<kv_object>;
+
+   // set two new pairs, each is billed like a single kv_set
+   int64_t base_usage = ram_usage();
+   std::vector<std::pair<bytes, bytes>> pairs{ { bytes_of("a"), bytes_of("xyz") }, { bytes_of("bc"), bytes{} } };
+   auto delta = fc::raw::unpack<int64_t>( push_batch( "set"_n, fc::raw::pack( pairs ) ) );
+   BOOST_TEST(delta == 2 * base_billable + 1 + 3 + 2);
+   BOOST_TEST(ram_usage() == base_usage + delta);
+
+   // shrinking a value refunds the difference
+   pairs = { { bytes_of("a"), bytes_of("x") } };
+   delta = fc::raw::unpack<int64_t>( push_batch( "set"_n, fc::raw::pack( pairs ) ) );
+   BOOST_TEST(delta == -2);
+   BOOST_TEST(ram_usage() == base_usage + 2 * base_billable + 1 + 1 + 2);
+
+   // missing keys come back as empty optionals, in key order
+   std::vector<bytes> keys{ bytes_of("a"), bytes_of("missing"), bytes_of("bc") };
+   std::vector<std::optional<bytes>> expected{ bytes_of("x"), std::nullopt, bytes{} };
+   BOOST_TEST(push_batch( "get"_n, fc::raw::pack( keys ) ) == fc::raw::pack( expected ));
+
+   // a buffer that is too small is left untouched and the required size is returned
+   auto small = push_batch( "getsmall"_n, fc::raw::pack( keys ) );
+   BOOST_TEST_REQUIRE(small.size() == 5u);
+   uint32_t required = 0;
+   memcpy( &required, small.data(), sizeof(required) );
+   BOOST_TEST(required == fc::raw::pack_size( expected ));
+   BOOST_TEST(static_cast<uint8_t>(small[4]) == 255);
+
+   // buffers outside of linear memory are rejected
+   BOOST_CHECK_EXCEPTION( push_batch( "setoob"_n, {} ), wasm_execution_error, fc_exception_message_is( "access violation" ) );
+   BOOST_CHECK_EXCEPTION( push_batch( "getoob"_n, fc::raw::pack( keys ) ), wasm_execution_error, fc_exception_message_is( "access violation" ) );
+   BOOST_TEST(ram_usage() == base_usage + 2 * base_billable + 1 + 1 + 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 #include <eosio/chain/authority_checker.hpp>
 #include <eosio/chain/types.hpp>
 #include <eosio/chain/thread_utils.hpp>
+#include <eosio/chain/merkle.hpp>
 #include <eosio/chain/block_log.hpp>
 #include <eosio/testing/tester.hpp>
 
@@ -985,10 +986,116 @@ BOOST_AUTO_TEST_CASE(transaction_metadata_test) { try {
       BOOST_CHECK_EQUAL(1u, keys3.size());
       BOOST_CHECK_EQUAL(public_key, *keys3.begin());
 
+      // batch recovery, a failure of one trx does not affect the others
+      packed_transaction_ptr pruned = std::make_shared<packed_transaction>( signed_transaction(trx), true, packed_transaction::compression_type::none);
+      pruned->prune_all();
+      auto futs = transaction_metadata::start_recover_keys( {ptrx, pruned, ptrx2, ptrx}, thread_pool.get_executor(),
+                                                            test.control->get_chain_id(), fc::microseconds::maximum(), 2 );
+      BOOST_REQUIRE_EQUAL(4u, futs.size());
+      BOOST_CHECK_THROW(futs[1].get(), tx_no_signature);
+      for( size_t i : {0, 2, 3} ) {
+         auto m = futs[i].get();
+         BOOST_CHECK_EQUAL(trx.id(), m->id());
+         BOOST_REQUIRE_EQUAL(1u, m->recovered_keys().size());
+         BOOST_CHECK_EQUAL(public_key, *m->recovered_keys().begin());
+      }
+      BOOST_CHECK(transaction_metadata::start_recover_keys( vector<packed_transaction_ptr>{}, thread_pool.get_executor(),
+                                                            test.control->get_chain_id(), fc::microseconds::maximum(), 2 ).empty());
+
       thread_pool.stop();
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE(merkle_accumulator_test) { try {
+   merkle_accumulator acc;
+   BOOST_CHECK( acc.empty() );
+   BOOST_CHECK_EQUAL( acc.get_root(), digest_type() );
+
+   deque<digest_type> digests;
+   for( uint32_t i = 0; i < 70; ++i ) {
+      digests.emplace_back( digest_type::hash( i ) );
+      acc.append( digests.back() );
+      BOOST_REQUIRE_EQUAL( acc.size(), digests.size() );
+      BOOST_REQUIRE_EQUAL( acc.get_root(), merkle( digests ) );
+   }
+
+   merkle_accumulator bulk;
+   bulk.append( digests );
+   BOOST_CHECK_EQUAL( bulk.get_root(), acc.get_root() );
+
+   for( size_t i = 1; i < digests.size(); ++i ) {
+      BOOST_REQUIRE_EQUAL( hash_canonical_pair( digests[i-1], digests[i] ),
+                           digest_type::hash( make_canonical_pair( digests[i-1], digests[i] ) ) );
+   }
+   // reference implementation duplicating the last id of odd levels
+   auto reference_merkle = []( deque<digest_type> ids ) {
+      while( ids.size() > 1 ) {
+         if( ids.size() % 2 ) ids.push_back( ids.back() );
+         for( size_t i = 0; i < ids.size() / 2; ++i ) {
+            ids[i] = digest_type::hash( make_canonical_pair( ids[2 * i], ids[2 * i + 1] ) );
+         }
+         ids.resize( ids.size() / 2 );
+      }
+      return ids.front();
+   };
+   for( size_t n = 1; n <= digests.size(); ++n ) {
+      deque<digest_type> ids( digests.begin(), digests.begin() + n );
+      BOOST_REQUIRE_EQUAL( merkle( ids ), reference_merkle( ids ) );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(bounded_serial_executor_test) { try {
+   bounded_serial_executor executor( "serial", 2 );
+   std::vector<int> order;
+   for( int i = 0; i < 100; ++i ) {
+      executor.post( [&order, i]() {
+         if( i == 50 ) throw std::runtime_error( "dropped" ); // logged, later tasks still run
+         order.push_back( i );
+      } );
+      BOOST_CHECK_LE( executor.queued(), 2u );
+   }
+   executor.drain();
+   BOOST_CHECK_EQUAL( executor.queued(), 0u );
+   BOOST_REQUIRE_EQUAL( order.size(), 99u );
+   for( size_t i = 1; i < order.size(); ++i ) {
+      BOOST_CHECK_LT( order[i-1], order[i] );
+   }
+   executor.stop();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(thread_pool_task_counters_test) { try {
+   named_thread_pool thread_pool( "count", 2 );
+   auto& counters = get_thread_pool_task_counters( "misc_tests" );
+   BOOST_CHECK_EQUAL( &counters, &get_thread_pool_task_counters( "misc_tests" ) );
+
+   auto fut = async_thread_pool( thread_pool.get_executor(), counters, []() { return 42; } );
+   BOOST_CHECK_EQUAL( fut.get(), 42 );
+
+   std::promise<int> then_result;
+   async_thread_pool( thread_pool.get_executor(), counters, []() -> int { throw std::runtime_error( "failed" ); },
+                      [&then_result]( std::future<int> f ) {
+                         try {
+                            then_result.set_value( f.get() );
+                         } catch( ... ) {
+                            then_result.set_exception( std::current_exception() );
+                         }
+                      } );
+   BOOST_CHECK_THROW( then_result.get_future().get(), std::runtime_error );
+
+   std::promise<int> then_value;
+   async_thread_pool( thread_pool.get_executor(), counters, []() { return 1; },
+                      [&then_value]( std::future<int> f ) { then_value.set_value( f.get() ); } );
+   BOOST_CHECK_EQUAL( then_value.get_future().get(), 1 );
+   thread_pool.stop();
+
+   auto metrics = get_thread_pool_task_metrics();
+   auto itr = std::find_if( metrics.begin(), metrics.end(), []( const auto& m ) { return m.task_type == "misc_tests"; } );
+   BOOST_REQUIRE( itr != metrics.end() );
+   BOOST_CHECK_EQUAL( itr->completed, 3u );
+   BOOST_CHECK_EQUAL( itr->queued, 0u );
+   BOOST_CHECK_EQUAL( itr->running, 0u );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE(prunable_transaction_data_test) {
    {
       packed_transaction::prunable_data_type basic{packed_transaction::prunable_data_type::full_legacy{{}, {}}};
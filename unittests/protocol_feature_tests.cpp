@@ -1908,4 +1908,68 @@ BOOST_AUTO_TEST_CASE( set_parameters_packed_test ) { try {
                        c.error("alice does not have permission to call this API"));
 } FC_LOG_AND_RETHROW() }
 
+
+static const char import_db_get_batch_i64_wast[] = R"=====(
+(module
+ (import "env" "db_get_batch_i64" (func $db_get_batch_i64 (param i64 i64 i64 i32 i32 i32 i32)(result i32)))
+ (import "env" "eosio_assert" (func $eosio_assert (param i32 i32)))
+ (memory $0 1)
+ (export "apply" (func $apply))
+ (func $apply (param $0 i64) (param $1 i64) (param $2 i64)
+   ;; one missing row packs as a vector of one empty optional
+   (call $eosio_assert
+      (i32.eq
+         (call $db_get_batch_i64
+            (get_local $0)
+            (get_local $0)
+            (get_local $0)
+            (i32.const 0)
+            (i32.const 9)
+            (i32.const 16)
+            (i32.const 16)
+         )
+         (i32.const 2)
+      )
+      (i32.const 32)
+   )
+   (call $eosio_assert
+      (i32.and
+         (i32.eq (i32.load8_u (i32.const 16)) (i32.const 1))
+         (i32.eq (i32.load8_u (i32.const 17)) (i32.const 0))
+      )
+      (i32.const 32)
+   )
+ )
+ (data (i32.const 0) "\01\01\00\00\00\00\00\00\00")
+ (data (i32.const 32) "unexpected batch result\00")
+)
+)=====";
+
+BOOST_AUTO_TEST_CASE( db_get_batch_i64_test ) { try {
+   tester c( setup_policy::preactivate_feature_and_new_bios );
+
+   const auto& pfm = c.control->get_protocol_feature_manager();
+   const auto& d = pfm.get_builtin_digest(builtin_protocol_feature_t::batched_database);
+   BOOST_REQUIRE(d);
+
+   const auto& alice_account = account_name("alice");
+   c.create_accounts( {alice_account} );
+   c.produce_block();
+
+   BOOST_CHECK_EXCEPTION(  c.set_code( alice_account, import_db_get_batch_i64_wast ),
+                           wasm_exception,
+                           fc_exception_message_is( "env.db_get_batch_i64 unresolveable" ) );
+
+   c.preactivate_protocol_features( {*d} );
+   c.produce_block();
+
+   // ensure it now resolves
+   c.set_code( alice_account, import_db_get_batch_i64_wast );
+
+   // ensure it can be called
+   BOOST_REQUIRE_EQUAL(c.push_action(action({{ alice_account, permission_name("active") }}, alice_account, action_name(), {} ), alice_account.to_uint64_t()), c.success());
+
+   c.produce_block();
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
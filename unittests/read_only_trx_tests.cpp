@@ -0,0 +1,83 @@
+#include <eosio/chain/transaction_metadata.hpp>
+#include <eosio/testing/tester.hpp>
+
+#include <fc/variant_object.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <contracts.hpp>
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::testing;
+
+using mvo = fc::mutable_variant_object;
+
+namespace {
+
+transaction_trace_ptr push_read_only( tester& chain, const action& act ) {
+   signed_transaction trx;
+   trx.actions.push_back( act );
+   chain.set_transaction_headers( trx );
+   // no signatures, read-only transactions are not authorized
+   auto meta = transaction_metadata::create_no_recover_keys( std::make_shared<packed_transaction>( std::move(trx), true ),
+                                                             transaction_metadata::trx_type::read_only );
+   return chain.control->push_transaction( meta, fc::time_point::maximum(), 0, false, 0 );
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(read_only_trx_tests)
+
+BOOST_AUTO_TEST_CASE( writes_are_rejected ) try {
+   tester chain;
+
+   chain.create_accounts( { "eosio.token"_n, "alice"_n, "bob"_n } );
+   chain.set_code( "eosio.token"_n, contracts::eosio_token_wasm() );
+   chain.set_abi( "eosio.token"_n, contracts::eosio_token_abi().data() );
+   chain.push_action( "eosio.token"_n, "create"_n, "eosio.token"_n,
+                      mvo()( "issuer", "eosio.token" )( "maximum_supply", "1000.0000 TOK" ) );
+   chain.push_action( "eosio.token"_n, "issue"_n, "eosio.token"_n,
+                      mvo()( "to", "eosio.token" )( "quantity", "100.0000 TOK" )( "memo", "" ) );
+   chain.produce_block();
+
+   action transfer = chain.get_action( "eosio.token"_n, "transfer"_n,
+                                       vector<permission_level>{{"eosio.token"_n, config::active_name}},
+                                       mvo()( "from", "eosio.token" )( "to", "alice" )( "quantity", "1.0000 TOK" )( "memo", "" ) );
+   auto trace = push_read_only( chain, transfer );
+   BOOST_REQUIRE( trace->except );
+   BOOST_CHECK_EQUAL( trace->except->code(), unaccessible_api::code_value );
+   BOOST_CHECK_EQUAL( chain.get_currency_balance( "eosio.token"_n, symbol(SY(4,TOK)), "alice"_n ), asset() );
+
+   action newaccount = chain.get_action( config::system_account_name, "newaccount"_n,
+                                         vector<permission_level>{{"alice"_n, config::active_name}},
+                                         mvo()( "creator", "alice" )( "name", "carol" )
+                                              ( "owner", authority( chain.get_public_key( "carol"_n, "owner" ) ) )
+                                              ( "active", authority( chain.get_public_key( "carol"_n, "active" ) ) ) );
+   trace = push_read_only( chain, newaccount );
+   BOOST_REQUIRE( trace->except );
+   BOOST_CHECK( !chain.control->db().find<account_object, by_name>( "carol"_n ) );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( state_is_undone ) try {
+   tester chain;
+   chain.create_account( "alice"_n );
+   chain.produce_block();
+
+   const auto& rlm = chain.control->get_resource_limits_manager();
+   const auto cpu_before = rlm.get_account_cpu_limit( "alice"_n ).first;
+
+   // alice has no contract, so the action does nothing but is still billed
+   action noop( vector<permission_level>{{"alice"_n, config::active_name}}, "alice"_n, "noop"_n, bytes() );
+   auto trace = push_read_only( chain, noop );
+   BOOST_REQUIRE( !trace->except );
+   BOOST_REQUIRE( trace->receipt );
+   BOOST_CHECK_EQUAL( trace->receipt->status, transaction_receipt::executed );
+   BOOST_CHECK_EQUAL( rlm.get_account_cpu_limit( "alice"_n ).first, cpu_before );
+
+   // nothing was added to the pending block
+   auto b = chain.produce_block();
+   BOOST_CHECK( b->transactions.empty() );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/chain/recovered_key_cache.hpp>
+#include <fc/exception/exception.hpp>
+
+using namespace eosio;
+using namespace eosio::chain;
+
+BOOST_AUTO_TEST_SUITE(recovered_key_cache_tests)
+
+private_key_type get_private_key( const std::string& seed ) {
+   return private_key_type::regenerate<fc::ecc::private_key_shim>( fc::sha256::hash( seed ) );
+}
+
+BOOST_AUTO_TEST_CASE( recover_and_find ) try {
+   recovered_key_cache cache( 1024 );
+
+   auto priv = get_private_key( "alice" );
+   auto digest = digest_type::hash( std::string( "message" ) );
+   auto sig = priv.sign( digest );
+   auto key = recovered_key_cache::make_key( sig, digest );
+
+   BOOST_CHECK( !cache.find( key ) );
+   BOOST_CHECK_EQUAL( cache.recover( sig, digest ), priv.get_public_key() );
+   BOOST_CHECK_EQUAL( cache.size(), 1u );
+   BOOST_REQUIRE( cache.find( key ) );
+   BOOST_CHECK_EQUAL( *cache.find( key ), priv.get_public_key() );
+
+   // cached, does not grow
+   BOOST_CHECK_EQUAL( cache.recover( sig, digest ), priv.get_public_key() );
+   BOOST_CHECK_EQUAL( cache.size(), 1u );
+
+   // same signature over a different digest is a different entry
+   auto digest2 = digest_type::hash( std::string( "message2" ) );
+   BOOST_CHECK( !cache.find( recovered_key_cache::make_key( sig, digest2 ) ) );
+
+   cache.clear();
+   BOOST_CHECK_EQUAL( cache.size(), 0u );
+   BOOST_CHECK( !cache.find( key ) );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( canonical_check_kept_apart ) try {
+   recovered_key_cache cache( 1024 );
+
+   auto priv = get_private_key( "dave" );
+   auto digest = digest_type::hash( std::string( "message" ) );
+   auto sig = priv.sign( digest );
+
+   BOOST_CHECK( recovered_key_cache::make_key( sig, digest, false ) != recovered_key_cache::make_key( sig, digest ) );
+
+   BOOST_CHECK_EQUAL( cache.recover( sig, digest, false ), priv.get_public_key() );
+   BOOST_CHECK_EQUAL( cache.size(), 1u );
+   BOOST_CHECK( cache.find( recovered_key_cache::make_key( sig, digest, false ) ) );
+   BOOST_CHECK( !cache.find( recovered_key_cache::make_key( sig, digest ) ) );
+
+   BOOST_CHECK_EQUAL( cache.recover( sig, digest ), priv.get_public_key() );
+   BOOST_CHECK_EQUAL( cache.size(), 2u );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( bounded ) try {
+   // one entry per shard
+   recovered_key_cache cache( 1 );
+
+   auto priv = get_private_key( "bob" );
+   for( uint32_t i = 0; i < 100; ++i ) {
+      auto digest = digest_type::hash( i );
+      BOOST_CHECK_EQUAL( cache.recover( priv.sign( digest ), digest ), priv.get_public_key() );
+   }
+   BOOST_CHECK_LE( cache.size(), 16u );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( disabled ) try {
+   recovered_key_cache cache( 0 );
+
+   auto priv = get_private_key( "carol" );
+   auto digest = digest_type::hash( std::string( "message" ) );
+   auto sig = priv.sign( digest );
+
+   BOOST_CHECK_EQUAL( cache.recover( sig, digest ), priv.get_public_key() );
+   BOOST_CHECK_EQUAL( cache.size(), 0u );
+   BOOST_CHECK( !cache.find( recovered_key_cache::make_key( sig, digest ) ) );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
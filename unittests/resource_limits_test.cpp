@@ -284,6 +284,39 @@ BOOST_AUTO_TEST_SUITE(resource_limits_test)
 
    } FC_LOG_AND_RETHROW();
 
+   BOOST_FIXTURE_TEST_CASE(enforce_account_ram_limit_batched, resource_limits_fixture) try {
+      const account_name account(1);
+      initialize_account(account);
+      set_account_limits(account, 1000, -1, -1 );
+      process_account_limit_updates();
+
+      // +300 -100 +200: 400 in total, never below 0
+      add_pending_ram_usage(account, 400, 0, 400);
+      BOOST_REQUIRE_EQUAL(get_account_ram_usage(account), 400);
+
+      // -500 +600 nets to +100 but underflows on the way, as the deltas one by one would
+      BOOST_REQUIRE_THROW(add_pending_ram_usage(account, 100, -500, 100), transaction_exception);
+      BOOST_REQUIRE_EQUAL(get_account_ram_usage(account), 400);
+
+      // -400 +400 nets to nothing and stays in range
+      add_pending_ram_usage(account, 0, -400, 0);
+      BOOST_REQUIRE_EQUAL(get_account_ram_usage(account), 400);
+
+      add_pending_ram_usage(account, 700, 0, 700);
+      BOOST_REQUIRE_THROW(verify_account_ram_usage(account), ram_usage_exceeded);
+   } FC_LOG_AND_RETHROW();
+
+   BOOST_FIXTURE_TEST_CASE(enforce_account_ram_limit_batched_overflow, resource_limits_fixture) try {
+      const account_name account(1);
+      initialize_account(account);
+      set_account_limits(account, -1, -1, -1 );
+      process_account_limit_updates();
+      add_pending_ram_usage(account, UINT64_MAX/2, generic_storage_usage_trace(0));
+      add_pending_ram_usage(account, UINT64_MAX/2, generic_storage_usage_trace(0));
+      // +2 -2 nets to nothing but overflows on the way
+      BOOST_REQUIRE_THROW(add_pending_ram_usage(account, 0, 0, 2), transaction_exception);
+   } FC_LOG_AND_RETHROW();
+
    BOOST_FIXTURE_TEST_CASE(enforce_account_ram_commitment, resource_limits_fixture) try {
       const int64_t limit = 1000;
       const int64_t commit = 600;
@@ -419,6 +452,86 @@ BOOST_AUTO_TEST_SUITE(resource_limits_test)
 
    } FC_LOG_AND_RETHROW()
 
+   /**
+    * Test that get_account_bandwidth_limits_ex returns what get_account_net_limit_ex and get_account_cpu_limit_ex return,
+    * and time them for the billed accounts of a transaction
+    */
+   BOOST_FIXTURE_TEST_CASE(get_account_bandwidth_limits_ex, resource_limits_fixture) try {
+      constexpr uint32_t accounts = 64;
+      constexpr uint32_t iterations = 20000;
+      for( uint32_t i = 1; i <= accounts; ++i ) {
+         const account_name account(i);
+         initialize_account(account);
+         set_account_limits(account, -1, i % 8 == 0 ? -1 : 1000 * i, i % 5 == 0 ? -1 : 2000 * i);
+      }
+      process_account_limit_updates();
+      for( uint32_t i = 1; i <= accounts; ++i ) {
+         add_transaction_usage({account_name(i)}, 10 * i, 20 * i, i);
+      }
+      process_block_usage(1);
+
+      auto check_equal = []( const std::pair<account_resource_limit, bool>& a, const std::pair<account_resource_limit, bool>& b ) {
+         BOOST_CHECK_EQUAL(a.first.used, b.first.used);
+         BOOST_CHECK_EQUAL(a.first.available, b.first.available);
+         BOOST_CHECK_EQUAL(a.first.max, b.first.max);
+         BOOST_CHECK_EQUAL(a.first.current_used, b.first.current_used);
+         BOOST_CHECK_EQUAL(a.first.last_usage_update_time.slot, b.first.last_usage_update_time.slot);
+         BOOST_CHECK_EQUAL(a.second, b.second);
+      };
+      const block_timestamp_type now(accounts + 10);
+      for( uint32_t greylist_limit : {1u, 10u, config::maximum_elastic_resource_multiplier} ) {
+         for( uint32_t i = 1; i <= accounts; ++i ) {
+            const account_name account(i);
+            const auto limits = get_account_bandwidth_limits_ex(account, greylist_limit, now);
+            check_equal(limits.net, get_account_net_limit_ex(account, greylist_limit, now));
+            check_equal(limits.cpu, get_account_cpu_limit_ex(account, greylist_limit, now));
+         }
+      }
+
+      int64_t sum = 0;
+      auto start = fc::time_point::now();
+      for( uint32_t n = 0; n < iterations; ++n ) {
+         const account_name account(n % accounts + 1);
+         sum += get_account_net_limit(account).first + get_account_cpu_limit(account).first;
+      }
+      const auto separate = fc::time_point::now() - start;
+      start = fc::time_point::now();
+      for( uint32_t n = 0; n < iterations; ++n ) {
+         const auto limits = get_account_bandwidth_limits_ex(account_name(n % accounts + 1));
+         sum -= limits.net.first.available + limits.cpu.first.available;
+      }
+      const auto together = fc::time_point::now() - start;
+      BOOST_CHECK_EQUAL(sum, 0);
+      BOOST_TEST_MESSAGE( "net and cpu limits of " << iterations << " accounts: separately " << separate.count()
+                          << "us, together " << together.count() << "us" );
+
+   } FC_LOG_AND_RETHROW()
+
+   /**
+    * Test that update_account_usage in the slot of the last usage leaves the usage unchanged
+    */
+   BOOST_FIXTURE_TEST_CASE(update_account_usage_same_slot, resource_limits_fixture) try {
+      const account_name account("acc");
+      initialize_account(account);
+      set_account_limits(account, -1, 1000, 1000);
+      process_account_limit_updates();
+
+      add_transaction_usage({account}, 100, 200, 10);
+      const auto before = get_account_bandwidth_limits_ex(account);
+      update_account_usage({account}, 10);
+      const auto after = get_account_bandwidth_limits_ex(account);
+      BOOST_CHECK_EQUAL(before.net.first.used, after.net.first.used);
+      BOOST_CHECK_EQUAL(before.cpu.first.used, after.cpu.first.used);
+
+      // a later slot still decays the usage
+      update_account_usage({account}, 20);
+      const auto decayed = get_account_bandwidth_limits_ex(account);
+      BOOST_CHECK_LT(decayed.net.first.used, before.net.first.used);
+      BOOST_CHECK_LT(decayed.cpu.first.used, before.cpu.first.used);
+      BOOST_CHECK_EQUAL(decayed.net.first.last_usage_update_time.slot, 20u);
+
+   } FC_LOG_AND_RETHROW()
+
    BOOST_AUTO_TEST_CASE(light_net_validation) try {
       tester main( setup_policy::preactivate_feature_and_new_bios );
       tester validator( setup_policy::none );
@@ -62,6 +62,7 @@ struct restart_from_block_log_test_fixture {
    tester   chain;
    uint32_t cutoff_block_num;
    bool     fix_irreversible_blocks = false;
+   bool     replay_trust_block_log = false;
    restart_from_block_log_test_fixture() {
       chain.create_account("replay1"_n);
       chain.produce_blocks(1);
@@ -82,6 +83,7 @@ struct restart_from_block_log_test_fixture {
    ~restart_from_block_log_test_fixture() {
       controller::config copied_config      = chain.get_config();
       copied_config.blog.fix_irreversible_blocks = this->fix_irreversible_blocks;
+      copied_config.replay_trust_block_log  = this->replay_trust_block_log;
       auto genesis                          = chain::block_log::extract_genesis_state(chain.get_config().blog.log_dir);
       BOOST_REQUIRE(genesis);
 
@@ -96,12 +98,14 @@ struct restart_from_block_log_test_fixture {
 
    
 
-void  light_validation_restart_from_block_log_test_case(bool do_prune, uint32_t stride) {
+void  light_validation_restart_from_block_log_test_case(bool do_prune, uint32_t stride, bool do_compact = false,
+                                                        bool zstd = false) {
 
    fc::temp_directory temp_dir;
    auto [ config, gen]  = tester::default_config(temp_dir);
    config.read_mode = db_read_mode::SPECULATIVE;
    config.blog.stride = stride;
+   config.blog.zstd_compression = zstd;
    tester chain(config, gen);
    chain.execute_setup_policy(setup_policy::full);
 
@@ -134,6 +138,18 @@ void  light_validation_restart_from_block_log_test_case(bool do_prune, uint32_t
       BOOST_REQUIRE_NO_THROW(block_log::repair_log(blocks_dir));
    }
 
+   if (do_compact) {
+      const auto size_before = boost::filesystem::file_size(blocks_dir / "blocks.log");
+      BOOST_CHECK_EQUAL(block_log::prune_and_compact(blocks_dir, blocks_dir / "old", 0, UINT32_MAX, fc::time_point::maximum(), 2), 1u);
+      BOOST_CHECK_LT(boost::filesystem::file_size(blocks_dir / "blocks.log"), size_before);
+      block_log::smoke_test(blocks_dir, 1);
+
+      block_log blog(chain.get_config().blog);
+      auto      block = blog.read_signed_block_by_num(trace->block_num);
+      BOOST_REQUIRE(block);
+      BOOST_CHECK(block->prune_state == signed_block::prune_state_type::incomplete);
+   }
+
    controller::config copied_config = chain.get_config();
    auto               genesis       = chain::block_log::extract_genesis_state(blocks_dir);
    BOOST_REQUIRE(genesis);
@@ -232,6 +248,10 @@ BOOST_FIXTURE_TEST_CASE(test_restart_from_block_log, restart_from_block_log_test
    BOOST_REQUIRE_NO_THROW(block_log::smoke_test(chain.get_config().blog.log_dir, 1));
 }
 
+BOOST_FIXTURE_TEST_CASE(test_restart_from_trusted_block_log, restart_from_block_log_test_fixture) {
+   replay_trust_block_log = true;
+}
+
 BOOST_FIXTURE_TEST_CASE(test_restart_from_trimmed_block_log, restart_from_block_log_test_fixture) {
    auto& config = chain.get_config();
    auto blocks_path = config.blog.log_dir;
@@ -260,6 +280,180 @@ BOOST_AUTO_TEST_CASE(test_light_validation_restart_from_block_log_with_pruned_tr
    light_validation_restart_from_block_log_test_case(do_prune, blocks_log_stride);
 }
 
+BOOST_AUTO_TEST_CASE(test_light_validation_restart_from_block_log_with_compacted_trx) {
+   bool do_prune = false;
+   uint32_t blocks_log_stride = UINT32_MAX;
+   light_validation_restart_from_block_log_test_case(do_prune, blocks_log_stride, true);
+}
+
+BOOST_AUTO_TEST_CASE(test_light_validation_restart_from_zstd_block_log_with_pruned_trx_and_split_log) {
+   if (!block_log::zstd_supported())
+      return;
+   bool do_prune = true;
+   uint32_t blocks_log_stride = 10;
+   light_validation_restart_from_block_log_test_case(do_prune, blocks_log_stride, false, true);
+}
+
+BOOST_AUTO_TEST_CASE(test_light_validation_restart_from_zstd_block_log_with_compacted_trx) {
+   if (!block_log::zstd_supported())
+      return;
+   bool do_prune = false;
+   uint32_t blocks_log_stride = UINT32_MAX;
+   light_validation_restart_from_block_log_test_case(do_prune, blocks_log_stride, true, true);
+}
+
+uint32_t block_file_version(const fc::path& block_file) {
+   fc::cfile file;
+   file.set_file_path(block_file);
+   file.open("rb");
+   uint32_t version = 0;
+   file.read(reinterpret_cast<char*>(&version), sizeof(version));
+   return version;
+}
+
+BOOST_AUTO_TEST_CASE(test_block_log_version_without_compression) {
+   fc::temp_directory temp_dir;
+   tester chain(
+         temp_dir,
+         [](controller::config& config) {
+            config.blog.stride = 10;
+         },
+         true);
+   chain.produce_blocks(25);
+   chain.close();
+
+   const auto& blocks_dir = chain.get_config().blog.log_dir;
+   BOOST_CHECK_EQUAL(block_file_version(blocks_dir / "blocks-1-10.log"), block_log::default_version);
+   BOOST_CHECK_EQUAL(block_file_version(blocks_dir / "blocks.log"), block_log::default_version);
+   block_log blog(chain.get_config().blog);
+   BOOST_CHECK_EQUAL(blog.version(), block_log::default_version);
+}
+
+BOOST_AUTO_TEST_CASE(test_zstd_block_log_round_trip) {
+   if (!block_log::zstd_supported())
+      return;
+   fc::temp_directory temp_dir;
+   tester chain(
+         temp_dir,
+         [](controller::config& config) {
+            config.blog.zstd_compression = true;
+         },
+         true);
+
+   std::vector<signed_block_ptr> blocks;
+   for (char c = 'a'; c < 'k'; ++c) {
+      chain.create_account(account_name(std::string("zstdacct") + c));
+      blocks.push_back(chain.produce_block());
+   }
+   chain.close();
+
+   controller::config config = chain.get_config();
+   BOOST_CHECK_EQUAL(block_file_version(config.blog.log_dir / "blocks.log"), block_log::max_supported_version);
+   BOOST_REQUIRE_NO_THROW(block_log::smoke_test(config.blog.log_dir, 1));
+   {
+      block_log blog(config.blog);
+      for (const auto& b : blocks) {
+         auto block = blog.read_signed_block_by_num(b->block_num());
+         BOOST_REQUIRE(block);
+         BOOST_CHECK(fc::raw::pack(*block) == fc::raw::pack(*b));
+         BOOST_CHECK(blog.read_block_id_by_num(b->block_num()) == b->calculate_id());
+      }
+   }
+
+   // replay from the compressed blocks, then keep appending to the version 5 file without compression
+   auto genesis = block_log::extract_genesis_state(config.blog.log_dir);
+   BOOST_REQUIRE(genesis);
+   remove_existing_states(config);
+   config.blog.zstd_compression = false;
+   tester restarted(config, *genesis);
+   BOOST_REQUIRE_NO_THROW(restarted.control->get_account("zstdacctj"_n));
+   blocks.push_back(restarted.produce_block());
+   restarted.close();
+
+   block_log blog(config.blog);
+   BOOST_CHECK_EQUAL(blog.version(), block_log::max_supported_version);
+   for (const auto& b : blocks) {
+      auto block = blog.read_signed_block_by_num(b->block_num());
+      BOOST_REQUIRE(block);
+      BOOST_CHECK(fc::raw::pack(*block) == fc::raw::pack(*b));
+   }
+}
+
+BOOST_AUTO_TEST_CASE(test_zstd_block_log_prune_transactions) {
+   if (!block_log::zstd_supported())
+      return;
+   fc::temp_directory temp_dir;
+   auto [ config, gen] = tester::default_config(temp_dir);
+   config.blog.zstd_compression = true;
+   tester chain(config, gen);
+   chain.execute_setup_policy(setup_policy::full);
+   deploy_test_api(chain);
+   chain.produce_blocks(2);
+   auto trace = push_test_cfd_transaction(chain);
+   chain.produce_blocks(2);
+   chain.close();
+
+   block_log blog(chain.get_config().blog);
+   const auto before = blog.read_signed_block_by_num(trace->block_num);
+   BOOST_REQUIRE(before);
+
+   std::vector<transaction_id_type> ids{trace->id};
+   BOOST_CHECK_EQUAL(blog.prune_transactions(trace->block_num, ids), 1u);
+   BOOST_CHECK(ids.empty());
+
+   const auto after = blog.read_signed_block_by_num(trace->block_num);
+   BOOST_REQUIRE(after);
+   BOOST_CHECK(after->prune_state == signed_block::prune_state_type::incomplete);
+   BOOST_CHECK(after->calculate_id() == before->calculate_id());
+   BOOST_REQUIRE_EQUAL(after->transactions.size(), before->transactions.size());
+   BOOST_CHECK(std::get<packed_transaction>(after->transactions.back().trx).id() == trace->id);
+   // the entries after the pruned one are untouched
+   BOOST_CHECK(blog.read_signed_block_by_num(trace->block_num + 1)->block_num() == trace->block_num + 1);
+   BOOST_REQUIRE_NO_THROW(block_log::smoke_test(chain.get_config().blog.log_dir, 1));
+}
+
+BOOST_AUTO_TEST_CASE(test_zstd_split_log_retained_files) {
+   if (!block_log::zstd_supported())
+      return;
+   namespace bfs = boost::filesystem;
+   fc::temp_directory temp_dir;
+   tester chain(
+         temp_dir,
+         [](controller::config& config) {
+            config.blog.archive_dir        = "";
+            config.blog.stride             = 20;
+            config.blog.max_retained_files = 2;
+            config.blog.zstd_compression   = true;
+         },
+         true);
+
+   std::vector<signed_block_ptr> blocks;
+   for (int i = 0; i < 85; ++i)
+      blocks.push_back(chain.produce_block());
+
+   const auto& blocks_dir = chain.get_config().blog.log_dir;
+   BOOST_CHECK(!bfs::exists(blocks_dir / "blocks-1-20.log"));
+   BOOST_CHECK(!bfs::exists(blocks_dir / "blocks-21-40.log"));
+   BOOST_CHECK_EQUAL(block_file_version(blocks_dir / "blocks-41-60.log"), block_log::max_supported_version);
+   BOOST_CHECK_EQUAL(block_file_version(blocks_dir / "blocks-61-80.log"), block_log::max_supported_version);
+
+   BOOST_CHECK(!chain.control->fetch_block_by_number(40));
+   for (uint32_t n : {41u, 60u, 61u, 80u, 81u}) {
+      auto block = chain.control->fetch_block_by_number(n);
+      BOOST_REQUIRE(block);
+      BOOST_CHECK(fc::raw::pack(*block) == fc::raw::pack(*blocks[n - blocks.front()->block_num()]));
+   }
+   chain.close();
+
+   block_log blog(chain.get_config().blog);
+   BOOST_CHECK_EQUAL(blog.version(), block_log::max_supported_version);
+   for (uint32_t n : {41u, 60u, 61u, 80u, 81u}) {
+      auto block = blog.read_signed_block_by_num(n);
+      BOOST_REQUIRE(block);
+      BOOST_CHECK(block->calculate_id() == blocks[n - blocks.front()->block_num()]->calculate_id());
+   }
+}
+
 BOOST_AUTO_TEST_CASE(test_split_log) {
    namespace bfs = boost::filesystem;
    fc::temp_directory temp_dir;
@@ -457,6 +651,91 @@ BOOST_AUTO_TEST_CASE(test_restart_without_blocks_log_file) {
    from_block_log_chain.produce_blocks(10);
 }
 
+BOOST_AUTO_TEST_CASE(test_export_import_chunks) {
+   namespace bfs = boost::filesystem;
+   fc::temp_directory temp_dir;
+
+   const uint32_t stride = 20;
+
+   tester chain(temp_dir, [](controller::config& config) {}, true);
+   chain.produce_blocks(75);
+   auto blocks_dir = chain.get_config().blog.log_dir;
+   chain.close();
+
+   auto chunks_dir = temp_dir.path() / "chunks";
+   auto chunks     = block_log::export_chunks(blocks_dir, chunks_dir, stride);
+   BOOST_REQUIRE_EQUAL(chunks.size(), 3u);
+   BOOST_CHECK_EQUAL(chunks[1].first_block_num, 21u);
+   BOOST_CHECK_EQUAL(chunks[1].last_block_num, 40u);
+   BOOST_CHECK(bfs::exists(chunks_dir / block_log::chunk_manifest_name));
+   BOOST_CHECK(bfs::exists(chunks_dir / (chunks[1].log_hash.str() + ".log")));
+   BOOST_CHECK(bfs::exists(chunks_dir / (chunks[1].index_hash.str() + ".index")));
+
+   auto retained_dir = temp_dir.path() / "retained";
+   BOOST_CHECK_EQUAL(block_log::import_chunks(chunks_dir, retained_dir, 2), 3u);
+   BOOST_CHECK(bfs::exists(retained_dir / "blocks-1-20.log"));
+   BOOST_CHECK(bfs::exists(retained_dir / "blocks-41-60.index"));
+   // already imported chunks are skipped
+   BOOST_CHECK_EQUAL(block_log::import_chunks(chunks_dir, retained_dir, 2), 0u);
+
+   // a chunk which does not start at block 1 is a standalone block log
+   auto single_dir = temp_dir.path() / "single";
+   bfs::create_directories(single_dir);
+   bfs::copy_file(retained_dir / "blocks-21-40.log", single_dir / "blocks.log");
+   bfs::copy_file(retained_dir / "blocks-21-40.index", single_dir / "blocks.index");
+   block_log::smoke_test(single_dir, 1);
+   {
+      block_log single_log({ .log_dir = single_dir });
+      BOOST_CHECK_EQUAL(single_log.first_block_num(), 21u);
+      BOOST_CHECK_EQUAL(single_log.read_signed_block_by_num(30)->block_num(), 30u);
+   }
+
+   // a chunk whose content does not match its hash is rejected
+   bfs::remove(retained_dir / "blocks-41-60.log");
+   fc::cfile logfile;
+   logfile.set_file_path(chunks_dir / (chunks[2].log_hash.str() + ".log"));
+   logfile.open("ab");
+   const char random_data[] = "12345678";
+   logfile.write(random_data, sizeof(random_data));
+   logfile.close();
+   BOOST_CHECK_THROW(block_log::import_chunks(chunks_dir, retained_dir, 2), block_log_exception);
+   BOOST_CHECK(!bfs::exists(retained_dir / "blocks-41-60.log"));
+}
+
+BOOST_AUTO_TEST_CASE(test_trx_index) {
+   namespace bfs = boost::filesystem;
+   fc::temp_directory temp_dir;
+
+   tester chain(
+         temp_dir,
+         [](controller::config& config) {
+            config.blog.stride    = 10;
+            config.blog.trx_index = true;
+         },
+         true);
+   auto first_trace = chain.create_account("alice"_n);
+   chain.produce_blocks(15);
+   auto second_trace = chain.create_account("bob"_n);
+   chain.produce_blocks(5);
+
+   BOOST_REQUIRE(chain.control->has_block_log_trx_index());
+   BOOST_CHECK_EQUAL(*chain.control->fetch_irreversible_block_num_by_trx_id(first_trace->id), first_trace->block_num);
+   BOOST_CHECK_EQUAL(*chain.control->fetch_irreversible_block_num_by_trx_id(second_trace->id), second_trace->block_num);
+   BOOST_CHECK(!chain.control->fetch_irreversible_block_num_by_trx_id(transaction_id_type()));
+
+   auto blocks_dir = chain.get_config().blog.log_dir;
+   chain.close();
+
+   // the index is rebuilt from the block log and the retained block files
+   block_log::construct_trx_index(blocks_dir);
+   block_log::config_type config;
+   config.log_dir   = blocks_dir;
+   config.trx_index = true;
+   block_log blog(config);
+   BOOST_CHECK_EQUAL(*blog.find_block_num_by_trx_id(first_trace->id), first_trace->block_num);
+   BOOST_CHECK_EQUAL(*blog.find_block_num_by_trx_id(second_trace->id), second_trace->block_num);
+}
+
 BOOST_FIXTURE_TEST_CASE(auto_fix_with_incomplete_head,restart_from_block_log_test_fixture) {
    auto& config = chain.get_config();
    auto blocks_path = config.blog.log_dir;
@@ -502,7 +781,7 @@ BOOST_FIXTURE_TEST_CASE(auto_fix_with_corrupted_log_and_index,restart_from_block
 
 struct blocklog_version_setter {
    blocklog_version_setter(uint32_t ver) { block_log::set_version(ver); };
-   ~blocklog_version_setter() { block_log::set_version(block_log::max_supported_version); };
+   ~blocklog_version_setter() { block_log::set_version(block_log::default_version); };
 };
 
 BOOST_AUTO_TEST_CASE(test_split_from_v1_log) {
@@ -570,4 +849,8 @@ BOOST_AUTO_TEST_CASE(test_trim_blocklog_front_v3) {
    trim_blocklog_front(3);
 }
 
+BOOST_AUTO_TEST_CASE(test_trim_blocklog_front_v4) {
+   trim_blocklog_front(4);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,82 @@
+#include <eosio/chain/generated_transaction_object.hpp>
+#include <eosio/chain/scheduled_transaction_queue.hpp>
+#include <eosio/testing/tester.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::testing;
+
+namespace {
+
+transaction_id_type push_delayed_newaccount( tester& chain, account_name a, uint32_t delay_sec ) {
+   signed_transaction trx;
+   account_name creator = config::system_account_name;
+   trx.actions.emplace_back( vector<permission_level>{{creator,config::active_name}},
+                             newaccount{
+                                .creator  = creator,
+                                .name     = a,
+                                .owner    = authority( chain.get_public_key( a, "owner" ) ),
+                                .active   = authority( chain.get_public_key( a, "active" ) )
+                             });
+   chain.set_transaction_headers( trx );
+   trx.delay_sec = delay_sec;
+   trx.sign( chain.get_private_key( creator, "active" ), chain.control->get_chain_id() );
+   chain.push_transaction( trx );
+   return trx.id();
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(scheduled_transaction_queue_tests)
+
+BOOST_AUTO_TEST_CASE( due_prefix ) try {
+   tester chain;
+   chain.produce_block();
+
+   const auto a = push_delayed_newaccount( chain, "alice"_n, 1 );
+   const auto b = push_delayed_newaccount( chain, "bob"_n, 1 );
+   push_delayed_newaccount( chain, "carol"_n, 10 );
+
+   {
+      scheduled_transaction_queue queue( chain.control->db(), chain.control->pending_block_time() );
+      BOOST_CHECK_EQUAL( queue.depth(), 3u );
+      BOOST_CHECK( !queue.next() );
+   }
+
+   chain.produce_block();
+   chain.produce_block();
+
+   // a chunk of one transaction forces a refill for every transaction
+   scheduled_transaction_queue queue( chain.control->db(), chain.control->pending_block_time(), 1 );
+   BOOST_CHECK_EQUAL( queue.depth(), 3u );
+   auto first = queue.next();
+   BOOST_REQUIRE( first );
+   BOOST_CHECK_EQUAL( first->trx_id, a );
+   auto second = queue.next();
+   BOOST_REQUIRE( second );
+   BOOST_CHECK_EQUAL( second->trx_id, b );
+   BOOST_CHECK( !queue.next() );
+   BOOST_CHECK( !queue.next() );
+   BOOST_CHECK_EQUAL( queue.num_published(), 0u );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( executed_transactions_are_skipped ) try {
+   tester chain;
+   chain.produce_block();
+
+   const auto a = push_delayed_newaccount( chain, "alice"_n, 1 );
+   const auto b = push_delayed_newaccount( chain, "bob"_n, 1 );
+   chain.produce_block();
+   chain.produce_block();
+
+   scheduled_transaction_queue queue( chain.control->db(), chain.control->pending_block_time(), 1 );
+   auto first = queue.next();
+   BOOST_REQUIRE( first );
+   BOOST_CHECK_EQUAL( first->trx_id, a );
+   chain.control->push_scheduled_transaction( b, fc::time_point::maximum(), 0, false );
+   BOOST_CHECK( !queue.next() );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
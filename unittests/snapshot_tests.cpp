@@ -709,4 +709,106 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_kv_snapshot, SNAPSHOT_SUITE, snapshot_suites)
    }
 }
 
+BOOST_AUTO_TEST_CASE(test_exhaustive_compressed_snapshot)
+{
+   exhaustive_snapshot<compressed_snapshot_suite>(eosio::chain::backing_store_type::CHAINBASE,
+                                                  eosio::chain::backing_store_type::ROCKSDB);
+}
+
+BOOST_AUTO_TEST_CASE(test_compressed_snapshot_integrity_hash) try {
+   tester chain;
+   chain.create_account("snapshot"_n);
+   chain.produce_blocks(1);
+   chain.set_code("snapshot"_n, contracts::snapshot_test_wasm());
+   chain.set_abi("snapshot"_n, contracts::snapshot_test_abi().data());
+   chain.produce_blocks(1);
+   chain.control->abort_block();
+
+   // the hash computed while writing matches the separate integrity pass
+   fc::sha256::encoder enc;
+   auto writer = compressed_snapshot_suite::get_writer(&enc);
+   chain.control->write_snapshot(writer);
+   auto snapshot = compressed_snapshot_suite::finalize(writer);
+   BOOST_REQUIRE_EQUAL(enc.result().str(), chain.control->calculate_integrity_hash().str());
+
+   std::istringstream compressed_in(snapshot);
+   BOOST_CHECK(compressed_istream_snapshot_reader::is_compressed_snapshot(compressed_in));
+   BOOST_CHECK(compressed_in.tellg() == std::streampos(0));
+
+   auto plain_writer = buffered_snapshot_suite::get_writer();
+   chain.control->write_snapshot(plain_writer);
+   std::istringstream plain_in(buffered_snapshot_suite::finalize(plain_writer));
+   BOOST_CHECK(!compressed_istream_snapshot_reader::is_compressed_snapshot(plain_in));
+
+   auto reader = compressed_snapshot_suite::get_reader(snapshot);
+   reader->validate();
+   snapshotted_tester snap_chain(chain.get_config(), reader, 0);
+   verify_integrity_hash<compressed_snapshot_suite>(*chain.control, *snap_chain.control);
+
+   // a truncated snapshot has no trailer
+   BOOST_CHECK_THROW(compressed_snapshot_suite::get_reader(snapshot.substr(0, snapshot.size() - 4))->validate(), snapshot_exception);
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE(test_delta_snapshot) try {
+   tester chain;
+   chain.create_account("snapshot"_n);
+   chain.produce_blocks(1);
+   chain.set_code("snapshot"_n, contracts::snapshot_test_wasm());
+   chain.set_abi("snapshot"_n, contracts::snapshot_test_abi().data());
+   chain.produce_blocks(1);
+   chain.control->abort_block();
+
+   auto base_writer = buffered_snapshot_suite::get_writer();
+   chain.control->write_snapshot(base_writer);
+   auto base = buffered_snapshot_suite::finalize(base_writer);
+
+   chain.create_account("snapshot1"_n);
+   chain.push_action("snapshot"_n, "increment"_n, "snapshot"_n, mutable_variant_object()
+      ( "value", 1 )
+   );
+   chain.produce_blocks(2);
+   chain.control->abort_block();
+
+   auto full_writer = buffered_snapshot_suite::get_writer();
+   chain.control->write_snapshot(full_writer);
+   auto full = buffered_snapshot_suite::finalize(full_writer);
+
+   std::istringstream base_for_write(base);
+   std::ostringstream delta_out;
+   auto delta_writer = std::make_shared<delta_ostream_snapshot_writer>(delta_out, base_for_write);
+   chain.control->write_snapshot(delta_writer);
+   delta_writer->finalize();
+   auto delta = delta_out.str();
+   BOOST_CHECK_LT(delta.size(), full.size());
+
+   std::istringstream delta_in(delta);
+   BOOST_CHECK(delta_istream_snapshot_reader::is_delta_snapshot(delta_in));
+   std::istringstream base_in(base);
+   auto reader = std::make_shared<delta_istream_snapshot_reader>(delta_in, base_in);
+   reader->validate();
+   snapshotted_tester snap_chain(chain.get_config(), reader, 0);
+   verify_integrity_hash<buffered_snapshot_suite>(*chain.control, *snap_chain.control);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE(test_setup_snapshot_fixture) try {
+   tester set_up(setup_policy::full);
+   set_up.control->abort_block();
+
+   validating_tester chain(from_setup_snapshot);
+   BOOST_REQUIRE_EQUAL(chain.control->head_block_num(), set_up.control->head_block_num());
+   BOOST_REQUIRE_EQUAL(chain.control->db().get<account_metadata_object, by_name>("eosio"_n).code_hash,
+                       set_up.control->db().get<account_metadata_object, by_name>("eosio"_n).code_hash);
+   BOOST_REQUIRE_EQUAL(chain.validating_node->head_block_id(), chain.control->head_block_id());
+
+   // a second tester of the policy starts from the same snapshot, independent of the first
+   tester other(from_setup_snapshot);
+   chain.create_account("snapshot"_n);
+   chain.produce_blocks(2);
+   BOOST_REQUIRE_EQUAL(other.control->head_block_num(), set_up.control->head_block_num());
+   BOOST_REQUIRE(chain.control->db().find<account_object, by_name>("snapshot"_n));
+   BOOST_REQUIRE(!other.control->db().find<account_object, by_name>("snapshot"_n));
+   BOOST_REQUIRE(chain.validate());
+} FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,124 @@
+#include <eosio/chain/state_access_recorder.hpp>
+#include <eosio/testing/tester.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <contracts.hpp>
+
+#include <fstream>
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::testing;
+
+using mvo = fc::mutable_variant_object;
+
+BOOST_AUTO_TEST_SUITE(state_access_recorder_tests)
+
+BOOST_AUTO_TEST_CASE( conflict_graph ) try {
+   const name code = "token"_n;
+   const name table = "accounts"_n;
+   auto make_trx = []( uint64_t n, transaction_state_accesses a ) {
+      a.normalize();
+      return state_access_recorder::recorded_transaction{ digest_type::hash( n ), std::move(a) };
+   };
+
+   vector<state_access_recorder::recorded_transaction> trxs;
+   transaction_state_accesses a;
+   // 0: writes alice
+   a.add_db_read( code, "alice"_n, table, 1 );
+   a.add_db_write( code, "alice"_n, table, 1 );
+   trxs.push_back( make_trx( 0, std::move(a) ) );
+   // 1: writes bob, independent of 0
+   a = {};
+   a.add_db_write( code, "bob"_n, table, 1 );
+   trxs.push_back( make_trx( 1, std::move(a) ) );
+   // 2: reads alice, depends on 0
+   a = {};
+   a.add_db_read( code, "alice"_n, table, 1 );
+   a.add_db_read( code, "alice"_n, table, 1 );
+   trxs.push_back( make_trx( 2, std::move(a) ) );
+   // 3: writes alice, depends on the last writer 0 and the reader 2
+   a = {};
+   a.add_db_write( code, "alice"_n, table, 1 );
+   trxs.push_back( make_trx( 3, std::move(a) ) );
+   // 4: iterates the table of bob, depends on 1
+   a = {};
+   a.add_db_range_read( code, "bob"_n, table );
+   trxs.push_back( make_trx( 4, std::move(a) ) );
+   // 5: writes another row of the table of bob, depends on 4
+   a = {};
+   a.add_db_write( code, "bob"_n, table, 2 );
+   trxs.push_back( make_trx( 5, std::move(a) ) );
+   // 6: kv accesses do not conflict with table rows
+   a = {};
+   a.add_kv_write( code, "bob", 3 );
+   trxs.push_back( make_trx( 6, std::move(a) ) );
+
+   BOOST_CHECK_EQUAL( trxs[2].second.reads.size(), 1u ); // normalized
+
+   auto g = state_access_recorder::build_conflict_graph( 7, block_id_type(), trxs );
+   BOOST_CHECK_EQUAL( g.block_num, 7u );
+   BOOST_REQUIRE_EQUAL( g.trxs.size(), trxs.size() );
+   const vector<std::pair<uint32_t, uint32_t>> expected_edges{ {0, 2}, {0, 3}, {2, 3}, {1, 4}, {4, 5} };
+   BOOST_CHECK( g.edges == expected_edges );
+   BOOST_CHECK_EQUAL( g.longest_chain, 3u );
+
+   // empty block
+   auto empty = state_access_recorder::build_conflict_graph( 8, block_id_type(), {} );
+   BOOST_CHECK( empty.edges.empty() );
+   BOOST_CHECK_EQUAL( empty.longest_chain, 0u );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( record_token_transfers ) try {
+   fc::temp_directory tempdir;
+   const auto log_file = tempdir.path() / "state_access.log";
+   tester chain( tempdir, [&]( controller::config& cfg ) { cfg.state_access_log = log_file; }, true );
+   chain.execute_setup_policy( setup_policy::full );
+
+   chain.create_accounts( { "eosio.token"_n, "alice"_n, "bob"_n, "carol"_n, "dave"_n } );
+   chain.set_code( "eosio.token"_n, contracts::eosio_token_wasm() );
+   chain.set_abi( "eosio.token"_n, contracts::eosio_token_abi().data() );
+   chain.push_action( "eosio.token"_n, "create"_n, "eosio.token"_n,
+                      mvo()( "issuer", "eosio.token" )( "maximum_supply", "1000.0000 TOK" ) );
+   for( auto to : { "alice"_n, "carol"_n } ) {
+      chain.push_action( "eosio.token"_n, "issue"_n, "eosio.token"_n,
+                         mvo()( "to", "eosio.token" )( "quantity", "100.0000 TOK" )( "memo", "" ) );
+      chain.push_action( "eosio.token"_n, "transfer"_n, "eosio.token"_n,
+                         mvo()( "from", "eosio.token" )( "to", to )( "quantity", "100.0000 TOK" )( "memo", "" ) );
+   }
+   chain.produce_block();
+
+   auto transfer = [&]( name from, name to ) {
+      return chain.push_action( "eosio.token"_n, "transfer"_n, from,
+                                mvo()( "from", from )( "to", to )( "quantity", "1.0000 TOK" )( "memo", "" ) )->id;
+   };
+   const auto t0 = transfer( "alice"_n, "bob"_n );
+   const auto t1 = transfer( "carol"_n, "dave"_n ); // independent of t0
+   const auto t2 = transfer( "bob"_n, "carol"_n );  // conflicts with both
+   chain.produce_block();
+
+   std::ifstream in( log_file.generic_string() );
+   std::string line, last;
+   uint32_t lines = 0;
+   while( std::getline( in, line ) ) {
+      last = line;
+      ++lines;
+   }
+   BOOST_REQUIRE_GE( lines, 2u ); // one line per committed block
+
+   block_conflict_graph g;
+   fc::from_variant( fc::json::from_string( last ), g );
+   BOOST_CHECK_EQUAL( g.block_num, chain.control->head_block_num() );
+   BOOST_CHECK_EQUAL( g.id, chain.control->head_block_id() );
+   const vector<transaction_id_type> expected_trxs{ t0, t1, t2 };
+   BOOST_CHECK( g.trxs == expected_trxs );
+   const vector<std::pair<uint32_t, uint32_t>> expected_edges{ {0, 2}, {1, 2} };
+   BOOST_CHECK( g.edges == expected_edges );
+   BOOST_CHECK_EQUAL( g.longest_chain, 2u );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
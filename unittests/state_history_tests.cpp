@@ -2,6 +2,7 @@
 #include <contracts.hpp>
 #include <eosio/chain/authorization_manager.hpp>
 #include <eosio/state_history/create_deltas.hpp>
+#include <eosio/state_history/filter.hpp>
 #include <eosio/state_history/log.hpp>
 #include <eosio/state_history/trace_converter.hpp>
 #include <utilities.hpp>
@@ -143,6 +144,51 @@ BOOST_AUTO_TEST_CASE(test_trace_converter) {
    BOOST_CHECK(std::holds_alternative<prunable_data_type::none>(get_prunable_data_from_traces_bin(cfd_entry, cfd_trace->id)));
 }
 
+BOOST_AUTO_TEST_CASE(test_packed_trace_cache) {
+
+   tester chain;
+   using namespace eosio::state_history;
+
+   transaction_trace_cache                 cache;
+   packed_trace_cache                      packed_cache;
+   std::map<uint32_t, eosio::chain::bytes> entries, packed_entries;
+
+   chain.control->applied_transaction.connect(
+       [&](std::tuple<const transaction_trace_ptr&, const packed_transaction_ptr&> t) {
+          cache.add_transaction(std::get<0>(t), std::get<1>(t));
+          packed_cache.add_transaction(chain.control->db(), true, compression_type::zlib, std::get<0>(t), std::get<1>(t));
+       });
+
+   chain.control->accepted_block.connect([&](const block_state_ptr& bs) {
+      fc::datastream<std::vector<char>> strm;
+      trace_converter::pack(strm, chain.control->db(), true, cache.prepare_traces(bs), compression_type::zlib);
+      entries[bs->block_num]        = strm.storage();
+      packed_entries[bs->block_num] = packed_cache.prepare_entry(bs, compression_type::zlib);
+   });
+
+   chain.control->block_start.connect([&](uint32_t block_num) {
+      cache.clear();
+      packed_cache.clear();
+   });
+
+   deploy_test_api(chain);
+   auto cfd_trace = push_test_cfd_transaction(chain);
+   chain.produce_blocks(1);
+
+   // both entries unpack to the same traces
+   BOOST_REQUIRE_EQUAL(entries.size(), packed_entries.size());
+   for (auto& [block_num, entry] : entries) {
+      auto& packed_entry = packed_entries.at(block_num);
+      std::vector<transaction_trace> traces, packed_traces;
+      fc::datastream<const char*>    strm(entry.data(), entry.size()), packed_strm(packed_entry.data(), packed_entry.size());
+      trace_converter::unpack(strm, traces);
+      trace_converter::unpack(packed_strm, packed_traces);
+      BOOST_CHECK(fc::raw::pack(traces) == fc::raw::pack(packed_traces));
+   }
+   BOOST_CHECK(!std::holds_alternative<prunable_data_type::none>(
+       get_prunable_data_from_traces_bin(packed_entries.at(cfd_trace->block_num), cfd_trace->id)));
+}
+
 BOOST_AUTO_TEST_CASE(test_trace_log) {
    namespace bfs = boost::filesystem;
    tester chain;
@@ -153,7 +199,7 @@ BOOST_AUTO_TEST_CASE(test_trace_log) {
 
    chain.control->applied_transaction.connect(
        [&](std::tuple<const transaction_trace_ptr&, const packed_transaction_ptr&> t) {
-          log.add_transaction(std::get<0>(t), std::get<1>(t));
+          log.add_transaction(chain.control->db(), std::get<0>(t), std::get<1>(t));
        });
 
    chain.control->accepted_block.connect([&](const block_state_ptr& bs) { log.store(chain.control->db(), bs); });
@@ -192,7 +238,7 @@ BOOST_AUTO_TEST_CASE(test_trace_log_with_transaction_extensions) {
 
    c.control->applied_transaction.connect(
        [&](std::tuple<const transaction_trace_ptr&, const packed_transaction_ptr&> t) {
-          log.add_transaction(std::get<0>(t), std::get<1>(t));
+          log.add_transaction(c.control->db(), std::get<0>(t), std::get<1>(t));
        });
 
    c.control->accepted_block.connect([&](const block_state_ptr& bs) { log.store(c.control->db(), bs); });
@@ -262,6 +308,98 @@ BOOST_AUTO_TEST_CASE(test_chain_state_log) {
    BOOST_CHECK_NO_THROW(from_bin(deltas, deltas_bin));
 }
 
+BOOST_AUTO_TEST_CASE(test_chain_state_log_zstd) {
+   if (!eosio::state_history::zstd_supported())
+      return;
+
+   scoped_temp_path state_history_dir;
+   fc::create_directories(state_history_dir.path);
+   eosio::state_history_config config{ .log_dir = state_history_dir.path };
+
+   std::map<uint32_t, eosio::chain::bytes> entries;
+   {
+      tester chain;
+      eosio::state_history_chain_state_log log(config);
+      chain.control->accepted_block.connect([&](const block_state_ptr& block_state) {
+         log.store(chain.control->kv_db(), block_state);
+      });
+      chain.produce_blocks(10);
+      for (auto block_num = log.begin_block(); block_num < log.end_block(); ++block_num)
+         entries[block_num] = log.get_log_entry(block_num);
+   }
+   BOOST_REQUIRE(!entries.empty());
+
+   config.chain_state_compression = eosio::state_history::log_compression::zstd;
+   BOOST_CHECK_EQUAL(eosio::state_history_chain_state_log::convert(config), entries.size());
+
+   {
+      eosio::state_history_chain_state_log log(config);
+      for (const auto& [block_num, entry] : entries)
+         BOOST_CHECK(log.get_log_entry(block_num) == entry);
+   }
+
+   // back to zlib
+   config.chain_state_compression = eosio::state_history::log_compression::zlib;
+   BOOST_CHECK_EQUAL(eosio::state_history_chain_state_log::convert(config), entries.size());
+   eosio::state_history_chain_state_log zlib_log(config);
+   for (const auto& [block_num, entry] : entries)
+      BOOST_CHECK(zlib_log.get_log_entry(block_num) == entry);
+}
+
+BOOST_AUTO_TEST_CASE(test_chain_state_log_row_diffs) {
+   scoped_temp_path full_dir, diff_dir;
+   fc::create_directories(full_dir.path);
+   fc::create_directories(diff_dir.path);
+   eosio::state_history_config diff_config{ .log_dir = diff_dir.path, .chain_state_row_diff_interval = 5 };
+
+   std::map<uint32_t, eosio::chain::bytes> entries;
+   {
+      tester chain;
+      eosio::state_history_chain_state_log full_log({ .log_dir = full_dir.path });
+      eosio::state_history_chain_state_log diff_log(diff_config);
+      chain.control->accepted_block.connect([&](const block_state_ptr& block_state) {
+         full_log.store(chain.control->kv_db(), block_state);
+         diff_log.store(chain.control->kv_db(), block_state);
+      });
+
+      chain.create_accounts({ "eosio.token"_n, "alice"_n, "bob"_n });
+      chain.set_code("eosio.token"_n, contracts::eosio_token_wasm());
+      chain.set_abi("eosio.token"_n, contracts::eosio_token_abi().data());
+      chain.push_action("eosio.token"_n, "create"_n, "eosio.token"_n,
+                        mutable_variant_object()("issuer", "eosio.token")("maximum_supply", "1000.0000 TOK"));
+      chain.push_action("eosio.token"_n, "issue"_n, "eosio.token"_n,
+                        mutable_variant_object()("to", "eosio.token")("quantity", "100.0000 TOK")("memo", ""));
+      chain.produce_block();
+      // the same balances are modified by each block
+      for (int i = 0; i < 12; ++i) {
+         chain.push_action("eosio.token"_n, "transfer"_n, "eosio.token"_n,
+                           mutable_variant_object()("from", "eosio.token")("to", "alice")("quantity", "1.0000 TOK")("memo", ""));
+         chain.produce_block();
+      }
+
+      BOOST_REQUIRE_EQUAL(diff_log.end_block(), full_log.end_block());
+      for (auto block_num = full_log.begin_block(); block_num < full_log.end_block(); ++block_num) {
+         entries[block_num] = full_log.get_log_entry(block_num);
+         BOOST_CHECK(diff_log.get_log_entry(block_num) == entries[block_num]);
+      }
+      BOOST_CHECK_LT(boost::filesystem::file_size(diff_dir.path / "chain_state_history.log"),
+                     boost::filesystem::file_size(full_dir.path / "chain_state_history.log"));
+   }
+
+   // rebuilt without the entries cached while writing, newest first
+   {
+      eosio::state_history_chain_state_log log(diff_config);
+      for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+         BOOST_CHECK(log.get_log_entry(it->first) == it->second);
+   }
+
+   // converted to full rows
+   diff_config.chain_state_row_diff_interval = 0;
+   BOOST_CHECK_EQUAL(eosio::state_history_chain_state_log::convert(diff_config), entries.size());
+   eosio::state_history_chain_state_log log(diff_config);
+   for (const auto& [block_num, entry] : entries)
+      BOOST_CHECK(log.get_log_entry(block_num) == entry);
+}
 
 struct state_history_tester_logs  {
    state_history_tester_logs(const eosio::state_history_config& config) 
@@ -276,7 +414,7 @@ struct state_history_tester : state_history_tester_logs, tester {
    : state_history_tester_logs(config), tester ([&](eosio::chain::controller& control) {
       control.applied_transaction.connect(
        [&](std::tuple<const transaction_trace_ptr&, const packed_transaction_ptr&> t) {
-          traces_log.add_transaction(std::get<0>(t), std::get<1>(t));
+          traces_log.add_transaction(control.db(), std::get<0>(t), std::get<1>(t));
        });
 
       control.accepted_block.connect([&](const block_state_ptr& bs) { 
@@ -287,6 +425,96 @@ struct state_history_tester : state_history_tester_logs, tester {
    }) {}
 };
 
+BOOST_AUTO_TEST_CASE(test_block_filter) {
+   scoped_temp_path state_history_dir;
+   fc::create_directories(state_history_dir.path);
+   state_history_tester chain({ .log_dir = state_history_dir.path });
+
+   chain.create_account("tester"_n);
+   chain.set_code("tester"_n, contracts::get_table_test_wasm());
+   chain.set_abi("tester"_n, contracts::get_table_test_abi().data());
+   chain.produce_block();
+
+   chain.push_action("tester"_n, "addhashobj"_n, "tester"_n, mutable_variant_object()("hashinput", "hello"));
+   auto trace = chain.push_action("tester"_n, "addnumobj"_n, "tester"_n, mutable_variant_object()("input", 2));
+   chain.create_account("other"_n);
+   chain.produce_block();
+
+   eosio::state_history::get_blocks_request_v2 req;
+   req.filter_contracts = { "tester"_n };
+   req.filter_actions   = { "addnumobj"_n };
+   req.filter_tables    = { "numobjs"_n };
+   eosio::state_history::block_filter filter(req);
+
+   auto traces_bin = filter.filter_traces(chain.traces_log.get_log_entry(trace->block_num));
+   std::vector<eosio::ship_protocol::transaction_trace> traces;
+   eosio::input_stream traces_stream{traces_bin.data(), traces_bin.data() + traces_bin.size()};
+   BOOST_REQUIRE_NO_THROW(from_bin(traces, traces_stream));
+   BOOST_REQUIRE_EQUAL(traces.size(), 1);
+   auto& trace_v0 = std::get<eosio::ship_protocol::transaction_trace_v0>(traces[0]);
+   BOOST_CHECK(trace_v0.id == trace->id);
+   for (auto& at : trace_v0.action_traces)
+      BOOST_CHECK(std::get<eosio::ship_protocol::action_trace_v1>(at).act.name.value == "addnumobj"_n.to_uint64_t());
+
+   auto deltas_bin = filter.filter_deltas(chain.chain_state_log.get_log_entry(trace->block_num));
+   state_history_abi_serializer serializer(chain);
+   auto deltas = serializer.deserialize(deltas_bin, "table_delta[]").get_array();
+   BOOST_REQUIRE(!deltas.empty());
+   for (auto& delta : deltas) {
+      auto& delta_obj = delta.get_array()[1].get_object();
+      BOOST_CHECK(delta_obj["name"].as_string() != "account");
+      if (delta_obj["name"].as_string() != "contract_row")
+         continue;
+      for (auto& row : delta_obj["rows"].get_array()) {
+         auto  row_bin = row.get_object()["data"].as<eosio::chain::bytes>();
+         auto  contract_row = serializer.deserialize(row_bin, "contract_row");
+         auto& row_obj = contract_row.get_array()[1].get_object();
+         BOOST_CHECK_EQUAL(row_obj["code"].as_string(), "tester");
+         BOOST_CHECK_EQUAL(row_obj["table"].as_string(), "numobjs");
+      }
+   }
+
+   // nothing matches
+   req.filter_scopes = { "nobody"_n };
+   BOOST_CHECK(eosio::state_history::block_filter(req).filter_deltas(chain.chain_state_log.get_log_entry(trace->block_num)).empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_table_index) {
+   scoped_temp_path state_history_dir;
+   fc::create_directories(state_history_dir.path);
+   eosio::state_history_config config{ .log_dir = state_history_dir.path, .chain_state_table_index = true };
+   uint32_t                    numobjs_block = 0;
+   {
+      state_history_tester chain(config);
+      chain.create_account("tester"_n);
+      chain.set_code("tester"_n, contracts::get_table_test_wasm());
+      chain.set_abi("tester"_n, contracts::get_table_test_abi().data());
+      chain.produce_block();
+
+      numobjs_block = chain.push_action("tester"_n, "addnumobj"_n, "tester"_n, mutable_variant_object()("input", 2))->block_num;
+      chain.produce_blocks(3);
+
+      auto index = chain.chain_state_log.get_table_index();
+      BOOST_REQUIRE(index);
+      BOOST_CHECK_EQUAL(index->end_block(), chain.chain_state_log.end_block());
+      auto blocks = index->find_blocks("tester"_n, "numobjs"_n, numobjs_block - 1, index->end_block(), 10);
+      BOOST_REQUIRE_EQUAL(blocks.size(), 1);
+      BOOST_CHECK_EQUAL(blocks[0], numobjs_block);
+      BOOST_CHECK(index->changed(numobjs_block, "tester"_n, "numobjs"_n));
+      BOOST_CHECK(!index->changed(numobjs_block + 1, "tester"_n, "numobjs"_n));
+      BOOST_CHECK(!index->changed(numobjs_block, "tester"_n, "hashobjs"_n));
+
+      auto deltas = chain.chain_state_log.get_log_entry(numobjs_block);
+      BOOST_CHECK(eosio::state_history::changed_tables(deltas).count({"tester"_n, "numobjs"_n}));
+   }
+
+   // an index lost after a crash is rebuilt from the log
+   boost::filesystem::remove_all(state_history_dir.path / "chain_state_tables");
+   eosio::state_history_chain_state_log log(config);
+   BOOST_CHECK_EQUAL(log.get_table_index()->end_block(), log.end_block());
+   BOOST_CHECK(log.get_table_index()->changed(numobjs_block, "tester"_n, "numobjs"_n));
+}
+
 BOOST_AUTO_TEST_CASE(test_splitted_log) {
    namespace bfs = boost::filesystem;
 
@@ -586,7 +814,7 @@ BOOST_AUTO_TEST_CASE(test_traces_present)
       [&](std::tuple<const transaction_trace_ptr&, const packed_transaction_ptr&> t) {
          const transaction_trace_ptr &trace_ptr = std::get<0>(t);
          const eosio::chain::packed_transaction_ptr &transaction = std::get<1>(t);
-         log.add_transaction(trace_ptr, transaction);
+         log.add_transaction(chain.control->db(), trace_ptr, transaction);
 
          // see issue #9159
          if (!trace_ptr->action_traces.empty() && trace_ptr->action_traces[0].act.name == "onblock"_n) {
@@ -669,6 +897,19 @@ BOOST_AUTO_TEST_CASE(test_deltas_not_empty) {
    }
 }
 
+BOOST_AUTO_TEST_CASE(test_deltas_parallel) {
+   table_deltas_tester chain { backing_store_type::CHAINBASE };
+   chain.create_account("newacc"_n);
+
+   // packing the tables on the thread pool gives the same deltas in the same order
+   for (bool full_snapshot : { false, true }) {
+      auto serial   = fc::raw::pack(eosio::state_history::create_deltas(chain.control->kv_db(), full_snapshot));
+      auto parallel = fc::raw::pack(eosio::state_history::create_deltas(chain.control->kv_db(), full_snapshot,
+                                                                        &chain.control->get_thread_pool()));
+      BOOST_CHECK(serial == parallel);
+   }
+}
+
 BOOST_AUTO_TEST_CASE(test_deltas_account_creation) {
    for (backing_store_type backing_store : { backing_store_type::CHAINBASE, backing_store_type::ROCKSDB }) {
       table_deltas_tester chain { backing_store };
@@ -0,0 +1,98 @@
+#include <eosio/chain/table_usage_tracker.hpp>
+#include <eosio/chain/contract_table_objects.hpp>
+#include <eosio/testing/tester.hpp>
+
+#include <fc/variant_object.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <contracts.hpp>
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::testing;
+
+using mvo = fc::mutable_variant_object;
+
+BOOST_AUTO_TEST_SUITE(table_usage_tracker_tests)
+
+BOOST_AUTO_TEST_CASE( commit_and_pop ) try {
+   const table_usage_key accounts{ "token"_n, "accounts"_n, false };
+   const table_usage_key stat{ "token"_n, "stat"_n, false };
+   table_usage_tracker tracker( { { accounts, table_usage{ 2, 200 } } }, true );
+
+   auto deltas = []( std::initializer_list<std::pair<table_usage_key, table_usage>> l ) {
+      return table_usage_deltas( l.begin(), l.end() );
+   };
+   tracker.commit_block( 10, { deltas( { { accounts, { 1, 100 } } } ), deltas( { { accounts, { 0, 8 } }, { stat, { 1, 50 } } } ) }, 9 );
+   tracker.commit_block( 11, { deltas( { { stat, { -1, -50 } } } ) }, 9 );
+   BOOST_CHECK_EQUAL( tracker.head_block_num(), 11u );
+
+   auto tables = tracker.get_tables();
+   BOOST_REQUIRE_EQUAL( tables.size(), 1u ); // stat is empty again
+   BOOST_CHECK_EQUAL( tables[accounts].rows, 3 );
+   BOOST_CHECK_EQUAL( tables[accounts].bytes, 308 );
+
+   // popping undoes the changes of the block
+   tracker.pop_block( 11 );
+   tables = tracker.get_tables();
+   BOOST_CHECK_EQUAL( tables[stat].rows, 1 );
+   BOOST_CHECK_EQUAL( tables[stat].bytes, 50 );
+   BOOST_CHECK_EQUAL( tracker.head_block_num(), 10u );
+
+   // changes of irreversible blocks are not kept
+   tracker.commit_block( 11, {}, 11 );
+   tracker.pop_block( 11 );
+   tracker.pop_block( 10 );
+   BOOST_CHECK_EQUAL( tracker.get_tables()[accounts].rows, 3 );
+
+   BOOST_CHECK_EQUAL( table_usage_key::kv_table( "\x12\x34", 2 ), name( 0x1234000000000000ull ) );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( track_token_tables ) try {
+   tester chain;
+   auto tracker = std::make_shared<table_usage_tracker>( table_usage_tracker::usage_map{}, false );
+   chain.control->set_table_usage_tracker( tracker );
+
+   chain.create_accounts( { "eosio.token"_n, "alice"_n, "bob"_n } );
+   chain.set_code( "eosio.token"_n, contracts::eosio_token_wasm() );
+   chain.set_abi( "eosio.token"_n, contracts::eosio_token_abi().data() );
+   chain.push_action( "eosio.token"_n, "create"_n, "eosio.token"_n,
+                      mvo()( "issuer", "eosio.token" )( "maximum_supply", "1000.0000 TOK" ) );
+   chain.push_action( "eosio.token"_n, "issue"_n, "eosio.token"_n,
+                      mvo()( "to", "eosio.token" )( "quantity", "100.0000 TOK" )( "memo", "" ) );
+   chain.push_action( "eosio.token"_n, "transfer"_n, "eosio.token"_n,
+                      mvo()( "from", "eosio.token" )( "to", "alice" )( "quantity", "10.0000 TOK" )( "memo", "" ) );
+   chain.push_action( "eosio.token"_n, "transfer"_n, "alice"_n,
+                      mvo()( "from", "alice" )( "to", "bob" )( "quantity", "1.0000 TOK" )( "memo", "" ) );
+   chain.produce_block();
+   BOOST_CHECK_EQUAL( tracker->head_block_num(), chain.control->head_block_num() );
+
+   // the tracked usage matches the rows in the state db
+   auto tables = tracker->get_tables();
+   const auto& db = chain.control->db();
+   for( auto table : { "accounts"_n, "stat"_n } ) {
+      int64_t rows = 0, bytes = 0;
+      for( const auto& t : db.get_index<table_id_multi_index>().indices() ) {
+         if( t.code != "eosio.token"_n || t.table != table ) continue;
+         rows += t.count;
+         const auto& idx = db.get_index<key_value_index, by_scope_primary>();
+         for( auto itr = idx.lower_bound( boost::make_tuple( t.id ) ); itr != idx.end() && itr->t_id == t.id; ++itr )
+            bytes += itr->value.size() + config::billable_size_v<key_value_object>;
+      }
+      const auto& u = tables[table_usage_key{ "eosio.token"_n, table, false }];
+      BOOST_CHECK_EQUAL( u.rows, rows );
+      BOOST_CHECK_EQUAL( u.bytes, bytes );
+   }
+   BOOST_CHECK_EQUAL( tables[table_usage_key{ "eosio.token"_n, "accounts"_n, false }].rows, 3 );
+   BOOST_CHECK_EQUAL( tables[table_usage_key{ "eosio.token"_n, "stat"_n, false }].rows, 1 );
+
+   // a transaction which fails changes nothing
+   BOOST_CHECK_THROW( chain.push_action( "eosio.token"_n, "transfer"_n, "bob"_n,
+                                         mvo()( "from", "bob" )( "to", "alice" )( "quantity", "5.0000 TOK" )( "memo", "" ) ),
+                      eosio_assert_message_exception );
+   chain.produce_block();
+   BOOST_CHECK_EQUAL( tracker->get_tables()[table_usage_key{ "eosio.token"_n, "accounts"_n, false }].rows, 3 );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
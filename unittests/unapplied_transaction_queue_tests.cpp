@@ -496,4 +496,64 @@ BOOST_AUTO_TEST_CASE( unapplied_transaction_queue_incoming_count ) try {
 
 } FC_LOG_AND_RETHROW() /// unapplied_transaction_queue_incoming_count
 
+BOOST_AUTO_TEST_CASE( unapplied_transaction_queue_priority ) try {
+
+   unapplied_transaction_queue q;
+   std::map<transaction_id_type, uint32_t> priorities;
+   q.set_priority_function( [&]( const transaction_metadata_ptr& trx ) { return priorities[trx->id()]; } );
+
+   auto trx1 = unique_trx_meta_data();
+   auto trx2 = unique_trx_meta_data();
+   auto trx3 = unique_trx_meta_data();
+   auto trx4 = unique_trx_meta_data();
+   auto trx5 = unique_trx_meta_data();
+   priorities[trx2->id()] = 2;
+   priorities[trx3->id()] = 1;
+   priorities[trx4->id()] = 2;
+
+   q.add_incoming( trx1, false, [](auto){} );
+   q.add_incoming( trx2, false, [](auto){} );
+   q.add_incoming( trx3, false, [](auto){} );
+   q.add_incoming( trx4, false, [](auto){} );
+   q.add_incoming( trx5, true, [](auto){} );
+   BOOST_CHECK( q.incoming_size() == 5 );
+
+   // incoming_persisted first, then by priority, equal priority in arrival order
+   BOOST_CHECK( next( q ) == trx5 );
+   BOOST_CHECK( next( q ) == trx2 );
+   BOOST_CHECK( next( q ) == trx4 );
+   BOOST_CHECK( next( q ) == trx3 );
+   BOOST_CHECK( next( q ) == trx1 );
+   BOOST_CHECK( q.empty() );
+
+   // room for two transactions, a third with higher priority replaces the lowest priority one
+   auto trx6 = unique_trx_meta_data();
+   auto trx7 = unique_trx_meta_data();
+   auto trx8 = unique_trx_meta_data();
+   auto trx9 = unique_trx_meta_data();
+   priorities[trx6->id()] = 1;
+   priorities[trx8->id()] = 2;
+   q.set_max_transaction_queue_size( ( sizeof(unapplied_transaction) + trx6->get_estimated_size() ) * 5 / 2 );
+
+   bool trx7_dropped = false;
+   q.add_incoming( trx6, false, [](auto){} );
+   q.add_incoming( trx7, false, [&]( const auto& r ) {
+      trx7_dropped = std::holds_alternative<fc::exception_ptr>( r ) &&
+                     std::get<fc::exception_ptr>( r )->code() == tx_resource_exhaustion::code_value;
+   } );
+   q.add_incoming( trx8, false, [](auto){} );
+   BOOST_CHECK( trx7_dropped );
+   BOOST_CHECK( q.incoming_size() == 2 );
+   BOOST_CHECK( !q.get_trx( trx7->id() ) );
+
+   // nothing lower priority to replace
+   BOOST_CHECK_THROW( q.add_incoming( trx9, false, [](auto){} ), tx_resource_exhaustion );
+   BOOST_CHECK( q.get_trx( trx6->id() ) );
+   BOOST_CHECK( q.get_trx( trx8->id() ) );
+
+   BOOST_CHECK( next( q ) == trx8 );
+   BOOST_CHECK( next( q ) == trx6 );
+
+} FC_LOG_AND_RETHROW() /// unapplied_transaction_queue_priority
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -772,6 +772,30 @@ BOOST_FIXTURE_TEST_CASE( memory_init_border, TESTER ) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( memory_init_outside_initial_memory, TESTER ) try {
+   produce_blocks(2);
+
+   create_accounts( {"memoryinit"_n} );
+   produce_block();
+
+   // the data segment lies in the first 64KiB, which is all setcode checks, but not in the empty initial memory
+   set_code("memoryinit"_n, memory_init_outside_initial_memory);
+   produce_blocks(1);
+
+   signed_transaction trx;
+   action act;
+   act.account = "memoryinit"_n;
+   act.name = name();
+   act.authorization = vector<permission_level>{{"memoryinit"_n,config::active_name}};
+   trx.actions.push_back(act);
+   set_transaction_headers(trx);
+   trx.sign(get_private_key( "memoryinit"_n, "active" ), control->get_chain_id());
+
+   BOOST_CHECK_EXCEPTION(push_transaction(trx), eosio::chain::wasm_execution_error,
+                         fc_exception_message_is("WASM data segment outside of valid memory range"));
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE( imports, TESTER ) try {
    try {
       produce_blocks(2);